@@ -98,6 +98,7 @@
  */
 
 #include "gst_private.h"
+#include "gstslicecache.h"
 #include "gstconfig.h"
 #include <stdlib.h>
 #include <stdio.h>
@@ -680,6 +681,7 @@ init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
   llf = G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_ERROR | G_LOG_FLAG_FATAL;
   g_log_set_handler (g_log_domain_gstreamer, llf, debug_log_handler, NULL);
 
+  _priv_gst_slice_cache_initialize ();
   _priv_gst_mini_object_initialize ();
   _priv_gst_quarks_initialize ();
   _priv_gst_allocator_initialize ();
@@ -1148,6 +1150,8 @@ gst_deinit (void)
   gst_object_unref (clock);
   gst_object_unref (clock);
 
+  _priv_gst_type_find_factory_cleanup ();
+  _priv_gst_element_factory_pools_cleanup ();
   _priv_gst_registry_cleanup ();
   _priv_gst_allocator_cleanup ();
 
@@ -1157,6 +1161,8 @@ gst_deinit (void)
 #ifndef GST_DISABLE_GST_DEBUG
   _priv_gst_tracing_deinit ();
 #endif
+  /* after the final reports of the tracers */
+  _priv_gst_tracer_record_cleanup ();
 
   _priv_gst_caps_features_cleanup ();
   _priv_gst_caps_cleanup ();
@@ -1263,6 +1269,8 @@ gst_deinit (void)
   g_type_class_unref (g_type_class_peek (gst_stack_trace_flags_get_type ()));
   g_type_class_unref (g_type_class_peek (gst_promise_result_get_type ()));
 
+  _priv_gst_slice_cache_cleanup ();
+
   gst_deinitialized = TRUE;
   GST_INFO ("deinitialized GStreamer");
   g_mutex_unlock (&init_lock);
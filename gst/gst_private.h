@@ -67,6 +67,39 @@ extern const char             g_log_domain_gstreamer[];
 
 #include "gsttracerutils.h"
 
+#include "gstsdt-private.h"
+
+#ifdef GST_ENABLE_LOCK_TRACING
+/* Route the object and pad stream locks taken by the core, libgstbase and
+ * the core elements through the instrumented locks of gsttracerutils.c so
+ * the lock-acquired and lock-released hooks see them. Code built outside
+ * of GStreamer keeps using the plain macros. */
+#undef GST_OBJECT_LOCK
+#undef GST_OBJECT_TRYLOCK
+#undef GST_OBJECT_UNLOCK
+#define GST_OBJECT_LOCK(obj) \
+    _gst_tracer_mutex_lock (GST_OBJECT_GET_LOCK (obj), GST_OBJECT_CAST (obj), \
+        G_STRLOC)
+#define GST_OBJECT_TRYLOCK(obj) \
+    _gst_tracer_mutex_trylock (GST_OBJECT_GET_LOCK (obj), \
+        GST_OBJECT_CAST (obj), G_STRLOC)
+#define GST_OBJECT_UNLOCK(obj) \
+    _gst_tracer_mutex_unlock (GST_OBJECT_GET_LOCK (obj), GST_OBJECT_CAST (obj))
+
+#undef GST_PAD_STREAM_LOCK
+#undef GST_PAD_STREAM_TRYLOCK
+#undef GST_PAD_STREAM_UNLOCK
+#define GST_PAD_STREAM_LOCK(pad) \
+    _gst_tracer_rec_mutex_lock (GST_PAD_GET_STREAM_LOCK (pad), \
+        GST_OBJECT_CAST (pad), G_STRLOC)
+#define GST_PAD_STREAM_TRYLOCK(pad) \
+    _gst_tracer_rec_mutex_trylock (GST_PAD_GET_STREAM_LOCK (pad), \
+        GST_OBJECT_CAST (pad), G_STRLOC)
+#define GST_PAD_STREAM_UNLOCK(pad) \
+    _gst_tracer_rec_mutex_unlock (GST_PAD_GET_STREAM_LOCK (pad), \
+        GST_OBJECT_CAST (pad))
+#endif /* GST_ENABLE_LOCK_TRACING */
+
 G_BEGIN_DECLS
 
 /* used by gstparse.c and grammar.y */
@@ -104,6 +137,16 @@ struct _GstMetaItem {
   GstMeta meta;
 };
 
+/* Buffers keep a bitmask of the APIs of their metas. The first 63 registered
+ * APIs get their own bit, all others share the last one. */
+#define GST_META_API_UNINDEXED 63
+
+G_GNUC_INTERNAL
+guint _priv_gst_meta_api_index (GType api);
+
+G_GNUC_INTERNAL
+gboolean _priv_gst_meta_info_is_memory (const GstMetaInfo * info);
+
 /* FIXME: could rename all priv_gst_* functions to __gst_* now */
 G_GNUC_INTERNAL  gboolean priv_gst_plugin_loading_have_whitelist (void);
 
@@ -121,6 +164,11 @@ G_GNUC_INTERNAL  void  _priv_gst_quarks_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_mini_object_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_memory_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_allocator_initialize (void);
+G_GNUC_INTERNAL  GstAllocator * _priv_gst_allocator_numa_new (void);
+
+G_GNUC_INTERNAL  GstAllocator * _priv_gst_allocator_shm_new (void);
+
+G_GNUC_INTERNAL  GstAllocator * _priv_gst_allocator_file_new (void);
 G_GNUC_INTERNAL  void  _priv_gst_buffer_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_buffer_list_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_structure_initialize (void);
@@ -141,22 +189,81 @@ G_GNUC_INTERNAL  void  _priv_gst_toc_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_date_time_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_plugin_feature_rank_initialize (void);
 
+G_GNUC_INTERNAL
+void  _priv_gst_static_caps_init (GstStaticCaps * static_caps,
+                                  const gchar * string);
+
 /* cleanup functions called from gst_deinit(). */
 G_GNUC_INTERNAL  void  _priv_gst_allocator_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_features_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_debug_cleanup (void);
+G_GNUC_INTERNAL  void  _priv_gst_tracer_record_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_meta_cleanup (void);
+G_GNUC_INTERNAL  void  _priv_gst_type_find_factory_cleanup (void);
 
 /* called from gst_task_cleanup_all(). */
 G_GNUC_INTERNAL  void  _priv_gst_element_cleanup (void);
 
+G_GNUC_INTERNAL  void  _priv_gst_element_factory_pools_cleanup (void);
+
+/* the internal pad of a proxy pad, must be called with the pad's object lock */
+G_GNUC_INTERNAL  GstPad * _priv_gst_proxy_pad_get_internal_unlocked (GstPad * pad);
+
 /* Private registry functions */
 G_GNUC_INTERNAL
 gboolean _priv_gst_registry_remove_cache_plugins (GstRegistry *registry);
 
 G_GNUC_INTERNAL  void _priv_gst_registry_cleanup (void);
 
+/* Summary of a plugin directory as seen by the last registry scan, used to
+ * skip the per-file checks of directories that didn't change */
+typedef struct {
+  gint64  mtime;
+  guint64 inode;
+  guint32 n_entries;
+  guint32 entries_hash;
+} GstRegistryDirSummary;
+
+/* secondary indices over the element factories of a registry, used by
+ * gst_element_factory_list_get_elements() and
+ * gst_element_factory_list_filter() */
+typedef struct _GstRegistryFactoryIndex GstRegistryFactoryIndex;
+
+G_GNUC_INTERNAL
+GList *   _priv_gst_registry_get_element_factories_by_type (GstRegistry *registry,
+                                                            GstElementFactoryListType type,
+                                                            GstRank minrank);
+
+G_GNUC_INTERNAL
+GList *   _priv_gst_registry_get_element_factories_by_uri_protocol (GstRegistry *registry,
+                                                                  GstURIType type,
+                                                                  const gchar *protocol);
+
+G_GNUC_INTERNAL
+GstRegistryFactoryIndex * _priv_gst_registry_get_media_type_index (GstRegistry *registry);
+
+G_GNUC_INTERNAL
+gboolean  _priv_gst_registry_media_type_index_may_match (GstRegistryFactoryIndex *index,
+                                                         GstElementFactory *factory,
+                                                         const GstCaps *caps,
+                                                         GstPadDirection direction);
+
+G_GNUC_INTERNAL
+void      _priv_gst_registry_factory_index_unref (GstRegistryFactoryIndex *index);
+
+/* the GstElementFactoryListType bits that describe @factory */
+G_GNUC_INTERNAL
+GstElementFactoryListType _priv_gst_element_factory_get_type_mask (GstElementFactory *factory);
+
+G_GNUC_INTERNAL
+gboolean  _priv_gst_element_factory_type_mask_matches (GstElementFactoryListType mask,
+                                                       GstElementFactoryListType type);
+
+/* directory path -> GstRegistryDirSummary, stored in the registry cache */
+G_GNUC_INTERNAL
+GHashTable * _priv_gst_registry_get_dir_index (GstRegistry *registry);
+
 GST_API
 gboolean _gst_plugin_loader_client_run (void);
 
@@ -198,6 +305,22 @@ gboolean priv_gst_structure_parse_name (gchar * str, gchar **start, gchar ** end
 G_GNUC_INTERNAL
 gboolean priv_gst_structure_parse_fields (gchar *str, gchar ** end, GstStructure *structure);
 
+/* copy-on-write sharing of structures between caps, used in gstcaps.c.
+ * A shared structure is never mutable, it has to be made exclusive to one
+ * owner with priv_gst_structure_make_exclusive() before modifying it */
+G_GNUC_INTERNAL
+GstStructure * priv_gst_structure_share (GstStructure * structure);
+
+G_GNUC_INTERNAL
+gboolean priv_gst_structure_is_shared (const GstStructure * structure);
+
+G_GNUC_INTERNAL
+GstStructure * priv_gst_structure_make_exclusive (GstStructure * structure,
+                                                  gint         * refcount);
+
+G_GNUC_INTERNAL
+void priv_gst_structure_release (GstStructure * structure);
+
 /* used in gstvalue.c and gststructure.c */
 
 #define GST_WRAPPED_PTR_FORMAT     "p\aa"
@@ -221,6 +344,26 @@ G_GNUC_INTERNAL
 void      __gst_element_factory_add_interface           (GstElementFactory    * elementfactory,
                                                          const gchar          * interfacename);
 
+/* element factories loaded from the registry cache read their details from
+ * the mapped cache on first use, implemented in gstregistrychunks.c */
+G_GNUC_INTERNAL
+void      _priv_gst_registry_chunks_load_element_factory_details  (GstElementFactory * factory);
+
+G_GNUC_INTERNAL
+void      _priv_gst_registry_chunks_clear_element_factory_details (GstElementFactory * factory);
+
+G_GNUC_INTERNAL
+GType     _priv_gst_element_factory_ensure_type         (GstElementFactory * factory);
+
+#define GST_ELEMENT_FACTORY_ENSURE_TYPE(factory)                       \
+  (G_LIKELY ((factory)->type != 0 || (factory)->get_type_func == NULL) ? \
+      (factory)->type : _priv_gst_element_factory_ensure_type (factory))
+
+#define GST_ELEMENT_FACTORY_ENSURE_DETAILS(factory) G_STMT_START {     \
+  if (G_UNLIKELY (g_atomic_pointer_get (&(factory)->lazy_details)))     \
+    _priv_gst_registry_chunks_load_element_factory_details (factory);  \
+} G_STMT_END
+
 /* used in gstvalue.c and gststructure.c */
 #define GST_ASCII_IS_STRING(c) (g_ascii_isalnum((c)) || ((c) == '_') || \
     ((c) == '-') || ((c) == '+') || ((c) == '/') || ((c) == ':') || \
@@ -425,10 +568,17 @@ struct _GstTypeFindFactory {
   GstTypeFindFunction           function;
   gchar **                      extensions;
   GstCaps *                     caps;
+  /* interned string of the caps loaded from the registry, which are only
+   * parsed on first use */
+  const gchar *                 caps_string;
 
   gpointer                      user_data;
   GDestroyNotify                user_data_notify;
 
+  /* bytes every stream of this type starts with, or NULL */
+  guint8 *                      magic;
+  guint                         magic_size;
+
   gpointer _gst_reserved[GST_PADDING];
 };
 
@@ -476,6 +626,14 @@ struct _GstElementFactory {
 
   GList *               interfaces;             /* interface type names this element implements */
 
+  /* metadata, pad templates, URI handling and interfaces that still have to
+   * be read from the registry cache, see gstregistrychunks.c */
+  gpointer              lazy_details;
+
+  /* for factories registered from a #GstElementFactoryDescription, the type
+   * is only registered when it's needed the first time */
+  GType               (*get_type_func) (void);
+
   /*< private >*/
   gpointer _gst_reserved[GST_PADDING];
 };
@@ -509,6 +667,7 @@ struct _GstDynamicTypeFactory {
   GstPluginFeature           feature;
 
   GType                      type; /* GType of the type, when loaded. 0 if not */
+  gint                       load_failed; /* loading the plugin failed before */
 };
 
 struct _GstDynamicTypeFactoryClass {
@@ -47,6 +47,7 @@
 
 #include "gst_private.h"
 #include "gstmemory.h"
+#include "gstslicecache.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_allocator_debug);
 #define GST_CAT_DEFAULT gst_allocator_debug
@@ -287,6 +288,31 @@ gst_allocator_set_default (GstAllocator * allocator)
     gst_object_unref (old);
 }
 
+/**
+ * gst_allocator_cache_get_stats:
+ * @hits: (out) (optional): the number of blocks that were taken from the
+ *   caches
+ * @misses: (out) (optional): the number of blocks that had to be allocated
+ * @slab_size: (out) (optional): the number of bytes allocated for slabs
+ *
+ * Gets the statistics of the per-thread caches of small blocks. The caches
+ * hold the memory of the system memory allocator up to 4kB, as well as
+ * buffers, events and other small structures. Hits of other threads are
+ * added to the totals in batches, so they lag behind by a few hundred.
+ *
+ * @slab_size is only non-zero when the caches are backed by slabs, which is
+ * enabled with the `GST_ALLOCATOR_SLAB` environment variable. Slabs are never
+ * freed.
+ *
+ * Since: 1.20
+ */
+void
+gst_allocator_cache_get_stats (guint64 * hits, guint64 * misses,
+    guint64 * slab_size)
+{
+  _priv_gst_slice_cache_get_stats (hits, misses, slab_size);
+}
+
 /**
  * gst_allocator_alloc:
  * @allocator: (transfer none) (allow-none): a #GstAllocator to use
@@ -410,7 +436,7 @@ _sysmem_new (GstMemoryFlags flags,
 
   slice_size = sizeof (GstMemorySystem);
 
-  mem = g_slice_alloc (slice_size);
+  mem = _priv_gst_slice_cache_alloc (slice_size);
   _sysmem_init (mem, flags, parent, slice_size,
       data, maxsize, align, offset, size, user_data, notify);
 
@@ -433,7 +459,7 @@ _sysmem_new_block (GstMemoryFlags flags,
   /* alloc header and data in one block */
   slice_size = sizeof (GstMemorySystem) + maxsize;
 
-  mem = g_slice_alloc (slice_size);
+  mem = _priv_gst_slice_cache_alloc (slice_size);
   if (mem == NULL)
     return NULL;
 
@@ -552,7 +578,7 @@ default_free (GstAllocator * allocator, GstMemory * mem)
   memset (mem, 0xff, sizeof (GstMemorySystem));
 #endif
 
-  g_slice_free1 (slice_size, mem);
+  _priv_gst_slice_cache_free (slice_size, mem);
 }
 
 static void
@@ -598,6 +624,9 @@ gst_allocator_sysmem_init (GstAllocatorSysmem * allocator)
 void
 _priv_gst_allocator_initialize (void)
 {
+  GstAllocator *numa, *shm, *file;
+  const gchar *env;
+
   g_rw_lock_init (&lock);
   allocators = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
       gst_object_unref);
@@ -619,7 +648,34 @@ _priv_gst_allocator_initialize (void)
   gst_allocator_register (GST_ALLOCATOR_SYSMEM,
       gst_object_ref (_sysmem_allocator));
 
-  _default_allocator = gst_object_ref (_sysmem_allocator);
+  numa = _priv_gst_allocator_numa_new ();
+  if (numa) {
+    gst_object_ref_sink (numa);
+    gst_allocator_register (GST_ALLOCATOR_SYSMEM_NUMA, numa);
+  }
+
+  shm = _priv_gst_allocator_shm_new ();
+  if (shm) {
+    gst_object_ref_sink (shm);
+    gst_allocator_register (GST_ALLOCATOR_SHM, shm);
+  }
+
+  file = _priv_gst_allocator_file_new ();
+  if (file) {
+    gst_object_ref_sink (file);
+    gst_allocator_register (GST_ALLOCATOR_FILE, file);
+  }
+
+  /* allow selecting another default allocator from the environment */
+  if ((env = g_getenv ("GST_ALLOCATOR")) && *env)
+    _default_allocator = gst_allocator_find (env);
+
+  if (_default_allocator == NULL) {
+    if (env && *env)
+      GST_CAT_WARNING (GST_CAT_MEMORY, "allocator '%s' not found, using the "
+          "system memory allocator", env);
+    _default_allocator = gst_object_ref (_sysmem_allocator);
+  }
 }
 
 void
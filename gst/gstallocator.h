@@ -62,6 +62,40 @@ GST_API gsize gst_memory_alignment;
  */
 #define GST_ALLOCATOR_SYSMEM   "SystemMemory"
 
+/**
+ * GST_ALLOCATOR_SYSMEM_NUMA:
+ *
+ * The allocator name for the NUMA and hugepage aware system memory
+ * allocator. It is only registered on platforms that support it.
+ *
+ * Since: 1.20
+ */
+#define GST_ALLOCATOR_SYSMEM_NUMA   "SystemMemoryNUMA"
+
+/**
+ * GST_ALLOCATOR_SHM:
+ *
+ * The allocator name for the shared memory allocator. Its memory is backed
+ * by file descriptors that can be passed to other processes, see
+ * gst_shm_memory_get_fd() and gst_shm_memory_new_from_fd(). It is only
+ * registered on platforms that support it.
+ *
+ * Since: 1.20
+ */
+#define GST_ALLOCATOR_SHM   "ShmMemory"
+
+/**
+ * GST_ALLOCATOR_FILE:
+ *
+ * The allocator name for file memory, a read-only view of a range of a
+ * regular file that is only mapped when the memory is mapped, see
+ * gst_file_memory_new(). It is only registered on platforms that support
+ * it.
+ *
+ * Since: 1.20
+ */
+#define GST_ALLOCATOR_FILE   "FileMemory"
+
 /**
  * GstAllocationParams:
  * @flags: flags to control allocation
@@ -84,12 +118,18 @@ struct _GstAllocationParams {
 /**
  * GstAllocatorFlags:
  * @GST_ALLOCATOR_FLAG_CUSTOM_ALLOC: The allocator has a custom alloc function.
+ * @GST_ALLOCATOR_FLAG_CACHE_READ_MAPS: Nested #GST_MAP_READ maps of the same
+ *   memory reuse the first mapping. The map function of the allocator is only
+ *   called for the first map and the unmap function for the last unmap. The
+ *   user_data of the #GstMapInfo of the first map is copied to the nested
+ *   ones. Useful for allocators with expensive maps. (Since: 1.20)
  * @GST_ALLOCATOR_FLAG_LAST: first flag that can be used for custom purposes
  *
  * Flags for allocators.
  */
 typedef enum {
   GST_ALLOCATOR_FLAG_CUSTOM_ALLOC  = (GST_OBJECT_FLAG_LAST << 0),
+  GST_ALLOCATOR_FLAG_CACHE_READ_MAPS = (GST_OBJECT_FLAG_LAST << 1),
 
   GST_ALLOCATOR_FLAG_LAST          = (GST_OBJECT_FLAG_LAST << 16)
 } GstAllocatorFlags;
@@ -165,6 +205,10 @@ GstAllocator * gst_allocator_find            (const gchar *name);
 GST_API
 void           gst_allocator_set_default     (GstAllocator * allocator);
 
+GST_API
+void           gst_allocator_cache_get_stats (guint64 * hits, guint64 * misses,
+                                              guint64 * slab_size);
+
 /* allocation parameters */
 
 GST_API
@@ -194,6 +238,23 @@ GstMemory *    gst_memory_new_wrapped  (GstMemoryFlags flags, gpointer data, gsi
                                         gsize offset, gsize size, gpointer user_data,
                                         GDestroyNotify notify);
 
+/* shared memory */
+
+GST_API
+gint           gst_shm_memory_get_fd       (GstMemory * mem);
+
+GST_API
+GstMemory *    gst_shm_memory_new_from_fd  (gint fd, gsize maxsize, gsize offset,
+                                            gsize size);
+
+/* file memory */
+
+GST_API
+GstMemory *    gst_file_memory_new         (gint fd, guint64 offset, gsize size);
+
+GST_API
+gint           gst_file_memory_get_fd      (GstMemory * mem, guint64 * offset);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstAllocationParams, gst_allocation_params_free)
 
 G_END_DECLS
@@ -0,0 +1,339 @@
+/* GStreamer
+ *
+ * gstallocatorfile.c: file backed memory
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* File memory is a read-only view of a range of a regular file. Nothing is
+ * read or mapped when the memory is created, the range is only mapped with
+ * mmap() the first time the memory is mapped and stays mapped until the
+ * memory is freed. Elements that only pass the memory on, or that send it
+ * with sendfile() using gst_file_memory_get_fd(), never touch the data.
+ *
+ * Every memory, including the ones created with gst_memory_share(), maps its
+ * own page aligned range of the file so that a small block of a huge file
+ * only costs a mapping of that block. The root memory owns a duplicate of
+ * the file descriptor, shared memories use the one of their parent.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gst_private.h"
+#include "gstmemory.h"
+
+#if defined(HAVE_SYS_MMAN_H) && !defined(G_OS_WIN32)
+#define HAVE_FILE_ALLOCATOR 1
+#endif
+
+#ifdef HAVE_FILE_ALLOCATOR
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct
+{
+  GstMemory mem;
+
+  gint fd;
+  /* page aligned file offset of the start of the memory block */
+  guint64 file_base;
+  /* mapping of the whole block, NULL until the memory is mapped */
+  guint8 *data;
+} GstMemoryFile;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstAllocatorFile;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstAllocatorFileClass;
+
+static GType gst_allocator_file_get_type (void);
+G_DEFINE_TYPE (GstAllocatorFile, gst_allocator_file, GST_TYPE_ALLOCATOR);
+
+/* the registered allocator, the allocator registry keeps it alive */
+static GstAllocator *_file_allocator;
+static guint64 _file_page_mask;
+
+static GstMemoryFile *
+_file_new (GstMemoryFlags flags, GstMemory * parent, gint fd,
+    guint64 offset, gsize size)
+{
+  GstMemoryFile *mem;
+  guint64 base;
+  gsize delta;
+
+  base = offset & ~_file_page_mask;
+  delta = offset - base;
+
+  mem = g_slice_new (GstMemoryFile);
+  gst_memory_init (GST_MEMORY_CAST (mem), flags, _file_allocator, parent,
+      size + delta, 0, delta, size);
+
+  mem->fd = fd;
+  mem->file_base = base;
+  mem->data = NULL;
+
+  return mem;
+}
+
+static GstMemory *
+gst_allocator_file_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GST_CAT_WARNING (GST_CAT_MEMORY, "file memory can only be created with "
+      "gst_file_memory_new()");
+  return NULL;
+}
+
+static void
+gst_allocator_file_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstMemoryFile *mem = (GstMemoryFile *) memory;
+
+  if (mem->data)
+    munmap (mem->data, memory->maxsize);
+
+  /* shared memory uses the fd of its parent */
+  if (memory->parent == NULL)
+    close (mem->fd);
+
+  g_slice_free (GstMemoryFile, mem);
+}
+
+static gpointer
+_file_map (GstMemoryFile * mem, gsize maxsize, GstMapFlags flags)
+{
+  struct stat st;
+  guint8 *data;
+
+  if ((data = g_atomic_pointer_get (&mem->data)))
+    return data;
+
+  /* a file that was truncated behind our back would fault on access */
+  if (fstat (mem->fd, &st) < 0
+      || (guint64) st.st_size < mem->file_base + mem->mem.maxsize) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "file of memory %p is smaller than %"
+        G_GUINT64_FORMAT " bytes", mem, mem->file_base + mem->mem.maxsize);
+    return NULL;
+  }
+
+  data = mmap (NULL, mem->mem.maxsize, PROT_READ, MAP_PRIVATE, mem->fd,
+      mem->file_base);
+  if (data == MAP_FAILED) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "failed to map %" G_GSIZE_FORMAT
+        " bytes of memory %p: %s", mem->mem.maxsize, mem, g_strerror (errno));
+    return NULL;
+  }
+
+  GST_CAT_LOG (GST_CAT_MEMORY, "mapped %" G_GSIZE_FORMAT " bytes at file "
+      "offset %" G_GUINT64_FORMAT " for memory %p", mem->mem.maxsize,
+      mem->file_base, mem);
+
+  /* another thread may have mapped the memory concurrently */
+  if (!g_atomic_pointer_compare_and_exchange (&mem->data, NULL, data)) {
+    munmap (data, mem->mem.maxsize);
+    data = g_atomic_pointer_get (&mem->data);
+  }
+
+  return data;
+}
+
+static gboolean
+_file_unmap (GstMemoryFile * mem)
+{
+  /* the mapping is kept until the memory is freed */
+  return TRUE;
+}
+
+static GstMemoryFile *
+_file_share (GstMemoryFile * mem, gssize offset, gsize size)
+{
+  GstMemory *parent;
+
+  /* find the real parent */
+  if ((parent = mem->mem.parent) == NULL)
+    parent = (GstMemory *) mem;
+
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  return _file_new (GST_MINI_OBJECT_FLAGS (parent) |
+      GST_MINI_OBJECT_FLAG_LOCK_READONLY, parent, mem->fd,
+      mem->file_base + mem->mem.offset + offset, size);
+}
+
+static gboolean
+_file_is_span (GstMemoryFile * mem1, GstMemoryFile * mem2, gsize * offset)
+{
+  /* both memories are views of the same file */
+  if (mem1->fd != mem2->fd)
+    return FALSE;
+
+  if (offset) {
+    GstMemoryFile *parent;
+
+    parent = (GstMemoryFile *) mem1->mem.parent;
+
+    *offset = mem1->file_base + mem1->mem.offset - parent->file_base -
+        parent->mem.offset;
+  }
+
+  return mem1->file_base + mem1->mem.offset + mem1->mem.size ==
+      mem2->file_base + mem2->mem.offset;
+}
+
+static void
+gst_allocator_file_class_init (GstAllocatorFileClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_allocator_file_alloc;
+  allocator_class->free = gst_allocator_file_free;
+}
+
+static void
+gst_allocator_file_init (GstAllocatorFile * file)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (file);
+
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "init allocator %p", file);
+
+  alloc->mem_type = GST_ALLOCATOR_FILE;
+  alloc->mem_map = (GstMemoryMapFunction) _file_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) _file_unmap;
+  alloc->mem_share = (GstMemoryShareFunction) _file_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) _file_is_span;
+
+  GST_OBJECT_FLAG_SET (file, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+/* the returned allocator must be registered */
+GstAllocator *
+_priv_gst_allocator_file_new (void)
+{
+  _file_page_mask = sysconf (_SC_PAGESIZE) - 1;
+  _file_allocator = g_object_new (gst_allocator_file_get_type (), NULL);
+
+  return _file_allocator;
+}
+
+/**
+ * gst_file_memory_new:
+ * @fd: a file descriptor of a regular file
+ * @offset: offset of the data in @fd
+ * @size: size of the data
+ *
+ * Creates a read-only #GstMemory of the #GST_ALLOCATOR_FILE allocator for
+ * @size bytes of @fd starting at @offset. Nothing is read from the file
+ * until the memory is mapped for the first time, the range then stays
+ * mapped until the memory is freed. @fd is duplicated, the caller keeps
+ * ownership of it.
+ *
+ * Use gst_memory_share() to create memory for parts of the range, this does
+ * not duplicate the file descriptor again.
+ *
+ * Returns: (transfer full) (nullable): a new #GstMemory, or %NULL when @fd
+ *   can't be duplicated or file memory is not supported.
+ *
+ * Since: 1.20
+ */
+GstMemory *
+gst_file_memory_new (gint fd, guint64 offset, gsize size)
+{
+  gint new_fd;
+
+  g_return_val_if_fail (fd >= 0, NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  if (_file_allocator == NULL)
+    return NULL;
+
+  new_fd = dup (fd);
+  if (new_fd < 0) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "failed to duplicate fd %d: %s", fd,
+        g_strerror (errno));
+    return NULL;
+  }
+
+  return (GstMemory *) _file_new (GST_MEMORY_FLAG_READONLY, NULL, new_fd,
+      offset, size);
+}
+
+/**
+ * gst_file_memory_get_fd:
+ * @mem: a #GstMemory
+ * @offset: (out) (optional): the file offset of the data of @mem
+ *
+ * Gets the file descriptor of memory of the #GST_ALLOCATOR_FILE allocator
+ * and the offset in the file where the data of @mem starts, which allows
+ * sending the data without mapping it. The file descriptor stays owned
+ * by @mem.
+ *
+ * Returns: the file descriptor of @mem, or -1 when @mem is not file memory.
+ *
+ * Since: 1.20
+ */
+gint
+gst_file_memory_get_fd (GstMemory * mem, guint64 * offset)
+{
+  GstMemoryFile *fmem = (GstMemoryFile *) mem;
+
+  g_return_val_if_fail (mem != NULL, -1);
+
+  if (mem->allocator == NULL || !gst_memory_is_type (mem, GST_ALLOCATOR_FILE))
+    return -1;
+
+  if (offset)
+    *offset = fmem->file_base + mem->offset;
+
+  return fmem->fd;
+}
+
+#else /* !HAVE_FILE_ALLOCATOR */
+
+GstAllocator *
+_priv_gst_allocator_file_new (void)
+{
+  return NULL;
+}
+
+GstMemory *
+gst_file_memory_new (gint fd, guint64 offset, gsize size)
+{
+  g_return_val_if_fail (fd >= 0, NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  return NULL;
+}
+
+gint
+gst_file_memory_get_fd (GstMemory * mem, guint64 * offset)
+{
+  g_return_val_if_fail (mem != NULL, -1);
+
+  return -1;
+}
+
+#endif /* HAVE_FILE_ALLOCATOR */
@@ -0,0 +1,448 @@
+/* GStreamer
+ *
+ * gstallocatornuma.c: NUMA and hugepage aware system memory allocator
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The NUMA allocator maps blocks of at least NUMA_MMAP_THRESHOLD bytes
+ * directly from the kernel and binds them to the NUMA node of the CPU the
+ * allocating thread runs on. Blocks of at least the hugepage threshold are
+ * backed by explicit hugepages when the system has some reserved and are
+ * marked for transparent hugepages otherwise. Smaller blocks are handed to the
+ * regular system memory allocator.
+ *
+ * The hugepage threshold can be changed with the
+ * GST_ALLOCATOR_HUGEPAGE_THRESHOLD environment variable, 0 disables hugepages.
+ *
+ * Node locality is reported to tracers with the "memory-numa-access" hook
+ * when memory is allocated and mapped.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gst_private.h"
+#include "gstmemory.h"
+
+#if defined(__linux__) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SCHED_GETCPU)
+#define HAVE_NUMA_ALLOCATOR 1
+#endif
+
+#ifdef HAVE_NUMA_ALLOCATOR
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+#define NUMA_MAX_NODES 64
+#define NUMA_MMAP_THRESHOLD (64 * 1024)
+#define NUMA_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+typedef struct
+{
+  GstMemory mem;
+
+  guint8 *data;
+  /* size of the mapping when we own it */
+  gsize map_size;
+  gint node;
+} GstMemoryNuma;
+
+typedef struct
+{
+  GstAllocator parent;
+
+  /* for the blocks we don't map ourselves */
+  GstAllocator *sysmem;
+
+  gsize page_size;
+  gsize hugepage_threshold;
+  /* cleared when the kernel has no explicit hugepages for us */
+  gboolean use_hugetlb;
+
+  guint n_nodes;
+  guint n_cpus;
+  /* node of each cpu */
+  gint *cpu_nodes;
+} GstAllocatorNuma;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstAllocatorNumaClass;
+
+static GType gst_allocator_numa_get_type (void);
+G_DEFINE_TYPE (GstAllocatorNuma, gst_allocator_numa, GST_TYPE_ALLOCATOR);
+
+static void
+parse_cpu_list (GstAllocatorNuma * numa, const gchar * list, gint node)
+{
+  const gchar *p = list;
+
+  while (*p) {
+    gchar *end;
+    guint64 first, last;
+
+    first = last = g_ascii_strtoull (p, &end, 10);
+    if (end == p)
+      break;
+    if (*end == '-') {
+      p = end + 1;
+      last = g_ascii_strtoull (p, &end, 10);
+      if (end == p)
+        break;
+    }
+    for (; first <= last && first < numa->n_cpus; first++)
+      numa->cpu_nodes[first] = node;
+
+    p = end;
+    while (*p == ',' || *p == '\n' || *p == ' ')
+      p++;
+  }
+}
+
+static void
+read_topology (GstAllocatorNuma * numa)
+{
+  gint node;
+  glong n_cpus;
+
+  n_cpus = sysconf (_SC_NPROCESSORS_CONF);
+  numa->n_cpus = MAX (n_cpus, 1);
+  numa->cpu_nodes = g_new0 (gint, numa->n_cpus);
+  numa->n_nodes = 1;
+
+  for (node = 0; node < NUMA_MAX_NODES; node++) {
+    gchar *path, *contents;
+
+    path = g_strdup_printf ("/sys/devices/system/node/node%d/cpulist", node);
+    if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+      g_free (path);
+      continue;
+    }
+    g_free (path);
+
+    parse_cpu_list (numa, contents, node);
+    numa->n_nodes = MAX (numa->n_nodes, node + 1);
+    g_free (contents);
+  }
+
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "%u cpus on %u NUMA nodes", numa->n_cpus,
+      numa->n_nodes);
+}
+
+/* sched_getcpu() goes through the vDSO, so this is cheap enough to do for
+ * every allocation and map */
+static inline gint
+current_node (GstAllocatorNuma * numa)
+{
+  gint cpu;
+
+  if (numa->n_nodes == 1)
+    return 0;
+
+  cpu = sched_getcpu ();
+  if (cpu < 0 || cpu >= numa->n_cpus)
+    return 0;
+
+  return numa->cpu_nodes[cpu];
+}
+
+static void
+bind_to_node (GstAllocatorNuma * numa, gpointer data, gsize size, gint node)
+{
+#ifdef SYS_mbind
+  gulong nodemask;
+
+  /* nothing to do on a single node */
+  if (numa->n_nodes == 1)
+    return;
+
+  nodemask = 1UL << node;
+  /* the memory is not touched yet, so the pages will be faulted in on the
+   * preferred node */
+  if (syscall (SYS_mbind, data, size, MPOL_PREFERRED, &nodemask,
+          sizeof (nodemask) * 8, 0) < 0)
+    GST_CAT_DEBUG (GST_CAT_MEMORY, "mbind to node %d failed: %s", node,
+        g_strerror (errno));
+#endif
+}
+
+static gpointer
+map_block (GstAllocatorNuma * numa, gsize * size)
+{
+  gpointer data;
+
+  if (numa->hugepage_threshold && *size >= numa->hugepage_threshold) {
+    gsize hsize = GST_ROUND_UP_N (*size, NUMA_HUGEPAGE_SIZE);
+
+#ifdef MAP_HUGETLB
+    if (g_atomic_int_get (&numa->use_hugetlb)) {
+      data = mmap (NULL, hsize, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (data != MAP_FAILED) {
+        *size = hsize;
+        return data;
+      }
+      GST_CAT_INFO (GST_CAT_MEMORY, "no explicit hugepages available: %s",
+          g_strerror (errno));
+      g_atomic_int_set (&numa->use_hugetlb, FALSE);
+    }
+#endif
+
+    data = mmap (NULL, hsize, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+      return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise (data, hsize, MADV_HUGEPAGE);
+#endif
+    *size = hsize;
+    return data;
+  }
+
+  *size = GST_ROUND_UP_N (*size, numa->page_size);
+  data = mmap (NULL, *size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED)
+    return NULL;
+
+  return data;
+}
+
+static GstMemoryNuma *
+_numa_new (GstAllocatorNuma * numa, GstMemoryFlags flags, GstMemory * parent,
+    guint8 * data, gsize map_size, gint node, gsize maxsize, gsize align,
+    gsize offset, gsize size)
+{
+  GstMemoryNuma *mem;
+
+  mem = g_slice_new (GstMemoryNuma);
+  gst_memory_init (GST_MEMORY_CAST (mem), flags, GST_ALLOCATOR_CAST (numa),
+      parent, maxsize, align, offset, size);
+
+  mem->data = data;
+  mem->map_size = map_size;
+  mem->node = node;
+
+  return mem;
+}
+
+static GstMemory *
+gst_allocator_numa_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  GstAllocatorNuma *numa = (GstAllocatorNuma *) allocator;
+  GstMemoryNuma *mem;
+  gsize maxsize, map_size;
+  guint8 *data;
+  gint node;
+
+  maxsize = size + params->prefix + params->padding;
+
+  /* small blocks and special alignments are better served by the system
+   * memory allocator */
+  if (maxsize < NUMA_MMAP_THRESHOLD || params->align >= numa->page_size)
+    return gst_allocator_alloc (numa->sysmem, size, params);
+
+  map_size = maxsize;
+  if (!(data = map_block (numa, &map_size)))
+    return NULL;
+
+  node = current_node (numa);
+  bind_to_node (numa, data, map_size, node);
+
+  /* anonymous mappings are zero filled, so prefix and padding are zeroed
+   * already */
+  mem = _numa_new (numa, params->flags, NULL, data, map_size, node,
+      maxsize, params->align | gst_memory_alignment, params->prefix, size);
+
+  GST_TRACER_MEMORY_NUMA_ACCESS (GST_MEMORY_CAST (mem), node, node);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+static void
+gst_allocator_numa_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstMemoryNuma *mem = (GstMemoryNuma *) memory;
+
+  /* shared memory points into the mapping of its parent */
+  if (memory->parent == NULL)
+    munmap (mem->data, mem->map_size);
+
+  g_slice_free (GstMemoryNuma, mem);
+}
+
+static gpointer
+_numa_map (GstMemoryNuma * mem, gsize maxsize, GstMapFlags flags)
+{
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  if (G_UNLIKELY (GST_TRACER_IS_ENABLED)) {
+    GstAllocatorNuma *numa = (GstAllocatorNuma *) mem->mem.allocator;
+
+    GST_TRACER_MEMORY_NUMA_ACCESS (GST_MEMORY_CAST (mem), mem->node,
+        current_node (numa));
+  }
+#endif
+
+  return mem->data;
+}
+
+static gboolean
+_numa_unmap (GstMemoryNuma * mem)
+{
+  return TRUE;
+}
+
+static GstMemoryNuma *
+_numa_copy (GstMemoryNuma * mem, gssize offset, gsize size)
+{
+  GstAllocationParams params = { 0, mem->mem.align, 0, 0, };
+  GstMemory *copy;
+  GstMapInfo map;
+
+  if (size == -1)
+    size = mem->mem.size > offset ? mem->mem.size - offset : 0;
+
+  copy = gst_allocator_alloc (mem->mem.allocator, size, &params);
+  if (copy == NULL || !gst_memory_map (copy, &map, GST_MAP_WRITE)) {
+    if (copy)
+      gst_memory_unref (copy);
+    return NULL;
+  }
+
+  GST_CAT_DEBUG (GST_CAT_PERFORMANCE,
+      "memcpy %" G_GSIZE_FORMAT " memory %p -> %p", size, mem, copy);
+  memcpy (map.data, mem->data + mem->mem.offset + offset, size);
+  gst_memory_unmap (copy, &map);
+
+  return (GstMemoryNuma *) copy;
+}
+
+static GstMemoryNuma *
+_numa_share (GstMemoryNuma * mem, gssize offset, gsize size)
+{
+  GstMemory *parent;
+
+  /* find the real parent */
+  if ((parent = mem->mem.parent) == NULL)
+    parent = (GstMemory *) mem;
+
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  /* the shared memory is always readonly */
+  return _numa_new ((GstAllocatorNuma *) mem->mem.allocator,
+      GST_MINI_OBJECT_FLAGS (parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+      parent, mem->data, 0, mem->node, mem->mem.maxsize, mem->mem.align,
+      mem->mem.offset + offset, size);
+}
+
+static gboolean
+_numa_is_span (GstMemoryNuma * mem1, GstMemoryNuma * mem2, gsize * offset)
+{
+  if (offset) {
+    GstMemoryNuma *parent;
+
+    parent = (GstMemoryNuma *) mem1->mem.parent;
+
+    *offset = mem1->mem.offset - parent->mem.offset;
+  }
+
+  /* and memory is contiguous */
+  return mem1->data + mem1->mem.offset + mem1->mem.size ==
+      mem2->data + mem2->mem.offset;
+}
+
+static void
+gst_allocator_numa_finalize (GObject * obj)
+{
+  GstAllocatorNuma *numa = (GstAllocatorNuma *) obj;
+
+  gst_object_unref (numa->sysmem);
+  g_free (numa->cpu_nodes);
+
+  ((GObjectClass *) gst_allocator_numa_parent_class)->finalize (obj);
+}
+
+static void
+gst_allocator_numa_class_init (GstAllocatorNumaClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstAllocatorClass *allocator_class;
+
+  gobject_class = (GObjectClass *) klass;
+  allocator_class = (GstAllocatorClass *) klass;
+
+  gobject_class->finalize = gst_allocator_numa_finalize;
+
+  allocator_class->alloc = gst_allocator_numa_alloc;
+  allocator_class->free = gst_allocator_numa_free;
+}
+
+static void
+gst_allocator_numa_init (GstAllocatorNuma * numa)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (numa);
+  const gchar *env;
+
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "init allocator %p", numa);
+
+  alloc->mem_type = GST_ALLOCATOR_SYSMEM_NUMA;
+  alloc->mem_map = (GstMemoryMapFunction) _numa_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) _numa_unmap;
+  alloc->mem_copy = (GstMemoryCopyFunction) _numa_copy;
+  alloc->mem_share = (GstMemoryShareFunction) _numa_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) _numa_is_span;
+
+  numa->sysmem = gst_allocator_find (GST_ALLOCATOR_SYSMEM);
+  numa->page_size = sysconf (_SC_PAGESIZE);
+  numa->hugepage_threshold = NUMA_HUGEPAGE_SIZE;
+  numa->use_hugetlb = TRUE;
+
+  if ((env = g_getenv ("GST_ALLOCATOR_HUGEPAGE_THRESHOLD")))
+    numa->hugepage_threshold = g_ascii_strtoull (env, NULL, 10);
+
+  read_topology (numa);
+}
+
+/* must be called after the system memory allocator is registered */
+GstAllocator *
+_priv_gst_allocator_numa_new (void)
+{
+  return g_object_new (gst_allocator_numa_get_type (), NULL);
+}
+
+#else /* !HAVE_NUMA_ALLOCATOR */
+
+GstAllocator *
+_priv_gst_allocator_numa_new (void)
+{
+  return NULL;
+}
+
+#endif /* HAVE_NUMA_ALLOCATOR */
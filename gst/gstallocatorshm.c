@@ -0,0 +1,367 @@
+/* GStreamer
+ *
+ * gstallocatorshm.c: shared memory allocator
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The shared memory allocator backs every block with its own anonymous
+ * memfd, which is mapped shared. The fd of a memory can be retrieved with
+ * gst_shm_memory_get_fd() and passed to another process, for example over a
+ * Unix socket, where gst_shm_memory_new_from_fd() maps the same pages again
+ * without copying the data.
+ *
+ * The size of the memfd is sealed when the kernel supports it, so that the
+ * receiving process can't be made to fault by truncating it. Memory imported
+ * from an fd is read-only, writing to it requires a copy.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#define _GNU_SOURCE 1
+
+#include "gst_private.h"
+#include "gstmemory.h"
+
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_MMAN_H)
+#define HAVE_SHM_ALLOCATOR 1
+#endif
+
+#ifdef HAVE_SHM_ALLOCATOR
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef struct
+{
+  GstMemory mem;
+
+  gint fd;
+  guint8 *data;
+} GstMemoryShm;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstAllocatorShm;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstAllocatorShmClass;
+
+static GType gst_allocator_shm_get_type (void);
+G_DEFINE_TYPE (GstAllocatorShm, gst_allocator_shm, GST_TYPE_ALLOCATOR);
+
+/* the registered allocator, also used for memory imported with
+ * gst_shm_memory_new_from_fd(). The allocator registry keeps it alive. */
+static GstAllocator *_shm_allocator;
+
+static GstMemoryShm *
+_shm_new (GstAllocator * allocator, GstMemoryFlags flags, GstMemory * parent,
+    gint fd, guint8 * data, gsize maxsize, gsize align, gsize offset,
+    gsize size)
+{
+  GstMemoryShm *mem;
+
+  mem = g_slice_new (GstMemoryShm);
+  gst_memory_init (GST_MEMORY_CAST (mem), flags, allocator, parent, maxsize,
+      align, offset, size);
+
+  mem->fd = fd;
+  mem->data = data;
+
+  return mem;
+}
+
+static GstMemory *
+gst_allocator_shm_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  gsize maxsize;
+  guint8 *data;
+  gint fd;
+
+  maxsize = size + params->prefix + params->padding;
+
+  /* the mapping is page aligned, which is enough for any sensible
+   * alignment */
+  fd = memfd_create ("gst-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "memfd_create failed: %s",
+        g_strerror (errno));
+    return NULL;
+  }
+
+  if (ftruncate (fd, maxsize) < 0) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "failed to resize memfd to %"
+        G_GSIZE_FORMAT " bytes: %s", maxsize, g_strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+#ifdef F_ADD_SEALS
+  if (fcntl (fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0)
+    GST_CAT_DEBUG (GST_CAT_MEMORY, "failed to seal memfd: %s",
+        g_strerror (errno));
+#endif
+
+  data = mmap (NULL, maxsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "failed to map memfd: %s",
+        g_strerror (errno));
+    close (fd);
+    return NULL;
+  }
+
+  /* a new memfd is zero filled, so prefix and padding are zeroed already */
+  return (GstMemory *) _shm_new (allocator, params->flags, NULL, fd, data,
+      maxsize, params->align | gst_memory_alignment, params->prefix, size);
+}
+
+static void
+gst_allocator_shm_free (GstAllocator * allocator, GstMemory * memory)
+{
+  GstMemoryShm *mem = (GstMemoryShm *) memory;
+
+  /* shared memory uses the mapping and the fd of its parent */
+  if (memory->parent == NULL) {
+    munmap (mem->data, memory->maxsize);
+    close (mem->fd);
+  }
+
+  g_slice_free (GstMemoryShm, mem);
+}
+
+static gpointer
+_shm_map (GstMemoryShm * mem, gsize maxsize, GstMapFlags flags)
+{
+  return mem->data;
+}
+
+static gboolean
+_shm_unmap (GstMemoryShm * mem)
+{
+  return TRUE;
+}
+
+static GstMemoryShm *
+_shm_copy (GstMemoryShm * mem, gssize offset, gsize size)
+{
+  GstAllocationParams params = { 0, mem->mem.align, 0, 0, };
+  GstMemory *copy;
+  GstMapInfo map;
+
+  if (size == -1)
+    size = mem->mem.size > offset ? mem->mem.size - offset : 0;
+
+  /* memory imported from another process always copies into new memory of
+   * our own allocator */
+  copy = gst_allocator_alloc (_shm_allocator, size, &params);
+  if (copy == NULL || !gst_memory_map (copy, &map, GST_MAP_WRITE)) {
+    if (copy)
+      gst_memory_unref (copy);
+    return NULL;
+  }
+
+  GST_CAT_DEBUG (GST_CAT_PERFORMANCE,
+      "memcpy %" G_GSIZE_FORMAT " memory %p -> %p", size, mem, copy);
+  memcpy (map.data, mem->data + mem->mem.offset + offset, size);
+  gst_memory_unmap (copy, &map);
+
+  return (GstMemoryShm *) copy;
+}
+
+static GstMemoryShm *
+_shm_share (GstMemoryShm * mem, gssize offset, gsize size)
+{
+  GstMemory *parent;
+
+  /* find the real parent */
+  if ((parent = mem->mem.parent) == NULL)
+    parent = (GstMemory *) mem;
+
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  /* the shared memory is always readonly */
+  return _shm_new (mem->mem.allocator,
+      GST_MINI_OBJECT_FLAGS (parent) | GST_MINI_OBJECT_FLAG_LOCK_READONLY,
+      parent, mem->fd, mem->data, mem->mem.maxsize, mem->mem.align,
+      mem->mem.offset + offset, size);
+}
+
+static gboolean
+_shm_is_span (GstMemoryShm * mem1, GstMemoryShm * mem2, gsize * offset)
+{
+  if (offset) {
+    GstMemoryShm *parent;
+
+    parent = (GstMemoryShm *) mem1->mem.parent;
+
+    *offset = mem1->mem.offset - parent->mem.offset;
+  }
+
+  /* and memory is contiguous */
+  return mem1->data + mem1->mem.offset + mem1->mem.size ==
+      mem2->data + mem2->mem.offset;
+}
+
+static void
+gst_allocator_shm_class_init (GstAllocatorShmClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_allocator_shm_alloc;
+  allocator_class->free = gst_allocator_shm_free;
+}
+
+static void
+gst_allocator_shm_init (GstAllocatorShm * shm)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (shm);
+
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "init allocator %p", shm);
+
+  alloc->mem_type = GST_ALLOCATOR_SHM;
+  alloc->mem_map = (GstMemoryMapFunction) _shm_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) _shm_unmap;
+  alloc->mem_copy = (GstMemoryCopyFunction) _shm_copy;
+  alloc->mem_share = (GstMemoryShareFunction) _shm_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) _shm_is_span;
+}
+
+/* the returned allocator must be registered */
+GstAllocator *
+_priv_gst_allocator_shm_new (void)
+{
+  _shm_allocator = g_object_new (gst_allocator_shm_get_type (), NULL);
+
+  return _shm_allocator;
+}
+
+/**
+ * gst_shm_memory_get_fd:
+ * @mem: a #GstMemory
+ *
+ * Gets the file descriptor of memory allocated by the #GST_ALLOCATOR_SHM
+ * allocator. The data of @mem starts at the offset of @mem in the file, see
+ * gst_memory_get_sizes(). The file descriptor stays owned by @mem.
+ *
+ * Returns: the file descriptor of @mem, or -1 when @mem is not shared memory.
+ *
+ * Since: 1.20
+ */
+gint
+gst_shm_memory_get_fd (GstMemory * mem)
+{
+  g_return_val_if_fail (mem != NULL, -1);
+
+  if (mem->allocator == NULL || !gst_memory_is_type (mem, GST_ALLOCATOR_SHM))
+    return -1;
+
+  return ((GstMemoryShm *) mem)->fd;
+}
+
+/**
+ * gst_shm_memory_new_from_fd:
+ * @fd: a file descriptor
+ * @maxsize: the size of the file
+ * @offset: offset of the data in @fd
+ * @size: size of the data
+ *
+ * Maps @maxsize bytes of @fd, typically received from another process, and
+ * wraps them in a read-only #GstMemory of the #GST_ALLOCATOR_SHM allocator.
+ * This function takes ownership of @fd, it is closed when the memory is freed
+ * or when it can't be mapped.
+ *
+ * Returns: (transfer full) (nullable): a new #GstMemory, or %NULL when @fd
+ *   is too small or can't be mapped.
+ *
+ * Since: 1.20
+ */
+GstMemory *
+gst_shm_memory_new_from_fd (gint fd, gsize maxsize, gsize offset, gsize size)
+{
+  struct stat st;
+  guint8 *data;
+
+  g_return_val_if_fail (fd >= 0, NULL);
+  g_return_val_if_fail (offset + size <= maxsize, NULL);
+
+  if (_shm_allocator == NULL || maxsize == 0)
+    goto error;
+
+  if (fstat (fd, &st) < 0 || (gsize) st.st_size < maxsize) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "fd %d is too small for %" G_GSIZE_FORMAT
+        " bytes", fd, maxsize);
+    goto error;
+  }
+
+  data = mmap (NULL, maxsize, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    GST_CAT_WARNING (GST_CAT_MEMORY, "failed to map fd %d: %s", fd,
+        g_strerror (errno));
+    goto error;
+  }
+
+  return (GstMemory *) _shm_new (_shm_allocator, GST_MEMORY_FLAG_READONLY,
+      NULL, fd, data, maxsize, gst_memory_alignment, offset, size);
+
+error:
+  close (fd);
+  return NULL;
+}
+
+#else /* !HAVE_SHM_ALLOCATOR */
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
+
+GstAllocator *
+_priv_gst_allocator_shm_new (void)
+{
+  return NULL;
+}
+
+gint
+gst_shm_memory_get_fd (GstMemory * mem)
+{
+  g_return_val_if_fail (mem != NULL, -1);
+
+  return -1;
+}
+
+GstMemory *
+gst_shm_memory_new_from_fd (gint fd, gsize maxsize, gsize offset, gsize size)
+{
+  g_return_val_if_fail (fd >= 0, NULL);
+
+  close (fd);
+  return NULL;
+}
+
+#endif /* HAVE_SHM_ALLOCATOR */
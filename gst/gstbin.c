@@ -142,6 +142,9 @@
 #include "gstutils.h"
 #include "gstchildproxy.h"
 
+/* For g_memdup2 */
+#include "glib-compat-private.h"
+
 GST_DEBUG_CATEGORY_STATIC (bin_debug);
 #define GST_CAT_DEFAULT bin_debug
 
@@ -172,6 +175,50 @@ struct _GstBinPrivate
   gboolean posted_eos;
   gboolean posted_playing;
   GstElementFlags suppressed_flags;
+
+  /* thread configuration for the tasks of our children */
+  GstTaskScheduling task_scheduling;
+  gint task_priority;
+  gchar *task_cpus_str;
+  guint *task_cpus;
+  guint n_task_cpus;
+
+  /* pool to change the state of independent children at the same time */
+  GstTaskPool *state_change_pool;
+
+  /* updated whenever a pad link or unlink of a child finished */
+  guint32 link_cookie;
+  /* children in topologically sorted order, with the children_cookie and
+   * link_cookie they were sorted with */
+  GArray *sort_cache;
+  guint32 sort_cache_children_cookie;
+  guint32 sort_cache_link_cookie;
+
+  /* latency recalculations, concurrent requests are collapsed into one more
+   * run of the thread that is recalculating */
+  GCond latency_cond;
+  GThread *latency_thread;
+  guint64 latency_requested;
+  guint64 latency_handled;
+  gboolean latency_res;
+  /* last configured latency, the LATENCY event is only sent again when it
+   * changes or when the pipeline changed since */
+  GstClockTime configured_latency;
+  gboolean latency_dirty;
+
+  /* the children by name, parented elements can't be renamed */
+  GHashTable *children_by_name;
+
+  /* index of the cached messages, the message links per source and the
+   * number of messages per type */
+  GHashTable *message_index;
+  guint n_messages[32];
+  /* sinks that did not post EOS or STREAM_START when last checked, valid
+   * as long as the children_cookie did not change */
+  GstElement *eos_pending_sink;
+  guint32 eos_pending_cookie;
+  GstElement *stream_start_pending_sink;
+  guint32 stream_start_pending_cookie;
 };
 
 typedef struct
@@ -181,6 +228,7 @@ typedef struct
 } BinContinueData;
 
 static void gst_bin_dispose (GObject * object);
+static void gst_bin_finalize (GObject * object);
 
 static void gst_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -246,12 +294,18 @@ enum
 
 #define DEFAULT_ASYNC_HANDLING	FALSE
 #define DEFAULT_MESSAGE_FORWARD	FALSE
+#define DEFAULT_TASK_SCHEDULING	GST_TASK_SCHEDULING_INHERIT
+#define DEFAULT_TASK_PRIORITY	0
 
 enum
 {
   PROP_0,
   PROP_ASYNC_HANDLING,
   PROP_MESSAGE_FORWARD,
+  PROP_TASK_SCHEDULING,
+  PROP_TASK_PRIORITY,
+  PROP_TASK_CPUS,
+  PROP_STATE_CHANGE_POOL,
   PROP_LAST
 };
 
@@ -446,7 +500,78 @@ gst_bin_class_init (GstBinClass * klass)
           "Forwards all children messages",
           DEFAULT_MESSAGE_FORWARD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstBin:task-scheduling:
+   *
+   * The scheduling policy for the threads of the tasks that are created
+   * by the elements in the bin, including the elements in child bins.
+   * It is applied to every task that has no scheduling policy configured
+   * when the task is created, so a child bin can override the policy of
+   * its parent. See gst_task_set_scheduling().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_SCHEDULING,
+      g_param_spec_enum ("task-scheduling", "Task Scheduling",
+          "Scheduling policy for the streaming threads of the children",
+          GST_TYPE_TASK_SCHEDULING, DEFAULT_TASK_SCHEDULING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBin:task-priority:
+   *
+   * The realtime priority used together with #GstBin:task-scheduling.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_PRIORITY,
+      g_param_spec_int ("task-priority", "Task Priority",
+          "Realtime priority for the streaming threads of the children",
+          0, 99, DEFAULT_TASK_PRIORITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBin:task-cpus:
+   *
+   * A comma separated list of CPUs and CPU ranges, like "0,2-3", for the
+   * threads of the tasks that are created by the elements in the bin.
+   * Like #GstBin:task-scheduling, it is only applied to tasks that have
+   * no CPU affinity configured yet. See gst_task_set_cpu_affinity().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_CPUS,
+      g_param_spec_string ("task-cpus", "Task CPUs",
+          "CPUs for the streaming threads of the children, like \"0,2-3\" "
+          "(NULL = no restriction)", NULL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBin:state-change-pool:
+   *
+   * A #GstTaskPool, for example a #GstSharedTaskPool, to change the state of
+   * the children from. With a pool, the children are still changed in
+   * topological order, sinks first, but all children that are not linked
+   * to each other through a chain of children that still needs to change
+   * state change their state at the same time. This speeds up state changes
+   * of bins with many elements that open devices, sockets or files.
+   *
+   * The thread doing the state change of the bin helps out with the state
+   * changes on the pool, so a pool with fewer threads than children, or one
+   * that is shared with child bins, works too.
+   *
+   * The pool must have been prepared with gst_task_pool_prepare().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATE_CHANGE_POOL,
+      g_param_spec_object ("state-change-pool", "State change pool",
+          "Task pool to change the state of independent children at the same "
+          "time (NULL = one after the other)", GST_TYPE_TASK_POOL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->dispose = gst_bin_dispose;
+  gobject_class->finalize = gst_bin_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class, "Generic bin",
       "Generic/Bin",
@@ -505,6 +630,14 @@ gst_bin_init (GstBin * bin)
   bin->priv->asynchandling = DEFAULT_ASYNC_HANDLING;
   bin->priv->structure_cookie = 0;
   bin->priv->message_forward = DEFAULT_MESSAGE_FORWARD;
+  bin->priv->task_scheduling = DEFAULT_TASK_SCHEDULING;
+  bin->priv->task_priority = DEFAULT_TASK_PRIORITY;
+  g_cond_init (&bin->priv->latency_cond);
+  bin->priv->message_index = g_hash_table_new (NULL, NULL);
+  bin->priv->children_by_name =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  bin->priv->configured_latency = GST_CLOCK_TIME_NONE;
+  bin->priv->latency_dirty = TRUE;
 }
 
 static void
@@ -522,6 +655,11 @@ gst_bin_dispose (GObject * object)
   gst_object_replace ((GstObject **) provided_clock_p, NULL);
   gst_object_replace ((GstObject **) clock_provider_p, NULL);
   bin_remove_messages (bin, NULL, GST_MESSAGE_ANY);
+  g_clear_pointer (&bin->priv->task_cpus_str, g_free);
+  g_clear_pointer (&bin->priv->task_cpus, g_free);
+  bin->priv->n_task_cpus = 0;
+  gst_object_replace ((GstObject **) & bin->priv->state_change_pool, NULL);
+  g_clear_pointer (&bin->priv->sort_cache, g_array_unref);
   GST_OBJECT_UNLOCK (object);
 
   while (bin->children) {
@@ -535,6 +673,18 @@ gst_bin_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_bin_finalize (GObject * object)
+{
+  GstBin *bin = GST_BIN_CAST (object);
+
+  g_cond_clear (&bin->priv->latency_cond);
+  g_hash_table_destroy (bin->priv->message_index);
+  g_hash_table_destroy (bin->priv->children_by_name);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 /**
  * gst_bin_new:
  * @name: (allow-none): the name of the new bin
@@ -549,6 +699,98 @@ gst_bin_new (const gchar * name)
   return gst_element_factory_make ("bin", name);
 }
 
+/* parse a list of CPUs like "0,2-3" */
+static guint *
+parse_cpu_list (const gchar * str, guint * n_cpus)
+{
+  GArray *cpus;
+  gchar **ranges;
+  guint i;
+
+  cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  ranges = g_strsplit (str, ",", -1);
+  for (i = 0; ranges[i]; i++) {
+    guint64 first, last;
+    gchar *end;
+
+    g_strstrip (ranges[i]);
+    if (ranges[i][0] == '\0')
+      continue;
+
+    first = g_ascii_strtoull (ranges[i], &end, 10);
+    if (end == ranges[i])
+      goto parse_error;
+    last = first;
+    if (*end == '-') {
+      gchar *start = end + 1;
+
+      last = g_ascii_strtoull (start, &end, 10);
+      if (end == start)
+        goto parse_error;
+    }
+    if (*end != '\0' || last < first || last >= G_MAXUINT16)
+      goto parse_error;
+
+    for (; first <= last; first++) {
+      guint cpu = first;
+
+      g_array_append_val (cpus, cpu);
+    }
+  }
+  g_strfreev (ranges);
+
+  *n_cpus = cpus->len;
+  return (guint *) g_array_free (cpus, cpus->len == 0);
+
+parse_error:
+  {
+    g_warning ("invalid CPU list '%s'", str);
+    g_strfreev (ranges);
+    g_array_free (cpus, TRUE);
+    *n_cpus = 0;
+    return NULL;
+  }
+}
+
+/* configure a task of a child with our defaults, unless the task or a bin
+ * closer to the task configured it already */
+static void
+bin_configure_task (GstBin * bin, GstTask * task)
+{
+  GstTaskScheduling scheduling;
+  gint priority;
+  guint *cpus = NULL, n_cpus;
+
+  GST_OBJECT_LOCK (bin);
+  scheduling = bin->priv->task_scheduling;
+  priority = bin->priv->task_priority;
+  n_cpus = bin->priv->n_task_cpus;
+  if (n_cpus)
+    cpus = g_memdup2 (bin->priv->task_cpus, n_cpus * sizeof (guint));
+  GST_OBJECT_UNLOCK (bin);
+
+  if (scheduling != GST_TASK_SCHEDULING_INHERIT &&
+      gst_task_get_scheduling (task, NULL) == GST_TASK_SCHEDULING_INHERIT) {
+    GST_DEBUG_OBJECT (bin, "configuring scheduling of %" GST_PTR_FORMAT,
+        task);
+    gst_task_set_scheduling (task, scheduling, priority);
+  }
+
+  if (cpus) {
+    guint n_task_cpus;
+    guint *task_cpus = gst_task_get_cpu_affinity (task, &n_task_cpus);
+
+    if (task_cpus == NULL) {
+      GST_DEBUG_OBJECT (bin, "configuring CPU affinity of %" GST_PTR_FORMAT,
+          task);
+      gst_task_set_cpu_affinity (task, cpus, n_cpus);
+    }
+    g_free (task_cpus);
+    g_free (cpus);
+  }
+}
+
 static void
 gst_bin_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -568,6 +810,38 @@ gst_bin_set_property (GObject * object, guint prop_id,
       gstbin->priv->message_forward = g_value_get_boolean (value);
       GST_OBJECT_UNLOCK (gstbin);
       break;
+    case PROP_TASK_SCHEDULING:
+      GST_OBJECT_LOCK (gstbin);
+      gstbin->priv->task_scheduling = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_TASK_PRIORITY:
+      GST_OBJECT_LOCK (gstbin);
+      gstbin->priv->task_priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_TASK_CPUS:{
+      const gchar *str = g_value_get_string (value);
+      guint *cpus = NULL, n_cpus = 0;
+
+      if (str)
+        cpus = parse_cpu_list (str, &n_cpus);
+
+      GST_OBJECT_LOCK (gstbin);
+      g_free (gstbin->priv->task_cpus_str);
+      gstbin->priv->task_cpus_str = cpus ? g_strdup (str) : NULL;
+      g_free (gstbin->priv->task_cpus);
+      gstbin->priv->task_cpus = cpus;
+      gstbin->priv->n_task_cpus = n_cpus;
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    }
+    case PROP_STATE_CHANGE_POOL:
+      GST_OBJECT_LOCK (gstbin);
+      gst_object_replace ((GstObject **) & gstbin->priv->state_change_pool,
+          g_value_get_object (value));
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -593,6 +867,26 @@ gst_bin_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, gstbin->priv->message_forward);
       GST_OBJECT_UNLOCK (gstbin);
       break;
+    case PROP_TASK_SCHEDULING:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_enum (value, gstbin->priv->task_scheduling);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_TASK_PRIORITY:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_int (value, gstbin->priv->task_priority);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_TASK_CPUS:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_string (value, gstbin->priv->task_cpus_str);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_STATE_CHANGE_POOL:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_object (value, gstbin->priv->state_change_pool);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -863,17 +1157,80 @@ message_check (GstMessage * message, MessageFind * target)
   return (eq ? 0 : 1);
 }
 
+#define MESSAGE_TYPE_INDEX(type) (g_bit_nth_lsf ((guint32) (type), -1))
+
+/* with LOCK. Add a link of the messages list to the index */
+static void
+bin_index_message (GstBin * bin, GList * link)
+{
+  GstMessage *message = link->data;
+  GstObject *src = GST_MESSAGE_SRC (message);
+  GList *links;
+
+  links = g_hash_table_lookup (bin->priv->message_index, src);
+  g_hash_table_insert (bin->priv->message_index, src,
+      g_list_prepend (links, link));
+  bin->priv->n_messages[MESSAGE_TYPE_INDEX (GST_MESSAGE_TYPE (message))]++;
+}
+
+/* with LOCK. Remove a message from the index and the messages list and
+ * unref it */
+static void
+bin_delete_message (GstBin * bin, GList * link)
+{
+  GstMessage *message = link->data;
+  GstObject *src = GST_MESSAGE_SRC (message);
+  GList *links;
+
+  links = g_hash_table_lookup (bin->priv->message_index, src);
+  links = g_list_remove (links, link);
+  if (links)
+    g_hash_table_insert (bin->priv->message_index, src, links);
+  else
+    g_hash_table_remove (bin->priv->message_index, src);
+  bin->priv->n_messages[MESSAGE_TYPE_INDEX (GST_MESSAGE_TYPE (message))]--;
+
+  bin->messages = g_list_delete_link (bin->messages, link);
+  gst_message_unref (message);
+}
+
+/* with LOCK. Check if any message of the given types is cached */
+static gboolean
+has_message (GstBin * bin, GstMessageType types)
+{
+  gint i = -1;
+
+  while ((i = g_bit_nth_lsf ((guint32) types, i)) != -1) {
+    if (bin->priv->n_messages[i] > 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
 static GList *
 find_message (GstBin * bin, GstObject * src, GstMessageType types)
 {
-  GList *result;
+  GList *result = NULL;
   MessageFind find;
 
   find.src = src;
   find.types = types;
 
-  result = g_list_find_custom (bin->messages, &find,
-      (GCompareFunc) message_check);
+  if (src) {
+    GList *links;
+
+    /* only look at the few messages of this source */
+    links = g_hash_table_lookup (bin->priv->message_index, src);
+    for (; links; links = links->next) {
+      if (message_check (((GList *) links->data)->data, &find) == 0) {
+        result = links->data;
+        break;
+      }
+    }
+  } else if (has_message (bin, types)) {
+    result = g_list_find_custom (bin->messages, &find,
+        (GCompareFunc) message_check);
+  }
 
   if (result) {
     GST_DEBUG_OBJECT (bin, "we found a message %p from %s matching types %08x",
@@ -916,6 +1273,10 @@ bin_replace_message (GstBin * bin, GstMessage * message, GstMessageType types)
       /* if we found a previous message, replace it */
       previous_msg = previous->data;
       previous->data = message;
+      bin->priv->n_messages[MESSAGE_TYPE_INDEX (GST_MESSAGE_TYPE
+              (previous_msg))]--;
+      bin->priv->n_messages[MESSAGE_TYPE_INDEX (GST_MESSAGE_TYPE
+              (message))]++;
 
       GST_DEBUG_OBJECT (bin, "replace old message %s from %s with %s message",
           GST_MESSAGE_TYPE_NAME (previous_msg), GST_ELEMENT_NAME (src),
@@ -925,6 +1286,7 @@ bin_replace_message (GstBin * bin, GstMessage * message, GstMessageType types)
     } else {
       /* keep new message */
       bin->messages = g_list_prepend (bin->messages, message);
+      bin_index_message (bin, bin->messages);
 
       GST_DEBUG_OBJECT (bin, "got new message %p, %s from %s",
           message, GST_MESSAGE_TYPE_NAME (message), GST_ELEMENT_NAME (src));
@@ -948,6 +1310,25 @@ bin_remove_messages (GstBin * bin, GstObject * src, GstMessageType types)
   find.src = src;
   find.types = types;
 
+  if (src) {
+    /* only look at the messages of this source */
+    walk = g_list_copy (g_hash_table_lookup (bin->priv->message_index, src));
+    for (next = walk; next; next = next->next) {
+      GList *link = next->data;
+
+      if (message_check (link->data, &find) == 0) {
+        GST_DEBUG_OBJECT (src, "deleting message %p of type %s (types 0x%08x)",
+            link->data, GST_MESSAGE_TYPE_NAME (link->data), types);
+        bin_delete_message (bin, link);
+      }
+    }
+    g_list_free (walk);
+    return;
+  }
+
+  if (!has_message (bin, types))
+    return;
+
   for (walk = bin->messages; walk; walk = next) {
     GstMessage *message = (GstMessage *) walk->data;
 
@@ -957,8 +1338,7 @@ bin_remove_messages (GstBin * bin, GstObject * src, GstMessageType types)
       GST_DEBUG_OBJECT (GST_MESSAGE_SRC (message),
           "deleting message %p of type %s (types 0x%08x)", message,
           GST_MESSAGE_TYPE_NAME (message), types);
-      bin->messages = g_list_delete_link (bin->messages, walk);
-      gst_message_unref (message);
+      bin_delete_message (bin, walk);
     } else {
       GST_DEBUG_OBJECT (GST_MESSAGE_SRC (message),
           "not deleting message %p of type 0x%08x", message,
@@ -968,6 +1348,19 @@ bin_remove_messages (GstBin * bin, GstObject * src, GstMessageType types)
 }
 
 
+/* with LOCK. Check if the sink remembered from the previous check is still
+ * a child and still did not post a message of @type */
+static gboolean
+pending_sink_is_waiting (GstBin * bin, GstElement * sink, guint32 cookie,
+    GstMessageType type)
+{
+  if (sink == NULL || cookie != bin->children_cookie)
+    return FALSE;
+
+  return bin_element_is_sink (sink, bin) == 0
+      && !find_message (bin, GST_OBJECT_CAST (sink), type);
+}
+
 /* Check if the bin is EOS. We do this by scanning all sinks and
  * checking if they posted an EOS message.
  *
@@ -979,6 +1372,12 @@ is_eos (GstBin * bin, guint32 * seqnum)
   gint n_eos = 0;
   GList *walk, *msgs;
 
+  /* most of the time the sink that stopped the last scan is still not EOS */
+  if (pending_sink_is_waiting (bin, bin->priv->eos_pending_sink,
+          bin->priv->eos_pending_cookie, GST_MESSAGE_EOS))
+    return FALSE;
+  bin->priv->eos_pending_sink = NULL;
+
   result = TRUE;
   for (walk = bin->children; walk; walk = g_list_next (walk)) {
     GstElement *element;
@@ -994,6 +1393,8 @@ is_eos (GstBin * bin, guint32 * seqnum)
       } else {
         GST_DEBUG ("sink '%s' did not post EOS yet",
             GST_ELEMENT_NAME (element));
+        bin->priv->eos_pending_sink = element;
+        bin->priv->eos_pending_cookie = bin->children_cookie;
         result = FALSE;
         break;
       }
@@ -1025,6 +1426,12 @@ is_stream_start (GstBin * bin, guint32 * seqnum, gboolean * have_group_id,
 
   *have_group_id = FALSE;
   *group_id = 0;
+
+  if (pending_sink_is_waiting (bin, bin->priv->stream_start_pending_sink,
+          bin->priv->stream_start_pending_cookie, GST_MESSAGE_STREAM_START))
+    return FALSE;
+  bin->priv->stream_start_pending_sink = NULL;
+
   result = FALSE;
   for (walk = bin->children; walk; walk = g_list_next (walk)) {
     GstElement *element;
@@ -1064,6 +1471,8 @@ is_stream_start (GstBin * bin, guint32 * seqnum, gboolean * have_group_id,
       } else {
         GST_DEBUG ("sink '%s' did not post STREAM_START yet",
             GST_ELEMENT_NAME (element));
+        bin->priv->stream_start_pending_sink = element;
+        bin->priv->stream_start_pending_cookie = bin->children_cookie;
         result = FALSE;
         break;
       }
@@ -1188,7 +1597,8 @@ gst_bin_add_func (GstBin * bin, GstElement * element)
    * we can safely take the lock here. This check is probably bogus because
    * you can safely change the element name after this check and before setting
    * the object parent. The window is very small though... */
-  if (G_UNLIKELY (!gst_object_check_uniqueness (bin->children, elem_name)))
+  if (G_UNLIKELY (g_hash_table_contains (bin->priv->children_by_name,
+              elem_name)))
     goto duplicate_name;
 
   /* set the element's parent and add the element to the bin's list of children */
@@ -1221,6 +1631,8 @@ gst_bin_add_func (GstBin * bin, GstElement * element)
   }
 
   bin->children = g_list_prepend (bin->children, element);
+  g_hash_table_insert (bin->priv->children_by_name, g_strdup (elem_name),
+      element);
   bin->numchildren++;
   bin->children_cookie++;
   if (!GST_BIN_IS_NO_RESYNC (bin))
@@ -1462,6 +1874,10 @@ gst_bin_deep_element_added_func (GstBin * bin, GstBin * sub_bin,
 {
   GstBin *parent_bin;
 
+  GST_OBJECT_LOCK (bin);
+  bin->priv->latency_dirty = TRUE;
+  GST_OBJECT_UNLOCK (bin);
+
   parent_bin = (GstBin *) gst_object_get_parent (GST_OBJECT_CAST (bin));
   if (parent_bin == NULL) {
     GST_LOG_OBJECT (bin, "no parent, reached top-level");
@@ -1485,6 +1901,10 @@ gst_bin_deep_element_removed_func (GstBin * bin, GstBin * sub_bin,
 {
   GstBin *parent_bin;
 
+  GST_OBJECT_LOCK (bin);
+  bin->priv->latency_dirty = TRUE;
+  GST_OBJECT_UNLOCK (bin);
+
   parent_bin = (GstBin *) gst_object_get_parent (GST_OBJECT_CAST (bin));
   if (parent_bin == NULL) {
     GST_LOG_OBJECT (bin, "no parent, reached top-level");
@@ -1648,6 +2068,8 @@ gst_bin_remove_func (GstBin * bin, GstElement * element)
   if (G_UNLIKELY (!found))
     goto not_in_bin;
 
+  g_hash_table_remove (bin->priv->children_by_name, elem_name);
+
   /* we now removed the element from the list of elements, increment the cookie
    * so that others can detect a change in the children list. */
   bin->numchildren--;
@@ -1697,62 +2119,42 @@ gst_bin_remove_func (GstBin * bin, GstElement * element)
   /* remove messages for the element, if there was a pending ASYNC_START
    * message we must see if removing the element caused the bin to lose its
    * async state. */
-  this_async = FALSE;
-  other_async = FALSE;
+  this_async = find_message (bin, GST_OBJECT_CAST (element),
+      GST_MESSAGE_ASYNC_START) != NULL;
+  other_async = bin->priv->n_messages[MESSAGE_TYPE_INDEX
+      (GST_MESSAGE_ASYNC_START)] > (this_async ? 1 : 0);
   /* If we remove an EOSed element, the bin might go EOS */
-  removed_eos = FALSE;
-  for (walk = bin->messages; walk; walk = next) {
-    GstMessage *message = (GstMessage *) walk->data;
-    GstElement *src = GST_ELEMENT_CAST (GST_MESSAGE_SRC (message));
-    gboolean remove;
-
-    next = g_list_next (walk);
-    remove = FALSE;
-
-    switch (GST_MESSAGE_TYPE (message)) {
-      case GST_MESSAGE_ASYNC_START:
-        if (src == element)
-          this_async = TRUE;
-        else
-          other_async = TRUE;
+  removed_eos = find_message (bin, GST_OBJECT_CAST (element),
+      GST_MESSAGE_EOS) != NULL;
+
+  /* it's unlikely that a structure change message is still in the list of
+   * messages because this would mean that a link/unlink is busy in another
+   * thread while we remove the element. We still have to remove the message
+   * because we might not receive the done message anymore when the element
+   * is removed from the bin. */
+  if (has_message (bin, GST_MESSAGE_STRUCTURE_CHANGE)) {
+    for (walk = bin->messages; walk; walk = next) {
+      GstMessage *message = (GstMessage *) walk->data;
+      GstElement *owner;
+
+      next = g_list_next (walk);
+
+      if (GST_MESSAGE_TYPE (message) != GST_MESSAGE_STRUCTURE_CHANGE)
+        continue;
 
-        GST_DEBUG_OBJECT (src, "looking at message %p", message);
-        break;
-      case GST_MESSAGE_STRUCTURE_CHANGE:
-      {
-        GstElement *owner;
-
-        GST_DEBUG_OBJECT (src, "looking at structure change message %p",
-            message);
-        /* it's unlikely that this message is still in the list of messages
-         * because this would mean that a link/unlink is busy in another thread
-         * while we remove the element. We still have to remove the message
-         * because we might not receive the done message anymore when the element
-         * is removed from the bin. */
-        gst_message_parse_structure_change (message, NULL, &owner, NULL);
-        if (owner == element)
-          remove = TRUE;
-        break;
-      }
-      case GST_MESSAGE_EOS:
-        if (src == element)
-          removed_eos = TRUE;
-        break;
-      default:
-        break;
-    }
-    if (src == element)
-      remove = TRUE;
-
-    if (remove) {
-      /* delete all message types */
-      GST_DEBUG_OBJECT (src, "deleting message %p of element \"%s\"",
-          message, elem_name);
-      bin->messages = g_list_delete_link (bin->messages, walk);
-      gst_message_unref (message);
+      GST_DEBUG_OBJECT (GST_MESSAGE_SRC (message),
+          "looking at structure change message %p", message);
+      gst_message_parse_structure_change (message, NULL, &owner, NULL);
+      if (owner == element)
+        bin_delete_message (bin, walk);
     }
   }
 
+  /* delete all message types */
+  GST_DEBUG_OBJECT (element, "deleting messages of element \"%s\"",
+      elem_name);
+  bin_remove_messages (bin, GST_OBJECT_CAST (element), GST_MESSAGE_ANY);
+
   /* get last return */
   ret = GST_STATE_RETURN (bin);
 
@@ -1911,6 +2313,9 @@ no_function:
  *
  * Gets an iterator for the elements in this bin.
  *
+ * Since 1.20 the iterator works on a snapshot of the children taken when it
+ * is created and never returns %GST_ITERATOR_RESYNC.
+ *
  * Returns: (transfer full) (nullable): a #GstIterator of #GstElement
  */
 GstIterator *
@@ -1921,9 +2326,8 @@ gst_bin_iterate_elements (GstBin * bin)
   g_return_val_if_fail (GST_IS_BIN (bin), NULL);
 
   GST_OBJECT_LOCK (bin);
-  result = gst_iterator_new_list (GST_TYPE_ELEMENT,
-      GST_OBJECT_GET_LOCK (bin),
-      &bin->children_cookie, &bin->children, (GObject *) bin, NULL);
+  result = gst_iterator_new_list_snapshot (GST_TYPE_ELEMENT, bin->children,
+      NULL);
   GST_OBJECT_UNLOCK (bin);
 
   return result;
@@ -1959,11 +2363,8 @@ gst_bin_iterate_recurse (GstBin * bin)
   g_return_val_if_fail (GST_IS_BIN (bin), NULL);
 
   GST_OBJECT_LOCK (bin);
-  result = gst_iterator_new_list (GST_TYPE_ELEMENT,
-      GST_OBJECT_GET_LOCK (bin),
-      &bin->children_cookie,
-      &bin->children,
-      (GObject *) bin, (GstIteratorItemFunction) iterate_child_recurse);
+  result = gst_iterator_new_list_snapshot (GST_TYPE_ELEMENT, bin->children,
+      (GstIteratorItemFunction) iterate_child_recurse);
   GST_OBJECT_UNLOCK (bin);
 
   return result;
@@ -2114,7 +2515,21 @@ gst_bin_get_state_func (GstElement * element, GstState * state,
  * on the sinkpads. When an element reaches degree 0, its state is
  * changed next.
  * When all elements are handled the algorithm stops.
+ *
+ * As long as no children are added or removed and no pads of the children
+ * are linked or unlinked, the order does not change. The bin keeps the last
+ * computed order and the iterator walks it instead of recalculating all
+ * degrees, unless the bin has the NO_RESYNC flag or some pad is busy in a
+ * link or unlink.
  */
+typedef struct
+{
+  GstElement *element;
+  GstElementFlags flags;        /* SINK and SOURCE flags when sorted */
+} GstBinSortEntry;
+
+#define SORT_FLAGS (GST_ELEMENT_FLAG_SINK | GST_ELEMENT_FLAG_SOURCE)
+
 typedef struct _GstBinSortIterator
 {
   GstIterator it;
@@ -2125,6 +2540,9 @@ typedef struct _GstBinSortIterator
   gint best_deg;                /* best degree */
   GHashTable *hash;             /* hashtable with element dependencies */
   gboolean dirty;               /* we detected structure change */
+  GArray *sorted;               /* sort cache of the bin we walk or NULL */
+  guint sorted_idx;             /* next entry in sorted */
+  guint32 children_cookie;      /* children_cookie of the bin when sorted */
 } GstBinSortIterator;
 
 static void
@@ -2155,6 +2573,9 @@ gst_bin_sort_iterator_copy (const GstBinSortIterator * it,
   g_hash_table_iter_init (&iter, it->hash);
   while (g_hash_table_iter_next (&iter, &key, &value))
     g_hash_table_insert (copy->hash, key, value);
+
+  if (it->sorted)
+    copy->sorted = g_array_ref (it->sorted);
 }
 
 /* we add and subtract 1 to make sure we don't confuse NULL and 0 */
@@ -2339,9 +2760,11 @@ find_element (GstElement * element, GstBinSortIterator * bit)
   }
 }
 
-/* get next element in iterator. */
-static GstIteratorResult
-gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
+/* get next element in the topological order and update the degrees of the
+ * elements linked to it. Returns a new ref or NULL when all elements are
+ * handled. */
+static GstElement *
+gst_bin_sort_iterator_next_element (GstBinSortIterator * bit)
 {
   GstElement *best;
   GstBin *bin = bit->bin;
@@ -2364,33 +2787,64 @@ gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
       GST_DEBUG_OBJECT (bin, "queue empty, next best: %s",
           GST_ELEMENT_NAME (best));
       HASH_SET_DEGREE (bit, best, -1);
-      g_value_set_object (result, best);
+      gst_object_ref (best);
     } else {
       GST_DEBUG_OBJECT (bin, "queue empty, elements exhausted");
       /* no more unhandled elements, we are done */
-      return GST_ITERATOR_DONE;
+      return NULL;
     }
   } else {
     /* everything added to the queue got reffed */
     best = g_queue_pop_head (&bit->queue);
-    g_value_set_object (result, best);
-    gst_object_unref (best);
   }
 
   GST_DEBUG_OBJECT (bin, "queue head gives %s", GST_ELEMENT_NAME (best));
   /* update degrees of linked elements */
   update_degree (best, bit);
 
+  return best;
+}
+
+/* get next element in iterator. */
+static GstIteratorResult
+gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
+{
+  GstElement *best;
+  GstBin *bin = bit->bin;
+
+  if (bit->sorted) {
+    while (bit->sorted_idx < bit->sorted->len) {
+      best = g_array_index (bit->sorted, GstBinSortEntry,
+          bit->sorted_idx++).element;
+
+      /* the bin only holds on to its children, skip the elements that were
+       * removed without a resync */
+      if (G_UNLIKELY (bin->children_cookie != bit->children_cookie)
+          && !g_list_find (bin->children, best))
+        continue;
+
+      GST_DEBUG_OBJECT (bin, "sort cache gives %s", GST_ELEMENT_NAME (best));
+      g_value_set_object (result, best);
+      return GST_ITERATOR_OK;
+    }
+    return GST_ITERATOR_DONE;
+  }
+
+  if (!(best = gst_bin_sort_iterator_next_element (bit)))
+    return GST_ITERATOR_DONE;
+
+  g_value_set_object (result, best);
+  gst_object_unref (best);
+
   return GST_ITERATOR_OK;
 }
 
-/* clear queues, recalculate the degrees and restart. */
+/* recalculate the degrees of all children */
 static void
-gst_bin_sort_iterator_resync (GstBinSortIterator * bit)
+gst_bin_sort_iterator_reset (GstBinSortIterator * bit)
 {
   GstBin *bin = bit->bin;
 
-  GST_DEBUG_OBJECT (bin, "resync");
   bit->dirty = FALSE;
   clear_queue (&bit->queue);
   /* reset degrees */
@@ -2402,6 +2856,92 @@ gst_bin_sort_iterator_resync (GstBinSortIterator * bit)
   bit->mode = -1;
 }
 
+/* check if the sort cache of the bin is still valid. The flags of the
+ * children are not covered by the cookies, a child bin for example becomes a
+ * sink when a sink is added to it. */
+static gboolean
+sort_cache_is_valid (GstBin * bin)
+{
+  GstBinPrivate *priv = bin->priv;
+  guint i;
+
+  if (priv->sort_cache == NULL
+      || priv->sort_cache_children_cookie != bin->children_cookie
+      || priv->sort_cache_link_cookie != priv->link_cookie)
+    return FALSE;
+
+  for (i = 0; i < priv->sort_cache->len; i++) {
+    GstBinSortEntry *entry =
+        &g_array_index (priv->sort_cache, GstBinSortEntry, i);
+
+    if ((GST_OBJECT_FLAGS (entry->element) & SORT_FLAGS) != entry->flags)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* run the sort over all children and store the order in the bin */
+static void
+gst_bin_sort_iterator_update_cache (GstBinSortIterator * bit)
+{
+  GstBin *bin = bit->bin;
+  GstBinPrivate *priv = bin->priv;
+  GstElement *element;
+  GArray *sorted;
+
+  sorted = g_array_sized_new (FALSE, FALSE, sizeof (GstBinSortEntry),
+      bin->numchildren);
+
+  gst_bin_sort_iterator_reset (bit);
+  while ((element = gst_bin_sort_iterator_next_element (bit))) {
+    GstBinSortEntry entry;
+
+    /* the bin keeps the element alive as long as the cache is valid */
+    entry.element = element;
+    entry.flags = GST_OBJECT_FLAGS (element) & SORT_FLAGS;
+    g_array_append_val (sorted, entry);
+    gst_object_unref (element);
+  }
+
+  GST_DEBUG_OBJECT (bin, "sorted %u children", sorted->len);
+
+  if (priv->sort_cache)
+    g_array_unref (priv->sort_cache);
+  priv->sort_cache = sorted;
+  priv->sort_cache_children_cookie = bin->children_cookie;
+  priv->sort_cache_link_cookie = priv->link_cookie;
+}
+
+/* clear queues, recalculate the degrees and restart. */
+static void
+gst_bin_sort_iterator_resync (GstBinSortIterator * bit)
+{
+  GstBin *bin = bit->bin;
+
+  GST_DEBUG_OBJECT (bin, "resync");
+  if (bit->sorted) {
+    g_array_unref (bit->sorted);
+    bit->sorted = NULL;
+  }
+
+  /* with pads busy in a link or unlink the order is not stable yet and
+   * without resyncs new children would never be picked up from the cache */
+  if (!GST_BIN_IS_NO_RESYNC (bin)
+      && !find_message (bin, NULL, GST_MESSAGE_STRUCTURE_CHANGE)) {
+    if (!sort_cache_is_valid (bin))
+      gst_bin_sort_iterator_update_cache (bit);
+
+    clear_queue (&bit->queue);
+    bit->sorted = g_array_ref (bin->priv->sort_cache);
+    bit->sorted_idx = 0;
+    bit->children_cookie = bin->children_cookie;
+    return;
+  }
+
+  gst_bin_sort_iterator_reset (bit);
+}
+
 /* clear queues, unref bin and free iterator. */
 static void
 gst_bin_sort_iterator_free (GstBinSortIterator * bit)
@@ -2411,6 +2951,8 @@ gst_bin_sort_iterator_free (GstBinSortIterator * bit)
   GST_DEBUG_OBJECT (bin, "free");
   clear_queue (&bit->queue);
   g_hash_table_destroy (bit->hash);
+  if (bit->sorted)
+    g_array_unref (bit->sorted);
   gst_object_unref (bin);
 }
 
@@ -2434,6 +2976,7 @@ gst_bin_sort_iterator_new (GstBin * bin)
       (GstIteratorFreeFunction) gst_bin_sort_iterator_free);
   g_queue_init (&result->queue);
   result->hash = g_hash_table_new (NULL, NULL);
+  result->sorted = NULL;
   gst_object_ref (bin);
   result->bin = bin;
   gst_bin_sort_iterator_resync (result);
@@ -2748,17 +3291,20 @@ gst_bin_recalculate_latency (GstBin * bin)
 }
 
 static gboolean
-gst_bin_do_latency_func (GstBin * bin)
+gst_bin_configure_latency (GstBin * bin)
 {
   GstQuery *query;
   GstElement *element;
   GstClockTime min_latency, max_latency;
-  gboolean res;
-
-  g_return_val_if_fail (GST_IS_BIN (bin), FALSE);
+  gboolean res, dirty;
 
   element = GST_ELEMENT_CAST (bin);
 
+  GST_OBJECT_LOCK (bin);
+  dirty = bin->priv->latency_dirty;
+  bin->priv->latency_dirty = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
   GST_DEBUG_OBJECT (element, "querying latency");
 
   query = gst_query_new_latency ();
@@ -2781,11 +3327,19 @@ gst_bin_do_latency_func (GstBin * bin)
               GST_TIME_ARGS (max_latency), GST_TIME_ARGS (min_latency)));
     }
 
+    if (!dirty && min_latency == bin->priv->configured_latency) {
+      GST_DEBUG_OBJECT (element, "latency of %" GST_TIME_FORMAT
+          " is already configured", GST_TIME_ARGS (min_latency));
+      gst_query_unref (query);
+      return TRUE;
+    }
+
     /* configure latency on elements */
     res = gst_element_send_event (element, gst_event_new_latency (min_latency));
     if (res) {
       GST_INFO_OBJECT (element, "configured latency of %" GST_TIME_FORMAT,
           GST_TIME_ARGS (min_latency));
+      bin->priv->configured_latency = min_latency;
     } else {
       GST_WARNING_OBJECT (element,
           "did not really configure latency of %" GST_TIME_FORMAT,
@@ -2797,6 +3351,60 @@ gst_bin_do_latency_func (GstBin * bin)
   }
   gst_query_unref (query);
 
+  if (!res) {
+    GST_OBJECT_LOCK (bin);
+    bin->priv->latency_dirty = TRUE;
+    GST_OBJECT_UNLOCK (bin);
+  }
+
+  return res;
+}
+
+static gboolean
+gst_bin_do_latency_func (GstBin * bin)
+{
+  GstBinPrivate *priv;
+  guint64 request;
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_BIN (bin), FALSE);
+
+  priv = bin->priv;
+
+  GST_OBJECT_LOCK (bin);
+  request = ++priv->latency_requested;
+  if (priv->latency_thread == g_thread_self ()) {
+    /* called from the query or the event of the running recalculation, it
+     * will run once more when done */
+    GST_DEBUG_OBJECT (bin, "recalculating already, rerun afterwards");
+    GST_OBJECT_UNLOCK (bin);
+    return TRUE;
+  } else if (priv->latency_thread) {
+    /* another thread is recalculating, it will run once more for all the
+     * requests made meanwhile */
+    GST_DEBUG_OBJECT (bin, "waiting for running recalculation");
+    while (priv->latency_handled < request)
+      g_cond_wait (&priv->latency_cond, GST_OBJECT_GET_LOCK (bin));
+    res = priv->latency_res;
+    GST_OBJECT_UNLOCK (bin);
+    return res;
+  }
+
+  priv->latency_thread = g_thread_self ();
+  do {
+    request = priv->latency_requested;
+    GST_OBJECT_UNLOCK (bin);
+
+    res = gst_bin_configure_latency (bin);
+
+    GST_OBJECT_LOCK (bin);
+    priv->latency_handled = request;
+    priv->latency_res = res;
+    g_cond_broadcast (&priv->latency_cond);
+  } while (priv->latency_requested != request);
+  priv->latency_thread = NULL;
+  GST_OBJECT_UNLOCK (bin);
+
   return res;
 }
 
@@ -2837,6 +3445,284 @@ reset_state (const GValue * data, gpointer user_data)
         gst_element_state_get_name (state));
 }
 
+/* children at the same topological level that change state at the same time
+ * on the state-change-pool. Refcounted because work items that are only
+ * started after the level completed still have a reference to it. */
+typedef struct
+{
+  gint refcount;
+
+  GstBin *bin;
+  GstClockTime base_time, start_time;
+  GstState current, next;
+
+  GMutex lock;
+  GCond cond;
+  GQueue pending;
+  guint running;
+
+  gboolean have_async;
+  gboolean have_no_preroll;
+  gboolean failed;
+} BinStateLevel;
+
+static void
+bin_state_level_clear_pending (BinStateLevel * level)
+{
+  GstElement *child;
+
+  while ((child = g_queue_pop_head (&level->pending)))
+    gst_object_unref (child);
+}
+
+static BinStateLevel *
+bin_state_level_ref (BinStateLevel * level)
+{
+  g_atomic_int_inc (&level->refcount);
+  return level;
+}
+
+static void
+bin_state_level_unref (BinStateLevel * level)
+{
+  if (g_atomic_int_dec_and_test (&level->refcount)) {
+    bin_state_level_clear_pending (level);
+    g_mutex_clear (&level->lock);
+    g_cond_clear (&level->cond);
+    g_slice_free (BinStateLevel, level);
+  }
+}
+
+/* change the state of pending children of the level until there are none
+ * left */
+static void
+bin_state_level_run (BinStateLevel * level)
+{
+  GstElement *child;
+
+  g_mutex_lock (&level->lock);
+  while ((child = g_queue_pop_head (&level->pending))) {
+    GstStateChangeReturn ret;
+    gboolean failed = FALSE;
+
+    level->running++;
+    g_mutex_unlock (&level->lock);
+
+    ret = gst_bin_element_set_state (level->bin, child, level->base_time,
+        level->start_time, level->current, level->next);
+
+    GST_CAT_INFO_OBJECT (GST_CAT_STATES, level->bin,
+        "child '%s' changed state to %s: %s", GST_ELEMENT_NAME (child),
+        gst_element_state_get_name (level->next),
+        gst_element_state_change_return_get_name (ret));
+
+    if (ret == GST_STATE_CHANGE_FAILURE) {
+      GstObject *parent = gst_object_get_parent (GST_OBJECT_CAST (child));
+
+      /* like in the sequential case, only fail if the child was not removed
+       * from the bin because of the error */
+      failed = parent == GST_OBJECT_CAST (level->bin);
+      if (parent)
+        gst_object_unref (parent);
+    }
+    gst_object_unref (child);
+
+    g_mutex_lock (&level->lock);
+    level->running--;
+    if (ret == GST_STATE_CHANGE_ASYNC)
+      level->have_async = TRUE;
+    else if (ret == GST_STATE_CHANGE_NO_PREROLL)
+      level->have_no_preroll = TRUE;
+    if (failed) {
+      /* don't start any more state changes, running ones are waited for */
+      level->failed = TRUE;
+      bin_state_level_clear_pending (level);
+    }
+  }
+  if (level->running == 0)
+    g_cond_broadcast (&level->cond);
+  g_mutex_unlock (&level->lock);
+}
+
+static void
+bin_state_level_func (BinStateLevel * level)
+{
+  bin_state_level_run (level);
+  bin_state_level_unref (level);
+}
+
+/* topological level of @child: 0 when none of its peers downstream was seen
+ * yet, else one more than the highest level of those peers */
+static guint
+bin_child_state_level (GstElement * child, GHashTable * child_levels)
+{
+  GstIterator *it;
+  GValue data = { 0, };
+  guint level = 0;
+  gboolean done = FALSE;
+
+  it = gst_element_iterate_src_pads (child);
+  while (!done) {
+    switch (gst_iterator_next (it, &data)) {
+      case GST_ITERATOR_OK:
+      {
+        GstPad *peer = gst_pad_get_peer (g_value_get_object (&data));
+        gpointer peer_level;
+
+        if (peer) {
+          GstObject *peer_parent = gst_object_get_parent (GST_OBJECT (peer));
+
+          if (peer_parent && g_hash_table_lookup_extended (child_levels,
+                  peer_parent, NULL, &peer_level))
+            level = MAX (level, GPOINTER_TO_UINT (peer_level) + 1);
+          if (peer_parent)
+            gst_object_unref (peer_parent);
+          gst_object_unref (peer);
+        }
+        g_value_reset (&data);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        level = 0;
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+
+  return level;
+}
+
+/* change the state of all children on @pool, level by level. Returns FALSE
+ * when the children changed and the state change must be redone, and
+ * @ret is FAILURE when a child failed to change state */
+static gboolean
+bin_change_children_state_parallel (GstBin * bin, GstTaskPool * pool,
+    GstIterator * it, GstClockTime base_time, GstClockTime start_time,
+    GstState current, GstState next, gboolean * have_async,
+    gboolean * have_no_preroll, GstStateChangeReturn * ret)
+{
+  GHashTable *child_levels;
+  GPtrArray *levels;
+  GValue data = { 0, };
+  guint32 cookie;
+  gboolean done = FALSE, resync = FALSE;
+  guint i, j;
+
+  *ret = GST_STATE_CHANGE_SUCCESS;
+
+  GST_OBJECT_LOCK (bin);
+  cookie = bin->children_cookie;
+  GST_OBJECT_UNLOCK (bin);
+
+  /* group the children by level, sinks are returned first by the iterator so
+   * all downstream peers of a child already have their level */
+  child_levels = g_hash_table_new (NULL, NULL);
+  levels = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
+  while (!done) {
+    switch (gst_iterator_next (it, &data)) {
+      case GST_ITERATOR_OK:
+      {
+        GstElement *child = g_value_get_object (&data);
+        guint level = bin_child_state_level (child, child_levels);
+
+        g_hash_table_insert (child_levels, child, GUINT_TO_POINTER (level));
+        while (levels->len <= level)
+          g_ptr_array_add (levels,
+              g_ptr_array_new_with_free_func (gst_object_unref));
+        g_ptr_array_add (g_ptr_array_index (levels, level),
+            gst_object_ref (child));
+        g_value_reset (&data);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        resync = TRUE;
+        done = TRUE;
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&data);
+  g_hash_table_unref (child_levels);
+
+  for (i = 0; !resync && i < levels->len; i++) {
+    GPtrArray *children = g_ptr_array_index (levels, i);
+    BinStateLevel *level;
+
+    level = g_slice_new0 (BinStateLevel);
+    level->refcount = 1;
+    level->bin = bin;
+    level->base_time = base_time;
+    level->start_time = start_time;
+    level->current = current;
+    level->next = next;
+    g_mutex_init (&level->lock);
+    g_cond_init (&level->cond);
+    for (j = 0; j < children->len; j++)
+      g_queue_push_tail (&level->pending,
+          gst_object_ref (g_ptr_array_index (children, j)));
+
+    GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin,
+        "changing state of %u children at level %u", children->len, i);
+
+    /* one less work item than children, we take care of one ourselves */
+    for (j = 1; j < children->len; j++) {
+      GError *error = NULL;
+      gpointer id;
+
+      id = gst_task_pool_push (pool, (GstTaskPoolFunction) bin_state_level_func,
+          bin_state_level_ref (level), &error);
+      if (error) {
+        GST_CAT_WARNING_OBJECT (GST_CAT_STATES, bin,
+            "failed to push state change work item: %s", error->message);
+        g_clear_error (&error);
+        bin_state_level_unref (level);
+        break;
+      }
+      if (id)
+        gst_task_pool_dispose_handle (pool, id);
+    }
+
+    bin_state_level_run (level);
+
+    g_mutex_lock (&level->lock);
+    while (level->running > 0 || !g_queue_is_empty (&level->pending))
+      g_cond_wait (&level->cond, &level->lock);
+    g_mutex_unlock (&level->lock);
+
+    if (level->have_async)
+      *have_async = TRUE;
+    if (level->have_no_preroll)
+      *have_no_preroll = TRUE;
+    if (level->failed)
+      *ret = GST_STATE_CHANGE_FAILURE;
+    bin_state_level_unref (level);
+
+    if (*ret == GST_STATE_CHANGE_FAILURE)
+      break;
+
+    /* like the iterator, start over when children were added or removed */
+    GST_OBJECT_LOCK (bin);
+    if (cookie != bin->children_cookie) {
+      GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin, "children changed");
+      resync = TRUE;
+    }
+    GST_OBJECT_UNLOCK (bin);
+    if (resync)
+      gst_iterator_resync (it);
+  }
+  g_ptr_array_unref (levels);
+
+  return !resync;
+}
+
 static GstStateChangeReturn
 gst_bin_change_state_func (GstElement * element, GstStateChange transition)
 {
@@ -2849,6 +3735,7 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
   GstIterator *it;
   gboolean done;
   GValue data = { 0, };
+  GstTaskPool *pool;
 
   /* we don't need to take the STATE_LOCK, it is already taken */
   current = (GstState) GST_STATE_TRANSITION_CURRENT (transition);
@@ -2868,6 +3755,7 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
       GST_OBJECT_LOCK (bin);
       toplevel = BIN_IS_TOPLEVEL (bin);
       asynchandling = bin->priv->asynchandling;
+      bin->priv->latency_dirty = TRUE;
       GST_OBJECT_UNLOCK (bin);
 
       if (toplevel)
@@ -2920,6 +3808,8 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
    * don't want them to interfere with this state change */
   GST_OBJECT_LOCK (bin);
   bin->polling = TRUE;
+  pool = bin->priv->state_change_pool ?
+      gst_object_ref (bin->priv->state_change_pool) : NULL;
   GST_OBJECT_UNLOCK (bin);
 
   /* iterate in state change order */
@@ -2938,7 +3828,15 @@ restart:
 
   have_no_preroll = FALSE;
 
-  done = FALSE;
+  if (pool) {
+    if (!bin_change_children_state_parallel (bin, pool, it, base_time,
+            start_time, current, next, &have_async, &have_no_preroll, &ret))
+      goto restart;
+    if (ret == GST_STATE_CHANGE_FAILURE)
+      goto undo;
+  }
+
+  done = pool != NULL;
   while (!done) {
     switch (gst_iterator_next (it, &data)) {
       case GST_ITERATOR_OK:
@@ -3040,6 +3938,8 @@ restart:
 done:
   g_value_unset (&data);
   gst_iterator_free (it);
+  if (pool)
+    gst_object_unref (pool);
 
   GST_OBJECT_LOCK (bin);
   bin->polling = FALSE;
@@ -3983,6 +4883,7 @@ gst_bin_handle_message_func (GstBin * bin, GstMessage * message)
          * need to resync by updating the structure_cookie. */
         bin_remove_messages (bin, GST_MESSAGE_SRC (message),
             GST_MESSAGE_STRUCTURE_CHANGE);
+        bin->priv->link_cookie++;
         if (!GST_BIN_IS_NO_RESYNC (bin))
           bin->priv->structure_cookie++;
       }
@@ -4039,6 +4940,31 @@ gst_bin_handle_message_func (GstBin * bin, GstMessage * message)
       goto forward;
       break;
     }
+    case GST_MESSAGE_STREAM_STATUS:{
+      GstStreamStatusType status_type;
+      const GValue *val;
+
+      /* posted synchronously before the thread of a new task is started */
+      gst_message_parse_stream_status (message, &status_type, NULL);
+      if (status_type == GST_STREAM_STATUS_TYPE_CREATE) {
+        val = gst_message_get_stream_status_object (message);
+        if (val && G_VALUE_HOLDS (val, GST_TYPE_TASK))
+          bin_configure_task (bin, g_value_get_object (val));
+      }
+
+      goto forward;
+      break;
+    }
+    case GST_MESSAGE_STATE_CHANGED:
+    {
+      /* sinks forget their latency when going to READY, make sure the
+       * next recalculation configures it again */
+      GST_OBJECT_LOCK (bin);
+      bin->priv->latency_dirty = TRUE;
+      GST_OBJECT_UNLOCK (bin);
+
+      goto forward;
+    }
     default:
       goto forward;
   }
@@ -0,0 +1,1043 @@
+/* GStreamer
+ *
+ * gstbinarycodec.c: Binary encoding of structures and caps
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A compact alternative to the string serialization of structures and
+ * caps, for data that is written and read by machines only, like the
+ * registry cache and the plugin loader protocol.
+ *
+ * An encoded blob starts with a 4 byte header ("GSB" and a version byte),
+ * followed by a table of all structure, field, feature and type names, each
+ * stored once as a nul-terminated string, and a single tagged value. Names
+ * are referenced by their 1-based index in the table, 0 stands for %NULL.
+ * Integers are stored as LEB128 varints, signed ones zig-zag encoded, and
+ * floating point numbers as little-endian IEEE 754. Strings are prefixed
+ * with their length + 1 (0 for %NULL) and nul-terminated, so that they can
+ * be used directly from the input without copying.
+ *
+ * Values of types without a native encoding are stored with their type
+ * name and the output of gst_value_serialize().
+ */
+
+#include "gst_private.h"
+
+#include <string.h>
+
+#include "gstbinarycodec.h"
+#include "gstutils.h"
+#include "gstvalue.h"
+
+#define BINARY_MAGIC "GSB"
+#define BINARY_VERSION 1
+#define BINARY_HEADER_SIZE 4
+
+/* maximum nesting of lists, arrays, structures and caps we accept when
+ * reading, so that bogus input can't exhaust the stack */
+#define BINARY_MAX_DEPTH 64
+
+enum
+{
+  TAG_INT = 1,
+  TAG_UINT,
+  TAG_INT64,
+  TAG_UINT64,
+  TAG_FALSE,
+  TAG_TRUE,
+  TAG_FLOAT,
+  TAG_DOUBLE,
+  TAG_STRING,
+  TAG_FRACTION,
+  TAG_INT_RANGE,
+  TAG_INT64_RANGE,
+  TAG_DOUBLE_RANGE,
+  TAG_FRACTION_RANGE,
+  TAG_LIST,
+  TAG_ARRAY,
+  TAG_STRUCTURE,
+  TAG_CAPS,
+  TAG_ENUM,
+  TAG_FLAGS,
+  TAG_BITMASK,
+  TAG_SERIALIZED
+};
+
+/* caps kinds */
+enum
+{
+  CAPS_NULL = 0,
+  CAPS_ANY,
+  CAPS_STRUCTURES
+};
+
+/* caps features codes, larger values are 2 + the number of features */
+enum
+{
+  FEATURES_NONE = 0,
+  FEATURES_ANY,
+  FEATURES_LIST
+};
+
+#define ZIGZAG(v)   (((guint64) (v) << 1) ^ (guint64) ((gint64) (v) >> 63))
+#define UNZIGZAG(v) ((gint64) ((v) >> 1) ^ -(gint64) ((v) & 1))
+
+typedef struct
+{
+  GByteArray *body;
+  /* name -> 1-based index in table */
+  GHashTable *names;
+  GPtrArray *table;
+} Writer;
+
+typedef struct
+{
+  const guint8 *data;
+  const guint8 *end;
+  guint n_names;
+  const gchar **names;
+  GQuark *quarks;
+  guint depth;
+} Reader;
+
+static gboolean write_value (Writer * w, const GValue * value);
+static gboolean read_value (Reader * r, GValue * value);
+
+/* writing */
+
+static inline void
+write_byte (GByteArray * out, guint8 b)
+{
+  g_byte_array_append (out, &b, 1);
+}
+
+static void
+write_varint (GByteArray * out, guint64 v)
+{
+  guint8 buf[10];
+  guint len = 0;
+
+  do {
+    buf[len] = v & 0x7f;
+    v >>= 7;
+    if (v)
+      buf[len] |= 0x80;
+    len++;
+  } while (v);
+
+  g_byte_array_append (out, buf, len);
+}
+
+static inline void
+write_sint (GByteArray * out, gint64 v)
+{
+  write_varint (out, ZIGZAG (v));
+}
+
+static void
+write_double (GByteArray * out, gdouble d)
+{
+  guint64 bits;
+
+  memcpy (&bits, &d, sizeof (bits));
+  bits = GUINT64_TO_LE (bits);
+  g_byte_array_append (out, (const guint8 *) &bits, sizeof (bits));
+}
+
+static void
+write_float (GByteArray * out, gfloat f)
+{
+  guint32 bits;
+
+  memcpy (&bits, &f, sizeof (bits));
+  bits = GUINT32_TO_LE (bits);
+  g_byte_array_append (out, (const guint8 *) &bits, sizeof (bits));
+}
+
+static void
+write_string (GByteArray * out, const gchar * str)
+{
+  gsize len;
+
+  if (str == NULL) {
+    write_varint (out, 0);
+    return;
+  }
+
+  len = strlen (str) + 1;
+  write_varint (out, len);
+  g_byte_array_append (out, (const guint8 *) str, len);
+}
+
+static void
+write_name (Writer * w, const gchar * name)
+{
+  guint idx;
+
+  if (name == NULL) {
+    write_varint (w->body, 0);
+    return;
+  }
+
+  idx = GPOINTER_TO_UINT (g_hash_table_lookup (w->names, name));
+  if (idx == 0) {
+    g_ptr_array_add (w->table, (gpointer) name);
+    idx = w->table->len;
+    g_hash_table_insert (w->names, (gpointer) name, GUINT_TO_POINTER (idx));
+  }
+  write_varint (w->body, idx);
+}
+
+typedef struct
+{
+  Writer *w;
+  gboolean ok;
+} WriteFieldData;
+
+static gboolean
+write_field (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  WriteFieldData *data = user_data;
+
+  write_name (data->w, g_quark_to_string (field_id));
+  data->ok = write_value (data->w, value);
+
+  return data->ok;
+}
+
+static gboolean
+write_structure (Writer * w, const GstStructure * structure)
+{
+  WriteFieldData data = { w, TRUE };
+
+  if (structure == NULL) {
+    write_name (w, NULL);
+    return TRUE;
+  }
+
+  write_name (w, gst_structure_get_name (structure));
+  write_varint (w->body, gst_structure_n_fields (structure));
+  gst_structure_foreach (structure, write_field, &data);
+
+  return data.ok;
+}
+
+static void
+write_features (Writer * w, const GstCapsFeatures * features)
+{
+  guint i, n;
+
+  if (features == NULL
+      || gst_caps_features_is_equal (features,
+          GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY)) {
+    write_varint (w->body, FEATURES_NONE);
+  } else if (gst_caps_features_is_any (features)) {
+    write_varint (w->body, FEATURES_ANY);
+  } else {
+    n = gst_caps_features_get_size (features);
+    write_varint (w->body, FEATURES_LIST + n);
+    for (i = 0; i < n; i++)
+      write_name (w, gst_caps_features_get_nth (features, i));
+  }
+}
+
+static gboolean
+write_caps (Writer * w, const GstCaps * caps)
+{
+  guint i, n;
+
+  if (caps == NULL) {
+    write_byte (w->body, CAPS_NULL);
+    return TRUE;
+  }
+  if (gst_caps_is_any (caps)) {
+    write_byte (w->body, CAPS_ANY);
+    return TRUE;
+  }
+
+  n = gst_caps_get_size (caps);
+  write_byte (w->body, CAPS_STRUCTURES);
+  write_varint (w->body, n);
+  for (i = 0; i < n; i++) {
+    write_features (w, gst_caps_get_features (caps, i));
+    if (!write_structure (w, gst_caps_get_structure (caps, i)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+write_value (Writer * w, const GValue * value)
+{
+  GByteArray *out = w->body;
+  GType type = G_VALUE_TYPE (value);
+
+  if (type == G_TYPE_INT) {
+    write_byte (out, TAG_INT);
+    write_sint (out, g_value_get_int (value));
+  } else if (type == G_TYPE_UINT) {
+    write_byte (out, TAG_UINT);
+    write_varint (out, g_value_get_uint (value));
+  } else if (type == G_TYPE_INT64) {
+    write_byte (out, TAG_INT64);
+    write_sint (out, g_value_get_int64 (value));
+  } else if (type == G_TYPE_UINT64) {
+    write_byte (out, TAG_UINT64);
+    write_varint (out, g_value_get_uint64 (value));
+  } else if (type == G_TYPE_BOOLEAN) {
+    write_byte (out, g_value_get_boolean (value) ? TAG_TRUE : TAG_FALSE);
+  } else if (type == G_TYPE_FLOAT) {
+    write_byte (out, TAG_FLOAT);
+    write_float (out, g_value_get_float (value));
+  } else if (type == G_TYPE_DOUBLE) {
+    write_byte (out, TAG_DOUBLE);
+    write_double (out, g_value_get_double (value));
+  } else if (type == G_TYPE_STRING) {
+    write_byte (out, TAG_STRING);
+    write_string (out, g_value_get_string (value));
+  } else if (type == GST_TYPE_FRACTION) {
+    write_byte (out, TAG_FRACTION);
+    write_sint (out, gst_value_get_fraction_numerator (value));
+    write_sint (out, gst_value_get_fraction_denominator (value));
+  } else if (type == GST_TYPE_INT_RANGE) {
+    write_byte (out, TAG_INT_RANGE);
+    write_sint (out, gst_value_get_int_range_min (value));
+    write_sint (out, gst_value_get_int_range_max (value));
+    write_sint (out, gst_value_get_int_range_step (value));
+  } else if (type == GST_TYPE_INT64_RANGE) {
+    write_byte (out, TAG_INT64_RANGE);
+    write_sint (out, gst_value_get_int64_range_min (value));
+    write_sint (out, gst_value_get_int64_range_max (value));
+    write_sint (out, gst_value_get_int64_range_step (value));
+  } else if (type == GST_TYPE_DOUBLE_RANGE) {
+    write_byte (out, TAG_DOUBLE_RANGE);
+    write_double (out, gst_value_get_double_range_min (value));
+    write_double (out, gst_value_get_double_range_max (value));
+  } else if (type == GST_TYPE_FRACTION_RANGE) {
+    const GValue *min = gst_value_get_fraction_range_min (value);
+    const GValue *max = gst_value_get_fraction_range_max (value);
+
+    if (min == NULL || max == NULL)
+      return FALSE;
+
+    write_byte (out, TAG_FRACTION_RANGE);
+    write_sint (out, gst_value_get_fraction_numerator (min));
+    write_sint (out, gst_value_get_fraction_denominator (min));
+    write_sint (out, gst_value_get_fraction_numerator (max));
+    write_sint (out, gst_value_get_fraction_denominator (max));
+  } else if (type == GST_TYPE_LIST || type == GST_TYPE_ARRAY) {
+    gboolean is_list = (type == GST_TYPE_LIST);
+    guint i, n;
+
+    n = is_list ? gst_value_list_get_size (value) :
+        gst_value_array_get_size (value);
+    write_byte (out, is_list ? TAG_LIST : TAG_ARRAY);
+    write_varint (out, n);
+    for (i = 0; i < n; i++) {
+      if (!write_value (w, is_list ? gst_value_list_get_value (value, i) :
+              gst_value_array_get_value (value, i)))
+        return FALSE;
+    }
+  } else if (type == GST_TYPE_STRUCTURE) {
+    write_byte (out, TAG_STRUCTURE);
+    return write_structure (w, gst_value_get_structure (value));
+  } else if (type == GST_TYPE_CAPS) {
+    write_byte (out, TAG_CAPS);
+    return write_caps (w, gst_value_get_caps (value));
+  } else if (G_TYPE_IS_ENUM (type)) {
+    write_byte (out, TAG_ENUM);
+    write_name (w, g_type_name (type));
+    write_sint (out, g_value_get_enum (value));
+  } else if (G_TYPE_IS_FLAGS (type)) {
+    write_byte (out, TAG_FLAGS);
+    write_name (w, g_type_name (type));
+    write_varint (out, g_value_get_flags (value));
+  } else if (type == GST_TYPE_BITMASK) {
+    write_byte (out, TAG_BITMASK);
+    write_varint (out, gst_value_get_bitmask (value));
+  } else {
+    gchar *str = gst_value_serialize (value);
+
+    if (str == NULL)
+      return FALSE;
+
+    write_byte (out, TAG_SERIALIZED);
+    write_name (w, g_type_name (type));
+    write_string (out, str);
+    g_free (str);
+  }
+
+  return TRUE;
+}
+
+static void
+writer_init (Writer * w)
+{
+  w->body = g_byte_array_sized_new (256);
+  w->names = g_hash_table_new (g_str_hash, g_str_equal);
+  w->table = g_ptr_array_new ();
+}
+
+static GBytes *
+writer_finish (Writer * w, gboolean ok)
+{
+  GByteArray *out = NULL;
+  guint i;
+
+  if (ok) {
+    out = g_byte_array_sized_new (BINARY_HEADER_SIZE + 16 * w->table->len +
+        w->body->len);
+    g_byte_array_append (out, (const guint8 *) BINARY_MAGIC, 3);
+    write_byte (out, BINARY_VERSION);
+
+    write_varint (out, w->table->len);
+    for (i = 0; i < w->table->len; i++) {
+      const gchar *name = g_ptr_array_index (w->table, i);
+
+      g_byte_array_append (out, (const guint8 *) name, strlen (name) + 1);
+    }
+    g_byte_array_append (out, w->body->data, w->body->len);
+  }
+
+  g_byte_array_unref (w->body);
+  g_hash_table_unref (w->names);
+  g_ptr_array_unref (w->table);
+
+  return out ? g_byte_array_free_to_bytes (out) : NULL;
+}
+
+/* reading */
+
+static inline gboolean
+read_byte (Reader * r, guint8 * b)
+{
+  if (G_UNLIKELY (r->data >= r->end))
+    return FALSE;
+
+  *b = *r->data++;
+  return TRUE;
+}
+
+static gboolean
+read_varint (Reader * r, guint64 * v)
+{
+  guint64 res = 0;
+  guint shift = 0;
+
+  while (r->data < r->end && shift < 64) {
+    guint8 b = *r->data++;
+
+    res |= (guint64) (b & 0x7f) << shift;
+    if ((b & 0x80) == 0) {
+      *v = res;
+      return TRUE;
+    }
+    shift += 7;
+  }
+  return FALSE;
+}
+
+static inline gboolean
+read_sint (Reader * r, gint64 * v)
+{
+  guint64 u;
+
+  if (!read_varint (r, &u))
+    return FALSE;
+
+  *v = UNZIGZAG (u);
+  return TRUE;
+}
+
+static gboolean
+read_uint32 (Reader * r, guint * v)
+{
+  guint64 u;
+
+  if (!read_varint (r, &u) || u > G_MAXUINT32)
+    return FALSE;
+
+  *v = u;
+  return TRUE;
+}
+
+static gboolean
+read_int32 (Reader * r, gint * v)
+{
+  gint64 s;
+
+  if (!read_sint (r, &s) || s < G_MININT32 || s > G_MAXINT32)
+    return FALSE;
+
+  *v = s;
+  return TRUE;
+}
+
+/* read a count of items that each take at least one byte */
+static gboolean
+read_count (Reader * r, guint * n)
+{
+  return read_uint32 (r, n) && *n <= (gsize) (r->end - r->data);
+}
+
+static gboolean
+read_double (Reader * r, gdouble * d)
+{
+  guint64 bits;
+
+  if ((gsize) (r->end - r->data) < sizeof (bits))
+    return FALSE;
+
+  memcpy (&bits, r->data, sizeof (bits));
+  bits = GUINT64_FROM_LE (bits);
+  memcpy (d, &bits, sizeof (bits));
+  r->data += sizeof (bits);
+  return TRUE;
+}
+
+static gboolean
+read_float (Reader * r, gfloat * f)
+{
+  guint32 bits;
+
+  if ((gsize) (r->end - r->data) < sizeof (bits))
+    return FALSE;
+
+  memcpy (&bits, r->data, sizeof (bits));
+  bits = GUINT32_FROM_LE (bits);
+  memcpy (f, &bits, sizeof (bits));
+  r->data += sizeof (bits);
+  return TRUE;
+}
+
+/* the returned string points into the input data */
+static gboolean
+read_string (Reader * r, const gchar ** str)
+{
+  guint64 len;
+
+  if (!read_varint (r, &len))
+    return FALSE;
+
+  if (len == 0) {
+    *str = NULL;
+    return TRUE;
+  }
+
+  if (len > (guint64) (r->end - r->data) || r->data[len - 1] != '\0' ||
+      memchr (r->data, '\0', len - 1) != NULL)
+    return FALSE;
+
+  *str = (const gchar *) r->data;
+  r->data += len;
+  return TRUE;
+}
+
+static gboolean
+read_name (Reader * r, const gchar ** name, GQuark * quark)
+{
+  guint idx;
+
+  if (!read_uint32 (r, &idx) || idx > r->n_names)
+    return FALSE;
+
+  if (idx == 0) {
+    if (name)
+      *name = NULL;
+    if (quark)
+      *quark = 0;
+    return TRUE;
+  }
+
+  idx--;
+  if (name)
+    *name = r->names[idx];
+  if (quark) {
+    if (r->quarks[idx] == 0)
+      r->quarks[idx] = g_quark_from_string (r->names[idx]);
+    *quark = r->quarks[idx];
+  }
+  return TRUE;
+}
+
+static gboolean
+read_structure (Reader * r, GstStructure ** structure)
+{
+  GstStructure *s;
+  GQuark name;
+  guint i, n;
+
+  if (!read_name (r, NULL, &name))
+    return FALSE;
+
+  if (name == 0) {
+    *structure = NULL;
+    return TRUE;
+  }
+
+  if (!read_count (r, &n))
+    return FALSE;
+
+  s = gst_structure_new_id_empty (name);
+  for (i = 0; i < n; i++) {
+    GValue value = G_VALUE_INIT;
+    GQuark field;
+
+    if (!read_name (r, NULL, &field) || field == 0 || !read_value (r, &value))
+      goto failed;
+
+    gst_structure_id_take_value (s, field, &value);
+  }
+
+  *structure = s;
+  return TRUE;
+
+failed:
+  gst_structure_free (s);
+  return FALSE;
+}
+
+static gboolean
+read_features (Reader * r, GstCapsFeatures ** features)
+{
+  GstCapsFeatures *f;
+  guint i, n;
+
+  if (!read_uint32 (r, &n))
+    return FALSE;
+
+  if (n == FEATURES_NONE) {
+    *features = NULL;
+    return TRUE;
+  } else if (n == FEATURES_ANY) {
+    *features = gst_caps_features_new_any ();
+    return TRUE;
+  }
+
+  n -= FEATURES_LIST;
+  if (n > r->end - r->data)
+    return FALSE;
+
+  f = gst_caps_features_new_empty ();
+  for (i = 0; i < n; i++) {
+    GQuark feature;
+
+    if (!read_name (r, NULL, &feature) || feature == 0) {
+      gst_caps_features_free (f);
+      return FALSE;
+    }
+    gst_caps_features_add_id (f, feature);
+  }
+
+  *features = f;
+  return TRUE;
+}
+
+static gboolean
+read_caps (Reader * r, GstCaps ** caps)
+{
+  GstCaps *c;
+  guint8 kind;
+  guint i, n;
+
+  if (!read_byte (r, &kind))
+    return FALSE;
+
+  switch (kind) {
+    case CAPS_NULL:
+      *caps = NULL;
+      return TRUE;
+    case CAPS_ANY:
+      *caps = gst_caps_new_any ();
+      return TRUE;
+    case CAPS_STRUCTURES:
+      break;
+    default:
+      return FALSE;
+  }
+
+  if (!read_count (r, &n))
+    return FALSE;
+
+  c = gst_caps_new_empty ();
+  for (i = 0; i < n; i++) {
+    GstCapsFeatures *features;
+    GstStructure *s;
+
+    if (!read_features (r, &features))
+      goto failed;
+
+    if (!read_structure (r, &s) || s == NULL) {
+      if (features)
+        gst_caps_features_free (features);
+      goto failed;
+    }
+
+    gst_caps_append_structure_full (c, s, features);
+  }
+
+  *caps = c;
+  return TRUE;
+
+failed:
+  gst_caps_unref (c);
+  return FALSE;
+}
+
+static gboolean
+read_typed_value (Reader * r, guint8 tag, GValue * value)
+{
+  switch (tag) {
+    case TAG_INT:{
+      gint v;
+
+      if (!read_int32 (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT);
+      g_value_set_int (value, v);
+      break;
+    }
+    case TAG_UINT:{
+      guint v;
+
+      if (!read_uint32 (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT);
+      g_value_set_uint (value, v);
+      break;
+    }
+    case TAG_INT64:{
+      gint64 v;
+
+      if (!read_sint (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT64);
+      g_value_set_int64 (value, v);
+      break;
+    }
+    case TAG_UINT64:{
+      guint64 v;
+
+      if (!read_varint (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT64);
+      g_value_set_uint64 (value, v);
+      break;
+    }
+    case TAG_FALSE:
+    case TAG_TRUE:
+      g_value_init (value, G_TYPE_BOOLEAN);
+      g_value_set_boolean (value, tag == TAG_TRUE);
+      break;
+    case TAG_FLOAT:{
+      gfloat v;
+
+      if (!read_float (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_FLOAT);
+      g_value_set_float (value, v);
+      break;
+    }
+    case TAG_DOUBLE:{
+      gdouble v;
+
+      if (!read_double (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, v);
+      break;
+    }
+    case TAG_STRING:{
+      const gchar *v;
+
+      if (!read_string (r, &v))
+        return FALSE;
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, v);
+      break;
+    }
+    case TAG_FRACTION:{
+      gint num, den;
+
+      if (!read_int32 (r, &num) || !read_int32 (r, &den) || den == 0 ||
+          num < -G_MAXINT || den < -G_MAXINT)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION);
+      gst_value_set_fraction (value, num, den);
+      break;
+    }
+    case TAG_INT_RANGE:{
+      gint min, max, step;
+
+      if (!read_int32 (r, &min) || !read_int32 (r, &max) ||
+          !read_int32 (r, &step) || min >= max || step <= 0 ||
+          min % step != 0 || max % step != 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range_step (value, min, max, step);
+      break;
+    }
+    case TAG_INT64_RANGE:{
+      gint64 min, max, step;
+
+      if (!read_sint (r, &min) || !read_sint (r, &max) ||
+          !read_sint (r, &step) || min >= max || step <= 0 ||
+          min % step != 0 || max % step != 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT64_RANGE);
+      gst_value_set_int64_range_step (value, min, max, step);
+      break;
+    }
+    case TAG_DOUBLE_RANGE:{
+      gdouble min, max;
+
+      if (!read_double (r, &min) || !read_double (r, &max) || !(min < max))
+        return FALSE;
+      g_value_init (value, GST_TYPE_DOUBLE_RANGE);
+      gst_value_set_double_range (value, min, max);
+      break;
+    }
+    case TAG_FRACTION_RANGE:{
+      gint n1, d1, n2, d2;
+
+      if (!read_int32 (r, &n1) || !read_int32 (r, &d1) ||
+          !read_int32 (r, &n2) || !read_int32 (r, &d2) ||
+          d1 <= 0 || d2 <= 0 || n1 < -G_MAXINT || n2 < -G_MAXINT ||
+          gst_util_fraction_compare (n1, d1, n2, d2) >= 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range_full (value, n1, d1, n2, d2);
+      break;
+    }
+    case TAG_LIST:
+    case TAG_ARRAY:{
+      guint i, n;
+
+      if (!read_count (r, &n))
+        return FALSE;
+
+      g_value_init (value, tag == TAG_LIST ? GST_TYPE_LIST : GST_TYPE_ARRAY);
+      for (i = 0; i < n; i++) {
+        GValue item = G_VALUE_INIT;
+
+        if (!read_value (r, &item)) {
+          g_value_unset (value);
+          return FALSE;
+        }
+        if (tag == TAG_LIST)
+          gst_value_list_append_and_take_value (value, &item);
+        else
+          gst_value_array_append_and_take_value (value, &item);
+      }
+      break;
+    }
+    case TAG_STRUCTURE:{
+      GstStructure *s;
+
+      if (!read_structure (r, &s))
+        return FALSE;
+      g_value_init (value, GST_TYPE_STRUCTURE);
+      g_value_take_boxed (value, s);
+      break;
+    }
+    case TAG_CAPS:{
+      GstCaps *caps;
+
+      if (!read_caps (r, &caps))
+        return FALSE;
+      g_value_init (value, GST_TYPE_CAPS);
+      g_value_take_boxed (value, caps);
+      break;
+    }
+    case TAG_ENUM:
+    case TAG_FLAGS:{
+      const gchar *type_name;
+      GType type;
+
+      if (!read_name (r, &type_name, NULL) || type_name == NULL)
+        return FALSE;
+
+      type = g_type_from_name (type_name);
+      if (tag == TAG_ENUM) {
+        gint v;
+
+        if (!G_TYPE_IS_ENUM (type) || !read_int32 (r, &v))
+          return FALSE;
+        g_value_init (value, type);
+        g_value_set_enum (value, v);
+      } else {
+        guint v;
+
+        if (!G_TYPE_IS_FLAGS (type) || !read_uint32 (r, &v))
+          return FALSE;
+        g_value_init (value, type);
+        g_value_set_flags (value, v);
+      }
+      break;
+    }
+    case TAG_BITMASK:{
+      guint64 v;
+
+      if (!read_varint (r, &v))
+        return FALSE;
+      g_value_init (value, GST_TYPE_BITMASK);
+      gst_value_set_bitmask (value, v);
+      break;
+    }
+    case TAG_SERIALIZED:{
+      const gchar *type_name, *str;
+      GType type;
+
+      if (!read_name (r, &type_name, NULL) || type_name == NULL ||
+          !read_string (r, &str) || str == NULL)
+        return FALSE;
+
+      type = g_type_from_name (type_name);
+      if (type == G_TYPE_INVALID || !G_TYPE_IS_VALUE_TYPE (type) ||
+          G_TYPE_IS_ABSTRACT (type))
+        return FALSE;
+
+      g_value_init (value, type);
+      if (!gst_value_deserialize (value, str)) {
+        g_value_unset (value);
+        return FALSE;
+      }
+      break;
+    }
+    default:
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+read_value (Reader * r, GValue * value)
+{
+  gboolean res;
+  guint8 tag;
+
+  if (!read_byte (r, &tag) || r->depth >= BINARY_MAX_DEPTH)
+    return FALSE;
+
+  r->depth++;
+  res = read_typed_value (r, tag, value);
+  r->depth--;
+
+  return res;
+}
+
+static gboolean
+reader_init (Reader * r, const guint8 * data, gsize size)
+{
+  guint i, n;
+
+  memset (r, 0, sizeof (Reader));
+
+  if (size < BINARY_HEADER_SIZE || memcmp (data, BINARY_MAGIC, 3) != 0 ||
+      data[3] != BINARY_VERSION)
+    return FALSE;
+
+  r->data = data + BINARY_HEADER_SIZE;
+  r->end = data + size;
+
+  if (!read_count (r, &n))
+    return FALSE;
+
+  r->n_names = n;
+  r->names = g_new (const gchar *, n);
+  r->quarks = g_new0 (GQuark, n);
+  for (i = 0; i < n; i++) {
+    const guint8 *nul = memchr (r->data, '\0', r->end - r->data);
+
+    if (nul == NULL)
+      return FALSE;
+
+    r->names[i] = (const gchar *) r->data;
+    r->data = nul + 1;
+  }
+
+  return TRUE;
+}
+
+static void
+reader_clear (Reader * r)
+{
+  g_free (r->names);
+  g_free (r->quarks);
+}
+
+GBytes *
+_priv_gst_binary_serialize_structure (const GstStructure * structure)
+{
+  Writer w;
+  gboolean ok;
+
+  writer_init (&w);
+  write_byte (w.body, TAG_STRUCTURE);
+  ok = write_structure (&w, structure);
+
+  return writer_finish (&w, ok);
+}
+
+gboolean
+_priv_gst_binary_deserialize_structure (const guint8 * data, gsize size,
+    gsize * consumed, GstStructure ** structure)
+{
+  Reader r;
+  guint8 tag;
+  gboolean res;
+
+  res = reader_init (&r, data, size) && read_byte (&r, &tag) &&
+      tag == TAG_STRUCTURE && read_structure (&r, structure);
+  if (res && consumed)
+    *consumed = r.data - data;
+  reader_clear (&r);
+
+  return res;
+}
+
+GBytes *
+_priv_gst_binary_serialize_caps (const GstCaps * caps)
+{
+  Writer w;
+  gboolean ok;
+
+  writer_init (&w);
+  write_byte (w.body, TAG_CAPS);
+  ok = write_caps (&w, caps);
+
+  return writer_finish (&w, ok);
+}
+
+gboolean
+_priv_gst_binary_deserialize_caps (const guint8 * data, gsize size,
+    gsize * consumed, GstCaps ** caps)
+{
+  Reader r;
+  guint8 tag;
+  gboolean res;
+
+  res = reader_init (&r, data, size) && read_byte (&r, &tag) &&
+      tag == TAG_CAPS && read_caps (&r, caps);
+  if (res && consumed)
+    *consumed = r.data - data;
+  reader_clear (&r);
+
+  return res;
+}
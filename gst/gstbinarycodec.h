@@ -0,0 +1,51 @@
+/* GStreamer
+ *
+ * gstbinarycodec.h: Header for the binary structure and caps encoding
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef __GST_BINARY_CODEC_H__
+#define __GST_BINARY_CODEC_H__
+
+#include <glib.h>
+#include "gststructure.h"
+#include "gstcaps.h"
+
+G_BEGIN_DECLS
+
+/* The serialize functions accept %NULL, which is encoded as such, and
+ * return %NULL when a value can't be serialized. The deserialize functions
+ * return %FALSE for invalid or truncated data and store the number of bytes
+ * used from @data in @consumed. */
+G_GNUC_INTERNAL
+GBytes *   _priv_gst_binary_serialize_structure   (const GstStructure * structure);
+
+G_GNUC_INTERNAL
+gboolean   _priv_gst_binary_deserialize_structure (const guint8 * data, gsize size,
+                                                   gsize * consumed,
+                                                   GstStructure ** structure);
+
+G_GNUC_INTERNAL
+GBytes *   _priv_gst_binary_serialize_caps        (const GstCaps * caps);
+
+G_GNUC_INTERNAL
+gboolean   _priv_gst_binary_deserialize_caps      (const guint8 * data, gsize size,
+                                                   gsize * consumed,
+                                                   GstCaps ** caps);
+
+G_END_DECLS
+
+#endif /* __GST_BINARY_CODEC_H__ */
@@ -132,6 +132,7 @@
 #include "gstinfo.h"
 #include "gstutils.h"
 #include "gstversion.h"
+#include "gstslicecache.h"
 
 /* For g_memdup2 */
 #include "glib-compat-private.h"
@@ -148,9 +149,20 @@ GType _gst_buffer_type = 0;
 #define GST_BUFFER_MEM_LEN(b)      (((GstBufferImpl *)(b))->len)
 #define GST_BUFFER_MEM_ARRAY(b)    (((GstBufferImpl *)(b))->mem)
 #define GST_BUFFER_MEM_PTR(b,i)    (((GstBufferImpl *)(b))->mem[i])
+#define GST_BUFFER_MEM_ALLOC(b)    (((GstBufferImpl *)(b))->mem_alloc)
+#define GST_BUFFER_MEM_INLINE(b)   (((GstBufferImpl *)(b))->mem_inline)
 #define GST_BUFFER_BUFMEM(b)       (((GstBufferImpl *)(b))->bufmem)
 #define GST_BUFFER_META(b)         (((GstBufferImpl *)(b))->item)
 #define GST_BUFFER_TAIL_META(b)    (((GstBufferImpl *)(b))->tail_item)
+#define GST_BUFFER_META_APIS(b)    (((GstBufferImpl *)(b))->meta_apis)
+#define GST_BUFFER_META_AREA(b)    ((GstMetaItem *) ((GstBufferImpl *)(b))->meta_area)
+#define GST_BUFFER_META_AREA_USED(b) (((GstBufferImpl *)(b))->meta_area_used)
+
+/* size of the storage for one small meta inside the buffer, enough for the
+ * likes of crop, parent buffer and reference timestamp metas */
+#define GST_BUFFER_META_AREA_SIZE  64
+
+#define META_API_BIT(api)          (G_GUINT64_CONSTANT (1) << _priv_gst_meta_api_index (api))
 
 typedef struct
 {
@@ -158,9 +170,13 @@ typedef struct
 
   gsize slice_size;
 
-  /* the memory blocks */
+  /* the memory blocks, mem points to mem_inline until more than
+   * GST_BUFFER_MEM_MAX blocks are added, then to a heap array of mem_alloc
+   * entries */
   guint len;
-  GstMemory *mem[GST_BUFFER_MEM_MAX];
+  guint mem_alloc;
+  GstMemory **mem;
+  GstMemory *mem_inline[GST_BUFFER_MEM_MAX];
 
   /* memory of the buffer when allocated from 1 chunk */
   GstMemory *bufmem;
@@ -169,10 +185,50 @@ typedef struct
    * GstBufferImpl */
   GstMetaItem *item;
   GstMetaItem *tail_item;
+
+  /* bitmask of the APIs of the metas in item, see
+   * _priv_gst_meta_api_index() */
+  guint64 meta_apis;
+
+  /* storage for the first small meta that is added */
+  gboolean meta_area_used;
+  guint64 meta_area[GST_BUFFER_META_AREA_SIZE / sizeof (guint64)];
 } GstBufferImpl;
 
 static gint64 meta_seq;         /* 0 *//* ATOMIC */
 
+static GstMetaItem *
+_alloc_meta_item (GstBuffer * buffer, gsize size)
+{
+  if (size <= GST_BUFFER_META_AREA_SIZE && !GST_BUFFER_META_AREA_USED (buffer)) {
+    GST_BUFFER_META_AREA_USED (buffer) = TRUE;
+    return GST_BUFFER_META_AREA (buffer);
+  }
+  return _priv_gst_slice_cache_alloc (size);
+}
+
+static void
+_free_meta_item (GstBuffer * buffer, GstMetaItem * item, gsize size)
+{
+  if (item == GST_BUFFER_META_AREA (buffer))
+    GST_BUFFER_META_AREA_USED (buffer) = FALSE;
+  else
+    _priv_gst_slice_cache_free (size, item);
+}
+
+/* recalculate the API bitmask after metas were removed */
+static void
+_update_meta_apis (GstBuffer * buffer)
+{
+  GstMetaItem *walk;
+  guint64 apis = 0;
+
+  for (walk = GST_BUFFER_META (buffer); walk; walk = walk->next)
+    apis |= META_API_BIT (walk->meta.info->api);
+
+  GST_BUFFER_META_APIS (buffer) = apis;
+}
+
 /* TODO: use GLib's once https://gitlab.gnome.org/GNOME/glib/issues/1076 lands */
 #if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
 static inline gint64
@@ -461,23 +517,29 @@ _memory_add (GstBuffer * buffer, gint idx, GstMemory * mem)
 
   GST_CAT_LOG (GST_CAT_BUFFER, "buffer %p, idx %d, mem %p", buffer, idx, mem);
 
-  if (G_UNLIKELY (len >= GST_BUFFER_MEM_MAX)) {
-    /* too many buffer, span them. */
-    /* FIXME, there is room for improvement here: We could only try to merge
-     * 2 buffers to make some room. If we can't efficiently merge 2 buffers we
-     * could try to only merge the two smallest buffers to avoid memcpy, etc. */
-    GST_CAT_DEBUG (GST_CAT_PERFORMANCE, "memory array overflow in buffer %p",
-        buffer);
-    _replace_memory (buffer, len, 0, len, _get_merged_memory (buffer, 0, len));
-    /* we now have 1 single spanned buffer */
-    len = 1;
+  if (G_UNLIKELY (len >= GST_BUFFER_MEM_ALLOC (buffer))) {
+    /* the array is full, move it out of line or make it bigger. The memory
+     * blocks are never merged so that adding memory stays zero-copy. */
+    guint alloc = GST_BUFFER_MEM_ALLOC (buffer) * 2;
+
+    GST_CAT_DEBUG (GST_CAT_PERFORMANCE, "buffer %p grows memory array to %u",
+        buffer, alloc);
+    if (GST_BUFFER_MEM_ARRAY (buffer) == GST_BUFFER_MEM_INLINE (buffer)) {
+      GST_BUFFER_MEM_ARRAY (buffer) = g_new (GstMemory *, alloc);
+      memcpy (GST_BUFFER_MEM_ARRAY (buffer), GST_BUFFER_MEM_INLINE (buffer),
+          len * sizeof (gpointer));
+    } else {
+      GST_BUFFER_MEM_ARRAY (buffer) =
+          g_renew (GstMemory *, GST_BUFFER_MEM_ARRAY (buffer), alloc);
+    }
+    GST_BUFFER_MEM_ALLOC (buffer) = alloc;
   }
 
   if (idx == -1)
     idx = len;
 
   for (i = len; i > idx; i--) {
-    /* move buffers to insert, FIXME, we need to insert first and then merge */
+    /* move buffers to insert */
     GST_BUFFER_MEM_PTR (buffer, i) = GST_BUFFER_MEM_PTR (buffer, i - 1);
   }
   /* and insert the new buffer */
@@ -505,13 +567,14 @@ _priv_gst_buffer_initialize (void)
 /**
  * gst_buffer_get_max_memory:
  *
- * Gets the maximum amount of memory blocks that a buffer can hold. This is a
- * compile time constant that can be queried with the function.
+ * Gets the amount of memory blocks that a buffer can hold without allocating
+ * additional storage. This is a compile time constant that can be queried
+ * with the function.
  *
- * When more memory blocks are added, existing memory blocks will be merged
- * together to make room for the new block.
+ * Since 1.20, more memory blocks can be added to a buffer. They are kept in
+ * a separate array and are not merged.
  *
- * Returns: the maximum amount of memory blocks that a buffer can hold.
+ * Returns: the amount of memory blocks that a buffer holds inline.
  *
  * Since: 1.2
  */
@@ -665,7 +728,21 @@ gst_buffer_copy_into (GstBuffer * dest, GstBuffer * src,
     }
   }
 
-  if (flags & GST_BUFFER_COPY_META) {
+  if ((flags & GST_BUFFER_COPY_META) && GST_BUFFER_META (src)) {
+    GstMetaTransformCopy copy_data;
+    gboolean skip_memory_metas;
+
+    copy_data.region = region;
+    copy_data.offset = offset;
+    copy_data.size = size;
+
+    /* Don't copy memory metas if we only copied part of the buffer, didn't
+     * copy memories or merged memories. In all these cases the memory
+     * structure has changed and the memory meta becomes meaningless.
+     */
+    skip_memory_metas = region || !(flags & GST_BUFFER_COPY_MEMORY)
+        || (flags & GST_BUFFER_COPY_MERGE);
+
     /* NOTE: GstGLSyncMeta copying relies on the meta
      *       being copied now, after the buffer data,
      *       so this has to happen last */
@@ -673,29 +750,18 @@ gst_buffer_copy_into (GstBuffer * dest, GstBuffer * src,
       GstMeta *meta = &walk->meta;
       const GstMetaInfo *info = meta->info;
 
-      /* Don't copy memory metas if we only copied part of the buffer, didn't
-       * copy memories or merged memories. In all these cases the memory
-       * structure has changed and the memory meta becomes meaningless.
-       */
-      if ((region || !(flags & GST_BUFFER_COPY_MEMORY)
-              || (flags & GST_BUFFER_COPY_MERGE))
-          && gst_meta_api_type_has_tag (info->api, _gst_meta_tag_memory)) {
+      if (info->transform_func == NULL)
+        continue;
+
+      if (skip_memory_metas && _priv_gst_meta_info_is_memory (info)) {
         GST_CAT_DEBUG (GST_CAT_BUFFER,
             "don't copy memory meta %p of API type %s", meta,
             g_type_name (info->api));
-      } else if (info->transform_func) {
-        GstMetaTransformCopy copy_data;
-
-        copy_data.region = region;
-        copy_data.offset = offset;
-        copy_data.size = size;
-
-        if (!info->transform_func (dest, meta, src,
-                _gst_meta_transform_copy, &copy_data)) {
-          GST_CAT_ERROR (GST_CAT_BUFFER,
-              "failed to copy meta %p of API type %s", meta,
-              g_type_name (info->api));
-        }
+      } else if (!info->transform_func (dest, meta, src,
+              _gst_meta_transform_copy, &copy_data)) {
+        GST_CAT_ERROR (GST_CAT_BUFFER,
+            "failed to copy meta %p of API type %s", meta,
+            g_type_name (info->api));
       }
     }
   }
@@ -790,7 +856,7 @@ _gst_buffer_free (GstBuffer * buffer)
 
     next = walk->next;
     /* and free the slice */
-    g_slice_free1 (ITEM_SIZE (info), walk);
+    _free_meta_item (buffer, walk, ITEM_SIZE (info));
   }
 
   /* get the size, when unreffing the memory, we could also unref the buffer
@@ -805,13 +871,15 @@ _gst_buffer_free (GstBuffer * buffer)
             (buffer, i)), GST_MINI_OBJECT_CAST (buffer));
     gst_memory_unref (GST_BUFFER_MEM_PTR (buffer, i));
   }
+  if (GST_BUFFER_MEM_ARRAY (buffer) != GST_BUFFER_MEM_INLINE (buffer))
+    g_free (GST_BUFFER_MEM_ARRAY (buffer));
 
   /* we set msize to 0 when the buffer is part of the memory block */
   if (msize) {
 #ifdef USE_POISONING
     memset (buffer, 0xff, msize);
 #endif
-    g_slice_free1 (msize, buffer);
+    _priv_gst_slice_cache_free (msize, buffer);
   } else {
     gst_memory_unref (GST_BUFFER_BUFMEM (buffer));
   }
@@ -835,7 +903,11 @@ gst_buffer_init (GstBufferImpl * buffer, gsize size)
   GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_NONE;
 
   GST_BUFFER_MEM_LEN (buffer) = 0;
+  GST_BUFFER_MEM_ALLOC (buffer) = GST_BUFFER_MEM_MAX;
+  GST_BUFFER_MEM_ARRAY (buffer) = GST_BUFFER_MEM_INLINE (buffer);
   GST_BUFFER_META (buffer) = NULL;
+  GST_BUFFER_META_APIS (buffer) = 0;
+  GST_BUFFER_META_AREA_USED (buffer) = FALSE;
 }
 
 /**
@@ -850,7 +922,7 @@ gst_buffer_new (void)
 {
   GstBufferImpl *newbuf;
 
-  newbuf = g_slice_new (GstBufferImpl);
+  newbuf = _priv_gst_slice_cache_alloc (sizeof (GstBufferImpl));
   GST_CAT_LOG (GST_CAT_BUFFER, "new %p", newbuf);
 
   gst_buffer_init (newbuf, sizeof (GstBufferImpl));
@@ -1065,8 +1137,8 @@ gst_buffer_new_memdup (gconstpointer data, gsize size)
  * gst_buffer_n_memory:
  * @buffer: a #GstBuffer.
  *
- * Gets the amount of memory blocks that this buffer has. This amount is never
- * larger than what gst_buffer_get_max_memory() returns.
+ * Gets the amount of memory blocks that this buffer has. Since 1.20 this
+ * amount can be larger than what gst_buffer_get_max_memory() returns.
  *
  * Returns: the number of memory blocks this buffer is made of.
  */
@@ -1121,9 +1193,9 @@ gst_buffer_append_memory (GstBuffer * buffer, GstMemory * mem)
  * Inserts the memory block @mem into @buffer at @idx. This function takes ownership
  * of @mem and thus doesn't increase its refcount.
  *
- * Only gst_buffer_get_max_memory() can be added to a buffer. If more memory is
- * added, existing memory blocks will automatically be merged to make room for
- * the new memory.
+ * Before 1.20, only gst_buffer_get_max_memory() blocks could be added to a
+ * buffer and existing memory blocks were merged to make room for more. Now
+ * any number of memory blocks can be added without merging.
  */
 void
 gst_buffer_insert_memory (GstBuffer * buffer, gint idx, GstMemory * mem)
@@ -1915,6 +1987,120 @@ gst_buffer_unmap (GstBuffer * buffer, GstMapInfo * info)
   }
 }
 
+/**
+ * gst_buffer_map_vectored:
+ * @buffer: a #GstBuffer.
+ * @vec: (out caller-allocates): a #GstBufferMapVec
+ * @flags: flags for the mapping
+ *
+ * Maps every memory block in @buffer separately and fills @vec with one
+ * #GstMapInfo per block. Unlike gst_buffer_map(), the memory blocks are never
+ * merged, which makes this suitable for consumers that can handle scattered
+ * data such as writev().
+ *
+ * When the buffer is writable but a memory block could only be mapped by
+ * copying it, the copy replaces the memory block in @buffer.
+ *
+ * An empty buffer is mapped with no #GstMapInfo.
+ *
+ * Unmap @vec with gst_buffer_unmap_vectored() after usage.
+ *
+ * Returns: %TRUE if all the memory blocks could be mapped.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_buffer_map_vectored (GstBuffer * buffer, GstBufferMapVec * vec,
+    GstMapFlags flags)
+{
+  GstMemory *mem, *nmem;
+  gboolean write, writable;
+  guint i, len;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (vec != NULL, FALSE);
+
+  len = GST_BUFFER_MEM_LEN (buffer);
+
+  GST_CAT_LOG (GST_CAT_BUFFER, "buffer %p, %u memories, flags %04x",
+      buffer, len, flags);
+
+  vec->n_maps = 0;
+  if (len <= G_N_ELEMENTS (vec->maps_static))
+    vec->maps = vec->maps_static;
+  else
+    vec->maps = g_new (GstMapInfo, len);
+
+  write = (flags & GST_MAP_WRITE) != 0;
+  writable = gst_buffer_is_writable (buffer);
+
+  /* check if we can write when asked for write access */
+  if (G_UNLIKELY (write && !writable))
+    goto not_writable;
+
+  for (i = 0; i < len; i++) {
+    mem = gst_memory_ref (GST_BUFFER_MEM_PTR (buffer, i));
+
+    nmem = gst_memory_make_mapped (mem, &vec->maps[i], flags);
+    if (G_UNLIKELY (nmem == NULL))
+      goto cannot_map;
+
+    /* the map returned a different memory, replace it when we can */
+    if (G_UNLIKELY (nmem != mem)) {
+      if (writable) {
+        _replace_memory (buffer, len, i, 1, gst_memory_ref (nmem));
+      } else {
+        GST_CAT_DEBUG (GST_CAT_PERFORMANCE,
+            "temporary mapping for memory %p in buffer %p", nmem, buffer);
+      }
+    }
+    vec->n_maps++;
+  }
+  return TRUE;
+
+  /* ERROR */
+not_writable:
+  {
+    GST_WARNING ("write map requested on non-writable buffer");
+    g_critical ("write map requested on non-writable buffer");
+    gst_buffer_unmap_vectored (buffer, vec);
+    return FALSE;
+  }
+cannot_map:
+  {
+    GST_DEBUG ("cannot map memory %u", i);
+    gst_buffer_unmap_vectored (buffer, vec);
+    return FALSE;
+  }
+}
+
+/**
+ * gst_buffer_unmap_vectored:
+ * @buffer: a #GstBuffer.
+ * @vec: a #GstBufferMapVec
+ *
+ * Releases the memory previously mapped with gst_buffer_map_vectored().
+ *
+ * Since: 1.20
+ */
+void
+gst_buffer_unmap_vectored (GstBuffer * buffer, GstBufferMapVec * vec)
+{
+  guint i;
+
+  g_return_if_fail (GST_IS_BUFFER (buffer));
+  g_return_if_fail (vec != NULL);
+
+  for (i = 0; i < vec->n_maps; i++) {
+    gst_memory_unmap (vec->maps[i].memory, &vec->maps[i]);
+    gst_memory_unref (vec->maps[i].memory);
+  }
+  if (vec->maps != vec->maps_static)
+    g_free (vec->maps);
+  vec->n_maps = 0;
+  vec->maps = NULL;
+}
+
 /**
  * gst_buffer_fill:
  * @buffer: a #GstBuffer.
@@ -2245,6 +2431,10 @@ gst_buffer_get_meta (GstBuffer * buffer, GType api)
   g_return_val_if_fail (buffer != NULL, NULL);
   g_return_val_if_fail (api != 0, NULL);
 
+  /* check if there can be such a meta at all */
+  if (!(GST_BUFFER_META_APIS (buffer) & META_API_BIT (api)))
+    return NULL;
+
   /* find GstMeta of the requested API */
   for (item = GST_BUFFER_META (buffer); item; item = item->next) {
     GstMeta *meta = &item->meta;
@@ -2306,10 +2496,9 @@ gst_buffer_add_meta (GstBuffer * buffer, const GstMetaInfo * info,
    * init function but let's play safe here and prevent
    * uninitialized memory
    */
+  item = _alloc_meta_item (buffer, size);
   if (!info->init_func)
-    item = g_slice_alloc0 (size);
-  else
-    item = g_slice_alloc (size);
+    memset (item, 0, size);
   result = &item->meta;
   result->info = info;
   result->flags = GST_META_FLAG_NONE;
@@ -2332,12 +2521,13 @@ gst_buffer_add_meta (GstBuffer * buffer, const GstMetaInfo * info,
     GST_BUFFER_TAIL_META (buffer)->next = item;
     GST_BUFFER_TAIL_META (buffer) = item;
   }
+  GST_BUFFER_META_APIS (buffer) |= META_API_BIT (info->api);
 
   return result;
 
 init_failed:
   {
-    g_slice_free1 (size, item);
+    _free_meta_item (buffer, item, size);
     return NULL;
   }
 }
@@ -2388,11 +2578,14 @@ gst_buffer_remove_meta (GstBuffer * buffer, GstMeta * meta)
         info->free_func (m, buffer);
 
       /* and free the slice */
-      g_slice_free1 (ITEM_SIZE (info), walk);
+      _free_meta_item (buffer, walk, ITEM_SIZE (info));
       break;
     }
     prev = walk;
   }
+  if (walk)
+    _update_meta_apis (buffer);
+
   return walk != NULL;
 }
 
@@ -2458,10 +2651,12 @@ gst_buffer_iterate_meta_filtered (GstBuffer * buffer, gpointer * state,
   g_return_val_if_fail (state != NULL, NULL);
 
   meta = (GstMetaItem **) state;
-  if (*meta == NULL)
-    /* state NULL, move to first item */
+  if (*meta == NULL) {
+    /* state NULL, move to first item if there can be a matching one */
+    if (!(GST_BUFFER_META_APIS (buffer) & META_API_BIT (meta_api_type)))
+      return NULL;
     *meta = GST_BUFFER_META (buffer);
-  else
+  } else
     /* state !NULL, move to next item in list */
     *meta = (*meta)->next;
 
@@ -2494,6 +2689,7 @@ gst_buffer_foreach_meta (GstBuffer * buffer, GstBufferForeachMetaFunc func,
 {
   GstMetaItem *walk, *prev, *next;
   gboolean res = TRUE;
+  gboolean removed = FALSE;
 
   g_return_val_if_fail (buffer != NULL, FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
@@ -2536,13 +2732,17 @@ gst_buffer_foreach_meta (GstBuffer * buffer, GstBufferForeachMetaFunc func,
         info->free_func (m, buffer);
 
       /* and free the slice */
-      g_slice_free1 (ITEM_SIZE (info), walk);
+      _free_meta_item (buffer, walk, ITEM_SIZE (info));
+      removed = TRUE;
     } else {
       prev = walk;
     }
     if (!res)
       break;
   }
+  if (removed)
+    _update_meta_apis (buffer);
+
   return res;
 }
 
@@ -294,6 +294,25 @@ struct _GstBuffer {
   guint64                offset_end;
 };
 
+/**
+ * GstBufferMapVec:
+ * @n_maps: the number of mapped memory blocks
+ * @maps: (array length=n_maps): the #GstMapInfo of every memory block
+ *
+ * The result of gst_buffer_map_vectored(). It contains one #GstMapInfo for
+ * every memory block of the buffer, in order.
+ *
+ * Since: 1.20
+ */
+typedef struct {
+  guint                  n_maps;
+  GstMapInfo            *maps;
+
+  /*< private >*/
+  GstMapInfo             maps_static[16];
+  gpointer               _gst_reserved[GST_PADDING];
+} GstBufferMapVec;
+
 GST_API
 GType       gst_buffer_get_type            (void);
 
@@ -413,6 +432,12 @@ gboolean    gst_buffer_map                 (GstBuffer *buffer, GstMapInfo *info,
 GST_API
 void        gst_buffer_unmap               (GstBuffer *buffer, GstMapInfo *info);
 
+GST_API
+gboolean    gst_buffer_map_vectored        (GstBuffer *buffer, GstBufferMapVec *vec,
+                                            GstMapFlags flags);
+GST_API
+void        gst_buffer_unmap_vectored      (GstBuffer *buffer, GstBufferMapVec *vec);
+
 GST_API
 void        gst_buffer_extract_dup         (GstBuffer *buffer, gsize offset,
                                             gsize size, gpointer *dest,
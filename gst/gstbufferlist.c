@@ -41,6 +41,7 @@
 
 #include "gstbuffer.h"
 #include "gstbufferlist.h"
+#include "gstslicecache.h"
 #include "gstutils.h"
 
 #define GST_CAT_DEFAULT GST_CAT_BUFFER_LIST
@@ -79,20 +80,39 @@ _priv_gst_buffer_list_initialize (void)
   _gst_buffer_list_type = gst_buffer_list_get_type ();
 }
 
+/* number of times the buffer at @idx is repeated from @idx on, so that
+ * lists that contain the same buffer many times can ref and unref it with a
+ * single atomic operation */
+static inline guint
+_gst_buffer_list_run_length (GstBufferList * list, guint idx)
+{
+  guint n = 1;
+
+  while (idx + n < list->n_buffers
+      && list->buffers[idx + n] == list->buffers[idx])
+    n++;
+
+  return n;
+}
+
 static GstBufferList *
 _gst_buffer_list_copy (GstBufferList * list)
 {
   GstBufferList *copy;
-  guint i, len;
+  guint i, j, n, len;
 
   len = list->n_buffers;
   copy = gst_buffer_list_new_sized (list->n_allocated);
 
   /* add and ref all buffers in the array */
-  for (i = 0; i < len; i++) {
-    copy->buffers[i] = gst_buffer_ref (list->buffers[i]);
-    gst_mini_object_add_parent (GST_MINI_OBJECT_CAST (copy->buffers[i]),
-        GST_MINI_OBJECT_CAST (copy));
+  for (i = 0; i < len; i += n) {
+    n = _gst_buffer_list_run_length (list, i);
+    gst_mini_object_ref_n (GST_MINI_OBJECT_CAST (list->buffers[i]), n);
+    for (j = i; j < i + n; j++) {
+      copy->buffers[j] = list->buffers[i];
+      gst_mini_object_add_parent (GST_MINI_OBJECT_CAST (copy->buffers[j]),
+          GST_MINI_OBJECT_CAST (copy));
+    }
   }
 
   copy->n_buffers = len;
@@ -103,17 +123,19 @@ _gst_buffer_list_copy (GstBufferList * list)
 static void
 _gst_buffer_list_free (GstBufferList * list)
 {
-  guint i, len;
+  guint i, j, n, len;
   gsize slice_size;
 
   GST_LOG ("free %p", list);
 
   /* unrefs all buffers too */
   len = list->n_buffers;
-  for (i = 0; i < len; i++) {
-    gst_mini_object_remove_parent (GST_MINI_OBJECT_CAST (list->buffers[i]),
-        GST_MINI_OBJECT_CAST (list));
-    gst_buffer_unref (list->buffers[i]);
+  for (i = 0; i < len; i += n) {
+    n = _gst_buffer_list_run_length (list, i);
+    for (j = i; j < i + n; j++)
+      gst_mini_object_remove_parent (GST_MINI_OBJECT_CAST (list->buffers[j]),
+          GST_MINI_OBJECT_CAST (list));
+    gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (list->buffers[i]), n);
   }
 
   if (GST_BUFFER_LIST_IS_USING_DYNAMIC_ARRAY (list))
@@ -125,7 +147,7 @@ _gst_buffer_list_free (GstBufferList * list)
   memset (list, 0xff, slice_size);
 #endif
 
-  g_slice_free1 (slice_size, list);
+  _priv_gst_slice_cache_free (slice_size, list);
 }
 
 static void
@@ -166,7 +188,7 @@ gst_buffer_list_new_sized (guint size)
 
   slice_size = sizeof (GstBufferList) + (n_allocated - 1) * sizeof (gpointer);
 
-  list = g_slice_alloc0 (slice_size);
+  list = _priv_gst_slice_cache_alloc0 (slice_size);
 
   GST_LOG ("new %p", list);
 
@@ -479,6 +501,26 @@ gst_buffer_list_remove (GstBufferList * list, guint idx, guint length)
   gst_buffer_list_remove_range_internal (list, idx, length, TRUE);
 }
 
+/**
+ * gst_buffer_list_reset:
+ * @list: a #GstBufferList
+ *
+ * Removes all buffers from @list. Unlike creating a new list, the storage of
+ * @list is kept so that it can be filled again without reallocating, for
+ * example when a new list of the same size is built for every batch of
+ * buffers.
+ *
+ * Since: 1.20
+ */
+void
+gst_buffer_list_reset (GstBufferList * list)
+{
+  g_return_if_fail (GST_IS_BUFFER_LIST (list));
+  g_return_if_fail (gst_buffer_list_is_writable (list));
+
+  gst_buffer_list_remove_range_internal (list, 0, list->n_buffers, TRUE);
+}
+
 /**
  * gst_buffer_list_copy_deep:
  * @list: a #GstBufferList
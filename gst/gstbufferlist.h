@@ -168,6 +168,9 @@ void                     gst_buffer_list_insert                (GstBufferList *l
 GST_API
 void                     gst_buffer_list_remove                (GstBufferList *list, guint idx, guint length);
 
+GST_API
+void                     gst_buffer_list_reset                 (GstBufferList *list);
+
 GST_API
 gboolean                 gst_buffer_list_foreach               (GstBufferList *list,
                                                                 GstBufferListFunc func,
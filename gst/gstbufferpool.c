@@ -64,26 +64,13 @@
 #include "gst_private.h"
 #include "glib-compat-private.h"
 
-#include <errno.h>
-#ifdef HAVE_UNISTD_H
-#  include <unistd.h>
-#endif
-#include <sys/types.h>
-
 #include "gstatomicqueue.h"
-#include "gstpoll.h"
 #include "gstinfo.h"
 #include "gstquark.h"
 #include "gstvalue.h"
 
 #include "gstbufferpool.h"
 
-#ifdef G_OS_WIN32
-#  ifndef EWOULDBLOCK
-#  define EWOULDBLOCK EAGAIN    /* This is just to placate gcc */
-#  endif
-#endif /* G_OS_WIN32 */
-
 GST_DEBUG_CATEGORY_STATIC (gst_buffer_pool_debug);
 #define GST_CAT_DEFAULT gst_buffer_pool_debug
 
@@ -93,7 +80,15 @@ GST_DEBUG_CATEGORY_STATIC (gst_buffer_pool_debug);
 struct _GstBufferPoolPrivate
 {
   GstAtomicQueue *queue;
-  GstPoll *poll;
+
+  /* Threads waiting for a buffer block on wait_cond. Releasing a buffer or
+   * flushing increments the wakeup sequence number. The cond is only
+   * signalled when there are waiters, so that acquiring and releasing
+   * buffers does not need any syscalls when no thread needs to wait. */
+  GMutex wait_lock;
+  GCond wait_cond;
+  gint waiters;
+  gint wakeup_seqnum;
 
   GRecMutex rec_lock;
 
@@ -110,6 +105,20 @@ struct _GstBufferPoolPrivate
   guint cur_buffers;
   GstAllocator *allocator;
   GstAllocationParams params;
+
+  /* free buffers that are idle for longer than this are trimmed, 0 to
+   * disable trimming */
+  GstClockTime idle_timeout;
+  /* lowest number of free buffers since the last trim */
+  gint trim_lowmark;
+  GstClockTime trim_last;
+  gint trimming;
+
+  /* statistics of the default acquire_buffer */
+  gint stats_hits;
+  gint stats_misses;
+  gint stats_waits;
+  GstClockTime stats_wait_time;
 };
 
 static void gst_buffer_pool_finalize (GObject * object);
@@ -157,7 +166,8 @@ gst_buffer_pool_init (GstBufferPool * pool)
 
   g_rec_mutex_init (&priv->rec_lock);
 
-  priv->poll = gst_poll_new_timer ();
+  g_mutex_init (&priv->wait_lock);
+  g_cond_init (&priv->wait_cond);
   priv->queue = gst_atomic_queue_new (16);
   pool->flushing = 1;
   priv->active = FALSE;
@@ -169,11 +179,6 @@ gst_buffer_pool_init (GstBufferPool * pool)
   gst_allocation_params_init (&priv->params);
   gst_buffer_pool_config_set_allocator (priv->config, priv->allocator,
       &priv->params);
-  /* 1 control write for flushing - the flush token */
-  gst_poll_write_control (priv->poll);
-  /* 1 control write for marking that we are not waiting for poll - the wait token */
-  gst_poll_write_control (priv->poll);
-
   GST_DEBUG_OBJECT (pool, "created");
 }
 
@@ -190,7 +195,8 @@ gst_buffer_pool_finalize (GObject * object)
 
   gst_buffer_pool_set_active (pool, FALSE);
   gst_atomic_queue_unref (priv->queue);
-  gst_poll_free (priv->poll);
+  g_mutex_clear (&priv->wait_lock);
+  g_cond_clear (&priv->wait_cond);
   gst_structure_free (priv->config);
   g_rec_mutex_clear (&priv->rec_lock);
   if (priv->allocator)
@@ -391,20 +397,8 @@ default_stop (GstBufferPool * pool)
   GstBuffer *buffer;
 
   /* clear the pool */
-  while ((buffer = gst_atomic_queue_pop (priv->queue))) {
-    while (!gst_poll_read_control (priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* We put the buffer into the queue but did not finish writing control
-         * yet, let's wait a bit and retry */
-        g_thread_yield ();
-        continue;
-      } else {
-        /* Critical error but GstPoll already complained */
-        break;
-      }
-    }
+  while ((buffer = gst_atomic_queue_pop (priv->queue)))
     do_free_buffer (pool, buffer);
-  }
   return priv->cur_buffers == 0;
 }
 
@@ -429,11 +423,32 @@ do_stop (GstBufferPool * pool)
   return TRUE;
 }
 
+/* wake up the threads waiting for a buffer, @all is used to wake up all of
+ * them instead of just one */
+static inline void
+wakeup_waiters (GstBufferPool * pool, gboolean all)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+
+  g_atomic_int_inc (&priv->wakeup_seqnum);
+
+  /* pairs with the waiters increment in default_acquire_buffer(), either the
+   * waiter sees the new seqnum or we see the waiter */
+  if (G_LIKELY (g_atomic_int_get (&priv->waiters) == 0))
+    return;
+
+  g_mutex_lock (&priv->wait_lock);
+  if (all)
+    g_cond_broadcast (&priv->wait_cond);
+  else
+    g_cond_signal (&priv->wait_cond);
+  g_mutex_unlock (&priv->wait_lock);
+}
+
 /* must be called with the lock */
 static void
 do_set_flushing (GstBufferPool * pool, gboolean flushing)
 {
-  GstBufferPoolPrivate *priv = pool->priv;
   GstBufferPoolClass *pclass;
 
   pclass = GST_BUFFER_POOL_GET_CLASS (pool);
@@ -443,8 +458,8 @@ do_set_flushing (GstBufferPool * pool, gboolean flushing)
 
   if (flushing) {
     g_atomic_int_set (&pool->flushing, 1);
-    /* Write the flush token to wake up any waiters */
-    gst_poll_write_control (priv->poll);
+    /* wake up any waiters */
+    wakeup_waiters (pool, TRUE);
 
     if (pclass->flush_start)
       pclass->flush_start (pool);
@@ -452,19 +467,6 @@ do_set_flushing (GstBufferPool * pool, gboolean flushing)
     if (pclass->flush_stop)
       pclass->flush_stop (pool);
 
-    while (!gst_poll_read_control (priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* This should not really happen unless flushing and unflushing
-         * happens on different threads. Let's wait a bit to get back flush
-         * token from the thread that was setting it to flushing */
-        g_thread_yield ();
-        continue;
-      } else {
-        /* Critical error but GstPoll already complained */
-        break;
-      }
-    }
-
     g_atomic_int_set (&pool->flushing, 0);
   }
 }
@@ -594,12 +596,16 @@ default_set_config (GstBufferPool * pool, GstStructure * config)
   guint size, min_buffers, max_buffers;
   GstAllocator *allocator;
   GstAllocationParams params;
+  GstClockTime idle_timeout;
 
   /* parse the config and keep around */
   if (!gst_buffer_pool_config_get_params (config, &caps, &size, &min_buffers,
           &max_buffers))
     goto wrong_config;
 
+  if (!gst_buffer_pool_config_get_idle_timeout (config, &idle_timeout))
+    idle_timeout = 0;
+
   if (!gst_buffer_pool_config_get_allocator (config, &allocator, &params))
     goto wrong_config;
 
@@ -609,6 +615,9 @@ default_set_config (GstBufferPool * pool, GstStructure * config)
   priv->min_buffers = min_buffers;
   priv->max_buffers = max_buffers;
   priv->cur_buffers = 0;
+  priv->idle_timeout = GST_CLOCK_TIME_IS_VALID (idle_timeout) ? idle_timeout : 0;
+  priv->trim_lowmark = 0;
+  priv->trim_last = GST_CLOCK_TIME_NONE;
 
   if (priv->allocator)
     gst_object_unref (priv->allocator);
@@ -865,6 +874,58 @@ gst_buffer_pool_config_set_allocator (GstStructure * config,
       GST_QUARK (PARAMS), GST_TYPE_ALLOCATION_PARAMS, params, NULL);
 }
 
+/**
+ * gst_buffer_pool_config_set_idle_timeout:
+ * @config: a #GstBufferPool configuration
+ * @idle_timeout: the idle time after which free buffers are freed
+ *
+ * Enables adaptive sizing of the pool.
+ *
+ * The pool allocates buffers on demand up to the maximum number of buffers
+ * configured with gst_buffer_pool_config_set_params() as usual. With an
+ * @idle_timeout, free buffers that were not needed for @idle_timeout are
+ * freed again when buffers are released, until the pool is back to its
+ * minimum number of buffers. This keeps the memory use of pools with a
+ * generous maximum number of buffers close to what is actually used.
+ *
+ * An @idle_timeout of 0 or %GST_CLOCK_TIME_NONE disables trimming, which is
+ * the default.
+ *
+ * Since: 1.20
+ */
+void
+gst_buffer_pool_config_set_idle_timeout (GstStructure * config,
+    GstClockTime idle_timeout)
+{
+  g_return_if_fail (config != NULL);
+
+  gst_structure_id_set (config,
+      GST_QUARK (IDLE_TIMEOUT), G_TYPE_UINT64, idle_timeout, NULL);
+}
+
+/**
+ * gst_buffer_pool_config_get_idle_timeout:
+ * @config: (transfer none): a #GstBufferPool configuration
+ * @idle_timeout: (out): the idle timeout
+ *
+ * Gets the idle timeout configured with
+ * gst_buffer_pool_config_set_idle_timeout() from @config.
+ *
+ * Returns: %TRUE if @config contains an idle timeout.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_buffer_pool_config_get_idle_timeout (GstStructure * config,
+    GstClockTime * idle_timeout)
+{
+  g_return_val_if_fail (config != NULL, FALSE);
+  g_return_val_if_fail (idle_timeout != NULL, FALSE);
+
+  return gst_structure_id_get (config,
+      GST_QUARK (IDLE_TIMEOUT), G_TYPE_UINT64, idle_timeout, NULL);
+}
+
 /**
  * gst_buffer_pool_config_add_option:
  * @config: a #GstBufferPool configuration
@@ -1089,36 +1150,109 @@ gst_buffer_pool_config_validate_params (GstStructure * config, GstCaps * caps,
   return ret;
 }
 
+static inline void
+update_trim_lowmark (GstBufferPool * pool, gint n_free)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  gint lowmark;
+
+  do {
+    lowmark = g_atomic_int_get (&priv->trim_lowmark);
+    if (lowmark <= n_free)
+      break;
+  } while (!g_atomic_int_compare_and_exchange (&priv->trim_lowmark, lowmark,
+          n_free));
+}
+
+/* Free the buffers that stayed in the queue for the whole last idle period,
+ * without going below the minimum number of buffers. Called from the release
+ * path, there is at most one thread trimming at a time. */
+static void
+trim_idle_buffers (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv = pool->priv;
+  GstClockTime now;
+  gint n_idle, n_excess;
+
+  if (!g_atomic_int_compare_and_exchange (&priv->trimming, 0, 1))
+    return;
+
+  now = gst_util_get_timestamp ();
+  if (!GST_CLOCK_TIME_IS_VALID (priv->trim_last)) {
+    /* first release, start the idle period */
+    priv->trim_last = now;
+    g_atomic_int_set (&priv->trim_lowmark,
+        gst_atomic_queue_length (priv->queue));
+    goto done;
+  }
+
+  if (now - priv->trim_last < priv->idle_timeout)
+    goto done;
+
+  n_idle = g_atomic_int_get (&priv->trim_lowmark);
+  n_excess = (gint) g_atomic_int_get (&priv->cur_buffers) -
+      (gint) priv->min_buffers;
+
+  while (n_idle > 0 && n_excess > 0) {
+    GstBuffer *buffer;
+
+    if (!(buffer = gst_atomic_queue_pop (priv->queue)))
+      break;
+
+    GST_CAT_DEBUG_OBJECT (GST_CAT_PERFORMANCE, pool,
+        "trimming idle buffer %p", buffer);
+    do_free_buffer (pool, buffer);
+    n_idle--;
+    n_excess--;
+  }
+
+  /* start a new idle period */
+  priv->trim_last = now;
+  g_atomic_int_set (&priv->trim_lowmark, gst_atomic_queue_length (priv->queue));
+
+done:
+  g_atomic_int_set (&priv->trimming, 0);
+}
+
 static GstFlowReturn
 default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
     GstBufferPoolAcquireParams * params)
 {
   GstFlowReturn result;
   GstBufferPoolPrivate *priv = pool->priv;
+  gboolean missed = FALSE;
 
   while (TRUE) {
+    gint seqnum;
+    GstClockTime start;
+
     if (G_UNLIKELY (GST_BUFFER_POOL_IS_FLUSHING (pool)))
       goto flushing;
 
+    /* any release after this point will make us retry instead of wait */
+    seqnum = g_atomic_int_get (&priv->wakeup_seqnum);
+
     /* try to get a buffer from the queue */
     *buffer = gst_atomic_queue_pop (priv->queue);
     if (G_LIKELY (*buffer)) {
-      while (!gst_poll_read_control (priv->poll)) {
-        if (errno == EWOULDBLOCK) {
-          /* We put the buffer into the queue but did not finish writing control
-           * yet, let's wait a bit and retry */
-          g_thread_yield ();
-          continue;
-        } else {
-          /* Critical error but GstPoll already complained */
-          break;
-        }
-      }
+      if (G_UNLIKELY (priv->idle_timeout))
+        update_trim_lowmark (pool, gst_atomic_queue_length (priv->queue));
+      if (G_LIKELY (!missed))
+        g_atomic_int_inc (&priv->stats_hits);
       result = GST_FLOW_OK;
       GST_LOG_OBJECT (pool, "acquired buffer %p", *buffer);
       break;
     }
 
+    if (!missed) {
+      g_atomic_int_inc (&priv->stats_misses);
+      missed = TRUE;
+    }
+
+    /* all buffers are in use, none of them is idle */
+    if (G_UNLIKELY (priv->idle_timeout))
+      update_trim_lowmark (pool, 0);
+
     /* no buffer, try to allocate some more */
     GST_LOG_OBJECT (pool, "no buffer, trying to allocate");
     result = do_alloc_buffer (pool, buffer, params);
@@ -1136,35 +1270,17 @@ default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
       break;
     }
 
-    /* now we release the control socket, we wait for a buffer release or
-     * flushing */
-    if (!gst_poll_read_control (pool->priv->poll)) {
-      if (errno == EWOULDBLOCK) {
-        /* This means that we have two threads trying to allocate buffers
-         * already, and the other one already got the wait token. This
-         * means that we only have to wait for the poll now and not write the
-         * token afterwards: we will be woken up once the other thread is
-         * woken up and that one will write the wait token it removed */
-        GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
-        gst_poll_wait (priv->poll, GST_CLOCK_TIME_NONE);
-      } else {
-        /* This is a critical error, GstPoll already gave a warning */
-        result = GST_FLOW_ERROR;
-        break;
-      }
-    } else {
-      /* We're the first thread waiting, we got the wait token and have to
-       * write it again later
-       * OR
-       * We're a second thread and just consumed the flush token and block all
-       * other threads, in which case we must not wait and give it back
-       * immediately */
-      if (!GST_BUFFER_POOL_IS_FLUSHING (pool)) {
-        GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
-        gst_poll_wait (priv->poll, GST_CLOCK_TIME_NONE);
-      }
-      gst_poll_write_control (pool->priv->poll);
-    }
+    /* wait for a buffer release or flushing */
+    GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
+    start = gst_util_get_timestamp ();
+    g_mutex_lock (&priv->wait_lock);
+    g_atomic_int_inc (&priv->waiters);
+    while (g_atomic_int_get (&priv->wakeup_seqnum) == seqnum)
+      g_cond_wait (&priv->wait_cond, &priv->wait_lock);
+    g_atomic_int_add (&priv->waiters, -1);
+    priv->stats_waits++;
+    priv->stats_wait_time += gst_util_get_timestamp () - start;
+    g_mutex_unlock (&priv->wait_lock);
   }
 
   return result;
@@ -1278,6 +1394,8 @@ gst_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
     /* all buffers from the pool point to the pool and have the refcount of the
      * pool incremented */
     (*buffer)->pool = gst_object_ref (pool);
+    GST_TRACER_BUFFER_POOL_ACQUIRE (pool, *buffer);
+    GST_SDT_PROBE2 (buffer_pool_acquire, pool, *buffer);
   } else {
     dec_outstanding (pool);
   }
@@ -1306,7 +1424,10 @@ default_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
 
   /* keep it around in our queue */
   gst_atomic_queue_push (pool->priv->queue, buffer);
-  gst_poll_write_control (pool->priv->poll);
+  wakeup_waiters (pool, FALSE);
+
+  if (G_UNLIKELY (pool->priv->idle_timeout))
+    trim_idle_buffers (pool);
 
   return;
 
@@ -1332,7 +1453,8 @@ not_writable:
 discard:
   {
     do_free_buffer (pool, buffer);
-    gst_poll_write_control (pool->priv->poll);
+    /* there is room to allocate a new buffer now */
+    wakeup_waiters (pool, FALSE);
     return;
   }
 }
@@ -1361,6 +1483,9 @@ gst_buffer_pool_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
   if (!g_atomic_pointer_compare_and_exchange (&buffer->pool, pool, NULL))
     return;
 
+  GST_TRACER_BUFFER_POOL_RELEASE (pool, buffer);
+  GST_SDT_PROBE2 (buffer_pool_release, pool, buffer);
+
   pclass = GST_BUFFER_POOL_GET_CLASS (pool);
 
   /* reset the buffer when needed */
@@ -1409,3 +1534,53 @@ gst_buffer_pool_set_flushing (GstBufferPool * pool, gboolean flushing)
 done:
   GST_BUFFER_POOL_UNLOCK (pool);
 }
+
+/**
+ * gst_buffer_pool_get_stats:
+ * @pool: a #GstBufferPool
+ *
+ * Get statistics about the buffers acquired from @pool with the default
+ * #GstBufferPoolClass.acquire_buffer() implementation.
+ *
+ * The returned structure has the following fields:
+ *
+ * * "hits" (guint): the number of acquired buffers that were taken from the
+ *   free buffers of the pool
+ * * "misses" (guint): the number of acquire calls that did not find a free
+ *   buffer and had to allocate one or wait
+ * * "hit-rate" (gdouble): the ratio of hits to all acquire calls
+ * * "waits" (guint): the number of times an acquire call had to wait for a
+ *   buffer to be released
+ * * "wait-time" (guint64): the total time in nanoseconds spent waiting
+ *
+ * Returns: (transfer full): a #GstStructure with the statistics of @pool
+ *
+ * Since: 1.20
+ */
+GstStructure *
+gst_buffer_pool_get_stats (GstBufferPool * pool)
+{
+  GstBufferPoolPrivate *priv;
+  guint hits, misses, waits;
+  GstClockTime wait_time;
+
+  g_return_val_if_fail (GST_IS_BUFFER_POOL (pool), NULL);
+
+  priv = pool->priv;
+
+  hits = g_atomic_int_get (&priv->stats_hits);
+  misses = g_atomic_int_get (&priv->stats_misses);
+
+  g_mutex_lock (&priv->wait_lock);
+  waits = priv->stats_waits;
+  wait_time = priv->stats_wait_time;
+  g_mutex_unlock (&priv->wait_lock);
+
+  return gst_structure_new ("application/x-gst-buffer-pool-stats",
+      "hits", G_TYPE_UINT, hits,
+      "misses", G_TYPE_UINT, misses,
+      "hit-rate", G_TYPE_DOUBLE,
+      hits + misses ? (gdouble) hits / (hits + misses) : 0.0,
+      "waits", G_TYPE_UINT, waits,
+      "wait-time", G_TYPE_UINT64, wait_time, NULL);
+}
@@ -300,6 +300,9 @@ gboolean         gst_buffer_pool_has_option      (GstBufferPool *pool, const gch
 GST_API
 void             gst_buffer_pool_set_flushing    (GstBufferPool *pool, gboolean flushing);
 
+GST_API
+GstStructure *   gst_buffer_pool_get_stats       (GstBufferPool *pool);
+
 /* helpers for configuring the config structure */
 
 GST_API
@@ -318,6 +321,12 @@ GST_API
 gboolean         gst_buffer_pool_config_get_allocator (GstStructure *config, GstAllocator **allocator,
                                                        GstAllocationParams *params);
 
+GST_API
+void             gst_buffer_pool_config_set_idle_timeout (GstStructure *config, GstClockTime idle_timeout);
+
+GST_API
+gboolean         gst_buffer_pool_config_get_idle_timeout (GstStructure *config, GstClockTime *idle_timeout);
+
 /* options */
 
 GST_API
@@ -152,8 +152,33 @@ struct _GstBusPrivate
   gboolean enable_async;
   GstPoll *poll;
   GPollFD pollfd;
+
+  /* types of messages that are queued for asynchronous delivery */
+  GstMessageType async_types;
+
+  /* types of messages of which only the newest one is kept, protected by
+   * coalesce_lock */
+  GMutex coalesce_lock;
+  GstMessageType coalesce_types;
+  GHashTable *coalesced;
+  gint n_coalesced;
 };
 
+/* A message in the queue that is to be replaced by a newer one with the same
+ * type, source and structure name when it is popped */
+typedef struct
+{
+  GstMessageType type;
+  GstObject *src;
+  GQuark name;
+
+  GstMessage *queued;
+  GstMessage *latest;
+} CoalescedMessage;
+
+/* messages handled in one dispatch of a bus watch */
+#define BUS_WATCH_MAX_DISPATCH 32
+
 #define gst_bus_parent_class parent_class
 G_DEFINE_TYPE_WITH_PRIVATE (GstBus, gst_bus, GST_TYPE_OBJECT);
 
@@ -250,7 +275,9 @@ gst_bus_init (GstBus * bus)
 {
   bus->priv = gst_bus_get_instance_private (bus);
   bus->priv->enable_async = DEFAULT_ENABLE_ASYNC;
+  bus->priv->async_types = GST_MESSAGE_ANY;
   g_mutex_init (&bus->priv->queue_lock);
+  g_mutex_init (&bus->priv->coalesce_lock);
   bus->priv->queue = gst_atomic_queue_new (32);
 
   GST_DEBUG_OBJECT (bus, "created");
@@ -264,6 +291,14 @@ gst_bus_dispose (GObject * object)
   if (bus->priv->queue) {
     GstMessage *message;
 
+    g_mutex_lock (&bus->priv->coalesce_lock);
+    if (bus->priv->coalesced) {
+      g_hash_table_unref (bus->priv->coalesced);
+      bus->priv->coalesced = NULL;
+    }
+    g_mutex_unlock (&bus->priv->coalesce_lock);
+    g_mutex_clear (&bus->priv->coalesce_lock);
+
     g_mutex_lock (&bus->priv->queue_lock);
     do {
       message = gst_atomic_queue_pop (bus->priv->queue);
@@ -315,6 +350,120 @@ gst_bus_new (void)
   return result;
 }
 
+static inline gboolean
+gst_bus_message_type_matches (GstMessage * message, GstMessageType types)
+{
+  if ((GST_MESSAGE_TYPE (message) & types) == 0)
+    return FALSE;
+
+  /* Extra check to ensure extended types don't get matched unless
+   * asked for */
+  return !GST_MESSAGE_TYPE_IS_EXTENDED (message)
+      || (types & GST_MESSAGE_EXTENDED);
+}
+
+static guint
+coalesced_message_hash (gconstpointer key)
+{
+  const CoalescedMessage *c = key;
+
+  return g_direct_hash (c->src) ^ (c->type * 31) ^ c->name;
+}
+
+static gboolean
+coalesced_message_equal (gconstpointer a, gconstpointer b)
+{
+  const CoalescedMessage *ca = a, *cb = b;
+
+  return ca->type == cb->type && ca->src == cb->src && ca->name == cb->name;
+}
+
+static void
+coalesced_message_free (CoalescedMessage * c)
+{
+  if (c->latest != c->queued)
+    gst_message_unref (c->latest);
+  g_slice_free (CoalescedMessage, c);
+}
+
+static void
+coalesced_message_init (CoalescedMessage * c, GstMessage * message)
+{
+  const GstStructure *s = gst_message_get_structure (message);
+
+  c->type = GST_MESSAGE_TYPE (message);
+  c->src = GST_MESSAGE_SRC (message);
+  c->name = s ? gst_structure_get_name_id (s) : 0;
+  c->queued = c->latest = message;
+}
+
+/* Returns TRUE if @message replaced an older message that is still queued,
+ * and must not be queued itself. Takes ownership of @message then. */
+static gboolean
+gst_bus_coalesce_message (GstBus * bus, GstMessage * message)
+{
+  GstBusPrivate *priv = bus->priv;
+  CoalescedMessage key, *c;
+  gboolean ret = FALSE;
+
+  if (g_atomic_int_get ((gint *) & priv->coalesce_types) == 0)
+    return FALSE;
+
+  g_mutex_lock (&priv->coalesce_lock);
+  if (!gst_bus_message_type_matches (message, priv->coalesce_types))
+    goto done;
+
+  coalesced_message_init (&key, message);
+  c = g_hash_table_lookup (priv->coalesced, &key);
+  if (c) {
+    if (c->latest != c->queued)
+      gst_message_unref (c->latest);
+    c->latest = message;
+    ret = TRUE;
+  } else {
+    c = g_slice_new (CoalescedMessage);
+    *c = key;
+    g_hash_table_insert (priv->coalesced, c, c);
+    g_atomic_int_inc (&priv->n_coalesced);
+  }
+
+done:
+  g_mutex_unlock (&priv->coalesce_lock);
+
+  return ret;
+}
+
+/* Returns the message to deliver for @message that was taken from the queue,
+ * which is the newest one that replaced it. With @remove, the message is
+ * forgotten about and ownership of @message is transferred. */
+static GstMessage *
+gst_bus_uncoalesce_message (GstBus * bus, GstMessage * message,
+    gboolean remove)
+{
+  GstBusPrivate *priv = bus->priv;
+  CoalescedMessage key, *c;
+
+  if (g_atomic_int_get (&priv->n_coalesced) == 0)
+    return message;
+
+  g_mutex_lock (&priv->coalesce_lock);
+  coalesced_message_init (&key, message);
+  c = g_hash_table_lookup (priv->coalesced, &key);
+  if (c && c->queued == message) {
+    message = c->latest;
+    if (remove) {
+      if (c->latest != c->queued)
+        gst_message_unref (c->queued);
+      g_hash_table_steal (priv->coalesced, c);
+      g_slice_free (CoalescedMessage, c);
+      g_atomic_int_add (&priv->n_coalesced, -1);
+    }
+  }
+  g_mutex_unlock (&priv->coalesce_lock);
+
+  return message;
+}
+
 /**
  * gst_bus_post:
  * @bus: a #GstBus to post on
@@ -331,6 +480,7 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   GstBusSyncReply reply = GST_BUS_PASS;
   gboolean emit_sync_message;
   SyncHandler *sync_handler = NULL;
+  GstMessageType async_types;
 
   g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
   g_return_val_if_fail (GST_IS_MESSAGE (message), FALSE);
@@ -350,6 +500,7 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   if (bus->priv->sync_handler)
     sync_handler = sync_handler_ref (bus->priv->sync_handler);
   emit_sync_message = bus->priv->num_sync_message_emitters > 0;
+  async_types = bus->priv->async_types;
   GST_OBJECT_UNLOCK (bus);
 
   /* first call the sync handler if it is installed */
@@ -370,6 +521,11 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   if (!bus->priv->poll)
     reply = GST_BUS_DROP;
 
+  /* don't wake up anyone for messages nobody is interested in */
+  if (reply == GST_BUS_PASS && !gst_bus_message_type_matches (message,
+          async_types))
+    reply = GST_BUS_DROP;
+
   /* now see what we should do with the message */
   switch (reply) {
     case GST_BUS_DROP:
@@ -377,6 +533,11 @@ gst_bus_post (GstBus * bus, GstMessage * message)
       GST_DEBUG_OBJECT (bus, "[msg %p] dropped", message);
       break;
     case GST_BUS_PASS:
+      if (gst_bus_coalesce_message (bus, message)) {
+        GST_DEBUG_OBJECT (bus, "[msg %p] replaces a queued message", message);
+        break;
+      }
+
       /* pass the message to the async queue, refcount passed in the queue */
       GST_DEBUG_OBJECT (bus, "[msg %p] pushing on async queue", message);
       gst_atomic_queue_push (bus->priv->queue, message);
@@ -498,6 +659,111 @@ gst_bus_set_flushing (GstBus * bus, gboolean flushing)
   g_list_free_full (message_list, (GDestroyNotify) gst_message_unref);
 }
 
+/**
+ * gst_bus_set_async_message_types:
+ * @bus: a #GstBus
+ * @types: message types to queue, %GST_MESSAGE_ANY for any type
+ *
+ * Sets the types of messages that are queued on @bus for asynchronous
+ * delivery to bus watches and gst_bus_pop() and related functions. Other
+ * messages are dropped after the sync handler and the #GstBus::sync-message
+ * signal have seen them, without waking up the main loop.
+ *
+ * This is useful to not be woken up for chatty messages that are of no
+ * interest, such as the element messages from level or spectrum.
+ *
+ * Since: 1.20
+ */
+void
+gst_bus_set_async_message_types (GstBus * bus, GstMessageType types)
+{
+  g_return_if_fail (GST_IS_BUS (bus));
+
+  GST_OBJECT_LOCK (bus);
+  bus->priv->async_types = types;
+  GST_OBJECT_UNLOCK (bus);
+}
+
+/**
+ * gst_bus_set_coalesce_message_types:
+ * @bus: a #GstBus
+ * @types: message types to coalesce, 0 for none
+ *
+ * Sets the types of messages that are coalesced on @bus. Of the messages of
+ * these types that have the same source and, if they have a structure, the
+ * same structure name, only the newest one is kept as long as none has been
+ * popped yet. The newest message takes the place of the oldest one in the
+ * queue, and does not wake up the main loop.
+ *
+ * This bounds the memory and work for messages that are posted at high
+ * rates when only the latest one is of interest, such as
+ * %GST_MESSAGE_BUFFERING, %GST_MESSAGE_QOS or %GST_MESSAGE_DURATION_CHANGED.
+ * The sync handler and the #GstBus::sync-message signal still see all
+ * messages.
+ *
+ * By default no messages are coalesced.
+ *
+ * Since: 1.20
+ */
+void
+gst_bus_set_coalesce_message_types (GstBus * bus, GstMessageType types)
+{
+  g_return_if_fail (GST_IS_BUS (bus));
+
+  g_mutex_lock (&bus->priv->coalesce_lock);
+  if (types != 0 && bus->priv->coalesced == NULL)
+    bus->priv->coalesced = g_hash_table_new_full (coalesced_message_hash,
+        coalesced_message_equal, (GDestroyNotify) coalesced_message_free,
+        NULL);
+  g_atomic_int_set ((gint *) & bus->priv->coalesce_types, types);
+  g_mutex_unlock (&bus->priv->coalesce_lock);
+}
+
+/**
+ * gst_bus_get_coalesce_message_types:
+ * @bus: a #GstBus
+ *
+ * Gets the types of messages that are coalesced on @bus, see
+ * gst_bus_set_coalesce_message_types().
+ *
+ * Returns: the message types that are coalesced
+ *
+ * Since: 1.20
+ */
+GstMessageType
+gst_bus_get_coalesce_message_types (GstBus * bus)
+{
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+
+  return (GstMessageType) g_atomic_int_get ((gint *) &
+      bus->priv->coalesce_types);
+}
+
+/**
+ * gst_bus_get_async_message_types:
+ * @bus: a #GstBus
+ *
+ * Gets the types of messages that are queued on @bus for asynchronous
+ * delivery, see gst_bus_set_async_message_types().
+ *
+ * Returns: the message types that are queued
+ *
+ * Since: 1.20
+ */
+GstMessageType
+gst_bus_get_async_message_types (GstBus * bus)
+{
+  GstMessageType types;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+
+  GST_OBJECT_LOCK (bus);
+  types = bus->priv->async_types;
+  GST_OBJECT_UNLOCK (bus);
+
+  return types;
+}
+
 /**
  * gst_bus_timed_pop_filtered:
  * @bus: a #GstBus to pop from
@@ -557,17 +823,14 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
         }
       }
 
+      message = gst_bus_uncoalesce_message (bus, message, TRUE);
+
       GST_DEBUG_OBJECT (bus, "got message %p, %s from %s, type mask is %u",
           message, GST_MESSAGE_TYPE_NAME (message),
           GST_MESSAGE_SRC_NAME (message), (guint) types);
-      if ((GST_MESSAGE_TYPE (message) & types) != 0) {
-        /* Extra check to ensure extended types don't get matched unless
-         * asked for */
-        if ((!GST_MESSAGE_TYPE_IS_EXTENDED (message))
-            || (types & GST_MESSAGE_EXTENDED)) {
-          /* exit the loop, we have a message */
-          goto beach;
-        }
+      if (gst_bus_message_type_matches (message, types)) {
+        /* exit the loop, we have a message */
+        goto beach;
       }
 
       GST_DEBUG_OBJECT (bus, "discarding message, does not match mask");
@@ -699,7 +962,8 @@ gst_bus_peek (GstBus * bus)
   g_mutex_lock (&bus->priv->queue_lock);
   message = gst_atomic_queue_peek (bus->priv->queue);
   if (message)
-    gst_message_ref (message);
+    message = gst_message_ref (gst_bus_uncoalesce_message (bus, message,
+            FALSE));
   g_mutex_unlock (&bus->priv->queue_lock);
 
   GST_DEBUG_OBJECT (bus, "peek on bus, got message %p", message);
@@ -796,8 +1060,9 @@ gst_bus_source_dispatch (GSource * source, GSourceFunc callback,
   GstBusFunc handler = (GstBusFunc) callback;
   GstBusSource *bsource = (GstBusSource *) source;
   GstMessage *message;
-  gboolean keep;
+  gboolean keep = TRUE;
   GstBus *bus;
+  guint i;
 
   g_return_val_if_fail (bsource != NULL, FALSE);
 
@@ -805,23 +1070,31 @@ gst_bus_source_dispatch (GSource * source, GSourceFunc callback,
 
   g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
 
-  message = gst_bus_pop (bus);
+  /* Handle a few messages per wakeup so that the main loop keeps up with
+   * chatty periods, but not too many to not starve other sources. */
+  for (i = 0; i < BUS_WATCH_MAX_DISPATCH && keep; i++) {
+    /* the handler might have removed the watch */
+    if (i > 0 && g_source_is_destroyed (source))
+      break;
 
-  /* The message queue might be empty if some other thread or callback set
-   * the bus to flushing between check/prepare and dispatch */
-  if (G_UNLIKELY (message == NULL))
-    return TRUE;
+    message = gst_bus_pop (bus);
 
-  if (!handler)
-    goto no_handler;
+    /* The message queue might be empty if some other thread or callback set
+     * the bus to flushing between check/prepare and dispatch */
+    if (message == NULL)
+      break;
 
-  GST_DEBUG_OBJECT (bus, "source %p calling dispatch with %" GST_PTR_FORMAT,
-      source, message);
+    if (!handler)
+      goto no_handler;
 
-  keep = handler (bus, message, user_data);
-  gst_message_unref (message);
+    GST_DEBUG_OBJECT (bus, "source %p calling dispatch with %" GST_PTR_FORMAT,
+        source, message);
 
-  GST_DEBUG_OBJECT (bus, "source %p handler returns %d", source, keep);
+    keep = handler (bus, message, user_data);
+    gst_message_unref (message);
+
+    GST_DEBUG_OBJECT (bus, "source %p handler returns %d", source, keep);
+  }
 
   return keep;
 
@@ -185,6 +185,18 @@ GstMessage *            gst_bus_timed_pop_filtered      (GstBus * bus, GstClockT
 GST_API
 void                    gst_bus_set_flushing            (GstBus * bus, gboolean flushing);
 
+GST_API
+void                    gst_bus_set_async_message_types (GstBus * bus, GstMessageType types);
+
+GST_API
+GstMessageType          gst_bus_get_async_message_types (GstBus * bus);
+
+GST_API
+void                    gst_bus_set_coalesce_message_types (GstBus * bus, GstMessageType types);
+
+GST_API
+GstMessageType          gst_bus_get_coalesce_message_types (GstBus * bus);
+
 /* synchronous dispatching */
 
 GST_API
@@ -68,6 +68,7 @@
 
 #define GST_DISABLE_MINIOBJECT_INLINE_FUNCTIONS
 #include "gst_private.h"
+#include "gstbinarycodec.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
 
@@ -104,6 +105,17 @@ typedef struct _GstCapsImpl
 #define CAPS_IS_EMPTY_SIMPLE(caps)					\
   ((GST_CAPS_ARRAY (caps) == NULL) || (GST_CAPS_LEN (caps) == 0))
 
+/* private flag for caps returned by gst_caps_intern() */
+#define CAPS_FLAG_INTERNED (GST_MINI_OBJECT_FLAG_LAST << 15)
+
+#define CAPS_IS_INTERNED(caps) \
+  (!!(GST_CAPS_FLAGS(caps) & CAPS_FLAG_INTERNED))
+
+/* static caps initialized with _priv_gst_static_caps_init(), which are freed
+ * again and must not get immortal caps */
+#define STATIC_CAPS_IS_MORTAL(static_caps) \
+  ((static_caps)->_gst_reserved[0] != NULL)
+
 #define gst_caps_features_copy_conditional(f) ((f && (gst_caps_features_is_any (f) || !gst_caps_features_is_equal (f, GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))) ? gst_caps_features_copy (f) : NULL)
 
 /* quick way to get a caps structure at an index without doing a type or array
@@ -122,6 +134,21 @@ typedef struct _GstCapsImpl
     g_array_append_val (GST_CAPS_ARRAY (caps), __e);                             \
 }G_STMT_END
 
+/* get the structure at @index for modifying it, @caps must be writable.
+ * Structures that are still shared with other caps are copied first */
+static inline GstStructure *
+gst_caps_get_structure_writable_unchecked (GstCaps * caps, guint index)
+{
+  GstCapsArrayElement *e =
+      &g_array_index (GST_CAPS_ARRAY (caps), GstCapsArrayElement, index);
+
+  if (G_UNLIKELY (priv_gst_structure_is_shared (e->structure)))
+    e->structure = priv_gst_structure_make_exclusive (e->structure,
+        &GST_CAPS_REFCOUNT (caps));
+
+  return e->structure;
+}
+
 /* lock to protect multiple invocations of static caps to caps conversion */
 G_LOCK_DEFINE_STATIC (static_caps_lock);
 
@@ -136,9 +163,349 @@ GstCaps *_gst_caps_none;
 
 GST_DEFINE_MINI_OBJECT_TYPE (GstCaps, gst_caps);
 
+/* Cache for the results of intersections and subset checks. Only caps that
+ * are not writable are considered, and the cache keeps a reference to them
+ * so that they can't be modified or freed and their address stays a valid
+ * key for as long as the entry exists. */
+typedef enum
+{
+  CAPS_CACHE_OP_INTERSECT_ZIG_ZAG = GST_CAPS_INTERSECT_ZIG_ZAG,
+  CAPS_CACHE_OP_INTERSECT_FIRST = GST_CAPS_INTERSECT_FIRST,
+  CAPS_CACHE_OP_IS_SUBSET
+} CapsCacheOp;
+
+typedef struct
+{
+  GstCaps *caps1;
+  GstCaps *caps2;
+  CapsCacheOp op;
+
+  /* the intersection, or NULL for subset checks */
+  GstCaps *result;
+  gboolean res;
+} CapsCacheEntry;
+
+static GMutex caps_cache_lock;
+static gint caps_cache_max_entries = 0;
+/* CapsCacheEntry -> GList link in caps_cache_lru */
+static GHashTable *caps_cache = NULL;
+/* most recently used entries first */
+static GQueue caps_cache_lru = G_QUEUE_INIT;
+static guint64 caps_cache_hits = 0;
+static guint64 caps_cache_misses = 0;
+
+#define CAPS_CACHE_USABLE(caps1,caps2) \
+  (g_atomic_int_get (&caps_cache_max_entries) > 0 && \
+   !IS_WRITABLE (caps1) && !IS_WRITABLE (caps2))
+
+static guint
+caps_cache_entry_hash (gconstpointer key)
+{
+  const CapsCacheEntry *entry = key;
+
+  return g_direct_hash (entry->caps1) ^ (g_direct_hash (entry->caps2) * 31) ^
+      entry->op;
+}
+
+static gboolean
+caps_cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+  const CapsCacheEntry *entry1 = a, *entry2 = b;
+
+  return entry1->caps1 == entry2->caps1 && entry1->caps2 == entry2->caps2 &&
+      entry1->op == entry2->op;
+}
+
+static void
+caps_cache_entry_free (CapsCacheEntry * entry)
+{
+  gst_caps_unref (entry->caps1);
+  gst_caps_unref (entry->caps2);
+  if (entry->result)
+    gst_caps_unref (entry->result);
+  g_slice_free (CapsCacheEntry, entry);
+}
+
+/* Removes the least recently used entries until there are at most
+ * @max_entries left and returns them. Must be called with the lock. */
+static GList *
+caps_cache_trim (guint max_entries)
+{
+  GList *removed = NULL;
+
+  while (caps_cache_lru.length > max_entries) {
+    CapsCacheEntry *entry = g_queue_pop_tail (&caps_cache_lru);
+
+    g_hash_table_remove (caps_cache, entry);
+    removed = g_list_prepend (removed, entry);
+  }
+
+  return removed;
+}
+
+static gboolean
+caps_cache_lookup (const GstCaps * caps1, const GstCaps * caps2,
+    CapsCacheOp op, GstCaps ** result, gboolean * res)
+{
+  CapsCacheEntry key = { (GstCaps *) caps1, (GstCaps *) caps2, op, };
+  GList *link = NULL;
+
+  g_mutex_lock (&caps_cache_lock);
+  if (caps_cache)
+    link = g_hash_table_lookup (caps_cache, &key);
+
+  if (link) {
+    CapsCacheEntry *entry = link->data;
+
+    g_queue_unlink (&caps_cache_lru, link);
+    g_queue_push_head_link (&caps_cache_lru, link);
+
+    if (result)
+      *result = gst_caps_ref (entry->result);
+    if (res)
+      *res = entry->res;
+    caps_cache_hits++;
+  } else {
+    caps_cache_misses++;
+  }
+  g_mutex_unlock (&caps_cache_lock);
+
+  return link != NULL;
+}
+
+static void
+caps_cache_insert (const GstCaps * caps1, const GstCaps * caps2,
+    CapsCacheOp op, GstCaps * result, gboolean res)
+{
+  CapsCacheEntry *entry;
+  GList *removed = NULL;
+
+  entry = g_slice_new (CapsCacheEntry);
+  entry->caps1 = gst_caps_ref ((GstCaps *) caps1);
+  entry->caps2 = gst_caps_ref ((GstCaps *) caps2);
+  entry->op = op;
+  entry->result = result ? gst_caps_ref (result) : NULL;
+  entry->res = res;
+
+  g_mutex_lock (&caps_cache_lock);
+  if (caps_cache_max_entries > 0 && !g_hash_table_contains (caps_cache, entry)) {
+    g_queue_push_head (&caps_cache_lru, entry);
+    g_hash_table_insert (caps_cache, entry, caps_cache_lru.head);
+    removed = caps_cache_trim (caps_cache_max_entries);
+  } else {
+    /* disabled or another thread was faster */
+    removed = g_list_prepend (removed, entry);
+  }
+  g_mutex_unlock (&caps_cache_lock);
+
+  g_list_free_full (removed, (GDestroyNotify) caps_cache_entry_free);
+}
+
+/**
+ * gst_caps_cache_set_max_entries:
+ * @max_entries: maximum number of cached results, or 0 to disable the cache
+ *
+ * Configures the cache for the results of gst_caps_intersect_full() and
+ * gst_caps_is_subset(). Results are only cached for caps that are not
+ * writable, and the least recently used results are dropped when the cache
+ * is full. Setting @max_entries to 0 disables the cache and drops all
+ * cached results. By default the cache is disabled unless the
+ * `GST_CAPS_CACHE_SIZE` environment variable is set.
+ *
+ * The cache keeps a reference to the caps it stores results for, which
+ * means that those caps stay non-writable while they are in the cache and
+ * intersections might return a reference to a previous result.
+ *
+ * Since: 1.20
+ */
+void
+gst_caps_cache_set_max_entries (guint max_entries)
+{
+  GList *removed;
+
+  max_entries = MIN (max_entries, G_MAXINT);
+
+  g_mutex_lock (&caps_cache_lock);
+  if (max_entries > 0 && caps_cache == NULL)
+    caps_cache = g_hash_table_new (caps_cache_entry_hash,
+        caps_cache_entry_equal);
+  g_atomic_int_set (&caps_cache_max_entries, max_entries);
+  removed = caps_cache_trim (max_entries);
+  if (max_entries == 0 && caps_cache) {
+    GST_CAT_INFO (GST_CAT_CAPS, "caps cache disabled, %" G_GUINT64_FORMAT
+        " hits, %" G_GUINT64_FORMAT " misses", caps_cache_hits,
+        caps_cache_misses);
+    g_hash_table_unref (caps_cache);
+    caps_cache = NULL;
+  }
+  g_mutex_unlock (&caps_cache_lock);
+
+  g_list_free_full (removed, (GDestroyNotify) caps_cache_entry_free);
+}
+
+/**
+ * gst_caps_cache_get_stats:
+ * @hits: (out) (optional): the number of results that were found in the cache
+ * @misses: (out) (optional): the number of results that had to be computed
+ *
+ * Gets the statistics of the caps cache, see
+ * gst_caps_cache_set_max_entries(). Only operations on caps that could be
+ * cached are counted.
+ *
+ * Since: 1.20
+ */
+void
+gst_caps_cache_get_stats (guint64 * hits, guint64 * misses)
+{
+  g_mutex_lock (&caps_cache_lock);
+  if (hits)
+    *hits = caps_cache_hits;
+  if (misses)
+    *misses = caps_cache_misses;
+  g_mutex_unlock (&caps_cache_lock);
+}
+
+/* Table of interned fixed caps. Interning keys on strict equality, so the
+ * hash may only depend on what is the same for strictly equal fixed caps:
+ * the names, features, field names and types and the values of the types
+ * that compare by value. */
+static GMutex intern_lock;
+static GHashTable *intern_table = NULL;
+
+static gboolean
+intern_hash_field (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  guint *hash = user_data;
+  GType type = G_VALUE_TYPE (value);
+  guint h = field_id * 0x9E3779B1u ^ g_direct_hash (GSIZE_TO_POINTER (type));
+
+  if (type == G_TYPE_INT) {
+    h ^= g_value_get_int (value);
+  } else if (type == G_TYPE_UINT) {
+    h ^= g_value_get_uint (value);
+  } else if (type == G_TYPE_BOOLEAN) {
+    h ^= g_value_get_boolean (value);
+  } else if (type == G_TYPE_STRING) {
+    const gchar *s = g_value_get_string (value);
+
+    if (s)
+      h ^= g_str_hash (s);
+  } else if (type == GST_TYPE_FRACTION) {
+    gint num = gst_value_get_fraction_numerator (value);
+    gint denom = gst_value_get_fraction_denominator (value);
+    gint gcd = gst_util_greatest_common_divisor (num, denom);
+
+    /* equal fractions don't need to be reduced */
+    if (gcd != 0) {
+      num /= gcd;
+      denom /= gcd;
+    }
+    h ^= g_int_hash (&num) * 31 + denom;
+  }
+
+  /* the fields can be in any order */
+  *hash += h;
+
+  return TRUE;
+}
+
+static guint
+intern_hash (gconstpointer key)
+{
+  const GstCaps *caps = key;
+  GstStructure *s = gst_caps_get_structure_unchecked (caps, 0);
+  GstCapsFeatures *f = gst_caps_get_features_unchecked (caps, 0);
+  guint i, n, hash;
+
+  hash = gst_structure_get_name_id (s);
+  if (f) {
+    n = gst_caps_features_get_size (f);
+    for (i = 0; i < n; i++)
+      hash += gst_caps_features_get_nth_id (f, i) * 31;
+  }
+  gst_structure_foreach (s, intern_hash_field, &hash);
+
+  return hash;
+}
+
+static gboolean
+intern_equal (gconstpointer a, gconstpointer b)
+{
+  return gst_caps_is_strictly_equal (a, b);
+}
+
+/**
+ * gst_caps_intern:
+ * @caps: (transfer full): a #GstCaps
+ *
+ * Returns the canonical instance of @caps. All fixed caps that are strictly
+ * equal are interned as the same #GstCaps, so that comparing interned caps
+ * only needs a pointer comparison, and identical CAPS events do not need to
+ * be sent again. Caps that are not fixed are returned unchanged.
+ *
+ * Interned caps are never writable and stay alive until gst_deinit().
+ *
+ * Returns: (transfer full): the interned caps.
+ *
+ * Since: 1.20
+ */
+GstCaps *
+gst_caps_intern (GstCaps * caps)
+{
+  GstCaps *interned;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  if (CAPS_IS_INTERNED (caps) || !gst_caps_is_fixed (caps))
+    return caps;
+
+  g_mutex_lock (&intern_lock);
+  if (G_UNLIKELY (intern_table == NULL))
+    intern_table = g_hash_table_new_full (intern_hash, intern_equal,
+        (GDestroyNotify) gst_mini_object_unref, NULL);
+
+  interned = g_hash_table_lookup (intern_table, caps);
+  if (interned == NULL) {
+    /* the flag can't be set on caps that others might look at, the table
+     * takes over the reference */
+    interned = gst_caps_make_writable (caps);
+    caps = NULL;
+    GST_CAPS_FLAG_SET (interned, CAPS_FLAG_INTERNED);
+    g_hash_table_add (intern_table, interned);
+    GST_CAT_DEBUG (GST_CAT_CAPS, "interned %" GST_PTR_FORMAT, interned);
+  }
+  gst_caps_ref (interned);
+  g_mutex_unlock (&intern_lock);
+
+  if (caps)
+    gst_caps_unref (caps);
+
+  return interned;
+}
+
+/**
+ * gst_caps_is_interned:
+ * @caps: a #GstCaps
+ *
+ * Checks if @caps is the canonical instance returned by gst_caps_intern().
+ *
+ * Returns: %TRUE if @caps is interned
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_caps_is_interned (const GstCaps * caps)
+{
+  g_return_val_if_fail (GST_IS_CAPS (caps), FALSE);
+
+  return CAPS_IS_INTERNED (caps);
+}
+
 void
 _priv_gst_caps_initialize (void)
 {
+  const gchar *env;
+
   _gst_caps_type = gst_caps_get_type ();
 
   _gst_caps_any = gst_caps_new_any ();
@@ -146,11 +513,23 @@ _priv_gst_caps_initialize (void)
 
   g_value_register_transform_func (_gst_caps_type,
       G_TYPE_STRING, gst_caps_transform_to_string);
+
+  env = g_getenv ("GST_CAPS_CACHE_SIZE");
+  if (env)
+    gst_caps_cache_set_max_entries (g_ascii_strtoull (env, NULL, 10));
 }
 
 void
 _priv_gst_caps_cleanup (void)
 {
+  gst_caps_cache_set_max_entries (0);
+
+  g_mutex_lock (&intern_lock);
+  if (intern_table) {
+    g_hash_table_unref (intern_table);
+    intern_table = NULL;
+  }
+  g_mutex_unlock (&intern_lock);
   gst_caps_unref (_gst_caps_any);
   _gst_caps_any = NULL;
   gst_caps_unref (_gst_caps_none);
@@ -170,20 +549,39 @@ _gst_caps_copy (const GstCaps * caps)
   GstStructure *structure;
   GstCapsFeatures *features;
   guint i, n;
+  gboolean share;
 
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps);
+  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps) &
+      ~(CAPS_FLAG_INTERNED | GST_MINI_OBJECT_FLAG_IMMORTAL);
   n = GST_CAPS_LEN (caps);
 
   GST_CAT_DEBUG (GST_CAT_PERFORMANCE, "doing copy %p -> %p", caps, newcaps);
 
+  /* nobody can modify the structures of caps that are not writable, so the
+   * copy can share them. They are only copied when one of the owners
+   * modifies them later. The structures of writable caps are copied right
+   * away as the owner might still be modifying them. */
+  share = !IS_WRITABLE (caps);
+
   for (i = 0; i < n; i++) {
     structure = gst_caps_get_structure_unchecked (caps, i);
     features = gst_caps_get_features_unchecked (caps, i);
-    gst_caps_append_structure_full (newcaps, gst_structure_copy (structure),
-        gst_caps_features_copy_conditional (features));
+    if (share) {
+      GstCapsArrayElement e = { priv_gst_structure_share (structure),
+        gst_caps_features_copy_conditional (features)
+      };
+
+      if (e.features)
+        gst_caps_features_set_parent_refcount (e.features,
+            &GST_CAPS_REFCOUNT (newcaps));
+      g_array_append_val (GST_CAPS_ARRAY (newcaps), e);
+    } else {
+      gst_caps_append_structure_full (newcaps, gst_structure_copy (structure),
+          gst_caps_features_copy_conditional (features));
+    }
   }
 
   return newcaps;
@@ -204,8 +602,7 @@ _gst_caps_free (GstCaps * caps)
   /*GST_CAT_INFO (GST_CAT_CAPS, "caps size: %d", len); */
   for (i = 0; i < len; i++) {
     structure = gst_caps_get_structure_unchecked (caps, i);
-    gst_structure_set_parent_refcount (structure, NULL);
-    gst_structure_free (structure);
+    priv_gst_structure_release (structure);
     features = gst_caps_get_features_unchecked (caps, i);
     if (features) {
       gst_caps_features_set_parent_refcount (features, NULL);
@@ -392,6 +789,17 @@ gst_caps_new_full_valist (GstStructure * structure, va_list var_args)
 
 G_DEFINE_POINTER_TYPE (GstStaticCaps, gst_static_caps);
 
+/* Initializes static caps that are allocated at runtime, like the ones of
+ * the pad templates of element factories. Their caps are freed by
+ * gst_static_caps_cleanup() instead of being made immortal */
+void
+_priv_gst_static_caps_init (GstStaticCaps * static_caps, const gchar * string)
+{
+  memset (static_caps, 0, sizeof (GstStaticCaps));
+  static_caps->string = string;
+  static_caps->_gst_reserved[0] = GINT_TO_POINTER (TRUE);
+}
+
 /**
  * gst_static_caps_get:
  * @static_caps: the #GstStaticCaps to convert
@@ -405,7 +813,7 @@ G_DEFINE_POINTER_TYPE (GstStaticCaps, gst_static_caps);
 GstCaps *
 gst_static_caps_get (GstStaticCaps * static_caps)
 {
-  GstCaps **caps;
+  GstCaps **caps, *new_caps;
 
   g_return_val_if_fail (static_caps != NULL, NULL);
 
@@ -425,16 +833,20 @@ gst_static_caps_get (GstStaticCaps * static_caps)
     if (G_UNLIKELY (string == NULL))
       goto no_string;
 
-    *caps = gst_caps_from_string (string);
+    new_caps = gst_caps_from_string (string);
 
     /* convert to string */
-    if (G_UNLIKELY (*caps == NULL)) {
+    if (G_UNLIKELY (new_caps == NULL)) {
       g_critical ("Could not convert static caps \"%s\"", string);
       goto done;
     }
 
-    /* Caps generated from static caps are usually leaked */
-    GST_MINI_OBJECT_FLAG_SET (*caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+    /* Caps generated from static caps in static storage are leaked, and
+     * shared by all users of the static caps. Don't refcount them so that
+     * threads using the same template caps don't contend on the refcount */
+    if (!STATIC_CAPS_IS_MORTAL (static_caps))
+      gst_mini_object_make_immortal (GST_MINI_OBJECT_CAST (new_caps));
+    g_atomic_pointer_set (caps, new_caps);
 
     GST_CAT_TRACE (GST_CAT_CAPS, "created %p from string %s", static_caps,
         string);
@@ -466,6 +878,7 @@ void
 gst_static_caps_cleanup (GstStaticCaps * static_caps)
 {
   G_LOCK (static_caps_lock);
+  /* immortal caps are only forgotten, others might still be using them */
   gst_caps_replace (&static_caps->caps, NULL);
   G_UNLOCK (static_caps_lock);
 }
@@ -485,7 +898,7 @@ gst_caps_remove_and_get_structure_and_features (GstCaps * caps, guint idx,
   /* don't use index_fast, gst_caps_simplify relies on the order */
   g_array_remove_index (GST_CAPS_ARRAY (caps), idx);
 
-  gst_structure_set_parent_refcount (s_, NULL);
+  s_ = priv_gst_structure_make_exclusive (s_, NULL);
   if (f_) {
     gst_caps_features_set_parent_refcount (f_, NULL);
   }
@@ -876,6 +1289,10 @@ gst_caps_get_structure (const GstCaps * caps, guint index)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
   g_return_val_if_fail (index < GST_CAPS_LEN (caps), NULL);
 
+  /* the caller may modify the structures of writable caps */
+  if (IS_WRITABLE (caps))
+    return gst_caps_get_structure_writable_unchecked ((GstCaps *) caps, index);
+
   return gst_caps_get_structure_unchecked (caps, index);
 }
 
@@ -1028,7 +1445,8 @@ gst_caps_copy_nth (const GstCaps * caps, guint nth)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps);
+  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps) &
+      ~(CAPS_FLAG_INTERNED | GST_MINI_OBJECT_FLAG_IMMORTAL);
 
   if (G_LIKELY (GST_CAPS_LEN (caps) > nth)) {
     structure = gst_caps_get_structure_unchecked (caps, nth);
@@ -1104,7 +1522,8 @@ gst_caps_set_value (GstCaps * caps, const char *field, const GValue * value)
 
   len = GST_CAPS_LEN (caps);
   for (i = 0; i < len; i++) {
-    GstStructure *structure = gst_caps_get_structure_unchecked (caps, i);
+    GstStructure *structure =
+        gst_caps_get_structure_writable_unchecked (caps, i);
     gst_structure_set_value (structure, field, value);
   }
 }
@@ -1266,6 +1685,10 @@ gst_caps_is_equal_fixed (const GstCaps * caps1, const GstCaps * caps2)
   g_return_val_if_fail (gst_caps_is_fixed (caps1), FALSE);
   g_return_val_if_fail (gst_caps_is_fixed (caps2), FALSE);
 
+  /* fixed caps are only equal if they are strictly equal */
+  if (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2))
+    return caps1 == caps2;
+
   struct1 = gst_caps_get_structure_unchecked (caps1, 0);
   features1 = gst_caps_get_features_unchecked (caps1, 0);
   if (!features1)
@@ -1313,6 +1736,7 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
 {
   GstStructure *s1, *s2;
   GstCapsFeatures *f1, *f2;
+  gboolean cacheable;
   gboolean ret = TRUE;
   gint i, j;
 
@@ -1324,6 +1748,11 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
   if (CAPS_IS_ANY (subset) || CAPS_IS_EMPTY (superset))
     return FALSE;
 
+  cacheable = CAPS_CACHE_USABLE (subset, superset);
+  if (cacheable && caps_cache_lookup (subset, superset,
+          CAPS_CACHE_OP_IS_SUBSET, NULL, &ret))
+    return ret;
+
   for (i = GST_CAPS_LEN (subset) - 1; i >= 0; i--) {
     s1 = gst_caps_get_structure_unchecked (subset, i);
     f1 = gst_caps_get_features_unchecked (subset, i);
@@ -1352,6 +1781,9 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
     }
   }
 
+  if (cacheable)
+    caps_cache_insert (subset, superset, CAPS_CACHE_OP_IS_SUBSET, NULL, ret);
+
   return ret;
 }
 
@@ -1485,6 +1917,10 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == caps2))
     return TRUE;
 
+  /* there is only one interned instance of strictly equal caps */
+  if (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2))
+    return FALSE;
+
   /* if both are ANY caps, consider them strictly equal */
   if (CAPS_IS_ANY (caps1))
     return (CAPS_IS_ANY (caps2));
@@ -1745,6 +2181,9 @@ GstCaps *
 gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
     GstCapsIntersectMode mode)
 {
+  GstCaps *dest;
+  gboolean cacheable;
+
   g_return_val_if_fail (GST_IS_CAPS (caps1), NULL);
   g_return_val_if_fail (GST_IS_CAPS (caps2), NULL);
 
@@ -1764,15 +2203,25 @@ gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
   if (G_UNLIKELY (CAPS_IS_ANY (caps2)))
     return gst_caps_ref (caps1);
 
-  switch (mode) {
-    case GST_CAPS_INTERSECT_FIRST:
-      return gst_caps_intersect_first (caps1, caps2);
-    default:
-      g_warning ("Unknown caps intersect mode: %d", mode);
-      /* fallthrough */
-    case GST_CAPS_INTERSECT_ZIG_ZAG:
-      return gst_caps_intersect_zig_zag (caps1, caps2);
+  if (mode != GST_CAPS_INTERSECT_FIRST && mode != GST_CAPS_INTERSECT_ZIG_ZAG) {
+    g_warning ("Unknown caps intersect mode: %d", mode);
+    mode = GST_CAPS_INTERSECT_ZIG_ZAG;
   }
+
+  cacheable = CAPS_CACHE_USABLE (caps1, caps2);
+  if (cacheable && caps_cache_lookup (caps1, caps2, (CapsCacheOp) mode, &dest,
+          NULL))
+    return dest;
+
+  if (mode == GST_CAPS_INTERSECT_FIRST)
+    dest = gst_caps_intersect_first (caps1, caps2);
+  else
+    dest = gst_caps_intersect_zig_zag (caps1, caps2);
+
+  if (cacheable)
+    caps_cache_insert (caps1, caps2, (CapsCacheOp) mode, dest, TRUE);
+
+  return dest;
 }
 
 /**
@@ -2014,7 +2463,7 @@ gst_caps_normalize (GstCaps * caps)
   nf.caps = caps;
 
   for (i = 0; i < gst_caps_get_size (nf.caps); i++) {
-    nf.structure = gst_caps_get_structure_unchecked (nf.caps, i);
+    nf.structure = gst_caps_get_structure_writable_unchecked (nf.caps, i);
     nf.features = gst_caps_get_features_unchecked (nf.caps, i);
     while (!gst_structure_foreach (nf.structure,
             gst_caps_normalize_foreach, &nf));
@@ -2140,8 +2589,7 @@ static void
 gst_caps_switch_structures (GstCaps * caps, GstStructure * old,
     GstStructure * new, gint i)
 {
-  gst_structure_set_parent_refcount (old, NULL);
-  gst_structure_free (old);
+  priv_gst_structure_release (old);
   gst_structure_set_parent_refcount (new, &GST_CAPS_REFCOUNT (caps));
   g_array_index (GST_CAPS_ARRAY (caps), GstCapsArrayElement, i).structure = new;
 }
@@ -2201,7 +2649,8 @@ gst_caps_simplify (GstCaps * caps)
     for (j = start; j >= 0; j--) {
       if (j == i)
         continue;
-      compare = gst_caps_get_structure_unchecked (caps, j);
+      /* compare might get modified below */
+      compare = gst_caps_get_structure_writable_unchecked (caps, j);
       compare_f = gst_caps_get_features_unchecked (caps, j);
       if (!compare_f)
         compare_f = GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY;
@@ -2526,6 +2975,54 @@ gst_caps_from_string (const gchar * string)
   }
 }
 
+/**
+ * gst_caps_to_binary:
+ * @caps: a #GstCaps
+ *
+ * Serializes @caps into a compact binary representation that can be
+ * turned back into equal caps with gst_caps_from_binary(). See
+ * gst_structure_to_binary() for details.
+ *
+ * Returns: (transfer full) (nullable): the serialized @caps, or %NULL if
+ *     one of the field values could not be serialized.
+ *
+ * Since: 1.20
+ */
+GBytes *
+gst_caps_to_binary (const GstCaps * caps)
+{
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  return _priv_gst_binary_serialize_caps (caps);
+}
+
+/**
+ * gst_caps_from_binary:
+ * @data: (array length=size): data created with gst_caps_to_binary()
+ * @size: the size of @data
+ * @consumed: (out) (optional): the number of bytes of @data that were used
+ *
+ * Converts caps from their binary representation created with
+ * gst_caps_to_binary().
+ *
+ * Returns: (transfer full) (nullable): a newly allocated #GstCaps or %NULL
+ *     when @data could not be parsed.
+ *
+ * Since: 1.20
+ */
+GstCaps *
+gst_caps_from_binary (const guint8 * data, gsize size, gsize * consumed)
+{
+  GstCaps *caps = NULL;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  if (!_priv_gst_binary_deserialize_caps (data, size, consumed, &caps))
+    return NULL;
+
+  return caps;
+}
+
 static void
 gst_caps_transform_to_string (const GValue * src_value, GValue * dest_value)
 {
@@ -2611,7 +3108,7 @@ gst_caps_map_in_place (GstCaps * caps, GstCapsMapFunc func, gpointer user_data)
 
   for (i = 0; i < n; i++) {
     features = gst_caps_get_features_unchecked (caps, i);
-    structure = gst_caps_get_structure_unchecked (caps, i);
+    structure = gst_caps_get_structure_writable_unchecked (caps, i);
 
     /* Provide sysmem features if there are none yet */
     if (!features) {
@@ -2660,7 +3157,7 @@ gst_caps_filter_and_map_in_place (GstCaps * caps, GstCapsFilterMapFunc func,
 
   for (i = 0; i < n;) {
     features = gst_caps_get_features_unchecked (caps, i);
-    structure = gst_caps_get_structure_unchecked (caps, i);
+    structure = gst_caps_get_structure_writable_unchecked (caps, i);
 
     /* Provide sysmem features if there are none yet */
     if (!features) {
@@ -2673,8 +3170,7 @@ gst_caps_filter_and_map_in_place (GstCaps * caps, GstCapsFilterMapFunc func,
     if (!ret) {
       GST_CAPS_ARRAY (caps) = g_array_remove_index (GST_CAPS_ARRAY (caps), i);
 
-      gst_structure_set_parent_refcount (structure, NULL);
-      gst_structure_free (structure);
+      priv_gst_structure_release (structure);
       if (features) {
         gst_caps_features_set_parent_refcount (features, NULL);
         gst_caps_features_free (features);
@@ -526,6 +526,21 @@ GstCaps *         gst_caps_simplify                (GstCaps *caps) G_GNUC_WARN_U
 GST_API
 GstCaps *         gst_caps_fixate                  (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
 
+GST_API
+GstCaps *         gst_caps_intern                  (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
+
+GST_API
+gboolean          gst_caps_is_interned             (const GstCaps *caps);
+
+/* cache */
+
+GST_API
+void              gst_caps_cache_set_max_entries   (guint max_entries);
+
+GST_API
+void              gst_caps_cache_get_stats         (guint64 *hits,
+                                                    guint64 *misses);
+
 /* utility */
 
 GST_API
@@ -536,6 +551,14 @@ gchar *           gst_caps_serialize               (const GstCaps *caps, GstSeri
 GST_API
 GstCaps *         gst_caps_from_string             (const gchar   *string) G_GNUC_WARN_UNUSED_RESULT;
 
+GST_API
+GBytes *          gst_caps_to_binary               (const GstCaps *caps);
+
+GST_API
+GstCaps *         gst_caps_from_binary             (const guint8  *data,
+                                                    gsize          size,
+                                                    gsize         *consumed) G_GNUC_WARN_UNUSED_RESULT;
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstCaps, gst_caps_unref)
 
 G_END_DECLS
@@ -64,8 +64,28 @@ struct _GstCapsFeatures
   gint *parent_refcount;
   GArray *array;
   gboolean is_any;
+
+  /* bits of all features in array, see gst_caps_feature_get_bit() */
+  guint64 mask;
 };
 
+/* Every feature name gets a global bit the first time it is used, which
+ * turns feature sets into bitmasks that can be compared directly. Names
+ * only ever get added, and once all bits are taken further features are
+ * marked with FEATURE_BIT_OTHER and compared by name. Processes rarely use
+ * more than a handful of different features. */
+#define MAX_FEATURE_BITS 63
+#define FEATURE_BIT_OTHER (G_GUINT64_CONSTANT (1) << MAX_FEATURE_BITS)
+#define FEATURE_BIT_SYSTEM_MEMORY (G_GUINT64_CONSTANT (1))
+
+static GQuark feature_bits[MAX_FEATURE_BITS];
+static gint n_feature_bits = 0;
+static GMutex feature_bits_lock;
+
+/* an empty set of features means system memory */
+#define FEATURES_MASK(features) \
+    ((features)->array->len == 0 ? FEATURE_BIT_SYSTEM_MEMORY : (features)->mask)
+
 GType _gst_caps_features_type = 0;
 static gint static_caps_features_parent_refcount = G_MAXINT;
 GstCapsFeatures *_gst_caps_features_any = NULL;
@@ -83,6 +103,57 @@ static void
 gst_caps_features_transform_to_string (const GValue * src_value,
     GValue * dest_value);
 
+/* returns 0 if @feature has no bit yet, lock-free as bits are never
+ * reassigned */
+static guint64
+gst_caps_feature_find_bit (GQuark feature)
+{
+  gint i, n = g_atomic_int_get (&n_feature_bits);
+
+  for (i = 0; i < n; i++) {
+    if (feature_bits[i] == feature)
+      return G_GUINT64_CONSTANT (1) << i;
+  }
+
+  return n == MAX_FEATURE_BITS ? FEATURE_BIT_OTHER : 0;
+}
+
+static guint64
+gst_caps_feature_get_bit (GQuark feature)
+{
+  guint64 bit;
+  gint n;
+
+  bit = gst_caps_feature_find_bit (feature);
+  if (G_LIKELY (bit != 0))
+    return bit;
+
+  g_mutex_lock (&feature_bits_lock);
+  bit = gst_caps_feature_find_bit (feature);
+  if (bit == 0) {
+    n = n_feature_bits;
+    feature_bits[n] = feature;
+    g_atomic_int_set (&n_feature_bits, n + 1);
+    bit = G_GUINT64_CONSTANT (1) << n;
+  }
+  g_mutex_unlock (&feature_bits_lock);
+
+  return bit;
+}
+
+static guint64
+gst_caps_features_compute_mask (const GstCapsFeatures * features)
+{
+  guint64 mask = 0;
+  guint i;
+
+  for (i = 0; i < features->array->len; i++)
+    mask |= gst_caps_feature_get_bit (g_array_index (features->array,
+            GQuark, i));
+
+  return mask;
+}
+
 void
 _priv_gst_caps_features_initialize (void)
 {
@@ -92,6 +163,10 @@ _priv_gst_caps_features_initialize (void)
   _gst_caps_features_type = gst_caps_features_get_type ();
   _gst_caps_feature_memory_system_memory =
       g_quark_from_static_string (GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY);
+  /* system memory always gets the first bit */
+  if (gst_caps_feature_get_bit (_gst_caps_feature_memory_system_memory) !=
+      FEATURE_BIT_SYSTEM_MEMORY)
+    g_assert_not_reached ();
 
   g_value_register_transform_func (_gst_caps_features_type, G_TYPE_STRING,
       gst_caps_features_transform_to_string);
@@ -185,6 +260,7 @@ gst_caps_features_new_empty (void)
   features->parent_refcount = NULL;
   features->array = g_array_new (FALSE, FALSE, sizeof (GQuark));
   features->is_any = FALSE;
+  features->mask = 0;
 
   GST_TRACE ("created caps features %p", features);
 
@@ -399,15 +475,21 @@ GstCapsFeatures *
 gst_caps_features_copy (const GstCapsFeatures * features)
 {
   GstCapsFeatures *copy;
-  guint i, n;
 
   g_return_val_if_fail (features != NULL, NULL);
 
-  copy = gst_caps_features_new_empty ();
-  n = gst_caps_features_get_size (features);
-  for (i = 0; i < n; i++)
-    gst_caps_features_add_id (copy, gst_caps_features_get_nth_id (features, i));
+  /* the features were validated when adding them already */
+  copy = g_slice_new (GstCapsFeatures);
+  copy->type = _gst_caps_features_type;
+  copy->parent_refcount = NULL;
+  copy->array = g_array_sized_new (FALSE, FALSE, sizeof (GQuark),
+      features->array->len);
+  g_array_append_vals (copy->array, features->array->data,
+      features->array->len);
   copy->is_any = features->is_any;
+  copy->mask = features->mask;
+
+  GST_TRACE ("created caps features %p", copy);
 
   return copy;
 }
@@ -685,6 +767,7 @@ gst_caps_features_contains (const GstCapsFeatures * features,
 gboolean
 gst_caps_features_contains_id (const GstCapsFeatures * features, GQuark feature)
 {
+  guint64 bit;
   guint i, n;
 
   g_return_val_if_fail (features != NULL, FALSE);
@@ -693,10 +776,13 @@ gst_caps_features_contains_id (const GstCapsFeatures * features, GQuark feature)
   if (features->is_any)
     return TRUE;
 
-  n = features->array->len;
-  if (n == 0)
-    return feature == _gst_caps_feature_memory_system_memory;
+  bit = gst_caps_feature_find_bit (feature);
+  if (bit != FEATURE_BIT_OTHER)
+    return (FEATURES_MASK (features) & bit) != 0;
+  if (!(features->mask & FEATURE_BIT_OTHER))
+    return FALSE;
 
+  n = features->array->len;
   for (i = 0; i < n; i++) {
     if (gst_caps_features_get_nth_id (features, i) == feature)
       return TRUE;
@@ -720,6 +806,7 @@ gboolean
 gst_caps_features_is_equal (const GstCapsFeatures * features1,
     const GstCapsFeatures * features2)
 {
+  guint64 mask1, mask2;
   guint i, n;
 
   g_return_val_if_fail (features1 != NULL, FALSE);
@@ -728,6 +815,13 @@ gst_caps_features_is_equal (const GstCapsFeatures * features1,
   if (features1->is_any || features2->is_any)
     return TRUE;
 
+  mask1 = FEATURES_MASK (features1);
+  mask2 = FEATURES_MASK (features2);
+  if (G_LIKELY (!((mask1 | mask2) & FEATURE_BIT_OTHER)))
+    return mask1 == mask2;
+  if ((mask1 ^ mask2) & ~FEATURE_BIT_OTHER)
+    return FALSE;
+
   /* Check for the sysmem==empty case */
   if (features1->array->len == 0 && features2->array->len == 0)
     return TRUE;
@@ -821,6 +915,7 @@ gst_caps_features_add_id (GstCapsFeatures * features, GQuark feature)
     return;
 
   g_array_append_val (features->array, feature);
+  features->mask |= gst_caps_feature_get_bit (feature);
 }
 
 /**
@@ -866,6 +961,7 @@ gst_caps_features_remove_id (GstCapsFeatures * features, GQuark feature)
 
     if (quark == feature) {
       g_array_remove_index_fast (features->array, i);
+      features->mask = gst_caps_features_compute_mask (features);
       return;
     }
   }
@@ -132,17 +132,35 @@ enum
 #define GST_CLOCK_SLAVE_LOCK(clock)     g_mutex_lock (&GST_CLOCK_CAST (clock)->priv->slave_lock)
 #define GST_CLOCK_SLAVE_UNLOCK(clock)   g_mutex_unlock (&GST_CLOCK_CAST (clock)->priv->slave_lock)
 
+#ifdef HAVE_UINT128_T
+/* Running sums of the observations in the window for the linear regression,
+ * so that every new observation only has to add itself and remove the
+ * oldest one. The sums are exact integers relative to the smallest values
+ * of the window, which keeps everything below 2^126 for windows of up to
+ * 1024 observations spanning less than 2^52ns. Otherwise the regression
+ * falls back to gst_calculate_linear_regression(). */
+#define REGRESSION_MAX_SPAN (G_GUINT64_CONSTANT (1) << 52)
+
+typedef struct
+{
+  gboolean valid;
+  GstClockTime xmin, ymin, xmax;
+  __int128_t sx, sy, sxx, sxy, syy;
+} GstClockRegression;
+#endif
+
 struct _GstClockPrivate
 {
   GMutex slave_lock;            /* order: SLAVE_LOCK, OBJECT_LOCK */
 
   GCond sync_cond;
 
-  /* with LOCK */
+  /* with LOCK, read without it with the seqlock */
   GstClockTime internal_calibration;
   GstClockTime external_calibration;
   GstClockTime rate_numerator;
   GstClockTime rate_denominator;
+  /* ATOMIC where 64-bit atomics are available, with LOCK otherwise */
   GstClockTime last_time;
 
   /* with LOCK */
@@ -159,6 +177,9 @@ struct _GstClockPrivate
   GstClockTime timeout;
   GstClockTime *times;
   GstClockTime *times_temp;
+#ifdef HAVE_UINT128_T
+  GstClockRegression regression;
+#endif
   GstClockID clockid;
 
   gint pre_count;
@@ -175,13 +196,28 @@ typedef struct _GstClockEntryImpl GstClockEntryImpl;
 #define read_seqbegin(clock)                                   \
   g_atomic_int_get (&clock->priv->post_count);
 
+/* number of times a reader yields to a writer before blocking on the lock */
+#define SEQ_MAX_SPINS 16
+
 static inline gboolean
 read_seqretry (GstClock * clock, gint seq)
 {
+  guint spins;
+
   /* no retry if the seqnum did not change */
   if (G_LIKELY (seq == g_atomic_int_get (&clock->priv->pre_count)))
     return FALSE;
 
+  /* writers only hold the lock for a few instructions, so give them a
+   * chance to finish before blocking on the lock. This is still needed
+   * when the writer got preempted by a reader with a higher priority. */
+  for (spins = 0; spins < SEQ_MAX_SPINS; spins++) {
+    if (g_atomic_int_get (&clock->priv->pre_count) ==
+        g_atomic_int_get (&clock->priv->post_count))
+      return TRUE;
+    g_thread_yield ();
+  }
+
   /* wait for the writer to finish and retry */
   GST_OBJECT_LOCK (clock);
   GST_OBJECT_UNLOCK (clock);
@@ -200,6 +236,39 @@ G_STMT_START {                                    \
   GST_OBJECT_UNLOCK (clock);                      \
 } G_STMT_END;
 
+/* Raises the last returned time to @time if it is bigger and returns the new
+ * last time. This keeps gst_clock_get_time() increasing without taking the
+ * lock in the readers. */
+#if GLIB_SIZEOF_VOID_P == 8
+/* the time fits in a pointer, so GLib's pointer atomics can update it */
+static inline GstClockTime
+gst_clock_update_last_time (GstClock * clock, GstClockTime time)
+{
+  gpointer *last_time = (gpointer *) & clock->priv->last_time;
+  GstClockTime last = (guintptr) g_atomic_pointer_get (last_time);
+
+  while (time > last) {
+    if (g_atomic_pointer_compare_and_exchange (last_time,
+            (gpointer) (guintptr) last, (gpointer) (guintptr) time))
+      return time;
+    last = (guintptr) g_atomic_pointer_get (last_time);
+  }
+
+  return last;
+}
+#else
+#define GST_CLOCK_LAST_TIME_LOCKED 1
+static inline GstClockTime
+gst_clock_update_last_time (GstClock * clock, GstClockTime time)
+{
+  GstClockPrivate *priv = clock->priv;
+
+  priv->last_time = MAX (time, priv->last_time);
+
+  return priv->last_time;
+}
+#endif
+
 #ifndef GST_DISABLE_GST_DEBUG
 static const gchar *
 gst_clock_return_get_name (GstClockReturn ret)
@@ -247,7 +316,7 @@ gst_clock_entry_new (GstClock * clock, GstClockTime time,
 
   entry = (GstClockEntry *) g_slice_new0 (GstClockEntryImpl);
 
-  /* FIXME: add tracer hook for struct allocations such as clock entries */
+  GST_TRACER_STRUCT_ALLOC ("GstClockEntry", entry, sizeof (GstClockEntryImpl));
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
       "created entry %p, time %" GST_TIME_FORMAT, entry, GST_TIME_ARGS (time));
@@ -376,7 +445,7 @@ _gst_clock_id_free (GstClockID id)
 
   g_weak_ref_clear (GST_CLOCK_ENTRY_CLOCK_WEAK_REF (entry));
 
-  /* FIXME: add tracer hook for struct allocations such as clock entries */
+  GST_TRACER_STRUCT_FREE ("GstClockEntry", id);
 
   g_slice_free (GstClockEntryImpl, (GstClockEntryImpl *) id);
 }
@@ -547,7 +616,9 @@ gst_clock_id_wait (GstClockID id, GstClockTimeDiff * jitter)
   if (G_UNLIKELY (cclass->wait == NULL))
     goto not_supported;
 
+  GST_SDT_PROBE3 (clock_wait, clock, id, requested);
   res = cclass->wait (clock, entry, jitter);
+  GST_SDT_PROBE3 (clock_wait_done, clock, id, res);
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
       "done waiting entry %p, res: %d (%s)", id, res,
@@ -951,9 +1022,7 @@ gst_clock_adjust_unlocked (GstClock * clock, GstClockTime internal)
       cnum, cdenom);
 
   /* make sure the time is increasing */
-  priv->last_time = MAX (ret, priv->last_time);
-
-  return priv->last_time;
+  return gst_clock_update_last_time (clock, ret);
 }
 
 /* FIXME 2.0: Remove clock parameter below */
@@ -1094,21 +1163,41 @@ not_supported:
 GstClockTime
 gst_clock_get_time (GstClock * clock)
 {
-  GstClockTime ret;
+  GstClockTime ret, internal, cinternal, cexternal, cnum, cdenom;
+  GstClockPrivate *priv;
   gint seq;
 
   g_return_val_if_fail (GST_IS_CLOCK (clock), GST_CLOCK_TIME_NONE);
 
+  priv = clock->priv;
+
+  /* only take a snapshot of the calibration in the read section, a torn
+   * calibration must not end up in last_time */
   do {
     /* reget the internal time when we retry to get the most current
      * timevalue */
-    ret = gst_clock_get_internal_time (clock);
+    internal = gst_clock_get_internal_time (clock);
 
     seq = read_seqbegin (clock);
-    /* this will scale for rate and offset */
-    ret = gst_clock_adjust_unlocked (clock, ret);
+    cinternal = priv->internal_calibration;
+    cexternal = priv->external_calibration;
+    cnum = priv->rate_numerator;
+    cdenom = priv->rate_denominator;
   } while (read_seqretry (clock, seq));
 
+  /* this will scale for rate and offset */
+  ret = gst_clock_adjust_with_calibration (clock, internal, cinternal,
+      cexternal, cnum, cdenom);
+
+  /* make sure the time is increasing */
+#ifdef GST_CLOCK_LAST_TIME_LOCKED
+  GST_OBJECT_LOCK (clock);
+  ret = gst_clock_update_last_time (clock, ret);
+  GST_OBJECT_UNLOCK (clock);
+#else
+  ret = gst_clock_update_last_time (clock, ret);
+#endif
+
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "adjusted time %" GST_TIME_FORMAT,
       GST_TIME_ARGS (ret));
 
@@ -1293,6 +1382,9 @@ gst_clock_set_master (GstClock * clock, GstClock * master)
   if (master) {
     priv->filling = TRUE;
     priv->time_index = 0;
+#ifdef HAVE_UINT128_T
+    priv->regression.valid = FALSE;
+#endif
     /* use the master periodic id to schedule sampling and
      * clock calibration. */
     priv->clockid = gst_clock_new_periodic_id (master,
@@ -1449,6 +1541,122 @@ gst_clock_add_observation (GstClock * clock, GstClockTime slave,
   return TRUE;
 }
 
+#ifdef HAVE_UINT128_T
+/* with SLAVE_LOCK */
+static void
+gst_clock_regression_add (GstClockRegression * r, GstClockTime x,
+    GstClockTime y, gint sign)
+{
+  __int128_t dx = x - r->xmin, dy = y - r->ymin;
+
+  r->sx += sign * dx;
+  r->sy += sign * dy;
+  r->sxx += sign * dx * dx;
+  r->sxy += sign * dx * dy;
+  r->syy += sign * dy * dy;
+}
+
+/* with SLAVE_LOCK */
+static gboolean
+gst_clock_regression_recompute (GstClockPrivate * priv, guint n)
+{
+  GstClockRegression *r = &priv->regression;
+  GstClockTime ymax = 0;
+  guint i;
+
+  r->xmin = r->ymin = G_MAXUINT64;
+  r->xmax = 0;
+  for (i = 0; i < n; i++) {
+    r->xmin = MIN (r->xmin, priv->times[2 * i]);
+    r->xmax = MAX (r->xmax, priv->times[2 * i]);
+    r->ymin = MIN (r->ymin, priv->times[2 * i + 1]);
+    ymax = MAX (ymax, priv->times[2 * i + 1]);
+  }
+
+  r->valid = r->xmax - r->xmin < REGRESSION_MAX_SPAN
+      && ymax - r->ymin < REGRESSION_MAX_SPAN;
+  if (!r->valid)
+    return FALSE;
+
+  r->sx = r->sy = r->sxx = r->sxy = r->syy = 0;
+  for (i = 0; i < n; i++)
+    gst_clock_regression_add (r, priv->times[2 * i], priv->times[2 * i + 1],
+        1);
+
+  return TRUE;
+}
+
+/* Updates the running sums after @x, @y replaced @old_x, @old_y in the
+ * window, if @replaced, or was appended to it. The sums are recalculated
+ * once per window to not depend on the old origin forever, and when the new
+ * observation doesn't fit.
+ *
+ * with SLAVE_LOCK */
+static gboolean
+gst_clock_regression_update (GstClockPrivate * priv, guint n,
+    gboolean replaced, GstClockTime old_x, GstClockTime old_y,
+    GstClockTime x, GstClockTime y)
+{
+  GstClockRegression *r = &priv->regression;
+
+  if (!r->valid || priv->time_index == 0 || x < r->xmin || y < r->ymin
+      || x - r->xmin >= REGRESSION_MAX_SPAN
+      || y - r->ymin >= REGRESSION_MAX_SPAN || (replaced && old_x == r->xmax
+          && x < r->xmax))
+    return gst_clock_regression_recompute (priv, n);
+
+  if (replaced)
+    gst_clock_regression_add (r, old_x, old_y, -1);
+  gst_clock_regression_add (r, x, y, 1);
+  r->xmax = MAX (r->xmax, x);
+
+  return TRUE;
+}
+
+/* Same result as gst_calculate_linear_regression() over the window, but
+ * calculated from the running sums
+ *
+ * with SLAVE_LOCK */
+static gboolean
+gst_clock_regression_calculate (GstClockPrivate * priv, guint n,
+    GstClockTime * m_num, GstClockTime * m_denom, GstClockTime * b,
+    GstClockTime * xbase, gdouble * r_squared)
+{
+  GstClockRegression *r = &priv->regression;
+  __int128_t num, den, syy;
+  __uint128_t b_num, b_den;
+
+  num = n * r->sxy - r->sx * r->sy;
+  den = n * r->sxx - r->sx * r->sx;
+  syy = n * r->syy - r->sy * r->sy;
+  if (G_UNLIKELY (den <= 0 || num < 0)) {
+    GST_CAT_DEBUG (GST_CAT_CLOCK, "sxx == 0, regression failed");
+    return FALSE;
+  }
+
+  *r_squared = ((double) num * (double) num) / ((double) den * (double) syy);
+
+  while (num > G_MAXINT64 || den > G_MAXINT64) {
+    num >>= 1;
+    den >>= 1;
+  }
+  if (G_UNLIKELY (den == 0))
+    return FALSE;
+
+  /* y at the most recent observation: ybar + m * (xmax - xbar) */
+  b_num = (__uint128_t) r->sy * den
+      + (__uint128_t) num * (n * (__int128_t) (r->xmax - r->xmin) - r->sx);
+  b_den = (__uint128_t) n * den;
+
+  *m_num = num;
+  *m_denom = den;
+  *b = r->ymin + (GstClockTime) ((b_num + b_den / 2) / b_den);
+  *xbase = r->xmax;
+
+  return TRUE;
+}
+#endif
+
 /**
  * gst_clock_add_observation_unapplied:
  * @clock: a #GstClock
@@ -1480,6 +1688,10 @@ gst_clock_add_observation_unapplied (GstClock * clock, GstClockTime slave,
   GstClockTime m_num, m_denom, b, xbase;
   GstClockPrivate *priv;
   guint n;
+#ifdef HAVE_UINT128_T
+  GstClockTime old_x, old_y;
+  gboolean replaced, have_sums;
+#endif
 
   g_return_val_if_fail (GST_IS_CLOCK (clock), FALSE);
   g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (slave), FALSE);
@@ -1494,6 +1706,12 @@ gst_clock_add_observation_unapplied (GstClock * clock, GstClockTime slave,
       "adding observation slave %" GST_TIME_FORMAT ", master %" GST_TIME_FORMAT,
       GST_TIME_ARGS (slave), GST_TIME_ARGS (master));
 
+#ifdef HAVE_UINT128_T
+  replaced = !priv->filling;
+  old_x = priv->times[(2 * priv->time_index)];
+  old_y = priv->times[(2 * priv->time_index) + 1];
+#endif
+
   priv->times[(2 * priv->time_index)] = slave;
   priv->times[(2 * priv->time_index) + 1] = master;
 
@@ -1503,10 +1721,22 @@ gst_clock_add_observation_unapplied (GstClock * clock, GstClockTime slave,
     priv->time_index = 0;
   }
 
+  n = priv->filling ? priv->time_index : priv->window_size;
+#ifdef HAVE_UINT128_T
+  have_sums = gst_clock_regression_update (priv, n, replaced, old_x, old_y,
+      slave, master);
+#endif
+
   if (G_UNLIKELY (priv->filling && priv->time_index < priv->window_threshold))
     goto filling;
 
-  n = priv->filling ? priv->time_index : priv->window_size;
+#ifdef HAVE_UINT128_T
+  if (have_sums) {
+    if (!gst_clock_regression_calculate (priv, n, &m_num, &m_denom, &b,
+            &xbase, r_squared))
+      goto invalid;
+  } else
+#endif
   if (!gst_calculate_linear_regression (priv->times, priv->times_temp, n,
           &m_num, &m_denom, &b, &xbase, r_squared))
     goto invalid;
@@ -1601,6 +1831,9 @@ gst_clock_set_property (GObject * object, guint prop_id,
       /* restart calibration */
       priv->filling = TRUE;
       priv->time_index = 0;
+#ifdef HAVE_UINT128_T
+      priv->regression.valid = FALSE;
+#endif
       GST_CLOCK_SLAVE_UNLOCK (clock);
       break;
     case PROP_WINDOW_THRESHOLD:
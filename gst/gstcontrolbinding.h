@@ -155,8 +155,27 @@ struct _GstControlBindingClass
    */
   gboolean (* get_g_value_array) (GstControlBinding *binding, GstClockTime timestamp,GstClockTime interval, guint n_values, GValue *values);
 
+  /**
+   * GstControlBindingClass::get_sync_value:
+   * @binding: the control binding
+   * @timestamp: the time that should be processed
+   * @last_sync: the last time this was called
+   * @value: (out caller-allocates): a zero-filled #GValue for the new
+   *     property value
+   *
+   * Compute the value that sync_values() would apply to the property, without
+   * applying it. @value is left unset if the property keeps its current
+   * value. Used by gst_object_sync_values_batch(), with the object lock of the
+   * controlled object held.
+   *
+   * Returns: %TRUE if the control value could be computed, %FALSE otherwise
+   *
+   * Since: 1.20
+   */
+  gboolean (* get_sync_value) (GstControlBinding *binding, GstClockTime timestamp, GstClockTime last_sync, GValue *value);
+
   /*< private >*/
-  gpointer _gst_reserved[GST_PADDING];
+  gpointer _gst_reserved[GST_PADDING - 1];
 };
 
 #define GST_CONTROL_BINDING_PSPEC(cb) (((GstControlBinding *) cb)->pspec)
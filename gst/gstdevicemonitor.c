@@ -115,6 +115,11 @@ struct _GstDeviceMonitorPrivate
   guint last_id;
   GList *hidden;
   gboolean show_all;
+
+  /* GstDevice -> whether it matches the filters. Filters can't change while
+   * started and the devices of started providers stay the same objects, so
+   * this is only filled while started */
+  GHashTable *matches;
 };
 
 #define DEFAULT_SHOW_ALL        FALSE
@@ -146,6 +151,59 @@ device_filter_free (struct DeviceFilter *filter)
   g_slice_free (struct DeviceFilter, filter);
 }
 
+typedef struct
+{
+  GstDeviceProvider *provider;
+  gboolean started;
+  GList *devices;
+} ProviderJob;
+
+static gpointer
+provider_job_start (ProviderJob * job)
+{
+  job->started = gst_device_provider_start (job->provider);
+
+  return NULL;
+}
+
+static gpointer
+provider_job_get_devices (ProviderJob * job)
+{
+  job->devices = gst_device_provider_get_devices (job->provider);
+
+  return NULL;
+}
+
+/* Runs @func for all @jobs. Starting or probing a provider can take a long
+ * time, so every job but the first gets its own thread and the first one
+ * runs in the calling thread. Must be called without the monitor lock */
+static void
+run_provider_jobs (ProviderJob * jobs, guint n_jobs, GThreadFunc func)
+{
+  GThread **threads;
+  guint i;
+
+  if (n_jobs == 0)
+    return;
+
+  threads = g_newa (GThread *, n_jobs);
+  threads[0] = NULL;
+
+  for (i = 1; i < n_jobs; i++) {
+    threads[i] = g_thread_try_new ("devicemonitor", func, &jobs[i], NULL);
+    /* run it here then */
+    if (threads[i] == NULL)
+      func (&jobs[i]);
+  }
+
+  func (&jobs[0]);
+
+  for (i = 1; i < n_jobs; i++) {
+    if (threads[i])
+      g_thread_join (threads[i]);
+  }
+}
+
 static void
 gst_device_monitor_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -233,6 +291,37 @@ update_hidden_providers_list (GList ** hidden, GstDeviceProvider * provider)
   }
 }
 
+/* must be called with monitor lock */
+static gboolean
+device_matches_filters (GstDeviceMonitor * monitor, GstDevice * device)
+{
+  gboolean matches = TRUE;
+  gpointer cached;
+  GstCaps *caps;
+  guint i;
+
+  if (g_hash_table_lookup_extended (monitor->priv->matches, device, NULL,
+          &cached))
+    return GPOINTER_TO_INT (cached);
+
+  caps = gst_device_get_caps (device);
+  for (i = 0; i < monitor->priv->filters->len; i++) {
+    struct DeviceFilter *filter = g_ptr_array_index (monitor->priv->filters, i);
+
+    matches = gst_caps_can_intersect (filter->caps, caps) &&
+        gst_device_has_classesv (device, filter->classesv);
+    if (matches)
+      break;
+  }
+  gst_caps_unref (caps);
+
+  if (monitor->priv->started)
+    g_hash_table_insert (monitor->priv->matches, gst_object_ref (device),
+        GINT_TO_POINTER (matches));
+
+  return matches;
+}
+
 static void
 bus_sync_message (GstBus * bus, GstMessage * message,
     GstDeviceMonitor * monitor)
@@ -241,8 +330,8 @@ bus_sync_message (GstBus * bus, GstMessage * message,
 
   if (type == GST_MESSAGE_DEVICE_ADDED || type == GST_MESSAGE_DEVICE_REMOVED ||
       type == GST_MESSAGE_DEVICE_CHANGED) {
-    gboolean matches = TRUE;
-    GstDevice *device;
+    gboolean matches;
+    GstDevice *device, *old_device = NULL;
     GstDeviceProvider *provider;
 
     if (type == GST_MESSAGE_DEVICE_ADDED)
@@ -250,33 +339,26 @@ bus_sync_message (GstBus * bus, GstMessage * message,
     else if (type == GST_MESSAGE_DEVICE_REMOVED)
       gst_message_parse_device_removed (message, &device);
     else
-      gst_message_parse_device_changed (message, &device, NULL);
+      gst_message_parse_device_changed (message, &device, &old_device);
 
     GST_OBJECT_LOCK (monitor);
     provider =
         GST_DEVICE_PROVIDER (gst_object_get_parent (GST_OBJECT (device)));
-    if (is_provider_hidden (monitor, monitor->priv->hidden, provider)) {
+    if (is_provider_hidden (monitor, monitor->priv->hidden, provider))
       matches = FALSE;
-    } else {
-      guint i;
+    else
+      matches = device_matches_filters (monitor, device);
 
-      for (i = 0; i < monitor->priv->filters->len; i++) {
-        struct DeviceFilter *filter =
-            g_ptr_array_index (monitor->priv->filters, i);
-        GstCaps *caps;
-
-        caps = gst_device_get_caps (device);
-        matches = gst_caps_can_intersect (filter->caps, caps) &&
-            gst_device_has_classesv (device, filter->classesv);
-        gst_caps_unref (caps);
-        if (matches)
-          break;
-      }
-    }
+    if (type == GST_MESSAGE_DEVICE_REMOVED)
+      g_hash_table_remove (monitor->priv->matches, device);
+    else if (old_device)
+      g_hash_table_remove (monitor->priv->matches, old_device);
     GST_OBJECT_UNLOCK (monitor);
 
     gst_object_unref (provider);
     gst_object_unref (device);
+    if (old_device)
+      gst_object_unref (old_device);
 
     if (matches)
       gst_bus_post (monitor->priv->bus, gst_message_ref (message));
@@ -297,6 +379,8 @@ gst_device_monitor_init (GstDeviceMonitor * self)
   self->priv->providers = g_ptr_array_new ();
   self->priv->filters = g_ptr_array_new_with_free_func (
       (GDestroyNotify) device_filter_free);
+  self->priv->matches = g_hash_table_new_full (NULL, NULL, gst_object_unref,
+      NULL);
 
   self->priv->last_id = 1;
 }
@@ -336,6 +420,11 @@ gst_device_monitor_dispose (GObject * object)
     self->priv->filters = NULL;
   }
 
+  if (self->priv->matches) {
+    g_hash_table_unref (self->priv->matches);
+    self->priv->matches = NULL;
+  }
+
   gst_object_replace ((GstObject **) & self->priv->bus, NULL);
 
   G_OBJECT_CLASS (gst_device_monitor_parent_class)->dispose (object);
@@ -346,7 +435,8 @@ gst_device_monitor_dispose (GObject * object)
  * @monitor: A #GstDeviceProvider
  *
  * Gets a list of devices from all of the relevant monitors. This may actually
- * probe the hardware if the monitor is not currently started.
+ * probe the hardware if the monitor is not currently started, the providers
+ * are then probed in parallel.
  *
  * Returns: (transfer full) (element-type GstDevice) (nullable): a #GList of
  *   #GstDevice
@@ -358,7 +448,8 @@ GList *
 gst_device_monitor_get_devices (GstDeviceMonitor * monitor)
 {
   GList *devices = NULL, *hidden = NULL;
-  guint i;
+  ProviderJob *jobs = NULL;
+  guint i, n_jobs = 0;
   guint cookie;
 
   g_return_val_if_fail (GST_IS_DEVICE_MONITOR (monitor), NULL);
@@ -379,6 +470,11 @@ gst_device_monitor_get_devices (GstDeviceMonitor * monitor)
 
 again:
 
+  for (i = 0; i < n_jobs; i++) {
+    g_list_free_full (jobs[i].devices, gst_object_unref);
+    gst_object_unref (jobs[i].provider);
+  }
+  g_free (jobs);
   g_list_free_full (devices, gst_object_unref);
   g_list_free_full (hidden, g_free);
   devices = NULL;
@@ -393,47 +489,37 @@ again:
 
   cookie = monitor->priv->cookie;
 
+  jobs = g_new0 (ProviderJob, monitor->priv->providers->len);
+  n_jobs = 0;
   for (i = 0; i < monitor->priv->providers->len; i++) {
-    GList *tmpdev;
     GstDeviceProvider *provider =
-        gst_object_ref (g_ptr_array_index (monitor->priv->providers, i));
-    GList *item;
+        g_ptr_array_index (monitor->priv->providers, i);
 
-    if (!is_provider_hidden (monitor, hidden, provider)) {
-      GST_OBJECT_UNLOCK (monitor);
+    if (!is_provider_hidden (monitor, hidden, provider))
+      jobs[n_jobs++].provider = gst_object_ref (provider);
+  }
 
-      tmpdev = gst_device_provider_get_devices (provider);
+  GST_OBJECT_UNLOCK (monitor);
+  run_provider_jobs (jobs, n_jobs, (GThreadFunc) provider_job_get_devices);
+  GST_OBJECT_LOCK (monitor);
 
-      GST_OBJECT_LOCK (monitor);
-    } else {
-      tmpdev = NULL;
-    }
+  if (monitor->priv->cookie != cookie)
+    goto again;
 
+  for (i = 0; i < n_jobs; i++) {
+    GList *item;
 
-    for (item = tmpdev; item; item = item->next) {
+    for (item = jobs[i].devices; item; item = item->next) {
       GstDevice *dev = GST_DEVICE (item->data);
-      GstCaps *caps = gst_device_get_caps (dev);
-      guint j;
 
-      for (j = 0; j < monitor->priv->filters->len; j++) {
-        struct DeviceFilter *filter =
-            g_ptr_array_index (monitor->priv->filters, j);
-
-        if (gst_caps_can_intersect (filter->caps, caps) &&
-            gst_device_has_classesv (dev, filter->classesv)) {
-          devices = g_list_prepend (devices, gst_object_ref (dev));
-          break;
-        }
-      }
-      gst_caps_unref (caps);
+      if (device_matches_filters (monitor, dev))
+        devices = g_list_prepend (devices, gst_object_ref (dev));
     }
 
-    g_list_free_full (tmpdev, gst_object_unref);
-    gst_object_unref (provider);
-
-    if (monitor->priv->cookie != cookie)
-      goto again;
+    g_list_free_full (jobs[i].devices, gst_object_unref);
+    gst_object_unref (jobs[i].provider);
   }
+  g_free (jobs);
   g_list_free_full (hidden, g_free);
 
   GST_OBJECT_UNLOCK (monitor);
@@ -457,8 +543,10 @@ again:
 gboolean
 gst_device_monitor_start (GstDeviceMonitor * monitor)
 {
-  guint cookie, i;
+  guint cookie, i, n_jobs;
   GList *pending = NULL, *started = NULL, *removed = NULL;
+  ProviderJob *jobs;
+  gboolean failed = FALSE;
 
   g_return_val_if_fail (GST_IS_DEVICE_MONITOR (monitor), FALSE);
 
@@ -507,22 +595,37 @@ again:
   g_list_free_full (removed, gst_object_unref);
   removed = NULL;
 
-  while (pending) {
-    GstDeviceProvider *provider = pending->data;
+  /* start all pending providers at once */
+  n_jobs = g_list_length (pending);
+  jobs = g_new (ProviderJob, n_jobs);
+  for (i = 0; pending; i++) {
+    jobs[i].provider = pending->data;
+    jobs[i].started = FALSE;
+    pending = g_list_delete_link (pending, pending);
+  }
 
-    GST_OBJECT_UNLOCK (monitor);
+  GST_OBJECT_UNLOCK (monitor);
+  run_provider_jobs (jobs, n_jobs, (GThreadFunc) provider_job_start);
 
-    if (!gst_device_provider_start (provider))
-      goto start_failed;
+  for (i = 0; i < n_jobs; i++) {
+    if (jobs[i].started) {
+      started = g_list_prepend (started, jobs[i].provider);
+    } else {
+      GST_WARNING_OBJECT (monitor, "Failed to start %" GST_PTR_FORMAT,
+          jobs[i].provider);
+      gst_object_unref (jobs[i].provider);
+      failed = TRUE;
+    }
+  }
+  g_free (jobs);
 
-    GST_OBJECT_LOCK (monitor);
+  if (failed)
+    goto start_failed;
 
-    started = g_list_prepend (started, provider);
-    pending = g_list_delete_link (pending, pending);
+  GST_OBJECT_LOCK (monitor);
+  if (monitor->priv->cookie != cookie)
+    goto again;
 
-    if (monitor->priv->cookie != cookie)
-      goto again;
-  }
   monitor->priv->started = TRUE;
   GST_OBJECT_UNLOCK (monitor);
 
@@ -587,6 +690,7 @@ gst_device_monitor_stop (GstDeviceMonitor * monitor)
 
   GST_OBJECT_LOCK (monitor);
   monitor->priv->started = FALSE;
+  g_hash_table_remove_all (monitor->priv->matches);
   GST_OBJECT_UNLOCK (monitor);
 
 }
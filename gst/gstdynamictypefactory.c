@@ -100,21 +100,41 @@ gst_dynamic_type_factory_find (const gchar * name)
 GType
 gst_dynamic_type_factory_load (const gchar * factoryname)
 {
-  GstDynamicTypeFactory *factory = gst_dynamic_type_factory_find (factoryname);
+  GstDynamicTypeFactory *factory, *loaded;
+  GType type;
+
+  factory = gst_dynamic_type_factory_find (factoryname);
 
   /* Called with a non-dynamic or unregistered type? */
   if (factory == NULL)
-    return FALSE;
+    return 0;
+
+  /* The type is looked up again for every value that is deserialized with
+   * it, don't try to load a plugin that failed to load over and over */
+  if (g_atomic_int_get (&factory->load_failed)) {
+    GST_LOG_OBJECT (factory, "Not loading type %s again", factoryname);
+    gst_object_unref (factory);
+    return 0;
+  }
 
-  factory =
+  loaded =
       GST_DYNAMIC_TYPE_FACTORY (gst_plugin_feature_load (GST_PLUGIN_FEATURE
           (factory)));
-  if (factory == NULL)
+  if (loaded == NULL) {
+    GST_WARNING_OBJECT (factory, "Failed to load type %s", factoryname);
+    g_atomic_int_set (&factory->load_failed, TRUE);
+    gst_object_unref (factory);
     return 0;
+  }
+
+  /* the type stays registered after the factory is unreffed */
+  type = loaded->type;
+  GST_DEBUG_OBJECT (loaded, "Loaded type %s", factoryname);
 
-  GST_DEBUG_OBJECT (factory, "Loaded type %s", factoryname);
+  gst_object_unref (loaded);
+  gst_object_unref (factory);
 
-  return factory->type;
+  return type;
 }
 
 static GstDynamicTypeFactory *
@@ -171,6 +191,8 @@ gst_dynamic_type_register (GstPlugin * plugin, GType dyn_type)
         existing_feature, name);
     existing_feature->loaded = TRUE;
     GST_DYNAMIC_TYPE_FACTORY (existing_feature)->type = dyn_type;
+    g_atomic_int_set (&GST_DYNAMIC_TYPE_FACTORY (existing_feature)->load_failed,
+        FALSE);
     gst_object_unref (existing_feature);
     return TRUE;
   }
@@ -160,6 +160,33 @@ static void gst_element_call_async_func (gpointer data, gpointer user_data);
 static GstObjectClass *parent_class = NULL;
 static guint gst_element_signals[LAST_SIGNAL] = { 0 };
 
+/* the indices in use for the pads of a request pad template */
+typedef struct
+{
+  GstPadTemplate *templ;
+  gulong *used;
+  guint n_words;
+  guint next;
+} GstPadIndexSet;
+
+#define PAD_INDEX_BITS (sizeof (gulong) * 8)
+
+typedef struct
+{
+  /* with LOCK, maps the pad names to the pads once an element has many pads.
+   * The keys are the names of the pads, which can't change while they are
+   * parented. */
+  GHashTable *pads_by_name;
+  /* with LOCK, list of GstPadIndexSet */
+  GSList *pad_indices;
+} GstElementPrivate;
+
+/* number of pads from which gst_element_get_static_pad() uses a hash table
+ * instead of walking the pads */
+#define PADS_BY_NAME_THRESHOLD 16
+
+static gint private_offset = 0;
+
 static GMutex _element_pool_lock;
 static GThreadPool *gst_element_pool = NULL;
 
@@ -189,6 +216,9 @@ gst_element_get_type (void)
     _type = g_type_register_static (GST_TYPE_OBJECT, "GstElement",
         &element_info, G_TYPE_FLAG_ABSTRACT);
 
+    private_offset =
+        g_type_add_instance_private (_type, sizeof (GstElementPrivate));
+
     __gst_elementclass_factory =
         g_quark_from_static_string ("GST_ELEMENTCLASS_FACTORY");
     g_once_init_leave (&gst_element_type, _type);
@@ -196,6 +226,12 @@ gst_element_get_type (void)
   return gst_element_type;
 }
 
+static inline GstElementPrivate *
+gst_element_get_instance_private (GstElement * self)
+{
+  return (G_STRUCT_MEMBER_P (self, private_offset));
+}
+
 static GThreadPool *
 gst_element_setup_thread_pool (void)
 {
@@ -223,6 +259,9 @@ gst_element_class_init (GstElementClass * klass)
 
   parent_class = g_type_class_peek_parent (klass);
 
+  if (private_offset != 0)
+    g_type_class_adjust_private_offset (klass, &private_offset);
+
   /**
    * GstElement::pad-added:
    * @gstelement: the object which received the signal
@@ -741,6 +780,7 @@ gst_element_get_index (GstElement * element)
 gboolean
 gst_element_add_pad (GstElement * element, GstPad * pad)
 {
+  GstElementPrivate *priv;
   gchar *pad_name;
   gboolean active;
 
@@ -758,8 +798,14 @@ gst_element_add_pad (GstElement * element, GstPad * pad)
 
   /* then check to see if there's already a pad by that name here */
   GST_OBJECT_LOCK (element);
-  if (G_UNLIKELY (!gst_object_check_uniqueness (element->pads, pad_name)))
+  priv = gst_element_get_instance_private (element);
+  if (priv->pads_by_name) {
+    if (G_UNLIKELY (g_hash_table_contains (priv->pads_by_name, pad_name)))
+      goto name_exists;
+  } else if (G_UNLIKELY (!gst_object_check_uniqueness (element->pads,
+              pad_name))) {
     goto name_exists;
+  }
 
   /* try to set the pad's parent */
   if (G_UNLIKELY (!gst_object_set_parent (GST_OBJECT_CAST (pad),
@@ -790,6 +836,16 @@ gst_element_add_pad (GstElement * element, GstPad * pad)
   element->pads = g_list_append (element->pads, pad);
   element->numpads++;
   element->pads_cookie++;
+
+  if (priv->pads_by_name) {
+    g_hash_table_insert (priv->pads_by_name, GST_PAD_NAME (pad), pad);
+  } else if (element->numpads >= PADS_BY_NAME_THRESHOLD) {
+    GList *l;
+
+    priv->pads_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    for (l = element->pads; l; l = l->next)
+      g_hash_table_insert (priv->pads_by_name, GST_PAD_NAME (l->data), l->data);
+  }
   GST_OBJECT_UNLOCK (element);
 
   /* emit the PAD_ADDED signal */
@@ -859,6 +915,7 @@ no_direction:
 gboolean
 gst_element_remove_pad (GstElement * element, GstPad * pad)
 {
+  GstElementPrivate *priv;
   GstPad *peer;
 
   g_return_val_if_fail (GST_IS_ELEMENT (element), FALSE);
@@ -914,6 +971,10 @@ gst_element_remove_pad (GstElement * element, GstPad * pad)
   element->pads = g_list_remove (element->pads, pad);
   element->numpads--;
   element->pads_cookie++;
+
+  priv = gst_element_get_instance_private (element);
+  if (priv->pads_by_name)
+    g_hash_table_remove (priv->pads_by_name, GST_PAD_NAME (pad));
   GST_OBJECT_UNLOCK (element);
 
   /* emit the PAD_REMOVED signal before unparenting and losing the last ref. */
@@ -989,19 +1050,26 @@ pad_compare_name (GstPad * pad1, const gchar * name)
 GstPad *
 gst_element_get_static_pad (GstElement * element, const gchar * name)
 {
-  GList *find;
+  GstElementPrivate *priv;
   GstPad *result = NULL;
 
   g_return_val_if_fail (GST_IS_ELEMENT (element), NULL);
   g_return_val_if_fail (name != NULL, NULL);
 
   GST_OBJECT_LOCK (element);
-  find =
-      g_list_find_custom (element->pads, name, (GCompareFunc) pad_compare_name);
-  if (find) {
-    result = GST_PAD_CAST (find->data);
-    gst_object_ref (result);
+  priv = gst_element_get_instance_private (element);
+  if (priv->pads_by_name) {
+    result = g_hash_table_lookup (priv->pads_by_name, name);
+  } else {
+    GList *find;
+
+    find = g_list_find_custom (element->pads, name,
+        (GCompareFunc) pad_compare_name);
+    if (find)
+      result = GST_PAD_CAST (find->data);
   }
+  if (result)
+    gst_object_ref (result);
 
   if (result == NULL) {
     GST_CAT_INFO (GST_CAT_ELEMENT_PADS, "no such pad '%s' in element \"%s\"",
@@ -1289,15 +1357,232 @@ gst_element_request_pad (GstElement * element,
   return _gst_element_request_pad (element, templ, name, caps);
 }
 
+static void
+pad_index_set_free (GstPadIndexSet * set)
+{
+  g_free (set->used);
+  g_slice_free (GstPadIndexSet, set);
+}
+
+/* call with LOCK */
+static GstPadIndexSet *
+pad_index_set_get (GstElement * element, GstPadTemplate * templ,
+    gboolean create)
+{
+  GstElementPrivate *priv = gst_element_get_instance_private (element);
+  GstPadIndexSet *set;
+  GSList *l;
+
+  for (l = priv->pad_indices; l; l = l->next) {
+    set = l->data;
+    if (set->templ == templ)
+      return set;
+  }
+
+  if (!create)
+    return NULL;
+
+  /* the template is owned by the element class, no need to ref it */
+  set = g_slice_new0 (GstPadIndexSet);
+  set->templ = templ;
+  priv->pad_indices = g_slist_prepend (priv->pad_indices, set);
+
+  return set;
+}
+
+static inline gboolean
+pad_index_set_contains (GstPadIndexSet * set, guint index)
+{
+  guint word = index / PAD_INDEX_BITS;
+
+  if (word >= set->n_words)
+    return FALSE;
+
+  return (set->used[word] & (1UL << (index % PAD_INDEX_BITS))) != 0;
+}
+
+static void
+pad_index_set_add (GstPadIndexSet * set, guint index)
+{
+  guint word = index / PAD_INDEX_BITS;
+
+  if (word >= set->n_words) {
+    guint n_words = MAX (set->n_words * 2, word + 1);
+
+    set->used = g_renew (gulong, set->used, n_words);
+    memset (set->used + set->n_words, 0,
+        (n_words - set->n_words) * sizeof (gulong));
+    set->n_words = n_words;
+  }
+
+  set->used[word] |= 1UL << (index % PAD_INDEX_BITS);
+}
+
+/* the first index from @start that is not in use */
+static guint
+pad_index_set_find_free (GstPadIndexSet * set, guint start)
+{
+  guint word = start / PAD_INDEX_BITS;
+  gint bit = (gint) (start % PAD_INDEX_BITS) - 1;
+
+  for (; word < set->n_words; word++) {
+    bit = g_bit_nth_lsf (~set->used[word], bit);
+    if (bit != -1)
+      return word * PAD_INDEX_BITS + bit;
+    bit = -1;
+  }
+
+  return MAX (start, set->n_words * PAD_INDEX_BITS);
+}
+
+/* checks that the template has a single %u or %d specifier */
+static const gchar *
+pad_index_template_specifier (const gchar * name_template)
+{
+  const gchar *spec;
+
+  spec = strchr (name_template, '%');
+  if (spec == NULL || (spec[1] != 'u' && spec[1] != 'd')
+      || strchr (spec + 1, '%') != NULL)
+    return NULL;
+
+  return spec;
+}
+
+/* parses the index from @name */
+static gboolean
+pad_index_parse (const gchar * name_template, const gchar * spec,
+    const gchar * name, guint * index)
+{
+  const gchar *postfix;
+  gsize prefix_len, postfix_len, name_len;
+  guint64 val;
+  gchar *endptr;
+
+  prefix_len = spec - name_template;
+  postfix = spec + 2;
+  postfix_len = strlen (postfix);
+  name_len = strlen (name);
+
+  if (name_len <= prefix_len + postfix_len
+      || strncmp (name, name_template, prefix_len) != 0
+      || strcmp (name + name_len - postfix_len, postfix) != 0
+      || !g_ascii_isdigit (name[prefix_len]))
+    return FALSE;
+
+  val = g_ascii_strtoull (name + prefix_len, &endptr, 10);
+  if (val > G_MAXUINT || endptr != name + name_len - postfix_len)
+    return FALSE;
+
+  *index = val;
+  return TRUE;
+}
+
+/**
+ * gst_element_claim_pad_index:
+ * @element: a #GstElement
+ * @templ: a request #GstPadTemplate of @element with a single \%u or \%d
+ *     specifier in its name template
+ * @name: (allow-none): the name of the requested pad. Can be %NULL.
+ * @index: (out): the claimed index
+ *
+ * Claims the index of a new request pad of @templ. This is meant to be used
+ * by elements in their #GstElementClass::request_new_pad implementation and
+ * does not walk the existing pads.
+ *
+ * When @name is %NULL or still contains the specifier, the first index after
+ * the last claimed one that is not in use is returned. Otherwise the index is
+ * parsed from @name.
+ *
+ * The index should be released with gst_element_release_pad_index() when
+ * the pad is released.
+ *
+ * Returns: %TRUE if @index was claimed, %FALSE if @name doesn't match @templ
+ * or its index is in use already.
+ *
+ * MT safe.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_element_claim_pad_index (GstElement * element, GstPadTemplate * templ,
+    const gchar * name, guint * index)
+{
+  GstPadIndexSet *set;
+  const gchar *spec;
+  gboolean next_free;
+  guint idx = 0;
+
+  g_return_val_if_fail (GST_IS_ELEMENT (element), FALSE);
+  g_return_val_if_fail (GST_IS_PAD_TEMPLATE (templ), FALSE);
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  spec = pad_index_template_specifier (templ->name_template);
+  g_return_val_if_fail (spec != NULL, FALSE);
+
+  next_free = name == NULL || strchr (name, '%') != NULL;
+  if (!next_free
+      && !pad_index_parse (templ->name_template, spec, name, &idx)) {
+    GST_CAT_WARNING_OBJECT (GST_CAT_ELEMENT_PADS, element,
+        "pad name %s doesn't match template %s", name, templ->name_template);
+    return FALSE;
+  }
+
+  GST_OBJECT_LOCK (element);
+  set = pad_index_set_get (element, templ, TRUE);
+  if (next_free) {
+    idx = pad_index_set_find_free (set, set->next);
+  } else if (pad_index_set_contains (set, idx)) {
+    GST_OBJECT_UNLOCK (element);
+    GST_CAT_WARNING_OBJECT (GST_CAT_ELEMENT_PADS, element,
+        "pad index %u of template %s is in use", idx, templ->name_template);
+    return FALSE;
+  }
+  pad_index_set_add (set, idx);
+  if (idx >= set->next)
+    set->next = idx + 1;
+  GST_OBJECT_UNLOCK (element);
+
+  *index = idx;
+
+  return TRUE;
+}
+
+/**
+ * gst_element_release_pad_index:
+ * @element: a #GstElement
+ * @templ: the request #GstPadTemplate @index was claimed for
+ * @index: an index claimed with gst_element_claim_pad_index()
+ *
+ * Releases @index so that it can be claimed again for a new pad of @templ.
+ *
+ * MT safe.
+ *
+ * Since: 1.20
+ */
+void
+gst_element_release_pad_index (GstElement * element, GstPadTemplate * templ,
+    guint index)
+{
+  GstPadIndexSet *set;
+
+  g_return_if_fail (GST_IS_ELEMENT (element));
+  g_return_if_fail (GST_IS_PAD_TEMPLATE (templ));
+
+  GST_OBJECT_LOCK (element);
+  set = pad_index_set_get (element, templ, FALSE);
+  if (set && pad_index_set_contains (set, index))
+    set->used[index / PAD_INDEX_BITS] &= ~(1UL << (index % PAD_INDEX_BITS));
+  GST_OBJECT_UNLOCK (element);
+}
+
 static GstIterator *
 gst_element_iterate_pad_list (GstElement * element, GList ** padlist)
 {
   GstIterator *result;
 
   GST_OBJECT_LOCK (element);
-  result = gst_iterator_new_list (GST_TYPE_PAD,
-      GST_OBJECT_GET_LOCK (element),
-      &element->pads_cookie, padlist, (GObject *) element, NULL);
+  result = gst_iterator_new_list_snapshot (GST_TYPE_PAD, *padlist, NULL);
   GST_OBJECT_UNLOCK (element);
 
   return result;
@@ -1314,6 +1599,11 @@ gst_element_iterate_pad_list (GstElement * element, GList ** padlist)
  * The order of pads returned by the iterator will be the order in which
  * the pads were added to the element.
  *
+ * Since 1.20 the iterator works on a snapshot of the pads taken when it is
+ * created. It never returns %GST_ITERATOR_RESYNC and doesn't keep pads from
+ * being added or removed while iterating. This also applies to the more
+ * specialized iterators.
+ *
  * Returns: (transfer full): the #GstIterator of #GstPad.
  *
  * MT safe.
@@ -3451,8 +3741,14 @@ gst_element_finalize (GObject * object)
 {
   GstElement *element = GST_ELEMENT_CAST (object);
 
+  GstElementPrivate *priv = gst_element_get_instance_private (element);
+
   GST_CAT_INFO_OBJECT (GST_CAT_REFCOUNTING, element, "%p finalize", element);
 
+  if (priv->pads_by_name)
+    g_hash_table_unref (priv->pads_by_name);
+  g_slist_free_full (priv->pad_indices, (GDestroyNotify) pad_index_set_free);
+
   g_cond_clear (&element->state_cond);
   g_rec_mutex_clear (&element->state_lock);
 
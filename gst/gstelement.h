@@ -1050,6 +1050,13 @@ GstPad*                 gst_element_request_pad         (GstElement *element, Gs
 GST_API
 void                    gst_element_release_request_pad (GstElement *element, GstPad *pad);
 
+GST_API
+gboolean                gst_element_claim_pad_index     (GstElement *element, GstPadTemplate *templ,
+                                                         const gchar *name, guint *index);
+GST_API
+void                    gst_element_release_pad_index   (GstElement *element, GstPadTemplate *templ,
+                                                         guint index);
+
 GST_API
 GstIterator *           gst_element_iterate_pads        (GstElement * element);
 
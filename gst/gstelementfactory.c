@@ -150,6 +150,8 @@ gst_element_factory_cleanup (GstElementFactory * factory)
 {
   GList *item;
 
+  _priv_gst_registry_chunks_clear_element_factory_details (factory);
+
   if (factory->metadata) {
     gst_structure_free ((GstStructure *) factory->metadata);
     factory->metadata = NULL;
@@ -260,8 +262,8 @@ gst_element_register (GstPlugin * plugin, const gchar * name, guint rank,
     newt->name_template = g_intern_string (templ->name_template);
     newt->direction = templ->direction;
     newt->presence = templ->presence;
-    newt->static_caps.caps = NULL;
-    newt->static_caps.string = g_intern_string (caps_string);
+    _priv_gst_static_caps_init (&newt->static_caps,
+        g_intern_string (caps_string));
     factory->staticpadtemplates =
         g_list_append (factory->staticpadtemplates, newt);
 
@@ -327,6 +329,149 @@ detailserror:
   }
 }
 
+GType
+_priv_gst_element_factory_ensure_type (GstElementFactory * factory)
+{
+  GType type;
+
+  /* get_type functions are thread-safe and setting the qdata again is
+   * harmless, so two threads doing this at the same time is fine */
+  type = factory->get_type_func ();
+  g_type_set_qdata (type, __gst_elementclass_factory, factory);
+  factory->type = type;
+
+  GST_DEBUG_OBJECT (factory, "registered type %s", g_type_name (type));
+
+  return type;
+}
+
+static gboolean
+gst_element_factory_description_implements (const GstElementFactoryDescription
+    * desc, const gchar * interface_name)
+{
+  guint i;
+
+  for (i = 0; desc->interfaces && desc->interfaces[i]; i++) {
+    if (strcmp (desc->interfaces[i], interface_name) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * gst_element_register_description:
+ * @plugin: (allow-none): #GstPlugin to register the element with, or %NULL for
+ *     a static element.
+ * @desc: the description of the element factory
+ *
+ * Create a new elementfactory from the constant description @desc and add
+ * it to @plugin. Unlike gst_element_register(), this neither registers the
+ * element type nor initializes its class. Both happen when the first
+ * element is created or the type is requested with
+ * gst_element_factory_get_element_type().
+ *
+ * The descriptions are usually generated at build time for statically
+ * linked plugins, see `scripts/gst-gen-prelinked-registry.py`. @desc and
+ * everything it points to must stay valid for the lifetime of the process.
+ *
+ * Elements implementing #GstURIHandler need their class to know the
+ * supported protocols and are always registered with gst_element_register().
+ *
+ * Returns: %TRUE, if the registering succeeded, %FALSE on error
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_element_register_description (GstPlugin * plugin,
+    const GstElementFactoryDescription * desc)
+{
+  GstPluginFeature *existing_feature;
+  GstRegistry *registry;
+  GstElementFactory *factory;
+  GstStructure *metadata;
+  guint i;
+
+  g_return_val_if_fail (desc != NULL, FALSE);
+  g_return_val_if_fail (desc->name != NULL, FALSE);
+  g_return_val_if_fail (desc->get_type != NULL, FALSE);
+
+  if (gst_element_factory_description_implements (desc, "GstURIHandler"))
+    return gst_element_register (plugin, desc->name, desc->rank,
+        desc->get_type ());
+
+  if (desc->longname == NULL || desc->klass == NULL ||
+      desc->description == NULL || desc->author == NULL) {
+    g_warning ("Element factory description for '%s' is incomplete",
+        desc->name);
+    return FALSE;
+  }
+
+  registry = gst_registry_get ();
+
+  existing_feature = gst_registry_lookup_feature (registry, desc->name);
+  if (existing_feature && existing_feature->plugin == plugin) {
+    GST_DEBUG_OBJECT (registry, "update existing feature %p (%s)",
+        existing_feature, desc->name);
+    factory = GST_ELEMENT_FACTORY_CAST (existing_feature);
+    factory->get_type_func = desc->get_type;
+    existing_feature->loaded = TRUE;
+    gst_object_unref (existing_feature);
+    return TRUE;
+  } else if (existing_feature) {
+    gst_object_unref (existing_feature);
+  }
+
+  factory = g_object_new (GST_TYPE_ELEMENT_FACTORY, NULL);
+  gst_plugin_feature_set_name (GST_PLUGIN_FEATURE_CAST (factory), desc->name);
+  GST_LOG_OBJECT (factory, "Created new elementfactory from description");
+
+  factory->get_type_func = desc->get_type;
+
+  metadata = gst_structure_new_empty ("metadata");
+  gst_structure_set (metadata,
+      GST_ELEMENT_METADATA_LONGNAME, G_TYPE_STRING, desc->longname,
+      GST_ELEMENT_METADATA_KLASS, G_TYPE_STRING, desc->klass,
+      GST_ELEMENT_METADATA_DESCRIPTION, G_TYPE_STRING, desc->description,
+      GST_ELEMENT_METADATA_AUTHOR, G_TYPE_STRING, desc->author, NULL);
+  factory->metadata = metadata;
+
+  /* the strings of the description are static, the caps are only parsed
+   * when they're used */
+  for (i = 0; i < desc->n_pad_templates; i++) {
+    const GstStaticPadTemplate *templ = &desc->pad_templates[i];
+    GstStaticPadTemplate *newt;
+
+    newt = g_slice_new (GstStaticPadTemplate);
+    newt->name_template = g_intern_static_string (templ->name_template);
+    newt->direction = templ->direction;
+    newt->presence = templ->presence;
+    _priv_gst_static_caps_init (&newt->static_caps,
+        g_intern_static_string (templ->static_caps.string));
+    factory->staticpadtemplates =
+        g_list_append (factory->staticpadtemplates, newt);
+  }
+  factory->numpadtemplates = desc->n_pad_templates;
+
+  for (i = 0; desc->interfaces && desc->interfaces[i]; i++)
+    __gst_element_factory_add_interface (factory, desc->interfaces[i]);
+
+  if (plugin && plugin->desc.name) {
+    GST_PLUGIN_FEATURE_CAST (factory)->plugin_name = plugin->desc.name;
+    GST_PLUGIN_FEATURE_CAST (factory)->plugin = plugin;
+    g_object_add_weak_pointer ((GObject *) plugin,
+        (gpointer *) & GST_PLUGIN_FEATURE_CAST (factory)->plugin);
+  } else {
+    GST_PLUGIN_FEATURE_CAST (factory)->plugin_name = "NULL";
+    GST_PLUGIN_FEATURE_CAST (factory)->plugin = NULL;
+  }
+  gst_plugin_feature_set_rank (GST_PLUGIN_FEATURE_CAST (factory), desc->rank);
+  GST_PLUGIN_FEATURE_CAST (factory)->loaded = TRUE;
+
+  gst_registry_add_feature (registry, GST_PLUGIN_FEATURE_CAST (factory));
+
+  return TRUE;
+}
+
 static gboolean
 gst_element_factory_property_valist_to_array (const gchar * first,
     va_list properties, GType object_type, guint * n, const gchar ** names[],
@@ -397,6 +542,369 @@ cleanup:
   return FALSE;
 }
 
+/* Element pools, see gst_element_factory_set_pool_size().
+ *
+ * A pool keeps the property values of a freshly created element of the
+ * factory as prototype. Elements handed back with
+ * gst_element_factory_recycle() have their properties reset to those values
+ * and are then given out again instead of constructing a new instance. */
+typedef struct
+{
+  gint refcount;
+  guint max_size;
+  GQueue elements;
+
+  /* prototype state */
+  guint n_props;
+  GParamSpec **pspecs;
+  GValue *values;
+  guint32 flags;
+  guint16 numpads;
+} GstElementFactoryPool;
+
+static GMutex pools_lock;
+static GHashTable *pools;       /* GstElementFactory -> GstElementFactoryPool */
+static gint n_pools;
+
+static GstElementFactoryPool *
+gst_element_factory_pool_ref (GstElementFactoryPool * pool)
+{
+  g_atomic_int_inc (&pool->refcount);
+  return pool;
+}
+
+static void
+gst_element_factory_pool_unref (GstElementFactoryPool * pool)
+{
+  GstElement *element;
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&pool->refcount))
+    return;
+
+  while ((element = g_queue_pop_head (&pool->elements)))
+    gst_object_unref (element);
+
+  for (i = 0; i < pool->n_props; i++) {
+    g_param_spec_unref (pool->pspecs[i]);
+    g_value_unset (&pool->values[i]);
+  }
+  g_free (pool->pspecs);
+  g_free (pool->values);
+  g_free (pool);
+}
+
+static GstElementFactoryPool *
+gst_element_factory_pool_new (GstElement * prototype)
+{
+  GstElementFactoryPool *pool;
+  GParamSpec **pspecs;
+  guint i, n;
+
+  pool = g_new0 (GstElementFactoryPool, 1);
+  pool->refcount = 1;
+  g_queue_init (&pool->elements);
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (prototype), &n);
+  pool->pspecs = g_new (GParamSpec *, n);
+  pool->values = g_new0 (GValue, n);
+  for (i = 0; i < n; i++) {
+    GParamSpec *pspec = pspecs[i];
+
+    /* the name is given out on reuse and the parent is unset when the
+     * element is recycled */
+    if (pspec->owner_type == GST_TYPE_OBJECT)
+      continue;
+    if ((pspec->flags & G_PARAM_READWRITE) != G_PARAM_READWRITE ||
+        (pspec->flags & G_PARAM_CONSTRUCT_ONLY))
+      continue;
+
+    pool->pspecs[pool->n_props] = g_param_spec_ref (pspec);
+    g_value_init (&pool->values[pool->n_props], pspec->value_type);
+    g_object_get_property ((GObject *) prototype, pspec->name,
+        &pool->values[pool->n_props]);
+    pool->n_props++;
+  }
+  g_free (pspecs);
+
+  pool->flags = GST_OBJECT_FLAGS (prototype);
+  pool->numpads = prototype->numpads;
+
+  return pool;
+}
+
+/* Checks if @element is back in the state it had right after construction,
+ * apart from its properties. Called with the object lock of @element. */
+static gboolean
+gst_element_factory_pool_can_recycle (GstElementFactoryPool * pool,
+    GstElement * element)
+{
+  GList *l;
+
+  if (G_OBJECT (element)->ref_count != 1)
+    return FALSE;
+  if (GST_OBJECT_PARENT (element) != NULL)
+    return FALSE;
+  if (GST_STATE (element) != GST_STATE_NULL ||
+      GST_STATE_PENDING (element) != GST_STATE_VOID_PENDING)
+    return FALSE;
+  if (element->numpads != pool->numpads)
+    return FALSE;
+
+  for (l = element->pads; l; l = l->next) {
+    if (GST_PAD_PEER (l->data) != NULL)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static void
+gst_element_factory_pool_reset (GstElementFactoryPool * pool,
+    GstElement * element)
+{
+  GList *contexts;
+  guint i;
+
+  GST_OBJECT_LOCK (element);
+  GST_OBJECT_FLAGS (element) = pool->flags;
+  contexts = element->contexts;
+  element->contexts = NULL;
+  element->base_time = 0;
+  element->start_time = 0;
+  GST_OBJECT_UNLOCK (element);
+  g_list_free_full (contexts, (GDestroyNotify) gst_context_unref);
+
+  gst_element_set_clock (element, NULL);
+  gst_element_set_bus (element, NULL);
+
+  /* only set the properties that changed, setters might not be cheap */
+  for (i = 0; i < pool->n_props; i++) {
+    GParamSpec *pspec = pool->pspecs[i];
+    GValue value = G_VALUE_INIT;
+
+    g_value_init (&value, pspec->value_type);
+    g_object_get_property ((GObject *) element, pspec->name, &value);
+    if (g_param_values_cmp (pspec, &value, &pool->values[i]) != 0)
+      g_object_set_property ((GObject *) element, pspec->name,
+          &pool->values[i]);
+    g_value_unset (&value);
+  }
+}
+
+/* Takes an element out of the pool of @factory. Only done when the element
+ * would be constructed with no properties other than its name. */
+static GstElement *
+gst_element_factory_pool_acquire (GstElementFactory * factory, guint n,
+    const gchar * names[], const GValue values[])
+{
+  GstElementFactoryPool *pool;
+  GstElement *element = NULL;
+  const gchar *name = NULL;
+
+  if (n > 1)
+    return NULL;
+  if (n == 1) {
+    if (strcmp (names[0], "name") != 0 || !G_VALUE_HOLDS_STRING (&values[0]))
+      return NULL;
+    name = g_value_get_string (&values[0]);
+  }
+
+  g_mutex_lock (&pools_lock);
+  if (pools && (pool = g_hash_table_lookup (pools, factory)))
+    element = g_queue_pop_head (&pool->elements);
+  g_mutex_unlock (&pools_lock);
+
+  if (element == NULL)
+    return NULL;
+
+  gst_object_set_name (GST_OBJECT_CAST (element), name);
+  g_object_force_floating ((GObject *) element);
+
+  GST_DEBUG_OBJECT (factory, "reusing element %" GST_PTR_FORMAT, element);
+
+  return element;
+}
+
+/**
+ * gst_element_factory_set_pool_size:
+ * @factory: a #GstElementFactory
+ * @max_elements: maximum number of elements to keep around, or 0 to
+ *   disable the pool
+ *
+ * Enables recycling of elements of @factory. Up to @max_elements elements
+ * handed back with gst_element_factory_recycle() are kept around and given
+ * out again by gst_element_factory_create() and gst_element_factory_make()
+ * when no properties other than the name are requested, instead of
+ * constructing new instances.
+ *
+ * Before reuse, all writable properties of a recycled element are reset to
+ * the values a newly constructed element of @factory has. The element is
+ * only recycled when it can be assumed to be in a pristine state again, see
+ * gst_element_factory_recycle(). This is only suitable for elements that
+ * keep no other state across a change to the %GST_STATE_NULL state.
+ *
+ * Setting @max_elements to 0 disables the pool and frees all elements that
+ * were kept around.
+ *
+ * Returns: %TRUE if the pool could be configured, %FALSE if the factory
+ *   could not be loaded.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_element_factory_set_pool_size (GstElementFactory * factory,
+    guint max_elements)
+{
+  GstElementFactoryPool *pool, *old_pool = NULL;
+  GstElement *prototype = NULL;
+  GList *dropped = NULL;
+
+  g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), FALSE);
+
+  if (max_elements > 0) {
+    /* must happen before the pool is installed, the prototype has to be a
+     * newly constructed element */
+    prototype = gst_element_factory_create_with_properties (factory, 0, NULL,
+        NULL);
+    if (prototype == NULL)
+      return FALSE;
+    gst_object_ref_sink (prototype);
+  }
+
+  g_mutex_lock (&pools_lock);
+  if (pools == NULL)
+    pools = g_hash_table_new (NULL, NULL);
+
+  pool = g_hash_table_lookup (pools, factory);
+  if (max_elements == 0) {
+    if (pool) {
+      g_hash_table_remove (pools, factory);
+      g_atomic_int_add (&n_pools, -1);
+      old_pool = pool;
+    }
+  } else if (pool) {
+    pool->max_size = max_elements;
+    g_queue_push_tail (&pool->elements, prototype);
+    prototype = NULL;
+    while (pool->elements.length > max_elements)
+      dropped = g_list_prepend (dropped, g_queue_pop_tail (&pool->elements));
+  } else {
+    pool = gst_element_factory_pool_new (prototype);
+    pool->max_size = max_elements;
+    g_queue_push_tail (&pool->elements, prototype);
+    prototype = NULL;
+    g_hash_table_insert (pools, gst_object_ref (factory), pool);
+    g_atomic_int_add (&n_pools, 1);
+  }
+  g_mutex_unlock (&pools_lock);
+
+  if (prototype)
+    gst_object_unref (prototype);
+  g_list_free_full (dropped, gst_object_unref);
+  if (old_pool) {
+    gst_element_factory_pool_unref (old_pool);
+    gst_object_unref (factory);
+  }
+
+  GST_DEBUG_OBJECT (factory, "pool size set to %u", max_elements);
+
+  return TRUE;
+}
+
+/**
+ * gst_element_factory_recycle:
+ * @element: (transfer full): a #GstElement
+ *
+ * Hands @element back to the pool of its factory, see
+ * gst_element_factory_set_pool_size(). If the factory has no pool, the pool
+ * is full or @element can't be recycled, @element is unreffed.
+ *
+ * @element is only recycled if the caller owns the only reference to it, it
+ * is in the %GST_STATE_NULL state, has no parent, has the same number of
+ * pads as a newly constructed element and none of them are linked. Signal
+ * handlers and pad probes installed by the application must be removed
+ * before calling this function.
+ *
+ * Since: 1.20
+ */
+void
+gst_element_factory_recycle (GstElement * element)
+{
+  GstElementFactory *factory;
+  GstElementFactoryPool *pool = NULL;
+  gboolean recycled = FALSE;
+
+  g_return_if_fail (GST_IS_ELEMENT (element));
+
+  factory = gst_element_get_factory (element);
+  if (factory == NULL || g_atomic_int_get (&n_pools) == 0)
+    goto drop;
+
+  g_mutex_lock (&pools_lock);
+  if (pools)
+    pool = g_hash_table_lookup (pools, factory);
+  if (pool && pool->elements.length < pool->max_size) {
+    GST_OBJECT_LOCK (element);
+    if (gst_element_factory_pool_can_recycle (pool, element))
+      gst_element_factory_pool_ref (pool);
+    else
+      pool = NULL;
+    GST_OBJECT_UNLOCK (element);
+  } else {
+    pool = NULL;
+  }
+  g_mutex_unlock (&pools_lock);
+
+  if (pool == NULL)
+    goto drop;
+
+  /* property setters can do anything, including creating elements, so this
+   * is done without the lock. The pool might get replaced in the meantime */
+  gst_element_factory_pool_reset (pool, element);
+
+  g_mutex_lock (&pools_lock);
+  if (pools && g_hash_table_lookup (pools, factory) == pool &&
+      pool->elements.length < pool->max_size) {
+    g_queue_push_tail (&pool->elements, element);
+    recycled = TRUE;
+  }
+  g_mutex_unlock (&pools_lock);
+  gst_element_factory_pool_unref (pool);
+
+  if (recycled) {
+    GST_LOG_OBJECT (factory, "recycled element");
+    return;
+  }
+
+drop:
+  gst_object_unref (element);
+}
+
+void
+_priv_gst_element_factory_pools_cleanup (void)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GHashTable *old_pools;
+
+  g_mutex_lock (&pools_lock);
+  old_pools = pools;
+  pools = NULL;
+  g_atomic_int_set (&n_pools, 0);
+  g_mutex_unlock (&pools_lock);
+
+  if (old_pools == NULL)
+    return;
+
+  g_hash_table_iter_init (&iter, old_pools);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    gst_element_factory_pool_unref (value);
+    gst_object_unref (key);
+  }
+  g_hash_table_unref (old_pools);
+}
+
 /**
  * gst_element_factory_create_with_properties:
  * @factory: factory to instantiate
@@ -433,9 +941,17 @@ gst_element_factory_create_with_properties (GstElementFactory * factory,
 
   GST_INFO ("creating element \"%s\"", GST_OBJECT_NAME (factory));
 
-  if (factory->type == 0)
+  if (GST_ELEMENT_FACTORY_ENSURE_TYPE (factory) == 0)
     goto no_type;
 
+  if (G_UNLIKELY (g_atomic_int_get (&n_pools) > 0)) {
+    element = gst_element_factory_pool_acquire (factory, n, names, values);
+    if (element) {
+      gst_object_unref (factory);
+      return element;
+    }
+  }
+
   element = (GstElement *) g_object_new_with_properties (factory->type, n,
       names, values);
 
@@ -519,7 +1035,8 @@ gst_element_factory_create_valist (GstElementFactory * factory,
           (factory)));
 
   g_return_val_if_fail (newfactory != NULL, NULL);
-  g_return_val_if_fail (newfactory->type != 0, NULL);
+  g_return_val_if_fail (GST_ELEMENT_FACTORY_ENSURE_TYPE (newfactory) != 0,
+      NULL);
 
   factory = newfactory;
 
@@ -788,7 +1305,7 @@ gst_element_factory_get_element_type (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), 0);
 
-  return factory->type;
+  return GST_ELEMENT_FACTORY_ENSURE_TYPE (factory);
 }
 
 /**
@@ -807,6 +1324,8 @@ gst_element_factory_get_metadata (GstElementFactory * factory,
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   return gst_structure_get_string ((GstStructure *) factory->metadata, key);
 }
 
@@ -829,6 +1348,8 @@ gst_element_factory_get_metadata_keys (GstElementFactory * factory)
 
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   metadata = (GstStructure *) factory->metadata;
   if (metadata == NULL)
     return NULL;
@@ -858,6 +1379,8 @@ gst_element_factory_get_num_pad_templates (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), 0);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   return factory->numpadtemplates;
 }
 
@@ -896,6 +1419,8 @@ gst_element_factory_get_static_pad_templates (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   return factory->staticpadtemplates;
 }
 
@@ -912,6 +1437,8 @@ gst_element_factory_get_uri_type (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), GST_URI_UNKNOWN);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   return factory->uri_type;
 }
 
@@ -932,6 +1459,8 @@ gst_element_factory_get_uri_protocols (GstElementFactory * factory)
 {
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   return (const gchar * const *) factory->uri_protocols;
 }
 
@@ -952,6 +1481,8 @@ gst_element_factory_has_interface (GstElementFactory * factory,
 
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), FALSE);
 
+  GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
+
   for (walk = factory->interfaces; walk; walk = g_list_next (walk)) {
     gchar *iname = (gchar *) walk->data;
 
@@ -962,117 +1493,96 @@ gst_element_factory_has_interface (GstElementFactory * factory,
 }
 
 
-typedef struct
-{
-  GstElementFactoryListType type;
-  GstRank minrank;
-} FilterData;
+#define ELEMENT_TYPES (GST_ELEMENT_FACTORY_TYPE_MAX_ELEMENTS - 1)
+#define MEDIA_TYPES (GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO | \
+    GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO | \
+    GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE | \
+    GST_ELEMENT_FACTORY_TYPE_MEDIA_SUBTITLE | \
+    GST_ELEMENT_FACTORY_TYPE_MEDIA_METADATA)
 
-
-/**
- * gst_element_factory_list_is_type:
- * @factory: a #GstElementFactory
- * @type: a #GstElementFactoryListType
- *
- * Check if @factory is of the given types.
- *
- * Returns: %TRUE if @factory is of @type.
- */
-gboolean
-gst_element_factory_list_is_type (GstElementFactory * factory,
-    GstElementFactoryListType type)
+GstElementFactoryListType
+_priv_gst_element_factory_get_type_mask (GstElementFactory * factory)
 {
-  gboolean res = FALSE;
+  static const struct
+  {
+    GstElementFactoryListType type;
+    const gchar *klass;
+  } klasses[] = {
+    {GST_ELEMENT_FACTORY_TYPE_SINK, "Sink"},
+    {GST_ELEMENT_FACTORY_TYPE_SRC, "Source"},
+    {GST_ELEMENT_FACTORY_TYPE_DECODER, "Decoder"},
+    {GST_ELEMENT_FACTORY_TYPE_ENCODER, "Encoder"},
+    {GST_ELEMENT_FACTORY_TYPE_MUXER, "Muxer"},
+    {GST_ELEMENT_FACTORY_TYPE_DEMUXER, "Demux"},
+    {GST_ELEMENT_FACTORY_TYPE_DEPAYLOADER, "Depayloader"},
+    {GST_ELEMENT_FACTORY_TYPE_PAYLOADER, "Payloader"},
+    {GST_ELEMENT_FACTORY_TYPE_FORMATTER, "Formatter"},
+    {GST_ELEMENT_FACTORY_TYPE_DECRYPTOR, "Decryptor"},
+    {GST_ELEMENT_FACTORY_TYPE_ENCRYPTOR, "Encryptor"},
+    {GST_ELEMENT_FACTORY_TYPE_HARDWARE, "Hardware"},
+    {GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO, "Audio"},
+    {GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, "Video"},
+    {GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE, "Image"},
+    {GST_ELEMENT_FACTORY_TYPE_MEDIA_SUBTITLE, "Subtitle"},
+    {GST_ELEMENT_FACTORY_TYPE_MEDIA_METADATA, "Metadata"},
+  };
+  GstElementFactoryListType mask = 0;
   const gchar *klass;
+  guint i;
 
   klass =
       gst_element_factory_get_metadata (factory, GST_ELEMENT_METADATA_KLASS);
 
   if (klass == NULL) {
     GST_ERROR_OBJECT (factory, "element factory is missing klass identifiers");
-    return res;
+    return 0;
   }
 
-  /* Filter by element type first, as soon as it matches
-   * one type, we skip all other tests */
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_SINK))
-    res = (strstr (klass, "Sink") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_SRC))
-    res = (strstr (klass, "Source") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_DECODER))
-    res = (strstr (klass, "Decoder") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_ENCODER))
-    res = (strstr (klass, "Encoder") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_MUXER))
-    res = (strstr (klass, "Muxer") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_DEMUXER))
-    res = (strstr (klass, "Demux") != NULL);
+  for (i = 0; i < G_N_ELEMENTS (klasses); i++) {
+    if (strstr (klass, klasses[i].klass) != NULL)
+      mask |= klasses[i].type;
+  }
 
   /* FIXME : We're actually parsing two Classes here... */
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_PARSER))
-    res = ((strstr (klass, "Parser") != NULL)
-        && (strstr (klass, "Codec") != NULL));
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_DEPAYLOADER))
-    res = (strstr (klass, "Depayloader") != NULL);
+  if ((strstr (klass, "Parser") != NULL) && (strstr (klass, "Codec") != NULL))
+    mask |= GST_ELEMENT_FACTORY_TYPE_PARSER;
 
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_PAYLOADER))
-    res = (strstr (klass, "Payloader") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_FORMATTER))
-    res = (strstr (klass, "Formatter") != NULL);
-
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_DECRYPTOR))
-    res = (strstr (klass, "Decryptor") != NULL);
+  return mask;
+}
 
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_ENCRYPTOR))
-    res = (strstr (klass, "Encryptor") != NULL);
+gboolean
+_priv_gst_element_factory_type_mask_matches (GstElementFactoryListType mask,
+    GstElementFactoryListType type)
+{
+  gboolean res;
 
-  if (!res && (type & GST_ELEMENT_FACTORY_TYPE_HARDWARE))
-    res = (strstr (klass, "Hardware") != NULL);
+  /* Filter by element type first, it's enough if one type matches */
+  res = (mask & type & ELEMENT_TYPES) != 0;
 
   /* Filter by media type now, we only test if it
    * matched any of the types above or only checking the media
    * type was requested. */
-  if ((res || !(type & (GST_ELEMENT_FACTORY_TYPE_MAX_ELEMENTS - 1)))
-      && (type & (GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO |
-              GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO |
-              GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE |
-              GST_ELEMENT_FACTORY_TYPE_MEDIA_SUBTITLE |
-              GST_ELEMENT_FACTORY_TYPE_MEDIA_METADATA)))
-    res = ((type & GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO)
-        && (strstr (klass, "Audio") != NULL))
-        || ((type & GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO)
-        && (strstr (klass, "Video") != NULL))
-        || ((type & GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE)
-        && (strstr (klass, "Image") != NULL)) ||
-        ((type & GST_ELEMENT_FACTORY_TYPE_MEDIA_SUBTITLE)
-        && (strstr (klass, "Subtitle") != NULL)) ||
-        ((type & GST_ELEMENT_FACTORY_TYPE_MEDIA_METADATA)
-        && (strstr (klass, "Metadata") != NULL));
+  if ((res || !(type & ELEMENT_TYPES)) && (type & MEDIA_TYPES))
+    res = (mask & type & MEDIA_TYPES) != 0;
 
   return res;
 }
 
-static gboolean
-element_filter (GstPluginFeature * feature, FilterData * data)
+/**
+ * gst_element_factory_list_is_type:
+ * @factory: a #GstElementFactory
+ * @type: a #GstElementFactoryListType
+ *
+ * Check if @factory is of the given types.
+ *
+ * Returns: %TRUE if @factory is of @type.
+ */
+gboolean
+gst_element_factory_list_is_type (GstElementFactory * factory,
+    GstElementFactoryListType type)
 {
-  gboolean res;
-
-  /* we only care about element factories */
-  if (G_UNLIKELY (!GST_IS_ELEMENT_FACTORY (feature)))
-    return FALSE;
-
-  res = (gst_plugin_feature_get_rank (feature) >= data->minrank) &&
-      gst_element_factory_list_is_type (GST_ELEMENT_FACTORY_CAST (feature),
-      data->type);
-
-  return res;
+  return _priv_gst_element_factory_type_mask_matches
+      (_priv_gst_element_factory_get_type_mask (factory), type);
 }
 
 /**
@@ -1093,15 +1603,10 @@ gst_element_factory_list_get_elements (GstElementFactoryListType type,
     GstRank minrank)
 {
   GList *result;
-  FilterData data;
 
-  /* prepare type */
-  data.type = type;
-  data.minrank = minrank;
-
-  /* get the feature list using the filter */
-  result = gst_registry_feature_filter (gst_registry_get (),
-      (GstPluginFeatureFilter) element_filter, FALSE, &data);
+  /* get the matching factories from the registry's index */
+  result = _priv_gst_registry_get_element_factories_by_type (gst_registry_get
+      (), type, minrank);
 
   /* sort on rank and name */
   result = g_list_sort (result, gst_plugin_feature_rank_compare_func);
@@ -1133,9 +1638,15 @@ gst_element_factory_list_filter (GList * list,
     const GstCaps * caps, GstPadDirection direction, gboolean subsetonly)
 {
   GQueue results = G_QUEUE_INIT;
+  GstRegistryFactoryIndex *index = NULL;
 
   GST_DEBUG ("finding factories");
 
+  /* factories that have no template for any of the media types can be
+   * skipped without looking at their templates */
+  if (list && !gst_caps_is_any (caps) && !gst_caps_is_empty (caps))
+    index = _priv_gst_registry_get_media_type_index (gst_registry_get ());
+
   /* loop over all the factories */
   for (; list; list = list->next) {
     GstElementFactory *factory;
@@ -1144,6 +1655,10 @@ gst_element_factory_list_filter (GList * list,
 
     factory = (GstElementFactory *) list->data;
 
+    if (index && !_priv_gst_registry_media_type_index_may_match (index,
+            factory, caps, direction))
+      continue;
+
     GST_DEBUG ("Trying %s",
         gst_plugin_feature_get_name ((GstPluginFeature *) factory));
 
@@ -1174,5 +1689,9 @@ gst_element_factory_list_filter (GList * list,
       }
     }
   }
+
+  if (index)
+    _priv_gst_registry_factory_index_unref (index);
+
   return results.head;
 }
@@ -108,6 +108,56 @@ GST_API
 gboolean                gst_element_register                    (GstPlugin *plugin, const gchar *name,
                                                                  guint rank, GType type);
 
+/**
+ * GstElementFactoryDescription:
+ * @name: name of elements of this type
+ * @rank: rank of the element factory
+ * @get_type: function returning the #GType of the element
+ * @longname: long, english name of the element
+ * @klass: string describing the type of element, see
+ *   gst_element_class_set_metadata()
+ * @description: sentence describing the purpose of the element
+ * @author: name and contact details of the author(s)
+ * @pad_templates: (array length=n_pad_templates): the pad templates of the
+ *   element class
+ * @n_pad_templates: number of entries in @pad_templates
+ * @interfaces: (array zero-terminated=1) (nullable): names of the interfaces
+ *   implemented by the element
+ *
+ * Constant description of an element factory, used with
+ * gst_element_register_description().
+ *
+ * Since: 1.20
+ */
+typedef struct {
+  const gchar                 *name;
+  guint                        rank;
+  GType                      (*get_type) (void);
+
+  const gchar                 *longname;
+  const gchar                 *klass;
+  const gchar                 *description;
+  const gchar                 *author;
+
+  const GstStaticPadTemplate  *pad_templates;
+  guint                        n_pad_templates;
+
+  const gchar * const         *interfaces;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+} GstElementFactoryDescription;
+
+GST_API
+gboolean                gst_element_register_description        (GstPlugin *plugin,
+                                                                 const GstElementFactoryDescription *desc);
+
+GST_API
+gboolean                gst_element_factory_set_pool_size       (GstElementFactory *factory,
+                                                                 guint max_elements);
+GST_API
+void                    gst_element_factory_recycle             (GstElement *element);
+
 /* Factory list functions */
 
 /**
@@ -81,6 +81,7 @@
 #include "gstutils.h"
 #include "gstquark.h"
 #include "gstvalue.h"
+#include "gstslicecache.h"
 
 GType _gst_event_type = 0;
 
@@ -234,7 +235,7 @@ _gst_event_free (GstEvent * event)
   memset (event, 0xff, sizeof (GstEventImpl));
 #endif
 
-  g_slice_free1 (sizeof (GstEventImpl), event);
+  _priv_gst_slice_cache_free (sizeof (GstEventImpl), event);
 }
 
 static void gst_event_init (GstEventImpl * event, GstEventType type);
@@ -245,7 +246,7 @@ _gst_event_copy (GstEvent * event)
   GstEventImpl *copy;
   GstStructure *s;
 
-  copy = g_slice_new0 (GstEventImpl);
+  copy = _priv_gst_slice_cache_alloc0 (sizeof (GstEventImpl));
 
   gst_event_init (copy, GST_EVENT_TYPE (event));
 
@@ -305,7 +306,7 @@ gst_event_new_custom (GstEventType type, GstStructure * structure)
 {
   GstEventImpl *event;
 
-  event = g_slice_new0 (GstEventImpl);
+  event = _priv_gst_slice_cache_alloc0 (sizeof (GstEventImpl));
 
   GST_CAT_DEBUG (GST_CAT_EVENT, "creating new event %p %s %d", event,
       gst_event_type_get_name (type), type);
@@ -326,7 +327,7 @@ gst_event_new_custom (GstEventType type, GstStructure * structure)
   /* ERRORS */
 had_parent:
   {
-    g_slice_free1 (sizeof (GstEventImpl), event);
+    _priv_gst_slice_cache_free (sizeof (GstEventImpl), event);
     g_warning ("structure is already owned by another object");
     return NULL;
   }
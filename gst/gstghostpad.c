@@ -228,6 +228,14 @@ gst_proxy_pad_get_internal (GstProxyPad * pad)
   return GST_PROXY_PAD_CAST (internal);
 }
 
+GstPad *
+_priv_gst_proxy_pad_get_internal_unlocked (GstPad * pad)
+{
+  g_return_val_if_fail (GST_IS_PROXY_PAD (pad), NULL);
+
+  return GST_PROXY_PAD_INTERNAL (pad);
+}
+
 static void
 gst_proxy_pad_class_init (GstProxyPadClass * klass)
 {
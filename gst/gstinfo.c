@@ -290,21 +290,28 @@ struct _GstDebugMessage
   va_list arguments;
 };
 
-/* list of all name/level pairs from --gst-debug and GST_DEBUG */
+/* list of all name/level pairs from --gst-debug and GST_DEBUG, newest first */
 static GMutex __level_name_mutex;
 static GSList *__level_name = NULL;
 typedef struct
 {
   GPatternSpec *pat;
   GstDebugLevel level;
+  /* the category name if the pattern has no wildcards */
+  gchar *name;
 }
 LevelNameEntry;
+/* the newest entry of __level_name for a name without wildcards */
+static GHashTable *__level_name_exact = NULL;
 
 /* list of all categories */
 static GMutex __cat_mutex;
 static GSList *__categories = NULL;
+static GHashTable *__categories_by_name = NULL;
 
 static GstDebugCategory *_gst_debug_get_category_locked (const gchar * name);
+static void gst_deferred_logger_add (guint max_size_per_thread,
+    FILE * dump_file);
 
 
 /* all registered debug handlers */
@@ -361,6 +368,7 @@ _priv_gst_debug_init (void)
 {
   const gchar *env;
   FILE *log_file;
+  guint64 deferred_size = 0;
 
   if (add_default_log_func) {
     env = g_getenv ("GST_DEBUG_FILE");
@@ -381,7 +389,14 @@ _priv_gst_debug_init (void)
       log_file = stderr;
     }
 
-    gst_debug_add_log_function (gst_debug_log_default, log_file, NULL);
+    env = g_getenv ("GST_DEBUG_DEFERRED_LOG");
+    if (env != NULL && *env != '\0')
+      deferred_size = g_ascii_strtoull (env, NULL, 10);
+
+    if (deferred_size > 0 && deferred_size <= G_MAXUINT)
+      gst_deferred_logger_add (deferred_size, log_file);
+    else
+      gst_debug_add_log_function (gst_debug_log_default, log_file, NULL);
   }
 
   __gst_printf_pointer_extension_set_func
@@ -1723,15 +1738,27 @@ static void
 gst_debug_reset_threshold (gpointer category, gpointer unused)
 {
   GstDebugCategory *cat = (GstDebugCategory *) category;
+  LevelNameEntry *exact = NULL;
   GSList *walk;
 
   g_mutex_lock (&__level_name_mutex);
 
+  if (__level_name_exact)
+    exact = g_hash_table_lookup (__level_name_exact, cat->name);
+
+  /* only the patterns with wildcards that are newer than the exact match
+   * need to be checked */
   for (walk = __level_name; walk != NULL; walk = walk->next) {
-    if (gst_debug_apply_entry (cat, walk->data))
+    LevelNameEntry *entry = walk->data;
+
+    if (entry == exact || (entry->name == NULL
+            && gst_debug_apply_entry (cat, entry)))
       break;
   }
 
+  if (walk != NULL && walk->data == exact)
+    gst_debug_apply_entry (cat, exact);
+
   g_mutex_unlock (&__level_name_mutex);
 
   if (walk == NULL)
@@ -1775,11 +1802,28 @@ gst_debug_set_threshold_for_name (const gchar * name, GstDebugLevel level)
   entry = g_slice_new (LevelNameEntry);
   entry->pat = pat;
   entry->level = level;
+  entry->name = NULL;
+  if (strpbrk (name, "*?") == NULL)
+    entry->name = g_strdup (name);
+
   g_mutex_lock (&__level_name_mutex);
   __level_name = g_slist_prepend (__level_name, entry);
+  if (entry->name) {
+    if (__level_name_exact == NULL)
+      __level_name_exact = g_hash_table_new (g_str_hash, g_str_equal);
+    g_hash_table_replace (__level_name_exact, entry->name, entry);
+  }
   g_mutex_unlock (&__level_name_mutex);
+
   g_mutex_lock (&__cat_mutex);
-  g_slist_foreach (__categories, for_each_threshold_by_entry, entry);
+  if (entry->name) {
+    GstDebugCategory *cat = _gst_debug_get_category_locked (entry->name);
+
+    if (cat)
+      gst_debug_apply_entry (cat, entry);
+  } else {
+    g_slist_foreach (__categories, for_each_threshold_by_entry, entry);
+  }
   g_mutex_unlock (&__cat_mutex);
 }
 
@@ -1806,7 +1850,11 @@ gst_debug_unset_threshold_for_name (const gchar * name)
 
     if (g_pattern_spec_equal (entry->pat, pat)) {
       __level_name = g_slist_remove_link (__level_name, walk);
+      /* all entries with this name go, so there's no older one to restore */
+      if (entry->name)
+        g_hash_table_remove (__level_name_exact, entry->name);
       g_pattern_spec_free (entry->pat);
+      g_free (entry->name);
       g_slice_free (LevelNameEntry, entry);
       g_slist_free_1 (walk);
       walk = __level_name;
@@ -1827,6 +1875,15 @@ _gst_debug_category_new (const gchar * name, guint color,
 
   g_return_val_if_fail (name != NULL, NULL);
 
+  /* plugins register the same categories again whenever they are loaded, so
+   * check for an existing one first */
+  g_mutex_lock (&__cat_mutex);
+  catfound = _gst_debug_get_category_locked (name);
+  if (catfound) {
+    g_mutex_unlock (&__cat_mutex);
+    return catfound;
+  }
+
   cat = g_slice_new (GstDebugCategory);
   cat->name = g_strdup (name);
   cat->color = color;
@@ -1839,16 +1896,10 @@ _gst_debug_category_new (const gchar * name, guint color,
   gst_debug_reset_threshold (cat, NULL);
 
   /* add to category list */
-  g_mutex_lock (&__cat_mutex);
-  catfound = _gst_debug_get_category_locked (name);
-  if (catfound) {
-    g_free ((gpointer) cat->name);
-    g_free ((gpointer) cat->description);
-    g_slice_free (GstDebugCategory, cat);
-    cat = catfound;
-  } else {
-    __categories = g_slist_prepend (__categories, cat);
-  }
+  __categories = g_slist_prepend (__categories, cat);
+  if (__categories_by_name == NULL)
+    __categories_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (__categories_by_name, (gpointer) cat->name, cat);
   g_mutex_unlock (&__cat_mutex);
 
   return cat;
@@ -1993,16 +2044,10 @@ gst_debug_get_all_categories (void)
 static GstDebugCategory *
 _gst_debug_get_category_locked (const gchar * name)
 {
-  GstDebugCategory *ret = NULL;
-  GSList *node;
+  if (__categories_by_name == NULL)
+    return NULL;
 
-  for (node = __categories; node; node = g_slist_next (node)) {
-    ret = (GstDebugCategory *) node->data;
-    if (!strcmp (name, ret->name)) {
-      return ret;
-    }
-  }
-  return NULL;
+  return g_hash_table_lookup (__categories_by_name, name);
 }
 
 GstDebugCategory *
@@ -2201,6 +2246,9 @@ _gst_debug_register_funcptr (GstDebugFuncPtr func, const gchar * ptrname)
 void
 _priv_gst_debug_cleanup (void)
 {
+  /* the deferred logs refer to the categories, so write them out first */
+  gst_debug_remove_deferred_logger ();
+
   g_mutex_lock (&__dbg_functions_mutex);
 
   if (__gst_function_pointers) {
@@ -2211,6 +2259,10 @@ _priv_gst_debug_cleanup (void)
   g_mutex_unlock (&__dbg_functions_mutex);
 
   g_mutex_lock (&__cat_mutex);
+  if (__categories_by_name) {
+    g_hash_table_unref (__categories_by_name);
+    __categories_by_name = NULL;
+  }
   while (__categories) {
     GstDebugCategory *cat = __categories->data;
     g_free ((gpointer) cat->name);
@@ -2224,9 +2276,14 @@ _priv_gst_debug_cleanup (void)
   while (__level_name) {
     LevelNameEntry *level_name_entry = __level_name->data;
     g_pattern_spec_free (level_name_entry->pat);
+    g_free (level_name_entry->name);
     g_slice_free (LevelNameEntry, level_name_entry);
     __level_name = g_slist_delete_link (__level_name, __level_name);
   }
+  if (__level_name_exact) {
+    g_hash_table_unref (__level_name_exact);
+    __level_name_exact = NULL;
+  }
   g_mutex_unlock (&__level_name_mutex);
 
   g_mutex_lock (&__log_func_mutex);
@@ -3162,6 +3219,166 @@ gst_debug_get_stack_trace (GstStackTraceFlags flags)
   return NULL;
 }
 
+/**
+ * gst_debug_get_stack_addresses:
+ * @addresses: (out caller-allocates) (array length=n_addresses): the
+ *   return addresses of the stack frames
+ * @n_addresses: the size of @addresses
+ *
+ * Retrieves the return addresses of the current stack frames, innermost
+ * first and starting with the caller of this function, without resolving
+ * any symbols. This is much cheaper than gst_debug_get_stack_trace(), the
+ * addresses can be symbolized later with
+ * gst_debug_symbolize_stack_addresses() while the code they point to is
+ * still loaded.
+ *
+ * Returns: the number of frames stored in @addresses, 0 if the stack can't
+ * be walked on this platform.
+ *
+ * Since: 1.20
+ */
+guint
+gst_debug_get_stack_addresses (gpointer * addresses, guint n_addresses)
+{
+  guint n = 0;
+
+  g_return_val_if_fail (addresses != NULL || n_addresses == 0, 0);
+
+#ifdef HAVE_UNWIND
+  {
+    unw_context_t uc;
+    unw_cursor_t cursor;
+
+    if (unw_getcontext (&uc) || unw_init_local (&cursor, &uc))
+      return 0;
+
+    /* unw_step() first moves to the caller */
+    while (n < n_addresses && unw_step (&cursor) > 0) {
+      unw_word_t ip;
+
+      if (unw_get_reg (&cursor, UNW_REG_IP, &ip))
+        break;
+      addresses[n++] = (gpointer) ip;
+    }
+  }
+#elif defined (HAVE_BACKTRACE)
+  {
+    void *buffer[BT_BUF_SIZE];
+    gint nptrs = backtrace (buffer, BT_BUF_SIZE);
+
+    /* skip this function */
+    if (nptrs > 1) {
+      n = MIN ((guint) nptrs - 1, n_addresses);
+      memcpy (addresses, buffer + 1, n * sizeof (gpointer));
+    }
+  }
+#elif defined (HAVE_DBGHELP)
+  n = RtlCaptureStackBackTrace (1, MIN (n_addresses, 62), addresses, NULL);
+#endif
+
+  return n;
+}
+
+/**
+ * gst_debug_symbolize_stack_addresses:
+ * @addresses: (array length=n_addresses): return addresses as retrieved
+ *   with gst_debug_get_stack_addresses()
+ * @n_addresses: the number of addresses
+ * @flags: A set of #GstStackTraceFlags, #GST_STACK_TRACE_SHOW_FULL to look
+ *   up the source information
+ *
+ * Resolves @addresses to a stack trace formatted like the ones returned by
+ * gst_debug_get_stack_trace().
+ *
+ * Returns: (nullable): a stack trace, %NULL if @n_addresses is 0.
+ *
+ * Since: 1.20
+ */
+gchar *
+gst_debug_symbolize_stack_addresses (gpointer const *addresses,
+    guint n_addresses, GstStackTraceFlags flags)
+{
+  GString *trace;
+  guint i;
+
+  if (n_addresses == 0)
+    return NULL;
+
+  trace = g_string_new (NULL);
+
+#if defined (HAVE_UNWIND) && defined (HAVE_DW)
+  if ((flags & GST_STACK_TRACE_SHOW_FULL)) {
+    Dwfl *dwfl = get_global_dwfl ();
+
+    if (dwfl) {
+      GST_DWFL_LOCK ();
+      if (dwfl_linux_proc_report (dwfl, getpid ()) == 0) {
+        /* a return address points after the call */
+        for (i = 0; i < n_addresses; i++) {
+          append_debug_info (trace, dwfl,
+              (const guint8 *) addresses[i] - 1);
+          g_string_append (trace, ")\n");
+        }
+      }
+      GST_DWFL_UNLOCK ();
+      if (trace->len > 0)
+        return g_string_free (trace, FALSE);
+    }
+  }
+#endif
+
+#ifdef HAVE_BACKTRACE
+  {
+    char **strings = backtrace_symbols ((void *const *) addresses,
+        n_addresses);
+
+    if (strings) {
+      for (i = 0; i < n_addresses; i++)
+        g_string_append_printf (trace, "%s\n", strings[i]);
+      free (strings);
+      return g_string_free (trace, FALSE);
+    }
+  }
+#elif defined (HAVE_DBGHELP)
+  {
+    HANDLE process = GetCurrentProcess ();
+
+    if (dbghelp_initialize_symbols (process)) {
+      for (i = 0; i < n_addresses; i++) {
+        char buffer[sizeof (SYMBOL_INFO) + MAX_SYM_NAME * sizeof (TCHAR)];
+        PSYMBOL_INFO symbol = (PSYMBOL_INFO) buffer;
+        IMAGEHLP_LINE64 line;
+        DWORD displacement = 0;
+        DWORD64 addr = (DWORD64) (guintptr) addresses[i];
+
+        symbol->SizeOfStruct = sizeof (SYMBOL_INFO);
+        symbol->MaxNameLen = MAX_SYM_NAME;
+        line.SizeOfStruct = sizeof (line);
+
+        if (dbg_help_vtable.pSymFromAddr (process, addr, 0, symbol))
+          g_string_append_printf (trace, "%s ", symbol->Name);
+        else
+          g_string_append (trace, "?? ");
+
+        if ((flags & GST_STACK_TRACE_SHOW_FULL) &&
+            dbg_help_vtable.pSymGetLineFromAddr64 (process, addr,
+                &displacement, &line))
+          g_string_append_printf (trace, "(%s:%lu)\n", line.FileName,
+              line.LineNumber);
+        else
+          g_string_append_printf (trace, "(%p)\n", addresses[i]);
+      }
+      return g_string_free (trace, FALSE);
+    }
+  }
+#endif
+
+  for (i = 0; i < n_addresses; i++)
+    g_string_append_printf (trace, "?? (%p)\n", addresses[i]);
+
+  return g_string_free (trace, FALSE);
+}
+
 /**
  * gst_debug_print_stack_trace:
  *
@@ -3189,27 +3406,212 @@ gst_debug_print_stack_trace (void)
 }
 
 #ifndef GST_DISABLE_GST_DEBUG
+/* Fixed size ring buffer of variable sized records that each start with
+ * their size as guint32. Records never wrap around the end of the buffer, a
+ * record with size 0 marks that the next one is at the start. */
+typedef struct
+{
+  guint8 *data;
+  gsize allocated;
+  gsize head, tail;
+  guint n_records;
+  gboolean wrapped;
+} GstLogRing;
+
+#define GST_LOG_RING_AT(ring,pos) ((gpointer) ((ring)->data + (pos)))
+#define GST_LOG_RING_SIZE_AT(ring,pos) (*(guint32 *) GST_LOG_RING_AT (ring, pos))
+
+static void
+gst_log_ring_init (GstLogRing * ring, guint size)
+{
+  ring->allocated = GST_ROUND_UP_8 ((gsize) size);
+  ring->data = g_malloc (ring->allocated);
+  ring->head = ring->tail = 0;
+  ring->n_records = 0;
+  ring->wrapped = FALSE;
+}
+
+static void
+gst_log_ring_clear (GstLogRing * ring)
+{
+  g_free (ring->data);
+  ring->data = NULL;
+}
+
+/* position of the record following the one at @pos */
+static gsize
+gst_log_ring_next (GstLogRing * ring, gsize pos)
+{
+  pos += GST_LOG_RING_SIZE_AT (ring, pos);
+  if (pos == ring->allocated || GST_LOG_RING_SIZE_AT (ring, pos) == 0)
+    pos = 0;
+
+  return pos;
+}
+
+/* Returns room for a record of @size, a multiple of 8, at the head of the
+ * ring, dropping the oldest records as needed. */
+static gpointer
+gst_log_ring_reserve (GstLogRing * ring, gsize size)
+{
+  gsize pos;
+
+  if (size > ring->allocated)
+    return NULL;
+
+  for (;;) {
+    if (ring->n_records == 0) {
+      ring->head = ring->tail = 0;
+      ring->wrapped = FALSE;
+    }
+
+    if (!ring->wrapped) {
+      if (ring->allocated - ring->head >= size)
+        break;
+
+      if (ring->head < ring->allocated)
+        GST_LOG_RING_SIZE_AT (ring, ring->head) = 0;
+      ring->head = 0;
+      ring->wrapped = TRUE;
+    }
+
+    if (ring->tail - ring->head >= size)
+      break;
+
+    ring->tail = gst_log_ring_next (ring, ring->tail);
+    if (ring->tail == 0)
+      ring->wrapped = FALSE;
+    ring->n_records--;
+  }
+
+  pos = ring->head;
+  GST_LOG_RING_SIZE_AT (ring, pos) = size;
+  ring->head += size;
+  ring->n_records++;
+
+  return GST_LOG_RING_AT (ring, pos);
+}
+
+/* Per thread log of the ring buffer and deferred loggers, owned by the
+ * thread and by the logger while it is attached to it. Only the owning
+ * thread writes, so the lock is only ever contended while the logs are
+ * read. */
+typedef struct
+{
+  gint refcount;
+  GMutex lock;
+  GThread *thread;
+  gboolean exited;
+  /* in the list of threads of the logger, NULL when detached */
+  GList *link;
+
+  gint64 last_use;
+  GstLogRing ring;
+} GstThreadLog;
+
+static GstThreadLog *
+gst_thread_log_get (GPrivate * key)
+{
+  GstThreadLog *log = g_private_get (key);
+
+  if (G_UNLIKELY (log == NULL)) {
+    log = g_new0 (GstThreadLog, 1);
+    log->refcount = 1;
+    g_mutex_init (&log->lock);
+    log->thread = g_thread_self ();
+    g_private_set (key, log);
+  }
+
+  return log;
+}
+
+static void
+gst_thread_log_unref (GstThreadLog * log)
+{
+  if (g_atomic_int_dec_and_test (&log->refcount)) {
+    g_mutex_clear (&log->lock);
+    gst_log_ring_clear (&log->ring);
+    g_free (log);
+  }
+}
+
+/* called with the lock of the logger that owns @threads */
+static void
+gst_thread_log_attach (GstThreadLog * log, GQueue * threads,
+    guint max_size_per_thread)
+{
+  g_mutex_lock (&log->lock);
+  if (log->link == NULL) {
+    gst_log_ring_init (&log->ring, max_size_per_thread);
+
+    g_queue_push_tail (threads, log);
+    log->link = threads->tail;
+    g_atomic_int_inc (&log->refcount);
+  }
+  g_mutex_unlock (&log->lock);
+}
+
+/* called with the lock of the logger that owns @threads */
+static void
+gst_thread_log_detach (GstThreadLog * log, GQueue * threads)
+{
+  g_queue_delete_link (threads, log->link);
+
+  g_mutex_lock (&log->lock);
+  log->link = NULL;
+  gst_log_ring_clear (&log->ring);
+  g_mutex_unlock (&log->lock);
+
+  gst_thread_log_unref (log);
+}
+
 typedef struct
 {
   guint max_size_per_thread;
   guint thread_timeout;
   GQueue threads;
-  GHashTable *thread_index;
 } GstRingBufferLogger;
 
+/* A record is followed by the formatted line */
 typedef struct
 {
-  GList *link;
-  gint64 last_use;
-  GThread *thread;
-
-  GQueue log;
-  gsize log_size;
-} GstRingBufferLog;
+  guint32 size;
+  guint32 len;
+} GstRingBufferRecord;
 
 G_LOCK_DEFINE_STATIC (ring_buffer_logger);
 static GstRingBufferLogger *ring_buffer_logger = NULL;
 
+/* the logs of exited threads are kept until they time out */
+static GPrivate ring_buffer_log_key =
+G_PRIVATE_INIT ((GDestroyNotify) gst_thread_log_unref);
+
+/* Remove all threads that saw no output since thread_timeout seconds.
+ * Called with the ring_buffer_logger lock. */
+static void
+gst_ring_buffer_logger_remove_timed_out (GstRingBufferLogger * logger,
+    gint64 now)
+{
+  GList *l, *next;
+
+  if (logger->thread_timeout == 0)
+    return;
+
+  for (l = logger->threads.head; l; l = next) {
+    GstThreadLog *log = l->data;
+    gint64 last_use;
+
+    next = l->next;
+
+    g_mutex_lock (&log->lock);
+    last_use = log->last_use;
+    g_mutex_unlock (&log->lock);
+
+    if (last_use + logger->thread_timeout * G_USEC_PER_SEC < now)
+      gst_thread_log_detach (log, &logger->threads);
+  }
+}
+
 static void
 gst_ring_buffer_logger_log (GstDebugCategory * category,
     GstDebugLevel level,
@@ -3225,7 +3627,8 @@ gst_ring_buffer_logger_log (GstDebugCategory * category,
   gchar c;
   gchar *output;
   gsize output_len;
-  GstRingBufferLog *log;
+  GstThreadLog *log;
+  GstRingBufferRecord *rec;
   gint64 now = g_get_monotonic_time ();
   const gchar *message_str = gst_debug_message_get (message);
 
@@ -3262,76 +3665,49 @@ gst_ring_buffer_logger_log (GstDebugCategory * category,
   if (object != NULL)
     g_free (obj);
 
-  G_LOCK (ring_buffer_logger);
-
-  if (logger->thread_timeout > 0) {
-    gchar *buf;
+  log = gst_thread_log_get (&ring_buffer_log_key);
 
-    /* Remove all threads that saw no output since thread_timeout seconds.
-     * By construction these are all at the tail of the queue, and the queue
-     * is ordered by last use, so we just need to look at the tail.
-     */
-    while (logger->threads.tail) {
-      log = logger->threads.tail->data;
-      if (log->last_use + logger->thread_timeout * G_USEC_PER_SEC >= now)
-        break;
+  g_mutex_lock (&log->lock);
+  if (G_UNLIKELY (log->link == NULL)) {
+    g_mutex_unlock (&log->lock);
 
-      g_hash_table_remove (logger->thread_index, log->thread);
-      while ((buf = g_queue_pop_head (&log->log)))
-        g_free (buf);
-      g_free (log);
-      g_queue_pop_tail (&logger->threads);
+    /* new threads are rare, so look for timed out ones here */
+    G_LOCK (ring_buffer_logger);
+    if (ring_buffer_logger == logger) {
+      gst_ring_buffer_logger_remove_timed_out (logger, now);
+      gst_thread_log_attach (log, &logger->threads,
+          logger->max_size_per_thread);
     }
-  }
+    G_UNLOCK (ring_buffer_logger);
 
-  /* Get logger for this thread, and put it back at the
-   * head of the threads queue */
-  log = g_hash_table_lookup (logger->thread_index, thread);
-  if (!log) {
-    log = g_new0 (GstRingBufferLog, 1);
-    g_queue_init (&log->log);
-    log->log_size = 0;
-    g_queue_push_head (&logger->threads, log);
-    log->link = logger->threads.head;
-    log->thread = thread;
-    g_hash_table_insert (logger->thread_index, thread, log);
-  } else {
-    g_queue_unlink (&logger->threads, log->link);
-    g_queue_push_head_link (&logger->threads, log->link);
+    g_mutex_lock (&log->lock);
   }
+
   log->last_use = now;
 
-  if (output_len < logger->max_size_per_thread) {
-    gchar *buf;
-
-    /* While using a GQueue here is not the most efficient thing to do, we
-     * have to allocate a string for every output anyway and could just store
-     * that instead of copying it to an actual ringbuffer.
-     * Better than GQueue would be GstQueueArray, but that one is in
-     * libgstbase and we can't use it here. That one allocation will not make
-     * much of a difference anymore, considering the number of allocations
-     * needed to get to this point...
-     */
-    while (log->log_size + output_len > logger->max_size_per_thread) {
-      buf = g_queue_pop_head (&log->log);
-      log->log_size -= strlen (buf);
-      g_free (buf);
-    }
-    g_queue_push_tail (&log->log, output);
-    log->log_size += output_len;
-  } else {
-    gchar *buf;
+  /* Lines bigger than the maximum allowed log size are dropped */
+  if (log->link && (rec = gst_log_ring_reserve (&log->ring,
+              GST_ROUND_UP_8 (sizeof (GstRingBufferRecord) + output_len)))) {
+    rec->len = output_len;
+    memcpy (rec + 1, output, output_len);
+  }
+  g_mutex_unlock (&log->lock);
 
-    /* Can't really write anything as the line is bigger than the maximum
-     * allowed log size already, so just remove everything */
+  g_free (output);
+}
 
-    while ((buf = g_queue_pop_head (&log->log)))
-      g_free (buf);
-    g_free (output);
-    log->log_size = 0;
-  }
+static gint
+gst_thread_log_compare_last_use (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const GstThreadLog *log_a = *(GstThreadLog * const *) a;
+  const GstThreadLog *log_b = *(GstThreadLog * const *) b;
 
-  G_UNLOCK (ring_buffer_logger);
+  if (log_a->last_use > log_b->last_use)
+    return -1;
+  if (log_a->last_use < log_b->last_use)
+    return 1;
+  return 0;
 }
 
 /**
@@ -3348,33 +3724,61 @@ gst_ring_buffer_logger_log (GstDebugCategory * category,
 gchar **
 gst_debug_ring_buffer_logger_get_logs (void)
 {
-  gchar **logs, **tmp;
+  gchar **logs;
+  GstThreadLog **threads;
   GList *l;
+  guint i, n_threads;
 
   g_return_val_if_fail (ring_buffer_logger != NULL, NULL);
 
   G_LOCK (ring_buffer_logger);
 
-  tmp = logs = g_new0 (gchar *, ring_buffer_logger->threads.length + 1);
-  for (l = ring_buffer_logger->threads.head; l; l = l->next) {
-    GstRingBufferLog *log = l->data;
-    GList *l;
+  gst_ring_buffer_logger_remove_timed_out (ring_buffer_logger,
+      g_get_monotonic_time ());
+
+  n_threads = ring_buffer_logger->threads.length;
+  threads = g_new (GstThreadLog *, n_threads);
+  logs = g_new0 (gchar *, n_threads + 1);
+
+  for (i = 0, l = ring_buffer_logger->threads.head; l; l = l->next, i++) {
+    threads[i] = l->data;
+    g_mutex_lock (&threads[i]->lock);
+  }
+
+  /* the threads used last come first */
+  g_qsort_with_data (threads, n_threads, sizeof (GstThreadLog *),
+      gst_thread_log_compare_last_use, NULL);
+
+  for (i = 0; i < n_threads; i++) {
+    GstLogRing *ring = &threads[i]->ring;
+    gsize pos = ring->tail, len = 0;
+    guint j;
     gchar *p;
-    gsize len;
 
-    *tmp = p = g_new0 (gchar, log->log_size + 1);
+    for (j = 0; j < ring->n_records; j++) {
+      len += ((GstRingBufferRecord *) GST_LOG_RING_AT (ring, pos))->len;
+      pos = gst_log_ring_next (ring, pos);
+    }
+
+    logs[i] = p = g_new (gchar, len + 1);
+
+    pos = ring->tail;
+    for (j = 0; j < ring->n_records; j++) {
+      GstRingBufferRecord *rec = GST_LOG_RING_AT (ring, pos);
 
-    for (l = log->log.head; l; l = l->next) {
-      len = strlen (l->data);
-      memcpy (p, l->data, len);
-      p += len;
+      memcpy (p, rec + 1, rec->len);
+      p += rec->len;
+      pos = gst_log_ring_next (ring, pos);
     }
+    *p = '\0';
 
-    tmp++;
+    g_mutex_unlock (&threads[i]->lock);
   }
 
   G_UNLOCK (ring_buffer_logger);
 
+  g_free (threads);
+
   return logs;
 }
 
@@ -3383,16 +3787,10 @@ gst_ring_buffer_logger_free (GstRingBufferLogger * logger)
 {
   G_LOCK (ring_buffer_logger);
   if (ring_buffer_logger == logger) {
-    GstRingBufferLog *log;
-
-    while ((log = g_queue_pop_head (&logger->threads))) {
-      gchar *buf;
-      while ((buf = g_queue_pop_head (&log->log)))
-        g_free (buf);
-      g_free (log);
-    }
+    GstThreadLog *log;
 
-    g_hash_table_unref (logger->thread_index);
+    while ((log = g_queue_peek_head (&logger->threads)))
+      gst_thread_log_detach (log, &logger->threads);
 
     g_free (logger);
     ring_buffer_logger = NULL;
@@ -3433,7 +3831,6 @@ gst_debug_add_ring_buffer_logger (guint max_size_per_thread,
 
   logger->max_size_per_thread = max_size_per_thread;
   logger->thread_timeout = thread_timeout;
-  logger->thread_index = g_hash_table_new (g_direct_hash, g_direct_equal);
   g_queue_init (&logger->threads);
 
   gst_debug_add_log_function (gst_ring_buffer_logger_log, logger,
@@ -3455,6 +3852,344 @@ gst_debug_remove_ring_buffer_logger (void)
   gst_debug_remove_log_function (gst_ring_buffer_logger_log);
 }
 
+/* Exited threads whose logs are kept around */
+#define DEFERRED_LOGGER_MAX_EXITED_THREADS 16
+
+typedef struct
+{
+  guint max_size_per_thread;
+  /* where to write the logs to when the logger is removed */
+  FILE *dump_file;
+  GQueue threads;
+} GstDeferredLogger;
+
+/* A record is followed by the object description and the arguments as
+ * captured by __gst_vasprintf_capture() */
+typedef struct
+{
+  guint32 size;
+  guint32 obj_len;
+  GstClockTime elapsed;
+  GstDebugCategory *category;
+  const gchar *file;
+  const gchar *function;
+  const gchar *format;
+  gint line;
+  GstDebugLevel level;
+} GstDeferredRecord;
+
+G_LOCK_DEFINE_STATIC (deferred_logger);
+static GstDeferredLogger *deferred_logger = NULL;
+
+static void gst_deferred_log_thread_exit (GstThreadLog * log);
+static GPrivate deferred_log_key =
+G_PRIVATE_INIT ((GDestroyNotify) gst_deferred_log_thread_exit);
+
+static void
+gst_deferred_log_thread_exit (GstThreadLog * log)
+{
+  G_LOCK (deferred_logger);
+  log->exited = TRUE;
+
+  if (deferred_logger) {
+    GList *l, *next;
+    guint n_exited = 0;
+
+    for (l = deferred_logger->threads.head; l; l = l->next) {
+      if (((GstThreadLog *) l->data)->exited)
+        n_exited++;
+    }
+
+    /* forget about the threads that exited first */
+    for (l = deferred_logger->threads.head;
+        l && n_exited > DEFERRED_LOGGER_MAX_EXITED_THREADS; l = next) {
+      GstThreadLog *exited = l->data;
+
+      next = l->next;
+      if (exited->exited) {
+        gst_thread_log_detach (exited, &deferred_logger->threads);
+        n_exited--;
+      }
+    }
+  }
+  G_UNLOCK (deferred_logger);
+
+  gst_thread_log_unref (log);
+}
+
+static gpointer
+gst_deferred_capture (gpointer buf, gsize * size, const gchar * format, ...)
+{
+  gpointer ret;
+  va_list args;
+
+  va_start (args, format);
+  ret = __gst_vasprintf_capture (buf, size, format, args);
+  va_end (args);
+
+  return ret;
+}
+
+static void
+gst_deferred_logger_log (GstDebugCategory * category,
+    GstDebugLevel level,
+    const gchar * file,
+    const gchar * function,
+    gint line, GObject * object, GstDebugMessage * message, gpointer user_data)
+{
+  GstDeferredLogger *logger = user_data;
+  GstThreadLog *log;
+  GstDeferredRecord *rec;
+  const gchar *format = message->format;
+  gchar scratch[512];
+  gpointer args = NULL;
+  gsize args_len = sizeof (scratch), obj_len = 0;
+  gchar *obj = NULL;
+
+  /* If another handler formatted the message already the arguments were
+   * consumed, and that string is all that's left to record */
+  if (message->message == NULL) {
+    va_list va;
+
+    G_VA_COPY (va, message->arguments);
+    args = __gst_vasprintf_capture (scratch, &args_len, format, va);
+    va_end (va);
+  }
+
+  if (G_UNLIKELY (args == NULL)) {
+    const gchar *message_str = gst_debug_message_get (message);
+
+    if (message_str == NULL)
+      return;
+
+    format = "%s";
+    args_len = sizeof (scratch);
+    args = gst_deferred_capture (scratch, &args_len, format, message_str);
+    if (args == NULL)
+      return;
+  }
+
+  /* the object might be gone by the time the log is read */
+  if (object) {
+    obj = gst_debug_print_object (object);
+    obj_len = strlen (obj) + 1;
+  }
+
+  log = gst_thread_log_get (&deferred_log_key);
+
+  g_mutex_lock (&log->lock);
+  if (G_UNLIKELY (log->link == NULL)) {
+    g_mutex_unlock (&log->lock);
+
+    G_LOCK (deferred_logger);
+    if (deferred_logger == logger)
+      gst_thread_log_attach (log, &logger->threads,
+          logger->max_size_per_thread);
+    G_UNLOCK (deferred_logger);
+
+    g_mutex_lock (&log->lock);
+  }
+
+  if (log->link && (rec = gst_log_ring_reserve (&log->ring,
+              GST_ROUND_UP_8 (sizeof (GstDeferredRecord) + obj_len +
+                  args_len)))) {
+    rec->obj_len = obj_len;
+    rec->elapsed =
+        GST_CLOCK_DIFF (_priv_gst_start_time, gst_util_get_timestamp ());
+    rec->category = category;
+    rec->file = file;
+    rec->function = function;
+    rec->format = format;
+    rec->line = line;
+    rec->level = level;
+    if (obj_len)
+      memcpy (rec + 1, obj, obj_len);
+    memcpy ((guint8 *) (rec + 1) + obj_len, args, args_len);
+  }
+  g_mutex_unlock (&log->lock);
+
+  g_free (obj);
+  if (args != scratch)
+    g_free (args);
+}
+
+/* called with the log lock */
+static gchar *
+gst_deferred_log_format (GstThreadLog * log)
+{
+  GString *output = g_string_new (NULL);
+  GstLogRing *ring = &log->ring;
+  gint pid = getpid ();
+  gsize pos = ring->tail;
+  guint i;
+
+  for (i = 0; i < ring->n_records; i++) {
+    GstDeferredRecord *rec = GST_LOG_RING_AT (ring, pos);
+    const gchar *file = rec->file;
+    const gchar *obj = rec->obj_len ? (const gchar *) (rec + 1) : "";
+    gchar *message_str = NULL;
+    gchar c;
+
+    __gst_asprintf_captured (&message_str, rec->format,
+        (guint8 *) (rec + 1) + rec->obj_len);
+
+    c = file[0];
+    if (c == '.' || c == '/' || c == '\\' || (c != '\0' && file[1] == ':')) {
+      file = gst_path_basename (file);
+    }
+
+    /* same format as the ring buffer logger */
+#define PRINT_FMT " "PID_FMT" "PTR_FMT" %s "CAT_FMT" %s\n"
+    g_string_append_printf (output, "%" GST_TIME_FORMAT PRINT_FMT,
+        GST_TIME_ARGS (rec->elapsed), pid, log->thread,
+        gst_debug_level_get_name (rec->level),
+        gst_debug_category_get_name (rec->category), file, rec->line,
+        rec->function, obj, GST_STR_NULL (message_str));
+#undef PRINT_FMT
+
+    g_free (message_str);
+    pos = gst_log_ring_next (ring, pos);
+  }
+
+  return g_string_free (output, FALSE);
+}
+
+/**
+ * gst_debug_deferred_logger_get_logs:
+ *
+ * Fetches the current logs per thread from the deferred logger, formatting
+ * them in the same way as gst_debug_ring_buffer_logger_get_logs(). See
+ * gst_debug_add_deferred_logger() for details.
+ *
+ * Returns: (transfer full) (array zero-terminated): NULL-terminated array of
+ * strings with the debug output per thread
+ *
+ * Since: 1.20
+ */
+gchar **
+gst_debug_deferred_logger_get_logs (void)
+{
+  gchar **logs, **tmp;
+  GList *l;
+
+  g_return_val_if_fail (deferred_logger != NULL, NULL);
+
+  G_LOCK (deferred_logger);
+
+  tmp = logs = g_new0 (gchar *, deferred_logger->threads.length + 1);
+  for (l = deferred_logger->threads.head; l; l = l->next) {
+    GstThreadLog *log = l->data;
+
+    g_mutex_lock (&log->lock);
+    *tmp++ = gst_deferred_log_format (log);
+    g_mutex_unlock (&log->lock);
+  }
+
+  G_UNLOCK (deferred_logger);
+
+  return logs;
+}
+
+static void
+gst_deferred_logger_free (GstDeferredLogger * logger)
+{
+  G_LOCK (deferred_logger);
+  if (deferred_logger == logger) {
+    GstThreadLog *log;
+
+    while ((log = g_queue_peek_head (&logger->threads))) {
+      if (logger->dump_file) {
+        gchar *output;
+
+        g_mutex_lock (&log->lock);
+        output = gst_deferred_log_format (log);
+        g_mutex_unlock (&log->lock);
+
+        fputs (output, logger->dump_file);
+        g_free (output);
+      }
+      gst_thread_log_detach (log, &logger->threads);
+    }
+
+    if (logger->dump_file)
+      fflush (logger->dump_file);
+
+    g_free (logger);
+    deferred_logger = NULL;
+  }
+  G_UNLOCK (deferred_logger);
+}
+
+static void
+gst_deferred_logger_add (guint max_size_per_thread, FILE * dump_file)
+{
+  GstDeferredLogger *logger;
+
+  G_LOCK (deferred_logger);
+
+  if (deferred_logger) {
+    g_warn_if_reached ();
+    G_UNLOCK (deferred_logger);
+    return;
+  }
+
+  logger = deferred_logger = g_new0 (GstDeferredLogger, 1);
+
+  logger->max_size_per_thread = max_size_per_thread;
+  logger->dump_file = dump_file;
+  g_queue_init (&logger->threads);
+
+  gst_debug_add_log_function (gst_deferred_logger_log, logger,
+      (GDestroyNotify) gst_deferred_logger_free);
+  G_UNLOCK (deferred_logger);
+}
+
+/**
+ * gst_debug_add_deferred_logger:
+ * @max_size_per_thread: Maximum size of log per thread in bytes
+ *
+ * Adds a debug logger that stores up to @max_size_per_thread bytes of log
+ * records per thread, dropping the oldest records when full. Unlike the ring
+ * buffer logger, the messages are not formatted when logging: only the
+ * category, level, location, format string and a copy of the arguments are
+ * recorded, and the messages are formatted when the logs are fetched with
+ * gst_debug_deferred_logger_get_logs().
+ *
+ * The format strings are referenced and not copied, so this should only be
+ * used when all log messages use static format strings, as is the case with
+ * the GST_DEBUG() family of macros. Arguments for GST_PTR_FORMAT and similar
+ * are still serialized when logging, as are the objects the messages relate
+ * to. Messages using %n are formatted right away.
+ *
+ * The logs of threads that have exited are kept around, up to a limit.
+ * The logger can be removed again, freeing all logs, with
+ * gst_debug_remove_deferred_logger(). Only one logger at a time is
+ * possible.
+ *
+ * Since: 1.20
+ */
+void
+gst_debug_add_deferred_logger (guint max_size_per_thread)
+{
+  g_return_if_fail (max_size_per_thread > 0);
+
+  gst_deferred_logger_add (max_size_per_thread, NULL);
+}
+
+/**
+ * gst_debug_remove_deferred_logger:
+ *
+ * Removes any previously added deferred logger with
+ * gst_debug_add_deferred_logger().
+ *
+ * Since: 1.20
+ */
+void
+gst_debug_remove_deferred_logger (void)
+{
+  gst_debug_remove_log_function (gst_deferred_logger_log);
+}
+
 #else /* GST_DISABLE_GST_DEBUG */
 #ifndef GST_REMOVE_DISABLED
 
@@ -3475,5 +4210,21 @@ gst_debug_remove_ring_buffer_logger (void)
 {
 }
 
+gchar **
+gst_debug_deferred_logger_get_logs (void)
+{
+  return NULL;
+}
+
+void
+gst_debug_add_deferred_logger (guint max_size_per_thread)
+{
+}
+
+void
+gst_debug_remove_deferred_logger (void)
+{
+}
+
 #endif /* GST_REMOVE_DISABLED */
 #endif /* GST_DISABLE_GST_DEBUG */
@@ -1790,6 +1790,14 @@ void gst_debug_print_stack_trace (void);
 GST_API
 gchar * gst_debug_get_stack_trace (GstStackTraceFlags flags);
 
+GST_API
+guint   gst_debug_get_stack_addresses (gpointer * addresses, guint n_addresses);
+
+GST_API
+gchar * gst_debug_symbolize_stack_addresses (gpointer const * addresses,
+                                             guint              n_addresses,
+                                             GstStackTraceFlags flags);
+
 GST_API
 void                  gst_debug_add_ring_buffer_logger      (guint max_size_per_thread, guint thread_timeout);
 GST_API
@@ -1797,6 +1805,13 @@ void                  gst_debug_remove_ring_buffer_logger   (void);
 GST_API
 gchar **              gst_debug_ring_buffer_logger_get_logs (void);
 
+GST_API
+void                  gst_debug_add_deferred_logger         (guint max_size_per_thread);
+GST_API
+void                  gst_debug_remove_deferred_logger      (void);
+GST_API
+gchar **              gst_debug_deferred_logger_get_logs    (void);
+
 G_END_DECLS
 
 #endif /* __GSTINFO_H__ */
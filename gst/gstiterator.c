@@ -283,6 +283,101 @@ gst_iterator_new_list (GType type,
   return GST_ITERATOR (result);
 }
 
+/*
+ * snapshot iterator
+ */
+typedef struct _GstSnapshotIterator
+{
+  GstIterator iterator;
+  GPtrArray *items;             /* shared between copies, never modified */
+  guint pos;
+} GstSnapshotIterator;
+
+static guint32 _snapshot_dummy_cookie = 0;
+
+static void
+gst_snapshot_iterator_copy (const GstSnapshotIterator * it,
+    GstSnapshotIterator * copy)
+{
+  g_ptr_array_ref (copy->items);
+}
+
+static GstIteratorResult
+gst_snapshot_iterator_next (GstSnapshotIterator * it, GValue * elem)
+{
+  if (it->pos >= it->items->len)
+    return GST_ITERATOR_DONE;
+
+  g_value_set_object (elem, g_ptr_array_index (it->items, it->pos));
+  it->pos++;
+
+  return GST_ITERATOR_OK;
+}
+
+static void
+gst_snapshot_iterator_resync (GstSnapshotIterator * it)
+{
+  it->pos = 0;
+}
+
+static void
+gst_snapshot_iterator_free (GstSnapshotIterator * it)
+{
+  g_ptr_array_unref (it->items);
+}
+
+/**
+ * gst_iterator_new_list_snapshot: (skip)
+ * @type: #GType of the objects in @list
+ * @list: (element-type GObject): the list of objects to iterate
+ * @item: function to call on each item retrieved
+ *
+ * Create a new iterator that iterates over a snapshot of @list. The
+ * iterator takes a reference to every object in @list, so this function
+ * must be called with the lock that protects @list held, and that lock can
+ * be released right after.
+ *
+ * The iterator doesn't use a lock or a cookie. Changes to @list after this
+ * function returned are not seen by the iterator, so it never returns
+ * %GST_ITERATOR_RESYNC and never blocks the owner of @list from changing
+ * it. gst_iterator_resync() starts again at the beginning of the snapshot.
+ * Copies of the iterator share the snapshot.
+ *
+ * The @item function is called without any lock held.
+ *
+ * Returns: the new #GstIterator for @list.
+ *
+ * Since: 1.20
+ */
+GstIterator *
+gst_iterator_new_list_snapshot (GType type, GList * list,
+    GstIteratorItemFunction item)
+{
+  GstSnapshotIterator *result;
+  GPtrArray *items;
+  GList *walk;
+
+  g_return_val_if_fail (g_type_is_a (type, G_TYPE_OBJECT), NULL);
+
+  items = g_ptr_array_new_full (g_list_length (list), g_object_unref);
+  for (walk = list; walk; walk = walk->next)
+    g_ptr_array_add (items, g_object_ref (walk->data));
+
+  result = (GstSnapshotIterator *)
+      gst_iterator_new (sizeof (GstSnapshotIterator),
+      type, NULL, &_snapshot_dummy_cookie,
+      (GstIteratorCopyFunction) gst_snapshot_iterator_copy,
+      (GstIteratorNextFunction) gst_snapshot_iterator_next,
+      (GstIteratorItemFunction) item,
+      (GstIteratorResyncFunction) gst_snapshot_iterator_resync,
+      (GstIteratorFreeFunction) gst_snapshot_iterator_free);
+
+  result->items = items;
+  result->pos = 0;
+
+  return GST_ITERATOR (result);
+}
+
 static void
 gst_iterator_pop (GstIterator * it)
 {
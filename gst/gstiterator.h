@@ -248,6 +248,10 @@ GstIterator*            gst_iterator_new_list           (GType type,
                                                          GObject * owner,
                                                          GstIteratorItemFunction item) G_GNUC_MALLOC;
 GST_API
+GstIterator*            gst_iterator_new_list_snapshot  (GType type,
+                                                         GList *list,
+                                                         GstIteratorItemFunction item) G_GNUC_MALLOC;
+GST_API
 GstIterator*            gst_iterator_new_single         (GType type,
                                                          const GValue * object) G_GNUC_MALLOC;
 GST_API
@@ -74,6 +74,40 @@
 GType _gst_memory_type = 0;
 GST_DEFINE_MINI_OBJECT_TYPE (GstMemory, gst_memory);
 
+/* Mappings of memory of allocators with GST_ALLOCATOR_FLAG_CACHE_READ_MAPS
+ * that are currently mapped read-only. The tables are striped by memory to
+ * keep unrelated memory from contending on a single lock. */
+#define MAP_CACHE_STRIPES 16
+
+typedef struct
+{
+  gint count;
+  guint8 *data;                 /* as returned by the allocator */
+  GstMapInfo info;              /* of the first map */
+} MapCacheEntry;
+
+typedef struct
+{
+  GMutex lock;
+  GHashTable *entries;
+} MapCacheStripe;
+
+static MapCacheStripe map_cache[MAP_CACHE_STRIPES];
+
+static inline MapCacheStripe *
+map_cache_stripe (GstMemory * mem)
+{
+  return &map_cache[((guintptr) mem >> 6) % MAP_CACHE_STRIPES];
+}
+
+static inline gboolean
+map_cache_usable (GstMemory * mem, GstMapFlags flags)
+{
+  return flags == GST_MAP_READ &&
+      GST_OBJECT_FLAG_IS_SET (mem->allocator,
+      GST_ALLOCATOR_FLAG_CACHE_READ_MAPS);
+}
+
 static GstMemory *
 _gst_memory_copy (GstMemory * mem)
 {
@@ -88,6 +122,8 @@ _gst_memory_free (GstMemory * mem)
 
   GST_CAT_DEBUG (GST_CAT_MEMORY, "free memory %p", mem);
 
+  GST_TRACER_MEMORY_FREE (mem);
+
   if (mem->parent) {
     gst_memory_unlock (mem->parent, GST_LOCK_FLAG_EXCLUSIVE);
     gst_memory_unref (mem->parent);
@@ -139,6 +175,8 @@ gst_memory_init (GstMemory * mem, GstMemoryFlags flags,
   GST_CAT_DEBUG (GST_CAT_MEMORY, "new memory %p, maxsize:%" G_GSIZE_FORMAT
       " offset:%" G_GSIZE_FORMAT " size:%" G_GSIZE_FORMAT, mem, maxsize,
       offset, size);
+
+  GST_TRACER_MEMORY_ALLOC (mem);
 }
 
 /**
@@ -267,6 +305,66 @@ cannot_map:
   }
 }
 
+static gboolean
+memory_map_cached (GstMemory * mem, GstMapInfo * info)
+{
+  MapCacheStripe *stripe = map_cache_stripe (mem);
+  MapCacheEntry *entry;
+
+  g_mutex_lock (&stripe->lock);
+  if (stripe->entries == NULL)
+    stripe->entries = g_hash_table_new (NULL, NULL);
+
+  entry = g_hash_table_lookup (stripe->entries, mem);
+  if (entry) {
+    /* nested map, reuse the mapping and the user_data of the first one */
+    entry->count++;
+    memcpy (info->user_data, entry->info.user_data, sizeof (info->user_data));
+    info->data = entry->data;
+  } else {
+    if (mem->allocator->mem_map_full)
+      info->data = mem->allocator->mem_map_full (mem, info, mem->maxsize);
+    else
+      info->data = mem->allocator->mem_map (mem, mem->maxsize, GST_MAP_READ);
+
+    if (info->data != NULL) {
+      entry = g_slice_new (MapCacheEntry);
+      entry->count = 1;
+      entry->data = info->data;
+      entry->info = *info;
+      /* the allocator sees the same info on unmap as without the cache */
+      entry->info.data += mem->offset;
+      g_hash_table_insert (stripe->entries, mem, entry);
+    }
+  }
+  g_mutex_unlock (&stripe->lock);
+
+  return info->data != NULL;
+}
+
+/* returns FALSE if @mem was not mapped through the cache */
+static gboolean
+memory_unmap_cached (GstMemory * mem)
+{
+  MapCacheStripe *stripe = map_cache_stripe (mem);
+  MapCacheEntry *entry = NULL;
+
+  g_mutex_lock (&stripe->lock);
+  if (stripe->entries)
+    entry = g_hash_table_lookup (stripe->entries, mem);
+  if (entry && --entry->count == 0) {
+    g_hash_table_remove (stripe->entries, mem);
+    if (mem->allocator->mem_unmap_full)
+      mem->allocator->mem_unmap_full (mem, &entry->info);
+    else
+      mem->allocator->mem_unmap (mem);
+    g_slice_free (MapCacheEntry, entry);
+  }
+  g_mutex_unlock (&stripe->lock);
+
+  return entry != NULL;
+}
+
 /**
  * gst_memory_map:
  * @mem: a #GstMemory
@@ -286,6 +384,10 @@ cannot_map:
  * For each gst_memory_map() call, a corresponding gst_memory_unmap() call
  * should be done.
  *
+ * When the allocator of @mem has #GST_ALLOCATOR_FLAG_CACHE_READ_MAPS, a
+ * #GST_MAP_READ map of memory that is already mapped with #GST_MAP_READ
+ * reuses the existing mapping without calling into the allocator.
+ *
  * Returns: %TRUE if the map operation was successful.
  */
 gboolean
@@ -302,10 +404,14 @@ gst_memory_map (GstMemory * mem, GstMapInfo * info, GstMapFlags flags)
   info->size = mem->size;
   info->maxsize = mem->maxsize - mem->offset;
 
-  if (mem->allocator->mem_map_full)
+  if (map_cache_usable (mem, flags)) {
+    if (!memory_map_cached (mem, info))
+      goto error;
+  } else if (mem->allocator->mem_map_full) {
     info->data = mem->allocator->mem_map_full (mem, info, mem->maxsize);
-  else
+  } else {
     info->data = mem->allocator->mem_map (mem, mem->maxsize, flags);
+  }
 
   if (G_UNLIKELY (info->data == NULL))
     goto error;
@@ -346,10 +452,13 @@ gst_memory_unmap (GstMemory * mem, GstMapInfo * info)
   g_return_if_fail (info != NULL);
   g_return_if_fail (info->memory == mem);
 
-  if (mem->allocator->mem_unmap_full)
+  if (map_cache_usable (mem, info->flags) && memory_unmap_cached (mem)) {
+    /* unmapped by the map cache when this was the last map */
+  } else if (mem->allocator->mem_unmap_full) {
     mem->allocator->mem_unmap_full (mem, info);
-  else
+  } else {
     mem->allocator->mem_unmap (mem);
+  }
   gst_memory_unlock (mem, (GstLockFlags) info->flags);
 }
 
@@ -54,6 +54,7 @@
 #include "gstutils.h"
 #include "gstquark.h"
 #include "gstvalue.h"
+#include "gstslicecache.h"
 
 
 typedef struct
@@ -223,7 +224,7 @@ _gst_message_free (GstMessage * message)
   memset (message, 0xff, sizeof (GstMessageImpl));
 #endif
 
-  g_slice_free1 (sizeof (GstMessageImpl), message);
+  _priv_gst_slice_cache_free (sizeof (GstMessageImpl), message);
 }
 
 static void
@@ -240,7 +241,7 @@ _gst_message_copy (GstMessage * message)
       GST_MESSAGE_TYPE_NAME (message),
       GST_OBJECT_NAME (GST_MESSAGE_SRC (message)));
 
-  copy = g_slice_new0 (GstMessageImpl);
+  copy = _priv_gst_slice_cache_alloc0 (sizeof (GstMessageImpl));
 
   gst_message_init (copy, GST_MESSAGE_TYPE (message),
       GST_MESSAGE_SRC (message));
@@ -299,7 +300,7 @@ gst_message_new_custom (GstMessageType type, GstObject * src,
 {
   GstMessageImpl *message;
 
-  message = g_slice_new0 (GstMessageImpl);
+  message = _priv_gst_slice_cache_alloc0 (sizeof (GstMessageImpl));
 
   GST_CAT_LOG (GST_CAT_MESSAGE, "source %s: creating new message %p %s",
       (src ? GST_OBJECT_NAME (src) : "NULL"), message,
@@ -320,7 +321,7 @@ gst_message_new_custom (GstMessageType type, GstObject * src,
   /* ERRORS */
 had_parent:
   {
-    g_slice_free1 (sizeof (GstMessageImpl), message);
+    _priv_gst_slice_cache_free (sizeof (GstMessageImpl), message);
     g_warning ("structure is already owned by another object");
     return NULL;
   }
@@ -55,6 +55,63 @@
 static GHashTable *metainfo = NULL;
 static GRWLock lock;
 
+/* Open addressing hash table from API types to their index for buffers, see
+ * _priv_gst_meta_api_index(). Entries are only ever added, so that lookups
+ * don't need to take a lock. */
+#define API_INDEX_SIZE 128
+
+static GMutex api_index_lock;
+static gpointer api_index_types[API_INDEX_SIZE];
+static guint8 api_index_ids[API_INDEX_SIZE];
+static guint n_api_index_ids;
+
+static inline guint
+api_index_hash (GType api)
+{
+  return (guint) (((guint64) api * G_GUINT64_CONSTANT (0x9e3779b97f4a7c15))
+      >> 32) & (API_INDEX_SIZE - 1);
+}
+
+static void
+api_index_add (GType api)
+{
+  guint i;
+
+  g_mutex_lock (&api_index_lock);
+  if (n_api_index_ids < GST_META_API_UNINDEXED) {
+    for (i = api_index_hash (api);; i = (i + 1) & (API_INDEX_SIZE - 1)) {
+      gpointer type = api_index_types[i];
+
+      if (type == GSIZE_TO_POINTER (api))
+        break;
+      if (type == NULL) {
+        api_index_ids[i] = n_api_index_ids++;
+        g_atomic_pointer_set (&api_index_types[i], GSIZE_TO_POINTER (api));
+        break;
+      }
+    }
+  }
+  g_mutex_unlock (&api_index_lock);
+}
+
+/* Returns the bit of @api in the meta bitmask of buffers */
+guint
+_priv_gst_meta_api_index (GType api)
+{
+  guint i, n;
+
+  for (i = api_index_hash (api), n = 0; n < API_INDEX_SIZE;
+      i = (i + 1) & (API_INDEX_SIZE - 1), n++) {
+    gpointer type = g_atomic_pointer_get (&api_index_types[i]);
+
+    if (type == GSIZE_TO_POINTER (api))
+      return api_index_ids[i];
+    if (type == NULL)
+      break;
+  }
+  return GST_META_API_UNINDEXED;
+}
+
 GQuark _gst_meta_transform_copy;
 GQuark _gst_meta_tag_memory;
 
@@ -72,6 +129,8 @@ typedef struct
   gpointer custom_transform_user_data;
   GDestroyNotify custom_transform_destroy_notify;
   gboolean is_custom;
+  /* the API has the memory tag, cached for gst_buffer_copy_into() */
+  gboolean is_memory;
 } GstMetaInfoImpl;
 
 static void
@@ -145,6 +204,9 @@ gst_meta_api_type_register (const gchar * api, const gchar ** tags)
 
   g_type_set_qdata (type, GST_QUARK (TAGS), g_strdupv ((gchar **) tags));
 
+  if (type != 0)
+    api_index_add (type);
+
   return type;
 }
 
@@ -310,6 +372,14 @@ gst_meta_info_is_custom (const GstMetaInfo * info)
   return ((GstMetaInfoImpl *) info)->is_custom;
 }
 
+/* Returns TRUE if the API of @info has the memory tag, without looking up
+ * the tag in the qdata of the API type */
+gboolean
+_priv_gst_meta_info_is_memory (const GstMetaInfo * info)
+{
+  return ((GstMetaInfoImpl *) info)->is_memory;
+}
+
 /**
  * gst_meta_api_type_has_tag:
  * @api: an API
@@ -399,6 +469,8 @@ gst_meta_register (GType api, const gchar * impl, gsize size,
   info->free_func = free_func;
   info->transform_func = transform_func;
   ((GstMetaInfoImpl *) info)->is_custom = FALSE;
+  ((GstMetaInfoImpl *) info)->is_memory =
+      gst_meta_api_type_has_tag (api, _gst_meta_tag_memory);
 
   GST_CAT_DEBUG (GST_CAT_META,
       "register \"%s\" implementing \"%s\" of size %" G_GSIZE_FORMAT, impl,
@@ -61,8 +61,6 @@
 
 GType _gst_mini_object_type = 0;
 
-/* Mutex used for weak referencing */
-G_LOCK_DEFINE_STATIC (qdata_mutex);
 static GQuark weak_ref_quark;
 
 #define SHARE_ONE (1 << 16)
@@ -126,6 +124,8 @@ typedef struct
   guint n_parents, n_parents_len;
   GstMiniObject **parents;
 
+  /* Atomic spinlock for the qdata: 1 if locked, 0 otherwise */
+  gint qdata_lock;
   guint n_qdata, n_qdata_len;
   GstQData *qdata;
 } PrivData;
@@ -202,6 +202,10 @@ gst_mini_object_copy (const GstMiniObject * mini_object)
   else
     copy = NULL;
 
+  /* copies of immortal objects are normal objects again */
+  if (copy)
+    GST_MINI_OBJECT_FLAG_UNSET (copy, GST_MINI_OBJECT_FLAG_IMMORTAL);
+
   return copy;
 }
 
@@ -472,6 +476,10 @@ gst_mini_object_ref (GstMiniObject * mini_object)
    g_return_val_if_fail (mini_object->refcount > 0, NULL);
    */
 
+  if (G_UNLIKELY (GST_MINI_OBJECT_FLAGS (mini_object) &
+          GST_MINI_OBJECT_FLAG_IMMORTAL))
+    return mini_object;
+
   old_refcount = g_atomic_int_add (&mini_object->refcount, 1);
   new_refcount = old_refcount + 1;
 
@@ -483,19 +491,49 @@ gst_mini_object_ref (GstMiniObject * mini_object)
   return mini_object;
 }
 
-/* Called with global qdata lock */
+/**
+ * gst_mini_object_ref_n: (skip)
+ * @mini_object: the mini-object
+ * @n: the number of references to add
+ *
+ * Increase the reference count of the mini-object by @n with a single atomic
+ * operation. This is useful when the same object is handed to many
+ * consumers, each of which takes ownership of one reference, for example
+ * when pushing a buffer on the source pads of a tee.
+ *
+ * Returns: (transfer full): the mini-object.
+ *
+ * Since: 1.20
+ */
+GstMiniObject *
+gst_mini_object_ref_n (GstMiniObject * mini_object, guint n)
+{
+  gint old_refcount, new_refcount;
+
+  g_return_val_if_fail (mini_object != NULL, NULL);
+  g_return_val_if_fail (n <= G_MAXINT, NULL);
+
+  if (n == 0 || G_UNLIKELY (GST_MINI_OBJECT_FLAGS (mini_object) &
+          GST_MINI_OBJECT_FLAG_IMMORTAL))
+    return mini_object;
+
+  old_refcount = g_atomic_int_add (&mini_object->refcount, n);
+  new_refcount = old_refcount + n;
+
+  GST_CAT_TRACE (GST_CAT_REFCOUNTING, "%p ref %d->%d", mini_object,
+      old_refcount, new_refcount);
+
+  GST_TRACER_MINI_OBJECT_REFFED (mini_object, new_refcount);
+
+  return mini_object;
+}
+
+/* Called with the qdata lock of the object, see lock_qdata() */
 static gint
-find_notify (GstMiniObject * object, GQuark quark, gboolean match_notify,
+find_notify (PrivData * priv_data, GQuark quark, gboolean match_notify,
     GstMiniObjectNotify notify, gpointer data)
 {
   guint i;
-  gint priv_state = g_atomic_int_get ((gint *) & object->priv_uint);
-  PrivData *priv_data;
-
-  if (priv_state != PRIV_DATA_STATE_PARENTS_OR_QDATA)
-    return -1;
-
-  priv_data = object->priv_pointer;
 
   for (i = 0; i < priv_data->n_qdata; i++) {
     if (QDATA_QUARK (priv_data, i) == quark) {
@@ -509,14 +547,8 @@ find_notify (GstMiniObject * object, GQuark quark, gboolean match_notify,
 }
 
 static void
-remove_notify (GstMiniObject * object, gint index)
+remove_notify (PrivData * priv_data, gint index)
 {
-  gint priv_state = g_atomic_int_get ((gint *) & object->priv_uint);
-  PrivData *priv_data;
-
-  g_assert (priv_state == PRIV_DATA_STATE_PARENTS_OR_QDATA);
-  priv_data = object->priv_pointer;
-
   /* remove item */
   priv_data->n_qdata--;
   if (priv_data->n_qdata == 0) {
@@ -537,6 +569,10 @@ ensure_priv_data (GstMiniObject * object)
   PrivData *priv_data;
   GstMiniObject *parent = NULL;
 
+  if (g_atomic_int_get ((gint *) & object->priv_uint) ==
+      PRIV_DATA_STATE_PARENTS_OR_QDATA)
+    return;
+
   GST_CAT_DEBUG (GST_CAT_PERFORMANCE,
       "allocating private data %s miniobject %p",
       g_type_name (GST_MINI_OBJECT_TYPE (object)), object);
@@ -569,15 +605,36 @@ ensure_priv_data (GstMiniObject * object)
   }
 }
 
-static void
-set_notify (GstMiniObject * object, gint index, GQuark quark,
-    GstMiniObjectNotify notify, gpointer data, GDestroyNotify destroy)
+/* Locks the qdata of @object. The PrivData is allocated first when @create
+ * is TRUE, otherwise NULL is returned if the object has no PrivData and thus
+ * no qdata */
+static PrivData *
+lock_qdata (GstMiniObject * object, gboolean create)
 {
   PrivData *priv_data;
 
-  ensure_priv_data (object);
+  if (create)
+    ensure_priv_data (object);
+  else if (g_atomic_int_get ((gint *) & object->priv_uint) !=
+      PRIV_DATA_STATE_PARENTS_OR_QDATA)
+    return NULL;
+
   priv_data = object->priv_pointer;
+  while (!g_atomic_int_compare_and_exchange (&priv_data->qdata_lock, 0, 1));
+
+  return priv_data;
+}
+
+static inline void
+unlock_qdata (PrivData * priv_data)
+{
+  g_atomic_int_set (&priv_data->qdata_lock, 0);
+}
 
+static void
+set_notify (PrivData * priv_data, gint index, GQuark quark,
+    GstMiniObjectNotify notify, gpointer data, GDestroyNotify destroy)
+{
   if (index == -1) {
     /* add item */
     index = priv_data->n_qdata++;
@@ -637,6 +694,32 @@ free_priv_data (GstMiniObject * obj)
   g_free (priv_data);
 }
 
+/* the last reference was dropped */
+static void
+mini_object_dispose (GstMiniObject * mini_object)
+{
+  gboolean do_free;
+
+  if (mini_object->dispose)
+    do_free = mini_object->dispose (mini_object);
+  else
+    do_free = TRUE;
+
+  /* if the subclass recycled the object (and returned FALSE) we don't
+   * want to free the instance anymore */
+  if (G_LIKELY (do_free)) {
+    /* there should be no outstanding locks */
+    g_return_if_fail ((g_atomic_int_get (&mini_object->lockstate) & LOCK_MASK)
+        < 4);
+
+    free_priv_data (mini_object);
+
+    GST_TRACER_MINI_OBJECT_DESTROYED (mini_object);
+    if (mini_object->free)
+      mini_object->free (mini_object);
+  }
+}
+
 /**
  * gst_mini_object_unref: (skip)
  * @mini_object: the mini-object
@@ -652,6 +735,10 @@ gst_mini_object_unref (GstMiniObject * mini_object)
   g_return_if_fail (mini_object != NULL);
   g_return_if_fail (GST_MINI_OBJECT_REFCOUNT_VALUE (mini_object) > 0);
 
+  if (G_UNLIKELY (GST_MINI_OBJECT_FLAGS (mini_object) &
+          GST_MINI_OBJECT_FLAG_IMMORTAL))
+    return;
+
   old_refcount = g_atomic_int_add (&mini_object->refcount, -1);
   new_refcount = old_refcount - 1;
 
@@ -662,28 +749,78 @@ gst_mini_object_unref (GstMiniObject * mini_object)
 
   GST_TRACER_MINI_OBJECT_UNREFFED (mini_object, new_refcount);
 
-  if (new_refcount == 0) {
-    gboolean do_free;
+  if (new_refcount == 0)
+    mini_object_dispose (mini_object);
+}
 
-    if (mini_object->dispose)
-      do_free = mini_object->dispose (mini_object);
-    else
-      do_free = TRUE;
+/**
+ * gst_mini_object_unref_n: (skip)
+ * @mini_object: the mini-object
+ * @n: the number of references to drop
+ *
+ * Decreases the reference count of the mini-object by @n with a single
+ * atomic operation, possibly freeing the mini-object. @n must not be larger
+ * than the number of references the caller owns.
+ *
+ * Since: 1.20
+ */
+void
+gst_mini_object_unref_n (GstMiniObject * mini_object, guint n)
+{
+  gint old_refcount, new_refcount;
 
-    /* if the subclass recycled the object (and returned FALSE) we don't
-     * want to free the instance anymore */
-    if (G_LIKELY (do_free)) {
-      /* there should be no outstanding locks */
-      g_return_if_fail ((g_atomic_int_get (&mini_object->lockstate) & LOCK_MASK)
-          < 4);
+  g_return_if_fail (mini_object != NULL);
+  g_return_if_fail (n <= G_MAXINT);
+  g_return_if_fail (GST_MINI_OBJECT_REFCOUNT_VALUE (mini_object) >= (gint) n);
 
-      free_priv_data (mini_object);
+  if (n == 0 || G_UNLIKELY (GST_MINI_OBJECT_FLAGS (mini_object) &
+          GST_MINI_OBJECT_FLAG_IMMORTAL))
+    return;
 
-      GST_TRACER_MINI_OBJECT_DESTROYED (mini_object);
-      if (mini_object->free)
-        mini_object->free (mini_object);
-    }
-  }
+  old_refcount = g_atomic_int_add (&mini_object->refcount, -(gint) n);
+  new_refcount = old_refcount - n;
+
+  g_return_if_fail (new_refcount >= 0);
+
+  GST_CAT_TRACE (GST_CAT_REFCOUNTING, "%p unref %d->%d",
+      mini_object, old_refcount, new_refcount);
+
+  GST_TRACER_MINI_OBJECT_UNREFFED (mini_object, new_refcount);
+
+  if (new_refcount == 0)
+    mini_object_dispose (mini_object);
+}
+
+/**
+ * gst_mini_object_make_immortal: (skip)
+ * @mini_object: (transfer full): the mini-object
+ *
+ * Makes @mini_object immortal, taking over the caller's reference. The
+ * object is never freed afterwards, and gst_mini_object_ref() and
+ * gst_mini_object_unref() return without touching the refcount, so that
+ * objects that are shared by many threads, like the caps of static pad
+ * templates, don't bounce the cache line of their refcount between CPUs.
+ *
+ * Immortal objects are never writable, gst_mini_object_make_writable()
+ * returns a copy. They are flagged with #GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED.
+ *
+ * Since: 1.20
+ */
+void
+gst_mini_object_make_immortal (GstMiniObject * mini_object)
+{
+  g_return_if_fail (mini_object != NULL);
+
+  if (GST_MINI_OBJECT_FLAGS (mini_object) & GST_MINI_OBJECT_FLAG_IMMORTAL)
+    return;
+
+  /* keep a reference nobody owns, so the object is never writable, even if
+   * references taken before are released while the flag is being set */
+  g_atomic_int_add (&mini_object->refcount, 1);
+  g_atomic_int_or (&mini_object->flags, GST_MINI_OBJECT_FLAG_IMMORTAL |
+      GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+
+  GST_CAT_TRACE (GST_CAT_REFCOUNTING, "%p made immortal", mini_object);
 }
 
 /**
@@ -842,13 +979,15 @@ void
 gst_mini_object_weak_ref (GstMiniObject * object,
     GstMiniObjectNotify notify, gpointer data)
 {
+  PrivData *priv_data;
+
   g_return_if_fail (object != NULL);
   g_return_if_fail (notify != NULL);
   g_return_if_fail (GST_MINI_OBJECT_REFCOUNT_VALUE (object) >= 1);
 
-  G_LOCK (qdata_mutex);
-  set_notify (object, -1, weak_ref_quark, notify, data, NULL);
-  G_UNLOCK (qdata_mutex);
+  priv_data = lock_qdata (object, TRUE);
+  set_notify (priv_data, -1, weak_ref_quark, notify, data, NULL);
+  unlock_qdata (priv_data);
 }
 
 /**
@@ -863,19 +1002,24 @@ void
 gst_mini_object_weak_unref (GstMiniObject * object,
     GstMiniObjectNotify notify, gpointer data)
 {
-  gint i;
+  PrivData *priv_data;
+  gint i = -1;
 
   g_return_if_fail (object != NULL);
   g_return_if_fail (notify != NULL);
 
-  G_LOCK (qdata_mutex);
-  if ((i = find_notify (object, weak_ref_quark, TRUE, notify, data)) != -1) {
-    remove_notify (object, i);
-  } else {
+  priv_data = lock_qdata (object, FALSE);
+  if (priv_data) {
+    i = find_notify (priv_data, weak_ref_quark, TRUE, notify, data);
+    if (i != -1)
+      remove_notify (priv_data, i);
+    unlock_qdata (priv_data);
+  }
+
+  if (i == -1) {
     g_warning ("%s: couldn't find weak ref %p (object:%p data:%p)", G_STRFUNC,
         notify, object, data);
   }
-  G_UNLOCK (qdata_mutex);
 }
 
 /**
@@ -903,6 +1047,7 @@ void
 gst_mini_object_set_qdata (GstMiniObject * object, GQuark quark,
     gpointer data, GDestroyNotify destroy)
 {
+  PrivData *priv_data;
   gint i;
   gpointer old_data = NULL;
   GDestroyNotify old_notify = NULL;
@@ -910,19 +1055,21 @@ gst_mini_object_set_qdata (GstMiniObject * object, GQuark quark,
   g_return_if_fail (object != NULL);
   g_return_if_fail (quark > 0);
 
-  G_LOCK (qdata_mutex);
-  if ((i = find_notify (object, quark, FALSE, NULL, NULL)) != -1) {
-    PrivData *priv_data = object->priv_pointer;
+  /* only allocate the private data if there is something to set */
+  priv_data = lock_qdata (object, data != NULL);
+  if (priv_data == NULL)
+    return;
 
+  if ((i = find_notify (priv_data, quark, FALSE, NULL, NULL)) != -1) {
     old_data = QDATA_DATA (priv_data, i);
     old_notify = QDATA_DESTROY (priv_data, i);
 
     if (data == NULL)
-      remove_notify (object, i);
+      remove_notify (priv_data, i);
   }
   if (data != NULL)
-    set_notify (object, i, quark, NULL, data, destroy);
-  G_UNLOCK (qdata_mutex);
+    set_notify (priv_data, i, quark, NULL, data, destroy);
+  unlock_qdata (priv_data);
 
   if (old_notify)
     old_notify (old_data);
@@ -942,20 +1089,20 @@ gst_mini_object_set_qdata (GstMiniObject * object, GQuark quark,
 gpointer
 gst_mini_object_get_qdata (GstMiniObject * object, GQuark quark)
 {
-  guint i;
-  gpointer result;
+  PrivData *priv_data;
+  gint i;
+  gpointer result = NULL;
 
   g_return_val_if_fail (object != NULL, NULL);
   g_return_val_if_fail (quark > 0, NULL);
 
-  G_LOCK (qdata_mutex);
-  if ((i = find_notify (object, quark, FALSE, NULL, NULL)) != -1) {
-    PrivData *priv_data = object->priv_pointer;
+  priv_data = lock_qdata (object, FALSE);
+  if (priv_data == NULL)
+    return NULL;
+
+  if ((i = find_notify (priv_data, quark, FALSE, NULL, NULL)) != -1)
     result = QDATA_DATA (priv_data, i);
-  } else {
-    result = NULL;
-  }
-  G_UNLOCK (qdata_mutex);
+  unlock_qdata (priv_data);
 
   return result;
 }
@@ -975,21 +1122,22 @@ gst_mini_object_get_qdata (GstMiniObject * object, GQuark quark)
 gpointer
 gst_mini_object_steal_qdata (GstMiniObject * object, GQuark quark)
 {
-  guint i;
-  gpointer result;
+  PrivData *priv_data;
+  gint i;
+  gpointer result = NULL;
 
   g_return_val_if_fail (object != NULL, NULL);
   g_return_val_if_fail (quark > 0, NULL);
 
-  G_LOCK (qdata_mutex);
-  if ((i = find_notify (object, quark, FALSE, NULL, NULL)) != -1) {
-    PrivData *priv_data = object->priv_pointer;
+  priv_data = lock_qdata (object, FALSE);
+  if (priv_data == NULL)
+    return NULL;
+
+  if ((i = find_notify (priv_data, quark, FALSE, NULL, NULL)) != -1) {
     result = QDATA_DATA (priv_data, i);
-    remove_notify (object, i);
-  } else {
-    result = NULL;
+    remove_notify (priv_data, i);
   }
-  G_UNLOCK (qdata_mutex);
+  unlock_qdata (priv_data);
 
   return result;
 }
@@ -134,6 +134,9 @@ typedef void (*GstMiniObjectNotify) (gpointer user_data, GstMiniObject * obj);
  * @GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED: the object is expected to stay alive
  * even after gst_deinit() has been called and so should be ignored by leak
  * detection tools. (Since: 1.10)
+ * @GST_MINI_OBJECT_FLAG_IMMORTAL: the object was made immortal with
+ * gst_mini_object_make_immortal(), referencing and unreferencing it doesn't
+ * change the refcount. (Since: 1.20)
  * @GST_MINI_OBJECT_FLAG_LAST: first flag that can be used by subclasses.
  *
  * Flags for the mini object
@@ -143,6 +146,7 @@ typedef enum
   GST_MINI_OBJECT_FLAG_LOCKABLE      = (1 << 0),
   GST_MINI_OBJECT_FLAG_LOCK_READONLY = (1 << 1),
   GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED = (1 << 2),
+  GST_MINI_OBJECT_FLAG_IMMORTAL      = (1 << 3),
   /* padding */
   GST_MINI_OBJECT_FLAG_LAST          = (1 << 4)
 } GstMiniObjectFlags;
@@ -241,6 +245,17 @@ GstMiniObject * gst_mini_object_ref		(GstMiniObject *mini_object);
 GST_API
 void            gst_mini_object_unref		(GstMiniObject *mini_object);
 
+GST_API
+GstMiniObject * gst_mini_object_ref_n           (GstMiniObject *mini_object,
+                                                 guint n);
+
+GST_API
+void            gst_mini_object_unref_n         (GstMiniObject *mini_object,
+                                                 guint n);
+
+GST_API
+void            gst_mini_object_make_immortal   (GstMiniObject *mini_object);
+
 GST_API
 void        gst_clear_mini_object (GstMiniObject **object_ptr);
 #define     gst_clear_mini_object(object_ptr) g_clear_pointer ((object_ptr), gst_mini_object_unref)
@@ -465,7 +465,9 @@ gst_object_dispatch_properties_changed (GObject * object,
     debug_name = "";
 #endif
 
-  /* now let the parent dispatch those, too */
+  /* now let the parent dispatch those, too. The detail is the name quark
+   * of the pspec, which unlike g_quark_from_string() doesn't need the global
+   * quark lock. Without handlers, the emission itself is cheap. */
   parent = gst_object_get_parent (gst_object);
   while (parent) {
     for (i = 0; i < n_pspecs; i++) {
@@ -473,7 +475,7 @@ gst_object_dispatch_properties_changed (GObject * object,
           "deep notification from %s (%s)", debug_name, pspecs[i]->name);
 
       g_signal_emit (parent, gst_object_signals[DEEP_NOTIFY],
-          g_quark_from_string (pspecs[i]->name), gst_object, pspecs[i]);
+          g_param_spec_get_name_quark (pspecs[i]), gst_object, pspecs[i]);
     }
 
     old_parent = parent;
@@ -1159,6 +1161,103 @@ gst_object_sync_values (GstObject * object, GstClockTime timestamp)
   return ret;
 }
 
+/**
+ * gst_object_sync_values_batch:
+ * @object: the object that has controlled properties
+ * @timestamp: the time that should be processed
+ *
+ * Like gst_object_sync_values(), but computes the values of all control
+ * bindings first, with the object lock taken once, and then applies them
+ * directly through the set_property implementation of the object.
+ *
+ * No #GObject::notify signals are emitted for the properties changed this way
+ * and the values are not validated against the #GParamSpec of the property
+ * again. This is meant for elements that have many controlled properties and
+ * sync them for every buffer, and that don't rely on the notifications.
+ *
+ * Control bindings that don't implement
+ * #GstControlBindingClass::get_sync_value are synced like with
+ * gst_object_sync_values().
+ *
+ * Returns: %TRUE if the controller values could be applied to the object
+ * properties, %FALSE otherwise
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_object_sync_values_batch (GstObject * object, GstClockTime timestamp)
+{
+  GstControlBinding **bindings;
+  GValue *values;
+  GstClockTime last_sync;
+  GList *node;
+  guint i, n = 0, n_bindings;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail (GST_IS_OBJECT (object), FALSE);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (timestamp), FALSE);
+
+  GST_LOG_OBJECT (object, "sync_values_batch");
+  if (!object->control_bindings)
+    return TRUE;
+
+  GST_OBJECT_LOCK (object);
+  n_bindings = g_list_length (object->control_bindings);
+  bindings = n_bindings > 64 ? g_new (GstControlBinding *, n_bindings) :
+      g_newa (GstControlBinding *, n_bindings);
+  values = n_bindings > 64 ? g_new0 (GValue, n_bindings) :
+      g_newa (GValue, n_bindings);
+  if (n_bindings <= 64)
+    memset (values, 0, n_bindings * sizeof (GValue));
+
+  last_sync = object->last_sync;
+  for (node = object->control_bindings; node; node = g_list_next (node)) {
+    GstControlBinding *binding = node->data;
+    GstControlBindingClass *klass = GST_CONTROL_BINDING_GET_CLASS (binding);
+
+    if (binding->disabled)
+      continue;
+
+    if (klass->get_sync_value == NULL) {
+      /* synced after releasing the lock, values[n] stays unset */
+      bindings[n++] = gst_object_ref (binding);
+      continue;
+    }
+
+    ret &= klass->get_sync_value (binding, timestamp, last_sync, &values[n]);
+    if (G_IS_VALUE (&values[n]))
+      bindings[n++] = gst_object_ref (binding);
+  }
+  object->last_sync = timestamp;
+  GST_OBJECT_UNLOCK (object);
+
+  g_object_freeze_notify ((GObject *) object);
+  for (i = 0; i < n; i++) {
+    GstControlBinding *binding = bindings[i];
+
+    if (G_IS_VALUE (&values[i])) {
+      GParamSpec *pspec = binding->pspec;
+      GObjectClass *klass = g_type_class_peek (pspec->owner_type);
+
+      klass->set_property ((GObject *) object, pspec->param_id, &values[i],
+          pspec);
+      g_value_unset (&values[i]);
+    } else {
+      ret &= gst_control_binding_sync_values (binding, object, timestamp,
+          last_sync);
+    }
+    gst_object_unref (binding);
+  }
+  g_object_thaw_notify ((GObject *) object);
+
+  if (n_bindings > 64) {
+    g_free (bindings);
+    g_free (values);
+  }
+
+  return ret;
+}
+
 
 /**
  * gst_object_has_active_control_bindings:
@@ -1451,6 +1550,55 @@ gst_object_get_g_value_array (GstObject * object, const gchar * property_name,
   return res;
 }
 
+/**
+ * gst_object_get_value_arrays: (skip)
+ * @object: the object that has controlled properties
+ * @n_properties: the number of properties
+ * @property_names: (array length=n_properties): the names of the properties
+ *     to get
+ * @timestamp: the time that should be processed
+ * @interval: the time spacing between subsequent values
+ * @n_values: the number of values per property
+ * @values: (array length=n_properties): arrays to put the control-values in,
+ *     one per property
+ *
+ * Gets @n_values values for each of the given controlled properties starting
+ * at the requested time, like gst_object_get_value_array() does for a single
+ * property. The object lock is only taken once for all properties, which is
+ * useful for elements that process blocks of samples and have many
+ * controlled properties.
+ *
+ * Returns: %TRUE if all arrays could be filled, %FALSE otherwise
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_object_get_value_arrays (GstObject * object, guint n_properties,
+    const gchar ** property_names, GstClockTime timestamp,
+    GstClockTime interval, guint n_values, gpointer * values)
+{
+  gboolean res = TRUE;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_OBJECT (object), FALSE);
+  g_return_val_if_fail (n_properties == 0 || property_names, FALSE);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (timestamp), FALSE);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (interval), FALSE);
+  g_return_val_if_fail (n_properties == 0 || values, FALSE);
+
+  GST_OBJECT_LOCK (object);
+  for (i = 0; i < n_properties; i++) {
+    GstControlBinding *binding;
+
+    binding = gst_object_find_control_binding (object, property_names[i]);
+    if (!binding || !gst_control_binding_get_value_array (binding, timestamp,
+            interval, n_values, values[i]))
+      res = FALSE;
+  }
+  GST_OBJECT_UNLOCK (object);
+  return res;
+}
+
 
 /**
  * gst_object_get_control_rate:
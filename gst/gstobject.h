@@ -286,6 +286,9 @@ GstClockTime    gst_object_suggest_next_sync      (GstObject * object);
 GST_API
 gboolean        gst_object_sync_values            (GstObject * object, GstClockTime timestamp);
 
+GST_API
+gboolean        gst_object_sync_values_batch      (GstObject * object, GstClockTime timestamp);
+
 GST_API
 gboolean        gst_object_has_active_control_bindings   (GstObject *object);
 
@@ -319,6 +322,11 @@ gboolean        gst_object_get_g_value_array      (GstObject * object, const gch
                                                    GstClockTime timestamp, GstClockTime interval,
                                                    guint n_values, GValue *values);
 GST_API
+gboolean        gst_object_get_value_arrays       (GstObject * object, guint n_properties,
+                                                   const gchar ** property_names,
+                                                   GstClockTime timestamp, GstClockTime interval,
+                                                   guint n_values, gpointer * values);
+GST_API
 GstClockTime    gst_object_get_control_rate       (GstObject * object);
 
 GST_API
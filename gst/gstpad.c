@@ -91,6 +91,7 @@
 
 #include "gstpad.h"
 #include "gstpadtemplate.h"
+#include "gstghostpad.h"
 #include "gstenumtypes.h"
 #include "gstutils.h"
 #include "gstinfo.h"
@@ -132,15 +133,38 @@ typedef struct
   GstEvent *event;
 } PadEvent;
 
+/* last answer of a caps or accept-caps query on the peer, see
+ * GST_PAD_FLAG_CACHE_CAPS. @caps is the filter of the caps query or the caps
+ * of the accept-caps query. The entry is only valid when @cookie matches the
+ * query_cache_cookie of the pad */
+typedef struct
+{
+  guint cookie;
+  gboolean valid;
+  GstCaps *caps;
+  GstCaps *result;
+  gboolean accepted;
+} QueryCacheEntry;
+
+/* the core sticky event types have a slot with the index of their first
+ * event in the events array, -1 if there is none */
+#define N_EVENT_SLOTS 13
+
 struct _GstPadPrivate
 {
   guint events_cookie;
   GArray *events;
+  gint16 event_slots[N_EVENT_SLOTS];
   guint last_cookie;
 
   gint using;
   guint probe_list_cookie;
 
+  /* union of the masks of all installed probes. Written with the object
+   * lock held, read atomically so that the data passing functions can skip
+   * the probe list when no installed probe can match */
+  guint probe_mask;
+
   /* counter of how many idle probes are running directly from the add_probe
    * call. Used to block any data flowing in the pad while the idle callback
    * Doesn't finish its work */
@@ -150,8 +174,16 @@ struct _GstPadPrivate
    * by a single thread at a time. Protected by the object lock */
   GCond activation_cond;
   gboolean in_activation;
+
+  /* generation of the peer query cache, bumped with the object lock held
+   * whenever cached query answers could have become stale */
+  guint query_cache_cookie;
+  QueryCacheEntry caps_cache;
+  QueryCacheEntry accept_caps_cache;
 };
 
+#define QUERY_CACHE_INVALIDATE(pad) ((pad)->priv->query_cache_cookie++)
+
 typedef struct
 {
   GHook hook;
@@ -417,6 +449,7 @@ gst_pad_init (GstPad * pad)
   g_hook_list_init (&pad->probes, sizeof (GstProbe));
 
   pad->priv->events = g_array_sized_new (FALSE, TRUE, sizeof (PadEvent), 16);
+  memset (pad->priv->event_slots, 0xff, sizeof (pad->priv->event_slots));
   pad->priv->events_cookie = 0;
   pad->priv->last_cookie = -1;
   g_cond_init (&pad->priv->activation_cond);
@@ -424,6 +457,75 @@ gst_pad_init (GstPad * pad)
   pad->ABI.abi.last_flowret = GST_FLOW_FLUSHING;
 }
 
+static inline gint
+event_slot (GstEventType type)
+{
+  switch (type) {
+    case GST_EVENT_STREAM_START:
+      return 0;
+    case GST_EVENT_CAPS:
+      return 1;
+    case GST_EVENT_SEGMENT:
+      return 2;
+    case GST_EVENT_STREAM_COLLECTION:
+      return 3;
+    case GST_EVENT_TAG:
+      return 4;
+    case GST_EVENT_BUFFERSIZE:
+      return 5;
+    case GST_EVENT_SINK_MESSAGE:
+      return 6;
+    case GST_EVENT_STREAM_GROUP_DONE:
+      return 7;
+    case GST_EVENT_EOS:
+      return 8;
+    case GST_EVENT_TOC:
+      return 9;
+    case GST_EVENT_PROTECTION:
+      return 10;
+    case GST_EVENT_INSTANT_RATE_CHANGE:
+      return 11;
+    case GST_EVENT_CUSTOM_DOWNSTREAM_STICKY:
+      return 12;
+    default:
+      return -1;
+  }
+}
+
+/* update the slots after events were inserted or removed. should be called
+ * with object lock */
+static void
+update_event_slots (GstPad * pad)
+{
+  GArray *events = pad->priv->events;
+  gint16 *slots = pad->priv->event_slots;
+  guint i;
+
+  memset (slots, 0xff, sizeof (pad->priv->event_slots));
+
+  for (i = 0; i < events->len; i++) {
+    PadEvent *ev = &g_array_index (events, PadEvent, i);
+    gint slot;
+
+    if (ev->event == NULL)
+      continue;
+
+    slot = event_slot (GST_EVENT_TYPE (ev->event));
+    if (slot >= 0 && slots[slot] < 0)
+      slots[slot] = i;
+  }
+}
+
+/* index in the events array from which on to look for an event of @type, or
+ * -1 if there is none. should be called with object lock */
+static inline gint
+first_event_index (GstPad * pad, GstEventType type)
+{
+  gint slot = event_slot (type);
+
+  return slot >= 0 ? pad->priv->event_slots[slot] : 0;
+}
+
 /* called when setting the pad inactive. It removes all sticky events from
  * the pad. must be called with object lock */
 static void
@@ -450,6 +552,7 @@ remove_events (GstPad * pad)
 
   GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_PENDING_EVENTS);
   g_array_set_size (events, 0);
+  memset (pad->priv->event_slots, 0xff, sizeof (pad->priv->event_slots));
   pad->priv->events_cookie++;
 
   if (notify) {
@@ -467,13 +570,18 @@ static PadEvent *
 find_event_by_type (GstPad * pad, GstEventType type, guint idx)
 {
   guint i, len;
+  gint first;
   GArray *events;
   PadEvent *ev;
 
+  first = first_event_index (pad, type);
+  if (first < 0)
+    return NULL;
+
   events = pad->priv->events;
   len = events->len;
 
-  for (i = 0; i < len; i++) {
+  for (i = first; i < len; i++) {
     ev = &g_array_index (events, PadEvent, i);
     if (ev->event == NULL)
       continue;
@@ -496,13 +604,18 @@ static PadEvent *
 find_event (GstPad * pad, GstEvent * event)
 {
   guint i, len;
+  gint first;
   GArray *events;
   PadEvent *ev;
 
+  first = first_event_index (pad, GST_EVENT_TYPE (event));
+  if (first < 0)
+    return NULL;
+
   events = pad->priv->events;
   len = events->len;
 
-  for (i = 0; i < len; i++) {
+  for (i = first; i < len; i++) {
     ev = &g_array_index (events, PadEvent, i);
     if (event == ev->event)
       goto found;
@@ -519,13 +632,19 @@ static void
 remove_event_by_type (GstPad * pad, GstEventType type)
 {
   guint i, len;
+  gint first;
   GArray *events;
   PadEvent *ev;
+  gboolean removed = FALSE;
+
+  first = first_event_index (pad, type);
+  if (first < 0)
+    return;
 
   events = pad->priv->events;
   len = events->len;
 
-  i = 0;
+  i = first;
   while (i < len) {
     ev = &g_array_index (events, PadEvent, i);
     if (ev->event == NULL)
@@ -540,11 +659,15 @@ remove_event_by_type (GstPad * pad, GstEventType type)
     g_array_remove_index (events, i);
     len--;
     pad->priv->events_cookie++;
+    removed = TRUE;
     continue;
 
   next:
     i++;
   }
+
+  if (removed)
+    update_event_slots (pad);
 }
 
 /* check all events on srcpad against those on sinkpad. All events that are not
@@ -624,6 +747,7 @@ restart:
         /* function unreffed and set the event to NULL, remove it */
         gst_event_unref (ev->event);
         g_array_remove_index (events, i);
+        update_event_slots (pad);
         len--;
         cookie = ++pad->priv->events_cookie;
         continue;
@@ -698,6 +822,14 @@ get_pad_caps (GstPad * pad)
   return caps;
 }
 
+static void
+query_cache_entry_clear (QueryCacheEntry * entry)
+{
+  gst_caps_replace (&entry->caps, NULL);
+  gst_caps_replace (&entry->result, NULL);
+  entry->valid = FALSE;
+}
+
 static void
 gst_pad_dispose (GObject * object)
 {
@@ -767,6 +899,8 @@ gst_pad_finalize (GObject * object)
   g_cond_clear (&pad->block_cond);
   g_cond_clear (&pad->priv->activation_cond);
   g_array_free (pad->priv->events, TRUE);
+  query_cache_entry_clear (&pad->priv->caps_cache);
+  query_cache_entry_clear (&pad->priv->accept_caps_cache);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1208,6 +1342,10 @@ activate_mode_internal (GstPad * pad, GstObject * parent, GstPadMode mode,
   if (active)
     GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
 
+  GST_OBJECT_LOCK (pad);
+  QUERY_CACHE_INVALIDATE (pad);
+  GST_OBJECT_UNLOCK (pad);
+
   /* pre_activate returns TRUE if we weren't already in the process of
    * switching to the 'new' mode */
   if (pre_activate (pad, new)) {
@@ -1363,6 +1501,52 @@ gst_pad_is_active (GstPad * pad)
   return result;
 }
 
+/* call with the object lock */
+static void
+update_probe_mask (GstPad * pad)
+{
+  GHook *hook;
+  guint mask = 0;
+
+  for (hook = pad->probes.hooks; hook; hook = hook->next) {
+    if (G_HOOK_IS_VALID (hook))
+      mask |= (hook->flags >> G_HOOK_FLAG_USER_SHIFT);
+  }
+  g_atomic_int_set (&pad->priv->probe_mask, mask);
+}
+
+/* check if any of the installed probes could possibly match a probe of
+ * @type. This mirrors the checks done in probe_hook_marshal() on the union
+ * of all probe masks, so it can give false positives but never false
+ * negatives. */
+static inline gboolean
+probe_mask_can_match (GstPad * pad, GstPadProbeType type)
+{
+  guint mask = g_atomic_int_get (&pad->priv->probe_mask);
+
+  /* a running idle probe needs to be waited for in do_probe_callbacks() */
+  if (G_UNLIKELY (pad->priv->idle_running > 0))
+    return TRUE;
+
+  if ((mask & GST_PAD_PROBE_TYPE_SCHEDULING & type) == 0)
+    return FALSE;
+
+  if ((type & GST_PAD_PROBE_TYPE_BLOCKING) &&
+      (mask & GST_PAD_PROBE_TYPE_BLOCKING & type) == 0)
+    return FALSE;
+
+  if (type & GST_PAD_PROBE_TYPE_PUSH) {
+    if ((type & GST_PAD_PROBE_TYPE_IDLE) == 0
+        && (mask & _PAD_PROBE_TYPE_ALL_BOTH_AND_FLUSH & type) == 0)
+      return FALSE;
+  } else if ((type & GST_PAD_PROBE_TYPE_BLOCKING) == 0
+      && (mask & _PAD_PROBE_TYPE_ALL_BOTH_AND_FLUSH & type) == 0) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 static void
 cleanup_hook (GstPad * pad, GHook * hook)
 {
@@ -1394,6 +1578,7 @@ cleanup_hook (GstPad * pad, GHook * hook)
   }
   g_hook_destroy_link (&pad->probes, hook);
   pad->num_probes--;
+  update_probe_mask (pad);
 }
 
 /**
@@ -1457,6 +1642,8 @@ gst_pad_add_probe (GstPad * pad, GstPadProbeType mask,
   /* add the probe */
   g_hook_append (&pad->probes, hook);
   pad->num_probes++;
+  g_atomic_int_set (&pad->priv->probe_mask,
+      g_atomic_int_get (&pad->priv->probe_mask) | mask);
   /* incremenent cookie so that the new hook gets called */
   pad->priv->probe_list_cookie++;
 
@@ -1697,6 +1884,7 @@ gst_pad_mark_reconfigure (GstPad * pad)
 
   GST_OBJECT_LOCK (pad);
   GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
+  QUERY_CACHE_INVALIDATE (pad);
   GST_OBJECT_UNLOCK (pad);
 }
 
@@ -2180,6 +2368,8 @@ no_sink_parent:
   /* first clear peers */
   GST_PAD_PEER (srcpad) = NULL;
   GST_PAD_PEER (sinkpad) = NULL;
+  QUERY_CACHE_INVALIDATE (srcpad);
+  QUERY_CACHE_INVALIDATE (sinkpad);
 
   GST_OBJECT_UNLOCK (sinkpad);
   GST_OBJECT_UNLOCK (srcpad);
@@ -2538,6 +2728,8 @@ gst_pad_link_full (GstPad * srcpad, GstPad * sinkpad, GstPadLinkCheck flags)
   /* must set peers before calling the link function */
   GST_PAD_PEER (srcpad) = sinkpad;
   GST_PAD_PEER (sinkpad) = srcpad;
+  QUERY_CACHE_INVALIDATE (srcpad);
+  QUERY_CACHE_INVALIDATE (sinkpad);
 
   /* check events, when something is different, mark pending */
   schedule_events (srcpad, sinkpad);
@@ -2624,6 +2816,8 @@ link_failed:
 
     GST_PAD_PEER (srcpad) = NULL;
     GST_PAD_PEER (sinkpad) = NULL;
+    QUERY_CACHE_INVALIDATE (srcpad);
+    QUERY_CACHE_INVALIDATE (sinkpad);
 
     GST_OBJECT_UNLOCK (sinkpad);
     GST_OBJECT_UNLOCK (srcpad);
@@ -2660,6 +2854,7 @@ gst_pad_set_pad_template (GstPad * pad, GstPadTemplate * templ)
   GST_OBJECT_LOCK (pad);
   template_p = &pad->padtemplate;
   gst_object_replace ((GstObject **) template_p, (GstObject *) templ);
+  QUERY_CACHE_INVALIDATE (pad);
   GST_OBJECT_UNLOCK (pad);
 
   if (templ)
@@ -2941,9 +3136,6 @@ gst_pad_iterate_internal_links_default (GstPad * pad, GstObject * parent)
 {
   GstIterator *res;
   GList **padlist;
-  guint32 *cookie;
-  GMutex *lock;
-  gpointer owner;
   GstElement *eparent;
 
   g_return_val_if_fail (GST_IS_PAD (pad), NULL);
@@ -2967,14 +3159,13 @@ gst_pad_iterate_internal_links_default (GstPad * pad, GstObject * parent)
 
   GST_DEBUG_OBJECT (pad, "Making iterator");
 
-  cookie = &eparent->pads_cookie;
-  owner = eparent;
-  lock = GST_OBJECT_GET_LOCK (eparent);
-
-  res = gst_iterator_new_list (GST_TYPE_PAD,
-      lock, cookie, padlist, (GObject *) owner, NULL);
+  /* a snapshot, so that forwarding doesn't resync when request pads are
+   * added or removed concurrently */
+  GST_OBJECT_LOCK (eparent);
+  res = gst_iterator_new_list_snapshot (GST_TYPE_PAD, *padlist, NULL);
+  GST_OBJECT_UNLOCK (eparent);
 
-  gst_object_unref (owner);
+  gst_object_unref (eparent);
 
   return res;
 
@@ -3736,7 +3927,8 @@ already_called:
 /* a probe that does not take or return any data */
 #define PROBE_NO_DATA(pad,mask,label,defaultval)                \
   G_STMT_START {						\
-    if (G_UNLIKELY (pad->num_probes)) {				\
+    if (G_UNLIKELY (pad->num_probes) &&				\
+        probe_mask_can_match (pad, mask)) {				\
       GstFlowReturn pval = defaultval;				\
       /* pass NULL as the data item */                          \
       GstPadProbeInfo info = { mask, 0, NULL, 0, 0 };		\
@@ -3749,7 +3941,8 @@ already_called:
 
 #define PROBE_FULL(pad,mask,data,offs,size,label,handleable,handle_label) \
   G_STMT_START {							\
-    if (G_UNLIKELY (pad->num_probes)) {					\
+    if (G_UNLIKELY (pad->num_probes) &&					\
+        probe_mask_can_match (pad, mask)) {				\
       /* pass the data item */						\
       GstPadProbeInfo info = { mask, 0, data, offs, size };		\
       info.ABI.abi.flow_ret = GST_FLOW_OK;				\
@@ -4173,6 +4366,7 @@ gst_pad_query (GstPad * pad, GstQuery * query)
   GST_DEBUG_OBJECT (pad, "doing query %p (%s)", query,
       GST_QUERY_TYPE_NAME (query));
   GST_TRACER_PAD_QUERY_PRE (pad, query);
+  GST_SDT_PROBE3 (pad_query, pad, query, GST_QUERY_TYPE (query));
 
   serialized = GST_QUERY_IS_SERIALIZED (query);
   if (G_UNLIKELY (serialized))
@@ -4196,6 +4390,7 @@ gst_pad_query (GstPad * pad, GstQuery * query)
   GST_DEBUG_OBJECT (pad, "sent query %p (%s), result %d", query,
       GST_QUERY_TYPE_NAME (query), res);
   GST_TRACER_PAD_QUERY_POST (pad, query, res);
+  GST_SDT_PROBE3 (pad_query_done, pad, query, res);
 
   if (res != TRUE)
     goto query_failed;
@@ -4262,6 +4457,87 @@ probe_stopped:
   }
 }
 
+/* call with the object lock. Returns the cache entry for @query and its
+ * filter or accept caps in @caps, or %NULL when @query is not cached */
+static QueryCacheEntry *
+query_cache_get_entry (GstPad * pad, GstQuery * query, GstCaps ** caps)
+{
+  GstPad *peer = GST_PAD_PEER (pad);
+
+  if (!GST_PAD_IS_SRC (pad) || peer == NULL)
+    return NULL;
+
+  /* probes could see or change the query on the way, don't hide it from
+   * them */
+  if ((g_atomic_int_get (&pad->priv->probe_mask) |
+          g_atomic_int_get (&peer->priv->probe_mask)) &
+      GST_PAD_PROBE_TYPE_QUERY_BOTH)
+    return NULL;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+      gst_query_parse_caps (query, caps);
+      return &pad->priv->caps_cache;
+    case GST_QUERY_ACCEPT_CAPS:
+      gst_query_parse_accept_caps (query, caps);
+      return &pad->priv->accept_caps_cache;
+    default:
+      return NULL;
+  }
+}
+
+static inline gboolean
+query_cache_entry_matches (QueryCacheEntry * entry, guint cookie,
+    GstCaps * caps)
+{
+  if (!entry->valid || entry->cookie != cookie)
+    return FALSE;
+
+  if (entry->caps == caps)
+    return TRUE;
+  if (entry->caps == NULL || caps == NULL)
+    return FALSE;
+
+  return gst_caps_is_strictly_equal (entry->caps, caps);
+}
+
+/* call with the object lock */
+static void
+query_cache_entry_store (QueryCacheEntry * entry, guint cookie,
+    GstQuery * query, GstCaps * caps)
+{
+  query_cache_entry_clear (entry);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CAPS) {
+    GstCaps *result;
+
+    gst_query_parse_caps_result (query, &result);
+    if (result == NULL)
+      return;
+    gst_caps_replace (&entry->result, result);
+  } else {
+    gst_query_parse_accept_caps_result (query, &entry->accepted);
+  }
+
+  /* keep our own copy of the caps so that the caller can still modify
+   * them, interned caps are immutable and compare by pointer */
+  if (caps)
+    gst_caps_take (&entry->caps, gst_caps_is_interned (caps) ?
+        gst_caps_ref (caps) : gst_caps_copy (caps));
+
+  entry->cookie = cookie;
+  entry->valid = TRUE;
+}
+
+static void
+query_cache_entry_answer (QueryCacheEntry * entry, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CAPS)
+    gst_query_set_caps_result (query, entry->result);
+  else
+    gst_query_set_accept_caps_result (query, entry->accepted);
+}
+
 /**
  * gst_pad_peer_query:
  * @pad: a #GstPad to invoke the peer query on.
@@ -4282,6 +4558,9 @@ gst_pad_peer_query (GstPad * pad, GstQuery * query)
   GstPadProbeType type;
   gboolean res, serialized;
   GstFlowReturn ret;
+  QueryCacheEntry *cache = NULL;
+  GstCaps *cache_caps = NULL;
+  guint cache_cookie = 0;
 
   g_return_val_if_fail (GST_IS_PAD (pad), FALSE);
   g_return_val_if_fail (GST_IS_QUERY (query), FALSE);
@@ -4310,6 +4589,13 @@ gst_pad_peer_query (GstPad * pad, GstQuery * query)
       goto sticky_failed;
   }
 
+  if (GST_PAD_IS_CACHE_CAPS (pad) &&
+      (cache = query_cache_get_entry (pad, query, &cache_caps))) {
+    cache_cookie = pad->priv->query_cache_cookie;
+    if (query_cache_entry_matches (cache, cache_cookie, cache_caps))
+      goto cache_hit;
+  }
+
   PROBE_PUSH (pad, type | GST_PAD_PROBE_TYPE_PUSH |
       GST_PAD_PROBE_TYPE_BLOCK, query, probe_stopped);
   PROBE_PUSH (pad, type | GST_PAD_PROBE_TYPE_PUSH, query, probe_stopped);
@@ -4329,11 +4615,23 @@ gst_pad_peer_query (GstPad * pad, GstQuery * query)
     goto query_failed;
 
   GST_OBJECT_LOCK (pad);
+  /* only store the answer when nothing changed while the query was running */
+  if (cache && cache_cookie == pad->priv->query_cache_cookie)
+    query_cache_entry_store (cache, cache_cookie, query, cache_caps);
   PROBE_PUSH (pad, type | GST_PAD_PROBE_TYPE_PULL, query, probe_stopped);
   GST_OBJECT_UNLOCK (pad);
 
   return res;
 
+cache_hit:
+  {
+    GST_DEBUG_OBJECT (pad, "answering %s query from cache",
+        GST_QUERY_TYPE_NAME (query));
+    query_cache_entry_answer (cache, query);
+    GST_OBJECT_UNLOCK (pad);
+    return TRUE;
+  }
+
   /* ERRORS */
 wrong_direction:
   {
@@ -4444,7 +4742,9 @@ gst_pad_chain_data_unchecked (GstPad * pad, GstPadProbeType type, void *data)
         "calling chainfunction &%s with buffer %" GST_PTR_FORMAT,
         GST_DEBUG_FUNCPTR_NAME (chainfunc), GST_BUFFER (data));
 
+    GST_SDT_PROBE2 (pad_chain, pad, data);
     ret = chainfunc (pad, parent, GST_BUFFER_CAST (data));
+    GST_SDT_PROBE2 (pad_chain_done, pad, ret);
 
     GST_CAT_DEBUG_OBJECT (GST_CAT_SCHEDULING, pad,
         "called chainfunction &%s with buffer %p, returned %s",
@@ -4459,7 +4759,9 @@ gst_pad_chain_data_unchecked (GstPad * pad, GstPadProbeType type, void *data)
         "calling chainlistfunction &%s",
         GST_DEBUG_FUNCPTR_NAME (chainlistfunc));
 
+    GST_SDT_PROBE2 (pad_chain_list, pad, data);
     ret = chainlistfunc (pad, parent, GST_BUFFER_LIST_CAST (data));
+    GST_SDT_PROBE2 (pad_chain_list_done, pad, ret);
 
     GST_CAT_DEBUG_OBJECT (GST_CAT_SCHEDULING, pad,
         "called chainlistfunction &%s, returned %s",
@@ -4649,6 +4951,74 @@ gst_pad_chain_list (GstPad * pad, GstBufferList * list)
       GST_PAD_PROBE_TYPE_BUFFER_LIST | GST_PAD_PROBE_TYPE_PUSH, list);
 }
 
+/* whether @pad only forwards the data to its internal pad with the default
+ * proxy pad chain functions, like the sink pads of ghost pads and the
+ * internal pads of source ghost pads do. The tracers expect to see the
+ * pushes on the internal pads, they disable the shortcut. */
+static inline gboolean
+gst_pad_is_default_proxy (GstPad * pad, GstPadProbeType type)
+{
+#ifndef GST_DISABLE_GST_TRACER_HOOKS
+  if (GST_TRACER_IS_ENABLED)
+    return FALSE;
+#endif
+
+  if (G_LIKELY (type & GST_PAD_PROBE_TYPE_BUFFER))
+    return GST_PAD_CHAINFUNC (pad) == gst_proxy_pad_chain_default;
+  else
+    return GST_PAD_CHAINLISTFUNC (pad) == gst_proxy_pad_chain_list_default;
+}
+
+static GstFlowReturn gst_pad_push_data (GstPad * pad, GstPadProbeType type,
+    void *data);
+
+/* push @data on the internal pad of the proxy pad @pad directly instead of
+ * going through the chain function of @pad. This skips acquiring the
+ * parent of @pad and its internal pad and the dispatch through
+ * gst_pad_push(). Falls back to chaining normally when @pad has probes or
+ * can't take the data. */
+static GstFlowReturn
+gst_pad_proxy_data (GstPad * pad, GstPadProbeType type, void *data)
+{
+  GstFlowReturn ret;
+  GstPad *internal;
+
+  GST_PAD_STREAM_LOCK (pad);
+
+  GST_OBJECT_LOCK (pad);
+  if (G_UNLIKELY (pad->num_probes || GST_PAD_IS_FLUSHING (pad)
+          || GST_PAD_IS_EOS (pad) || GST_PAD_MODE (pad) != GST_PAD_MODE_PUSH
+          || GST_OBJECT_PARENT (pad) == NULL))
+    goto slow_path;
+
+  internal = _priv_gst_proxy_pad_get_internal_unlocked (pad);
+  if (G_UNLIKELY (internal == NULL))
+    goto slow_path;
+
+  gst_object_ref (internal);
+  GST_OBJECT_UNLOCK (pad);
+
+  GST_CAT_LOG_OBJECT (GST_CAT_SCHEDULING, pad,
+      "pushing %" GST_PTR_FORMAT " on internal pad", data);
+
+  ret = gst_pad_push_data (internal, type, data);
+  gst_object_unref (internal);
+
+  pad->ABI.abi.last_flowret = ret;
+  GST_PAD_STREAM_UNLOCK (pad);
+
+  return ret;
+
+slow_path:
+  {
+    GST_OBJECT_UNLOCK (pad);
+    ret = gst_pad_chain_data_unchecked (pad, type, data);
+    GST_PAD_STREAM_UNLOCK (pad);
+
+    return ret;
+  }
+}
+
 static GstFlowReturn
 gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
 {
@@ -4685,18 +5055,21 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
   if (G_UNLIKELY ((ret = check_sticky (pad, NULL))) != GST_FLOW_OK)
     goto events_error;
 
-  /* do block probes */
-  PROBE_HANDLE (pad, type | GST_PAD_PROBE_TYPE_BLOCK, data, probe_stopped,
-      probe_handled);
+  if (G_UNLIKELY (pad->num_probes)) {
+    /* do block probes */
+    PROBE_HANDLE (pad, type | GST_PAD_PROBE_TYPE_BLOCK, data, probe_stopped,
+        probe_handled);
 
-  /* recheck sticky events because the probe might have cause a relink */
-  if (G_UNLIKELY ((ret = check_sticky (pad, NULL))) != GST_FLOW_OK)
-    goto events_error;
+    /* recheck sticky events because the probe might have cause a relink */
+    if (G_UNLIKELY ((ret = check_sticky (pad, NULL))) != GST_FLOW_OK)
+      goto events_error;
 
-  /* do post-blocking probes */
-  PROBE_HANDLE (pad, type, data, probe_stopped, probe_handled);
+    /* do post-blocking probes */
+    PROBE_HANDLE (pad, type, data, probe_stopped, probe_handled);
+  }
 
-  /* recheck sticky events because the probe might have cause a relink */
+  /* recheck sticky events because the probe might have cause a relink, and
+   * pushing the sticky events above releases the object lock */
   if (G_UNLIKELY ((ret = check_sticky (pad, NULL))) != GST_FLOW_OK)
     goto events_error;
 
@@ -4708,7 +5081,10 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
   pad->priv->using++;
   GST_OBJECT_UNLOCK (pad);
 
-  ret = gst_pad_chain_data_unchecked (peer, type, data);
+  if (gst_pad_is_default_proxy (peer, type))
+    ret = gst_pad_proxy_data (peer, type, data);
+  else
+    ret = gst_pad_chain_data_unchecked (peer, type, data);
   data = NULL;
 
   gst_object_unref (peer);
@@ -4827,8 +5203,10 @@ gst_pad_push (GstPad * pad, GstBuffer * buffer)
   g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
 
   GST_TRACER_PAD_PUSH_PRE (pad, buffer);
+  GST_SDT_PROBE2 (pad_push, pad, buffer);
   res = gst_pad_push_data (pad,
       GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_PUSH, buffer);
+  GST_SDT_PROBE2 (pad_push_done, pad, res);
   GST_TRACER_PAD_PUSH_POST (pad, res);
   return res;
 }
@@ -5278,6 +5656,7 @@ store_sticky_event (GstPad * pad, GstEvent * event)
   gboolean res = FALSE;
   GQuark name_id = 0;
   gboolean insert = TRUE;
+  gint first;
 
   type = GST_EVENT_TYPE (event);
 
@@ -5309,7 +5688,11 @@ store_sticky_event (GstPad * pad, GstEvent * event)
   events = pad->priv->events;
   len = events->len;
 
-  for (i = 0; i < len; i++) {
+  /* start at the first event of the same type if there is one, all events
+   * before it have a lower type */
+  first = first_event_index (pad, type);
+
+  for (i = MAX (first, 0); i < len; i++) {
     PadEvent *ev = &g_array_index (events, PadEvent, i);
 
     if (ev->event == NULL)
@@ -5320,6 +5703,19 @@ store_sticky_event (GstPad * pad, GstEvent * event)
       if (name_id && !gst_event_has_name_id (ev->event, name_id))
         continue;
 
+      /* a CAPS event with the same interned caps does not need to be stored
+       * and sent again */
+      if (type == GST_EVENT_CAPS && ev->event != event) {
+        GstCaps *old_caps, *new_caps;
+
+        gst_event_parse_caps (ev->event, &old_caps);
+        gst_event_parse_caps (event, &new_caps);
+        if (old_caps == new_caps && gst_caps_is_interned (new_caps)) {
+          insert = FALSE;
+          break;
+        }
+      }
+
       /* overwrite */
       if ((res = gst_event_replace (&ev->event, event)))
         ev->received = FALSE;
@@ -5347,6 +5743,7 @@ store_sticky_event (GstPad * pad, GstEvent * event)
     ev.event = gst_event_ref (event);
     ev.received = FALSE;
     g_array_insert_val (events, i, ev);
+    update_event_slots (pad);
     res = TRUE;
   }
 
@@ -5639,6 +6036,7 @@ gst_pad_push_event (GstPad * pad, GstEvent * event)
   g_return_val_if_fail (GST_IS_EVENT (event), FALSE);
 
   GST_TRACER_PAD_PUSH_EVENT_PRE (pad, event);
+  GST_SDT_PROBE3 (pad_push_event, pad, event, GST_EVENT_TYPE (event));
 
   if (GST_PAD_IS_SRC (pad)) {
     if (G_UNLIKELY (!GST_EVENT_IS_DOWNSTREAM (event)))
@@ -5694,6 +6092,7 @@ gst_pad_push_event (GstPad * pad, GstEvent * event)
   }
   GST_OBJECT_UNLOCK (pad);
 
+  GST_SDT_PROBE2 (pad_push_event_done, pad, res);
   GST_TRACER_PAD_PUSH_EVENT_POST (pad, res);
   return res;
 
@@ -5726,6 +6125,7 @@ eos:
     goto done;
   }
 done:
+  GST_SDT_PROBE2 (pad_push_event_done, pad, FALSE);
   GST_TRACER_PAD_PUSH_EVENT_POST (pad, FALSE);
   return FALSE;
 }
@@ -5824,8 +6224,10 @@ gst_pad_send_event_unchecked (GstPad * pad, GstEvent * event,
         goto flushing;
       break;
     case GST_EVENT_RECONFIGURE:
-      if (GST_PAD_IS_SRC (pad))
+      if (GST_PAD_IS_SRC (pad)) {
         GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
+        QUERY_CACHE_INVALIDATE (pad);
+      }
     default:
       GST_CAT_DEBUG_OBJECT (GST_CAT_EVENT, pad,
           "have event type %" GST_PTR_FORMAT, event);
@@ -699,6 +699,10 @@ typedef gboolean  (*GstPadStickyEventsForeachFunction) (GstPad *pad, GstEvent **
  *                      the template pad caps instead of query caps to
  *                      compare with the accept caps. Use this in combination
  *                      with %GST_PAD_FLAG_ACCEPT_INTERSECT. (Since: 1.6)
+ * @GST_PAD_FLAG_CACHE_CAPS: the results of the last caps and accept-caps
+ *                      query done on the peer of this source pad are cached
+ *                      and reused for identical queries until the pad is
+ *                      relinked or receives a RECONFIGURE event. (Since: 1.20)
  * @GST_PAD_FLAG_LAST: offset to define more flags
  *
  * Pad state flags
@@ -717,6 +721,7 @@ typedef enum {
   GST_PAD_FLAG_PROXY_SCHEDULING = (GST_OBJECT_FLAG_LAST << 10),
   GST_PAD_FLAG_ACCEPT_INTERSECT = (GST_OBJECT_FLAG_LAST << 11),
   GST_PAD_FLAG_ACCEPT_TEMPLATE  = (GST_OBJECT_FLAG_LAST << 12),
+  GST_PAD_FLAG_CACHE_CAPS       = (GST_OBJECT_FLAG_LAST << 13),
   /* padding */
   GST_PAD_FLAG_LAST        = (GST_OBJECT_FLAG_LAST << 16)
 } GstPadFlags;
@@ -1231,6 +1236,42 @@ struct _GstPadClass {
  * Since: 1.6
  */
 #define GST_PAD_UNSET_ACCEPT_TEMPLATE(pad) (GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_ACCEPT_TEMPLATE))
+/**
+ * GST_PAD_IS_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Check if the results of caps and accept-caps queries on the peer of @pad
+ * are cached.
+ *
+ * Since: 1.20
+ */
+#define GST_PAD_IS_CACHE_CAPS(pad)         (GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_CACHE_CAPS))
+/**
+ * GST_PAD_SET_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Set @pad to cache the result of the last caps and accept-caps query done
+ * on its peer. An identical query is then answered from the cache without
+ * calling into the downstream elements, until downstream signals a change
+ * with a RECONFIGURE event or @pad is relinked.
+ *
+ * Only use this on source pads of elements that do the same queries over and
+ * over again and when downstream is known to send RECONFIGURE events whenever
+ * the answers could change. The cache is not used while query probes are
+ * installed on @pad or its peer.
+ *
+ * Since: 1.20
+ */
+#define GST_PAD_SET_CACHE_CAPS(pad)        (GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_CACHE_CAPS))
+/**
+ * GST_PAD_UNSET_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Unset cache caps flag.
+ *
+ * Since: 1.20
+ */
+#define GST_PAD_UNSET_CACHE_CAPS(pad)      (GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_CACHE_CAPS))
 /**
  * GST_PAD_GET_STREAM_LOCK:
  * @pad: a #GstPad
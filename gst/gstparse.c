@@ -371,3 +371,148 @@ gst_parse_launch_full (const gchar * pipeline_description,
   return NULL;
 #endif
 }
+
+G_DEFINE_BOXED_TYPE (GstParseTemplate, gst_parse_template,
+    (GBoxedCopyFunc) gst_parse_template_ref,
+    (GBoxedFreeFunc) gst_parse_template_unref);
+
+/**
+ * gst_parse_template_new:
+ * @pipeline_description: the command line describing the pipeline
+ * @flags: parsing options, or #GST_PARSE_FLAG_NONE
+ * @error: the error message in case of an erroneous pipeline.
+ *
+ * Parses @pipeline_description once so that the pipeline can be created
+ * many times with gst_parse_template_instantiate() without parsing the
+ * description, looking up the element factories and deserializing the
+ * property values again.
+ *
+ * Property values can contain parameters in the form `${name}`. They are
+ * replaced with the values given to gst_parse_template_instantiate(). The
+ * properties with parameters are only checked to exist when parsing.
+ *
+ * The pipeline is created once while parsing. Unlike with gst_parse_launch(),
+ * any error makes this function fail.
+ *
+ * Returns: (transfer full) (nullable): a new #GstParseTemplate or %NULL on
+ *     failure
+ *
+ * Since: 1.20
+ */
+GstParseTemplate *
+gst_parse_template_new (const gchar * pipeline_description,
+    GstParseFlags flags, GError ** error)
+{
+#ifndef GST_DISABLE_PARSE
+  g_return_val_if_fail (pipeline_description != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  GST_CAT_INFO (GST_CAT_PIPELINE, "compiling pipeline description '%s'",
+      pipeline_description);
+
+  return priv_gst_parse_template_compile (pipeline_description, flags, error);
+#else
+  gchar *msg;
+
+  GST_WARNING ("Disabled API called");
+
+  msg = gst_error_get_message (GST_CORE_ERROR, GST_CORE_ERROR_DISABLED);
+  g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_DISABLED, "%s", msg);
+  g_free (msg);
+
+  return NULL;
+#endif
+}
+
+/**
+ * gst_parse_template_ref:
+ * @templ: a #GstParseTemplate
+ *
+ * Increases the refcount of @templ.
+ *
+ * Returns: (transfer full): @templ
+ *
+ * Since: 1.20
+ */
+GstParseTemplate *
+gst_parse_template_ref (GstParseTemplate * templ)
+{
+  g_return_val_if_fail (templ != NULL, NULL);
+
+#ifndef GST_DISABLE_PARSE
+  g_atomic_int_inc (&templ->refcount);
+#endif
+
+  return templ;
+}
+
+/**
+ * gst_parse_template_unref:
+ * @templ: (transfer full): a #GstParseTemplate
+ *
+ * Decreases the refcount of @templ, freeing it when the refcount reaches 0.
+ *
+ * Since: 1.20
+ */
+void
+gst_parse_template_unref (GstParseTemplate * templ)
+{
+  g_return_if_fail (templ != NULL);
+
+#ifndef GST_DISABLE_PARSE
+  if (g_atomic_int_dec_and_test (&templ->refcount))
+    priv_gst_parse_template_free (templ);
+#endif
+}
+
+/**
+ * gst_parse_template_instantiate:
+ * @templ: a #GstParseTemplate
+ * @params: (allow-none): values for the parameters of the description
+ * @error: the error message in case the pipeline could not be created
+ *
+ * Creates a new pipeline from @templ like gst_parse_launch_full() would
+ * create it from the description @templ was created from, with the
+ * parameters replaced by the fields of the same name in @params. String
+ * fields are used as they are, other fields are serialized first.
+ *
+ * This function can be called from any thread.
+ *
+ * Returns: (transfer floating) (nullable): a new element on success; on
+ *   failure, either %NULL or a partially-constructed bin or element will be
+ *   returned and @error will be set (unless the template was created with
+ *   #GST_PARSE_FLAG_FATAL_ERRORS, then %NULL will always be returned on
+ *   failure)
+ *
+ * Since: 1.20
+ */
+GstElement *
+gst_parse_template_instantiate (GstParseTemplate * templ,
+    const GstStructure * params, GError ** error)
+{
+#ifndef GST_DISABLE_PARSE
+  GstElement *element;
+  GError *myerror = NULL;
+
+  g_return_val_if_fail (templ != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  element = priv_gst_parse_template_instantiate (templ, params, &myerror);
+
+  if (G_UNLIKELY (myerror != NULL && element != NULL)) {
+    if ((templ->flags & GST_PARSE_FLAG_FATAL_ERRORS)) {
+      gst_object_unref (element);
+      element = NULL;
+    }
+  }
+
+  if (myerror)
+    g_propagate_error (error, myerror);
+
+  return element;
+#else
+  g_return_val_if_fail (templ != NULL, NULL);
+
+  return NULL;
+#endif
+}
@@ -111,6 +111,37 @@ void              gst_parse_context_free (GstParseContext * context);
 GST_API
 GstParseContext * gst_parse_context_copy (const GstParseContext * context);
 
+#define GST_TYPE_PARSE_TEMPLATE (gst_parse_template_get_type())
+
+/**
+ * GstParseTemplate:
+ *
+ * Opaque structure.
+ *
+ * Since: 1.20
+ */
+typedef struct _GstParseTemplate GstParseTemplate;
+
+/* parse once, instantiate many times */
+
+GST_API
+GType              gst_parse_template_get_type (void);
+
+GST_API
+GstParseTemplate * gst_parse_template_new (const gchar      * pipeline_description,
+                                           GstParseFlags      flags,
+                                           GError          ** error);
+GST_API
+GstParseTemplate * gst_parse_template_ref (GstParseTemplate * templ);
+
+GST_API
+void               gst_parse_template_unref (GstParseTemplate * templ);
+
+GST_API
+GstElement       * gst_parse_template_instantiate (GstParseTemplate   * templ,
+                                                   const GstStructure * params,
+                                                   GError            ** error) G_GNUC_MALLOC;
+
 
 /* parse functions */
 
@@ -133,6 +164,8 @@ GstElement      * gst_parse_launchv_full (const gchar     ** argv,
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstParseContext, gst_parse_context_free)
 
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstParseTemplate, gst_parse_template_unref)
+
 G_END_DECLS
 
 #endif /* __GST_PARSE_H__ */
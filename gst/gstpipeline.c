@@ -100,13 +100,15 @@ enum
 #define DEFAULT_DELAY           0
 #define DEFAULT_AUTO_FLUSH_BUS  TRUE
 #define DEFAULT_LATENCY         GST_CLOCK_TIME_NONE
+#define DEFAULT_QUERY_CACHE_TIME 0
 
 enum
 {
   PROP_0,
   PROP_DELAY,
   PROP_AUTO_FLUSH_BUS,
-  PROP_LATENCY
+  PROP_LATENCY,
+  PROP_QUERY_CACHE_TIME
 };
 
 struct _GstPipelinePrivate
@@ -127,6 +129,18 @@ struct _GstPipelinePrivate
   gdouble active_instant_rate;
   GstClockTime instant_rate_upstream_anchor;
   GstClockTime instant_rate_clock_anchor;
+
+  /* cached TIME duration and position queries, the stamps are the
+   * g_get_monotonic_time() of the query or -1 when the cache is invalid */
+  GstClockTime query_cache_time;
+  gint64 cached_duration;
+  gint64 duration_stamp;
+  gint64 cached_position;
+  gint64 position_stamp;
+  /* clock time of the position when it was queried in PLAYING */
+  GstClockTime position_clock_time;
+  /* rate of the last seek sent to the pipeline */
+  gdouble seek_rate;
 };
 
 
@@ -139,6 +153,9 @@ static void gst_pipeline_get_property (GObject * object, guint prop_id,
 static GstClock *gst_pipeline_provide_clock_func (GstElement * element);
 static GstStateChangeReturn gst_pipeline_change_state (GstElement * element,
     GstStateChange transition);
+static gboolean gst_pipeline_query (GstElement * element, GstQuery * query);
+static gboolean gst_pipeline_send_event (GstElement * element,
+    GstEvent * event);
 
 static void gst_pipeline_handle_message (GstBin * bin, GstMessage * message);
 static gboolean gst_pipeline_do_latency (GstBin * bin);
@@ -205,6 +222,27 @@ gst_pipeline_class_init (GstPipelineClass * klass)
           "Latency to configure on the pipeline", 0, G_MAXUINT64,
           DEFAULT_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPipeline:query-cache-time:
+   *
+   * Time during which TIME duration and position queries on the pipeline are
+   * answered from the result of a previous query instead of asking all the
+   * sinks again. While PLAYING, the cached position is advanced with the
+   * pipeline clock and the rate of the last seek. The cache is dropped on
+   * state changes, seeks, flushes, EOS and when the duration changes.
+   *
+   * This is meant for applications polling the position of many pipelines
+   * at a high rate. 0 disables the cache.
+   *
+   * Since: 1.20
+   **/
+  g_object_class_install_property (gobject_class, PROP_QUERY_CACHE_TIME,
+      g_param_spec_uint64 ("query-cache-time", "Query Cache Time",
+          "Time during which duration and position queries are answered "
+          "from a cache (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_QUERY_CACHE_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->dispose = gst_pipeline_dispose;
 
   gst_element_class_set_static_metadata (gstelement_class, "Pipeline object",
@@ -216,6 +254,8 @@ gst_pipeline_class_init (GstPipelineClass * klass)
       GST_DEBUG_FUNCPTR (gst_pipeline_change_state);
   gstelement_class->provide_clock =
       GST_DEBUG_FUNCPTR (gst_pipeline_provide_clock_func);
+  gstelement_class->query = GST_DEBUG_FUNCPTR (gst_pipeline_query);
+  gstelement_class->send_event = GST_DEBUG_FUNCPTR (gst_pipeline_send_event);
   gstbin_class->handle_message =
       GST_DEBUG_FUNCPTR (gst_pipeline_handle_message);
   gstbin_class->do_latency = GST_DEBUG_FUNCPTR (gst_pipeline_do_latency);
@@ -232,6 +272,10 @@ gst_pipeline_init (GstPipeline * pipeline)
   pipeline->priv->auto_flush_bus = DEFAULT_AUTO_FLUSH_BUS;
   pipeline->delay = DEFAULT_DELAY;
   pipeline->priv->latency = DEFAULT_LATENCY;
+  pipeline->priv->query_cache_time = DEFAULT_QUERY_CACHE_TIME;
+  pipeline->priv->duration_stamp = -1;
+  pipeline->priv->position_stamp = -1;
+  pipeline->priv->seek_rate = 1.0;
 
   pipeline->priv->is_live = FALSE;
 
@@ -279,6 +323,11 @@ gst_pipeline_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       gst_pipeline_set_latency (pipeline, g_value_get_uint64 (value));
       break;
+    case PROP_QUERY_CACHE_TIME:
+      GST_OBJECT_LOCK (pipeline);
+      pipeline->priv->query_cache_time = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (pipeline);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -301,12 +350,26 @@ gst_pipeline_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_uint64 (value, gst_pipeline_get_latency (pipeline));
       break;
+    case PROP_QUERY_CACHE_TIME:
+      GST_OBJECT_LOCK (pipeline);
+      g_value_set_uint64 (value, pipeline->priv->query_cache_time);
+      GST_OBJECT_UNLOCK (pipeline);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* call with LOCK */
+static void
+invalidate_query_cache (GstPipeline * pipeline, gboolean duration)
+{
+  pipeline->priv->position_stamp = -1;
+  if (duration)
+    pipeline->priv->duration_stamp = -1;
+}
+
 /* set the start_time to 0, this will cause us to select a new base_time and
  * make the running_time start from 0 again. */
 static void
@@ -324,6 +387,7 @@ reset_start_time (GstPipeline * pipeline, GstClockTime start_time)
     pipeline->priv->instant_rate_upstream_anchor =
         pipeline->priv->instant_rate_clock_anchor = GST_CLOCK_TIME_NONE;
     pipeline->priv->active_instant_rate = 1.0;
+    pipeline->priv->position_stamp = -1;
     GST_DEBUG_OBJECT (pipeline, "Reset start time to %" GST_TIME_FORMAT,
         GST_TIME_ARGS (start_time));
   } else {
@@ -400,6 +464,16 @@ gst_pipeline_change_state (GstElement * element, GstStateChange transition)
   GstPipeline *pipeline = GST_PIPELINE_CAST (element);
   GstClock *clock;
 
+  /* positions extrapolated in PLAYING or frozen in PAUSED are both wrong
+   * after a state change, the duration is only kept while PAUSED or
+   * PLAYING */
+  GST_OBJECT_LOCK (element);
+  invalidate_query_cache (pipeline,
+      GST_STATE_TRANSITION_NEXT (transition) <= GST_STATE_READY);
+  if (transition == GST_STATE_CHANGE_READY_TO_PAUSED)
+    pipeline->priv->seek_rate = 1.0;
+  GST_OBJECT_UNLOCK (element);
+
   switch (transition) {
     case GST_STATE_CHANGE_NULL_TO_NULL:
       break;
@@ -618,6 +692,17 @@ gst_pipeline_handle_message (GstBin * bin, GstMessage * message)
   GstPipeline *pipeline = GST_PIPELINE_CAST (bin);
 
   switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_DURATION_CHANGED:
+    case GST_MESSAGE_ASYNC_START:
+    case GST_MESSAGE_ASYNC_DONE:
+    case GST_MESSAGE_EOS:
+    case GST_MESSAGE_SEGMENT_DONE:
+    case GST_MESSAGE_NEW_CLOCK:
+      GST_OBJECT_LOCK (bin);
+      invalidate_query_cache (pipeline,
+          GST_MESSAGE_TYPE (message) == GST_MESSAGE_DURATION_CHANGED);
+      GST_OBJECT_UNLOCK (bin);
+      break;
     case GST_MESSAGE_RESET_TIME:
     {
       GstClockTime running_time;
@@ -649,6 +734,7 @@ gst_pipeline_handle_message (GstBin * bin, GstMessage * message)
             GST_OBJECT_NAME (clock));
         pipeline->priv->update_clock = TRUE;
       }
+      invalidate_query_cache (pipeline, FALSE);
       GST_OBJECT_UNLOCK (bin);
     }
       break;
@@ -832,6 +918,179 @@ gst_pipeline_get_pipeline_clock (GstPipeline * pipeline)
 }
 
 
+/* call with LOCK */
+static gboolean
+gst_pipeline_cache_valid (GstPipeline * pipeline, gint64 stamp, gint64 now)
+{
+  GstClockTime cache_time = pipeline->priv->query_cache_time;
+
+  if (cache_time == 0 || stamp == -1)
+    return FALSE;
+
+  return now - stamp < (gint64) (cache_time / GST_USECOND);
+}
+
+/* answer TIME duration and position queries from the cache, call with LOCK */
+static gboolean
+gst_pipeline_query_cached (GstPipeline * pipeline, GstQuery * query,
+    gint64 now)
+{
+  GstPipelinePrivate *priv = pipeline->priv;
+  GstClock *clock;
+  gint64 position;
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    if (!gst_pipeline_cache_valid (pipeline, priv->duration_stamp, now))
+      return FALSE;
+
+    gst_query_set_duration (query, GST_FORMAT_TIME, priv->cached_duration);
+    return TRUE;
+  }
+
+  if (!gst_pipeline_cache_valid (pipeline, priv->position_stamp, now))
+    return FALSE;
+
+  position = priv->cached_position;
+  clock = GST_ELEMENT_CLOCK (pipeline);
+
+  if (GST_CLOCK_TIME_IS_VALID (priv->position_clock_time)) {
+    GstClockTime clock_time;
+    gdouble elapsed;
+
+    /* the cache is dropped on every state change, so we are still
+     * PLAYING with the clock the position was sampled with */
+    if (clock == NULL)
+      return FALSE;
+
+    clock_time = gst_clock_get_time (clock);
+    if (!GST_CLOCK_TIME_IS_VALID (clock_time))
+      return FALSE;
+
+    elapsed = GST_CLOCK_DIFF (priv->position_clock_time, clock_time);
+    position += elapsed * priv->seek_rate * priv->active_instant_rate;
+    if (position < 0)
+      position = 0;
+    if (gst_pipeline_cache_valid (pipeline, priv->duration_stamp, now)
+        && priv->cached_duration != -1 && position > priv->cached_duration)
+      position = priv->cached_duration;
+  }
+
+  gst_query_set_position (query, GST_FORMAT_TIME, position);
+  return TRUE;
+}
+
+/* store the result of a TIME duration or position query, call with LOCK */
+static void
+gst_pipeline_query_store (GstPipeline * pipeline, GstQuery * query,
+    gint64 now)
+{
+  GstPipelinePrivate *priv = pipeline->priv;
+  GstClock *clock;
+  gint64 value;
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    gst_query_parse_duration (query, NULL, &value);
+    priv->cached_duration = value;
+    priv->duration_stamp = now;
+    return;
+  }
+
+  gst_query_parse_position (query, NULL, &value);
+  if (value == -1)
+    return;
+
+  priv->position_clock_time = GST_CLOCK_TIME_NONE;
+  clock = GST_ELEMENT_CLOCK (pipeline);
+
+  if (GST_STATE (pipeline) == GST_STATE_PLAYING
+      && GST_STATE_PENDING (pipeline) == GST_STATE_VOID_PENDING) {
+    /* without a clock we can't advance the position */
+    if (clock == NULL)
+      return;
+    priv->position_clock_time = gst_clock_get_time (clock);
+    if (!GST_CLOCK_TIME_IS_VALID (priv->position_clock_time))
+      return;
+  } else if (GST_STATE_PENDING (pipeline) != GST_STATE_VOID_PENDING) {
+    /* the position is not stable while changing state */
+    return;
+  }
+
+  priv->cached_position = value;
+  priv->position_stamp = now;
+}
+
+static gboolean
+gst_pipeline_query (GstElement * element, GstQuery * query)
+{
+  GstPipeline *pipeline = GST_PIPELINE_CAST (element);
+  GstFormat format = GST_FORMAT_UNDEFINED;
+  GstClockTime cache_time;
+  gint64 now;
+  gboolean res;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_DURATION:
+      gst_query_parse_duration (query, &format, NULL);
+      break;
+    case GST_QUERY_POSITION:
+      gst_query_parse_position (query, &format, NULL);
+      break;
+    default:
+      break;
+  }
+
+  if (format != GST_FORMAT_TIME)
+    return GST_ELEMENT_CLASS (parent_class)->query (element, query);
+
+  GST_OBJECT_LOCK (pipeline);
+  cache_time = pipeline->priv->query_cache_time;
+  if (cache_time == 0) {
+    GST_OBJECT_UNLOCK (pipeline);
+    return GST_ELEMENT_CLASS (parent_class)->query (element, query);
+  }
+
+  now = g_get_monotonic_time ();
+  if (gst_pipeline_query_cached (pipeline, query, now)) {
+    GST_OBJECT_UNLOCK (pipeline);
+    GST_LOG_OBJECT (pipeline, "answered %s query from the cache",
+        GST_QUERY_TYPE_NAME (query));
+    return TRUE;
+  }
+  GST_OBJECT_UNLOCK (pipeline);
+
+  res = GST_ELEMENT_CLASS (parent_class)->query (element, query);
+
+  if (res) {
+    GST_OBJECT_LOCK (pipeline);
+    gst_pipeline_query_store (pipeline, query, now);
+    GST_OBJECT_UNLOCK (pipeline);
+  }
+
+  return res;
+}
+
+static gboolean
+gst_pipeline_send_event (GstElement * element, GstEvent * event)
+{
+  GstPipeline *pipeline = GST_PIPELINE_CAST (element);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
+    GstSeekFlags flags;
+    gdouble rate;
+
+    gst_event_parse_seek (event, &rate, NULL, &flags, NULL, NULL, NULL, NULL);
+
+    GST_OBJECT_LOCK (pipeline);
+    /* instant rate changes are tracked with the active_instant_rate */
+    if (!(flags & GST_SEEK_FLAG_INSTANT_RATE_CHANGE))
+      pipeline->priv->seek_rate = rate;
+    invalidate_query_cache (pipeline, FALSE);
+    GST_OBJECT_UNLOCK (pipeline);
+  }
+
+  return GST_ELEMENT_CLASS (parent_class)->send_event (element, event);
+}
+
 /**
  * gst_pipeline_use_clock:
  * @pipeline: a #GstPipeline
@@ -1152,6 +1411,7 @@ gst_pipeline_handle_instant_rate (GstPipeline * pipeline, gdouble rate,
 
     pipeline->priv->instant_rate_seqnum = seqnum;
     pipeline->priv->active_instant_rate = rate;
+    invalidate_query_cache (pipeline, FALSE);
   }
 
   GST_OBJECT_UNLOCK (pipeline);
@@ -24,6 +24,9 @@
 #  include "config.h"
 #endif
 
+/* for F_SETPIPE_SZ */
+#define _GNU_SOURCE 1
+
 #include <gst/gst_private.h>
 
 #ifndef G_OS_WIN32
@@ -65,14 +68,14 @@ static const guint32 loader_protocol_version = 3;
 
 #define GST_CAT_DEFAULT GST_CAT_PLUGIN_LOADING
 
-static GstPluginLoader *plugin_loader_new (GstRegistry * registry);
-static gboolean plugin_loader_free (GstPluginLoader * loader);
-static gboolean plugin_loader_load (GstPluginLoader * loader,
+static GstPluginLoader *plugin_loader_pool_new (GstRegistry * registry);
+static gboolean plugin_loader_pool_free (GstPluginLoader * pool);
+static gboolean plugin_loader_pool_load (GstPluginLoader * pool,
     const gchar * filename, off_t file_size, time_t file_mtime);
 
 /* functions used in GstRegistry scanning */
 const GstPluginLoaderFuncs _priv_gst_plugin_loader_funcs = {
-  plugin_loader_new, plugin_loader_free, plugin_loader_load
+  plugin_loader_pool_new, plugin_loader_pool_free, plugin_loader_pool_load
 };
 
 typedef struct _PendingPluginEntry
@@ -84,6 +87,26 @@ typedef struct _PendingPluginEntry
   time_t file_mtime;
 } PendingPluginEntry;
 
+typedef enum
+{
+  PLUGIN_RESULT_PENDING = 0,
+  PLUGIN_RESULT_NONE,
+  PLUGIN_RESULT_DETAILS,
+  PLUGIN_RESULT_BLACKLIST
+} PluginResultType;
+
+/* What a scanner child found for a file, kept until all files that were
+ * sent to any child before are added to the registry */
+typedef struct
+{
+  PluginResultType type;
+  PendingPluginEntry *entry;
+  /* the details packet, with the payload at HEADER_SIZE like in the sent
+   * packet so that the chunks keep their alignment */
+  guint8 *packet;
+  guint payload_len;
+} PluginResult;
+
 struct _GstPluginLoader
 {
   GstRegistry *registry;
@@ -106,8 +129,11 @@ struct _GstPluginLoader
   /* next sequence number (for PendingPluginEntry) */
   guint32 next_tag;
 
+  /* Receive buffer, holds the start of a packet that wasn't read
+   * completely yet */
   guint8 *rx_buf;
   guint rx_buf_size;
+  guint rx_buf_write;
   gboolean rx_done;
   gboolean rx_got_sync;
 
@@ -115,6 +141,18 @@ struct _GstPluginLoader
      PendingPluginEntry structs */
   GList *pending_plugins;
   GList *pending_plugins_tail;
+
+  /* The loader given to the registry doesn't talk to a child itself but
+   * distributes the files over one loader per scanner child. It collects
+   * their results by tag and adds them to the registry in tag order, so
+   * the registry contents don't depend on which child is faster. */
+  GstPluginLoader **workers;
+  guint n_workers;
+  GArray *results;
+  guint32 next_commit;
+
+  /* for the loaders of the scanner children, the loader that owns them */
+  GstPluginLoader *pool;
 };
 
 #define PACKET_EXIT 1
@@ -126,16 +164,29 @@ struct _GstPluginLoader
 #define BUF_INIT_SIZE 512
 #define BUF_GROW_EXTRA 512
 #define BUF_MAX_SIZE (32 * 1024 * 1024)
+/* how much to try to read at once */
+#define RX_READ_SIZE (16 * 1024)
+/* the parent writes at most this much at once, which fits in a pipe that
+ * poll() reported as writable, see write_packets() */
+#define TX_BATCH_SIZE 4096
+/* the size we ask for the pipe the scanner writes the details to */
+#define PIPE_SIZE (1024 * 1024)
 
 #define HEADER_SIZE 12
 /* 4 magic hex bytes to mark each packet */
 #define HEADER_MAGIC 0xbefec0ae
 #define ALIGNMENT   (sizeof (void *))
 
+/* Upper limit for the number of scanner children when GST_REGISTRY_SCAN_JOBS
+ * isn't set, and for the value of GST_REGISTRY_SCAN_JOBS */
+#define MAX_DEFAULT_SCAN_JOBS 8
+#define MAX_SCAN_JOBS 64
+
 static gboolean gst_plugin_loader_spawn (GstPluginLoader * loader);
 static void put_packet (GstPluginLoader * loader, guint type, guint32 tag,
     const guint8 * payload, guint32 payload_len);
 static gboolean exchange_packets (GstPluginLoader * l);
+static gboolean read_packets (GstPluginLoader * l);
 static gboolean plugin_loader_replay_pending (GstPluginLoader * l);
 static gboolean plugin_loader_load_and_sync (GstPluginLoader * l,
     PendingPluginEntry * entry);
@@ -143,6 +194,9 @@ static void plugin_loader_create_blacklist_plugin (GstPluginLoader * l,
     PendingPluginEntry * entry);
 static void plugin_loader_cleanup_child (GstPluginLoader * loader);
 static gboolean plugin_loader_sync_with_child (GstPluginLoader * l);
+static void plugin_loader_set_result (GstPluginLoader * l,
+    PendingPluginEntry * entry, PluginResultType type, const guint8 * payload,
+    guint payload_len);
 
 static GstPluginLoader *
 plugin_loader_new (GstRegistry * registry)
@@ -210,9 +264,8 @@ plugin_loader_free (GstPluginLoader * loader)
   cur = loader->pending_plugins;
   while (cur) {
     PendingPluginEntry *entry = (PendingPluginEntry *) (cur->data);
-    g_free (entry->filename);
-    g_slice_free (PendingPluginEntry, entry);
 
+    plugin_loader_set_result (loader, entry, PLUGIN_RESULT_NONE, NULL, 0);
     cur = g_list_delete_link (cur, cur);
   }
 
@@ -223,7 +276,7 @@ plugin_loader_free (GstPluginLoader * loader)
 
 static gboolean
 plugin_loader_load (GstPluginLoader * loader, const gchar * filename,
-    off_t file_size, time_t file_mtime)
+    off_t file_size, time_t file_mtime, guint32 tag)
 {
   gint len;
   PendingPluginEntry *entry;
@@ -233,10 +286,10 @@ plugin_loader_load (GstPluginLoader * loader, const gchar * filename,
 
   /* Send a packet to the child requesting that it load the given file */
   GST_LOG_OBJECT (loader->registry,
-      "Sending file %s to child. tag %u", filename, loader->next_tag);
+      "Sending file %s to child. tag %u", filename, tag);
 
   entry = g_slice_new (PendingPluginEntry);
-  entry->tag = loader->next_tag++;
+  entry->tag = tag;
   entry->filename = g_strdup (filename);
   entry->file_size = file_size;
   entry->file_mtime = file_mtime;
@@ -260,6 +313,214 @@ plugin_loader_load (GstPluginLoader * loader, const gchar * filename,
   return TRUE;
 }
 
+/* Read whatever the child already sent without waiting, so that it doesn't
+ * block on a full pipe while we're feeding the other children */
+static gboolean
+plugin_loader_drain (GstPluginLoader * l)
+{
+  gint res;
+
+  while (l->child_running && !l->rx_done) {
+    do {
+      res = gst_poll_wait (l->fdset, 0);
+    } while (res == -1 && (errno == EINTR || errno == EAGAIN));
+
+    if (res < 0)
+      goto fail;
+    if (gst_poll_fd_has_error (l->fdset, &l->fd_r))
+      goto fail;
+    if (!gst_poll_fd_can_read (l->fdset, &l->fd_r)) {
+      if (gst_poll_fd_has_closed (l->fdset, &l->fd_r))
+        goto fail;
+      break;
+    }
+    if (!read_packets (l))
+      goto fail;
+  }
+
+  return TRUE;
+
+fail:
+  plugin_loader_cleanup_child (l);
+  return plugin_loader_replay_pending (l);
+}
+
+static void
+plugin_loader_set_result (GstPluginLoader * l, PendingPluginEntry * entry,
+    PluginResultType type, const guint8 * payload, guint payload_len)
+{
+  GstPluginLoader *pool = l->pool;
+  PluginResult *result;
+
+  if (pool == NULL || entry->tag >= pool->results->len) {
+    g_free (entry->filename);
+    g_slice_free (PendingPluginEntry, entry);
+    return;
+  }
+
+  result = &g_array_index (pool->results, PluginResult, entry->tag);
+  g_assert (result->type == PLUGIN_RESULT_PENDING);
+
+  result->type = type;
+  result->entry = entry;
+  if (type == PLUGIN_RESULT_DETAILS) {
+    result->packet = g_malloc (HEADER_SIZE + payload_len);
+    memcpy (result->packet + HEADER_SIZE, payload, payload_len);
+    result->payload_len = payload_len;
+  }
+}
+
+static void
+plugin_loader_commit_result (GstPluginLoader * pool, PluginResult * result)
+{
+  PendingPluginEntry *entry = result->entry;
+
+  if (result->type == PLUGIN_RESULT_DETAILS) {
+    GstPlugin *newplugin = NULL;
+    gchar *tmp = (gchar *) result->packet + HEADER_SIZE;
+
+    if (_priv_gst_registry_chunks_load_plugin (pool->registry, &tmp,
+            tmp + result->payload_len, NULL, &newplugin)) {
+      GST_OBJECT_FLAG_UNSET (newplugin, GST_PLUGIN_FLAG_CACHED);
+      GST_LOG_OBJECT (pool->registry,
+          "marking plugin %p as registered as %s", newplugin,
+          newplugin->filename);
+      newplugin->registered = TRUE;
+    } else {
+      /* Got garbage from the child, don't try this file again */
+      GST_ERROR_OBJECT (pool->registry,
+          "Problems loading plugin details for %s from scanner. Blacklisting",
+          entry->filename);
+      plugin_loader_create_blacklist_plugin (pool, entry);
+    }
+    /* We got a set of plugin details - remember it for later */
+    pool->got_plugin_details = TRUE;
+  } else if (result->type == PLUGIN_RESULT_BLACKLIST) {
+    plugin_loader_create_blacklist_plugin (pool, entry);
+    pool->got_plugin_details = TRUE;
+  }
+
+  g_free (result->packet);
+  result->packet = NULL;
+  if (entry) {
+    g_free (entry->filename);
+    g_slice_free (PendingPluginEntry, entry);
+    result->entry = NULL;
+  }
+}
+
+/* Add all results to the registry that don't wait for an earlier file */
+static void
+plugin_loader_commit_results (GstPluginLoader * pool)
+{
+  while (pool->next_commit < pool->results->len) {
+    PluginResult *result =
+        &g_array_index (pool->results, PluginResult, pool->next_commit);
+
+    if (result->type == PLUGIN_RESULT_PENDING)
+      break;
+
+    plugin_loader_commit_result (pool, result);
+    pool->next_commit++;
+  }
+}
+
+static guint
+plugin_loader_get_n_jobs (void)
+{
+  const gchar *env;
+  guint n_jobs;
+
+  env = g_getenv ("GST_REGISTRY_SCAN_JOBS");
+  if (env != NULL && *env != '\0')
+    n_jobs = (guint) g_ascii_strtoull (env, NULL, 10);
+  else
+    n_jobs = MIN (g_get_num_processors (), MAX_DEFAULT_SCAN_JOBS);
+
+  return CLAMP (n_jobs, 1, MAX_SCAN_JOBS);
+}
+
+static GstPluginLoader *
+plugin_loader_pool_new (GstRegistry * registry)
+{
+  GstPluginLoader *pool = g_slice_new0 (GstPluginLoader);
+  guint i;
+
+  pool->registry = gst_object_ref (registry);
+  pool->n_workers = plugin_loader_get_n_jobs ();
+  pool->workers = g_new0 (GstPluginLoader *, pool->n_workers);
+  for (i = 0; i < pool->n_workers; i++) {
+    pool->workers[i] = plugin_loader_new (registry);
+    pool->workers[i]->pool = pool;
+  }
+  pool->results = g_array_new (FALSE, TRUE, sizeof (PluginResult));
+
+  GST_DEBUG_OBJECT (registry, "Scanning plugins with up to %u scanners",
+      pool->n_workers);
+
+  return pool;
+}
+
+static gboolean
+plugin_loader_pool_free (GstPluginLoader * pool)
+{
+  gboolean got_plugin_details;
+  guint i;
+
+  /* Remaining results are handed to the pool while shutting down the
+   * children, pending files of crashed children get blacklisted */
+  for (i = 0; i < pool->n_workers; i++)
+    plugin_loader_free (pool->workers[i]);
+  g_free (pool->workers);
+
+  for (; pool->next_commit < pool->results->len; pool->next_commit++) {
+    plugin_loader_commit_result (pool,
+        &g_array_index (pool->results, PluginResult, pool->next_commit));
+  }
+  g_array_free (pool->results, TRUE);
+
+  got_plugin_details = pool->got_plugin_details;
+  gst_object_unref (pool->registry);
+  g_slice_free (GstPluginLoader, pool);
+
+  return got_plugin_details;
+}
+
+static gboolean
+plugin_loader_pool_load (GstPluginLoader * pool, const gchar * filename,
+    off_t file_size, time_t file_mtime)
+{
+  GstPluginLoader *worker = NULL;
+  guint i, n_pending = G_MAXUINT;
+  guint32 tag;
+
+  /* Pick the child with the least files queued, and pick up what
+   * the others found in the meantime */
+  for (i = 0; i < pool->n_workers; i++) {
+    GstPluginLoader *l = pool->workers[i];
+    guint n;
+
+    if (!plugin_loader_drain (l))
+      return FALSE;
+
+    n = g_list_length (l->pending_plugins);
+    if (n < n_pending) {
+      worker = l;
+      n_pending = n;
+    }
+  }
+
+  tag = pool->next_tag++;
+  g_array_set_size (pool->results, tag + 1);
+
+  if (!plugin_loader_load (worker, filename, file_size, file_mtime, tag))
+    return FALSE;
+
+  plugin_loader_commit_results (pool);
+
+  return TRUE;
+}
+
 static gboolean
 plugin_loader_replay_pending (GstPluginLoader * l)
 {
@@ -278,12 +539,9 @@ restart:
       /* Create dummy plugin entry to block re-scanning this file */
       GST_ERROR ("Plugin file %s failed to load. Blacklisting",
           entry->filename);
-      plugin_loader_create_blacklist_plugin (l, entry);
-      l->got_plugin_details = TRUE;
+      plugin_loader_set_result (l, entry, PLUGIN_RESULT_BLACKLIST, NULL, 0);
       /* Now remove this crashy plugin from the head of the list */
       l->pending_plugins = g_list_delete_link (cur, cur);
-      g_free (entry->filename);
-      g_slice_free (PendingPluginEntry, entry);
       if (l->pending_plugins == NULL)
         l->pending_plugins_tail = NULL;
       if (!gst_plugin_loader_spawn (l))
@@ -444,6 +702,7 @@ gst_plugin_loader_try_helper (GstPluginLoader * loader, gchar * location)
   gst_poll_fd_ctl_read (loader->fdset, &loader->fd_r, TRUE);
 
   loader->tx_buf_write = loader->tx_buf_read = 0;
+  loader->rx_buf_write = 0;
 
   put_packet (loader, PACKET_VERSION, 0, NULL, 0);
   if (!plugin_loader_sync_with_child (loader))
@@ -566,6 +825,12 @@ _gst_plugin_loader_client_run (void)
     /* Dup stderr down to stdout so things that plugins print are visible,
      * but don't care if it fails */
     dup2 (2, 1);
+
+#ifdef F_SETPIPE_SZ
+    /* a bigger pipe lets us write the details of a few plugins without
+     * waiting for the parent to read them, don't care if it fails */
+    fcntl (l->fd_w.fd, F_SETPIPE_SZ, PIPE_SIZE);
+#endif
   }
 #else
   /* FIXME: Use DuplicateHandle and friends on win32 */
@@ -659,34 +924,54 @@ put_chunk (GstPluginLoader * l, GstRegistryChunk * chunk, guint * pos)
   gst_poll_fd_ctl_write (l->fdset, &l->fd_w, TRUE);
 };
 
+/* Write as many of the pending packets as possible with one write(). The
+ * scanner child may block in write() because the parent keeps reading in
+ * between its writes. The parent makes sure to only write what fits in the
+ * pipe, so that it doesn't block on a child that is itself blocked writing
+ * to the parent. A single packet larger than that is still written as a
+ * whole. */
 static gboolean
-write_one (GstPluginLoader * l)
+write_packets (GstPluginLoader * l)
 {
   guint8 *out;
-  guint32 to_write, magic;
+  guint32 to_write, len, magic, max_write;
+  guint n_packets = 0;
   int res;
 
   if (l->tx_buf_read + HEADER_SIZE > l->tx_buf_write)
     return FALSE;
 
   out = l->tx_buf + l->tx_buf_read;
+  max_write = l->is_child ? G_MAXUINT32 : TX_BATCH_SIZE;
+  to_write = 0;
 
-  magic = GST_READ_UINT32_BE (out + 8);
-  if (magic != HEADER_MAGIC) {
-    GST_ERROR ("Packet magic number is missing. Memory corruption detected");
-    goto fail_and_cleanup;
-  }
+  do {
+    guint8 *hdr = out + to_write;
 
-  to_write = GST_READ_UINT32_BE (out + 4) + HEADER_SIZE;
-  /* Check that the magic is intact, and the size is sensible */
-  if (to_write > l->tx_buf_size) {
-    GST_ERROR ("Indicated packet size is too large. Corruption detected");
-    goto fail_and_cleanup;
-  }
+    magic = GST_READ_UINT32_BE (hdr + 8);
+    if (magic != HEADER_MAGIC) {
+      GST_ERROR ("Packet magic number is missing. Memory corruption detected");
+      goto fail_and_cleanup;
+    }
+
+    len = GST_READ_UINT32_BE (hdr + 4) + HEADER_SIZE;
+    /* Check that the magic is intact, and the size is sensible */
+    if (len > l->tx_buf_write - l->tx_buf_read - to_write) {
+      GST_ERROR ("Indicated packet size is too large. Corruption detected");
+      goto fail_and_cleanup;
+    }
+
+    if (n_packets > 0 && to_write + len > max_write)
+      break;
+
+    to_write += len;
+    n_packets++;
+  } while (l->tx_buf_read + to_write + HEADER_SIZE <= l->tx_buf_write);
 
   l->tx_buf_read += to_write;
 
-  GST_LOG ("Writing packet of size %d bytes to fd %d", to_write, l->fd_w.fd);
+  GST_LOG ("Writing %u packets of %u bytes to fd %d", n_packets, to_write,
+      l->fd_w.fd);
 
   do {
     res = write (l->fd_w.fd, out, to_write);
@@ -840,7 +1125,6 @@ handle_rx_packet (GstPluginLoader * l,
       break;
     }
     case PACKET_PLUGIN_DETAILS:{
-      gchar *tmp = (gchar *) payload;
       PendingPluginEntry *entry = NULL;
       GList *cur;
 
@@ -863,8 +1147,7 @@ handle_rx_packet (GstPluginLoader * l,
           break;
         } else {
           cur = g_list_delete_link (cur, cur);
-          g_free (e->filename);
-          g_slice_free (PendingPluginEntry, e);
+          plugin_loader_set_result (l, e, PLUGIN_RESULT_NONE, NULL, 0);
         }
       }
 
@@ -872,33 +1155,19 @@ handle_rx_packet (GstPluginLoader * l,
       if (cur == NULL)
         l->pending_plugins_tail = NULL;
 
-      if (payload_len > 0) {
-        GstPlugin *newplugin = NULL;
-        if (!_priv_gst_registry_chunks_load_plugin (l->registry, &tmp,
-                tmp + payload_len, &newplugin)) {
-          /* Got garbage from the child, so fail and trigger replay of plugins */
-          GST_ERROR_OBJECT (l->registry,
-              "Problems loading plugin details with tag %u from scanner", tag);
-          return FALSE;
-        }
-
-        GST_OBJECT_FLAG_UNSET (newplugin, GST_PLUGIN_FLAG_CACHED);
-        GST_LOG_OBJECT (l->registry,
-            "marking plugin %p as registered as %s", newplugin,
-            newplugin->filename);
-        newplugin->registered = TRUE;
-
-        /* We got a set of plugin details - remember it for later */
-        l->got_plugin_details = TRUE;
-      } else if (entry != NULL) {
-        /* Create a blacklist entry for this file to prevent scanning every time */
-        plugin_loader_create_blacklist_plugin (l, entry);
-        l->got_plugin_details = TRUE;
+      if (entry == NULL) {
+        GST_WARNING_OBJECT (l->registry,
+            "Got plugin details for unknown tag %u from scanner", tag);
+        break;
       }
 
-      if (entry != NULL) {
-        g_free (entry->filename);
-        g_slice_free (PendingPluginEntry, entry);
+      if (payload_len > 0) {
+        /* The details are only parsed once they're added to the registry */
+        plugin_loader_set_result (l, entry, PLUGIN_RESULT_DETAILS, payload,
+            payload_len);
+      } else {
+        /* Create a blacklist entry for this file to prevent scanning every time */
+        plugin_loader_set_result (l, entry, PLUGIN_RESULT_BLACKLIST, NULL, 0);
       }
 
       /* Remove the plugin entry we just loaded */
@@ -942,71 +1211,81 @@ handle_rx_packet (GstPluginLoader * l,
   return res;
 }
 
+/* Read whatever is available with one read() and handle all complete
+ * packets in it, so that a batch of packets doesn't cost two reads per
+ * packet. The start of an incomplete packet is kept in rx_buf until the
+ * rest arrives. Only called when poll() reported the fd readable. */
 static gboolean
-read_one (GstPluginLoader * l)
+read_packets (GstPluginLoader * l)
 {
-  guint64 magic;
-  guint32 to_read, packet_len, tag;
+  guint32 magic, packet_len, tag;
+  guint wanted, pos;
   guint8 *in;
   gint res;
 
-  to_read = HEADER_SIZE;
-  in = l->rx_buf;
-  do {
-    res = read (l->fd_r.fd, in, to_read);
-    if (G_UNLIKELY (res < 0)) {
-      if (errno == EAGAIN || errno == EINTR)
-        continue;
-      GST_LOG ("Failed reading packet header");
-      return FALSE;
-    }
-    to_read -= res;
-    in += res;
-  } while (to_read > 0);
-
-  magic = GST_READ_UINT32_BE (l->rx_buf + 8);
-  if (magic != HEADER_MAGIC) {
-    GST_WARNING
-        ("Invalid packet (bad magic number) received from plugin scanner subprocess");
-    return FALSE;
+  /* make room for a read, and for all of a packet we know the size of */
+  wanted = l->rx_buf_write + RX_READ_SIZE;
+  if (l->rx_buf_write >= HEADER_SIZE)
+    wanted = MAX (wanted, GST_READ_UINT32_BE (l->rx_buf + 4) + HEADER_SIZE);
+  if (wanted > l->rx_buf_size) {
+    GST_LOG ("Expanding rx buf from %d to %d", l->rx_buf_size,
+        wanted + BUF_GROW_EXTRA);
+    l->rx_buf_size = wanted + BUF_GROW_EXTRA;
+    l->rx_buf = g_realloc (l->rx_buf, l->rx_buf_size);
   }
 
-  packet_len = GST_READ_UINT32_BE (l->rx_buf + 4);
-  if (packet_len + HEADER_SIZE > BUF_MAX_SIZE) {
-    GST_WARNING
-        ("Received excessively large packet for plugin scanner subprocess");
+  do {
+    res = read (l->fd_r.fd, l->rx_buf + l->rx_buf_write,
+        l->rx_buf_size - l->rx_buf_write);
+  } while (G_UNLIKELY (res < 0 && (errno == EAGAIN || errno == EINTR)));
+
+  if (G_UNLIKELY (res <= 0)) {
+    GST_LOG ("Failed reading packets");
     return FALSE;
   }
-  tag = GST_READ_UINT24_BE (l->rx_buf + 1);
-
-  if (packet_len > 0) {
-    if (packet_len + HEADER_SIZE >= l->rx_buf_size) {
-      GST_LOG ("Expanding rx buf from %d to %d",
-          l->rx_buf_size, packet_len + HEADER_SIZE + BUF_GROW_EXTRA);
-      l->rx_buf_size = packet_len + HEADER_SIZE + BUF_GROW_EXTRA;
-      l->rx_buf = g_realloc (l->rx_buf, l->rx_buf_size);
+  l->rx_buf_write += res;
+
+  pos = 0;
+  while (!l->rx_done && l->rx_buf_write - pos >= HEADER_SIZE) {
+    in = l->rx_buf + pos;
+
+    magic = GST_READ_UINT32_BE (in + 8);
+    if (magic != HEADER_MAGIC) {
+      GST_WARNING
+          ("Invalid packet (bad magic number) received from plugin scanner subprocess");
+      return FALSE;
     }
 
-    in = l->rx_buf + HEADER_SIZE;
-    to_read = packet_len;
-    do {
-      res = read (l->fd_r.fd, in, to_read);
-      if (G_UNLIKELY (res < 0)) {
-        if (errno == EAGAIN || errno == EINTR)
-          continue;
-        GST_ERROR ("Packet payload read failed");
-        return FALSE;
-      }
-      to_read -= res;
-      in += res;
-    } while (to_read > 0);
-  } else {
-    GST_LOG ("No payload to read for 0 length packet type %d tag %u",
-        l->rx_buf[0], tag);
+    packet_len = GST_READ_UINT32_BE (in + 4);
+    if (packet_len + HEADER_SIZE > BUF_MAX_SIZE) {
+      GST_WARNING
+          ("Received excessively large packet for plugin scanner subprocess");
+      return FALSE;
+    }
+
+    /* wait for the rest of the payload */
+    if (l->rx_buf_write - pos < packet_len + HEADER_SIZE)
+      break;
+
+    tag = GST_READ_UINT24_BE (in + 1);
+    if (packet_len == 0) {
+      GST_LOG ("No payload to read for 0 length packet type %d tag %u",
+          in[0], tag);
+    }
+
+    if (!handle_rx_packet (l, in[0], tag, in + HEADER_SIZE, packet_len))
+      return FALSE;
+
+    pos += packet_len + HEADER_SIZE;
+  }
+
+  /* keep the incomplete packet for the next read */
+  if (pos > 0) {
+    l->rx_buf_write -= pos;
+    memmove (l->rx_buf, l->rx_buf + pos, l->rx_buf_write);
   }
 
-  return handle_rx_packet (l, l->rx_buf[0], tag,
-      l->rx_buf + HEADER_SIZE, packet_len);
+  return TRUE;
 }
 
 static gboolean
@@ -1033,7 +1312,7 @@ exchange_packets (GstPluginLoader * l)
       }
 
       if (gst_poll_fd_can_read (l->fdset, &l->fd_r)) {
-        if (!read_one (l))
+        if (!read_packets (l))
           goto fail_and_cleanup;
       } else if (gst_poll_fd_has_closed (l->fdset, &l->fd_r)) {
         GST_LOG ("read fd %d closed", l->fd_r.fd);
@@ -1047,7 +1326,7 @@ exchange_packets (GstPluginLoader * l)
         goto fail_and_cleanup;
       }
       if (gst_poll_fd_can_write (l->fdset, &l->fd_w)) {
-        if (!write_one (l))
+        if (!write_packets (l))
           goto fail_and_cleanup;
       } else if (gst_poll_fd_has_closed (l->fdset, &l->fd_w)) {
         GST_LOG ("write fd %d closed", l->fd_w.fd);
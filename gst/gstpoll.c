@@ -83,6 +83,12 @@
 #endif
 #include <sys/time.h>
 #include <sys/socket.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #endif
 
 #ifdef G_OS_WIN32
@@ -124,9 +130,17 @@ typedef enum
   GST_POLL_MODE_PSELECT,
   GST_POLL_MODE_POLL,
   GST_POLL_MODE_PPOLL,
+  GST_POLL_MODE_EPOLL,
   GST_POLL_MODE_WINDOWS
 } GstPollMode;
 
+#ifdef HAVE_SYS_EPOLL_H
+/* Sets with this many fds are waited on with epoll, which doesn't have to
+ * pass and scan all fds for every wait */
+#define EPOLL_MIN_FDS 32
+#define EPOLL_MAX_EVENTS 64
+#endif
+
 struct _GstPoll
 {
   GstPollMode mode;
@@ -140,8 +154,17 @@ struct _GstPoll
   GArray *active_fds;
 
 #ifndef G_OS_WIN32
+  /* the same fd if an eventfd is used */
   GstPollFD control_read_fd;
   GstPollFD control_write_fd;
+#ifdef HAVE_SYS_EPOLL_H
+  /* created once the set has EPOLL_MIN_FDS fds, updated with the lock */
+  gint epoll_fd;
+  gint epoll_active;
+  /* indices of the active fds that got events in the last epoll wait, only
+   * used from the waiting thread */
+  GArray *epoll_ready;
+#endif
 #else
   GArray *active_fds_ignored;
   GArray *events;
@@ -178,6 +201,20 @@ static gboolean
 wake_event (GstPoll * set)
 {
   ssize_t num_written;
+#ifdef HAVE_SYS_EVENTFD_H
+  if (set->control_write_fd.fd == set->control_read_fd.fd) {
+    guint64 one = 1;
+
+    while ((num_written = write (set->control_write_fd.fd, &one,
+                sizeof (one))) != sizeof (one)) {
+      if (num_written == -1 && errno != EAGAIN && errno != EINTR) {
+        g_critical ("%p: failed to wake event: %s", set, strerror (errno));
+        return FALSE;
+      }
+    }
+    return TRUE;
+  }
+#endif
   while ((num_written = write (set->control_write_fd.fd, "W", 1)) != 1) {
     if (num_written == -1 && errno != EAGAIN && errno != EINTR) {
       g_critical ("%p: failed to wake event: %s", set, strerror (errno));
@@ -192,6 +229,21 @@ release_event (GstPoll * set)
 {
   gchar buf[1] = { '\0' };
   ssize_t num_read;
+#ifdef HAVE_SYS_EVENTFD_H
+  if (set->control_write_fd.fd == set->control_read_fd.fd) {
+    guint64 count;
+
+    /* the counter is at most 1 here, reading resets it */
+    while ((num_read = read (set->control_read_fd.fd, &count,
+                sizeof (count))) != sizeof (count)) {
+      if (num_read == -1 && errno != EAGAIN && errno != EINTR) {
+        g_critical ("%p: failed to release event: %s", set, strerror (errno));
+        return FALSE;
+      }
+    }
+    return TRUE;
+  }
+#endif
   while ((num_read = read (set->control_read_fd.fd, buf, 1)) != 1) {
     if (num_read == -1 && errno != EAGAIN && errno != EINTR) {
       g_critical ("%p: failed to release event: %s", set, strerror (errno));
@@ -276,23 +328,37 @@ release_event (GstPoll * set)
 #endif
 
 /* the poll/select call is also performed on a control socket, that way
- * we can send special commands to control it */
+ * we can send special commands to control it.
+ *
+ * control_pending only changes from and to 0 with the lock, together with
+ * WAKE_EVENT() and RELEASE_EVENT(). While a wakeup is pending, further
+ * raises and releases only count atomically, which keeps the lock and the
+ * syscall out of e.g. every bus post while messages are queued. */
 static inline gboolean
 raise_wakeup (GstPoll * set)
 {
   gboolean result = TRUE;
+  gint pending;
+
+  pending = g_atomic_int_get (&set->control_pending);
+  while (pending > 0) {
+    if (g_atomic_int_compare_and_exchange (&set->control_pending, pending,
+            pending + 1))
+      return TRUE;
+    pending = g_atomic_int_get (&set->control_pending);
+  }
 
-  /* makes testing control_pending and WAKE_EVENT() atomic. */
   g_mutex_lock (&set->lock);
 
-  if (set->control_pending == 0) {
-    /* raise when nothing pending */
+  if (g_atomic_int_get (&set->control_pending) > 0) {
+    /* raised by someone else in the meantime */
+    g_atomic_int_inc (&set->control_pending);
+  } else {
+    /* raise when nothing pending, nobody else can change it now */
     GST_LOG ("%p: raise", set);
     result = wake_event (set);
-  }
-
-  if (result) {
-    set->control_pending++;
+    if (result)
+      g_atomic_int_set (&set->control_pending, 1);
   }
 
   g_mutex_unlock (&set->lock);
@@ -304,24 +370,39 @@ static inline gboolean
 release_wakeup (GstPoll * set)
 {
   gboolean result = FALSE;
+  gint pending;
+
+  pending = g_atomic_int_get (&set->control_pending);
+  while (pending > 1) {
+    if (g_atomic_int_compare_and_exchange (&set->control_pending, pending,
+            pending - 1))
+      return TRUE;
+    pending = g_atomic_int_get (&set->control_pending);
+  }
 
-  /* makes testing/modifying control_pending and RELEASE_EVENT() atomic. */
   g_mutex_lock (&set->lock);
 
-  if (set->control_pending > 0) {
-    /* release, only if this was the last pending. */
-    if (set->control_pending == 1) {
+  while (TRUE) {
+    pending = g_atomic_int_get (&set->control_pending);
+    if (pending == 0) {
+      errno = EWOULDBLOCK;
+      break;
+    } else if (pending > 1) {
+      if (g_atomic_int_compare_and_exchange (&set->control_pending, pending,
+              pending - 1)) {
+        result = TRUE;
+        break;
+      }
+    } else if (g_atomic_int_compare_and_exchange (&set->control_pending, 1,
+            0)) {
+      /* release, as this was the last pending. Raising now has to wait for
+       * the lock */
       GST_LOG ("%p: release", set);
       result = release_event (set);
-    } else {
-      result = TRUE;
+      if (!result)
+        g_atomic_int_set (&set->control_pending, 1);
+      break;
     }
-
-    if (result) {
-      set->control_pending--;
-    }
-  } else {
-    errno = EWOULDBLOCK;
   }
 
   g_mutex_unlock (&set->lock);
@@ -337,11 +418,15 @@ release_all_wakeup (GstPoll * set)
   /* makes testing control_pending and RELEASE_EVENT() atomic. */
   g_mutex_lock (&set->lock);
 
-  if ((old = set->control_pending) > 0) {
+  do {
+    old = g_atomic_int_get (&set->control_pending);
+  } while (old > 0
+      && !g_atomic_int_compare_and_exchange (&set->control_pending, old, 0));
+
+  if (old > 0) {
     GST_LOG ("%p: releasing %d", set, old);
-    if (release_event (set)) {
-      set->control_pending = 0;
-    } else {
+    if (!release_event (set)) {
+      g_atomic_int_set (&set->control_pending, old);
       old = 0;
     }
   }
@@ -392,6 +477,108 @@ find_index (GArray * array, GstPollFD * fd)
   return fd->idx;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/* the fd is stored next to the index so that an index that changed since
+ * the last rebuild can be detected */
+#define EPOLL_DATA(fd,idx) (((guint64) (idx) << 32) | (guint32) (fd))
+#define EPOLL_DATA_FD(data) ((gint) (guint32) (data))
+#define EPOLL_DATA_IDX(data) ((guint) ((data) >> 32))
+
+/* with the lock */
+static void
+gst_poll_epoll_ctl (GstPoll * set, gint op, guint idx)
+{
+  struct pollfd *pfd = &g_array_index (set->fds, struct pollfd, idx);
+  struct epoll_event ev;
+
+  if (!set->epoll_active)
+    return;
+
+  /* epoll uses the same event bits as poll, errors and hangups are always
+   * reported */
+  ev.events = pfd->events & (POLLIN | POLLOUT | POLLPRI);
+  ev.data.u64 = EPOLL_DATA (pfd->fd, idx);
+
+  if (epoll_ctl (set->epoll_fd, op, pfd->fd, &ev) == 0)
+    return;
+
+  /* not all fds can be used with epoll, regular files for example. The
+   * epoll fd stays around until the set is freed as it could still be
+   * waited on */
+  GST_INFO ("%p: can't use epoll for fd %d, disabling: %s", set, pfd->fd,
+      g_strerror (errno));
+  g_atomic_int_set (&set->epoll_active, FALSE);
+}
+
+/* with the lock */
+static void
+gst_poll_epoll_start (GstPoll * set)
+{
+  guint i;
+
+  set->epoll_ready = g_array_new (FALSE, FALSE, sizeof (guint));
+  set->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (set->epoll_fd < 0) {
+    GST_INFO ("%p: can't create epoll fd: %s", set, g_strerror (errno));
+    return;
+  }
+
+  GST_DEBUG ("%p: using epoll for %u fds", set, set->fds->len);
+  g_atomic_int_set (&set->epoll_active, TRUE);
+  for (i = 0; i < set->fds->len && set->epoll_active; i++)
+    gst_poll_epoll_ctl (set, EPOLL_CTL_ADD, i);
+}
+
+/* called from the waiting thread after a rebuild, without the lock */
+static gint
+gst_poll_epoll_wait (GstPoll * set, GstClockTime timeout)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  gint i, n, t;
+
+  if (timeout == GST_CLOCK_TIME_NONE)
+    t = -1;
+  else                          /* never wake up too early */
+    t = MIN ((timeout + GST_MSECOND - 1) / GST_MSECOND, G_MAXINT);
+
+  n = epoll_wait (set->epoll_fd, events, EPOLL_MAX_EVENTS, t);
+  if (n < 0)
+    return -1;
+
+  /* only clear the fds that got events the last time instead of all */
+  for (i = 0; i < set->epoll_ready->len; i++) {
+    guint idx = g_array_index (set->epoll_ready, guint, i);
+
+    if (idx < set->active_fds->len)
+      g_array_index (set->active_fds, struct pollfd, idx).revents = 0;
+  }
+  g_array_set_size (set->epoll_ready, 0);
+
+  for (i = 0; i < n; i++) {
+    GstPollFD fd = GST_POLL_FD_INIT;
+    struct pollfd *pfd;
+
+    fd.fd = EPOLL_DATA_FD (events[i].data.u64);
+    fd.idx = EPOLL_DATA_IDX (events[i].data.u64);
+    if (find_index (set->active_fds, &fd) < 0)
+      continue;
+
+    pfd = &g_array_index (set->active_fds, struct pollfd, fd.idx);
+    pfd->revents =
+        events[i].events & (POLLIN | POLLOUT | POLLPRI | POLLERR | POLLHUP);
+    g_array_append_val (set->epoll_ready, fd.idx);
+  }
+
+  /* all events were for fds that changed since the last rebuild */
+  if (G_UNLIKELY (n > 0 && set->epoll_ready->len == 0)) {
+    errno = EINTR;
+    return -1;
+  }
+
+  return set->epoll_ready->len;
+}
+#endif
+
 #if !defined(HAVE_PPOLL) && defined(HAVE_POLL)
 /* check if all file descriptors will fit in an fd_set */
 static gboolean
@@ -440,6 +627,10 @@ choose_mode (GstPoll * set, GstClockTime timeout)
   GstPollMode mode;
 
   if (set->mode == GST_POLL_MODE_AUTO) {
+#ifdef HAVE_SYS_EPOLL_H
+    if (g_atomic_int_get (&set->epoll_active))
+      return GST_POLL_MODE_EPOLL;
+#endif
 #ifdef HAVE_PPOLL
     mode = GST_POLL_MODE_PPOLL;
 #elif defined(HAVE_POLL)
@@ -686,11 +877,19 @@ gst_poll_new (gboolean controllable)
   nset->active_fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->control_read_fd.fd = -1;
   nset->control_write_fd.fd = -1;
+#ifdef HAVE_SYS_EPOLL_H
+  nset->epoll_fd = -1;
+#endif
   {
     gint control_sock[2];
 
-    if (socketpair (PF_UNIX, SOCK_STREAM, 0, control_sock) < 0)
-      goto no_socket_pair;
+#ifdef HAVE_SYS_EVENTFD_H
+    /* a single fd is enough for the wakeups */
+    control_sock[0] = control_sock[1] = eventfd (0, EFD_CLOEXEC);
+    if (control_sock[0] < 0)
+#endif
+      if (socketpair (PF_UNIX, SOCK_STREAM, 0, control_sock) < 0)
+        goto no_socket_pair;
 
     nset->control_read_fd.fd = control_sock[0];
     nset->control_write_fd.fd = control_sock[1];
@@ -772,10 +971,17 @@ gst_poll_free (GstPoll * set)
   GST_DEBUG ("%p: freeing", set);
 
 #ifndef G_OS_WIN32
-  if (set->control_write_fd.fd >= 0)
+  if (set->control_write_fd.fd >= 0
+      && set->control_write_fd.fd != set->control_read_fd.fd)
     close (set->control_write_fd.fd);
   if (set->control_read_fd.fd >= 0)
     close (set->control_read_fd.fd);
+#ifdef HAVE_SYS_EPOLL_H
+  if (set->epoll_fd >= 0)
+    close (set->epoll_fd);
+  if (set->epoll_ready)
+    g_array_free (set->epoll_ready, TRUE);
+#endif
 #else
   CloseHandle (set->wakeup_event);
 
@@ -859,6 +1065,12 @@ gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd)
     g_array_append_val (set->fds, nfd);
 
     fd->idx = set->fds->len - 1;
+#ifdef HAVE_SYS_EPOLL_H
+    if (set->epoll_ready)
+      gst_poll_epoll_ctl (set, EPOLL_CTL_ADD, fd->idx);
+    else if (set->fds->len >= EPOLL_MIN_FDS && set->mode == GST_POLL_MODE_AUTO)
+      gst_poll_epoll_start (set);
+#endif
 #else
     WinsockFd wfd;
     HANDLE event;
@@ -939,10 +1151,19 @@ gst_poll_remove_fd (GstPoll * set, GstPollFD * fd)
     gst_poll_free_winsock_event (set, idx);
     g_array_remove_index_fast (set->events, idx);
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+    /* the fd might already be closed, which removed it from the epoll set */
+    if (set->epoll_active)
+      epoll_ctl (set->epoll_fd, EPOLL_CTL_DEL, fd->fd, NULL);
+#endif
 
     /* remove the fd at index, we use _remove_index_fast, which copies the last
      * element of the array to the freed index */
     g_array_remove_index_fast (set->fds, idx);
+#ifdef HAVE_SYS_EPOLL_H
+    if (idx < set->fds->len)
+      gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, idx);
+#endif
 
     /* mark fd as removed by setting the index to -1 */
     fd->idx = -1;
@@ -992,6 +1213,9 @@ gst_poll_fd_ctl_write (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLOUT;
 
     GST_LOG ("%p: pfd->events now %d (POLLOUT:%d)", set, pfd->events, POLLOUT);
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, idx);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_WRITE | FD_CONNECT,
         active);
@@ -1024,6 +1248,9 @@ gst_poll_fd_ctl_read_unlocked (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events |= POLLIN;
     else
       pfd->events &= ~POLLIN;
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, idx);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_READ | FD_ACCEPT, active);
 #endif
@@ -1106,6 +1333,9 @@ gst_poll_fd_ctl_pri (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLPRI;
 
     GST_LOG ("%p: pfd->events now %d (POLLPRI:%d)", set, pfd->events, POLLOUT);
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, idx);
+#endif
     MARK_REBUILD (set);
   } else {
     GST_WARNING ("%p: couldn't find fd !", set);
@@ -1440,6 +1670,11 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
       g_array_set_size (set->active_fds, set->fds->len);
       memcpy (set->active_fds->data, set->fds->data,
           set->fds->len * sizeof (struct pollfd));
+#ifdef HAVE_SYS_EPOLL_H
+      /* the copy has no events set */
+      if (set->epoll_ready)
+        g_array_set_size (set->epoll_ready, 0);
+#endif
 #else
       if (!gst_poll_prepare_winsock_active_sets (set))
         goto winsock_error;
@@ -1490,6 +1725,16 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 #else
         g_assert_not_reached ();
         errno = ENOSYS;
+#endif
+        break;
+      }
+      case GST_POLL_MODE_EPOLL:
+      {
+#ifdef HAVE_SYS_EPOLL_H
+        res = gst_poll_epoll_wait (set, timeout);
+#else
+        g_assert_not_reached ();
+        errno = ENOSYS;
 #endif
         break;
       }
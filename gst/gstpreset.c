@@ -370,139 +370,407 @@ compare_preset_and_version (gconstpointer a, gconstpointer b,
     return 0;
 }
 
-/* reads the user and system presets files and merges them together. This
- * function caches the GKeyFile on the element type. If there is no existing
+/* a file the presets of a type were loaded from, to notice changes */
+typedef struct
+{
+  gchar *path;
+  /* -1 when the file did not exist */
+  gint64 mtime;
+  gint64 size;
+} PresetFileStamp;
+
+/* the deserialized property values of a preset */
+typedef struct
+{
+  gint refcount;
+  guint n_values;
+  const gchar **names;
+  GValue *values;
+} PresetValues;
+
+/* the presets of an element type, attached to the type */
+typedef struct
+{
+  GKeyFile *keyfile;
+  /* array of PresetFileStamp */
+  GArray *stamps;
+  /* preset name -> PresetValues */
+  GHashTable *values;
+  /* changes whenever the values are dropped */
+  guint cookie;
+} PresetCache;
+
+/* protects the PresetCache of all types */
+static GMutex preset_cache_lock;
+
+static void
+preset_stamp_update (PresetFileStamp * stamp)
+{
+  GStatBuf st;
+
+  if (g_stat (stamp->path, &st) == 0) {
+    stamp->mtime = st.st_mtime;
+    stamp->size = st.st_size;
+  } else {
+    stamp->mtime = stamp->size = -1;
+  }
+}
+
+static void
+preset_stamp_add (GArray * stamps, const gchar * path)
+{
+  PresetFileStamp stamp;
+
+  stamp.path = g_strdup (path);
+  preset_stamp_update (&stamp);
+  g_array_append_val (stamps, stamp);
+}
+
+static void
+preset_stamp_clear (PresetFileStamp * stamp)
+{
+  g_free (stamp->path);
+}
+
+static gboolean
+preset_stamps_changed (GArray * stamps)
+{
+  guint i;
+
+  for (i = 0; i < stamps->len; i++) {
+    PresetFileStamp *stamp = &g_array_index (stamps, PresetFileStamp, i);
+    gint64 mtime = stamp->mtime, size = stamp->size;
+
+    preset_stamp_update (stamp);
+    if (stamp->mtime != mtime || stamp->size != size) {
+      GST_INFO ("preset file %s changed", stamp->path);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+static PresetValues *
+preset_values_ref (PresetValues * values)
+{
+  g_atomic_int_inc (&values->refcount);
+  return values;
+}
+
+static void
+preset_values_unref (PresetValues * values)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&values->refcount))
+    return;
+
+  for (i = 0; i < values->n_values; i++)
+    g_value_unset (&values->values[i]);
+  g_free (values->names);
+  g_free (values->values);
+  g_slice_free (PresetValues, values);
+}
+
+/* reads the user and system presets files and merges them together. The
+ * files that were tried are added to @stamps. If there is no existing
  * preset file, a new in-memory GKeyFile will be created. */
 static GKeyFile *
-preset_get_keyfile (GstPreset * preset)
+preset_load_keyfile (GstPreset * preset, GArray * stamps, gboolean * merged)
 {
-  GKeyFile *presets;
-  GType type = G_TYPE_FROM_INSTANCE (preset);
+  const gchar *preset_user_path, *preset_app_path, *preset_system_path;
+  guint64 version_system = G_GUINT64_CONSTANT (0);
+  guint64 version_app = G_GUINT64_CONSTANT (0);
+  guint64 version_user = G_GUINT64_CONSTANT (0);
+  guint64 version = G_GUINT64_CONSTANT (0);
+  GKeyFile *presets = NULL;
+  GKeyFile *in_user, *in_app = NULL, *in_system;
+  GQueue in_env = G_QUEUE_INIT;
+  gboolean have_env = FALSE;
+  const gchar *envvar;
+
+  /* try to load the user, app and system presets, we do this to get the
+   * versions of all files. */
+  preset_get_paths (preset, &preset_user_path, &preset_app_path,
+      &preset_system_path);
+  preset_stamp_add (stamps, preset_user_path);
+  in_user = preset_open_and_parse_header (preset, preset_user_path,
+      &version_user);
 
-  /* first see if the have a cached version for the type */
-  if (!(presets = g_type_get_qdata (type, preset_quark))) {
-    const gchar *preset_user_path, *preset_app_path, *preset_system_path;
-    guint64 version_system = G_GUINT64_CONSTANT (0);
-    guint64 version_app = G_GUINT64_CONSTANT (0);
-    guint64 version_user = G_GUINT64_CONSTANT (0);
-    guint64 version = G_GUINT64_CONSTANT (0);
-    gboolean merged = FALSE;
-    GKeyFile *in_user, *in_app = NULL, *in_system;
-    GQueue in_env = G_QUEUE_INIT;
-    gboolean have_env = FALSE;
-    const gchar *envvar;
-
-    /* try to load the user, app and system presets, we do this to get the
-     * versions of all files. */
-    preset_get_paths (preset, &preset_user_path, &preset_app_path,
-        &preset_system_path);
-    in_user = preset_open_and_parse_header (preset, preset_user_path,
-        &version_user);
-
-    if (preset_app_path) {
-      in_app = preset_open_and_parse_header (preset, preset_app_path,
-          &version_app);
-    }
+  if (preset_app_path) {
+    preset_stamp_add (stamps, preset_app_path);
+    in_app = preset_open_and_parse_header (preset, preset_app_path,
+        &version_app);
+  }
 
-    envvar = g_getenv ("GST_PRESET_PATH");
-    if (envvar) {
-      gint i;
-      gchar **preset_dirs = g_strsplit (envvar, G_SEARCHPATH_SEPARATOR_S, -1);
-
-      for (i = 0; preset_dirs[i]; i++) {
-        gchar *preset_path = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.prs",
-            preset_dirs[i], G_OBJECT_TYPE_NAME (preset));
-        GKeyFile *env_file;
-        guint64 env_version;
-
-        env_file = preset_open_and_parse_header (preset, preset_path,
-            &env_version);
-        g_free (preset_path);
-        if (env_file) {
-          PresetAndVersion *pv = g_new (PresetAndVersion, 1);
-          pv->preset = env_file;
-          pv->version = env_version;
-          g_queue_push_tail (&in_env, pv);
-          have_env = TRUE;
-        }
+  envvar = g_getenv ("GST_PRESET_PATH");
+  if (envvar) {
+    gint i;
+    gchar **preset_dirs = g_strsplit (envvar, G_SEARCHPATH_SEPARATOR_S, -1);
+
+    for (i = 0; preset_dirs[i]; i++) {
+      gchar *preset_path = g_strdup_printf ("%s" G_DIR_SEPARATOR_S "%s.prs",
+          preset_dirs[i], G_OBJECT_TYPE_NAME (preset));
+      GKeyFile *env_file;
+      guint64 env_version;
+
+      preset_stamp_add (stamps, preset_path);
+      env_file = preset_open_and_parse_header (preset, preset_path,
+          &env_version);
+      g_free (preset_path);
+      if (env_file) {
+        PresetAndVersion *pv = g_new (PresetAndVersion, 1);
+        pv->preset = env_file;
+        pv->version = env_version;
+        g_queue_push_tail (&in_env, pv);
+        have_env = TRUE;
       }
-      g_strfreev (preset_dirs);
     }
+    g_strfreev (preset_dirs);
+  }
 
-    in_system = preset_open_and_parse_header (preset, preset_system_path,
-        &version_system);
+  preset_stamp_add (stamps, preset_system_path);
+  in_system = preset_open_and_parse_header (preset, preset_system_path,
+      &version_system);
 
-    /* compare version to check for merge */
-    if (in_system) {
-      presets = in_system;
-      version = version_system;
-    }
+  /* compare version to check for merge */
+  if (in_system) {
+    presets = in_system;
+    version = version_system;
+  }
 
-    if (have_env) {
-      GList *l;
-
-      /* merge the ones from the environment paths. If any of them has a
-       * higher version, take that as the "master" version. Lower versions are
-       * then just merged in. */
-      g_queue_sort (&in_env, compare_preset_and_version, NULL);
-      /* highest version to lowest */
-      for (l = in_env.head; l; l = l->next) {
-        PresetAndVersion *pv = l->data;
-
-        if (version > pv->version) {
-          preset_merge (presets, pv->preset);
-          g_key_file_free (pv->preset);
-        } else {
-          if (presets)
-            g_key_file_free (presets);
-          presets = pv->preset;
-          version = pv->version;
-        }
-        g_free (pv);
-      }
-      g_queue_clear (&in_env);
-    }
+  if (have_env) {
+    GList *l;
+
+    /* merge the ones from the environment paths. If any of them has a
+     * higher version, take that as the "master" version. Lower versions are
+     * then just merged in. */
+    g_queue_sort (&in_env, compare_preset_and_version, NULL);
+    /* highest version to lowest */
+    for (l = in_env.head; l; l = l->next) {
+      PresetAndVersion *pv = l->data;
 
-    if (in_app) {
-      /* if system/env version is higher, merge */
-      if (version > version_app) {
-        preset_merge (presets, in_app);
-        g_key_file_free (in_app);
+      if (version > pv->version) {
+        preset_merge (presets, pv->preset);
+        g_key_file_free (pv->preset);
       } else {
         if (presets)
           g_key_file_free (presets);
-        presets = in_app;
-        version = version_app;
+        presets = pv->preset;
+        version = pv->version;
       }
+      g_free (pv);
     }
-    if (in_user) {
-      /* if system/env or app version is higher, merge */
-      if (version > version_user) {
-        preset_merge (presets, in_user);
-        g_key_file_free (in_user);
-        merged = TRUE;
-      } else {
-        if (presets)
-          g_key_file_free (presets);
-        presets = in_user;
-      }
+    g_queue_clear (&in_env);
+  }
+
+  if (in_app) {
+    /* if system/env version is higher, merge */
+    if (version > version_app) {
+      preset_merge (presets, in_app);
+      g_key_file_free (in_app);
+    } else {
+      if (presets)
+        g_key_file_free (presets);
+      presets = in_app;
+      version = version_app;
+    }
+  }
+  if (in_user) {
+    /* if system/env or app version is higher, merge */
+    if (version > version_user) {
+      preset_merge (presets, in_user);
+      g_key_file_free (in_user);
+      *merged = TRUE;
+    } else {
+      if (presets)
+        g_key_file_free (presets);
+      presets = in_user;
     }
+  }
+
+  if (!presets) {
+    /* we did not load a user, app or system presets file, create a new one */
+    presets = g_key_file_new ();
+    g_key_file_set_string (presets, PRESET_HEADER, PRESET_HEADER_ELEMENT_NAME,
+        G_OBJECT_TYPE_NAME (preset));
+  }
+
+  return presets;
+}
+
+/* returns the presets of the type of @preset. They are cached on the type and
+ * reloaded when one of the preset files changed. */
+static GKeyFile *
+preset_get_keyfile (GstPreset * preset)
+{
+  GType type = G_TYPE_FROM_INSTANCE (preset);
+  PresetCache *cache;
+  GKeyFile *presets;
+  gboolean merged = FALSE;
+
+  g_mutex_lock (&preset_cache_lock);
+  if (!(cache = g_type_get_qdata (type, preset_quark))) {
+    cache = g_slice_new0 (PresetCache);
+    cache->stamps = g_array_new (FALSE, FALSE, sizeof (PresetFileStamp));
+    g_array_set_clear_func (cache->stamps,
+        (GDestroyNotify) preset_stamp_clear);
+    cache->values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) preset_values_unref);
+    cache->keyfile = preset_load_keyfile (preset, cache->stamps, &merged);
+
+    /* attach the presets to the type */
+    g_type_set_qdata (type, preset_quark, cache);
+  } else if (preset_stamps_changed (cache->stamps)) {
+    GKeyFile *fresh;
+    gchar *data;
+    gsize size;
+
+    GST_INFO_OBJECT (preset, "reloading changed presets");
+    g_array_set_size (cache->stamps, 0);
+    fresh = preset_load_keyfile (preset, cache->stamps, &merged);
+
+    /* load into the cached keyfile, it might still be used by others */
+    data = g_key_file_to_data (fresh, &size, NULL);
+    g_key_file_load_from_data (cache->keyfile, data, size,
+        G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS, NULL);
+    g_free (data);
+    g_key_file_free (fresh);
 
-    if (!presets) {
-      /* we did not load a user, app or system presets file, create a new one */
-      presets = g_key_file_new ();
-      g_key_file_set_string (presets, PRESET_HEADER, PRESET_HEADER_ELEMENT_NAME,
-          G_OBJECT_TYPE_NAME (preset));
+    g_hash_table_remove_all (cache->values);
+    cache->cookie++;
+  }
+  presets = cache->keyfile;
+  g_mutex_unlock (&preset_cache_lock);
+
+  if (merged) {
+    gst_preset_default_save_presets_file (preset);
+  }
+  return presets;
+}
+
+/* drops the cached values after the presets were changed and takes new
+ * stamps of the preset files when they were written */
+static void
+preset_cache_changed (GstPreset * preset, gboolean written)
+{
+  PresetCache *cache;
+
+  g_mutex_lock (&preset_cache_lock);
+  if ((cache = g_type_get_qdata (G_TYPE_FROM_INSTANCE (preset), preset_quark))) {
+    if (written) {
+      guint i;
+
+      for (i = 0; i < cache->stamps->len; i++)
+        preset_stamp_update (&g_array_index (cache->stamps, PresetFileStamp,
+                i));
     }
+    g_hash_table_remove_all (cache->values);
+    cache->cookie++;
+  }
+  g_mutex_unlock (&preset_cache_lock);
+}
+
+/* deserializes the values of the preset @name for the properties of
+ * @preset */
+static PresetValues *
+preset_values_new (GstPreset * preset, GKeyFile * presets, const gchar * name)
+{
+  PresetValues *values;
+  GObjectClass *gclass;
+  gchar **props;
+  guint i, n_props;
 
-    /* attach the preset to the type */
-    g_type_set_qdata (type, preset_quark, (gpointer) presets);
+  /* get the properties that we can configure in this element */
+  if (!(props = gst_preset_get_property_names (preset)))
+    return NULL;
+
+  gclass = G_OBJECT_CLASS (GST_ELEMENT_GET_CLASS (preset));
+  n_props = g_strv_length (props);
 
-    if (merged) {
-      gst_preset_default_save_presets_file (preset);
+  values = g_slice_new0 (PresetValues);
+  values->refcount = 1;
+  values->names = g_new (const gchar *, n_props);
+  values->values = g_new0 (GValue, n_props);
+
+  /* for each of the property names, find the preset parameter and try to
+   * deserialize its value */
+  for (i = 0; props[i]; i++) {
+    GValue *gvalue = &values->values[values->n_values];
+    GParamSpec *property;
+    gchar *str;
+
+    /* check if we have a settings for this element property */
+    if (!(str = g_key_file_get_value (presets, name, props[i], NULL))) {
+      /* the element has a property but the parameter is not in the keyfile */
+      GST_INFO_OBJECT (preset, "parameter '%s' not in preset", props[i]);
+      continue;
     }
+
+    GST_DEBUG_OBJECT (preset, "using value '%s' for property '%s'", str,
+        props[i]);
+
+    if (!(property = g_object_class_find_property (gclass, props[i]))) {
+      /* the parameter was in the keyfile, the element said it supported it but
+       * then the property was not found in the element. This should not happen. */
+      GST_WARNING_OBJECT (preset, "property '%s' not in object", props[i]);
+      g_free (str);
+      continue;
+    }
+
+    g_value_init (gvalue, property->value_type);
+    if (gst_value_deserialize (gvalue, str)) {
+      /* the name of the property stays around with the class */
+      values->names[values->n_values++] = property->name;
+    } else {
+      GST_WARNING_OBJECT (preset,
+          "deserialization of value '%s' for property '%s' failed", str,
+          props[i]);
+      g_value_unset (gvalue);
+    }
+    g_free (str);
   }
-  return presets;
+  g_strfreev (props);
+
+  return values;
+}
+
+/* get the deserialized values of the preset @name, they are cached on the type
+ * of @preset */
+static PresetValues *
+preset_get_values (GstPreset * preset, GKeyFile * presets, const gchar * name)
+{
+  PresetCache *cache;
+  PresetValues *values, *other;
+  guint cookie;
+
+  g_mutex_lock (&preset_cache_lock);
+  cache = g_type_get_qdata (G_TYPE_FROM_INSTANCE (preset), preset_quark);
+  if ((values = g_hash_table_lookup (cache->values, name))) {
+    preset_values_ref (values);
+    g_mutex_unlock (&preset_cache_lock);
+    return values;
+  }
+  cookie = cache->cookie;
+  g_mutex_unlock (&preset_cache_lock);
+
+  /* the element might be called to get its property names, don't hold the
+   * lock */
+  if (!(values = preset_values_new (preset, presets, name)))
+    return NULL;
+
+  g_mutex_lock (&preset_cache_lock);
+  if ((other = g_hash_table_lookup (cache->values, name))) {
+    /* someone else was faster */
+    preset_values_unref (values);
+    values = preset_values_ref (other);
+  } else if (cookie == cache->cookie) {
+    g_hash_table_insert (cache->values, g_strdup (name),
+        preset_values_ref (values));
+  }
+  g_mutex_unlock (&preset_cache_lock);
+
+  return values;
 }
 
 static gint
@@ -641,8 +909,6 @@ gst_preset_default_load_preset (GstPreset * preset, const gchar * name)
   GKeyFile *presets;
   gchar **props;
   guint i;
-  GObjectClass *gclass;
-  gboolean is_child_proxy;
 
   /* get the presets from the type */
   if (!(presets = preset_get_keyfile (preset)))
@@ -654,13 +920,26 @@ gst_preset_default_load_preset (GstPreset * preset, const gchar * name)
 
   GST_DEBUG_OBJECT (preset, "loading preset : '%s'", name);
 
-  /* get the properties that we can configure in this element */
+  if (!GST_IS_CHILD_PROXY (preset)) {
+    PresetValues *values;
+
+    /* the properties only depend on the type, so we can set the values that
+     * were deserialized for the previous instances */
+    if (!(values = preset_get_values (preset, presets, name)))
+      goto no_properties;
+
+    g_object_setv ((GObject *) preset, values->n_values, values->names,
+        values->values);
+    preset_values_unref (values);
+
+    return TRUE;
+  }
+
+  /* get the properties that we can configure in this element, they depend on
+   * the children */
   if (!(props = gst_preset_get_property_names (preset)))
     goto no_properties;
 
-  gclass = G_OBJECT_CLASS (GST_ELEMENT_GET_CLASS (preset));
-  is_child_proxy = GST_IS_CHILD_PROXY (preset);
-
   /* for each of the property names, find the preset parameter and try to
    * configure the property with its value */
   for (i = 0; props[i]; i++) {
@@ -678,12 +957,8 @@ gst_preset_default_load_preset (GstPreset * preset, const gchar * name)
     GST_DEBUG_OBJECT (preset, "setting value '%s' for property '%s'", str,
         props[i]);
 
-    if (is_child_proxy) {
-      gst_child_proxy_lookup ((GstChildProxy *) preset, props[i], NULL,
-          &property);
-    } else {
-      property = g_object_class_find_property (gclass, props[i]);
-    }
+    gst_child_proxy_lookup ((GstChildProxy *) preset, props[i], NULL,
+        &property);
     if (!property) {
       /* the parameter was in the keyfile, the element said it supported it but
        * then the property was not found in the element. This should not happen. */
@@ -696,12 +971,8 @@ gst_preset_default_load_preset (GstPreset * preset, const gchar * name)
      * the object property */
     g_value_init (&gvalue, property->value_type);
     if (gst_value_deserialize (&gvalue, str)) {
-      if (is_child_proxy) {
-        gst_child_proxy_set_property ((GstChildProxy *) preset, props[i],
-            &gvalue);
-      } else {
-        g_object_set_property ((GObject *) preset, props[i], &gvalue);
-      }
+      gst_child_proxy_set_property ((GstChildProxy *) preset, props[i],
+          &gvalue);
     } else {
       GST_WARNING_OBJECT (preset,
           "deserialization of value '%s' for property '%s' failed", str,
@@ -784,6 +1055,9 @@ gst_preset_default_save_presets_file (GstPreset * preset)
 
   g_free (data);
 
+  /* don't reload the file we just wrote */
+  preset_cache_changed (preset, TRUE);
+
   return TRUE;
 
   /* ERRORS */
@@ -801,6 +1075,7 @@ convert_failed:
         error->message);
     g_error_free (error);
     g_free (data);
+    preset_cache_changed (preset, FALSE);
     return FALSE;
   }
 write_failed:
@@ -809,6 +1084,7 @@ write_failed:
         preset_path, error->message);
     g_error_free (error);
     g_free (data);
+    preset_cache_changed (preset, FALSE);
     return FALSE;
   }
 }
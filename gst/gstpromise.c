@@ -91,8 +91,17 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
 static const int immutable_structure_refcount = 2;
 
+/* The result only ever moves out of pending once, with a compare-and-swap,
+ * so that the thread winning the transition doesn't need the lock. A reply
+ * goes through the internal replying state while the reply is stored, which
+ * waiters treat like pending. The lock and cond are only used when someone
+ * waits, replying to a promise that only has a change function never takes
+ * the lock. */
+#define PROMISE_RESULT_REPLYING         (-1)
+
 #define GST_PROMISE_REPLY(p)            (((GstPromiseImpl *)(p))->reply)
 #define GST_PROMISE_RESULT(p)           (((GstPromiseImpl *)(p))->result)
+#define GST_PROMISE_WAITERS(p)          (((GstPromiseImpl *)(p))->waiters)
 #define GST_PROMISE_LOCK(p)             (&(((GstPromiseImpl *)(p))->lock))
 #define GST_PROMISE_COND(p)             (&(((GstPromiseImpl *)(p))->cond))
 #define GST_PROMISE_CHANGE_FUNC(p)      (((GstPromiseImpl *)(p))->change_func)
@@ -103,9 +112,11 @@ typedef struct
 {
   GstPromise promise;
 
-  GstPromiseResult result;
+  /* a GstPromiseResult or PROMISE_RESULT_REPLYING, accessed atomically */
+  gint result;
   GstStructure *reply;
 
+  gint waiters;
   GMutex lock;
   GCond cond;
   GstPromiseChangeFunc change_func;
@@ -113,6 +124,39 @@ typedef struct
   GDestroyNotify notify;
 } GstPromiseImpl;
 
+static inline gboolean
+result_is_pending (gint result)
+{
+  return result == GST_PROMISE_RESULT_PENDING
+      || result == PROMISE_RESULT_REPLYING;
+}
+
+/* moves @promise from pending to @to, returns the result it had before or
+ * the current result when @promise was not pending */
+static inline gint
+promise_transition (GstPromise * promise, gint to)
+{
+  if (g_atomic_int_compare_and_exchange (&GST_PROMISE_RESULT (promise),
+          GST_PROMISE_RESULT_PENDING, to))
+    return GST_PROMISE_RESULT_PENDING;
+
+  return g_atomic_int_get (&GST_PROMISE_RESULT (promise));
+}
+
+/* called after the final result was set */
+static void
+promise_wake_waiters (GstPromise * promise)
+{
+  /* waiters register before checking the result, so when none is seen here
+   * any later waiter sees the final result */
+  if (g_atomic_int_get (&GST_PROMISE_WAITERS (promise)) == 0)
+    return;
+
+  g_mutex_lock (GST_PROMISE_LOCK (promise));
+  g_cond_broadcast (GST_PROMISE_COND (promise));
+  g_mutex_unlock (GST_PROMISE_LOCK (promise));
+}
+
 /**
  * gst_promise_wait:
  * @promise: a #GstPromise
@@ -128,20 +172,24 @@ typedef struct
 GstPromiseResult
 gst_promise_wait (GstPromise * promise)
 {
-  GstPromiseResult ret;
+  gint ret;
 
   g_return_val_if_fail (promise != NULL, GST_PROMISE_RESULT_EXPIRED);
 
-  g_mutex_lock (GST_PROMISE_LOCK (promise));
-  ret = GST_PROMISE_RESULT (promise);
+  ret = g_atomic_int_get (&GST_PROMISE_RESULT (promise));
+  if (!result_is_pending (ret))
+    return ret;
 
-  while (ret == GST_PROMISE_RESULT_PENDING) {
+  g_mutex_lock (GST_PROMISE_LOCK (promise));
+  g_atomic_int_inc (&GST_PROMISE_WAITERS (promise));
+  ret = g_atomic_int_get (&GST_PROMISE_RESULT (promise));
+  while (result_is_pending (ret)) {
     GST_LOG ("%p waiting", promise);
     g_cond_wait (GST_PROMISE_COND (promise), GST_PROMISE_LOCK (promise));
-    ret = GST_PROMISE_RESULT (promise);
+    ret = g_atomic_int_get (&GST_PROMISE_RESULT (promise));
   }
+  g_atomic_int_add (&GST_PROMISE_WAITERS (promise), -1);
   GST_LOG ("%p waited", promise);
-
   g_mutex_unlock (GST_PROMISE_LOCK (promise));
 
   return ret;
@@ -164,54 +212,40 @@ gst_promise_wait (GstPromise * promise)
 void
 gst_promise_reply (GstPromise * promise, GstStructure * s)
 {
-  GstPromiseChangeFunc change_func = NULL;
-  gpointer change_data = NULL;
+  gint result;
 
   /* Caller requested that no reply is necessary */
   if (promise == NULL)
     return;
 
-  g_mutex_lock (GST_PROMISE_LOCK (promise));
-  if (GST_PROMISE_RESULT (promise) != GST_PROMISE_RESULT_PENDING &&
-      GST_PROMISE_RESULT (promise) != GST_PROMISE_RESULT_INTERRUPTED) {
-    GstPromiseResult result = GST_PROMISE_RESULT (promise);
-    g_mutex_unlock (GST_PROMISE_LOCK (promise));
-    g_return_if_fail (result == GST_PROMISE_RESULT_PENDING ||
-        result == GST_PROMISE_RESULT_INTERRUPTED);
+  if (s
+      && !gst_structure_set_parent_refcount (s,
+          (int *) &immutable_structure_refcount)) {
+    g_critical ("Input structure has a parent already!");
+    return;
   }
 
-  /* XXX: is this necessary and valid? */
-  if (GST_PROMISE_REPLY (promise) && GST_PROMISE_REPLY (promise) != s)
-    gst_structure_free (GST_PROMISE_REPLY (promise));
-
   /* Only reply iff we are currently in pending */
-  if (GST_PROMISE_RESULT (promise) == GST_PROMISE_RESULT_PENDING) {
-    if (s
-        && !gst_structure_set_parent_refcount (s,
-            (int *) &immutable_structure_refcount)) {
-      g_critical ("Input structure has a parent already!");
-      g_mutex_unlock (GST_PROMISE_LOCK (promise));
-      return;
-    }
-
-    GST_PROMISE_RESULT (promise) = GST_PROMISE_RESULT_REPLIED;
-    GST_LOG ("%p replied", promise);
-
-    GST_PROMISE_REPLY (promise) = s;
-
-    change_func = GST_PROMISE_CHANGE_FUNC (promise);
-    change_data = GST_PROMISE_CHANGE_DATA (promise);
-  } else {
+  result = promise_transition (promise, PROMISE_RESULT_REPLYING);
+  if (result != GST_PROMISE_RESULT_PENDING) {
     /* eat the value */
-    if (s)
+    if (s) {
+      gst_structure_set_parent_refcount (s, NULL);
       gst_structure_free (s);
+    }
+    g_return_if_fail (result == GST_PROMISE_RESULT_INTERRUPTED);
+    return;
   }
 
-  g_cond_broadcast (GST_PROMISE_COND (promise));
-  g_mutex_unlock (GST_PROMISE_LOCK (promise));
+  GST_PROMISE_REPLY (promise) = s;
+  g_atomic_int_set (&GST_PROMISE_RESULT (promise), GST_PROMISE_RESULT_REPLIED);
+  GST_LOG ("%p replied", promise);
 
-  if (change_func)
-    change_func (promise, change_data);
+  promise_wake_waiters (promise);
+
+  if (GST_PROMISE_CHANGE_FUNC (promise))
+    GST_PROMISE_CHANGE_FUNC (promise) (promise,
+        GST_PROMISE_CHANGE_DATA (promise));
 }
 
 /**
@@ -229,15 +263,8 @@ const GstStructure *
 gst_promise_get_reply (GstPromise * promise)
 {
   g_return_val_if_fail (promise != NULL, NULL);
-
-  g_mutex_lock (GST_PROMISE_LOCK (promise));
-  if (GST_PROMISE_RESULT (promise) != GST_PROMISE_RESULT_REPLIED) {
-    GstPromiseResult result = GST_PROMISE_RESULT (promise);
-    g_mutex_unlock (GST_PROMISE_LOCK (promise));
-    g_return_val_if_fail (result == GST_PROMISE_RESULT_REPLIED, NULL);
-  }
-
-  g_mutex_unlock (GST_PROMISE_LOCK (promise));
+  g_return_val_if_fail (g_atomic_int_get (&GST_PROMISE_RESULT (promise)) ==
+      GST_PROMISE_RESULT_REPLIED, NULL);
 
   return GST_PROMISE_REPLY (promise);
 }
@@ -255,32 +282,25 @@ gst_promise_get_reply (GstPromise * promise)
 void
 gst_promise_interrupt (GstPromise * promise)
 {
-  GstPromiseChangeFunc change_func = NULL;
-  gpointer change_data = NULL;
+  gint result;
 
   g_return_if_fail (promise != NULL);
 
-  g_mutex_lock (GST_PROMISE_LOCK (promise));
-  if (GST_PROMISE_RESULT (promise) != GST_PROMISE_RESULT_PENDING &&
-      GST_PROMISE_RESULT (promise) != GST_PROMISE_RESULT_REPLIED) {
-    GstPromiseResult result = GST_PROMISE_RESULT (promise);
-    g_mutex_unlock (GST_PROMISE_LOCK (promise));
-    g_return_if_fail (result == GST_PROMISE_RESULT_PENDING ||
-        result == GST_PROMISE_RESULT_REPLIED);
-  }
-  /* only interrupt if we are currently in pending */
-  if (GST_PROMISE_RESULT (promise) == GST_PROMISE_RESULT_PENDING) {
-    GST_PROMISE_RESULT (promise) = GST_PROMISE_RESULT_INTERRUPTED;
-    g_cond_broadcast (GST_PROMISE_COND (promise));
-    GST_LOG ("%p interrupted", promise);
-
-    change_func = GST_PROMISE_CHANGE_FUNC (promise);
-    change_data = GST_PROMISE_CHANGE_DATA (promise);
+  /* only interrupt if we are currently in pending, a reply that is being
+   * stored counts as replied */
+  result = promise_transition (promise, GST_PROMISE_RESULT_INTERRUPTED);
+  if (result != GST_PROMISE_RESULT_PENDING) {
+    g_return_if_fail (result == GST_PROMISE_RESULT_REPLIED
+        || result == PROMISE_RESULT_REPLYING);
+    return;
   }
-  g_mutex_unlock (GST_PROMISE_LOCK (promise));
+  GST_LOG ("%p interrupted", promise);
 
-  if (change_func)
-    change_func (promise, change_data);
+  promise_wake_waiters (promise);
+
+  if (GST_PROMISE_CHANGE_FUNC (promise))
+    GST_PROMISE_CHANGE_FUNC (promise) (promise,
+        GST_PROMISE_CHANGE_DATA (promise));
 }
 
 /**
@@ -296,23 +316,22 @@ gst_promise_interrupt (GstPromise * promise)
 void
 gst_promise_expire (GstPromise * promise)
 {
-  GstPromiseChangeFunc change_func = NULL;
-  gpointer change_data = NULL;
+  GstPromiseChangeFunc change_func;
+  gpointer change_data;
 
   g_return_if_fail (promise != NULL);
 
-  g_mutex_lock (GST_PROMISE_LOCK (promise));
-  if (GST_PROMISE_RESULT (promise) == GST_PROMISE_RESULT_PENDING) {
-    GST_PROMISE_RESULT (promise) = GST_PROMISE_RESULT_EXPIRED;
-    g_cond_broadcast (GST_PROMISE_COND (promise));
-    GST_LOG ("%p expired", promise);
-
-    change_func = GST_PROMISE_CHANGE_FUNC (promise);
-    change_data = GST_PROMISE_CHANGE_DATA (promise);
-    GST_PROMISE_CHANGE_FUNC (promise) = NULL;
-    GST_PROMISE_CHANGE_DATA (promise) = NULL;
-  }
-  g_mutex_unlock (GST_PROMISE_LOCK (promise));
+  if (promise_transition (promise, GST_PROMISE_RESULT_EXPIRED) !=
+      GST_PROMISE_RESULT_PENDING)
+    return;
+  GST_LOG ("%p expired", promise);
+
+  change_func = GST_PROMISE_CHANGE_FUNC (promise);
+  change_data = GST_PROMISE_CHANGE_DATA (promise);
+  GST_PROMISE_CHANGE_FUNC (promise) = NULL;
+  GST_PROMISE_CHANGE_DATA (promise) = NULL;
+
+  promise_wake_waiters (promise);
 
   if (change_func)
     change_func (promise, change_data);
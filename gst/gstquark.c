@@ -22,6 +22,7 @@
 
 #include "gst_private.h"
 #include "gstquark.h"
+#include <string.h>
 #include "gstelementmetadata.h"
 
 /* These strings must match order and number declared in the GstQuarkId
@@ -80,11 +81,32 @@ static const gchar *_quark_strings[] = {
   "GstEventInstantRateChange",
   "GstEventInstantRateSyncTime", "GstMessageInstantRateRequest",
   "upstream-running-time", "base", "offset", "plugin-api", "plugin-api-flags",
-  "gap-flags"
+  "gap-flags", "idle-timeout"
 };
 
 GQuark _priv_gst_quark_table[GST_QUARK_MAX];
 
+/* Open addressing hash table from the strings above to their index + 1, 0
+ * marks an empty slot. It is filled once by _priv_gst_quarks_initialize()
+ * and only read afterwards, so lookups don't need a lock. */
+#define QUARK_INDEX_SIZE 512
+#define QUARK_INDEX_MASK (QUARK_INDEX_SIZE - 1)
+static guint16 _quark_index[QUARK_INDEX_SIZE];
+
+/* Per thread cache of the quarks that are not in the table above, direct
+ * mapped by hash. The strings are the ones owned by GLib for the quark,
+ * which stay valid forever. */
+#define QUARK_CACHE_SIZE 256
+#define QUARK_CACHE_MASK (QUARK_CACHE_SIZE - 1)
+
+typedef struct
+{
+  const gchar *string;
+  GQuark quark;
+} QuarkCacheEntry;
+
+static GPrivate quark_cache = G_PRIVATE_INIT (g_free);
+
 void
 _priv_gst_quarks_initialize (void)
 {
@@ -94,7 +116,93 @@ _priv_gst_quarks_initialize (void)
     g_warning ("the quark table is not consistent! %d != %d",
         (int) G_N_ELEMENTS (_quark_strings), GST_QUARK_MAX);
 
+  G_STATIC_ASSERT (GST_QUARK_MAX < QUARK_INDEX_SIZE / 2);
+
   for (i = 0; i < GST_QUARK_MAX; i++) {
+    guint slot = g_str_hash (_quark_strings[i]) & QUARK_INDEX_MASK;
+
     _priv_gst_quark_table[i] = g_quark_from_static_string (_quark_strings[i]);
+
+    /* some strings are in the table twice, keep the first one */
+    while (_quark_index[slot] != 0 &&
+        strcmp (_quark_strings[_quark_index[slot] - 1], _quark_strings[i]))
+      slot = (slot + 1) & QUARK_INDEX_MASK;
+    if (_quark_index[slot] == 0)
+      _quark_index[slot] = i + 1;
+  }
+}
+
+static inline GQuark
+quark_lookup_static (const gchar * string, guint hash)
+{
+  guint slot = hash & QUARK_INDEX_MASK;
+  guint16 idx;
+
+  while ((idx = _quark_index[slot]) != 0) {
+    if (strcmp (_quark_strings[idx - 1], string) == 0)
+      return _priv_gst_quark_table[idx - 1];
+    slot = (slot + 1) & QUARK_INDEX_MASK;
+  }
+  return 0;
+}
+
+static inline QuarkCacheEntry *
+quark_cache_get (guint hash)
+{
+  QuarkCacheEntry *cache = g_private_get (&quark_cache);
+
+  if (G_UNLIKELY (cache == NULL)) {
+    cache = g_new0 (QuarkCacheEntry, QUARK_CACHE_SIZE);
+    g_private_set (&quark_cache, cache);
+  }
+  return &cache[hash & QUARK_CACHE_MASK];
+}
+
+static GQuark
+quark_lookup (const gchar * string, gboolean create)
+{
+  QuarkCacheEntry *entry;
+  GQuark quark;
+  guint hash;
+
+  hash = g_str_hash (string);
+  if ((quark = quark_lookup_static (string, hash)))
+    return quark;
+
+  entry = quark_cache_get (hash);
+  if (entry->string && strcmp (entry->string, string) == 0)
+    return entry->quark;
+
+  /* not seen by this thread yet, ask GLib */
+  if (create)
+    quark = g_quark_from_string (string);
+  else
+    quark = g_quark_try_string (string);
+
+  if (quark) {
+    entry->string = g_quark_to_string (quark);
+    entry->quark = quark;
   }
+  return quark;
+}
+
+/* Like g_quark_from_string(), but common GStreamer strings and strings this
+ * thread looked up before are found without taking the GLib quark lock */
+GQuark
+_priv_gst_quark_from_string (const gchar * string)
+{
+  if (string == NULL)
+    return 0;
+
+  return quark_lookup (string, TRUE);
+}
+
+/* Like g_quark_try_string(), see _priv_gst_quark_from_string() */
+GQuark
+_priv_gst_quark_try_string (const gchar * string)
+{
+  if (string == NULL)
+    return 0;
+
+  return quark_lookup (string, FALSE);
 }
@@ -231,11 +231,15 @@ typedef enum _GstQuarkId
   GST_QUARK_PLUGIN_API = 200,
   GST_QUARK_PLUGIN_API_FLAGS = 201,
   GST_QUARK_GAP_FLAGS = 202,
-  GST_QUARK_MAX = 203
+  GST_QUARK_IDLE_TIMEOUT = 203,
+  GST_QUARK_MAX = 204
 } GstQuarkId;
 
 extern GQuark _priv_gst_quark_table[GST_QUARK_MAX];
 
+G_GNUC_INTERNAL GQuark _priv_gst_quark_from_string (const gchar * string);
+G_GNUC_INTERNAL GQuark _priv_gst_quark_try_string (const gchar * string);
+
 #define GST_QUARK(q) _priv_gst_quark_table[GST_QUARK_##q]
 
 #endif
@@ -62,6 +62,7 @@
 #include "gstquark.h"
 #include "gsturi.h"
 #include "gstbufferpool.h"
+#include "gstslicecache.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_query_debug);
 #define GST_CAT_DEFAULT gst_query_debug
@@ -200,7 +201,7 @@ _gst_query_free (GstQuery * query)
   memset (query, 0xff, sizeof (GstQueryImpl));
 #endif
 
-  g_slice_free1 (sizeof (GstQueryImpl), query);
+  _priv_gst_slice_cache_free (sizeof (GstQueryImpl), query);
 }
 
 static GstQuery *
@@ -674,7 +675,7 @@ gst_query_new_custom (GstQueryType type, GstStructure * structure)
 {
   GstQueryImpl *query;
 
-  query = g_slice_new0 (GstQueryImpl);
+  query = _priv_gst_slice_cache_alloc0 (sizeof (GstQueryImpl));
 
   GST_DEBUG ("creating new query %p %s", query, gst_query_type_get_name (type));
 
@@ -697,7 +698,7 @@ gst_query_new_custom (GstQueryType type, GstStructure * structure)
   /* ERRORS */
 had_parent:
   {
-    g_slice_free1 (sizeof (GstQueryImpl), query);
+    _priv_gst_slice_cache_free (sizeof (GstQueryImpl), query);
     g_warning ("structure is already owned by another object");
     return NULL;
   }
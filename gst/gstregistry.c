@@ -101,6 +101,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 /* For g_stat () */
 #include <glib/gstdio.h>
@@ -154,6 +155,9 @@ struct _GstRegistryPrivate
   /* hash to speedup _lookup */
   GHashTable *basename_hash;
 
+  /* path -> GstRegistryDirSummary of the directories seen by the last scan */
+  GHashTable *dir_index;
+
   /* updated whenever the feature list changes */
   guint32 cookie;
   /* speedup for searching features */
@@ -163,6 +167,43 @@ struct _GstRegistryPrivate
   guint32 tfl_cookie;
   GList *device_provider_factory_list;
   guint32 dmfl_cookie;
+
+  /* secondary indices over the element factories, rebuilt on demand when
+   * the cookie changes */
+  GstRegistryFactoryIndex *type_index;
+  GstRegistryFactoryIndex *media_type_index;
+};
+
+typedef struct
+{
+  GstElementFactory *factory;
+  GstElementFactoryListType type_mask;
+} GstRegistryFactoryEntry;
+
+/* An index over the element factories of the registry at the time of the
+ * given cookie. Never modified after it was built, so it can be used without
+ * holding the registry lock. */
+struct _GstRegistryFactoryIndex
+{
+  gint refcount;
+  guint32 cookie;
+
+  /* GstElementFactory -> GstRegistryFactoryEntry, holding a reference to
+   * each factory */
+  GHashTable *factories;
+
+  /* factory type bit -> GPtrArray of GstRegistryFactoryEntry with that bit
+   * in their type mask */
+  GPtrArray *by_type[64];
+
+  /* per GstPadDirection: media type quark -> set of the factories that have a
+   * template for it, and the set of factories that have ANY template caps */
+  GHashTable *by_media_type[3];
+  GHashTable *any_media_type[3];
+
+  /* per GstURIType: URI protocol, compared case-insensitively -> GPtrArray
+   * of the factories handling it. The keys are owned by the factories. */
+  GHashTable *by_uri_protocol[3];
 };
 
 /* the one instance of the default registry and the mutex protecting the
@@ -252,6 +293,8 @@ gst_registry_init (GstRegistry * registry)
   registry->priv = gst_registry_get_instance_private (registry);
   registry->priv->feature_hash = g_hash_table_new (g_str_hash, g_str_equal);
   registry->priv->basename_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  registry->priv->dir_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, g_free);
 }
 
 static void
@@ -299,6 +342,8 @@ gst_registry_finalize (GObject * object)
   registry->priv->feature_hash = NULL;
   g_hash_table_destroy (registry->priv->basename_hash);
   registry->priv->basename_hash = NULL;
+  g_hash_table_destroy (registry->priv->dir_index);
+  registry->priv->dir_index = NULL;
 
   if (registry->priv->element_factory_list) {
     GST_DEBUG_OBJECT (registry, "Cleaning up cached element factory list");
@@ -316,6 +361,11 @@ gst_registry_finalize (GObject * object)
     gst_plugin_feature_list_free (registry->priv->device_provider_factory_list);
   }
 
+  if (registry->priv->type_index)
+    _priv_gst_registry_factory_index_unref (registry->priv->type_index);
+  if (registry->priv->media_type_index)
+    _priv_gst_registry_factory_index_unref (registry->priv->media_type_index);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -772,6 +822,359 @@ gst_registry_get_element_factory_list (GstRegistry * registry)
   return list;
 }
 
+static void
+gst_registry_factory_entry_free (GstRegistryFactoryEntry * entry)
+{
+  gst_object_unref (entry->factory);
+  g_slice_free (GstRegistryFactoryEntry, entry);
+}
+
+void
+_priv_gst_registry_factory_index_unref (GstRegistryFactoryIndex * index)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&index->refcount))
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (index->by_type); i++) {
+    if (index->by_type[i])
+      g_ptr_array_unref (index->by_type[i]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (index->by_media_type); i++) {
+    if (index->by_media_type[i])
+      g_hash_table_unref (index->by_media_type[i]);
+    if (index->any_media_type[i])
+      g_hash_table_unref (index->any_media_type[i]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (index->by_uri_protocol); i++) {
+    if (index->by_uri_protocol[i])
+      g_hash_table_unref (index->by_uri_protocol[i]);
+  }
+  g_hash_table_unref (index->factories);
+  g_slice_free (GstRegistryFactoryIndex, index);
+}
+
+static void
+gst_registry_factory_index_add_media_types (GstRegistryFactoryIndex * index,
+    GstElementFactory * factory)
+{
+  const GList *l;
+
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
+    GstPadDirection dir = templ->direction;
+    GstCaps *caps;
+    guint i, n;
+
+    if (dir >= G_N_ELEMENTS (index->by_media_type))
+      continue;
+
+    caps = gst_static_caps_get (&templ->static_caps);
+    if (caps == NULL)
+      continue;
+
+    if (gst_caps_is_any (caps)) {
+      if (index->any_media_type[dir] == NULL)
+        index->any_media_type[dir] = g_hash_table_new (NULL, NULL);
+      g_hash_table_add (index->any_media_type[dir], factory);
+    } else {
+      if (index->by_media_type[dir] == NULL)
+        index->by_media_type[dir] = g_hash_table_new_full (NULL, NULL, NULL,
+            (GDestroyNotify) g_hash_table_unref);
+
+      n = gst_caps_get_size (caps);
+      for (i = 0; i < n; i++) {
+        GQuark name = gst_structure_get_name_id (gst_caps_get_structure (caps,
+                i));
+        GHashTable *set;
+
+        set = g_hash_table_lookup (index->by_media_type[dir],
+            GUINT_TO_POINTER (name));
+        if (set == NULL) {
+          set = g_hash_table_new (NULL, NULL);
+          g_hash_table_insert (index->by_media_type[dir],
+              GUINT_TO_POINTER (name), set);
+        }
+        g_hash_table_add (set, factory);
+      }
+    }
+    gst_caps_unref (caps);
+  }
+}
+
+static guint
+gst_registry_uri_protocol_hash (gconstpointer key)
+{
+  const gchar *p = key;
+  guint h = 5381;
+
+  for (; *p; p++)
+    h = (h << 5) + h + g_ascii_tolower (*p);
+
+  return h;
+}
+
+static gboolean
+gst_registry_uri_protocol_equal (gconstpointer a, gconstpointer b)
+{
+  return g_ascii_strcasecmp (a, b) == 0;
+}
+
+static void
+gst_registry_factory_index_add_uri_protocols (GstRegistryFactoryIndex *
+    index, GstElementFactory * factory)
+{
+  const gchar *const *protocols;
+  GstURIType type;
+
+  type = gst_element_factory_get_uri_type (factory);
+  if (!GST_URI_TYPE_IS_VALID (type))
+    return;
+
+  protocols = gst_element_factory_get_uri_protocols (factory);
+  if (protocols == NULL) {
+    g_warning ("Factory '%s' implements GstUriHandler interface but returned "
+        "no supported protocols!", GST_OBJECT_NAME (factory));
+    return;
+  }
+
+  if (index->by_uri_protocol[type] == NULL)
+    index->by_uri_protocol[type] =
+        g_hash_table_new_full (gst_registry_uri_protocol_hash,
+        gst_registry_uri_protocol_equal, NULL,
+        (GDestroyNotify) g_ptr_array_unref);
+
+  for (; *protocols != NULL; protocols++) {
+    GPtrArray *factories;
+
+    factories = g_hash_table_lookup (index->by_uri_protocol[type], *protocols);
+    if (factories == NULL) {
+      factories = g_ptr_array_new ();
+      g_hash_table_insert (index->by_uri_protocol[type],
+          (gpointer) * protocols, factories);
+    } else if (factories->len > 0 &&
+        g_ptr_array_index (factories, factories->len - 1) == factory) {
+      /* the same protocol listed twice */
+      continue;
+    }
+    g_ptr_array_add (factories, factory);
+  }
+}
+
+/* Builds the factory type index, or the media type index if @media_types
+ * is %TRUE. Parsing the template caps is only done for the latter. */
+static GstRegistryFactoryIndex *
+gst_registry_factory_index_build (GstRegistry * registry, gboolean media_types)
+{
+  GstRegistryFactoryIndex *index;
+  GList *factories, *l;
+
+  index = g_slice_new0 (GstRegistryFactoryIndex);
+  index->refcount = 1;
+  index->factories = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) gst_registry_factory_entry_free);
+
+  GST_OBJECT_LOCK (registry);
+  gst_registry_get_feature_list_or_create (registry,
+      &registry->priv->element_factory_list, &registry->priv->efl_cookie,
+      GST_TYPE_ELEMENT_FACTORY);
+  factories = gst_plugin_feature_list_copy (registry->priv->element_factory_list);
+  index->cookie = registry->priv->cookie;
+  GST_OBJECT_UNLOCK (registry);
+
+  for (l = factories; l; l = l->next) {
+    GstElementFactory *factory = l->data;
+    GstRegistryFactoryEntry *entry;
+
+    entry = g_slice_new (GstRegistryFactoryEntry);
+    /* takes the reference of the list */
+    entry->factory = factory;
+    entry->type_mask = 0;
+    g_hash_table_insert (index->factories, factory, entry);
+
+    if (media_types) {
+      gst_registry_factory_index_add_media_types (index, factory);
+    } else {
+      guint i;
+
+      entry->type_mask = _priv_gst_element_factory_get_type_mask (factory);
+      gst_registry_factory_index_add_uri_protocols (index, factory);
+      for (i = 0; i < G_N_ELEMENTS (index->by_type); i++) {
+        if (!(entry->type_mask & (G_GUINT64_CONSTANT (1) << i)))
+          continue;
+        if (index->by_type[i] == NULL)
+          index->by_type[i] = g_ptr_array_new ();
+        g_ptr_array_add (index->by_type[i], entry);
+      }
+    }
+  }
+  g_list_free (factories);
+
+  GST_DEBUG_OBJECT (registry, "built %s index of %u element factories",
+      media_types ? "media type" : "factory type",
+      g_hash_table_size (index->factories));
+
+  return index;
+}
+
+static GstRegistryFactoryIndex *
+gst_registry_get_factory_index (GstRegistry * registry, gboolean media_types)
+{
+  GstRegistryFactoryIndex **cached, *index;
+
+  cached = media_types ? &registry->priv->media_type_index :
+      &registry->priv->type_index;
+
+  GST_OBJECT_LOCK (registry);
+  index = *cached;
+  if (index && index->cookie == registry->priv->cookie) {
+    g_atomic_int_inc (&index->refcount);
+    GST_OBJECT_UNLOCK (registry);
+    return index;
+  }
+  GST_OBJECT_UNLOCK (registry);
+
+  /* build without the lock, looking at the factories might load their
+   * details from the registry cache */
+  index = gst_registry_factory_index_build (registry, media_types);
+
+  GST_OBJECT_LOCK (registry);
+  if (index->cookie == registry->priv->cookie) {
+    if (*cached)
+      _priv_gst_registry_factory_index_unref (*cached);
+    g_atomic_int_inc (&index->refcount);
+    *cached = index;
+  }
+  GST_OBJECT_UNLOCK (registry);
+
+  return index;
+}
+
+/* Returns the element factories matching @type with at least @minrank, in
+ * no particular order. Only the index entries for the requested type bits
+ * are looked at. */
+GList *
+_priv_gst_registry_get_element_factories_by_type (GstRegistry * registry,
+    GstElementFactoryListType type, GstRank minrank)
+{
+  GstRegistryFactoryIndex *index;
+  GstElementFactoryListType bits;
+  GList *result = NULL;
+  guint i, j;
+
+  bits = type & (GST_ELEMENT_FACTORY_TYPE_MAX_ELEMENTS - 1);
+  if (bits == 0)
+    bits = type & ~(GST_ELEMENT_FACTORY_TYPE_MAX_ELEMENTS |
+        (GST_ELEMENT_FACTORY_TYPE_MAX_ELEMENTS - 1));
+  if (bits == 0)
+    return NULL;
+
+  index = gst_registry_get_factory_index (registry, FALSE);
+
+  for (i = 0; i < G_N_ELEMENTS (index->by_type); i++) {
+    GstElementFactoryListType bit = G_GUINT64_CONSTANT (1) << i;
+    GPtrArray *entries = index->by_type[i];
+
+    if (!(bits & bit) || entries == NULL)
+      continue;
+
+    for (j = 0; j < entries->len; j++) {
+      GstRegistryFactoryEntry *entry = g_ptr_array_index (entries, j);
+
+      /* already added for one of the previous bits */
+      if (entry->type_mask & bits & (bit - 1))
+        continue;
+
+      if (!_priv_gst_element_factory_type_mask_matches (entry->type_mask,
+              type))
+        continue;
+
+      if (gst_plugin_feature_get_rank (GST_PLUGIN_FEATURE_CAST
+              (entry->factory)) < minrank)
+        continue;
+
+      result = g_list_prepend (result, gst_object_ref (entry->factory));
+    }
+  }
+
+  _priv_gst_registry_factory_index_unref (index);
+
+  return result;
+}
+
+/* Returns the element factories of @type that handle the URI @protocol, in
+ * no particular order */
+GList *
+_priv_gst_registry_get_element_factories_by_uri_protocol (GstRegistry *
+    registry, GstURIType type, const gchar * protocol)
+{
+  GstRegistryFactoryIndex *index;
+  GPtrArray *factories = NULL;
+  GList *result = NULL;
+  guint i;
+
+  if (!GST_URI_TYPE_IS_VALID (type))
+    return NULL;
+
+  index = gst_registry_get_factory_index (registry, FALSE);
+
+  if (index->by_uri_protocol[type])
+    factories = g_hash_table_lookup (index->by_uri_protocol[type], protocol);
+
+  for (i = 0; factories && i < factories->len; i++)
+    result = g_list_prepend (result,
+        gst_object_ref (g_ptr_array_index (factories, i)));
+
+  _priv_gst_registry_factory_index_unref (index);
+
+  return result;
+}
+
+GstRegistryFactoryIndex *
+_priv_gst_registry_get_media_type_index (GstRegistry * registry)
+{
+  return gst_registry_get_factory_index (registry, TRUE);
+}
+
+/* Returns %FALSE if none of the templates of @factory in @direction can
+ * handle any of the media types of @caps. @caps must not be ANY or empty.
+ * Factories the index doesn't know are never excluded. */
+gboolean
+_priv_gst_registry_media_type_index_may_match (GstRegistryFactoryIndex *
+    index, GstElementFactory * factory, const GstCaps * caps,
+    GstPadDirection direction)
+{
+  guint i, n;
+
+  if (direction >= G_N_ELEMENTS (index->by_media_type))
+    return TRUE;
+
+  if (!g_hash_table_contains (index->factories, factory))
+    return TRUE;
+
+  if (index->any_media_type[direction] &&
+      g_hash_table_contains (index->any_media_type[direction], factory))
+    return TRUE;
+
+  if (index->by_media_type[direction] == NULL)
+    return FALSE;
+
+  n = gst_caps_get_size (caps);
+  for (i = 0; i < n; i++) {
+    GQuark name = gst_structure_get_name_id (gst_caps_get_structure (caps, i));
+    GHashTable *set;
+
+    set = g_hash_table_lookup (index->by_media_type[direction],
+        GUINT_TO_POINTER (name));
+    if (set && g_hash_table_contains (set, factory))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
 static GList *
 gst_registry_get_typefind_factory_list (GstRegistry * registry)
 {
@@ -1046,6 +1449,12 @@ gst_registry_lookup_bn_locked (GstRegistry * registry, const char *basename)
   return g_hash_table_lookup (registry->priv->basename_hash, basename);
 }
 
+GHashTable *
+_priv_gst_registry_get_dir_index (GstRegistry * registry)
+{
+  return registry->priv->dir_index;
+}
+
 static GstPlugin *
 gst_registry_lookup_bn (GstRegistry * registry, const char *basename)
 {
@@ -1104,11 +1513,16 @@ typedef struct
   GstRegistryScanHelperState helper_state;
   GstPluginLoader *helper;
   gboolean changed;
+  /* whether unchanged directories may be skipped */
+  gboolean use_dir_index;
+  /* the directory summaries taken by this scan */
+  GHashTable *dir_index;
 } GstRegistryScanContext;
 
 static void
 init_scan_context (GstRegistryScanContext * context, GstRegistry * registry)
 {
+  const gchar *dir_index_env;
   gboolean do_fork;
 
   context->registry = registry;
@@ -1132,6 +1546,11 @@ init_scan_context (GstRegistryScanContext * context, GstRegistry * registry)
 
   context->helper = NULL;
   context->changed = FALSE;
+
+  dir_index_env = g_getenv ("GST_REGISTRY_DIR_INDEX");
+  context->use_dir_index = dir_index_env && strcmp (dir_index_env, "no") != 0;
+  context->dir_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, g_free);
 }
 
 static void
@@ -1233,6 +1652,58 @@ is_blacklisted_directory (const gchar * dirent)
   return FALSE;
 }
 
+/* Marks the plugins from @path as registered without looking at the files
+ * if the last scan saw the directory in the same state. Returns %FALSE if
+ * the directory needs to be scanned file by file. */
+static gboolean
+gst_registry_check_dir_index (GstRegistryScanContext * context,
+    const gchar * path, const GstRegistryDirSummary * summary)
+{
+  GstRegistry *registry = context->registry;
+  GstRegistryDirSummary *cached;
+  GList *l, *plugins = NULL;
+  gboolean unchanged = TRUE;
+
+  cached = g_hash_table_lookup (registry->priv->dir_index, path);
+  if (cached == NULL || memcmp (cached, summary, sizeof (*summary)) != 0)
+    return FALSE;
+
+  GST_OBJECT_LOCK (registry);
+  for (l = registry->priv->plugins; l != NULL; l = l->next) {
+    GstPlugin *plugin = l->data;
+    gchar *filename;
+
+    if (plugin->filename == NULL || plugin->registered)
+      continue;
+
+    filename = g_build_filename (path, plugin->basename, NULL);
+    if (strcmp (filename, plugin->filename) == 0)
+      plugins = g_list_prepend (plugins, gst_object_ref (plugin));
+    g_free (filename);
+  }
+  GST_OBJECT_UNLOCK (registry);
+
+  for (l = plugins; l != NULL && unchanged; l = l->next) {
+    GstPlugin *plugin = l->data;
+
+    unchanged = !_priv_plugin_deps_env_vars_changed (plugin) &&
+        !_priv_plugin_deps_files_changed (plugin);
+  }
+
+  for (l = plugins; l != NULL && unchanged; l = l->next) {
+    GstPlugin *plugin = l->data;
+
+    GST_OBJECT_FLAG_UNSET (plugin, GST_PLUGIN_FLAG_CACHED);
+    plugin->registered = TRUE;
+  }
+  g_list_free_full (plugins, gst_object_unref);
+
+  GST_LOG_OBJECT (registry, "directory %s %s", path,
+      unchanged ? "unchanged, plugins cached" : "has changed dependencies");
+
+  return unchanged;
+}
+
 static gboolean
 gst_registry_scan_path_level (GstRegistryScanContext * context,
     const gchar * path, int level)
@@ -1242,11 +1713,37 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
   gchar *filename;
   GstPlugin *plugin;
   gboolean changed = FALSE;
+  GStatBuf dir_status;
+  GstRegistryDirSummary summary = { 0, };
+  gboolean indexable;
 
   dir = g_dir_open (path, 0, NULL);
   if (!dir)
     return FALSE;
 
+  /* Only directories that were seen completely, contain no subdirectories
+   * and whose modification time is in the past can be summarized, anything
+   * else is checked file by file every time */
+  indexable = g_stat (path, &dir_status) == 0 &&
+      dir_status.st_mtime < time (NULL);
+  if (indexable) {
+    summary.mtime = dir_status.st_mtime;
+    summary.inode = dir_status.st_ino;
+    while ((dirent = g_dir_read_name (dir))) {
+      summary.n_entries++;
+      summary.entries_hash += g_str_hash (dirent);
+    }
+    g_dir_rewind (dir);
+
+    if (context->use_dir_index &&
+        gst_registry_check_dir_index (context, path, &summary)) {
+      g_dir_close (dir);
+      g_hash_table_replace (context->dir_index, g_strdup (path),
+          g_memdup2 (&summary, sizeof (summary)));
+      return FALSE;
+    }
+  }
+
   while ((dirent = g_dir_read_name (dir))) {
     GStatBuf file_status;
 
@@ -1255,6 +1752,7 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
       /* Plugin will be removed from cache after the scan completes if it
        * is still marked 'cached' */
       g_free (filename);
+      indexable = FALSE;
       continue;
     }
 
@@ -1264,6 +1762,7 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
         g_free (filename);
         continue;
       }
+      indexable = FALSE;
       /* FIXME 2.0: Don't recurse into directories, this behaviour
        * is inconsistent with other PATH environment variables
        */
@@ -1322,6 +1821,7 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
             GST_STR_NULL (plugin->filename));
         g_free (filename);
         gst_object_unref (plugin);
+        indexable = FALSE;
         continue;
       }
 
@@ -1363,14 +1863,49 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
           file_status.st_size, file_status.st_mtime);
     }
 
+    /* a module that is shadowed by another path or failed to load must be
+     * looked at again next time */
+    if (indexable) {
+      plugin = gst_registry_lookup_bn (context->registry, dirent);
+      if (plugin == NULL || g_strcmp0 (plugin->filename, filename) != 0)
+        indexable = FALSE;
+      if (plugin)
+        gst_object_unref (plugin);
+    }
+
     g_free (filename);
   }
 
   g_dir_close (dir);
 
+  if (indexable) {
+    g_hash_table_replace (context->dir_index, g_strdup (path),
+        g_memdup2 (&summary, sizeof (summary)));
+  }
+
   return changed;
 }
 
+static gboolean
+dir_index_equal (GHashTable * a, GHashTable * b)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (g_hash_table_size (a) != g_hash_table_size (b))
+    return FALSE;
+
+  g_hash_table_iter_init (&iter, a);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    GstRegistryDirSummary *other = g_hash_table_lookup (b, key);
+
+    if (other == NULL || memcmp (value, other, sizeof (*other)) != 0)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
 static gboolean
 gst_registry_scan_path_internal (GstRegistryScanContext * context,
     const gchar * path)
@@ -1399,6 +1934,8 @@ gboolean
 gst_registry_scan_path (GstRegistry * registry, const gchar * path)
 {
   GstRegistryScanContext context;
+  GHashTableIter iter;
+  gpointer key, value;
   gboolean result;
 
   g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
@@ -1411,6 +1948,14 @@ gst_registry_scan_path (GstRegistry * registry, const gchar * path)
   clear_scan_context (&context);
   result |= context.changed;
 
+  /* only the scanned path was looked at, keep the other summaries */
+  g_hash_table_iter_init (&iter, context.dir_index);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    g_hash_table_iter_steal (&iter);
+    g_hash_table_replace (registry->priv->dir_index, key, value);
+  }
+  g_hash_table_unref (context.dir_index);
+
   return result;
 }
 
@@ -1516,6 +2061,88 @@ gst_registry_check_feature_version (GstRegistry * registry,
   return ret;
 }
 
+static void
+gst_registry_warm_feature (GstPluginFeature * feature)
+{
+  if (GST_IS_ELEMENT_FACTORY (feature)) {
+    GstElementFactory *factory = GST_ELEMENT_FACTORY_CAST (feature);
+    const GList *l;
+
+    /* features from the registry cache only get their class set up when
+     * the first element is created, which also creates the pad templates */
+    if (GST_ELEMENT_FACTORY_ENSURE_TYPE (factory) != G_TYPE_INVALID)
+      g_type_class_unref (g_type_class_ref (factory->type));
+
+    for (l = gst_element_factory_get_static_pad_templates (factory); l;
+        l = l->next) {
+      GstStaticPadTemplate *templ = l->data;
+
+      gst_caps_unref (gst_static_caps_get (&templ->static_caps));
+    }
+  } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
+    /* returns a borrowed reference */
+    gst_type_find_factory_get_caps (GST_TYPE_FIND_FACTORY (feature));
+  }
+}
+
+/**
+ * gst_registry_warm:
+ * @registry: a #GstRegistry
+ * @feature_names: (array zero-terminated=1): %NULL-terminated array of
+ *     feature names
+ *
+ * Loads the plugins providing the features named in @feature_names and does
+ * the setup that would otherwise happen when the features are first used:
+ * the element classes are initialized, which creates their pad templates,
+ * and the caps of their static pad templates and of typefinders are parsed.
+ *
+ * This is meant for applications that fork worker processes after
+ * gst_init(). Warming the features in the parent lets all children share the
+ * loaded plugins and these structures copy-on-write, instead of every child
+ * loading and allocating them again.
+ *
+ * Returns: %TRUE if all features were found and could be loaded.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_registry_warm (GstRegistry * registry, const gchar * const *feature_names)
+{
+  gboolean ret = TRUE;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
+  g_return_val_if_fail (feature_names != NULL, FALSE);
+
+  for (i = 0; feature_names[i] != NULL; i++) {
+    GstPluginFeature *feature, *loaded;
+
+    feature = gst_registry_lookup_feature (registry, feature_names[i]);
+    if (feature == NULL) {
+      GST_WARNING_OBJECT (registry, "Could not find plugin feature '%s'",
+          feature_names[i]);
+      ret = FALSE;
+      continue;
+    }
+
+    loaded = gst_plugin_feature_load (feature);
+    gst_object_unref (feature);
+    if (loaded == NULL) {
+      GST_WARNING_OBJECT (registry, "Could not load plugin feature '%s'",
+          feature_names[i]);
+      ret = FALSE;
+      continue;
+    }
+
+    GST_DEBUG_OBJECT (registry, "warming plugin feature '%s'",
+        feature_names[i]);
+    gst_registry_warm_feature (loaded);
+    gst_object_unref (loaded);
+  }
+
+  return ret;
+}
+
 static void
 load_plugin_func (gpointer data, gpointer user_data)
 {
@@ -1617,7 +2244,9 @@ scan_and_update_registry (GstRegistry * default_registry,
 
   /* It sounds tempting to just compare the mtime of directories with the mtime
    * of the registry cache, but it does not work. It would not catch updated
-   * plugins, which might bring more or less features.
+   * plugins, which might bring more or less features. Directories that look
+   * unchanged are therefore only skipped when GST_REGISTRY_DIR_INDEX asks for
+   * it, for setups where plugins are only ever replaced and not overwritten.
    */
 
   /* scan paths specified via --gst-plugin-path */
@@ -1706,6 +2335,13 @@ scan_and_update_registry (GstRegistry * default_registry,
   clear_scan_context (&context);
   changed |= context.changed;
 
+  /* Store the new directory summaries with the cache, if they're used */
+  if (context.use_dir_index &&
+      !dir_index_equal (context.dir_index, default_registry->priv->dir_index))
+    changed = TRUE;
+  g_hash_table_unref (default_registry->priv->dir_index);
+  default_registry->priv->dir_index = context.dir_index;
+
   /* Remove cached plugins so stale info is cleared. */
   changed |= gst_registry_remove_cache_plugins (default_registry);
 
@@ -124,6 +124,10 @@ gboolean                gst_registry_check_feature_version (GstRegistry *registr
                                                             guint        min_minor,
                                                             guint        min_micro);
 
+GST_API
+gboolean                gst_registry_warm               (GstRegistry *registry,
+                                                         const gchar * const *feature_names);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstRegistry, gst_object_unref)
 
 G_END_DECLS
@@ -23,9 +23,9 @@
  */
 
 /* FIXME:
- * - keep registry binary blob and reference strings
- *   - don't free/unmmap contents when leaving gst_registry_binary_read_cache()
- *     - free at gst_deinit() / _priv_gst_registry_cleanup() ?
+ * - reference strings in the registry binary blob
+ *   - the blob is kept mapped while element factories haven't read their
+ *     details from it, other features still copy everything on load
  *   - GstPlugin:
  *     - GST_PLUGIN_FLAG_CONST
  *   - GstPluginFeature, GstIndexFactory, GstElementFactory
@@ -557,6 +557,7 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
     const char *location)
 {
   GMappedFile *mapped = NULL;
+  GBytes *data = NULL;
   gchar *contents = NULL;
   gchar *in = NULL;
   gsize size;
@@ -598,10 +599,13 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
       g_error_free (err);
       return FALSE;
     }
+    data = g_bytes_new_take (contents, size);
   } else {
     /* This can't fail if g_mapped_file_new() succeeded */
     contents = g_mapped_file_get_contents (mapped);
     size = g_mapped_file_get_length (mapped);
+    data = g_bytes_new_with_free_func (contents, size,
+        (GDestroyNotify) g_mapped_file_unref, mapped);
   }
 
   /* in is a cursor pointer, we initialize it with the begin of registry and is updated on each read */
@@ -649,7 +653,8 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
       GST_DEBUG ("reading binary registry %" G_GSIZE_FORMAT "(%x)/%"
           G_GSIZE_FORMAT, (gsize) in - (gsize) contents,
           (guint) ((gsize) in - (gsize) contents), size);
-      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL)) {
+      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, data,
+              NULL)) {
         GST_ERROR ("Problem while reading binary registry %s", location);
         goto Error;
       }
@@ -666,16 +671,13 @@ done:
   GST_INFO ("loaded %s in %lf seconds", location, seconds);
 
   res = TRUE;
-  /* TODO: once we re-use the pointers to registry contents, return here */
 
 Error:
 #ifndef GST_DISABLE_GST_DEBUG
   g_timer_destroy (timer);
 #endif
-  if (mapped) {
-    g_mapped_file_unref (mapped);
-  } else {
-    g_free (contents);
-  }
+  /* element factories that didn't load their details yet keep the
+   * contents alive */
+  g_bytes_unref (data);
   return res;
 }
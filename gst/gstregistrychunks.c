@@ -43,6 +43,7 @@
 #include "glib-compat-private.h"
 
 #include <gst/gstregistrychunks.h>
+#include "gstbinarycodec.h"
 
 #define GST_CAT_DEFAULT GST_CAT_REGISTRY
 
@@ -108,6 +109,16 @@ _strnlen (const gchar * str, gint maxlen)
   inptr += _len + 1; \
 }G_STMT_END
 
+#define unpack_structure(inptr, outptr, endptr, error_label)  G_STMT_START{\
+  gsize _consumed; \
+  if (!_priv_gst_binary_deserialize_structure ((const guint8 *) inptr, \
+          endptr - inptr, &_consumed, &outptr)) { \
+    GST_ERROR ("Failed reading structure"); \
+    goto error_label; \
+  } \
+  inptr += _consumed; \
+}G_STMT_END
+
 #define ALIGNMENT            (sizeof (void *))
 #define alignment(_address)  (gsize)_address%ALIGNMENT
 #define align(_ptr)          _ptr += (( alignment(_ptr) == 0) ? 0 : ALIGNMENT-alignment(_ptr))
@@ -171,6 +182,36 @@ gst_registry_chunks_save_string (GList ** list, gchar * str)
   return TRUE;
 }
 
+/*
+ * gst_registry_chunks_save_structure:
+ *
+ * Store a structure, which may be %NULL, in a binary chunk.
+ *
+ * Returns: %TRUE for success
+ */
+static gboolean
+gst_registry_chunks_save_structure (GList ** list,
+    const GstStructure * structure)
+{
+  GstRegistryChunk *chunk;
+  GBytes *bytes;
+  gsize size;
+
+  bytes = _priv_gst_binary_serialize_structure (structure);
+  if (G_UNLIKELY (bytes == NULL)) {
+    GST_ERROR ("could not serialize structure %" GST_PTR_FORMAT, structure);
+    return FALSE;
+  }
+
+  chunk = g_slice_new (GstRegistryChunk);
+  chunk->data = g_bytes_unref_to_data (bytes, &size);
+  chunk->size = size;
+  chunk->flags = GST_REGISTRY_CHUNK_FLAG_MALLOC;
+  chunk->align = FALSE;
+  *list = g_list_prepend (*list, chunk);
+  return TRUE;
+}
+
 /*
  * gst_registry_chunks_save_data:
  *
@@ -247,6 +288,10 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
   if (GST_IS_ELEMENT_FACTORY (feature)) {
     GstRegistryChunkElementFactory *ef;
     GstElementFactory *factory = GST_ELEMENT_FACTORY (feature);
+    GList *details_end;
+    gsize pos;
+
+    GST_ELEMENT_FACTORY_ENSURE_DETAILS (factory);
 
     /* Initialize with zeroes because of struct padding and
      * valgrind complaining about copying uninitialized memory
@@ -256,6 +301,7 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     chk = gst_registry_chunks_make_data (ef, pf_size);
     ef->npadtemplates = ef->ninterfaces = ef->nuriprotocols = 0;
     pf = (GstRegistryChunkPluginFeature *) ef;
+    details_end = *list;
 
     /* save interfaces */
     for (walk = factory->interfaces; walk;
@@ -300,9 +346,21 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
       }
     }
 
-    /* pack element metadata strings */
-    gst_registry_chunks_save_string (list,
-        gst_structure_to_string (factory->metadata));
+    /* pack element metadata */
+    if (!gst_registry_chunks_save_structure (list, factory->metadata))
+      goto fail;
+
+    /* the size of all details as they will be written, the chunk of the
+     * factory itself is aligned so we know where padding will go */
+    pos = pf_size;
+    for (walk = *list; walk != details_end; walk = g_list_next (walk)) {
+      GstRegistryChunk *cur = walk->data;
+
+      if (cur->align && alignment (pos) != 0)
+        pos += ALIGNMENT - alignment (pos);
+      pos += cur->size;
+    }
+    ef->details_size = pos - pf_size;
   } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
     GstRegistryChunkTypeFindFactory *tff;
     GstTypeFindFactory *factory = GST_TYPE_FIND_FACTORY (feature);
@@ -315,8 +373,19 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     pf_size = sizeof (GstRegistryChunkTypeFindFactory);
     chk = gst_registry_chunks_make_data (tff, pf_size);
     tff->nextensions = 0;
+    tff->magic_size = factory->magic_size;
     pf = (GstRegistryChunkPluginFeature *) tff;
 
+    /* save magic bytes, they are loaded after the extensions */
+    if (factory->magic_size > 0) {
+      GstRegistryChunk *magic_chk;
+
+      magic_chk = gst_registry_chunks_make_data (g_slice_copy
+          (factory->magic_size, factory->magic), factory->magic_size);
+      magic_chk->align = FALSE;
+      *list = g_list_prepend (*list, magic_chk);
+    }
+
     /* save extensions */
     if (factory->extensions) {
       while (factory->extensions[tff->nextensions]) {
@@ -335,6 +404,9 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
       gst_caps_unref (fcaps);
 
       gst_registry_chunks_save_string (list, str);
+    } else if (factory->caps_string) {
+      /* still as loaded from the registry, no need to parse it */
+      gst_registry_chunks_save_const_string (list, factory->caps_string);
     } else {
       gst_registry_chunks_save_const_string (list, "");
     }
@@ -352,9 +424,9 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     pf = (GstRegistryChunkPluginFeature *) tff;
 
 
-    /* pack element metadata strings */
-    gst_registry_chunks_save_string (list,
-        gst_structure_to_string (factory->metadata));
+    /* pack element metadata */
+    if (!gst_registry_chunks_save_structure (list, factory->metadata))
+      goto fail;
   } else if (GST_IS_TRACER_FACTORY (feature)) {
     /* Initialize with zeroes because of struct padding and
      * valgrind complaining about copying uninitialized memory
@@ -474,11 +546,9 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
   gst_plugin_feature_list_free (plugin_features);
 
   /* pack cache data */
-  if (plugin->priv->cache_data) {
-    gchar *cache_str = gst_structure_to_string (plugin->priv->cache_data);
-    gst_registry_chunks_save_string (list, cache_str);
-  } else {
-    gst_registry_chunks_save_const_string (list, "");
+  if (!gst_registry_chunks_save_structure (list, plugin->priv->cache_data)) {
+    GST_WARNING ("Plugin %s cache data can't be stored", plugin->desc.name);
+    gst_registry_chunks_save_structure (list, NULL);
   }
 
   /* pack plugin element strings */
@@ -530,7 +600,7 @@ gst_registry_chunks_load_pad_template (GstElementFactory * factory, gchar ** in,
   template = g_slice_new (GstStaticPadTemplate);
   template->presence = pt->presence;
   template->direction = (GstPadDirection) pt->direction;
-  template->static_caps.caps = NULL;
+  _priv_gst_static_caps_init (&template->static_caps, NULL);
 
   /* unpack pad template strings */
   unpack_const_string (*in, template->name_template, end, fail);
@@ -547,6 +617,144 @@ fail:
   return FALSE;
 }
 
+/*
+ * gst_registry_chunks_load_element_factory_details:
+ *
+ * Read the metadata, pad templates, uri types and interfaces that follow
+ * @ef into @factory.
+ *
+ * Returns: %TRUE for success
+ */
+static gboolean
+gst_registry_chunks_load_element_factory_details (GstElementFactory * factory,
+    const GstRegistryChunkElementFactory * ef, gchar ** in, gchar * end)
+{
+  const gchar *const_str;
+  gchar *str;
+  guint i, n;
+
+  /* unpack element factory metadata */
+  unpack_structure (*in, factory->metadata, end, fail);
+  n = ef->npadtemplates;
+  GST_DEBUG ("Element factory : npadtemplates=%d", n);
+
+  /* load pad templates */
+  for (i = 0; i < n; i++) {
+    if (G_UNLIKELY (!gst_registry_chunks_load_pad_template (factory, in,
+                end))) {
+      GST_ERROR ("Error while loading binary pad template");
+      goto fail;
+    }
+  }
+
+  /* load uritypes */
+  if (G_UNLIKELY ((n = ef->nuriprotocols))) {
+    GST_DEBUG ("Reading %d UriTypes at address %p", n, *in);
+
+    align (*in);
+    factory->uri_type = *((guint *) * in);
+    *in += sizeof (factory->uri_type);
+    /*unpack_element(*in, &factory->uri_type, factory->uri_type, end, fail); */
+
+    factory->uri_protocols = g_new0 (gchar *, n + 1);
+    for (i = 0; i < n; i++) {
+      unpack_string (*in, str, end, fail);
+      factory->uri_protocols[i] = str;
+    }
+  }
+  /* load interfaces */
+  if (G_UNLIKELY ((n = ef->ninterfaces))) {
+    GST_DEBUG ("Reading %d Interfaces at address %p", n, *in);
+    for (i = 0; i < n; i++) {
+      unpack_string_nocopy (*in, const_str, end, fail);
+      __gst_element_factory_add_interface (factory, const_str);
+    }
+  }
+
+  return TRUE;
+
+fail:
+  GST_INFO ("Reading element factory details failed");
+  return FALSE;
+}
+
+/* Element factory details that are still in the registry cache. Only the
+ * offset into the cache is stored, the cache itself is kept alive by @data
+ * until all factories read their details or were reloaded. */
+typedef struct
+{
+  GBytes *data;
+  gsize offset;
+  GstRegistryChunkElementFactory ef;
+} GstRegistryLazyDetails;
+
+/* serializes loading the details on first use from different threads */
+static GMutex lazy_details_lock;
+
+static void
+gst_registry_chunks_set_lazy_details (GstElementFactory * factory,
+    const GstRegistryChunkElementFactory * ef, const gchar * details,
+    GBytes * data)
+{
+  GstRegistryLazyDetails *lazy;
+
+  lazy = g_slice_new (GstRegistryLazyDetails);
+  lazy->data = g_bytes_ref (data);
+  lazy->offset = details - (const gchar *) g_bytes_get_data (data, NULL);
+  lazy->ef = *ef;
+
+  g_atomic_pointer_set (&factory->lazy_details, lazy);
+}
+
+static void
+gst_registry_lazy_details_free (GstRegistryLazyDetails * lazy)
+{
+  g_bytes_unref (lazy->data);
+  g_slice_free (GstRegistryLazyDetails, lazy);
+}
+
+void
+_priv_gst_registry_chunks_load_element_factory_details (GstElementFactory *
+    factory)
+{
+  GstRegistryLazyDetails *lazy;
+
+  g_mutex_lock (&lazy_details_lock);
+  lazy = factory->lazy_details;
+  if (lazy) {
+    gchar *in, *end;
+
+    in = (gchar *) g_bytes_get_data (lazy->data, NULL) + lazy->offset;
+    end = in + lazy->ef.details_size;
+
+    GST_LOG_OBJECT (factory, "loading details from the registry cache");
+    if (!gst_registry_chunks_load_element_factory_details (factory,
+            &lazy->ef, &in, end))
+      GST_ERROR_OBJECT (factory, "Could not load details from the registry");
+
+    /* only clear it after everything is loaded, the check in
+     * GST_ELEMENT_FACTORY_ENSURE_DETAILS() doesn't take the lock */
+    g_atomic_pointer_set (&factory->lazy_details, NULL);
+    gst_registry_lazy_details_free (lazy);
+  }
+  g_mutex_unlock (&lazy_details_lock);
+}
+
+void
+_priv_gst_registry_chunks_clear_element_factory_details (GstElementFactory *
+    factory)
+{
+  GstRegistryLazyDetails *lazy;
+
+  g_mutex_lock (&lazy_details_lock);
+  lazy = factory->lazy_details;
+  g_atomic_pointer_set (&factory->lazy_details, NULL);
+  g_mutex_unlock (&lazy_details_lock);
+
+  if (lazy)
+    gst_registry_lazy_details_free (lazy);
+}
+
 /*
  * gst_registry_chunks_load_feature:
  *
@@ -556,7 +764,7 @@ fail:
  */
 static gboolean
 gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin * plugin)
+    gchar * end, GBytes * data, GstPlugin * plugin)
 {
   GstRegistryChunkPluginFeature *pf = NULL;
   GstPluginFeature *feature = NULL;
@@ -601,10 +809,7 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
 
   if (GST_IS_ELEMENT_FACTORY (feature)) {
     GstRegistryChunkElementFactory *ef;
-    guint n;
     GstElementFactory *factory = GST_ELEMENT_FACTORY_CAST (feature);
-    gchar *str;
-    const gchar *meta_data_str;
 
     align (*in);
     GST_LOG ("Reading/casting for GstRegistryChunkElementFactory at address %p",
@@ -612,51 +817,18 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
     unpack_element (*in, ef, GstRegistryChunkElementFactory, end, fail);
     pf = (GstRegistryChunkPluginFeature *) ef;
 
-    /* unpack element factory strings */
-    unpack_string_nocopy (*in, meta_data_str, end, fail);
-    if (meta_data_str && *meta_data_str) {
-      factory->metadata = gst_structure_from_string (meta_data_str, NULL);
-      if (!factory->metadata) {
-        GST_ERROR
-            ("Error when trying to deserialize structure for metadata '%s'",
-            meta_data_str);
+    if (data) {
+      /* skip the details, they are read when they are first needed */
+      if (G_UNLIKELY (ef->details_size > (gsize) (end - *in))) {
+        GST_ERROR ("Failed reading %u bytes of element factory details",
+            ef->details_size);
         goto fail;
       }
-    }
-    n = ef->npadtemplates;
-    GST_DEBUG ("Element factory : npadtemplates=%d", n);
-
-    /* load pad templates */
-    for (i = 0; i < n; i++) {
-      if (G_UNLIKELY (!gst_registry_chunks_load_pad_template (factory, in,
-                  end))) {
-        GST_ERROR ("Error while loading binary pad template");
-        goto fail;
-      }
-    }
-
-    /* load uritypes */
-    if (G_UNLIKELY ((n = ef->nuriprotocols))) {
-      GST_DEBUG ("Reading %d UriTypes at address %p", n, *in);
-
-      align (*in);
-      factory->uri_type = *((guint *) * in);
-      *in += sizeof (factory->uri_type);
-      /*unpack_element(*in, &factory->uri_type, factory->uri_type, end, fail); */
-
-      factory->uri_protocols = g_new0 (gchar *, n + 1);
-      for (i = 0; i < n; i++) {
-        unpack_string (*in, str, end, fail);
-        factory->uri_protocols[i] = str;
-      }
-    }
-    /* load interfaces */
-    if (G_UNLIKELY ((n = ef->ninterfaces))) {
-      GST_DEBUG ("Reading %d Interfaces at address %p", n, *in);
-      for (i = 0; i < n; i++) {
-        unpack_string_nocopy (*in, const_str, end, fail);
-        __gst_element_factory_add_interface (factory, const_str);
-      }
+      gst_registry_chunks_set_lazy_details (factory, ef, *in, data);
+      *in += ef->details_size;
+    } else if (G_UNLIKELY (!gst_registry_chunks_load_element_factory_details
+            (factory, ef, in, end))) {
+      goto fail;
     }
   } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
     GstRegistryChunkTypeFindFactory *tff;
@@ -669,12 +841,13 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
     unpack_element (*in, tff, GstRegistryChunkTypeFindFactory, end, fail);
     pf = (GstRegistryChunkPluginFeature *) tff;
 
-    /* load typefinder caps */
+    /* load typefinder caps, they are parsed when they are first used */
     unpack_string_nocopy (*in, const_str, end, fail);
+    factory->caps = NULL;
     if (const_str != NULL && *const_str != '\0')
-      factory->caps = gst_caps_from_string (const_str);
+      factory->caps_string = g_intern_string (const_str);
     else
-      factory->caps = NULL;
+      factory->caps_string = NULL;
 
     /* load extensions */
     if (tff->nextensions) {
@@ -687,10 +860,20 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
         factory->extensions[i - 1] = str;
       }
     }
+
+    /* load magic bytes */
+    if (tff->magic_size) {
+      if (*in + tff->magic_size > end) {
+        GST_ERROR ("Failed reading %u typefind magic bytes", tff->magic_size);
+        goto fail;
+      }
+      factory->magic = g_memdup2 (*in, tff->magic_size);
+      factory->magic_size = tff->magic_size;
+      *in += tff->magic_size;
+    }
   } else if (GST_IS_DEVICE_PROVIDER_FACTORY (feature)) {
     GstRegistryChunkDeviceProviderFactory *dmf;
     GstDeviceProviderFactory *factory = GST_DEVICE_PROVIDER_FACTORY (feature);
-    const gchar *meta_data_str;
 
     align (*in);
     GST_DEBUG
@@ -701,17 +884,8 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
 
     pf = (GstRegistryChunkPluginFeature *) dmf;
 
-    /* unpack element factory strings */
-    unpack_string_nocopy (*in, meta_data_str, end, fail);
-    if (meta_data_str && *meta_data_str) {
-      factory->metadata = gst_structure_from_string (meta_data_str, NULL);
-      if (!factory->metadata) {
-        GST_ERROR
-            ("Error when trying to deserialize structure for metadata '%s'",
-            meta_data_str);
-        goto fail;
-      }
-    }
+    /* unpack element factory metadata */
+    unpack_structure (*in, factory->metadata, end, fail);
   } else if (GST_IS_TRACER_FACTORY (feature)) {
     align (*in);
     GST_DEBUG
@@ -820,16 +994,18 @@ fail:
  * Make a new GstPlugin from current GstRegistryChunkPluginElement structure
  * and add it to the GstRegistry. Return an offset to the next
  * GstRegistryChunkPluginElement structure.
+ *
+ * When @data is not %NULL it has to contain the chunks, element factories
+ * then keep a reference to it and only read their details on first use.
  */
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin ** out_plugin)
+    gchar * end, GBytes * data, GstPlugin ** out_plugin)
 {
 #ifndef GST_DISABLE_GST_DEBUG
   gchar *start = *in;
 #endif
   GstRegistryChunkPluginElement *pe;
-  const gchar *cache_str = NULL;
   GstPlugin *plugin = NULL;
   guint i, n;
 
@@ -870,9 +1046,7 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
     plugin->desc.release_datetime = NULL;
 
   /* unpack cache data */
-  unpack_string_nocopy (*in, cache_str, end, fail);
-  if (cache_str != NULL && *cache_str != '\0')
-    plugin->priv->cache_data = gst_structure_from_string (cache_str, NULL);
+  unpack_structure (*in, plugin->priv->cache_data, end, fail);
 
   /* If the license string is 'BLACKLIST', mark this as a blacklisted
    * plugin */
@@ -890,7 +1064,7 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   /* Load plugin features */
   for (i = 0; i < n; i++) {
     if (G_UNLIKELY (!gst_registry_chunks_load_feature (registry, in, end,
-                plugin))) {
+                data, plugin))) {
       GST_ERROR ("Error while loading binary feature for plugin '%s'",
           GST_STR_NULL (plugin->desc.name));
       gst_registry_remove_plugin (registry, plugin);
@@ -925,16 +1099,38 @@ _priv_gst_registry_chunks_save_global_header (GList ** list,
 {
   GstRegistryChunkGlobalHeader *hdr;
   GstRegistryChunk *chk;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  /* the list is written in reverse, so the directories go first to end up
+   * between the header and the plugins */
+  g_hash_table_iter_init (&iter, _priv_gst_registry_get_dir_index (registry));
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    const GstRegistryDirSummary *summary = value;
+    GstRegistryChunkDirIndex *di;
+
+    gst_registry_chunks_save_string (list, g_strdup (key));
+
+    di = g_slice_new (GstRegistryChunkDirIndex);
+    chk = gst_registry_chunks_make_data (di, sizeof (GstRegistryChunkDirIndex));
+    di->mtime = summary->mtime;
+    di->inode = summary->inode;
+    di->n_entries = summary->n_entries;
+    di->entries_hash = summary->entries_hash;
+    *list = g_list_prepend (*list, chk);
+  }
 
   hdr = g_slice_new (GstRegistryChunkGlobalHeader);
   chk = gst_registry_chunks_make_data (hdr,
       sizeof (GstRegistryChunkGlobalHeader));
 
   hdr->filter_env_hash = filter_env_hash;
+  hdr->n_dirs = g_hash_table_size (_priv_gst_registry_get_dir_index (registry));
 
   *list = g_list_prepend (*list, chk);
 
-  GST_LOG ("Saved global header (filter_env_hash=0x%08x)", filter_env_hash);
+  GST_LOG ("Saved global header (filter_env_hash=0x%08x, %u directories)",
+      filter_env_hash, hdr->n_dirs);
 }
 
 gboolean
@@ -942,11 +1138,32 @@ _priv_gst_registry_chunks_load_global_header (GstRegistry * registry,
     gchar ** in, gchar * end, guint32 * filter_env_hash)
 {
   GstRegistryChunkGlobalHeader *hdr;
+  GHashTable *dir_index;
+  guint i;
 
   align (*in);
   GST_LOG ("Reading/casting for GstRegistryChunkGlobalHeader at %p", *in);
   unpack_element (*in, hdr, GstRegistryChunkGlobalHeader, end, fail);
   *filter_env_hash = hdr->filter_env_hash;
+
+  dir_index = _priv_gst_registry_get_dir_index (registry);
+  for (i = 0; i < hdr->n_dirs; i++) {
+    GstRegistryChunkDirIndex *di;
+    GstRegistryDirSummary *summary;
+    const gchar *path;
+
+    align (*in);
+    unpack_element (*in, di, GstRegistryChunkDirIndex, end, fail);
+    unpack_string_nocopy (*in, path, end, fail);
+
+    summary = g_new (GstRegistryDirSummary, 1);
+    summary->mtime = di->mtime;
+    summary->inode = di->inode;
+    summary->n_entries = di->n_entries;
+    summary->entries_hash = di->entries_hash;
+    g_hash_table_replace (dir_index, g_strdup (path), summary);
+  }
+
   return TRUE;
 
   /* Errors */
@@ -50,11 +50,32 @@ typedef struct _GstRegistryChunk
   gboolean align;
 } GstRegistryChunk;
 
+/*
+ * GstRegistryChunkGlobalHeader:
+ *
+ * @n_dirs: says how many GstRegistryChunkDirIndex structures follow the
+ * header, before the first plugin.
+ */
 typedef struct _GstRegistryChunkGlobalHeader
 {
   guint32  filter_env_hash;
+  guint32  n_dirs;
 } GstRegistryChunkGlobalHeader;
 
+/*
+ * GstRegistryChunkDirIndex:
+ *
+ * The summary of a scanned plugin directory, followed by the path of
+ * the directory.
+ */
+typedef struct _GstRegistryChunkDirIndex
+{
+  gint64  mtime;
+  guint64 inode;
+  guint32 n_entries;
+  guint32 entries_hash;
+} GstRegistryChunkDirIndex;
+
 /*
  * GstRegistryChunkPluginElement:
  *
@@ -106,6 +127,8 @@ typedef struct _GstRegistryChunkPluginFeature
  * following the structure
  * @ninterfaces: stores the number of interface names following the structure
  * @nuriprotocols: stores the number of protocol strings following the structure
+ * @details_size: size in bytes of the metadata, pad templates, uri types and
+ * interfaces following the structure
  *
  * A structure containing the element factory fields
  */
@@ -116,11 +139,13 @@ typedef struct _GstRegistryChunkElementFactory
   guint npadtemplates;
   guint ninterfaces;
   guint nuriprotocols;
+  guint details_size;
 } GstRegistryChunkElementFactory;
 
 /*
  * GstRegistryChunkTypeFindFactory:
  * @nextensions: stores the number of typefind extensions
+ * @magic_size: stores the number of magic bytes
  *
  * A structure containing the type find factory fields
  */
@@ -129,6 +154,7 @@ typedef struct _GstRegistryChunkTypeFindFactory
   GstRegistryChunkPluginFeature plugin_feature;
 
   guint nextensions;
+  guint magic_size;
 } GstRegistryChunkTypeFindFactory;
 
 /*
@@ -173,7 +199,7 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
 
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar *end, GstPlugin **out_plugin);
+    gchar *end, GBytes * data, GstPlugin **out_plugin);
 
 void
 _priv_gst_registry_chunks_save_global_header (GList ** list,
@@ -0,0 +1,68 @@
+/* GStreamer
+ *
+ * gstsdt-private.h: static tracepoints for the hot paths
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_SDT_PRIVATE_H__
+#define __GST_SDT_PRIVATE_H__
+
+/* Statically defined tracepoints in the "gstreamer" provider, enabled with
+ * the usdt meson option when <sys/sdt.h> is available. An unattached probe
+ * is a single nop plus the note describing where its arguments live, so
+ * only cheap arguments (pointers, already computed values) should be passed.
+ * They can be listed with `perf list sdt_gstreamer:*` after
+ * `perf buildid-cache --add libgstreamer-1.0.so` or used directly with
+ * bpftrace, e.g. `usdt:libgstreamer-1.0.so:gstreamer:pad_push`. The
+ * base_sink probes live in libgstbase and the queue probes in the
+ * coreelements plugin.
+ *
+ * The probes are:
+ *
+ *  pad_push (pad, buffer)                  pad_push_done (pad, ret)
+ *  pad_chain (pad, buffer)                 pad_chain_done (pad, ret)
+ *  pad_chain_list (pad, list)              pad_chain_list_done (pad, ret)
+ *  pad_push_event (pad, event, type)       pad_push_event_done (pad, res)
+ *  pad_query (pad, query, type)            pad_query_done (pad, query, res)
+ *  buffer_pool_acquire (pool, buffer)      buffer_pool_release (pool, buffer)
+ *  clock_wait (clock, id, time)            clock_wait_done (clock, id, ret)
+ *  base_sink_render (sink, obj)            base_sink_qos_drop (sink, obj,
+ *                                                              jitter)
+ *  queue_enqueue (queue, item, buffers, bytes, time)
+ *  queue_dequeue (queue, item, buffers, bytes, time)
+ */
+
+#ifdef HAVE_SYS_SDT_H
+
+#include <sys/sdt.h>
+
+#define GST_SDT_PROBE2(name, a1, a2) \
+    DTRACE_PROBE2 (gstreamer, name, a1, a2)
+#define GST_SDT_PROBE3(name, a1, a2, a3) \
+    DTRACE_PROBE3 (gstreamer, name, a1, a2, a3)
+#define GST_SDT_PROBE5(name, a1, a2, a3, a4, a5) \
+    DTRACE_PROBE5 (gstreamer, name, a1, a2, a3, a4, a5)
+
+#else /* !HAVE_SYS_SDT_H */
+
+#define GST_SDT_PROBE2(name, a1, a2) G_STMT_START { } G_STMT_END
+#define GST_SDT_PROBE3(name, a1, a2, a3) G_STMT_START { } G_STMT_END
+#define GST_SDT_PROBE5(name, a1, a2, a3, a4, a5) G_STMT_START { } G_STMT_END
+
+#endif /* HAVE_SYS_SDT_H */
+
+#endif /* __GST_SDT_PRIVATE_H__ */
@@ -387,50 +387,16 @@ gst_segment_do_seek (GstSegment * segment, gdouble rate,
   return TRUE;
 }
 
-/**
- * gst_segment_to_stream_time_full:
- * @segment: a #GstSegment structure.
- * @format: the format of the segment.
- * @position: the position in the segment
- * @stream_time: (out): result stream-time
- *
- * Translate @position to the total stream time using the currently configured
- * segment. Compared to gst_segment_to_stream_time() this function can return
- * negative stream-time.
- *
- * This function is typically used by elements that need to synchronize buffers
- * against the clock or each other.
- *
- * @position can be any value and the result of this function for values outside
- * of the segment is extrapolated.
- *
- * When 1 is returned, @position resulted in a positive stream-time returned
- * in @stream_time.
- *
- * When this function returns -1, the returned @stream_time should be negated
- * to get the real negative stream time.
- *
- * Returns: a 1 or -1 on success, 0 on failure.
- *
- * Since: 1.8
- */
-gint
-gst_segment_to_stream_time_full (const GstSegment * segment, GstFormat format,
-    guint64 position, guint64 * stream_time)
+/* the part of gst_segment_to_stream_time_full() after the arguments were
+ * checked, shared with gst_segment_to_stream_time() */
+static inline gint
+segment_to_stream_time_full (const GstSegment * segment, guint64 position,
+    guint64 * stream_time)
 {
   guint64 start, stop, time;
   gdouble abs_applied_rate;
   gint res;
 
-  /* format does not matter for -1 */
-  if (G_UNLIKELY (position == -1)) {
-    *stream_time = -1;
-    return 0;
-  }
-
-  g_return_val_if_fail (segment != NULL, 0);
-  g_return_val_if_fail (segment->format == format, 0);
-
   stop = segment->stop;
 
   start = segment->start;
@@ -495,6 +461,49 @@ gst_segment_to_stream_time_full (const GstSegment * segment, GstFormat format,
   return res;
 }
 
+/**
+ * gst_segment_to_stream_time_full:
+ * @segment: a #GstSegment structure.
+ * @format: the format of the segment.
+ * @position: the position in the segment
+ * @stream_time: (out): result stream-time
+ *
+ * Translate @position to the total stream time using the currently configured
+ * segment. Compared to gst_segment_to_stream_time() this function can return
+ * negative stream-time.
+ *
+ * This function is typically used by elements that need to synchronize buffers
+ * against the clock or each other.
+ *
+ * @position can be any value and the result of this function for values outside
+ * of the segment is extrapolated.
+ *
+ * When 1 is returned, @position resulted in a positive stream-time returned
+ * in @stream_time.
+ *
+ * When this function returns -1, the returned @stream_time should be negated
+ * to get the real negative stream time.
+ *
+ * Returns: a 1 or -1 on success, 0 on failure.
+ *
+ * Since: 1.8
+ */
+gint
+gst_segment_to_stream_time_full (const GstSegment * segment, GstFormat format,
+    guint64 position, guint64 * stream_time)
+{
+  /* format does not matter for -1 */
+  if (G_UNLIKELY (position == -1)) {
+    *stream_time = -1;
+    return 0;
+  }
+
+  g_return_val_if_fail (segment != NULL, 0);
+  g_return_val_if_fail (segment->format == format, 0);
+
+  return segment_to_stream_time_full (segment, position, stream_time);
+}
+
 /**
  * gst_segment_to_stream_time:
  * @segment: a #GstSegment structure.
@@ -539,7 +548,10 @@ gst_segment_to_stream_time (const GstSegment * segment, GstFormat format,
     return -1;
   }
 
-  if (gst_segment_to_stream_time_full (segment, format, position, &result) == 1)
+  if (G_UNLIKELY (position == -1))
+    return -1;
+
+  if (segment_to_stream_time_full (segment, position, &result) == 1)
     return result;
 
   return -1;
@@ -704,51 +716,30 @@ gst_segment_position_from_stream_time (const GstSegment * segment,
   return -1;
 }
 
-/**
- * gst_segment_to_running_time_full:
- * @segment: a #GstSegment structure.
- * @format: the format of the segment.
- * @position: the position in the segment
- * @running_time: (out) (allow-none): result running-time
- *
- * Translate @position to the total running time using the currently configured
- * segment. Compared to gst_segment_to_running_time() this function can return
- * negative running-time.
- *
- * This function is typically used by elements that need to synchronize buffers
- * against the clock or each other.
- *
- * @position can be any value and the result of this function for values outside
- * of the segment is extrapolated.
- *
- * When 1 is returned, @position resulted in a positive running-time returned
- * in @running_time.
- *
- * When this function returns -1, the returned @running_time should be negated
- * to get the real negative running time.
- *
- * Returns: a 1 or -1 on success, 0 on failure.
- *
- * Since: 1.6
- */
-gint
-gst_segment_to_running_time_full (const GstSegment * segment, GstFormat format,
-    guint64 position, guint64 * running_time)
+/* the part of gst_segment_to_running_time_full() after the arguments were
+ * checked, shared with gst_segment_to_running_time() */
+static inline gint
+segment_to_running_time_full (const GstSegment * segment, guint64 position,
+    guint64 * running_time)
 {
   gint res = 0;
   guint64 result;
   guint64 start, stop, offset;
   gdouble abs_rate;
 
-  if (G_UNLIKELY (position == -1)) {
-    GST_DEBUG ("invalid position (-1)");
-    goto done;
-  }
+  offset = segment->offset;
 
-  g_return_val_if_fail (segment != NULL, 0);
-  g_return_val_if_fail (segment->format == format, 0);
+  /* the common case of a forward segment at normal rate, without any floating
+   * point math */
+  if (G_LIKELY (segment->rate == 1.0)) {
+    start = segment->start + offset;
 
-  offset = segment->offset;
+    if (G_LIKELY (position >= start)) {
+      if (running_time)
+        *running_time = position - start + segment->base;
+      return 1;
+    }
+  }
 
   if (G_LIKELY (segment->rate > 0.0)) {
     start = segment->start + offset;
@@ -808,13 +799,50 @@ gst_segment_to_running_time_full (const GstSegment * segment, GstFormat format,
     }
   }
   return res;
+}
 
-done:
-  {
+/**
+ * gst_segment_to_running_time_full:
+ * @segment: a #GstSegment structure.
+ * @format: the format of the segment.
+ * @position: the position in the segment
+ * @running_time: (out) (allow-none): result running-time
+ *
+ * Translate @position to the total running time using the currently configured
+ * segment. Compared to gst_segment_to_running_time() this function can return
+ * negative running-time.
+ *
+ * This function is typically used by elements that need to synchronize buffers
+ * against the clock or each other.
+ *
+ * @position can be any value and the result of this function for values outside
+ * of the segment is extrapolated.
+ *
+ * When 1 is returned, @position resulted in a positive running-time returned
+ * in @running_time.
+ *
+ * When this function returns -1, the returned @running_time should be negated
+ * to get the real negative running time.
+ *
+ * Returns: a 1 or -1 on success, 0 on failure.
+ *
+ * Since: 1.6
+ */
+gint
+gst_segment_to_running_time_full (const GstSegment * segment, GstFormat format,
+    guint64 position, guint64 * running_time)
+{
+  if (G_UNLIKELY (position == -1)) {
+    GST_DEBUG ("invalid position (-1)");
     if (running_time)
       *running_time = -1;
     return 0;
   }
+
+  g_return_val_if_fail (segment != NULL, 0);
+  g_return_val_if_fail (segment->format == format, 0);
+
+  return segment_to_running_time_full (segment, position, running_time);
 }
 
 /**
@@ -858,8 +886,10 @@ gst_segment_to_running_time (const GstSegment * segment, GstFormat format,
     return -1;
   }
 
-  if (gst_segment_to_running_time_full (segment, format, position,
-          &result) == 1)
+  if (G_UNLIKELY (position == -1))
+    return -1;
+
+  if (segment_to_running_time_full (segment, position, &result) == 1)
     return result;
 
   return -1;
@@ -934,6 +964,91 @@ gst_segment_clip (const GstSegment * segment, GstFormat format, guint64 start,
   return TRUE;
 }
 
+/* the part of gst_segment_position_from_running_time_full() after the
+ * arguments were checked, shared with gst_segment_position_from_running_time() */
+static inline gint
+segment_position_from_running_time_full (const GstSegment * segment,
+    guint64 running_time, guint64 * position)
+{
+  gint res;
+  guint64 start, stop, base;
+  gdouble abs_rate;
+
+  base = segment->base;
+
+  /* the common case of a forward segment at normal rate */
+  if (G_LIKELY (segment->rate == 1.0 && running_time >= base)) {
+    *position = running_time - base + segment->start + segment->offset;
+    return 1;
+  }
+
+  abs_rate = ABS (segment->rate);
+
+  start = segment->start;
+  stop = segment->stop;
+
+  if (G_LIKELY (segment->rate > 0.0)) {
+    /* start by subtracting the base time */
+    if (G_LIKELY (running_time >= base)) {
+      *position = running_time - base;
+      /* move into the segment at the right rate */
+      if (G_UNLIKELY (abs_rate != 1.0))
+        *position = ceil (*position * abs_rate);
+      /* bring to corrected position in segment */
+      *position += start + segment->offset;
+      res = 1;
+    } else {
+      *position = base - running_time;
+      if (G_UNLIKELY (abs_rate != 1.0))
+        *position = ceil (*position * abs_rate);
+      if (start + segment->offset >= *position) {
+        /* The TS is before the segment, but the result is >= 0 */
+        *position = start + segment->offset - *position;
+        res = 1;
+      } else {
+        /* The TS is before the segment, and the result is < 0
+         * so negate the return result */
+        *position = *position - (start + segment->offset);
+        res = -1;
+      }
+    }
+  } else {
+    if (G_LIKELY (running_time >= base)) {
+      *position = running_time - base;
+      if (G_UNLIKELY (abs_rate != 1.0))
+        *position = ceil (*position * abs_rate);
+      if (G_UNLIKELY (stop < *position + segment->offset)) {
+        *position += segment->offset - stop;
+        res = -1;
+      } else {
+        *position = stop - *position - segment->offset;
+        res = 1;
+      }
+    } else {
+      /* This case is tricky. Requested running time precedes the
+       * segment base, so in a reversed segment where rate < 0, that
+       * means it's before the alignment point of (stop - offset).
+       * Before = always bigger than (stop-offset), which is usually +ve,
+       * but could be -ve is offset is big enough. -ve position implies
+       * that the offset has clipped away the entire segment anyway */
+      *position = base - running_time;
+      if (G_UNLIKELY (abs_rate != 1.0))
+        *position = ceil (*position * abs_rate);
+
+      if (G_LIKELY (stop + *position >= segment->offset)) {
+        *position = stop + *position - segment->offset;
+        res = 1;
+      } else {
+        /* Requested position is still negative because offset is big,
+         * so negate the result */
+        *position = segment->offset - *position - stop;
+        res = -1;
+      }
+    }
+  }
+  return res;
+}
+
 /**
  * gst_segment_position_from_running_time:
  * @segment: a #GstSegment structure.
@@ -958,9 +1073,11 @@ gst_segment_position_from_running_time (const GstSegment * segment,
   g_return_val_if_fail (segment != NULL, -1);
   g_return_val_if_fail (segment->format == format, -1);
 
-  res =
-      gst_segment_position_from_running_time_full (segment, format,
-      running_time, &position);
+  if (G_UNLIKELY (running_time == -1))
+    return -1;
+
+  res = segment_position_from_running_time_full (segment, running_time,
+      &position);
 
   if (res != 1)
     return -1;
@@ -1014,10 +1131,6 @@ gint
 gst_segment_position_from_running_time_full (const GstSegment * segment,
     GstFormat format, guint64 running_time, guint64 * position)
 {
-  gint res;
-  guint64 start, stop, base;
-  gdouble abs_rate;
-
   if (G_UNLIKELY (running_time == -1)) {
     *position = -1;
     return 0;
@@ -1026,73 +1139,8 @@ gst_segment_position_from_running_time_full (const GstSegment * segment,
   g_return_val_if_fail (segment != NULL, 0);
   g_return_val_if_fail (segment->format == format, 0);
 
-  base = segment->base;
-
-  abs_rate = ABS (segment->rate);
-
-  start = segment->start;
-  stop = segment->stop;
-
-  if (G_LIKELY (segment->rate > 0.0)) {
-    /* start by subtracting the base time */
-    if (G_LIKELY (running_time >= base)) {
-      *position = running_time - base;
-      /* move into the segment at the right rate */
-      if (G_UNLIKELY (abs_rate != 1.0))
-        *position = ceil (*position * abs_rate);
-      /* bring to corrected position in segment */
-      *position += start + segment->offset;
-      res = 1;
-    } else {
-      *position = base - running_time;
-      if (G_UNLIKELY (abs_rate != 1.0))
-        *position = ceil (*position * abs_rate);
-      if (start + segment->offset >= *position) {
-        /* The TS is before the segment, but the result is >= 0 */
-        *position = start + segment->offset - *position;
-        res = 1;
-      } else {
-        /* The TS is before the segment, and the result is < 0
-         * so negate the return result */
-        *position = *position - (start + segment->offset);
-        res = -1;
-      }
-    }
-  } else {
-    if (G_LIKELY (running_time >= base)) {
-      *position = running_time - base;
-      if (G_UNLIKELY (abs_rate != 1.0))
-        *position = ceil (*position * abs_rate);
-      if (G_UNLIKELY (stop < *position + segment->offset)) {
-        *position += segment->offset - stop;
-        res = -1;
-      } else {
-        *position = stop - *position - segment->offset;
-        res = 1;
-      }
-    } else {
-      /* This case is tricky. Requested running time precedes the
-       * segment base, so in a reversed segment where rate < 0, that
-       * means it's before the alignment point of (stop - offset).
-       * Before = always bigger than (stop-offset), which is usually +ve,
-       * but could be -ve is offset is big enough. -ve position implies
-       * that the offset has clipped away the entire segment anyway */
-      *position = base - running_time;
-      if (G_UNLIKELY (abs_rate != 1.0))
-        *position = ceil (*position * abs_rate);
-
-      if (G_LIKELY (stop + *position >= segment->offset)) {
-        *position = stop + *position - segment->offset;
-        res = 1;
-      } else {
-        /* Requested position is still negative because offset is big,
-         * so negate the result */
-        *position = segment->offset - *position - stop;
-        res = -1;
-      }
-    }
-  }
-  return res;
+  return segment_position_from_running_time_full (segment, running_time,
+      position);
 }
 
 /**
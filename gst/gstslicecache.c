@@ -0,0 +1,451 @@
+/* GStreamer
+ *
+ * gstslicecache.c: Per-thread caches for small memory blocks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The buffer and sysmem memory structures and small sysmem data blocks are
+ * allocated and freed at a very high rate from many streaming threads. To
+ * avoid contention in the system allocator we keep a magazine cache per
+ * thread, in the spirit of Bonwick's magazine allocator: every thread owns
+ * two magazines of free blocks per size class and only exchanges complete
+ * magazines with a global, mutex protected, depot.
+ *
+ * Blocks are always allocated with the size of their size class, so blocks
+ * can move freely between the caches and the slice allocator.
+ *
+ * When GST_ALLOCATOR_SLAB is set, the caches are refilled from slabs instead
+ * of the slice allocator, which nowadays is plain malloc. A slab is one
+ * allocation holding a full magazine of blocks of one size class. Blocks of
+ * a slab can't be freed individually, so in this mode the depot keeps every
+ * magazine that is returned to it and the memory is never given back to the
+ * system. This trades memory for allocations that never leave the caches in
+ * steady state, for example when relaying many small packets.
+ */
+
+#include "gst_private.h"
+
+#include <string.h>
+
+#include "gstslicecache.h"
+
+#define MAGAZINE_SIZE 32
+#define DEPOT_MAX_MAGAZINES 16
+
+/* blocks are placed after the header to keep the alignment of the slab */
+#define SLAB_HEADER_SIZE 64
+
+/* pending hits of a thread are added to the totals this often */
+#define STATS_FLUSH_INTERVAL 256
+
+/* 1792 holds the sysmem header and the data of a full ethernet MTU packet */
+static const gsize size_classes[] = {
+  64, 128, 192, 256, 320, 384, 512, 768, 1024, 1280, 1792, 2048, 3072, 4096
+};
+
+#define N_SIZE_CLASSES G_N_ELEMENTS (size_classes)
+
+typedef struct _Magazine Magazine;
+
+struct _Magazine
+{
+  Magazine *next;
+  guint n_items;
+  gpointer items[MAGAZINE_SIZE];
+};
+
+typedef struct
+{
+  Magazine *loaded;
+  Magazine *previous;
+} ThreadClassCache;
+
+typedef struct
+{
+  ThreadClassCache classes[N_SIZE_CLASSES];
+  guint pending_hits;
+} ThreadCache;
+
+typedef struct _Slab Slab;
+
+struct _Slab
+{
+  Slab *next;
+};
+
+typedef struct
+{
+  Magazine *full;
+  guint n_full;
+  Magazine *empty;
+  guint n_empty;
+} Depot;
+
+static gboolean cache_enabled = FALSE;
+static gboolean slab_enabled = FALSE;
+
+static GMutex depot_lock;
+static Depot depots[N_SIZE_CLASSES];
+/* protected by depot_lock */
+static Slab *slabs;
+static guint64 slab_bytes;
+
+static GMutex stats_lock;
+static guint64 stats_hits, stats_misses;
+
+static void thread_cache_free (ThreadCache * cache);
+
+static GPrivate thread_cache = G_PRIVATE_INIT ((GDestroyNotify)
+    thread_cache_free);
+
+static inline gint
+size_to_class (gsize size)
+{
+  gint i;
+
+  for (i = 0; i < N_SIZE_CLASSES; i++) {
+    if (size <= size_classes[i])
+      return i;
+  }
+  return -1;
+}
+
+static void
+magazine_drain (gint idx, Magazine * mag)
+{
+  while (mag->n_items > 0)
+    g_slice_free1 (size_classes[idx], mag->items[--mag->n_items]);
+}
+
+/* give a magazine back to the depot, or free it when the depot is full */
+static void
+depot_release (gint idx, Magazine * mag)
+{
+  Depot *depot = &depots[idx];
+
+  g_mutex_lock (&depot_lock);
+  if (mag->n_items > 0 && (slab_enabled
+          || depot->n_full < DEPOT_MAX_MAGAZINES)) {
+    mag->next = depot->full;
+    depot->full = mag;
+    depot->n_full++;
+    mag = NULL;
+  } else if (mag->n_items == 0 && depot->n_empty < DEPOT_MAX_MAGAZINES) {
+    mag->next = depot->empty;
+    depot->empty = mag;
+    depot->n_empty++;
+    mag = NULL;
+  }
+  g_mutex_unlock (&depot_lock);
+
+  if (mag) {
+    magazine_drain (idx, mag);
+    g_free (mag);
+  }
+}
+
+/* get a magazine with free blocks from the depot */
+static Magazine *
+depot_get_full (gint idx)
+{
+  Depot *depot = &depots[idx];
+  Magazine *mag;
+
+  g_mutex_lock (&depot_lock);
+  if ((mag = depot->full)) {
+    depot->full = mag->next;
+    depot->n_full--;
+  }
+  g_mutex_unlock (&depot_lock);
+
+  return mag;
+}
+
+/* get an empty magazine from the depot or allocate a new one */
+static Magazine *
+depot_get_empty (gint idx)
+{
+  Depot *depot = &depots[idx];
+  Magazine *mag;
+
+  g_mutex_lock (&depot_lock);
+  if ((mag = depot->empty)) {
+    depot->empty = mag->next;
+    depot->n_empty--;
+  }
+  g_mutex_unlock (&depot_lock);
+
+  if (mag == NULL)
+    mag = g_new0 (Magazine, 1);
+
+  return mag;
+}
+
+/* allocate a new slab and return its blocks in a full magazine */
+static Magazine *
+slab_new_magazine (gint idx)
+{
+  gsize block_size = size_classes[idx], size;
+  Magazine *mag;
+  Slab *slab;
+  guint8 *block;
+  guint i;
+
+  size = SLAB_HEADER_SIZE + MAGAZINE_SIZE * block_size;
+  slab = g_malloc (size);
+  mag = g_new (Magazine, 1);
+
+  block = (guint8 *) slab + SLAB_HEADER_SIZE;
+  for (i = 0; i < MAGAZINE_SIZE; i++, block += block_size)
+    mag->items[i] = block;
+  mag->n_items = MAGAZINE_SIZE;
+
+  g_mutex_lock (&depot_lock);
+  slab->next = slabs;
+  slabs = slab;
+  slab_bytes += size;
+  g_mutex_unlock (&depot_lock);
+
+  GST_CAT_LOG (GST_CAT_MEMORY, "new slab of %" G_GSIZE_FORMAT " blocks of %"
+      G_GSIZE_FORMAT " bytes", (gsize) MAGAZINE_SIZE, block_size);
+
+  return mag;
+}
+
+static void
+stats_flush (ThreadCache * cache, guint misses)
+{
+  g_mutex_lock (&stats_lock);
+  stats_hits += cache->pending_hits;
+  stats_misses += misses;
+  g_mutex_unlock (&stats_lock);
+  cache->pending_hits = 0;
+}
+
+static void
+thread_cache_free (ThreadCache * cache)
+{
+  gint i;
+
+  for (i = 0; i < N_SIZE_CLASSES; i++) {
+    ThreadClassCache *cc = &cache->classes[i];
+
+    if (cc->loaded)
+      depot_release (i, cc->loaded);
+    if (cc->previous)
+      depot_release (i, cc->previous);
+  }
+  stats_flush (cache, 0);
+  g_free (cache);
+}
+
+static inline ThreadCache *
+get_thread_cache (void)
+{
+  ThreadCache *cache = g_private_get (&thread_cache);
+
+  if (G_UNLIKELY (cache == NULL)) {
+    cache = g_new0 (ThreadCache, 1);
+    g_private_set (&thread_cache, cache);
+  }
+  return cache;
+}
+
+static inline gpointer
+cache_hit (ThreadCache * cache, Magazine * mag)
+{
+  if (G_UNLIKELY (++cache->pending_hits == STATS_FLUSH_INTERVAL))
+    stats_flush (cache, 0);
+
+  return mag->items[--mag->n_items];
+}
+
+gpointer
+_priv_gst_slice_cache_alloc (gsize size)
+{
+  ThreadCache *cache;
+  ThreadClassCache *cc;
+  Magazine *mag;
+  gint idx;
+
+  idx = size_to_class (size);
+  if (idx < 0)
+    return g_slice_alloc (size);
+
+  if (!cache_enabled)
+    return g_slice_alloc (size_classes[idx]);
+
+  cache = get_thread_cache ();
+  cc = &cache->classes[idx];
+
+  if (G_LIKELY (cc->loaded && cc->loaded->n_items > 0))
+    return cache_hit (cache, cc->loaded);
+
+  if (cc->previous && cc->previous->n_items > 0) {
+    mag = cc->previous;
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+    return cache_hit (cache, mag);
+  }
+
+  if ((mag = depot_get_full (idx))) {
+    /* both our magazines are empty here, keep one of them around */
+    if (cc->previous)
+      depot_release (idx, cc->previous);
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+    return cache_hit (cache, mag);
+  }
+
+  stats_flush (cache, 1);
+
+  if (slab_enabled) {
+    mag = slab_new_magazine (idx);
+    if (cc->previous)
+      depot_release (idx, cc->previous);
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+    return mag->items[--mag->n_items];
+  }
+
+  return g_slice_alloc (size_classes[idx]);
+}
+
+gpointer
+_priv_gst_slice_cache_alloc0 (gsize size)
+{
+  return memset (_priv_gst_slice_cache_alloc (size), 0, size);
+}
+
+void
+_priv_gst_slice_cache_free (gsize size, gpointer mem)
+{
+  ThreadClassCache *cc;
+  Magazine *mag;
+  gint idx;
+
+  idx = size_to_class (size);
+  if (idx < 0) {
+    g_slice_free1 (size, mem);
+    return;
+  }
+
+  if (!cache_enabled) {
+    g_slice_free1 (size_classes[idx], mem);
+    return;
+  }
+
+  cc = &get_thread_cache ()->classes[idx];
+
+  if (G_LIKELY (cc->loaded && cc->loaded->n_items < MAGAZINE_SIZE)) {
+    cc->loaded->items[cc->loaded->n_items++] = mem;
+    return;
+  }
+
+  if (cc->previous && cc->previous->n_items < MAGAZINE_SIZE) {
+    mag = cc->previous;
+    cc->previous = cc->loaded;
+    cc->loaded = mag;
+    mag->items[mag->n_items++] = mem;
+    return;
+  }
+
+  /* both magazines are full (or missing), hand one to the depot */
+  if (cc->previous)
+    depot_release (idx, cc->previous);
+  mag = depot_get_empty (idx);
+  cc->previous = cc->loaded;
+  cc->loaded = mag;
+  mag->items[mag->n_items++] = mem;
+}
+
+void
+_priv_gst_slice_cache_initialize (void)
+{
+  const gchar *env;
+
+  /* don't hide allocations from memory debugging tools */
+  env = g_getenv ("G_SLICE");
+  if (env && (strstr (env, "always-malloc") || strstr (env, "debug-blocks")))
+    return;
+
+  cache_enabled = TRUE;
+
+  env = g_getenv ("GST_ALLOCATOR_SLAB");
+  if (env && *env && strcmp (env, "0") != 0) {
+    GST_CAT_INFO (GST_CAT_MEMORY, "allocating small blocks from slabs");
+    slab_enabled = TRUE;
+  }
+}
+
+void
+_priv_gst_slice_cache_get_stats (guint64 * hits, guint64 * misses,
+    guint64 * slab_size)
+{
+  ThreadCache *cache = g_private_get (&thread_cache);
+
+  g_mutex_lock (&stats_lock);
+  if (hits)
+    *hits = stats_hits + (cache ? cache->pending_hits : 0);
+  if (misses)
+    *misses = stats_misses;
+  g_mutex_unlock (&stats_lock);
+
+  if (slab_size) {
+    g_mutex_lock (&depot_lock);
+    *slab_size = slab_bytes;
+    g_mutex_unlock (&depot_lock);
+  }
+}
+
+void
+_priv_gst_slice_cache_cleanup (void)
+{
+  gint i;
+
+  /* return the magazines of the calling thread to the depot */
+  g_private_replace (&thread_cache, NULL);
+
+  GST_CAT_INFO (GST_CAT_MEMORY, "slice cache: %" G_GUINT64_FORMAT " hits, %"
+      G_GUINT64_FORMAT " misses, %" G_GUINT64_FORMAT " bytes in slabs",
+      stats_hits, stats_misses, slab_bytes);
+
+  /* blocks of slabs may still be in use by other threads and can't be freed
+   * individually, the slabs stay around */
+  if (slab_enabled)
+    return;
+
+  cache_enabled = FALSE;
+
+  g_mutex_lock (&depot_lock);
+  for (i = 0; i < N_SIZE_CLASSES; i++) {
+    Depot *depot = &depots[i];
+    Magazine *mag;
+
+    while ((mag = depot->full)) {
+      depot->full = mag->next;
+      magazine_drain (i, mag);
+      g_free (mag);
+    }
+    while ((mag = depot->empty)) {
+      depot->empty = mag->next;
+      g_free (mag);
+    }
+    depot->n_full = depot->n_empty = 0;
+  }
+  g_mutex_unlock (&depot_lock);
+}
@@ -0,0 +1,52 @@
+/* GStreamer
+ *
+ * gstslicecache.h: Header for per-thread slice caches
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef __GST_SLICE_CACHE_H__
+#define __GST_SLICE_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Drop-in replacements for g_slice_alloc() and g_slice_free1() for the
+ * fixed size structures and small memory blocks that are allocated and freed
+ * for every buffer. A block allocated with _priv_gst_slice_cache_alloc() must
+ * be freed with _priv_gst_slice_cache_free() and the same @size. */
+G_GNUC_INTERNAL
+gpointer  _priv_gst_slice_cache_alloc      (gsize size);
+
+G_GNUC_INTERNAL
+gpointer  _priv_gst_slice_cache_alloc0     (gsize size);
+
+G_GNUC_INTERNAL
+void      _priv_gst_slice_cache_free       (gsize size, gpointer mem);
+
+G_GNUC_INTERNAL
+void      _priv_gst_slice_cache_get_stats  (guint64 * hits, guint64 * misses,
+                                            guint64 * slab_size);
+
+G_GNUC_INTERNAL
+void      _priv_gst_slice_cache_initialize (void);
+
+G_GNUC_INTERNAL
+void      _priv_gst_slice_cache_cleanup    (void);
+
+G_END_DECLS
+
+#endif /* __GST_SLICE_CACHE_H__ */
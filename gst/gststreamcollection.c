@@ -46,8 +46,15 @@ struct _GstStreamCollectionPrivate
   /* Maybe switch this to a GArray if performance is
    * ever an issue? */
   GQueue streams;
+
+  /* stream-id -> first GstStream with that id, only for large collections */
+  GHashTable *streams_by_id;
 };
 
+/* number of streams from which lookups by stream-id use a hash table
+ * instead of walking the streams */
+#define STREAMS_BY_ID_THRESHOLD 16
+
 /* stream signals and properties */
 enum
 {
@@ -151,6 +158,11 @@ gst_stream_collection_dispose (GObject * object)
     collection->upstream_id = NULL;
   }
 
+  if (collection->priv->streams_by_id) {
+    g_hash_table_unref (collection->priv->streams_by_id);
+    collection->priv->streams_by_id = NULL;
+  }
+
   g_queue_foreach (&collection->priv->streams,
       (GFunc) release_gst_stream, collection);
   g_queue_clear (&collection->priv->streams);
@@ -281,12 +293,31 @@ gboolean
 gst_stream_collection_add_stream (GstStreamCollection * collection,
     GstStream * stream)
 {
+  GstStreamCollectionPrivate *priv;
+
   g_return_val_if_fail (GST_IS_STREAM_COLLECTION (collection), FALSE);
   g_return_val_if_fail (GST_IS_STREAM (stream), FALSE);
 
   GST_DEBUG_OBJECT (collection, "Adding stream %" GST_PTR_FORMAT, stream);
 
-  g_queue_push_tail (&collection->priv->streams, stream);
+  priv = collection->priv;
+  g_queue_push_tail (&priv->streams, stream);
+
+  /* stream-ids never change, so the streams can be indexed by them */
+  if (priv->streams_by_id) {
+    if (!g_hash_table_contains (priv->streams_by_id, stream->stream_id))
+      g_hash_table_insert (priv->streams_by_id, (gpointer) stream->stream_id,
+          stream);
+  } else if (priv->streams.length >= STREAMS_BY_ID_THRESHOLD) {
+    GList *l;
+
+    priv->streams_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+    for (l = priv->streams.tail; l; l = l->prev) {
+      GstStream *s = l->data;
+
+      g_hash_table_insert (priv->streams_by_id, (gpointer) s->stream_id, s);
+    }
+  }
   g_signal_connect (stream, "notify", (GCallback) proxy_stream_notify_cb,
       collection);
 
@@ -331,3 +362,163 @@ gst_stream_collection_get_stream (GstStreamCollection * collection, guint index)
 
   return g_queue_peek_nth (&collection->priv->streams, index);
 }
+
+/**
+ * gst_stream_collection_get_stream_by_id:
+ * @collection: a #GstStreamCollection
+ * @stream_id: the stream-id of the stream to retrieve
+ *
+ * Retrieve the first #GstStream of @collection with the given @stream_id,
+ * for example to check the streams of a #GST_EVENT_SELECT_STREAMS event.
+ * Large collections keep an index of their streams, so this does not need
+ * to compare @stream_id with the id of every stream.
+ *
+ * The caller should not modify the returned #GstStream
+ *
+ * Returns: (transfer none) (nullable): A #GstStream, or %NULL if
+ *   @collection has no stream with @stream_id
+ *
+ * Since: 1.20
+ */
+GstStream *
+gst_stream_collection_get_stream_by_id (GstStreamCollection * collection,
+    const gchar * stream_id)
+{
+  GList *l;
+
+  g_return_val_if_fail (GST_IS_STREAM_COLLECTION (collection), NULL);
+  g_return_val_if_fail (stream_id != NULL, NULL);
+
+  if (collection->priv->streams_by_id)
+    return g_hash_table_lookup (collection->priv->streams_by_id, stream_id);
+
+  for (l = collection->priv->streams.head; l; l = l->next) {
+    GstStream *stream = l->data;
+
+    if (g_str_equal (stream->stream_id, stream_id))
+      return stream;
+  }
+
+  return NULL;
+}
+
+static gboolean
+gst_stream_is_equal (GstStream * stream, GstStream * other)
+{
+  GstCaps *caps, *other_caps;
+  GstTagList *tags, *other_tags;
+  gboolean res;
+
+  /* collections usually share the streams that did not change */
+  if (stream == other)
+    return TRUE;
+
+  if (gst_stream_get_stream_type (stream) != gst_stream_get_stream_type (other)
+      || gst_stream_get_stream_flags (stream) !=
+      gst_stream_get_stream_flags (other))
+    return FALSE;
+
+  caps = gst_stream_get_caps (stream);
+  other_caps = gst_stream_get_caps (other);
+  if (caps && other_caps)
+    res = gst_caps_is_equal (caps, other_caps);
+  else
+    res = caps == other_caps;
+  gst_clear_caps (&caps);
+  gst_clear_caps (&other_caps);
+  if (!res)
+    return FALSE;
+
+  tags = gst_stream_get_tags (stream);
+  other_tags = gst_stream_get_tags (other);
+  if (tags && other_tags)
+    res = gst_tag_list_is_equal (tags, other_tags);
+  else
+    res = tags == other_tags;
+  gst_clear_tag_list (&tags);
+  gst_clear_tag_list (&other_tags);
+
+  return res;
+}
+
+/**
+ * gst_stream_collection_diff:
+ * @collection: a #GstStreamCollection
+ * @previous: (allow-none): the #GstStreamCollection replaced by @collection
+ * @added: (out) (optional) (transfer container) (element-type GstStream):
+ *   the streams of @collection that are not in @previous
+ * @removed: (out) (optional) (transfer container) (element-type GstStream):
+ *   the streams of @previous that are not in @collection
+ * @changed: (out) (optional) (transfer container) (element-type GstStream):
+ *   the streams of @collection whose type, flags, caps or tags differ from
+ *   the stream with the same stream-id in @previous
+ *
+ * Compares @collection with the @previous collection it replaces, matching
+ * streams by their stream-id, so that only the streams that were added,
+ * removed or changed need to be handled again. Streams shared by both
+ * collections are never reported as changed. A %NULL @previous reports all
+ * streams of @collection as added.
+ *
+ * The streams in the returned lists are owned by the collections, and the
+ * lists are in the order of the streams in their collection.
+ *
+ * Returns: %TRUE if @collection differs from @previous
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_stream_collection_diff (GstStreamCollection * collection,
+    GstStreamCollection * previous, GList ** added, GList ** removed,
+    GList ** changed)
+{
+  GList *added_list = NULL, *removed_list = NULL, *changed_list = NULL;
+  gboolean res = FALSE;
+  GList *l;
+
+  g_return_val_if_fail (GST_IS_STREAM_COLLECTION (collection), FALSE);
+  g_return_val_if_fail (previous == NULL
+      || GST_IS_STREAM_COLLECTION (previous), FALSE);
+
+  for (l = collection->priv->streams.tail; l; l = l->prev) {
+    GstStream *stream = l->data;
+    GstStream *old = NULL;
+
+    if (previous)
+      old = gst_stream_collection_get_stream_by_id (previous,
+          stream->stream_id);
+
+    if (old == NULL) {
+      added_list = g_list_prepend (added_list, stream);
+      res = TRUE;
+    } else if (!gst_stream_is_equal (stream, old)) {
+      changed_list = g_list_prepend (changed_list, stream);
+      res = TRUE;
+    }
+  }
+
+  if (previous) {
+    for (l = previous->priv->streams.tail; l; l = l->prev) {
+      GstStream *old = l->data;
+
+      if (!gst_stream_collection_get_stream_by_id (collection, old->stream_id)) {
+        removed_list = g_list_prepend (removed_list, old);
+        res = TRUE;
+      }
+    }
+  }
+
+  if (added)
+    *added = added_list;
+  else
+    g_list_free (added_list);
+  if (removed)
+    *removed = removed_list;
+  else
+    g_list_free (removed_list);
+  if (changed)
+    *changed = changed_list;
+  else
+    g_list_free (changed_list);
+
+  return res;
+}
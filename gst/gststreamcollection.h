@@ -108,10 +108,21 @@ guint gst_stream_collection_get_size (GstStreamCollection *collection);
 GST_API
 GstStream *gst_stream_collection_get_stream (GstStreamCollection *collection, guint index);
 
+GST_API
+GstStream *gst_stream_collection_get_stream_by_id (GstStreamCollection *collection,
+                                                   const gchar *stream_id);
+
 GST_API
 gboolean gst_stream_collection_add_stream (GstStreamCollection *collection,
                                            GstStream *stream);
 
+GST_API
+gboolean gst_stream_collection_diff (GstStreamCollection *collection,
+                                     GstStreamCollection *previous,
+                                     GList **added,
+                                     GList **removed,
+                                     GList **changed);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstStreamCollection, gst_object_unref)
 
 G_END_DECLS
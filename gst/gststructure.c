@@ -143,6 +143,8 @@
 
 #include "gst_private.h"
 #include "gstquark.h"
+#include "gstbinarycodec.h"
+#include "gstslicecache.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
 
@@ -161,11 +163,22 @@ typedef struct
 {
   GstStructure s;
 
-  /* owned by parent structure, NULL if no parent */
+  /* owned by parent structure, NULL if no parent. Points to
+   * shared_refcount while the structure is shared between caps */
   gint *parent_refcount;
 
+  /* number of caps owning this structure, see priv_gst_structure_share() */
+  gint owners;
+
   guint fields_len;             /* Number of valid items in fields */
   guint fields_alloc;           /* Allocated items in fields */
+  guint arr_alloc;              /* Allocated items in arr */
+
+  /* Open addressing hash table on the field names with the index + 1 of
+   * the field, only used for structures with more than INDEX_THRESHOLD
+   * fields. The size is index_mask + 1. */
+  guint32 *index;
+  guint index_mask;
 
   /* Fields are allocated if GST_STRUCTURE_IS_USING_DYNAMIC_ARRAY(),
    *  else it's a pointer to the arr field. */
@@ -183,6 +196,19 @@ typedef struct
 #define GST_STRUCTURE_FIELD(structure, index) \
   (&((GstStructureImpl*)(structure))->fields[(index)])
 
+/* structures with a few fields are allocated from the per-thread slice
+ * caches, as the ones of events, queries and messages come and go at the
+ * same rate as those */
+#define GST_STRUCTURE_IMPL_SIZE(n_alloc) \
+  (sizeof (GstStructureImpl) + ((n_alloc) - 1) * sizeof (GstStructureField))
+
+/* the parent refcount of shared structures, never 1 so that shared
+ * structures are never mutable */
+static gint shared_refcount = 2;
+
+#define IS_SHARED(structure) \
+    (GST_STRUCTURE_REFCOUNT(structure) == &shared_refcount)
+
 #define IS_MUTABLE(structure) \
     (!GST_STRUCTURE_REFCOUNT(structure) || \
      g_atomic_int_get (GST_STRUCTURE_REFCOUNT(structure)) == 1)
@@ -190,6 +216,49 @@ typedef struct
 #define IS_TAGLIST(structure) \
     (structure->name == GST_QUARK (TAGLIST))
 
+/* fields are allocated in multiples of this */
+#define FIELDS_ALLOC_ALIGN 4
+
+/* the fields of smaller structures are searched linearly */
+#define INDEX_THRESHOLD 8
+
+#define INDEX_HASH(impl, name) (((name) * 0x9E3779B1u) & (impl)->index_mask)
+
+static inline void
+_structure_index_insert (GstStructureImpl * impl, guint idx)
+{
+  guint i = INDEX_HASH (impl, impl->fields[idx].name);
+
+  while (impl->index[i] != 0)
+    i = (i + 1) & impl->index_mask;
+  impl->index[i] = idx + 1;
+}
+
+/* (Re)builds the index for the current fields, or drops it if the structure
+ * is small enough to not need one */
+static void
+_structure_index_rebuild (GstStructureImpl * impl)
+{
+  guint i, size;
+
+  g_free (impl->index);
+  impl->index = NULL;
+  impl->index_mask = 0;
+
+  if (impl->fields_len <= INDEX_THRESHOLD)
+    return;
+
+  /* keep the table at most half full until the number of fields doubled */
+  size = 1;
+  while (size < impl->fields_len * 4)
+    size <<= 1;
+
+  impl->index = g_new0 (guint32, size);
+  impl->index_mask = size - 1;
+  for (i = 0; i < impl->fields_len; i++)
+    _structure_index_insert (impl, i);
+}
+
 /* Replacement for g_array_append_val */
 static void
 _structure_append_val (GstStructure * s, GstStructureField * val)
@@ -204,7 +273,7 @@ _structure_append_val (GstStructure * s, GstStructureField * val)
       g_error ("Growing structure would result in overflow");
 
     want_alloc =
-        MAX (GST_ROUND_UP_8 (impl->fields_len + 1), impl->fields_alloc * 2);
+        MAX (GST_ROUND_UP_4 (impl->fields_len + 1), impl->fields_alloc * 2);
     if (GST_STRUCTURE_IS_USING_DYNAMIC_ARRAY (s)) {
       impl->fields = g_renew (GstStructureField, impl->fields, want_alloc);
     } else {
@@ -218,6 +287,11 @@ _structure_append_val (GstStructure * s, GstStructureField * val)
 
   /* Finally set value */
   impl->fields[impl->fields_len++] = *val;
+
+  if (impl->index && impl->fields_len * 2 <= impl->index_mask + 1)
+    _structure_index_insert (impl, impl->fields_len - 1);
+  else if (impl->fields_len > INDEX_THRESHOLD)
+    _structure_index_rebuild (impl);
 }
 
 /* Replacement for g_array_remove_index */
@@ -236,6 +310,10 @@ _structure_remove_index (GstStructure * s, guint idx)
         &impl->fields[idx + 1],
         (impl->fields_len - idx - 1) * sizeof (GstStructureField));
   impl->fields_len--;
+
+  /* the indices of the following fields changed */
+  if (impl->index)
+    _structure_index_rebuild (impl);
 }
 
 static void gst_structure_set_field (GstStructure * structure,
@@ -276,17 +354,17 @@ gst_structure_new_id_empty_with_size (GQuark quark, guint prealloc)
   if (prealloc == 0)
     prealloc = 1;
 
-  n_alloc = GST_ROUND_UP_8 (prealloc);
-  structure =
-      g_malloc0 (sizeof (GstStructureImpl) + (n_alloc -
-          1) * sizeof (GstStructureField));
+  n_alloc = GST_ROUND_UP_N (prealloc, FIELDS_ALLOC_ALIGN);
+  structure = _priv_gst_slice_cache_alloc0 (GST_STRUCTURE_IMPL_SIZE (n_alloc));
 
   ((GstStructure *) structure)->type = _gst_structure_type;
   ((GstStructure *) structure)->name = quark;
   GST_STRUCTURE_REFCOUNT (structure) = NULL;
+  structure->owners = 1;
 
   structure->fields_len = 0;
   structure->fields_alloc = n_alloc;
+  structure->arr_alloc = n_alloc;
   structure->fields = &structure->arr[0];
 
   GST_TRACE ("created structure %p", structure);
@@ -363,7 +441,8 @@ gst_structure_new_empty (const gchar * name)
 {
   g_return_val_if_fail (gst_structure_validate_name (name), NULL);
 
-  return gst_structure_new_id_empty_with_size (g_quark_from_string (name), 0);
+  return gst_structure_new_id_empty_with_size (_priv_gst_quark_from_string
+      (name), 0);
 }
 
 /**
@@ -433,7 +512,8 @@ gst_structure_new_valist (const gchar * name,
   va_end (copy);
 
   structure =
-      gst_structure_new_id_empty_with_size (g_quark_from_string (name), len);
+      gst_structure_new_id_empty_with_size (_priv_gst_quark_from_string
+      (name), len);
 
   if (structure)
     gst_structure_set_valist (structure, firstfield, varargs);
@@ -477,6 +557,54 @@ gst_structure_set_parent_refcount (GstStructure * structure, gint * refcount)
   return TRUE;
 }
 
+/* Adds an owner to @structure, which must be owned by a caps. The structure
+ * stays immutable until all but one owner released it. */
+GstStructure *
+priv_gst_structure_share (GstStructure * structure)
+{
+  GST_STRUCTURE_REFCOUNT (structure) = &shared_refcount;
+  g_atomic_int_inc (&((GstStructureImpl *) structure)->owners);
+
+  return structure;
+}
+
+gboolean
+priv_gst_structure_is_shared (const GstStructure * structure)
+{
+  return IS_SHARED (structure);
+}
+
+/* Returns @structure or a copy of it that is only owned by the caller, with
+ * @refcount as parent refcount. The caller's ownership of @structure is
+ * transferred to the result. */
+GstStructure *
+priv_gst_structure_make_exclusive (GstStructure * structure, gint * refcount)
+{
+  GstStructure *copy;
+
+  if (!IS_SHARED (structure)
+      || g_atomic_int_get (&((GstStructureImpl *) structure)->owners) == 1) {
+    GST_STRUCTURE_REFCOUNT (structure) = refcount;
+    return structure;
+  }
+
+  copy = gst_structure_copy (structure);
+  GST_STRUCTURE_REFCOUNT (copy) = refcount;
+  priv_gst_structure_release (structure);
+
+  return copy;
+}
+
+/* Drops one owner of @structure and frees it when it was the last one */
+void
+priv_gst_structure_release (GstStructure * structure)
+{
+  if (g_atomic_int_dec_and_test (&((GstStructureImpl *) structure)->owners)) {
+    GST_STRUCTURE_REFCOUNT (structure) = NULL;
+    gst_structure_free (structure);
+  }
+}
+
 /**
  * gst_structure_copy:
  * @structure: a #GstStructure to duplicate
@@ -540,13 +668,15 @@ gst_structure_free (GstStructure * structure)
   }
   if (GST_STRUCTURE_IS_USING_DYNAMIC_ARRAY (structure))
     g_free (((GstStructureImpl *) structure)->fields);
+  g_free (((GstStructureImpl *) structure)->index);
 
 #ifdef USE_POISONING
   memset (structure, 0xff, sizeof (GstStructure));
 #endif
   GST_TRACE ("free structure %p", structure);
 
-  g_free (structure);
+  _priv_gst_slice_cache_free (GST_STRUCTURE_IMPL_SIZE (((GstStructureImpl *)
+              structure)->arr_alloc), structure);
 }
 
 /**
@@ -687,7 +817,7 @@ gst_structure_set_name (GstStructure * structure, const gchar * name)
   g_return_if_fail (IS_MUTABLE (structure));
   g_return_if_fail (gst_structure_validate_name (name));
 
-  structure->name = g_quark_from_string (name);
+  structure->name = _priv_gst_quark_from_string (name);
 }
 
 static inline void
@@ -744,7 +874,7 @@ gst_structure_set_value (GstStructure * structure,
   g_return_if_fail (IS_MUTABLE (structure));
 
   gst_structure_id_set_value_internal (structure,
-      g_quark_from_string (fieldname), value);
+      _priv_gst_quark_from_string (fieldname), value);
 }
 
 static inline void
@@ -807,7 +937,7 @@ gst_structure_take_value (GstStructure * structure, const gchar * fieldname,
   g_return_if_fail (IS_MUTABLE (structure));
 
   gst_structure_id_take_value_internal (structure,
-      g_quark_from_string (fieldname), value);
+      _priv_gst_quark_from_string (fieldname), value);
 }
 
 static void
@@ -820,7 +950,7 @@ gst_structure_set_valist_internal (GstStructure * structure,
   while (fieldname) {
     GstStructureField field = { 0 };
 
-    field.name = g_quark_from_string (fieldname);
+    field.name = _priv_gst_quark_from_string (fieldname);
 
     type = va_arg (varargs, GType);
 
@@ -1010,9 +1140,6 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 {
   GstStructureField *f;
   GType field_value_type;
-  guint i, len;
-
-  len = GST_STRUCTURE_LEN (structure);
 
   field_value_type = G_VALUE_TYPE (&field->value);
   if (field_value_type == G_TYPE_STRING) {
@@ -1063,14 +1190,11 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
-  for (i = 0; i < len; i++) {
-    f = GST_STRUCTURE_FIELD (structure, i);
-
-    if (G_UNLIKELY (f->name == field->name)) {
-      g_value_unset (&f->value);
-      memcpy (f, field, sizeof (GstStructureField));
-      return;
-    }
+  f = gst_structure_id_get_field (structure, field->name);
+  if (G_UNLIKELY (f != NULL)) {
+    g_value_unset (&f->value);
+    memcpy (f, field, sizeof (GstStructureField));
+    return;
   }
 
   _structure_append_val (structure, field);
@@ -1081,9 +1205,23 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 static GstStructureField *
 gst_structure_id_get_field (const GstStructure * structure, GQuark field_id)
 {
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
   GstStructureField *field;
   guint i, len;
 
+  if (G_UNLIKELY (impl->index)) {
+    guint32 idx;
+
+    i = INDEX_HASH (impl, field_id);
+    while ((idx = impl->index[i]) != 0) {
+      field = &impl->fields[idx - 1];
+      if (field->name == field_id)
+        return field;
+      i = (i + 1) & impl->index_mask;
+    }
+    return NULL;
+  }
+
   len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
@@ -1102,11 +1240,17 @@ static GstStructureField *
 gst_structure_get_field (const GstStructure * structure,
     const gchar * fieldname)
 {
+  GQuark field_id;
+
   g_return_val_if_fail (structure != NULL, NULL);
   g_return_val_if_fail (fieldname != NULL, NULL);
 
-  return gst_structure_id_get_field (structure,
-      g_quark_from_string (fieldname));
+  /* no structure can have a field with a name that was never used */
+  field_id = _priv_gst_quark_try_string (fieldname);
+  if (field_id == 0)
+    return NULL;
+
+  return gst_structure_id_get_field (structure, field_id);
 }
 
 /**
@@ -1178,7 +1322,10 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
   g_return_if_fail (fieldname != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  id = g_quark_from_string (fieldname);
+  id = _priv_gst_quark_try_string (fieldname);
+  if (id == 0)
+    return;
+
   len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
@@ -1263,8 +1410,9 @@ gst_structure_remove_all_fields (GstStructure * structure)
     if (G_IS_VALUE (&field->value)) {
       g_value_unset (&field->value);
     }
-    _structure_remove_index (structure, i);
   }
+  GST_STRUCTURE_LEN (structure) = 0;
+  _structure_index_rebuild ((GstStructureImpl *) structure);
 }
 
 /**
@@ -1489,7 +1637,7 @@ gst_structure_has_field (const GstStructure * structure,
   g_return_val_if_fail (fieldname != NULL, FALSE);
 
   return gst_structure_id_has_field (structure,
-      g_quark_from_string (fieldname));
+      _priv_gst_quark_from_string (fieldname));
 }
 
 /**
@@ -1536,7 +1684,7 @@ gst_structure_has_field_typed (const GstStructure * structure,
   g_return_val_if_fail (fieldname != NULL, FALSE);
 
   return gst_structure_id_has_field_typed (structure,
-      g_quark_from_string (fieldname), type);
+      _priv_gst_quark_from_string (fieldname), type);
 }
 
 /* utility functions */
@@ -2254,7 +2402,7 @@ gst_structure_parse_field (gchar * str,
 
   c = *name_end;
   *name_end = '\0';
-  field->name = g_quark_from_string (name);
+  field->name = _priv_gst_quark_from_string (name);
   GST_DEBUG ("trying field name '%s'", name);
   *name_end = c;
 
@@ -2445,6 +2593,62 @@ error:
   return NULL;
 }
 
+/**
+ * gst_structure_to_binary:
+ * @structure: a #GstStructure
+ *
+ * Serializes @structure into a compact binary representation that can be
+ * turned back into an equal structure with gst_structure_from_binary().
+ *
+ * This is both smaller and faster to produce and parse than the string
+ * representation, but it is not human readable and only meant for
+ * exchanging structures between processes using the same GStreamer version,
+ * or for caching them.
+ *
+ * Returns: (transfer full) (nullable): the serialized @structure, or %NULL
+ *     if one of the field values could not be serialized.
+ *
+ * Since: 1.20
+ */
+GBytes *
+gst_structure_to_binary (const GstStructure * structure)
+{
+  g_return_val_if_fail (structure != NULL, NULL);
+
+  return _priv_gst_binary_serialize_structure (structure);
+}
+
+/**
+ * gst_structure_from_binary: (constructor):
+ * @data: (array length=size): data created with gst_structure_to_binary()
+ * @size: the size of @data
+ * @consumed: (out) (optional): the number of bytes of @data that were used
+ *
+ * Creates a #GstStructure from its binary representation created with
+ * gst_structure_to_binary(). @data can contain trailing data after the
+ * structure, the position where parsing ended is returned in @consumed.
+ *
+ * Free-function: gst_structure_free
+ *
+ * Returns: (transfer full) (nullable): a new #GstStructure or %NULL
+ *     when @data could not be parsed.
+ *
+ * Since: 1.20
+ */
+GstStructure *
+gst_structure_from_binary (const guint8 * data, gsize size, gsize * consumed)
+{
+  GstStructure *structure = NULL;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  if (!_priv_gst_binary_deserialize_structure (data, size, consumed,
+          &structure))
+    return NULL;
+
+  return structure;
+}
+
 static void
 gst_structure_transform_to_string (const GValue * src_value,
     GValue * dest_value)
@@ -3426,7 +3630,7 @@ _gst_structure_set_any_list (GstStructure * structure, GType type,
 
   if (g_value_transform (&arval, &value)) {
     gst_structure_id_set_value_internal (structure,
-        g_quark_from_string (fieldname), &value);
+        _priv_gst_quark_from_string (fieldname), &value);
   } else {
     g_warning ("Failed to convert a GValueArray");
   }
@@ -352,6 +352,13 @@ GST_API
 GstStructure *        gst_structure_from_string  (const gchar * string,
                                                   gchar      ** end) G_GNUC_MALLOC;
 GST_API
+GBytes *              gst_structure_to_binary            (const GstStructure * structure);
+
+GST_API
+GstStructure *        gst_structure_from_binary  (const guint8 * data,
+                                                  gsize          size,
+                                                  gsize        * consumed) G_GNUC_MALLOC;
+GST_API
 gboolean              gst_structure_fixate_field_nearest_int      (GstStructure * structure,
                                                                    const char   * field_name,
                                                                    int            target);
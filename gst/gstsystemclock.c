@@ -60,14 +60,29 @@
 #include <mach/mach_time.h>
 #endif
 
+#if defined (__GNUC__) && defined (HAVE_UINT128_T) && !defined (__APPLE__) && \
+    defined (HAVE_POSIX_TIMERS) && defined (HAVE_CLOCK_GETTIME) && \
+    defined (HAVE_MONOTONIC_CLOCK) && \
+    (defined (__x86_64__) || defined (__aarch64__))
+#define HAVE_TSC_CLOCK 1
+#ifdef __x86_64__
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
 /* Define this to get some extra debug about jitter from each clock_wait */
 #undef WAIT_DEBUGGING
 
 #define GST_SYSTEM_CLOCK_GET_LOCK(clock)        GST_OBJECT_GET_LOCK(clock)
-#define GST_SYSTEM_CLOCK_LOCK(clock)            g_mutex_lock(GST_SYSTEM_CLOCK_GET_LOCK(clock))
-#define GST_SYSTEM_CLOCK_UNLOCK(clock)          g_mutex_unlock(GST_SYSTEM_CLOCK_GET_LOCK(clock))
+#define GST_SYSTEM_CLOCK_LOCK(clock)            GST_OBJECT_LOCK(clock)
+#define GST_SYSTEM_CLOCK_UNLOCK(clock)          GST_OBJECT_UNLOCK(clock)
 #define GST_SYSTEM_CLOCK_GET_COND(clock)        (&GST_SYSTEM_CLOCK_CAST(clock)->priv->entries_changed)
+#ifdef GST_ENABLE_LOCK_TRACING
+#define GST_SYSTEM_CLOCK_WAIT(clock)            _gst_tracer_cond_wait(GST_SYSTEM_CLOCK_GET_COND(clock),GST_SYSTEM_CLOCK_GET_LOCK(clock),GST_OBJECT_CAST(clock),G_STRLOC)
+#else
 #define GST_SYSTEM_CLOCK_WAIT(clock)            g_cond_wait(GST_SYSTEM_CLOCK_GET_COND(clock),GST_SYSTEM_CLOCK_GET_LOCK(clock))
+#endif
 #define GST_SYSTEM_CLOCK_BROADCAST(clock)       g_cond_broadcast(GST_SYSTEM_CLOCK_GET_COND(clock))
 
 #if defined(HAVE_FUTEX)
@@ -100,6 +115,11 @@ struct _GstClockEntryFutex
 
   gboolean initialized;
 
+  /* position in the heap of async entries, -1 if not queued */
+  gint heap_index;
+  /* keeps the insertion order of entries with the same time */
+  guint64 heap_seqnum;
+
   GMutex lock;
   guint cond_val;
 };
@@ -305,6 +325,11 @@ struct _GstClockEntryGLib
 
   gboolean initialized;
 
+  /* position in the heap of async entries, -1 if not queued */
+  gint heap_index;
+  /* keeps the insertion order of entries with the same time */
+  guint64 heap_seqnum;
+
   GMutex lock;
   GCond cond;
 };
@@ -336,6 +361,7 @@ ensure_entry_initialized (GstClockEntryImpl * entry_impl)
 {
   if (!entry_impl->initialized) {
     init_entry (entry_impl);
+    entry_impl->heap_index = -1;
     entry_impl->initialized = TRUE;
   }
 }
@@ -345,10 +371,15 @@ struct _GstSystemClockPrivate
   GThread *thread;              /* thread for async notify */
   gboolean stopping;
 
-  GList *entries;
+  /* pending async entries as binary min-heap on the entry time */
+  GstClockEntryImpl **heap;
+  guint heap_len;
+  guint heap_alloc;
+  guint64 heap_seqnum;
   GCond entries_changed;
 
   GstClockType clock_type;
+  GstClockTime coalesce_slack;
 
 #ifdef G_OS_WIN32
   LARGE_INTEGER frequency;
@@ -358,6 +389,102 @@ struct _GstSystemClockPrivate
 #endif
 };
 
+/* heap of async entries, all functions must be called with clock lock */
+static inline gboolean
+heap_entry_less (GstClockEntryImpl * a, GstClockEntryImpl * b)
+{
+  GstClockTime ta = GST_CLOCK_ENTRY_TIME ((GstClockEntry *) a);
+  GstClockTime tb = GST_CLOCK_ENTRY_TIME ((GstClockEntry *) b);
+
+  return ta < tb || (ta == tb && a->heap_seqnum < b->heap_seqnum);
+}
+
+static inline void
+heap_set (GstSystemClockPrivate * priv, guint idx, GstClockEntryImpl * entry)
+{
+  priv->heap[idx] = entry;
+  entry->heap_index = idx;
+}
+
+static void
+heap_sift_up (GstSystemClockPrivate * priv, guint idx)
+{
+  GstClockEntryImpl *entry = priv->heap[idx];
+
+  while (idx > 0) {
+    guint parent = (idx - 1) / 2;
+
+    if (!heap_entry_less (entry, priv->heap[parent]))
+      break;
+    heap_set (priv, idx, priv->heap[parent]);
+    idx = parent;
+  }
+  heap_set (priv, idx, entry);
+}
+
+static void
+heap_sift_down (GstSystemClockPrivate * priv, guint idx)
+{
+  GstClockEntryImpl *entry = priv->heap[idx];
+
+  for (;;) {
+    guint child = 2 * idx + 1;
+
+    if (child >= priv->heap_len)
+      break;
+    if (child + 1 < priv->heap_len &&
+        heap_entry_less (priv->heap[child + 1], priv->heap[child]))
+      child++;
+    if (!heap_entry_less (priv->heap[child], entry))
+      break;
+    heap_set (priv, idx, priv->heap[child]);
+    idx = child;
+  }
+  heap_set (priv, idx, entry);
+}
+
+/* takes ownership of a ref */
+static void
+heap_push (GstSystemClockPrivate * priv, GstClockEntryImpl * entry)
+{
+  if (priv->heap_len == priv->heap_alloc) {
+    priv->heap_alloc = MAX (16, priv->heap_alloc * 2);
+    priv->heap = g_renew (GstClockEntryImpl *, priv->heap, priv->heap_alloc);
+  }
+  entry->heap_seqnum = priv->heap_seqnum++;
+  priv->heap[priv->heap_len++] = entry;
+  heap_sift_up (priv, priv->heap_len - 1);
+}
+
+/* restores the heap order after the time of a queued entry changed */
+static void
+heap_update (GstSystemClockPrivate * priv, GstClockEntryImpl * entry)
+{
+  guint idx = entry->heap_index;
+
+  heap_sift_up (priv, idx);
+  if (entry->heap_index == idx)
+    heap_sift_down (priv, idx);
+}
+
+/* releases the ref of the heap */
+static void
+heap_remove (GstSystemClockPrivate * priv, GstClockEntryImpl * entry)
+{
+  guint idx = entry->heap_index;
+  GstClockEntryImpl *last;
+
+  g_assert (idx < priv->heap_len && priv->heap[idx] == entry);
+
+  entry->heap_index = -1;
+  last = priv->heap[--priv->heap_len];
+  if (last != entry) {
+    heap_set (priv, idx, last);
+    heap_update (priv, last);
+  }
+  gst_clock_id_unref ((GstClockID) entry);
+}
+
 #ifdef HAVE_POSIX_TIMERS
 # ifdef HAVE_MONOTONIC_CLOCK
 #  define DEFAULT_CLOCK_TYPE GST_CLOCK_TYPE_MONOTONIC
@@ -368,10 +495,13 @@ struct _GstSystemClockPrivate
 #define DEFAULT_CLOCK_TYPE GST_CLOCK_TYPE_MONOTONIC
 #endif
 
+#define DEFAULT_COALESCE_SLACK 0
+
 enum
 {
   PROP_0,
   PROP_CLOCK_TYPE,
+  PROP_COALESCE_SLACK,
   /* FILL ME */
 };
 
@@ -429,6 +559,24 @@ gst_system_clock_class_init (GstSystemClockClass * klass)
           GST_TYPE_CLOCK_TYPE, DEFAULT_CLOCK_TYPE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstSystemClock:coalesce-slack:
+   *
+   * Async clock entries that are due at most this long after the last
+   * timeout of the async thread are fired together with it, without waiting
+   * for each of them separately. This reduces the number of wakeups when many
+   * entries have almost the same time, at the cost of firing them up to
+   * this much too early. It should be smaller than the interval of periodic
+   * entries.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_COALESCE_SLACK,
+      g_param_spec_uint64 ("coalesce-slack", "Coalesce slack",
+          "Maximum time async clock entries are fired early to coalesce "
+          "wakeups", 0, G_MAXUINT64, DEFAULT_COALESCE_SLACK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstclock_class->get_internal_time = gst_system_clock_get_internal_time;
   gstclock_class->get_resolution = gst_system_clock_get_resolution;
   gstclock_class->wait = gst_system_clock_id_wait_jitter;
@@ -450,8 +598,10 @@ gst_system_clock_init (GstSystemClock * clock)
   clock->priv = priv = gst_system_clock_get_instance_private (clock);
 
   priv->clock_type = DEFAULT_CLOCK_TYPE;
+  priv->coalesce_slack = DEFAULT_COALESCE_SLACK;
 
-  priv->entries = NULL;
+  priv->heap = NULL;
+  priv->heap_len = priv->heap_alloc = 0;
   g_cond_init (&priv->entries_changed);
 
 #ifdef G_OS_WIN32
@@ -476,14 +626,14 @@ gst_system_clock_dispose (GObject * object)
   GstClock *clock = (GstClock *) object;
   GstSystemClock *sysclock = GST_SYSTEM_CLOCK_CAST (clock);
   GstSystemClockPrivate *priv = sysclock->priv;
-  GList *entries;
+  guint i;
 
   /* else we have to stop the thread */
   GST_SYSTEM_CLOCK_LOCK (clock);
   priv->stopping = TRUE;
   /* unschedule all entries */
-  for (entries = priv->entries; entries; entries = g_list_next (entries)) {
-    GstClockEntryImpl *entry = (GstClockEntryImpl *) entries->data;
+  for (i = 0; i < priv->heap_len; i++) {
+    GstClockEntryImpl *entry = priv->heap[i];
 
     /* We don't need to take the entry lock here because the async thread
      * would only ever look at the head entry, which is locked below and only
@@ -495,9 +645,9 @@ gst_system_clock_dispose (GObject * object)
      * this one, not all of them. Once the head entry is unscheduled it tries
      * to get the system clock lock (which we hold here) and then look for the
      * next entry. Once it gets the lock it will notice that all further
-     * entries are unscheduled, would remove them one by one from the list and
+     * entries are unscheduled, would remove them one by one from the heap and
      * then shut down. */
-    if (!entries->prev) {
+    if (i == 0) {
       /* it was initialized before adding to the list */
       g_assert (entry->initialized);
 
@@ -516,9 +666,11 @@ gst_system_clock_dispose (GObject * object)
   priv->thread = NULL;
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "joined thread");
 
-  g_list_foreach (priv->entries, (GFunc) gst_clock_id_unref, NULL);
-  g_list_free (priv->entries);
-  priv->entries = NULL;
+  while (priv->heap_len > 0)
+    heap_remove (priv, priv->heap[priv->heap_len - 1]);
+  g_free (priv->heap);
+  priv->heap = NULL;
+  priv->heap_alloc = 0;
 
   g_cond_clear (&priv->entries_changed);
 
@@ -541,6 +693,15 @@ gst_system_clock_set_property (GObject * object, guint prop_id,
       sysclock->priv->clock_type = (GstClockType) g_value_get_enum (value);
       GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, sysclock, "clock-type set to %d",
           sysclock->priv->clock_type);
+#ifdef HAVE_TSC_CLOCK
+      if (sysclock->priv->clock_type == GST_CLOCK_TYPE_TSC)
+        tsc_ensure_calibrated ();
+#endif
+      break;
+    case PROP_COALESCE_SLACK:
+      GST_SYSTEM_CLOCK_LOCK (sysclock);
+      sysclock->priv->coalesce_slack = g_value_get_uint64 (value);
+      GST_SYSTEM_CLOCK_UNLOCK (sysclock);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -558,6 +719,11 @@ gst_system_clock_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CLOCK_TYPE:
       g_value_set_enum (value, sysclock->priv->clock_type);
       break;
+    case PROP_COALESCE_SLACK:
+      GST_SYSTEM_CLOCK_LOCK (sysclock);
+      g_value_set_uint64 (value, sysclock->priv->coalesce_slack);
+      GST_SYSTEM_CLOCK_UNLOCK (sysclock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -643,12 +809,12 @@ gst_system_clock_obtain (void)
   return clock;
 }
 
-/* this thread reads the sorted clock entries from the queue.
+/* this thread reads the earliest clock entry from the heap.
  *
  * It waits on each of them and fires the callback when the timeout occurs.
  *
- * When an entry in the queue was canceled before we wait for it, it is
- * simply skipped.
+ * When an entry in the queue was canceled before we wait for it, it was
+ * already removed from the heap by gst_system_clock_id_unschedule().
  *
  * When waiting for an entry, it can become canceled, in that case we don't
  * call the callback but move to the next item in the queue.
@@ -662,6 +828,8 @@ gst_system_clock_async_thread (GstClock * clock)
   GstSystemClockPrivate *priv = sysclock->priv;
   GstClockReturn status;
   gboolean entry_needs_unlock = FALSE;
+  /* entries up to this time are fired without waiting */
+  GstClockTime batch_deadline = 0;
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "enter system clock thread");
   GST_SYSTEM_CLOCK_LOCK (clock);
@@ -674,7 +842,7 @@ gst_system_clock_async_thread (GstClock * clock)
     GstClockReturn res;
 
     /* check if something to be done */
-    while (priv->entries == NULL) {
+    while (priv->heap_len == 0) {
       GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
           "no clock entries, waiting..");
       /* wait for work to do */
@@ -685,8 +853,9 @@ gst_system_clock_async_thread (GstClock * clock)
         goto exit;
     }
 
-    /* pick the next entry */
-    entry = priv->entries->data;
+    /* pick the next entry, the ref keeps it alive when it is removed from the
+     * heap while we wait on it or call its callback */
+    entry = gst_clock_id_ref ((GstClockID) priv->heap[0]);
 
     /* it was initialized before adding to the list */
     g_assert (((GstClockEntryImpl *) entry)->initialized);
@@ -712,23 +881,44 @@ gst_system_clock_async_thread (GstClock * clock)
       GST_CAT_ERROR_OBJECT (GST_CAT_CLOCK, clock,
           "unexpected status %d for entry %p", status, entry);
 
-    /* mark the entry as busy */
-    GST_CLOCK_ENTRY_STATUS (entry) = GST_CLOCK_BUSY;
-
     requested = entry->time;
 
-    /* needs to be locked again before the next loop iteration, and we only
-     * unlock it here so that gst_system_clock_id_wait_async() is guaranteed
-     * to see status==BUSY later and wakes up this thread, and dispose() does
-     * not override BUSY with UNSCHEDULED here. */
-    GST_SYSTEM_CLOCK_UNLOCK (clock);
+    if (requested <= batch_deadline) {
+      /* due already or within the slack of the last timeout, fire it in the
+       * same pass as the previous entries instead of waiting for it */
+      GST_CLOCK_ENTRY_STATUS (entry) = GST_CLOCK_OK;
+      GST_SYSTEM_CLOCK_UNLOCK (clock);
 
-    GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "waiting on entry %p", entry);
+      GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
+          "entry %p due before %" GST_TIME_FORMAT, entry,
+          GST_TIME_ARGS (batch_deadline));
+      res = GST_CLOCK_OK;
+    } else {
+      GstClockTime slack = priv->coalesce_slack;
+
+      /* mark the entry as busy */
+      GST_CLOCK_ENTRY_STATUS (entry) = GST_CLOCK_BUSY;
+
+      /* needs to be locked again before the next loop iteration, and we only
+       * unlock it here so that gst_system_clock_id_wait_async() is guaranteed
+       * to see status==BUSY later and wakes up this thread, and dispose() does
+       * not override BUSY with UNSCHEDULED here. */
+      GST_SYSTEM_CLOCK_UNLOCK (clock);
 
-    /* now wait for the entry */
-    res =
-        gst_system_clock_id_wait_jitter_unlocked (clock, (GstClockID) entry,
-        NULL, FALSE);
+      GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "waiting on entry %p",
+          entry);
+
+      /* now wait for the entry */
+      res =
+          gst_system_clock_id_wait_jitter_unlocked (clock, (GstClockID) entry,
+          NULL, FALSE);
+
+      if (res == GST_CLOCK_OK || res == GST_CLOCK_EARLY) {
+        GstClockTime now = gst_clock_get_time (clock);
+
+        batch_deadline = now + MIN (slack, G_MAXUINT64 - now);
+      }
+    }
 
     switch (res) {
       case GST_CLOCK_UNSCHEDULED:
@@ -745,6 +935,14 @@ gst_system_clock_async_thread (GstClock * clock)
          * entry */
         GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "async entry %p timed out",
             entry);
+        if (entry->type != GST_CLOCK_ENTRY_PERIODIC) {
+          /* dequeue before firing the callback, which might want to queue the
+           * entry again */
+          GST_SYSTEM_CLOCK_LOCK (clock);
+          if (((GstClockEntryImpl *) entry)->heap_index >= 0)
+            heap_remove (priv, (GstClockEntryImpl *) entry);
+          GST_SYSTEM_CLOCK_UNLOCK (clock);
+        }
         if (entry->func) {
           /* unlock before firing the callback */
           entry->func (clock, entry->time, (GstClockID) entry,
@@ -757,14 +955,18 @@ gst_system_clock_async_thread (GstClock * clock)
           GST_SYSTEM_CLOCK_LOCK (clock);
           /* adjust time now */
           entry->time = requested + entry->interval;
-          /* and resort the list now */
-          priv->entries =
-              g_list_sort (priv->entries, gst_clock_id_compare_func);
+          /* and move it to its new place if it was not unscheduled from the
+           * callback */
+          if (((GstClockEntryImpl *) entry)->heap_index >= 0)
+            heap_update (priv, (GstClockEntryImpl *) entry);
+          gst_clock_id_unref ((GstClockID) entry);
           /* and restart */
           continue;
         } else {
           GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "moving to next entry");
-          goto next_entry;
+          GST_SYSTEM_CLOCK_LOCK (clock);
+          gst_clock_id_unref ((GstClockID) entry);
+          continue;
         }
       }
       case GST_CLOCK_BUSY:
@@ -781,6 +983,7 @@ gst_system_clock_async_thread (GstClock * clock)
         if (entry_needs_unlock)
           GST_SYSTEM_CLOCK_ENTRY_UNLOCK ((GstClockEntryImpl *) entry);
         GST_SYSTEM_CLOCK_LOCK (clock);
+        gst_clock_id_unref ((GstClockID) entry);
         continue;
       default:
         GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
@@ -794,8 +997,9 @@ gst_system_clock_async_thread (GstClock * clock)
       GST_SYSTEM_CLOCK_ENTRY_UNLOCK ((GstClockEntryImpl *) entry);
     GST_SYSTEM_CLOCK_LOCK (clock);
 
-    /* we remove the current entry and unref it */
-    priv->entries = g_list_remove (priv->entries, entry);
+    /* we remove the current entry if it is still queued and unref it */
+    if (((GstClockEntryImpl *) entry)->heap_index >= 0)
+      heap_remove (priv, (GstClockEntryImpl *) entry);
     gst_clock_id_unref ((GstClockID) entry);
   }
 exit:
@@ -805,12 +1009,154 @@ exit:
   GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock, "exit system clock thread");
 }
 
+#ifdef HAVE_TSC_CLOCK
+/* The timestamp counter is converted to the time of the monotonic clock with
+ * a base and a 32.32 fixed point factor in nanoseconds per tick, which are
+ * determined once when the first clock of type GST_CLOCK_TYPE_TSC is set
+ * up. */
+typedef struct
+{
+  gboolean usable;
+  guint64 tsc_base;
+  GstClockTime mono_base;
+  guint64 mult;
+} GstTscCalibration;
+
+static GstTscCalibration tsc_calibration;
+
+static inline guint64
+tsc_read (void)
+{
+#ifdef __x86_64__
+  return __rdtsc ();
+#else
+  guint64 v;
+
+  __asm__ __volatile__ ("isb; mrs %0, cntvct_el0":"=r" (v)::"memory");
+  return v;
+#endif
+}
+
+static inline GstClockTime
+tsc_to_time (guint64 tsc)
+{
+  return tsc_calibration.mono_base + (GstClockTime)
+      (((__uint128_t) (tsc - tsc_calibration.tsc_base) *
+          tsc_calibration.mult) >> 32);
+}
+
+static GstClockTime
+tsc_mono_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return GST_TIMESPEC_TO_TIME (ts);
+}
+
+/* reads the counter and the monotonic clock as close together as possible */
+static void
+tsc_sample (guint64 * tsc, GstClockTime * mono)
+{
+  GstClockTime best = GST_CLOCK_TIME_NONE;
+  guint i;
+
+  for (i = 0; i < 5; i++) {
+    GstClockTime before, after;
+    guint64 t;
+
+    before = tsc_mono_time ();
+    t = tsc_read ();
+    after = tsc_mono_time ();
+
+    if (after - before < best) {
+      best = after - before;
+      *tsc = t;
+      *mono = before + best / 2;
+    }
+  }
+}
+
+static gpointer
+tsc_calibrate (gpointer data)
+{
+  GstTscCalibration *cal = &tsc_calibration;
+  GstClockTime mono1, mono2, predicted;
+  guint64 tsc1, tsc2;
+  GstClockTimeDiff diff;
+
+#ifdef __x86_64__
+  {
+    guint eax, ebx, ecx, edx;
+
+    /* only an invariant TSC runs at a constant rate in all power states */
+    if (!__get_cpuid (0x80000000, &eax, &ebx, &ecx, &edx) || eax < 0x80000007
+        || !__get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx)
+        || !(edx & (1 << 8))) {
+      GST_CAT_WARNING (GST_CAT_CLOCK, "no invariant TSC");
+      return NULL;
+    }
+  }
+#endif
+
+  tsc_sample (&cal->tsc_base, &cal->mono_base);
+#ifdef __x86_64__
+  g_usleep (20 * 1000);
+  tsc_sample (&tsc1, &mono1);
+  if (tsc1 <= cal->tsc_base || mono1 <= cal->mono_base) {
+    GST_CAT_WARNING (GST_CAT_CLOCK, "TSC not increasing");
+    return NULL;
+  }
+  cal->mult = gst_util_uint64_scale (mono1 - cal->mono_base, G_GUINT64_CONSTANT
+      (1) << 32, tsc1 - cal->tsc_base);
+#else
+  {
+    guint64 freq;
+
+    __asm__ __volatile__ ("mrs %0, cntfrq_el0":"=r" (freq));
+    if (freq == 0) {
+      GST_CAT_WARNING (GST_CAT_CLOCK, "unknown counter frequency");
+      return NULL;
+    }
+    cal->mult = gst_util_uint64_scale (GST_SECOND, G_GUINT64_CONSTANT (1) << 32,
+        freq);
+  }
+#endif
+
+  /* check the conversion against the monotonic clock a bit later */
+  g_usleep (20 * 1000);
+  tsc_sample (&tsc2, &mono2);
+  predicted = tsc_to_time (tsc2);
+  diff = GST_CLOCK_DIFF (mono2, predicted);
+  if (diff > 50 * GST_USECOND || diff < -50 * GST_USECOND) {
+    GST_CAT_WARNING (GST_CAT_CLOCK, "TSC deviates %" G_GINT64_FORMAT "ns "
+        "from the monotonic clock", diff);
+    return NULL;
+  }
+
+  GST_CAT_INFO (GST_CAT_CLOCK, "using TSC with %" G_GUINT64_FORMAT
+      " ns/2^32 ticks, deviation %" G_GINT64_FORMAT "ns", cal->mult, diff);
+  cal->usable = TRUE;
+
+  return NULL;
+}
+
+static void
+tsc_ensure_calibrated (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  g_once (&once, tsc_calibrate, NULL);
+}
+#endif /* HAVE_TSC_CLOCK */
+
 #ifdef HAVE_POSIX_TIMERS
 static inline clockid_t
 clock_type_to_posix_id (GstClockType clock_type)
 {
 #ifdef HAVE_MONOTONIC_CLOCK
-  if (clock_type == GST_CLOCK_TYPE_MONOTONIC)
+  if (clock_type == GST_CLOCK_TYPE_MONOTONIC ||
+      clock_type == GST_CLOCK_TYPE_TSC)
     return CLOCK_MONOTONIC;
   else
 #endif
@@ -836,6 +1182,12 @@ gst_system_clock_get_internal_time (GstClock * clock)
   clockid_t ptype;
   struct timespec ts;
 
+#ifdef HAVE_TSC_CLOCK
+  if (sysclock->priv->clock_type == GST_CLOCK_TYPE_TSC &&
+      tsc_calibration.usable)
+    return tsc_to_time (tsc_read ());
+#endif
+
   ptype = clock_type_to_posix_id (sysclock->priv->clock_type);
 
   if (G_UNLIKELY (clock_gettime (ptype, &ts)))
@@ -917,6 +1269,12 @@ gst_system_clock_get_resolution (GstClock * clock)
     clockid_t ptype;
   struct timespec ts;
 
+#ifdef HAVE_TSC_CLOCK
+  if (sysclock->priv->clock_type == GST_CLOCK_TYPE_TSC &&
+      tsc_calibration.usable)
+    return 1;
+#endif
+
   ptype = clock_type_to_posix_id (sysclock->priv->clock_type);
 
   if (G_UNLIKELY (clock_getres (ptype, &ts)))
@@ -1159,10 +1517,10 @@ no_thread:
   return FALSE;
 }
 
-/* Add an entry to the list of pending async waits. The entry is inserted
- * in sorted order. If we inserted the entry at the head of the list, we
- * need to signal the thread as it might either be waiting on it or waiting
- * for a new entry.
+/* Add an entry to the heap of pending async waits. If the entry became the
+ * head of the heap, we need to signal the thread as it might either be waiting
+ * on it or waiting for a new entry. An entry that is already queued is only
+ * moved to its new place.
  *
  * MT safe.
  */
@@ -1171,6 +1529,7 @@ gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
 {
   GstSystemClock *sysclock;
   GstSystemClockPrivate *priv;
+  GstClockEntryImpl *entry_impl = (GstClockEntryImpl *) entry;
   GstClockEntry *head;
 
   sysclock = GST_SYSTEM_CLOCK_CAST (clock);
@@ -1189,22 +1548,23 @@ gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
     goto was_unscheduled;
   GST_SYSTEM_CLOCK_ENTRY_UNLOCK ((GstClockEntryImpl *) entry);
 
-  if (priv->entries)
-    head = priv->entries->data;
+  if (priv->heap_len > 0)
+    head = (GstClockEntry *) priv->heap[0];
   else
     head = NULL;
 
-  /* need to take a ref */
-  gst_clock_id_ref ((GstClockID) entry);
-
-  /* insert the entry in sorted order */
-  priv->entries = g_list_insert_sorted (priv->entries, entry,
-      gst_clock_id_compare_func);
+  if (entry_impl->heap_index >= 0) {
+    heap_update (priv, entry_impl);
+  } else {
+    /* need to take a ref */
+    gst_clock_id_ref ((GstClockID) entry);
+    heap_push (priv, entry_impl);
+  }
 
   /* only need to send the signal if the entry was added to the
    * front, else the thread is just waiting for another entry and
    * will get to this entry automatically. */
-  if (priv->entries->data == entry) {
+  if ((GstClockEntry *) priv->heap[0] == entry && head != entry) {
     GST_CAT_DEBUG_OBJECT (GST_CAT_CLOCK, clock,
         "async entry added to head %p", head);
     if (head == NULL) {
@@ -1283,5 +1643,12 @@ gst_system_clock_id_unschedule (GstClock * clock, GstClockEntry * entry)
     GST_SYSTEM_CLOCK_ENTRY_BROADCAST ((GstClockEntryImpl *) entry);
   }
   GST_SYSTEM_CLOCK_ENTRY_UNLOCK ((GstClockEntryImpl *) entry);
+
+  /* drop pending async entries right away instead of letting them wait in the
+   * queue until they would have timed out. The async thread holds its own
+   * ref on the entry it is currently handling. */
+  if (((GstClockEntryImpl *) entry)->heap_index >= 0)
+    heap_remove (GST_SYSTEM_CLOCK_CAST (clock)->priv,
+        (GstClockEntryImpl *) entry);
   GST_SYSTEM_CLOCK_UNLOCK (clock);
 }
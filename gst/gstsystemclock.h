@@ -50,6 +50,10 @@ typedef struct _GstSystemClockPrivate GstSystemClockPrivate;
  * @GST_CLOCK_TYPE_OTHER: some other time source is used (Since: 1.0.5)
  * @GST_CLOCK_TYPE_TAI: time since Epoch, but using International Atomic Time
  *                      as reference (Since: 1.18)
+ * @GST_CLOCK_TYPE_TSC: monotonic time like %GST_CLOCK_TYPE_MONOTONIC, but
+ *                      read from the CPU timestamp counter (TSC on x86-64,
+ *                      CNTVCT on ARM64) if it is usable, which is unaffected
+ *                      by NTP adjustments (Since: 1.20)
  *
  * The different kind of clocks.
  */
@@ -57,7 +61,8 @@ typedef enum {
   GST_CLOCK_TYPE_REALTIME       = 0,
   GST_CLOCK_TYPE_MONOTONIC      = 1,
   GST_CLOCK_TYPE_OTHER          = 2,
-  GST_CLOCK_TYPE_TAI            = 3
+  GST_CLOCK_TYPE_TAI            = 3,
+  GST_CLOCK_TYPE_TSC            = 4
 } GstClockType;
 
 /**
@@ -79,12 +79,43 @@ GstTagInfo;
 
 #define g_value_get_char g_value_get_schar
 
+typedef struct
+{
+  GHashTable *by_name;          /* tag name string => GstTagInfo */
+  GHashTable *by_quark;         /* tag name quark => GstTagInfo */
+}
+GstTagTable;
+
+/* only serializes registrations, lookups don't take it */
 static GMutex __tag_mutex;
 #define TAG_LOCK g_mutex_lock (&__tag_mutex)
 #define TAG_UNLOCK g_mutex_unlock (&__tag_mutex)
 
-/* tags hash table: maps tag name string => GstTagInfo */
-static GHashTable *__tags;
+/* snapshot of the registered tags. A published table is never modified,
+ * registering a tag publishes an extended copy instead. Replaced tables are
+ * kept in __retired_tags as lookups can still be using them without a lock,
+ * tags are rarely registered after initialization so these are few. */
+static GstTagTable *__tags;
+static GSList *__retired_tags;
+static gboolean __tags_initialized;
+
+static void gst_tag_register_core_tags (void);
+static void gst_tag_register_static_internal (const gchar * name,
+    GstTagFlag flag, GType type, const gchar * nick, const gchar * blurb,
+    GstTagMergeFunc func);
+
+/* The core tags are only registered when the first tag is looked up or
+ * registered, most applications never use tags */
+static inline void
+gst_tag_ensure_core_tags (void)
+{
+  static gsize core_tags_registered = 0;
+
+  if (g_once_init_enter (&core_tags_registered)) {
+    gst_tag_register_core_tags ();
+    g_once_init_leave (&core_tags_registered, 1);
+  }
+}
 
 GType _gst_tag_list_type = 0;
 GST_DEFINE_MINI_OBJECT_TYPE (GstTagList, gst_tag_list);
@@ -102,8 +133,19 @@ _priv_gst_tag_initialize (void)
   g_mutex_init (&__tag_mutex);
 
   _gst_tag_list_type = gst_tag_list_get_type ();
+}
 
-  __tags = g_hash_table_new (g_str_hash, g_str_equal);
+/* called with the once guard held, so the public function that waits for
+ * it can't be used here */
+#define gst_tag_register_static gst_tag_register_static_internal
+static void
+gst_tag_register_core_tags (void)
+{
+  /* the core tags are added to the table in place, nothing can look them up
+   * before we return */
+  __tags = g_new0 (GstTagTable, 1);
+  __tags->by_name = g_hash_table_new (g_str_hash, g_str_equal);
+  __tags->by_quark = g_hash_table_new (NULL, NULL);
   gst_tag_register_static (GST_TAG_TITLE, GST_TAG_FLAG_META,
       G_TYPE_STRING,
       _("title"), _("commonly used title"), gst_tag_merge_strings_with_comma);
@@ -411,7 +453,9 @@ _priv_gst_tag_initialize (void)
       GST_TYPE_SAMPLE,
       _("private-data"), _("Private data"), gst_tag_merge_use_first);
 
+  __tags_initialized = TRUE;
 }
+#undef gst_tag_register_static
 
 /**
  * gst_tag_merge_use_first:
@@ -462,13 +506,38 @@ gst_tag_merge_strings_with_comma (GValue * dest, const GValue * src)
 static GstTagInfo *
 gst_tag_lookup (const gchar * tag_name)
 {
-  GstTagInfo *ret;
+  GstTagTable *tags;
 
-  TAG_LOCK;
-  ret = g_hash_table_lookup (__tags, (gpointer) tag_name);
-  TAG_UNLOCK;
+  gst_tag_ensure_core_tags ();
+  tags = g_atomic_pointer_get (&__tags);
+
+  return g_hash_table_lookup (tags->by_name, (gpointer) tag_name);
+}
+
+static GstTagInfo *
+gst_tag_lookup_quark (GQuark tag_quark)
+{
+  GstTagTable *tags;
+
+  gst_tag_ensure_core_tags ();
+  tags = g_atomic_pointer_get (&__tags);
 
-  return ret;
+  return g_hash_table_lookup (tags->by_quark, GUINT_TO_POINTER (tag_quark));
+}
+
+static GHashTable *
+gst_tag_table_copy (GHashTable * table, GHashFunc hash_func,
+    GEqualFunc equal_func)
+{
+  GHashTable *copy = g_hash_table_new (hash_func, equal_func);
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_insert (copy, key, value);
+
+  return copy;
 }
 
 /**
@@ -535,16 +604,35 @@ void
 gst_tag_register_static (const gchar * name, GstTagFlag flag, GType type,
     const gchar * nick, const gchar * blurb, GstTagMergeFunc func)
 {
-  GstTagInfo *info;
-
   g_return_if_fail (name != NULL);
   g_return_if_fail (nick != NULL);
   g_return_if_fail (blurb != NULL);
   g_return_if_fail (type != 0 && type != GST_TYPE_LIST);
 
-  info = gst_tag_lookup (name);
+  gst_tag_ensure_core_tags ();
+  gst_tag_register_static_internal (name, flag, type, nick, blurb, func);
+}
+
+static void
+gst_tag_register_static_internal (const gchar * name, GstTagFlag flag,
+    GType type, const gchar * nick, const gchar * blurb, GstTagMergeFunc func)
+{
+  GstTagTable *tags;
+  GstTagInfo *info;
+
+  info = g_hash_table_lookup (g_atomic_pointer_get (&__tags)->by_name, name);
+
+  if (info) {
+    g_return_if_fail (info->type == type);
+    return;
+  }
 
+  TAG_LOCK;
+  tags = __tags;
+  /* check again, someone might have registered it in the meantime */
+  info = g_hash_table_lookup (tags->by_name, name);
   if (info) {
+    TAG_UNLOCK;
     g_return_if_fail (info->type == type);
     return;
   }
@@ -557,8 +645,19 @@ gst_tag_register_static (const gchar * name, GstTagFlag flag, GType type,
   info->blurb = blurb;
   info->merge_func = func;
 
-  TAG_LOCK;
-  g_hash_table_insert (__tags, (gpointer) name, info);
+  if (__tags_initialized) {
+    tags = g_new0 (GstTagTable, 1);
+    tags->by_name = gst_tag_table_copy (__tags->by_name, g_str_hash,
+        g_str_equal);
+    tags->by_quark = gst_tag_table_copy (__tags->by_quark, NULL, NULL);
+  }
+  g_hash_table_insert (tags->by_name, (gpointer) name, info);
+  g_hash_table_insert (tags->by_quark, GUINT_TO_POINTER (info->name_quark),
+      info);
+  if (tags != __tags) {
+    __retired_tags = g_slist_prepend (__retired_tags, __tags);
+    g_atomic_pointer_set (&__tags, tags);
+  }
   TAG_UNLOCK;
 }
 
@@ -902,6 +1001,57 @@ gst_tag_list_new_from_string (const gchar * str)
   return tag_list;
 }
 
+/**
+ * gst_tag_list_to_binary:
+ * @list: a #GstTagList
+ *
+ * Serializes a tag list into a compact binary representation, see
+ * gst_structure_to_binary().
+ *
+ * Returns: (transfer full) (nullable): the serialized @list, or %NULL in
+ *     case of an error.
+ *
+ * Since: 1.20
+ */
+GBytes *
+gst_tag_list_to_binary (const GstTagList * list)
+{
+  g_return_val_if_fail (GST_IS_TAG_LIST (list), NULL);
+
+  return gst_structure_to_binary (GST_TAG_LIST_STRUCTURE (list));
+}
+
+/**
+ * gst_tag_list_new_from_binary:
+ * @data: (array length=size): data created with gst_tag_list_to_binary()
+ * @size: the size of @data
+ *
+ * Deserializes a tag list from its binary representation.
+ *
+ * Returns: (nullable): a new #GstTagList, or %NULL in case of an
+ * error.
+ *
+ * Since: 1.20
+ */
+GstTagList *
+gst_tag_list_new_from_binary (const guint8 * data, gsize size)
+{
+  GstStructure *s;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  s = gst_structure_from_binary (data, size, NULL);
+  if (s == NULL)
+    return NULL;
+
+  if (!gst_structure_has_name (s, "taglist")) {
+    gst_structure_free (s);
+    return NULL;
+  }
+
+  return gst_tag_list_new_internal (s, GST_TAG_SCOPE_STREAM);
+}
+
 /**
  * gst_tag_list_n_tags:
  * @list: A #GstTagList.
@@ -1110,10 +1260,14 @@ gst_tag_list_copy_foreach (GQuark tag_quark, const GValue * value,
     gpointer user_data)
 {
   GstTagCopyData *copy = (GstTagCopyData *) user_data;
-  const gchar *tag;
+  GstTagInfo *info;
 
-  tag = g_quark_to_string (tag_quark);
-  gst_tag_list_add_value_internal (copy->list, copy->mode, tag, value, NULL);
+  info = gst_tag_lookup_quark (tag_quark);
+  if (G_UNLIKELY (info == NULL)) {
+    g_warning ("unknown tag '%s'", g_quark_to_string (tag_quark));
+    return TRUE;
+  }
+  gst_tag_list_add_value_internal (copy->list, copy->mode, NULL, value, info);
 
   return TRUE;
 }
@@ -1137,6 +1291,21 @@ gst_tag_list_insert (GstTagList * into, const GstTagList * from,
   g_return_if_fail (GST_IS_TAG_LIST (from));
   g_return_if_fail (GST_TAG_MODE_IS_VALID (mode));
 
+  if (mode == GST_TAG_MERGE_KEEP_ALL)
+    return;
+
+  /* merging into an empty list in any other mode results in a copy of
+   * @from, all its values have been checked already when adding them */
+  if (into != from && gst_structure_get_name_id (GST_TAG_LIST_STRUCTURE (into))
+      == gst_structure_get_name_id (GST_TAG_LIST_STRUCTURE (from))
+      && (mode == GST_TAG_MERGE_REPLACE_ALL
+          || gst_structure_n_fields (GST_TAG_LIST_STRUCTURE (into)) == 0)) {
+    gst_structure_free (GST_TAG_LIST_STRUCTURE (into));
+    GST_TAG_LIST_STRUCTURE (into) =
+        gst_structure_copy (GST_TAG_LIST_STRUCTURE (from));
+    return;
+  }
+
   data.list = into;
   data.mode = mode;
   if (mode == GST_TAG_MERGE_REPLACE_ALL) {
@@ -1164,7 +1333,6 @@ gst_tag_list_merge (const GstTagList * list1, const GstTagList * list2,
     GstTagMergeMode mode)
 {
   GstTagList *list1_cp;
-  const GstTagList *list2_cp;
 
   g_return_val_if_fail (list1 == NULL || GST_IS_TAG_LIST (list1), NULL);
   g_return_val_if_fail (list2 == NULL || GST_IS_TAG_LIST (list2), NULL);
@@ -1177,12 +1345,11 @@ gst_tag_list_merge (const GstTagList * list1, const GstTagList * list2,
 
   /* create empty list, we need to do this to correctly handling merge modes */
   list1_cp = (list1) ? gst_tag_list_copy (list1) : gst_tag_list_new_empty ();
-  list2_cp = (list2) ? list2 : gst_tag_list_new_empty ();
-
-  gst_tag_list_insert (list1_cp, list2_cp, mode);
 
-  if (!list2)
-    gst_tag_list_unref ((GstTagList *) list2_cp);
+  if (list2)
+    gst_tag_list_insert (list1_cp, list2, mode);
+  else if (mode == GST_TAG_MERGE_REPLACE_ALL)
+    gst_structure_remove_all_fields (GST_TAG_LIST_STRUCTURE (list1_cp));
 
   return list1_cp;
 }
@@ -83,6 +83,12 @@
 #include <pthread.h>
 #endif
 
+#if defined (HAVE_PTHREAD_SETSCHEDPARAM) || defined (HAVE_PTHREAD_SETAFFINITY_NP)
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (task_debug);
 #define GST_CAT_DEFAULT (task_debug)
 
@@ -106,6 +112,25 @@ struct _GstTaskPrivate
   /* remember the pool and id that is currently running. */
   gpointer id;
   GstTaskPool *pool_id;
+
+  /* configuration of the thread, applied by the thread itself */
+  GstTaskScheduling scheduling;
+  gint priority;
+  guint *cpus;
+  guint n_cpus;
+  gint thread_config_changed;
+
+  /* settings of the thread before we changed them, restored when the
+   * thread goes back to the pool */
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  gboolean sched_saved;
+  int saved_policy;
+  struct sched_param saved_param;
+#endif
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  gboolean affinity_saved;
+  cpu_set_t saved_cpus;
+#endif
 };
 
 #ifdef _MSC_VER
@@ -275,6 +300,7 @@ gst_task_finalize (GObject * object)
     task->notify (task->user_data);
 
   gst_object_unref (priv->pool);
+  g_free (priv->cpus);
 
   /* task thread cannot be running here since it holds a ref
    * to the task so that the finalize could not have happened */
@@ -325,6 +351,119 @@ gst_task_configure_name (GstTask * task)
 #endif
 }
 
+/* apply the scheduling policy and CPU affinity to the calling thread, must
+ * be called from the task thread */
+static void
+gst_task_configure_thread (GstTask * task)
+{
+#if defined (HAVE_PTHREAD_SETSCHEDPARAM) || defined (HAVE_PTHREAD_SETAFFINITY_NP)
+  GstTaskPrivate *priv = task->priv;
+#endif
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  GstTaskScheduling scheduling;
+  gint priority;
+#endif
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  cpu_set_t cpus;
+  guint i, n_cpus;
+#endif
+  G_GNUC_UNUSED gint res;
+
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  GST_OBJECT_LOCK (task);
+  scheduling = priv->scheduling;
+  priority = priv->priority;
+  GST_OBJECT_UNLOCK (task);
+
+  if (scheduling != GST_TASK_SCHEDULING_INHERIT) {
+    struct sched_param param = { 0, };
+    int policy;
+
+    switch (scheduling) {
+      case GST_TASK_SCHEDULING_FIFO:
+        policy = SCHED_FIFO;
+        break;
+      case GST_TASK_SCHEDULING_RR:
+        policy = SCHED_RR;
+        break;
+      default:
+        policy = SCHED_OTHER;
+        break;
+    }
+    if (policy != SCHED_OTHER)
+      param.sched_priority = CLAMP (priority, sched_get_priority_min (policy),
+          sched_get_priority_max (policy));
+
+    if (!priv->sched_saved)
+      priv->sched_saved = pthread_getschedparam (pthread_self (),
+          &priv->saved_policy, &priv->saved_param) == 0;
+
+    GST_DEBUG_OBJECT (task, "Setting scheduling policy %d, priority %d",
+        policy, param.sched_priority);
+    if ((res = pthread_setschedparam (pthread_self (), policy, &param)) != 0)
+      GST_WARNING_OBJECT (task, "Failed to set scheduling policy: %s",
+          g_strerror (res));
+  } else if (priv->sched_saved) {
+    pthread_setschedparam (pthread_self (), priv->saved_policy,
+        &priv->saved_param);
+    priv->sched_saved = FALSE;
+  }
+#else
+  if (task->priv->scheduling != GST_TASK_SCHEDULING_INHERIT)
+    GST_WARNING_OBJECT (task, "Scheduling policies are not supported");
+#endif
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  CPU_ZERO (&cpus);
+  GST_OBJECT_LOCK (task);
+  n_cpus = priv->n_cpus;
+  for (i = 0; i < n_cpus; i++) {
+    if (priv->cpus[i] < CPU_SETSIZE)
+      CPU_SET (priv->cpus[i], &cpus);
+  }
+  GST_OBJECT_UNLOCK (task);
+
+  if (n_cpus > 0) {
+    if (!priv->affinity_saved)
+      priv->affinity_saved = pthread_getaffinity_np (pthread_self (),
+          sizeof (priv->saved_cpus), &priv->saved_cpus) == 0;
+
+    GST_DEBUG_OBJECT (task, "Setting CPU affinity to %u CPUs", n_cpus);
+    if ((res = pthread_setaffinity_np (pthread_self (), sizeof (cpus),
+                &cpus)) != 0)
+      GST_WARNING_OBJECT (task, "Failed to set CPU affinity: %s",
+          g_strerror (res));
+  } else if (priv->affinity_saved) {
+    pthread_setaffinity_np (pthread_self (), sizeof (priv->saved_cpus),
+        &priv->saved_cpus);
+    priv->affinity_saved = FALSE;
+  }
+#else
+  if (task->priv->n_cpus > 0)
+    GST_WARNING_OBJECT (task, "Setting the CPU affinity is not supported");
+#endif
+}
+
+/* undo gst_task_configure_thread() before the thread goes back to the pool */
+static void
+gst_task_restore_thread (GstTask * task)
+{
+#ifdef HAVE_PTHREAD_SETSCHEDPARAM
+  if (task->priv->sched_saved) {
+    pthread_setschedparam (pthread_self (), task->priv->saved_policy,
+        &task->priv->saved_param);
+    task->priv->sched_saved = FALSE;
+  }
+#endif
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  if (task->priv->affinity_saved) {
+    pthread_setaffinity_np (pthread_self (), sizeof (task->priv->saved_cpus),
+        &task->priv->saved_cpus);
+    task->priv->affinity_saved = FALSE;
+  }
+#endif
+}
+
 static void
 gst_task_func (GstTask * task)
 {
@@ -358,6 +497,8 @@ gst_task_func (GstTask * task)
   g_rec_mutex_lock (lock);
   /* configure the thread name now */
   gst_task_configure_name (task);
+  g_atomic_int_set (&priv->thread_config_changed, FALSE);
+  gst_task_configure_thread (task);
 
   while (G_LIKELY (GET_TASK_STATE (task) != GST_TASK_STOPPED)) {
     GST_OBJECT_LOCK (task);
@@ -381,11 +522,18 @@ gst_task_func (GstTask * task)
       GST_OBJECT_UNLOCK (task);
     }
 
+    if (G_UNLIKELY (g_atomic_int_get (&priv->thread_config_changed))) {
+      g_atomic_int_set (&priv->thread_config_changed, FALSE);
+      gst_task_configure_thread (task);
+    }
+
     task->func (task->user_data);
   }
 
   g_rec_mutex_unlock (lock);
 
+  gst_task_restore_thread (task);
+
   GST_OBJECT_LOCK (task);
   task->thread = NULL;
 
@@ -665,6 +813,123 @@ gst_task_set_leave_callback (GstTask * task, GstTaskThreadFunc leave_func,
   GST_OBJECT_UNLOCK (task);
 }
 
+/**
+ * gst_task_set_scheduling:
+ * @task: a #GstTask
+ * @scheduling: the #GstTaskScheduling policy
+ * @priority: the realtime priority for %GST_TASK_SCHEDULING_FIFO and
+ *     %GST_TASK_SCHEDULING_RR
+ *
+ * Configure the scheduling policy of the thread that runs @task. The policy
+ * is applied when the task function is entered, or before the next
+ * iteration when @task is running already, and the previous policy of the
+ * thread is restored when the task function is left. @priority is clamped
+ * to the range supported by the system for @scheduling.
+ *
+ * Realtime scheduling usually requires special privileges, a warning is
+ * logged if the policy can not be applied.
+ *
+ * Since: 1.20
+ */
+void
+gst_task_set_scheduling (GstTask * task, GstTaskScheduling scheduling,
+    gint priority)
+{
+  g_return_if_fail (GST_IS_TASK (task));
+
+  GST_OBJECT_LOCK (task);
+  task->priv->scheduling = scheduling;
+  task->priv->priority = priority;
+  GST_OBJECT_UNLOCK (task);
+
+  g_atomic_int_set (&task->priv->thread_config_changed, TRUE);
+}
+
+/**
+ * gst_task_get_scheduling:
+ * @task: a #GstTask
+ * @priority: (out) (optional): the configured priority
+ *
+ * Get the scheduling policy configured with gst_task_set_scheduling().
+ *
+ * Returns: the #GstTaskScheduling policy of @task
+ *
+ * Since: 1.20
+ */
+GstTaskScheduling
+gst_task_get_scheduling (GstTask * task, gint * priority)
+{
+  GstTaskScheduling scheduling;
+
+  g_return_val_if_fail (GST_IS_TASK (task), GST_TASK_SCHEDULING_INHERIT);
+
+  GST_OBJECT_LOCK (task);
+  scheduling = task->priv->scheduling;
+  if (priority)
+    *priority = task->priv->priority;
+  GST_OBJECT_UNLOCK (task);
+
+  return scheduling;
+}
+
+/**
+ * gst_task_set_cpu_affinity:
+ * @task: a #GstTask
+ * @cpus: (array length=n_cpus) (nullable): the CPUs to run on
+ * @n_cpus: the number of CPUs in @cpus
+ *
+ * Restrict the thread that runs @task to the CPUs in @cpus. Like for
+ * gst_task_set_scheduling(), the affinity is applied by the task thread
+ * itself and restored when the task function is left. An empty array
+ * removes the restriction.
+ *
+ * Since: 1.20
+ */
+void
+gst_task_set_cpu_affinity (GstTask * task, const guint * cpus, guint n_cpus)
+{
+  g_return_if_fail (GST_IS_TASK (task));
+  g_return_if_fail (cpus != NULL || n_cpus == 0);
+
+  GST_OBJECT_LOCK (task);
+  g_free (task->priv->cpus);
+  task->priv->cpus =
+      n_cpus ? g_memdup2 (cpus, n_cpus * sizeof (guint)) : NULL;
+  task->priv->n_cpus = n_cpus;
+  GST_OBJECT_UNLOCK (task);
+
+  g_atomic_int_set (&task->priv->thread_config_changed, TRUE);
+}
+
+/**
+ * gst_task_get_cpu_affinity:
+ * @task: a #GstTask
+ * @n_cpus: (out): the number of returned CPUs
+ *
+ * Get the CPUs configured with gst_task_set_cpu_affinity().
+ *
+ * Returns: (array length=n_cpus) (transfer full) (nullable): the CPUs @task
+ * may run on, or %NULL if it is not restricted. g_free() after usage.
+ *
+ * Since: 1.20
+ */
+guint *
+gst_task_get_cpu_affinity (GstTask * task, guint * n_cpus)
+{
+  guint *cpus;
+
+  g_return_val_if_fail (GST_IS_TASK (task), NULL);
+  g_return_val_if_fail (n_cpus != NULL, NULL);
+
+  GST_OBJECT_LOCK (task);
+  cpus = task->priv->n_cpus ? g_memdup2 (task->priv->cpus,
+      task->priv->n_cpus * sizeof (guint)) : NULL;
+  *n_cpus = task->priv->n_cpus;
+  GST_OBJECT_UNLOCK (task);
+
+  return cpus;
+}
+
 /**
  * gst_task_get_state:
  * @task: The #GstTask to query
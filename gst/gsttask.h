@@ -64,6 +64,25 @@ typedef enum {
   GST_TASK_PAUSED
 } GstTaskState;
 
+/**
+ * GstTaskScheduling:
+ * @GST_TASK_SCHEDULING_INHERIT: keep the scheduling policy of the thread
+ * @GST_TASK_SCHEDULING_OTHER: the default time-sharing scheduling policy
+ * @GST_TASK_SCHEDULING_FIFO: first in, first out realtime scheduling
+ * @GST_TASK_SCHEDULING_RR: round robin realtime scheduling
+ *
+ * The scheduling policy of the thread of a task, see
+ * gst_task_set_scheduling().
+ *
+ * Since: 1.20
+ */
+typedef enum {
+  GST_TASK_SCHEDULING_INHERIT,
+  GST_TASK_SCHEDULING_OTHER,
+  GST_TASK_SCHEDULING_FIFO,
+  GST_TASK_SCHEDULING_RR
+} GstTaskScheduling;
+
 /**
  * GST_TASK_STATE:
  * @task: Task to get the state of
@@ -192,6 +211,20 @@ void            gst_task_set_leave_callback  (GstTask *task,
                                               GstTaskThreadFunc leave_func,
                                               gpointer user_data,
                                               GDestroyNotify notify);
+GST_API
+void            gst_task_set_scheduling      (GstTask *task,
+                                              GstTaskScheduling scheduling,
+                                              gint priority);
+GST_API
+GstTaskScheduling gst_task_get_scheduling    (GstTask *task, gint *priority);
+
+GST_API
+void            gst_task_set_cpu_affinity    (GstTask *task,
+                                              const guint *cpus,
+                                              guint n_cpus);
+GST_API
+guint *         gst_task_get_cpu_affinity    (GstTask *task, guint *n_cpus);
+
 GST_API
 GstTaskState    gst_task_get_state      (GstTask *task);
 
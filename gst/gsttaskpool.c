@@ -37,6 +37,13 @@
 #include "gsttaskpool.h"
 #include "gsterror.h"
 
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#include <pthread.h>
+#include <sched.h>
+#elif defined (HAVE_SCHED_GETCPU)
+#include <sched.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (taskpool_debug);
 #define GST_CAT_DEFAULT (taskpool_debug)
 
@@ -547,3 +554,532 @@ gst_shared_task_pool_new (void)
 
   return pool;
 }
+
+/**
+ * SECTION:gstworkstealingtaskpool
+ * @title: GstWorkStealingTaskPool
+ * @short_description: Task pool with per-thread job queues
+ * @see_also: #GstTaskPool, #GstSharedTaskPool
+ *
+ * A #GstWorkStealingTaskPool runs jobs on a fixed number of threads. Every
+ * thread has its own job queue so that pushing and running short jobs from
+ * many threads does not contend on a single lock. Jobs pushed from one of
+ * the pool threads are queued on that thread, other jobs are distributed
+ * over the threads. Idle threads steal jobs from the queues of busy ones.
+ *
+ * Optionally the threads can be pinned to the CPUs the process may run on,
+ * in which case jobs pushed from outside the pool are queued on the thread
+ * of the CPU the caller runs on.
+ *
+ * Like for #GstSharedTaskPool, jobs that wait for other jobs of the same
+ * pool can deadlock and must be avoided.
+ *
+ * Since: 1.20
+ */
+
+typedef struct _WorkStealingWorker WorkStealingWorker;
+
+typedef struct
+{
+  GstTaskPoolFunction func;
+  gpointer user_data;
+  gint done;
+  gint refcount;
+} WorkStealingTaskData;
+
+struct _WorkStealingWorker
+{
+  GstWorkStealingTaskPool *pool;
+  guint index;
+  gint cpu;
+  GThread *thread;
+
+  /* jobs are run in the order they were queued, by this worker or by a
+   * thief, which keeps jobs that reschedule themselves fair to each other */
+  GMutex lock;
+  GQueue jobs;
+  gint n_jobs;
+};
+
+struct _GstWorkStealingTaskPoolPrivate
+{
+  guint n_threads;
+  gboolean pin_threads;
+
+  WorkStealingWorker *workers;
+  guint n_workers;
+  /* worker for each CPU when the workers are pinned */
+  gint *cpu_workers;
+  guint n_cpu_workers;
+  gint next_worker;
+
+  gint n_pending;               /* jobs queued on all workers */
+  gint n_sleeping;              /* workers waiting for jobs */
+  gint n_joining;               /* threads waiting for a job to finish */
+  gboolean shutdown;
+
+  GMutex sleep_lock;
+  GCond sleep_cond;
+  GCond done_cond;
+};
+
+#define GST_WORK_STEALING_TASK_POOL_CAST(pool) ((GstWorkStealingTaskPool*)(pool))
+
+G_DEFINE_TYPE_WITH_PRIVATE (GstWorkStealingTaskPool,
+    gst_work_stealing_task_pool, GST_TYPE_TASK_POOL);
+
+/* the worker of the calling thread, if any */
+static GPrivate current_worker;
+
+static void
+work_stealing_task_data_unref (WorkStealingTaskData * tdata)
+{
+  if (g_atomic_int_dec_and_test (&tdata->refcount))
+    g_slice_free (WorkStealingTaskData, tdata);
+}
+
+static WorkStealingTaskData *
+work_stealing_pop (WorkStealingWorker * worker)
+{
+  WorkStealingTaskData *tdata;
+
+  /* don't take the lock of idle workers */
+  if (g_atomic_int_get (&worker->n_jobs) == 0)
+    return NULL;
+
+  g_mutex_lock (&worker->lock);
+  tdata = g_queue_pop_head (&worker->jobs);
+  if (tdata)
+    g_atomic_int_add (&worker->n_jobs, -1);
+  g_mutex_unlock (&worker->lock);
+
+  return tdata;
+}
+
+static WorkStealingTaskData *
+work_stealing_find_job (WorkStealingWorker * worker)
+{
+  GstWorkStealingTaskPoolPrivate *priv = worker->pool->priv;
+  WorkStealingTaskData *tdata;
+  guint i;
+
+  if ((tdata = work_stealing_pop (worker)))
+    return tdata;
+
+  /* start with our neighbour so thieves don't all go for the same worker */
+  for (i = 1; i < priv->n_workers; i++) {
+    WorkStealingWorker *victim =
+        &priv->workers[(worker->index + i) % priv->n_workers];
+
+    if ((tdata = work_stealing_pop (victim))) {
+      GST_LOG ("worker %u stole a job from worker %u", worker->index,
+          victim->index);
+      return tdata;
+    }
+  }
+
+  return NULL;
+}
+
+static gpointer
+work_stealing_worker_func (WorkStealingWorker * worker)
+{
+  GstWorkStealingTaskPoolPrivate *priv = worker->pool->priv;
+  WorkStealingTaskData *tdata;
+
+  g_private_set (&current_worker, worker);
+
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  if (worker->cpu >= 0) {
+    cpu_set_t set;
+
+    CPU_ZERO (&set);
+    CPU_SET (worker->cpu, &set);
+    if (pthread_setaffinity_np (pthread_self (), sizeof (set), &set) != 0)
+      GST_WARNING ("failed to pin worker %u to CPU %d", worker->index,
+          worker->cpu);
+  }
+#endif
+
+  while (TRUE) {
+    if ((tdata = work_stealing_find_job (worker))) {
+      g_atomic_int_add (&priv->n_pending, -1);
+
+      tdata->func (tdata->user_data);
+
+      g_atomic_int_set (&tdata->done, 1);
+      if (g_atomic_int_get (&priv->n_joining) > 0) {
+        g_mutex_lock (&priv->sleep_lock);
+        g_cond_broadcast (&priv->done_cond);
+        g_mutex_unlock (&priv->sleep_lock);
+      }
+      work_stealing_task_data_unref (tdata);
+      continue;
+    }
+
+    /* a pusher increments n_pending before it checks n_sleeping, so either
+     * we see the new job here or it sees us sleeping and wakes us up */
+    g_mutex_lock (&priv->sleep_lock);
+    g_atomic_int_inc (&priv->n_sleeping);
+    if (g_atomic_int_get (&priv->n_pending) == 0) {
+      if (priv->shutdown) {
+        g_atomic_int_add (&priv->n_sleeping, -1);
+        g_mutex_unlock (&priv->sleep_lock);
+        break;
+      }
+      g_cond_wait (&priv->sleep_cond, &priv->sleep_lock);
+    }
+    g_atomic_int_add (&priv->n_sleeping, -1);
+    g_mutex_unlock (&priv->sleep_lock);
+  }
+
+  g_private_set (&current_worker, NULL);
+
+  return NULL;
+}
+
+static void
+work_stealing_stop_workers (GstWorkStealingTaskPoolPrivate * priv,
+    guint n_started)
+{
+  guint i;
+
+  g_mutex_lock (&priv->sleep_lock);
+  priv->shutdown = TRUE;
+  g_cond_broadcast (&priv->sleep_cond);
+  g_mutex_unlock (&priv->sleep_lock);
+
+  /* the workers run all queued jobs before they exit */
+  for (i = 0; i < n_started; i++)
+    g_thread_join (priv->workers[i].thread);
+
+  for (i = 0; i < priv->n_workers; i++) {
+    g_mutex_clear (&priv->workers[i].lock);
+    g_queue_clear (&priv->workers[i].jobs);
+  }
+  g_free (priv->workers);
+  priv->workers = NULL;
+  priv->n_workers = 0;
+  g_free (priv->cpu_workers);
+  priv->cpu_workers = NULL;
+  priv->n_cpu_workers = 0;
+}
+
+static void
+work_stealing_setup_pinning (GstWorkStealingTaskPoolPrivate * priv)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  cpu_set_t allowed;
+  gint cpus[CPU_SETSIZE];
+  guint i, n_cpus = 0;
+
+  if (sched_getaffinity (0, sizeof (allowed), &allowed) != 0) {
+    GST_WARNING ("could not get the CPU affinity, not pinning threads");
+    return;
+  }
+
+  for (i = 0; i < CPU_SETSIZE; i++) {
+    if (CPU_ISSET (i, &allowed))
+      cpus[n_cpus++] = i;
+  }
+  if (n_cpus == 0)
+    return;
+
+  priv->n_cpu_workers = cpus[n_cpus - 1] + 1;
+  priv->cpu_workers = g_new (gint, priv->n_cpu_workers);
+  for (i = 0; i < priv->n_cpu_workers; i++)
+    priv->cpu_workers[i] = -1;
+
+  /* spread the workers over the allowed CPUs */
+  for (i = 0; i < priv->n_workers; i++) {
+    priv->workers[i].cpu = cpus[i % n_cpus];
+    if (priv->cpu_workers[priv->workers[i].cpu] == -1)
+      priv->cpu_workers[priv->workers[i].cpu] = i;
+  }
+#else
+  GST_WARNING ("pinning threads is not supported on this platform");
+#endif
+}
+
+static void
+work_stealing_prepare (GstTaskPool * pool, GError ** error)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (pool)->priv;
+  guint i, n_workers;
+
+  GST_OBJECT_LOCK (pool);
+  if (priv->workers)
+    goto done;
+
+  n_workers = priv->n_threads ? priv->n_threads : g_get_num_processors ();
+
+  priv->workers = g_new0 (WorkStealingWorker, n_workers);
+  priv->n_workers = n_workers;
+  priv->shutdown = FALSE;
+  for (i = 0; i < n_workers; i++) {
+    WorkStealingWorker *worker = &priv->workers[i];
+
+    worker->pool = GST_WORK_STEALING_TASK_POOL_CAST (pool);
+    worker->index = i;
+    worker->cpu = -1;
+    g_mutex_init (&worker->lock);
+    g_queue_init (&worker->jobs);
+  }
+
+  if (priv->pin_threads)
+    work_stealing_setup_pinning (priv);
+
+  for (i = 0; i < n_workers; i++) {
+    gchar *name = g_strdup_printf ("gstwspool-%u", i);
+
+    priv->workers[i].thread = g_thread_try_new (name,
+        (GThreadFunc) work_stealing_worker_func, &priv->workers[i], error);
+    g_free (name);
+
+    if (priv->workers[i].thread == NULL) {
+      work_stealing_stop_workers (priv, i);
+      break;
+    }
+  }
+
+  GST_DEBUG_OBJECT (pool, "started %u workers", priv->n_workers);
+
+done:
+  GST_OBJECT_UNLOCK (pool);
+}
+
+static void
+work_stealing_cleanup (GstTaskPool * pool)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (pool)->priv;
+
+  GST_OBJECT_LOCK (pool);
+  if (priv->workers)
+    work_stealing_stop_workers (priv, priv->n_workers);
+  GST_OBJECT_UNLOCK (pool);
+}
+
+static gpointer
+work_stealing_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstWorkStealingTaskPool *self = GST_WORK_STEALING_TASK_POOL_CAST (pool);
+  GstWorkStealingTaskPoolPrivate *priv = self->priv;
+  WorkStealingWorker *worker;
+  WorkStealingTaskData *tdata;
+
+  if (G_UNLIKELY (priv->workers == NULL))
+    goto not_prepared;
+
+  worker = g_private_get (&current_worker);
+  if (worker == NULL || worker->pool != self) {
+    gint idx = -1;
+
+#ifdef HAVE_SCHED_GETCPU
+    if (priv->cpu_workers) {
+      gint cpu = sched_getcpu ();
+
+      if (cpu >= 0 && (guint) cpu < priv->n_cpu_workers)
+        idx = priv->cpu_workers[cpu];
+    }
+#endif
+    if (idx < 0)
+      idx = (guint) g_atomic_int_add (&priv->next_worker, 1) %
+          priv->n_workers;
+
+    worker = &priv->workers[idx];
+  }
+
+  tdata = g_slice_new (WorkStealingTaskData);
+  tdata->func = func;
+  tdata->user_data = user_data;
+  tdata->done = 0;
+  /* one for the worker and one for the returned handle */
+  tdata->refcount = 2;
+
+  g_mutex_lock (&worker->lock);
+  g_queue_push_tail (&worker->jobs, tdata);
+  g_atomic_int_inc (&worker->n_jobs);
+  g_mutex_unlock (&worker->lock);
+
+  g_atomic_int_inc (&priv->n_pending);
+  if (g_atomic_int_get (&priv->n_sleeping) > 0) {
+    g_mutex_lock (&priv->sleep_lock);
+    g_cond_signal (&priv->sleep_cond);
+    g_mutex_unlock (&priv->sleep_lock);
+  }
+
+  return tdata;
+
+  /* ERRORS */
+not_prepared:
+  {
+    g_set_error_literal (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
+        "Task pool was not prepared");
+    return NULL;
+  }
+}
+
+static void
+work_stealing_join (GstTaskPool * pool, gpointer id)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (pool)->priv;
+  WorkStealingTaskData *tdata = id;
+
+  if (!tdata)
+    return;
+
+  if (!g_atomic_int_get (&tdata->done)) {
+    g_mutex_lock (&priv->sleep_lock);
+    g_atomic_int_inc (&priv->n_joining);
+    while (!g_atomic_int_get (&tdata->done))
+      g_cond_wait (&priv->done_cond, &priv->sleep_lock);
+    g_atomic_int_add (&priv->n_joining, -1);
+    g_mutex_unlock (&priv->sleep_lock);
+  }
+
+  work_stealing_task_data_unref (tdata);
+}
+
+static void
+work_stealing_dispose_handle (GstTaskPool * pool, gpointer id)
+{
+  if (id)
+    work_stealing_task_data_unref (id);
+}
+
+static void
+gst_work_stealing_task_pool_finalize (GObject * object)
+{
+  GstWorkStealingTaskPoolPrivate *priv =
+      GST_WORK_STEALING_TASK_POOL_CAST (object)->priv;
+
+  if (priv->workers)
+    work_stealing_stop_workers (priv, priv->n_workers);
+
+  g_mutex_clear (&priv->sleep_lock);
+  g_cond_clear (&priv->sleep_cond);
+  g_cond_clear (&priv->done_cond);
+
+  G_OBJECT_CLASS (gst_work_stealing_task_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_work_stealing_task_pool_class_init (GstWorkStealingTaskPoolClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstTaskPoolClass *taskpoolclass = GST_TASK_POOL_CLASS (klass);
+
+  gobject_class->finalize = gst_work_stealing_task_pool_finalize;
+
+  taskpoolclass->prepare = work_stealing_prepare;
+  taskpoolclass->cleanup = work_stealing_cleanup;
+  taskpoolclass->push = work_stealing_push;
+  taskpoolclass->join = work_stealing_join;
+  taskpoolclass->dispose_handle = work_stealing_dispose_handle;
+}
+
+static void
+gst_work_stealing_task_pool_init (GstWorkStealingTaskPool * pool)
+{
+  GstWorkStealingTaskPoolPrivate *priv;
+
+  priv = pool->priv = gst_work_stealing_task_pool_get_instance_private (pool);
+  g_mutex_init (&priv->sleep_lock);
+  g_cond_init (&priv->sleep_cond);
+  g_cond_init (&priv->done_cond);
+}
+
+/**
+ * gst_work_stealing_task_pool_set_pin_threads:
+ * @pool: a #GstWorkStealingTaskPool
+ * @pin_threads: whether to pin the threads to CPUs
+ *
+ * Pin each thread of @pool to one of the CPUs the process is allowed to run
+ * on, and queue jobs pushed from outside of the pool on the thread of the
+ * CPU the caller runs on. This takes effect the next time @pool is
+ * prepared and is not supported on all platforms.
+ *
+ * Since: 1.20
+ */
+void
+gst_work_stealing_task_pool_set_pin_threads (GstWorkStealingTaskPool * pool,
+    gboolean pin_threads)
+{
+  g_return_if_fail (GST_IS_WORK_STEALING_TASK_POOL (pool));
+
+  GST_OBJECT_LOCK (pool);
+  pool->priv->pin_threads = pin_threads;
+  GST_OBJECT_UNLOCK (pool);
+}
+
+/**
+ * gst_work_stealing_task_pool_get_pin_threads:
+ * @pool: a #GstWorkStealingTaskPool
+ *
+ * Returns: whether the threads of @pool are pinned to CPUs
+ * Since: 1.20
+ */
+gboolean
+gst_work_stealing_task_pool_get_pin_threads (GstWorkStealingTaskPool * pool)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_WORK_STEALING_TASK_POOL (pool), FALSE);
+
+  GST_OBJECT_LOCK (pool);
+  ret = pool->priv->pin_threads;
+  GST_OBJECT_UNLOCK (pool);
+
+  return ret;
+}
+
+/**
+ * gst_work_stealing_task_pool_get_n_threads:
+ * @pool: a #GstWorkStealingTaskPool
+ *
+ * Returns: the number of threads @pool runs when it is prepared
+ * Since: 1.20
+ */
+guint
+gst_work_stealing_task_pool_get_n_threads (GstWorkStealingTaskPool * pool)
+{
+  guint ret;
+
+  g_return_val_if_fail (GST_IS_WORK_STEALING_TASK_POOL (pool), 0);
+
+  GST_OBJECT_LOCK (pool);
+  ret = pool->priv->n_threads ? pool->priv->n_threads :
+      g_get_num_processors ();
+  GST_OBJECT_UNLOCK (pool);
+
+  return ret;
+}
+
+/**
+ * gst_work_stealing_task_pool_new:
+ * @n_threads: the number of threads, or 0 for one per CPU
+ *
+ * Create a new work stealing task pool that runs jobs on @n_threads
+ * threads.
+ *
+ * Returns: (transfer full): a new #GstWorkStealingTaskPool. gst_object_unref()
+ * after usage.
+ * Since: 1.20
+ */
+GstTaskPool *
+gst_work_stealing_task_pool_new (guint n_threads)
+{
+  GstWorkStealingTaskPool *pool;
+
+  pool = g_object_new (GST_TYPE_WORK_STEALING_TASK_POOL, NULL);
+  pool->priv->n_threads = n_threads;
+
+  /* clear floating flag */
+  gst_object_ref_sink (pool);
+
+  return GST_TASK_POOL_CAST (pool);
+}
@@ -200,8 +200,11 @@ gst_toc_merge_tags (GstToc * toc, GstTagList * tags, GstTagMergeMode mode)
 
   if (!toc->tags) {
     toc->tags = gst_tag_list_ref (tags);
+  } else if (tags) {
+    toc->tags = gst_tag_list_make_writable (toc->tags);
+    gst_tag_list_insert (toc->tags, tags, mode);
   } else {
-    GstTagList *tmp = gst_tag_list_merge (toc->tags, tags, mode);
+    GstTagList *tmp = gst_tag_list_merge (toc->tags, NULL, mode);
     gst_tag_list_unref (toc->tags);
     toc->tags = tmp;
   }
@@ -740,8 +743,11 @@ gst_toc_entry_merge_tags (GstTocEntry * entry, GstTagList * tags,
 
   if (!entry->tags) {
     entry->tags = gst_tag_list_ref (tags);
+  } else if (tags) {
+    entry->tags = gst_tag_list_make_writable (entry->tags);
+    gst_tag_list_insert (entry->tags, tags, mode);
   } else {
-    GstTagList *tmp = gst_tag_list_merge (entry->tags, tags, mode);
+    GstTagList *tmp = gst_tag_list_merge (entry->tags, NULL, mode);
     gst_tag_list_unref (entry->tags);
     entry->tags = tmp;
   }
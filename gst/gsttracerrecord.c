@@ -27,6 +27,12 @@
  * Tracing modules will create instances of this class to announce the data they
  * will log and create a log formatter.
  *
+ * If the GST_TRACER_RECORD_FILE environment variable is set, the records are
+ * not formatted as text into the debug log but written in a binary format to
+ * the given file. The values are then only copied into a ring buffer of the
+ * logging thread and a background thread writes them out, which makes
+ * tracing much cheaper. gst-stats reads both formats.
+ *
  * Since: 1.8
  */
 
@@ -37,16 +43,50 @@
 #include "gsttracerrecord.h"
 #include "gstvalue.h"
 #include <gobject/gvaluecollector.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
 
 GST_DEBUG_CATEGORY_EXTERN (tracer_debug);
 #define GST_CAT_DEFAULT tracer_debug
 
+/* How the values of a field are stored in the binary format */
+typedef enum
+{
+  FIELD_INT32,
+  FIELD_UINT32,
+  FIELD_INT64,
+  FIELD_UINT64,
+  FIELD_BOOLEAN,
+  FIELD_DOUBLE,
+  FIELD_POINTER,
+  FIELD_ENUM,
+  FIELD_FLAGS,
+  FIELD_STRING,
+  /* anything else, as string serialized with gst_value_serialize() */
+  FIELD_SERIALIZED
+} GstTracerRecordFieldKind;
+
+typedef struct
+{
+  GQuark name;
+  GType type;
+  GstTracerRecordFieldKind kind;
+} GstTracerRecordField;
+
 struct _GstTracerRecord
 {
   GstObject parent;
 
   GstStructure *spec;
   gchar *format;
+
+  /* the values in the order they are passed to gst_tracer_record_log(),
+   * including the booleans of optional values */
+  GArray *fields;
+  /* id in the binary log, 0 if not written there */
+  guint32 binary_id;
 };
 
 struct _GstTracerRecordClass
@@ -95,6 +135,74 @@ build_field_template (GQuark field_id, const GValue * value, gpointer user_data)
   return res;
 }
 
+static gboolean
+build_field_plan (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  GArray *fields = user_data;
+  GstTracerRecordField field;
+  GstTracerValueFlags flags = GST_TRACER_VALUE_FLAGS_NONE;
+  GType type = G_TYPE_INVALID;
+
+  gst_structure_get (gst_value_get_structure (value), "type", G_TYPE_GTYPE,
+      &type, "flags", GST_TYPE_TRACER_VALUE_FLAGS, &flags, NULL);
+
+  if (flags & GST_TRACER_VALUE_FLAGS_OPTIONAL) {
+    gchar *opt_name = g_strconcat ("have-", g_quark_to_string (field_id), NULL);
+
+    field.name = g_quark_from_string (opt_name);
+    field.type = G_TYPE_BOOLEAN;
+    field.kind = FIELD_BOOLEAN;
+    g_array_append_val (fields, field);
+    g_free (opt_name);
+  }
+
+  field.name = field_id;
+  field.type = type;
+  switch (G_TYPE_FUNDAMENTAL (type)) {
+    case G_TYPE_CHAR:
+    case G_TYPE_INT:
+      field.kind = FIELD_INT32;
+      break;
+    case G_TYPE_UCHAR:
+    case G_TYPE_UINT:
+      field.kind = FIELD_UINT32;
+      break;
+    case G_TYPE_LONG:
+    case G_TYPE_INT64:
+      field.kind = FIELD_INT64;
+      break;
+    case G_TYPE_ULONG:
+    case G_TYPE_UINT64:
+      field.kind = FIELD_UINT64;
+      break;
+    case G_TYPE_BOOLEAN:
+      field.kind = FIELD_BOOLEAN;
+      break;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      field.kind = FIELD_DOUBLE;
+      break;
+    case G_TYPE_POINTER:
+      field.kind = FIELD_POINTER;
+      break;
+    case G_TYPE_ENUM:
+      field.kind = FIELD_ENUM;
+      break;
+    case G_TYPE_FLAGS:
+      field.kind = FIELD_FLAGS;
+      break;
+    case G_TYPE_STRING:
+      field.kind = FIELD_STRING;
+      break;
+    default:
+      field.kind = FIELD_SERIALIZED;
+      break;
+  }
+  g_array_append_val (fields, field);
+
+  return TRUE;
+}
+
 static void
 gst_tracer_record_build_format (GstTracerRecord * self)
 {
@@ -122,6 +230,9 @@ gst_tracer_record_build_format (GstTracerRecord * self)
   self->format = g_string_free (s, FALSE);
   GST_DEBUG ("new format string: %s", self->format);
   g_free (name);
+
+  self->fields = g_array_new (FALSE, FALSE, sizeof (GstTracerRecordField));
+  gst_structure_foreach (structure, build_field_plan, self->fields);
 }
 
 static void
@@ -135,6 +246,10 @@ gst_tracer_record_dispose (GObject * object)
   }
   g_free (self->format);
   self->format = NULL;
+  if (self->fields) {
+    g_array_free (self->fields, TRUE);
+    self->fields = NULL;
+  }
 }
 
 static void
@@ -150,6 +265,391 @@ gst_tracer_record_init (GstTracerRecord * self)
 {
 }
 
+#ifndef GST_DISABLE_GST_DEBUG
+/* Binary record log
+ *
+ * The file starts with the 8 bytes "GSTTRACE", a 32 bit version and the 32
+ * bit value 0x01020304 for detecting the byte order, which is the one of the
+ * writer. Then follow frames consisting of a type byte, a 32 bit payload size
+ * and the payload:
+ *
+ * - BINARY_FRAME_SCHEMA: the 32 bit record id, the name, the number of
+ *   values and for each value its name, its GstTracerRecordFieldKind as a
+ *   byte and its type name
+ * - BINARY_FRAME_ENTRY: the 32 bit record id followed by the values
+ * - BINARY_FRAME_DROPPED: 32 bit number of entries that were dropped
+ *
+ * Strings are stored as 32 bit length followed by the characters, with
+ * a length of G_MAXUINT32 for %NULL. Enums and flags take 32 bits, pointers
+ * 64 bits.
+ *
+ * Every logging thread writes the entries into its own ring buffer, without
+ * any locking, and entries are dropped if it is full. A background thread
+ * writes them to the file regularly. Schemas are written directly to the
+ * file when the record is created, so they always come before its entries.
+ */
+#define BINARY_MAGIC "GSTTRACE"
+#define BINARY_VERSION 1
+#define BINARY_BYTE_ORDER 0x01020304
+
+#define BINARY_FRAME_SCHEMA 1
+#define BINARY_FRAME_ENTRY 2
+#define BINARY_FRAME_DROPPED 3
+
+#define BINARY_RING_SIZE (256 * 1024)
+#define BINARY_MAX_ENTRY_SIZE 4096
+#define BINARY_DRAIN_INTERVAL (50 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct _BinaryRing BinaryRing;
+
+struct _BinaryRing
+{
+  BinaryRing *next;
+  guint8 *data;
+  /* positions modulo 2^32, head is only written by the owning thread and
+   * tail only by the drain thread */
+  gint head;
+  gint tail;
+  gint dropped;
+  /* the owning thread exited */
+  gint dead;
+};
+
+static GMutex binary_lock;
+static GCond binary_cond;
+static FILE *binary_file;
+static gboolean binary_active = FALSE;
+static gboolean binary_running;
+static guint32 binary_next_id = 1;
+static GThread *binary_thread;
+/* with binary_lock */
+static BinaryRing *binary_rings;
+
+static void
+binary_ring_thread_exit (BinaryRing * ring)
+{
+  g_atomic_int_set (&ring->dead, TRUE);
+}
+
+static GPrivate binary_current_ring = G_PRIVATE_INIT ((GDestroyNotify)
+    binary_ring_thread_exit);
+
+/* with binary_lock */
+static void
+binary_write_frame (guint8 type, const guint8 * payload, guint32 size)
+{
+  fwrite (&type, 1, 1, binary_file);
+  fwrite (&size, sizeof (size), 1, binary_file);
+  fwrite (payload, 1, size, binary_file);
+}
+
+/* with binary_lock */
+static void
+binary_drain (void)
+{
+  BinaryRing *ring, **prev = &binary_rings;
+
+  while ((ring = *prev)) {
+    gboolean dead = g_atomic_int_get (&ring->dead);
+    guint head = (guint) g_atomic_int_get (&ring->head);
+    guint tail = (guint) ring->tail;
+    gint dropped;
+
+    while (tail != head) {
+      guint offset = tail % BINARY_RING_SIZE;
+      guint len = MIN (head - tail, BINARY_RING_SIZE - offset);
+
+      fwrite (ring->data + offset, 1, len, binary_file);
+      tail += len;
+    }
+    g_atomic_int_set (&ring->tail, tail);
+
+    do {
+      dropped = g_atomic_int_get (&ring->dropped);
+    } while (dropped > 0
+        && !g_atomic_int_compare_and_exchange (&ring->dropped, dropped, 0));
+    if (dropped > 0) {
+      guint32 n = dropped;
+
+      binary_write_frame (BINARY_FRAME_DROPPED, (guint8 *) & n, sizeof (n));
+    }
+
+    if (dead) {
+      *prev = ring->next;
+      g_free (ring->data);
+      g_free (ring);
+    } else {
+      prev = &ring->next;
+    }
+  }
+  fflush (binary_file);
+}
+
+static gpointer
+binary_drain_thread (gpointer data)
+{
+  g_mutex_lock (&binary_lock);
+  while (binary_running) {
+    gint64 end_time = g_get_monotonic_time () + BINARY_DRAIN_INTERVAL;
+
+    while (binary_running && g_cond_wait_until (&binary_cond, &binary_lock,
+            end_time));
+    binary_drain ();
+  }
+  g_mutex_unlock (&binary_lock);
+
+  return NULL;
+}
+
+static void
+binary_init (void)
+{
+  static gsize initted = 0;
+  const gchar *filename;
+  guint32 header[2] = { BINARY_VERSION, BINARY_BYTE_ORDER };
+
+  if (!g_once_init_enter (&initted))
+    return;
+
+  filename = g_getenv ("GST_TRACER_RECORD_FILE");
+  if (filename && *filename) {
+    if ((binary_file = g_fopen (filename, "wb"))) {
+      fwrite (BINARY_MAGIC, 1, 8, binary_file);
+      fwrite (header, sizeof (header), 1, binary_file);
+      binary_running = TRUE;
+      binary_thread = g_thread_new ("GstTracerRecord", binary_drain_thread,
+          NULL);
+      g_atomic_int_set (&binary_active, TRUE);
+      GST_INFO ("writing binary tracer records to %s", filename);
+    } else {
+      g_printerr ("Could not open tracer record file '%s': %s\n", filename,
+          g_strerror (errno));
+    }
+  }
+
+  g_once_init_leave (&initted, 1);
+}
+
+static void
+binary_put_string (GByteArray * arr, const gchar * str)
+{
+  guint32 len = str ? strlen (str) : G_MAXUINT32;
+
+  g_byte_array_append (arr, (guint8 *) & len, sizeof (len));
+  if (str)
+    g_byte_array_append (arr, (const guint8 *) str, len);
+}
+
+static void
+binary_register (GstTracerRecord * self)
+{
+  GByteArray *arr = g_byte_array_new ();
+  const gchar *name = g_quark_to_string (self->spec->name);
+  gchar *short_name = g_strndup (name, strlen (name) - strlen (".class"));
+  guint32 n_fields = self->fields->len;
+  guint i;
+
+  g_mutex_lock (&binary_lock);
+  self->binary_id = binary_next_id++;
+
+  g_byte_array_append (arr, (guint8 *) & self->binary_id, sizeof (guint32));
+  binary_put_string (arr, short_name);
+  g_byte_array_append (arr, (guint8 *) & n_fields, sizeof (n_fields));
+  for (i = 0; i < n_fields; i++) {
+    GstTracerRecordField *field =
+        &g_array_index (self->fields, GstTracerRecordField, i);
+    guint8 kind = field->kind;
+
+    binary_put_string (arr, g_quark_to_string (field->name));
+    g_byte_array_append (arr, &kind, 1);
+    binary_put_string (arr, g_type_name (field->type));
+  }
+
+  binary_write_frame (BINARY_FRAME_SCHEMA, arr->data, arr->len);
+  g_mutex_unlock (&binary_lock);
+
+  g_byte_array_unref (arr);
+  g_free (short_name);
+}
+
+static BinaryRing *
+binary_get_ring (void)
+{
+  BinaryRing *ring = g_private_get (&binary_current_ring);
+
+  if (G_UNLIKELY (ring == NULL)) {
+    ring = g_new0 (BinaryRing, 1);
+    ring->data = g_malloc (BINARY_RING_SIZE);
+    g_mutex_lock (&binary_lock);
+    ring->next = binary_rings;
+    binary_rings = ring;
+    g_mutex_unlock (&binary_lock);
+    g_private_set (&binary_current_ring, ring);
+  }
+
+  return ring;
+}
+
+#define BINARY_PUT(type, val) G_STMT_START {            \
+  type _v = (val);                                      \
+  if (G_UNLIKELY (pos + sizeof (_v) > end))             \
+    goto too_big;                                       \
+  memcpy (pos, &_v, sizeof (_v));                       \
+  pos += sizeof (_v);                                   \
+} G_STMT_END
+
+#define BINARY_PUT_STRING(str) G_STMT_START {           \
+  const gchar *_s = (str);                              \
+  guint32 _len = _s ? strlen (_s) : G_MAXUINT32;        \
+  BINARY_PUT (guint32, _len);                           \
+  if (_s) {                                             \
+    if (G_UNLIKELY (pos + _len > end))                  \
+      goto too_big;                                     \
+    memcpy (pos, _s, _len);                             \
+    pos += _len;                                        \
+  }                                                     \
+} G_STMT_END
+
+static void
+binary_log_valist (GstTracerRecord * self, va_list var_args)
+{
+  guint8 entry[BINARY_MAX_ENTRY_SIZE];
+  guint8 *pos, *end = entry + sizeof (entry);
+  BinaryRing *ring;
+  guint32 size;
+  guint head, tail, i, len;
+
+  /* frame header: type, payload size and the record id */
+  pos = entry + 5;
+  BINARY_PUT (guint32, self->binary_id);
+
+  for (i = 0; i < self->fields->len; i++) {
+    GstTracerRecordField *field =
+        &g_array_index (self->fields, GstTracerRecordField, i);
+
+    switch (field->kind) {
+      case FIELD_INT32:
+        BINARY_PUT (gint32, va_arg (var_args, gint));
+        break;
+      case FIELD_UINT32:
+        BINARY_PUT (guint32, va_arg (var_args, guint));
+        break;
+      case FIELD_INT64:
+        if (G_TYPE_FUNDAMENTAL (field->type) == G_TYPE_LONG)
+          BINARY_PUT (gint64, va_arg (var_args, glong));
+        else
+          BINARY_PUT (gint64, va_arg (var_args, gint64));
+        break;
+      case FIELD_UINT64:
+        if (G_TYPE_FUNDAMENTAL (field->type) == G_TYPE_ULONG)
+          BINARY_PUT (guint64, va_arg (var_args, gulong));
+        else
+          BINARY_PUT (guint64, va_arg (var_args, guint64));
+        break;
+      case FIELD_BOOLEAN:
+        BINARY_PUT (guint8, va_arg (var_args, gboolean) ? 1 : 0);
+        break;
+      case FIELD_DOUBLE:
+        BINARY_PUT (gdouble, va_arg (var_args, gdouble));
+        break;
+      case FIELD_POINTER:
+        BINARY_PUT (guint64, (guintptr) va_arg (var_args, gpointer));
+        break;
+      case FIELD_ENUM:
+        BINARY_PUT (gint32, va_arg (var_args, gint));
+        break;
+      case FIELD_FLAGS:
+        BINARY_PUT (guint32, va_arg (var_args, guint));
+        break;
+      case FIELD_STRING:
+        BINARY_PUT_STRING (va_arg (var_args, const gchar *));
+        break;
+      case FIELD_SERIALIZED:{
+        GValue value = G_VALUE_INIT;
+        gchar *err = NULL, *str;
+
+        G_VALUE_COLLECT_INIT (&value, field->type, var_args,
+            G_VALUE_NOCOPY_CONTENTS, &err);
+        if (G_UNLIKELY (err)) {
+          g_critical ("%s", err);
+          g_free (err);
+          return;
+        }
+        str = gst_value_serialize (&value);
+        g_value_unset (&value);
+        if (G_UNLIKELY (str && pos + 4 + strlen (str) > end)) {
+          g_free (str);
+          goto too_big;
+        }
+        BINARY_PUT_STRING (str);
+        g_free (str);
+        break;
+      }
+    }
+  }
+
+  entry[0] = BINARY_FRAME_ENTRY;
+  size = pos - entry - 5;
+  memcpy (entry + 1, &size, sizeof (size));
+  len = pos - entry;
+
+  ring = binary_get_ring ();
+  head = (guint) ring->head;
+  tail = (guint) g_atomic_int_get (&ring->tail);
+  if (G_UNLIKELY (BINARY_RING_SIZE - (head - tail) < len)) {
+    g_atomic_int_inc (&ring->dropped);
+    return;
+  }
+
+  for (i = 0; i < len;) {
+    guint offset = (head + i) % BINARY_RING_SIZE;
+    guint n = MIN (len - i, BINARY_RING_SIZE - offset);
+
+    memcpy (ring->data + offset, entry + i, n);
+    i += n;
+  }
+  /* publishes the data to the drain thread */
+  g_atomic_int_set (&ring->head, head + len);
+  return;
+
+too_big:
+  {
+    GST_WARNING ("dropping oversized %s entry",
+        g_quark_to_string (self->spec->name));
+    g_atomic_int_inc (&binary_get_ring ()->dropped);
+  }
+}
+
+#undef BINARY_PUT
+#undef BINARY_PUT_STRING
+#endif
+
+void
+_priv_gst_tracer_record_cleanup (void)
+{
+#ifndef GST_DISABLE_GST_DEBUG
+  if (!binary_thread)
+    return;
+
+  g_atomic_int_set (&binary_active, FALSE);
+
+  g_mutex_lock (&binary_lock);
+  binary_running = FALSE;
+  g_cond_signal (&binary_cond);
+  g_mutex_unlock (&binary_lock);
+  g_thread_join (binary_thread);
+  binary_thread = NULL;
+
+  /* rings of threads that are still running are not freed, they could still
+   * be in use */
+  g_mutex_lock (&binary_lock);
+  binary_drain ();
+  fclose (binary_file);
+  binary_file = NULL;
+  g_mutex_unlock (&binary_lock);
+#endif
+}
+
 /**
  * gst_tracer_record_new:
  * @name: name of new record, must end on ".class".
@@ -233,6 +733,12 @@ gst_tracer_record_new (const gchar * name, const gchar * firstfield, ...)
   self->spec = structure;
   gst_tracer_record_build_format (self);
 
+#ifndef GST_DISABLE_GST_DEBUG
+  binary_init ();
+  if (self->fields && g_atomic_int_get (&binary_active))
+    binary_register (self);
+#endif
+
   return self;
 }
 
@@ -245,7 +751,9 @@ gst_tracer_record_new (const gchar * name, const gchar * firstfield, ...)
  * Serialzes the trace event into the log.
  *
  * Right now this is using the gstreamer debug log with the level TRACE (7) and
- * the category "GST_TRACER".
+ * the category "GST_TRACER". If the `GST_TRACER_RECORD_FILE` environment
+ * variable is set, the trace event is written to that file in a binary format
+ * instead.
  *
  * > Please note that this is still under discussion and subject to change.
  *
@@ -269,7 +777,9 @@ gst_tracer_record_log (GstTracerRecord * self, ...)
    */
 
   va_start (var_args, self);
-  if (G_LIKELY (GST_LEVEL_TRACE <= _gst_debug_min)) {
+  if (self->binary_id && g_atomic_int_get (&binary_active)) {
+    binary_log_valist (self, var_args);
+  } else if (G_LIKELY (GST_LEVEL_TRACE <= _gst_debug_min)) {
     gst_debug_log_valist (GST_CAT_DEFAULT, GST_LEVEL_TRACE, "", "", 0, NULL,
         self->format, var_args);
   }
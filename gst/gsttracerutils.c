@@ -29,6 +29,11 @@
  *
  * Note that instantiating tracers at runtime is possible but is not thread safe
  * and needs to be done before any pipeline state is set to PAUSED.
+ *
+ * For dispatching, the hooks are compiled into one flat array per hook id in
+ * _priv_tracer_hooks, which is replaced atomically when a hook is registered.
+ * The hooks can thus be dispatched without any lookup while tracers are
+ * added.
  */
 
 #include "gst_private.h"
@@ -54,7 +59,10 @@ static const gchar *_quark_strings[] = {
   "element-change-state-pre", "element-change-state-post",
   "mini-object-created", "mini-object-destroyed", "object-created",
   "object-destroyed", "mini-object-reffed", "mini-object-unreffed",
-  "object-reffed", "object-unreffed", "plugin-feature-loaded"
+  "object-reffed", "object-unreffed", "plugin-feature-loaded",
+  "memory-numa-access", "memory-alloc", "memory-free", "buffer-pool-acquire",
+  "buffer-pool-release", "struct-alloc", "struct-free", "lock-acquired",
+  "lock-released"
 };
 
 GQuark _priv_gst_tracer_quark_table[GST_TRACER_QUARK_MAX];
@@ -63,6 +71,11 @@ GQuark _priv_gst_tracer_quark_table[GST_TRACER_QUARK_MAX];
 
 gboolean _priv_tracer_enabled = FALSE;
 GHashTable *_priv_tracers = NULL;
+GstTracerHook *_priv_tracer_hooks[GST_TRACER_QUARK_MAX];
+
+/* replaced hook arrays, hooks might still be dispatched from them so they
+ * are only freed in _priv_gst_tracing_deinit() */
+static GSList *old_tracer_hooks = NULL;
 
 /* Initialize the tracing system */
 void
@@ -142,11 +155,19 @@ _priv_gst_tracing_deinit (void)
 {
   GList *h_list, *h_node, *t_node;
   GstTracerHook *hook;
+  gint i;
 
   _priv_tracer_enabled = FALSE;
   if (!_priv_tracers)
     return;
 
+  for (i = 0; i < GST_TRACER_QUARK_MAX; i++) {
+    g_free (_priv_tracer_hooks[i]);
+    _priv_tracer_hooks[i] = NULL;
+  }
+  g_slist_free_full (old_tracer_hooks, g_free);
+  old_tracer_hooks = NULL;
+
   /* shutdown tracers for final reports */
   h_list = g_hash_table_get_values (_priv_tracers);
   for (h_node = h_list; h_node; h_node = g_list_next (h_node)) {
@@ -162,12 +183,40 @@ _priv_gst_tracing_deinit (void)
   _priv_tracers = NULL;
 }
 
+/* Compile the hook lists from _priv_tracers into the array dispatched for
+ * @id, the hooks for this detail followed by the ones for all details */
+static void
+gst_tracing_update_hooks (gint id)
+{
+  GList *detailed, *all, *l;
+  GstTracerHook *hooks, *old;
+  guint n = 0;
+
+  detailed = g_hash_table_lookup (_priv_tracers,
+      GINT_TO_POINTER (_priv_gst_tracer_quark_table[id]));
+  all = g_hash_table_lookup (_priv_tracers, NULL);
+
+  hooks = g_new0 (GstTracerHook, g_list_length (detailed) +
+      g_list_length (all) + 1);
+  for (l = detailed; l; l = l->next)
+    hooks[n++] = *(GstTracerHook *) l->data;
+  for (l = all; l; l = l->next)
+    hooks[n++] = *(GstTracerHook *) l->data;
+
+  old = g_atomic_pointer_get (&_priv_tracer_hooks[id]);
+  g_atomic_pointer_set (&_priv_tracer_hooks[id], hooks);
+  if (old)
+    old_tracer_hooks = g_slist_prepend (old_tracer_hooks, old);
+}
+
 static void
 gst_tracing_register_hook_id (GstTracer * tracer, GQuark detail, GCallback func)
 {
   gpointer key = GINT_TO_POINTER (detail);
   GList *list = g_hash_table_lookup (_priv_tracers, key);
   GstTracerHook *hook = g_slice_new0 (GstTracerHook);
+  gint i;
+
   hook->tracer = gst_object_ref (tracer);
   hook->func = func;
 
@@ -175,6 +224,11 @@ gst_tracing_register_hook_id (GstTracer * tracer, GQuark detail, GCallback func)
   g_hash_table_replace (_priv_tracers, key, list);
   GST_DEBUG ("registering tracer for '%s', list.len=%d",
       (detail ? g_quark_to_string (detail) : "*"), g_list_length (list));
+
+  for (i = 0; i < GST_TRACER_QUARK_MAX; i++) {
+    if (!detail || _priv_gst_tracer_quark_table[i] == detail)
+      gst_tracing_update_hooks (i);
+  }
   _priv_tracer_enabled = TRUE;
 }
 
@@ -234,6 +288,108 @@ gst_tracing_get_active_tracers (void)
   return tracers;
 }
 
+#ifdef GST_ENABLE_LOCK_TRACING
+
+/* The instrumented locks only take timestamps when a tracer is listening.
+ * As the hooks can take locks of the tracers themselves, the released hook
+ * is dispatched after the lock was released. */
+#define LOCK_HOOKED() (GST_TRACER_IS_ENABLED && \
+    g_atomic_pointer_get \
+        (&_priv_tracer_hooks[GST_TRACER_QUARK_HOOK_LOCK_ACQUIRED]))
+
+/* at least 1ns so that a contended lock is never reported as free */
+#define WAIT_SINCE(start) MAX (gst_util_get_timestamp () - (start), 1)
+
+void
+_gst_tracer_mutex_lock (GMutex * mutex, GstObject * object, const gchar * site)
+{
+  GstClockTime start;
+
+  if (G_LIKELY (!LOCK_HOOKED ())) {
+    g_mutex_lock (mutex);
+    return;
+  }
+
+  if (g_mutex_trylock (mutex)) {
+    GST_TRACER_LOCK_ACQUIRED (object, mutex, site, 0);
+    return;
+  }
+
+  start = gst_util_get_timestamp ();
+  g_mutex_lock (mutex);
+  GST_TRACER_LOCK_ACQUIRED (object, mutex, site, WAIT_SINCE (start));
+}
+
+gboolean
+_gst_tracer_mutex_trylock (GMutex * mutex, GstObject * object,
+    const gchar * site)
+{
+  if (!g_mutex_trylock (mutex))
+    return FALSE;
+
+  GST_TRACER_LOCK_ACQUIRED (object, mutex, site, 0);
+  return TRUE;
+}
+
+void
+_gst_tracer_mutex_unlock (GMutex * mutex, GstObject * object)
+{
+  g_mutex_unlock (mutex);
+  GST_TRACER_LOCK_RELEASED (object, mutex);
+}
+
+void
+_gst_tracer_rec_mutex_lock (GRecMutex * mutex, GstObject * object,
+    const gchar * site)
+{
+  GstClockTime start;
+
+  if (G_LIKELY (!LOCK_HOOKED ())) {
+    g_rec_mutex_lock (mutex);
+    return;
+  }
+
+  if (g_rec_mutex_trylock (mutex)) {
+    GST_TRACER_LOCK_ACQUIRED (object, mutex, site, 0);
+    return;
+  }
+
+  start = gst_util_get_timestamp ();
+  g_rec_mutex_lock (mutex);
+  GST_TRACER_LOCK_ACQUIRED (object, mutex, site, WAIT_SINCE (start));
+}
+
+gboolean
+_gst_tracer_rec_mutex_trylock (GRecMutex * mutex, GstObject * object,
+    const gchar * site)
+{
+  if (!g_rec_mutex_trylock (mutex))
+    return FALSE;
+
+  GST_TRACER_LOCK_ACQUIRED (object, mutex, site, 0);
+  return TRUE;
+}
+
+void
+_gst_tracer_rec_mutex_unlock (GRecMutex * mutex, GstObject * object)
+{
+  g_rec_mutex_unlock (mutex);
+  GST_TRACER_LOCK_RELEASED (object, mutex);
+}
+
+/* the time spent waiting for the condition does not count as holding the
+ * lock, and getting it back is not contention */
+void
+_gst_tracer_cond_wait (GCond * cond, GMutex * mutex, GstObject * object,
+    const gchar * site)
+{
+  GST_TRACER_LOCK_RELEASED (object, mutex);
+  g_cond_wait (cond, mutex);
+  GST_TRACER_LOCK_ACQUIRED (object, mutex, site, 0);
+}
+
+#endif /* GST_ENABLE_LOCK_TRACING */
+
 #else /* !GST_DISABLE_GST_TRACER_HOOKS */
 
 void
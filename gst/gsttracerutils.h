@@ -80,6 +80,15 @@ typedef enum /*< skip >*/
   GST_TRACER_QUARK_HOOK_OBJECT_REFFED,
   GST_TRACER_QUARK_HOOK_OBJECT_UNREFFED,
   GST_TRACER_QUARK_HOOK_PLUGIN_FEATURE_LOADED,
+  GST_TRACER_QUARK_HOOK_MEMORY_NUMA_ACCESS,
+  GST_TRACER_QUARK_HOOK_MEMORY_ALLOC,
+  GST_TRACER_QUARK_HOOK_MEMORY_FREE,
+  GST_TRACER_QUARK_HOOK_BUFFER_POOL_ACQUIRE,
+  GST_TRACER_QUARK_HOOK_BUFFER_POOL_RELEASE,
+  GST_TRACER_QUARK_HOOK_STRUCT_ALLOC,
+  GST_TRACER_QUARK_HOOK_STRUCT_FREE,
+  GST_TRACER_QUARK_HOOK_LOCK_ACQUIRED,
+  GST_TRACER_QUARK_HOOK_LOCK_RELEASED,
   GST_TRACER_QUARK_MAX
 } GstTracerQuarkId;
 
@@ -97,6 +106,11 @@ typedef struct {
 extern gboolean _priv_tracer_enabled;
 /* key are hook-id quarks, values are GstTracerHook */
 extern GHashTable *_priv_tracers;
+/* for each GstTracerQuarkId, the hooks to call as an array terminated by a
+ * hook without func, or NULL. Built from _priv_tracers when tracers are
+ * registered and replaced atomically, including the hooks registered for
+ * all details. */
+extern GstTracerHook *_priv_tracer_hooks[GST_TRACER_QUARK_MAX];
 
 #define GST_TRACER_IS_ENABLED (_priv_tracer_enabled)
 
@@ -106,20 +120,13 @@ extern GHashTable *_priv_tracers;
 /* tracing hooks */
 
 #define GST_TRACER_ARGS h->tracer, ts
-#define GST_TRACER_DISPATCH(key,type,args) G_STMT_START{ \
+#define GST_TRACER_DISPATCH(id,type,args) G_STMT_START{ \
   if (GST_TRACER_IS_ENABLED) {                                         \
-    GstClockTime ts = GST_TRACER_TS;                                   \
-    GList *__l, *__n;                                                  \
-    GstTracerHook *h;                                                  \
-    __l = g_hash_table_lookup (_priv_tracers, GINT_TO_POINTER (key));  \
-    for (__n = __l; __n; __n = g_list_next (__n)) {                    \
-      h = (GstTracerHook *) __n->data;                                 \
-      ((type)(h->func)) args;                                          \
-    }                                                                  \
-    __l = g_hash_table_lookup (_priv_tracers, NULL);                   \
-    for (__n = __l; __n; __n = g_list_next (__n)) {                    \
-      h = (GstTracerHook *) __n->data;                                 \
-      ((type)(h->func)) args;                                          \
+    GstTracerHook *h = g_atomic_pointer_get (&_priv_tracer_hooks[id]); \
+    if (h) {                                                           \
+      GstClockTime ts = GST_TRACER_TS;                                 \
+      for (; h->func; h++)                                             \
+        ((type)(h->func)) args;                                        \
     }                                                                  \
   }                                                                    \
 }G_STMT_END
@@ -136,7 +143,7 @@ extern GHashTable *_priv_tracers;
 typedef void (*GstTracerHookPadPushPre) (GObject *self, GstClockTime ts,
     GstPad *pad, GstBuffer *buffer);
 #define GST_TRACER_PAD_PUSH_PRE(pad, buffer) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_PRE, \
     GstTracerHookPadPushPre, (GST_TRACER_ARGS, pad, buffer)); \
 }G_STMT_END
 
@@ -152,7 +159,7 @@ typedef void (*GstTracerHookPadPushPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadPushPost) (GObject * self, GstClockTime ts,
     GstPad *pad, GstFlowReturn res);
 #define GST_TRACER_PAD_PUSH_POST(pad, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_POST, \
     GstTracerHookPadPushPost, (GST_TRACER_ARGS, pad, res)); \
 }G_STMT_END
 
@@ -168,7 +175,7 @@ typedef void (*GstTracerHookPadPushPost) (GObject * self, GstClockTime ts,
 typedef void (*GstTracerHookPadPushListPre) (GObject *self, GstClockTime ts,
     GstPad *pad, GstBufferList *list);
 #define GST_TRACER_PAD_PUSH_LIST_PRE(pad, list) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_LIST_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_LIST_PRE, \
     GstTracerHookPadPushListPre, (GST_TRACER_ARGS, pad, list)); \
 }G_STMT_END
 
@@ -185,7 +192,7 @@ typedef void (*GstTracerHookPadPushListPost) (GObject *self, GstClockTime ts,
     GstPad *pad,
     GstFlowReturn res);
 #define GST_TRACER_PAD_PUSH_LIST_POST(pad, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_LIST_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_LIST_POST, \
     GstTracerHookPadPushListPost, (GST_TRACER_ARGS, pad, res)); \
 }G_STMT_END
 
@@ -202,7 +209,7 @@ typedef void (*GstTracerHookPadPushListPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadPullRangePre) (GObject *self, GstClockTime ts,
     GstPad *pad, guint64 offset, guint size);
 #define GST_TRACER_PAD_PULL_RANGE_PRE(pad, offset, size) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PULL_RANGE_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PULL_RANGE_PRE, \
     GstTracerHookPadPullRangePre, (GST_TRACER_ARGS, pad, offset, size)); \
 }G_STMT_END
 
@@ -219,7 +226,7 @@ typedef void (*GstTracerHookPadPullRangePre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadPullRangePost) (GObject *self, GstClockTime ts,
     GstPad *pad, GstBuffer *buffer, GstFlowReturn res);
 #define GST_TRACER_PAD_PULL_RANGE_POST(pad, buffer, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PULL_RANGE_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PULL_RANGE_POST, \
     GstTracerHookPadPullRangePost, (GST_TRACER_ARGS, pad, buffer, res)); \
 }G_STMT_END
 
@@ -235,7 +242,7 @@ typedef void (*GstTracerHookPadPullRangePost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadPushEventPre) (GObject *self, GstClockTime ts,
     GstPad *pad, GstEvent *event);
 #define GST_TRACER_PAD_PUSH_EVENT_PRE(pad, event) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_EVENT_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_EVENT_PRE, \
     GstTracerHookPadPushEventPre, (GST_TRACER_ARGS, pad, event)); \
 }G_STMT_END
 
@@ -251,7 +258,7 @@ typedef void (*GstTracerHookPadPushEventPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadPushEventPost) (GObject *self, GstClockTime ts,
     GstPad *pad, gboolean res);
 #define GST_TRACER_PAD_PUSH_EVENT_POST(pad, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_PUSH_EVENT_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_PUSH_EVENT_POST, \
     GstTracerHookPadPushEventPost, (GST_TRACER_ARGS, pad, res)); \
 }G_STMT_END
 
@@ -267,7 +274,7 @@ typedef void (*GstTracerHookPadPushEventPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadQueryPre) (GObject *self, GstClockTime ts,
     GstPad *pad, GstQuery *query);
 #define GST_TRACER_PAD_QUERY_PRE(pad, query) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_QUERY_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_QUERY_PRE, \
     GstTracerHookPadQueryPre, (GST_TRACER_ARGS, pad, query)); \
 }G_STMT_END
 
@@ -284,7 +291,7 @@ typedef void (*GstTracerHookPadQueryPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadQueryPost) (GObject *self, GstClockTime ts,
     GstPad *pad, GstQuery *query, gboolean res);
 #define GST_TRACER_PAD_QUERY_POST(pad, query, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_QUERY_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_QUERY_POST, \
     GstTracerHookPadQueryPost, (GST_TRACER_ARGS, pad, query, res)); \
 }G_STMT_END
 
@@ -300,7 +307,7 @@ typedef void (*GstTracerHookPadQueryPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementPostMessagePre) (GObject *self,
     GstClockTime ts, GstElement *element, GstMessage *message);
 #define GST_TRACER_ELEMENT_POST_MESSAGE_PRE(element, message) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_POST_MESSAGE_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_POST_MESSAGE_PRE, \
     GstTracerHookElementPostMessagePre, (GST_TRACER_ARGS, element, message)); \
 }G_STMT_END
 
@@ -316,7 +323,7 @@ typedef void (*GstTracerHookElementPostMessagePre) (GObject *self,
 typedef void (*GstTracerHookElementPostMessagePost) (GObject *self,
     GstClockTime ts, GstElement *element, gboolean res);
 #define GST_TRACER_ELEMENT_POST_MESSAGE_POST(element, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_POST_MESSAGE_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_POST_MESSAGE_POST, \
     GstTracerHookElementPostMessagePost, (GST_TRACER_ARGS, element, res)); \
 }G_STMT_END
 
@@ -332,7 +339,7 @@ typedef void (*GstTracerHookElementPostMessagePost) (GObject *self,
 typedef void (*GstTracerHookElementQueryPre) (GObject *self, GstClockTime ts,
     GstElement *element, GstQuery *query);
 #define GST_TRACER_ELEMENT_QUERY_PRE(element, query) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_QUERY_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_QUERY_PRE, \
     GstTracerHookElementQueryPre, (GST_TRACER_ARGS, element, query)); \
 }G_STMT_END
 
@@ -349,7 +356,7 @@ typedef void (*GstTracerHookElementQueryPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementQueryPost) (GObject *self, GstClockTime ts,
     GstElement *element, GstQuery *query, gboolean res);
 #define GST_TRACER_ELEMENT_QUERY_POST(element, query, res) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_QUERY_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_QUERY_POST, \
     GstTracerHookElementQueryPost, (GST_TRACER_ARGS, element, query, res)); \
 }G_STMT_END
 
@@ -364,7 +371,7 @@ typedef void (*GstTracerHookElementQueryPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementNew) (GObject *self, GstClockTime ts,
     GstElement *element);
 #define GST_TRACER_ELEMENT_NEW(element) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_NEW), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_NEW, \
     GstTracerHookElementNew, (GST_TRACER_ARGS, element)); \
 }G_STMT_END
 
@@ -380,7 +387,7 @@ typedef void (*GstTracerHookElementNew) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementAddPad) (GObject *self, GstClockTime ts,
     GstElement *element, GstPad *pad);
 #define GST_TRACER_ELEMENT_ADD_PAD(element, pad) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_ADD_PAD), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_ADD_PAD, \
     GstTracerHookElementAddPad, (GST_TRACER_ARGS, element, pad)); \
 }G_STMT_END
 
@@ -396,7 +403,7 @@ typedef void (*GstTracerHookElementAddPad) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementRemovePad) (GObject *self, GstClockTime ts,
     GstElement *element, GstPad *pad);
 #define GST_TRACER_ELEMENT_REMOVE_PAD(element, pad) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_REMOVE_PAD), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_REMOVE_PAD, \
     GstTracerHookElementRemovePad, (GST_TRACER_ARGS, element, pad)); \
 }G_STMT_END
 
@@ -412,7 +419,7 @@ typedef void (*GstTracerHookElementRemovePad) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookElementChangeStatePre) (GObject *self,
     GstClockTime ts, GstElement *element, GstStateChange transition);
 #define GST_TRACER_ELEMENT_CHANGE_STATE_PRE(element, transition) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_CHANGE_STATE_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_CHANGE_STATE_PRE, \
     GstTracerHookElementChangeStatePre, (GST_TRACER_ARGS, element, transition)); \
 }G_STMT_END
 
@@ -430,7 +437,7 @@ typedef void (*GstTracerHookElementChangeStatePost) (GObject *self,
     GstClockTime ts, GstElement *element, GstStateChange transition,
     GstStateChangeReturn result);
 #define GST_TRACER_ELEMENT_CHANGE_STATE_POST(element, transition, result) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_ELEMENT_CHANGE_STATE_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_ELEMENT_CHANGE_STATE_POST, \
     GstTracerHookElementChangeStatePost, (GST_TRACER_ARGS, element, transition, result)); \
 }G_STMT_END
 
@@ -446,7 +453,7 @@ typedef void (*GstTracerHookElementChangeStatePost) (GObject *self,
 typedef void (*GstTracerHookBinAddPre) (GObject *self, GstClockTime ts,
     GstBin *bin, GstElement *element);
 #define GST_TRACER_BIN_ADD_PRE(bin, element) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_BIN_ADD_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BIN_ADD_PRE, \
     GstTracerHookBinAddPre, (GST_TRACER_ARGS, bin, element)); \
 }G_STMT_END
 
@@ -463,7 +470,7 @@ typedef void (*GstTracerHookBinAddPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookBinAddPost) (GObject *self, GstClockTime ts,
     GstBin *bin, GstElement *element, gboolean result);
 #define GST_TRACER_BIN_ADD_POST(bin, element, result) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_BIN_ADD_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BIN_ADD_POST, \
     GstTracerHookBinAddPost, (GST_TRACER_ARGS, bin, element, result)); \
 }G_STMT_END
 
@@ -479,7 +486,7 @@ typedef void (*GstTracerHookBinAddPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookBinRemovePre) (GObject *self, GstClockTime ts,
     GstBin *bin, GstElement *element);
 #define GST_TRACER_BIN_REMOVE_PRE(bin, element) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_BIN_REMOVE_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BIN_REMOVE_PRE, \
     GstTracerHookBinRemovePre, (GST_TRACER_ARGS, bin, element)); \
 }G_STMT_END
 
@@ -495,7 +502,7 @@ typedef void (*GstTracerHookBinRemovePre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookBinRemovePost) (GObject *self, GstClockTime ts,
     GstBin *bin, gboolean result);
 #define GST_TRACER_BIN_REMOVE_POST(bin, result) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_BIN_REMOVE_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BIN_REMOVE_POST, \
     GstTracerHookBinRemovePost, (GST_TRACER_ARGS, bin, result)); \
 }G_STMT_END
 
@@ -511,7 +518,7 @@ typedef void (*GstTracerHookBinRemovePost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadLinkPre) (GObject *self, GstClockTime ts,
     GstPad *srcpad, GstPad *sinkpad);
 #define GST_TRACER_PAD_LINK_PRE(srcpad, sinkpad) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_LINK_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_LINK_PRE, \
     GstTracerHookPadLinkPre, (GST_TRACER_ARGS, srcpad, sinkpad)); \
 }G_STMT_END
 
@@ -528,7 +535,7 @@ typedef void (*GstTracerHookPadLinkPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadLinkPost) (GObject *self, GstClockTime ts,
     GstPad *srcpad, GstPad *sinkpad, GstPadLinkReturn result);
 #define GST_TRACER_PAD_LINK_POST(srcpad, sinkpad, result) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_LINK_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_LINK_POST, \
     GstTracerHookPadLinkPost, (GST_TRACER_ARGS, srcpad, sinkpad, result)); \
 }G_STMT_END
 
@@ -544,7 +551,7 @@ typedef void (*GstTracerHookPadLinkPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadUnlinkPre) (GObject *self, GstClockTime ts,
     GstPad *srcpad, GstPad *sinkpad);
 #define GST_TRACER_PAD_UNLINK_PRE(srcpad, sinkpad) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_UNLINK_PRE), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_UNLINK_PRE, \
     GstTracerHookPadUnlinkPre, (GST_TRACER_ARGS, srcpad, sinkpad)); \
 }G_STMT_END
 
@@ -561,7 +568,7 @@ typedef void (*GstTracerHookPadUnlinkPre) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookPadUnlinkPost) (GObject *self, GstClockTime ts,
     GstPad *srcpad, GstPad *sinkpad, gboolean result);
 #define GST_TRACER_PAD_UNLINK_POST(srcpad, sinkpad, result) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_UNLINK_POST), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PAD_UNLINK_POST, \
     GstTracerHookPadUnlinkPost, (GST_TRACER_ARGS, srcpad, sinkpad, result)); \
 }G_STMT_END
 
@@ -576,7 +583,7 @@ typedef void (*GstTracerHookPadUnlinkPost) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookMiniObjectCreated) (GObject *self, GstClockTime ts,
     GstMiniObject *object);
 #define GST_TRACER_MINI_OBJECT_CREATED(object) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MINI_OBJECT_CREATED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MINI_OBJECT_CREATED, \
     GstTracerHookMiniObjectCreated, (GST_TRACER_ARGS, object)); \
 }G_STMT_END
 
@@ -592,7 +599,7 @@ typedef void (*GstTracerHookMiniObjectCreated) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookMiniObjectDestroyed) (GObject *self, GstClockTime ts,
     GstMiniObject *object);
 #define GST_TRACER_MINI_OBJECT_DESTROYED(object) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MINI_OBJECT_DESTROYED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MINI_OBJECT_DESTROYED, \
     GstTracerHookMiniObjectDestroyed, (GST_TRACER_ARGS, object)); \
 }G_STMT_END
 
@@ -609,7 +616,7 @@ typedef void (*GstTracerHookMiniObjectDestroyed) (GObject *self, GstClockTime ts
 typedef void (*GstTracerHookObjectUnreffed) (GObject *self, GstClockTime ts,
     GstObject *object, gint new_refcount);
 #define GST_TRACER_OBJECT_UNREFFED(object, new_refcount) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_OBJECT_UNREFFED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_OBJECT_UNREFFED, \
     GstTracerHookObjectUnreffed, (GST_TRACER_ARGS, object, new_refcount)); \
 }G_STMT_END
 
@@ -626,7 +633,7 @@ typedef void (*GstTracerHookObjectUnreffed) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookObjectReffed) (GObject *self, GstClockTime ts,
     GstObject *object, gint new_refcount);
 #define GST_TRACER_OBJECT_REFFED(object, new_refcount) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_OBJECT_REFFED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_OBJECT_REFFED, \
     GstTracerHookObjectReffed, (GST_TRACER_ARGS, object, new_refcount)); \
 }G_STMT_END
 
@@ -643,7 +650,7 @@ typedef void (*GstTracerHookObjectReffed) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookMiniObjectUnreffed) (GObject *self, GstClockTime ts,
     GstMiniObject *object, gint new_refcount);
 #define GST_TRACER_MINI_OBJECT_UNREFFED(object, new_refcount) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MINI_OBJECT_UNREFFED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MINI_OBJECT_UNREFFED, \
     GstTracerHookMiniObjectUnreffed, (GST_TRACER_ARGS, object, new_refcount)); \
 }G_STMT_END
 
@@ -660,7 +667,7 @@ typedef void (*GstTracerHookMiniObjectUnreffed) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookMiniObjectReffed) (GObject *self, GstClockTime ts,
     GstMiniObject *object, gint new_refcount);
 #define GST_TRACER_MINI_OBJECT_REFFED(object, new_refcount) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_MINI_OBJECT_REFFED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MINI_OBJECT_REFFED, \
     GstTracerHookMiniObjectReffed, (GST_TRACER_ARGS, object, new_refcount)); \
 }G_STMT_END
 
@@ -675,7 +682,7 @@ typedef void (*GstTracerHookMiniObjectReffed) (GObject *self, GstClockTime ts,
 typedef void (*GstTracerHookObjectCreated) (GObject *self, GstClockTime ts,
     GstObject *object);
 #define GST_TRACER_OBJECT_CREATED(object) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_OBJECT_CREATED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_OBJECT_CREATED, \
     GstTracerHookObjectCreated, (GST_TRACER_ARGS, object)); \
 }G_STMT_END
 
@@ -692,7 +699,7 @@ typedef void (*GstTracerHookObjectDestroyed) (GObject *self, GstClockTime ts,
     GstObject *object);
 
 #define GST_TRACER_OBJECT_DESTROYED(object) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_OBJECT_DESTROYED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_OBJECT_DESTROYED, \
     GstTracerHookObjectDestroyed, (GST_TRACER_ARGS, object)); \
 }G_STMT_END
 
@@ -718,10 +725,281 @@ typedef void (*GstTracerHookPluginFeatureLoaded) (GObject *self, GstClockTime ts
  * Since: 1.20
  */
 #define GST_TRACER_PLUGIN_FEATURE_LOADED(feature) G_STMT_START{ \
-  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PLUGIN_FEATURE_LOADED), \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_PLUGIN_FEATURE_LOADED, \
     GstTracerHookPluginFeatureLoaded, (GST_TRACER_ARGS, feature)); \
 }G_STMT_END
 
+/**
+ * GstTracerHookMemoryNumaAccess:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @memory: the memory that is allocated or mapped
+ * @memory_node: the NUMA node the memory was allocated on
+ * @thread_node: the NUMA node of the CPU the calling thread runs on
+ *
+ * Hook called when memory from the NUMA aware system memory allocator is
+ * allocated or mapped, named "memory-numa-access". The access is local when
+ * @memory_node and @thread_node are the same.
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookMemoryNumaAccess) (GObject *self, GstClockTime ts,
+    GstMemory *memory, gint memory_node, gint thread_node);
+/**
+ * GST_TRACER_MEMORY_NUMA_ACCESS:
+ * @memory: The memory that this tracer is called for
+ * @memory_node: The NUMA node of the memory
+ * @thread_node: The NUMA node of the calling thread
+ *
+ * Add a tracepoint when NUMA aware memory is allocated or mapped.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_MEMORY_NUMA_ACCESS(memory, memory_node, thread_node) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MEMORY_NUMA_ACCESS, \
+    GstTracerHookMemoryNumaAccess, (GST_TRACER_ARGS, memory, memory_node, thread_node)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookMemoryAlloc:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @memory: the memory that was initialized
+ *
+ * Hook called at the end of gst_memory_init() named "memory-alloc", for all
+ * allocators. The allocator and size are set on @memory already. Memory
+ * sharing the data of a parent memory has its parent set.
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookMemoryAlloc) (GObject *self, GstClockTime ts,
+    GstMemory *memory);
+/**
+ * GST_TRACER_MEMORY_ALLOC:
+ * @memory: The memory that this tracer is called for
+ *
+ * Add a tracepoint when a memory is initialized.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_MEMORY_ALLOC(memory) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MEMORY_ALLOC, \
+    GstTracerHookMemoryAlloc, (GST_TRACER_ARGS, memory)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookMemoryFree:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @memory: the memory that is freed
+ *
+ * Hook called when the last reference of a memory is dropped, before it is
+ * returned to its allocator, named "memory-free".
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookMemoryFree) (GObject *self, GstClockTime ts,
+    GstMemory *memory);
+/**
+ * GST_TRACER_MEMORY_FREE:
+ * @memory: The memory that this tracer is called for
+ *
+ * Add a tracepoint when a memory is freed.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_MEMORY_FREE(memory) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_MEMORY_FREE, \
+    GstTracerHookMemoryFree, (GST_TRACER_ARGS, memory)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookBufferPoolAcquire:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @pool: the buffer pool
+ * @buffer: the acquired buffer
+ *
+ * Hook called when a buffer was acquired from a buffer pool, named
+ * "buffer-pool-acquire".
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookBufferPoolAcquire) (GObject *self, GstClockTime ts,
+    GstBufferPool *pool, GstBuffer *buffer);
+/**
+ * GST_TRACER_BUFFER_POOL_ACQUIRE:
+ * @pool: The buffer pool that this tracer is called for
+ * @buffer: The acquired buffer
+ *
+ * Add a tracepoint when a buffer is acquired from a pool.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_BUFFER_POOL_ACQUIRE(pool, buffer) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BUFFER_POOL_ACQUIRE, \
+    GstTracerHookBufferPoolAcquire, (GST_TRACER_ARGS, pool, buffer)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookBufferPoolRelease:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @pool: the buffer pool
+ * @buffer: the released buffer
+ *
+ * Hook called when a buffer is released to its buffer pool, before it is
+ * reset, named "buffer-pool-release".
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookBufferPoolRelease) (GObject *self, GstClockTime ts,
+    GstBufferPool *pool, GstBuffer *buffer);
+/**
+ * GST_TRACER_BUFFER_POOL_RELEASE:
+ * @pool: The buffer pool that this tracer is called for
+ * @buffer: The released buffer
+ *
+ * Add a tracepoint when a buffer is released to its pool.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_BUFFER_POOL_RELEASE(pool, buffer) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_BUFFER_POOL_RELEASE, \
+    GstTracerHookBufferPoolRelease, (GST_TRACER_ARGS, pool, buffer)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookStructAlloc:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @name: the static name of the structure type, e.g. "GstClockEntry"
+ * @data: the allocated structure
+ * @size: the size of the structure
+ *
+ * Hook called when a structure that is not an object, like a clock entry,
+ * was allocated, named "struct-alloc".
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookStructAlloc) (GObject *self, GstClockTime ts,
+    const gchar *name, gpointer data, gsize size);
+/**
+ * GST_TRACER_STRUCT_ALLOC:
+ * @name: The static name of the structure type
+ * @data: The allocated structure
+ * @size: The size of the structure
+ *
+ * Add a tracepoint when a structure is allocated.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_STRUCT_ALLOC(name, data, size) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_STRUCT_ALLOC, \
+    GstTracerHookStructAlloc, (GST_TRACER_ARGS, name, data, size)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookStructFree:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @name: the static name of the structure type
+ * @data: the structure that is freed
+ *
+ * Hook called before a structure reported with the "struct-alloc" hook is
+ * freed, named "struct-free".
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookStructFree) (GObject *self, GstClockTime ts,
+    const gchar *name, gpointer data);
+/**
+ * GST_TRACER_STRUCT_FREE:
+ * @name: The static name of the structure type
+ * @data: The structure that is freed
+ *
+ * Add a tracepoint when a structure is freed.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_STRUCT_FREE(name, data) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_STRUCT_FREE, \
+    GstTracerHookStructFree, (GST_TRACER_ARGS, name, data)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookLockAcquired:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @object: the object the lock belongs to
+ * @lock: the #GMutex or #GRecMutex
+ * @site: the static source location that takes the lock
+ * @wait: how long the thread was blocked on the lock, 0 if it was free
+ *
+ * Hook called after an instrumented lock was taken, named "lock-acquired".
+ * Locks are only instrumented when GStreamer is built with the lock_tracing
+ * option.
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookLockAcquired) (GObject *self, GstClockTime ts,
+    GstObject *object, gpointer lock, const gchar *site, GstClockTime wait);
+/**
+ * GST_TRACER_LOCK_ACQUIRED:
+ * @object: the object the lock belongs to
+ * @lock: the lock
+ * @site: the source location
+ * @wait: the time spent waiting for the lock
+ *
+ * Add a tracepoint after a lock was taken.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_LOCK_ACQUIRED(object, lock, site, wait) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_LOCK_ACQUIRED, \
+    GstTracerHookLockAcquired, (GST_TRACER_ARGS, object, lock, site, wait)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookLockReleased:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @object: the object the lock belongs to, only to be used as a key
+ * @lock: the #GMutex or #GRecMutex
+ *
+ * Hook called after an instrumented lock was released, named
+ * "lock-released". @object might already be gone when this is called.
+ *
+ * Since: 1.20
+ */
+typedef void (*GstTracerHookLockReleased) (GObject *self, GstClockTime ts,
+    GstObject *object, gpointer lock);
+/**
+ * GST_TRACER_LOCK_RELEASED:
+ * @object: the object the lock belongs to
+ * @lock: the lock
+ *
+ * Add a tracepoint after a lock was released.
+ *
+ * Since: 1.20
+ */
+#define GST_TRACER_LOCK_RELEASED(object, lock) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK_HOOK_LOCK_RELEASED, \
+    GstTracerHookLockReleased, (GST_TRACER_ARGS, object, lock)); \
+}G_STMT_END
+
+#ifdef GST_ENABLE_LOCK_TRACING
+/* instrumented locks, see gst_private.h. Exported for libgstbase and the
+ * core elements */
+GST_API void     _gst_tracer_mutex_lock        (GMutex * mutex, GstObject * object, const gchar * site);
+GST_API gboolean _gst_tracer_mutex_trylock     (GMutex * mutex, GstObject * object, const gchar * site);
+GST_API void     _gst_tracer_mutex_unlock      (GMutex * mutex, GstObject * object);
+GST_API void     _gst_tracer_rec_mutex_lock    (GRecMutex * mutex, GstObject * object, const gchar * site);
+GST_API gboolean _gst_tracer_rec_mutex_trylock (GRecMutex * mutex, GstObject * object, const gchar * site);
+GST_API void     _gst_tracer_rec_mutex_unlock  (GRecMutex * mutex, GstObject * object);
+GST_API void     _gst_tracer_cond_wait         (GCond * cond, GMutex * mutex, GstObject * object, const gchar * site);
+#endif /* GST_ENABLE_LOCK_TRACING */
+
 
 #else /* !GST_DISABLE_GST_TRACER_HOOKS */
 
@@ -772,6 +1050,15 @@ _priv_gst_tracing_deinit (void)
 #define GST_TRACER_OBJECT_REFFED(object, new_refcount)
 #define GST_TRACER_OBJECT_UNREFFED(object, new_refcount)
 #define GST_TRACER_PLUGIN_FEATURE_LOADED(feature)
+#define GST_TRACER_MEMORY_NUMA_ACCESS(memory, memory_node, thread_node)
+#define GST_TRACER_MEMORY_ALLOC(memory)
+#define GST_TRACER_MEMORY_FREE(memory)
+#define GST_TRACER_BUFFER_POOL_ACQUIRE(pool, buffer)
+#define GST_TRACER_BUFFER_POOL_RELEASE(pool, buffer)
+#define GST_TRACER_STRUCT_ALLOC(name, data, size)
+#define GST_TRACER_STRUCT_FREE(name, data)
+#define GST_TRACER_LOCK_ACQUIRED(object, lock, site, wait)
+#define GST_TRACER_LOCK_RELEASED(object, lock)
 
 #endif /* GST_DISABLE_GST_TRACER_HOOKS */
 
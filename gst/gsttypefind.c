@@ -34,6 +34,9 @@
 #include "gstregistry.h"
 #include "gsttypefindfactory.h"
 
+/* For g_memdup2 */
+#include "glib-compat-private.h"
+
 GST_DEBUG_CATEGORY_EXTERN (type_find_debug);
 #define GST_CAT_DEFAULT type_find_debug
 
@@ -64,10 +67,52 @@ gboolean
 gst_type_find_register (GstPlugin * plugin, const gchar * name, guint rank,
     GstTypeFindFunction func, const gchar * extensions,
     GstCaps * possible_caps, gpointer data, GDestroyNotify data_notify)
+{
+  return gst_type_find_register_with_magic (plugin, name, rank, func,
+      extensions, possible_caps, NULL, 0, data, data_notify);
+}
+
+/**
+ * gst_type_find_register_with_magic:
+ * @plugin: (nullable): A #GstPlugin, or %NULL for a static typefind function
+ * @name: The name for registering
+ * @rank: The rank (or importance) of this typefind function
+ * @func: The #GstTypeFindFunction to use
+ * @extensions: (nullable): Optional comma-separated list of extensions
+ *     that could belong to this type
+ * @possible_caps: (nullable): Optionally the caps that could be returned when typefinding
+ *                 succeeds
+ * @magic: (nullable) (array length=magic_size): the bytes every stream of this
+ *     type starts with, or %NULL
+ * @magic_size: the size of @magic
+ * @data: Optional user data. This user data must be available until the plugin
+ *        is unloaded.
+ * @data_notify: a #GDestroyNotify that will be called on @data when the plugin
+ *        is unloaded.
+ *
+ * Like gst_type_find_register(), but additionally declares that every stream
+ * this typefind function recognises starts with @magic.
+ *
+ * The magic bytes are stored in the registry, and the typefind helpers use
+ * them to call the typefind functions whose magic matches the start of the
+ * stream before any other, without loading unrelated plugins. When one of
+ * these returns %GST_TYPE_FIND_MAXIMUM the other typefind functions are not
+ * called at all.
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_type_find_register_with_magic (GstPlugin * plugin, const gchar * name,
+    guint rank, GstTypeFindFunction func, const gchar * extensions,
+    GstCaps * possible_caps, const guint8 * magic, guint magic_size,
+    gpointer data, GDestroyNotify data_notify)
 {
   GstTypeFindFactory *factory;
 
   g_return_val_if_fail (name != NULL, FALSE);
+  g_return_val_if_fail (magic != NULL || magic_size == 0, FALSE);
 
   GST_INFO ("registering typefind function for %s", name);
 
@@ -81,6 +126,10 @@ gst_type_find_register (GstPlugin * plugin, const gchar * name, guint rank,
     factory->extensions = g_strsplit (extensions, ",", -1);
 
   gst_caps_replace (&factory->caps, possible_caps);
+  if (magic_size > 0) {
+    factory->magic = g_memdup2 (magic, magic_size);
+    factory->magic_size = magic_size;
+  }
   factory->function = func;
   factory->user_data = data;
   factory->user_data_notify = data_notify;
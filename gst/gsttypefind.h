@@ -216,6 +216,18 @@ gboolean  gst_type_find_register   (GstPlugin            * plugin,
                                     gpointer               data,
                                     GDestroyNotify         data_notify);
 
+GST_API
+gboolean  gst_type_find_register_with_magic (GstPlugin       * plugin,
+                                    const gchar          * name,
+                                    guint                  rank,
+                                    GstTypeFindFunction    func,
+                                    const gchar          * extensions,
+                                    GstCaps              * possible_caps,
+                                    const guint8         * magic,
+                                    guint                  magic_size,
+                                    gpointer               data,
+                                    GDestroyNotify         data_notify);
+
 G_END_DECLS
 
 #endif /* __GST_TYPE_FIND_H__ */
@@ -81,9 +81,23 @@
 #include "gsttypefindfactory.h"
 #include "gstregistry.h"
 
+#include <string.h>
+
 GST_DEBUG_CATEGORY (type_find_debug);
 #define GST_CAT_DEFAULT type_find_debug
 
+/* The factories that declared magic bytes are indexed on the first
+ * MAGIC_KEY_SIZE bytes of their magic, with one table per key length so
+ * that shorter magics can be indexed too. Every table maps the key bytes to
+ * the list of factories with that key, and the index is rebuilt whenever
+ * the feature list of the registry changes. */
+#define MAGIC_KEY_SIZE 4
+
+static GMutex magic_index_lock;
+static GHashTable *magic_index[MAGIC_KEY_SIZE];
+static guint32 magic_index_cookie;
+static gboolean magic_index_valid = FALSE;
+
 static void gst_type_find_factory_dispose (GObject * object);
 
 #define _do_init \
@@ -124,6 +138,9 @@ gst_type_find_factory_dispose (GObject * object)
     g_strfreev (factory->extensions);
     factory->extensions = NULL;
   }
+  g_free (factory->magic);
+  factory->magic = NULL;
+  factory->magic_size = 0;
   if (factory->user_data_notify && factory->user_data) {
     factory->user_data_notify (factory->user_data);
     factory->user_data = NULL;
@@ -153,6 +170,160 @@ gst_type_find_factory_get_list (void)
       GST_TYPE_TYPE_FIND_FACTORY);
 }
 
+static inline guint
+magic_key (const guint8 * data, guint len)
+{
+  guint i, key = 0;
+
+  for (i = 0; i < len; i++)
+    key = (key << 8) | data[i];
+
+  return key;
+}
+
+static void
+magic_index_clear (void)
+{
+  guint i;
+
+  for (i = 0; i < MAGIC_KEY_SIZE; i++) {
+    if (magic_index[i]) {
+      g_hash_table_destroy (magic_index[i]);
+      magic_index[i] = NULL;
+    }
+  }
+  magic_index_valid = FALSE;
+}
+
+/* with magic_index_lock */
+static void
+magic_index_update (void)
+{
+  GstRegistry *registry = gst_registry_get ();
+  GList *l, *type_list;
+  guint32 cookie;
+
+  cookie = gst_registry_get_feature_list_cookie (registry);
+  if (magic_index_valid && cookie == magic_index_cookie)
+    return;
+
+  magic_index_clear ();
+
+  type_list = gst_type_find_factory_get_list ();
+  for (l = type_list; l; l = l->next) {
+    GstTypeFindFactory *factory = l->data;
+    GHashTable *table;
+    GList *list;
+    guint len;
+    gpointer key;
+
+    if (factory->magic_size == 0)
+      continue;
+
+    len = MIN (factory->magic_size, MAGIC_KEY_SIZE);
+    if (magic_index[len - 1] == NULL)
+      magic_index[len - 1] = g_hash_table_new_full (NULL, NULL, NULL,
+          (GDestroyNotify) gst_plugin_feature_list_free);
+    table = magic_index[len - 1];
+
+    key = GUINT_TO_POINTER (magic_key (factory->magic, len));
+    list = g_hash_table_lookup (table, key);
+    /* appending to a non-empty list keeps its head */
+    if (list)
+      g_list_append (list, gst_object_ref (factory));
+    else
+      g_hash_table_insert (table, key,
+          g_list_append (NULL, gst_object_ref (factory)));
+  }
+  gst_plugin_feature_list_free (type_list);
+
+  magic_index_cookie = cookie;
+  magic_index_valid = TRUE;
+}
+
+void
+_priv_gst_type_find_factory_cleanup (void)
+{
+  g_mutex_lock (&magic_index_lock);
+  magic_index_clear ();
+  g_mutex_unlock (&magic_index_lock);
+}
+
+/**
+ * gst_type_find_factory_get_list_for_data:
+ * @data: (array length=size): the first bytes of a stream
+ * @size: the size of @data
+ *
+ * Gets the typefind factories that declared magic bytes @data starts with,
+ * see gst_type_find_register_with_magic(). The factories are looked up in an
+ * index of the magic bytes stored in the registry, which does not require
+ * loading any plugin. You must free the list using
+ * gst_plugin_feature_list_free().
+ *
+ * The returned factories are sorted by highest rank first, and then by
+ * factory name.
+ *
+ * Free-function: gst_plugin_feature_list_free
+ *
+ * Returns: (transfer full) (element-type Gst.TypeFindFactory): the list of
+ *     #GstTypeFindFactory with magic bytes matching @data.
+ *
+ * Since: 1.20
+ */
+GList *
+gst_type_find_factory_get_list_for_data (const guint8 * data, gsize size)
+{
+  GList *l, *result = NULL;
+  guint len;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  g_mutex_lock (&magic_index_lock);
+  magic_index_update ();
+
+  for (len = MIN (size, MAGIC_KEY_SIZE); len > 0; len--) {
+    if (magic_index[len - 1] == NULL)
+      continue;
+
+    l = g_hash_table_lookup (magic_index[len - 1],
+        GUINT_TO_POINTER (magic_key (data, len)));
+    for (; l; l = l->next) {
+      GstTypeFindFactory *factory = l->data;
+
+      if (factory->magic_size <= size
+          && memcmp (factory->magic, data, factory->magic_size) == 0)
+        result = g_list_prepend (result, gst_object_ref (factory));
+    }
+  }
+  g_mutex_unlock (&magic_index_lock);
+
+  return g_list_sort (result, gst_plugin_feature_rank_compare_func);
+}
+
+/**
+ * gst_type_find_factory_get_magic:
+ * @factory: A #GstTypeFindFactory
+ * @size: (out): location to store the size of the magic bytes
+ *
+ * Gets the magic bytes every stream identified by this factory starts with,
+ * if it declared any with gst_type_find_register_with_magic().
+ *
+ * Returns: (transfer none) (nullable) (array length=size): the magic bytes
+ *     of this factory, or %NULL.
+ *
+ * Since: 1.20
+ */
+const guint8 *
+gst_type_find_factory_get_magic (GstTypeFindFactory * factory, guint * size)
+{
+  g_return_val_if_fail (GST_IS_TYPE_FIND_FACTORY (factory), NULL);
+  g_return_val_if_fail (size != NULL, NULL);
+
+  *size = factory->magic_size;
+
+  return factory->magic;
+}
+
 /**
  * gst_type_find_factory_get_caps:
  * @factory: A #GstTypeFindFactory
@@ -164,9 +335,20 @@ gst_type_find_factory_get_list (void)
 GstCaps *
 gst_type_find_factory_get_caps (GstTypeFindFactory * factory)
 {
+  GstCaps *caps;
+
   g_return_val_if_fail (GST_IS_TYPE_FIND_FACTORY (factory), NULL);
 
-  return factory->caps;
+  caps = g_atomic_pointer_get (&factory->caps);
+  if (G_UNLIKELY (caps == NULL && factory->caps_string != NULL)) {
+    caps = gst_caps_from_string (factory->caps_string);
+    if (!g_atomic_pointer_compare_and_exchange (&factory->caps, NULL, caps)) {
+      gst_caps_unref (caps);
+      caps = g_atomic_pointer_get (&factory->caps);
+    }
+  }
+
+  return caps;
 }
 
 /**
@@ -55,6 +55,14 @@ GList *         gst_type_find_factory_get_list          (void);
 GST_API
 const gchar * const * gst_type_find_factory_get_extensions (GstTypeFindFactory *factory);
 
+GST_API
+GList *         gst_type_find_factory_get_list_for_data (const guint8 *data,
+                                                         gsize         size);
+
+GST_API
+const guint8 *  gst_type_find_factory_get_magic         (GstTypeFindFactory *factory,
+                                                         guint              *size);
+
 GST_API
 GstCaps *       gst_type_find_factory_get_caps          (GstTypeFindFactory *factory);
 
@@ -525,43 +525,6 @@ gst_uri_construct (const gchar * protocol, const gchar * location)
 }
 #endif
 
-typedef struct
-{
-  GstURIType type;
-  const gchar *protocol;
-}
-SearchEntry;
-
-static gboolean
-search_by_entry (GstPluginFeature * feature, gpointer search_entry)
-{
-  const gchar *const *protocols;
-  GstElementFactory *factory;
-  SearchEntry *entry = (SearchEntry *) search_entry;
-
-  if (!GST_IS_ELEMENT_FACTORY (feature))
-    return FALSE;
-  factory = GST_ELEMENT_FACTORY_CAST (feature);
-
-  if (factory->uri_type != entry->type)
-    return FALSE;
-
-  protocols = gst_element_factory_get_uri_protocols (factory);
-
-  if (protocols == NULL) {
-    g_warning ("Factory '%s' implements GstUriHandler interface but returned "
-        "no supported protocols!", gst_plugin_feature_get_name (feature));
-    return FALSE;
-  }
-
-  while (*protocols != NULL) {
-    if (g_ascii_strcasecmp (*protocols, entry->protocol) == 0)
-      return TRUE;
-    protocols++;
-  }
-  return FALSE;
-}
-
 static gint
 sort_by_rank (GstPluginFeature * first, GstPluginFeature * second)
 {
@@ -569,21 +532,16 @@ sort_by_rank (GstPluginFeature * first, GstPluginFeature * second)
       gst_plugin_feature_get_rank (first);
 }
 
+/* looked up in the protocol index of the registry, which is only rebuilt
+ * when the registry changes */
 static GList *
 get_element_factories_from_uri_protocol (const GstURIType type,
     const gchar * protocol)
 {
-  GList *possibilities;
-  SearchEntry entry;
-
   g_return_val_if_fail (protocol, NULL);
 
-  entry.type = type;
-  entry.protocol = protocol;
-  possibilities = gst_registry_feature_filter (gst_registry_get (),
-      search_by_entry, FALSE, &entry);
-
-  return possibilities;
+  return _priv_gst_registry_get_element_factories_by_uri_protocol
+      (gst_registry_get (), type, protocol);
 }
 
 /**
@@ -607,7 +565,7 @@ gst_uri_protocol_is_supported (const GstURIType type, const gchar * protocol)
   possibilities = get_element_factories_from_uri_protocol (type, protocol);
 
   if (possibilities) {
-    g_list_free (possibilities);
+    gst_plugin_feature_list_free (possibilities);
     return TRUE;
   } else
     return FALSE;
@@ -1315,7 +1273,7 @@ _gst_uri_string_to_list (const gchar * str, const gchar * sep, gboolean convert,
       for (next_elem = split_str; *next_elem; next_elem += 1) {
         gchar *elem = *next_elem;
         if (*elem == '\0') {
-          new_list = g_list_append (new_list, NULL);
+          new_list = g_list_prepend (new_list, NULL);
         } else {
           if (convert && !unescape) {
             gchar *next_sep;
@@ -1327,11 +1285,11 @@ _gst_uri_string_to_list (const gchar * str, const gchar * sep, gboolean convert,
             }
           }
           if (unescape) {
-            *next_elem = g_uri_unescape_string (elem, NULL);
-            g_free (elem);
-            elem = *next_elem;
+            new_list = g_list_prepend (new_list,
+                g_uri_unescape_string (elem, NULL));
+          } else {
+            new_list = g_list_prepend (new_list, g_strdup (elem));
           }
-          new_list = g_list_append (new_list, g_strdup (elem));
         }
       }
     }
@@ -1340,7 +1298,35 @@ _gst_uri_string_to_list (const gchar * str, const gchar * sep, gboolean convert,
       g_free (pct_sep);
   }
 
-  return new_list;
+  return g_list_reverse (new_list);
+}
+
+/* Splits and unescapes the segments between @str and @end without copying
+ * the string first, like _gst_uri_string_to_list() with @unescape and without
+ * @convert. @str must not be empty. */
+static GList *
+_gst_uri_span_to_list (const gchar * str, const gchar * end, gchar sep)
+{
+  GList *new_list = NULL;
+  const gchar *next;
+
+  for (;;) {
+    next = memchr (str, sep, end - str);
+    if (next == NULL)
+      next = end;
+
+    if (next == str)
+      new_list = g_list_prepend (new_list, NULL);
+    else
+      new_list = g_list_prepend (new_list,
+          g_uri_unescape_segment (str, next, NULL));
+
+    if (next == end)
+      break;
+    str = next + 1;
+  }
+
+  return g_list_reverse (new_list);
 }
 
 static GHashTable *
@@ -1598,17 +1584,12 @@ _gst_uri_from_string_internal (const gchar * uri, gboolean unescape)
       /* get path */
       size_t len;
       len = strcspn (uri, "?#");
-      if (uri[len] == '\0') {
-        uri_obj->path = _gst_uri_string_to_list (uri, "/", FALSE, TRUE);
+      if (len > 0)
+        uri_obj->path = _gst_uri_span_to_list (uri, uri + len, '/');
+      if (uri[len] == '\0')
         uri = NULL;
-      } else {
-        if (len > 0) {
-          gchar *path_str = g_strndup (uri, len);
-          uri_obj->path = _gst_uri_string_to_list (path_str, "/", FALSE, TRUE);
-          g_free (path_str);
-        }
+      else
         uri += len;
-      }
     }
     if (uri != NULL && uri[0] == '?') {
       /* get query */
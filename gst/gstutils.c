@@ -823,6 +823,255 @@ gst_util_uint64_scale_int_ceil (guint64 val, gint num, gint denom)
   return _gst_util_uint64_scale_int (val, num, denom, denom - 1);
 }
 
+/* how a scaler divides by its denominator */
+enum
+{
+  SCALER_SHIFT,
+  SCALER_MUL,
+  SCALER_MUL_ADD
+};
+
+static inline guint64
+gst_util_uint64_mul_high (guint64 a, guint64 b)
+{
+#ifdef HAVE_UINT128_T
+  return (guint64) (((__uint128_t) a * b) >> 64);
+#else
+  GstUInt64 c1, c0;
+
+  gst_util_uint64_mul_uint64 (&c1, &c0, a, b);
+
+  return c1.ll;
+#endif
+}
+
+/* computes 2^(64 + @shift) / @d with 2^@shift < @d. It's done bit by bit
+ * because it only happens once per scaler */
+static guint64
+gst_util_scaler_div_pow2 (guint shift, guint64 d, guint64 * rem)
+{
+  guint64 q = 0, r = G_GUINT64_CONSTANT (1) << shift;
+  guint i;
+
+  for (i = 0; i < 64; i++) {
+    gboolean carry = r >> 63;
+
+    r <<= 1;
+    q <<= 1;
+    if (carry || r >= d) {
+      r -= d;
+      q |= 1;
+    }
+  }
+  *rem = r;
+
+  return q;
+}
+
+/**
+ * gst_util_scaler_init:
+ * @scaler: a #GstUtilScaler
+ * @num: the numerator of the scale ratio
+ * @denom: the denominator of the scale ratio
+ *
+ * Prepares @scaler for scaling values by @num / @denom. The division by
+ * @denom is replaced by a multiplication with a precomputed reciprocal and
+ * a shift, which makes gst_util_scaler_scale() and its variants a lot
+ * cheaper than gst_util_uint64_scale() when the same fixed ratio, such as a
+ * sample rate and %GST_SECOND, is used for many values.
+ *
+ * The results are exactly the same as those of gst_util_uint64_scale(),
+ * gst_util_uint64_scale_round() and gst_util_uint64_scale_ceil().
+ *
+ * Since: 1.20
+ */
+void
+gst_util_scaler_init (GstUtilScaler * scaler, guint64 num, guint64 denom)
+{
+  guint64 a, b, d, m, rem;
+  guint shift = 0;
+
+  g_return_if_fail (scaler != NULL);
+  g_return_if_fail (denom != 0);
+
+  memset (scaler, 0, sizeof (GstUtilScaler));
+
+  /* reducing the ratio doesn't change any of the results, also not the
+   * rounded ones, and it makes the products fit in 64 bits more often */
+  a = num;
+  b = denom;
+  while (b) {
+    guint64 t = a % b;
+
+    a = b;
+    b = t;
+  }
+  scaler->num = num / a;
+  scaler->denom = d = denom / a;
+
+  /* the largest value for which value * num plus any rounding correction
+   * fits in 64 bits */
+  scaler->max_val =
+      scaler->num ? (G_MAXUINT64 - (d - 1)) / scaler->num : G_MAXUINT64;
+
+  while ((d >> shift) > 1)
+    shift++;
+  scaler->shift = shift;
+
+  if ((d & (d - 1)) == 0) {
+    scaler->mode = SCALER_SHIFT;
+    return;
+  }
+
+  /* see "Division by Invariant Integers using Multiplication", Granlund and
+   * Montgomery. If the rounded up reciprocal with shift bits isn't precise
+   * enough, one more bit is used and the multiplication needs an extra
+   * addition */
+  m = gst_util_scaler_div_pow2 (shift, d, &rem);
+  if (d - rem < (G_GUINT64_CONSTANT (1) << shift)) {
+    scaler->mode = SCALER_MUL;
+  } else {
+    guint64 twice_rem = rem + rem;
+
+    m += m;
+    if (twice_rem >= d || twice_rem < rem)
+      m++;
+    scaler->mode = SCALER_MUL_ADD;
+  }
+  scaler->mul = m + 1;
+}
+
+static inline guint64
+_gst_util_scaler_scale (const GstUtilScaler * scaler, guint64 val,
+    guint64 correct)
+{
+  guint64 x, q;
+
+  if (G_UNLIKELY (val > scaler->max_val))
+    return _gst_util_uint64_scale (val, scaler->num, scaler->denom, correct);
+
+  x = val * scaler->num + correct;
+
+  switch (scaler->mode) {
+    case SCALER_SHIFT:
+      return x >> scaler->shift;
+    case SCALER_MUL:
+      return gst_util_uint64_mul_high (x, scaler->mul) >> scaler->shift;
+    default:
+      q = gst_util_uint64_mul_high (x, scaler->mul);
+      return (((x - q) >> 1) + q) >> scaler->shift;
+  }
+}
+
+/**
+ * gst_util_scaler_scale:
+ * @scaler: a #GstUtilScaler
+ * @val: the number to scale
+ *
+ * Scales @val by the ratio of @scaler, see gst_util_uint64_scale().
+ *
+ * Returns: @val * num / denom, truncated. In the case of an overflow, this
+ * function returns G_MAXUINT64.
+ *
+ * Since: 1.20
+ */
+guint64
+gst_util_scaler_scale (const GstUtilScaler * scaler, guint64 val)
+{
+  g_return_val_if_fail (scaler != NULL, G_MAXUINT64);
+
+  return _gst_util_scaler_scale (scaler, val, 0);
+}
+
+/**
+ * gst_util_scaler_scale_round:
+ * @scaler: a #GstUtilScaler
+ * @val: the number to scale
+ *
+ * Scales @val by the ratio of @scaler, see gst_util_uint64_scale_round().
+ *
+ * Returns: @val * num / denom, rounded to the nearest integer (half-way
+ * cases are rounded up). In the case of an overflow, this function returns
+ * G_MAXUINT64.
+ *
+ * Since: 1.20
+ */
+guint64
+gst_util_scaler_scale_round (const GstUtilScaler * scaler, guint64 val)
+{
+  g_return_val_if_fail (scaler != NULL, G_MAXUINT64);
+
+  return _gst_util_scaler_scale (scaler, val, scaler->denom >> 1);
+}
+
+/**
+ * gst_util_scaler_scale_ceil:
+ * @scaler: a #GstUtilScaler
+ * @val: the number to scale
+ *
+ * Scales @val by the ratio of @scaler, see gst_util_uint64_scale_ceil().
+ *
+ * Returns: @val * num / denom, rounded up. In the case of an overflow, this
+ * function returns G_MAXUINT64.
+ *
+ * Since: 1.20
+ */
+guint64
+gst_util_scaler_scale_ceil (const GstUtilScaler * scaler, guint64 val)
+{
+  g_return_val_if_fail (scaler != NULL, G_MAXUINT64);
+
+  return _gst_util_scaler_scale (scaler, val, scaler->denom - 1);
+}
+
+/**
+ * gst_util_scaler_scale_array:
+ * @scaler: a #GstUtilScaler
+ * @vals: (array length=n_vals): the numbers to scale
+ * @results: (out caller-allocates) (array length=n_vals): the scaled
+ *   numbers, can be the same as @vals
+ * @n_vals: the number of values
+ *
+ * Scales all @vals by the ratio of @scaler with truncation, like calling
+ * gst_util_scaler_scale() for each of them.
+ *
+ * Since: 1.20
+ */
+void
+gst_util_scaler_scale_array (const GstUtilScaler * scaler,
+    const guint64 * vals, guint64 * results, gsize n_vals)
+{
+  gsize i;
+
+  g_return_if_fail (scaler != NULL);
+  g_return_if_fail (n_vals == 0 || (vals != NULL && results != NULL));
+
+  /* keep the mode out of the loops */
+  switch (scaler->mode) {
+    case SCALER_SHIFT:
+      for (i = 0; i < n_vals; i++) {
+        if (G_LIKELY (vals[i] <= scaler->max_val))
+          results[i] = (vals[i] * scaler->num) >> scaler->shift;
+        else
+          results[i] = _gst_util_scaler_scale (scaler, vals[i], 0);
+      }
+      break;
+    case SCALER_MUL:
+      for (i = 0; i < n_vals; i++) {
+        if (G_LIKELY (vals[i] <= scaler->max_val))
+          results[i] = gst_util_uint64_mul_high (vals[i] * scaler->num,
+              scaler->mul) >> scaler->shift;
+        else
+          results[i] = _gst_util_scaler_scale (scaler, vals[i], 0);
+      }
+      break;
+    default:
+      for (i = 0; i < n_vals; i++)
+        results[i] = _gst_util_scaler_scale (scaler, vals[i], 0);
+      break;
+  }
+}
+
 /**
  * gst_util_seqnum_next:
  *
@@ -1378,7 +1627,7 @@ gst_element_factory_can_accept_all_caps_in_direction (GstElementFactory *
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
-  templates = factory->staticpadtemplates;
+  templates = (GList *) gst_element_factory_get_static_pad_templates (factory);
 
   while (templates) {
     GstStaticPadTemplate *template = (GstStaticPadTemplate *) templates->data;
@@ -1407,7 +1656,7 @@ gst_element_factory_can_accept_any_caps_in_direction (GstElementFactory *
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
-  templates = factory->staticpadtemplates;
+  templates = (GList *) gst_element_factory_get_static_pad_templates (factory);
 
   while (templates) {
     GstStaticPadTemplate *template = (GstStaticPadTemplate *) templates->data;
@@ -3390,6 +3639,168 @@ gst_bin_sync_children_states (GstBin * bin)
   return success;
 }
 
+static gboolean
+element_in_branch (GstElement * element, GstElement ** elements,
+    guint n_elements)
+{
+  guint i;
+
+  for (i = 0; i < n_elements; i++)
+    if (elements[i] == element)
+      return TRUE;
+
+  return FALSE;
+}
+
+/* collects the pads outside of the branch that feed the sinkpads of @element,
+ * each pad only once */
+static void
+collect_upstream_peers (GstElement * element, GstElement ** elements,
+    guint n_elements, GPtrArray * peers)
+{
+  GList *l;
+
+  GST_OBJECT_LOCK (element);
+  for (l = element->sinkpads; l; l = l->next) {
+    GstPad *peer = gst_pad_get_peer (GST_PAD_CAST (l->data));
+    GstObject *parent;
+
+    if (peer == NULL)
+      continue;
+
+    /* only look at the direct parent, we hold the lock of @element */
+    parent = GST_OBJECT_PARENT (peer);
+    if ((parent && GST_IS_ELEMENT (parent)
+            && element_in_branch (GST_ELEMENT_CAST (parent), elements,
+                n_elements)) || g_ptr_array_find (peers, peer, NULL))
+      gst_object_unref (peer);
+    else
+      g_ptr_array_add (peers, peer);
+  }
+  GST_OBJECT_UNLOCK (element);
+}
+
+/**
+ * gst_bin_attach_branch:
+ * @bin: a #GstBin
+ * @srcpad: (allow-none): a #GstPad of an element in @bin to link the branch
+ *   to, or %NULL
+ * @elements: (array length=n_elements) (transfer floating): the elements of
+ *   the branch, upstream elements first
+ * @n_elements: the number of elements in @elements
+ *
+ * Adds a branch of elements that are already linked with each other to @bin
+ * while @bin may be running, and brings them to the state of @bin in one
+ * pass. This is the same as gst_bin_add() for every element, linking @srcpad
+ * to a compatible pad of the first element, and
+ * gst_element_sync_state_with_parent() for every element from the last to
+ * the first, but it reads the state of @bin only once.
+ *
+ * No RECONFIGURE event is sent while the branch is linked and its pads are
+ * activated. Instead, a single RECONFIGURE event is sent from every pad
+ * outside the branch that is linked to it, once all elements are in their
+ * new state.
+ *
+ * If an element can't be added, the elements added so far are removed from
+ * @bin again. If linking or the state change fails, the elements stay in
+ * @bin.
+ *
+ * Returns: %TRUE if the branch was added, linked and its state synced
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_bin_attach_branch (GstBin * bin, GstPad * srcpad, GstElement ** elements,
+    guint n_elements)
+{
+  GstState target;
+  GPtrArray *peers;
+  gboolean res = TRUE;
+  guint i;
+
+  g_return_val_if_fail (GST_IS_BIN (bin), FALSE);
+  g_return_val_if_fail (srcpad == NULL || GST_IS_PAD (srcpad), FALSE);
+  g_return_val_if_fail (srcpad == NULL
+      || GST_PAD_IS_SRC (srcpad), FALSE);
+  g_return_val_if_fail (elements != NULL && n_elements > 0, FALSE);
+
+  for (i = 0; i < n_elements; i++) {
+    if (!gst_bin_add (bin, elements[i]))
+      goto add_failed;
+  }
+
+  if (srcpad) {
+    GstPad *sinkpad;
+
+    sinkpad = gst_element_get_compatible_pad (elements[0], srcpad, NULL);
+    if (sinkpad == NULL)
+      goto no_pad;
+
+    res = GST_PAD_LINK_SUCCESSFUL (gst_pad_link_full (srcpad, sinkpad,
+            GST_PAD_LINK_CHECK_DEFAULT | GST_PAD_LINK_CHECK_NO_RECONFIGURE));
+    gst_object_unref (sinkpad);
+    if (!res)
+      goto link_failed;
+  }
+
+  GST_OBJECT_LOCK (bin);
+  target = GST_STATE_PENDING (bin);
+  if (target == GST_STATE_VOID_PENDING)
+    target = GST_STATE (bin);
+  GST_OBJECT_UNLOCK (bin);
+
+  GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin,
+      "attaching branch of %u elements in state %s", n_elements,
+      gst_element_state_get_name (target));
+
+  /* downstream elements first, so that data only flows into elements that
+   * are ready for it */
+  for (i = n_elements; i > 0 && res; i--) {
+    GstElement *element = elements[i - 1];
+
+    if (gst_element_is_locked_state (element))
+      continue;
+
+    if (gst_element_set_state (element, target) == GST_STATE_CHANGE_FAILURE) {
+      GST_CAT_WARNING_OBJECT (GST_CAT_STATES, element,
+          "failed to sync state to %s", gst_element_state_get_name (target));
+      res = FALSE;
+    }
+  }
+
+  /* one RECONFIGURE for every pad feeding the branch */
+  peers = g_ptr_array_new_with_free_func (gst_object_unref);
+  for (i = 0; i < n_elements; i++)
+    collect_upstream_peers (elements[i], elements, n_elements, peers);
+  for (i = 0; i < peers->len; i++)
+    gst_pad_send_event (g_ptr_array_index (peers, i),
+        gst_event_new_reconfigure ());
+  g_ptr_array_unref (peers);
+
+  return res;
+
+  /* ERRORS */
+add_failed:
+  {
+    GST_WARNING_OBJECT (bin, "failed to add element %u of the branch", i);
+    while (i > 0)
+      gst_bin_remove (bin, elements[--i]);
+    return FALSE;
+  }
+no_pad:
+  {
+    GST_WARNING_OBJECT (bin, "no pad of %" GST_PTR_FORMAT " to link %"
+        GST_PTR_FORMAT " to", elements[0], srcpad);
+    return FALSE;
+  }
+link_failed:
+  {
+    GST_WARNING_OBJECT (bin, "failed to link %" GST_PTR_FORMAT " to %"
+        GST_PTR_FORMAT, srcpad, elements[0]);
+    return FALSE;
+  }
+}
+
 /**
  * gst_parse_bin_from_description:
  * @bin_description: command line describing the bin
@@ -99,6 +99,47 @@ guint64         gst_util_uint64_scale_int_round (guint64 val, gint num, gint den
 GST_API
 guint64         gst_util_uint64_scale_int_ceil  (guint64 val, gint num, gint denom);
 
+/**
+ * GstUtilScaler:
+ * @num: the numerator of the scale ratio, reduced
+ * @denom: the denominator of the scale ratio, reduced
+ *
+ * Scales many values by the same rational number, see
+ * gst_util_scaler_init().
+ *
+ * Since: 1.20
+ */
+typedef struct {
+  guint64 num;
+  guint64 denom;
+
+  /*< private >*/
+  guint64 mul;
+  guint64 max_val;
+  guint   shift;
+  guint   mode;
+
+  gpointer _gst_reserved[GST_PADDING];
+} GstUtilScaler;
+
+GST_API
+void            gst_util_scaler_init            (GstUtilScaler * scaler,
+                                                 guint64 num, guint64 denom);
+GST_API
+guint64         gst_util_scaler_scale           (const GstUtilScaler * scaler,
+                                                 guint64 val);
+GST_API
+guint64         gst_util_scaler_scale_round     (const GstUtilScaler * scaler,
+                                                 guint64 val);
+GST_API
+guint64         gst_util_scaler_scale_ceil      (const GstUtilScaler * scaler,
+                                                 guint64 val);
+GST_API
+void            gst_util_scaler_scale_array     (const GstUtilScaler * scaler,
+                                                 const guint64 * vals,
+                                                 guint64 * results,
+                                                 gsize n_vals);
+
 /**
  * GST_SEQNUM_INVALID:
  *
@@ -1142,6 +1183,11 @@ GstPad *                gst_bin_find_unlinked_pad       (GstBin *bin, GstPadDire
 GST_API
 gboolean                gst_bin_sync_children_states    (GstBin *bin);
 
+GST_API
+gboolean                gst_bin_attach_branch           (GstBin *bin, GstPad *srcpad,
+                                                         GstElement **elements,
+                                                         guint n_elements);
+
 /* parse utility functions */
 
 GST_API
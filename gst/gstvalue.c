@@ -2808,9 +2808,11 @@ _priv_gst_value_parse_value (gchar * str,
 
       if (G_UNLIKELY (!_priv_gst_value_parse_string (s, &value_end, &s, FALSE)))
         return FALSE;
-      /* Set NULL terminator for deserialization */
+      /* Set NULL terminator for deserialization, in place to avoid copying
+       * every value */
       value_size = value_end - value_s;
-      value_s = g_strndup (value_s, value_end - value_s);
+      c = *value_end;
+      *value_end = '\0';
       /* Keep old broken behavior where "2" could be interpretted as an int */
       check_wrapped_non_string = value_s[0] == '"' &&
           strlen (value_s) >= 2 && value_end[-1] == '"';
@@ -2842,19 +2844,21 @@ _priv_gst_value_parse_value (gchar * str,
         }
         g_value_unset (value);
       }
+      *value_end = c;
     } else {
       g_value_init (value, type);
 
       if (G_UNLIKELY (!_priv_gst_value_parse_string (s, &value_end, &s, FALSE)))
         return FALSE;
       /* Set NULL terminator for deserialization */
-      value_s = g_strndup (value_s, value_end - value_s);
+      c = *value_end;
+      *value_end = '\0';
 
       ret = gst_value_deserialize_with_pspec (value, value_s, pspec);
       if (G_UNLIKELY (!ret))
         g_value_unset (value);
+      *value_end = c;
     }
-    g_free (value_s);
   }
 
   *after = s;
@@ -4946,6 +4950,146 @@ gst_value_intersect_double_range_double_range (GValue * dest,
   return FALSE;
 }
 
+/* Lists with at least this many items of a type that compares by value
+ * are intersected by looking the items up in a sorted copy of the second
+ * list instead of intersecting every pair of items */
+#define SORTED_INTERSECT_MIN_SIZE 8
+
+static gint
+compare_list_item_int (gconstpointer a, gconstpointer b)
+{
+  gint i1 = g_value_get_int (*(const GValue **) a);
+  gint i2 = g_value_get_int (*(const GValue **) b);
+
+  return (i1 > i2) - (i1 < i2);
+}
+
+static gint
+compare_list_item_string (gconstpointer a, gconstpointer b)
+{
+  return strcmp (g_value_get_string (*(const GValue **) a),
+      g_value_get_string (*(const GValue **) b));
+}
+
+static gint
+compare_list_item_fraction (gconstpointer a, gconstpointer b)
+{
+  const GValue *v1 = *(const GValue **) a;
+  const GValue *v2 = *(const GValue **) b;
+
+  return gst_util_fraction_compare (gst_value_get_fraction_numerator (v1),
+      gst_value_get_fraction_denominator (v1),
+      gst_value_get_fraction_numerator (v2),
+      gst_value_get_fraction_denominator (v2));
+}
+
+static gboolean
+list_items_are_sortable (const GValue * list, GType type)
+{
+  guint i, len = VALUE_LIST_SIZE (list);
+
+  for (i = 0; i < len; i++) {
+    const GValue *item = VALUE_LIST_GET_VALUE (list, i);
+
+    if (G_VALUE_TYPE (item) != type)
+      return FALSE;
+    if (type == G_TYPE_STRING && g_value_get_string (item) == NULL)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Same result as the generic list intersection below, in the order of
+ * @value1. Returns FALSE in @handled if the lists are not suitable. */
+static gboolean
+gst_value_intersect_list_list_sorted (GValue * dest, const GValue * value1,
+    const GValue * value2, GType type, gboolean * handled)
+{
+  GCompareFunc compare;
+  const GValue **sorted;
+  guint8 *visited;
+  GstValueList *vlist = NULL;
+  guint it1, it2, len1, len2;
+  gboolean res = FALSE;
+
+  *handled = FALSE;
+
+  if (type == G_TYPE_INT)
+    compare = compare_list_item_int;
+  else if (type == G_TYPE_STRING)
+    compare = compare_list_item_string;
+  else if (type == GST_TYPE_FRACTION)
+    compare = compare_list_item_fraction;
+  else
+    return FALSE;
+
+  len1 = VALUE_LIST_SIZE (value1);
+  len2 = VALUE_LIST_SIZE (value2);
+  if (len1 < SORTED_INTERSECT_MIN_SIZE || len2 < SORTED_INTERSECT_MIN_SIZE)
+    return FALSE;
+
+  if (!list_items_are_sortable (value1, type) ||
+      !list_items_are_sortable (value2, type))
+    return FALSE;
+
+  *handled = TRUE;
+
+  sorted = g_new (const GValue *, len2);
+  for (it2 = 0; it2 < len2; it2++)
+    sorted[it2] = VALUE_LIST_GET_VALUE (value2, it2);
+  qsort (sorted, len2, sizeof (const GValue *), compare);
+
+  /* every item of @value2 can only be matched once */
+  visited = g_malloc0 (len2);
+
+  if (dest)
+    vlist = _gst_value_list_new (MIN (len1, len2));
+
+  for (it1 = 0; it1 < len1; it1++) {
+    const GValue *item1 = VALUE_LIST_GET_VALUE (value1, it1);
+    guint lo = 0, hi = len2;
+
+    /* find the first item that is not smaller than item1 */
+    while (lo < hi) {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (compare (&sorted[mid], &item1) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    while (lo < len2 && visited[lo] && compare (&sorted[lo], &item1) == 0)
+      lo++;
+    if (lo == len2 || compare (&sorted[lo], &item1) != 0)
+      continue;
+
+    res = TRUE;
+    if (!dest)
+      break;
+
+    visited[lo] = TRUE;
+    gst_value_init_and_copy (&vlist->fields[vlist->len++], item1);
+  }
+
+  g_free (visited);
+  g_free (sorted);
+
+  if (dest) {
+    if (vlist->len == 1) {
+      gst_value_move (dest, &vlist->fields[0]);
+      g_free (vlist);
+    } else if (vlist->len > 1) {
+      dest->g_type = GST_TYPE_LIST;
+      dest->data[0].v_pointer = vlist;
+    } else {
+      g_free (vlist);
+    }
+  }
+
+  return res;
+}
+
 static gboolean
 gst_value_intersect_list_list (GValue * dest, const GValue * value1,
     const GValue * value2)
@@ -4965,6 +5109,15 @@ gst_value_intersect_list_list (GValue * dest, const GValue * value1,
       type1 != type2)
     return FALSE;
 
+  {
+    gboolean handled;
+
+    res = gst_value_intersect_list_list_sorted (dest, value1, value2, type1,
+        &handled);
+    if (handled)
+      return res;
+  }
+
   len1 = VALUE_LIST_SIZE (value1);
   len2 = VALUE_LIST_SIZE (value2);
 
@@ -7720,7 +7873,7 @@ try_as_flags_string:
       GType flags_type = g_type_from_name (class_name);
       if (flags_type == 0) {
         GST_TRACE ("Looking for dynamic type %s", class_name);
-        gst_dynamic_type_factory_load (class_name);
+        flags_type = gst_dynamic_type_factory_load (class_name);
       }
 
       if (flags_type != 0) {
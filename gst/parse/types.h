@@ -4,6 +4,7 @@
 #include <glib-object.h>
 #include "../gstelement.h"
 #include "../gstparse.h"
+#include "../gsturi.h"
 
 typedef struct {
   GstElement *element;
@@ -24,6 +25,53 @@ typedef struct {
   reference_t last;
 } chain_t;
 
+/* the steps recorded for a GstParseTemplate, replayed in order to create the
+ * elements of a new instance. Elements are referred to by the index of the
+ * step that created them. */
+typedef enum {
+  OP_ELEMENT,
+  OP_URI,
+  OP_SET,
+  OP_PRESET,
+  OP_BIN
+} op_type_t;
+
+typedef struct {
+  op_type_t type;
+  guint element;                /* element created or changed by the step */
+  GstElementFactory *factory;   /* ELEMENT and BIN */
+  GstURIType uri_type;          /* URI */
+  gchar *str;                   /* URI: uri, SET: value, PRESET: preset */
+  gchar *name;                  /* SET: property name */
+  GType owner;                  /* SET: type the property was looked up on */
+  GParamSpec *pspec;            /* SET: property of the element or NULL */
+  GValue value;                 /* SET: deserialized value without parameters */
+  GArray *children;             /* BIN: indices of the children */
+} op_t;
+
+typedef struct {
+  gint element;                 /* index of the element or -1 */
+  gchar *name;
+  GSList *pads;
+} template_ref_t;
+
+typedef struct {
+  template_ref_t src;
+  template_ref_t sink;
+  GstCaps *caps;
+  gboolean all_pads;
+} template_link_t;
+
+struct _GstParseTemplate {
+  gint refcount;
+  GstParseFlags flags;
+  guint n_elements;
+  GArray *ops;                  /* op_t */
+  GArray *links;                /* template_link_t */
+  GArray *toplevel;             /* indices of the toplevel elements */
+  GHashTable *indices;          /* element -> index + 1, while compiling */
+};
+
 typedef struct _graph_t graph_t;
 struct _graph_t {
   chain_t *chain; /* links are supposed to be done now */
@@ -31,6 +79,7 @@ struct _graph_t {
   GError **error;
   GstParseContext *ctx; /* may be NULL */
   GstParseFlags flags;
+  GstParseTemplate *templ; /* template to record into or NULL */
 };
 
 
@@ -106,4 +155,14 @@ G_GNUC_INTERNAL GstElement *priv_gst_parse_launch (const gchar      * str,
                                                    GstParseContext  * ctx,
                                                    GstParseFlags      flags);
 
+G_GNUC_INTERNAL GstParseTemplate *priv_gst_parse_template_compile (const gchar   * str,
+                                                   GstParseFlags      flags,
+                                                   GError          ** err);
+
+G_GNUC_INTERNAL GstElement *priv_gst_parse_template_instantiate (GstParseTemplate * templ,
+                                                   const GstStructure * params,
+                                                   GError          ** err);
+
+G_GNUC_INTERNAL void priv_gst_parse_template_free (GstParseTemplate * templ);
+
 #endif /* __GST_PARSE_TYPES_H__ */
@@ -25,6 +25,8 @@
 /* Private namespace for gnulib functions */
 #define asnprintf        __gst_asnprintf
 #define vasnprintf       __gst_vasnprintf
+#define vasnprintf_capture  __gst_vasnprintf_capture
+#define vasnprintf_captured __gst_vasnprintf_captured
 #define printf_parse     __gst_printf_parse
 #define printf_fetchargs __gst_printf_fetchargs
 
@@ -146,14 +146,63 @@ __gst_vsnprintf (char *string, size_t n, char const *format, va_list args)
 }
 #endif
 
+/* Short results are formatted into a buffer on the stack first, so that
+ * they need only a single allocation of the right size instead of growing
+ * the result a few times */
+#define STACK_BUF_SIZE 256
+
+static char *
+finish_result (char *result, char *stackbuf, size_t length)
+{
+  char *str;
+
+  if (result != stackbuf)
+    return result;
+
+  str = malloc (length + 1);
+  memcpy (str, stackbuf, length + 1);
+
+  return str;
+}
+
 int
 __gst_vasprintf (char **result, char const *format, va_list args)
 {
-  size_t length;
+  char stackbuf[STACK_BUF_SIZE];
+  size_t length = sizeof (stackbuf);
+  char *str;
 
-  *result = vasnprintf (NULL, &length, format, args);
-  if (*result == NULL)
+  str = vasnprintf (stackbuf, &length, format, args);
+  if (str == NULL) {
+    *result = NULL;
     return -1;
+  }
+
+  *result = finish_result (str, stackbuf, length);
+  return length;
+}
+
+void *
+__gst_vasprintf_capture (void *buf, size_t * size, char const *format,
+    va_list args)
+{
+  return vasnprintf_capture (buf, size, format, args);
+}
+
+int
+__gst_asprintf_captured (char **result, char const *format,
+    void const *captured)
+{
+  char stackbuf[STACK_BUF_SIZE];
+  size_t length = sizeof (stackbuf);
+  char *str;
+
+  str = vasnprintf_captured (stackbuf, &length, format, captured);
+  if (str == NULL) {
+    *result = NULL;
+    return -1;
+  }
 
+  *result = finish_result (str, stackbuf, length);
   return length;
 }
@@ -60,5 +60,14 @@ int __gst_vasprintf (char       **result,
                      char const *format,
                      va_list      args);
 
+void * __gst_vasprintf_capture (void        *buf,
+                                size_t      *size,
+                                char const  *format,
+                                va_list      args);
+
+int __gst_asprintf_captured (char       **result,
+                             char const *format,
+                             void const *captured);
+
 
 #endif /* __GNULIB_PRINTF_H__ */
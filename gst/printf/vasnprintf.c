@@ -260,35 +260,165 @@ printf_postprocess_args (char_directives * directives, arguments * arguments)
   }
 }
 
-char *
-vasnprintf (char *resultbuf, size_t * lengthp, const char *format, va_list args)
+/* Most formats have only a few directives, their parse results are copied
+   into storage on the stack instead of the heap.  */
+#define N_INLINE_DIRECTIVES 8
+#define N_INLINE_ARGUMENTS 8
+
+typedef struct
+{
+  /* one more for the directive marking the end of the format */
+  char_directive dir[N_INLINE_DIRECTIVES + 1];
+  argument arg[N_INLINE_ARGUMENTS];
+} format_storage;
+
+/* Parsing the format is a good part of the cost of formatting, and the
+   debug system uses the same few formats over and over again. The parse
+   results are kept in a small per-thread cache keyed by the format pointer.
+   A hit also compares the format against the copy made when it was parsed,
+   so a format in a reused buffer never matches stale directives, which
+   point into the format.  */
+#define PARSE_CACHE_SIZE 32
+#define PARSE_CACHE_MAX_FORMAT 256
+
+typedef struct
 {
+  const char *format;
+  char *copy;
   char_directives d;
   arguments a;
+} parse_cache_entry;
 
-  if (printf_parse (format, &d, &a) < 0) {
-    errno = EINVAL;
-    return NULL;
+static void
+parse_cache_free (void *data)
+{
+  parse_cache_entry *cache = (parse_cache_entry *) data;
+  unsigned int i;
+
+  for (i = 0; i < PARSE_CACHE_SIZE; i++) {
+    if (cache[i].format == NULL)
+      continue;
+    free (cache[i].copy);
+    free (cache[i].d.dir);
+    free (cache[i].a.arg);
   }
-#define CLEANUP()                         \
-  free (d.dir);                           \
-  if (a.arg) {                            \
-    while (a.count--) {                   \
-      if (a.arg[a.count].ext_string)      \
-        free (a.arg[a.count].ext_string); \
-    }                                     \
-    free (a.arg);                         \
+  free (cache);
+}
+
+static GPrivate parse_cache_key = G_PRIVATE_INIT (parse_cache_free);
+
+static parse_cache_entry *
+parse_cache_lookup (const char *format)
+{
+  parse_cache_entry *cache;
+  size_t hash = (size_t) format;
+
+  cache = (parse_cache_entry *) g_private_get (&parse_cache_key);
+  if (cache == NULL) {
+    cache = g_new0 (parse_cache_entry, PARSE_CACHE_SIZE);
+    g_private_set (&parse_cache_key, cache);
   }
 
-  if (printf_fetchargs (args, &a) < 0) {
-    CLEANUP ();
-    errno = EINVAL;
-    return NULL;
+  hash ^= hash >> 12;
+  return &cache[(hash >> 3) % PARSE_CACHE_SIZE];
+}
+
+/* Copies the parse results into S when they fit, or into newly allocated
+   memory otherwise.  */
+static int
+copy_format (const char_directives * src_d, const arguments * src_a,
+    char_directives * d, arguments * a, format_storage * s)
+{
+  *d = *src_d;
+  *a = *src_a;
+
+  if (d->count <= N_INLINE_DIRECTIVES)
+    d->dir = s->dir;
+  else if ((d->dir = malloc ((d->count + 1) * sizeof (char_directive))) ==
+      NULL)
+    return -1;
+  memcpy (d->dir, src_d->dir, (d->count + 1) * sizeof (char_directive));
+
+  if (a->count == 0) {
+    a->arg = NULL;
+    return 0;
   }
 
-  /* collect TYPE_POINTER_EXT argument strings */
-  printf_postprocess_args (&d, &a);
+  if (a->count <= N_INLINE_ARGUMENTS)
+    a->arg = s->arg;
+  else if ((a->arg = malloc (a->count * sizeof (argument))) == NULL) {
+    if (d->dir != s->dir)
+      free (d->dir);
+    return -1;
+  }
+  memcpy (a->arg, src_a->arg, a->count * sizeof (argument));
+
+  return 0;
+}
+
+/* Like printf_parse(), but looks up FORMAT in the parse cache first. The
+   results must be released with free_format().  */
+static int
+parse_format (const char *format, char_directives * d, arguments * a,
+    format_storage * s)
+{
+  parse_cache_entry *entry;
+  char_directives pd;
+  arguments pa;
+  size_t len;
+
+  entry = parse_cache_lookup (format);
+  if (entry->format == format && strcmp (entry->copy, format) == 0)
+    return copy_format (&entry->d, &entry->a, d, a, s);
+
+  if (printf_parse (format, &pd, &pa) < 0)
+    return -1;
+
+  len = strlen (format);
+  if (len >= PARSE_CACHE_MAX_FORMAT) {
+    /* not worth keeping, hand out the parse results directly */
+    *d = pd;
+    *a = pa;
+    return 0;
+  }
+
+  if (entry->format != NULL) {
+    free (entry->copy);
+    free (entry->d.dir);
+    free (entry->a.arg);
+  }
+  entry->format = format;
+  entry->copy = (char *) malloc (len + 1);
+  memcpy (entry->copy, format, len + 1);
+  entry->d = pd;
+  entry->a = pa;
 
+  return copy_format (&entry->d, &entry->a, d, a, s);
+}
+
+static void
+free_format (char_directives * d, arguments * a, format_storage * s)
+{
+  if (d->dir != s->dir)
+    free (d->dir);
+  if (a->arg) {
+    while (a->count--) {
+      if (a->arg[a->count].ext_string)
+        free (a->arg[a->count].ext_string);
+    }
+    if (a->arg != s->arg)
+      free (a->arg);
+  }
+}
+
+#define CLEANUP() free_format (&d, &a, s)
+
+/* Formats the parsed directives D with the fetched arguments A and frees
+   both afterwards.  */
+static char *
+format_arguments (char *resultbuf, size_t * lengthp, const char *format,
+    char_directives d, arguments a, format_storage * s)
+{
   {
     char *buf =
         (char *) alloca (7 + d.max_width_length + d.max_precision_length + 6);
@@ -1039,3 +1169,174 @@ vasnprintf (char *resultbuf, size_t * lengthp, const char *format, va_list args)
     return result;
   }
 }
+
+char *
+vasnprintf (char *resultbuf, size_t * lengthp, const char *format, va_list args)
+{
+  format_storage storage, *s = &storage;
+  char_directives d;
+  arguments a;
+
+  if (parse_format (format, &d, &a, s) < 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  if (printf_fetchargs (args, &a) < 0) {
+    CLEANUP ();
+    errno = EINVAL;
+    return NULL;
+  }
+
+  /* collect TYPE_POINTER_EXT argument strings */
+  printf_postprocess_args (&d, &a);
+
+  return format_arguments (resultbuf, lengthp, format, d, a, s);
+}
+
+/* Captured arguments are stored as the argument count, followed by the
+   argument array and the string data. String and TYPE_POINTER_EXT arguments
+   refer to their copy by offset from the start of the capture, so that the
+   capture can be moved around freely.  */
+#define CAPTURE_ARG_OFFSET(i) (sizeof (unsigned int) + (i) * sizeof (argument))
+
+static size_t
+capture_string (char *result, size_t * offset, const char *str)
+{
+  size_t len = strlen (str) + 1;
+  size_t ret = *offset;
+
+  memcpy (result + ret, str, len);
+  *offset += len;
+
+  return ret;
+}
+
+void *
+vasnprintf_capture (void *resultbuf, size_t * lengthp, const char *format,
+    va_list args)
+{
+  format_storage storage, *s = &storage;
+  char_directives d;
+  arguments a;
+  unsigned int i;
+  size_t length, offset;
+  char *result;
+
+  if (parse_format (format, &d, &a, s) < 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  /* %n writes to the caller's memory, which is gone when formatting */
+  for (i = 0; i < a.count; i++) {
+    if (a.arg[i].type >= TYPE_COUNT_SCHAR_POINTER) {
+      CLEANUP ();
+      errno = EINVAL;
+      return NULL;
+    }
+  }
+
+  if (printf_fetchargs (args, &a) < 0) {
+    CLEANUP ();
+    errno = EINVAL;
+    return NULL;
+  }
+
+  /* the pointers might not be valid anymore later, so serialize them now */
+  printf_postprocess_args (&d, &a);
+
+  length = CAPTURE_ARG_OFFSET (a.count);
+  for (i = 0; i < a.count; i++) {
+    if (a.arg[i].type == TYPE_STRING && a.arg[i].a.a_string != NULL)
+      length += strlen (a.arg[i].a.a_string) + 1;
+    if (a.arg[i].ext_string != NULL)
+      length += strlen (a.arg[i].ext_string) + 1;
+  }
+
+  if (resultbuf != NULL && length <= *lengthp)
+    result = (char *) resultbuf;
+  else {
+    result = (char *) malloc (length);
+    if (result == NULL) {
+      CLEANUP ();
+      errno = ENOMEM;
+      return NULL;
+    }
+  }
+
+  memcpy (result, &a.count, sizeof (unsigned int));
+  offset = CAPTURE_ARG_OFFSET (a.count);
+  for (i = 0; i < a.count; i++) {
+    argument arg = a.arg[i];
+
+    if (arg.type == TYPE_STRING && arg.a.a_string != NULL)
+      arg.a.a_string =
+          (const char *) capture_string (result, &offset, arg.a.a_string);
+    if (arg.ext_string != NULL)
+      arg.ext_string = (char *) capture_string (result, &offset,
+          arg.ext_string);
+
+    memcpy (result + CAPTURE_ARG_OFFSET (i), &arg, sizeof (argument));
+  }
+
+  CLEANUP ();
+  *lengthp = length;
+  return result;
+}
+
+char *
+vasnprintf_captured (char *resultbuf, size_t * lengthp, const char *format,
+    const void *captured)
+{
+  const char *base = (const char *) captured;
+  format_storage storage, *s = &storage;
+  char_directives d;
+  arguments a;
+  unsigned int i, count;
+
+  if (parse_format (format, &d, &a, s) < 0) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  memcpy (&count, base, sizeof (unsigned int));
+  if (count != a.count) {
+    CLEANUP ();
+    errno = EINVAL;
+    return NULL;
+  }
+
+  for (i = 0; i < a.count; i++) {
+    argument *ap = &a.arg[i];
+    arg_type type = ap->type;
+
+    memcpy (ap, base + CAPTURE_ARG_OFFSET (i), sizeof (argument));
+
+    if (ap->type != type) {
+      ap->ext_string = NULL;
+      CLEANUP ();
+      errno = EINVAL;
+      return NULL;
+    }
+
+    if (ap->type == TYPE_STRING && ap->a.a_string != NULL)
+      ap->a.a_string = base + (size_t) ap->a.a_string;
+
+    /* the argument owns its ext_string, so make a copy */
+    if (ap->ext_string != NULL) {
+      const char *str = base + (size_t) ap->ext_string;
+      size_t len = strlen (str) + 1;
+
+      ap->ext_string = (char *) malloc (len);
+      if (ap->ext_string == NULL) {
+        CLEANUP ();
+        errno = ENOMEM;
+        return NULL;
+      }
+      memcpy (ap->ext_string, str, len);
+    }
+  }
+
+  return format_arguments (resultbuf, lengthp, format, d, a, s);
+}
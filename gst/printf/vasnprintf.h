@@ -54,6 +54,17 @@ extern char * asnprintf (char *resultbuf, size_t *lengthp, const char *format, .
 extern char * vasnprintf (char *resultbuf, size_t *lengthp, const char *format, va_list args)
        __attribute__ ((__format__ (__printf__, 3, 0)));
 
+/* Capture the arguments needed for formatting FORMAT with ARGS, so that
+   vasnprintf_captured() can format them at a later time. Strings and
+   pointer extensions are copied into the capture, %n is not supported.
+   RESULTBUF and LENGTHP are used like with vasnprintf(), and on success
+   *LENGTHP is set to the size of the capture.  Upon error, set errno and
+   return NULL.  */
+extern void * vasnprintf_capture (void *resultbuf, size_t *lengthp, const char *format, va_list args);
+/* Format the arguments CAPTURED by vasnprintf_capture() with the same
+   FORMAT, like vasnprintf() would have done.  */
+extern char * vasnprintf_captured (char *resultbuf, size_t *lengthp, const char *format, const void *captured);
+
 #ifdef	__cplusplus
 }
 #endif
@@ -39,6 +39,7 @@
 #include <gst/base/gstflowcombiner.h>
 #include <gst/base/gstpushsrc.h>
 #include <gst/base/gstqueuearray.h>
+#include <gst/base/gstqueuebudget.h>
 #include <gst/base/gsttypefindhelper.h>
 
 #endif /* __GST_BASE_H__ */
@@ -113,6 +113,12 @@
  * gst_adapter_copy() can be used to copy data into a (statically allocated)
  * user provided buffer.
  *
+ * Parsers that only need to read the data can avoid the copy when a range
+ * spans multiple buffers with gst_adapter_map_vectored(). It maps every
+ * memory in the range separately and returns the pieces as an array of
+ * #GstAdapterSpan, which can be read as one stream of bytes with a
+ * #GstAdapterReader.
+ *
  * #GstAdapter is not MT safe. All operations on an adapter must be serialized by
  * the caller. This is not normally a problem, however, as the normal use case
  * of #GstAdapter is inside one pad's chain function, in which case access is
@@ -128,11 +134,13 @@
 #include "gstadapter.h"
 #include <string.h>
 #include <gst/base/gstqueuearray.h>
+#include <gst/base/gstbytereader.h>
 
 /* default size for the assembled data buffer */
 #define DEFAULT_SIZE 4096
 
 static void gst_adapter_flush_unchecked (GstAdapter * adapter, gsize flush);
+static void gst_adapter_unmap_vectored_unchecked (GstAdapter * adapter);
 
 GST_DEBUG_CATEGORY_STATIC (gst_adapter_debug);
 #define GST_CAT_DEFAULT gst_adapter_debug
@@ -170,6 +178,10 @@ struct _GstAdapter
   guint64 distance_from_discont;
 
   GstMapInfo info;
+
+  /* memories mapped with gst_adapter_map_vectored() and their spans */
+  GArray *vmaps;
+  GArray *spans;
 };
 
 struct _GstAdapterClass
@@ -231,6 +243,11 @@ gst_adapter_finalize (GObject * object)
 
   gst_queue_array_free (adapter->bufqueue);
 
+  if (adapter->vmaps)
+    g_array_free (adapter->vmaps, TRUE);
+  if (adapter->spans)
+    g_array_free (adapter->spans, TRUE);
+
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
 
@@ -261,6 +278,7 @@ gst_adapter_clear (GstAdapter * adapter)
 
   if (adapter->info.memory)
     gst_adapter_unmap (adapter);
+  gst_adapter_unmap_vectored_unchecked (adapter);
 
   while ((obj = gst_queue_array_pop_head (adapter->bufqueue)))
     gst_mini_object_unref (obj);
@@ -575,6 +593,136 @@ gst_adapter_unmap (GstAdapter * adapter)
   }
 }
 
+static void
+gst_adapter_unmap_vectored_unchecked (GstAdapter * adapter)
+{
+  guint i;
+
+  if (adapter->vmaps == NULL || adapter->vmaps->len == 0)
+    return;
+
+  GST_LOG_OBJECT (adapter, "unmap %u memories", adapter->vmaps->len);
+  for (i = 0; i < adapter->vmaps->len; i++) {
+    GstMapInfo *info = &g_array_index (adapter->vmaps, GstMapInfo, i);
+
+    gst_memory_unmap (info->memory, info);
+  }
+  g_array_set_size (adapter->vmaps, 0);
+  g_array_set_size (adapter->spans, 0);
+}
+
+/**
+ * gst_adapter_map_vectored:
+ * @adapter: a #GstAdapter
+ * @offset: the bytes offset in the adapter to start from
+ * @size: the number of bytes to map
+ * @n_spans: (out): the number of returned spans
+ *
+ * Maps @size bytes starting at @offset in the @adapter without merging
+ * them into one contiguous memory area. Every memory of the buffers in the
+ * range is mapped separately and a #GstAdapterSpan is returned for each of
+ * them, in the order of the data. Use a #GstAdapterReader to read across
+ * the span boundaries.
+ *
+ * Unlike gst_adapter_map() this never copies data, which makes it the better
+ * choice for parsers that read packetized input in place.
+ *
+ * The returned spans are valid until gst_adapter_unmap_vectored(),
+ * gst_adapter_flush(), gst_adapter_clear() or the next call to this function.
+ * Any of the functions that take data out of the adapter flush it.
+ *
+ * Returns %NULL if @offset + @size bytes are not available.
+ *
+ * Returns: (transfer none) (array length=n_spans) (nullable): the spans
+ *     covering the requested range, or %NULL
+ *
+ * Since: 1.20
+ */
+const GstAdapterSpan *
+gst_adapter_map_vectored (GstAdapter * adapter, gsize offset, gsize size,
+    guint * n_spans)
+{
+  GstBuffer *buf;
+  gsize skip, bsize;
+  guint idx = 0, i, n_mem;
+
+  g_return_val_if_fail (GST_IS_ADAPTER (adapter), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+  g_return_val_if_fail (n_spans != NULL, NULL);
+
+  gst_adapter_unmap_vectored_unchecked (adapter);
+
+  if (G_UNLIKELY (offset + size > adapter->size))
+    return NULL;
+
+  if (adapter->vmaps == NULL) {
+    adapter->vmaps = g_array_new (FALSE, FALSE, sizeof (GstMapInfo));
+    adapter->spans = g_array_new (FALSE, FALSE, sizeof (GstAdapterSpan));
+  }
+
+  skip = offset + adapter->skip;
+  while (size > 0) {
+    buf = gst_queue_array_peek_nth (adapter->bufqueue, idx++);
+    bsize = gst_buffer_get_size (buf);
+    if (skip >= bsize) {
+      skip -= bsize;
+      continue;
+    }
+
+    n_mem = gst_buffer_n_memory (buf);
+    for (i = 0; i < n_mem && size > 0; i++) {
+      GstMemory *mem = gst_buffer_peek_memory (buf, i);
+      GstAdapterSpan span;
+      GstMapInfo info;
+
+      if (skip >= mem->size) {
+        skip -= mem->size;
+        continue;
+      }
+      if (!gst_memory_map (mem, &info, GST_MAP_READ))
+        goto map_failed;
+      g_array_append_val (adapter->vmaps, info);
+
+      span.data = info.data + skip;
+      span.size = MIN (info.size - skip, size);
+      g_array_append_val (adapter->spans, span);
+
+      size -= span.size;
+      skip = 0;
+    }
+  }
+
+  GST_CAT_LOG_OBJECT (GST_CAT_PERFORMANCE, adapter, "mapped %u spans",
+      adapter->spans->len);
+
+  *n_spans = adapter->spans->len;
+  return (const GstAdapterSpan *) adapter->spans->data;
+
+  /* ERRORS */
+map_failed:
+  {
+    GST_WARNING_OBJECT (adapter, "failed to map memory");
+    gst_adapter_unmap_vectored_unchecked (adapter);
+    return NULL;
+  }
+}
+
+/**
+ * gst_adapter_unmap_vectored:
+ * @adapter: a #GstAdapter
+ *
+ * Releases the memories mapped with the last gst_adapter_map_vectored().
+ *
+ * Since: 1.20
+ */
+void
+gst_adapter_unmap_vectored (GstAdapter * adapter)
+{
+  g_return_if_fail (GST_IS_ADAPTER (adapter));
+
+  gst_adapter_unmap_vectored_unchecked (adapter);
+}
+
 /**
  * gst_adapter_copy: (skip)
  * @adapter: a #GstAdapter
@@ -635,6 +783,7 @@ gst_adapter_flush_unchecked (GstAdapter * adapter, gsize flush)
 
   if (adapter->info.memory)
     gst_adapter_unmap (adapter);
+  gst_adapter_unmap_vectored_unchecked (adapter);
 
   /* clear state */
   adapter->size -= flush;
@@ -1652,12 +1801,13 @@ gssize
 gst_adapter_masked_scan_uint32_peek (GstAdapter * adapter, guint32 mask,
     guint32 pattern, gsize offset, gsize size, guint32 * value)
 {
-  gsize skip, bsize, i;
+  gsize skip, bsize, i, end;
   guint32 state;
   GstMapInfo info;
   guint8 *bdata;
   GstBuffer *buf;
   guint idx;
+  gboolean start_code;
 
   g_return_val_if_fail (size > 0, -1);
   g_return_val_if_fail (offset + size <= adapter->size, -1);
@@ -1667,6 +1817,10 @@ gst_adapter_masked_scan_uint32_peek (GstAdapter * adapter, guint32 mask,
   if (G_UNLIKELY (size < 4))
     return -1;
 
+  /* special case found in MPEG and H264, scanned with the vectorized start
+   * code search of the byte reader inside each memory chunk */
+  start_code = (pattern == 0x00000100) && (mask == 0xffffff00);
+
   skip = offset + adapter->skip;
 
   /* first step, do skipping and position on the first buffer */
@@ -1702,7 +1856,10 @@ gst_adapter_masked_scan_uint32_peek (GstAdapter * adapter, guint32 mask,
   /* now find data */
   do {
     bsize = MIN (bsize, size);
-    for (i = 0; i < bsize; i++) {
+    /* with the fast start code scan only matches that started in the
+     * previous chunk can end in the first 3 bytes of this one */
+    end = (start_code && bsize >= 4) ? 3 : bsize;
+    for (i = 0; i < end; i++) {
       state = ((state << 8) | bdata[i]);
       if (G_UNLIKELY ((state & mask) == pattern)) {
         /* we have a match but we need to have skipped at
@@ -1715,6 +1872,21 @@ gst_adapter_masked_scan_uint32_peek (GstAdapter * adapter, guint32 mask,
         }
       }
     }
+    if (end < bsize) {
+      GstByteReader reader;
+      guint pos;
+
+      gst_byte_reader_init (&reader, bdata, bsize);
+      /* the byte following the prefix must be in this chunk too */
+      pos = gst_byte_reader_find_start_code (&reader, 0, bsize - 1);
+      if (pos != -1) {
+        if (G_LIKELY (value))
+          *value = (1 << 8) | bdata[pos + 3];
+        gst_buffer_unmap (buf, &info);
+        return offset + skip + pos;
+      }
+      state = GST_READ_UINT32_BE (bdata + bsize - 4);
+    }
     size -= bsize;
     if (size == 0)
       break;
@@ -1790,3 +1962,355 @@ gst_adapter_masked_scan_uint32 (GstAdapter * adapter, guint32 mask,
   return gst_adapter_masked_scan_uint32_peek (adapter, mask, pattern, offset,
       size, NULL);
 }
+
+/**
+ * gst_adapter_reader_init:
+ * @reader: a #GstAdapterReader
+ * @spans: (array length=n_spans): the spans to read from
+ * @n_spans: the number of spans
+ *
+ * Initializes a #GstAdapterReader to read from the @n_spans spans at
+ * @spans, usually obtained with gst_adapter_map_vectored(). The spans must
+ * stay valid for as long as the reader is used.
+ *
+ * Since: 1.20
+ */
+void
+gst_adapter_reader_init (GstAdapterReader * reader,
+    const GstAdapterSpan * spans, guint n_spans)
+{
+  guint i;
+
+  g_return_if_fail (reader != NULL);
+  g_return_if_fail (spans != NULL || n_spans == 0);
+
+  memset (reader, 0, sizeof (GstAdapterReader));
+  reader->spans = spans;
+  reader->n_spans = n_spans;
+  for (i = 0; i < n_spans; i++)
+    reader->size += spans[i].size;
+
+  /* position on the first non-empty span */
+  while (reader->span < n_spans && spans[reader->span].size == 0)
+    reader->span++;
+}
+
+/**
+ * gst_adapter_reader_get_pos:
+ * @reader: a #GstAdapterReader
+ *
+ * Returns: the current position of @reader in bytes.
+ *
+ * Since: 1.20
+ */
+gsize
+gst_adapter_reader_get_pos (const GstAdapterReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, 0);
+
+  return reader->byte;
+}
+
+/**
+ * gst_adapter_reader_get_remaining:
+ * @reader: a #GstAdapterReader
+ *
+ * Returns: the number of bytes left to read from @reader.
+ *
+ * Since: 1.20
+ */
+gsize
+gst_adapter_reader_get_remaining (const GstAdapterReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, 0);
+
+  return reader->size - reader->byte;
+}
+
+static inline void
+gst_adapter_reader_skip_unchecked (GstAdapterReader * reader, gsize nbytes)
+{
+  reader->byte += nbytes;
+  reader->span_byte += nbytes;
+  while (reader->span < reader->n_spans &&
+      reader->span_byte >= reader->spans[reader->span].size) {
+    reader->span_byte -= reader->spans[reader->span].size;
+    reader->span++;
+  }
+}
+
+/**
+ * gst_adapter_reader_set_pos:
+ * @reader: a #GstAdapterReader
+ * @pos: the new position in bytes
+ *
+ * Sets the current position of @reader to @pos bytes from the start of the
+ * first span.
+ *
+ * Returns: %TRUE if the position could be set, %FALSE if @pos is past the
+ *     end of the data.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_set_pos (GstAdapterReader * reader, gsize pos)
+{
+  g_return_val_if_fail (reader != NULL, FALSE);
+
+  if (pos > reader->size)
+    return FALSE;
+
+  /* seeking forward continues from the current span */
+  if (pos < reader->byte) {
+    reader->byte = 0;
+    reader->span = 0;
+    reader->span_byte = 0;
+  }
+  gst_adapter_reader_skip_unchecked (reader, pos - reader->byte);
+
+  return TRUE;
+}
+
+/**
+ * gst_adapter_reader_skip:
+ * @reader: a #GstAdapterReader
+ * @nbytes: the number of bytes to skip
+ *
+ * Skips @nbytes bytes of @reader, crossing span boundaries as needed.
+ *
+ * Returns: %TRUE if @nbytes bytes could be skipped, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_skip (GstAdapterReader * reader, gsize nbytes)
+{
+  g_return_val_if_fail (reader != NULL, FALSE);
+
+  if (G_UNLIKELY (nbytes > reader->size - reader->byte))
+    return FALSE;
+
+  gst_adapter_reader_skip_unchecked (reader, nbytes);
+  return TRUE;
+}
+
+/**
+ * gst_adapter_reader_peek_data:
+ * @reader: a #GstAdapterReader
+ * @size: the number of bytes
+ * @val: (out) (transfer none) (array length=size): pointer to the data
+ *
+ * Returns a pointer to the next @size bytes of @reader without changing the
+ * position, if they are contiguous in memory. This is the case when they are
+ * all inside the current span. Use gst_adapter_reader_copy() to read data
+ * across span boundaries.
+ *
+ * Returns: %TRUE if the next @size bytes are contiguous, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_peek_data (const GstAdapterReader * reader, gsize size,
+    const guint8 ** val)
+{
+  const GstAdapterSpan *span;
+
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (val != NULL, FALSE);
+
+  if (G_UNLIKELY (reader->span >= reader->n_spans))
+    return FALSE;
+
+  span = &reader->spans[reader->span];
+  if (span->size - reader->span_byte < size)
+    return FALSE;
+
+  *val = span->data + reader->span_byte;
+  return TRUE;
+}
+
+static void
+gst_adapter_reader_copy_unchecked (const GstAdapterReader * reader,
+    guint8 * dest, gsize size)
+{
+  guint span = reader->span;
+  gsize skip = reader->span_byte;
+
+  while (size > 0) {
+    gsize csize = MIN (reader->spans[span].size - skip, size);
+
+    memcpy (dest, reader->spans[span].data + skip, csize);
+    dest += csize;
+    size -= csize;
+    skip = 0;
+    span++;
+  }
+}
+
+/**
+ * gst_adapter_reader_copy:
+ * @reader: a #GstAdapterReader
+ * @dest: (out caller-allocates) (array length=size) (element-type guint8):
+ *     the memory to copy into
+ * @size: the number of bytes to copy
+ *
+ * Copies the next @size bytes of @reader into @dest without changing the
+ * position.
+ *
+ * Returns: %TRUE if @size bytes were available, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_copy (const GstAdapterReader * reader, gpointer dest,
+    gsize size)
+{
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (dest != NULL || size == 0, FALSE);
+
+  if (G_UNLIKELY (size > reader->size - reader->byte))
+    return FALSE;
+
+  gst_adapter_reader_copy_unchecked (reader, dest, size);
+  return TRUE;
+}
+
+/* returns a pointer to the next @size bytes, using @tmp when they cross a
+ * span boundary */
+static inline const guint8 *
+gst_adapter_reader_peek_bytes (const GstAdapterReader * reader, guint8 * tmp,
+    gsize size)
+{
+  const GstAdapterSpan *span;
+
+  if (G_UNLIKELY (size > reader->size - reader->byte))
+    return NULL;
+
+  span = &reader->spans[reader->span];
+  if (G_LIKELY (span->size - reader->span_byte >= size))
+    return span->data + reader->span_byte;
+
+  gst_adapter_reader_copy_unchecked (reader, tmp, size);
+  return tmp;
+}
+
+/**
+ * gst_adapter_reader_peek_uint8:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned 8 bit integer without changing the position.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_peek_uint8 (const GstAdapterReader * reader, guint8 * val)
+{
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (val != NULL, FALSE);
+
+  if (G_UNLIKELY (reader->byte >= reader->size))
+    return FALSE;
+
+  *val = reader->spans[reader->span].data[reader->span_byte];
+  return TRUE;
+}
+
+/**
+ * gst_adapter_reader_get_uint8:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned 8 bit integer and updates the position.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_adapter_reader_get_uint8 (GstAdapterReader * reader, guint8 * val)
+{
+  if (!gst_adapter_reader_peek_uint8 (reader, val))
+    return FALSE;
+
+  gst_adapter_reader_skip_unchecked (reader, 1);
+  return TRUE;
+}
+
+#define GST_ADAPTER_READER_GET(bits,endianness,END) \
+gboolean \
+gst_adapter_reader_get_uint##bits##_##endianness (GstAdapterReader * reader, \
+    guint##bits * val) \
+{ \
+  guint8 tmp[bits / 8]; \
+  const guint8 *data; \
+  \
+  g_return_val_if_fail (reader != NULL, FALSE); \
+  g_return_val_if_fail (val != NULL, FALSE); \
+  \
+  data = gst_adapter_reader_peek_bytes (reader, tmp, bits / 8); \
+  if (G_UNLIKELY (data == NULL)) \
+    return FALSE; \
+  \
+  *val = GST_READ_UINT##bits##_##END (data); \
+  gst_adapter_reader_skip_unchecked (reader, bits / 8); \
+  return TRUE; \
+}
+
+/**
+ * gst_adapter_reader_get_uint16_be:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned big endian 16 bit integer and updates the position.
+ * The bytes may be spread over multiple spans.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+GST_ADAPTER_READER_GET (16, be, BE)
+
+/**
+ * gst_adapter_reader_get_uint16_le:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned little endian 16 bit integer and updates the position.
+ * The bytes may be spread over multiple spans.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+GST_ADAPTER_READER_GET (16, le, LE)
+
+/**
+ * gst_adapter_reader_get_uint32_be:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned big endian 32 bit integer and updates the position.
+ * The bytes may be spread over multiple spans.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+GST_ADAPTER_READER_GET (32, be, BE)
+
+/**
+ * gst_adapter_reader_get_uint32_le:
+ * @reader: a #GstAdapterReader
+ * @val: (out): location to store the value
+ *
+ * Reads an unsigned little endian 32 bit integer and updates the position.
+ * The bytes may be spread over multiple spans.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+GST_ADAPTER_READER_GET (32, le, LE)
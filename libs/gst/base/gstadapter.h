@@ -48,6 +48,45 @@ G_BEGIN_DECLS
 typedef struct _GstAdapter GstAdapter;
 typedef struct _GstAdapterClass GstAdapterClass;
 
+/**
+ * GstAdapterSpan:
+ * @data: (array length=size): the mapped bytes
+ * @size: the number of bytes at @data
+ *
+ * A contiguous piece of data as returned by gst_adapter_map_vectored().
+ *
+ * Since: 1.20
+ */
+typedef struct {
+  const guint8 *data;
+  gsize size;
+} GstAdapterSpan;
+
+/**
+ * GstAdapterReader:
+ * @spans: (array length=n_spans): the spans to read from
+ * @n_spans: the number of spans
+ * @size: the total number of bytes in all spans
+ * @byte: the current position in bytes
+ *
+ * Reads data from a set of #GstAdapterSpan, as returned by
+ * gst_adapter_map_vectored(), as if it was one contiguous memory area.
+ *
+ * Since: 1.20
+ */
+typedef struct {
+  const GstAdapterSpan *spans;
+  guint n_spans;
+  gsize size;
+  gsize byte;
+
+  /*< private >*/
+  guint span;
+  gsize span_byte;
+
+  gpointer _gst_reserved[GST_PADDING];
+} GstAdapterReader;
+
 GST_BASE_API
 GType                   gst_adapter_get_type            (void);
 
@@ -66,6 +105,12 @@ gconstpointer           gst_adapter_map                 (GstAdapter *adapter, gs
 GST_BASE_API
 void                    gst_adapter_unmap               (GstAdapter *adapter);
 
+GST_BASE_API
+const GstAdapterSpan *  gst_adapter_map_vectored        (GstAdapter *adapter, gsize offset,
+                                                         gsize size, guint *n_spans);
+GST_BASE_API
+void                    gst_adapter_unmap_vectored      (GstAdapter *adapter);
+
 GST_BASE_API
 void                    gst_adapter_copy                (GstAdapter *adapter, gpointer dest,
                                                          gsize offset, gsize size);
@@ -142,6 +187,46 @@ GST_BASE_API
 gssize                  gst_adapter_masked_scan_uint32_peek  (GstAdapter * adapter, guint32 mask,
                                                          guint32 pattern, gsize offset, gsize size, guint32 * value);
 
+GST_BASE_API
+void                    gst_adapter_reader_init          (GstAdapterReader *reader,
+                                                          const GstAdapterSpan *spans,
+                                                          guint n_spans);
+GST_BASE_API
+gsize                   gst_adapter_reader_get_pos       (const GstAdapterReader *reader);
+
+GST_BASE_API
+gsize                   gst_adapter_reader_get_remaining (const GstAdapterReader *reader);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_set_pos       (GstAdapterReader *reader, gsize pos);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_skip          (GstAdapterReader *reader, gsize nbytes);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_peek_data     (const GstAdapterReader *reader,
+                                                          gsize size, const guint8 **val);
+GST_BASE_API
+gboolean                gst_adapter_reader_copy          (const GstAdapterReader *reader,
+                                                          gpointer dest, gsize size);
+GST_BASE_API
+gboolean                gst_adapter_reader_get_uint8     (GstAdapterReader *reader, guint8 *val);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_peek_uint8    (const GstAdapterReader *reader, guint8 *val);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_get_uint16_be (GstAdapterReader *reader, guint16 *val);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_get_uint16_le (GstAdapterReader *reader, guint16 *val);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_get_uint32_be (GstAdapterReader *reader, guint32 *val);
+
+GST_BASE_API
+gboolean                gst_adapter_reader_get_uint32_le (GstAdapterReader *reader, guint32 *val);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstAdapter, gst_object_unref)
 
 G_END_DECLS
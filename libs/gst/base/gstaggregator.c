@@ -84,6 +84,11 @@
  *    sink and source pads.
  *    See gst_element_class_add_static_pad_template_with_gtype().
  *
+ * By default the aggregation runs in a dedicated streaming thread of the
+ * source pad. With the #GstAggregator:task-pool property it is instead
+ * scheduled on a #GstTaskPool shared with other elements, and only occupies
+ * a thread of the pool while there is data to aggregate.
+ *
  * This class used to live in gst-plugins-bad and was moved to core.
  *
  * Since: 1.14
@@ -242,8 +247,32 @@ GST_DEBUG_CATEGORY_STATIC (aggregator_debug);
     if (self->priv->aggregate_id)                                   \
       gst_clock_id_unschedule (self->priv->aggregate_id);           \
     g_cond_broadcast(&(self->priv->src_cond));                      \
+    if (self->priv->aggregate_pool)                                 \
+      gst_aggregator_schedule_aggregate (self);                     \
   } G_STMT_END
 
+/* What a sink pad has at the top of its queue, see
+ * gst_aggregator_check_pads_ready() */
+typedef enum
+{
+  PAD_STATE_EMPTY,              /* no data and not EOS */
+  PAD_STATE_EOS,                /* no data but EOS */
+  PAD_STATE_BUFFER,             /* a buffer or a clipped buffer */
+  PAD_STATE_EVENT_OR_QUERY,     /* a serialized event or query */
+  PAD_STATE_LAST
+} PadState;
+
+/* Number of sink pads in each state. The pads update it atomically with
+ * their PAD_LOCK held, so that the aggregator can check if all pads are
+ * ready without taking any pad lock. A new one is created whenever the sink
+ * pads of the aggregator change, removed pads then only update the old one
+ * they still hold a reference to. */
+typedef struct
+{
+  gint refcount;
+  gint n_pads[PAD_STATE_LAST];
+} PadCounts;
+
 struct _GstAggregatorPadPrivate
 {
   /* Following fields are protected by the PAD_LOCK */
@@ -259,6 +288,17 @@ struct _GstAggregatorPadPrivate
   guint num_buffers;
   GstBuffer *peeked_buffer;
 
+  PadState state;
+  PadCounts *counts;
+
+  /* statistics, see the stats property */
+  guint64 stats_buffers;
+  guint64 stats_late;
+  guint64 stats_missed;
+  gboolean stats_have_lateness;
+  GstClockTimeDiff stats_avg_lateness;
+  GstClockTimeDiff stats_max_lateness;
+
   /* used to track fill state of queues, only used with live-src and when
    * latency property is set to > 0 */
   GstClockTime head_position;
@@ -283,6 +323,61 @@ struct _GstAggregatorPadPrivate
   gboolean emit_signals;
 };
 
+static PadCounts *
+pad_counts_new (void)
+{
+  PadCounts *counts = g_new0 (PadCounts, 1);
+
+  counts->refcount = 1;
+
+  return counts;
+}
+
+static void
+pad_counts_unref (PadCounts * counts)
+{
+  if (g_atomic_int_dec_and_test (&counts->refcount))
+    g_free (counts);
+}
+
+/* Must be called with PAD_LOCK held */
+static PadState
+gst_aggregator_pad_get_state_unlocked (GstAggregatorPad * aggpad)
+{
+  gpointer item;
+
+  if (aggpad->priv->clipped_buffer)
+    return PAD_STATE_BUFFER;
+
+  item = g_queue_peek_tail (&aggpad->priv->data);
+  if (GST_IS_BUFFER (item))
+    return PAD_STATE_BUFFER;
+  if (GST_IS_EVENT (item) || GST_IS_QUERY (item))
+    return PAD_STATE_EVENT_OR_QUERY;
+
+  return aggpad->priv->eos ? PAD_STATE_EOS : PAD_STATE_EMPTY;
+}
+
+/* Must be called with PAD_LOCK held whenever the top of the queue, the
+ * clipped buffer or the EOS state changed */
+static void
+gst_aggregator_pad_update_state_unlocked (GstAggregatorPad * aggpad)
+{
+  PadState state = gst_aggregator_pad_get_state_unlocked (aggpad);
+  PadCounts *counts = aggpad->priv->counts;
+
+  if (state == aggpad->priv->state)
+    return;
+
+  /* count the new state first so that the aggregator never sees the pad in
+   * none of them, it might only see it in both */
+  if (counts) {
+    g_atomic_int_inc (&counts->n_pads[state]);
+    g_atomic_int_add (&counts->n_pads[aggpad->priv->state], -1);
+  }
+  aggpad->priv->state = state;
+}
+
 /* Must be called with PAD_LOCK held */
 static void
 gst_aggregator_pad_reset_unlocked (GstAggregatorPad * aggpad)
@@ -299,6 +394,7 @@ gst_aggregator_pad_reset_unlocked (GstAggregatorPad * aggpad)
   aggpad->priv->tail_time = GST_CLOCK_TIME_NONE;
   aggpad->priv->time_level = 0;
   aggpad->priv->first_buffer = TRUE;
+  gst_aggregator_pad_update_state_unlocked (aggpad);
 }
 
 static gboolean
@@ -388,6 +484,8 @@ struct _GstAggregatorPrivate
   GCond src_cond;
 
   gboolean first_buffer;        /* protected by object lock */
+  PadCounts *pad_counts;        /* protected by object lock */
+  guint32 pad_counts_cookie;    /* protected by object lock */
   GstAggregatorStartTimeSelection start_time_selection;
   GstClockTime start_time;
 
@@ -397,9 +495,20 @@ struct _GstAggregatorPrivate
   GstBufferPool *pool;
   GstAllocationParams allocation_params;
 
+  /* aggregating from a task pool instead of the srcpad task */
+  GstTaskPool *aggregate_pool;  /* set while the srcpad is active */
+  guint pool_jobs;              /* protected by src_lock */
+  gboolean pool_scheduled;      /* protected by src_lock */
+  gboolean pool_paused;         /* protected by src_lock */
+  gboolean pool_timed_out;      /* protected by src_lock */
+  gboolean pool_wait;           /* protected by srcpad stream lock */
+  GCond pool_cond;
+
   /* properties */
   gint64 latency;               /* protected by both src_lock and all pad locks */
   gboolean emit_signals;
+  GstTaskPool *task_pool;
+  guint quorum;                 /* protected by src_lock */
 };
 
 /* Seek event forwarding helper */
@@ -420,6 +529,10 @@ typedef struct
 #define DEFAULT_START_TIME_SELECTION GST_AGGREGATOR_START_TIME_SELECTION_ZERO
 #define DEFAULT_START_TIME           (-1)
 #define DEFAULT_EMIT_SIGNALS         FALSE
+#define DEFAULT_QUORUM               0
+
+/* aggregate cycles of a task pool work item before it yields the thread */
+#define POOL_AGGREGATE_BUDGET        16
 
 enum
 {
@@ -429,6 +542,8 @@ enum
   PROP_START_TIME_SELECTION,
   PROP_START_TIME,
   PROP_EMIT_SIGNALS,
+  PROP_TASK_POOL,
+  PROP_QUORUM,
   PROP_LAST
 };
 
@@ -442,6 +557,7 @@ static guint gst_aggregator_signals[LAST_SIGNAL] = { 0 };
 
 static GstFlowReturn gst_aggregator_pad_chain_internal (GstAggregator * self,
     GstAggregatorPad * aggpad, GstBuffer * buffer, gboolean head);
+static void gst_aggregator_schedule_aggregate (GstAggregator * self);
 
 static gboolean
 gst_aggregator_pad_queue_is_empty (GstAggregatorPad * pad)
@@ -450,77 +566,88 @@ gst_aggregator_pad_queue_is_empty (GstAggregatorPad * pad)
       pad->priv->clipped_buffer == NULL);
 }
 
+/* Must be called with the object lock held. Recounts the states of all sink
+ * pads if they changed since the last time */
+static void
+gst_aggregator_update_pad_counts (GstAggregator * self)
+{
+  GstElement *element = GST_ELEMENT_CAST (self);
+  PadCounts *counts;
+  GList *l;
+
+  if (self->priv->pad_counts
+      && self->priv->pad_counts_cookie == element->pads_cookie)
+    return;
+
+  GST_DEBUG_OBJECT (self, "sink pads changed, recounting pad states");
+
+  counts = pad_counts_new ();
+  for (l = element->sinkpads; l != NULL; l = l->next) {
+    GstAggregatorPad *pad = l->data;
+
+    PAD_LOCK (pad);
+    pad->priv->state = gst_aggregator_pad_get_state_unlocked (pad);
+    /* the pads counted before can already update it */
+    g_atomic_int_inc (&counts->n_pads[pad->priv->state]);
+    g_atomic_int_inc (&counts->refcount);
+    if (pad->priv->counts)
+      pad_counts_unref (pad->priv->counts);
+    pad->priv->counts = counts;
+    PAD_UNLOCK (pad);
+  }
+
+  if (self->priv->pad_counts)
+    pad_counts_unref (self->priv->pad_counts);
+  self->priv->pad_counts = counts;
+  self->priv->pad_counts_cookie = element->pads_cookie;
+}
+
 /* Will return FALSE if there's no buffer available on every non-EOS pad, or
  * if at least one of the pads has an event or query at the top of its queue.
  *
  * Only returns TRUE if all non-EOS pads have a buffer available at the top of
  * their queue or a clipped buffer already.
+ *
+ * This only looks at the number of pads in each state, which the pads keep
+ * up to date, so no pad lock has to be taken.
  */
 static gboolean
 gst_aggregator_check_pads_ready (GstAggregator * self,
     gboolean * have_event_or_query_ret)
 {
-  GstAggregatorPad *pad = NULL;
-  GList *l, *sinkpads;
-  gboolean have_buffer = TRUE;
+  PadCounts *counts;
   gboolean have_event_or_query = FALSE;
 
   GST_LOG_OBJECT (self, "checking pads");
 
   GST_OBJECT_LOCK (self);
 
-  sinkpads = GST_ELEMENT_CAST (self)->sinkpads;
-  if (sinkpads == NULL)
+  if (GST_ELEMENT_CAST (self)->sinkpads == NULL)
     goto no_sinkpads;
 
-  for (l = sinkpads; l != NULL; l = l->next) {
-    pad = l->data;
-
-    PAD_LOCK (pad);
-
-    /* If there's an event or query at the top of the queue and we don't yet
-     * have taken the top buffer out and stored it as clip_buffer, remember
-     * that and exit the loop. We first have to handle all events/queries
-     * before we handle any buffers. */
-    if (!pad->priv->clipped_buffer
-        && (GST_IS_EVENT (g_queue_peek_tail (&pad->priv->data))
-            || GST_IS_QUERY (g_queue_peek_tail (&pad->priv->data)))) {
-      PAD_UNLOCK (pad);
-      have_event_or_query = TRUE;
-      break;
-    }
-
-    /* Otherwise check if we have a clipped buffer or a buffer at the top of
-     * the queue, and if not then this pad is not ready unless it is also EOS */
-    if (!pad->priv->clipped_buffer
-        && !GST_IS_BUFFER (g_queue_peek_tail (&pad->priv->data))) {
-      /* We must not have any buffers at all in this pad then as otherwise we
-       * would've had an event/query at the top of the queue */
-      g_assert (pad->priv->num_buffers == 0);
-
-      /* Only consider this pad as worth waiting for if it's not already EOS.
-       * There's no point in waiting for buffers on EOS pads */
-      if (!pad->priv->eos)
-        have_buffer = FALSE;
-    } else if (self->priv->peer_latency_live) {
-      /* In live mode, having a single pad with buffers is enough to
-       * generate a start time from it. In non-live mode all pads need
-       * to have a buffer
-       */
-      self->priv->first_buffer = FALSE;
-    }
+  gst_aggregator_update_pad_counts (self);
+  counts = self->priv->pad_counts;
 
-    PAD_UNLOCK (pad);
-  }
+  /* In live mode, having a single pad with buffers is enough to
+   * generate a start time from it. In non-live mode all pads need
+   * to have a buffer
+   */
+  if (self->priv->peer_latency_live
+      && g_atomic_int_get (&counts->n_pads[PAD_STATE_BUFFER]) > 0)
+    self->priv->first_buffer = FALSE;
 
-  if (have_event_or_query)
+  /* We first have to handle all events/queries before we handle any
+   * buffers */
+  if (g_atomic_int_get (&counts->n_pads[PAD_STATE_EVENT_OR_QUERY]) > 0) {
+    have_event_or_query = TRUE;
     goto pad_not_ready_but_event_or_query;
+  }
 
-  if (!have_buffer)
+  /* There's no point in waiting for buffers on EOS pads */
+  if (g_atomic_int_get (&counts->n_pads[PAD_STATE_EMPTY]) > 0)
     goto pad_not_ready;
 
-  if (have_buffer)
-    self->priv->first_buffer = FALSE;
+  self->priv->first_buffer = FALSE;
 
   GST_OBJECT_UNLOCK (self);
   GST_LOG_OBJECT (self, "pads are ready");
@@ -542,7 +669,7 @@ no_sinkpads:
   }
 pad_not_ready:
   {
-    GST_LOG_OBJECT (pad, "pad not ready to be aggregated yet");
+    GST_LOG_OBJECT (self, "pads not ready to be aggregated yet");
     GST_OBJECT_UNLOCK (self);
 
     if (have_event_or_query_ret)
@@ -552,8 +679,8 @@ pad_not_ready:
   }
 pad_not_ready_but_event_or_query:
   {
-    GST_LOG_OBJECT (pad,
-        "pad not ready to be aggregated yet, need to handle serialized event or query first");
+    GST_LOG_OBJECT (self,
+        "pads not ready to be aggregated yet, need to handle serialized event or query first");
     GST_OBJECT_UNLOCK (self);
 
     if (have_event_or_query_ret)
@@ -762,6 +889,55 @@ gst_aggregator_get_next_time (GstAggregator * self)
   return GST_CLOCK_TIME_NONE;
 }
 
+/* Must be called with the src_lock held when aggregating without waiting
+ * for all pads */
+static void
+gst_aggregator_count_missed_pads (GstAggregator * self)
+{
+  GList *l;
+
+  GST_OBJECT_LOCK (self);
+  for (l = GST_ELEMENT_CAST (self)->sinkpads; l != NULL; l = l->next) {
+    GstAggregatorPad *pad = l->data;
+
+    PAD_LOCK (pad);
+    if (pad->priv->state == PAD_STATE_EMPTY)
+      pad->priv->stats_missed++;
+    PAD_UNLOCK (pad);
+  }
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Must be called with the src_lock and the object lock held */
+static gboolean
+gst_aggregator_quorum_reached_unlocked (GstAggregator * self)
+{
+  PadCounts *counts = self->priv->pad_counts;
+
+  if (self->priv->quorum == 0 || counts == NULL)
+    return FALSE;
+
+  return g_atomic_int_get (&counts->n_pads[PAD_STATE_BUFFER]) >=
+      self->priv->quorum;
+}
+
+static gboolean
+gst_aggregator_clock_callback (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstAggregator *self = user_data;
+
+  SRC_LOCK (self);
+  /* the wait of a previous work item might still fire */
+  if (self->priv->aggregate_id == id) {
+    self->priv->pool_timed_out = TRUE;
+    gst_aggregator_schedule_aggregate (self);
+  }
+  SRC_UNLOCK (self);
+
+  return TRUE;
+}
+
 static gboolean
 gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 {
@@ -774,6 +950,26 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 
   SRC_LOCK (self);
 
+  /* with a task pool, a previous work item might have started an
+   * asynchronous clock wait that either timed out or was unscheduled because
+   * something happened in the meantime */
+  if (self->priv->aggregate_id && self->priv->aggregate_pool) {
+    gboolean timed_out = self->priv->pool_timed_out;
+
+    gst_clock_id_unschedule (self->priv->aggregate_id);
+    gst_clock_id_unref (self->priv->aggregate_id);
+    self->priv->aggregate_id = NULL;
+    self->priv->pool_timed_out = FALSE;
+
+    if (timed_out) {
+      GST_DEBUG_OBJECT (self, "clock wait timed out");
+      gst_aggregator_count_missed_pads (self);
+      SRC_UNLOCK (self);
+      *timeout = TRUE;
+      return TRUE;
+    }
+  }
+
   latency = gst_aggregator_get_latency_unlocked (self);
 
   if (gst_aggregator_check_pads_ready (self, &have_event_or_query)) {
@@ -819,6 +1015,12 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
      * we will be directly called again.
      */
     GST_OBJECT_UNLOCK (self);
+    if (self->priv->aggregate_pool) {
+      /* SRC_BROADCAST schedules a new work item */
+      self->priv->pool_wait = TRUE;
+      SRC_UNLOCK (self);
+      return FALSE;
+    }
     SRC_WAIT (self);
   } else {
     GstClockTime base_time, time;
@@ -829,6 +1031,17 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
     GST_DEBUG_OBJECT (self, "got subclass start time: %" GST_TIME_FORMAT,
         GST_TIME_ARGS (start));
 
+    /* don't let the late pads hold back the others */
+    if (gst_aggregator_quorum_reached_unlocked (self)) {
+      GST_OBJECT_UNLOCK (self);
+      GST_DEBUG_OBJECT (self, "%u pads have data, not waiting for the others",
+          self->priv->quorum);
+      gst_aggregator_count_missed_pads (self);
+      SRC_UNLOCK (self);
+      *timeout = TRUE;
+      return TRUE;
+    }
+
     base_time = GST_ELEMENT_CAST (self)->base_time;
     clock = gst_object_ref (GST_ELEMENT_CLOCK (self));
     GST_OBJECT_UNLOCK (self);
@@ -846,6 +1059,19 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 
     self->priv->aggregate_id = gst_clock_new_single_shot_id (clock, time);
     gst_object_unref (clock);
+
+    if (self->priv->aggregate_pool) {
+      GstClockID id = gst_clock_id_ref (self->priv->aggregate_id);
+
+      /* the callback schedules a new work item once the clock reached the
+       * deadline, SRC_BROADCAST does so when something happened before */
+      self->priv->pool_wait = TRUE;
+      SRC_UNLOCK (self);
+      gst_clock_id_wait_async (id, gst_aggregator_clock_callback,
+          gst_object_ref (self), (GDestroyNotify) gst_object_unref);
+      gst_clock_id_unref (id);
+      return FALSE;
+    }
     SRC_UNLOCK (self);
 
     jitter = 0;
@@ -863,6 +1089,7 @@ gst_aggregator_wait_and_check (GstAggregator * self, gboolean * timeout)
 
     /* we timed out */
     if (status == GST_CLOCK_OK || status == GST_CLOCK_EARLY) {
+      gst_aggregator_count_missed_pads (self);
       SRC_UNLOCK (self);
       *timeout = TRUE;
       return TRUE;
@@ -939,6 +1166,7 @@ gst_aggregator_do_events_and_queries (GstElement * self, GstPad * epad,
         }
       }
 
+      gst_aggregator_pad_update_state_unlocked (pad);
       PAD_BROADCAST_EVENT (pad);
       PAD_UNLOCK (pad);
     }
@@ -979,6 +1207,7 @@ gst_aggregator_pad_skip_buffers (GstElement * self, GstPad * epad,
     item = prev;
   }
 
+  gst_aggregator_pad_update_state_unlocked (aggpad);
   PAD_UNLOCK (aggpad);
 
   return TRUE;
@@ -1031,6 +1260,7 @@ gst_aggregator_pad_set_flushing (GstAggregatorPad * aggpad,
   }
   aggpad->priv->num_buffers = 0;
   gst_buffer_replace (&aggpad->priv->clipped_buffer, NULL);
+  gst_aggregator_pad_update_state_unlocked (aggpad);
 
   PAD_BROADCAST_EVENT (aggpad);
   PAD_UNLOCK (aggpad);
@@ -1311,6 +1541,7 @@ gst_aggregator_aggregate_func (GstAggregator * self)
   GstAggregatorPrivate *priv = self->priv;
   GstAggregatorClass *klass = GST_AGGREGATOR_GET_CLASS (self);
   gboolean timeout = FALSE;
+  guint n_cycles = 0;
 
   if (self->priv->running == FALSE) {
     GST_DEBUG_OBJECT (self, "Not running anymore");
@@ -1322,6 +1553,14 @@ gst_aggregator_aggregate_func (GstAggregator * self)
     GstFlowReturn flow_return = GST_FLOW_OK;
     DoHandleEventsAndQueriesData events_query_data = { FALSE, GST_FLOW_OK };
 
+    /* let the other work items of the pool run before we continue */
+    if (priv->aggregate_pool && n_cycles++ == POOL_AGGREGATE_BUDGET) {
+      SRC_LOCK (self);
+      gst_aggregator_schedule_aggregate (self);
+      SRC_UNLOCK (self);
+      return;
+    }
+
     gst_element_foreach_sink_pad (GST_ELEMENT_CAST (self),
         gst_aggregator_do_events_and_queries, &events_query_data);
 
@@ -1337,6 +1576,11 @@ gst_aggregator_aggregate_func (GstAggregator * self)
     if (!gst_aggregator_wait_and_check (self, &timeout)) {
       gst_element_foreach_sink_pad (GST_ELEMENT_CAST (self),
           gst_aggregator_pad_reset_peeked_buffer, NULL);
+      /* nothing to do until a new work item is scheduled */
+      if (priv->pool_wait) {
+        priv->pool_wait = FALSE;
+        return;
+      }
       continue;
     }
 
@@ -1406,7 +1650,79 @@ gst_aggregator_aggregate_func (GstAggregator * self)
    *    would otherwise call the task function over and over
    *    again without doing anything
    */
-  gst_pad_pause_task (self->srcpad);
+  if (priv->aggregate_pool) {
+    SRC_LOCK (self);
+    priv->pool_paused = TRUE;
+    SRC_UNLOCK (self);
+  } else {
+    gst_pad_pause_task (self->srcpad);
+  }
+}
+
+/* runs gst_aggregator_aggregate_func() from a task pool thread. It holds the
+ * srcpad stream lock like the srcpad task would */
+static void
+gst_aggregator_pool_func (gpointer user_data)
+{
+  GstAggregator *self = user_data;
+
+  GST_PAD_STREAM_LOCK (self->srcpad);
+
+  /* anything happening from now on needs another work item */
+  SRC_LOCK (self);
+  self->priv->pool_scheduled = FALSE;
+  SRC_UNLOCK (self);
+
+  gst_aggregator_aggregate_func (self);
+
+  GST_PAD_STREAM_UNLOCK (self->srcpad);
+
+  SRC_LOCK (self);
+  self->priv->pool_jobs--;
+  g_cond_broadcast (&self->priv->pool_cond);
+  SRC_UNLOCK (self);
+
+  gst_object_unref (self);
+}
+
+/* schedule a work item on the task pool if none is pending yet. Must be
+ * called with the src_lock held */
+static void
+gst_aggregator_schedule_aggregate (GstAggregator * self)
+{
+  GstAggregatorPrivate *priv = self->priv;
+  GError *err = NULL;
+  gpointer id;
+
+  if (priv->pool_scheduled || priv->pool_paused || !priv->running)
+    return;
+
+  priv->pool_scheduled = TRUE;
+  priv->pool_jobs++;
+  id = gst_task_pool_push (priv->aggregate_pool, gst_aggregator_pool_func,
+      gst_object_ref (self), &err);
+  if (G_UNLIKELY (err != NULL))
+    goto push_failed;
+
+  if (id)
+    gst_task_pool_dispose_handle (priv->aggregate_pool, id);
+
+  return;
+
+  /* ERRORS */
+push_failed:
+  {
+    GST_ELEMENT_ERROR (self, CORE, THREAD,
+        ("Failed to schedule aggregation on the task pool."),
+        ("%s", err->message));
+    g_error_free (err);
+    gst_object_unref (self);
+    priv->pool_scheduled = FALSE;
+    priv->pool_jobs--;
+    priv->pool_paused = TRUE;
+    g_cond_broadcast (&priv->pool_cond);
+    return;
+  }
 }
 
 static gboolean
@@ -1453,7 +1769,21 @@ gst_aggregator_stop_srcpad_task (GstAggregator * self, GstEvent * flush_start)
     res = gst_pad_push_event (self->srcpad, flush_start);
   }
 
-  gst_pad_stop_task (self->srcpad);
+  if (self->priv->aggregate_pool) {
+    /* wait for the scheduled and running work items */
+    SRC_LOCK (self);
+    while (self->priv->pool_jobs > 0)
+      g_cond_wait (&self->priv->pool_cond, &self->priv->src_lock);
+    if (self->priv->aggregate_id) {
+      gst_clock_id_unschedule (self->priv->aggregate_id);
+      gst_clock_id_unref (self->priv->aggregate_id);
+      self->priv->aggregate_id = NULL;
+    }
+    self->priv->pool_timed_out = FALSE;
+    SRC_UNLOCK (self);
+  } else {
+    gst_pad_stop_task (self->srcpad);
+  }
 
   return res;
 }
@@ -1463,6 +1793,22 @@ gst_aggregator_start_srcpad_task (GstAggregator * self)
 {
   GST_INFO_OBJECT (self, "Starting srcpad task");
 
+  if (!self->priv->aggregate_pool) {
+    GST_OBJECT_LOCK (self);
+    if (self->priv->task_pool)
+      self->priv->aggregate_pool = gst_object_ref (self->priv->task_pool);
+    GST_OBJECT_UNLOCK (self);
+  }
+
+  if (self->priv->aggregate_pool) {
+    SRC_LOCK (self);
+    self->priv->running = TRUE;
+    self->priv->pool_paused = FALSE;
+    gst_aggregator_schedule_aggregate (self);
+    SRC_UNLOCK (self);
+    return;
+  }
+
   self->priv->running = TRUE;
   gst_pad_start_task (GST_PAD (self->srcpad),
       (GstTaskFunction) gst_aggregator_aggregate_func, self, NULL);
@@ -1660,6 +2006,7 @@ gst_aggregator_default_sink_event (GstAggregator * self,
       PAD_LOCK (aggpad);
       g_assert (aggpad->priv->num_buffers == 0);
       aggpad->priv->eos = TRUE;
+      gst_aggregator_pad_update_state_unlocked (aggpad);
       PAD_UNLOCK (aggpad);
       SRC_BROADCAST (self);
       SRC_UNLOCK (self);
@@ -1725,6 +2072,7 @@ gst_aggregator_default_sink_event (GstAggregator * self,
       PAD_LOCK (aggpad);
       if (g_queue_peek_tail (&aggpad->priv->data) == event)
         gst_event_unref (g_queue_pop_tail (&aggpad->priv->data));
+      gst_aggregator_pad_update_state_unlocked (aggpad);
       PAD_UNLOCK (aggpad);
 
       if (gst_aggregator_pad_chain_internal (self, aggpad, gapbuf, FALSE) !=
@@ -1782,6 +2130,7 @@ gst_aggregator_default_sink_event_pre_queue (GstAggregator * self,
 
     GST_DEBUG_OBJECT (aggpad, "Store event in queue: %" GST_PTR_FORMAT, event);
     g_queue_push_head (&aggpad->priv->data, event);
+    gst_aggregator_pad_update_state_unlocked (aggpad);
     SRC_BROADCAST (self);
     PAD_UNLOCK (aggpad);
     SRC_UNLOCK (self);
@@ -1820,6 +2169,12 @@ gst_aggregator_stop_pad (GstElement * self, GstPad * epad, gpointer user_data)
   PAD_LOCK (pad);
   pad->priv->flow_return = GST_FLOW_FLUSHING;
   pad->priv->negotiated = FALSE;
+  pad->priv->stats_buffers = 0;
+  pad->priv->stats_late = 0;
+  pad->priv->stats_missed = 0;
+  pad->priv->stats_have_lateness = FALSE;
+  pad->priv->stats_avg_lateness = 0;
+  pad->priv->stats_max_lateness = 0;
   PAD_BROADCAST_EVENT (pad);
   PAD_UNLOCK (pad);
 
@@ -2449,6 +2804,7 @@ gst_aggregator_src_pad_activate_mode_func (GstPad * pad,
   GST_INFO_OBJECT (self, "Deactivating srcpad");
 
   gst_aggregator_stop_srcpad_task (self, FALSE);
+  gst_clear_object (&self->priv->aggregate_pool);
 
   return TRUE;
 }
@@ -2518,6 +2874,7 @@ gst_aggregator_default_sink_query_pre_queue (GstAggregator * self,
     }
 
     g_queue_push_head (&aggpad->priv->data, query);
+    gst_aggregator_pad_update_state_unlocked (aggpad);
     SRC_BROADCAST (self);
     SRC_UNLOCK (self);
 
@@ -2532,6 +2889,7 @@ gst_aggregator_default_sink_query_pre_queue (GstAggregator * self,
       gst_structure_remove_field (s, "gst-aggregator-retval");
     else
       g_queue_remove (&aggpad->priv->data, query);
+    gst_aggregator_pad_update_state_unlocked (aggpad);
 
     if (aggpad->priv->flow_return != GST_FLOW_OK)
       goto flushing;
@@ -2560,6 +2918,13 @@ gst_aggregator_finalize (GObject * object)
 
   g_mutex_clear (&self->priv->src_lock);
   g_cond_clear (&self->priv->src_cond);
+  g_cond_clear (&self->priv->pool_cond);
+
+  if (self->priv->pad_counts)
+    pad_counts_unref (self->priv->pad_counts);
+
+  gst_clear_object (&self->priv->aggregate_pool);
+  gst_clear_object (&self->priv->task_pool);
 
   G_OBJECT_CLASS (aggregator_parent_class)->finalize (object);
 }
@@ -2663,6 +3028,18 @@ gst_aggregator_set_property (GObject * object, guint prop_id,
     case PROP_EMIT_SIGNALS:
       agg->priv->emit_signals = g_value_get_boolean (value);
       break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (agg);
+      gst_object_replace ((GstObject **) & agg->priv->task_pool,
+          g_value_get_object (value));
+      GST_OBJECT_UNLOCK (agg);
+      break;
+    case PROP_QUORUM:
+      SRC_LOCK (agg);
+      agg->priv->quorum = g_value_get_uint (value);
+      SRC_BROADCAST (agg);
+      SRC_UNLOCK (agg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2693,6 +3070,16 @@ gst_aggregator_get_property (GObject * object, guint prop_id,
     case PROP_EMIT_SIGNALS:
       g_value_set_boolean (value, agg->priv->emit_signals);
       break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (agg);
+      g_value_set_object (value, agg->priv->task_pool);
+      GST_OBJECT_UNLOCK (agg);
+      break;
+    case PROP_QUORUM:
+      SRC_LOCK (agg);
+      g_value_set_uint (value, agg->priv->quorum);
+      SRC_UNLOCK (agg);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2798,6 +3185,49 @@ gst_aggregator_class_init (GstAggregatorClass * klass)
           "Send signals", DEFAULT_EMIT_SIGNALS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAggregator:task-pool:
+   *
+   * A #GstTaskPool, for example a #GstSharedTaskPool, to aggregate from
+   * instead of a dedicated streaming thread. A work item is scheduled on the
+   * pool whenever data arrives on a sink pad or, when live, once the clock
+   * reaches the aggregation deadline, which is waited for asynchronously.
+   * The timeout behaviour is the same as with the dedicated thread.
+   *
+   * The pool must have been prepared with gst_task_pool_prepare(). Note
+   * that a work item blocks its pool thread while downstream blocks, so
+   * the pool needs enough threads for all aggregators that can block at the
+   * same time.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_POOL,
+      g_param_spec_object ("task-pool", "Task pool",
+          "Task pool to aggregate from instead of a dedicated thread "
+          "(NULL = dedicated thread)", GST_TYPE_TASK_POOL,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAggregator:quorum:
+   *
+   * In live mode, aggregate as soon as at least this many sink pads have
+   * data instead of waiting until the deadline for the other pads, as if
+   * the deadline was reached already. This lowers the latency when some
+   * inputs are consistently late, at the cost of aggregating without them.
+   *
+   * 0 disables this and always waits for all pads or the deadline. How late
+   * the inputs are can be seen in the #GstAggregatorPad:stats.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QUORUM,
+      g_param_spec_uint ("quorum", "Quorum",
+          "Number of pads with data to aggregate without waiting for the "
+          "others in live mode (0 = wait for all pads)", 0, G_MAXUINT,
+          DEFAULT_QUORUM, G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
   /**
    * GstAggregator::samples-selected:
    * @aggregator: The #GstAggregator that emitted the signal
@@ -2879,6 +3309,7 @@ gst_aggregator_init (GstAggregator * self, GstAggregatorClass * klass)
 
   g_mutex_init (&self->priv->src_lock);
   g_cond_init (&self->priv->src_cond);
+  g_cond_init (&self->priv->pool_cond);
 }
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
@@ -2977,6 +3408,49 @@ apply_buffer (GstAggregatorPad * aggpad, GstBuffer * buffer, gboolean head)
  * Because of this second case, FLUSH_LOCK can't be used here.
  */
 
+/* Must be called with the src_lock, the object lock and the PAD_LOCK held
+ * when @buffer was queued */
+static void
+gst_aggregator_pad_update_stats_unlocked (GstAggregator * self,
+    GstAggregatorPad * aggpad, GstBuffer * buffer)
+{
+  GstAggregatorPadPrivate *priv = aggpad->priv;
+  GstClockTime pts, running_time, base_time, now, latency;
+  GstClockTimeDiff lateness;
+  GstClock *clock;
+
+  priv->stats_buffers++;
+
+  /* lateness is only meaningful against the clock when live */
+  clock = GST_ELEMENT_CLOCK (self);
+  pts = GST_BUFFER_PTS (buffer);
+  if (!self->priv->peer_latency_live || clock == NULL ||
+      !GST_CLOCK_TIME_IS_VALID (pts) ||
+      priv->head_segment.format != GST_FORMAT_TIME)
+    return;
+
+  running_time = gst_segment_to_running_time (&priv->head_segment,
+      GST_FORMAT_TIME, pts);
+  base_time = GST_ELEMENT_CAST (self)->base_time;
+  now = gst_clock_get_time (clock);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time) || now < base_time)
+    return;
+
+  lateness = GST_CLOCK_DIFF (running_time, now - base_time);
+  if (!priv->stats_have_lateness) {
+    priv->stats_avg_lateness = priv->stats_max_lateness = lateness;
+    priv->stats_have_lateness = TRUE;
+  } else {
+    priv->stats_avg_lateness = (7 * priv->stats_avg_lateness + lateness) / 8;
+    priv->stats_max_lateness = MAX (priv->stats_max_lateness, lateness);
+  }
+
+  /* arrived after the deadline of the aggregation it belongs to */
+  latency = gst_aggregator_get_latency_unlocked (self);
+  if (GST_CLOCK_TIME_IS_VALID (latency) && lateness > (GstClockTimeDiff) latency)
+    priv->stats_late++;
+}
+
 static GstFlowReturn
 gst_aggregator_pad_chain_internal (GstAggregator * self,
     GstAggregatorPad * aggpad, GstBuffer * buffer, gboolean head)
@@ -3011,7 +3485,10 @@ gst_aggregator_pad_chain_internal (GstAggregator * self,
         g_queue_push_tail (&aggpad->priv->data, buffer);
       apply_buffer (aggpad, buffer, head);
       aggpad->priv->num_buffers++;
+      if (head)
+        gst_aggregator_pad_update_stats_unlocked (self, aggpad, buffer);
       buffer = NULL;
+      gst_aggregator_pad_update_state_unlocked (aggpad);
       SRC_BROADCAST (self);
       break;
     }
@@ -3168,6 +3645,7 @@ enum
 {
   PAD_PROP_0,
   PAD_PROP_EMIT_SIGNALS,
+  PAD_PROP_STATS,
 };
 
 enum
@@ -3201,6 +3679,8 @@ gst_aggregator_pad_finalize (GObject * object)
   GstAggregatorPad *pad = (GstAggregatorPad *) object;
 
   gst_buffer_replace (&pad->priv->peeked_buffer, NULL);
+  if (pad->priv->counts)
+    pad_counts_unref (pad->priv->counts);
   g_cond_clear (&pad->priv->event_cond);
   g_mutex_clear (&pad->priv->flush_lock);
   g_mutex_clear (&pad->priv->lock);
@@ -3244,6 +3724,18 @@ gst_aggregator_pad_get_property (GObject * object, guint prop_id,
     case PAD_PROP_EMIT_SIGNALS:
       g_value_set_boolean (value, pad->priv->emit_signals);
       break;
+    case PAD_PROP_STATS:
+      PAD_LOCK (pad);
+      g_value_take_boxed (value,
+          gst_structure_new ("application/x-gst-aggregator-pad-stats",
+              "buffers", G_TYPE_UINT64, pad->priv->stats_buffers,
+              "late", G_TYPE_UINT64, pad->priv->stats_late,
+              "missed", G_TYPE_UINT64, pad->priv->stats_missed,
+              "average-lateness", G_TYPE_INT64, pad->priv->stats_avg_lateness,
+              "max-lateness", G_TYPE_INT64, pad->priv->stats_max_lateness,
+              NULL));
+      PAD_UNLOCK (pad);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3288,6 +3780,31 @@ gst_aggregator_pad_class_init (GstAggregatorPadClass * klass)
       g_param_spec_boolean ("emit-signals", "Emit signals",
           "Send signals to signal data consumption", DEFAULT_PAD_EMIT_SIGNALS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAggregatorPad:stats:
+   *
+   * Various statistics about the data arriving on the pad. This property
+   * returns a #GstStructure with name
+   * `application/x-gst-aggregator-pad-stats` with the following fields:
+   *
+   * - "buffers" G_TYPE_UINT64   Number of buffers queued on the pad
+   * - "late" G_TYPE_UINT64   Number of buffers that arrived after the
+   *   deadline for aggregating them
+   * - "missed" G_TYPE_UINT64   Number of times the aggregator did not wait
+   *   for the pad, because of the deadline or the #GstAggregator:quorum
+   * - "average-lateness" G_TYPE_INT64   Running average of how much later
+   *   than their running time the buffers arrived, in nanoseconds
+   * - "max-lateness" G_TYPE_INT64   Maximum lateness, in nanoseconds
+   *
+   * Lateness is only measured in live mode.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PAD_PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Pad Statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -3342,6 +3859,7 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
       self = GST_AGGREGATOR (gst_pad_get_parent_element (GST_PAD (pad)));
       if (self == NULL) {
         gst_buffer_unref (buffer);
+        gst_aggregator_pad_update_state_unlocked (pad);
         return;
       }
 
@@ -3362,6 +3880,8 @@ gst_aggregator_pad_clip_buffer_unlocked (GstAggregatorPad * pad)
     pad->priv->clipped_buffer = buffer;
   }
 
+  gst_aggregator_pad_update_state_unlocked (pad);
+
   if (self)
     gst_object_unref (self);
 }
@@ -3407,6 +3927,7 @@ done:
       gst_aggregator_pad_buffer_consumed (pad, buffer, TRUE);
       pad->priv->clipped_buffer = NULL;
       gst_buffer_replace (&pad->priv->peeked_buffer, NULL);
+      gst_aggregator_pad_update_state_unlocked (pad);
     } else {
       /* Here our clipped buffer has already been released, for
        * example because of a flush. We thus transfer the reference
@@ -3562,9 +4083,15 @@ gst_aggregator_merge_tags (GstAggregator * self,
   if (tags)
     GST_DEBUG_OBJECT (self, "merging tags %" GST_PTR_FORMAT, tags);
   otags = self->priv->tags;
-  self->priv->tags = gst_tag_list_merge (self->priv->tags, tags, mode);
-  if (otags)
-    gst_tag_list_unref (otags);
+  if (otags && tags) {
+    /* merge in place unless the list is still used elsewhere */
+    self->priv->tags = gst_tag_list_make_writable (otags);
+    gst_tag_list_insert (self->priv->tags, tags, mode);
+  } else {
+    self->priv->tags = gst_tag_list_merge (otags, tags, mode);
+    if (otags)
+      gst_tag_list_unref (otags);
+  }
   self->priv->tags_changed = TRUE;
   GST_OBJECT_UNLOCK (self);
 }
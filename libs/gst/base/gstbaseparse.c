@@ -179,6 +179,8 @@
 #include <string.h>
 
 #include <gst/base/gstadapter.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstbytewriter.h>
 
 #include "gstbaseparse.h"
 
@@ -289,6 +291,8 @@ struct _GstBaseParsePrivate
   GstClockTime index_last_ts;
   gint64 index_last_offset;
   gboolean index_last_valid;
+  /* loaded with gst_base_parse_load_index() before the index existed */
+  GBytes *pending_index;
 
   /* timestamps currently produced are accurate, e.g. started from 0 onwards */
   gboolean exact_position;
@@ -343,6 +347,11 @@ struct _GstBaseParsePrivate
 
   /* Current segment seqnum */
   guint32 segment_seqnum;
+
+  /* buffers collected by gst_base_parse_finish_frames() and the flow of
+   * the lists pushed so far */
+  GstBufferList *out_list;
+  GstFlowReturn out_list_ret;
 };
 
 typedef struct _GstBaseParseSeek
@@ -478,6 +487,7 @@ static inline GstFlowReturn gst_base_parse_check_sync (GstBaseParse * parse);
 static gboolean gst_base_parse_is_seekable (GstBaseParse * parse);
 
 static void gst_base_parse_push_pending_events (GstBaseParse * parse);
+static void gst_base_parse_push_out_list (GstBaseParse * parse);
 
 static void
 gst_base_parse_clear_queues (GstBaseParse * parse)
@@ -525,6 +535,10 @@ gst_base_parse_finalize (GObject * object)
     gst_object_unref (parse->priv->index);
     parse->priv->index = NULL;
   }
+  if (parse->priv->pending_index) {
+    g_bytes_unref (parse->priv->pending_index);
+    parse->priv->pending_index = NULL;
+  }
   g_mutex_clear (&parse->priv->index_lock);
 
   gst_base_parse_clear_queues (parse);
@@ -2064,6 +2078,237 @@ exit:
   return ret;
 }
 
+/* Serialized index: a header of the magic, version, number of entries and
+ * upstream size in bytes (0 if unknown), followed by the time and byte
+ * offset of every key unit entry, sorted by time. All little endian. */
+#define INDEX_MAGIC "GstBPIdx"
+#define INDEX_VERSION 1
+#define INDEX_HEADER_SIZE 24
+#define INDEX_ENTRY_SIZE 16
+
+typedef struct
+{
+  guint64 ts;
+  guint64 offset;
+} GstBaseParseIndexEntry;
+
+static void
+gst_base_parse_collect_index_entry (GstIndexEntry * entry, GArray * entries)
+{
+  GstBaseParseIndexEntry e;
+  gint64 ts, offset;
+
+  if (entry->type != GST_INDEX_ENTRY_ASSOCIATION ||
+      !(GST_INDEX_ASSOC_FLAGS (entry) & GST_INDEX_ASSOCIATION_FLAG_KEY_UNIT))
+    return;
+
+  if (!gst_index_entry_assoc_map (entry, GST_FORMAT_TIME, &ts) ||
+      !gst_index_entry_assoc_map (entry, GST_FORMAT_BYTES, &offset))
+    return;
+
+  e.ts = ts;
+  e.offset = offset;
+  g_array_append_val (entries, e);
+}
+
+static gint
+gst_base_parse_index_entry_compare (gconstpointer a, gconstpointer b)
+{
+  const GstBaseParseIndexEntry *ea = a, *eb = b;
+
+  if (ea->ts != eb->ts)
+    return ea->ts < eb->ts ? -1 : 1;
+  if (ea->offset != eb->offset)
+    return ea->offset < eb->offset ? -1 : 1;
+  return 0;
+}
+
+/* must be called with the INDEX_LOCK and a valid index */
+static void
+gst_base_parse_apply_index (GstBaseParse * parse, GBytes * data)
+{
+  GstIndexAssociation associations[2];
+  GstByteReader reader;
+  gsize size;
+  guint32 n_entries;
+
+  gst_byte_reader_init (&reader, g_bytes_get_data (data, &size), size);
+  gst_byte_reader_skip_unchecked (&reader, 12);
+  n_entries = gst_byte_reader_get_uint32_le_unchecked (&reader);
+  gst_byte_reader_skip_unchecked (&reader, 8);
+
+  GST_DEBUG_OBJECT (parse, "adding %u index entries", n_entries);
+
+  associations[0].format = GST_FORMAT_TIME;
+  associations[1].format = GST_FORMAT_BYTES;
+  while (n_entries--) {
+    associations[0].value = gst_byte_reader_get_uint64_le_unchecked (&reader);
+    associations[1].value = gst_byte_reader_get_uint64_le_unchecked (&reader);
+    gst_index_add_associationv (parse->priv->index, parse->priv->index_id,
+        GST_INDEX_ASSOCIATION_FLAG_KEY_UNIT, 2,
+        (const GstIndexAssociation *) &associations);
+  }
+
+  /* the index now consists of several intervals, so new entries have to be
+   * checked against all existing ones */
+  parse->priv->index_last_valid = FALSE;
+  parse->priv->index_last_offset = 0;
+  parse->priv->index_last_ts = 0;
+}
+
+/**
+ * gst_base_parse_save_index:
+ * @parse: #GstBaseParse.
+ *
+ * Serializes the key unit entries of the seek index that @parse collected so
+ * far, for example while playing a file, into a compact binary form. It can
+ * be stored by the application, keyed by the identity of the stream such as
+ * a hash of the file, and loaded again with gst_base_parse_load_index() when
+ * the same stream is opened again, so that seeking is fast right away.
+ *
+ * Returns: (transfer full) (nullable): the serialized index, or %NULL if
+ *     @parse has no index.
+ *
+ * Since: 1.20
+ */
+GBytes *
+gst_base_parse_save_index (GstBaseParse * parse)
+{
+  GstBaseParseIndexEntry *e, *last = NULL;
+  GstByteWriter writer;
+  GArray *entries;
+  guint i, n_entries = 0;
+
+  g_return_val_if_fail (GST_IS_BASE_PARSE (parse), NULL);
+
+  entries = g_array_new (FALSE, FALSE, sizeof (GstBaseParseIndexEntry));
+
+  GST_BASE_PARSE_INDEX_LOCK (parse);
+  if (!parse->priv->index) {
+    GST_BASE_PARSE_INDEX_UNLOCK (parse);
+    g_array_free (entries, TRUE);
+    return NULL;
+  }
+  gst_mem_index_foreach_association (parse->priv->index,
+      parse->priv->index_id, (GFunc) gst_base_parse_collect_index_entry,
+      entries);
+  GST_BASE_PARSE_INDEX_UNLOCK (parse);
+
+  g_array_sort (entries, gst_base_parse_index_entry_compare);
+
+  gst_byte_writer_init_with_size (&writer,
+      INDEX_HEADER_SIZE + entries->len * INDEX_ENTRY_SIZE, FALSE);
+  gst_byte_writer_put_data_unchecked (&writer, (const guint8 *) INDEX_MAGIC, 8);
+  gst_byte_writer_put_uint32_le_unchecked (&writer, INDEX_VERSION);
+  /* number of entries, filled in below */
+  gst_byte_writer_put_uint32_le_unchecked (&writer, 0);
+  gst_byte_writer_put_uint64_le_unchecked (&writer, parse->priv->upstream_size);
+
+  for (i = 0; i < entries->len; i++) {
+    e = &g_array_index (entries, GstBaseParseIndexEntry, i);
+    /* entries with the same time are redundant for seeking */
+    if (last && last->ts == e->ts)
+      continue;
+    gst_byte_writer_put_uint64_le_unchecked (&writer, e->ts);
+    gst_byte_writer_put_uint64_le_unchecked (&writer, e->offset);
+    last = e;
+    n_entries++;
+  }
+  g_array_free (entries, TRUE);
+
+  gst_byte_writer_set_pos (&writer, 12);
+  gst_byte_writer_put_uint32_le_unchecked (&writer, n_entries);
+
+  GST_DEBUG_OBJECT (parse, "saved %u index entries", n_entries);
+
+  return g_bytes_new_take (gst_byte_writer_reset_and_get_data (&writer),
+      INDEX_HEADER_SIZE + n_entries * INDEX_ENTRY_SIZE);
+}
+
+/**
+ * gst_base_parse_load_index:
+ * @parse: #GstBaseParse.
+ * @index: the serialized index
+ *
+ * Adds the entries of an index previously serialized with
+ * gst_base_parse_save_index() to the seek index of @parse. This can be
+ * done in any state. In the NULL and READY states the entries are added
+ * when the index for the next stream is created.
+ *
+ * The application is responsible for only loading an index that was saved
+ * for the same stream. An index whose stream size does not match
+ * the size of the current upstream is rejected.
+ *
+ * Returns: %TRUE if @index was valid and loaded.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_base_parse_load_index (GstBaseParse * parse, GBytes * index)
+{
+  GstByteReader reader;
+  const guint8 *magic;
+  guint32 version, n_entries, i;
+  guint64 upstream_size, ts, prev_ts = 0;
+  gsize size;
+
+  g_return_val_if_fail (GST_IS_BASE_PARSE (parse), FALSE);
+  g_return_val_if_fail (index != NULL, FALSE);
+
+  gst_byte_reader_init (&reader, g_bytes_get_data (index, &size), size);
+  if (!gst_byte_reader_get_data (&reader, 8, &magic) ||
+      memcmp (magic, INDEX_MAGIC, 8) != 0)
+    goto invalid;
+  if (!gst_byte_reader_get_uint32_le (&reader, &version) ||
+      version != INDEX_VERSION)
+    goto invalid;
+  if (!gst_byte_reader_get_uint32_le (&reader, &n_entries) ||
+      !gst_byte_reader_get_uint64_le (&reader, &upstream_size))
+    goto invalid;
+  if (gst_byte_reader_get_remaining (&reader) / INDEX_ENTRY_SIZE != n_entries
+      || gst_byte_reader_get_remaining (&reader) % INDEX_ENTRY_SIZE != 0)
+    goto invalid;
+
+  for (i = 0; i < n_entries; i++) {
+    ts = gst_byte_reader_get_uint64_le_unchecked (&reader);
+    gst_byte_reader_skip_unchecked (&reader, 8);
+    if (!GST_CLOCK_TIME_IS_VALID (ts) || (i > 0 && ts <= prev_ts))
+      goto invalid;
+    prev_ts = ts;
+  }
+
+  if (upstream_size && parse->priv->upstream_size &&
+      (guint64) parse->priv->upstream_size != upstream_size)
+    goto wrong_size;
+
+  GST_BASE_PARSE_INDEX_LOCK (parse);
+  if (parse->priv->index) {
+    gst_base_parse_apply_index (parse, index);
+  } else {
+    GST_DEBUG_OBJECT (parse, "no index yet, keeping %u entries", n_entries);
+    if (parse->priv->pending_index)
+      g_bytes_unref (parse->priv->pending_index);
+    parse->priv->pending_index = g_bytes_ref (index);
+  }
+  GST_BASE_PARSE_INDEX_UNLOCK (parse);
+
+  return TRUE;
+
+  /* ERRORS */
+invalid:
+  {
+    GST_WARNING_OBJECT (parse, "invalid index data");
+    return FALSE;
+  }
+wrong_size:
+  {
+    GST_WARNING_OBJECT (parse, "index is for a stream of %" G_GUINT64_FORMAT
+        " bytes, upstream has %" G_GINT64_FORMAT, upstream_size,
+        parse->priv->upstream_size);
+    return FALSE;
+  }
+}
+
 /* check for seekable upstream, above and beyond a mere query */
 static void
 gst_base_parse_check_seekability (GstBaseParse * parse)
@@ -2330,8 +2575,12 @@ static void
 gst_base_parse_push_pending_events (GstBaseParse * parse)
 {
   if (G_UNLIKELY (parse->priv->pending_events)) {
-    GList *r = g_list_reverse (parse->priv->pending_events);
-    GList *l;
+    GList *r, *l;
+
+    /* keep the collected frames in front of the events */
+    gst_base_parse_push_out_list (parse);
+
+    r = g_list_reverse (parse->priv->pending_events);
 
     parse->priv->pending_events = NULL;
     for (l = r; l != NULL; l = l->next) {
@@ -2588,7 +2837,20 @@ gst_base_parse_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     gst_buffer_unref (buffer);
     ret = GST_FLOW_OK;
   } else if (ret == GST_FLOW_OK) {
-    if (parse->segment.rate > 0.0) {
+    if (parse->segment.rate > 0.0 && parse->priv->out_list) {
+      /* the flow of the frames collected so far is only known once they
+       * were pushed, so report errors of earlier lists here */
+      ret = parse->priv->out_list_ret;
+      if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED) {
+        GST_LOG_OBJECT (parse, "adding frame (%" G_GSIZE_FORMAT " bytes) to "
+            "list", size);
+        gst_buffer_list_add (parse->priv->out_list, buffer);
+      } else {
+        GST_LOG_OBJECT (parse, "frame (%" G_GSIZE_FORMAT " bytes) not "
+            "pushed: %s", size, gst_flow_get_name (ret));
+        gst_buffer_unref (buffer);
+      }
+    } else if (parse->segment.rate > 0.0) {
       GST_LOG_OBJECT (parse, "pushing frame (%" G_GSIZE_FORMAT " bytes) now..",
           size);
       ret = gst_pad_push (parse->srcpad, buffer);
@@ -2755,6 +3017,105 @@ exit:
   return ret;
 }
 
+/* pushes the frames collected by gst_base_parse_finish_frames() as one
+ * buffer list */
+static void
+gst_base_parse_push_out_list (GstBaseParse * parse)
+{
+  GstBufferList *list = parse->priv->out_list;
+  GstFlowReturn ret;
+  guint len;
+
+  if (list == NULL || (len = gst_buffer_list_length (list)) == 0)
+    return;
+
+  parse->priv->out_list = gst_buffer_list_new ();
+
+  GST_LOG_OBJECT (parse, "pushing list of %u frames", len);
+  ret = gst_pad_push_list (parse->srcpad, list);
+  GST_LOG_OBJECT (parse, "list pushed, flow %s", gst_flow_get_name (ret));
+
+  if (ret != GST_FLOW_OK && (parse->priv->out_list_ret == GST_FLOW_OK ||
+          parse->priv->out_list_ret == GST_FLOW_NOT_LINKED))
+    parse->priv->out_list_ret = ret;
+}
+
+/**
+ * gst_base_parse_finish_frames:
+ * @parse: a #GstBaseParse
+ * @frame: a #GstBaseParseFrame
+ * @sizes: (array length=n_frames): consumed input data of each frame
+ * @n_frames: the number of frames
+ *
+ * Collects @n_frames consecutive parsed frames from one
+ * #GstBaseParseClass.handle_frame() invocation and pushes them downstream
+ * together as one #GstBufferList. This avoids the per-frame overhead of
+ * gst_base_parse_finish_frame() for formats with many small frames, such as
+ * compressed audio.
+ *
+ * The frames are handled as if gst_base_parse_finish_frame() was called for
+ * each of them in turn. The metadata set by the subclass on @frame's (input)
+ * buffer is used for the first frame. The following frames get the same
+ * duration, offsets and flags except for %GST_BUFFER_FLAG_DISCONT, and their
+ * timestamps are interpolated as usual. @frame must not have an out_buffer.
+ *
+ * Events that have to be sent while the frames are handled, for example tags
+ * added in #GstBaseParseClass.pre_push_frame(), cause the frames collected
+ * up to then to be pushed first.
+ *
+ * Returns: a #GstFlowReturn that should be escalated to caller (of caller)
+ *
+ * Since: 1.20
+ */
+GstFlowReturn
+gst_base_parse_finish_frames (GstBaseParse * parse, GstBaseParseFrame * frame,
+    const gint * sizes, guint n_frames)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *meta;
+  guint i;
+
+  g_return_val_if_fail (frame != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (frame->buffer != NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (frame->out_buffer == NULL, GST_FLOW_ERROR);
+  g_return_val_if_fail (sizes != NULL || n_frames == 0, GST_FLOW_ERROR);
+  g_return_val_if_fail (parse->priv->out_list == NULL, GST_FLOW_ERROR);
+
+  if (n_frames == 0)
+    return GST_FLOW_OK;
+
+  /* template for the metadata of the following frames */
+  meta = gst_buffer_new ();
+  gst_buffer_copy_into (meta, frame->buffer, GST_BUFFER_COPY_METADATA, 0, -1);
+  GST_BUFFER_PTS (meta) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DTS (meta) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_FLAG_UNSET (meta, GST_BUFFER_FLAG_DISCONT);
+
+  parse->priv->out_list = gst_buffer_list_new_sized (n_frames);
+  parse->priv->out_list_ret = GST_FLOW_OK;
+
+  /* like for single frames, not-linked does not stop the parsing */
+  for (i = 0; i < n_frames && (ret == GST_FLOW_OK ||
+          ret == GST_FLOW_NOT_LINKED); i++) {
+    if (i > 0) {
+      gst_buffer_replace (&frame->buffer, NULL);
+      frame->buffer = gst_buffer_copy (meta);
+      frame->offset += sizes[i - 1];
+    }
+    ret = gst_base_parse_finish_frame (parse, frame, sizes[i]);
+  }
+
+  gst_base_parse_push_out_list (parse);
+  if (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED)
+    ret = parse->priv->out_list_ret;
+
+  gst_buffer_list_unref (parse->priv->out_list);
+  parse->priv->out_list = NULL;
+  gst_buffer_unref (meta);
+
+  return ret;
+}
+
 /**
  * gst_base_parse_drain:
  * @parse: a #GstBaseParse
@@ -4932,6 +5293,11 @@ gst_base_parse_change_state (GstElement * element, GstStateChange transition)
             &parse->priv->index_id);
         parse->priv->own_index = TRUE;
       }
+      if (parse->priv->pending_index) {
+        gst_base_parse_apply_index (parse, parse->priv->pending_index);
+        g_bytes_unref (parse->priv->pending_index);
+        parse->priv->pending_index = NULL;
+      }
       GST_BASE_PARSE_INDEX_UNLOCK (parse);
       break;
     default:
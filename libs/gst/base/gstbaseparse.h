@@ -303,6 +303,11 @@ GstFlowReturn   gst_base_parse_finish_frame    (GstBaseParse * parse,
                                                 GstBaseParseFrame * frame,
                                                 gint size);
 GST_BASE_API
+GstFlowReturn   gst_base_parse_finish_frames   (GstBaseParse      * parse,
+                                                GstBaseParseFrame * frame,
+                                                const gint        * sizes,
+                                                guint               n_frames);
+GST_BASE_API
 void            gst_base_parse_set_duration    (GstBaseParse      * parse,
                                                 GstFormat           fmt,
                                                 gint64              duration,
@@ -354,6 +359,12 @@ gboolean        gst_base_parse_add_index_entry (GstBaseParse * parse,
                                                 gboolean       key,
                                                 gboolean       force);
 GST_BASE_API
+GBytes *        gst_base_parse_save_index      (GstBaseParse * parse);
+
+GST_BASE_API
+gboolean        gst_base_parse_load_index      (GstBaseParse * parse,
+                                                GBytes       * index);
+GST_BASE_API
 void            gst_base_parse_set_ts_at_offset (GstBaseParse *parse,
                                                  gsize offset);
 GST_BASE_API
@@ -179,6 +179,23 @@ struct _GstBaseSinkPrivate
   GstClockTimeDiff ts_offset;
   GstClockTime render_delay;
   GstClockTime processing_deadline;
+  GstClockTime sync_window;
+
+  /* set while a group of buffers of a list is synchronised at once, with
+   * STREAM_LOCK */
+  gboolean in_sync_group;
+
+  /* asynchronous clock waits. task_pool is the property, protected with
+   * LOCK, async_pool the pool in use while the pad is active in push mode.
+   * The other fields are protected with async_lock */
+  GstTaskPool *task_pool;
+  GstTaskPool *async_pool;
+  GMutex async_lock;
+  GCond async_cond;
+  GQueue async_queue;
+  GstClockID async_id;
+  gboolean async_running;
+  GstFlowReturn async_result;
 
   /* start, stop of current buffer, stream time, used to report position */
   GstClockTime current_sstart;
@@ -271,6 +288,11 @@ struct _GstBaseSinkPrivate
   GstClockTime earliest_in_time;
   GstClockTime throttle_time;
 
+  /* for coalescing QoS events, running time and diff of the last sent one */
+  GstClockTime qos_interval;
+  GstClockTime qos_last_sent;
+  GstClockTimeDiff qos_last_diff;
+
   /* for rate control */
   guint64 max_bitrate;
   GstClockTime rc_time;
@@ -308,6 +330,12 @@ struct _GstBaseSinkPrivate
 #define DEFAULT_MAX_BITRATE         0
 #define DEFAULT_DROP_OUT_OF_SEGMENT TRUE
 #define DEFAULT_PROCESSING_DEADLINE (20 * GST_MSECOND)
+#define DEFAULT_SYNC_WINDOW         0
+#define DEFAULT_QOS_INTERVAL        0
+
+/* maximum number of objects waiting for their asynchronous clock wait before
+ * the streaming thread blocks */
+#define ASYNC_MAX_PENDING           32
 
 enum
 {
@@ -325,6 +353,9 @@ enum
   PROP_MAX_BITRATE,
   PROP_PROCESSING_DEADLINE,
   PROP_STATS,
+  PROP_SYNC_WINDOW,
+  PROP_TASK_POOL,
+  PROP_QOS_INTERVAL,
   PROP_LAST
 };
 
@@ -388,6 +419,10 @@ static void gst_base_sink_default_get_times (GstBaseSink * basesink,
     GstBuffer * buffer, GstClockTime * start, GstClockTime * end);
 static gboolean gst_base_sink_set_flushing (GstBaseSink * basesink,
     GstPad * pad, gboolean flushing);
+static void gst_base_sink_async_drain (GstBaseSink * basesink);
+static void gst_base_sink_async_flush (GstBaseSink * basesink,
+    gboolean flushing);
+static void gst_base_sink_async_pause (GstBaseSink * basesink);
 static gboolean gst_base_sink_default_activate_pull (GstBaseSink * basesink,
     gboolean active);
 static gboolean gst_base_sink_default_do_seek (GstBaseSink * sink,
@@ -574,6 +609,67 @@ gst_base_sink_class_init (GstBaseSinkClass * klass)
           G_MAXUINT64, DEFAULT_PROCESSING_DEADLINE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstBaseSink:sync-window:
+   *
+   * Buffers of a buffer list whose running time is within this window (in
+   * nanoseconds) of the first buffer of a group are synchronised against the
+   * clock at once and rendered together. 0 disables the grouping.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SYNC_WINDOW,
+      g_param_spec_uint64 ("sync-window", "Sync window",
+          "Synchronise buffers of a list within this window together "
+          "(in nanoseconds, 0 = disabled)", 0,
+          G_MAXUINT64, DEFAULT_SYNC_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseSink:task-pool:
+   *
+   * A #GstTaskPool, for example a #GstSharedTaskPool, on which buffers are
+   * rendered after waiting for the clock asynchronously. When set, a buffer
+   * that has to wait for its render time in the PLAYING state is queued,
+   * the clock is waited for with gst_clock_id_wait_async() and the
+   * streaming thread returns right away, so that it can serve other
+   * elements in the meantime. When the wait completes the buffer is
+   * rendered from a work item on the pool.
+   *
+   * The streaming thread only blocks when 32 objects are waiting already,
+   * and serialized events and queries wait until all pending buffers are
+   * rendered. Prerolling and waiting for the PLAYING
+   * state still block the thread that pushes or renders the buffer.
+   *
+   * The pool must have been prepared with gst_task_pool_prepare().
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_POOL,
+      g_param_spec_object ("task-pool", "Task pool",
+          "Task pool to render buffers from after waiting for the clock "
+          "asynchronously (NULL = wait in the streaming thread)",
+          GST_TYPE_TASK_POOL, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseSink:qos-interval:
+   *
+   * The minimum running time (in nanoseconds) between two QoS events sent
+   * upstream. The values of the buffers in between are coalesced, the next
+   * QoS event carries the latest jitter and proportion. A buffer that is late
+   * while the last QoS event said that the sink is on time is reported right
+   * away so that upstream can start dropping. 0 sends a QoS event for every
+   * buffer.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QOS_INTERVAL,
+      g_param_spec_uint64 ("qos-interval", "QoS interval",
+          "Minimum running time between QoS events sent upstream "
+          "(in nanoseconds, 0 = every buffer)", 0, G_MAXUINT64,
+          DEFAULT_QOS_INTERVAL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
 
   /**
    * GstBaseSink:stats:
@@ -708,6 +804,11 @@ gst_base_sink_init (GstBaseSink * basesink, gpointer g_class)
   g_cond_init (&basesink->preroll_cond);
   priv->have_latency = FALSE;
 
+  g_mutex_init (&priv->async_lock);
+  g_cond_init (&priv->async_cond);
+  g_queue_init (&priv->async_queue);
+  priv->async_result = GST_FLOW_OK;
+
   basesink->can_activate_push = DEFAULT_CAN_ACTIVATE_PUSH;
   basesink->can_activate_pull = DEFAULT_CAN_ACTIVATE_PULL;
 
@@ -718,6 +819,8 @@ gst_base_sink_init (GstBaseSink * basesink, gpointer g_class)
   priv->ts_offset = DEFAULT_TS_OFFSET;
   priv->render_delay = DEFAULT_RENDER_DELAY;
   priv->processing_deadline = DEFAULT_PROCESSING_DEADLINE;
+  priv->sync_window = DEFAULT_SYNC_WINDOW;
+  priv->qos_interval = DEFAULT_QOS_INTERVAL;
   priv->blocksize = DEFAULT_BLOCKSIZE;
   priv->cached_clock_id = NULL;
   g_atomic_int_set (&priv->enable_last_sample, DEFAULT_ENABLE_LAST_SAMPLE);
@@ -739,6 +842,10 @@ gst_base_sink_finalize (GObject * object)
   g_mutex_clear (&basesink->preroll_lock);
   g_cond_clear (&basesink->preroll_cond);
 
+  gst_clear_object (&basesink->priv->task_pool);
+  g_mutex_clear (&basesink->priv->async_lock);
+  g_cond_clear (&basesink->priv->async_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1558,6 +1665,61 @@ gst_base_sink_get_processing_deadline (GstBaseSink * sink)
   return res;
 }
 
+/**
+ * gst_base_sink_set_sync_window:
+ * @sink: a #GstBaseSink
+ * @window: the new sync window in nanoseconds.
+ *
+ * Configure the window in which the buffers of a buffer list are
+ * synchronised together. Consecutive buffers whose running time lies within
+ * @window of the first buffer of a group only cause a single wait on the
+ * clock and a single QoS update, and are passed to #GstBaseSinkClass.render_list()
+ * at once, or to #GstBaseSinkClass.render() one after another if the
+ * subclass does not implement render_list().
+ *
+ * A value of 0 disables the grouping, buffer lists are then synchronised
+ * on their first buffer when the subclass implements render_list() and
+ * buffer by buffer otherwise.
+ *
+ * Since: 1.20
+ */
+void
+gst_base_sink_set_sync_window (GstBaseSink * sink, GstClockTime window)
+{
+  g_return_if_fail (GST_IS_BASE_SINK (sink));
+
+  GST_OBJECT_LOCK (sink);
+  sink->priv->sync_window = window;
+  GST_LOG_OBJECT (sink, "set sync window to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (window));
+  GST_OBJECT_UNLOCK (sink);
+}
+
+/**
+ * gst_base_sink_get_sync_window:
+ * @sink: a #GstBaseSink
+ *
+ * Get the sync window of @sink. See gst_base_sink_set_sync_window() for
+ * more information.
+ *
+ * Returns: the sync window in nanoseconds
+ *
+ * Since: 1.20
+ */
+GstClockTime
+gst_base_sink_get_sync_window (GstBaseSink * sink)
+{
+  GstClockTime res;
+
+  g_return_val_if_fail (GST_IS_BASE_SINK (sink), 0);
+
+  GST_OBJECT_LOCK (sink);
+  res = sink->priv->sync_window;
+  GST_OBJECT_UNLOCK (sink);
+
+  return res;
+}
+
 static void
 gst_base_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -1598,6 +1760,20 @@ gst_base_sink_set_property (GObject * object, guint prop_id,
     case PROP_PROCESSING_DEADLINE:
       gst_base_sink_set_processing_deadline (sink, g_value_get_uint64 (value));
       break;
+    case PROP_SYNC_WINDOW:
+      gst_base_sink_set_sync_window (sink, g_value_get_uint64 (value));
+      break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (sink);
+      gst_object_replace ((GstObject **) & sink->priv->task_pool,
+          g_value_get_object (value));
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_QOS_INTERVAL:
+      GST_OBJECT_LOCK (sink);
+      sink->priv->qos_interval = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (sink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1650,6 +1826,19 @@ gst_base_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_STATS:
       g_value_take_boxed (value, gst_base_sink_get_stats (sink));
       break;
+    case PROP_SYNC_WINDOW:
+      g_value_set_uint64 (value, gst_base_sink_get_sync_window (sink));
+      break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_object (value, sink->priv->task_pool);
+      GST_OBJECT_UNLOCK (sink);
+      break;
+    case PROP_QOS_INTERVAL:
+      GST_OBJECT_LOCK (sink);
+      g_value_set_uint64 (value, sink->priv->qos_interval);
+      GST_OBJECT_UNLOCK (sink);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2929,6 +3118,30 @@ gst_base_sink_send_qos (GstBaseSink * basesink, GstQOSType type,
   return res;
 }
 
+/* whether a QoS event with @diff should be sent now or can wait for a
+ * later buffer, which will carry newer values */
+static gboolean
+gst_base_sink_qos_is_due (GstBaseSink * sink, GstClockTimeDiff diff)
+{
+  GstBaseSinkPrivate *priv = sink->priv;
+  GstClockTime interval;
+
+  GST_OBJECT_LOCK (sink);
+  interval = priv->qos_interval;
+  GST_OBJECT_UNLOCK (sink);
+
+  if (interval == 0 || !GST_CLOCK_TIME_IS_VALID (priv->qos_last_sent))
+    return TRUE;
+
+  /* upstream should know right away when we start being late */
+  if (diff > 0 && priv->qos_last_diff <= 0)
+    return TRUE;
+
+  /* running time went backwards, or the interval is over */
+  return priv->current_rstart < priv->qos_last_sent
+      || priv->current_rstart - priv->qos_last_sent >= interval;
+}
+
 static void
 gst_base_sink_perform_qos (GstBaseSink * sink, gboolean dropped)
 {
@@ -3051,8 +3264,14 @@ gst_base_sink_perform_qos (GstBaseSink * sink, gboolean dropped)
         type = GST_QOS_TYPE_UNDERFLOW;
     }
 
-    gst_base_sink_send_qos (sink, type, priv->avg_rate, priv->current_rstart,
-        diff);
+    if (gst_base_sink_qos_is_due (sink, diff)) {
+      priv->qos_last_sent = priv->current_rstart;
+      priv->qos_last_diff = diff;
+      gst_base_sink_send_qos (sink, type, priv->avg_rate,
+          priv->current_rstart, diff);
+    } else {
+      GST_CAT_LOG_OBJECT (GST_CAT_QOS, sink, "coalescing QoS event");
+    }
   }
 
   /* record when this buffer will leave us */
@@ -3074,6 +3293,8 @@ gst_base_sink_reset_qos (GstBaseSink * sink)
   priv->avg_pt = GST_CLOCK_TIME_NONE;
   priv->avg_rate = -1.0;
   priv->avg_in_diff = GST_CLOCK_TIME_NONE;
+  priv->qos_last_sent = GST_CLOCK_TIME_NONE;
+  priv->qos_last_diff = 0;
   priv->rendered = 0;
   priv->dropped = 0;
 
@@ -3666,6 +3887,9 @@ gst_base_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       break;
     default:
       if (GST_EVENT_IS_SERIALIZED (event)) {
+        /* render everything that is waiting for the clock first */
+        gst_base_sink_async_drain (basesink);
+
         GST_BASE_SINK_PREROLL_LOCK (basesink);
         if (G_UNLIKELY (basesink->flushing))
           goto flushing;
@@ -3855,8 +4079,9 @@ gst_base_sink_chain_unlocked (GstBaseSink * basesink, GstPad * pad,
 
     current = &priv->current_step;
     syncable =
-        gst_base_sink_get_sync_times (basesink, obj, &sstart, &sstop, &rstart,
-        &rstop, &rnext, &do_sync, &stepped, current, &step_end);
+        gst_base_sink_get_sync_times (basesink, GST_MINI_OBJECT_CAST (sync_buf),
+        &sstart, &sstop, &rstart, &rstop, &rnext, &do_sync, &stepped, current,
+        &step_end);
 
     if (G_UNLIKELY (stepped))
       goto dropped;
@@ -3904,6 +4129,16 @@ gst_base_sink_chain_unlocked (GstBaseSink * basesink, GstPad * pad,
         ret = bclass->prepare_list (basesink, GST_BUFFER_LIST_CAST (obj));
         if (G_UNLIKELY (ret != GST_FLOW_OK))
           goto prepare_failed;
+      } else if (priv->in_sync_group && bclass->prepare) {
+        GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (obj);
+        guint i, len = gst_buffer_list_length (buffer_list);
+
+        for (i = 0; i < len; i++) {
+          ret = bclass->prepare (basesink, gst_buffer_list_get (buffer_list,
+                  i));
+          if (G_UNLIKELY (ret != GST_FLOW_OK))
+            goto prepare_failed;
+        }
       }
     }
 
@@ -3942,6 +4177,7 @@ again:
   }
 
   GST_DEBUG_OBJECT (basesink, "rendering object %p", obj);
+  GST_SDT_PROBE2 (base_sink_render, basesink, obj);
 
   if (!is_list) {
     /* For buffer lists do not set last buffer for now. */
@@ -3953,8 +4189,16 @@ again:
   } else {
     GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (obj);
 
-    if (bclass->render_list)
+    if (bclass->render_list) {
       ret = bclass->render_list (basesink, buffer_list);
+    } else if (priv->in_sync_group && bclass->render) {
+      guint i, len = gst_buffer_list_length (buffer_list);
+
+      /* the group was synchronised on its first buffer, render the others
+       * right away */
+      for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+        ret = bclass->render (basesink, gst_buffer_list_get (buffer_list, i));
+    }
 
     /* Set the first buffer and buffer list to be included in last sample */
     gst_base_sink_set_last_buffer (basesink, sync_buf);
@@ -3967,7 +4211,10 @@ again:
   if (G_UNLIKELY (basesink->flushing))
     goto flushing;
 
-  priv->rendered++;
+  if (is_list && priv->in_sync_group)
+    priv->rendered += gst_buffer_list_length (GST_BUFFER_LIST_CAST (obj));
+  else
+    priv->rendered++;
 
 done:
   if (step_end) {
@@ -4026,6 +4273,7 @@ dropped:
   {
     priv->dropped++;
     GST_DEBUG_OBJECT (basesink, "buffer late, dropping");
+    GST_SDT_PROBE3 (base_sink_qos_drop, basesink, obj, priv->current_jitter);
 
     if (g_atomic_int_get (&priv->qos_enabled)) {
       GstMessage *qos_msg;
@@ -4097,28 +4345,104 @@ wrong_mode:
   }
 }
 
+/* running time of the start of @buffer, with STREAM_LOCK */
+static GstClockTime
+gst_base_sink_buffer_running_time (GstBaseSink * basesink,
+    GstBaseSinkClass * bclass, GstBuffer * buffer)
+{
+  GstClockTime start = GST_CLOCK_TIME_NONE, end = GST_CLOCK_TIME_NONE;
+
+  if (bclass->get_times)
+    bclass->get_times (basesink, buffer, &start, &end);
+
+  if (!GST_CLOCK_TIME_IS_VALID (start))
+    gst_base_sink_default_get_times (basesink, buffer, &start, &end);
+
+  if (!GST_CLOCK_TIME_IS_VALID (start)
+      || basesink->segment.format != GST_FORMAT_TIME)
+    return GST_CLOCK_TIME_NONE;
+
+  return gst_segment_to_running_time (&basesink->segment, GST_FORMAT_TIME,
+      start);
+}
+
+/* Splits @list into groups of consecutive buffers that start within @window
+ * of the first buffer of the group. Every group is synchronised once on its
+ * first buffer and then rendered as a whole. Buffers without a valid running
+ * time form a group of their own. with STREAM_LOCK */
 static GstFlowReturn
-gst_base_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+gst_base_sink_chain_list_grouped (GstBaseSink * basesink, GstPad * pad,
+    GstBufferList * list, GstClockTime window)
 {
-  GstBaseSink *basesink;
+  GstBaseSinkClass *bclass = GST_BASE_SINK_GET_CLASS (basesink);
+  GstFlowReturn result = GST_FLOW_OK;
+  guint i, first, len;
 
-  basesink = GST_BASE_SINK (parent);
+  len = gst_buffer_list_length (list);
 
-  return gst_base_sink_chain_main (basesink, pad, buf, FALSE);
+  for (first = 0; first < len && result == GST_FLOW_OK; first = i) {
+    GstClockTime rt0, rt;
+    GstBufferList *group;
+
+    rt0 = gst_base_sink_buffer_running_time (basesink, bclass,
+        gst_buffer_list_get (list, first));
+
+    for (i = first + 1; i < len && GST_CLOCK_TIME_IS_VALID (rt0); i++) {
+      rt = gst_base_sink_buffer_running_time (basesink, bclass,
+          gst_buffer_list_get (list, i));
+      if (!GST_CLOCK_TIME_IS_VALID (rt) || rt < rt0 || rt - rt0 >= window)
+        break;
+    }
+
+    if (i - first == 1 && !bclass->render_list) {
+      result = gst_base_sink_chain_main (basesink, pad,
+          gst_buffer_ref (gst_buffer_list_get (list, first)), FALSE);
+      continue;
+    }
+
+    if (first == 0 && i == len) {
+      group = gst_buffer_list_ref (list);
+    } else {
+      guint j;
+
+      group = gst_buffer_list_new_sized (i - first);
+      for (j = first; j < i; j++)
+        gst_buffer_list_add (group, gst_buffer_ref (gst_buffer_list_get (list,
+                    j)));
+    }
+
+    GST_LOG_OBJECT (pad, "chaining group of %u buffers at %" GST_TIME_FORMAT,
+        i - first, GST_TIME_ARGS (rt0));
+
+    basesink->priv->in_sync_group = TRUE;
+    result = gst_base_sink_chain_main (basesink, pad, group, TRUE);
+    basesink->priv->in_sync_group = FALSE;
+  }
+  gst_buffer_list_unref (list);
+
+  return result;
 }
 
+/* with STREAM_LOCK */
 static GstFlowReturn
-gst_base_sink_chain_list (GstPad * pad, GstObject * parent,
+gst_base_sink_chain_list_main (GstBaseSink * basesink, GstPad * pad,
     GstBufferList * list)
 {
-  GstBaseSink *basesink;
   GstBaseSinkClass *bclass;
   GstFlowReturn result;
+  GstClockTime window;
+  gboolean sync;
 
-  basesink = GST_BASE_SINK (parent);
   bclass = GST_BASE_SINK_GET_CLASS (basesink);
 
-  if (G_LIKELY (bclass->render_list)) {
+  GST_OBJECT_LOCK (basesink);
+  window = basesink->priv->sync_window;
+  sync = basesink->sync;
+  GST_OBJECT_UNLOCK (basesink);
+
+  if (window > 0 && sync && gst_buffer_list_length (list) > 1) {
+    result = gst_base_sink_chain_list_grouped (basesink, pad, list, window);
+  } else if (G_LIKELY (bclass->render_list)) {
     result = gst_base_sink_chain_main (basesink, pad, list, TRUE);
   } else {
     guint i, len;
@@ -4141,6 +4465,344 @@ gst_base_sink_chain_list (GstPad * pad, GstObject * parent,
   return result;
 }
 
+static GstFlowReturn
+gst_base_sink_dispatch (GstBaseSink * basesink, GstPad * pad,
+    GstMiniObject * obj)
+{
+  if (GST_IS_BUFFER_LIST (obj))
+    return gst_base_sink_chain_list_main (basesink, pad,
+        GST_BUFFER_LIST_CAST (obj));
+
+  return gst_base_sink_chain_main (basesink, pad, obj, FALSE);
+}
+
+/* Returns the clock time at which @obj has to be rendered if that is in the
+ * future and the wait can be done asynchronously, GST_CLOCK_TIME_NONE
+ * otherwise. @clock is set to the clock to wait on in the first case.
+ * with async_lock */
+static GstClockTime
+gst_base_sink_async_sync_time (GstBaseSink * basesink, GstMiniObject * obj,
+    GstClock ** clock)
+{
+  GstBaseSinkClass *bclass = GST_BASE_SINK_GET_CLASS (basesink);
+  GstBaseSinkPrivate *priv = basesink->priv;
+  GstClockTime rt, stime = GST_CLOCK_TIME_NONE;
+  GstBuffer *buf;
+
+  if (GST_IS_BUFFER_LIST (obj)) {
+    if (gst_buffer_list_length (GST_BUFFER_LIST_CAST (obj)) == 0)
+      return GST_CLOCK_TIME_NONE;
+    buf = gst_buffer_list_get (GST_BUFFER_LIST_CAST (obj), 0);
+  } else {
+    buf = GST_BUFFER_CAST (obj);
+  }
+
+  /* leave missing segments, reverse playback, stepping and instant rate
+   * changes to the regular code path */
+  if (!basesink->have_newsegment || basesink->segment.rate < 0.0
+      || priv->current_step.valid || priv->instant_rate_multiplier != 0)
+    return GST_CLOCK_TIME_NONE;
+
+  rt = gst_base_sink_buffer_running_time (basesink, bclass, buf);
+  if (!GST_CLOCK_TIME_IS_VALID (rt))
+    return GST_CLOCK_TIME_NONE;
+
+  GST_OBJECT_LOCK (basesink);
+  if (basesink->sync && GST_ELEMENT_CLOCK (basesink)
+      && GST_STATE (basesink) == GST_STATE_PLAYING
+      && GST_STATE_NEXT (basesink) == GST_STATE_VOID_PENDING) {
+    stime = gst_base_sink_adjust_time (basesink, rt);
+    /* rather wake up early, the remainder is waited for when rendering */
+    if (stime > priv->render_delay)
+      stime -= priv->render_delay;
+    else
+      stime = 0;
+    stime += GST_ELEMENT_CAST (basesink)->base_time;
+
+    if (stime > gst_clock_get_time (GST_ELEMENT_CLOCK (basesink)))
+      *clock = gst_object_ref (GST_ELEMENT_CLOCK (basesink));
+    else
+      stime = GST_CLOCK_TIME_NONE;
+  }
+  GST_OBJECT_UNLOCK (basesink);
+
+  return stime;
+}
+
+/* with async_lock */
+static void
+gst_base_sink_async_clear (GstBaseSink * basesink)
+{
+  GstMiniObject *obj;
+
+  while ((obj = g_queue_pop_head (&basesink->priv->async_queue)))
+    gst_mini_object_unref (obj);
+}
+
+static void gst_base_sink_async_func (gpointer data);
+
+/* with async_lock */
+static void
+gst_base_sink_async_push_work (GstBaseSink * basesink)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+  GError *err = NULL;
+  gpointer id;
+
+  id = gst_task_pool_push (priv->async_pool, gst_base_sink_async_func,
+      gst_object_ref (basesink), &err);
+  if (G_UNLIKELY (err != NULL))
+    goto push_failed;
+
+  if (id)
+    gst_task_pool_dispose_handle (priv->async_pool, id);
+
+  return;
+
+  /* ERRORS */
+push_failed:
+  {
+    GST_ELEMENT_ERROR (basesink, CORE, THREAD,
+        ("Failed to schedule rendering on the task pool."),
+        ("%s", err->message));
+    g_clear_error (&err);
+    gst_object_unref (basesink);
+    priv->async_result = GST_FLOW_ERROR;
+    gst_base_sink_async_clear (basesink);
+    priv->async_running = FALSE;
+    g_cond_broadcast (&priv->async_cond);
+  }
+}
+
+static gboolean
+gst_base_sink_async_clock_cb (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstBaseSink *basesink = user_data;
+  GstBaseSinkPrivate *priv = basesink->priv;
+
+  g_mutex_lock (&priv->async_lock);
+  /* the wait might have been cancelled in the meantime */
+  if (priv->async_id == id) {
+    gst_clock_id_unref (priv->async_id);
+    priv->async_id = NULL;
+    gst_base_sink_async_push_work (basesink);
+  }
+  g_mutex_unlock (&priv->async_lock);
+
+  return TRUE;
+}
+
+/* with async_lock */
+static void
+gst_base_sink_async_wait (GstBaseSink * basesink, GstClock * clock,
+    GstClockTime stime)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+  GstClockReturn res;
+
+  GST_LOG_OBJECT (basesink, "waiting asynchronously for %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (stime));
+
+  priv->async_id = gst_clock_new_single_shot_id (clock, stime);
+  res = gst_clock_id_wait_async (priv->async_id, gst_base_sink_async_clock_cb,
+      gst_object_ref (basesink), gst_object_unref);
+  if (G_LIKELY (res == GST_CLOCK_OK))
+    return;
+
+  GST_DEBUG_OBJECT (basesink, "async wait failed: %d", res);
+  /* the destroy notify is only installed when the clock supports async
+   * waits */
+  if (res == GST_CLOCK_UNSUPPORTED)
+    gst_object_unref (basesink);
+  gst_clock_id_unref (priv->async_id);
+  priv->async_id = NULL;
+
+  /* render right away, waiting in the work item */
+  gst_base_sink_async_push_work (basesink);
+}
+
+/* renders the pending objects whose render time has come and schedules a
+ * new wait for the others */
+static void
+gst_base_sink_async_func (gpointer data)
+{
+  GstBaseSink *basesink = data;
+  GstBaseSinkPrivate *priv = basesink->priv;
+  GstMiniObject *obj;
+  GstClockTime stime;
+  GstClock *clock;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&priv->async_lock);
+  while ((obj = g_queue_peek_head (&priv->async_queue))) {
+    clock = NULL;
+    stime = gst_base_sink_async_sync_time (basesink, obj, &clock);
+    if (GST_CLOCK_TIME_IS_VALID (stime)) {
+      gst_base_sink_async_wait (basesink, clock, stime);
+      gst_object_unref (clock);
+      goto done;
+    }
+
+    g_queue_pop_head (&priv->async_queue);
+    g_cond_broadcast (&priv->async_cond);
+    g_mutex_unlock (&priv->async_lock);
+
+    ret = gst_base_sink_dispatch (basesink, basesink->sinkpad, obj);
+
+    g_mutex_lock (&priv->async_lock);
+    if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+      GST_DEBUG_OBJECT (basesink, "rendering returned %s",
+          gst_flow_get_name (ret));
+      if (priv->async_result == GST_FLOW_OK)
+        priv->async_result = ret;
+      gst_base_sink_async_clear (basesink);
+    }
+  }
+  priv->async_running = FALSE;
+  g_cond_broadcast (&priv->async_cond);
+
+done:
+  g_mutex_unlock (&priv->async_lock);
+  gst_object_unref (basesink);
+}
+
+/* Queues @obj when it has to wait for the clock or other objects are
+ * waiting already, renders it right away otherwise. with STREAM_LOCK */
+static GstFlowReturn
+gst_base_sink_chain_async (GstBaseSink * basesink, GstPad * pad,
+    GstMiniObject * obj)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+  GstClockTime stime;
+  GstClock *clock = NULL;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&priv->async_lock);
+  while (priv->async_running
+      && priv->async_queue.length >= ASYNC_MAX_PENDING
+      && priv->async_result == GST_FLOW_OK)
+    g_cond_wait (&priv->async_cond, &priv->async_lock);
+
+  if (G_UNLIKELY (priv->async_result != GST_FLOW_OK))
+    goto async_failed;
+
+  if (priv->async_running) {
+    g_queue_push_tail (&priv->async_queue, obj);
+  } else {
+    stime = gst_base_sink_async_sync_time (basesink, obj, &clock);
+    if (!GST_CLOCK_TIME_IS_VALID (stime)) {
+      /* nothing to wait for */
+      g_mutex_unlock (&priv->async_lock);
+      return gst_base_sink_dispatch (basesink, pad, obj);
+    }
+    g_queue_push_tail (&priv->async_queue, obj);
+    priv->async_running = TRUE;
+    gst_base_sink_async_wait (basesink, clock, stime);
+    gst_object_unref (clock);
+  }
+  g_mutex_unlock (&priv->async_lock);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+async_failed:
+  {
+    ret = priv->async_result;
+    g_mutex_unlock (&priv->async_lock);
+    GST_DEBUG_OBJECT (basesink, "dropping object, rendering returned %s",
+        gst_flow_get_name (ret));
+    gst_mini_object_unref (obj);
+    return ret;
+  }
+}
+
+/* waits until all queued objects are rendered, with STREAM_LOCK */
+static void
+gst_base_sink_async_drain (GstBaseSink * basesink)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+
+  if (G_LIKELY (priv->async_pool == NULL))
+    return;
+
+  g_mutex_lock (&priv->async_lock);
+  while (priv->async_running)
+    g_cond_wait (&priv->async_cond, &priv->async_lock);
+  g_mutex_unlock (&priv->async_lock);
+}
+
+/* drops all queued objects and waits for a running work item */
+static void
+gst_base_sink_async_flush (GstBaseSink * basesink, gboolean flushing)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+
+  g_mutex_lock (&priv->async_lock);
+  if (flushing) {
+    priv->async_result = GST_FLOW_FLUSHING;
+    gst_base_sink_async_clear (basesink);
+    if (priv->async_id) {
+      gst_clock_id_unschedule (priv->async_id);
+      gst_clock_id_unref (priv->async_id);
+      priv->async_id = NULL;
+      priv->async_running = FALSE;
+    }
+    g_cond_broadcast (&priv->async_cond);
+    while (priv->async_running)
+      g_cond_wait (&priv->async_cond, &priv->async_lock);
+  } else {
+    priv->async_result = GST_FLOW_OK;
+  }
+  g_mutex_unlock (&priv->async_lock);
+}
+
+/* cancels the wait of the first queued object and renders it right away so
+ * that it can be prerolled when going to PAUSED */
+static void
+gst_base_sink_async_pause (GstBaseSink * basesink)
+{
+  GstBaseSinkPrivate *priv = basesink->priv;
+
+  g_mutex_lock (&priv->async_lock);
+  if (priv->async_id) {
+    gst_clock_id_unschedule (priv->async_id);
+    gst_clock_id_unref (priv->async_id);
+    priv->async_id = NULL;
+    gst_base_sink_async_push_work (basesink);
+  }
+  g_mutex_unlock (&priv->async_lock);
+}
+
+static GstFlowReturn
+gst_base_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstBaseSink *basesink;
+
+  basesink = GST_BASE_SINK (parent);
+
+  if (G_UNLIKELY (basesink->priv->async_pool))
+    return gst_base_sink_chain_async (basesink, pad,
+        GST_MINI_OBJECT_CAST (buf));
+
+  return gst_base_sink_chain_main (basesink, pad, buf, FALSE);
+}
+
+static GstFlowReturn
+gst_base_sink_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstBaseSink *basesink;
+
+  basesink = GST_BASE_SINK (parent);
+
+  if (G_UNLIKELY (basesink->priv->async_pool))
+    return gst_base_sink_chain_async (basesink, pad,
+        GST_MINI_OBJECT_CAST (list));
+
+  return gst_base_sink_chain_list_main (basesink, pad, list);
+}
+
 
 static gboolean
 gst_base_sink_default_do_seek (GstBaseSink * sink, GstSegment * segment)
@@ -4688,6 +5350,10 @@ gst_base_sink_set_flushing (GstBaseSink * basesink, GstPad * pad,
   }
   GST_BASE_SINK_PREROLL_UNLOCK (basesink);
 
+  /* drop what is waiting for the clock asynchronously, a work item that
+   * is rendering is unblocked by now */
+  gst_base_sink_async_flush (basesink, flushing);
+
   return TRUE;
 }
 
@@ -4804,6 +5470,11 @@ gst_base_sink_pad_activate_push (GstPad * pad, GstObject * parent,
     } else {
       result = TRUE;
       basesink->pad_mode = GST_PAD_MODE_PUSH;
+      GST_OBJECT_LOCK (basesink);
+      if (basesink->priv->task_pool)
+        basesink->priv->async_pool =
+            gst_object_ref (basesink->priv->task_pool);
+      GST_OBJECT_UNLOCK (basesink);
     }
   } else {
     if (G_UNLIKELY (basesink->pad_mode != GST_PAD_MODE_PUSH)) {
@@ -4813,6 +5484,7 @@ gst_base_sink_pad_activate_push (GstPad * pad, GstObject * parent,
       gst_base_sink_set_flushing (basesink, pad, TRUE);
       result = TRUE;
       basesink->pad_mode = GST_PAD_MODE_NONE;
+      gst_clear_object (&basesink->priv->async_pool);
     }
   }
 
@@ -5636,6 +6308,9 @@ gst_base_sink_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
   basesink = GST_BASE_SINK_CAST (parent);
   bclass = GST_BASE_SINK_GET_CLASS (basesink);
 
+  if (GST_QUERY_IS_SERIALIZED (query))
+    gst_base_sink_async_drain (basesink);
+
   if (bclass->query)
     res = bclass->query (basesink, query);
   else
@@ -5813,6 +6488,10 @@ gst_base_sink_change_state (GstElement * element, GstStateChange transition)
 
       gst_base_sink_reset_qos (basesink);
       GST_BASE_SINK_PREROLL_UNLOCK (basesink);
+
+      /* a buffer waiting for the clock asynchronously is the next one to
+       * preroll */
+      gst_base_sink_async_pause (basesink);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_BASE_SINK_PREROLL_LOCK (basesink);
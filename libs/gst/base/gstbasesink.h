@@ -322,6 +322,13 @@ void            gst_base_sink_set_processing_deadline  (GstBaseSink *sink, GstCl
 GST_BASE_API
 GstClockTime    gst_base_sink_get_processing_deadline  (GstBaseSink *sink);
 
+/* sync window */
+GST_BASE_API
+void            gst_base_sink_set_sync_window   (GstBaseSink *sink, GstClockTime window);
+
+GST_BASE_API
+GstClockTime    gst_base_sink_get_sync_window   (GstBaseSink *sink);
+
 GST_BASE_API
 GstClockReturn  gst_base_sink_wait_clock        (GstBaseSink *sink, GstClockTime time,
                                                  GstClockTimeDiff * jitter);
@@ -261,6 +261,12 @@ struct _GstBaseSrcPrivate
 
   /* for _submit_buffer_list() */
   GstBufferList *pending_bufferlist;
+
+  /* for create_list() */
+  gint buffers_per_list;        /* atomic */
+  gboolean create_list_unsupported;     /* STREAM_LOCK */
+  /* pending_bufferlist holds a whole batch from create_list() */
+  gboolean pending_batch;       /* STREAM_LOCK */
 };
 
 #define BASE_SRC_HAS_PENDING_BUFFER_LIST(src) \
@@ -470,6 +476,9 @@ gst_base_src_init (GstBaseSrc * basesrc, gpointer g_class)
   gst_base_src_set_format (basesrc, GST_FORMAT_BYTES);
   basesrc->priv->do_timestamp = DEFAULT_DO_TIMESTAMP;
   g_atomic_int_set (&basesrc->priv->have_events, FALSE);
+  basesrc->priv->buffers_per_list = 1;
+  basesrc->priv->proportion = 1.0;
+  basesrc->priv->earliest_time = GST_CLOCK_TIME_NONE;
 
   g_cond_init (&basesrc->priv->async_cond);
   basesrc->priv->start_result = GST_FLOW_FLUSHING;
@@ -804,6 +813,48 @@ gst_base_src_get_blocksize (GstBaseSrc * src)
   return res;
 }
 
+/**
+ * gst_base_src_set_buffers_per_list:
+ * @src: the source
+ * @max_buffers: the maximum number of buffers per buffer list
+ *
+ * Set the maximum number of buffers that @src creates with one call to
+ * #GstBaseSrcClass::create_list in push mode. The buffers are then pushed
+ * downstream as one buffer list, which amortizes the per-buffer overhead of
+ * the base class and of downstream elements.
+ *
+ * With the default of 1, #GstBaseSrcClass::create is used and buffers are
+ * pushed one by one.
+ *
+ * Since: 1.20
+ */
+void
+gst_base_src_set_buffers_per_list (GstBaseSrc * src, guint max_buffers)
+{
+  g_return_if_fail (GST_IS_BASE_SRC (src));
+  g_return_if_fail (max_buffers > 0 && max_buffers <= G_MAXINT);
+
+  g_atomic_int_set (&src->priv->buffers_per_list, max_buffers);
+}
+
+/**
+ * gst_base_src_get_buffers_per_list:
+ * @src: the source
+ *
+ * Get the maximum number of buffers that @src creates with one call to
+ * #GstBaseSrcClass::create_list.
+ *
+ * Returns: the maximum number of buffers per buffer list.
+ *
+ * Since: 1.20
+ */
+guint
+gst_base_src_get_buffers_per_list (GstBaseSrc * src)
+{
+  g_return_val_if_fail (GST_IS_BASE_SRC (src), 1);
+
+  return g_atomic_int_get (&src->priv->buffers_per_list);
+}
 
 /**
  * gst_base_src_set_do_timestamp:
@@ -2093,6 +2144,51 @@ gst_base_src_update_qos (GstBaseSrc * src,
   GST_OBJECT_UNLOCK (src);
 }
 
+/**
+ * gst_base_src_get_qos_values:
+ * @src: the source
+ * @proportion: (out) (optional): the long term proportion of the processing
+ *     time of downstream and the buffer duration
+ * @earliest_time: (out) (optional): the earliest running time that
+ *     downstream can still render in time
+ *
+ * Get the values of the latest QoS event that reached @src. A source can
+ * skip producing buffers with a running time before @earliest_time when the
+ * pipeline is overloaded, instead of leaving it to a decoder or the sink to
+ * drop them after they were produced.
+ *
+ * Returns: %TRUE when a QoS event reached @src since it was started or
+ * flushed, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_base_src_get_qos_values (GstBaseSrc * src, gdouble * proportion,
+    GstClockTime * earliest_time)
+{
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_BASE_SRC (src), FALSE);
+
+  GST_OBJECT_LOCK (src);
+  res = GST_CLOCK_TIME_IS_VALID (src->priv->earliest_time);
+  if (proportion)
+    *proportion = src->priv->proportion;
+  if (earliest_time)
+    *earliest_time = src->priv->earliest_time;
+  GST_OBJECT_UNLOCK (src);
+
+  return res;
+}
+
+/* with OBJECT_LOCK */
+static inline void
+gst_base_src_reset_qos (GstBaseSrc * src)
+{
+  src->priv->proportion = 1.0;
+  src->priv->earliest_time = GST_CLOCK_TIME_NONE;
+}
+
 
 static gboolean
 gst_base_src_default_event (GstBaseSrc * src, GstEvent * event)
@@ -2772,6 +2868,214 @@ null_buffer:
   }
 }
 
+/* Like gst_base_src_get_range() but lets the subclass create up to
+ * @max_buffers buffers at once with create_list(). On success the list is
+ * stored as pending buffer list and @buf is set to its first buffer.
+ * Returns GST_FLOW_NOT_SUPPORTED if the subclass doesn't implement it, in
+ * which case nothing was consumed yet.
+ *
+ * Called with STREAM_LOCK and LIVE_LOCK */
+static GstFlowReturn
+gst_base_src_get_range_list (GstBaseSrc * src, guint64 offset, guint length,
+    guint max_buffers, GstBuffer ** buf)
+{
+  GstFlowReturn ret;
+  GstBaseSrcClass *bclass;
+  GstClockReturn status;
+  GstBufferList *list;
+  GstBuffer *first;
+  guint i, n;
+
+  bclass = GST_BASE_SRC_GET_CLASS (src);
+
+again:
+  if (src->is_live) {
+    if (G_UNLIKELY (!src->live_running)) {
+      ret = gst_base_src_wait_playing_unlocked (src);
+      if (ret != GST_FLOW_OK)
+        goto stopped;
+    }
+  }
+
+  if (G_UNLIKELY (!GST_BASE_SRC_IS_STARTED (src)
+          && !GST_BASE_SRC_IS_STARTING (src)))
+    goto not_started;
+
+  if (G_UNLIKELY (!gst_base_src_update_length (src, offset, &length, FALSE)))
+    goto unexpected_length;
+
+  /* track position */
+  GST_OBJECT_LOCK (src);
+  if (src->segment.format == GST_FORMAT_BYTES)
+    src->segment.position = offset;
+  GST_OBJECT_UNLOCK (src);
+
+  /* never create more buffers than we're allowed to push */
+  if (G_UNLIKELY (src->num_buffers_left >= 0)) {
+    if (src->num_buffers_left == 0)
+      goto reached_num_buffers;
+    max_buffers = MIN (max_buffers, src->num_buffers_left);
+  }
+
+  if (G_UNLIKELY (g_atomic_int_get (&src->priv->has_pending_eos))) {
+    src->priv->forced_eos = TRUE;
+    goto eos;
+  }
+
+  GST_DEBUG_OBJECT (src,
+      "calling create_list offset %" G_GUINT64_FORMAT " length %u, "
+      "max buffers %u", offset, length, max_buffers);
+
+  list = gst_buffer_list_new_sized (max_buffers);
+
+  GST_LIVE_UNLOCK (src);
+  ret = bclass->create_list (src, offset, length, max_buffers, list);
+  GST_LIVE_LOCK (src);
+
+  if (G_UNLIKELY (ret == GST_FLOW_NOT_SUPPORTED)) {
+    GST_DEBUG_OBJECT (src, "create_list not supported, using create");
+    src->priv->create_list_unsupported = TRUE;
+    gst_buffer_list_unref (list);
+    return GST_FLOW_NOT_SUPPORTED;
+  }
+
+  /* As we released the LIVE_LOCK, the state may have changed */
+  if (src->is_live) {
+    if (G_UNLIKELY (!src->live_running)) {
+      GstFlowReturn wait_ret;
+      wait_ret = gst_base_src_wait_playing_unlocked (src);
+      if (wait_ret != GST_FLOW_OK) {
+        gst_buffer_list_unref (list);
+        ret = wait_ret;
+        goto stopped;
+      }
+    }
+  }
+
+  if (G_UNLIKELY (g_atomic_int_get (&src->priv->has_pending_eos))) {
+    gst_buffer_list_unref (list);
+    src->priv->forced_eos = TRUE;
+    goto eos;
+  }
+
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    gst_buffer_list_unref (list);
+    goto not_ok;
+  }
+
+  n = gst_buffer_list_length (list);
+  if (G_UNLIKELY (n == 0)) {
+    gst_buffer_list_unref (list);
+    goto null_buffer;
+  }
+  if (G_UNLIKELY (n > max_buffers)) {
+    GST_WARNING_OBJECT (src, "create_list returned %u buffers instead of at "
+        "most %u, dropping the remaining ones", n, max_buffers);
+    gst_buffer_list_remove (list, max_buffers, n - max_buffers);
+    n = max_buffers;
+  }
+
+  if (G_UNLIKELY (src->num_buffers_left >= 0))
+    src->num_buffers_left -= n;
+
+  /* no timestamp set and we are at offset 0, we can timestamp with 0 */
+  first = gst_buffer_list_get_writable (list, 0);
+  if (offset == 0 && src->segment.time == 0
+      && GST_BUFFER_DTS (first) == -1 && !src->is_live) {
+    GST_DEBUG_OBJECT (src, "setting first timestamp to 0");
+    GST_BUFFER_DTS (first) = 0;
+  }
+
+  /* timestamp and sync every buffer of the list, the whole list is pushed
+   * once the last one is due */
+  for (i = 0; i < n; i++) {
+    status = gst_base_src_do_sync (src, gst_buffer_list_get_writable (list, i));
+
+    if (G_UNLIKELY (src->priv->flushing)) {
+      gst_buffer_list_unref (list);
+      goto flushing;
+    }
+
+    switch (status) {
+      case GST_CLOCK_EARLY:
+        GST_DEBUG_OBJECT (src, "buffer too late!, returning anyway");
+        break;
+      case GST_CLOCK_OK:
+        break;
+      case GST_CLOCK_UNSCHEDULED:
+        gst_buffer_list_unref (list);
+        if (!src->live_running) {
+          GST_DEBUG_OBJECT (src,
+              "clock was unscheduled (%d), returning FLUSHING", status);
+          return GST_FLOW_FLUSHING;
+        }
+        GST_DEBUG_OBJECT (src,
+            "clock was unscheduled (%d), but we are running", status);
+        goto again;
+      default:
+        GST_ELEMENT_ERROR (src, CORE, CLOCK,
+            (_("Internal clock error.")),
+            ("clock returned unexpected return value %d", status));
+        gst_buffer_list_unref (list);
+        return GST_FLOW_ERROR;
+    }
+  }
+
+  src->priv->pending_bufferlist = list;
+  src->priv->pending_batch = TRUE;
+  *buf = gst_buffer_list_get_writable (list, 0);
+
+  return GST_FLOW_OK;
+
+  /* ERROR */
+stopped:
+  {
+    GST_DEBUG_OBJECT (src, "wait_playing returned %d (%s)", ret,
+        gst_flow_get_name (ret));
+    return ret;
+  }
+not_ok:
+  {
+    GST_DEBUG_OBJECT (src, "create_list returned %d (%s)", ret,
+        gst_flow_get_name (ret));
+    return ret;
+  }
+not_started:
+  {
+    GST_DEBUG_OBJECT (src, "getrange but not started");
+    return GST_FLOW_FLUSHING;
+  }
+unexpected_length:
+  {
+    GST_DEBUG_OBJECT (src, "unexpected length %u (offset=%" G_GUINT64_FORMAT
+        ", size=%" G_GINT64_FORMAT ")", length, offset, src->segment.duration);
+    return GST_FLOW_EOS;
+  }
+reached_num_buffers:
+  {
+    GST_DEBUG_OBJECT (src, "sent all buffers");
+    return GST_FLOW_EOS;
+  }
+flushing:
+  {
+    GST_DEBUG_OBJECT (src, "we are flushing");
+    return GST_FLOW_FLUSHING;
+  }
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "we are EOS");
+    return GST_FLOW_EOS;
+  }
+null_buffer:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, FAILED,
+        (_("Internal data flow error.")),
+        ("Subclass %s didn't add any buffers to the list in its create_list "
+            "function", G_OBJECT_TYPE_NAME (src)));
+    return GST_FLOW_ERROR;
+  }
+}
+
 static GstFlowReturn
 gst_base_src_getrange (GstPad * pad, GstObject * parent, guint64 offset,
     guint length, GstBuffer ** buf)
@@ -2829,16 +3133,18 @@ static void
 gst_base_src_loop (GstPad * pad)
 {
   GstBaseSrc *src;
-  GstBuffer *buf = NULL;
+  GstBaseSrcClass *bclass;
+  GstBuffer *buf = NULL, *last;
   GstFlowReturn ret;
   gint64 position;
   gboolean eos;
-  guint blocksize;
+  guint blocksize, buffers_per_list;
   GList *pending_events = NULL, *tmp;
 
   eos = FALSE;
 
   src = GST_BASE_SRC (GST_OBJECT_PARENT (pad));
+  bclass = GST_BASE_SRC_GET_CLASS (src);
 
   /* Just leave immediately if we're flushing */
   GST_LIVE_LOCK (src);
@@ -2907,8 +3213,18 @@ gst_base_src_loop (GstPad * pad)
     gst_buffer_list_unref (src->priv->pending_bufferlist);
     src->priv->pending_bufferlist = NULL;
   }
+  src->priv->pending_batch = FALSE;
 
-  ret = gst_base_src_get_range (src, position, blocksize, &buf);
+  buffers_per_list = g_atomic_int_get (&src->priv->buffers_per_list);
+  if (buffers_per_list > 1 && bclass->create_list
+      && !src->priv->create_list_unsupported) {
+    ret = gst_base_src_get_range_list (src, position, blocksize,
+        buffers_per_list, &buf);
+    if (ret == GST_FLOW_NOT_SUPPORTED && src->priv->create_list_unsupported)
+      ret = gst_base_src_get_range (src, position, blocksize, &buf);
+  } else {
+    ret = gst_base_src_get_range (src, position, blocksize, &buf);
+  }
   if (G_UNLIKELY (ret != GST_FLOW_OK)) {
     GST_INFO_OBJECT (src, "pausing after gst_base_src_get_range() = %s",
         gst_flow_get_name (ret));
@@ -2949,11 +3265,25 @@ gst_base_src_loop (GstPad * pad)
     g_list_free (pending_events);
   }
 
+  /* the position is after the last buffer of a batch from create_list() */
+  last = buf;
+  if (src->priv->pending_batch) {
+    GstBufferList *list = src->priv->pending_bufferlist;
+
+    last = gst_buffer_list_get (list, gst_buffer_list_length (list) - 1);
+  }
+
   /* figure out the new position */
   switch (src->segment.format) {
     case GST_FORMAT_BYTES:
     {
-      guint bufsize = gst_buffer_get_size (buf);
+      gsize bufsize;
+
+      if (src->priv->pending_batch)
+        bufsize =
+            gst_buffer_list_calculate_size (src->priv->pending_bufferlist);
+      else
+        bufsize = gst_buffer_get_size (buf);
 
       /* we subtracted above for negative rates */
       if (src->segment.rate >= 0.0)
@@ -2964,8 +3294,8 @@ gst_base_src_loop (GstPad * pad)
     {
       GstClockTime start, duration;
 
-      start = GST_BUFFER_TIMESTAMP (buf);
-      duration = GST_BUFFER_DURATION (buf);
+      start = GST_BUFFER_TIMESTAMP (last);
+      duration = GST_BUFFER_DURATION (last);
 
       if (GST_CLOCK_TIME_IS_VALID (start))
         position = start;
@@ -2980,7 +3310,7 @@ gst_base_src_loop (GstPad * pad)
     }
     case GST_FORMAT_DEFAULT:
       if (src->segment.rate >= 0.0)
-        position = GST_BUFFER_OFFSET_END (buf);
+        position = GST_BUFFER_OFFSET_END (last);
       else
         position = GST_BUFFER_OFFSET (buf);
       break;
@@ -3026,6 +3356,7 @@ gst_base_src_loop (GstPad * pad)
   if (src->priv->pending_bufferlist != NULL) {
     ret = gst_pad_push_list (pad, src->priv->pending_bufferlist);
     src->priv->pending_bufferlist = NULL;
+    src->priv->pending_batch = FALSE;
   } else {
     ret = gst_pad_push (pad, buf);
   }
@@ -3506,6 +3837,7 @@ gst_base_src_start (GstBaseSrc * basesrc)
   basesrc->priv->start_result = GST_FLOW_FLUSHING;
   GST_OBJECT_FLAG_SET (basesrc, GST_BASE_SRC_FLAG_STARTING);
   gst_segment_init (&basesrc->segment, basesrc->segment.format);
+  gst_base_src_reset_qos (basesrc);
   GST_OBJECT_UNLOCK (basesrc);
 
   basesrc->num_buffers_left = basesrc->num_buffers;
@@ -3759,6 +4091,7 @@ gst_base_src_stop (GstBaseSrc * basesrc)
     gst_buffer_list_unref (basesrc->priv->pending_bufferlist);
     basesrc->priv->pending_bufferlist = NULL;
   }
+  basesrc->priv->pending_batch = FALSE;
 
   gst_base_src_set_allocation (basesrc, NULL, NULL, NULL);
 
@@ -3811,6 +4144,7 @@ gst_base_src_set_flushing (GstBaseSrc * basesrc, gboolean flushing)
 
     /* Drop all delayed events */
     GST_OBJECT_LOCK (basesrc);
+    gst_base_src_reset_qos (basesrc);
     if (basesrc->priv->pending_events) {
       g_list_foreach (basesrc->priv->pending_events, (GFunc) gst_event_unref,
           NULL);
@@ -163,6 +163,15 @@ struct _GstBaseSrc {
  *   default implementation will create a new buffer from the negotiated allocator.
  * @fill: Ask the subclass to fill the buffer with data for offset and size. The
  *   passed buffer is guaranteed to hold the requested amount of bytes.
+ * @create_list: Ask the subclass to add at least one and at most
+ *   @max_buffers buffers to @list, each created like with
+ *   #GstBaseSrcClass::create for the given offset and size. Only used in push
+ *   mode when more than one buffer per list is configured with
+ *   gst_base_src_set_buffers_per_list(). The base class takes care of
+ *   timestamping, the num-buffers limit and the segment position for all
+ *   buffers of the list and pushes them downstream as one buffer list.
+ *   Returning %GST_FLOW_NOT_SUPPORTED makes the base class use
+ *   #GstBaseSrcClass::create from then on. (Since: 1.20)
  *
  * Subclasses can override any of the available virtual methods or not, as
  * needed. At the minimum, the @create method should be overridden to produce
@@ -249,8 +258,12 @@ struct _GstBaseSrcClass {
   GstFlowReturn (*fill)         (GstBaseSrc *src, guint64 offset, guint size,
                                  GstBuffer *buf);
 
+  /* ask the subclass to create several buffers at once */
+  GstFlowReturn (*create_list)  (GstBaseSrc *src, guint64 offset, guint size,
+                                 guint max_buffers, GstBufferList *list);
+
   /*< private >*/
-  gpointer       _gst_reserved[GST_PADDING_LARGE];
+  gpointer       _gst_reserved[GST_PADDING_LARGE - 1];
 };
 
 GST_BASE_API
@@ -327,6 +340,17 @@ GST_BASE_API
 void            gst_base_src_submit_buffer_list (GstBaseSrc    * src,
                                                  GstBufferList * buffer_list);
 
+GST_BASE_API
+void            gst_base_src_set_buffers_per_list (GstBaseSrc * src, guint max_buffers);
+
+GST_BASE_API
+guint           gst_base_src_get_buffers_per_list (GstBaseSrc * src);
+
+GST_BASE_API
+gboolean        gst_base_src_get_qos_values   (GstBaseSrc *src,
+                                               gdouble *proportion,
+                                               GstClockTime *earliest_time);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstBaseSrc, gst_object_unref)
 
 G_END_DECLS
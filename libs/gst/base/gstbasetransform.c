@@ -156,13 +156,34 @@ enum
 };
 
 #define DEFAULT_PROP_QOS	FALSE
+#define DEFAULT_PROP_WRITABLE_WAIT	0
+#define DEFAULT_PROP_MAX_IN_FLIGHT	1
+#define DEFAULT_PROP_QOS_INTERVAL	0
 
 enum
 {
   PROP_0,
-  PROP_QOS
+  PROP_QOS,
+  PROP_WRITABLE_WAIT,
+  PROP_COPY_STATS,
+  PROP_MAX_IN_FLIGHT,
+  PROP_TASK_POOL,
+  PROP_QOS_INTERVAL
 };
 
+/* a buffer transformed on the worker pool in parallel mode */
+typedef struct
+{
+  GstBaseTransform *trans;
+  GstBuffer *inbuf;
+  GstBuffer *outbuf;
+  GstClockTime position;
+  gboolean in_place;
+  gboolean discont;
+  gboolean done;
+  GstFlowReturn ret;
+} GstBaseTransformJob;
+
 struct _GstBaseTransformPrivate
 {
   /* Set by sub-class */
@@ -181,6 +202,11 @@ struct _GstBaseTransformPrivate
   gboolean qos_enabled;
   gdouble proportion;
   GstClockTime earliest_time;
+  /* coalescing of forwarded QoS events, running time and diff of the last
+   * forwarded one */
+  GstClockTime qos_interval;
+  GstClockTime qos_last_forwarded;
+  GstClockTimeDiff qos_last_diff;
   /* previous buffer had a discont */
   gboolean discont;
 
@@ -193,6 +219,31 @@ struct _GstBaseTransformPrivate
   guint64 processed;
   guint64 dropped;
 
+  /* in-place statistics, with STREAM_LOCK */
+  GstClockTime writable_wait;   /* with LOCK */
+  guint64 in_place;
+  guint64 copied;
+  guint64 copied_bytes;
+  guint64 deferred;
+  guint64 memory_copies;
+
+  /* parallel mode. The flag is set by the subclass and max_in_flight and
+   * task_pool are properties, all protected with LOCK. The pool in use is
+   * set up from the streaming thread, the jobs are protected with
+   * parallel_lock */
+  gboolean parallel;
+  guint max_in_flight;
+  GstTaskPool *task_pool;
+  GstTaskPool *parallel_pool;
+  gboolean parallel_own_pool;
+  guint parallel_depth;
+  GMutex parallel_lock;
+  GCond parallel_cond;
+  GQueue jobs;
+  gboolean pushing;
+  gboolean parallel_discont;
+  GstFlowReturn parallel_result;
+
   GstClockTime position_out;
 
   GstBufferPool *pool;
@@ -213,6 +264,8 @@ static GstFlowReturn default_submit_input_buffer (GstBaseTransform * trans,
     gboolean is_discont, GstBuffer * input);
 static GstFlowReturn default_generate_output (GstBaseTransform * trans,
     GstBuffer ** outbuf);
+static void gst_base_transform_parallel_drain (GstBaseTransform * trans);
+static void gst_base_transform_parallel_stop (GstBaseTransform * trans);
 
 /* we can't use G_DEFINE_ABSTRACT_TYPE because we need the klass in the _init
  * method to get to the padtemplates */
@@ -314,6 +367,12 @@ gst_base_transform_default_transform_meta (GstBaseTransform * trans,
 static void
 gst_base_transform_finalize (GObject * object)
 {
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (object);
+
+  gst_clear_object (&trans->priv->task_pool);
+  g_mutex_clear (&trans->priv->parallel_lock);
+  g_cond_clear (&trans->priv->parallel_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -341,6 +400,100 @@ gst_base_transform_class_init (GstBaseTransformClass * klass)
       g_param_spec_boolean ("qos", "QoS", "Handle Quality-of-Service events",
           DEFAULT_PROP_QOS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstBaseTransform:writable-wait:
+   *
+   * Maximum time in nanoseconds to wait for a non-writable input buffer to
+   * become writable before copying it for an in-place transform. Buffers
+   * are often only shared for a short moment, for example while another
+   * branch of a tee still holds a reference that is released from a
+   * different thread. 0 copies right away.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WRITABLE_WAIT,
+      g_param_spec_uint64 ("writable-wait", "Writable wait",
+          "Maximum time to wait for a shared input buffer to become writable "
+          "before copying it for in-place processing (in nanoseconds)",
+          0, G_MAXUINT64, DEFAULT_PROP_WRITABLE_WAIT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseTransform:copy-stats:
+   *
+   * Statistics about the in-place processing of the element. This property
+   * returns a #GstStructure with name
+   * `application/x-gst-base-transform-copy-stats` with the following fields:
+   *
+   * - "in-place" G_TYPE_UINT64 buffers transformed in place without a copy
+   * - "copied" G_TYPE_UINT64 buffers that were copied because the input
+   *   buffer was shared
+   * - "copied-bytes" G_TYPE_UINT64 size of the copied buffers
+   * - "deferred" G_TYPE_UINT64 copies avoided by waiting for the input buffer
+   *   to become writable, see #GstBaseTransform:writable-wait
+   * - "memory-copies" G_TYPE_UINT64 buffers that were writable but contained
+   *   shared memory, which is copied when it is mapped for writing
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_COPY_STATS,
+      g_param_spec_boxed ("copy-stats", "Copy statistics",
+          "In-place processing and copy statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseTransform:max-in-flight:
+   *
+   * Maximum number of buffers that are transformed at the same time on
+   * worker threads. This only has an effect for subclasses that enabled
+   * parallel processing with gst_base_transform_set_parallel(). The output
+   * buffers are pushed in the order of the input buffers. 1 transforms the
+   * buffers in the streaming thread.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_IN_FLIGHT,
+      g_param_spec_uint ("max-in-flight", "Max in flight",
+          "Maximum number of buffers transformed in parallel, if supported "
+          "by the element (1 = in the streaming thread)", 1, G_MAXUINT,
+          DEFAULT_PROP_MAX_IN_FLIGHT, G_PARAM_READWRITE |
+          GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseTransform:task-pool:
+   *
+   * The #GstTaskPool to transform buffers on in parallel mode, see
+   * #GstBaseTransform:max-in-flight. When %NULL, a #GstSharedTaskPool with
+   * max-in-flight threads is created for the element.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_POOL,
+      g_param_spec_object ("task-pool", "Task pool",
+          "Task pool to transform buffers on in parallel mode "
+          "(NULL = private pool)", GST_TYPE_TASK_POOL,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseTransform:qos-interval:
+   *
+   * The minimum running time (in nanoseconds) between two QoS events that
+   * are forwarded upstream. The QoS events in between still update the QoS
+   * values of the element but are dropped, the next forwarded event carries
+   * the latest values. An event saying that downstream is late is forwarded
+   * right away when the last forwarded one said it was on time. 0 forwards
+   * all QoS events.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_QOS_INTERVAL,
+      g_param_spec_uint64 ("qos-interval", "QoS interval",
+          "Minimum running time between QoS events forwarded upstream "
+          "(in nanoseconds, 0 = all)", 0, G_MAXUINT64,
+          DEFAULT_PROP_QOS_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_base_transform_finalize;
 
   klass->passthrough_on_same_caps = FALSE;
@@ -411,6 +564,14 @@ gst_base_transform_init (GstBaseTransform * trans,
   gst_element_add_pad (GST_ELEMENT (trans), trans->srcpad);
 
   priv->qos_enabled = DEFAULT_PROP_QOS;
+  priv->writable_wait = DEFAULT_PROP_WRITABLE_WAIT;
+  priv->max_in_flight = DEFAULT_PROP_MAX_IN_FLIGHT;
+  priv->qos_interval = DEFAULT_PROP_QOS_INTERVAL;
+  priv->qos_last_forwarded = GST_CLOCK_TIME_NONE;
+  g_mutex_init (&priv->parallel_lock);
+  g_cond_init (&priv->parallel_cond);
+  g_queue_init (&priv->jobs);
+  priv->parallel_result = GST_FLOW_OK;
   priv->cache_caps1 = NULL;
   priv->cache_caps2 = NULL;
   priv->pad_mode = GST_PAD_MODE_NONE;
@@ -1619,12 +1780,60 @@ gst_base_transform_query (GstPad * pad, GstObject * parent, GstQuery * query)
   trans = GST_BASE_TRANSFORM_CAST (parent);
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
 
+  if (pad == trans->sinkpad && GST_QUERY_IS_SERIALIZED (query))
+    gst_base_transform_parallel_drain (trans);
+
   if (bclass->query)
     ret = bclass->query (trans, GST_PAD_DIRECTION (pad), query);
 
   return ret;
 }
 
+static gboolean
+gst_base_transform_memory_is_writable (GstBuffer * buffer)
+{
+  guint i, n = gst_buffer_n_memory (buffer);
+
+  for (i = 0; i < n; i++) {
+    if (!gst_memory_is_writable (gst_buffer_peek_memory (buffer, i)))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* waits up to writable-wait for the other references of @buffer to be
+ * dropped, with STREAM_LOCK */
+static gboolean
+gst_base_transform_wait_writable (GstBaseTransform * trans, GstBuffer * buffer)
+{
+  GstClockTime timeout;
+  gint64 deadline;
+  guint spins = 0;
+
+  GST_OBJECT_LOCK (trans);
+  timeout = trans->priv->writable_wait;
+  GST_OBJECT_UNLOCK (trans);
+
+  if (timeout == 0)
+    return FALSE;
+
+  deadline = g_get_monotonic_time () + timeout / GST_USECOND;
+  while (!gst_buffer_is_writable (buffer)) {
+    if (g_get_monotonic_time () >= deadline)
+      return FALSE;
+    /* yield for a few turns first, the reference is usually dropped soon */
+    if (spins++ < 64)
+      g_thread_yield ();
+    else
+      g_usleep (10);
+  }
+
+  GST_DEBUG_OBJECT (trans, "buffer %p became writable after waiting", buffer);
+  trans->priv->deferred++;
+
+  return TRUE;
+}
+
 /* this function either returns the input buffer without incrementing the
  * refcount or it allocates a new (writable) buffer */
 static GstFlowReturn
@@ -1669,11 +1878,25 @@ default_prepare_output_buffer (GstBaseTransform * trans,
   /* no pool, we need to figure out the size of the output buffer first */
   if ((bclass->transform_ip != NULL) && priv->always_in_place) {
     /* we want to do an in-place alloc */
-    if (gst_buffer_is_writable (inbuf)) {
+    if (gst_buffer_is_writable (inbuf)
+        || gst_base_transform_wait_writable (trans, inbuf)) {
       GST_DEBUG_OBJECT (trans, "inplace reuse writable input buffer");
+      if (G_UNLIKELY (!gst_base_transform_memory_is_writable (inbuf))) {
+        GST_CAT_DEBUG_OBJECT (GST_CAT_PERFORMANCE, trans,
+            "buffer %p has shared memory, mapping it writable copies it",
+            inbuf);
+        priv->memory_copies++;
+      }
+      priv->in_place++;
       *outbuf = inbuf;
     } else {
       GST_DEBUG_OBJECT (trans, "making writable buffer copy");
+      GST_CAT_DEBUG_OBJECT (GST_CAT_PERFORMANCE, trans,
+          "copying buffer %p of size %" G_GSIZE_FORMAT " for in-place "
+          "processing, it has %d references", inbuf,
+          gst_buffer_get_size (inbuf), GST_MINI_OBJECT_REFCOUNT_VALUE (inbuf));
+      priv->copied++;
+      priv->copied_bytes += gst_buffer_get_size (inbuf);
       /* we make a copy of the input buffer */
       *outbuf = gst_buffer_copy (inbuf);
     }
@@ -1900,6 +2123,13 @@ gst_base_transform_sink_event (GstPad * pad, GstObject * parent,
   trans = GST_BASE_TRANSFORM_CAST (parent);
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
 
+  /* push out everything transformed in parallel before the event */
+  if (GST_EVENT_IS_SERIALIZED (event)) {
+    gst_base_transform_parallel_drain (trans);
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+      trans->priv->parallel_result = GST_FLOW_OK;
+  }
+
   if (bclass->sink_event)
     ret = bclass->sink_event (trans, event);
   else
@@ -1922,6 +2152,7 @@ gst_base_transform_sink_eventfunc (GstBaseTransform * trans, GstEvent * event)
       /* reset QoS parameters */
       priv->proportion = 1.0;
       priv->earliest_time = -1;
+      priv->qos_last_forwarded = GST_CLOCK_TIME_NONE;
       priv->discont = FALSE;
       priv->processed = 0;
       priv->dropped = 0;
@@ -1989,6 +2220,34 @@ gst_base_transform_src_event (GstPad * pad, GstObject * parent,
   return ret;
 }
 
+/* whether a QoS event for @timestamp with @diff should be forwarded, or can
+ * be dropped because a later one will carry newer values */
+static gboolean
+gst_base_transform_qos_forward_is_due (GstBaseTransform * trans,
+    GstClockTimeDiff diff, GstClockTime timestamp)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  gboolean res;
+
+  GST_OBJECT_LOCK (trans);
+  if (priv->qos_interval == 0
+      || !GST_CLOCK_TIME_IS_VALID (priv->qos_last_forwarded))
+    res = TRUE;
+  else if (diff > 0 && priv->qos_last_diff <= 0)
+    res = TRUE;
+  else
+    res = timestamp < priv->qos_last_forwarded
+        || timestamp - priv->qos_last_forwarded >= priv->qos_interval;
+
+  if (res) {
+    priv->qos_last_forwarded = timestamp;
+    priv->qos_last_diff = diff;
+  }
+  GST_OBJECT_UNLOCK (trans);
+
+  return res;
+}
+
 static gboolean
 gst_base_transform_src_eventfunc (GstBaseTransform * trans, GstEvent * event)
 {
@@ -2009,6 +2268,12 @@ gst_base_transform_src_eventfunc (GstBaseTransform * trans, GstEvent * event)
 
       gst_event_parse_qos (event, NULL, &proportion, &diff, &timestamp);
       gst_base_transform_update_qos (trans, proportion, diff, timestamp);
+
+      if (!gst_base_transform_qos_forward_is_due (trans, diff, timestamp)) {
+        GST_CAT_LOG_OBJECT (GST_CAT_QOS, trans, "coalescing QoS event");
+        gst_event_unref (event);
+        return TRUE;
+      }
       break;
     }
     default:
@@ -2299,6 +2564,267 @@ pull_error:
  * getrange() function - we have data, feed it to the sub-class
  * and then iterate, pushing buffers it generates until it either
  * wants more data or returns an error */
+/* pushes the finished jobs at the head of the queue in input order. Only one
+ * thread pushes at a time. with parallel_lock */
+static void
+gst_base_transform_parallel_push_ready (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstBaseTransformJob *job;
+
+  if (priv->pushing)
+    return;
+
+  priv->pushing = TRUE;
+  while ((job = g_queue_peek_head (&priv->jobs)) && job->done) {
+    GstBuffer *outbuf = job->outbuf;
+    GstFlowReturn ret;
+
+    g_queue_pop_head (&priv->jobs);
+    g_cond_broadcast (&priv->parallel_cond);
+
+    if (job->ret != GST_FLOW_OK || priv->parallel_result != GST_FLOW_OK) {
+      if (job->ret == GST_BASE_TRANSFORM_FLOW_DROPPED) {
+        GST_DEBUG_OBJECT (trans, "dropped a buffer, marking DISCONT");
+        priv->parallel_discont = TRUE;
+      } else if (priv->parallel_result == GST_FLOW_OK) {
+        GST_DEBUG_OBJECT (trans, "we got return %s",
+            gst_flow_get_name (job->ret));
+        priv->parallel_result = job->ret;
+      }
+      gst_buffer_unref (outbuf);
+    } else {
+      GstClockTime position_out = GST_CLOCK_TIME_NONE;
+      gboolean discont = job->discont || priv->parallel_discont;
+
+      priv->parallel_discont = FALSE;
+      priv->processed++;
+      g_mutex_unlock (&priv->parallel_lock);
+
+      /* Remember last stop position */
+      if (job->position != GST_CLOCK_TIME_NONE &&
+          trans->segment.format == GST_FORMAT_TIME)
+        trans->segment.position = job->position;
+
+      if (GST_BUFFER_TIMESTAMP_IS_VALID (outbuf)) {
+        position_out = GST_BUFFER_TIMESTAMP (outbuf);
+        if (GST_BUFFER_DURATION_IS_VALID (outbuf))
+          position_out += GST_BUFFER_DURATION (outbuf);
+      } else if (job->position != GST_CLOCK_TIME_NONE) {
+        position_out = job->position;
+      }
+      if (position_out != GST_CLOCK_TIME_NONE
+          && trans->segment.format == GST_FORMAT_TIME)
+        priv->position_out = position_out;
+
+      if (discont && !GST_BUFFER_IS_DISCONT (outbuf)) {
+        GST_DEBUG_OBJECT (trans, "marking DISCONT on output buffer");
+        outbuf = gst_buffer_make_writable (outbuf);
+        GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+      }
+
+      ret = gst_pad_push (trans->srcpad, outbuf);
+
+      g_mutex_lock (&priv->parallel_lock);
+      if (ret != GST_FLOW_OK && priv->parallel_result == GST_FLOW_OK)
+        priv->parallel_result = ret;
+    }
+    g_free (job);
+  }
+  priv->pushing = FALSE;
+  g_cond_broadcast (&priv->parallel_cond);
+}
+
+static void
+gst_base_transform_parallel_func (gpointer data)
+{
+  GstBaseTransformJob *job = data;
+  GstBaseTransform *trans = job->trans;
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstFlowReturn ret;
+
+  if (job->in_place) {
+    GST_DEBUG_OBJECT (trans, "doing inplace transform");
+    ret = bclass->transform_ip (trans, job->outbuf);
+  } else if (bclass->transform) {
+    GST_DEBUG_OBJECT (trans, "doing non-inplace transform");
+    ret = bclass->transform (trans, job->inbuf, job->outbuf);
+  } else {
+    ret = GST_FLOW_NOT_SUPPORTED;
+  }
+
+  if (job->outbuf != job->inbuf)
+    gst_buffer_unref (job->inbuf);
+  job->inbuf = NULL;
+
+  g_mutex_lock (&priv->parallel_lock);
+  job->ret = ret;
+  job->done = TRUE;
+  gst_base_transform_parallel_push_ready (trans);
+  g_mutex_unlock (&priv->parallel_lock);
+}
+
+/* with STREAM_LOCK */
+static gboolean
+gst_base_transform_parallel_start (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstTaskPool *pool;
+  GError *err = NULL;
+
+  if (G_LIKELY (priv->parallel_pool))
+    return TRUE;
+
+  GST_OBJECT_LOCK (trans);
+  pool = priv->task_pool ? gst_object_ref (priv->task_pool) : NULL;
+  priv->parallel_depth = priv->max_in_flight;
+  GST_OBJECT_UNLOCK (trans);
+
+  if (pool == NULL) {
+    pool = gst_shared_task_pool_new ();
+    gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool),
+        priv->parallel_depth);
+    gst_task_pool_prepare (pool, &err);
+    if (G_UNLIKELY (err != NULL))
+      goto prepare_failed;
+    priv->parallel_own_pool = TRUE;
+  }
+
+  GST_DEBUG_OBJECT (trans, "transforming up to %u buffers in parallel",
+      priv->parallel_depth);
+  priv->parallel_pool = pool;
+
+  return TRUE;
+
+  /* ERRORS */
+prepare_failed:
+  {
+    GST_ELEMENT_ERROR (trans, CORE, THREAD,
+        ("Failed to prepare the task pool."), ("%s", err->message));
+    g_clear_error (&err);
+    gst_object_unref (pool);
+    return FALSE;
+  }
+}
+
+/* waits until all jobs are pushed, with STREAM_LOCK */
+static void
+gst_base_transform_parallel_drain (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+
+  if (G_LIKELY (priv->parallel_pool == NULL))
+    return;
+
+  g_mutex_lock (&priv->parallel_lock);
+  while (priv->jobs.length > 0 || priv->pushing)
+    g_cond_wait (&priv->parallel_cond, &priv->parallel_lock);
+  g_mutex_unlock (&priv->parallel_lock);
+}
+
+/* with STREAM_LOCK */
+static void
+gst_base_transform_parallel_stop (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+
+  if (priv->parallel_pool == NULL)
+    return;
+
+  gst_base_transform_parallel_drain (trans);
+
+  if (priv->parallel_own_pool)
+    gst_task_pool_cleanup (priv->parallel_pool);
+  gst_clear_object (&priv->parallel_pool);
+  priv->parallel_own_pool = FALSE;
+  priv->parallel_discont = FALSE;
+  priv->parallel_result = GST_FLOW_OK;
+}
+
+/* prepares the output buffer for the queued input buffer and transforms it
+ * on the worker pool. Waits while max-in-flight buffers are being
+ * transformed. with STREAM_LOCK */
+static GstFlowReturn
+gst_base_transform_parallel_submit (GstBaseTransform * trans,
+    GstClockTime position)
+{
+  GstBaseTransformClass *bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstBaseTransformJob *job;
+  GstBuffer *inbuf, *outbuf = NULL;
+  GstFlowReturn ret;
+  GError *err = NULL;
+  gpointer id;
+
+  inbuf = trans->queued_buf;
+  trans->queued_buf = NULL;
+  if (inbuf == NULL)
+    return GST_FLOW_OK;
+
+  if (G_UNLIKELY (!gst_base_transform_parallel_start (trans))) {
+    gst_buffer_unref (inbuf);
+    return GST_FLOW_ERROR;
+  }
+
+  if (bclass->prepare_output_buffer == NULL)
+    goto no_prepare;
+
+  ret = bclass->prepare_output_buffer (trans, inbuf, &outbuf);
+  if (ret != GST_FLOW_OK || outbuf == NULL)
+    goto no_buffer;
+
+  job = g_new0 (GstBaseTransformJob, 1);
+  job->trans = trans;
+  job->inbuf = inbuf;
+  job->outbuf = outbuf;
+  job->position = position;
+  job->in_place = (bclass->transform_ip != NULL) && priv->always_in_place;
+  job->discont = priv->discont;
+  priv->discont = FALSE;
+
+  g_mutex_lock (&priv->parallel_lock);
+  g_queue_push_tail (&priv->jobs, job);
+  g_mutex_unlock (&priv->parallel_lock);
+
+  id = gst_task_pool_push (priv->parallel_pool,
+      gst_base_transform_parallel_func, job, &err);
+  if (G_UNLIKELY (err != NULL)) {
+    GST_WARNING_OBJECT (trans, "failed to schedule transform, doing it in "
+        "the streaming thread: %s", err->message);
+    g_clear_error (&err);
+    gst_base_transform_parallel_func (job);
+  } else if (id) {
+    gst_task_pool_dispose_handle (priv->parallel_pool, id);
+  }
+
+  /* wait until there is room for the next buffer */
+  g_mutex_lock (&priv->parallel_lock);
+  while (priv->jobs.length >= priv->parallel_depth
+      && priv->parallel_result == GST_FLOW_OK)
+    g_cond_wait (&priv->parallel_cond, &priv->parallel_lock);
+  ret = priv->parallel_result;
+  g_mutex_unlock (&priv->parallel_lock);
+
+  return ret;
+
+  /* ERRORS */
+no_prepare:
+  {
+    gst_buffer_unref (inbuf);
+    GST_ELEMENT_ERROR (trans, STREAM, NOT_IMPLEMENTED,
+        ("Sub-class has no prepare_output_buffer implementation"), (NULL));
+    return GST_FLOW_NOT_SUPPORTED;
+  }
+no_buffer:
+  {
+    gst_buffer_unref (inbuf);
+    GST_WARNING_OBJECT (trans, "could not get buffer from pool: %s",
+        gst_flow_get_name (ret));
+    return ret;
+  }
+}
+
 static GstFlowReturn
 gst_base_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
@@ -2335,6 +2861,13 @@ gst_base_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (ret != GST_FLOW_OK)
     goto done;
 
+  if (G_UNLIKELY (priv->parallel) && priv->max_in_flight > 1
+      && klass->generate_output == default_generate_output
+      && !priv->passthrough) {
+    ret = gst_base_transform_parallel_submit (trans, position);
+    goto done;
+  }
+
   do {
     outbuf = NULL;
 
@@ -2405,6 +2938,27 @@ gst_base_transform_set_property (GObject * object, guint prop_id,
     case PROP_QOS:
       gst_base_transform_set_qos_enabled (trans, g_value_get_boolean (value));
       break;
+    case PROP_WRITABLE_WAIT:
+      GST_OBJECT_LOCK (trans);
+      trans->priv->writable_wait = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (trans);
+      trans->priv->max_in_flight = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (trans);
+      gst_object_replace ((GstObject **) & trans->priv->task_pool,
+          g_value_get_object (value));
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_QOS_INTERVAL:
+      GST_OBJECT_LOCK (trans);
+      trans->priv->qos_interval = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (trans);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2423,6 +2977,36 @@ gst_base_transform_get_property (GObject * object, guint prop_id,
     case PROP_QOS:
       g_value_set_boolean (value, gst_base_transform_is_qos_enabled (trans));
       break;
+    case PROP_WRITABLE_WAIT:
+      GST_OBJECT_LOCK (trans);
+      g_value_set_uint64 (value, trans->priv->writable_wait);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_MAX_IN_FLIGHT:
+      GST_OBJECT_LOCK (trans);
+      g_value_set_uint (value, trans->priv->max_in_flight);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_TASK_POOL:
+      GST_OBJECT_LOCK (trans);
+      g_value_set_object (value, trans->priv->task_pool);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_QOS_INTERVAL:
+      GST_OBJECT_LOCK (trans);
+      g_value_set_uint64 (value, trans->priv->qos_interval);
+      GST_OBJECT_UNLOCK (trans);
+      break;
+    case PROP_COPY_STATS:
+      g_value_take_boxed (value, gst_structure_new
+          ("application/x-gst-base-transform-copy-stats",
+              "in-place", G_TYPE_UINT64, trans->priv->in_place,
+              "copied", G_TYPE_UINT64, trans->priv->copied,
+              "copied-bytes", G_TYPE_UINT64, trans->priv->copied_bytes,
+              "deferred", G_TYPE_UINT64, trans->priv->deferred,
+              "memory-copies", G_TYPE_UINT64, trans->priv->memory_copies,
+              NULL));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2461,9 +3045,15 @@ gst_base_transform_activate (GstBaseTransform * trans, gboolean active)
     priv->position_out = GST_CLOCK_TIME_NONE;
     priv->proportion = 1.0;
     priv->earliest_time = -1;
+    priv->qos_last_forwarded = GST_CLOCK_TIME_NONE;
     priv->discont = FALSE;
     priv->processed = 0;
     priv->dropped = 0;
+    priv->in_place = 0;
+    priv->copied = 0;
+    priv->copied_bytes = 0;
+    priv->deferred = 0;
+    priv->memory_copies = 0;
     GST_OBJECT_UNLOCK (trans);
 
     if (incaps)
@@ -2474,6 +3064,7 @@ gst_base_transform_activate (GstBaseTransform * trans, gboolean active)
     /* We must make sure streaming has finished before resetting things
      * and calling the ::stop vfunc */
     GST_PAD_STREAM_LOCK (trans->sinkpad);
+    gst_base_transform_parallel_stop (trans);
     GST_PAD_STREAM_UNLOCK (trans->sinkpad);
 
     priv->have_same_caps = FALSE;
@@ -2653,6 +3244,61 @@ gst_base_transform_set_in_place (GstBaseTransform * trans, gboolean in_place)
   GST_OBJECT_UNLOCK (trans);
 }
 
+/**
+ * gst_base_transform_set_parallel:
+ * @trans: the #GstBaseTransform to modify
+ * @parallel: whether buffers can be transformed in parallel
+ *
+ * Declares that the #GstBaseTransformClass.transform() and
+ * #GstBaseTransformClass.transform_ip() functions of @trans can be called
+ * for several buffers at the same time from different threads, because the
+ * buffers are processed independently of each other.
+ *
+ * Buffers are then transformed on a worker pool with up to
+ * #GstBaseTransform:max-in-flight buffers in flight, and the output buffers
+ * are pushed in the order of the input buffers. prepare_output_buffer() and
+ * QoS handling are still done in the streaming thread. Subclasses that
+ * implement #GstBaseTransformClass.generate_output() are not affected.
+ *
+ * This function is usually called from the instance init function of the
+ * subclass.
+ *
+ * Since: 1.20
+ */
+void
+gst_base_transform_set_parallel (GstBaseTransform * trans, gboolean parallel)
+{
+  g_return_if_fail (GST_IS_BASE_TRANSFORM (trans));
+
+  GST_OBJECT_LOCK (trans);
+  trans->priv->parallel = parallel;
+  GST_OBJECT_UNLOCK (trans);
+}
+
+/**
+ * gst_base_transform_is_parallel:
+ * @trans: the #GstBaseTransform to query
+ *
+ * See if @trans supports transforming buffers in parallel.
+ *
+ * Returns: %TRUE if gst_base_transform_set_parallel() was enabled.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_base_transform_is_parallel (GstBaseTransform * trans)
+{
+  gboolean result;
+
+  g_return_val_if_fail (GST_IS_BASE_TRANSFORM (trans), FALSE);
+
+  GST_OBJECT_LOCK (trans);
+  result = trans->priv->parallel;
+  GST_OBJECT_UNLOCK (trans);
+
+  return result;
+}
+
 /**
  * gst_base_transform_is_in_place:
  * @trans: the #GstBaseTransform to query
@@ -2919,3 +3565,65 @@ gst_base_transform_update_src_caps (GstBaseTransform * trans,
 
   return FALSE;
 }
+
+/**
+ * gst_base_transform_push_list:
+ * @trans: a #GstBaseTransform
+ * @list: (transfer full): a #GstBufferList
+ *
+ * Pushes @list on the source pad of @trans. This is meant for subclasses
+ * with a chain list function on their sink pad that have no per-buffer work
+ * to do and forward buffer lists as one unit.
+ *
+ * Like for every buffer pushed by @trans, the segment position and the
+ * position answered to POSITION queries on the source pad are updated, from
+ * the last buffer of @list, and a pending DISCONT is set on the first buffer
+ * of @list.
+ *
+ * Returns: a #GstFlowReturn from the push on the source pad.
+ *
+ * Since: 1.20
+ */
+GstFlowReturn
+gst_base_transform_push_list (GstBaseTransform * trans, GstBufferList * list)
+{
+  GstBaseTransformPrivate *priv;
+  GstBuffer *buf;
+  guint len;
+
+  g_return_val_if_fail (GST_IS_BASE_TRANSFORM (trans), GST_FLOW_ERROR);
+  g_return_val_if_fail (GST_IS_BUFFER_LIST (list), GST_FLOW_ERROR);
+
+  priv = trans->priv;
+  len = gst_buffer_list_length (list);
+  if (len == 0)
+    return gst_pad_push_list (trans->srcpad, list);
+
+  /* Remember last stop position */
+  buf = gst_buffer_list_get (list, len - 1);
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (buf)
+      && trans->segment.format == GST_FORMAT_TIME) {
+    GstClockTime position = GST_BUFFER_TIMESTAMP (buf);
+
+    if (GST_BUFFER_DURATION_IS_VALID (buf))
+      position += GST_BUFFER_DURATION (buf);
+    trans->segment.position = position;
+    priv->position_out = position;
+  }
+
+  /* apply DISCONT flag if the first buffer is not yet marked as such */
+  if (priv->discont) {
+    GST_DEBUG_OBJECT (trans, "we have a pending DISCONT");
+    buf = gst_buffer_list_get (list, 0);
+    if (!GST_BUFFER_IS_DISCONT (buf)) {
+      GST_DEBUG_OBJECT (trans, "marking DISCONT on first buffer of list");
+      list = gst_buffer_list_make_writable (list);
+      buf = gst_buffer_list_get_writable (list, 0);
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    }
+    priv->discont = FALSE;
+  }
+  priv->processed += len;
+
+  return gst_pad_push_list (trans->srcpad, list);
+}
@@ -328,6 +328,12 @@ void		gst_base_transform_set_in_place     (GstBaseTransform *trans,
 GST_BASE_API
 gboolean	gst_base_transform_is_in_place      (GstBaseTransform *trans);
 
+GST_BASE_API
+void		gst_base_transform_set_parallel     (GstBaseTransform *trans,
+	                                             gboolean parallel);
+GST_BASE_API
+gboolean	gst_base_transform_is_parallel      (GstBaseTransform *trans);
+
 GST_BASE_API
 void		gst_base_transform_update_qos       (GstBaseTransform *trans,
 						     gdouble proportion,
@@ -365,6 +371,10 @@ gboolean gst_base_transform_update_src_caps (GstBaseTransform *trans,
 GST_BASE_API
 gboolean gst_base_transform_reconfigure (GstBaseTransform * trans);
 
+GST_BASE_API
+GstFlowReturn gst_base_transform_push_list (GstBaseTransform * trans,
+                                            GstBufferList * list);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstBaseTransform, gst_object_unref)
 
 G_END_DECLS
@@ -45,7 +45,8 @@
  *
  * #GstBitReader provides a bit reader that can read any number of bits
  * from a memory buffer. It provides functions for reading any number of bits
- * into 8, 16, 32 and 64 bit variables.
+ * into 8, 16, 32 and 64 bit variables, and for reading the Exp-Golomb codes
+ * used by the headers of MPEG and ITU video bitstreams.
  */
 
 /**
@@ -305,3 +306,41 @@ GST_BIT_READER_READ_BITS (8);
 GST_BIT_READER_READ_BITS (16);
 GST_BIT_READER_READ_BITS (32);
 GST_BIT_READER_READ_BITS (64);
+
+/**
+ * gst_bit_reader_get_ue:
+ * @reader: a #GstBitReader instance
+ * @val: (out): Pointer to a #guint32 to store the result
+ *
+ * Read an unsigned Exp-Golomb code, as used for the ue(v) syntax elements
+ * of H.264 and H.265, into @val and update the current position.
+ *
+ * Codes with more than 31 leading zero bits are not supported.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_bit_reader_get_ue (GstBitReader * reader, guint32 * val)
+{
+  return _gst_bit_reader_get_ue_inline (reader, val);
+}
+
+/**
+ * gst_bit_reader_get_se:
+ * @reader: a #GstBitReader instance
+ * @val: (out): Pointer to a #gint32 to store the result
+ *
+ * Read a signed Exp-Golomb code, as used for the se(v) syntax elements
+ * of H.264 and H.265, into @val and update the current position.
+ *
+ * Returns: %TRUE if successful, %FALSE otherwise.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_bit_reader_get_se (GstBitReader * reader, gint32 * val)
+{
+  return _gst_bit_reader_get_se_inline (reader, val);
+}
@@ -102,6 +102,12 @@ gboolean        gst_bit_reader_peek_bits_uint32 (const GstBitReader *reader, gui
 GST_BASE_API
 gboolean        gst_bit_reader_peek_bits_uint64 (const GstBitReader *reader, guint64 *val, guint nbits);
 
+GST_BASE_API
+gboolean        gst_bit_reader_get_ue           (GstBitReader *reader, guint32 *val);
+
+GST_BASE_API
+gboolean        gst_bit_reader_get_se           (GstBitReader *reader, gint32 *val);
+
 /**
  * GST_BIT_READER_INIT:
  * @data: Data from which the #GstBitReader should read
@@ -145,6 +151,11 @@ gst_bit_reader_peek_bits_uint##bits##_unchecked (const GstBitReader *reader, gui
   byte = reader->byte; \
   bit = reader->bit; \
   \
+  /* one big endian 64 bit load covers all bits if enough bytes are left */ \
+  if (G_LIKELY (nbits > 0 && nbits + bit <= 64 && reader->size - byte >= 8)) \
+    return (guint##bits) ((GST_READ_UINT64_BE (data + byte) << bit) >> \
+        (64 - nbits)); \
+  \
   while (nbits > 0) { \
     guint toread = MIN (nbits, 8 - bit); \
     \
@@ -181,6 +192,17 @@ __GST_BIT_READER_READ_BITS_UNCHECKED (64)
 
 #undef __GST_BIT_READER_READ_BITS_UNCHECKED
 
+/* number of leading zero bits in @val, which must not be 0 */
+static inline guint
+_gst_bit_reader_clz32 (guint32 val)
+{
+#if defined(__GNUC__) && (__GNUC__ > 3 || (__GNUC__ == 3 && __GNUC_MINOR__ >= 4))
+  return __builtin_clz (val);
+#else
+  return 31 - g_bit_nth_msf (val, -1);
+#endif
+}
+
 /* unchecked variants -- do not use */
 
 static inline guint
@@ -288,6 +310,54 @@ __GST_BIT_READER_READ_BITS_INLINE (64)
 
 #undef __GST_BIT_READER_READ_BITS_INLINE
 
+static inline gboolean
+_gst_bit_reader_get_ue_inline (GstBitReader * reader, guint32 * val)
+{
+  guint remaining, n, leading_zeros;
+  guint32 word;
+
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (val != NULL, FALSE);
+
+  remaining = _gst_bit_reader_get_remaining_unchecked (reader);
+  if (G_UNLIKELY (remaining == 0))
+    return FALSE;
+
+  /* find the first 1 bit among the next 32 bits at once */
+  n = MIN (remaining, 32);
+  word = gst_bit_reader_peek_bits_uint32_unchecked (reader, n) << (32 - n);
+  if (G_UNLIKELY (word == 0))
+    return FALSE;
+
+  leading_zeros = _gst_bit_reader_clz32 (word);
+  if (G_UNLIKELY (remaining < 2 * leading_zeros + 1))
+    return FALSE;
+
+  gst_bit_reader_skip_unchecked (reader, leading_zeros + 1);
+  *val = ((1U << leading_zeros) - 1) +
+      gst_bit_reader_get_bits_uint32_unchecked (reader, leading_zeros);
+
+  return TRUE;
+}
+
+static inline gboolean
+_gst_bit_reader_get_se_inline (GstBitReader * reader, gint32 * val)
+{
+  guint32 ue;
+
+  g_return_val_if_fail (val != NULL, FALSE);
+
+  if (!_gst_bit_reader_get_ue_inline (reader, &ue))
+    return FALSE;
+
+  if (ue & 1)
+    *val = (gint32) ((ue >> 1) + 1);
+  else
+    *val = -(gint32) (ue >> 1);
+
+  return TRUE;
+}
+
 #ifndef GST_BIT_READER_DISABLE_INLINES
 
 #define gst_bit_reader_get_size(reader) \
@@ -321,6 +391,11 @@ __GST_BIT_READER_READ_BITS_INLINE (64)
     G_LIKELY (_gst_bit_reader_peek_bits_uint32_inline (reader, val, nbits))
 #define gst_bit_reader_peek_bits_uint64(reader, val, nbits) \
     G_LIKELY (_gst_bit_reader_peek_bits_uint64_inline (reader, val, nbits))
+
+#define gst_bit_reader_get_ue(reader, val) \
+    G_LIKELY (_gst_bit_reader_get_ue_inline (reader, val))
+#define gst_bit_reader_get_se(reader, val) \
+    G_LIKELY (_gst_bit_reader_get_se_inline (reader, val))
 #endif
 
 G_END_DECLS
@@ -37,8 +37,111 @@
  * #GstBitWriter provides a bit writer that can write any number of
  * bits into a memory buffer. It provides functions for writing any
  * number of bits into 8, 16, 32 and 64 bit variables.
+ *
+ * A writer initialized with gst_bit_writer_init_chunked() grows by adding
+ * chunks instead of reallocating its data, and
+ * gst_bit_writer_reset_and_get_buffer() returns the chunks as the memory of
+ * one #GstBuffer without copying. The size, position and data of such a
+ * writer refer to the current chunk.
  */
 
+/* leaves room for the sysmem header and alignment, so the chunks of the
+ * default allocator fit the largest size of its per-thread block cache */
+#define DEFAULT_CHUNK_SIZE (4096 - 256)
+
+typedef struct
+{
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  guint chunk_size;
+
+  /* completed chunks */
+  GstBuffer *buffer;
+
+  /* the chunk being written, mapped writable */
+  GstMemory *mem;
+  GstMapInfo map;
+} GstBitWriterChunks;
+
+static void
+gst_bit_writer_chunks_finish (GstBitWriter * bitwriter, guint size)
+{
+  GstBitWriterChunks *chunks = bitwriter->chunks;
+
+  if (chunks->mem == NULL)
+    return;
+
+  gst_memory_unmap (chunks->mem, &chunks->map);
+  if (size > 0) {
+    gst_memory_resize (chunks->mem, 0, size);
+    gst_buffer_append_memory (chunks->buffer, chunks->mem);
+  } else {
+    gst_memory_unref (chunks->mem);
+  }
+  chunks->mem = NULL;
+
+  bitwriter->data = NULL;
+  bitwriter->bit_size = 0;
+  bitwriter->bit_capacity = 0;
+}
+
+static void
+gst_bit_writer_chunks_free (GstBitWriter * bitwriter)
+{
+  GstBitWriterChunks *chunks = bitwriter->chunks;
+
+  if (chunks->mem) {
+    gst_memory_unmap (chunks->mem, &chunks->map);
+    gst_memory_unref (chunks->mem);
+  }
+  gst_buffer_unref (chunks->buffer);
+  if (chunks->allocator)
+    gst_object_unref (chunks->allocator);
+  g_slice_free (GstBitWriterChunks, chunks);
+  bitwriter->chunks = NULL;
+}
+
+/* completes the current chunk at the last complete byte and continues in a
+ * new, zeroed chunk with room for at least @bits more bits. A partially
+ * written byte moves along into the new chunk. */
+gboolean
+_gst_bit_writer_next_chunk (GstBitWriter * bitwriter, guint32 bits)
+{
+  GstBitWriterChunks *chunks = bitwriter->chunks;
+  GstMemory *mem;
+  GstMapInfo map;
+  guint partial;
+  gsize size;
+
+  g_return_val_if_fail (chunks != NULL, FALSE);
+
+  partial = bitwriter->bit_size & 0x07;
+  size = MAX (chunks->chunk_size, ((gsize) bits + partial + 7) >> 3);
+  if (G_UNLIKELY (size > G_MAXUINT32 >> 3))
+    return FALSE;
+
+  mem = gst_allocator_alloc (chunks->allocator, size, &chunks->params);
+  if (G_UNLIKELY (mem == NULL))
+    return FALSE;
+  if (G_UNLIKELY (!gst_memory_map (mem, &map, GST_MAP_WRITE))) {
+    gst_memory_unref (mem);
+    return FALSE;
+  }
+
+  memset (map.data, 0, map.size);
+  if (partial)
+    map.data[0] = bitwriter->data[bitwriter->bit_size >> 3];
+  gst_bit_writer_chunks_finish (bitwriter, bitwriter->bit_size >> 3);
+
+  chunks->mem = mem;
+  chunks->map = map;
+  bitwriter->data = map.data;
+  bitwriter->bit_size = partial;
+  bitwriter->bit_capacity = MIN (map.size, G_MAXUINT32 >> 3) << 3;
+
+  return TRUE;
+}
+
 /**
  * gst_bit_writer_new: (skip)
  *
@@ -102,6 +205,33 @@ gst_bit_writer_new_with_data (guint8 * data, guint size, gboolean initialized)
   return ret;
 }
 
+/**
+ * gst_bit_writer_new_chunked: (skip)
+ * @allocator: (transfer none) (allow-none): the #GstAllocator for the chunks,
+ *     or %NULL to use the default allocator
+ * @params: (transfer none) (allow-none): the #GstAllocationParams for the
+ *     chunks, or %NULL
+ * @chunk_size: the size of a chunk in bytes, or 0 to use a default size
+ *
+ * Creates a new, empty #GstBitWriter instance that writes to chunks
+ * allocated from @allocator. See gst_bit_writer_init_chunked().
+ *
+ * Free-function: gst_bit_writer_free
+ *
+ * Returns: (transfer full): a new, empty #GstBitWriter instance
+ *
+ * Since: 1.20
+ */
+GstBitWriter *
+gst_bit_writer_new_chunked (GstAllocator * allocator,
+    const GstAllocationParams * params, guint chunk_size)
+{
+  GstBitWriter *ret = g_slice_new0 (GstBitWriter);
+
+  gst_bit_writer_init_chunked (ret, allocator, params, chunk_size);
+  return ret;
+}
+
 /**
  * gst_bit_writer_init: (skip)
  * @bitwriter: #GstBitWriter instance
@@ -166,6 +296,50 @@ gst_bit_writer_init_with_data (GstBitWriter * bitwriter, guint8 * data,
   bitwriter->owned = FALSE;
 }
 
+/**
+ * gst_bit_writer_init_chunked: (skip)
+ * @bitwriter: #GstBitWriter instance
+ * @allocator: (transfer none) (allow-none): the #GstAllocator for the chunks,
+ *     or %NULL to use the default allocator
+ * @params: (transfer none) (allow-none): the #GstAllocationParams for the
+ *     chunks, or %NULL
+ * @chunk_size: the size of a chunk in bytes, or 0 to use a default size
+ *
+ * Initializes @bitwriter to an empty instance that grows by allocating new
+ * chunks of at least @chunk_size bytes from @allocator instead of
+ * reallocating and copying its data. The chunks become the memory of the
+ * buffer returned by gst_bit_writer_reset_and_get_buffer(); a chunk always
+ * ends at a byte boundary.
+ *
+ * gst_bit_writer_get_size(), gst_bit_writer_get_data() and
+ * gst_bit_writer_set_pos() refer to the current chunk only.
+ *
+ * Since: 1.20
+ */
+void
+gst_bit_writer_init_chunked (GstBitWriter * bitwriter,
+    GstAllocator * allocator, const GstAllocationParams * params,
+    guint chunk_size)
+{
+  GstBitWriterChunks *chunks;
+
+  g_return_if_fail (bitwriter != NULL);
+
+  gst_bit_writer_init (bitwriter);
+
+  chunks = g_slice_new0 (GstBitWriterChunks);
+  if (allocator)
+    chunks->allocator = gst_object_ref (allocator);
+  if (params)
+    chunks->params = *params;
+  else
+    gst_allocation_params_init (&chunks->params);
+  chunks->chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
+  chunks->buffer = gst_buffer_new ();
+
+  bitwriter->chunks = chunks;
+}
+
 /**
  * gst_bit_writer_reset:
  * @bitwriter: #GstBitWriter instance
@@ -177,7 +351,9 @@ gst_bit_writer_reset (GstBitWriter * bitwriter)
 {
   g_return_if_fail (bitwriter != NULL);
 
-  if (bitwriter->owned)
+  if (bitwriter->chunks)
+    gst_bit_writer_chunks_free (bitwriter);
+  else if (bitwriter->owned)
     g_free (bitwriter->data);
   memset (bitwriter, 0, sizeof (GstBitWriter));
 }
@@ -200,6 +376,18 @@ gst_bit_writer_reset_and_get_data (GstBitWriter * bitwriter)
 
   g_return_val_if_fail (bitwriter != NULL, NULL);
 
+  if (bitwriter->chunks) {
+    GstBitWriterChunks *chunks = bitwriter->chunks;
+    gsize size;
+
+    gst_bit_writer_chunks_finish (bitwriter,
+        GST_ROUND_UP_8 (bitwriter->bit_size) >> 3);
+    gst_buffer_extract_dup (chunks->buffer, 0, -1, (gpointer *) & data, &size);
+    gst_bit_writer_reset (bitwriter);
+
+    return data;
+  }
+
   data = bitwriter->data;
   if (bitwriter->owned)
     data = g_memdup2 (data, GST_ROUND_UP_8 (bitwriter->bit_size) >> 3);
@@ -229,6 +417,17 @@ gst_bit_writer_reset_and_get_buffer (GstBitWriter * bitwriter)
 
   g_return_val_if_fail (bitwriter != NULL, NULL);
 
+  if (bitwriter->chunks) {
+    GstBitWriterChunks *chunks = bitwriter->chunks;
+
+    gst_bit_writer_chunks_finish (bitwriter,
+        GST_ROUND_UP_8 (bitwriter->bit_size) >> 3);
+    buffer = gst_buffer_ref (chunks->buffer);
+    gst_bit_writer_reset (bitwriter);
+
+    return buffer;
+  }
+
   owned = bitwriter->owned;
 
   size = GST_ROUND_UP_8 (bitwriter->bit_size) >> 3;
@@ -54,7 +54,8 @@ struct _GstBitWriter
   guint bit_capacity; /* Capacity of the allocated data */
   gboolean auto_grow; /* Whether space can auto grow */
   gboolean owned;
-  gpointer _gst_reserved[GST_PADDING];
+  gpointer chunks;
+  gpointer _gst_reserved[GST_PADDING - 1];
 };
 
 GST_BASE_API
@@ -76,6 +77,11 @@ guint8 *        gst_bit_writer_free_and_get_data (GstBitWriter *bitwriter);
 GST_BASE_API
 GstBuffer *     gst_bit_writer_free_and_get_buffer (GstBitWriter *bitwriter);
 
+GST_BASE_API
+GstBitWriter *  gst_bit_writer_new_chunked      (GstAllocator *allocator,
+						 const GstAllocationParams *params,
+						 guint chunk_size) G_GNUC_MALLOC;
+
 GST_BASE_API
 void            gst_bit_writer_init             (GstBitWriter *bitwriter);
 
@@ -87,6 +93,12 @@ GST_BASE_API
 void            gst_bit_writer_init_with_data   (GstBitWriter *bitwriter,  guint8 *data,
 						 guint size, gboolean initialized);
 
+GST_BASE_API
+void            gst_bit_writer_init_chunked     (GstBitWriter *bitwriter,
+						 GstAllocator *allocator,
+						 const GstAllocationParams *params,
+						 guint chunk_size);
+
 GST_BASE_API
 void            gst_bit_writer_reset            (GstBitWriter *bitwriter);
 
@@ -142,6 +154,10 @@ static const guint8 _gst_bit_writer_bit_filling_mask[9] = {
 #define __GST_BITS_WRITER_ALIGNED(bitsize)                   \
     (((bitsize) + __GST_BITS_WRITER_ALIGNMENT_MASK)&(~__GST_BITS_WRITER_ALIGNMENT_MASK))
 
+/* private, used by the inline functions of chunked writers */
+GST_BASE_API
+gboolean        _gst_bit_writer_next_chunk      (GstBitWriter *bitwriter, guint32 bits);
+
 static inline gboolean
 _gst_bit_writer_check_remaining (GstBitWriter * bitwriter, guint32 bits)
 {
@@ -155,6 +171,9 @@ _gst_bit_writer_check_remaining (GstBitWriter * bitwriter, guint32 bits)
   if (!bitwriter->auto_grow)
     return FALSE;
 
+  if (bitwriter->chunks != NULL)
+    return _gst_bit_writer_next_chunk (bitwriter, bits);
+
   /* auto grow space */
   new_bit_size = __GST_BITS_WRITER_ALIGNED (new_bit_size);
   g_assert (new_bit_size
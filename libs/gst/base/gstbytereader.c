@@ -29,6 +29,14 @@
 #include "gst/glib-compat-private.h"
 #include <string.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#define SCAN_SSE2 1
+#elif defined (__ARM_NEON) && defined (__aarch64__)
+#include <arm_neon.h>
+#define SCAN_NEON 1
+#endif
+
 /**
  * SECTION:gstbytereader
  * @title: GstByteReader
@@ -862,12 +870,65 @@ gst_byte_reader_dup_data (GstByteReader * reader, guint size, guint8 ** val)
   return _gst_byte_reader_dup_data_inline (reader, size, val);
 }
 
-/* Special optimized scan for mask 0xffffff00 and pattern 0x00000100 */
+/* Finds the first 0x00 0x00 0x01 prefix that lies completely inside the
+ * @size bytes at @data. Both SSE2 and NEON are part of the baseline
+ * instruction set of the architectures they are used on, so the vector
+ * paths are selected at compile time and need no runtime CPU detection.
+ * They compare 16 candidate positions at once and the remaining bytes are
+ * handled by the scalar skipping loop. */
 static inline gint
 _scan_for_start_code (const guint8 * data, guint size)
 {
   guint8 *pdata = (guint8 *) data;
-  guint8 *pend = (guint8 *) (data + size - 4);
+  guint8 *pend;
+  guint i = 0;
+
+  if (G_UNLIKELY (size < 3))
+    return -1;
+
+#if defined (SCAN_SSE2)
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    const __m128i one = _mm_set1_epi8 (1);
+
+    for (; i + 18 <= size; i += 16) {
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+      __m128i b2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+      gint mask;
+
+      mask = _mm_movemask_epi8 (_mm_and_si128 (_mm_and_si128 (_mm_cmpeq_epi8
+                  (b0, zero), _mm_cmpeq_epi8 (b1, zero)), _mm_cmpeq_epi8 (b2,
+                  one)));
+      if (G_UNLIKELY (mask != 0))
+        return i + g_bit_nth_lsf (mask, -1);
+    }
+  }
+#elif defined (SCAN_NEON)
+  {
+    const uint8x16_t zero = vdupq_n_u8 (0);
+    const uint8x16_t one = vdupq_n_u8 (1);
+
+    for (; i + 18 <= size; i += 16) {
+      uint8x16_t match;
+
+      match = vandq_u8 (vandq_u8 (vceqq_u8 (vld1q_u8 (data + i), zero),
+              vceqq_u8 (vld1q_u8 (data + i + 1), zero)),
+          vceqq_u8 (vld1q_u8 (data + i + 2), one));
+      if (G_UNLIKELY (vmaxvq_u8 (match) != 0)) {
+        guint j;
+
+        for (j = i;; j++) {
+          if (data[j] == 0 && data[j + 1] == 0 && data[j + 2] == 1)
+            return j;
+        }
+      }
+    }
+  }
+#endif
+
+  pdata += i;
+  pend = (guint8 *) (data + size - 3);
 
   while (pdata <= pend) {
     if (pdata[2] > 1) {
@@ -903,9 +964,10 @@ _masked_scan_uint32_peek (const GstByteReader * reader,
 
   data = reader->data + reader->byte + offset;
 
-  /* Handle special case found in MPEG and H264 */
+  /* Handle special case found in MPEG and H264. The byte following the
+   * start code is part of the pattern, so it must be inside the scan range */
   if ((pattern == 0x00000100) && (mask == 0xffffff00)) {
-    gint ret = _scan_for_start_code (data, size);
+    gint ret = _scan_for_start_code (data, size - 1);
 
     if (ret == -1)
       return ret;
@@ -1020,6 +1082,46 @@ gst_byte_reader_masked_scan_uint32_peek (const GstByteReader * reader,
   return _masked_scan_uint32_peek (reader, mask, pattern, offset, size, value);
 }
 
+/**
+ * gst_byte_reader_find_start_code:
+ * @reader: a #GstByteReader
+ * @offset: offset from which to start scanning, relative to the current
+ *     position
+ * @size: number of bytes to scan from offset
+ *
+ * Scans for the first 0x00 0x00 0x01 start code prefix as used by MPEG,
+ * H.264 and H.265 bitstreams in the byte reader data, starting from offset
+ * @offset relative to the current position. All three bytes of the prefix
+ * must be inside the scanned range for it to match.
+ *
+ * Unlike gst_byte_reader_masked_scan_uint32() this does not require the
+ * byte following the prefix to be available, which makes it suitable for
+ * finding the end of the last unit in a buffer.
+ *
+ * It is an error to call this function without making sure that there is
+ * enough data (offset+size bytes) in the byte reader.
+ *
+ * Returns: offset of the first start code prefix, or -1 if none was found.
+ *
+ * Since: 1.20
+ */
+guint
+gst_byte_reader_find_start_code (const GstByteReader * reader, guint offset,
+    guint size)
+{
+  gint ret;
+
+  g_return_val_if_fail (size > 0, -1);
+  g_return_val_if_fail ((guint64) offset + size <= reader->size - reader->byte,
+      -1);
+
+  ret = _scan_for_start_code (reader->data + reader->byte + offset, size);
+  if (ret == -1)
+    return ret;
+
+  return ret + offset;
+}
+
 #define GST_BYTE_READER_SCAN_STRING(bits) \
 static guint \
 gst_byte_reader_scan_string_utf##bits (const GstByteReader * reader) \
@@ -271,6 +271,11 @@ guint           gst_byte_reader_masked_scan_uint32_peek (const GstByteReader * r
                                                          guint size,
                                                          guint32 * value);
 
+GST_BASE_API
+guint           gst_byte_reader_find_start_code (const GstByteReader * reader,
+                                                 guint                 offset,
+                                                 guint                 size);
+
 /**
  * GST_BYTE_READER_INIT:
  * @data: Data from which the #GstByteReader should read
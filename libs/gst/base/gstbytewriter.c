@@ -64,8 +64,105 @@
  * 32 and 64 bits and functions for reading little/big endian floating points numbers of
  * 32 and 64 bits. It also provides functions to write/read NUL-terminated strings
  * in various character encodings.
+ *
+ * A writer created with gst_byte_writer_new_chunked() or initialized with
+ * gst_byte_writer_init_chunked() never reallocates. When the current chunk
+ * is full it is kept as a #GstMemory and writing continues in a new chunk,
+ * and gst_byte_writer_reset_and_get_buffer() returns all chunks as the
+ * memory of one #GstBuffer without copying. The position and size of such a
+ * writer refer to the current chunk, data in completed chunks can't be
+ * revisited with gst_byte_writer_set_pos().
  */
 
+/* leaves room for the sysmem header and alignment, so the chunks of the
+ * default allocator fit the largest size of its per-thread block cache */
+#define DEFAULT_CHUNK_SIZE (4096 - 256)
+
+typedef struct
+{
+  GstAllocator *allocator;
+  GstAllocationParams params;
+  guint chunk_size;
+
+  /* completed chunks */
+  GstBuffer *buffer;
+
+  /* the chunk being written, mapped writable */
+  GstMemory *mem;
+  GstMapInfo map;
+} GstByteWriterChunks;
+
+static void
+gst_byte_writer_chunks_finish (GstByteWriter * writer)
+{
+  GstByteWriterChunks *chunks = writer->chunks;
+
+  if (chunks->mem == NULL)
+    return;
+
+  gst_memory_unmap (chunks->mem, &chunks->map);
+  if (writer->parent.size > 0) {
+    gst_memory_resize (chunks->mem, 0, writer->parent.size);
+    gst_buffer_append_memory (chunks->buffer, chunks->mem);
+  } else {
+    gst_memory_unref (chunks->mem);
+  }
+  chunks->mem = NULL;
+
+  writer->parent.data = NULL;
+  writer->parent.byte = 0;
+  writer->parent.size = 0;
+  writer->alloc_size = 0;
+}
+
+static void
+gst_byte_writer_chunks_free (GstByteWriter * writer)
+{
+  GstByteWriterChunks *chunks = writer->chunks;
+
+  if (chunks->mem) {
+    gst_memory_unmap (chunks->mem, &chunks->map);
+    gst_memory_unref (chunks->mem);
+  }
+  gst_buffer_unref (chunks->buffer);
+  if (chunks->allocator)
+    gst_object_unref (chunks->allocator);
+  g_slice_free (GstByteWriterChunks, chunks);
+  writer->chunks = NULL;
+}
+
+/* completes the current chunk at the cursor and continues in a new one that
+ * has room for at least @size bytes. Anything written after the cursor is
+ * shorter than @size and would be overwritten by the next write anyway. */
+gboolean
+_gst_byte_writer_next_chunk (GstByteWriter * writer, guint size)
+{
+  GstByteWriterChunks *chunks = writer->chunks;
+  GstMemory *mem;
+  GstMapInfo map;
+
+  g_return_val_if_fail (chunks != NULL, FALSE);
+
+  mem = gst_allocator_alloc (chunks->allocator,
+      MAX (chunks->chunk_size, size), &chunks->params);
+  if (G_UNLIKELY (mem == NULL))
+    return FALSE;
+  if (G_UNLIKELY (!gst_memory_map (mem, &map, GST_MAP_WRITE))) {
+    gst_memory_unref (mem);
+    return FALSE;
+  }
+
+  writer->parent.size = writer->parent.byte;
+  gst_byte_writer_chunks_finish (writer);
+
+  chunks->mem = mem;
+  chunks->map = map;
+  writer->parent.data = map.data;
+  writer->alloc_size = map.size;
+
+  return TRUE;
+}
+
 /**
  * gst_byte_writer_new: (skip)
  *
@@ -137,6 +234,35 @@ gst_byte_writer_new_with_data (guint8 * data, guint size, gboolean initialized)
   return ret;
 }
 
+/**
+ * gst_byte_writer_new_chunked: (skip)
+ * @allocator: (transfer none) (allow-none): the #GstAllocator for the chunks,
+ *     or %NULL to use the default allocator
+ * @params: (transfer none) (allow-none): the #GstAllocationParams for the
+ *     chunks, or %NULL
+ * @chunk_size: the size of a chunk, or 0 to use a default size
+ *
+ * Creates a new, empty #GstByteWriter instance that writes to chunks of
+ * @chunk_size bytes allocated from @allocator. See
+ * gst_byte_writer_init_chunked().
+ *
+ * Free-function: gst_byte_writer_free
+ *
+ * Returns: (transfer full): a new, empty #GstByteWriter instance
+ *
+ * Since: 1.20
+ */
+GstByteWriter *
+gst_byte_writer_new_chunked (GstAllocator * allocator,
+    const GstAllocationParams * params, guint chunk_size)
+{
+  GstByteWriter *ret = g_slice_new (GstByteWriter);
+
+  gst_byte_writer_init_chunked (ret, allocator, params, chunk_size);
+
+  return ret;
+}
+
 /**
  * gst_byte_writer_init:
  * @writer: #GstByteWriter instance
@@ -201,6 +327,50 @@ gst_byte_writer_init_with_data (GstByteWriter * writer, guint8 * data,
   writer->owned = FALSE;
 }
 
+/**
+ * gst_byte_writer_init_chunked:
+ * @writer: #GstByteWriter instance
+ * @allocator: (transfer none) (allow-none): the #GstAllocator for the chunks,
+ *     or %NULL to use the default allocator
+ * @params: (transfer none) (allow-none): the #GstAllocationParams for the
+ *     chunks, or %NULL
+ * @chunk_size: the size of a chunk, or 0 to use a default size
+ *
+ * Initializes @writer to an empty instance that grows by allocating new
+ * chunks of at least @chunk_size bytes from @allocator instead of
+ * reallocating and copying its data. The default chunk size fits the block
+ * cache of the default allocator.
+ *
+ * The chunks become the memory of the buffer returned by
+ * gst_byte_writer_reset_and_get_buffer(). gst_byte_writer_get_pos(),
+ * gst_byte_writer_set_pos() and gst_byte_writer_get_size() refer to the
+ * current chunk only.
+ *
+ * Since: 1.20
+ */
+void
+gst_byte_writer_init_chunked (GstByteWriter * writer, GstAllocator * allocator,
+    const GstAllocationParams * params, guint chunk_size)
+{
+  GstByteWriterChunks *chunks;
+
+  g_return_if_fail (writer != NULL);
+
+  gst_byte_writer_init (writer);
+
+  chunks = g_slice_new0 (GstByteWriterChunks);
+  if (allocator)
+    chunks->allocator = gst_object_ref (allocator);
+  if (params)
+    chunks->params = *params;
+  else
+    gst_allocation_params_init (&chunks->params);
+  chunks->chunk_size = chunk_size ? chunk_size : DEFAULT_CHUNK_SIZE;
+  chunks->buffer = gst_buffer_new ();
+
+  writer->chunks = chunks;
+}
+
 /**
  * gst_byte_writer_reset:
  * @writer: #GstByteWriter instance
@@ -213,7 +383,9 @@ gst_byte_writer_reset (GstByteWriter * writer)
 {
   g_return_if_fail (writer != NULL);
 
-  if (writer->owned)
+  if (writer->chunks)
+    gst_byte_writer_chunks_free (writer);
+  else if (writer->owned)
     g_free ((guint8 *) writer->parent.data);
   memset (writer, 0, sizeof (GstByteWriter));
 }
@@ -236,6 +408,17 @@ gst_byte_writer_reset_and_get_data (GstByteWriter * writer)
 
   g_return_val_if_fail (writer != NULL, NULL);
 
+  if (writer->chunks) {
+    GstByteWriterChunks *chunks = writer->chunks;
+    gsize size;
+
+    gst_byte_writer_chunks_finish (writer);
+    gst_buffer_extract_dup (chunks->buffer, 0, -1, (gpointer *) & data, &size);
+    gst_byte_writer_reset (writer);
+
+    return data;
+  }
+
   data = (guint8 *) writer->parent.data;
   if (!writer->owned)
     data = g_memdup2 (data, writer->parent.size);
@@ -265,6 +448,16 @@ gst_byte_writer_reset_and_get_buffer (GstByteWriter * writer)
 
   g_return_val_if_fail (writer != NULL, NULL);
 
+  if (writer->chunks) {
+    GstByteWriterChunks *chunks = writer->chunks;
+
+    gst_byte_writer_chunks_finish (writer);
+    buffer = gst_buffer_ref (chunks->buffer);
+    gst_byte_writer_reset (writer);
+
+    return buffer;
+  }
+
   size = writer->parent.size;
   data = gst_byte_writer_reset_and_get_data (writer);
 
@@ -48,7 +48,8 @@ typedef struct {
   gboolean owned;
 
   /* < private > */
-  gpointer _gst_reserved[GST_PADDING];
+  gpointer chunks;
+  gpointer _gst_reserved[GST_PADDING - 1];
 } GstByteWriter;
 
 GST_BASE_API
@@ -60,6 +61,11 @@ GstByteWriter * gst_byte_writer_new_with_size   (guint size, gboolean fixed) G_G
 GST_BASE_API
 GstByteWriter * gst_byte_writer_new_with_data   (guint8 *data, guint size, gboolean initialized) G_GNUC_MALLOC;
 
+GST_BASE_API
+GstByteWriter * gst_byte_writer_new_chunked     (GstAllocator *allocator,
+                                                 const GstAllocationParams *params,
+                                                 guint chunk_size) G_GNUC_MALLOC;
+
 GST_BASE_API
 void            gst_byte_writer_init            (GstByteWriter *writer);
 
@@ -69,6 +75,13 @@ void            gst_byte_writer_init_with_size  (GstByteWriter *writer, guint si
 GST_BASE_API
 void            gst_byte_writer_init_with_data  (GstByteWriter *writer, guint8 *data,
                                                  guint size, gboolean initialized);
+
+GST_BASE_API
+void            gst_byte_writer_init_chunked    (GstByteWriter *writer,
+                                                 GstAllocator *allocator,
+                                                 const GstAllocationParams *params,
+                                                 guint chunk_size);
+
 GST_BASE_API
 void            gst_byte_writer_free                    (GstByteWriter *writer);
 
@@ -242,6 +255,10 @@ _gst_byte_writer_next_pow2 (guint n)
   return ret ? ret : n;
 }
 
+/* private, used by the inline functions of chunked writers */
+GST_BASE_API
+gboolean        _gst_byte_writer_next_chunk       (GstByteWriter *writer, guint size);
+
 static inline gboolean
 _gst_byte_writer_ensure_free_space_inline (GstByteWriter * writer, guint size)
 {
@@ -251,6 +268,8 @@ _gst_byte_writer_ensure_free_space_inline (GstByteWriter * writer, guint size)
     return TRUE;
   if (G_UNLIKELY (writer->fixed || !writer->owned))
     return FALSE;
+  if (writer->chunks != NULL)
+    return _gst_byte_writer_next_chunk (writer, size);
   if (G_UNLIKELY (writer->parent.byte > G_MAXUINT - size))
     return FALSE;
 
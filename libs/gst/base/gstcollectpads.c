@@ -959,6 +959,26 @@ gst_collect_pads_peek (GstCollectPads * pads, GstCollectData * data)
   return result;
 }
 
+/* pop without waking up the blocked pads, the caller broadcasts */
+static GstBuffer *
+gst_collect_pads_pop_unlocked (GstCollectPads * pads, GstCollectData * data)
+{
+  GstBuffer *result;
+
+  if ((result = data->buffer)) {
+    data->buffer = NULL;
+    data->pos = 0;
+    /* one less pad with queued data now */
+    if (GST_COLLECT_PADS_STATE_IS_SET (data, GST_COLLECT_PADS_STATE_WAITING))
+      pads->priv->queuedpads--;
+  }
+
+  GST_DEBUG_OBJECT (pads, "Pop buffer on pad %s:%s: buffer=%" GST_PTR_FORMAT,
+      GST_DEBUG_PAD_NAME (data->pad), result);
+
+  return result;
+}
+
 /**
  * gst_collect_pads_pop:
  * @pads: the collectpads to pop
@@ -982,22 +1002,65 @@ gst_collect_pads_pop (GstCollectPads * pads, GstCollectData * data)
   g_return_val_if_fail (GST_IS_COLLECT_PADS (pads), NULL);
   g_return_val_if_fail (data != NULL, NULL);
 
-  if ((result = data->buffer)) {
-    data->buffer = NULL;
-    data->pos = 0;
-    /* one less pad with queued data now */
-    if (GST_COLLECT_PADS_STATE_IS_SET (data, GST_COLLECT_PADS_STATE_WAITING))
-      pads->priv->queuedpads--;
-  }
+  result = gst_collect_pads_pop_unlocked (pads, data);
 
   GST_COLLECT_PADS_EVT_BROADCAST (pads);
 
-  GST_DEBUG_OBJECT (pads, "Pop buffer on pad %s:%s: buffer=%" GST_PTR_FORMAT,
-      GST_DEBUG_PAD_NAME (data->pad), result);
-
   return result;
 }
 
+/**
+ * gst_collect_pads_pop_all:
+ * @pads: the collectpads to pop
+ * @buffers: (out caller-allocates) (array length=n_buffers) (transfer full):
+ *     location for the popped buffers
+ * @n_buffers: the number of entries in @buffers
+ *
+ * Pop the buffers currently queued on the first @n_buffers pads of @pads,
+ * in the order of #GstCollectPads.data. The buffer of the i-th pad is stored
+ * in @buffers[i], or %NULL if that pad has no buffer queued.
+ *
+ * Unlike calling gst_collect_pads_pop() for every pad, the blocked pads are
+ * woken up only once, after all buffers were taken. This function should be
+ * called with the @pads STREAM_LOCK held, such as in the callback handler.
+ *
+ * MT safe.
+ *
+ * Returns: the number of buffers that were popped. You should unref the
+ * buffers after usage.
+ *
+ * Since: 1.20
+ */
+guint
+gst_collect_pads_pop_all (GstCollectPads * pads, GstBuffer ** buffers,
+    guint n_buffers)
+{
+  GSList *collected;
+  guint i, n_popped = 0;
+
+  g_return_val_if_fail (pads != NULL, 0);
+  g_return_val_if_fail (GST_IS_COLLECT_PADS (pads), 0);
+  g_return_val_if_fail (buffers != NULL || n_buffers == 0, 0);
+
+  collected = pads->data;
+  for (i = 0; i < n_buffers; i++) {
+    if (collected) {
+      buffers[i] = gst_collect_pads_pop_unlocked (pads,
+          (GstCollectData *) collected->data);
+      if (buffers[i])
+        n_popped++;
+      collected = g_slist_next (collected);
+    } else {
+      buffers[i] = NULL;
+    }
+  }
+
+  if (n_popped > 0)
+    GST_COLLECT_PADS_EVT_BROADCAST (pads);
+
+  return n_popped;
+}
+
 /* pop and unref the currently queued buffer, should be called with STREAM_LOCK
  * held */
 static void
@@ -1461,11 +1524,12 @@ gst_collect_pads_find_best_pad (GstCollectPads * pads,
     GstCollectData *data = (GstCollectData *) collected->data;
     GstClockTime timestamp;
 
-    buffer = gst_collect_pads_peek (pads, data);
+    /* no need to peek, we hold the STREAM_LOCK and only look at the
+     * timestamp */
+    buffer = data->buffer;
     /* if we have a buffer check if it is better then the current best one */
     if (buffer != NULL) {
       timestamp = GST_BUFFER_DTS_OR_PTS (buffer);
-      gst_buffer_unref (buffer);
       if (best == NULL || pads->priv->compare_func (pads, data, timestamp,
               best, best_time, pads->priv->compare_user_data) < 0) {
         best = data;
@@ -407,6 +407,10 @@ GstBuffer*      gst_collect_pads_peek          (GstCollectPads *pads, GstCollect
 GST_BASE_API
 GstBuffer*      gst_collect_pads_pop           (GstCollectPads *pads, GstCollectData *data);
 
+GST_BASE_API
+guint           gst_collect_pads_pop_all       (GstCollectPads *pads, GstBuffer **buffers,
+                                                guint n_buffers);
+
 /* get collected bytes */
 
 GST_BASE_API
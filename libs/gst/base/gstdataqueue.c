@@ -27,6 +27,11 @@
  * #GstDataQueue is an object that handles threadsafe queueing of objects. It
  * also provides size-related functionality. This object should be used for
  * any #GstElement that wishes to provide some sort of queueing functionality.
+ *
+ * A #GstDataQueue created with gst_data_queue_new_bounded() keeps at most a
+ * fixed number of items in a lock-free ring buffer. Pushing and popping
+ * items then doesn't take any lock unless a thread has to wait because the
+ * queue is full or empty.
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -60,6 +65,15 @@ enum
       /* FILL ME */
 };
 
+/* a slot of the bounded ring buffer, @seq tells whether the slot is free for
+ * the producer at position @seq or holds the item for the consumer at
+ * position @seq - 1 */
+typedef struct
+{
+  gint seq;                     /* ATOMIC */
+  GstDataQueueItem *item;
+} GstDataQueueSlot;
+
 struct _GstDataQueuePrivate
 {
   /* the array of data we're keeping our grubby hands on */
@@ -78,8 +92,65 @@ struct _GstDataQueuePrivate
                                  * of external flushing */
   GstDataQueueFullCallback fullcallback;
   GstDataQueueEmptyCallback emptycallback;
+
+  /* bounded mode, NULL otherwise */
+  GstDataQueueSlot *slots;
+  guint mask;
+  gint enqueue_pos;             /* ATOMIC */
+  gint dequeue_pos;             /* ATOMIC */
+  gint n_waiting_add;           /* ATOMIC */
+  gint n_waiting_del;           /* ATOMIC */
 };
 
+/* the time level is updated without the lock in bounded mode */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+static inline void
+gst_data_queue_time_add (guint64 * time, gint64 delta)
+{
+  __sync_fetch_and_add (time, delta);
+}
+
+static inline guint64
+gst_data_queue_time_get (guint64 * time)
+{
+  return __sync_fetch_and_add (time, 0);
+}
+#elif defined (G_PLATFORM_WIN32)
+#include <windows.h>
+static inline void
+gst_data_queue_time_add (guint64 * time, gint64 delta)
+{
+  InterlockedExchangeAdd64 ((LONGLONG volatile *) time, delta);
+}
+
+static inline guint64
+gst_data_queue_time_get (guint64 * time)
+{
+  return InterlockedExchangeAdd64 ((LONGLONG volatile *) time, 0);
+}
+#else
+G_LOCK_DEFINE_STATIC (time_level);
+static inline void
+gst_data_queue_time_add (guint64 * time, gint64 delta)
+{
+  G_LOCK (time_level);
+  *time += delta;
+  G_UNLOCK (time_level);
+}
+
+static inline guint64
+gst_data_queue_time_get (guint64 * time)
+{
+  guint64 res;
+
+  G_LOCK (time_level);
+  res = *time;
+  G_UNLOCK (time_level);
+
+  return res;
+}
+#endif
+
 #define GST_DATA_QUEUE_MUTEX_LOCK(q) G_STMT_START {                     \
     GST_CAT_TRACE (data_queue_dataflow,                                 \
       "locking qlock from thread %p",                                   \
@@ -245,11 +316,353 @@ gst_data_queue_new (GstDataQueueCheckFullFunction checkfull,
   return ret;
 }
 
+/**
+ * gst_data_queue_new_bounded: (skip)
+ * @checkfull: the callback used to tell if the element considers the queue full
+ * or not.
+ * @fullcallback: the callback which will be called when the queue is considered full.
+ * @emptycallback: the callback which will be called when the queue is considered empty.
+ * @checkdata: a #gpointer that will be passed to the @checkfull, @fullcallback,
+ *   and @emptycallback callbacks.
+ * @max_items: the maximum number of items in the queue
+ *
+ * Creates a new #GstDataQueue like gst_data_queue_new(), which stores its
+ * items in a lock-free ring buffer of @max_items, rounded up to a power of
+ * two. Any number of threads can push and pop items without taking a lock,
+ * only threads that have to wait for an item or for space in the queue do.
+ *
+ * The queue is full as soon as @checkfull returns %TRUE or the ring buffer
+ * is full. The levels passed to @checkfull are exact when there is a single
+ * pushing thread and may include items that are just being pushed
+ * otherwise. gst_data_queue_push_force() ignores @checkfull but waits for
+ * space in the ring buffer. gst_data_queue_peek() must only be used when
+ * there is a single popping thread, and gst_data_queue_drop_head() can only
+ * drop the item at the head of the queue.
+ *
+ * Returns: a new #GstDataQueue.
+ *
+ * Since: 1.20
+ */
+GstDataQueue *
+gst_data_queue_new_bounded (GstDataQueueCheckFullFunction checkfull,
+    GstDataQueueFullCallback fullcallback,
+    GstDataQueueEmptyCallback emptycallback, gpointer checkdata,
+    guint max_items)
+{
+  GstDataQueue *ret;
+  GstDataQueuePrivate *priv;
+  guint i, n_slots;
+
+  g_return_val_if_fail (checkfull != NULL, NULL);
+  g_return_val_if_fail (max_items > 0 && max_items <= G_MAXINT / 2, NULL);
+
+  ret = gst_data_queue_new (checkfull, fullcallback, emptycallback, checkdata);
+  priv = ret->priv;
+
+  n_slots = 1;
+  while (n_slots < max_items)
+    n_slots <<= 1;
+
+  priv->slots = g_new (GstDataQueueSlot, n_slots);
+  for (i = 0; i < n_slots; i++) {
+    priv->slots[i].seq = i;
+    priv->slots[i].item = NULL;
+  }
+  priv->mask = n_slots - 1;
+
+  GST_DEBUG ("queue:%p bounded to %u items", ret, n_slots);
+
+  return ret;
+}
+
+/* the bounded ring buffer is a multi-producer multi-consumer queue as
+ * described by Dmitry Vyukov. Positions are claimed with a CAS and the
+ * sequence number of the slot is used to publish the item to the other
+ * side. */
+static gboolean
+gst_data_queue_ring_push (GstDataQueuePrivate * priv, GstDataQueueItem * item)
+{
+  GstDataQueueSlot *slot;
+  guint pos;
+
+  pos = g_atomic_int_get (&priv->enqueue_pos);
+  for (;;) {
+    gint diff;
+
+    slot = &priv->slots[pos & priv->mask];
+    diff = (gint) ((guint) g_atomic_int_get (&slot->seq) - pos);
+    if (diff == 0) {
+      if (g_atomic_int_compare_and_exchange (&priv->enqueue_pos, pos, pos + 1))
+        break;
+    } else if (diff < 0) {
+      /* the consumer didn't release this slot yet, full */
+      return FALSE;
+    }
+    pos = g_atomic_int_get (&priv->enqueue_pos);
+  }
+
+  slot->item = item;
+  g_atomic_int_set (&slot->seq, pos + 1);
+
+  return TRUE;
+}
+
+static GstDataQueueItem *
+gst_data_queue_ring_pop (GstDataQueuePrivate * priv)
+{
+  GstDataQueueSlot *slot;
+  GstDataQueueItem *item;
+  guint pos;
+
+  pos = g_atomic_int_get (&priv->dequeue_pos);
+  for (;;) {
+    gint diff;
+
+    slot = &priv->slots[pos & priv->mask];
+    diff = (gint) ((guint) g_atomic_int_get (&slot->seq) - (pos + 1));
+    if (diff == 0) {
+      if (g_atomic_int_compare_and_exchange (&priv->dequeue_pos, pos, pos + 1))
+        break;
+    } else if (diff < 0) {
+      /* nothing published in this slot yet, empty */
+      return NULL;
+    }
+    pos = g_atomic_int_get (&priv->dequeue_pos);
+  }
+
+  item = slot->item;
+  slot->item = NULL;
+  g_atomic_int_set (&slot->seq, pos + priv->mask + 1);
+
+  return item;
+}
+
+/* only safe with a single consumer */
+static GstDataQueueItem *
+gst_data_queue_ring_peek (GstDataQueuePrivate * priv)
+{
+  GstDataQueueSlot *slot;
+  guint pos;
+
+  pos = g_atomic_int_get (&priv->dequeue_pos);
+  slot = &priv->slots[pos & priv->mask];
+  if ((guint) g_atomic_int_get (&slot->seq) != pos + 1)
+    return NULL;
+
+  return slot->item;
+}
+
+static gboolean
+gst_data_queue_ring_is_full (GstDataQueuePrivate * priv)
+{
+  guint pos = g_atomic_int_get (&priv->enqueue_pos);
+  GstDataQueueSlot *slot = &priv->slots[pos & priv->mask];
+
+  return (gint) ((guint) g_atomic_int_get (&slot->seq) - pos) < 0;
+}
+
+static gboolean
+gst_data_queue_ring_is_empty (GstDataQueuePrivate * priv)
+{
+  guint pos = g_atomic_int_get (&priv->dequeue_pos);
+  GstDataQueueSlot *slot = &priv->slots[pos & priv->mask];
+
+  return (gint) ((guint) g_atomic_int_get (&slot->seq) - (pos + 1)) < 0;
+}
+
+static inline void
+gst_data_queue_bounded_add_level (GstDataQueuePrivate * priv,
+    GstDataQueueItem * item, gint sign)
+{
+  if (item->visible)
+    g_atomic_int_add ((gint *) & priv->cur_level.visible, sign);
+  g_atomic_int_add ((gint *) & priv->cur_level.bytes, sign * (gint) item->size);
+  gst_data_queue_time_add (&priv->cur_level.time,
+      sign * (gint64) item->duration);
+}
+
+static gboolean
+gst_data_queue_bounded_is_full (GstDataQueue * queue)
+{
+  GstDataQueuePrivate *priv = queue->priv;
+
+  return gst_data_queue_ring_is_full (priv) ||
+      priv->checkfull (queue,
+      (guint) g_atomic_int_get ((gint *) & priv->cur_level.visible),
+      (guint) g_atomic_int_get ((gint *) & priv->cur_level.bytes),
+      gst_data_queue_time_get (&priv->cur_level.time), priv->checkdata);
+}
+
+static gboolean
+gst_data_queue_bounded_has_slot (GstDataQueue * queue)
+{
+  return !gst_data_queue_ring_is_full (queue->priv);
+}
+
+static gboolean
+gst_data_queue_bounded_has_space (GstDataQueue * queue)
+{
+  return !gst_data_queue_bounded_is_full (queue);
+}
+
+static gboolean
+gst_data_queue_bounded_has_item (GstDataQueue * queue)
+{
+  return !gst_data_queue_ring_is_empty (queue->priv);
+}
+
+/* Waits until @ready returns %TRUE or the queue is flushing. The other side
+ * changes the ring buffer before checking for waiters, and waiters announce
+ * themselves before checking the ring buffer, so no wakeup is lost. */
+static gboolean
+gst_data_queue_bounded_wait (GstDataQueue * queue, gboolean (*ready)
+    (GstDataQueue * queue), gint * n_waiting, GCond * cond)
+{
+  GstDataQueuePrivate *priv = queue->priv;
+  gboolean res;
+
+  GST_DATA_QUEUE_MUTEX_LOCK (queue);
+  g_atomic_int_inc (n_waiting);
+  for (;;) {
+    if (g_atomic_int_get (&priv->flushing)) {
+      res = FALSE;
+      break;
+    }
+    if (ready (queue)) {
+      res = TRUE;
+      break;
+    }
+    g_cond_wait (cond, &priv->qlock);
+  }
+  g_atomic_int_add (n_waiting, -1);
+  GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
+
+  return res;
+}
+
+static inline void
+gst_data_queue_bounded_wake (GstDataQueue * queue, gint * n_waiting,
+    GCond * cond)
+{
+  if (g_atomic_int_get (n_waiting) > 0) {
+    GST_DATA_QUEUE_MUTEX_LOCK (queue);
+    g_cond_broadcast (cond);
+    GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
+  }
+}
+
+static gboolean
+gst_data_queue_bounded_push (GstDataQueue * queue, GstDataQueueItem * item,
+    gboolean force)
+{
+  GstDataQueuePrivate *priv = queue->priv;
+  gboolean notified = force;
+
+  for (;;) {
+    if (g_atomic_int_get (&priv->flushing))
+      goto flushing;
+
+    if (force || !gst_data_queue_bounded_is_full (queue)) {
+      /* account the item before publishing it so that the levels never
+       * underflow when it's popped right away */
+      gst_data_queue_bounded_add_level (priv, item, 1);
+      if (gst_data_queue_ring_push (priv, item))
+        break;
+      gst_data_queue_bounded_add_level (priv, item, -1);
+    }
+
+    if (!notified) {
+      if (G_LIKELY (priv->fullcallback))
+        priv->fullcallback (queue, priv->checkdata);
+      else
+        g_signal_emit (queue, gst_data_queue_signals[SIGNAL_FULL], 0);
+      notified = TRUE;
+      /* the callback might have removed some items */
+      continue;
+    }
+
+    if (!gst_data_queue_bounded_wait (queue, force ?
+            gst_data_queue_bounded_has_slot : gst_data_queue_bounded_has_space,
+            &priv->n_waiting_del, &priv->item_del))
+      goto flushing;
+  }
+
+  gst_data_queue_bounded_wake (queue, &priv->n_waiting_add, &priv->item_add);
+
+  return TRUE;
+
+  /* ERRORS */
+flushing:
+  {
+    GST_DEBUG ("queue:%p, we are flushing", queue);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_data_queue_bounded_pop (GstDataQueue * queue, GstDataQueueItem ** item,
+    gboolean peek)
+{
+  GstDataQueuePrivate *priv = queue->priv;
+  gboolean notified = FALSE;
+
+  for (;;) {
+    if (g_atomic_int_get (&priv->flushing))
+      goto flushing;
+
+    if (peek)
+      *item = gst_data_queue_ring_peek (priv);
+    else
+      *item = gst_data_queue_ring_pop (priv);
+    if (*item)
+      break;
+
+    if (!notified) {
+      if (G_LIKELY (priv->emptycallback))
+        priv->emptycallback (queue, priv->checkdata);
+      else
+        g_signal_emit (queue, gst_data_queue_signals[SIGNAL_EMPTY], 0);
+      notified = TRUE;
+      continue;
+    }
+
+    if (!gst_data_queue_bounded_wait (queue, gst_data_queue_bounded_has_item,
+            &priv->n_waiting_add, &priv->item_add))
+      goto flushing;
+  }
+
+  if (!peek) {
+    gst_data_queue_bounded_add_level (priv, *item, -1);
+    gst_data_queue_bounded_wake (queue, &priv->n_waiting_del, &priv->item_del);
+  }
+
+  return TRUE;
+
+  /* ERRORS */
+flushing:
+  {
+    GST_DEBUG ("queue:%p, we are flushing", queue);
+    return FALSE;
+  }
+}
+
 static void
 gst_data_queue_cleanup (GstDataQueue * queue)
 {
   GstDataQueuePrivate *priv = queue->priv;
 
+  if (priv->slots) {
+    GstDataQueueItem *item;
+
+    /* other threads might still be pushing, so only remove the levels of
+     * the items that were dropped */
+    while ((item = gst_data_queue_ring_pop (priv))) {
+      gst_data_queue_bounded_add_level (priv, item, -1);
+      item->destroy (item);
+    }
+    return;
+  }
+
   while (!gst_queue_array_is_empty (priv->queue)) {
     GstDataQueueItem *item = gst_queue_array_pop_head (priv->queue);
 
@@ -272,6 +685,7 @@ gst_data_queue_finalize (GObject * object)
 
   gst_data_queue_cleanup (queue);
   gst_queue_array_free (priv->queue);
+  g_free (priv->slots);
 
   GST_DEBUG ("free mutex");
   g_mutex_clear (&priv->qlock);
@@ -326,7 +740,16 @@ gst_data_queue_locked_is_full (GstDataQueue * queue)
 void
 gst_data_queue_flush (GstDataQueue * queue)
 {
+  GstDataQueuePrivate *priv = queue->priv;
+
   GST_DEBUG ("queue:%p", queue);
+
+  if (priv->slots) {
+    gst_data_queue_cleanup (queue);
+    gst_data_queue_bounded_wake (queue, &priv->n_waiting_del, &priv->item_del);
+    return;
+  }
+
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
   gst_data_queue_locked_flush (queue);
   GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
@@ -348,6 +771,9 @@ gst_data_queue_is_empty (GstDataQueue * queue)
 {
   gboolean res;
 
+  if (queue->priv->slots)
+    return gst_data_queue_ring_is_empty (queue->priv);
+
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
   res = gst_data_queue_locked_is_empty (queue);
   GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
@@ -372,6 +798,9 @@ gst_data_queue_is_full (GstDataQueue * queue)
 {
   gboolean res;
 
+  if (queue->priv->slots)
+    return gst_data_queue_bounded_is_full (queue);
+
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
   res = gst_data_queue_locked_is_full (queue);
   GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
@@ -402,13 +831,18 @@ gst_data_queue_set_flushing (GstDataQueue * queue, gboolean flushing)
   GST_DEBUG ("queue:%p , flushing:%d", queue, flushing);
 
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
-  priv->flushing = flushing;
+  g_atomic_int_set (&priv->flushing, flushing);
   if (flushing) {
     /* release push/pop functions */
-    if (priv->waiting_add)
-      g_cond_signal (&priv->item_add);
-    if (priv->waiting_del)
-      g_cond_signal (&priv->item_del);
+    if (priv->slots) {
+      g_cond_broadcast (&priv->item_add);
+      g_cond_broadcast (&priv->item_del);
+    } else {
+      if (priv->waiting_add)
+        g_cond_signal (&priv->item_add);
+      if (priv->waiting_del)
+        g_cond_signal (&priv->item_del);
+    }
   }
   GST_DATA_QUEUE_MUTEX_UNLOCK (queue);
 }
@@ -454,6 +888,9 @@ gst_data_queue_push_force (GstDataQueue * queue, GstDataQueueItem * item)
   g_return_val_if_fail (GST_IS_DATA_QUEUE (queue), FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
 
+  if (priv->slots)
+    return gst_data_queue_bounded_push (queue, item, TRUE);
+
   GST_DATA_QUEUE_MUTEX_LOCK_CHECK (queue, flushing);
 
   STATUS (queue, "before pushing");
@@ -502,6 +939,9 @@ gst_data_queue_push (GstDataQueue * queue, GstDataQueueItem * item)
   g_return_val_if_fail (GST_IS_DATA_QUEUE (queue), FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
 
+  if (priv->slots)
+    return gst_data_queue_bounded_push (queue, item, FALSE);
+
   GST_DATA_QUEUE_MUTEX_LOCK_CHECK (queue, flushing);
 
   STATUS (queue, "before pushing");
@@ -581,6 +1021,9 @@ gst_data_queue_pop (GstDataQueue * queue, GstDataQueueItem ** item)
   g_return_val_if_fail (GST_IS_DATA_QUEUE (queue), FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
 
+  if (priv->slots)
+    return gst_data_queue_bounded_pop (queue, item, FALSE);
+
   GST_DATA_QUEUE_MUTEX_LOCK_CHECK (queue, flushing);
 
   STATUS (queue, "before popping");
@@ -651,6 +1094,9 @@ gst_data_queue_peek (GstDataQueue * queue, GstDataQueueItem ** item)
   g_return_val_if_fail (GST_IS_DATA_QUEUE (queue), FALSE);
   g_return_val_if_fail (item != NULL, FALSE);
 
+  if (priv->slots)
+    return gst_data_queue_bounded_pop (queue, item, TRUE);
+
   GST_DATA_QUEUE_MUTEX_LOCK_CHECK (queue, flushing);
 
   STATUS (queue, "before peeking");
@@ -707,6 +1153,20 @@ gst_data_queue_drop_head (GstDataQueue * queue, GType type)
 
   GST_DEBUG ("queue:%p", queue);
 
+  if (priv->slots) {
+    /* items can't be removed from the middle of the ring buffer */
+    leak = gst_data_queue_ring_peek (priv);
+    if (leak == NULL || GST_MINI_OBJECT_TYPE (leak->object) != type)
+      return FALSE;
+
+    leak = gst_data_queue_ring_pop (priv);
+    gst_data_queue_bounded_add_level (priv, leak, -1);
+    leak->destroy (leak);
+    gst_data_queue_bounded_wake (queue, &priv->n_waiting_del, &priv->item_del);
+
+    return TRUE;
+  }
+
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
   idx = gst_queue_array_find (priv->queue, is_of_type, GSIZE_TO_POINTER (type));
 
@@ -749,7 +1209,9 @@ gst_data_queue_limits_changed (GstDataQueue * queue)
   g_return_if_fail (GST_IS_DATA_QUEUE (queue));
 
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
-  if (priv->waiting_del) {
+  if (priv->slots) {
+    g_cond_broadcast (&priv->item_del);
+  } else if (priv->waiting_del) {
     GST_DEBUG ("signal del");
     g_cond_signal (&priv->item_del);
   }
@@ -770,6 +1232,13 @@ gst_data_queue_get_level (GstDataQueue * queue, GstDataQueueSize * level)
 {
   GstDataQueuePrivate *priv = queue->priv;
 
+  if (priv->slots) {
+    level->visible = g_atomic_int_get ((gint *) & priv->cur_level.visible);
+    level->bytes = g_atomic_int_get ((gint *) & priv->cur_level.bytes);
+    level->time = gst_data_queue_time_get (&priv->cur_level.time);
+    return;
+  }
+
   memcpy (level, (&priv->cur_level), sizeof (GstDataQueueSize));
 }
 
@@ -789,19 +1258,20 @@ gst_data_queue_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
 {
   GstDataQueue *queue = GST_DATA_QUEUE (object);
-  GstDataQueuePrivate *priv = queue->priv;
+  GstDataQueueSize level;
 
   GST_DATA_QUEUE_MUTEX_LOCK (queue);
+  gst_data_queue_get_level (queue, &level);
 
   switch (prop_id) {
     case PROP_CUR_LEVEL_BYTES:
-      g_value_set_uint (value, priv->cur_level.bytes);
+      g_value_set_uint (value, level.bytes);
       break;
     case PROP_CUR_LEVEL_VISIBLE:
-      g_value_set_uint (value, priv->cur_level.visible);
+      g_value_set_uint (value, level.visible);
       break;
     case PROP_CUR_LEVEL_TIME:
-      g_value_set_uint64 (value, priv->cur_level.time);
+      g_value_set_uint64 (value, level.time);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
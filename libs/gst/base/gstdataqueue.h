@@ -145,6 +145,12 @@ GstDataQueue * gst_data_queue_new            (GstDataQueueCheckFullFunction chec
 					      GstDataQueueEmptyCallback emptycallback,
 					      gpointer checkdata) G_GNUC_MALLOC;
 GST_BASE_API
+GstDataQueue * gst_data_queue_new_bounded    (GstDataQueueCheckFullFunction checkfull,
+					      GstDataQueueFullCallback fullcallback,
+					      GstDataQueueEmptyCallback emptycallback,
+					      gpointer checkdata,
+					      guint max_items) G_GNUC_MALLOC;
+GST_BASE_API
 gboolean       gst_data_queue_push           (GstDataQueue * queue, GstDataQueueItem * item);
 
 GST_BASE_API
@@ -58,6 +58,13 @@
  * %GST_FLOW_ERROR or below, GST_FLOW_NOT_NEGOTIATED and GST_FLOW_FLUSHING are
  * returned immediately from the gst_flow_combiner_update_flow() function.
  *
+ * The combiner counts how many of its pads are in each of these states, so
+ * gst_flow_combiner_update_pad_flow() takes the same time no matter how many
+ * pads were added. It only knows about the flow returns it was given though:
+ * after changing the last flow return of pads behind its back, call
+ * gst_flow_combiner_update_flow() or gst_flow_combiner_reset(), which look at
+ * all pads again.
+ *
  * Since: 1.4
  */
 #ifdef HAVE_CONFIG_H
@@ -67,14 +74,32 @@
 #include <gst/gst.h>
 #include "gstflowcombiner.h"
 
+typedef struct
+{
+  GstPad *pad;
+  /* the flow return of the pad as counted in the combiner */
+  GstFlowReturn flow;
+} GstFlowCombinerPad;
+
 struct _GstFlowCombiner
 {
+  /* GstFlowCombinerPad, in the order the pads are checked in */
   GQueue pads;
+  /* GstPad -> GList link in pads */
+  GHashTable *links;
+
+  /* number of pads with an error, not-negotiated or flushing flow return */
+  guint n_fatal;
+  guint n_eos;
+  guint n_not_linked;
 
   GstFlowReturn last_ret;
   gint ref_count;
 };
 
+#define IS_FATAL_FLOW(fret) \
+    ((fret) <= GST_FLOW_NOT_NEGOTIATED || (fret) == GST_FLOW_FLUSHING)
+
 GST_DEBUG_CATEGORY_STATIC (flowcombiner_dbg);
 #define GST_CAT_DEFAULT flowcombiner_dbg
 
@@ -98,6 +123,8 @@ gst_flow_combiner_new (void)
   GstFlowCombiner *combiner = g_slice_new (GstFlowCombiner);
 
   g_queue_init (&combiner->pads);
+  combiner->links = g_hash_table_new (NULL, NULL);
+  combiner->n_fatal = combiner->n_eos = combiner->n_not_linked = 0;
   combiner->last_ret = GST_FLOW_OK;
   g_atomic_int_set (&combiner->ref_count, 1);
 
@@ -107,6 +134,48 @@ gst_flow_combiner_new (void)
   return combiner;
 }
 
+static void
+gst_flow_combiner_count_flow (GstFlowCombiner * combiner, GstFlowReturn fret,
+    gint delta)
+{
+  if (IS_FATAL_FLOW (fret))
+    combiner->n_fatal += delta;
+  else if (fret == GST_FLOW_EOS)
+    combiner->n_eos += delta;
+  else if (fret == GST_FLOW_NOT_LINKED)
+    combiner->n_not_linked += delta;
+}
+
+static void
+gst_flow_combiner_set_pad_flow (GstFlowCombiner * combiner,
+    GstFlowCombinerPad * cpad, GstFlowReturn fret)
+{
+  if (cpad->flow == fret)
+    return;
+
+  gst_flow_combiner_count_flow (combiner, cpad->flow, -1);
+  gst_flow_combiner_count_flow (combiner, fret, 1);
+  cpad->flow = fret;
+}
+
+static void
+gst_flow_combiner_pad_free (GstFlowCombinerPad * cpad)
+{
+  gst_object_unref (cpad->pad);
+  g_slice_free (GstFlowCombinerPad, cpad);
+}
+
+static void
+gst_flow_combiner_remove_all_pads (GstFlowCombiner * combiner)
+{
+  GstFlowCombinerPad *cpad;
+
+  while ((cpad = g_queue_pop_head (&combiner->pads)))
+    gst_flow_combiner_pad_free (cpad);
+  g_hash_table_remove_all (combiner->links);
+  combiner->n_fatal = combiner->n_eos = combiner->n_not_linked = 0;
+}
+
 /**
  * gst_flow_combiner_free:
  * @combiner: the #GstFlowCombiner to free
@@ -156,10 +225,8 @@ gst_flow_combiner_unref (GstFlowCombiner * combiner)
   g_return_if_fail (combiner->ref_count > 0);
 
   if (g_atomic_int_dec_and_test (&combiner->ref_count)) {
-    GstPad *pad;
-
-    while ((pad = g_queue_pop_head (&combiner->pads)))
-      gst_object_unref (pad);
+    gst_flow_combiner_remove_all_pads (combiner);
+    g_hash_table_unref (combiner->links);
 
     g_slice_free (GstFlowCombiner, combiner);
   }
@@ -176,14 +243,11 @@ gst_flow_combiner_unref (GstFlowCombiner * combiner)
 void
 gst_flow_combiner_clear (GstFlowCombiner * combiner)
 {
-  GstPad *pad;
-
   g_return_if_fail (combiner != NULL);
 
   GST_DEBUG ("%p clearing", combiner);
 
-  while ((pad = g_queue_pop_head (&combiner->pads)))
-    gst_object_unref (pad);
+  gst_flow_combiner_remove_all_pads (combiner);
   combiner->last_ret = GST_FLOW_OK;
 }
 
@@ -205,46 +269,65 @@ gst_flow_combiner_reset (GstFlowCombiner * combiner)
   GST_DEBUG ("%p reset flow returns", combiner);
 
   for (iter = combiner->pads.head; iter; iter = iter->next) {
-    GST_PAD_LAST_FLOW_RETURN (iter->data) = GST_FLOW_OK;
+    GstFlowCombinerPad *cpad = iter->data;
+
+    GST_PAD_LAST_FLOW_RETURN (cpad->pad) = GST_FLOW_OK;
+    cpad->flow = GST_FLOW_OK;
   }
 
+  combiner->n_fatal = combiner->n_eos = combiner->n_not_linked = 0;
   combiner->last_ret = GST_FLOW_OK;
 }
 
+/* re-reads the last flow return of all pads */
+static void
+gst_flow_combiner_sync_pads (GstFlowCombiner * combiner)
+{
+  GList *iter;
+
+  for (iter = combiner->pads.head; iter; iter = iter->next) {
+    GstFlowCombinerPad *cpad = iter->data;
+    GstFlowReturn fret = GST_PAD_LAST_FLOW_RETURN (cpad->pad);
+
+    GST_TRACE ("%p pad %" GST_PTR_FORMAT " has flow return of %s (%d)",
+        combiner, cpad->pad, gst_flow_get_name (fret), fret);
+
+    gst_flow_combiner_set_pad_flow (combiner, cpad, fret);
+  }
+}
+
 static GstFlowReturn
 gst_flow_combiner_get_flow (GstFlowCombiner * combiner)
 {
   GstFlowReturn cret = GST_FLOW_OK;
-  gboolean all_eos = TRUE;
-  gboolean all_notlinked = TRUE;
-  GList *iter;
+  guint n_pads = combiner->pads.length;
 
   GST_DEBUG ("%p Combining flow returns", combiner);
 
-  for (iter = combiner->pads.head; iter; iter = iter->next) {
-    GstFlowReturn fret = GST_PAD_LAST_FLOW_RETURN (iter->data);
+  /* pads may have been activated or flushed since they were counted, this
+   * doesn't happen in the steady state so it's fine to walk the pads here */
+  if (combiner->n_fatal > 0)
+    gst_flow_combiner_sync_pads (combiner);
 
-    GST_TRACE ("%p pad %" GST_PTR_FORMAT " has flow return of %s (%d)",
-        combiner, iter->data, gst_flow_get_name (fret), fret);
+  if (combiner->n_fatal > 0) {
+    GList *iter;
 
-    if (fret <= GST_FLOW_NOT_NEGOTIATED || fret == GST_FLOW_FLUSHING) {
-      GST_DEBUG ("%p Error flow return found, returning", combiner);
-      cret = fret;
-      goto done;
-    }
+    /* return the first error in the list */
+    for (iter = combiner->pads.head; iter; iter = iter->next) {
+      GstFlowCombinerPad *cpad = iter->data;
 
-    if (fret != GST_FLOW_NOT_LINKED) {
-      all_notlinked = FALSE;
-      if (fret != GST_FLOW_EOS)
-        all_eos = FALSE;
+      if (IS_FATAL_FLOW (cpad->flow)) {
+        GST_DEBUG ("%p Error flow return found, returning", combiner);
+        cret = cpad->flow;
+        break;
+      }
     }
-  }
-  if (all_notlinked)
+  } else if (combiner->n_not_linked == n_pads) {
     cret = GST_FLOW_NOT_LINKED;
-  else if (all_eos)
+  } else if (combiner->n_not_linked + combiner->n_eos == n_pads) {
     cret = GST_FLOW_EOS;
+  }
 
-done:
   GST_DEBUG ("%p Combined flow return: %s (%d)", combiner,
       gst_flow_get_name (cret), cret);
   return cret;
@@ -279,10 +362,10 @@ gst_flow_combiner_update_flow (GstFlowCombiner * combiner, GstFlowReturn fret)
     return fret;
   }
 
-  if (fret <= GST_FLOW_NOT_NEGOTIATED || fret == GST_FLOW_FLUSHING
-      || !combiner->pads.head) {
+  if (IS_FATAL_FLOW (fret) || !combiner->pads.head) {
     ret = fret;
   } else {
+    gst_flow_combiner_sync_pads (combiner);
     ret = gst_flow_combiner_get_flow (combiner);
   }
   combiner->last_ret = ret;
@@ -303,6 +386,9 @@ gst_flow_combiner_update_flow (GstFlowCombiner * combiner, GstFlowReturn fret)
  * combinations and avoid looking over all pads again. e.g. The last combined
  * return is the same as the latest obtained #GstFlowReturn.
  *
+ * Unlike gst_flow_combiner_update_flow() this doesn't look at the other pads
+ * but uses the flow returns counted for them, so it takes constant time.
+ *
  * Returns: The combined #GstFlowReturn
  * Since: 1.6
  */
@@ -310,11 +396,31 @@ GstFlowReturn
 gst_flow_combiner_update_pad_flow (GstFlowCombiner * combiner, GstPad * pad,
     GstFlowReturn fret)
 {
+  GList *link;
+  GstFlowReturn ret;
+
+  g_return_val_if_fail (combiner != NULL, GST_FLOW_ERROR);
   g_return_val_if_fail (pad != NULL, GST_FLOW_ERROR);
 
   GST_PAD_LAST_FLOW_RETURN (pad) = fret;
 
-  return gst_flow_combiner_update_flow (combiner, fret);
+  if ((link = g_hash_table_lookup (combiner->links, pad)))
+    gst_flow_combiner_set_pad_flow (combiner, link->data, fret);
+
+  GST_DEBUG ("%p updating combiner with flow %s (%d) of pad %" GST_PTR_FORMAT,
+      combiner, gst_flow_get_name (fret), fret, pad);
+
+  if (combiner->last_ret == fret) {
+    return fret;
+  }
+
+  if (IS_FATAL_FLOW (fret) || !combiner->pads.head) {
+    ret = fret;
+  } else {
+    ret = gst_flow_combiner_get_flow (combiner);
+  }
+  combiner->last_ret = ret;
+  return ret;
 }
 
 /**
@@ -329,10 +435,24 @@ gst_flow_combiner_update_pad_flow (GstFlowCombiner * combiner, GstPad * pad,
 void
 gst_flow_combiner_add_pad (GstFlowCombiner * combiner, GstPad * pad)
 {
+  GstFlowCombinerPad *cpad;
+
   g_return_if_fail (combiner != NULL);
   g_return_if_fail (pad != NULL);
 
-  g_queue_push_head (&combiner->pads, gst_object_ref (pad));
+  if (g_hash_table_contains (combiner->links, pad)) {
+    GST_WARNING ("%p pad %" GST_PTR_FORMAT " was already added", combiner,
+        pad);
+    return;
+  }
+
+  cpad = g_slice_new (GstFlowCombinerPad);
+  cpad->pad = gst_object_ref (pad);
+  cpad->flow = GST_PAD_LAST_FLOW_RETURN (pad);
+  gst_flow_combiner_count_flow (combiner, cpad->flow, 1);
+
+  g_queue_push_head (&combiner->pads, cpad);
+  g_hash_table_insert (combiner->links, pad, combiner->pads.head);
 }
 
 /**
@@ -347,9 +467,17 @@ gst_flow_combiner_add_pad (GstFlowCombiner * combiner, GstPad * pad)
 void
 gst_flow_combiner_remove_pad (GstFlowCombiner * combiner, GstPad * pad)
 {
+  GList *link;
+
   g_return_if_fail (combiner != NULL);
   g_return_if_fail (pad != NULL);
 
-  if (g_queue_remove (&combiner->pads, pad))
-    gst_object_unref (pad);
+  if ((link = g_hash_table_lookup (combiner->links, pad))) {
+    GstFlowCombinerPad *cpad = link->data;
+
+    g_hash_table_remove (combiner->links, pad);
+    gst_flow_combiner_count_flow (combiner, cpad->flow, -1);
+    g_queue_delete_link (&combiner->pads, link);
+    gst_flow_combiner_pad_free (cpad);
+  }
 }
@@ -405,6 +405,23 @@ gst_mem_index_get_assoc_entry (GstIndex * index, gint id,
   return entry;
 }
 
+/* calls @func for every association entry of writer @id, in no particular
+ * order */
+static void
+gst_mem_index_foreach_association (GstIndex * index, gint id, GFunc func,
+    gpointer user_data)
+{
+  GstMemIndex *memindex = GST_MEM_INDEX (index);
+  GList *l;
+
+  for (l = memindex->associations; l; l = l->next) {
+    GstIndexEntry *entry = l->data;
+
+    if (entry->id == id)
+      func (entry, user_data);
+  }
+}
+
 #if 0
 gboolean
 gst_mem_index_plugin_init (GstPlugin * plugin)
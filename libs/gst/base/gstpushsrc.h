@@ -62,6 +62,9 @@ struct _GstPushSrc {
  *         size this buffer should be. The default implementation will create
  *         a new buffer from the negotiated allocator.
  * @fill: Ask the subclass to fill the buffer with data.
+ * @create_list: Ask the subclass to add at least one and at most
+ *   @max_buffers buffers to @list. Refer to #GstBaseSrcClass::create_list
+ *   for more details. (Since: 1.20)
  *
  * Subclasses can override any of the available virtual methods or not, as
  * needed. At the minimum, the @fill method should be overridden to produce
@@ -78,8 +81,12 @@ struct _GstPushSrcClass {
   /* ask the subclass to fill a buffer */
   GstFlowReturn (*fill)   (GstPushSrc *src, GstBuffer *buf);
 
+  /* ask the subclass to create several buffers at once */
+  GstFlowReturn (*create_list) (GstPushSrc *src, guint max_buffers,
+                                GstBufferList *list);
+
   /*< private >*/
-  gpointer _gst_reserved[GST_PADDING];
+  gpointer _gst_reserved[GST_PADDING - 1];
 };
 
 GST_BASE_API
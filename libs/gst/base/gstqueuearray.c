@@ -28,6 +28,12 @@
  * #GstQueueArray is an object that provides standard queue functionality
  * based on an array instead of linked lists. This reduces the overhead
  * caused by memory management by a large factor.
+ *
+ * The size of the underlying array is always a power of two, so positions
+ * wrap around with a mask. Several elements can be moved in and out at once
+ * with gst_queue_array_push_tail_n() and gst_queue_array_pop_head_n(), and
+ * the memory kept after a burst can be given back with
+ * gst_queue_array_shrink().
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -41,7 +47,9 @@ struct _GstQueueArray
 {
   /* < private > */
   guint8 *array;
+  /* always a power of two */
   guint size;
+  guint min_size;
   guint head;
   guint tail;
   guint length;
@@ -56,7 +64,8 @@ struct _GstQueueArray
  * @initial_size: Initial size of the new queue
  *
  * Allocates a new #GstQueueArray object for elements (e.g. structures)
- * of size @struct_size, with an initial queue size of @initial_size.
+ * of size @struct_size, with an initial queue size of @initial_size,
+ * rounded up to a power of two.
  *
  * Returns: a new #GstQueueArray object
  *
@@ -68,11 +77,15 @@ gst_queue_array_new_for_struct (gsize struct_size, guint initial_size)
   GstQueueArray *array;
 
   g_return_val_if_fail (struct_size > 0, NULL);
+  g_return_val_if_fail (initial_size <= G_MAXUINT / 2 + 1, NULL);
 
   array = g_slice_new (GstQueueArray);
   array->elt_size = struct_size;
-  array->size = initial_size;
-  array->array = g_malloc0 (struct_size * initial_size);
+  array->size = 1;
+  while (array->size < initial_size)
+    array->size <<= 1;
+  array->min_size = array->size;
+  array->array = g_malloc0 (struct_size * array->size);
   array->head = 0;
   array->tail = 0;
   array->length = 0;
@@ -86,7 +99,7 @@ gst_queue_array_new_for_struct (gsize struct_size, guint initial_size)
  * @initial_size: Initial size of the new queue
  *
  * Allocates a new #GstQueueArray object with an initial
- * queue size of @initial_size.
+ * queue size of @initial_size, rounded up to a power of two.
  *
  * Returns: a new #GstQueueArray object
  *
@@ -153,7 +166,7 @@ gst_queue_array_clear_idx (GstQueueArray * array, guint idx)
   if (!array->clear_func)
     return;
 
-  pos = (idx + array->head) % array->size;
+  pos = (idx + array->head) & (array->size - 1);
   if (array->struct_array)
     array->clear_func (array->array + pos * array->elt_size);
   else
@@ -210,7 +223,7 @@ gst_queue_array_pop_head_struct (GstQueueArray * array)
   p_struct = array->array + (array->elt_size * array->head);
 
   array->head++;
-  array->head %= array->size;
+  array->head &= array->size - 1;
   array->length--;
 
   return p_struct;
@@ -239,11 +252,47 @@ gst_queue_array_pop_head (GstQueueArray * array)
 
   ret = *(gpointer *) (array->array + (sizeof (gpointer) * array->head));
   array->head++;
-  array->head %= array->size;
+  array->head &= array->size - 1;
   array->length--;
   return ret;
 }
 
+/**
+ * gst_queue_array_pop_head_n: (skip)
+ * @array: a #GstQueueArray object
+ * @data: (out caller-allocates) (array length=n): location for the elements
+ * @n: the maximum number of elements to pop
+ *
+ * Removes up to @n elements from the head of the queue @array and stores
+ * them in order at @data. For a queue created with gst_queue_array_new()
+ * @data is an array of pointers, otherwise an array of structures of the
+ * struct size specified when creating the queue. The clear function is not
+ * called for the popped elements.
+ *
+ * Returns: the number of elements stored in @data
+ *
+ * Since: 1.20
+ */
+guint
+gst_queue_array_pop_head_n (GstQueueArray * array, gpointer data, guint n)
+{
+  guint elt_size, first;
+
+  g_return_val_if_fail (array != NULL, 0);
+  g_return_val_if_fail (data != NULL || n == 0, 0);
+
+  n = MIN (n, array->length);
+  elt_size = array->elt_size;
+  first = MIN (n, array->size - array->head);
+  memcpy (data, array->array + elt_size * array->head, first * elt_size);
+  memcpy ((guint8 *) data + elt_size * first, array->array,
+      (n - first) * elt_size);
+  array->head = (array->head + n) & (array->size - 1);
+  array->length -= n;
+
+  return n;
+}
+
 /**
  * gst_queue_array_peek_head_struct: (skip)
  * @array: a #GstQueueArray object
@@ -304,7 +353,7 @@ gst_queue_array_peek_nth (GstQueueArray * array, guint idx)
   g_return_val_if_fail (array != NULL, NULL);
   g_return_val_if_fail (idx < array->length, NULL);
 
-  idx = (array->head + idx) % array->size;
+  idx = (array->head + idx) & (array->size - 1);
 
   return *(gpointer *) (array->array + (sizeof (gpointer) * idx));
 }
@@ -324,50 +373,92 @@ gst_queue_array_peek_nth_struct (GstQueueArray * array, guint idx)
   g_return_val_if_fail (array != NULL, NULL);
   g_return_val_if_fail (idx < array->length, NULL);
 
-  idx = (array->head + idx) % array->size;
+  idx = (array->head + idx) & (array->size - 1);
 
   return array->array + (array->elt_size * idx);
 }
 
+/* called when the array is full, so head == tail */
 static void
 gst_queue_array_do_expand (GstQueueArray * array)
 {
   guint elt_size = array->elt_size;
-  /* newsize is 50% bigger */
   guint oldsize = array->size;
-  guint newsize = MAX ((3 * oldsize) / 2, oldsize + 1);
-
-  /* copy over data */
-  if (array->tail != 0) {
-    guint8 *array2 = g_malloc0 (elt_size * newsize);
-    guint t1 = array->head;
-    guint t2 = oldsize - array->head;
-
-    /* [0-----TAIL][HEAD------SIZE]
-     *
-     * We want to end up with
-     * [HEAD------------------TAIL][----FREEDATA------NEWSIZE]
-     *
-     * 1) move [HEAD-----SIZE] part to beginning of new array
-     * 2) move [0-------TAIL] part new array, after previous part
-     */
-
-    memcpy (array2, array->array + (elt_size * array->head), t2 * elt_size);
-    memcpy (array2 + t2 * elt_size, array->array, t1 * elt_size);
-
-    g_free (array->array);
-    array->array = array2;
-    array->head = 0;
+  guint newsize = oldsize * 2;
+  guint t1 = array->tail;
+  guint t2 = oldsize - array->head;
+
+  g_assert (newsize > oldsize);
+
+  array->array = g_realloc (array->array, elt_size * newsize);
+
+  /* [0-----TAIL][HEAD------SIZE][----FREEDATA------NEWSIZE]
+   *
+   * Only the smaller of the two parts needs to be moved to get a contiguous
+   * queue again:
+   * 1) [HEAD-----SIZE][0-----TAIL] with the wrapped part after SIZE
+   * 2) [0-----TAIL][----FREEDATA----][HEAD-----NEWSIZE]
+   */
+  if (t1 <= t2) {
+    memcpy (array->array + elt_size * oldsize, array->array, t1 * elt_size);
+    array->tail = oldsize + t1;
   } else {
-    /* Fast path, we just need to grow the array */
-    array->array = g_realloc (array->array, elt_size * newsize);
-    memset (array->array + elt_size * oldsize, 0,
-        elt_size * (newsize - oldsize));
+    memcpy (array->array + elt_size * (newsize - t2),
+        array->array + elt_size * array->head, t2 * elt_size);
+    array->head = newsize - t2;
   }
-  array->tail = oldsize;
+  array->tail &= newsize - 1;
+  array->size = newsize;
+}
+
+/* relayouts the elements at the start of an array of @newsize */
+static void
+gst_queue_array_resize (GstQueueArray * array, guint newsize)
+{
+  guint elt_size = array->elt_size;
+  guint8 *array2;
+  guint t2;
+
+  g_assert (newsize >= array->length);
+
+  array2 = g_malloc (elt_size * newsize);
+  t2 = MIN (array->length, array->size - array->head);
+  memcpy (array2, array->array + elt_size * array->head, t2 * elt_size);
+  memcpy (array2 + elt_size * t2, array->array,
+      (array->length - t2) * elt_size);
+
+  g_free (array->array);
+  array->array = array2;
+  array->head = 0;
+  array->tail = array->length & (newsize - 1);
   array->size = newsize;
 }
 
+/**
+ * gst_queue_array_shrink: (skip)
+ * @array: a #GstQueueArray object
+ *
+ * Releases the memory that @array kept after a burst of elements, by
+ * reducing its size to the smallest power of two that still holds all
+ * queued elements, but not below the initial size.
+ *
+ * Since: 1.20
+ */
+void
+gst_queue_array_shrink (GstQueueArray * array)
+{
+  guint newsize;
+
+  g_return_if_fail (array != NULL);
+
+  newsize = array->min_size;
+  while (newsize < array->length)
+    newsize <<= 1;
+
+  if (newsize < array->size)
+    gst_queue_array_resize (array, newsize);
+}
+
 /**
  * gst_queue_array_push_element_tail: (skip)
  * @array: a #GstQueueArray object
@@ -394,7 +485,7 @@ gst_queue_array_push_tail_struct (GstQueueArray * array, gpointer p_struct)
 
   memcpy (array->array + elt_size * array->tail, p_struct, elt_size);
   array->tail++;
-  array->tail %= array->size;
+  array->tail &= array->size - 1;
   array->length++;
 }
 
@@ -418,10 +509,52 @@ gst_queue_array_push_tail (GstQueueArray * array, gpointer data)
 
   *(gpointer *) (array->array + sizeof (gpointer) * array->tail) = data;
   array->tail++;
-  array->tail %= array->size;
+  array->tail &= array->size - 1;
   array->length++;
 }
 
+/**
+ * gst_queue_array_push_tail_n: (skip)
+ * @array: a #GstQueueArray object
+ * @data: (array length=n): the elements to push
+ * @n: the number of elements in @data
+ *
+ * Pushes the @n elements at @data to the tail of the queue @array, in order.
+ * For a queue created with gst_queue_array_new() @data is an array of
+ * pointers, otherwise an array of structures of the struct size specified
+ * when creating the queue.
+ *
+ * Since: 1.20
+ */
+void
+gst_queue_array_push_tail_n (GstQueueArray * array, gconstpointer data,
+    guint n)
+{
+  guint elt_size, first;
+
+  g_return_if_fail (array != NULL);
+  g_return_if_fail (data != NULL || n == 0);
+
+  /* Check if we need to make room */
+  if (G_UNLIKELY (array->size - array->length < n)) {
+    guint newsize = array->size;
+
+    g_return_if_fail (n <= G_MAXUINT / 2 + 1 - array->length);
+
+    while (newsize - array->length < n)
+      newsize <<= 1;
+    gst_queue_array_resize (array, newsize);
+  }
+
+  elt_size = array->elt_size;
+  first = MIN (n, array->size - array->tail);
+  memcpy (array->array + elt_size * array->tail, data, first * elt_size);
+  memcpy (array->array, (const guint8 *) data + elt_size * first,
+      (n - first) * elt_size);
+  array->tail = (array->tail + n) & (array->size - 1);
+  array->length += n;
+}
+
 /**
  * gst_queue_array_peek_tail: (skip)
  * @array: a #GstQueueArray object
@@ -445,7 +578,7 @@ gst_queue_array_peek_tail (GstQueueArray * array)
   if (len == 0)
     return NULL;
 
-  idx = (array->head + (len - 1)) % array->size;
+  idx = (array->head + (len - 1)) & (array->size - 1);
 
   return *(gpointer *) (array->array + (sizeof (gpointer) * idx));
 }
@@ -473,7 +606,7 @@ gst_queue_array_peek_tail_struct (GstQueueArray * array)
   if (len == 0)
     return NULL;
 
-  idx = (array->head + (len - 1)) % array->size;
+  idx = (array->head + (len - 1)) & (array->size - 1);
 
   return array->array + (array->elt_size * idx);
 }
@@ -503,7 +636,7 @@ gst_queue_array_pop_tail (GstQueueArray * array)
   if (len == 0)
     return NULL;
 
-  idx = (array->head + (len - 1)) % array->size;
+  idx = (array->head + (len - 1)) & (array->size - 1);
 
   ret = *(gpointer *) (array->array + (sizeof (gpointer) * idx));
 
@@ -538,7 +671,7 @@ gst_queue_array_pop_tail_struct (GstQueueArray * array)
   if (len == 0)
     return NULL;
 
-  idx = (array->head + (len - 1)) % array->size;
+  idx = (array->head + (len - 1)) & (array->size - 1);
 
   ret = array->array + (array->elt_size * idx);
 
@@ -589,7 +722,7 @@ gst_queue_array_drop_struct (GstQueueArray * array, guint idx,
   guint elt_size;
 
   g_return_val_if_fail (array != NULL, FALSE);
-  actual_idx = (array->head + idx) % array->size;
+  actual_idx = (array->head + idx) & (array->size - 1);
 
   g_return_val_if_fail (array->length > 0, FALSE);
   g_return_val_if_fail (actual_idx < array->size, FALSE);
@@ -599,7 +732,7 @@ gst_queue_array_drop_struct (GstQueueArray * array, guint idx,
   first_item_index = array->head;
 
   /* tail points to the first free spot */
-  last_item_index = (array->tail - 1 + array->size) % array->size;
+  last_item_index = (array->tail - 1) & (array->size - 1);
 
   if (p_struct != NULL)
     memcpy (p_struct, array->array + elt_size * actual_idx, elt_size);
@@ -612,7 +745,7 @@ gst_queue_array_drop_struct (GstQueueArray * array, guint idx,
 
     /* move the head plus one */
     array->head++;
-    array->head %= array->size;
+    array->head &= array->size - 1;
     array->length--;
     return TRUE;
   }
@@ -624,7 +757,7 @@ gst_queue_array_drop_struct (GstQueueArray * array, guint idx,
       gst_queue_array_clear_idx (array, idx);
 
     /* move tail minus one, potentially wrapping */
-    array->tail = (array->tail - 1 + array->size) % array->size;
+    array->tail = (array->tail - 1) & (array->size - 1);
     array->length--;
     return TRUE;
   }
@@ -641,7 +774,7 @@ gst_queue_array_drop_struct (GstQueueArray * array, guint idx,
         array->array + elt_size * (actual_idx + 1),
         (last_item_index - actual_idx) * elt_size);
     /* tail might wrap, ie if tail == 0 (and last_item_index == size) */
-    array->tail = (array->tail - 1 + array->size) % array->size;
+    array->tail = (array->tail - 1) & (array->size - 1);
     array->length--;
     return TRUE;
   }
@@ -739,13 +872,15 @@ gst_queue_array_find (GstQueueArray * array, GCompareFunc func, gpointer data)
   if (func != NULL) {
     /* Scan from head to tail */
     for (i = 0; i < array->length; i++) {
-      p_element = array->array + ((i + array->head) % array->size) * elt_size;
+      p_element =
+          array->array + ((i + array->head) & (array->size - 1)) * elt_size;
       if (func (*(gpointer *) p_element, data) == 0)
         return i;
     }
   } else {
     for (i = 0; i < array->length; i++) {
-      p_element = array->array + ((i + array->head) % array->size) * elt_size;
+      p_element =
+          array->array + ((i + array->head) & (array->size - 1)) * elt_size;
       if (*(gpointer *) p_element == data)
         return i;
     }
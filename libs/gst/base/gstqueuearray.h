@@ -64,6 +64,17 @@ gpointer        gst_queue_array_peek_tail (GstQueueArray * array);
 GST_BASE_API
 void            gst_queue_array_push_tail (GstQueueArray * array,
                                            gpointer        data);
+GST_BASE_API
+void            gst_queue_array_push_tail_n (GstQueueArray * array,
+                                             gconstpointer   data,
+                                             guint           n);
+GST_BASE_API
+guint           gst_queue_array_pop_head_n  (GstQueueArray * array,
+                                             gpointer        data,
+                                             guint           n);
+GST_BASE_API
+void            gst_queue_array_shrink    (GstQueueArray * array);
+
 GST_BASE_API
 gboolean        gst_queue_array_is_empty  (GstQueueArray * array);
 
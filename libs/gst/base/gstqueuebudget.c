@@ -0,0 +1,433 @@
+/* GStreamer
+ *
+ * gstqueuebudget.c: memory budget shared between queueing elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstqueuebudget
+ * @title: GstQueueBudget
+ * @short_description: Bound the memory buffered by a set of queues
+ *
+ * A #GstQueueBudget counts the bytes buffered by all the queues that share
+ * it, so that the total amount of memory held by queue, queue2 and
+ * multiqueue elements can be bounded for a whole process instead of per
+ * element.
+ *
+ * The budget is exhausted once #GstQueueBudget:high-watermark bytes are
+ * charged and stays exhausted until the usage drops to
+ * #GstQueueBudget:low-watermark again. While it is exhausted, queues either
+ * wait for their own data to drain or drop new buffers, depending on the
+ * #GstQueueBudget:policy.
+ *
+ * The budget is given to the elements with their `budget` property, or to a
+ * whole pipeline with a #GstContext of type #GST_QUEUE_BUDGET_CONTEXT_TYPE
+ * created with gst_context_set_queue_budget():
+ *
+ * |[<!-- language="C" -->
+ * GstQueueBudget *budget = gst_queue_budget_new (64 * 1024 * 1024, 0);
+ * GstContext *context = gst_context_new (GST_QUEUE_BUDGET_CONTEXT_TYPE, TRUE);
+ *
+ * gst_context_set_queue_budget (context, budget);
+ * gst_element_set_context (pipeline, context);
+ * ]|
+ *
+ * Charging and releasing only use atomic operations, the levels are
+ * approximate while several queues change them at the same time.
+ *
+ * Since: 1.20
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstqueuebudget.h"
+
+GST_DEBUG_CATEGORY_STATIC (queue_budget_debug);
+#define GST_CAT_DEFAULT queue_budget_debug
+
+#define DEFAULT_HIGH_WATERMARK 0
+#define DEFAULT_LOW_WATERMARK 0
+#define DEFAULT_POLICY GST_QUEUE_BUDGET_POLICY_BLOCK
+
+enum
+{
+  PROP_0,
+  PROP_HIGH_WATERMARK,
+  PROP_LOW_WATERMARK,
+  PROP_POLICY,
+  PROP_CURRENT_LEVEL_BYTES
+};
+
+struct _GstQueueBudgetPrivate
+{
+  /* all accessed atomically, the sizes are gsize so that they can be
+   * updated with the pointer sized atomic operations */
+  gsize bytes;
+  gsize high_watermark;
+  gsize low_watermark;
+  gint policy;
+  gint exhausted;
+};
+
+GType
+gst_queue_budget_policy_get_type (void)
+{
+  static GType gtype = 0;
+
+  if (g_once_init_enter (&gtype)) {
+    static const GEnumValue values[] = {
+      {GST_QUEUE_BUDGET_POLICY_BLOCK, "GST_QUEUE_BUDGET_POLICY_BLOCK", "block"},
+      {GST_QUEUE_BUDGET_POLICY_LEAK, "GST_QUEUE_BUDGET_POLICY_LEAK", "leak"},
+      {0, NULL, NULL}
+    };
+    GType new_type = g_enum_register_static ("GstQueueBudgetPolicy", values);
+
+    g_once_init_leave (&gtype, new_type);
+  }
+  return gtype;
+}
+
+#define gst_queue_budget_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstQueueBudget, gst_queue_budget, GST_TYPE_OBJECT,
+    G_ADD_PRIVATE (GstQueueBudget)
+    GST_DEBUG_CATEGORY_INIT (queue_budget_debug, "queuebudget", 0,
+        "queue budget"));
+
+static void
+gst_queue_budget_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstQueueBudget *budget = GST_QUEUE_BUDGET (object);
+  GstQueueBudgetPrivate *priv = budget->priv;
+
+  switch (prop_id) {
+    case PROP_HIGH_WATERMARK:
+      g_atomic_pointer_set (&priv->high_watermark,
+          (gsize) g_value_get_uint64 (value));
+      break;
+    case PROP_LOW_WATERMARK:
+      g_atomic_pointer_set (&priv->low_watermark,
+          (gsize) g_value_get_uint64 (value));
+      break;
+    case PROP_POLICY:
+      g_atomic_int_set (&priv->policy, g_value_get_enum (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_queue_budget_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstQueueBudget *budget = GST_QUEUE_BUDGET (object);
+  GstQueueBudgetPrivate *priv = budget->priv;
+
+  switch (prop_id) {
+    case PROP_HIGH_WATERMARK:
+      g_value_set_uint64 (value,
+          (gsize) g_atomic_pointer_get (&priv->high_watermark));
+      break;
+    case PROP_LOW_WATERMARK:
+      g_value_set_uint64 (value,
+          (gsize) g_atomic_pointer_get (&priv->low_watermark));
+      break;
+    case PROP_POLICY:
+      g_value_set_enum (value, g_atomic_int_get (&priv->policy));
+      break;
+    case PROP_CURRENT_LEVEL_BYTES:
+      g_value_set_uint64 (value, gst_queue_budget_get_bytes (budget));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_queue_budget_class_init (GstQueueBudgetClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->set_property = gst_queue_budget_set_property;
+  gobject_class->get_property = gst_queue_budget_get_property;
+
+  /**
+   * GstQueueBudget:high-watermark:
+   *
+   * Number of bytes at which the budget is exhausted, 0 disables the budget.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_HIGH_WATERMARK,
+      g_param_spec_uint64 ("high-watermark", "High watermark",
+          "Bytes at which the budget is exhausted (0=unlimited)",
+          0, G_MAXSIZE, DEFAULT_HIGH_WATERMARK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQueueBudget:low-watermark:
+   *
+   * Number of bytes the usage must drop to before an exhausted budget can be
+   * charged again.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LOW_WATERMARK,
+      g_param_spec_uint64 ("low-watermark", "Low watermark",
+          "Bytes below which an exhausted budget is available again",
+          0, G_MAXSIZE, DEFAULT_LOW_WATERMARK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQueueBudget:policy:
+   *
+   * What the queues do while the budget is exhausted.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_POLICY,
+      g_param_spec_enum ("policy", "Policy",
+          "What queues do while the budget is exhausted",
+          gst_queue_budget_policy_get_type (), DEFAULT_POLICY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQueueBudget:current-level-bytes:
+   *
+   * Number of bytes currently charged by all queues.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CURRENT_LEVEL_BYTES,
+      g_param_spec_uint64 ("current-level-bytes", "Current level (bytes)",
+          "Bytes currently charged by all queues", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gst_queue_budget_init (GstQueueBudget * budget)
+{
+  budget->priv = gst_queue_budget_get_instance_private (budget);
+
+  budget->priv->high_watermark = DEFAULT_HIGH_WATERMARK;
+  budget->priv->low_watermark = DEFAULT_LOW_WATERMARK;
+  budget->priv->policy = DEFAULT_POLICY;
+}
+
+/**
+ * gst_queue_budget_new:
+ * @high_watermark: bytes at which the budget is exhausted, 0 for unlimited
+ * @low_watermark: bytes at which an exhausted budget is available again
+ *
+ * Creates a new budget with the #GST_QUEUE_BUDGET_POLICY_BLOCK policy.
+ *
+ * Returns: (transfer full): a new #GstQueueBudget
+ *
+ * Since: 1.20
+ */
+GstQueueBudget *
+gst_queue_budget_new (guint64 high_watermark, guint64 low_watermark)
+{
+  GstQueueBudget *budget;
+
+  budget = g_object_new (GST_TYPE_QUEUE_BUDGET, "high-watermark",
+      high_watermark, "low-watermark", low_watermark, NULL);
+
+  /* Clear floating flag */
+  gst_object_ref_sink (budget);
+
+  return budget;
+}
+
+/**
+ * gst_queue_budget_charge:
+ * @budget: a #GstQueueBudget
+ * @bytes: the number of bytes queued
+ *
+ * Adds @bytes to the usage of @budget. Every charge must be matched by a
+ * gst_queue_budget_release() of the same size.
+ *
+ * Since: 1.20
+ */
+void
+gst_queue_budget_charge (GstQueueBudget * budget, guint64 bytes)
+{
+  GstQueueBudgetPrivate *priv;
+  gsize high, level;
+
+  g_return_if_fail (GST_IS_QUEUE_BUDGET (budget));
+
+  priv = budget->priv;
+  level = (gsize) g_atomic_pointer_add (&priv->bytes, (gssize) bytes) + bytes;
+
+  high = (gsize) g_atomic_pointer_get (&priv->high_watermark);
+  if (high > 0 && level >= high && !g_atomic_int_get (&priv->exhausted)) {
+    GST_DEBUG_OBJECT (budget, "exhausted at %" G_GSIZE_FORMAT " bytes", level);
+    g_atomic_int_set (&priv->exhausted, TRUE);
+  }
+}
+
+/**
+ * gst_queue_budget_release:
+ * @budget: a #GstQueueBudget
+ * @bytes: the number of bytes that left the queue
+ *
+ * Removes @bytes from the usage of @budget.
+ *
+ * Since: 1.20
+ */
+void
+gst_queue_budget_release (GstQueueBudget * budget, guint64 bytes)
+{
+  GstQueueBudgetPrivate *priv;
+  gsize low, level;
+
+  g_return_if_fail (GST_IS_QUEUE_BUDGET (budget));
+
+  priv = budget->priv;
+  level = (gsize) g_atomic_pointer_add (&priv->bytes, -(gssize) bytes) - bytes;
+
+  low = (gsize) g_atomic_pointer_get (&priv->low_watermark);
+  if (level <= low && g_atomic_int_get (&priv->exhausted)) {
+    GST_DEBUG_OBJECT (budget, "available again at %" G_GSIZE_FORMAT " bytes",
+        level);
+    g_atomic_int_set (&priv->exhausted, FALSE);
+  }
+}
+
+/**
+ * gst_queue_budget_is_exhausted:
+ * @budget: a #GstQueueBudget
+ *
+ * Checks if @budget reached its high watermark and did not drop to its low
+ * watermark since.
+ *
+ * Returns: %TRUE when queues should not buffer more data.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_queue_budget_is_exhausted (GstQueueBudget * budget)
+{
+  GstQueueBudgetPrivate *priv;
+  gsize high, level;
+
+  g_return_val_if_fail (GST_IS_QUEUE_BUDGET (budget), FALSE);
+
+  priv = budget->priv;
+  high = (gsize) g_atomic_pointer_get (&priv->high_watermark);
+  if (high == 0)
+    return FALSE;
+
+  level = (gsize) g_atomic_pointer_get (&priv->bytes);
+  if (level >= high)
+    return TRUE;
+
+  /* the flag can be stale when a charge and a release race, the level
+   * decides */
+  return g_atomic_int_get (&priv->exhausted)
+      && level > (gsize) g_atomic_pointer_get (&priv->low_watermark);
+}
+
+/**
+ * gst_queue_budget_get_bytes:
+ * @budget: a #GstQueueBudget
+ *
+ * Returns: the number of bytes currently charged to @budget.
+ *
+ * Since: 1.20
+ */
+guint64
+gst_queue_budget_get_bytes (GstQueueBudget * budget)
+{
+  g_return_val_if_fail (GST_IS_QUEUE_BUDGET (budget), 0);
+
+  return (gsize) g_atomic_pointer_get (&budget->priv->bytes);
+}
+
+/**
+ * gst_queue_budget_get_policy:
+ * @budget: a #GstQueueBudget
+ *
+ * Returns: what queues should do while @budget is exhausted.
+ *
+ * Since: 1.20
+ */
+GstQueueBudgetPolicy
+gst_queue_budget_get_policy (GstQueueBudget * budget)
+{
+  g_return_val_if_fail (GST_IS_QUEUE_BUDGET (budget),
+      GST_QUEUE_BUDGET_POLICY_BLOCK);
+
+  return g_atomic_int_get (&budget->priv->policy);
+}
+
+/**
+ * gst_context_set_queue_budget:
+ * @context: a writable #GstContext of type #GST_QUEUE_BUDGET_CONTEXT_TYPE
+ * @budget: (allow-none): a #GstQueueBudget
+ *
+ * Stores @budget in @context.
+ *
+ * Since: 1.20
+ */
+void
+gst_context_set_queue_budget (GstContext * context, GstQueueBudget * budget)
+{
+  GstStructure *s;
+
+  g_return_if_fail (context != NULL);
+  g_return_if_fail (budget == NULL || GST_IS_QUEUE_BUDGET (budget));
+
+  s = gst_context_writable_structure (context);
+  gst_structure_set (s, "budget", GST_TYPE_QUEUE_BUDGET, budget, NULL);
+}
+
+/**
+ * gst_context_get_queue_budget:
+ * @context: a #GstContext
+ * @budget: (out) (transfer full) (nullable): the resulting #GstQueueBudget
+ *
+ * Gets the #GstQueueBudget stored in a context of type
+ * #GST_QUEUE_BUDGET_CONTEXT_TYPE.
+ *
+ * Returns: %TRUE when @context holds a #GstQueueBudget.
+ *
+ * Since: 1.20
+ */
+gboolean
+gst_context_get_queue_budget (const GstContext * context,
+    GstQueueBudget ** budget)
+{
+  const GstStructure *s;
+
+  g_return_val_if_fail (GST_IS_CONTEXT (context), FALSE);
+  g_return_val_if_fail (budget != NULL, FALSE);
+
+  if (g_strcmp0 (gst_context_get_context_type (context),
+          GST_QUEUE_BUDGET_CONTEXT_TYPE) != 0)
+    return FALSE;
+
+  s = gst_context_get_structure (context);
+  return gst_structure_get (s, "budget", GST_TYPE_QUEUE_BUDGET, budget, NULL)
+      && *budget != NULL;
+}
@@ -0,0 +1,132 @@
+/* GStreamer
+ *
+ * gstqueuebudget.h: memory budget shared between queueing elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_QUEUE_BUDGET_H__
+#define __GST_QUEUE_BUDGET_H__
+
+#include <gst/gst.h>
+#include <gst/base/base-prelude.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_QUEUE_BUDGET            (gst_queue_budget_get_type())
+#define GST_QUEUE_BUDGET(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_QUEUE_BUDGET,GstQueueBudget))
+#define GST_QUEUE_BUDGET_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_QUEUE_BUDGET,GstQueueBudgetClass))
+#define GST_IS_QUEUE_BUDGET(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_QUEUE_BUDGET))
+#define GST_IS_QUEUE_BUDGET_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_QUEUE_BUDGET))
+#define GST_QUEUE_BUDGET_CAST(obj)       ((GstQueueBudget *)(obj))
+
+/**
+ * GST_QUEUE_BUDGET_CONTEXT_TYPE:
+ *
+ * The #GstContext type used to share a #GstQueueBudget with the queueing
+ * elements of a pipeline.
+ *
+ * Since: 1.20
+ */
+#define GST_QUEUE_BUDGET_CONTEXT_TYPE "gst.queue-budget"
+
+typedef struct _GstQueueBudget GstQueueBudget;
+typedef struct _GstQueueBudgetClass GstQueueBudgetClass;
+typedef struct _GstQueueBudgetPrivate GstQueueBudgetPrivate;
+
+/**
+ * GstQueueBudgetPolicy:
+ * @GST_QUEUE_BUDGET_POLICY_BLOCK: apply back-pressure, queues that hold data
+ *   wait until the budget is below its low watermark again.
+ * @GST_QUEUE_BUDGET_POLICY_LEAK: drop new buffers while the budget is
+ *   exhausted.
+ *
+ * What queues do when the #GstQueueBudget they charge is exhausted.
+ *
+ * Since: 1.20
+ */
+typedef enum
+{
+  GST_QUEUE_BUDGET_POLICY_BLOCK,
+  GST_QUEUE_BUDGET_POLICY_LEAK
+} GstQueueBudgetPolicy;
+
+/**
+ * GstQueueBudget:
+ *
+ * Opaque object holding the number of bytes buffered by all the queues
+ * sharing it.
+ *
+ * Since: 1.20
+ */
+struct _GstQueueBudget
+{
+  GstObject object;
+
+  /*< private >*/
+  GstQueueBudgetPrivate *priv;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+struct _GstQueueBudgetClass
+{
+  GstObjectClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GST_BASE_API
+GType                 gst_queue_budget_get_type        (void);
+
+GST_BASE_API
+GType                 gst_queue_budget_policy_get_type (void);
+
+GST_BASE_API
+GstQueueBudget *      gst_queue_budget_new             (guint64 high_watermark,
+                                                        guint64 low_watermark);
+
+GST_BASE_API
+void                  gst_queue_budget_charge          (GstQueueBudget * budget,
+                                                        guint64 bytes);
+
+GST_BASE_API
+void                  gst_queue_budget_release         (GstQueueBudget * budget,
+                                                        guint64 bytes);
+
+GST_BASE_API
+gboolean              gst_queue_budget_is_exhausted    (GstQueueBudget * budget);
+
+GST_BASE_API
+guint64               gst_queue_budget_get_bytes       (GstQueueBudget * budget);
+
+GST_BASE_API
+GstQueueBudgetPolicy  gst_queue_budget_get_policy      (GstQueueBudget * budget);
+
+GST_BASE_API
+void                  gst_context_set_queue_budget     (GstContext * context,
+                                                        GstQueueBudget * budget);
+
+GST_BASE_API
+gboolean              gst_context_get_queue_budget     (const GstContext * context,
+                                                        GstQueueBudget ** budget);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstQueueBudget, gst_object_unref)
+
+G_END_DECLS
+
+#endif /* __GST_QUEUE_BUDGET_H__ */
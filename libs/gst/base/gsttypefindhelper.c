@@ -95,7 +95,8 @@ helper_find_peek (gpointer data, gint64 offset, guint size)
   helper = (GstTypeFindHelper *) data;
 
   GST_LOG_OBJECT (helper->obj, "'%s' called peek (%" G_GINT64_FORMAT
-      ", %u)", GST_OBJECT_NAME (helper->factory), offset, size);
+      ", %u)", helper->factory ? GST_OBJECT_NAME (helper->factory) : "helper",
+      offset, size);
 
   if (size == 0)
     return NULL;
@@ -367,6 +368,9 @@ gst_type_find_helper_get_range (GstObject * obj, GstObject * parent,
  * functions for the given extension, which might speed up the typefinding
  * in many cases.
  *
+ * Before any of that, the typefind functions whose magic bytes match the
+ * start of the data are tried, see gst_type_find_register_with_magic().
+ *
  * Returns: the last %GstFlowReturn from pulling a buffer or %GST_FLOW_OK if
  *          typefinding was successful.
  *
@@ -382,6 +386,8 @@ gst_type_find_helper_get_range_full (GstObject * obj, GstObject * parent,
   GSList *walk;
   GList *l, *type_list;
   GstCaps *result = NULL;
+  const guint8 *head;
+  guint head_size;
 
   g_return_val_if_fail (GST_IS_OBJECT (obj), GST_FLOW_ERROR);
   g_return_val_if_fail (func != NULL, GST_FLOW_ERROR);
@@ -409,6 +415,33 @@ gst_type_find_helper_get_range_full (GstObject * obj, GstObject * parent,
     find.get_length = helper_find_get_length;
   }
 
+  /* first try the typefinders whose magic bytes match the start of the
+   * stream. Data that is too short for the peek is left to the full scan */
+  head_size = (size == 0 || size == (guint64) - 1) ? 4096 : (guint) MIN (size,
+      4096);
+  helper.factory = NULL;
+  head = helper_find_peek (&helper, 0, head_size);
+  if (head) {
+    type_list = gst_type_find_factory_get_list_for_data (head, head_size);
+    for (l = type_list; l; l = l->next) {
+      helper.factory = GST_TYPE_FIND_FACTORY (l->data);
+      gst_type_find_factory_call_function (helper.factory, &find);
+      if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
+        break;
+    }
+    gst_plugin_feature_list_free (type_list);
+  }
+
+  if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM) {
+    helper.flow_ret = GST_FLOW_OK;
+    goto done;
+  }
+
+  /* start over so the result only depends on the order of rank */
+  gst_caps_replace (&helper.caps, NULL);
+  helper.best_probability = GST_TYPE_FIND_NONE;
+  helper.flow_ret = GST_FLOW_OK;
+
   type_list = gst_type_find_factory_get_list ();
   type_list = prioritize_extension (obj, type_list, extension);
 
@@ -431,6 +464,7 @@ gst_type_find_helper_get_range_full (GstObject * obj, GstObject * parent,
   }
   gst_plugin_feature_list_free (type_list);
 
+done:
   for (walk = helper.buffers; walk; walk = walk->next) {
     GstMappedBuffer *bmap = (GstMappedBuffer *) walk->data;
 
@@ -497,6 +531,12 @@ typedef struct
   GstCaps *caps;
   GstTypeFindFactory *factory;  /* for logging */
   GstObject *obj;               /* for logging */
+  gint index;                   /* rank order of the factory */
+  gint *cancel;                 /* atomic, no data after this index */
+
+  /* for incremental typefinding, per call of a typefind function */
+  gboolean peek_failed;
+  gboolean suggested;
 } GstTypeFindBufHelper;
 
 /*
@@ -522,6 +562,10 @@ buf_helper_find_peek (gpointer data, gint64 off, guint size)
   if (size == 0)
     return NULL;
 
+  /* a typefind function of higher rank already found the maximum */
+  if (helper->cancel && helper->index > g_atomic_int_get (helper->cancel))
+    return NULL;
+
   if (off < 0) {
     GST_LOG_OBJECT (helper->obj, "'%s' wanted to peek at end; not supported",
         GST_OBJECT_NAME (helper->factory));
@@ -542,6 +586,22 @@ buf_helper_find_peek (gpointer data, gint64 off, guint size)
   return NULL;
 }
 
+/* like buf_helper_find_peek(), but remembers when a peek failed. A typefind
+ * function that got all data it asked for and didn't suggest anything will
+ * not suggest anything for more data with the same start either. */
+static const guint8 *
+buf_helper_find_peek_incremental (gpointer data, gint64 off, guint size)
+{
+  GstTypeFindBufHelper *helper = (GstTypeFindBufHelper *) data;
+  const guint8 *res;
+
+  res = buf_helper_find_peek (data, off, size);
+  if (res == NULL)
+    helper->peek_failed = TRUE;
+
+  return res;
+}
+
 /*
  * buf_helper_find_suggest:
  * @data: helper data struct
@@ -559,6 +619,8 @@ buf_helper_find_suggest (gpointer data, guint probability, GstCaps * caps)
       "'%s' called suggest (%u, %" GST_PTR_FORMAT ")",
       GST_OBJECT_NAME (helper->factory), probability, caps);
 
+  helper->suggested = TRUE;
+
   /* Note: not >= as we call typefinders in order of rank, highest first */
   if (probability > helper->best_probability) {
     gst_caps_replace (&helper->caps, caps);
@@ -566,6 +628,163 @@ buf_helper_find_suggest (gpointer data, guint probability, GstCaps * caps)
   }
 }
 
+/* ****************** parallel typefinding for buffers ******************* */
+
+typedef struct
+{
+  GstTypeFindBufHelper *helpers;        /* one per typefind function */
+  gint n_helpers;
+  gint next;                    /* atomic, next typefind function to call */
+  gint first_maximum;           /* atomic, lowest index with MAXIMUM */
+
+  GMutex lock;
+  GCond cond;
+  gint n_workers;
+} GstTypeFindParallel;
+
+static void
+parallel_run (GstTypeFindParallel * par)
+{
+  gint i;
+
+  /* the typefind functions are picked in order of rank, so as soon as one
+   * is after the first one that found the maximum, all others are as well */
+  while ((i = g_atomic_int_add (&par->next, 1)) < par->n_helpers) {
+    GstTypeFindBufHelper *helper = &par->helpers[i];
+    GstTypeFind find;
+    gint first;
+
+    if (i > g_atomic_int_get (&par->first_maximum))
+      break;
+
+    find.data = helper;
+    find.peek = buf_helper_find_peek;
+    find.suggest = buf_helper_find_suggest;
+    find.get_length = NULL;
+    gst_type_find_factory_call_function (helper->factory, &find);
+
+    if (helper->best_probability < GST_TYPE_FIND_MAXIMUM)
+      continue;
+
+    do {
+      first = g_atomic_int_get (&par->first_maximum);
+    } while (i < first
+        && !g_atomic_int_compare_and_exchange (&par->first_maximum, first, i));
+  }
+}
+
+static void
+parallel_worker (GstTypeFindParallel * par)
+{
+  parallel_run (par);
+
+  g_mutex_lock (&par->lock);
+  if (--par->n_workers == 0)
+    g_cond_signal (&par->cond);
+  g_mutex_unlock (&par->lock);
+}
+
+/* calls the typefind functions of @type_list from the threads of @pool and
+ * the calling thread, and stores the result in @result like calling them in
+ * order would have done */
+static void
+type_find_data_parallel (GstTypeFindBufHelper * result, GList * type_list,
+    GstTaskPool * pool)
+{
+  GstTypeFindParallel par;
+  GstTypeFindBufHelper *best = NULL;
+  gpointer *ids;
+  gint i, n_threads, n_pushed;
+  GList *l;
+
+  par.n_helpers = g_list_length (type_list);
+  if (par.n_helpers == 0)
+    return;
+
+  par.helpers = g_new0 (GstTypeFindBufHelper, par.n_helpers);
+  for (i = 0, l = type_list; l; l = l->next, i++) {
+    GstTypeFindBufHelper *helper = &par.helpers[i];
+
+    helper->data = result->data;
+    helper->size = result->size;
+    helper->best_probability = GST_TYPE_FIND_NONE;
+    helper->factory = GST_TYPE_FIND_FACTORY (l->data);
+    helper->obj = result->obj;
+    helper->index = i;
+    helper->cancel = &par.first_maximum;
+  }
+  par.next = 0;
+  par.first_maximum = par.n_helpers;
+  g_mutex_init (&par.lock);
+  g_cond_init (&par.cond);
+  par.n_workers = 0;
+
+  n_threads = MIN (g_get_num_processors (), par.n_helpers) - 1;
+  ids = g_new0 (gpointer, MAX (n_threads, 1));
+  for (n_pushed = 0; n_pushed < n_threads; n_pushed++) {
+    GError *err = NULL;
+
+    g_mutex_lock (&par.lock);
+    par.n_workers++;
+    g_mutex_unlock (&par.lock);
+
+    ids[n_pushed] = gst_task_pool_push (pool,
+        (GstTaskPoolFunction) parallel_worker, &par, &err);
+    if (err) {
+      GST_WARNING_OBJECT (result->obj, "failed to push typefind job: %s",
+          err->message);
+      g_clear_error (&err);
+      g_mutex_lock (&par.lock);
+      par.n_workers--;
+      g_mutex_unlock (&par.lock);
+      break;
+    }
+  }
+
+  /* the calling thread does its share of the work too, and then waits for
+   * the typefind functions that are still running in the pool */
+  parallel_run (&par);
+
+  g_mutex_lock (&par.lock);
+  while (par.n_workers > 0)
+    g_cond_wait (&par.cond, &par.lock);
+  g_mutex_unlock (&par.lock);
+
+  for (i = 0; i < n_pushed; i++) {
+    if (ids[i])
+      gst_task_pool_join (pool, ids[i]);
+  }
+  g_free (ids);
+
+  /* same tie-break as calling them in order: the highest probability, and
+   * the highest rank among the ones with equal probability */
+  if (par.first_maximum < par.n_helpers) {
+    best = &par.helpers[par.first_maximum];
+  } else {
+    for (i = 0; i < par.n_helpers; i++) {
+      GstTypeFindBufHelper *helper = &par.helpers[i];
+
+      if (helper->best_probability > (best ? best->best_probability :
+              GST_TYPE_FIND_NONE))
+        best = helper;
+    }
+  }
+
+  if (best) {
+    result->best_probability = best->best_probability;
+    result->caps = best->caps;
+    best->caps = NULL;
+    GST_LOG_OBJECT (result->obj, "'%s' won with probability %u",
+        GST_OBJECT_NAME (best->factory), (guint) best->best_probability);
+  }
+
+  for (i = 0; i < par.n_helpers; i++)
+    gst_caps_replace (&par.helpers[i].caps, NULL);
+  g_free (par.helpers);
+  g_mutex_clear (&par.lock);
+  g_cond_clear (&par.cond);
+}
+
 /**
  * gst_type_find_helper_for_data:
  * @obj: (allow-none): object doing the typefinding, or %NULL (used for logging)
@@ -599,6 +818,108 @@ gst_type_find_helper_for_data (GstObject * obj, const guint8 * data, gsize size,
       prob);
 }
 
+/* calls the typefind function of @helper->factory, unless it is in
+ * @excluded. When @excluded is given, typefind functions that are sure to not
+ * match data starting with @helper->data are added to it. */
+static void
+call_type_find_function (GstTypeFindBufHelper * helper, GstTypeFind * find,
+    GList ** excluded)
+{
+  if (excluded == NULL) {
+    gst_type_find_factory_call_function (helper->factory, find);
+    return;
+  }
+
+  if (g_list_find (*excluded, helper->factory)) {
+    GST_LOG_OBJECT (helper->obj, "skipping '%s', it didn't match before",
+        GST_OBJECT_NAME (helper->factory));
+    return;
+  }
+
+  helper->peek_failed = FALSE;
+  helper->suggested = FALSE;
+  gst_type_find_factory_call_function (helper->factory, find);
+
+  if (!helper->peek_failed && !helper->suggested) {
+    GST_LOG_OBJECT (helper->obj, "'%s' doesn't match",
+        GST_OBJECT_NAME (helper->factory));
+    *excluded = g_list_prepend (*excluded, gst_object_ref (helper->factory));
+  }
+}
+
+static GstCaps *
+type_find_data (GstObject * obj, const guint8 * data, gsize size,
+    const gchar * extension, GstTaskPool * pool, GList ** excluded,
+    GstTypeFindProbability * prob)
+{
+  GstTypeFindBufHelper helper;
+  GstTypeFind find;
+  GList *l, *type_list;
+  GstCaps *result = NULL;
+
+  helper.data = data;
+  helper.size = size;
+  helper.best_probability = GST_TYPE_FIND_NONE;
+  helper.caps = NULL;
+  helper.obj = obj;
+  helper.index = 0;
+  helper.cancel = NULL;
+
+  if (helper.data == NULL || helper.size == 0)
+    return NULL;
+
+  find.data = &helper;
+  find.peek = excluded ? buf_helper_find_peek_incremental :
+      buf_helper_find_peek;
+  find.suggest = buf_helper_find_suggest;
+  find.get_length = NULL;
+
+  /* first try the typefinders whose magic bytes match the data */
+  type_list = gst_type_find_factory_get_list_for_data (data, size);
+  for (l = type_list; l; l = l->next) {
+    helper.factory = GST_TYPE_FIND_FACTORY (l->data);
+    call_type_find_function (&helper, &find, excluded);
+    if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
+      break;
+  }
+  gst_plugin_feature_list_free (type_list);
+
+  if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
+    goto done;
+
+  /* start over so the result only depends on the order of rank */
+  gst_caps_replace (&helper.caps, NULL);
+  helper.best_probability = GST_TYPE_FIND_NONE;
+
+  type_list = gst_type_find_factory_get_list ();
+  type_list = prioritize_extension (obj, type_list, extension);
+
+  if (pool) {
+    type_find_data_parallel (&helper, type_list, pool);
+  } else {
+    for (l = type_list; l; l = l->next) {
+      helper.factory = GST_TYPE_FIND_FACTORY (l->data);
+      call_type_find_function (&helper, &find, excluded);
+      if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
+        break;
+    }
+  }
+  gst_plugin_feature_list_free (type_list);
+
+done:
+
+  if (helper.best_probability > 0)
+    result = helper.caps;
+
+  if (prob)
+    *prob = helper.best_probability;
+
+  GST_LOG_OBJECT (obj, "Returning %" GST_PTR_FORMAT " (probability = %u)",
+      result, (guint) helper.best_probability);
+
+  return result;
+}
+
 /**
  * gst_type_find_helper_for_data_with_extension:
  * @obj: (allow-none): object doing the typefinding, or %NULL (used for logging)
@@ -623,6 +944,9 @@ gst_type_find_helper_for_data (GstObject * obj, const guint8 * data, gsize size,
  * functions for the given extension, which might speed up the typefinding
  * in many cases.
  *
+ * Before any of that, the typefind functions whose magic bytes match the
+ * start of @data are tried, see gst_type_find_register_with_magic().
+ *
  * Free-function: gst_caps_unref
  *
  * Returns: (transfer full) (nullable): the #GstCaps corresponding to the data,
@@ -637,48 +961,95 @@ gst_type_find_helper_for_data_with_extension (GstObject * obj,
     const guint8 * data, gsize size, const gchar * extension,
     GstTypeFindProbability * prob)
 {
-  GstTypeFindBufHelper helper;
-  GstTypeFind find;
-  GList *l, *type_list;
-  GstCaps *result = NULL;
-
   g_return_val_if_fail (data != NULL, NULL);
 
-  helper.data = data;
-  helper.size = size;
-  helper.best_probability = GST_TYPE_FIND_NONE;
-  helper.caps = NULL;
-  helper.obj = obj;
-
-  if (helper.data == NULL || helper.size == 0)
-    return NULL;
-
-  find.data = &helper;
-  find.peek = buf_helper_find_peek;
-  find.suggest = buf_helper_find_suggest;
-  find.get_length = NULL;
-
-  type_list = gst_type_find_factory_get_list ();
-  type_list = prioritize_extension (obj, type_list, extension);
-
-  for (l = type_list; l; l = l->next) {
-    helper.factory = GST_TYPE_FIND_FACTORY (l->data);
-    gst_type_find_factory_call_function (helper.factory, &find);
-    if (helper.best_probability >= GST_TYPE_FIND_MAXIMUM)
-      break;
-  }
-  gst_plugin_feature_list_free (type_list);
+  return type_find_data (obj, data, size, extension, NULL, NULL, prob);
+}
 
-  if (helper.best_probability > 0)
-    result = helper.caps;
+/**
+ * gst_type_find_helper_for_data_with_task_pool:
+ * @obj: (allow-none): object doing the typefinding, or %NULL (used for logging)
+ * @data: (transfer none) (array length=size): * a pointer with data to typefind
+ * @size: the size of @data
+ * @extension: (allow-none): extension of the media, or %NULL
+ * @pool: (allow-none): a prepared #GstTaskPool, or %NULL
+ * @prob: (out) (allow-none): location to store the probability of the found
+ *     caps, or %NULL
+ *
+ * Like gst_type_find_helper_for_data_with_extension(), but spreads the calls
+ * to the typefind functions over the threads of @pool, in addition to the
+ * calling thread. When @pool is %NULL all typefind functions are called from
+ * the calling thread.
+ *
+ * Once a typefind function returns %GST_TYPE_FIND_MAXIMUM, the typefind
+ * functions of lower rank are not called anymore and the running ones don't
+ * get any more data. The result is the same as the one of
+ * gst_type_find_helper_for_data_with_extension(): the caps with the highest
+ * probability, or the caps of the typefind function with the highest rank
+ * among those with the same probability.
+ *
+ * All typefind functions need to be thread-safe to be used with this
+ * function.
+ *
+ * Free-function: gst_caps_unref
+ *
+ * Returns: (transfer full) (nullable): the #GstCaps corresponding to the data,
+ *     or %NULL if no type could be found. The caller should free the caps
+ *     returned with gst_caps_unref().
+ *
+ * Since: 1.20
+ */
+GstCaps *
+gst_type_find_helper_for_data_with_task_pool (GstObject * obj,
+    const guint8 * data, gsize size, const gchar * extension,
+    GstTaskPool * pool, GstTypeFindProbability * prob)
+{
+  g_return_val_if_fail (data != NULL, NULL);
+  g_return_val_if_fail (pool == NULL || GST_IS_TASK_POOL (pool), NULL);
 
-  if (prob)
-    *prob = helper.best_probability;
+  return type_find_data (obj, data, size, extension, pool, NULL, prob);
+}
 
-  GST_LOG_OBJECT (obj, "Returning %" GST_PTR_FORMAT " (probability = %u)",
-      result, (guint) helper.best_probability);
+/**
+ * gst_type_find_helper_for_data_incremental:
+ * @obj: (allow-none): object doing the typefinding, or %NULL (used for logging)
+ * @data: (transfer none) (array length=size): * a pointer with data to typefind
+ * @size: the size of @data
+ * @extension: (allow-none): extension of the media, or %NULL
+ * @excluded: (inout) (element-type Gst.TypeFindFactory) (transfer full): the
+ *     typefind factories to skip, initially %NULL
+ * @prob: (out) (allow-none): location to store the probability of the found
+ *     caps, or %NULL
+ *
+ * Like gst_type_find_helper_for_data_with_extension(), for callers that
+ * retry typefinding each time more data of the stream is available.
+ *
+ * Typefind functions that got all the data they asked for without suggesting
+ * any caps can't match any longer data with the same start either. They are
+ * added to @excluded and are not called again when @excluded is passed to the
+ * next call with more data. Data passed with the same @excluded list must
+ * always start with the data of the previous calls.
+ *
+ * Free @excluded with gst_plugin_feature_list_free() once typefinding is
+ * done, or when the start of the data changes.
+ *
+ * Free-function: gst_caps_unref
+ *
+ * Returns: (transfer full) (nullable): the #GstCaps corresponding to the data,
+ *     or %NULL if no type could be found. The caller should free the caps
+ *     returned with gst_caps_unref().
+ *
+ * Since: 1.20
+ */
+GstCaps *
+gst_type_find_helper_for_data_incremental (GstObject * obj,
+    const guint8 * data, gsize size, const gchar * extension,
+    GList ** excluded, GstTypeFindProbability * prob)
+{
+  g_return_val_if_fail (data != NULL, NULL);
+  g_return_val_if_fail (excluded != NULL, NULL);
 
-  return result;
+  return type_find_data (obj, data, size, extension, NULL, excluded, prob);
 }
 
 /**
@@ -45,6 +45,22 @@ GstCaps * gst_type_find_helper_for_data_with_extension (GstObject              *
                                                         const gchar            *extension,
                                                         GstTypeFindProbability *prob);
 
+GST_BASE_API
+GstCaps * gst_type_find_helper_for_data_with_task_pool (GstObject              *obj,
+                                                        const guint8           *data,
+                                                        gsize                   size,
+                                                        const gchar            *extension,
+                                                        GstTaskPool            *pool,
+                                                        GstTypeFindProbability *prob);
+
+GST_BASE_API
+GstCaps * gst_type_find_helper_for_data_incremental (GstObject              *obj,
+                                                     const guint8           *data,
+                                                     gsize                   size,
+                                                     const gchar            *extension,
+                                                     GList                 **excluded,
+                                                     GstTypeFindProbability *prob);
+
 GST_BASE_API
 GstCaps * gst_type_find_helper_for_buffer (GstObject              *obj,
                                            GstBuffer              *buf,
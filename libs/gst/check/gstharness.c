@@ -173,6 +173,7 @@ struct _GstHarnessPrivate
   GstTestClock *testclock;
 
   gint recv_buffers;
+  guint64 recv_bytes;
   gint recv_events;
   gint recv_upstream_events;
 
@@ -217,6 +218,7 @@ gst_harness_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   g_assert (h != NULL);
   g_mutex_lock (&priv->blocking_push_mutex);
   g_atomic_int_inc (&priv->recv_buffers);
+  priv->recv_bytes += gst_buffer_get_size (buffer);
 
   if (priv->drop_buffers) {
     gst_buffer_unref (buffer);
@@ -236,6 +238,52 @@ gst_harness_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   return GST_FLOW_OK;
 }
 
+/* lists are counted, dropped or queued as a whole so that throughput tests
+ * measure the element and not the harness */
+static GstFlowReturn
+gst_harness_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstHarness *h = g_object_get_data (G_OBJECT (pad), HARNESS_KEY);
+  GstHarnessPrivate *priv = h->priv;
+  guint i, len;
+
+  g_assert (h != NULL);
+
+  len = gst_buffer_list_length (list);
+
+  g_mutex_lock (&priv->blocking_push_mutex);
+  if (priv->blocking_push_mode) {
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    /* every buffer waits for its pull */
+    g_mutex_unlock (&priv->blocking_push_mutex);
+    for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+      ret = gst_harness_chain (pad, parent,
+          gst_buffer_ref (gst_buffer_list_get (list, i)));
+    gst_buffer_list_unref (list);
+    return ret;
+  }
+
+  g_atomic_int_add (&priv->recv_buffers, len);
+  priv->recv_bytes += gst_buffer_list_calculate_size (list);
+
+  if (!priv->drop_buffers) {
+    g_mutex_lock (&priv->buf_or_eos_mutex);
+    g_async_queue_lock (priv->buffer_queue);
+    for (i = 0; i < len; i++)
+      g_async_queue_push_unlocked (priv->buffer_queue,
+          gst_buffer_ref (gst_buffer_list_get (list, i)));
+    g_async_queue_unlock (priv->buffer_queue);
+    g_cond_signal (&priv->buf_or_eos_cond);
+    g_mutex_unlock (&priv->buf_or_eos_mutex);
+  }
+  g_mutex_unlock (&priv->blocking_push_mutex);
+
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
 static gboolean
 gst_harness_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -603,6 +651,7 @@ gst_harness_setup_sink_pad (GstHarness * h,
   g_object_set_data (G_OBJECT (h->sinkpad), HARNESS_KEY, h);
 
   gst_pad_set_chain_function (h->sinkpad, gst_harness_chain);
+  gst_pad_set_chain_list_function (h->sinkpad, gst_harness_chain_list);
   gst_pad_set_query_function (h->sinkpad, gst_harness_sink_query);
   gst_pad_set_event_function (h->sinkpad, gst_harness_sink_event);
 
@@ -1666,6 +1715,37 @@ gst_harness_push (GstHarness * h, GstBuffer * buffer)
   return gst_pad_push (h->srcpad, buffer);
 }
 
+/**
+ * gst_harness_push_list:
+ * @h: a #GstHarness
+ * @list: (transfer full): a #GstBufferList to push
+ *
+ * Pushes a #GstBufferList on the #GstHarness srcpad. Pushing many buffers in
+ * one list costs a lot less per buffer than gst_harness_push(), which makes
+ * it the better choice for throughput tests.
+ *
+ * MT safe.
+ *
+ * Returns: a #GstFlowReturn with the result from the push
+ *
+ * Since: 1.20
+ */
+GstFlowReturn
+gst_harness_push_list (GstHarness * h, GstBufferList * list)
+{
+  GstHarnessPrivate *priv = h->priv;
+  guint len;
+
+  g_assert (list != NULL);
+
+  len = gst_buffer_list_length (list);
+  if (len > 0)
+    priv->last_push_ts =
+        GST_BUFFER_TIMESTAMP (gst_buffer_list_get (list, len - 1));
+
+  return gst_pad_push_list (h->srcpad, list);
+}
+
 /**
  * gst_harness_pull:
  * @h: a #GstHarness
@@ -1696,6 +1776,52 @@ gst_harness_pull (GstHarness * h)
   return buf;
 }
 
+/**
+ * gst_harness_pull_n:
+ * @h: a #GstHarness
+ * @buffers: (out caller-allocates) (array length=n) (transfer full): an
+ *   array for @n #GstBuffer pointers
+ * @n: the number of buffers to pull
+ *
+ * Pulls @n buffers from the #GAsyncQueue on the #GstHarness sinkpad in one
+ * go. The pull waits for all of them and times out in 60 seconds, in which
+ * case fewer buffers are returned.
+ *
+ * MT safe.
+ *
+ * Returns: the number of buffers stored in @buffers
+ *
+ * Since: 1.20
+ */
+guint
+gst_harness_pull_n (GstHarness * h, GstBuffer ** buffers, guint n)
+{
+  GstHarnessPrivate *priv = h->priv;
+  gint64 end_time = g_get_monotonic_time () + 60 * G_TIME_SPAN_SECOND;
+  guint i;
+
+  g_return_val_if_fail (buffers != NULL || n == 0, 0);
+
+  g_async_queue_lock (priv->buffer_queue);
+  for (i = 0; i < n; i++) {
+    gint64 timeout = end_time - g_get_monotonic_time ();
+
+    buffers[i] = g_async_queue_timeout_pop_unlocked (priv->buffer_queue,
+        MAX (timeout, 0));
+    if (buffers[i] == NULL)
+      break;
+  }
+  g_async_queue_unlock (priv->buffer_queue);
+
+  if (priv->blocking_push_mode) {
+    g_mutex_lock (&priv->blocking_push_mutex);
+    g_cond_broadcast (&priv->blocking_push_cond);
+    g_mutex_unlock (&priv->blocking_push_mutex);
+  }
+
+  return i;
+}
+
 /**
  * gst_harness_pull_until_eos:
  * @h: a #GstHarness
@@ -1821,6 +1947,34 @@ gst_harness_buffers_in_queue (GstHarness * h)
   return g_async_queue_length (priv->buffer_queue);
 }
 
+/**
+ * gst_harness_bytes_received:
+ * @h: a #GstHarness
+ *
+ * The total size of the #GstBuffers that have arrived on the #GstHarness
+ * sinkpad. Like gst_harness_buffers_received() this includes dropped
+ * buffers, so together with gst_harness_set_drop_buffers() it allows
+ * measuring the throughput of an element without keeping its output.
+ *
+ * MT safe.
+ *
+ * Returns: a #guint64 number of bytes received
+ *
+ * Since: 1.20
+ */
+guint64
+gst_harness_bytes_received (GstHarness * h)
+{
+  GstHarnessPrivate *priv = h->priv;
+  guint64 bytes;
+
+  g_mutex_lock (&priv->blocking_push_mutex);
+  bytes = priv->recv_bytes;
+  g_mutex_unlock (&priv->blocking_push_mutex);
+
+  return bytes;
+}
+
 /**
  * gst_harness_set_drop_buffers:
  * @h: a #GstHarness
@@ -182,12 +182,18 @@ GstBuffer *    gst_harness_create_buffer (GstHarness * h, gsize size);
 GST_CHECK_API
 GstFlowReturn  gst_harness_push (GstHarness * h, GstBuffer * buffer);
 
+GST_CHECK_API
+GstFlowReturn  gst_harness_push_list (GstHarness * h, GstBufferList * list);
+
 GST_CHECK_API
 GstBuffer *    gst_harness_pull (GstHarness * h);
 
 GST_CHECK_API
 GstBuffer *    gst_harness_try_pull (GstHarness * h);
 
+GST_CHECK_API
+guint          gst_harness_pull_n (GstHarness * h, GstBuffer ** buffers, guint n);
+
 GST_CHECK_API
 gboolean       gst_harness_pull_until_eos (GstHarness * h, GstBuffer ** buf);
 
@@ -200,6 +206,9 @@ guint          gst_harness_buffers_received (GstHarness * h);
 GST_CHECK_API
 guint          gst_harness_buffers_in_queue (GstHarness * h);
 
+GST_CHECK_API
+guint64        gst_harness_bytes_received (GstHarness * h);
+
 GST_CHECK_API
 void           gst_harness_set_drop_buffers (GstHarness * h, gboolean drop_buffers);
 
@@ -192,6 +192,8 @@ struct _GstClockEntryContext
 {
   GstClockEntry *clock_entry;
   GstClockTimeDiff time_diff;
+  /* signalled when the entry is processed, set by a synchronous waiter */
+  GCond *processed_cond;
 };
 
 struct _GstTestClockPrivate
@@ -199,9 +201,11 @@ struct _GstTestClockPrivate
   GstClockType clock_type;
   GstClockTime start_time;
   GstClockTime internal_time;
-  GList *entry_contexts;
+  /* pending entries sorted by time, and the position of each entry in it
+   * so that lookups and removals don't have to walk all the entries */
+  GSequence *entry_contexts;
+  GHashTable *entry_iters;
   GCond entry_added_cond;
-  GCond entry_processed_cond;
 };
 
 #define DEFAULT_CLOCK_TYPE GST_CLOCK_TYPE_MONOTONIC
@@ -306,8 +310,9 @@ gst_test_clock_init (GstTestClock * test_clock)
 
   priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
 
+  priv->entry_contexts = g_sequence_new (NULL);
+  priv->entry_iters = g_hash_table_new (NULL, NULL);
   g_cond_init (&priv->entry_added_cond);
-  g_cond_init (&priv->entry_processed_cond);
   priv->clock_type = DEFAULT_CLOCK_TYPE;
 
   GST_OBJECT_FLAG_SET (test_clock,
@@ -336,8 +341,9 @@ gst_test_clock_dispose (GObject * object)
 
   GST_OBJECT_LOCK (test_clock);
 
-  while (priv->entry_contexts != NULL) {
-    GstClockEntryContext *ctx = priv->entry_contexts->data;
+  while (!g_sequence_is_empty (priv->entry_contexts)) {
+    GstClockEntryContext *ctx =
+        g_sequence_get (g_sequence_get_begin_iter (priv->entry_contexts));
     gst_test_clock_remove_entry (test_clock, ctx->clock_entry);
   }
 
@@ -352,8 +358,9 @@ gst_test_clock_finalize (GObject * object)
   GstTestClock *test_clock = GST_TEST_CLOCK (object);
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
 
+  g_sequence_free (priv->entry_contexts);
+  g_hash_table_unref (priv->entry_iters);
   g_cond_clear (&priv->entry_added_cond);
-  g_cond_clear (&priv->entry_processed_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -434,7 +441,8 @@ gst_test_clock_wait (GstClock * clock,
     GstClockEntry * entry, GstClockTimeDiff * jitter)
 {
   GstTestClock *test_clock = GST_TEST_CLOCK (clock);
-  GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
+  GstClockEntryContext *ctx;
+  GCond processed_cond;
 
   GST_OBJECT_LOCK (test_clock);
 
@@ -450,8 +458,25 @@ gst_test_clock_wait (GstClock * clock,
 
   GST_CLOCK_ENTRY_STATUS (entry) = GST_CLOCK_BUSY;
 
-  while (GST_CLOCK_ENTRY_STATUS (entry) == GST_CLOCK_BUSY)
-    g_cond_wait (&priv->entry_processed_cond, GST_OBJECT_GET_LOCK (test_clock));
+  /* only this waiter is woken up when the entry is processed */
+  g_cond_init (&processed_cond);
+  ctx = gst_test_clock_lookup_entry_context (test_clock, entry);
+  ctx->processed_cond = &processed_cond;
+
+  while (GST_CLOCK_ENTRY_STATUS (entry) == GST_CLOCK_BUSY) {
+    g_cond_wait (&processed_cond, GST_OBJECT_GET_LOCK (test_clock));
+
+    /* woken up spuriously or the entry was scheduled again */
+    if (GST_CLOCK_ENTRY_STATUS (entry) == GST_CLOCK_BUSY &&
+        (ctx = gst_test_clock_lookup_entry_context (test_clock, entry)))
+      ctx->processed_cond = &processed_cond;
+  }
+
+  /* the entry may still be pending after an unschedule that raced with an
+   * add, make sure it doesn't point to our cond anymore */
+  if ((ctx = gst_test_clock_lookup_entry_context (test_clock, entry)))
+    ctx->processed_cond = NULL;
+  g_cond_clear (&processed_cond);
 
   GST_OBJECT_UNLOCK (test_clock);
 
@@ -519,11 +544,11 @@ gst_test_clock_peek_next_pending_id_unlocked (GstTestClock * test_clock,
     GstClockID * pending_id)
 {
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
-  GList *imminent_clock_id = g_list_first (priv->entry_contexts);
   gboolean result = FALSE;
 
-  if (imminent_clock_id != NULL) {
-    GstClockEntryContext *ctx = imminent_clock_id->data;
+  if (!g_sequence_is_empty (priv->entry_contexts)) {
+    GstClockEntryContext *ctx =
+        g_sequence_get (g_sequence_get_begin_iter (priv->entry_contexts));
 
     if (pending_id != NULL) {
       *pending_id = gst_clock_id_ref (ctx->clock_entry);
@@ -540,7 +565,7 @@ gst_test_clock_peek_id_count_unlocked (GstTestClock * test_clock)
 {
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
 
-  return g_list_length (priv->entry_contexts);
+  return g_sequence_get_length (priv->entry_contexts);
 }
 
 static void
@@ -559,9 +584,12 @@ gst_test_clock_add_entry (GstTestClock * test_clock,
   ctx = g_slice_new (GstClockEntryContext);
   ctx->clock_entry = GST_CLOCK_ENTRY (gst_clock_id_ref (entry));
   ctx->time_diff = GST_CLOCK_DIFF (now, GST_CLOCK_ENTRY_TIME (entry));
+  ctx->processed_cond = NULL;
 
-  priv->entry_contexts = g_list_insert_sorted (priv->entry_contexts, ctx,
-      gst_clock_entry_context_compare_func);
+  /* entries with the same time stay in the order they were added */
+  g_hash_table_insert (priv->entry_iters, entry,
+      g_sequence_insert_sorted (priv->entry_contexts, ctx,
+          (GCompareDataFunc) gst_clock_entry_context_compare_func, NULL));
 
   g_cond_broadcast (&priv->entry_added_cond);
 }
@@ -571,14 +599,19 @@ gst_test_clock_remove_entry (GstTestClock * test_clock, GstClockEntry * entry)
 {
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
   GstClockEntryContext *ctx;
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (priv->entry_iters, entry);
+  if (iter != NULL) {
+    ctx = g_sequence_get (iter);
+    g_hash_table_remove (priv->entry_iters, entry);
+    g_sequence_remove (iter);
+
+    if (ctx->processed_cond)
+      g_cond_signal (ctx->processed_cond);
 
-  ctx = gst_test_clock_lookup_entry_context (test_clock, entry);
-  if (ctx != NULL) {
     gst_clock_id_unref (ctx->clock_entry);
-    priv->entry_contexts = g_list_remove (priv->entry_contexts, ctx);
     g_slice_free (GstClockEntryContext, ctx);
-
-    g_cond_broadcast (&priv->entry_processed_cond);
   }
 }
 
@@ -587,19 +620,11 @@ gst_test_clock_lookup_entry_context (GstTestClock * test_clock,
     GstClockEntry * clock_entry)
 {
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
-  GstClockEntryContext *result = NULL;
-  GList *cur;
+  GSequenceIter *iter;
 
-  for (cur = priv->entry_contexts; cur != NULL; cur = cur->next) {
-    GstClockEntryContext *ctx = cur->data;
+  iter = g_hash_table_lookup (priv->entry_iters, clock_entry);
 
-    if (ctx->clock_entry == clock_entry) {
-      result = ctx;
-      break;
-    }
-  }
-
-  return result;
+  return iter ? g_sequence_get (iter) : NULL;
 }
 
 static gint
@@ -645,10 +670,11 @@ gst_test_clock_get_pending_id_list_unlocked (GstTestClock * test_clock)
 {
   GstTestClockPrivate *priv = GST_TEST_CLOCK_GET_PRIVATE (test_clock);
   GQueue queue = G_QUEUE_INIT;
-  GList *cur;
+  GSequenceIter *iter;
 
-  for (cur = priv->entry_contexts; cur != NULL; cur = cur->next) {
-    GstClockEntryContext *ctx = cur->data;
+  for (iter = g_sequence_get_begin_iter (priv->entry_contexts);
+      !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    GstClockEntryContext *ctx = g_sequence_get (iter);
 
     g_queue_push_tail (&queue, gst_clock_id_ref (ctx->clock_entry));
   }
@@ -885,7 +911,7 @@ gst_test_clock_wait_for_next_pending_id (GstTestClock * test_clock,
 
   GST_OBJECT_LOCK (test_clock);
 
-  while (priv->entry_contexts == NULL)
+  while (g_sequence_is_empty (priv->entry_contexts))
     g_cond_wait (&priv->entry_added_cond, GST_OBJECT_GET_LOCK (test_clock));
 
   if (!gst_test_clock_peek_next_pending_id_unlocked (test_clock, pending_id))
@@ -934,7 +960,6 @@ gst_test_clock_process_next_clock_id (GstTestClock * test_clock)
   GstTestClockPrivate *priv;
   GstClockID result = NULL;
   GstClockEntryContext *ctx = NULL;
-  GList *cur;
 
   g_return_val_if_fail (GST_IS_TEST_CLOCK (test_clock), NULL);
 
@@ -942,9 +967,9 @@ gst_test_clock_process_next_clock_id (GstTestClock * test_clock)
 
   GST_OBJECT_LOCK (test_clock);
 
-  for (cur = priv->entry_contexts; cur != NULL && result == NULL;
-      cur = cur->next) {
-    ctx = cur->data;
+  /* the entries are sorted by time, only the first one can be due */
+  if (!g_sequence_is_empty (priv->entry_contexts)) {
+    ctx = g_sequence_get (g_sequence_get_begin_iter (priv->entry_contexts));
 
     if (priv->internal_time >= GST_CLOCK_ENTRY_TIME (ctx->clock_entry))
       result = gst_clock_id_ref (ctx->clock_entry);
@@ -977,7 +1002,6 @@ gst_test_clock_get_next_entry_time (GstTestClock * test_clock)
 {
   GstTestClockPrivate *priv;
   GstClockTime result = GST_CLOCK_TIME_NONE;
-  GList *imminent_clock_id;
 
   g_return_val_if_fail (GST_IS_TEST_CLOCK (test_clock), GST_CLOCK_TIME_NONE);
 
@@ -987,9 +1011,9 @@ gst_test_clock_get_next_entry_time (GstTestClock * test_clock)
 
   /* The list of pending clock notifications is sorted by time,
      so the most imminent one is the first one in the list. */
-  imminent_clock_id = g_list_first (priv->entry_contexts);
-  if (imminent_clock_id != NULL) {
-    GstClockEntryContext *ctx = imminent_clock_id->data;
+  if (!g_sequence_is_empty (priv->entry_contexts)) {
+    GstClockEntryContext *ctx =
+        g_sequence_get (g_sequence_get_begin_iter (priv->entry_contexts));
     result = GST_CLOCK_ENTRY_TIME (ctx->clock_entry);
   }
 
@@ -1025,7 +1049,7 @@ gst_test_clock_wait_for_multiple_pending_ids (GstTestClock * test_clock,
 
   GST_OBJECT_LOCK (test_clock);
 
-  while (g_list_length (priv->entry_contexts) < count)
+  while (g_sequence_get_length (priv->entry_contexts) < count)
     g_cond_wait (&priv->entry_added_cond, GST_OBJECT_GET_LOCK (test_clock));
 
   if (pending_list)
@@ -1067,7 +1091,7 @@ gst_test_clock_timed_wait_for_multiple_pending_ids (GstTestClock * test_clock,
 
   GST_OBJECT_LOCK (test_clock);
 
-  while (g_list_length (priv->entry_contexts) < count &&
+  while (g_sequence_get_length (priv->entry_contexts) < count &&
       g_get_monotonic_time () < timeout) {
     g_cond_wait_until (&priv->entry_added_cond,
         GST_OBJECT_GET_LOCK (test_clock), timeout);
@@ -1076,7 +1100,7 @@ gst_test_clock_timed_wait_for_multiple_pending_ids (GstTestClock * test_clock,
   if (pending_list)
     *pending_list = gst_test_clock_get_pending_id_list_unlocked (test_clock);
 
-  ret = (g_list_length (priv->entry_contexts) == count);
+  ret = (g_sequence_get_length (priv->entry_contexts) == count);
 
   GST_OBJECT_UNLOCK (test_clock);
 
@@ -62,6 +62,8 @@ static GValue *gst_direct_control_binding_get_value (GstControlBinding * _self,
 static gboolean gst_direct_control_binding_get_value_array (GstControlBinding *
     _self, GstClockTime timestamp, GstClockTime interval, guint n_values,
     gpointer values);
+static gboolean gst_direct_control_binding_get_sync_value (GstControlBinding *
+    _self, GstClockTime timestamp, GstClockTime last_sync, GValue * value);
 static gboolean gst_direct_control_binding_get_g_value_array (GstControlBinding
     * _self, GstClockTime timestamp, GstClockTime interval, guint n_values,
     GValue * values);
@@ -121,6 +123,35 @@ abs_convert_value_to_##type (GstDirectControlBinding *self, gdouble s, gpointer
 { \
   g##type *d = (g##type *)d_; \
   *d = (g##type) ROUNDING_OP (s); \
+} \
+\
+static gboolean \
+convert_values_to_##type (GstDirectControlBinding *self, const gdouble *s, guint n, gpointer d_) \
+{ \
+  g##type *d = (g##type *)d_; \
+  guint i; \
+  \
+  if (self->convert_value == convert_value_to_##type) { \
+    GParamSpec##Type *pspec = G_PARAM_SPEC_##TYPE (((GstControlBinding *)self)->pspec); \
+    gdouble min = pspec->minimum, max = pspec->maximum; \
+    \
+    for (i = 0; i < n; i++) { \
+      gdouble v; \
+      \
+      if (isnan (s[i])) \
+        continue; \
+      v = CLAMP (s[i], 0.0, 1.0); \
+      d[i] = (g##type) ROUNDING_OP (min * (1-v)) + (g##type) ROUNDING_OP (max * v); \
+    } \
+  } else if (self->convert_value == abs_convert_value_to_##type) { \
+    for (i = 0; i < n; i++) { \
+      if (!isnan (s[i])) \
+        d[i] = (g##type) ROUNDING_OP (s[i]); \
+    } \
+  } else { \
+    return FALSE; \
+  } \
+  return TRUE; \
 }
 
 DEFINE_CONVERT (int, Int, INT, rint);
@@ -175,6 +206,36 @@ convert_value_to_enum (GstDirectControlBinding * self, gdouble s, gpointer d_)
   *d = e->values[(gint) (s * (e->n_values - 1))].value;
 }
 
+/* converts a whole block of control values in one go if the default mapping
+ * function for the property type is used, the values for which the control
+ * source returned NAN are left untouched */
+static gboolean
+convert_values (GstDirectControlBinding * self, const gdouble * s, guint n,
+    gpointer d)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_PARAM_SPEC_VALUE_TYPE (((GstControlBinding *)
+                  self)->pspec))) {
+    case G_TYPE_INT:
+      return convert_values_to_int (self, s, n, d);
+    case G_TYPE_UINT:
+      return convert_values_to_uint (self, s, n, d);
+    case G_TYPE_LONG:
+      return convert_values_to_long (self, s, n, d);
+    case G_TYPE_ULONG:
+      return convert_values_to_ulong (self, s, n, d);
+    case G_TYPE_INT64:
+      return convert_values_to_int64 (self, s, n, d);
+    case G_TYPE_UINT64:
+      return convert_values_to_uint64 (self, s, n, d);
+    case G_TYPE_FLOAT:
+      return convert_values_to_float (self, s, n, d);
+    case G_TYPE_DOUBLE:
+      return convert_values_to_double (self, s, n, d);
+    default:
+      return FALSE;
+  }
+}
+
 /* vmethods */
 
 static void
@@ -196,6 +257,8 @@ gst_direct_control_binding_class_init (GstDirectControlBindingClass * klass)
       gst_direct_control_binding_get_value_array;
   control_binding_class->get_g_value_array =
       gst_direct_control_binding_get_g_value_array;
+  control_binding_class->get_sync_value =
+      gst_direct_control_binding_get_sync_value;
 
   properties[PROP_CS] =
       g_param_spec_object ("control-source", "ControlSource",
@@ -397,6 +460,31 @@ gst_direct_control_binding_sync_values (GstControlBinding * _self,
   return (ret);
 }
 
+static gboolean
+gst_direct_control_binding_get_sync_value (GstControlBinding * _self,
+    GstClockTime timestamp, GstClockTime last_sync, GValue * value)
+{
+  GstDirectControlBinding *self = GST_DIRECT_CONTROL_BINDING (_self);
+  gdouble src_val;
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_DIRECT_CONTROL_BINDING (self), FALSE);
+  g_return_val_if_fail (GST_CONTROL_BINDING_PSPEC (self), FALSE);
+
+  ret = gst_control_source_get_value (self->cs, timestamp, &src_val);
+  if (G_LIKELY (ret)) {
+    /* same change detection as in sync_values */
+    if ((timestamp < last_sync) || (src_val != self->last_value)) {
+      g_value_init (value, G_VALUE_TYPE (&self->cur_value));
+      self->convert_g_value (self, src_val, value);
+      self->last_value = src_val;
+    }
+  } else {
+    GST_DEBUG ("no control value for param %s", _self->name);
+  }
+  return ret;
+}
+
 static GValue *
 gst_direct_control_binding_get_value (GstControlBinding * _self,
     GstClockTime timestamp)
@@ -447,15 +535,18 @@ gst_direct_control_binding_get_value_array (GstControlBinding * _self,
   src_val = g_new0 (gdouble, n_values);
   if ((res = gst_control_source_get_value_array (self->cs, timestamp,
               interval, n_values, src_val))) {
-    for (i = 0; i < n_values; i++) {
-      /* we will only get NAN for sparse control sources, such as triggers */
-      if (!isnan (src_val[i])) {
-        convert (self, src_val[i], (gpointer) values);
-      } else {
-        GST_LOG ("no control value for property %s at index %d", _self->name,
-            i);
+    /* use the bulk conversion for the default mapping functions */
+    if (!convert_values (self, src_val, n_values, values)) {
+      for (i = 0; i < n_values; i++) {
+        /* we will only get NAN for sparse control sources, such as triggers */
+        if (!isnan (src_val[i])) {
+          convert (self, src_val[i], (gpointer) values);
+        } else {
+          GST_LOG ("no control value for property %s at index %d", _self->name,
+              i);
+        }
+        values += byte_size;
       }
-      values += byte_size;
     }
   } else {
     GST_LOG ("failed to get control value for property %s at ts %"
@@ -105,6 +105,53 @@ _get_nearest_control_points2 (GstTimedValueControlSource * self,
   }
 }
 
+/* returns the number of values starting at @ts that fall before @next_ts */
+static inline guint
+_get_segment_n_values (GstClockTime ts, GstClockTime next_ts,
+    GstClockTime interval, guint n_values)
+{
+  guint64 n;
+
+  if (!GST_CLOCK_TIME_IS_VALID (next_ts) || interval == 0)
+    return n_values;
+
+  n = (next_ts - ts - 1) / interval + 1;
+  return MIN (n, n_values);
+}
+
+/* fills @values segment by segment, the blocks between two control points
+ * are computed with the interpolation specific kernel */
+#define DEFINE_GET_VALUE_ARRAY(mode) \
+static gboolean \
+interpolate_##mode##_get_value_array_unlocked (GstTimedValueControlSource * \
+    self, GstClockTime timestamp, GstClockTime interval, guint n_values, \
+    gdouble * values) \
+{ \
+  gboolean ret = FALSE; \
+  GstClockTime ts = timestamp, next_ts; \
+  GstControlPoint *cp1, *cp2; \
+  guint i, n; \
+  \
+  for (i = 0; i < n_values; i += n) { \
+    _get_nearest_control_points2 (self, ts, &cp1, &cp2, &next_ts); \
+    n = _get_segment_n_values (ts, next_ts, interval, n_values - i); \
+    GST_LOG ("values[%3d..%3d] : ts=%" GST_TIME_FORMAT ", next_ts=%" \
+        GST_TIME_FORMAT, i, i + n - 1, GST_TIME_ARGS (ts), \
+        GST_TIME_ARGS (next_ts)); \
+    if (cp1) { \
+      _interpolate_##mode##_block (self, cp1, cp2, ts, interval, n, \
+          &values[i]); \
+      ret = TRUE; \
+    } else { \
+      guint j; \
+      \
+      for (j = 0; j < n; j++) \
+        values[i + j] = NAN; \
+    } \
+    ts += n * interval; \
+  } \
+  return ret; \
+}
 
 /*  steps-like (no-)interpolation, default */
 /*  just returns the value for the most recent key-frame */
@@ -135,36 +182,30 @@ interpolate_none_get (GstTimedValueControlSource * self, GstClockTime timestamp,
   return ret;
 }
 
+static inline void
+_interpolate_none_block (GstTimedValueControlSource * self,
+    GstControlPoint * cp1, GstControlPoint * cp2, GstClockTime ts,
+    GstClockTime interval, guint n, gdouble * values)
+{
+  gdouble value = _interpolate_none (self, cp1);
+  guint i;
+
+  for (i = 0; i < n; i++)
+    values[i] = value;
+}
+
+DEFINE_GET_VALUE_ARRAY (none);
+
 static gboolean
 interpolate_none_get_value_array (GstTimedValueControlSource * self,
     GstClockTime timestamp, GstClockTime interval, guint n_values,
     gdouble * values)
 {
-  gboolean ret = FALSE;
-  guint i;
-  GstClockTime ts = timestamp;
-  GstClockTime next_ts = 0;
-  GstControlPoint *cp1 = NULL, *cp2 = NULL;
+  gboolean ret;
 
   g_mutex_lock (&self->lock);
-
-  for (i = 0; i < n_values; i++) {
-    GST_LOG ("values[%3d] : ts=%" GST_TIME_FORMAT ", next_ts=%" GST_TIME_FORMAT,
-        i, GST_TIME_ARGS (ts), GST_TIME_ARGS (next_ts));
-    if (ts >= next_ts) {
-      _get_nearest_control_points2 (self, ts, &cp1, &cp2, &next_ts);
-    }
-    if (cp1) {
-      *values = _interpolate_none (self, cp1);
-      ret = TRUE;
-      GST_LOG ("values[%3d]=%lf", i, *values);
-    } else {
-      *values = NAN;
-      GST_LOG ("values[%3d]=-", i);
-    }
-    ts += interval;
-    values++;
-  }
+  ret = interpolate_none_get_value_array_unlocked (self, timestamp, interval,
+      n_values, values);
   g_mutex_unlock (&self->lock);
   return ret;
 }
@@ -207,38 +248,41 @@ interpolate_linear_get (GstTimedValueControlSource * self,
   return ret;
 }
 
+static inline void
+_interpolate_linear_block (GstTimedValueControlSource * self,
+    GstControlPoint * cp1, GstControlPoint * cp2, GstClockTime ts,
+    GstClockTime interval, guint n, gdouble * values)
+{
+  gdouble value1 = cp1->value, slope;
+  guint i;
+
+  if (!cp2) {
+    for (i = 0; i < n; i++)
+      values[i] = value1;
+    return;
+  }
+
+  slope = (cp2->value - value1) /
+      gst_guint64_to_gdouble (cp2->timestamp - cp1->timestamp);
+  ts -= cp1->timestamp;
+  for (i = 0; i < n; i++) {
+    values[i] = value1 + (gst_guint64_to_gdouble (ts) * slope);
+    ts += interval;
+  }
+}
+
+DEFINE_GET_VALUE_ARRAY (linear);
+
 static gboolean
 interpolate_linear_get_value_array (GstTimedValueControlSource * self,
     GstClockTime timestamp, GstClockTime interval, guint n_values,
     gdouble * values)
 {
-  gboolean ret = FALSE;
-  guint i;
-  GstClockTime ts = timestamp;
-  GstClockTime next_ts = 0;
-  GstControlPoint *cp1 = NULL, *cp2 = NULL;
+  gboolean ret;
 
   g_mutex_lock (&self->lock);
-
-  for (i = 0; i < n_values; i++) {
-    GST_LOG ("values[%3d] : ts=%" GST_TIME_FORMAT ", next_ts=%" GST_TIME_FORMAT,
-        i, GST_TIME_ARGS (ts), GST_TIME_ARGS (next_ts));
-    if (ts >= next_ts) {
-      _get_nearest_control_points2 (self, ts, &cp1, &cp2, &next_ts);
-    }
-    if (cp1) {
-      *values = _interpolate_linear (cp1->timestamp, cp1->value,
-          (cp2 ? cp2->timestamp : GST_CLOCK_TIME_NONE),
-          (cp2 ? cp2->value : 0.0), ts);
-      ret = TRUE;
-      GST_LOG ("values[%3d]=%lf", i, *values);
-    } else {
-      *values = NAN;
-      GST_LOG ("values[%3d]=-", i);
-    }
-    ts += interval;
-    values++;
-  }
+  ret = interpolate_linear_get_value_array_unlocked (self, timestamp, interval,
+      n_values, values);
   g_mutex_unlock (&self->lock);
   return ret;
 }
@@ -392,41 +436,61 @@ interpolate_cubic_get (GstTimedValueControlSource * self,
   return ret;
 }
 
+static inline void
+_interpolate_cubic_block (GstTimedValueControlSource * self,
+    GstControlPoint * cp1, GstControlPoint * cp2, GstClockTime ts,
+    GstClockTime interval, guint n, gdouble * values)
+{
+  gdouble h, z1, z2, c1, c2;
+  guint i;
+
+  if (!cp2) {
+    for (i = 0; i < n; i++)
+      values[i] = cp1->value;
+    return;
+  }
+
+  if (!self->valid_cache) {
+    _interpolate_cubic_update_cache (self);
+    self->valid_cache = TRUE;
+  }
+
+  h = cp1->cache.cubic.h;
+  z1 = cp1->cache.cubic.z;
+  z2 = cp2->cache.cubic.z;
+  c1 = cp1->value / h - h * z1;
+  c2 = cp2->value / h - h * z2;
+
+  for (i = 0; i < n; i++) {
+    gdouble diff1, diff2, out;
+
+    diff1 = gst_guint64_to_gdouble (ts - cp1->timestamp);
+    diff2 = gst_guint64_to_gdouble (cp2->timestamp - ts);
+
+    out = (z2 * diff1 * diff1 * diff1 + z1 * diff2 * diff2 * diff2) / h;
+    out += c2 * diff1;
+    out += c1 * diff2;
+    values[i] = out;
+    ts += interval;
+  }
+}
+
+DEFINE_GET_VALUE_ARRAY (cubic);
+
 static gboolean
 interpolate_cubic_get_value_array (GstTimedValueControlSource * self,
     GstClockTime timestamp, GstClockTime interval, guint n_values,
     gdouble * values)
 {
-  gboolean ret = FALSE;
-  guint i;
-  GstClockTime ts = timestamp;
-  GstClockTime next_ts = 0;
-  GstControlPoint *cp1 = NULL, *cp2 = NULL;
+  gboolean ret;
 
   if (self->nvalues <= 2)
     return interpolate_linear_get_value_array (self, timestamp, interval,
         n_values, values);
 
   g_mutex_lock (&self->lock);
-
-  for (i = 0; i < n_values; i++) {
-    GST_LOG ("values[%3d] : ts=%" GST_TIME_FORMAT ", next_ts=%" GST_TIME_FORMAT,
-        i, GST_TIME_ARGS (ts), GST_TIME_ARGS (next_ts));
-    if (ts >= next_ts) {
-      _get_nearest_control_points2 (self, ts, &cp1, &cp2, &next_ts);
-    }
-    if (cp1) {
-      *values = _interpolate_cubic (self, cp1, cp1->value, cp2,
-          (cp2 ? cp2->value : 0.0), ts);
-      ret = TRUE;
-      GST_LOG ("values[%3d]=%lf", i, *values);
-    } else {
-      *values = NAN;
-      GST_LOG ("values[%3d]=-", i);
-    }
-    ts += interval;
-    values++;
-  }
+  ret = interpolate_cubic_get_value_array_unlocked (self, timestamp, interval,
+      n_values, values);
   g_mutex_unlock (&self->lock);
   return ret;
 }
@@ -561,41 +625,59 @@ interpolate_cubic_monotonic_get (GstTimedValueControlSource * self,
   return ret;
 }
 
+static inline void
+_interpolate_cubic_monotonic_block (GstTimedValueControlSource * self,
+    GstControlPoint * cp1, GstControlPoint * cp2, GstClockTime ts,
+    GstClockTime interval, guint n, gdouble * values)
+{
+  gdouble value1 = cp1->value, c1s, c2s, c3s;
+  guint i;
+
+  if (!cp2) {
+    for (i = 0; i < n; i++)
+      values[i] = value1;
+    return;
+  }
+
+  if (!self->valid_cache) {
+    _interpolate_cubic_monotonic_update_cache (self);
+    self->valid_cache = TRUE;
+  }
+
+  c1s = cp1->cache.cubic_monotonic.c1s;
+  c2s = cp1->cache.cubic_monotonic.c2s;
+  c3s = cp1->cache.cubic_monotonic.c3s;
+  ts -= cp1->timestamp;
+
+  for (i = 0; i < n; i++) {
+    gdouble diff = gst_guint64_to_gdouble (ts);
+    gdouble diff2 = diff * diff;
+    gdouble out;
+
+    out = value1 + c1s * diff;
+    out += c2s * diff2;
+    out += c3s * diff * diff2;
+    values[i] = out;
+    ts += interval;
+  }
+}
+
+DEFINE_GET_VALUE_ARRAY (cubic_monotonic);
+
 static gboolean
 interpolate_cubic_monotonic_get_value_array (GstTimedValueControlSource * self,
     GstClockTime timestamp, GstClockTime interval, guint n_values,
     gdouble * values)
 {
-  gboolean ret = FALSE;
-  guint i;
-  GstClockTime ts = timestamp;
-  GstClockTime next_ts = 0;
-  GstControlPoint *cp1 = NULL, *cp2 = NULL;
+  gboolean ret;
 
   if (self->nvalues <= 2)
     return interpolate_linear_get_value_array (self, timestamp, interval,
         n_values, values);
 
   g_mutex_lock (&self->lock);
-
-  for (i = 0; i < n_values; i++) {
-    GST_LOG ("values[%3d] : ts=%" GST_TIME_FORMAT ", next_ts=%" GST_TIME_FORMAT,
-        i, GST_TIME_ARGS (ts), GST_TIME_ARGS (next_ts));
-    if (ts >= next_ts) {
-      _get_nearest_control_points2 (self, ts, &cp1, &cp2, &next_ts);
-    }
-    if (cp1) {
-      *values = _interpolate_cubic_monotonic (self, cp1, cp1->value, cp2,
-          (cp2 ? cp2->value : 0.0), ts);
-      ret = TRUE;
-      GST_LOG ("values[%3d]=%lf", i, *values);
-    } else {
-      *values = NAN;
-      GST_LOG ("values[%3d]=-", i);
-    }
-    ts += interval;
-    values++;
-  }
+  ret = interpolate_cubic_monotonic_get_value_array_unlocked (self, timestamp, interval,
+      n_values, values);
   g_mutex_unlock (&self->lock);
   return ret;
 }
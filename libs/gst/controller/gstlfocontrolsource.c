@@ -80,11 +80,9 @@ _calculate_pos (GstClockTime timestamp, GstClockTime timeshift,
 
 static inline gdouble
 _sine_get (GstLFOControlSource * self, gdouble amp, gdouble off,
-    GstClockTime timeshift, GstClockTime period, gdouble frequency,
-    GstClockTime timestamp)
+    GstClockTime period, gdouble frequency, GstClockTime position)
 {
-  gdouble pos =
-      gst_guint64_to_gdouble (_calculate_pos (timestamp, timeshift, period));
+  gdouble pos = gst_guint64_to_gdouble (position);
   gdouble ret;
 
   ret = sin (2.0 * M_PI * (frequency / GST_SECOND) * pos);
@@ -102,43 +100,21 @@ waveform_sine_get (GstLFOControlSource * self, GstClockTime timestamp,
 
   gst_object_sync_values (GST_OBJECT (self), timestamp);
   g_mutex_lock (&self->lock);
-  *value = _sine_get (self, priv->amplitude, priv->offset, priv->timeshift,
-      priv->period, priv->frequency, timestamp);
+  *value = _sine_get (self, priv->amplitude, priv->offset, priv->period,
+      priv->frequency, _calculate_pos (timestamp, priv->timeshift,
+          priv->period));
   g_mutex_unlock (&self->lock);
   return TRUE;
 }
 
-static gboolean
-waveform_sine_get_value_array (GstLFOControlSource * self,
-    GstClockTime timestamp, GstClockTime interval, guint n_values,
-    gdouble * values)
-{
-  GstLFOControlSourcePrivate *priv = self->priv;
-  guint i;
-  GstClockTime ts = timestamp;
-
-  for (i = 0; i < n_values; i++) {
-    gst_object_sync_values (GST_OBJECT (self), ts);
-    g_mutex_lock (&self->lock);
-    *values = _sine_get (self, priv->amplitude, priv->offset, priv->timeshift,
-        priv->period, priv->frequency, ts);
-    g_mutex_unlock (&self->lock);
-    ts += interval;
-    values++;
-  }
-  return TRUE;
-}
-
 
 static inline gdouble
 _square_get (GstLFOControlSource * self, gdouble amp, gdouble off,
-    GstClockTime timeshift, GstClockTime period, gdouble frequency,
-    GstClockTime timestamp)
+    GstClockTime period, gdouble frequency, GstClockTime position)
 {
-  GstClockTime pos = _calculate_pos (timestamp, timeshift, period);
   gdouble ret;
 
-  if (pos >= period / 2)
+  if (position >= period / 2)
     ret = amp;
   else
     ret = -amp;
@@ -155,40 +131,18 @@ waveform_square_get (GstLFOControlSource * self, GstClockTime timestamp,
 
   gst_object_sync_values (GST_OBJECT (self), timestamp);
   g_mutex_lock (&self->lock);
-  *value = _square_get (self, priv->amplitude, priv->offset, priv->timeshift,
-      priv->period, priv->frequency, timestamp);
+  *value = _square_get (self, priv->amplitude, priv->offset, priv->period,
+      priv->frequency, _calculate_pos (timestamp, priv->timeshift,
+          priv->period));
   g_mutex_unlock (&self->lock);
   return TRUE;
 }
 
-static gboolean
-waveform_square_get_value_array (GstLFOControlSource * self,
-    GstClockTime timestamp, GstClockTime interval, guint n_values,
-    gdouble * values)
-{
-  GstLFOControlSourcePrivate *priv = self->priv;
-  guint i;
-  GstClockTime ts = timestamp;
-
-  for (i = 0; i < n_values; i++) {
-    gst_object_sync_values (GST_OBJECT (self), ts);
-    g_mutex_lock (&self->lock);
-    *values = _square_get (self, priv->amplitude, priv->offset, priv->timeshift,
-        priv->period, priv->frequency, ts);
-    g_mutex_unlock (&self->lock);
-    ts += interval;
-    values++;
-  }
-  return TRUE;
-}
-
 static inline gdouble
 _saw_get (GstLFOControlSource * self, gdouble amp, gdouble off,
-    GstClockTime timeshift, GstClockTime period, gdouble frequency,
-    GstClockTime timestamp)
+    GstClockTime period, gdouble frequency, GstClockTime position)
 {
-  gdouble pos =
-      gst_guint64_to_gdouble (_calculate_pos (timestamp, timeshift, period));
+  gdouble pos = gst_guint64_to_gdouble (position);
   gdouble per = gst_guint64_to_gdouble (period);
   gdouble ret;
 
@@ -206,40 +160,18 @@ waveform_saw_get (GstLFOControlSource * self, GstClockTime timestamp,
 
   gst_object_sync_values (GST_OBJECT (self), timestamp);
   g_mutex_lock (&self->lock);
-  *value = _saw_get (self, priv->amplitude, priv->offset, priv->timeshift,
-      priv->period, priv->frequency, timestamp);
+  *value = _saw_get (self, priv->amplitude, priv->offset, priv->period,
+      priv->frequency, _calculate_pos (timestamp, priv->timeshift,
+          priv->period));
   g_mutex_unlock (&self->lock);
   return TRUE;
 }
 
-static gboolean
-waveform_saw_get_value_array (GstLFOControlSource * self,
-    GstClockTime timestamp, GstClockTime interval, guint n_values,
-    gdouble * values)
-{
-  GstLFOControlSourcePrivate *priv = self->priv;
-  guint i;
-  GstClockTime ts = timestamp;
-
-  for (i = 0; i < n_values; i++) {
-    gst_object_sync_values (GST_OBJECT (self), ts);
-    g_mutex_lock (&self->lock);
-    *values = _saw_get (self, priv->amplitude, priv->offset, priv->timeshift,
-        priv->period, priv->frequency, ts);
-    g_mutex_unlock (&self->lock);
-    ts += interval;
-    values++;
-  }
-  return TRUE;
-}
-
 static inline gdouble
 _rsaw_get (GstLFOControlSource * self, gdouble amp, gdouble off,
-    GstClockTime timeshift, GstClockTime period, gdouble frequency,
-    GstClockTime timestamp)
+    GstClockTime period, gdouble frequency, GstClockTime position)
 {
-  gdouble pos =
-      gst_guint64_to_gdouble (_calculate_pos (timestamp, timeshift, period));
+  gdouble pos = gst_guint64_to_gdouble (position);
   gdouble per = gst_guint64_to_gdouble (period);
   gdouble ret;
 
@@ -257,41 +189,19 @@ waveform_rsaw_get (GstLFOControlSource * self, GstClockTime timestamp,
 
   gst_object_sync_values (GST_OBJECT (self), timestamp);
   g_mutex_lock (&self->lock);
-  *value = _rsaw_get (self, priv->amplitude, priv->offset, priv->timeshift,
-      priv->period, priv->frequency, timestamp);
+  *value = _rsaw_get (self, priv->amplitude, priv->offset, priv->period,
+      priv->frequency, _calculate_pos (timestamp, priv->timeshift,
+          priv->period));
   g_mutex_unlock (&self->lock);
   return TRUE;
 }
 
-static gboolean
-waveform_rsaw_get_value_array (GstLFOControlSource * self,
-    GstClockTime timestamp, GstClockTime interval, guint n_values,
-    gdouble * values)
-{
-  GstLFOControlSourcePrivate *priv = self->priv;
-  guint i;
-  GstClockTime ts = timestamp;
-
-  for (i = 0; i < n_values; i++) {
-    gst_object_sync_values (GST_OBJECT (self), ts);
-    g_mutex_lock (&self->lock);
-    *values = _rsaw_get (self, priv->amplitude, priv->offset, priv->timeshift,
-        priv->period, priv->frequency, ts);
-    g_mutex_unlock (&self->lock);
-    ts += interval;
-    values++;
-  }
-  return TRUE;
-}
-
 
 static inline gdouble
 _triangle_get (GstLFOControlSource * self, gdouble amp, gdouble off,
-    GstClockTime timeshift, GstClockTime period, gdouble frequency,
-    GstClockTime timestamp)
+    GstClockTime period, gdouble frequency, GstClockTime position)
 {
-  gdouble pos =
-      gst_guint64_to_gdouble (_calculate_pos (timestamp, timeshift, period));
+  gdouble pos = gst_guint64_to_gdouble (position);
   gdouble per = gst_guint64_to_gdouble (period);
   gdouble ret;
 
@@ -318,34 +228,65 @@ waveform_triangle_get (GstLFOControlSource * self, GstClockTime timestamp,
 
   gst_object_sync_values (GST_OBJECT (self), timestamp);
   g_mutex_lock (&self->lock);
-  *value = _triangle_get (self, priv->amplitude, priv->offset, priv->timeshift,
-      priv->period, priv->frequency, timestamp);
+  *value = _triangle_get (self, priv->amplitude, priv->offset, priv->period,
+      priv->frequency, _calculate_pos (timestamp, priv->timeshift,
+          priv->period));
   g_mutex_unlock (&self->lock);
   return TRUE;
 }
 
-static gboolean
-waveform_triangle_get_value_array (GstLFOControlSource * self,
-    GstClockTime timestamp, GstClockTime interval, guint n_values,
-    gdouble * values)
-{
-  GstLFOControlSourcePrivate *priv = self->priv;
-  guint i;
-  GstClockTime ts = timestamp;
-
-  for (i = 0; i < n_values; i++) {
-    gst_object_sync_values (GST_OBJECT (self), ts);
-    g_mutex_lock (&self->lock);
-    *values =
-        _triangle_get (self, priv->amplitude, priv->offset, priv->timeshift,
-        priv->period, priv->frequency, ts);
-    g_mutex_unlock (&self->lock);
-    ts += interval;
-    values++;
-  }
-  return TRUE;
+/* Without control bindings on the LFO itself the waveform parameters are the
+ * same for the whole block, so the position in the period is advanced
+ * incrementally instead of being recalculated for every value. */
+#define DEFINE_WAVEFORM_GET_VALUE_ARRAY(name) \
+static gboolean \
+waveform_##name##_get_value_array (GstLFOControlSource * self, \
+    GstClockTime timestamp, GstClockTime interval, guint n_values, \
+    gdouble * values) \
+{ \
+  GstLFOControlSourcePrivate *priv = self->priv; \
+  GstClockTime ts = timestamp, pos, period; \
+  gdouble amp, off, frequency; \
+  guint i; \
+  \
+  if (gst_object_has_active_control_bindings (GST_OBJECT (self))) { \
+    for (i = 0; i < n_values; i++) { \
+      gst_object_sync_values (GST_OBJECT (self), ts); \
+      g_mutex_lock (&self->lock); \
+      values[i] = _##name##_get (self, priv->amplitude, priv->offset, \
+          priv->period, priv->frequency, \
+          _calculate_pos (ts, priv->timeshift, priv->period)); \
+      g_mutex_unlock (&self->lock); \
+      ts += interval; \
+    } \
+    return TRUE; \
+  } \
+  \
+  g_mutex_lock (&self->lock); \
+  amp = priv->amplitude; \
+  off = priv->offset; \
+  period = priv->period; \
+  frequency = priv->frequency; \
+  pos = _calculate_pos (timestamp, priv->timeshift, period); \
+  g_mutex_unlock (&self->lock); \
+  \
+  if (interval >= period) \
+    interval %= period; \
+  for (i = 0; i < n_values; i++) { \
+    values[i] = _##name##_get (self, amp, off, period, frequency, pos); \
+    pos += interval; \
+    if (pos >= period) \
+      pos -= period; \
+  } \
+  return TRUE; \
 }
 
+DEFINE_WAVEFORM_GET_VALUE_ARRAY (sine);
+DEFINE_WAVEFORM_GET_VALUE_ARRAY (square);
+DEFINE_WAVEFORM_GET_VALUE_ARRAY (saw);
+DEFINE_WAVEFORM_GET_VALUE_ARRAY (rsaw);
+DEFINE_WAVEFORM_GET_VALUE_ARRAY (triangle);
+
 static struct
 {
   GstControlSourceGetValue get;
@@ -34,6 +34,12 @@
  *
  * All functions are MT-safe.
  *
+ * Besides the #GSequence of control points a sorted array of their
+ * timestamps is kept, so gst_timed_value_control_source_find_control_point_iter()
+ * can use a binary search over contiguous memory. The last found position is
+ * remembered, which makes looking up monotonically increasing timestamps,
+ * as done when calculating value arrays, constant time.
+ *
  */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -52,9 +58,24 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
   GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "timed value control source", 0, \
     "timed value control source base class")
 
+struct _GstTimedValueControlSourcePrivate
+{
+  /* sorted timestamps of the control points and their iters in values,
+   * only used while valid is set */
+  GstClockTime *timestamps;
+  GSequenceIter **iters;
+  guint n_points;
+  guint alloc_points;
+  gboolean valid;
+
+  /* position of the last lookup */
+  guint cursor;
+};
+
 #define gst_timed_value_control_source_parent_class parent_class
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (GstTimedValueControlSource,
-    gst_timed_value_control_source, GST_TYPE_CONTROL_SOURCE, _do_init);
+    gst_timed_value_control_source, GST_TYPE_CONTROL_SOURCE,
+    G_ADD_PRIVATE (GstTimedValueControlSource) _do_init);
 
 
 enum
@@ -112,6 +133,97 @@ gst_control_point_get_type (void)
   return type_id;
 }
 
+static void
+gst_timed_value_control_source_ensure_points_size (GstTimedValueControlSource *
+    self, guint n_points)
+{
+  GstTimedValueControlSourcePrivate *priv = self->priv;
+
+  if (n_points <= priv->alloc_points)
+    return;
+
+  priv->alloc_points = MAX (n_points, MAX (16, priv->alloc_points * 2));
+  priv->timestamps = g_renew (GstClockTime, priv->timestamps,
+      priv->alloc_points);
+  priv->iters = g_renew (GSequenceIter *, priv->iters, priv->alloc_points);
+}
+
+/* call with the lock held */
+static void
+gst_timed_value_control_source_update_points (GstTimedValueControlSource *
+    self)
+{
+  GstTimedValueControlSourcePrivate *priv = self->priv;
+  GSequenceIter *iter;
+  guint i = 0;
+
+  /* subclasses may have changed the sequence, they keep nvalues updated */
+  if (priv->valid && (gint) priv->n_points == self->nvalues)
+    return;
+
+  gst_timed_value_control_source_ensure_points_size (self, self->nvalues);
+
+  if (self->values) {
+    for (iter = g_sequence_get_begin_iter (self->values);
+        !g_sequence_iter_is_end (iter) && i < priv->alloc_points;
+        iter = g_sequence_iter_next (iter), i++) {
+      priv->timestamps[i] = ((GstControlPoint *) g_sequence_get (iter))->
+          timestamp;
+      priv->iters[i] = iter;
+    }
+  }
+
+  GST_DEBUG ("indexed %u control points", i);
+
+  priv->n_points = i;
+  priv->cursor = 0;
+  priv->valid = TRUE;
+}
+
+/* returns the position of the last control point at or before @timestamp, or
+ * -1 if there is none. Call with the lock held. */
+static gint
+gst_timed_value_control_source_find_point (GstTimedValueControlSource * self,
+    GstClockTime timestamp)
+{
+  GstTimedValueControlSourcePrivate *priv = self->priv;
+  const GstClockTime *ts;
+  guint n, c, lo, hi;
+
+  gst_timed_value_control_source_update_points (self);
+
+  n = priv->n_points;
+  ts = priv->timestamps;
+  c = priv->cursor;
+
+  /* sequential access hits the last segment or the next one */
+  if (c < n && ts[c] <= timestamp) {
+    if (c + 1 == n || timestamp < ts[c + 1])
+      return c;
+    if (c + 2 == n || timestamp < ts[c + 2]) {
+      priv->cursor = c + 1;
+      return c + 1;
+    }
+  }
+
+  lo = 0;
+  hi = n;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (ts[mid] <= timestamp)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo == 0)
+    return -1;
+
+  priv->cursor = lo - 1;
+  return lo - 1;
+}
+
 static void
 gst_timed_value_control_source_reset (GstTimedValueControlSource * self)
 {
@@ -127,6 +239,7 @@ gst_timed_value_control_source_reset (GstTimedValueControlSource * self)
 
   self->nvalues = 0;
   self->valid_cache = FALSE;
+  self->priv->valid = FALSE;
 }
 
 /*
@@ -182,13 +295,15 @@ static void
 gst_timed_value_control_source_set_internal (GstTimedValueControlSource *
     self, GstClockTime timestamp, const gdouble value)
 {
+  GstTimedValueControlSourcePrivate *priv = self->priv;
   GstControlPoint *cp;
+  GSequenceIter *iter;
 
   g_mutex_lock (&self->lock);
 
   /* check if a control point for the timestamp already exists */
   if (G_LIKELY (self->values)) {
-    GSequenceIter *iter = g_sequence_lookup (self->values, &timestamp,
+    iter = g_sequence_lookup (self->values, &timestamp,
         (GCompareDataFunc) gst_control_point_find, NULL);
 
     if (iter) {
@@ -209,9 +324,22 @@ gst_timed_value_control_source_set_internal (GstTimedValueControlSource *
 
   /* sort new cp into the prop->values list */
   cp = _make_new_cp (self, timestamp, value);
-  g_sequence_insert_sorted (self->values, cp,
+  iter = g_sequence_insert_sorted (self->values, cp,
       (GCompareDataFunc) gst_control_point_compare, NULL);
   self->nvalues++;
+
+  /* appending, as when loading a stored curve, keeps the index valid */
+  if (priv->valid && (gint) priv->n_points + 1 == self->nvalues &&
+      (priv->n_points == 0 ||
+          priv->timestamps[priv->n_points - 1] < timestamp)) {
+    gst_timed_value_control_source_ensure_points_size (self,
+        priv->n_points + 1);
+    priv->timestamps[priv->n_points] = timestamp;
+    priv->iters[priv->n_points] = iter;
+    priv->n_points++;
+  } else {
+    priv->valid = FALSE;
+  }
   g_mutex_unlock (&self->lock);
 
   g_signal_emit (self,
@@ -230,30 +358,23 @@ done:
  * If all values in the control point list come after the given
  * timestamp or no values exist, %NULL is returned.
  *
- * For use in control source implementations.
+ * For use in control source implementations, with the lock held.
  *
  * Returns: (transfer none): the found #GSequenceIter or %NULL
  */
 GSequenceIter *gst_timed_value_control_source_find_control_point_iter
     (GstTimedValueControlSource * self, GstClockTime timestamp)
 {
-  GSequenceIter *iter;
+  gint idx;
 
   if (!self->values)
     return NULL;
 
-  iter =
-      g_sequence_search (self->values, &timestamp,
-      (GCompareDataFunc) gst_control_point_find, NULL);
-
-  /* g_sequence_search() returns the iter where timestamp
-   * would be inserted, i.e. the iter > timestamp, so
-   * we need to get the previous one. And of course, if
-   * there is no previous one, we return NULL. */
-  if (g_sequence_iter_is_begin (iter))
+  idx = gst_timed_value_control_source_find_point (self, timestamp);
+  if (idx < 0)
     return NULL;
 
-  return g_sequence_iter_prev (iter);
+  return self->priv->iters[idx];
 }
 
 
@@ -347,6 +468,7 @@ gst_timed_value_control_source_unset (GstTimedValueControlSource * self,
     g_sequence_remove (iter);
     self->nvalues--;
     self->valid_cache = FALSE;
+    self->priv->valid = FALSE;
     res = TRUE;
   }
   g_mutex_unlock (&self->lock);
@@ -380,6 +502,7 @@ gst_timed_value_control_source_unset_all (GstTimedValueControlSource * self)
   }
   self->nvalues = 0;
   self->valid_cache = FALSE;
+  self->priv->valid = FALSE;
 
   g_mutex_unlock (&self->lock);
 }
@@ -441,11 +564,13 @@ gst_timed_value_control_invalidate_cache (GstTimedValueControlSource * self)
 {
   g_return_if_fail (GST_IS_TIMED_VALUE_CONTROL_SOURCE (self));
   self->valid_cache = FALSE;
+  self->priv->valid = FALSE;
 }
 
 static void
 gst_timed_value_control_source_init (GstTimedValueControlSource * self)
 {
+  self->priv = gst_timed_value_control_source_get_instance_private (self);
   g_mutex_init (&self->lock);
 }
 
@@ -458,6 +583,8 @@ gst_timed_value_control_source_finalize (GObject * obj)
   gst_timed_value_control_source_reset (self);
   g_mutex_unlock (&self->lock);
   g_mutex_clear (&self->lock);
+  g_free (self->priv->timestamps);
+  g_free (self->priv->iters);
 
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -39,7 +39,10 @@
  * provider along with a name and an initial time.
  *
  * This clock will poll the time provider and will update its calibration
- * parameters based on the local and remote observations.
+ * parameters based on the local and remote observations. All clocks of a
+ * process are polled from a single thread. Where the kernel supports it, the
+ * local receive times are taken from the kernel timestamps of the replies
+ * instead of the time at which that thread got to read them.
  *
  * The "round-trip" property limits the maximum round trip packets can take.
  *
@@ -65,8 +68,20 @@
 
 #include <gio/gio.h>
 
+#include <errno.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
+
+/* the kernel can tell the time at which it received a packet */
+#if defined (SO_TIMESTAMPNS) && defined (SCM_TIMESTAMPNS)
+#define HAVE_KERNEL_RX_TIMESTAMPS 1
+#include <sys/uio.h>
+#include <time.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (ncc_debug);
 #define GST_CAT_DEFAULT (ncc_debug)
 
@@ -131,12 +146,14 @@ struct _GstNetClientInternalClock
 {
   GstSystemClock clock;
 
-  GThread *thread;
+  /* attached to the shared observer thread */
+  GSource *socket_source;
+  GSource *timer_source;
 
   GSocket *socket;
   GSocketAddress *servaddr;
-  GCancellable *cancel;
-  gboolean made_cancel_fd;
+  gboolean kernel_timestamps;
+  gint cur_qos_dscp;
 
   GstClockTime timeout_expiration;
   GstClockTime roundtrip_limit;
@@ -220,7 +237,9 @@ gst_net_client_internal_clock_init (GstNetClientInternalClock * self)
 
   gst_clock_set_timeout (GST_CLOCK (self), DEFAULT_TIMEOUT);
 
-  self->thread = NULL;
+  self->socket_source = NULL;
+  self->timer_source = NULL;
+  self->cur_qos_dscp = DEFAULT_QOS_DSCP;
 
   self->servaddr = NULL;
   self->rtt_avg = GST_CLOCK_TIME_NONE;
@@ -236,7 +255,7 @@ gst_net_client_internal_clock_finalize (GObject * object)
 {
   GstNetClientInternalClock *self = GST_NET_CLIENT_INTERNAL_CLOCK (object);
 
-  if (self->thread) {
+  if (self->socket_source) {
     gst_net_client_internal_clock_stop (self);
   }
 
@@ -635,184 +654,362 @@ bogus_observation:
   return;
 }
 
+/* All internal clocks of the process are served by one thread, which runs
+ * a main loop with a socket source and a timer source per clock */
+G_LOCK_DEFINE_STATIC (observer_lock);
+static GMainContext *observer_context;
+static GMainLoop *observer_loop;
+static GThread *observer_thread;
+static guint observer_n_clocks;
+
 static gpointer
-gst_net_client_internal_clock_thread (gpointer data)
+observer_thread_func (gpointer data)
 {
-  GstNetClientInternalClock *self = data;
-  GSocket *socket = self->socket;
-  GError *err = NULL;
-  gint cur_qos_dscp = DEFAULT_QOS_DSCP;
+  g_main_context_push_thread_default (observer_context);
+  g_main_loop_run (observer_loop);
+  g_main_context_pop_thread_default (observer_context);
+
+  return NULL;
+}
+
+/* with observer_lock */
+static gboolean
+observer_ref (GError ** error)
+{
+  if (observer_n_clocks == 0) {
+    observer_context = g_main_context_new ();
+    observer_loop = g_main_loop_new (observer_context, FALSE);
+    observer_thread = g_thread_try_new ("GstNetClientClock",
+        observer_thread_func, NULL, error);
+
+    if (observer_thread == NULL) {
+      g_main_loop_unref (observer_loop);
+      observer_loop = NULL;
+      g_main_context_unref (observer_context);
+      observer_context = NULL;
+      return FALSE;
+    }
+    GST_INFO ("started net client clock thread");
+  }
+  observer_n_clocks++;
 
-  GST_INFO_OBJECT (self, "net client clock thread running, socket=%p", socket);
+  return TRUE;
+}
 
-  g_socket_set_blocking (socket, TRUE);
-  g_socket_set_timeout (socket, 0);
+static gboolean
+observer_quit_cb (GMainLoop * loop)
+{
+  g_main_loop_quit (loop);
 
-  while (!g_cancellable_is_cancelled (self->cancel)) {
-    GstClockTime expiration_time = self->timeout_expiration;
-    GstClockTime now = gst_util_get_timestamp ();
-    gint64 socket_timeout;
+  return G_SOURCE_REMOVE;
+}
 
-    if (now >= expiration_time || (expiration_time - now) <= GST_MSECOND) {
-      socket_timeout = 0;
-    } else {
-      socket_timeout = (expiration_time - now) / GST_USECOND;
-    }
+/* with observer_lock */
+static void
+observer_unref (void)
+{
+  GSource *source;
 
-    GST_TRACE_OBJECT (self, "timeout: %" G_GINT64_FORMAT "us", socket_timeout);
+  g_assert (observer_n_clocks > 0);
 
-    if (!g_socket_condition_timed_wait (socket, G_IO_IN, socket_timeout,
-            self->cancel, &err)) {
-      /* cancelled, timeout or error */
-      if (err->code == G_IO_ERROR_CANCELLED) {
-        GST_INFO_OBJECT (self, "cancelled");
-        g_clear_error (&err);
-        break;
-      } else if (err->code == G_IO_ERROR_TIMED_OUT) {
-        gint new_qos_dscp;
+  if (--observer_n_clocks > 0)
+    return;
+
+  GST_INFO ("shutting down net client clock thread");
+  /* quit from within the loop, it might not be running yet */
+  source = g_idle_source_new ();
+  g_source_set_callback (source, (GSourceFunc) observer_quit_cb,
+      g_main_loop_ref (observer_loop), (GDestroyNotify) g_main_loop_unref);
+  g_source_attach (source, observer_context);
+  g_source_unref (source);
+  /* the last clock can be stopped from the thread itself */
+  if (observer_thread != g_thread_self ())
+    g_thread_join (observer_thread);
+  else
+    g_thread_unref (observer_thread);
+  observer_thread = NULL;
+  g_main_loop_unref (observer_loop);
+  observer_loop = NULL;
+  g_main_context_unref (observer_context);
+  observer_context = NULL;
+}
 
-        /* timed out, let's send another packet */
-        GST_DEBUG_OBJECT (self, "timed out");
+static gboolean
+timer_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
+{
+  g_source_set_ready_time (source, -1);
+
+  return callback (user_data);
+}
+
+static GSourceFuncs timer_source_funcs = {
+  NULL, NULL, timer_source_dispatch, NULL
+};
+
+static void
+gst_net_client_internal_clock_schedule (GstNetClientInternalClock * self)
+{
+  GstClockTime now = gst_util_get_timestamp ();
+  gint64 ready_time = g_get_monotonic_time ();
+
+  if (self->timeout_expiration > now + GST_MSECOND)
+    ready_time += (self->timeout_expiration - now) / GST_USECOND;
+
+  GST_TRACE_OBJECT (self, "timeout: %" G_GINT64_FORMAT "us",
+      ready_time - g_get_monotonic_time ());
+
+  g_source_set_ready_time (self->timer_source, ready_time);
+}
 
-        /* before next sending check if need to change QoS */
-        new_qos_dscp = self->qos_dscp;
-        if (cur_qos_dscp != new_qos_dscp &&
-            gst_net_utils_set_socket_tos (socket, new_qos_dscp)) {
-          GST_DEBUG_OBJECT (self, "changed QoS DSCP to: %d", new_qos_dscp);
-          cur_qos_dscp = new_qos_dscp;
-        }
+/* timed out, let's send another packet */
+static gboolean
+gst_net_client_internal_clock_timeout_cb (GstNetClientInternalClock * self)
+{
+  gint new_qos_dscp;
+
+  GST_DEBUG_OBJECT (self, "timed out");
+
+  /* before next sending check if need to change QoS */
+  new_qos_dscp = self->qos_dscp;
+  if (self->cur_qos_dscp != new_qos_dscp &&
+      gst_net_utils_set_socket_tos (self->socket, new_qos_dscp)) {
+    GST_DEBUG_OBJECT (self, "changed QoS DSCP to: %d", new_qos_dscp);
+    self->cur_qos_dscp = new_qos_dscp;
+  }
+
+  if (self->is_ntp) {
+    GstNtpPacket *packet;
+
+    packet = gst_ntp_packet_new (NULL, NULL);
 
-        if (self->is_ntp) {
-          GstNtpPacket *packet;
+    packet->transmit_time = gst_clock_get_internal_time (GST_CLOCK_CAST (self));
 
-          packet = gst_ntp_packet_new (NULL, NULL);
+    GST_DEBUG_OBJECT (self,
+        "sending packet, local time = %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (packet->transmit_time));
 
-          packet->transmit_time =
-              gst_clock_get_internal_time (GST_CLOCK_CAST (self));
+    gst_ntp_packet_send (packet, self->socket, self->servaddr, NULL);
 
-          GST_DEBUG_OBJECT (self,
-              "sending packet, local time = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->transmit_time));
+    g_free (packet);
+  } else {
+    GstNetTimePacket *packet;
 
-          gst_ntp_packet_send (packet, self->socket, self->servaddr, NULL);
+    packet = gst_net_time_packet_new (NULL);
 
-          g_free (packet);
-        } else {
-          GstNetTimePacket *packet;
+    packet->local_time = gst_clock_get_internal_time (GST_CLOCK_CAST (self));
 
-          packet = gst_net_time_packet_new (NULL);
+    GST_DEBUG_OBJECT (self,
+        "sending packet, local time = %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (packet->local_time));
 
-          packet->local_time =
-              gst_clock_get_internal_time (GST_CLOCK_CAST (self));
+    gst_net_time_packet_send (packet, self->socket, self->servaddr, NULL);
 
-          GST_DEBUG_OBJECT (self,
-              "sending packet, local time = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->local_time));
+    g_free (packet);
+  }
 
-          gst_net_time_packet_send (packet, self->socket, self->servaddr, NULL);
+  /* reset timeout (but are expecting a response sooner anyway) */
+  self->timeout_expiration =
+      gst_util_get_timestamp () + gst_clock_get_timeout (GST_CLOCK_CAST (self));
+  gst_net_client_internal_clock_schedule (self);
 
-          g_free (packet);
-        }
+  return G_SOURCE_CONTINUE;
+}
 
-        /* reset timeout (but are expecting a response sooner anyway) */
+#ifdef HAVE_KERNEL_RX_TIMESTAMPS
+static gssize
+receive_with_timestamp (GstNetClientInternalClock * self, guint8 * buffer,
+    gsize size, GstClockTime * local_time)
+{
+  union
+  {
+    struct cmsghdr hdr;
+    guint8 buf[CMSG_SPACE (sizeof (struct timespec))];
+  } control;
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  struct timespec now;
+  gssize ret;
+
+  iov.iov_base = buffer;
+  iov.iov_len = size;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = &control;
+  msg.msg_controllen = sizeof (control);
+
+  do {
+    ret = recvmsg (g_socket_get_fd (self->socket), &msg, MSG_DONTWAIT);
+  } while (ret < 0 && errno == EINTR);
+
+  *local_time = gst_clock_get_internal_time (GST_CLOCK_CAST (self));
+  if (ret < 0)
+    return ret;
+
+  /* the kernel timestamp is in realtime, so only use the time that passed
+   * since then to go back from the current internal time */
+  clock_gettime (CLOCK_REALTIME, &now);
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+      struct timespec ts;
+      GstClockTimeDiff delay;
+
+      memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+      delay = GST_CLOCK_DIFF (GST_TIMESPEC_TO_TIME (ts),
+          GST_TIMESPEC_TO_TIME (now));
+
+      /* ignore it if the realtime clock jumped in the meantime */
+      if (delay >= 0 && delay < GST_SECOND && *local_time >= delay) {
+        GST_LOG_OBJECT (self, "packet received %" G_GINT64_FORMAT "ns ago",
+            delay);
+        *local_time -= delay;
+      }
+      break;
+    }
+  }
+
+  return ret;
+}
+#endif
+
+/* Receives the next packet into @buffer and returns the local time at which
+ * it was received. This is the time at which the kernel received it if
+ * possible, which is not affected by the scheduling latency of this thread */
+static gboolean
+gst_net_client_internal_clock_receive (GstNetClientInternalClock * self,
+    guint8 * buffer, gsize size, GstClockTime * local_time, GError ** error)
+{
+  gssize ret;
+
+#ifdef HAVE_KERNEL_RX_TIMESTAMPS
+  if (self->kernel_timestamps) {
+    ret = receive_with_timestamp (self, buffer, size, local_time);
+    if (ret < 0) {
+      gint errsv = errno;
+
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+          "Error receiving data: %s", g_strerror (errsv));
+      return FALSE;
+    }
+  } else
+#endif
+  {
+    *local_time = gst_clock_get_internal_time (GST_CLOCK_CAST (self));
+    ret = g_socket_receive (self->socket, (gchar *) buffer, size, NULL, error);
+    if (ret < 0)
+      return FALSE;
+  }
+
+  if (ret < (gssize) size) {
+    GST_DEBUG_OBJECT (self, "someone sent us a short packet (%"
+        G_GSSIZE_FORMAT " < %" G_GSIZE_FORMAT ")", ret, size);
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+        "short time packet (%d < %d)", (int) ret, (int) size);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* got packet */
+static gboolean
+gst_net_client_internal_clock_socket_cb (GSocket * socket,
+    GIOCondition condition, GstNetClientInternalClock * self)
+{
+  guint8 buffer[MAX (GST_NTP_PACKET_SIZE, GST_NET_TIME_PACKET_SIZE)];
+  GstClockTime new_local;
+  GError *err = NULL;
+
+  if (self->is_ntp) {
+    GstNtpPacket *packet = NULL;
+
+    if (gst_net_client_internal_clock_receive (self, buffer,
+            GST_NTP_PACKET_SIZE, &new_local, &err))
+      packet = gst_ntp_packet_new (buffer, &err);
+
+    if (packet != NULL) {
+      GST_LOG_OBJECT (self, "got packet back");
+      GST_LOG_OBJECT (self, "local_1 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->origin_time));
+      GST_LOG_OBJECT (self, "remote_1 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->receive_time));
+      GST_LOG_OBJECT (self, "remote_2 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->transmit_time));
+      GST_LOG_OBJECT (self, "local_2 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (new_local));
+      GST_LOG_OBJECT (self, "poll_interval = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->poll_interval));
+
+      /* Remember the last poll interval we ever got from the server */
+      if (packet->poll_interval != GST_CLOCK_TIME_NONE)
+        self->last_remote_poll_interval = packet->poll_interval;
+
+      /* observe_times will reset the timeout */
+      gst_net_client_internal_clock_observe_times (self,
+          packet->origin_time, packet->receive_time, packet->transmit_time,
+          new_local);
+
+      g_free (packet);
+    } else if (err != NULL) {
+      if (g_error_matches (err, GST_NTP_ERROR, GST_NTP_ERROR_WRONG_VERSION)
+          || g_error_matches (err, GST_NTP_ERROR, GST_NTP_ERROR_KOD_DENY)) {
+        GST_ERROR_OBJECT (self, "fatal receive error: %s", err->message);
+        g_clear_error (&err);
+        g_source_destroy (self->timer_source);
+        return G_SOURCE_REMOVE;
+      } else if (g_error_matches (err, GST_NTP_ERROR, GST_NTP_ERROR_KOD_RATE)) {
+        GST_WARNING_OBJECT (self, "need to limit rate");
+
+        /* If the server did not tell us a poll interval before, double
+         * our minimum poll interval. Otherwise we assume that the server
+         * already told us something sensible and that this error here
+         * was just a spurious error */
+        if (self->last_remote_poll_interval == GST_CLOCK_TIME_NONE)
+          self->minimum_update_interval *= 2;
+
+        /* And wait a bit before we send the next packet instead of
+         * sending it immediately */
         self->timeout_expiration =
             gst_util_get_timestamp () +
             gst_clock_get_timeout (GST_CLOCK_CAST (self));
-      } else {
-        GST_DEBUG_OBJECT (self, "socket error: %s", err->message);
-        g_usleep (G_USEC_PER_SEC / 10); /* throttle */
+      } else if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK)) {
+        GST_WARNING_OBJECT (self, "receive error: %s", err->message);
       }
       g_clear_error (&err);
-    } else {
-      GstClockTime new_local;
-
-      /* got packet */
-
-      new_local = gst_clock_get_internal_time (GST_CLOCK_CAST (self));
-
-      if (self->is_ntp) {
-        GstNtpPacket *packet;
-
-        packet = gst_ntp_packet_receive (socket, NULL, &err);
-
-        if (packet != NULL) {
-          GST_LOG_OBJECT (self, "got packet back");
-          GST_LOG_OBJECT (self, "local_1 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->origin_time));
-          GST_LOG_OBJECT (self, "remote_1 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->receive_time));
-          GST_LOG_OBJECT (self, "remote_2 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->transmit_time));
-          GST_LOG_OBJECT (self, "local_2 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (new_local));
-          GST_LOG_OBJECT (self, "poll_interval = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->poll_interval));
-
-          /* Remember the last poll interval we ever got from the server */
-          if (packet->poll_interval != GST_CLOCK_TIME_NONE)
-            self->last_remote_poll_interval = packet->poll_interval;
-
-          /* observe_times will reset the timeout */
-          gst_net_client_internal_clock_observe_times (self,
-              packet->origin_time, packet->receive_time, packet->transmit_time,
-              new_local);
-
-          g_free (packet);
-        } else if (err != NULL) {
-          if (g_error_matches (err, GST_NTP_ERROR, GST_NTP_ERROR_WRONG_VERSION)
-              || g_error_matches (err, GST_NTP_ERROR, GST_NTP_ERROR_KOD_DENY)) {
-            GST_ERROR_OBJECT (self, "fatal receive error: %s", err->message);
-            g_clear_error (&err);
-            break;
-          } else if (g_error_matches (err, GST_NTP_ERROR,
-                  GST_NTP_ERROR_KOD_RATE)) {
-            GST_WARNING_OBJECT (self, "need to limit rate");
-
-            /* If the server did not tell us a poll interval before, double
-             * our minimum poll interval. Otherwise we assume that the server
-             * already told us something sensible and that this error here
-             * was just a spurious error */
-            if (self->last_remote_poll_interval == GST_CLOCK_TIME_NONE)
-              self->minimum_update_interval *= 2;
-
-            /* And wait a bit before we send the next packet instead of
-             * sending it immediately */
-            self->timeout_expiration =
-                gst_util_get_timestamp () +
-                gst_clock_get_timeout (GST_CLOCK_CAST (self));
-          } else {
-            GST_WARNING_OBJECT (self, "receive error: %s", err->message);
-          }
-          g_clear_error (&err);
-        }
-      } else {
-        GstNetTimePacket *packet;
-
-        packet = gst_net_time_packet_receive (socket, NULL, &err);
-
-        if (packet != NULL) {
-          GST_LOG_OBJECT (self, "got packet back");
-          GST_LOG_OBJECT (self, "local_1 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->local_time));
-          GST_LOG_OBJECT (self, "remote = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (packet->remote_time));
-          GST_LOG_OBJECT (self, "local_2 = %" GST_TIME_FORMAT,
-              GST_TIME_ARGS (new_local));
-
-          /* observe_times will reset the timeout */
-          gst_net_client_internal_clock_observe_times (self, packet->local_time,
-              packet->remote_time, packet->remote_time, new_local);
-
-          g_free (packet);
-        } else if (err != NULL) {
-          GST_WARNING_OBJECT (self, "receive error: %s", err->message);
-          g_clear_error (&err);
-        }
-      }
+    }
+  } else {
+    GstNetTimePacket *packet = NULL;
+
+    if (gst_net_client_internal_clock_receive (self, buffer,
+            GST_NET_TIME_PACKET_SIZE, &new_local, &err))
+      packet = gst_net_time_packet_new (buffer);
+
+    if (packet != NULL) {
+      GST_LOG_OBJECT (self, "got packet back");
+      GST_LOG_OBJECT (self, "local_1 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->local_time));
+      GST_LOG_OBJECT (self, "remote = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (packet->remote_time));
+      GST_LOG_OBJECT (self, "local_2 = %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (new_local));
+
+      /* observe_times will reset the timeout */
+      gst_net_client_internal_clock_observe_times (self, packet->local_time,
+          packet->remote_time, packet->remote_time, new_local);
+
+      g_free (packet);
+    } else if (err != NULL) {
+      if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_WOULD_BLOCK))
+        GST_WARNING_OBJECT (self, "receive error: %s", err->message);
+      g_clear_error (&err);
     }
   }
-  GST_INFO_OBJECT (self, "shutting down net client clock thread");
-  return NULL;
+
+  gst_net_client_internal_clock_schedule (self);
+
+  return G_SOURCE_CONTINUE;
 }
 
 static gboolean
@@ -825,9 +1022,9 @@ gst_net_client_internal_clock_start (GstNetClientInternalClock * self)
   GSocket *socket;
   GError *error = NULL;
   GSocketFamily family;
-  GPollFD dummy_pollfd;
   GResolver *resolver = NULL;
   GError *err = NULL;
+  gboolean started;
 
   g_return_val_if_fail (self->address != NULL, FALSE);
   g_return_val_if_fail (self->servaddr == NULL, FALSE);
@@ -885,17 +1082,40 @@ gst_net_client_internal_clock_start (GstNetClientInternalClock * self)
 
   g_object_unref (myaddr);
 
-  self->cancel = g_cancellable_new ();
-  self->made_cancel_fd =
-      g_cancellable_make_pollfd (self->cancel, &dummy_pollfd);
+#ifdef HAVE_KERNEL_RX_TIMESTAMPS
+  {
+    gint on = 1;
+
+    self->kernel_timestamps = setsockopt (g_socket_get_fd (socket), SOL_SOCKET,
+        SO_TIMESTAMPNS, &on, sizeof (on)) == 0;
+  }
+#endif
+  GST_DEBUG_OBJECT (self, "kernel receive timestamps %s",
+      self->kernel_timestamps ? "enabled" : "not available");
+
+  g_socket_set_blocking (socket, FALSE);
 
   self->socket = socket;
   self->servaddr = G_SOCKET_ADDRESS (servaddr);
 
-  self->thread = g_thread_try_new ("GstNetClientInternalClock",
-      gst_net_client_internal_clock_thread, self, &error);
+  G_LOCK (observer_lock);
+  started = observer_ref (&error);
+  if (started) {
+    self->socket_source = g_socket_create_source (socket, G_IO_IN, NULL);
+    g_source_set_callback (self->socket_source,
+        (GSourceFunc) gst_net_client_internal_clock_socket_cb, self, NULL);
+    self->timer_source = g_source_new (&timer_source_funcs, sizeof (GSource));
+    g_source_set_callback (self->timer_source,
+        (GSourceFunc) gst_net_client_internal_clock_timeout_cb, self, NULL);
+    /* send the first packet right away */
+    g_source_set_ready_time (self->timer_source, 0);
+
+    g_source_attach (self->socket_source, observer_context);
+    g_source_attach (self->timer_source, observer_context);
+  }
+  G_UNLOCK (observer_lock);
 
-  if (error != NULL)
+  if (!started)
     goto no_thread;
 
   return TRUE;
@@ -941,23 +1161,72 @@ no_thread:
   }
 }
 
+typedef struct
+{
+  GstNetClientInternalClock *self;
+  GMutex lock;
+  GCond cond;
+  gboolean done;
+} StopData;
+
+static gboolean
+stop_sources_cb (StopData * data)
+{
+  g_source_destroy (data->self->socket_source);
+  g_source_destroy (data->self->timer_source);
+
+  g_mutex_lock (&data->lock);
+  data->done = TRUE;
+  g_cond_signal (&data->cond);
+  g_mutex_unlock (&data->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 gst_net_client_internal_clock_stop (GstNetClientInternalClock * self)
 {
-  if (self->thread == NULL)
+  if (self->socket_source == NULL)
     return;
 
   GST_INFO_OBJECT (self, "stopping...");
-  g_cancellable_cancel (self->cancel);
 
-  g_thread_join (self->thread);
-  self->thread = NULL;
+  /* the callbacks can't be running anymore when the sources were destroyed
+   * from the thread itself */
+  if (g_main_context_is_owner (observer_context)) {
+    g_source_destroy (self->socket_source);
+    g_source_destroy (self->timer_source);
+  } else {
+    StopData data;
+    GSource *source;
+
+    data.self = self;
+    g_mutex_init (&data.lock);
+    g_cond_init (&data.cond);
+    data.done = FALSE;
+
+    source = g_idle_source_new ();
+    g_source_set_priority (source, G_PRIORITY_HIGH);
+    g_source_set_callback (source, (GSourceFunc) stop_sources_cb, &data, NULL);
+    g_mutex_lock (&data.lock);
+    g_source_attach (source, observer_context);
+    g_source_unref (source);
+    while (!data.done)
+      g_cond_wait (&data.cond, &data.lock);
+    g_mutex_unlock (&data.lock);
+
+    g_cond_clear (&data.cond);
+    g_mutex_clear (&data.lock);
+  }
 
-  if (self->made_cancel_fd)
-    g_cancellable_release_fd (self->cancel);
+  g_source_unref (self->socket_source);
+  self->socket_source = NULL;
+  g_source_unref (self->timer_source);
+  self->timer_source = NULL;
 
-  g_object_unref (self->cancel);
-  self->cancel = NULL;
+  G_LOCK (observer_lock);
+  observer_unref ();
+  G_UNLOCK (observer_lock);
 
   g_object_unref (self->servaddr);
   self->servaddr = NULL;
@@ -38,6 +38,15 @@
 #include "config.h"
 #endif
 
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#endif
+
 #include "gstnettimeprovider.h"
 #include "gstnettimepacket.h"
 #include "gstnetutils.h"
@@ -48,6 +57,11 @@ GST_DEBUG_CATEGORY_STATIC (ntp_debug);
 #define DEFAULT_ADDRESS         "0.0.0.0"
 #define DEFAULT_PORT            5637
 #define DEFAULT_QOS_DSCP        -1
+#define DEFAULT_N_THREADS       1
+#define MAX_N_THREADS           64
+
+/* maximum number of requests that are answered at once */
+#define BATCH_SIZE              32
 
 #define IS_ACTIVE(self) (g_atomic_int_get (&((self)->priv->active)))
 
@@ -58,24 +72,47 @@ enum
   PROP_ADDRESS,
   PROP_CLOCK,
   PROP_ACTIVE,
-  PROP_QOS_DSCP
+  PROP_QOS_DSCP,
+  PROP_N_THREADS,
+  PROP_STATS
 };
 
+/* a thread answering the requests received on its own socket, all sockets
+ * are bound to the same port */
+typedef struct
+{
+  GstNetTimeProvider *self;
+
+  GSocket *socket;
+  GThread *thread;
+
+  GMutex stats_lock;
+  guint64 requests;
+  guint64 dropped;
+  GstClockTime latency_sum;
+  GstClockTime latency_max;
+} GstNetTimeProviderWorker;
+
 struct _GstNetTimeProviderPrivate
 {
   gchar *address;
   int port;
   gint qos_dscp;                /* ATOMIC */
+  guint n_threads;
 
-  GThread *thread;
+  GstNetTimeProviderWorker *workers;
+  guint n_workers;
 
   GstClock *clock;
 
   gboolean active;              /* ATOMIC */
 
-  GSocket *socket;
   GCancellable *cancel;
   gboolean made_cancel_fd;
+
+  /* with LOCK, to compute the request rate between stats queries */
+  GstClockTime last_stats_time;
+  guint64 last_stats_requests;
 };
 
 static void gst_net_time_provider_initable_iface_init (gpointer g_iface);
@@ -135,6 +172,43 @@ gst_net_time_provider_class_init (GstNetTimeProviderClass * klass)
           "Quality of Service, differentiated services code point (-1 default)",
           -1, 63, DEFAULT_QOS_DSCP,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetTimeProvider:n-threads:
+   *
+   * Number of threads answering requests. Every thread has its own socket
+   * bound to the same port with SO_REUSEPORT, so the kernel distributes the
+   * clients over them.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_N_THREADS,
+      g_param_spec_uint ("n-threads", "Number of threads",
+          "Number of threads answering requests", 1, MAX_N_THREADS,
+          DEFAULT_N_THREADS,
+          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstNetTimeProvider:stats:
+   *
+   * Statistics about the requests of the clients, with the following
+   * fields:
+   *
+   * * #guint64 `requests`: the number of answered requests
+   * * #guint64 `dropped`: the number of requests that were not answered,
+   *   because the provider was not active or sending failed
+   * * #gdouble `request-rate`: the requests per second that were answered
+   *   since the previous time the statistics were retrieved
+   * * #guint64 `average-latency`: the average time in nanoseconds between
+   *   receiving a request and sending the reply
+   * * #guint64 `max-latency`: the maximum of that time
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Statistics about the requests", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -145,7 +219,8 @@ gst_net_time_provider_init (GstNetTimeProvider * self)
   self->priv->port = DEFAULT_PORT;
   self->priv->address = g_strdup (DEFAULT_ADDRESS);
   self->priv->qos_dscp = DEFAULT_QOS_DSCP;
-  self->priv->thread = NULL;
+  self->priv->n_threads = DEFAULT_N_THREADS;
+  self->priv->workers = NULL;
   self->priv->active = TRUE;
 }
 
@@ -154,9 +229,9 @@ gst_net_time_provider_finalize (GObject * object)
 {
   GstNetTimeProvider *self = GST_NET_TIME_PROVIDER (object);
 
-  if (self->priv->thread) {
+  if (self->priv->workers) {
     gst_net_time_provider_stop (self);
-    g_assert (self->priv->thread == NULL);
+    g_assert (self->priv->workers == NULL);
   }
 
   g_free (self->priv->address);
@@ -169,13 +244,151 @@ gst_net_time_provider_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_net_time_provider_worker_add_stats (GstNetTimeProviderWorker * worker,
+    guint requests, guint dropped, GstClockTime latency_sum,
+    GstClockTime latency)
+{
+  g_mutex_lock (&worker->stats_lock);
+  worker->requests += requests;
+  worker->dropped += dropped;
+  worker->latency_sum += latency_sum;
+  worker->latency_max = MAX (worker->latency_max, latency);
+  g_mutex_unlock (&worker->stats_lock);
+}
+
+#if defined (HAVE_RECVMMSG) && defined (HAVE_SENDMMSG)
+/* answers all available requests with a single recvmmsg() and sendmmsg()
+ * call. The replies are the requests with the remote time filled in. */
+static gboolean
+gst_net_time_provider_worker_process_batch (GstNetTimeProviderWorker * worker,
+    GError ** error)
+{
+  GstNetTimeProvider *self = worker->self;
+  guint8 buffers[BATCH_SIZE][GST_NET_TIME_PACKET_SIZE];
+  struct sockaddr_storage addrs[BATCH_SIZE];
+  struct mmsghdr msgs[BATCH_SIZE];
+  struct iovec iovs[BATCH_SIZE];
+  GstClockTime received, latency = 0;
+  gint fd, i, n, n_replies = 0, n_sent = 0;
+
+  fd = g_socket_get_fd (worker->socket);
+
+  memset (msgs, 0, sizeof (msgs));
+  for (i = 0; i < BATCH_SIZE; i++) {
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = GST_NET_TIME_PACKET_SIZE;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof (addrs[i]);
+  }
+
+  do {
+    n = recvmmsg (fd, msgs, BATCH_SIZE, MSG_DONTWAIT, NULL);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    gint errsv = errno;
+
+    if (errsv == EAGAIN || errsv == EWOULDBLOCK)
+      return TRUE;
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+        "Error receiving data: %s", g_strerror (errsv));
+    return FALSE;
+  }
+  received = gst_util_get_timestamp ();
+
+  GST_LOG_OBJECT (self, "received %d packets", n);
+
+  if (!IS_ACTIVE (self)) {
+    gst_net_time_provider_worker_add_stats (worker, 0, n, 0, 0);
+    return TRUE;
+  }
+
+  /* drop short packets and fill in the time of the others */
+  for (i = 0; i < n; i++) {
+    if (msgs[i].msg_len < GST_NET_TIME_PACKET_SIZE) {
+      GST_DEBUG_OBJECT (self, "someone sent us a short packet (%u < %d)",
+          msgs[i].msg_len, GST_NET_TIME_PACKET_SIZE);
+      continue;
+    }
+
+    if (n_replies != i) {
+      memcpy (buffers[n_replies], buffers[i], GST_NET_TIME_PACKET_SIZE);
+      memcpy (&addrs[n_replies], &addrs[i], msgs[i].msg_hdr.msg_namelen);
+      msgs[n_replies].msg_hdr.msg_namelen = msgs[i].msg_hdr.msg_namelen;
+    }
+    GST_WRITE_UINT64_BE (buffers[n_replies] + sizeof (GstClockTime),
+        gst_clock_get_time (self->priv->clock));
+    n_replies++;
+  }
+
+  while (n_sent < n_replies) {
+    gint ret;
+
+    ret = sendmmsg (fd, msgs + n_sent, n_replies - n_sent, 0);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      /* ignore errors */
+      GST_DEBUG_OBJECT (self, "send error: %s", g_strerror (errno));
+      break;
+    }
+    n_sent += ret;
+  }
+  if (n_sent > 0)
+    latency = gst_util_get_timestamp () - received;
+
+  gst_net_time_provider_worker_add_stats (worker, n_sent, n - n_sent,
+      latency * n_sent, latency);
+
+  return TRUE;
+}
+#else
+static gboolean
+gst_net_time_provider_worker_process_batch (GstNetTimeProviderWorker * worker,
+    GError ** error)
+{
+  GstNetTimeProvider *self = worker->self;
+  GSocketAddress *sender_addr = NULL;
+  GstNetTimePacket *packet;
+  GstClockTime received;
+
+  packet = gst_net_time_packet_receive (worker->socket, &sender_addr, error);
+  if (packet == NULL)
+    return FALSE;
+  received = gst_util_get_timestamp ();
+
+  if (IS_ACTIVE (self)) {
+    GstClockTime latency;
+
+    /* do what we were asked to and send the packet back */
+    packet->remote_time = gst_clock_get_time (self->priv->clock);
+
+    /* ignore errors */
+    gst_net_time_packet_send (packet, worker->socket, sender_addr, NULL);
+
+    latency = gst_util_get_timestamp () - received;
+    gst_net_time_provider_worker_add_stats (worker, 1, 0, latency, latency);
+  } else {
+    gst_net_time_provider_worker_add_stats (worker, 0, 1, 0, 0);
+  }
+  g_object_unref (sender_addr);
+  g_free (packet);
+
+  return TRUE;
+}
+#endif
+
 static gpointer
 gst_net_time_provider_thread (gpointer data)
 {
-  GstNetTimeProvider *self = data;
+  GstNetTimeProviderWorker *worker = data;
+  GstNetTimeProvider *self = worker->self;
   GCancellable *cancel = self->priv->cancel;
-  GSocket *socket = self->priv->socket;
-  GstNetTimePacket *packet;
+  GSocket *socket = worker->socket;
   GError *err = NULL;
   gint cur_qos_dscp = DEFAULT_QOS_DSCP;
   gint new_qos_dscp;
@@ -183,9 +396,6 @@ gst_net_time_provider_thread (gpointer data)
   GST_INFO_OBJECT (self, "time provider thread is running");
 
   while (TRUE) {
-    GSocketAddress *sender_addr = NULL;
-
-
     GST_LOG_OBJECT (self, "waiting on socket");
     if (!g_socket_condition_wait (socket, G_IO_IN, cancel, &err)) {
       GST_INFO_OBJECT (self, "socket error: %s", err->message);
@@ -200,33 +410,21 @@ gst_net_time_provider_thread (gpointer data)
       continue;
     }
 
-    /* got data in */
-    packet = gst_net_time_packet_receive (socket, &sender_addr, &err);
-
-    if (err != NULL) {
-      GST_DEBUG_OBJECT (self, "receive error: %s", err->message);
-      g_usleep (G_USEC_PER_SEC / 10);
-      g_error_free (err);
-      err = NULL;
-      continue;
-    }
-
     /* before next sending check if need to change QoS */
-    new_qos_dscp = self->priv->qos_dscp;
+    new_qos_dscp = g_atomic_int_get (&self->priv->qos_dscp);
     if (cur_qos_dscp != new_qos_dscp &&
         gst_net_utils_set_socket_tos (socket, new_qos_dscp)) {
       GST_DEBUG_OBJECT (self, "changed QoS DSCP to: %d", new_qos_dscp);
       cur_qos_dscp = new_qos_dscp;
     }
 
-    if (IS_ACTIVE (self)) {
-      /* do what we were asked to and send the packet back */
-      packet->remote_time = gst_clock_get_time (self->priv->clock);
-
-      /* ignore errors */
-      gst_net_time_packet_send (packet, socket, sender_addr, NULL);
-      g_object_unref (sender_addr);
-      g_free (packet);
+    /* got data in */
+    if (!gst_net_time_provider_worker_process_batch (worker, &err)) {
+      GST_DEBUG_OBJECT (self, "receive error: %s", err->message);
+      g_usleep (G_USEC_PER_SEC / 10);
+      g_error_free (err);
+      err = NULL;
+      continue;
     }
   }
 
@@ -236,6 +434,44 @@ gst_net_time_provider_thread (gpointer data)
   return NULL;
 }
 
+static GstStructure *
+gst_net_time_provider_get_stats (GstNetTimeProvider * self)
+{
+  guint64 requests = 0, dropped = 0;
+  GstClockTime latency_sum = 0, latency_max = 0, now;
+  gdouble rate = 0.0;
+  guint i;
+
+  GST_OBJECT_LOCK (self);
+  for (i = 0; i < self->priv->n_workers; i++) {
+    GstNetTimeProviderWorker *worker = &self->priv->workers[i];
+
+    g_mutex_lock (&worker->stats_lock);
+    requests += worker->requests;
+    dropped += worker->dropped;
+    latency_sum += worker->latency_sum;
+    latency_max = MAX (latency_max, worker->latency_max);
+    g_mutex_unlock (&worker->stats_lock);
+  }
+
+  now = gst_util_get_timestamp ();
+  if (GST_CLOCK_TIME_IS_VALID (self->priv->last_stats_time) &&
+      now > self->priv->last_stats_time)
+    rate = (gdouble) (requests - self->priv->last_stats_requests) *
+        GST_SECOND / (now - self->priv->last_stats_time);
+  self->priv->last_stats_time = now;
+  self->priv->last_stats_requests = requests;
+  GST_OBJECT_UNLOCK (self);
+
+  return gst_structure_new ("GstNetTimeProviderStats",
+      "requests", G_TYPE_UINT64, requests,
+      "dropped", G_TYPE_UINT64, dropped,
+      "request-rate", G_TYPE_DOUBLE, rate,
+      "average-latency", G_TYPE_UINT64,
+      requests > 0 ? latency_sum / requests : (guint64) 0,
+      "max-latency", G_TYPE_UINT64, latency_max, NULL);
+}
+
 static void
 gst_net_time_provider_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -264,6 +500,9 @@ gst_net_time_provider_set_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_atomic_int_set (&self->priv->qos_dscp, g_value_get_int (value));
       break;
+    case PROP_N_THREADS:
+      self->priv->n_threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -292,12 +531,38 @@ gst_net_time_provider_get_property (GObject * object, guint prop_id,
     case PROP_QOS_DSCP:
       g_value_set_int (value, self->priv->qos_dscp);
       break;
+    case PROP_N_THREADS:
+      g_value_set_uint (value, self->priv->n_threads);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_net_time_provider_get_stats (self));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* creates another socket bound to the same address and port */
+static GSocket *
+gst_net_time_provider_new_worker_socket (GSocketAddress * bound_addr,
+    GError ** error)
+{
+  GSocket *socket;
+
+  socket = g_socket_new (g_socket_address_get_family (bound_addr),
+      G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, error);
+  if (!socket)
+    return NULL;
+
+  if (!g_socket_bind (socket, bound_addr, TRUE, error)) {
+    g_object_unref (socket);
+    return NULL;
+  }
+
+  return socket;
+}
+
 static gboolean
 gst_net_time_provider_start (GstNetTimeProvider * self, GError ** error)
 {
@@ -308,6 +573,7 @@ gst_net_time_provider_start (GstNetTimeProvider * self, GError ** error)
   int port;
   gchar *address;
   GError *err = NULL;
+  guint i, n_workers;
 
   if (self->priv->address) {
     inet_addr = g_inet_address_new_from_string (self->priv->address);
@@ -359,17 +625,47 @@ gst_net_time_provider_start (GstNetTimeProvider * self, GError ** error)
   }
   GST_DEBUG_OBJECT (self, "bound on UDP address %s, port %d",
       self->priv->address, port);
+
+  n_workers = self->priv->n_threads;
+#ifndef SO_REUSEPORT
+  if (n_workers > 1) {
+    GST_WARNING_OBJECT (self, "SO_REUSEPORT not supported, using one thread");
+    n_workers = 1;
+  }
+#endif
+
+  /* g_socket_bind() sets SO_REUSEPORT on datagram sockets, which allows
+   * binding the sockets of the other workers to the same port */
+  self->priv->workers = g_new0 (GstNetTimeProviderWorker, n_workers);
+  for (i = 0; i < n_workers; i++) {
+    self->priv->workers[i].self = self;
+    g_mutex_init (&self->priv->workers[i].stats_lock);
+  }
+  self->priv->n_workers = n_workers;
+
+  self->priv->workers[0].socket = socket;
+  for (i = 1; i < n_workers; i++) {
+    socket = gst_net_time_provider_new_worker_socket (bound_addr, &err);
+    if (!socket)
+      break;
+    self->priv->workers[i].socket = socket;
+  }
   g_object_unref (bound_addr);
 
-  self->priv->socket = socket;
   self->priv->cancel = g_cancellable_new ();
   self->priv->made_cancel_fd =
       g_cancellable_make_pollfd (self->priv->cancel, &dummy_pollfd);
+  self->priv->last_stats_time = gst_util_get_timestamp ();
+  self->priv->last_stats_requests = 0;
+
+  for (i = 0; err == NULL && i < n_workers; i++) {
+    GstNetTimeProviderWorker *worker = &self->priv->workers[i];
 
-  self->priv->thread = g_thread_try_new ("GstNetTimeProvider",
-      gst_net_time_provider_thread, self, &err);
+    worker->thread = g_thread_try_new ("GstNetTimeProvider",
+        gst_net_time_provider_thread, worker, &err);
+  }
 
-  if (!self->priv->thread)
+  if (err != NULL)
     goto no_thread;
 
   return TRUE;
@@ -397,12 +693,9 @@ bind_error:
   }
 no_thread:
   {
-    GST_ERROR_OBJECT (self, "could not create thread: %s", err->message);
+    GST_ERROR_OBJECT (self, "could not start worker: %s", err->message);
     g_propagate_error (error, err);
-    g_object_unref (self->priv->socket);
-    self->priv->socket = NULL;
-    g_object_unref (self->priv->cancel);
-    self->priv->cancel = NULL;
+    gst_net_time_provider_stop (self);
     return FALSE;
   }
 }
@@ -410,13 +703,29 @@ no_thread:
 static void
 gst_net_time_provider_stop (GstNetTimeProvider * self)
 {
-  g_return_if_fail (self->priv->thread != NULL);
+  GstNetTimeProviderWorker *workers;
+  guint i, n_workers;
+
+  g_return_if_fail (self->priv->workers != NULL);
 
   GST_INFO_OBJECT (self, "stopping..");
   g_cancellable_cancel (self->priv->cancel);
 
-  g_thread_join (self->priv->thread);
-  self->priv->thread = NULL;
+  GST_OBJECT_LOCK (self);
+  workers = self->priv->workers;
+  n_workers = self->priv->n_workers;
+  self->priv->workers = NULL;
+  self->priv->n_workers = 0;
+  GST_OBJECT_UNLOCK (self);
+
+  for (i = 0; i < n_workers; i++) {
+    if (workers[i].thread)
+      g_thread_join (workers[i].thread);
+    if (workers[i].socket)
+      g_object_unref (workers[i].socket);
+    g_mutex_clear (&workers[i].stats_lock);
+  }
+  g_free (workers);
 
   if (self->priv->made_cancel_fd)
     g_cancellable_release_fd (self->priv->cancel);
@@ -424,9 +733,6 @@ gst_net_time_provider_stop (GstNetTimeProvider * self)
   g_object_unref (self->priv->cancel);
   self->priv->cancel = NULL;
 
-  g_object_unref (self->priv->socket);
-  self->priv->socket = NULL;
-
   GST_INFO_OBJECT (self, "stopped");
 }
 
@@ -53,6 +53,15 @@
 #include "config.h"
 #endif
 
+/* Receiving the PTP messages directly needs the same interface probing as
+ * gst-ptp-helper and batched receives */
+#if defined (HAVE_SIOCGIFCONF_SIOCGIFFLAGS_SIOCGIFHWADDR) && defined (HAVE_RECVMMSG)
+#define HAVE_PTP_IN_PROCESS 1
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif
+
 #include "gstptpclock.h"
 
 #include "gstptp_private.h"
@@ -72,6 +81,18 @@
 #include <io.h>
 #endif
 
+#ifdef HAVE_PTP_IN_PROCESS
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <gio/gio.h>
+#endif
+
 #include <gst/base/base.h>
 
 GST_DEBUG_CATEGORY_STATIC (ptp_debug);
@@ -249,6 +270,25 @@ static GRand *delay_req_rand;
 static GstClock *observation_system_clock;
 static PtpClockIdentity ptp_clock_id = { GST_PTP_CLOCK_ID_NONE, 0 };
 
+#ifdef HAVE_PTP_IN_PROCESS
+/* The PTP ports are opened in this process if that is allowed, instead of
+ * going through gst-ptp-helper. The messages are then received on the
+ * PTP thread itself together with the time at which the kernel received
+ * them. */
+#define PTP_MULTICAST_GROUP "224.0.1.129"
+#define PTP_EVENT_PORT   319
+#define PTP_GENERAL_PORT 320
+
+/* maximum number of messages that are handled per wakeup */
+#define PTP_BATCH_SIZE 16
+#define PTP_MAX_MESSAGE_SIZE 1500
+
+static gboolean in_process = FALSE;
+static GSocket *socket_event, *socket_general;
+static GSocketAddress *event_saddr;
+static GSource *socket_event_source, *socket_general_source;
+#endif
+
 typedef struct
 {
   GstClockTime receive_time;
@@ -968,6 +1008,26 @@ send_delay_req_timeout (PtpPendingSync * sync)
   gst_byte_writer_put_uint64_be_unchecked (&writer, 0);
   gst_byte_writer_put_uint16_be_unchecked (&writer, 0);
 
+#ifdef HAVE_PTP_IN_PROCESS
+  if (in_process) {
+    gssize sent;
+
+    sync->delay_req_send_time_local =
+        gst_clock_get_time (observation_system_clock);
+
+    sent = g_socket_send_to (socket_event, event_saddr,
+        (const gchar *) delay_req, 44, NULL, &err);
+    if (sent < 0) {
+      GST_WARNING ("Failed to send delay_req: %s", err->message);
+      g_clear_error (&err);
+    } else if (sent != 44) {
+      GST_WARNING ("Unexpected send size: %" G_GSSIZE_FORMAT, sent);
+    }
+
+    return G_SOURCE_REMOVE;
+  }
+#endif
+
   status =
       g_io_channel_write_chars (stdout_channel, (gchar *) & header,
       sizeof (header), &written, &err);
@@ -1874,6 +1934,286 @@ have_stdin_data_cb (GIOChannel * channel, GIOCondition condition,
   return G_SOURCE_CONTINUE;
 }
 
+#ifdef HAVE_PTP_IN_PROCESS
+static gboolean
+have_socket_data_cb (GSocket * socket, GIOCondition condition,
+    gpointer user_data)
+{
+  /* only used from the PTP thread */
+  static guint8 buffers[PTP_BATCH_SIZE][PTP_MAX_MESSAGE_SIZE];
+  union
+  {
+    struct cmsghdr hdr;
+    guint8 buf[CMSG_SPACE (sizeof (struct timespec))];
+  } controls[PTP_BATCH_SIZE];
+  struct mmsghdr msgs[PTP_BATCH_SIZE];
+  struct iovec iovs[PTP_BATCH_SIZE];
+  GstClockTime now;
+  struct timespec now_realtime;
+  gint i, n;
+
+  memset (msgs, 0, sizeof (msgs));
+  for (i = 0; i < PTP_BATCH_SIZE; i++) {
+    iovs[i].iov_base = buffers[i];
+    iovs[i].iov_len = PTP_MAX_MESSAGE_SIZE;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_control = &controls[i];
+    msgs[i].msg_hdr.msg_controllen = sizeof (controls[i]);
+  }
+
+  do {
+    n = recvmmsg (g_socket_get_fd (socket), msgs, PTP_BATCH_SIZE,
+        MSG_DONTWAIT, NULL);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+      GST_WARNING ("Failed to read from socket: %s", g_strerror (errno));
+    return G_SOURCE_CONTINUE;
+  }
+
+  /* the kernel timestamps are in realtime, so only use the time that passed
+   * since then to go back from the current time */
+  now = gst_clock_get_time (observation_system_clock);
+  clock_gettime (CLOCK_REALTIME, &now_realtime);
+
+  GST_TRACE ("Received %d messages from %s socket", n,
+      (socket == socket_event ? "event" : "general"));
+
+  for (i = 0; i < n; i++) {
+    GstClockTime receive_time = now;
+    struct cmsghdr *cmsg;
+    PtpMessage msg;
+
+    for (cmsg = CMSG_FIRSTHDR (&msgs[i].msg_hdr); cmsg;
+        cmsg = CMSG_NXTHDR (&msgs[i].msg_hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+        struct timespec ts;
+        GstClockTimeDiff delay;
+
+        memcpy (&ts, CMSG_DATA (cmsg), sizeof (ts));
+        delay = GST_CLOCK_DIFF (GST_TIMESPEC_TO_TIME (ts),
+            GST_TIMESPEC_TO_TIME (now_realtime));
+
+        /* ignore it if the realtime clock jumped in the meantime */
+        if (delay >= 0 && delay < GST_SECOND && now >= delay)
+          receive_time = now - delay;
+        break;
+      }
+    }
+
+    if (parse_ptp_message (&msg, buffers[i], msgs[i].msg_len)) {
+      dump_ptp_message (&msg);
+      handle_ptp_message (&msg, receive_time);
+    }
+  }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GSocket *
+ptp_in_process_open_socket (guint16 port, GError ** error)
+{
+  GInetAddress *bind_addr;
+  GSocketAddress *bind_saddr;
+  GSocket *socket;
+  gint on = 1;
+
+  socket = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+      G_SOCKET_PROTOCOL_UDP, error);
+  if (!socket)
+    return NULL;
+  g_socket_set_multicast_loopback (socket, FALSE);
+  g_socket_set_blocking (socket, FALSE);
+
+  bind_addr = g_inet_address_new_any (G_SOCKET_FAMILY_IPV4);
+  bind_saddr = g_inet_socket_address_new (bind_addr, port);
+  g_object_unref (bind_addr);
+  if (!g_socket_bind (socket, bind_saddr, TRUE, error)) {
+    g_object_unref (bind_saddr);
+    g_object_unref (socket);
+    return NULL;
+  }
+  g_object_unref (bind_saddr);
+
+  if (setsockopt (g_socket_get_fd (socket), SOL_SOCKET, SO_TIMESTAMPNS, &on,
+          sizeof (on)) != 0)
+    GST_WARNING ("Kernel receive timestamps not available: %s",
+        g_strerror (errno));
+
+  return socket;
+}
+
+/* all non-loopback interfaces */
+static gchar **
+ptp_in_process_probe_interfaces (void)
+{
+  struct ifreq ifr;
+  struct ifconf ifc;
+  gchar buf[8192];
+  GPtrArray *arr;
+  gint fd = g_socket_get_fd (socket_event);
+  guint i;
+
+  ifc.ifc_len = sizeof (buf);
+  ifc.ifc_buf = buf;
+  if (ioctl (fd, SIOCGIFCONF, &ifc) == -1)
+    return NULL;
+
+  arr = g_ptr_array_new ();
+  for (i = 0; i < (guint) ifc.ifc_len / sizeof (struct ifreq); i++) {
+    strncpy (ifr.ifr_name, ifc.ifc_req[i].ifr_name, IFNAMSIZ);
+    if (ioctl (fd, SIOCGIFFLAGS, &ifr) == 0 && (ifr.ifr_flags & IFF_LOOPBACK))
+      continue;
+    g_ptr_array_add (arr, g_strndup (ifc.ifc_req[i].ifr_name, IFNAMSIZ));
+  }
+
+  if (arr->len == 0) {
+    g_ptr_array_free (arr, TRUE);
+    return NULL;
+  }
+  g_ptr_array_add (arr, NULL);
+
+  return (gchar **) g_ptr_array_free (arr, FALSE);
+}
+
+/* the clock id from the MAC address of the first interface that has one,
+ * like gst-ptp-helper does */
+static guint64
+ptp_in_process_get_clock_id (gchar ** ifaces)
+{
+  guint8 clock_id_array[8];
+  struct ifreq ifr;
+  gint fd = g_socket_get_fd (socket_event);
+
+  for (; ifaces && *ifaces; ifaces++) {
+    memset (&ifr, 0, sizeof (ifr));
+    strncpy (ifr.ifr_name, *ifaces, IFNAMSIZ - 1);
+    if (ioctl (fd, SIOCGIFHWADDR, &ifr) == 0) {
+      clock_id_array[0] = ifr.ifr_hwaddr.sa_data[0];
+      clock_id_array[1] = ifr.ifr_hwaddr.sa_data[1];
+      clock_id_array[2] = ifr.ifr_hwaddr.sa_data[2];
+      clock_id_array[3] = 0xff;
+      clock_id_array[4] = 0xfe;
+      clock_id_array[5] = ifr.ifr_hwaddr.sa_data[3];
+      clock_id_array[6] = ifr.ifr_hwaddr.sa_data[4];
+      clock_id_array[7] = ifr.ifr_hwaddr.sa_data[5];
+      return GST_READ_UINT64_BE (clock_id_array);
+    }
+  }
+
+  GST_WARNING ("can't get any MAC address, using random clock id");
+  GST_WRITE_UINT64_BE (clock_id_array,
+      (((guint64) g_random_int ()) << 32) | (g_random_int ()));
+  clock_id_array[3] = 0xff;
+  clock_id_array[4] = 0xfe;
+
+  return GST_READ_UINT64_BE (clock_id_array);
+}
+
+static void
+ptp_in_process_teardown (void)
+{
+  if (socket_event_source) {
+    g_source_destroy (socket_event_source);
+    g_source_unref (socket_event_source);
+    socket_event_source = NULL;
+  }
+  if (socket_general_source) {
+    g_source_destroy (socket_general_source);
+    g_source_unref (socket_general_source);
+    socket_general_source = NULL;
+  }
+  g_clear_object (&socket_event);
+  g_clear_object (&socket_general);
+  g_clear_object (&event_saddr);
+  in_process = FALSE;
+}
+
+/* Must be called with ptp_lock and before the PTP thread is started */
+static gboolean
+ptp_in_process_setup (guint64 clock_id, gchar ** interfaces)
+{
+  gchar **probed_ifaces = NULL;
+  GInetAddress *mcast_addr;
+  GError *err = NULL;
+  gboolean joined = FALSE;
+  gchar **ptr;
+
+  socket_event = ptp_in_process_open_socket (PTP_EVENT_PORT, &err);
+  if (socket_event)
+    socket_general = ptp_in_process_open_socket (PTP_GENERAL_PORT, &err);
+  if (!socket_general) {
+    GST_DEBUG ("Can't open PTP ports in process, using helper: %s",
+        err->message);
+    g_clear_error (&err);
+    ptp_in_process_teardown ();
+    return FALSE;
+  }
+
+  if (!interfaces)
+    interfaces = probed_ifaces = ptp_in_process_probe_interfaces ();
+
+  if (clock_id == GST_PTP_CLOCK_ID_NONE)
+    clock_id = ptp_in_process_get_clock_id (interfaces);
+
+  mcast_addr = g_inet_address_new_from_string (PTP_MULTICAST_GROUP);
+  for (ptr = interfaces; ptr && *ptr; ptr++) {
+    if ((!g_socket_join_multicast_group (socket_event, mcast_addr, FALSE,
+                *ptr, &err)
+            && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE))
+        || (!g_socket_join_multicast_group (socket_general, mcast_addr, FALSE,
+                *ptr, &err)
+            && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE))) {
+      GST_WARNING ("Couldn't join multicast group on interface '%s': %s",
+          *ptr, err->message);
+    } else {
+      joined = TRUE;
+    }
+    g_clear_error (&err);
+  }
+  g_strfreev (probed_ifaces);
+
+  /* Join multicast group without any interface */
+  if (!joined && (!g_socket_join_multicast_group (socket_event, mcast_addr,
+              FALSE, NULL, &err)
+          || !g_socket_join_multicast_group (socket_general, mcast_addr,
+              FALSE, NULL, &err))) {
+    GST_ERROR ("Couldn't join multicast group: %s", err->message);
+    g_clear_error (&err);
+    g_object_unref (mcast_addr);
+    ptp_in_process_teardown ();
+    return FALSE;
+  }
+
+  event_saddr = g_inet_socket_address_new (mcast_addr, PTP_EVENT_PORT);
+  g_object_unref (mcast_addr);
+
+  socket_event_source =
+      g_socket_create_source (socket_event, G_IO_IN | G_IO_PRI, NULL);
+  g_source_set_priority (socket_event_source, G_PRIORITY_HIGH);
+  g_source_set_callback (socket_event_source, (GSourceFunc) have_socket_data_cb,
+      NULL, NULL);
+  g_source_attach (socket_event_source, main_context);
+  socket_general_source =
+      g_socket_create_source (socket_general, G_IO_IN | G_IO_PRI, NULL);
+  g_source_set_priority (socket_general_source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (socket_general_source,
+      (GSourceFunc) have_socket_data_cb, NULL, NULL);
+  g_source_attach (socket_general_source, main_context);
+
+  ptp_clock_id.clock_identity = clock_id;
+  ptp_clock_id.port_number = getpid ();
+  in_process = TRUE;
+
+  GST_DEBUG ("Running PTP in process with clock id 0x%016" G_GINT64_MODIFIER
+      "x %u", ptp_clock_id.clock_identity, ptp_clock_id.port_number);
+
+  return TRUE;
+}
+#endif /* HAVE_PTP_IN_PROCESS */
+
 /* Cleanup all announce messages and announce message senders
  * that are timed out by now, and clean up all pending syncs
  * that are missing their FOLLOW_UP or DELAY_RESP */
@@ -1971,6 +2311,18 @@ ptp_helper_main (gpointer data)
 
   GST_DEBUG ("Starting PTP helper loop");
 
+#ifdef HAVE_PTP_IN_PROCESS
+  /* The receive times are taken by the kernel but the delay_req send time is
+   * taken here, so try to not be preempted by normal threads */
+  if (in_process) {
+    struct sched_param param;
+
+    param.sched_priority = sched_get_priority_min (SCHED_FIFO);
+    if (pthread_setschedparam (pthread_self (), SCHED_FIFO, &param) != 0)
+      GST_DEBUG ("Can't use realtime scheduling for the PTP thread");
+  }
+#endif
+
   /* Check all 5 seconds, if we have to cleanup ANNOUNCE or pending syncs message */
   cleanup_source = g_timeout_source_new_seconds (5);
   g_source_set_priority (cleanup_source, G_PRIORITY_DEFAULT);
@@ -2035,6 +2387,11 @@ gst_ptp_is_initialized (void)
  * If @clock_id is %GST_PTP_CLOCK_ID_NONE, a clock id is automatically
  * generated from the MAC address of the first network interface.
  *
+ * If the PTP ports can be opened by this process, the PTP messages are
+ * received directly on the PTP thread with kernel receive timestamps.
+ * Otherwise, or if the GST_PTP_HELPER environment variable is set, the
+ * gst-ptp-helper process is used for the network access.
+ *
  * This function is automatically called by gst_ptp_clock_new() with default
  * parameters if it wasn't called before.
  *
@@ -2115,6 +2472,18 @@ gst_ptp_init (guint64 clock_id, gchar ** interfaces)
   main_context = g_main_context_new ();
   main_loop = g_main_loop_new (main_context, FALSE);
 
+  delay_req_rand = g_rand_new ();
+  observation_system_clock =
+      g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "ptp-observation-clock",
+      NULL);
+  gst_object_ref_sink (observation_system_clock);
+
+#ifdef HAVE_PTP_IN_PROCESS
+  /* An explicitly selected helper is always used */
+  if (env == NULL || *env == '\0')
+    ptp_in_process_setup (clock_id, interfaces);
+#endif
+
   ptp_helper_thread =
       g_thread_try_new ("ptp-helper-thread", ptp_helper_main, NULL, &err);
   if (!ptp_helper_thread) {
@@ -2124,6 +2493,13 @@ gst_ptp_init (guint64 clock_id, gchar ** interfaces)
     goto done;
   }
 
+#ifdef HAVE_PTP_IN_PROCESS
+  if (in_process) {
+    initted = TRUE;
+    goto wait;
+  }
+#endif
+
   if (!g_spawn_async_with_pipes (NULL, argv, NULL, 0, NULL, NULL,
           &ptp_helper_pid, &fd_w, &fd_r, NULL, &err)) {
     GST_ERROR ("Failed to start ptp helper process: %s", err->message);
@@ -2151,12 +2527,6 @@ gst_ptp_init (guint64 clock_id, gchar ** interfaces)
   g_io_channel_set_close_on_unref (stdout_channel, TRUE);
   g_io_channel_set_buffered (stdout_channel, FALSE);
 
-  delay_req_rand = g_rand_new ();
-  observation_system_clock =
-      g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "ptp-observation-clock",
-      NULL);
-  gst_object_ref_sink (observation_system_clock);
-
   initted = TRUE;
 
 wait:
@@ -2202,6 +2572,9 @@ done:
       g_thread_join (ptp_helper_thread);
     }
     ptp_helper_thread = NULL;
+#ifdef HAVE_PTP_IN_PROCESS
+    ptp_in_process_teardown ();
+#endif
     if (main_loop)
       g_main_loop_unref (main_loop);
     main_loop = NULL;
@@ -2266,6 +2639,9 @@ gst_ptp_deinit (void)
     g_thread_join (tmp);
     g_mutex_lock (&ptp_lock);
   }
+#ifdef HAVE_PTP_IN_PROCESS
+  ptp_in_process_teardown ();
+#endif
   if (main_loop)
     g_main_loop_unref (main_loop);
   main_loop = NULL;
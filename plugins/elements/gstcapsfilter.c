@@ -43,6 +43,7 @@
 #include "../../gst/gst-i18n-lib.h"
 #include "gstcapsfilter.h"
 #include "gstcoreelementselements.h"
+#include "gstelements_private.h"
 
 enum
 {
@@ -109,6 +110,8 @@ static gboolean gst_capsfilter_accept_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps);
 static GstFlowReturn gst_capsfilter_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
+static GstFlowReturn gst_capsfilter_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstFlowReturn gst_capsfilter_prepare_buf (GstBaseTransform * trans,
     GstBuffer * input, GstBuffer ** buf);
 static gboolean gst_capsfilter_sink_event (GstBaseTransform * trans,
@@ -174,6 +177,9 @@ gst_capsfilter_init (GstCapsFilter * filter)
   filter->filter_caps_used = FALSE;
   filter->got_sink_caps = FALSE;
   filter->caps_change_mode = DEFAULT_CAPS_CHANGE_MODE;
+
+  gst_pad_set_chain_list_function (GST_BASE_TRANSFORM_SINK_PAD (trans),
+      GST_DEBUG_FUNCPTR (gst_capsfilter_chain_list));
 }
 
 static void
@@ -376,6 +382,22 @@ gst_capsfilter_transform_ip (GstBaseTransform * base, GstBuffer * buf)
   return GST_FLOW_OK;
 }
 
+/* Once negotiated there is nothing to do per buffer, so forward whole
+ * lists downstream instead of chaining them buffer by buffer */
+static GstFlowReturn
+gst_capsfilter_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (parent);
+  GstCapsFilter *filter = GST_CAPS_FILTER (parent);
+
+  if (!filter->got_sink_caps || filter->pending_events
+      || !gst_base_transform_can_push_list (trans))
+    return gst_pad_chain_list_buffers (pad, parent, list);
+
+  return gst_base_transform_push_list (trans, list);
+}
+
 static void
 gst_capsfilter_push_pending_events (GstCapsFilter * filter, GList * events)
 {
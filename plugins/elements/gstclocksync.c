@@ -57,6 +57,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_clock_sync_debug);
 #define DEFAULT_SYNC                    TRUE
 #define DEFAULT_TS_OFFSET               0
 #define DEFAULT_SYNC_TO_FIRST           FALSE
+#define DEFAULT_TOLERANCE               0
 
 enum
 {
@@ -64,6 +65,8 @@ enum
   PROP_SYNC,
   PROP_TS_OFFSET,
   PROP_SYNC_TO_FIRST,
+  PROP_TOLERANCE,
+  PROP_STATS,
   PROP_LAST
 };
 
@@ -156,6 +159,43 @@ gst_clock_sync_class_init (GstClockSyncClass * klass)
       "Note that mixed use of ts-offset and this property would be racy "
       "if clocksync element is running already.",
       DEFAULT_SYNC_TO_FIRST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstClockSync:tolerance:
+   *
+   * Buffers whose running time is at most this many nanoseconds after the
+   * running time of the last clock wait are pushed without waiting on the
+   * clock again. Such buffers can be pushed up to the tolerance early, in
+   * exchange for one clock wait per window at high packet rates.
+   *
+   * Since: 1.20
+   */
+  properties[PROP_TOLERANCE] =
+      g_param_spec_uint64 ("tolerance", "Tolerance",
+      "Push buffers within this many nanoseconds after the last clock wait "
+      "without waiting again (0 = wait for every buffer)", 0, G_MAXUINT64,
+      DEFAULT_TOLERANCE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstClockSync:stats:
+   *
+   * Synchronisation statistics since the last READY to PAUSED state change.
+   * This property returns a GstStructure named application/x-clocksync-stats
+   * with the following fields:
+   *
+   * - "waits" G_TYPE_UINT64: the number of clock waits
+   * - "skipped" G_TYPE_UINT64: the number of waits skipped because of
+   *   #GstClockSync:tolerance
+   * - "late" G_TYPE_UINT64: the number of waits that were already late
+   * - "max-lateness" G_TYPE_INT64: the largest lateness of a clock wait, in
+   *   nanoseconds
+   *
+   * Since: 1.20
+   */
+  properties[PROP_STATS] =
+      g_param_spec_boxed ("stats", "Statistics",
+      "Synchronisation statistics", GST_TYPE_STRUCTURE,
+      G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
   g_object_class_install_properties (gobject_class, PROP_LAST, properties);
 
   gstelement_class->change_state =
@@ -205,6 +245,8 @@ gst_clock_sync_init (GstClockSync * clocksync)
   clocksync->ts_offset = DEFAULT_TS_OFFSET;
   clocksync->sync = DEFAULT_SYNC;
   clocksync->sync_to_first = DEFAULT_SYNC_TO_FIRST;
+  clocksync->tolerance = DEFAULT_TOLERANCE;
+  clocksync->last_sync_time = GST_CLOCK_TIME_NONE;
   g_cond_init (&clocksync->blocked_cond);
 
   GST_OBJECT_FLAG_SET (clocksync, GST_ELEMENT_FLAG_PROVIDE_CLOCK);
@@ -248,12 +290,45 @@ gst_clock_sync_set_property (GObject * object, guint prop_id,
     case PROP_SYNC_TO_FIRST:
       clocksync->sync_to_first = g_value_get_boolean (value);
       break;
+    case PROP_TOLERANCE:
+      GST_OBJECT_LOCK (clocksync);
+      clocksync->tolerance = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (clocksync);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static GstStructure *
+gst_clock_sync_create_stats (GstClockSync * clocksync)
+{
+  GstStructure *s;
+
+  GST_OBJECT_LOCK (clocksync);
+  s = gst_structure_new ("application/x-clocksync-stats",
+      "waits", G_TYPE_UINT64, clocksync->num_waits,
+      "skipped", G_TYPE_UINT64, clocksync->num_skipped,
+      "late", G_TYPE_UINT64, clocksync->num_late,
+      "max-lateness", G_TYPE_INT64, clocksync->max_lateness, NULL);
+  GST_OBJECT_UNLOCK (clocksync);
+
+  return s;
+}
+
+static void
+gst_clock_sync_reset_stats (GstClockSync * clocksync)
+{
+  GST_OBJECT_LOCK (clocksync);
+  clocksync->last_sync_time = GST_CLOCK_TIME_NONE;
+  clocksync->num_waits = 0;
+  clocksync->num_skipped = 0;
+  clocksync->num_late = 0;
+  clocksync->max_lateness = 0;
+  GST_OBJECT_UNLOCK (clocksync);
+}
+
 static void
 gst_clock_sync_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -270,6 +345,14 @@ gst_clock_sync_get_property (GObject * object, guint prop_id,
     case PROP_SYNC_TO_FIRST:
       g_value_set_boolean (value, clocksync->sync_to_first);
       break;
+    case PROP_TOLERANCE:
+      GST_OBJECT_LOCK (clocksync);
+      g_value_set_uint64 (value, clocksync->tolerance);
+      GST_OBJECT_UNLOCK (clocksync);
+      break;
+    case PROP_STATS:
+      g_value_take_boxed (value, gst_clock_sync_create_stats (clocksync));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -306,6 +389,20 @@ gst_clocksync_do_sync (GstClockSync * clocksync, GstClockTime running_time)
     return GST_FLOW_FLUSHING;
   }
 
+  /* close enough to the last wait, don't wait again */
+  if (clocksync->tolerance > 0
+      && GST_CLOCK_TIME_IS_VALID (clocksync->last_sync_time)
+      && running_time >= clocksync->last_sync_time
+      && running_time - clocksync->last_sync_time <= clocksync->tolerance) {
+    GST_LOG_OBJECT (clocksync, "running time %" GST_TIME_FORMAT
+        " within tolerance of last wait at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (running_time),
+        GST_TIME_ARGS (clocksync->last_sync_time));
+    clocksync->num_skipped++;
+    GST_OBJECT_UNLOCK (clocksync);
+    return GST_FLOW_OK;
+  }
+
   if ((clock = GST_ELEMENT (clocksync)->clock)) {
     GstClockReturn cret;
     GstClockTime timestamp;
@@ -353,8 +450,16 @@ gst_clocksync_do_sync (GstClockSync * clocksync, GstClockTime running_time)
       gst_clock_id_unref (clocksync->clock_id);
       clocksync->clock_id = NULL;
     }
-    if (cret == GST_CLOCK_UNSCHEDULED || clocksync->flushing)
+    if (cret == GST_CLOCK_UNSCHEDULED || clocksync->flushing) {
       ret = GST_FLOW_FLUSHING;
+    } else {
+      clocksync->last_sync_time = running_time;
+      clocksync->num_waits++;
+      if (cret == GST_CLOCK_EARLY) {
+        clocksync->num_late++;
+        clocksync->max_lateness = MAX (clocksync->max_lateness, jitter);
+      }
+    }
   }
   GST_OBJECT_UNLOCK (clocksync);
 
@@ -374,6 +479,9 @@ gst_clock_sync_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_SEGMENT:
       /* store the event for synching */
       gst_event_copy_segment (event, &clocksync->segment);
+      GST_OBJECT_LOCK (clocksync);
+      clocksync->last_sync_time = GST_CLOCK_TIME_NONE;
+      GST_OBJECT_UNLOCK (clocksync);
       break;
     case GST_EVENT_GAP:
     {
@@ -405,6 +513,7 @@ gst_clock_sync_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_OBJECT_LOCK (clocksync);
       clocksync->flushing = FALSE;
       gst_segment_init (&clocksync->segment, GST_FORMAT_UNDEFINED);
+      clocksync->last_sync_time = GST_CLOCK_TIME_NONE;
       GST_OBJECT_UNLOCK (clocksync);
       clocksync->is_first = TRUE;
       break;
@@ -615,6 +724,7 @@ gst_clocksync_change_state (GstElement * element, GstStateChange transition)
       if (clocksync->sync)
         no_preroll = TRUE;
       clocksync->is_first = TRUE;
+      gst_clock_sync_reset_stats (clocksync);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       GST_OBJECT_LOCK (clocksync);
@@ -644,6 +754,8 @@ gst_clocksync_change_state (GstElement * element, GstStateChange transition)
       GST_OBJECT_LOCK (clocksync);
       clocksync->upstream_latency = 0;
       clocksync->blocked = TRUE;
+      /* the base time changes when going back to PLAYING */
+      clocksync->last_sync_time = GST_CLOCK_TIME_NONE;
       GST_OBJECT_UNLOCK (clocksync);
       if (clocksync->sync)
         no_preroll = TRUE;
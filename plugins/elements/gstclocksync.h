@@ -63,6 +63,13 @@ struct _GstClockSync
   gboolean is_first;
 
   GstClockTime   upstream_latency;
+
+  GstClockTime   tolerance;
+  GstClockTime   last_sync_time;
+  guint64        num_waits;
+  guint64        num_skipped;
+  guint64        num_late;
+  GstClockTimeDiff max_lateness;
 };
 
 struct _GstClockSyncClass
@@ -38,6 +38,12 @@
  * another downstream element like a streamsynchronizer adjusts the base
  * values on its own). The adjust-base property can be used for this purpose.
  *
+ * To avoid a gap at every stream switch, the prefetch-buffers property lets
+ * the streams that are not active yet already accept a number of buffers,
+ * and the serialized events that come with them. These are pushed downstream
+ * as soon as that stream becomes active, while upstream of it can already
+ * prepare the following data.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 concat name=c ! xvimagesink  videotestsrc num-buffers=100 ! c.   videotestsrc num-buffers=100 pattern=ball ! c.
@@ -75,6 +81,15 @@ struct _GstConcatPad
 
   /* Protected by the concat lock */
   gboolean flushing;
+
+  /* Buffers and serialized events received before this pad became the
+   * current one, and the number of buffers among them */
+  GQueue prefetched;
+  guint n_prefetched;
+  /* Prefetched items are being pushed downstream */
+  gboolean draining;
+  /* Last flow return of pushing prefetched buffers */
+  GstFlowReturn prefetch_flow;
 };
 
 struct _GstConcatPadClass
@@ -84,9 +99,28 @@ struct _GstConcatPadClass
 
 G_DEFINE_TYPE (GstConcatPad, gst_concat_pad, GST_TYPE_PAD);
 
+static void
+gst_concat_pad_clear_prefetched (GstConcatPad * self)
+{
+  g_queue_foreach (&self->prefetched, (GFunc) gst_mini_object_unref, NULL);
+  g_queue_clear (&self->prefetched);
+  self->n_prefetched = 0;
+}
+
+static void
+gst_concat_pad_finalize (GObject * object)
+{
+  gst_concat_pad_clear_prefetched (GST_CONCAT_PAD_CAST (object));
+
+  G_OBJECT_CLASS (gst_concat_pad_parent_class)->finalize (object);
+}
+
 static void
 gst_concat_pad_class_init (GstConcatPadClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = gst_concat_pad_finalize;
 }
 
 static void
@@ -94,6 +128,10 @@ gst_concat_pad_init (GstConcatPad * self)
 {
   gst_segment_init (&self->segment, GST_FORMAT_UNDEFINED);
   self->flushing = FALSE;
+  g_queue_init (&self->prefetched);
+  self->n_prefetched = 0;
+  self->draining = FALSE;
+  self->prefetch_flow = GST_FLOW_OK;
 }
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink_%u",
@@ -110,10 +148,12 @@ enum
 {
   PROP_0,
   PROP_ACTIVE_PAD,
-  PROP_ADJUST_BASE
+  PROP_ADJUST_BASE,
+  PROP_PREFETCH_BUFFERS
 };
 
 #define DEFAULT_ADJUST_BASE TRUE
+#define DEFAULT_PREFETCH_BUFFERS 0
 
 #define _do_init \
   GST_DEBUG_CATEGORY_INIT (gst_concat_debug, "concat", 0, "concat element");
@@ -146,7 +186,11 @@ static gboolean gst_concat_src_event (GstPad * pad, GstObject * parent,
 static gboolean gst_concat_src_query (GstPad * pad, GstObject * parent,
     GstQuery * query);
 
+static gboolean gst_concat_pad_event (GstConcat * self, GstConcatPad * spad,
+    GstEvent * event, gboolean replay);
+
 static gboolean gst_concat_switch_pad (GstConcat * self);
+static void gst_concat_drain_prefetched (GstConcat * self);
 
 static void gst_concat_notify_active_pad (GstConcat * self);
 
@@ -174,6 +218,21 @@ gst_concat_class_init (GstConcatClass * klass)
           "Adjust the base value of segments to ensure they are adjacent",
           DEFAULT_ADJUST_BASE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstConcat:prefetch-buffers:
+   *
+   * Number of buffers a sink pad accepts while it is waiting to become the
+   * active pad. The serialized events before and between these buffers are
+   * accepted as well. Set to 0 to block the pads until they are active.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_BUFFERS,
+      g_param_spec_uint ("prefetch-buffers", "Prefetch buffers",
+          "Number of buffers to accept on a sink pad before it is active "
+          "(0 = disabled)", 0, G_MAXUINT, DEFAULT_PREFETCH_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Concat", "Generic", "Concatenate multiple streams",
       "Sebastian Dröge <sebastian@centricular.com>");
@@ -203,6 +262,7 @@ gst_concat_init (GstConcat * self)
   gst_element_add_pad (GST_ELEMENT (self), self->srcpad);
 
   self->adjust_base = DEFAULT_ADJUST_BASE;
+  self->prefetch_buffers = DEFAULT_PREFETCH_BUFFERS;
 }
 
 static void
@@ -256,6 +316,12 @@ gst_concat_get_property (GObject * object, guint prop_id, GValue * value,
       g_mutex_unlock (&self->lock);
       break;
     }
+    case PROP_PREFETCH_BUFFERS:{
+      g_mutex_lock (&self->lock);
+      g_value_set_uint (value, self->prefetch_buffers);
+      g_mutex_unlock (&self->lock);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -275,6 +341,12 @@ gst_concat_set_property (GObject * object, guint prop_id, const GValue * value,
       g_mutex_unlock (&self->lock);
       break;
     }
+    case PROP_PREFETCH_BUFFERS:{
+      g_mutex_lock (&self->lock);
+      self->prefetch_buffers = g_value_get_uint (value);
+      g_mutex_unlock (&self->lock);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -345,6 +417,7 @@ gst_concat_release_pad (GstElement * element, GstPad * pad)
 
   g_mutex_lock (&self->lock);
   spad->flushing = TRUE;
+  gst_concat_pad_clear_prefetched (spad);
   g_cond_broadcast (&self->cond);
   g_mutex_unlock (&self->lock);
 
@@ -373,6 +446,9 @@ gst_concat_release_pad (GstElement * element, GstPad * pad)
   if (do_notify)
     gst_concat_notify_active_pad (self);
 
+  if (current_pad_removed && !eos)
+    gst_concat_drain_prefetched (self);
+
   if (GST_STATE (self) > GST_STATE_READY) {
     if (current_pad_removed && !eos)
       gst_element_post_message (GST_ELEMENT_CAST (self),
@@ -397,7 +473,19 @@ gst_concat_pad_wait (GstConcatPad * spad, GstConcat * self)
     return FALSE;
   }
 
-  while (spad != GST_CONCAT_PAD_CAST (self->current_sinkpad)) {
+  /* prefetched data has to go first */
+  while (spad != GST_CONCAT_PAD_CAST (self->current_sinkpad)
+      || spad->draining || spad->prefetched.length > 0) {
+    if (spad == GST_CONCAT_PAD_CAST (self->current_sinkpad)) {
+      GST_TRACE_OBJECT (spad, "Waiting for prefetched data to be pushed");
+      g_cond_wait (&self->cond, &self->lock);
+      if (spad->flushing) {
+        g_mutex_unlock (&self->lock);
+        GST_DEBUG_OBJECT (spad, "Flushing");
+        return FALSE;
+      }
+      continue;
+    }
     GST_TRACE_OBJECT (spad, "Not the current sinkpad - waiting");
     if (self->current_sinkpad == NULL && g_list_length (self->sinkpads) == 1) {
       GST_LOG_OBJECT (spad, "Sole pad waiting, switching");
@@ -425,17 +513,41 @@ gst_concat_pad_wait (GstConcatPad * spad, GstConcat * self)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_concat_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+/* Queues @obj if @spad is not the current sinkpad yet and there is room for
+ * it. Returns FALSE if @obj has to be handled as usual, and then stores the
+ * flow return of the prefetched buffers in @ret. Must be called from the
+ * pad's streaming thread */
+static gboolean
+gst_concat_pad_prefetch (GstConcatPad * spad, GstConcat * self,
+    GstMiniObject * obj, GstFlowReturn * ret)
 {
-  GstFlowReturn ret;
-  GstConcat *self = GST_CONCAT (parent);
-  GstConcatPad *spad = GST_CONCAT_PAD (pad);
+  gboolean queued = FALSE;
 
-  GST_LOG_OBJECT (pad, "received buffer %" GST_PTR_FORMAT, buffer);
+  g_mutex_lock (&self->lock);
+  *ret = spad->prefetch_flow;
+  if (GST_IS_BUFFER (obj))
+    spad->prefetch_flow = GST_FLOW_OK;
+  if (self->prefetch_buffers > 0 && !spad->flushing
+      && self->current_sinkpad != NULL
+      && spad != GST_CONCAT_PAD_CAST (self->current_sinkpad)
+      && spad->n_prefetched < self->prefetch_buffers
+      && *ret == GST_FLOW_OK) {
+    GST_LOG_OBJECT (spad, "prefetching %" GST_PTR_FORMAT, obj);
+    g_queue_push_tail (&spad->prefetched, obj);
+    if (GST_IS_BUFFER (obj))
+      spad->n_prefetched++;
+    queued = TRUE;
+  }
+  g_mutex_unlock (&self->lock);
 
-  if (!gst_concat_pad_wait (spad, self))
-    return GST_FLOW_FLUSHING;
+  return queued;
+}
+
+static GstFlowReturn
+gst_concat_pad_push_buffer (GstConcat * self, GstConcatPad * spad,
+    GstBuffer * buffer)
+{
+  GstFlowReturn ret;
 
   if (self->last_stop == GST_CLOCK_TIME_NONE)
     self->last_stop = spad->segment.start;
@@ -457,12 +569,89 @@ gst_concat_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   ret = gst_pad_push (self->srcpad, buffer);
 
-  GST_LOG_OBJECT (pad, "handled buffer %s, last_stop %" GST_TIME_FORMAT,
+  GST_LOG_OBJECT (spad, "handled buffer %s, last_stop %" GST_TIME_FORMAT,
       gst_flow_get_name (ret), GST_TIME_ARGS (self->last_stop));
 
   return ret;
 }
 
+static GstFlowReturn
+gst_concat_sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstFlowReturn ret;
+  GstConcat *self = GST_CONCAT (parent);
+  GstConcatPad *spad = GST_CONCAT_PAD (pad);
+
+  GST_LOG_OBJECT (pad, "received buffer %" GST_PTR_FORMAT, buffer);
+
+  if (gst_concat_pad_prefetch (spad, self, GST_MINI_OBJECT_CAST (buffer),
+          &ret))
+    return ret;
+
+  if (ret != GST_FLOW_OK) {
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+
+  if (!gst_concat_pad_wait (spad, self)) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_FLUSHING;
+  }
+
+  return gst_concat_pad_push_buffer (self, spad, buffer);
+}
+
+/* Pushes the data prefetched by the new current sinkpad downstream, from
+ * the thread that made it the current sinkpad */
+static void
+gst_concat_drain_prefetched (GstConcat * self)
+{
+  GstConcatPad *spad;
+  GstMiniObject *obj;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  g_mutex_lock (&self->lock);
+  if (!self->current_sinkpad) {
+    g_mutex_unlock (&self->lock);
+    return;
+  }
+  spad = gst_object_ref (GST_CONCAT_PAD_CAST (self->current_sinkpad));
+  if (spad->draining || spad->prefetched.length == 0) {
+    g_mutex_unlock (&self->lock);
+    gst_object_unref (spad);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (spad, "pushing %u prefetched buffers", spad->n_prefetched);
+  spad->draining = TRUE;
+  while (!spad->flushing && (obj = g_queue_pop_head (&spad->prefetched))) {
+    gboolean is_buffer = GST_IS_BUFFER (obj);
+
+    g_mutex_unlock (&self->lock);
+
+    if (is_buffer) {
+      if (ret == GST_FLOW_OK)
+        ret = gst_concat_pad_push_buffer (self, spad, GST_BUFFER_CAST (obj));
+      else
+        gst_mini_object_unref (obj);
+    } else {
+      gst_concat_pad_event (self, spad, GST_EVENT_CAST (obj), TRUE);
+    }
+
+    g_mutex_lock (&self->lock);
+    if (is_buffer && spad->n_prefetched > 0)
+      spad->n_prefetched--;
+    /* report it upstream with the next buffer */
+    if (ret != GST_FLOW_OK && spad->prefetch_flow == GST_FLOW_OK)
+      spad->prefetch_flow = ret;
+  }
+  spad->draining = FALSE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  gst_object_unref (spad);
+}
+
 /* Returns FALSE if no further pad, must be called with concat lock */
 static gboolean
 gst_concat_switch_pad (GstConcat * self)
@@ -518,23 +707,57 @@ gst_concat_notify_active_pad (GstConcat * self)
   g_object_notify_by_pspec ((GObject *) self, pspec_active_pad);
 }
 
+/* Prefetched events are replayed by the thread that made the pad the current
+ * one, which must not wait for the pad to become current */
+static gboolean
+gst_concat_pad_wait_event (GstConcatPad * spad, GstConcat * self,
+    gboolean replay)
+{
+  gboolean ret;
+
+  if (!replay)
+    return gst_concat_pad_wait (spad, self);
+
+  g_mutex_lock (&self->lock);
+  ret = !spad->flushing;
+  g_mutex_unlock (&self->lock);
+
+  return ret;
+}
+
 static gboolean
 gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
   GstConcat *self = GST_CONCAT (parent);
   GstConcatPad *spad = GST_CONCAT_PAD_CAST (pad);
-  gboolean ret = TRUE;
-  gboolean adjust_base;
+  GstFlowReturn flow;
 
   GST_LOG_OBJECT (pad, "received event %" GST_PTR_FORMAT, event);
 
+  if (GST_EVENT_IS_SERIALIZED (event)
+      && GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP
+      && gst_concat_pad_prefetch (spad, self, GST_MINI_OBJECT_CAST (event),
+          &flow))
+    return TRUE;
+
+  return gst_concat_pad_event (self, spad, event, FALSE);
+}
+
+static gboolean
+gst_concat_pad_event (GstConcat * self, GstConcatPad * spad, GstEvent * event,
+    gboolean replay)
+{
+  GstPad *pad = GST_PAD_CAST (spad);
+  gboolean ret = TRUE;
+  gboolean adjust_base;
+
   g_mutex_lock (&self->lock);
   adjust_base = self->adjust_base;
   g_mutex_unlock (&self->lock);
 
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_STREAM_START:{
-      if (!gst_concat_pad_wait (spad, self)) {
+      if (!gst_concat_pad_wait_event (spad, self, replay)) {
         ret = FALSE;
         gst_event_replace (&event, NULL);
       }
@@ -571,7 +794,7 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       g_mutex_unlock (&self->lock);
 
-      if (!gst_concat_pad_wait (spad, self)) {
+      if (!gst_concat_pad_wait_event (spad, self, replay)) {
         ret = FALSE;
       } else {
         GstSegment segment = spad->segment;
@@ -618,7 +841,7 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_EOS:{
       gst_event_replace (&event, NULL);
 
-      if (!gst_concat_pad_wait (spad, self)) {
+      if (!gst_concat_pad_wait_event (spad, self, replay)) {
         ret = FALSE;
       } else {
         gboolean next;
@@ -635,6 +858,7 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
         } else {
           gst_element_post_message (GST_ELEMENT_CAST (self),
               gst_message_new_duration_changed (GST_OBJECT_CAST (self)));
+          gst_concat_drain_prefetched (self);
         }
       }
       break;
@@ -644,6 +868,7 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       g_mutex_lock (&self->lock);
       spad->flushing = TRUE;
+      gst_concat_pad_clear_prefetched (spad);
       g_cond_broadcast (&self->cond);
       forward = (self->current_sinkpad == GST_PAD_CAST (spad));
       if (!forward && g_list_length (self->sinkpads) == 1)
@@ -658,9 +883,10 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gboolean forward;
 
       gst_segment_init (&spad->segment, GST_FORMAT_UNDEFINED);
-      spad->flushing = FALSE;
 
       g_mutex_lock (&self->lock);
+      spad->flushing = FALSE;
+      spad->prefetch_flow = GST_FLOW_OK;
       forward = (self->current_sinkpad == GST_PAD_CAST (spad));
       if (!forward && g_list_length (self->sinkpads) == 1)
         forward = TRUE;
@@ -683,7 +909,8 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     }
     default:{
       /* Wait for other serialized events before forwarding */
-      if (GST_EVENT_IS_SERIALIZED (event) && !gst_concat_pad_wait (spad, self)) {
+      if (GST_EVENT_IS_SERIALIZED (event)
+          && !gst_concat_pad_wait_event (spad, self, replay)) {
         gst_event_replace (&event, NULL);
         ret = FALSE;
       }
@@ -703,7 +930,7 @@ gst_concat_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gst_event_set_running_time_offset (event, offset);
     }
     g_mutex_unlock (&self->lock);
-    ret = gst_pad_event_default (pad, parent, event);
+    ret = gst_pad_event_default (pad, GST_OBJECT_CAST (self), event);
   }
 
   return ret;
@@ -836,6 +1063,7 @@ reset_pad (const GValue * data, gpointer user_data)
 
   gst_segment_init (&spad->segment, GST_FORMAT_UNDEFINED);
   spad->flushing = FALSE;
+  spad->prefetch_flow = GST_FLOW_OK;
 }
 
 static void
@@ -845,6 +1073,7 @@ unblock_pad (const GValue * data, gpointer user_data)
   GstConcatPad *spad = GST_CONCAT_PAD_CAST (pad);
 
   spad->flushing = TRUE;
+  gst_concat_pad_clear_prefetched (spad);
 }
 
 static GstStateChangeReturn
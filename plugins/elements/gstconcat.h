@@ -61,6 +61,7 @@ struct _GstConcat
   guint64 last_stop;
 
   gboolean adjust_base;
+  guint prefetch_buffers;
 };
 
 struct _GstConcatClass
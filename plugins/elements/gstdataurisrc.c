@@ -31,6 +31,11 @@
  * ]|
  *
  * This pipeline displays a small 16x16 PNG image from the data URI.
+ *
+ * A base64 payload that only consists of the base64 alphabet is not decoded
+ * up front but block by block when data is requested, so large payloads
+ * start quickly and seeking doesn't need to decode the data before the
+ * requested offset.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -43,6 +48,10 @@
 #include <string.h>
 #include <gst/base/gsttypefindhelper.h>
 
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
 GST_DEBUG_CATEGORY (data_uri_src_debug);
 #define GST_CAT_DEFAULT (data_uri_src_debug)
 
@@ -51,6 +60,9 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
+/* maps base64 characters to their 6 bit value, 0xff for anything else */
+static guint8 base64_table[256];
+
 enum
 {
   PROP_0,
@@ -89,9 +101,12 @@ GST_ELEMENT_REGISTER_DEFINE (dataurisrc, "dataurisrc", GST_RANK_PRIMARY,
 static void
 gst_data_uri_src_class_init (GstDataURISrcClass * klass)
 {
+  static const gchar alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *element_class = (GstElementClass *) klass;
   GstBaseSrcClass *basesrc_class = (GstBaseSrcClass *) klass;
+  guint i;
 
   gobject_class->finalize = gst_data_uri_src_finalize;
   gobject_class->set_property = gst_data_uri_src_set_property;
@@ -117,6 +132,10 @@ gst_data_uri_src_class_init (GstDataURISrcClass * klass)
   basesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_data_uri_src_is_seekable);
   basesrc_class->create = GST_DEBUG_FUNCPTR (gst_data_uri_src_create);
   basesrc_class->start = GST_DEBUG_FUNCPTR (gst_data_uri_src_start);
+
+  memset (base64_table, 0xff, sizeof (base64_table));
+  for (i = 0; i < 64; i++)
+    base64_table[(guint8) alphabet[i]] = i;
 }
 
 static void
@@ -195,7 +214,10 @@ gst_data_uri_src_get_size (GstBaseSrc * basesrc, guint64 * size)
   gboolean ret;
 
   GST_OBJECT_LOCK (src);
-  if (!src->buffer) {
+  if (src->base64_data) {
+    ret = TRUE;
+    *size = src->size;
+  } else if (!src->buffer) {
     ret = FALSE;
     *size = -1;
   } else {
@@ -213,6 +235,175 @@ gst_data_uri_src_is_seekable (GstBaseSrc * basesrc)
   return TRUE;
 }
 
+/* checks that @data only contains base64 characters with optional padding
+ * and calculates the decoded size. @n_chars is set to the number of
+ * characters without the padding */
+static gboolean
+gst_data_uri_src_base64_get_size (const gchar * data, gsize len,
+    gsize * n_chars, guint64 * size)
+{
+  gsize i, n = len;
+
+  if (n > 0 && data[n - 1] == '=')
+    n--;
+  if (n > 0 && data[n - 1] == '=')
+    n--;
+
+  /* padding only ever completes a group and one character alone can't
+   * encode a byte */
+  if ((n != len && len % 4 != 0) || n % 4 == 1)
+    return FALSE;
+
+  for (i = 0; i < n; i++) {
+    if (base64_table[(guint8) data[i]] == 0xff)
+      return FALSE;
+  }
+
+  *n_chars = n;
+  *size = n / 4 * 3 + (n % 4 ? n % 4 - 1 : 0);
+
+  return TRUE;
+}
+
+/* decodes the group of up to 4 characters at @in, returns the number of
+ * bytes in the group */
+static guint
+gst_data_uri_src_base64_decode_group (const guint8 * in, const guint8 * end,
+    guint8 out[3])
+{
+  guint i, n = MIN (4, end - in);
+  guint32 v = 0;
+
+  for (i = 0; i < 4; i++)
+    v = v << 6 | (i < n ? base64_table[in[i]] : 0);
+
+  out[0] = v >> 16;
+  out[1] = v >> 8;
+  out[2] = v;
+
+  return n < 4 ? n - 1 : 3;
+}
+
+/* decodes @length bytes starting at byte @offset of the already validated
+ * base64 @data of @n_chars characters. Every group of 4 characters encodes
+ * 3 bytes, so the data at @offset can be found without decoding anything
+ * before it */
+static void
+gst_data_uri_src_base64_decode (const gchar * data, gsize n_chars,
+    guint64 offset, gsize length, guint8 * out)
+{
+  const guint8 *in = (const guint8 *) data + offset / 3 * 4;
+  const guint8 *end = (const guint8 *) data + n_chars;
+  guint skip = offset % 3;
+  guint8 tmp[3];
+
+  /* the first bytes might come from the middle of a group */
+  if (skip > 0) {
+    guint n;
+
+    n = gst_data_uri_src_base64_decode_group (in, end, tmp) - skip;
+    n = MIN (n, length);
+    memcpy (out, tmp + skip, n);
+    in += 4;
+    out += n;
+    length -= n;
+  }
+#ifdef __SSSE3__
+  {
+    /* offsets from the characters to their value, indexed by the high
+     * nibble. '/' shares its nibble with '+' and is moved to index 1 */
+    const __m128i shift_lut = _mm_setr_epi8 (0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+        -1, -1, -1, -1);
+
+    /* 16 characters make 12 bytes, the store writes 16 */
+    while (length >= 16 && end - in >= 16) {
+      __m128i v, hi, slash;
+
+      v = _mm_loadu_si128 ((const __m128i *) in);
+      hi = _mm_and_si128 (_mm_srli_epi32 (v, 4), _mm_set1_epi8 (0x0f));
+      slash = _mm_cmpeq_epi8 (v, _mm_set1_epi8 ('/'));
+      v = _mm_add_epi8 (v, _mm_shuffle_epi8 (shift_lut, _mm_add_epi8 (hi,
+                  slash)));
+      v = _mm_maddubs_epi16 (v, _mm_set1_epi32 (0x01400140));
+      v = _mm_madd_epi16 (v, _mm_set1_epi32 (0x00011000));
+      _mm_storeu_si128 ((__m128i *) out, _mm_shuffle_epi8 (v, pack));
+
+      in += 16;
+      out += 12;
+      length -= 12;
+    }
+  }
+#endif
+
+  while (length >= 3 && end - in >= 4) {
+    guint32 v;
+
+    v = (guint32) base64_table[in[0]] << 18 | base64_table[in[1]] << 12 |
+        base64_table[in[2]] << 6 | base64_table[in[3]];
+    out[0] = v >> 16;
+    out[1] = v >> 8;
+    out[2] = v;
+
+    in += 4;
+    out += 3;
+    length -= 3;
+  }
+
+  if (length > 0) {
+    gst_data_uri_src_base64_decode_group (in, end, tmp);
+    memcpy (out, tmp, length);
+  }
+}
+
+/* must be called with the object lock */
+static GstFlowReturn
+gst_data_uri_src_decode_range (GstDataURISrc * src, guint64 offset,
+    guint size, GstBuffer ** buf)
+{
+  GstMapInfo info;
+
+  if (offset >= src->size)
+    return GST_FLOW_EOS;
+  size = MIN (size, src->size - offset);
+
+  if (*buf == NULL)
+    *buf = gst_buffer_new_allocate (NULL, size, NULL);
+  else if (gst_buffer_get_size (*buf) < size)
+    gst_buffer_set_size (*buf, size);
+
+  if (!gst_buffer_map (*buf, &info, GST_MAP_WRITE))
+    return GST_FLOW_ERROR;
+  size = MIN (size, info.size);
+  gst_data_uri_src_base64_decode (src->base64_data, src->base64_len, offset,
+      size, info.data);
+  gst_buffer_unmap (*buf, &info);
+  gst_buffer_set_size (*buf, size);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_data_uri_src_typefind_get_range (GstObject * obj, GstObject * parent,
+    guint64 offset, guint length, GstBuffer ** buffer)
+{
+  GstDataURISrc *src = GST_DATA_URI_SRC (obj);
+  GstFlowReturn ret;
+
+  *buffer = NULL;
+  GST_OBJECT_LOCK (src);
+  ret = gst_data_uri_src_decode_range (src, offset, length, buffer);
+  GST_OBJECT_UNLOCK (src);
+
+  if (ret != GST_FLOW_OK && *buffer) {
+    gst_buffer_unref (*buffer);
+    *buffer = NULL;
+  }
+
+  return ret;
+}
+
 static GstFlowReturn
 gst_data_uri_src_create (GstBaseSrc * basesrc, guint64 offset, guint size,
     GstBuffer ** buf)
@@ -222,6 +413,24 @@ gst_data_uri_src_create (GstBaseSrc * basesrc, guint64 offset, guint size,
 
   GST_OBJECT_LOCK (src);
 
+  if (src->base64_data) {
+    GstBuffer *outbuf = *buf;
+
+    /* GstBaseSrc clips size to the available data, see below */
+    if (offset + size > src->size)
+      ret = GST_FLOW_EOS;
+    else
+      ret = gst_data_uri_src_decode_range (src, offset, size, &outbuf);
+
+    if (ret == GST_FLOW_OK)
+      *buf = outbuf;
+    else if (outbuf != *buf)
+      gst_buffer_unref (outbuf);
+    GST_OBJECT_UNLOCK (src);
+
+    return ret;
+  }
+
   if (!src->buffer)
     goto no_buffer;
 
@@ -268,7 +477,8 @@ gst_data_uri_src_start (GstBaseSrc * basesrc)
 
   GST_OBJECT_LOCK (src);
 
-  if (src->uri == NULL || *src->uri == '\0' || src->buffer == NULL)
+  if (src->uri == NULL || *src->uri == '\0' || (src->buffer == NULL
+          && src->base64_data == NULL))
     goto no_uri;
 
   GST_OBJECT_UNLOCK (src);
@@ -323,11 +533,14 @@ gst_data_uri_src_set_uri (GstURIHandler * handler, const gchar * uri,
   const gchar *data_start;
   const gchar *orig_uri = uri;
   GstCaps *caps;
-  GstBuffer *buffer;
+  GstBuffer *buffer = NULL;
   gboolean base64 = FALSE;
+  gboolean convert;
   gchar *charset = NULL;
   gpointer bdata;
   gsize bsize;
+  gsize n_chars = 0;
+  guint64 size = 0;
 
   GST_OBJECT_LOCK (src);
   if (GST_STATE (src) >= GST_STATE_PAUSED)
@@ -384,6 +597,19 @@ gst_data_uri_src_set_uri (GstURIHandler * handler, const gchar * uri,
 
   /* Skip comma */
   data_start += 1;
+  convert = strcmp ("text/plain", mimetype) == 0 &&
+      charset && g_ascii_strcasecmp ("US-ASCII", charset) != 0
+      && g_ascii_strcasecmp ("UTF-8", charset) != 0;
+
+  /* plain base64 can be decoded from any offset later, everything else is
+   * decoded here */
+  if (base64 && !convert && gst_data_uri_src_base64_get_size (data_start,
+          strlen (data_start), &n_chars, &size)) {
+    GST_DEBUG_OBJECT (src, "decoding %" G_GUINT64_FORMAT " bytes on demand",
+        size);
+    goto done;
+  }
+
   if (base64) {
     bdata = g_base64_decode (data_start, &bsize);
   } else {
@@ -394,9 +620,7 @@ gst_data_uri_src_set_uri (GstURIHandler * handler, const gchar * uri,
     bsize = strlen (bdata);
   }
   /* Convert to UTF8 */
-  if (strcmp ("text/plain", mimetype) == 0 &&
-      charset && g_ascii_strcasecmp ("US-ASCII", charset) != 0
-      && g_ascii_strcasecmp ("UTF-8", charset) != 0) {
+  if (convert) {
     gsize read;
     gsize written;
     gpointer data;
@@ -411,19 +635,35 @@ gst_data_uri_src_set_uri (GstURIHandler * handler, const gchar * uri,
   }
   buffer = gst_buffer_new_wrapped (bdata, bsize);
 
-  caps = gst_type_find_helper_for_buffer (GST_OBJECT (src), buffer, NULL);
-  if (!caps)
-    caps = gst_caps_new_empty_simple (mimetype);
-  gst_base_src_set_caps (GST_BASE_SRC_CAST (src), caps);
-  gst_caps_unref (caps);
-
+done:
   GST_OBJECT_LOCK (src);
   gst_buffer_replace (&src->buffer, buffer);
-  gst_buffer_unref (buffer);
   g_free (src->uri);
   src->uri = g_strdup (orig_uri);
+  if (buffer) {
+    src->base64_data = NULL;
+    src->base64_len = 0;
+    src->size = 0;
+  } else {
+    src->base64_data = src->uri + (data_start - orig_uri);
+    src->base64_len = n_chars;
+    src->size = size;
+  }
   GST_OBJECT_UNLOCK (src);
 
+  /* the typefinders only get the data they look at decoded */
+  if (buffer) {
+    caps = gst_type_find_helper_for_buffer (GST_OBJECT (src), buffer, NULL);
+    gst_buffer_unref (buffer);
+  } else {
+    caps = gst_type_find_helper_get_range (GST_OBJECT (src), NULL,
+        gst_data_uri_src_typefind_get_range, size, NULL, NULL);
+  }
+  if (!caps)
+    caps = gst_caps_new_empty_simple (mimetype);
+  gst_base_src_set_caps (GST_BASE_SRC_CAST (src), caps);
+  gst_caps_unref (caps);
+
   ret = TRUE;
 
 out:
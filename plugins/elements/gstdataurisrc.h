@@ -47,6 +47,11 @@ struct _GstDataURISrc
   /* <private> */
   gchar *uri;
   GstBuffer *buffer;
+
+  /* plain base64 payload, decoded on demand. Points into @uri */
+  const gchar *base64_data;
+  gsize base64_len;
+  guint64 size;
 };
 
 struct _GstDataURISrcClass
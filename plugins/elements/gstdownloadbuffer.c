@@ -101,6 +101,13 @@ enum
 #define DEFAULT_LOW_PERCENT        10
 #define DEFAULT_HIGH_PERCENT       99
 #define DEFAULT_TEMP_REMOVE        TRUE
+#define DEFAULT_RATE_ESTIMATOR     GST_RATE_ESTIMATOR_AVERAGE
+#define DEFAULT_RATE_WINDOW        (2 * GST_SECOND)
+#define DEFAULT_PREFETCH_BYTES     0
+
+/* bounds of the seek threshold */
+#define MIN_SEEK_THRESHOLD         (512 * 1024)
+#define MAX_SEEK_THRESHOLD         (16 * 1024 * 1024)
 
 enum
 {
@@ -112,6 +119,9 @@ enum
   PROP_TEMP_TEMPLATE,
   PROP_TEMP_LOCATION,
   PROP_TEMP_REMOVE,
+  PROP_RATE_ESTIMATOR,
+  PROP_RATE_WINDOW,
+  PROP_PREFETCH_BYTES,
   PROP_LAST
 };
 
@@ -268,6 +278,57 @@ gst_download_buffer_class_init (GstDownloadBufferClass * klass)
           "Remove the temp-location after use",
           DEFAULT_TEMP_REMOVE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDownloadBuffer:rate-estimator
+   *
+   * How to estimate the input data rate that is used for the time level and
+   * the buffering statistics.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RATE_ESTIMATOR,
+      g_param_spec_enum ("rate-estimator", "Rate estimator",
+          "How to estimate the input data rate",
+          GST_TYPE_RATE_ESTIMATOR_MODE, DEFAULT_RATE_ESTIMATOR,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDownloadBuffer:rate-window
+   *
+   * The half-life of the `ewma` and the length of the window of the
+   * `percentile` #GstDownloadBuffer:rate-estimator.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_RATE_WINDOW,
+      g_param_spec_uint64 ("rate-window", "Rate window (ns)",
+          "Half-life or window length of the input rate estimator",
+          0, G_MAXUINT64, DEFAULT_RATE_WINDOW,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDownloadBuffer:prefetch-bytes
+   *
+   * When a read far away from the downloaded data makes the element seek,
+   * the download that was in progress is remembered. After this many bytes
+   * were downloaded at the new position, and as long as the reader is not
+   * close to catching up with them, the interrupted download is resumed.
+   * This matches demuxers that read an index before returning to the data
+   * they were reading. 0 disables resuming.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PREFETCH_BYTES,
+      g_param_spec_uint64 ("prefetch-bytes", "Prefetch bytes",
+          "Bytes to download after a seek before resuming the interrupted "
+          "download (0 = disable)", 0, G_MAXUINT64, DEFAULT_PREFETCH_BYTES,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  gst_type_mark_as_plugin_api (GST_TYPE_RATE_ESTIMATOR_MODE, 0);
+
   /* set several parent class virtual functions */
   gobject_class->finalize = gst_download_buffer_finalize;
 
@@ -324,6 +385,12 @@ gst_download_buffer_init (GstDownloadBuffer * dlbuf)
   dlbuf->sinkresult = GST_FLOW_FLUSHING;
   dlbuf->in_timer = g_timer_new ();
   dlbuf->out_timer = g_timer_new ();
+  gst_rate_estimator_init (&dlbuf->in_estimator, DEFAULT_RATE_ESTIMATOR,
+      DEFAULT_RATE_WINDOW);
+  dlbuf->seek_time = GST_CLOCK_TIME_NONE;
+  dlbuf->seek_latency = GST_CLOCK_TIME_NONE;
+  dlbuf->prefetch_bytes = DEFAULT_PREFETCH_BYTES;
+  dlbuf->prefetch_pos = -1;
 
   g_mutex_init (&dlbuf->qlock);
   dlbuf->waiting_add = FALSE;
@@ -362,6 +429,9 @@ reset_positions (GstDownloadBuffer * dlbuf)
   dlbuf->buffering_percent = 0;
   dlbuf->is_buffering = TRUE;
   dlbuf->seeking = FALSE;
+  dlbuf->seek_time = GST_CLOCK_TIME_NONE;
+  dlbuf->prefetch_pos = -1;
+  dlbuf->seek_bytes = 0;
   GST_DOWNLOAD_BUFFER_CLEAR_LEVEL (dlbuf->cur_level);
 }
 
@@ -371,7 +441,7 @@ reset_rate_timer (GstDownloadBuffer * dlbuf)
   dlbuf->bytes_in = 0;
   dlbuf->bytes_out = 0;
   dlbuf->byte_in_rate = 0.0;
-  dlbuf->byte_in_period = 0;
+  gst_rate_estimator_reset (&dlbuf->in_estimator);
   dlbuf->byte_out_rate = 0.0;
   dlbuf->last_in_elapsed = 0.0;
   dlbuf->last_out_elapsed = 0.0;
@@ -381,14 +451,11 @@ reset_rate_timer (GstDownloadBuffer * dlbuf)
 
 /* the interval in seconds to recalculate the rate */
 #define RATE_INTERVAL    0.2
-/* Tuning for rate estimation. We use a large window for the input rate because
- * it should be stable when connected to a network. The output rate is less
- * stable (the elements preroll, queues behind a demuxer fill, ...) and should
- * therefore adapt more quickly.
- * However, initial input rate may be subject to a burst, and should therefore
- * initially also adapt more quickly to changes, and only later on give higher
- * weight to previous values. */
-#define AVG_IN(avg,val,w1,w2)  ((avg) * (w1) + (val) * (w2)) / ((w1) + (w2))
+/* Tuning for rate estimation. The input rate is estimated with the configured
+ * #GstRateEstimatorMode, by default with a large window because it should be
+ * stable when connected to a network. The output rate is less stable (the
+ * elements preroll, queues behind a demuxer fill, ...) and should therefore
+ * adapt more quickly. */
 #define AVG_OUT(avg,val) ((avg) * 3.0 + (val)) / 4.0
 
 static void
@@ -411,7 +478,6 @@ static void
 update_in_rates (GstDownloadBuffer * dlbuf)
 {
   gdouble elapsed, period;
-  gdouble byte_in_rate;
 
   if (!dlbuf->in_timer_started) {
     dlbuf->in_timer_started = TRUE;
@@ -426,20 +492,10 @@ update_in_rates (GstDownloadBuffer * dlbuf)
     period = elapsed - dlbuf->last_in_elapsed;
 
     GST_DEBUG_OBJECT (dlbuf,
-        "rates: period %f, in %" G_GUINT64_FORMAT ", global period %f",
-        period, dlbuf->bytes_in, dlbuf->byte_in_period);
-
-    byte_in_rate = dlbuf->bytes_in / period;
+        "rates: period %f, in %" G_GUINT64_FORMAT, period, dlbuf->bytes_in);
 
-    if (dlbuf->byte_in_rate == 0.0)
-      dlbuf->byte_in_rate = byte_in_rate;
-    else
-      dlbuf->byte_in_rate = AVG_IN (dlbuf->byte_in_rate, byte_in_rate,
-          (double) dlbuf->byte_in_period, period);
-
-    /* another data point, cap at 16 for long time running average */
-    if (dlbuf->byte_in_period < 16 * RATE_INTERVAL)
-      dlbuf->byte_in_period += period;
+    dlbuf->byte_in_rate = gst_rate_estimator_update (&dlbuf->in_estimator,
+        dlbuf->bytes_in, period);
 
     /* reset the values to calculate rate over the next interval */
     dlbuf->last_in_elapsed = elapsed;
@@ -550,15 +606,18 @@ get_buffering_stats (GstDownloadBuffer * dlbuf, gint percent,
     *avg_out = dlbuf->byte_out_rate;
 
   if (buffering_left) {
-    guint64 max, cur;
+    guint64 target, cur;
 
     *buffering_left = (percent == 100 ? 0 : -1);
 
-    max = dlbuf->max_level.time;
+    /* the time until the level reaches the high percent at the estimated
+     * input rate */
+    target = gst_util_uint64_scale (dlbuf->max_level.time,
+        dlbuf->high_percent, 100);
     cur = dlbuf->cur_level.time;
 
-    if (percent != 100 && max > cur)
-      *buffering_left = (max - cur) / 1000000;
+    if (percent != 100 && target > cur)
+      *buffering_left = (target - cur) / GST_MSECOND;
   }
 }
 
@@ -623,6 +682,8 @@ perform_seek_to_offset (GstDownloadBuffer * dlbuf, guint64 offset)
   dlbuf->seeking = TRUE;
   dlbuf->write_pos = offset;
   dlbuf->filling = FALSE;
+  dlbuf->seek_time = gst_util_get_timestamp ();
+  dlbuf->seek_bytes = 0;
   GST_DOWNLOAD_BUFFER_MUTEX_UNLOCK (dlbuf);
 
   GST_DEBUG_OBJECT (dlbuf, "Seeking to %" G_GUINT64_FORMAT, offset);
@@ -642,14 +703,68 @@ perform_seek_to_offset (GstDownloadBuffer * dlbuf, guint64 offset)
 static guint64
 get_seek_threshold (GstDownloadBuffer * dlbuf)
 {
-  guint64 threshold;
+  guint64 threshold = MIN_SEEK_THRESHOLD;
 
-  /* FIXME, find a good threshold based on the incoming rate. */
-  threshold = 1024 * 512;
+  /* rereading is cheaper than seeking for as much data as arrives while
+   * waiting for the first byte after a seek */
+  if (dlbuf->byte_in_rate > 0.0
+      && GST_CLOCK_TIME_IS_VALID (dlbuf->seek_latency)) {
+    gdouble bytes;
+
+    bytes = dlbuf->byte_in_rate * dlbuf->seek_latency / GST_SECOND;
+    threshold = CLAMP (bytes, MIN_SEEK_THRESHOLD, MAX_SEEK_THRESHOLD);
+  }
 
   return threshold;
 }
 
+/* check if enough was downloaded since the last seek to resume the
+ * interrupted download */
+static gboolean
+prefetch_is_due (GstDownloadBuffer * dlbuf)
+{
+  if (dlbuf->prefetch_pos == -1 || dlbuf->prefetch_bytes == 0)
+    return FALSE;
+
+  if (dlbuf->seek_bytes < dlbuf->prefetch_bytes)
+    return FALSE;
+
+  /* the reader is still consuming this range and would catch up */
+  if (dlbuf->read_pos <= dlbuf->write_pos &&
+      dlbuf->write_pos - dlbuf->read_pos < dlbuf->prefetch_bytes)
+    return FALSE;
+
+  return TRUE;
+}
+
+/* resume the interrupted download, @stop is the end of the range that was
+ * written to last. Returns %TRUE when a seek was done. */
+static gboolean
+seek_to_prefetch (GstDownloadBuffer * dlbuf, guint64 stop)
+{
+  guint64 offset = dlbuf->prefetch_pos;
+  gsize start, end;
+
+  if (offset == -1)
+    return FALSE;
+
+  dlbuf->prefetch_pos = -1;
+
+  /* skip what was downloaded there in the meantime */
+  if (gst_sparse_file_get_range_before (dlbuf->file, offset, &start, &end) &&
+      offset < end)
+    offset = end;
+
+  if (offset == stop || (dlbuf->upstream_size
+          && offset >= dlbuf->upstream_size))
+    return FALSE;
+
+  GST_DEBUG_OBJECT (dlbuf, "resuming download at %" G_GUINT64_FORMAT, offset);
+  perform_seek_to_offset (dlbuf, offset);
+
+  return TRUE;
+}
+
 /* called with DOWNLOAD_BUFFER_MUTEX */
 static void
 gst_download_buffer_update_upstream_size (GstDownloadBuffer * dlbuf)
@@ -706,6 +821,12 @@ gst_download_buffer_wait_for_data (GstDownloadBuffer * dlbuf, guint64 offset,
   }
 
   if (dlbuf->write_pos != offset) {
+    /* remember the download we interrupt, it is likely that the reader
+     * comes back to it */
+    if (dlbuf->prefetch_bytes > 0 && !dlbuf->seeking &&
+        (!dlbuf->upstream_size || dlbuf->write_pos < dlbuf->upstream_size))
+      dlbuf->prefetch_pos = dlbuf->write_pos;
+
     perform_seek_to_offset (dlbuf, offset);
 
     /* perform_seek_to_offset() releases the lock, so we may have been flushed
@@ -1170,6 +1291,20 @@ gst_download_buffer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (dlbuf->seeking)
     goto out_seeking;
 
+  /* the first data after a seek, update the average seek latency */
+  if (GST_CLOCK_TIME_IS_VALID (dlbuf->seek_time)) {
+    GstClockTime latency = gst_util_get_timestamp () - dlbuf->seek_time;
+
+    if (GST_CLOCK_TIME_IS_VALID (dlbuf->seek_latency))
+      dlbuf->seek_latency = (3 * dlbuf->seek_latency + latency) / 4;
+    else
+      dlbuf->seek_latency = latency;
+    dlbuf->seek_time = GST_CLOCK_TIME_NONE;
+
+    GST_DEBUG_OBJECT (dlbuf, "seek latency %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (dlbuf->seek_latency));
+  }
+
   /* put buffer in dlbuf now */
   offset = dlbuf->write_pos;
 
@@ -1198,6 +1333,7 @@ gst_download_buffer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   dlbuf->write_pos = offset + info.size;
   dlbuf->bytes_in += info.size;
+  dlbuf->seek_bytes += info.size;
 
   GST_DOWNLOAD_BUFFER_SIGNAL_ADD (dlbuf, dlbuf->write_pos + available);
 
@@ -1205,8 +1341,10 @@ gst_download_buffer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (dlbuf->write_pos + available == dlbuf->upstream_size) {
     gsize start, stop;
 
-    /* we have everything up to the end, find a region to fill */
-    if (gst_sparse_file_get_range_after (dlbuf->file, 0, &start, &stop)) {
+    /* we have everything up to the end, continue the interrupted download
+     * or find a region to fill */
+    if (!seek_to_prefetch (dlbuf, dlbuf->upstream_size) &&
+        gst_sparse_file_get_range_after (dlbuf->file, 0, &start, &stop)) {
       if (stop < dlbuf->upstream_size) {
         /* a hole to fill, seek to its end */
         perform_seek_to_offset (dlbuf, stop);
@@ -1224,6 +1362,8 @@ gst_download_buffer_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     if (available > threshold) {
       /* further than threshold, it's better to skip than to reread */
       perform_seek_to_offset (dlbuf, dlbuf->write_pos + available);
+    } else if (prefetch_is_due (dlbuf)) {
+      seek_to_prefetch (dlbuf, dlbuf->write_pos + available);
     }
   }
   if (dlbuf->filling) {
@@ -1922,6 +2062,16 @@ gst_download_buffer_set_property (GObject * object,
     case PROP_TEMP_REMOVE:
       dlbuf->temp_remove = g_value_get_boolean (value);
       break;
+    case PROP_RATE_ESTIMATOR:
+      gst_rate_estimator_init (&dlbuf->in_estimator, g_value_get_enum (value),
+          dlbuf->in_estimator.window);
+      break;
+    case PROP_RATE_WINDOW:
+      dlbuf->in_estimator.window = g_value_get_uint64 (value);
+      break;
+    case PROP_PREFETCH_BYTES:
+      dlbuf->prefetch_bytes = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1964,6 +2114,15 @@ gst_download_buffer_get_property (GObject * object,
     case PROP_TEMP_REMOVE:
       g_value_set_boolean (value, dlbuf->temp_remove);
       break;
+    case PROP_RATE_ESTIMATOR:
+      g_value_set_enum (value, dlbuf->in_estimator.mode);
+      break;
+    case PROP_RATE_WINDOW:
+      g_value_set_uint64 (value, dlbuf->in_estimator.window);
+      break;
+    case PROP_PREFETCH_BYTES:
+      g_value_set_uint64 (value, dlbuf->prefetch_bytes);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -25,6 +25,7 @@
 #include <stdio.h>
 
 #include "gstsparsefile.h"
+#include "gstelements_private.h"
 
 G_BEGIN_DECLS
 
@@ -89,7 +90,7 @@ struct _GstDownloadBuffer
   gdouble last_in_elapsed;
   guint64 bytes_in;
   gdouble byte_in_rate;
-  gdouble byte_in_period;
+  GstRateEstimator in_estimator;
 
   GTimer *out_timer;
   gboolean out_timer_started;
@@ -110,6 +111,15 @@ struct _GstDownloadBuffer
   gint temp_fd;
   gboolean seeking;
 
+  /* seek latency, to decide between seeking and rereading */
+  GstClockTime seek_time;
+  GstClockTime seek_latency;
+
+  /* read-ahead interrupted by a seek, resumed after prefetch_bytes */
+  guint64 prefetch_bytes;
+  guint64 prefetch_pos;
+  guint64 seek_bytes;
+
   GstEvent *stream_start_event;
   GstEvent *segment_event;
 };
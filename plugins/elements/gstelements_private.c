@@ -32,12 +32,21 @@
 #ifdef HAVE_SYS_UIO_H
 #include <sys/uio.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
 #include <sys/types.h>
 #include <errno.h>
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <string.h>
 #include "gst/gst.h"
 #include "gstelements_private.h"
+#include "gstqueue.h"
 
 #ifdef G_OS_WIN32
 #  include <io.h>               /* lseek, open, close, read */
@@ -356,40 +365,34 @@ gst_writev_buffer (GstObject * sink, gint fd, GstPoll * fdset,
     gboolean * flushing)
 {
   GstFlowReturn flow_ret = GST_FLOW_OK;
-  struct iovec *vecs;
-  GstMapInfo *maps;
-  guint i, num_mem, num_vecs;
+  GstBufferMapVec vec;
+  struct iovec *vecs, *vecs_start;
+  guint i, num_vecs;
   gsize left = 0;
 
-  /* Buffers can contain up to 16 memories, so we can safely directly call
-   * writev() here without splitting up */
-  g_assert (gst_buffer_get_max_memory () <= GST_IOV_MAX);
-
-  num_mem = num_vecs = gst_buffer_n_memory (buffer);
-
   GST_DEBUG ("Writing buffer %p with %u memories and %" G_GSIZE_FORMAT " bytes",
-      buffer, num_mem, gst_buffer_get_size (buffer));
-
-  vecs = g_newa (struct iovec, num_mem);
-  maps = g_newa (GstMapInfo, num_mem);
+      buffer, gst_buffer_n_memory (buffer), gst_buffer_get_size (buffer));
 
   /* Map all memories */
-  {
-    GstMemory *mem;
-    guint i;
-
-    for (i = 0; i < num_mem; ++i) {
-      mem = gst_buffer_peek_memory (buffer, i);
-      if (gst_memory_map (mem, &maps[i], GST_MAP_READ)) {
-        vecs[i].iov_base = maps[i].data;
-        vecs[i].iov_len = maps[i].size;
-      } else {
-        GST_WARNING ("Failed to map memory %p for reading", mem);
-        vecs[i].iov_base = (void *) "";
-        vecs[i].iov_len = 0;
-      }
-      left += vecs[i].iov_len;
-    }
+  if (!gst_buffer_map_vectored (buffer, &vec, GST_MAP_READ)) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, READ, (NULL),
+        ("Failed to map buffer %p for reading", buffer));
+    return GST_FLOW_ERROR;
+  }
+  num_vecs = vec.n_maps;
+
+  /* Buffers usually hold only a few memories, but can have any number of
+   * them. gst_writev() takes care of more than GST_IOV_MAX vectors. */
+  if (num_vecs <= GST_IOV_MAX)
+    vecs = g_newa (struct iovec, num_vecs);
+  else
+    vecs = g_new (struct iovec, num_vecs);
+  vecs_start = vecs;
+
+  for (i = 0; i < num_vecs; ++i) {
+    vecs[i].iov_base = vec.maps[i].data;
+    vecs[i].iov_len = vec.maps[i].size;
+    left += vecs[i].iov_len;
   }
 
   do {
@@ -431,8 +434,9 @@ gst_writev_buffer (GstObject * sink, gint fd, GstPoll * fdset,
     }
   } while (left > 0);
 
-  for (i = 0; i < num_mem; i++)
-    gst_memory_unmap (maps[i].memory, &maps[i]);
+  if (vec.n_maps > GST_IOV_MAX)
+    g_free (vecs_start);
+  gst_buffer_unmap_vectored (buffer, &vec);
 
   return flow_ret;
 }
@@ -637,3 +641,820 @@ gst_writev_buffer_list (GstObject * sink, gint fd, GstPoll * fdset,
 
   return flow_ret;
 }
+
+/* A file descriptor shared by all the read-only memories that are a view
+ * of a regular file */
+struct _GstFileBacking
+{
+  gint refcount;
+  gint fd;
+};
+
+static GQuark
+gst_file_backing_quark (void)
+{
+  static GQuark quark = 0;
+
+  if (!quark)
+    quark = g_quark_from_static_string ("GstFileBacking");
+  return quark;
+}
+
+/* Takes a duplicate of @fd, so that memories can outlive the element that
+ * created them. Returns NULL if @fd can't be duplicated. */
+GstFileBacking *
+gst_file_backing_new (gint fd)
+{
+  GstFileBacking *backing;
+  gint new_fd;
+
+  new_fd = dup (fd);
+  if (new_fd < 0)
+    return NULL;
+
+  backing = g_slice_new (GstFileBacking);
+  backing->refcount = 1;
+  backing->fd = new_fd;
+
+  return backing;
+}
+
+GstFileBacking *
+gst_file_backing_ref (GstFileBacking * backing)
+{
+  g_atomic_int_inc (&backing->refcount);
+  return backing;
+}
+
+void
+gst_file_backing_unref (GstFileBacking * backing)
+{
+  if (g_atomic_int_dec_and_test (&backing->refcount)) {
+    close (backing->fd);
+    g_slice_free (GstFileBacking, backing);
+  }
+}
+
+/* Marks @mem as a read-only view of the file of @backing where the start of
+ * the memory block, at offset 0, is the start of the file */
+void
+gst_memory_set_file_backing (GstMemory * mem, GstFileBacking * backing)
+{
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (mem),
+      gst_file_backing_quark (), gst_file_backing_ref (backing),
+      (GDestroyNotify) gst_file_backing_unref);
+}
+
+/* Get the file descriptor and the file offset of the data of @mem if it is
+ * an unmodified view of a file. Memories shared from such a memory point
+ * into the same block and are file backed too. */
+gboolean
+gst_memory_get_file_range (GstMemory * mem, gint * fd, guint64 * offset)
+{
+  GstMemory *cur;
+
+  if ((*fd = gst_file_memory_get_fd (mem, offset)) >= 0)
+    return TRUE;
+
+  if (!GST_MEMORY_IS_READONLY (mem))
+    return FALSE;
+
+  for (cur = mem; cur; cur = cur->parent) {
+    GstFileBacking *backing;
+
+    if (cur->allocator != mem->allocator)
+      return FALSE;
+
+    backing = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (cur),
+        gst_file_backing_quark ());
+    if (backing) {
+      *fd = backing->fd;
+      *offset = mem->offset;
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+#ifdef HAVE_SYS_SENDFILE_H
+/* Write @size bytes at @offset from the file @in_fd to @fd with sendfile().
+ * Returns GST_FLOW_NOT_SUPPORTED, without posting an error, if the kernel
+ * doesn't support sendfile() for these file descriptors and nothing was
+ * written yet so that the caller can fall back to writing the data. */
+GstFlowReturn
+gst_sendfile_range (GstObject * sink, gint fd, GstPoll * fdset, gint in_fd,
+    guint64 offset, gsize size, guint64 * bytes_written)
+{
+  GstFlowReturn flow_ret = GST_FLOW_OK;
+  off_t file_offset = offset;
+  gsize left = size;
+
+  *bytes_written = 0;
+
+  while (left > 0) {
+    gssize ret;
+
+    if (fdset != NULL) {
+      do {
+        ret = gst_poll_wait (fdset, GST_CLOCK_TIME_NONE);
+      } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+
+      if (ret == -1) {
+        if (errno == EBUSY)
+          goto stopped;
+        else
+          goto select_error;
+      }
+    }
+
+    ret = sendfile (fd, in_fd, &file_offset, left);
+    if (ret > 0) {
+      left -= ret;
+      *bytes_written += ret;
+      continue;
+    }
+
+    if (ret == 0) {
+      /* the file was truncated */
+      errno = EIO;
+      goto write_error;
+    } else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      continue;
+    } else if ((errno == EINVAL || errno == ENOSYS) && *bytes_written == 0) {
+      GST_DEBUG_OBJECT (sink, "sendfile not supported: %s", g_strerror (errno));
+      return GST_FLOW_NOT_SUPPORTED;
+    } else {
+      goto write_error;
+    }
+  }
+
+  return flow_ret;
+
+  /* ERRORS */
+select_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, READ, (NULL),
+        ("select on file descriptor: %s", g_strerror (errno)));
+    return GST_FLOW_ERROR;
+  }
+stopped:
+  {
+    GST_DEBUG_OBJECT (sink, "Select stopped");
+    return GST_FLOW_FLUSHING;
+  }
+write_error:
+  {
+    switch (errno) {
+      case ENOSPC:
+        GST_ELEMENT_ERROR (sink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
+        break;
+      default:
+        GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+            ("Error while sending file to file descriptor %d: %s",
+                fd, g_strerror (errno)));
+        break;
+    }
+    return GST_FLOW_ERROR;
+  }
+}
+#endif
+
+#ifdef HAVE_SYS_SOCKET_H
+/* Header sent in front of the file descriptors of every buffer passed with
+ * gst_fd_passing_send_buffer(). Both sides run the same build, so the
+ * layout is native and only checked with a magic value. */
+#define FD_PASSING_MAGIC 0x47534446     /* GSDF */
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_CMSG_CLOEXEC
+#define MSG_CMSG_CLOEXEC 0
+#endif
+
+typedef struct
+{
+  guint64 maxsize;
+  guint64 offset;
+  guint64 size;
+} FdPassingMemory;
+
+typedef struct
+{
+  guint32 magic;
+  guint32 n_memories;
+  guint64 pts;
+  guint64 dts;
+  guint64 duration;
+  guint64 offset;
+  guint64 offset_end;
+  guint32 flags;
+  guint32 padding;
+  FdPassingMemory memories[GST_FD_PASSING_MAX_FDS];
+} FdPassingHeader;
+
+static gboolean
+fd_passing_wait (GstPoll * fdset, gboolean * stopped)
+{
+  gint ret;
+
+  *stopped = FALSE;
+  if (fdset == NULL)
+    return TRUE;
+
+  do {
+    ret = gst_poll_wait (fdset, GST_CLOCK_TIME_NONE);
+  } while (ret == -1 && (errno == EINTR || errno == EAGAIN));
+
+  if (ret == -1) {
+    *stopped = (errno == EBUSY);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Copy @n_mems memories of @buffer starting at @idx into one new block of
+ * shared memory, for memory that has no fd */
+static GstMemory *
+fd_passing_copy_to_shm (GstAllocator * shm, GstBuffer * buffer, guint idx,
+    guint n_mems)
+{
+  GstMemory *copy;
+  GstMapInfo dst, src;
+  gsize size = 0;
+  guint i;
+
+  for (i = 0; i < n_mems; i++)
+    size += gst_memory_get_sizes (gst_buffer_peek_memory (buffer, idx + i),
+        NULL, NULL);
+
+  copy = gst_allocator_alloc (shm, MAX (size, 1), NULL);
+  if (copy == NULL)
+    return NULL;
+  gst_memory_resize (copy, 0, size);
+
+  if (!gst_memory_map (copy, &dst, GST_MAP_WRITE))
+    goto map_failed;
+
+  size = 0;
+  for (i = 0; i < n_mems; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, idx + i);
+
+    if (!gst_memory_map (mem, &src, GST_MAP_READ)) {
+      gst_memory_unmap (copy, &dst);
+      goto map_failed;
+    }
+    memcpy (dst.data + size, src.data, src.size);
+    size += src.size;
+    gst_memory_unmap (mem, &src);
+  }
+  gst_memory_unmap (copy, &dst);
+
+  return copy;
+
+map_failed:
+  gst_memory_unref (copy);
+  return NULL;
+}
+
+/* Send @buffer over the Unix socket @fd, passing the file descriptors of its
+ * shared memory with SCM_RIGHTS instead of the data. Memory that is not
+ * shared memory, or the tail of a buffer with more than
+ * GST_FD_PASSING_MAX_FDS memories, is copied into new shared memory first.
+ * The sender must not modify the memory after it was sent. */
+GstFlowReturn
+gst_fd_passing_send_buffer (GstObject * sink, gint fd, GstPoll * fdset,
+    GstBuffer * buffer)
+{
+  FdPassingHeader header = { 0, };
+  GstMemory *mems[GST_FD_PASSING_MAX_FDS];
+  gint fds[GST_FD_PASSING_MAX_FDS];
+  union
+  {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE (sizeof (fds))];
+  } control;
+  GstAllocator *shm;
+  GstFlowReturn flow_ret = GST_FLOW_OK;
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  guint i, n_mem, n_fds = 0;
+  gsize left;
+  gboolean stopped;
+  gssize ret;
+
+  shm = gst_allocator_find (GST_ALLOCATOR_SHM);
+  if (shm == NULL)
+    goto no_shm;
+
+  n_mem = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+    gsize offset, maxsize, size;
+
+    if (gst_shm_memory_get_fd (mem) >= 0 &&
+        (n_fds < GST_FD_PASSING_MAX_FDS - 1 || i == n_mem - 1)) {
+      mem = gst_memory_ref (mem);
+    } else {
+      guint n_copy = 1;
+
+      /* the last fd carries all remaining memory */
+      if (n_fds == GST_FD_PASSING_MAX_FDS - 1)
+        n_copy = n_mem - i;
+
+      GST_LOG_OBJECT (sink, "copying %u memories into shared memory", n_copy);
+      mem = fd_passing_copy_to_shm (shm, buffer, i, n_copy);
+      if (mem == NULL)
+        goto copy_failed;
+      i += n_copy - 1;
+    }
+
+    size = gst_memory_get_sizes (mem, &offset, &maxsize);
+    header.memories[n_fds].maxsize = maxsize;
+    header.memories[n_fds].offset = offset;
+    header.memories[n_fds].size = size;
+    fds[n_fds] = gst_shm_memory_get_fd (mem);
+    mems[n_fds++] = mem;
+  }
+
+  header.magic = FD_PASSING_MAGIC;
+  header.n_memories = n_fds;
+  header.pts = GST_BUFFER_PTS (buffer);
+  header.dts = GST_BUFFER_DTS (buffer);
+  header.duration = GST_BUFFER_DURATION (buffer);
+  header.offset = GST_BUFFER_OFFSET (buffer);
+  header.offset_end = GST_BUFFER_OFFSET_END (buffer);
+  header.flags = GST_BUFFER_FLAGS (buffer);
+
+  iov.iov_base = &header;
+  iov.iov_len = sizeof (header);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (n_fds > 0) {
+    memset (&control, 0, sizeof (control));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = CMSG_SPACE (n_fds * sizeof (gint));
+    cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (n_fds * sizeof (gint));
+    memcpy (CMSG_DATA (cmsg), fds, n_fds * sizeof (gint));
+  }
+
+  /* the fds are attached to the first byte, a short write finishes the
+   * header without them */
+  do {
+    if (!fd_passing_wait (fdset, &stopped))
+      goto select_error;
+
+    ret = sendmsg (fd, &msg, MSG_NOSIGNAL);
+  } while (ret < 0 && (errno == EINTR || errno == EAGAIN
+          || errno == EWOULDBLOCK));
+
+  if (ret < 0)
+    goto write_error;
+
+  left = sizeof (header) - ret;
+  while (left > 0) {
+    if (!fd_passing_wait (fdset, &stopped))
+      goto select_error;
+
+    ret = write (fd, (guint8 *) & header + sizeof (header) - left, left);
+    if (ret > 0)
+      left -= ret;
+    else if (ret == 0 || (errno != EINTR && errno != EAGAIN
+            && errno != EWOULDBLOCK))
+      goto write_error;
+  }
+
+done:
+  for (i = 0; i < n_fds; i++)
+    gst_memory_unref (mems[i]);
+  if (shm)
+    gst_object_unref (shm);
+
+  return flow_ret;
+
+  /* ERRORS */
+no_shm:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("Shared memory is not supported on this platform"));
+    return GST_FLOW_ERROR;
+  }
+copy_failed:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("Failed to copy buffer into shared memory"));
+    flow_ret = GST_FLOW_ERROR;
+    goto done;
+  }
+select_error:
+  {
+    if (stopped) {
+      GST_DEBUG_OBJECT (sink, "Select stopped");
+      flow_ret = GST_FLOW_FLUSHING;
+    } else {
+      GST_ELEMENT_ERROR (sink, RESOURCE, READ, (NULL),
+          ("select on file descriptor: %s", g_strerror (errno)));
+      flow_ret = GST_FLOW_ERROR;
+    }
+    goto done;
+  }
+write_error:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("Error while passing buffer to file descriptor %d: %s", fd,
+            g_strerror (errno)));
+    flow_ret = GST_FLOW_ERROR;
+    goto done;
+  }
+}
+
+/* Receive a buffer sent with gst_fd_passing_send_buffer() from the Unix
+ * socket @fd. The memory of the buffer maps the received file descriptors
+ * read-only. Returns GST_FLOW_EOS when the peer closed the socket. */
+GstFlowReturn
+gst_fd_passing_receive_buffer (GstObject * src, gint fd, GstBuffer ** buffer)
+{
+  FdPassingHeader header;
+  gint fds[GST_FD_PASSING_MAX_FDS];
+  union
+  {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE (sizeof (fds))];
+  } control;
+  struct msghdr msg = { 0, };
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  GstBuffer *buf;
+  guint i, n_fds = 0;
+  gsize received;
+  gssize ret;
+
+  iov.iov_base = &header;
+  iov.iov_len = sizeof (header);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  do {
+    ret = recvmsg (fd, &msg, MSG_CMSG_CLOEXEC);
+  } while (ret < 0 && errno == EINTR);
+
+  if (ret < 0)
+    goto read_error;
+  if (ret == 0)
+    goto eos;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      guint n = (cmsg->cmsg_len - CMSG_LEN (0)) / sizeof (gint);
+
+      n = MIN (n, GST_FD_PASSING_MAX_FDS - n_fds);
+      memcpy (fds + n_fds, CMSG_DATA (cmsg), n * sizeof (gint));
+      n_fds += n;
+    }
+  }
+
+  /* read the rest of the header if the write was short */
+  received = ret;
+  while (received < sizeof (header)) {
+    ret = read (fd, (guint8 *) & header + received, sizeof (header) - received);
+    if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+      continue;
+    if (ret <= 0)
+      goto short_read;
+    received += ret;
+  }
+
+  if (header.magic != FD_PASSING_MAGIC || header.n_memories != n_fds
+      || (msg.msg_flags & MSG_CTRUNC))
+    goto invalid_header;
+
+  buf = gst_buffer_new ();
+  for (i = 0; i < n_fds; i++) {
+    FdPassingMemory *m = &header.memories[i];
+    GstMemory *mem;
+
+    if (m->offset + m->size > m->maxsize) {
+      mem = NULL;
+      close (fds[i]);
+    } else {
+      mem = gst_shm_memory_new_from_fd (fds[i], m->maxsize, m->offset, m->size);
+    }
+    if (mem == NULL) {
+      /* close the fds that weren't taken yet */
+      for (i = i + 1; i < n_fds; i++)
+        close (fds[i]);
+      gst_buffer_unref (buf);
+      goto import_failed;
+    }
+    gst_buffer_append_memory (buf, mem);
+  }
+
+  GST_BUFFER_PTS (buf) = header.pts;
+  GST_BUFFER_DTS (buf) = header.dts;
+  GST_BUFFER_DURATION (buf) = header.duration;
+  GST_BUFFER_OFFSET (buf) = header.offset;
+  GST_BUFFER_OFFSET_END (buf) = header.offset_end;
+  GST_BUFFER_FLAGS (buf) = header.flags;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "Read 0 bytes. EOS.");
+    return GST_FLOW_EOS;
+  }
+read_error:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("recvmsg on file descriptor: %s", g_strerror (errno)));
+    GST_DEBUG_OBJECT (src, "Error reading from fd");
+    return GST_FLOW_ERROR;
+  }
+short_read:
+  {
+    for (i = 0; i < n_fds; i++)
+      close (fds[i]);
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Short read of buffer header from file descriptor %d", fd));
+    return GST_FLOW_ERROR;
+  }
+invalid_header:
+  {
+    for (i = 0; i < n_fds; i++)
+      close (fds[i]);
+    GST_ELEMENT_ERROR (src, STREAM, DECODE, (NULL),
+        ("Received invalid buffer header with %u file descriptors", n_fds));
+    return GST_FLOW_ERROR;
+  }
+import_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("Failed to map received file descriptor"));
+    return GST_FLOW_ERROR;
+  }
+}
+#endif
+
+/* Check if @trans is negotiated and needs no per-buffer bookkeeping in the
+ * base class, in which case a subclass that has no per-buffer work to do
+ * can push a whole buffer list downstream at once */
+gboolean
+gst_base_transform_can_push_list (GstBaseTransform * trans)
+{
+  GstPad *srcpad = GST_BASE_TRANSFORM_SRC_PAD (trans);
+
+  /* QoS needs to look at every buffer */
+  if (gst_base_transform_is_qos_enabled (trans))
+    return FALSE;
+
+  if (!gst_pad_has_current_caps (srcpad) || gst_pad_needs_reconfigure (srcpad))
+    return FALSE;
+
+  return TRUE;
+}
+
+/* Chain all buffers of @list one by one to the chain function of @pad,
+ * like the default chain list function does */
+GstFlowReturn
+gst_pad_chain_list_buffers (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstPadChainFunction chainfunc = GST_PAD_CHAINFUNC (pad);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len; i++) {
+    ret = chainfunc (pad, parent, gst_buffer_ref (gst_buffer_list_get (list,
+                i)));
+    if (ret != GST_FLOW_OK)
+      break;
+  }
+  gst_buffer_list_unref (list);
+
+  return ret;
+}
+
+GType
+gst_queue_leaky_get_type (void)
+{
+  static GType queue_leaky_type = 0;
+  static const GEnumValue queue_leaky[] = {
+    {GST_QUEUE_NO_LEAK, "Not Leaky", "no"},
+    {GST_QUEUE_LEAK_UPSTREAM, "Leaky on upstream (new buffers)", "upstream"},
+    {GST_QUEUE_LEAK_DOWNSTREAM, "Leaky on downstream (old buffers)",
+        "downstream"},
+    {0, NULL, NULL},
+  };
+
+  if (!queue_leaky_type) {
+    queue_leaky_type = g_enum_register_static ("GstQueueLeaky", queue_leaky);
+  }
+  return queue_leaky_type;
+}
+
+GType
+gst_rate_estimator_mode_get_type (void)
+{
+  static GType mode_type = 0;
+  static const GEnumValue modes[] = {
+    {GST_RATE_ESTIMATOR_AVERAGE, "Long running average", "average"},
+    {GST_RATE_ESTIMATOR_EWMA, "Exponentially weighted moving average",
+        "ewma"},
+    {GST_RATE_ESTIMATOR_PERCENTILE, "25th percentile of a sliding window",
+        "percentile"},
+    {0, NULL, NULL},
+  };
+
+  if (!mode_type) {
+    mode_type = g_enum_register_static ("GstRateEstimatorMode", modes);
+  }
+  return mode_type;
+}
+
+void
+gst_rate_estimator_init (GstRateEstimator * est, GstRateEstimatorMode mode,
+    GstClockTime window)
+{
+  est->mode = mode;
+  est->window = window;
+  gst_rate_estimator_reset (est);
+}
+
+void
+gst_rate_estimator_reset (GstRateEstimator * est)
+{
+  est->rate = 0.0;
+  est->period = 0.0;
+  est->first = 0;
+  est->n_samples = 0;
+  est->total_period = 0.0;
+}
+
+static gint
+compare_rates (gconstpointer a, gconstpointer b)
+{
+  gdouble ra = *(const gdouble *) a, rb = *(const gdouble *) b;
+
+  return ra < rb ? -1 : (ra > rb ? 1 : 0);
+}
+
+/* Adds the sample of @bytes received in the last @period seconds and returns
+ * the new estimate of the rate in bytes per second */
+gdouble
+gst_rate_estimator_update (GstRateEstimator * est, guint64 bytes,
+    gdouble period)
+{
+  gdouble window = (gdouble) est->window / GST_SECOND;
+  gdouble rate = bytes / period;
+
+  switch (est->mode) {
+    case GST_RATE_ESTIMATOR_AVERAGE:
+      /* the initial rate may be subject to a burst, so adapt quickly at
+       * first, and give more weight to the past later on */
+      if (est->rate == 0.0)
+        est->rate = rate;
+      else
+        est->rate = (est->rate * est->period + rate * period) /
+            (est->period + period);
+
+      /* cap the weight at 16 samples of 0.2 seconds */
+      if (est->period < 3.2)
+        est->period += period;
+      break;
+    case GST_RATE_ESTIMATOR_EWMA:
+      if (est->rate == 0.0 || window <= 0.0)
+        est->rate = rate;
+      else
+        est->rate += (1.0 - exp2 (-period / window)) * (rate - est->rate);
+      break;
+    case GST_RATE_ESTIMATOR_PERCENTILE:
+    {
+      gdouble sorted[GST_RATE_ESTIMATOR_MAX_SAMPLES];
+      guint i, last;
+
+      if (est->n_samples == GST_RATE_ESTIMATOR_MAX_SAMPLES) {
+        est->total_period -= est->periods[est->first];
+        est->first = (est->first + 1) % GST_RATE_ESTIMATOR_MAX_SAMPLES;
+        est->n_samples--;
+      }
+      last = (est->first + est->n_samples) % GST_RATE_ESTIMATOR_MAX_SAMPLES;
+      est->samples[last] = rate;
+      est->periods[last] = period;
+      est->total_period += period;
+      est->n_samples++;
+
+      /* forget the samples that fell out of the window */
+      while (est->n_samples > 1 &&
+          est->total_period - est->periods[est->first] >= window) {
+        est->total_period -= est->periods[est->first];
+        est->first = (est->first + 1) % GST_RATE_ESTIMATOR_MAX_SAMPLES;
+        est->n_samples--;
+      }
+
+      for (i = 0; i < est->n_samples; i++)
+        sorted[i] = est->samples[(est->first + i) %
+            GST_RATE_ESTIMATOR_MAX_SAMPLES];
+      qsort (sorted, est->n_samples, sizeof (gdouble), compare_rates);
+      est->rate = sorted[(est->n_samples - 1) / 4];
+      break;
+    }
+  }
+
+  return est->rate;
+}
+
+GstPadArray *
+gst_pad_array_new (GList * pads)
+{
+  GstPadArray *array;
+  guint n_pads, i;
+
+  n_pads = g_list_length (pads);
+  array = g_malloc (sizeof (GstPadArray) + n_pads * sizeof (GstPad *));
+  array->refcount = 1;
+  array->n_pads = n_pads;
+  for (i = 0; pads; pads = g_list_next (pads), i++)
+    array->pads[i] = gst_object_ref (pads->data);
+
+  return array;
+}
+
+GstPadArray *
+gst_pad_array_ref (GstPadArray * array)
+{
+  g_atomic_int_inc (&array->refcount);
+
+  return array;
+}
+
+void
+gst_pad_array_unref (GstPadArray * array)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&array->refcount))
+    return;
+
+  for (i = 0; i < array->n_pads; i++)
+    gst_object_unref (array->pads[i]);
+  g_free (array);
+}
+
+void
+gst_pad_array_cache_init (GstPadArrayCache * cache)
+{
+  cache->current = gst_pad_array_new (NULL);
+  cache->cookie = 0;
+  cache->cached = gst_pad_array_ref (cache->current);
+  cache->cached_cookie = 0;
+}
+
+void
+gst_pad_array_cache_clear (GstPadArrayCache * cache)
+{
+  g_clear_pointer (&cache->cached, gst_pad_array_unref);
+  g_clear_pointer (&cache->current, gst_pad_array_unref);
+}
+
+/* Publish a new snapshot of @pads, must be called with the OBJECT_LOCK of
+ * the element owning the cache */
+void
+gst_pad_array_cache_set (GstPadArrayCache * cache, GList * pads)
+{
+  gst_pad_array_unref (cache->current);
+  cache->current = gst_pad_array_new (pads);
+  g_atomic_int_inc (&cache->cookie);
+}
+
+/* Get a reference to the latest snapshot. The streaming thread callers of
+ * this function must be serialized by the element, in the common case it
+ * only costs an atomic read and a ref */
+GstPadArray *
+gst_pad_array_cache_get (GstPadArrayCache * cache, GstObject * owner)
+{
+  gint cookie = g_atomic_int_get (&cache->cookie);
+
+  if (G_UNLIKELY (cookie != cache->cached_cookie)) {
+    GstPadArray *old = cache->cached;
+
+    GST_OBJECT_LOCK (owner);
+    cache->cached = gst_pad_array_ref (cache->current);
+    cache->cached_cookie = cache->cookie;
+    GST_OBJECT_UNLOCK (owner);
+
+    gst_pad_array_unref (old);
+  }
+
+  return gst_pad_array_ref (cache->cached);
+}
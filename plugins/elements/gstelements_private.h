@@ -24,6 +24,7 @@
 #define __GST_ELEMENTS_PRIVATE_H__
 
 #include "gst/gst.h"
+#include "gst/base/gstbasetransform.h"
 
 G_BEGIN_DECLS
 
@@ -54,6 +55,150 @@ GstFlowReturn  gst_writev_mem         (GstObject * sink, gint fd, GstPoll * fdse
                                        gint max_transient_error_timeout, guint64 current_position,
                                        gboolean * flushing);
 
+typedef struct _GstFileBacking GstFileBacking;
+
+G_GNUC_INTERNAL
+GstFileBacking * gst_file_backing_new   (gint fd);
+
+G_GNUC_INTERNAL
+GstFileBacking * gst_file_backing_ref   (GstFileBacking * backing);
+
+G_GNUC_INTERNAL
+void           gst_file_backing_unref (GstFileBacking * backing);
+
+G_GNUC_INTERNAL
+void           gst_memory_set_file_backing (GstMemory * mem,
+                                            GstFileBacking * backing);
+
+G_GNUC_INTERNAL
+gboolean       gst_memory_get_file_range (GstMemory * mem, gint * fd,
+                                          guint64 * offset);
+
+#ifdef HAVE_SYS_SENDFILE_H
+G_GNUC_INTERNAL
+GstFlowReturn  gst_sendfile_range     (GstObject * sink, gint fd, GstPoll * fdset,
+                                       gint in_fd, guint64 offset, gsize size,
+                                       guint64 * bytes_written);
+#endif
+
+#ifdef HAVE_SYS_SOCKET_H
+/* maximum number of file descriptors passed per buffer */
+#define GST_FD_PASSING_MAX_FDS 16
+
+G_GNUC_INTERNAL
+GstFlowReturn  gst_fd_passing_send_buffer    (GstObject * sink, gint fd,
+                                              GstPoll * fdset,
+                                              GstBuffer * buffer);
+
+G_GNUC_INTERNAL
+GstFlowReturn  gst_fd_passing_receive_buffer (GstObject * src, gint fd,
+                                              GstBuffer ** buffer);
+#endif
+
+G_GNUC_INTERNAL
+gboolean       gst_base_transform_can_push_list (GstBaseTransform * trans);
+
+G_GNUC_INTERNAL
+GstFlowReturn  gst_pad_chain_list_buffers (GstPad * pad, GstObject * parent,
+                                           GstBufferList * list);
+
+/* Immutable, refcounted snapshot of the pads of an element, so that the
+ * streaming thread can iterate them without taking the OBJECT_LOCK */
+typedef struct {
+  gint refcount;
+  guint n_pads;
+  GstPad *pads[];
+} GstPadArray;
+
+typedef struct {
+  GstPadArray *current;         /* protected by the element OBJECT_LOCK */
+  gint cookie;                  /* atomic, changed with current */
+
+  /* only used from the serialized streaming thread */
+  GstPadArray *cached;
+  gint cached_cookie;
+} GstPadArrayCache;
+
+G_GNUC_INTERNAL
+GstPadArray *  gst_pad_array_new   (GList * pads);
+
+G_GNUC_INTERNAL
+GstPadArray *  gst_pad_array_ref   (GstPadArray * array);
+
+G_GNUC_INTERNAL
+void           gst_pad_array_unref (GstPadArray * array);
+
+G_GNUC_INTERNAL
+void           gst_pad_array_cache_init  (GstPadArrayCache * cache);
+
+G_GNUC_INTERNAL
+void           gst_pad_array_cache_clear (GstPadArrayCache * cache);
+
+G_GNUC_INTERNAL
+void           gst_pad_array_cache_set   (GstPadArrayCache * cache,
+                                          GList * pads);
+
+G_GNUC_INTERNAL
+GstPadArray *  gst_pad_array_cache_get   (GstPadArrayCache * cache,
+                                          GstObject * owner);
+
+/* shared by the elements with a leaky property, the values are defined by
+ * #GstQueueLeaky in gstqueue.h */
+#define GST_TYPE_QUEUE_LEAKY (gst_queue_leaky_get_type ())
+G_GNUC_INTERNAL
+GType          gst_queue_leaky_get_type (void);
+
+/**
+ * GstRateEstimatorMode:
+ * @GST_RATE_ESTIMATOR_AVERAGE: running average that gives more weight to
+ *   the past as more samples come in
+ * @GST_RATE_ESTIMATOR_EWMA: exponentially weighted moving average that
+ *   forgets the past with the configured half-life
+ * @GST_RATE_ESTIMATOR_PERCENTILE: 25th percentile of the samples in the
+ *   configured window, a conservative estimate for bursty input
+ *
+ * How the input data rate of the buffering elements is estimated.
+ *
+ * Since: 1.20
+ */
+typedef enum {
+  GST_RATE_ESTIMATOR_AVERAGE,
+  GST_RATE_ESTIMATOR_EWMA,
+  GST_RATE_ESTIMATOR_PERCENTILE
+} GstRateEstimatorMode;
+
+#define GST_TYPE_RATE_ESTIMATOR_MODE (gst_rate_estimator_mode_get_type ())
+G_GNUC_INTERNAL
+GType          gst_rate_estimator_mode_get_type (void);
+
+#define GST_RATE_ESTIMATOR_MAX_SAMPLES 64
+
+typedef struct {
+  GstRateEstimatorMode mode;
+  GstClockTime window;          /* half-life or window length */
+
+  gdouble rate;
+  gdouble period;               /* weight of the average */
+
+  /* ring of the last samples for the percentile */
+  gdouble samples[GST_RATE_ESTIMATOR_MAX_SAMPLES];
+  gdouble periods[GST_RATE_ESTIMATOR_MAX_SAMPLES];
+  guint first, n_samples;
+  gdouble total_period;
+} GstRateEstimator;
+
+G_GNUC_INTERNAL
+void           gst_rate_estimator_init   (GstRateEstimator * est,
+                                          GstRateEstimatorMode mode,
+                                          GstClockTime window);
+
+G_GNUC_INTERNAL
+void           gst_rate_estimator_reset  (GstRateEstimator * est);
+
+G_GNUC_INTERNAL
+gdouble        gst_rate_estimator_update (GstRateEstimator * est,
+                                          guint64 bytes, gdouble period);
+
 G_END_DECLS
 
 #endif /* __GST_ELEMENTS_PRIVATE_H__ */
@@ -31,6 +31,11 @@
  * gst-launch-1.0 audiotestsrc num-buffers=1000 ! fakesink sync=false
  * ]| Render 1000 audio buffers (of default size) as fast as possible.
  *
+ * Since 1.20, #GstFakeSink:counting turns fakesink into a pure counting sink
+ * for load tests. It only updates a few counters per buffer or buffer list,
+ * that can be read with #GstFakeSink:counters, and takes no locks of its own
+ * and emits no signals.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -71,6 +76,7 @@ enum
 #define DEFAULT_CAN_ACTIVATE_PUSH TRUE
 #define DEFAULT_CAN_ACTIVATE_PULL FALSE
 #define DEFAULT_NUM_BUFFERS -1
+#define DEFAULT_COUNTING FALSE
 
 enum
 {
@@ -83,7 +89,9 @@ enum
   PROP_LAST_MESSAGE,
   PROP_CAN_ACTIVATE_PUSH,
   PROP_CAN_ACTIVATE_PULL,
-  PROP_NUM_BUFFERS
+  PROP_NUM_BUFFERS,
+  PROP_COUNTING,
+  PROP_COUNTERS
 };
 
 #define GST_TYPE_FAKE_SINK_STATE_ERROR (gst_fake_sink_state_error_get_type())
@@ -136,6 +144,8 @@ static GstFlowReturn gst_fake_sink_preroll (GstBaseSink * bsink,
     GstBuffer * buffer);
 static GstFlowReturn gst_fake_sink_render (GstBaseSink * bsink,
     GstBuffer * buffer);
+static GstFlowReturn gst_fake_sink_render_list (GstBaseSink * bsink,
+    GstBufferList * list);
 static gboolean gst_fake_sink_event (GstBaseSink * bsink, GstEvent * event);
 static gboolean gst_fake_sink_query (GstBaseSink * bsink, GstQuery * query);
 
@@ -200,6 +210,45 @@ gst_fake_sink_class_init (GstFakeSinkClass * klass)
           "Number of buffers to accept going EOS", -1, G_MAXINT,
           DEFAULT_NUM_BUFFERS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFakeSink:counting:
+   *
+   * Only count the rendered buffers and bytes and measure their latency.
+   * #GstFakeSink:silent, #GstFakeSink:dump and #GstFakeSink:signal-handoffs
+   * are ignored and buffer lists are counted as a whole.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_COUNTING,
+      g_param_spec_boolean ("counting", "Counting",
+          "Only count buffers and measure their latency", DEFAULT_COUNTING,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFakeSink:counters:
+   *
+   * The counters of the rendered data since the last READY to PAUSED state
+   * change. The structure contains:
+   *
+   * - "buffers" G_TYPE_UINT64: Number of rendered buffers
+   * - "bytes" G_TYPE_UINT64: Number of rendered bytes
+   * - "rate" G_TYPE_DOUBLE: Buffers per second since the first buffer
+   * - "byte-rate" G_TYPE_DOUBLE: Bytes per second since the first buffer
+   * - "average-latency" G_TYPE_UINT64: Average time between the running
+   *   time of a buffer and rendering it, or #GST_CLOCK_TIME_NONE
+   * - "max-latency" G_TYPE_UINT64: Maximum latency, or #GST_CLOCK_TIME_NONE
+   *
+   * Latency is only measured in #GstFakeSink:counting mode in PLAYING for
+   * buffers with a timestamp. The counters are written without locking, so
+   * they can be slightly off while data is flowing.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_COUNTERS,
+      g_param_spec_boxed ("counters", "Counters",
+          "Counters of the rendered data", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstFakeSink::handoff:
    * @fakesink: the fakesink instance
@@ -244,6 +293,8 @@ gst_fake_sink_class_init (GstFakeSinkClass * klass)
   gstbase_sink_class->event = GST_DEBUG_FUNCPTR (gst_fake_sink_event);
   gstbase_sink_class->preroll = GST_DEBUG_FUNCPTR (gst_fake_sink_preroll);
   gstbase_sink_class->render = GST_DEBUG_FUNCPTR (gst_fake_sink_render);
+  gstbase_sink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_fake_sink_render_list);
   gstbase_sink_class->query = GST_DEBUG_FUNCPTR (gst_fake_sink_query);
 
   gst_type_mark_as_plugin_api (GST_TYPE_FAKE_SINK_STATE_ERROR, 0);
@@ -258,6 +309,8 @@ gst_fake_sink_init (GstFakeSink * fakesink)
   fakesink->state_error = DEFAULT_STATE_ERROR;
   fakesink->signal_handoffs = DEFAULT_SIGNAL_HANDOFFS;
   fakesink->num_buffers = DEFAULT_NUM_BUFFERS;
+  fakesink->counting = DEFAULT_COUNTING;
+  fakesink->first_render_time = -1;
 
   gst_base_sink_set_sync (GST_BASE_SINK (fakesink), DEFAULT_SYNC);
   gst_base_sink_set_drop_out_of_segment (GST_BASE_SINK (fakesink),
@@ -267,9 +320,88 @@ gst_fake_sink_init (GstFakeSink * fakesink)
 static void
 gst_fake_sink_finalize (GObject * obj)
 {
+  GstFakeSink *sink = GST_FAKE_SINK (obj);
+
+  gst_clear_object (&sink->latency_clock);
+
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+static void
+gst_fake_sink_reset_counters (GstFakeSink * sink)
+{
+  sink->counted_buffers = 0;
+  sink->counted_bytes = 0;
+  sink->first_render_time = -1;
+  sink->latency_sum = 0;
+  sink->latency_max = 0;
+  sink->latency_count = 0;
+}
+
+static GstStructure *
+gst_fake_sink_get_counters (GstFakeSink * sink)
+{
+  guint64 buffers, bytes, latency_count, latency_sum;
+  GstClockTime latency_max;
+  gint64 first, elapsed;
+  gdouble rate = 0.0, byte_rate = 0.0;
+
+  buffers = sink->counted_buffers;
+  bytes = sink->counted_bytes;
+  first = sink->first_render_time;
+  latency_count = sink->latency_count;
+  latency_sum = sink->latency_sum;
+  latency_max = sink->latency_max;
+
+  if (first >= 0 && (elapsed = g_get_monotonic_time () - first) > 0) {
+    rate = buffers * (gdouble) G_USEC_PER_SEC / elapsed;
+    byte_rate = bytes * (gdouble) G_USEC_PER_SEC / elapsed;
+  }
+
+  return gst_structure_new ("application/x-gst-fake-sink-counters",
+      "buffers", G_TYPE_UINT64, buffers,
+      "bytes", G_TYPE_UINT64, bytes,
+      "rate", G_TYPE_DOUBLE, rate,
+      "byte-rate", G_TYPE_DOUBLE, byte_rate,
+      "average-latency", G_TYPE_UINT64,
+      latency_count ? latency_sum / latency_count : GST_CLOCK_TIME_NONE,
+      "max-latency", G_TYPE_UINT64,
+      latency_count ? latency_max : GST_CLOCK_TIME_NONE, NULL);
+}
+
+/* counts @n_buffers buffers of @bytes bytes, where @buf is the first of them.
+ * This runs in the streaming thread and only writes the counters. */
+static void
+gst_fake_sink_count (GstFakeSink * sink, GstBuffer * buf, guint n_buffers,
+    gsize bytes)
+{
+  GstBaseSink *bsink = GST_BASE_SINK_CAST (sink);
+  GstClock *clock = sink->latency_clock;
+
+  if (G_UNLIKELY (sink->first_render_time < 0))
+    sink->first_render_time = g_get_monotonic_time ();
+
+  sink->counted_buffers += n_buffers;
+  sink->counted_bytes += bytes;
+
+  if (clock && GST_BUFFER_PTS_IS_VALID (buf)) {
+    GstClockTime running_time, now;
+
+    running_time = gst_segment_to_running_time (&bsink->segment,
+        GST_FORMAT_TIME, GST_BUFFER_PTS (buf));
+    now = gst_clock_get_time (clock);
+
+    if (GST_CLOCK_TIME_IS_VALID (running_time)
+        && now >= sink->latency_base_time + running_time) {
+      GstClockTime latency = now - sink->latency_base_time - running_time;
+
+      sink->latency_sum += latency;
+      sink->latency_max = MAX (sink->latency_max, latency);
+      sink->latency_count++;
+    }
+  }
+}
+
 static void
 gst_fake_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -304,6 +436,9 @@ gst_fake_sink_set_property (GObject * object, guint prop_id,
     case PROP_NUM_BUFFERS:
       sink->num_buffers = g_value_get_int (value);
       break;
+    case PROP_COUNTING:
+      sink->counting = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -349,6 +484,12 @@ gst_fake_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_NUM_BUFFERS:
       g_value_set_int (value, sink->num_buffers);
       break;
+    case PROP_COUNTING:
+      g_value_set_boolean (value, sink->counting);
+      break;
+    case PROP_COUNTERS:
+      g_value_take_boxed (value, gst_fake_sink_get_counters (sink));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -452,6 +593,11 @@ gst_fake_sink_render (GstBaseSink * bsink, GstBuffer * buf)
   if (sink->num_buffers_left != -1)
     sink->num_buffers_left--;
 
+  gst_fake_sink_count (sink, buf, 1, gst_buffer_get_size (buf));
+
+  if (sink->counting)
+    goto done;
+
   if (!sink->silent) {
     gchar dts_str[64], pts_str[64], dur_str[64];
     gchar *flag_str, *meta_str;
@@ -510,6 +656,8 @@ gst_fake_sink_render (GstBaseSink * bsink, GstBuffer * buf)
       gst_buffer_unmap (buf, &info);
     }
   }
+
+done:
   if (sink->num_buffers_left == 0)
     goto eos;
 
@@ -523,6 +671,40 @@ eos:
   }
 }
 
+static gboolean
+gst_fake_sink_add_size (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  *(gsize *) user_data += gst_buffer_get_size (*buf);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_fake_sink_render_list (GstBaseSink * bsink, GstBufferList * list)
+{
+  GstFakeSink *sink = GST_FAKE_SINK_CAST (bsink);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+  gsize bytes = 0;
+
+  len = gst_buffer_list_length (list);
+  if (len == 0)
+    return GST_FLOW_OK;
+
+  /* count the whole list at once, the latency of the list is the one of its
+   * first buffer */
+  if (sink->counting && sink->num_buffers_left == -1) {
+    gst_buffer_list_foreach (list, gst_fake_sink_add_size, &bytes);
+    gst_fake_sink_count (sink, gst_buffer_list_get (list, 0), len, bytes);
+    return GST_FLOW_OK;
+  }
+
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    ret = gst_fake_sink_render (bsink, gst_buffer_list_get (list, i));
+
+  return ret;
+}
+
 static gboolean
 gst_fake_sink_query (GstBaseSink * bsink, GstQuery * query)
 {
@@ -561,10 +743,20 @@ gst_fake_sink_change_state (GstElement * element, GstStateChange transition)
       if (fakesink->state_error == FAKE_SINK_STATE_ERROR_READY_PAUSED)
         goto error;
       fakesink->num_buffers_left = fakesink->num_buffers;
+      gst_fake_sink_reset_counters (fakesink);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       if (fakesink->state_error == FAKE_SINK_STATE_ERROR_PAUSED_PLAYING)
         goto error;
+      /* render is called with the preroll lock, so the streaming thread can
+       * use the cached clock without taking any other lock */
+      GST_BASE_SINK_PREROLL_LOCK (fakesink);
+      gst_clear_object (&fakesink->latency_clock);
+      if (fakesink->counting) {
+        fakesink->latency_clock = gst_element_get_clock (element);
+        fakesink->latency_base_time = gst_element_get_base_time (element);
+      }
+      GST_BASE_SINK_PREROLL_UNLOCK (fakesink);
       break;
     default:
       break;
@@ -580,6 +772,9 @@ gst_fake_sink_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       if (fakesink->state_error == FAKE_SINK_STATE_ERROR_PAUSED_READY)
         goto error;
+      GST_BASE_SINK_PREROLL_LOCK (fakesink);
+      gst_clear_object (&fakesink->latency_clock);
+      GST_BASE_SINK_PREROLL_UNLOCK (fakesink);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       if (fakesink->state_error == FAKE_SINK_STATE_ERROR_READY_NULL)
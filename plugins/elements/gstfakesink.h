@@ -82,6 +82,16 @@ struct _GstFakeSink {
   gchar			*last_message;
   gint                  num_buffers;
   gint                  num_buffers_left;
+
+  gboolean              counting;
+  guint64               counted_buffers;
+  guint64               counted_bytes;
+  gint64                first_render_time;
+  GstClock             *latency_clock;
+  GstClockTime          latency_base_time;
+  guint64               latency_sum;
+  GstClockTime          latency_max;
+  guint64               latency_count;
 };
 
 struct _GstFakeSinkClass {
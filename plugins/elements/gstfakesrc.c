@@ -36,6 +36,17 @@
  * ]| This pipeline will push 5 empty buffers to the fakesink element and then
  * sends an EOS.
  *
+ * For load tests, `data=pool` reuses the buffers of a buffer pool instead of
+ * allocating new memory for each of them, and #GstFakeSrc:list-size pushes
+ * buffer lists instead of single buffers. Together with #GstFakeSrc:datarate
+ * and #GstFakeSrc:sync this generates data at a fixed rate:
+ *
+ * |[
+ * gst-launch-1.0 fakesrc data=pool sizetype=fixed sizemax=1400 list-size=32 \
+ *   datarate=125000000 sync=true ! fakesink counting=true sync=false
+ * ]| This pipeline pushes lists of 32 packets of 1400 bytes at one gigabit
+ * per second.
+ *
  */
 
 /* FIXME: this ignores basesrc::blocksize property, which could be used as an
@@ -86,6 +97,7 @@ enum
 #define DEFAULT_CAN_ACTIVATE_PULL TRUE
 #define DEFAULT_CAN_ACTIVATE_PUSH TRUE
 #define DEFAULT_FORMAT          GST_FORMAT_BYTES
+#define DEFAULT_LIST_SIZE       0
 
 enum
 {
@@ -109,6 +121,7 @@ enum
   PROP_CAN_ACTIVATE_PUSH,
   PROP_IS_LIVE,
   PROP_FORMAT,
+  PROP_LIST_SIZE,
   PROP_LAST,
 };
 
@@ -146,6 +159,7 @@ gst_fake_src_data_get_type (void)
   static const GEnumValue fakesrc_data[] = {
     {FAKE_SRC_DATA_ALLOCATE, "Allocate data", "allocate"},
     {FAKE_SRC_DATA_SUBBUFFER, "Subbuffer data", "subbuffer"},
+    {FAKE_SRC_DATA_POOL, "Reuse buffers of a pool", "pool"},
     {0, NULL, NULL},
   };
 
@@ -323,6 +337,20 @@ gst_fake_src_class_init (GstFakeSrcClass * klass)
       g_param_spec_enum ("format", "Format",
           "The format of the segment events", GST_TYPE_FORMAT,
           DEFAULT_FORMAT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstFakeSrc:list-size:
+   *
+   * Push buffer lists of this many buffers instead of single buffers. 0 and 1
+   * push single buffers, as does pull mode. A list counts as a single buffer
+   * for #GstBaseSrc:num-buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_LIST_SIZE,
+      g_param_spec_uint ("list-size", "List size",
+          "Number of buffers per pushed buffer list (0 = push buffers)",
+          0, G_MAXUINT, DEFAULT_LIST_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   /**
    * GstFakeSrc::handoff:
@@ -352,6 +380,8 @@ gst_fake_src_class_init (GstFakeSrcClass * klass)
   gstbase_src_class->get_times = GST_DEBUG_FUNCPTR (gst_fake_src_get_times);
   gstbase_src_class->create = GST_DEBUG_FUNCPTR (gst_fake_src_create);
 
+  fake_src_filled_quark = g_quark_from_static_string ("GstFakeSrcFilled");
+
   gst_type_mark_as_plugin_api (GST_TYPE_FAKE_SRC_DATA, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_FAKE_SRC_SIZETYPE, 0);
   gst_type_mark_as_plugin_api (GST_TYPE_FAKE_SRC_FILLTYPE, 0);
@@ -376,6 +406,7 @@ gst_fake_src_init (GstFakeSrc * fakesrc)
   fakesrc->datarate = DEFAULT_DATARATE;
   fakesrc->sync = DEFAULT_SYNC;
   fakesrc->format = DEFAULT_FORMAT;
+  fakesrc->list_size = DEFAULT_LIST_SIZE;
 }
 
 static void
@@ -515,6 +546,9 @@ gst_fake_src_set_property (GObject * object, guint prop_id,
     case PROP_FORMAT:
       src->format = (GstFormat) g_value_get_enum (value);
       break;
+    case PROP_LIST_SIZE:
+      src->list_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -589,6 +623,9 @@ gst_fake_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_FORMAT:
       g_value_set_enum (value, src->format);
       break;
+    case PROP_LIST_SIZE:
+      g_value_set_uint (value, src->list_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -668,6 +705,72 @@ gst_fake_src_alloc_buffer (GstFakeSrc * src, guint size)
   return buf;
 }
 
+static GQuark fake_src_filled_quark;
+
+/* Pool buffers keep their data when they are released, so only random and
+ * continuous pattern data need to be written again for every buffer. The
+ * other fill types are written once for the whole buffer. */
+static GstBuffer *
+gst_fake_src_acquire_buffer (GstFakeSrc * src, guint size)
+{
+  GstBuffer *buf = NULL;
+  GstMapInfo info;
+
+  if (size == 0)
+    return gst_buffer_new ();
+
+  if (src->pool && src->pool_size != src->sizemax) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_clear_object (&src->pool);
+  }
+
+  if (src->pool == NULL) {
+    GstStructure *config;
+
+    src->pool = gst_buffer_pool_new ();
+    src->pool_size = src->sizemax;
+
+    config = gst_buffer_pool_get_config (src->pool);
+    gst_buffer_pool_config_set_params (config, NULL, src->pool_size, 0, 0);
+    if (!gst_buffer_pool_set_config (src->pool, config)
+        || !gst_buffer_pool_set_active (src->pool, TRUE)) {
+      gst_clear_object (&src->pool);
+      return NULL;
+    }
+  }
+
+  if (gst_buffer_pool_acquire_buffer (src->pool, &buf, NULL) != GST_FLOW_OK)
+    return NULL;
+
+  switch (src->filltype) {
+    case FAKE_SRC_FILLTYPE_NOTHING:
+      break;
+    case FAKE_SRC_FILLTYPE_RANDOM:
+    case FAKE_SRC_FILLTYPE_PATTERN_CONT:
+      gst_buffer_resize (buf, 0, size);
+      if (gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
+        gst_fake_src_prepare_buffer (src, info.data, info.size);
+        gst_buffer_unmap (buf, &info);
+      }
+      return buf;
+    default:
+      if (gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (buf),
+              fake_src_filled_quark))
+        break;
+      if (gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
+        gst_fake_src_prepare_buffer (src, info.data, info.size);
+        gst_buffer_unmap (buf, &info);
+        gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (buf),
+            fake_src_filled_quark, GINT_TO_POINTER (TRUE), NULL);
+      }
+      break;
+  }
+
+  gst_buffer_resize (buf, 0, size);
+
+  return buf;
+}
+
 static guint
 gst_fake_src_get_size (GstFakeSrc * src)
 {
@@ -729,6 +832,11 @@ gst_fake_src_create_buffer (GstFakeSrc * src, gsize * bufsize)
       gst_fake_src_prepare_buffer (src, info.data, info.size);
       gst_buffer_unmap (buf, &info);
       break;
+    case FAKE_SRC_DATA_POOL:
+      buf = gst_fake_src_acquire_buffer (src, size);
+      if (buf == NULL)
+        goto buffer_create_fail;
+      break;
     default:
       g_warning ("fakesrc: dunno how to allocate buffers !");
       buf = gst_buffer_new ();
@@ -790,18 +898,18 @@ gst_fake_src_get_times (GstBaseSrc * basesrc, GstBuffer * buffer,
   }
 }
 
-static GstFlowReturn
-gst_fake_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
-    GstBuffer ** ret)
+static GstBuffer *
+gst_fake_src_create_one (GstFakeSrc * src, guint64 offset)
 {
-  GstFakeSrc *src;
+  GstBaseSrc *basesrc = GST_BASE_SRC_CAST (src);
   GstBuffer *buf;
   GstClockTime time;
   gsize size;
 
-  src = GST_FAKE_SRC (basesrc);
-
   buf = gst_fake_src_create_buffer (src, &size);
+  if (buf == NULL)
+    return NULL;
+
   GST_BUFFER_OFFSET (buf) = offset;
 
   if (src->datarate > 0) {
@@ -878,7 +986,44 @@ gst_fake_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
 
   src->bytes_sent += size;
 
-  *ret = buf;
+  return buf;
+}
+
+static GstFlowReturn
+gst_fake_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
+    GstBuffer ** ret)
+{
+  GstFakeSrc *src;
+  GstBufferList *list;
+  GstBuffer *buf;
+  guint i;
+
+  src = GST_FAKE_SRC (basesrc);
+
+  /* buffer lists can only be submitted in push mode */
+  if (src->list_size <= 1 || GST_PAD_MODE (basesrc->srcpad) != GST_PAD_MODE_PUSH) {
+    buf = gst_fake_src_create_one (src, offset);
+    if (buf == NULL)
+      return GST_FLOW_ERROR;
+
+    *ret = buf;
+    return GST_FLOW_OK;
+  }
+
+  list = gst_buffer_list_new_sized (src->list_size);
+  for (i = 0; i < src->list_size; i++) {
+    buf = gst_fake_src_create_one (src, offset);
+    if (buf == NULL) {
+      gst_buffer_list_unref (list);
+      return GST_FLOW_ERROR;
+    }
+    offset += gst_buffer_get_size (buf);
+    gst_buffer_list_add (list, buf);
+  }
+
+  gst_base_src_submit_buffer_list (basesrc, list);
+  *ret = NULL;
+
   return GST_FLOW_OK;
 }
 
@@ -913,6 +1058,11 @@ gst_fake_src_stop (GstBaseSrc * basesrc)
   src->last_message = NULL;
   GST_OBJECT_UNLOCK (src);
 
+  if (src->pool) {
+    gst_buffer_pool_set_active (src->pool, FALSE);
+    gst_clear_object (&src->pool);
+  }
+
   return TRUE;
 }
 
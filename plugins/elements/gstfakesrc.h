@@ -57,12 +57,14 @@ typedef enum {
  * GstFakeSrcDataType:
  * @FAKE_SRC_DATA_ALLOCATE: allocate buffers
  * @FAKE_SRC_DATA_SUBBUFFER: subbuffer each buffer
+ * @FAKE_SRC_DATA_POOL: reuse buffers of a buffer pool (Since: 1.20)
  *
  * The different ways buffers are allocated.
  */
 typedef enum {
   FAKE_SRC_DATA_ALLOCATE = 1,
-  FAKE_SRC_DATA_SUBBUFFER
+  FAKE_SRC_DATA_SUBBUFFER,
+  FAKE_SRC_DATA_POOL
 } GstFakeSrcDataType;
 
 /**
@@ -133,6 +135,9 @@ struct _GstFakeSrc {
   GstBuffer	*parent;
   guint		parentsize;
   guint		parentoffset;
+  GstBufferPool	*pool;
+  guint		pool_size;
+  guint		list_size;
   guint8	 pattern_byte;
   GList		*patternlist;
   gint		 datarate;
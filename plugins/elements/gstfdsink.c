@@ -30,6 +30,12 @@
  * This element will synchronize on the clock before writing the data on the
  * socket. For file descriptors where this does not make sense (files, ...) the
  * #GstBaseSink:sync property can be used to disable synchronisation.
+ *
+ * When #GstFdSink:pass-fds is enabled and the file descriptor is a Unix
+ * socket, the file descriptors of the shared memory of each buffer are passed
+ * to the peer instead of the data, see #GST_ALLOCATOR_SHM. Buffers that are
+ * not in shared memory are copied into it first. The peer receives the
+ * buffers with fdsrc and the same property enabled.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -100,9 +106,12 @@ enum
 enum
 {
   ARG_0,
-  ARG_FD
+  ARG_FD,
+  ARG_PASS_FDS
 };
 
+#define DEFAULT_PASS_FDS FALSE
+
 static void gst_fd_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
@@ -167,6 +176,20 @@ gst_fd_sink_class_init (GstFdSinkClass * klass)
   g_object_class_install_property (gobject_class, ARG_FD,
       g_param_spec_int ("fd", "fd", "An open file descriptor to write to",
           0, G_MAXINT, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSink:pass-fds:
+   *
+   * Pass the file descriptors of the shared memory of the buffers to a Unix
+   * socket instead of writing the data.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, ARG_PASS_FDS,
+      g_param_spec_boolean ("pass-fds", "Pass fds",
+          "Pass the file descriptors of shared memory over a Unix socket "
+          "instead of writing the data", DEFAULT_PASS_FDS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -175,6 +198,7 @@ gst_fd_sink_init (GstFdSink * fdsink)
   fdsink->fd = 1;
   fdsink->uri = g_strdup_printf ("fd://%d", fdsink->fd);
   fdsink->current_pos = 0;
+  fdsink->pass_fds = DEFAULT_PASS_FDS;
 
   gst_base_sink_set_sync (GST_BASE_SINK (fdsink), FALSE);
 }
@@ -245,6 +269,71 @@ gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query)
   return res;
 }
 
+#ifdef HAVE_SYS_SENDFILE_H
+static gboolean
+buffer_is_file_backed (GstBuffer * buffer)
+{
+  guint i, n_mem;
+  guint64 offset;
+  gint fd;
+
+  n_mem = gst_buffer_n_memory (buffer);
+  if (n_mem == 0)
+    return FALSE;
+
+  for (i = 0; i < n_mem; i++) {
+    if (!gst_memory_get_file_range (gst_buffer_peek_memory (buffer, i), &fd,
+            &offset))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* send the memories of @buffer straight from the file they are a view of,
+ * @bytes_written is updated also when the caller needs to fall back to a
+ * regular write */
+static GstFlowReturn
+gst_fd_sink_sendfile_buffer (GstFdSink * sink, GstBuffer * buffer,
+    guint64 * bytes_written)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, n_mem;
+
+  n_mem = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n_mem && ret == GST_FLOW_OK; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+    guint64 offset, skip = 0;
+    gint in_fd;
+
+    gst_memory_get_file_range (mem, &in_fd, &offset);
+
+    GST_LOG_OBJECT (sink, "sending %" G_GSIZE_FORMAT " bytes at file offset %"
+        G_GUINT64_FORMAT, mem->size, offset);
+
+    for (;;) {
+      guint64 sent = 0;
+
+      ret = gst_sendfile_range (GST_OBJECT_CAST (sink), sink->fd, sink->fdset,
+          in_fd, offset + skip, mem->size - skip, &sent);
+
+      sink->current_pos += sent;
+      skip += sent;
+      *bytes_written += sent;
+
+      if (!sink->unlock || ret != GST_FLOW_FLUSHING)
+        break;
+
+      ret = gst_base_sink_wait_preroll (GST_BASE_SINK (sink));
+      if (ret != GST_FLOW_OK)
+        return ret;
+    }
+  }
+
+  return ret;
+}
+#endif
+
 static GstFlowReturn
 gst_fd_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
 {
@@ -259,6 +348,31 @@ gst_fd_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
   if (num_buffers == 0)
     goto no_data;
 
+#ifdef HAVE_SYS_SOCKET_H
+  if (sink->pass_fds) {
+    guint i;
+
+    ret = GST_FLOW_OK;
+    for (i = 0; i < num_buffers && ret == GST_FLOW_OK; i++)
+      ret = gst_fd_sink_render (bsink, gst_buffer_list_get (buffer_list, i));
+
+    return ret;
+  }
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+  if (sink->use_sendfile
+      && buffer_is_file_backed (gst_buffer_list_get (buffer_list, 0))) {
+    guint i;
+
+    ret = GST_FLOW_OK;
+    for (i = 0; i < num_buffers && ret == GST_FLOW_OK; i++)
+      ret = gst_fd_sink_render (bsink, gst_buffer_list_get (buffer_list, i));
+
+    return ret;
+  }
+#endif
+
   for (;;) {
     guint64 bytes_written = 0;
 
@@ -294,6 +408,26 @@ gst_fd_sink_render (GstBaseSink * bsink, GstBuffer * buffer)
 
   sink = GST_FD_SINK_CAST (bsink);
 
+#ifdef HAVE_SYS_SOCKET_H
+  /* a buffer is passed in one message, it can't be resumed after a partial
+   * write like the data */
+  if (sink->pass_fds)
+    return gst_fd_passing_send_buffer (GST_OBJECT_CAST (sink), sink->fd,
+        sink->fdset, buffer);
+#endif
+
+#ifdef HAVE_SYS_SENDFILE_H
+  /* the data is still in the file, let the kernel copy it */
+  if (sink->use_sendfile && buffer_is_file_backed (buffer)) {
+    ret = gst_fd_sink_sendfile_buffer (sink, buffer, &skip);
+    if (ret != GST_FLOW_NOT_SUPPORTED)
+      return ret;
+
+    GST_INFO_OBJECT (sink, "sendfile not supported, writing the data");
+    sink->use_sendfile = FALSE;
+  }
+#endif
+
   for (;;) {
     guint64 bytes_written = 0;
 
@@ -376,6 +510,7 @@ gst_fd_sink_start (GstBaseSink * basesink)
   gst_poll_fd_ctl_write (fdsink->fdset, &fd, TRUE);
 
   fdsink->current_pos = 0;
+  fdsink->use_sendfile = TRUE;
 
   fdsink->seekable = gst_fd_sink_do_seek (fdsink, 0);
   GST_INFO_OBJECT (fdsink, "seeking supported: %d", fdsink->seekable);
@@ -457,6 +592,7 @@ gst_fd_sink_update_fd (GstFdSink * fdsink, int new_fd, GError ** error)
     gst_poll_fd_ctl_write (fdsink->fdset, &fd, TRUE);
   }
   fdsink->fd = new_fd;
+  fdsink->use_sendfile = TRUE;
   g_free (fdsink->uri);
   fdsink->uri = g_strdup_printf ("fd://%d", fdsink->fd);
 
@@ -486,6 +622,9 @@ gst_fd_sink_set_property (GObject * object, guint prop_id,
       gst_fd_sink_update_fd (fdsink, fd, NULL);
       break;
     }
+    case ARG_PASS_FDS:
+      fdsink->pass_fds = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -504,6 +643,9 @@ gst_fd_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case ARG_FD:
       g_value_set_int (value, fdsink->fd);
       break;
+    case ARG_PASS_FDS:
+      g_value_set_boolean (value, fdsink->pass_fds);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
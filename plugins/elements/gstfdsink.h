@@ -62,6 +62,9 @@ struct _GstFdSink {
 
   gboolean seekable;
   gboolean unlock; /* OBJECT LOCK */
+
+  gboolean use_sendfile;
+  gboolean pass_fds;
 };
 
 struct _GstFdSinkClass {
@@ -39,6 +39,11 @@
  * * #guint64 `timeout`: the timeout in microseconds that
  *   expired when waiting for data.
  *
+ * When #GstFdSrc:pass-fds is enabled, the file descriptor must be a Unix
+ * socket on which fdsink passes buffers of shared memory with the same
+ * property enabled. The received buffers map the memory of the sender
+ * read-only and without copying.
+ *
  * ## Example launch line
  * |[
  * echo "Hello GStreamer" | gst-launch-1.0 -v fdsrc ! fakesink dump=true
@@ -80,6 +85,7 @@
 
 #include "gstfdsrc.h"
 #include "gstcoreelementselements.h"
+#include "gstelements_private.h"
 
 #define struct_stat struct stat
 
@@ -102,6 +108,8 @@ GST_DEBUG_CATEGORY_STATIC (gst_fd_src_debug);
 
 #define DEFAULT_FD              0
 #define DEFAULT_TIMEOUT         0
+#define DEFAULT_MAX_DRAIN_BUFFERS 1
+#define DEFAULT_PASS_FDS        FALSE
 
 enum
 {
@@ -109,6 +117,8 @@ enum
 
   PROP_FD,
   PROP_TIMEOUT,
+  PROP_MAX_DRAIN_BUFFERS,
+  PROP_PASS_FDS,
 
   PROP_LAST
 };
@@ -172,6 +182,39 @@ gst_fd_src_class_init (GstFdSrcClass * klass)
           G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFdSrc:max-drain-buffers
+   *
+   * When the file descriptor becomes readable, keep reading blocks of
+   * #GstBaseSrc:blocksize bytes for as long as data is available, up to
+   * this many, and push them downstream as one #GstBufferList. This avoids
+   * a poll, read and push for every small chunk when ingesting from a
+   * busy pipe or socket.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass),
+      PROP_MAX_DRAIN_BUFFERS, g_param_spec_uint ("max-drain-buffers",
+          "Max drain buffers",
+          "Maximum number of buffers read per wakeup and pushed as a buffer "
+          "list (1 = push single buffers)", 1, G_MAXUINT,
+          DEFAULT_MAX_DRAIN_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFdSrc:pass-fds:
+   *
+   * Receive buffers whose shared memory file descriptors are passed over a
+   * Unix socket by fdsink, instead of reading data.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PASS_FDS,
+      g_param_spec_boolean ("pass-fds", "Pass fds",
+          "Receive the file descriptors of shared memory over a Unix socket "
+          "instead of reading data", DEFAULT_PASS_FDS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Filedescriptor Source",
       "Source/File",
@@ -198,6 +241,8 @@ gst_fd_src_init (GstFdSrc * fdsrc)
   fdsrc->fd = -1;
   fdsrc->size = -1;
   fdsrc->timeout = DEFAULT_TIMEOUT;
+  fdsrc->max_drain_buffers = DEFAULT_MAX_DRAIN_BUFFERS;
+  fdsrc->pass_fds = DEFAULT_PASS_FDS;
   fdsrc->uri = g_strdup_printf ("fd://0");
   fdsrc->curoffset = 0;
 }
@@ -362,6 +407,12 @@ gst_fd_src_set_property (GObject * object, guint prop_id, const GValue * value,
       GST_DEBUG_OBJECT (src, "poll timeout set to %" GST_TIME_FORMAT,
           GST_TIME_ARGS (src->timeout));
       break;
+    case PROP_MAX_DRAIN_BUFFERS:
+      src->max_drain_buffers = g_value_get_uint (value);
+      break;
+    case PROP_PASS_FDS:
+      src->pass_fds = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -381,12 +432,79 @@ gst_fd_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, src->timeout);
       break;
+    case PROP_MAX_DRAIN_BUFFERS:
+      g_value_set_uint (value, src->max_drain_buffers);
+      break;
+    case PROP_PASS_FDS:
+      g_value_set_boolean (value, src->pass_fds);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+#ifndef HAVE_WIN32
+/* Keep reading while data is available without blocking. Errors and EOS
+ * end the draining and are reported by the next read. Returns NULL if
+ * nothing more could be read and @first should be pushed on its own. */
+static GstBufferList *
+gst_fd_src_drain (GstFdSrc * src, GstBuffer * first, guint blocksize)
+{
+  GstBufferList *list = NULL;
+  guint n_buffers = 1;
+
+  while (n_buffers < src->max_drain_buffers) {
+    GstBuffer *buf;
+    GstMapInfo info;
+    gssize readbytes;
+
+    if (gst_poll_wait (src->fdset, 0) <= 0)
+      break;
+
+    buf = gst_buffer_new_allocate (NULL, blocksize, NULL);
+    if (G_UNLIKELY (buf == NULL))
+      break;
+
+    if (!gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
+      gst_buffer_unref (buf);
+      break;
+    }
+
+    do {
+      readbytes = read (src->fd, info.data, blocksize);
+    } while (readbytes == -1 && errno == EINTR);
+
+    gst_buffer_unmap (buf, &info);
+
+    if (readbytes <= 0) {
+      gst_buffer_unref (buf);
+      break;
+    }
+
+    gst_buffer_resize (buf, 0, readbytes);
+    GST_BUFFER_OFFSET (buf) = src->curoffset;
+    GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+    src->curoffset += readbytes;
+
+    if (list == NULL) {
+      list = gst_buffer_list_new_sized (MIN (src->max_drain_buffers, 64));
+      gst_buffer_list_add (list, first);
+    }
+    gst_buffer_list_add (list, buf);
+    n_buffers++;
+
+    if (readbytes < (gssize) blocksize)
+      break;
+  }
+
+  if (list)
+    GST_LOG_OBJECT (src, "drained %u buffers", n_buffers);
+
+  return list;
+}
+#endif
+
 static GstFlowReturn
 gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
@@ -440,6 +558,21 @@ gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
   } while (G_UNLIKELY (try_again));     /* retry if interrupted or timeout */
 #endif
 
+#ifdef HAVE_SYS_SOCKET_H
+  if (src->pass_fds) {
+    GstFlowReturn ret;
+
+    ret = gst_fd_passing_receive_buffer (GST_OBJECT_CAST (src), src->fd,
+        outbuf);
+    if (ret == GST_FLOW_OK) {
+      GST_LOG_OBJECT (psrc, "Received buffer of size %" G_GSIZE_FORMAT,
+          gst_buffer_get_size (*outbuf));
+      src->curoffset += gst_buffer_get_size (*outbuf);
+    }
+    return ret;
+  }
+#endif
+
   blocksize = GST_BASE_SRC (src)->blocksize;
 
   /* create the buffer */
@@ -470,6 +603,20 @@ gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 
   GST_LOG_OBJECT (psrc, "Read buffer of size %" G_GSSIZE_FORMAT, readbytes);
 
+#ifndef HAVE_WIN32
+  /* a short read means that there is nothing more to read right now */
+  if (src->max_drain_buffers > 1 && readbytes == (gssize) blocksize) {
+    GstBufferList *list;
+
+    list = gst_fd_src_drain (src, buf, blocksize);
+    if (list) {
+      gst_base_src_submit_buffer_list (GST_BASE_SRC_CAST (src), list);
+      *outbuf = NULL;
+      return GST_FLOW_OK;
+    }
+  }
+#endif
+
   /* we're done, return the buffer */
   *outbuf = buf;
 
@@ -66,6 +66,12 @@ struct _GstFdSrc {
   /* poll timeout */
   guint64 timeout;
 
+  /* maximum number of reads per wakeup */
+  guint max_drain_buffers;
+
+  /* receive buffers of shared memory */
+  gboolean pass_fds;
+
   gchar *uri;
 
   GstPoll *fdset;
@@ -38,6 +38,11 @@
 #  include "config.h"
 #endif
 
+/* for O_DIRECT */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include "../../gst/gst-i18n-lib.h"
 
 #include <gst/gst.h>
@@ -111,6 +116,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_file_sink_debug);
 #define DEFAULT_APPEND		FALSE
 #define DEFAULT_O_SYNC		FALSE
 #define DEFAULT_MAX_TRANSIENT_ERROR_TIMEOUT	0
+#define DEFAULT_ASYNC_WRITE	FALSE
+#define DEFAULT_MAX_INFLIGHT_BYTES	(16 * 1024 * 1024)
+#define DEFAULT_DIRECT_IO	FALSE
+
+#define DIRECT_IO_MIN_ALIGN	4096
+#define DIRECT_IO_MAX_ALIGN	(1024 * 1024)
 
 enum
 {
@@ -121,6 +132,9 @@ enum
   PROP_APPEND,
   PROP_O_SYNC,
   PROP_MAX_TRANSIENT_ERROR_TIMEOUT,
+  PROP_ASYNC_WRITE,
+  PROP_MAX_INFLIGHT_BYTES,
+  PROP_DIRECT_IO,
   PROP_LAST
 };
 
@@ -159,6 +173,7 @@ gst_fopen (const gchar * filename, const gchar * mode, gboolean o_sync)
 }
 
 static void gst_file_sink_dispose (GObject * object);
+static void gst_file_sink_finalize (GObject * object);
 
 static void gst_file_sink_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -184,11 +199,15 @@ static gboolean gst_file_sink_get_current_offset (GstFileSink * filesink,
     guint64 * p_pos);
 
 static gboolean gst_file_sink_query (GstBaseSink * bsink, GstQuery * query);
+static gboolean gst_file_sink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
 
 static void gst_file_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
 static GstFlowReturn gst_file_sink_flush_buffer (GstFileSink * filesink);
+static GstFlowReturn gst_file_sink_flush_direct (GstFileSink * filesink,
+    gboolean all);
 
 #define _do_init \
   G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER, gst_file_sink_uri_handler_init); \
@@ -207,6 +226,7 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
 
   gobject_class->dispose = gst_file_sink_dispose;
+  gobject_class->finalize = gst_file_sink_finalize;
 
   gobject_class->set_property = gst_file_sink_set_property;
   gobject_class->get_property = gst_file_sink_get_property;
@@ -250,6 +270,53 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
           G_MAXINT, DEFAULT_MAX_TRANSIENT_ERROR_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFileSink:async-write
+   *
+   * Write the data from a separate thread. Buffers are kept referenced until
+   * they are written and the streaming thread only blocks when more than
+   * #GstFileSink:max-inflight-bytes are pending. Write errors are reported
+   * on the next buffer or at EOS.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_ASYNC_WRITE,
+      g_param_spec_boolean ("async-write", "Asynchronous write",
+          "Write the data to the file from a separate thread",
+          DEFAULT_ASYNC_WRITE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSink:max-inflight-bytes
+   *
+   * The maximum amount of data that can be pending in asynchronous write
+   * mode before the streaming thread blocks.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_INFLIGHT_BYTES,
+      g_param_spec_uint64 ("max-inflight-bytes", "Max in-flight bytes",
+          "Maximum number of bytes pending in async-write mode", 1,
+          G_MAXUINT64, DEFAULT_MAX_INFLIGHT_BYTES,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstFileSink:direct-io
+   *
+   * Open the file with O_DIRECT to bypass the page cache. Data is written
+   * in blocks aligned to the file system block size, aligned buffers are
+   * proposed upstream and unaligned data is copied into an aligned staging
+   * buffer of #GstFileSink:buffer-size bytes. Falls back to normal writes if
+   * the file system does not support direct I/O.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_DIRECT_IO,
+      g_param_spec_boolean ("direct-io", "Direct I/O",
+          "Open the file with O_DIRECT to bypass the page cache",
+          DEFAULT_DIRECT_IO, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "File Sink",
       "Sink/File", "Write stream to a file",
@@ -259,6 +326,8 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_file_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_file_sink_stop);
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_file_sink_query);
+  gstbasesink_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_file_sink_propose_allocation);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_file_sink_render);
   gstbasesink_class->render_list =
       GST_DEBUG_FUNCPTR (gst_file_sink_render_list);
@@ -284,6 +353,14 @@ gst_file_sink_init (GstFileSink * filesink)
   filesink->buffer_mode = DEFAULT_BUFFER_MODE;
   filesink->buffer_size = DEFAULT_BUFFER_SIZE;
   filesink->append = FALSE;
+  filesink->async_write = DEFAULT_ASYNC_WRITE;
+  filesink->max_inflight_bytes = DEFAULT_MAX_INFLIGHT_BYTES;
+  filesink->direct_io = DEFAULT_DIRECT_IO;
+
+  g_mutex_init (&filesink->async_lock);
+  g_cond_init (&filesink->async_cond);
+  g_queue_init (&filesink->async_queue);
+  filesink->async_flow = GST_FLOW_OK;
 
   gst_base_sink_set_sync (GST_BASE_SINK (filesink), FALSE);
 }
@@ -301,6 +378,17 @@ gst_file_sink_dispose (GObject * object)
   sink->filename = NULL;
 }
 
+static void
+gst_file_sink_finalize (GObject * object)
+{
+  GstFileSink *sink = GST_FILE_SINK (object);
+
+  g_mutex_clear (&sink->async_lock);
+  g_cond_clear (&sink->async_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gboolean
 gst_file_sink_set_location (GstFileSink * sink, const gchar * location,
     GError ** error)
@@ -361,6 +449,18 @@ gst_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_MAX_TRANSIENT_ERROR_TIMEOUT:
       sink->max_transient_error_timeout = g_value_get_int (value);
       break;
+    case PROP_ASYNC_WRITE:
+      sink->async_write = g_value_get_boolean (value);
+      break;
+    case PROP_DIRECT_IO:
+      sink->direct_io = g_value_get_boolean (value);
+      break;
+    case PROP_MAX_INFLIGHT_BYTES:
+      g_mutex_lock (&sink->async_lock);
+      sink->max_inflight_bytes = g_value_get_uint64 (value);
+      g_cond_broadcast (&sink->async_cond);
+      g_mutex_unlock (&sink->async_lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -392,12 +492,239 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MAX_TRANSIENT_ERROR_TIMEOUT:
       g_value_set_int (value, sink->max_transient_error_timeout);
       break;
+    case PROP_ASYNC_WRITE:
+      g_value_set_boolean (value, sink->async_write);
+      break;
+    case PROP_DIRECT_IO:
+      g_value_set_boolean (value, sink->direct_io);
+      break;
+    case PROP_MAX_INFLIGHT_BYTES:
+      g_mutex_lock (&sink->async_lock);
+      g_value_set_uint64 (value, sink->max_inflight_bytes);
+      g_mutex_unlock (&sink->async_lock);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static guint64
+mini_object_get_size (GstMiniObject * obj)
+{
+  if (GST_IS_BUFFER (obj))
+    return gst_buffer_get_size (GST_BUFFER_CAST (obj));
+  else
+    return gst_buffer_list_calculate_size (GST_BUFFER_LIST_CAST (obj));
+}
+
+/* Writes out the buffers and buffer lists queued by the streaming thread in
+ * order. After a write error, or while flushing, the remaining data is
+ * dropped until the error was picked up at FLUSH_STOP. */
+static gpointer
+gst_file_sink_writer_func (GstFileSink * sink)
+{
+  g_mutex_lock (&sink->async_lock);
+  for (;;) {
+    GstMiniObject *obj;
+    GstFlowReturn flow;
+    guint64 size, bytes_written = 0;
+
+    while (g_queue_is_empty (&sink->async_queue) && !sink->writer_quit)
+      g_cond_wait (&sink->async_cond, &sink->async_lock);
+
+    obj = g_queue_pop_head (&sink->async_queue);
+    if (obj == NULL)
+      break;
+
+    sink->writing = TRUE;
+    flow = sink->async_flow;
+    g_mutex_unlock (&sink->async_lock);
+
+    size = mini_object_get_size (obj);
+
+    if (flow == GST_FLOW_OK) {
+      GST_LOG_OBJECT (sink, "writing %" G_GUINT64_FORMAT " bytes at position %"
+          G_GUINT64_FORMAT, size, sink->current_pos);
+
+      if (GST_IS_BUFFER (obj)) {
+        flow = gst_writev_buffer (GST_OBJECT_CAST (sink), fileno (sink->file),
+            NULL, GST_BUFFER_CAST (obj), &bytes_written, 0,
+            sink->max_transient_error_timeout, sink->current_pos,
+            &sink->async_flushing);
+      } else {
+        flow = gst_writev_buffer_list (GST_OBJECT_CAST (sink),
+            fileno (sink->file), NULL, GST_BUFFER_LIST_CAST (obj),
+            &bytes_written, 0, sink->max_transient_error_timeout,
+            sink->current_pos, &sink->async_flushing);
+      }
+    }
+    gst_mini_object_unref (obj);
+
+    g_mutex_lock (&sink->async_lock);
+    sink->current_pos += bytes_written;
+    sink->inflight_bytes -= size;
+    sink->writing = FALSE;
+    if (flow != GST_FLOW_OK && sink->async_flow == GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (sink, "write failed: %s", gst_flow_get_name (flow));
+      sink->async_flow = flow;
+    }
+    g_cond_broadcast (&sink->async_cond);
+  }
+  g_mutex_unlock (&sink->async_lock);
+
+  return NULL;
+}
+
+static gboolean
+gst_file_sink_start_writer (GstFileSink * sink)
+{
+  gchar *name;
+  GError *err = NULL;
+
+  sink->inflight_bytes = 0;
+  sink->writing = FALSE;
+  sink->writer_quit = FALSE;
+  sink->async_flushing = FALSE;
+  sink->async_flow = GST_FLOW_OK;
+
+  name = g_strdup_printf ("%s:writer", GST_OBJECT_NAME (sink));
+  sink->writer = g_thread_try_new (name,
+      (GThreadFunc) gst_file_sink_writer_func, sink, &err);
+  g_free (name);
+
+  if (sink->writer == NULL) {
+    GST_ELEMENT_ERROR (sink, RESOURCE, FAILED,
+        ("Failed to start writer thread"), ("%s", err->message));
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* lets the writer thread finish all pending writes and exit */
+static void
+gst_file_sink_stop_writer (GstFileSink * sink)
+{
+  if (sink->writer == NULL)
+    return;
+
+  g_mutex_lock (&sink->async_lock);
+  sink->writer_quit = TRUE;
+  g_cond_broadcast (&sink->async_cond);
+  g_mutex_unlock (&sink->async_lock);
+
+  g_thread_join (sink->writer);
+  sink->writer = NULL;
+}
+
+/* queue @obj for the writer thread, blocking while too much data is
+ * pending. Returns the error of a previous asynchronous write, if any. */
+static GstFlowReturn
+gst_file_sink_async_push (GstFileSink * sink, GstMiniObject * obj,
+    guint64 size)
+{
+  GstFlowReturn flow;
+
+  g_mutex_lock (&sink->async_lock);
+  while ((flow = sink->async_flow) == GST_FLOW_OK && !sink->async_flushing
+      && sink->inflight_bytes > 0
+      && sink->inflight_bytes + size > sink->max_inflight_bytes) {
+    GST_LOG_OBJECT (sink, "%" G_GUINT64_FORMAT " bytes in flight, waiting",
+        sink->inflight_bytes);
+    g_cond_wait (&sink->async_cond, &sink->async_lock);
+  }
+
+  if (sink->async_flushing)
+    flow = GST_FLOW_FLUSHING;
+
+  if (flow == GST_FLOW_OK) {
+    g_queue_push_tail (&sink->async_queue, gst_mini_object_ref (obj));
+    sink->inflight_bytes += size;
+    g_cond_broadcast (&sink->async_cond);
+  }
+  g_mutex_unlock (&sink->async_lock);
+
+  return flow;
+}
+
+/* wait until all queued data is written */
+static GstFlowReturn
+gst_file_sink_async_drain (GstFileSink * sink)
+{
+  GstFlowReturn flow;
+
+  if (sink->writer == NULL)
+    return GST_FLOW_OK;
+
+  g_mutex_lock (&sink->async_lock);
+  while (!g_queue_is_empty (&sink->async_queue) || sink->writing)
+    g_cond_wait (&sink->async_cond, &sink->async_lock);
+  flow = sink->async_flow;
+  g_mutex_unlock (&sink->async_lock);
+
+  return flow;
+}
+
+#ifdef O_DIRECT
+static gboolean
+gst_file_sink_set_direct (GstFileSink * sink, gboolean enable)
+{
+  gint fd = fileno (sink->file);
+  gint flags;
+
+  flags = fcntl (fd, F_GETFL);
+  if (flags < 0)
+    return FALSE;
+
+  if (enable)
+    flags |= O_DIRECT;
+  else
+    flags &= ~O_DIRECT;
+
+  return fcntl (fd, F_SETFL, flags) == 0;
+}
+#endif
+
+static void
+gst_file_sink_setup_direct_io (GstFileSink * sink)
+{
+#ifdef O_DIRECT
+  struct stat st;
+  gsize align = DIRECT_IO_MIN_ALIGN;
+
+  /* use the preferred I/O size if it is a larger power of two, it is a
+   * multiple of the logical block size O_DIRECT requires */
+  if (fstat (fileno (sink->file), &st) == 0 && st.st_blksize > align
+      && st.st_blksize <= DIRECT_IO_MAX_ALIGN
+      && (st.st_blksize & (st.st_blksize - 1)) == 0)
+    align = st.st_blksize;
+
+  if (!gst_file_sink_set_direct (sink, TRUE)) {
+    GST_ELEMENT_WARNING (sink, RESOURCE, SETTINGS,
+        ("Direct I/O is not supported for file \"%s\".", sink->filename),
+        ("%s", g_strerror (errno)));
+    return;
+  }
+
+  sink->direct_align = align;
+  sink->direct_buffer_size =
+      GST_ROUND_UP_N (MAX ((gsize) sink->buffer_size, align), align);
+  sink->direct_mem = g_malloc (sink->direct_buffer_size + align - 1);
+  sink->direct_buffer =
+      (guint8 *) GST_ROUND_UP_N ((guintptr) sink->direct_mem, align);
+  sink->direct_offset = 0;
+
+  GST_DEBUG_OBJECT (sink, "using direct I/O, alignment %" G_GSIZE_FORMAT
+      ", staging buffer of %" G_GSIZE_FORMAT " bytes", align,
+      sink->direct_buffer_size);
+#else
+  GST_ELEMENT_WARNING (sink, RESOURCE, SETTINGS,
+      ("Direct I/O is not supported on this platform."), (NULL));
+#endif
+}
+
 static gboolean
 gst_file_sink_open_file (GstFileSink * sink)
 {
@@ -423,7 +750,13 @@ gst_file_sink_open_file (GstFileSink * sink)
     gst_buffer_list_unref (sink->buffer_list);
   sink->buffer_list = NULL;
 
-  if (sink->buffer_mode != GST_FILE_SINK_BUFFER_MODE_UNBUFFERED) {
+  if (sink->direct_io)
+    gst_file_sink_setup_direct_io (sink);
+
+  /* the writer thread does the batching in async mode and direct I/O uses
+   * its own aligned staging buffer */
+  if (sink->buffer_mode != GST_FILE_SINK_BUFFER_MODE_UNBUFFERED
+      && !sink->async_write && !sink->direct_buffer) {
     if (sink->buffer_size == 0) {
       sink->buffer_size = DEFAULT_BUFFER_SIZE;
       g_object_notify (G_OBJECT (sink), "buffer-size");
@@ -438,8 +771,16 @@ gst_file_sink_open_file (GstFileSink * sink)
     sink->current_buffer_size = 0;
   }
 
-  GST_DEBUG_OBJECT (sink, "opened file %s, seekable %d",
-      sink->filename, sink->seekable);
+  if (sink->async_write && sink->direct_buffer) {
+    GST_WARNING_OBJECT (sink, "async-write is not supported with direct-io");
+  } else if (sink->async_write && !gst_file_sink_start_writer (sink)) {
+    fclose (sink->file);
+    sink->file = NULL;
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (sink, "opened file %s, seekable %d, async %d",
+      sink->filename, sink->seekable, sink->async_write);
 
   return TRUE;
 
@@ -463,6 +804,8 @@ static void
 gst_file_sink_close_file (GstFileSink * sink)
 {
   if (sink->file) {
+    gst_file_sink_stop_writer (sink);
+
     if (gst_file_sink_flush_buffer (sink) != GST_FLOW_OK)
       GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
           (_("Error closing file \"%s\"."), sink->filename), NULL);
@@ -486,6 +829,11 @@ gst_file_sink_close_file (GstFileSink * sink)
     sink->buffer_list = NULL;
   }
   sink->current_buffer_size = 0;
+
+  g_free (sink->direct_mem);
+  sink->direct_mem = NULL;
+  sink->direct_buffer = NULL;
+  sink->direct_buffer_size = 0;
 }
 
 static gboolean
@@ -504,8 +852,11 @@ gst_file_sink_query (GstBaseSink * bsink, GstQuery * query)
       switch (format) {
         case GST_FORMAT_DEFAULT:
         case GST_FORMAT_BYTES:
+          g_mutex_lock (&self->async_lock);
           gst_query_set_position (query, GST_FORMAT_BYTES,
-              self->current_pos + self->current_buffer_size);
+              self->current_pos + self->current_buffer_size +
+              self->inflight_bytes);
+          g_mutex_unlock (&self->async_lock);
           res = TRUE;
           break;
         default:
@@ -608,6 +959,9 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       gst_event_parse_segment (event, &segment);
 
       if (segment->format == GST_FORMAT_BYTES) {
+        if (gst_file_sink_async_drain (filesink) != GST_FLOW_OK)
+          goto flush_buffer_failed;
+
         /* only try to seek and fail when we are going to a different
          * position */
         if (filesink->current_pos + filesink->current_buffer_size !=
@@ -628,7 +982,20 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       }
       break;
     }
+    case GST_EVENT_FLUSH_START:
+      /* make the writer thread drop all pending data */
+      g_mutex_lock (&filesink->async_lock);
+      filesink->async_flushing = TRUE;
+      g_cond_broadcast (&filesink->async_cond);
+      g_mutex_unlock (&filesink->async_lock);
+      break;
     case GST_EVENT_FLUSH_STOP:
+      gst_file_sink_async_drain (filesink);
+      g_mutex_lock (&filesink->async_lock);
+      filesink->async_flushing = FALSE;
+      filesink->async_flow = GST_FLOW_OK;
+      g_mutex_unlock (&filesink->async_lock);
+
       if (filesink->current_pos != 0 && filesink->seekable) {
         gst_file_sink_do_seek (filesink, 0);
         if (ftruncate (fileno (filesink->file), 0))
@@ -641,6 +1008,8 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       filesink->current_buffer_size = 0;
       break;
     case GST_EVENT_EOS:
+      if (gst_file_sink_async_drain (filesink) != GST_FLOW_OK)
+        goto flush_buffer_failed;
       if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
         goto flush_buffer_failed;
       break;
@@ -746,35 +1115,47 @@ no_data:
 }
 
 static GstFlowReturn
-gst_file_sink_flush_buffer (GstFileSink * filesink)
+gst_file_sink_write_mem (GstFileSink * filesink, guint8 * data, gsize size)
 {
-  GstFlowReturn flow_ret = GST_FLOW_OK;
+  GstFlowReturn flow_ret;
+  guint64 skip = 0;
 
-  GST_DEBUG_OBJECT (filesink, "Flushing out buffer of size %" G_GSIZE_FORMAT,
-      filesink->current_buffer_size);
+  for (;;) {
+    guint64 bytes_written = 0;
 
-  if (filesink->buffer && filesink->current_buffer_size) {
-    guint64 skip = 0;
+    flow_ret =
+        gst_writev_mem (GST_OBJECT_CAST (filesink), fileno (filesink->file),
+        NULL, data, size, &bytes_written, skip,
+        filesink->max_transient_error_timeout, filesink->current_pos,
+        &filesink->flushing);
 
-    for (;;) {
-      guint64 bytes_written = 0;
+    filesink->current_pos += bytes_written;
+    skip += bytes_written;
 
-      flow_ret =
-          gst_writev_mem (GST_OBJECT_CAST (filesink), fileno (filesink->file),
-          NULL, filesink->buffer, filesink->current_buffer_size, &bytes_written,
-          skip, filesink->max_transient_error_timeout, filesink->current_pos,
-          &filesink->flushing);
+    if (flow_ret != GST_FLOW_FLUSHING)
+      break;
 
-      filesink->current_pos += bytes_written;
-      skip += bytes_written;
+    flow_ret = gst_base_sink_wait_preroll (GST_BASE_SINK (filesink));
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
 
-      if (flow_ret != GST_FLOW_FLUSHING)
-        break;
+  return flow_ret;
+}
 
-      flow_ret = gst_base_sink_wait_preroll (GST_BASE_SINK (filesink));
-      if (flow_ret != GST_FLOW_OK)
-        break;
-    }
+static GstFlowReturn
+gst_file_sink_flush_buffer (GstFileSink * filesink)
+{
+  GstFlowReturn flow_ret = GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (filesink, "Flushing out buffer of size %" G_GSIZE_FORMAT,
+      filesink->current_buffer_size);
+
+  if (filesink->direct_buffer) {
+    return gst_file_sink_flush_direct (filesink, TRUE);
+  } else if (filesink->buffer && filesink->current_buffer_size) {
+    flow_ret = gst_file_sink_write_mem (filesink, filesink->buffer,
+        filesink->current_buffer_size);
   } else if (filesink->buffer_list && filesink->current_buffer_size) {
     guint length;
 
@@ -846,6 +1227,191 @@ render_buffer (GstFileSink * filesink, GstBuffer * buffer)
   return flow;
 }
 
+/* O_DIRECT needs the file offset, the memory address and the size of every
+ * write to be aligned, so the unaligned head and tail of the data are
+ * written through the page cache */
+static GstFlowReturn
+gst_file_sink_write_unaligned (GstFileSink * filesink, guint8 * data,
+    gsize size)
+{
+#ifdef O_DIRECT
+  GstFlowReturn flow;
+
+  GST_LOG_OBJECT (filesink, "writing %" G_GSIZE_FORMAT " unaligned bytes at "
+      "position %" G_GUINT64_FORMAT, size, filesink->current_pos);
+
+  gst_file_sink_set_direct (filesink, FALSE);
+  flow = gst_file_sink_write_mem (filesink, data, size);
+  if (!gst_file_sink_set_direct (filesink, TRUE))
+    GST_WARNING_OBJECT (filesink, "failed to re-enable direct I/O: %s",
+        g_strerror (errno));
+
+  return flow;
+#else
+  g_assert_not_reached ();
+  return GST_FLOW_ERROR;
+#endif
+}
+
+/* write out all complete blocks of the staging buffer, or everything if
+ * @all is set. An incomplete last block is kept at the start of the
+ * staging buffer otherwise. */
+static GstFlowReturn
+gst_file_sink_flush_direct (GstFileSink * filesink, gboolean all)
+{
+  GstFlowReturn flow = GST_FLOW_OK;
+  gsize align = filesink->direct_align;
+  gsize start, end, aligned_start, aligned_end, tail = 0;
+  guint8 *data = filesink->direct_buffer;
+
+  if (filesink->current_buffer_size == 0)
+    return GST_FLOW_OK;
+
+  start = filesink->direct_offset;
+  end = start + filesink->current_buffer_size;
+  aligned_start = GST_ROUND_UP_N (start, align);
+  aligned_end = GST_ROUND_DOWN_N (end, align);
+
+  if (aligned_end <= aligned_start) {
+    /* no complete block */
+    flow = gst_file_sink_write_unaligned (filesink, data + start, end - start);
+    goto done;
+  }
+
+  if (start < aligned_start)
+    flow = gst_file_sink_write_unaligned (filesink, data + start,
+        aligned_start - start);
+
+  if (flow == GST_FLOW_OK) {
+    GST_LOG_OBJECT (filesink, "writing %" G_GSIZE_FORMAT " bytes at position %"
+        G_GUINT64_FORMAT, aligned_end - aligned_start, filesink->current_pos);
+    flow = gst_file_sink_write_mem (filesink, data + aligned_start,
+        aligned_end - aligned_start);
+  }
+
+  if (flow == GST_FLOW_OK && end > aligned_end) {
+    if (all) {
+      flow = gst_file_sink_write_unaligned (filesink, data + aligned_end,
+          end - aligned_end);
+    } else {
+      /* the tail now starts at an aligned file offset */
+      tail = end - aligned_end;
+      memmove (data, data + aligned_end, tail);
+    }
+  }
+
+done:
+  filesink->direct_offset = 0;
+  filesink->current_buffer_size = tail;
+
+  return flow;
+}
+
+static gboolean
+buffer_is_direct_io_aligned (GstBuffer * buffer, gsize align)
+{
+  guint i, n_mem;
+
+  n_mem = gst_buffer_n_memory (buffer);
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buffer, i);
+    GstMapInfo info;
+    gboolean aligned;
+
+    if ((mem->size & (align - 1)) != 0)
+      return FALSE;
+
+    if (!gst_memory_map (mem, &info, GST_MAP_READ))
+      return FALSE;
+    aligned = ((guintptr) info.data & (align - 1)) == 0;
+    gst_memory_unmap (mem, &info);
+
+    if (!aligned)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_file_sink_render_direct (GstFileSink * filesink, GstBuffer * buffer)
+{
+  GstFlowReturn flow = GST_FLOW_OK;
+  gsize size, offset = 0;
+
+  /* buffers from the pool we proposed can be written without a copy */
+  if (filesink->current_buffer_size == 0
+      && filesink->current_pos % filesink->direct_align == 0
+      && buffer_is_direct_io_aligned (buffer, filesink->direct_align)) {
+    GST_LOG_OBJECT (filesink, "writing aligned buffer at position %"
+        G_GUINT64_FORMAT, filesink->current_pos);
+    return render_buffer (filesink, buffer);
+  }
+
+  size = gst_buffer_get_size (buffer);
+  while (offset < size) {
+    gsize space;
+
+    if (filesink->current_buffer_size == 0)
+      filesink->direct_offset = filesink->current_pos % filesink->direct_align;
+
+    space = filesink->direct_buffer_size - filesink->direct_offset -
+        filesink->current_buffer_size;
+    if (space == 0) {
+      flow = gst_file_sink_flush_direct (filesink, FALSE);
+      if (flow != GST_FLOW_OK)
+        break;
+      continue;
+    }
+
+    space = gst_buffer_extract (buffer, offset,
+        filesink->direct_buffer + filesink->direct_offset +
+        filesink->current_buffer_size, MIN (space, size - offset));
+    filesink->current_buffer_size += space;
+    offset += space;
+  }
+
+  return flow;
+}
+
+static gboolean
+gst_file_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstFileSink *sink = GST_FILE_SINK_CAST (bsink);
+  GstAllocationParams params;
+  GstCaps *caps;
+  gboolean need_pool;
+
+  if (sink->direct_buffer == NULL)
+    return FALSE;
+
+  gst_allocation_params_init (&params);
+  params.align = sink->direct_align - 1;
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+
+  if (need_pool) {
+    GstBufferPool *pool;
+    GstStructure *config;
+    guint size = sink->direct_buffer_size;
+
+    pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, size, 0, 0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+    if (gst_buffer_pool_set_config (pool, config)) {
+      gst_query_add_allocation_pool (query, pool, size, 0, 0);
+    } else {
+      GST_WARNING_OBJECT (sink, "failed to configure aligned pool");
+    }
+    gst_object_unref (pool);
+  }
+
+  gst_query_add_allocation_param (query, NULL, &params);
+
+  return TRUE;
+}
+
 static GstFlowReturn
 gst_file_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
 {
@@ -863,7 +1429,19 @@ gst_file_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
 
   gst_buffer_list_foreach (buffer_list, has_sync_after_buffer, &sync_after);
 
-  if (sync_after || (!sink->buffer && !sink->buffer_list)) {
+  if (sink->writer) {
+    flow = gst_file_sink_async_push (sink, GST_MINI_OBJECT_CAST (buffer_list),
+        gst_buffer_list_calculate_size (buffer_list));
+    if (flow == GST_FLOW_OK && sync_after)
+      flow = gst_file_sink_async_drain (sink);
+  } else if (sink->direct_buffer) {
+    flow = GST_FLOW_OK;
+    for (i = 0; i < num_buffers && flow == GST_FLOW_OK; i++)
+      flow = gst_file_sink_render_direct (sink,
+          gst_buffer_list_get (buffer_list, i));
+    if (flow == GST_FLOW_OK && sync_after)
+      flow = gst_file_sink_flush_buffer (sink);
+  } else if (sync_after || (!sink->buffer && !sink->buffer_list)) {
     flow = gst_file_sink_flush_buffer (sink);
     if (flow == GST_FLOW_OK)
       flow = gst_file_sink_render_list_internal (sink, buffer_list);
@@ -952,7 +1530,16 @@ gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
 
   n_mem = gst_buffer_n_memory (buffer);
 
-  if (n_mem > 0 && (sync_after || (!filesink->buffer
+  if (n_mem > 0 && filesink->writer) {
+    flow = gst_file_sink_async_push (filesink, GST_MINI_OBJECT_CAST (buffer),
+        gst_buffer_get_size (buffer));
+    if (flow == GST_FLOW_OK && sync_after)
+      flow = gst_file_sink_async_drain (filesink);
+  } else if (n_mem > 0 && filesink->direct_buffer) {
+    flow = gst_file_sink_render_direct (filesink, buffer);
+    if (flow == GST_FLOW_OK && sync_after)
+      flow = gst_file_sink_flush_buffer (filesink);
+  } else if (n_mem > 0 && (sync_after || (!filesink->buffer
               && !filesink->buffer_list))) {
     flow = gst_file_sink_flush_buffer (filesink);
     if (flow == GST_FLOW_OK) {
@@ -96,6 +96,29 @@ struct _GstFileSink {
   gint max_transient_error_timeout;
 
   gboolean flushing;
+
+  /* For asynchronous writes */
+  gboolean async_write;
+  guint64 max_inflight_bytes;
+
+  GThread *writer;
+  GMutex async_lock;
+  GCond async_cond;
+  GQueue async_queue;
+  guint64 inflight_bytes;
+  gboolean writing;
+  gboolean writer_quit;
+  gboolean async_flushing;
+  GstFlowReturn async_flow;
+
+  /* For direct I/O, the staging buffer is aligned and the data starts at
+   * direct_offset so that it lines up with the file offset */
+  gboolean direct_io;
+  gsize direct_align;
+  guint8 *direct_mem;
+  guint8 *direct_buffer;
+  gsize direct_buffer_size;
+  gsize direct_offset;
 };
 
 struct _GstFileSinkClass {
@@ -31,6 +31,17 @@
  * gst-launch-1.0 filesrc location=song.ogg ! decodebin ! audioconvert ! audioresample ! autoaudiosink
  * ]| Play song.ogg audio file which must be in the current working directory.
  *
+ * Since 1.20, regular files can be mapped into memory instead of read by
+ * setting #GstFileSrc:read-mode to `mmap`. The pushed buffers then point
+ * directly into the page cache and are read-only. The file size is checked
+ * for every block and filesrc falls back to reading when the file was
+ * truncated. In `file-memory` mode every buffer gets its own file memory
+ * that is only mapped when the data is accessed, see gst_file_memory_new().
+ * This is meant for large blocks of huge files, where elements that only
+ * pass the data on or send it with sendfile() never touch the pages.
+ * #GstFileSrc:readahead can be used to ask the kernel to prefetch
+ * the data ahead of the current position in both modes.
+ *
  */
 
 #ifdef HAVE_CONFIG_H
@@ -41,6 +52,7 @@
 #include <glib/gstdio.h>
 #include "gstfilesrc.h"
 #include "gstcoreelementselements.h"
+#include "gstelements_private.h"
 
 #include <stdio.h>
 #include <sys/types.h>
@@ -79,6 +91,11 @@
 #include <errno.h>
 #include <string.h>
 
+#if defined(HAVE_SYS_MMAN_H) && !defined(G_OS_WIN32)
+#include <sys/mman.h>
+#define HAVE_MMAP 1
+#endif
+
 #include "../../gst/gst-i18n-lib.h"
 
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
@@ -110,11 +127,45 @@ enum
 };
 
 #define DEFAULT_BLOCKSIZE       4*1024
+#define DEFAULT_READ_MODE       GST_FILE_SRC_READ_MODE_READ
+#define DEFAULT_READAHEAD       0
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_READ_MODE,
+  PROP_READAHEAD
+};
+
+#define GST_TYPE_FILE_SRC_READ_MODE (gst_file_src_read_mode_get_type ())
+static GType
+gst_file_src_read_mode_get_type (void)
+{
+  static GType read_mode_type = 0;
+  static const GEnumValue read_mode[] = {
+    {GST_FILE_SRC_READ_MODE_READ, "Read into allocated buffers", "read"},
+    {GST_FILE_SRC_READ_MODE_MMAP, "Push buffers mapping the file", "mmap"},
+    {GST_FILE_SRC_READ_MODE_FILE_MEMORY,
+        "Push buffers of file memory that is mapped on demand", "file-memory"},
+    {0, NULL, NULL},
+  };
+
+  if (!read_mode_type) {
+    read_mode_type = g_enum_register_static ("GstFileSrcReadMode", read_mode);
+  }
+  return read_mode_type;
+}
+
+/* a read-only mapping of the file, shared by all the buffers pointing into
+ * it. The memories are marked with the file backing so that sinks can send
+ * the data straight from the file. */
+struct _GstFileSrcMapping
+{
+  gint refcount;
+  guint8 *data;
+  gsize size;
+  GstFileBacking *backing;
 };
 
 static void gst_file_src_finalize (GObject * object);
@@ -131,6 +182,10 @@ static gboolean gst_file_src_is_seekable (GstBaseSrc * src);
 static gboolean gst_file_src_get_size (GstBaseSrc * src, guint64 * size);
 static GstFlowReturn gst_file_src_fill (GstBaseSrc * src, guint64 offset,
     guint length, GstBuffer * buf);
+#ifdef HAVE_MMAP
+static GstFlowReturn gst_file_src_create (GstBaseSrc * src, guint64 offset,
+    guint length, GstBuffer ** buf);
+#endif
 
 static void gst_file_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
@@ -163,6 +218,40 @@ gst_file_src_class_init (GstFileSrcClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
 
+  /**
+   * GstFileSrc:read-mode:
+   *
+   * How to get the data of the file into buffers. In `mmap` mode regular
+   * files are mapped into memory and the pushed buffers are read-only and
+   * point into the mapping. In `file-memory` mode every buffer of a
+   * regular file is a view of the file that is only mapped when its data is
+   * accessed. Other files are always read.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_READ_MODE,
+      g_param_spec_enum ("read-mode", "Read Mode",
+          "How to get the data of the file into buffers",
+          GST_TYPE_FILE_SRC_READ_MODE, DEFAULT_READ_MODE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSrc:readahead:
+   *
+   * Number of bytes ahead of the read position that the kernel is asked to
+   * prefetch, so that reads can be served from the page cache. 0 leaves
+   * prefetching to the default heuristics of the system.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_READAHEAD,
+      g_param_spec_uint64 ("readahead", "Readahead",
+          "Bytes to prefetch ahead of the read position (0 = system default)",
+          0, G_MAXUINT64, DEFAULT_READAHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gobject_class->finalize = gst_file_src_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -177,6 +266,11 @@ gst_file_src_class_init (GstFileSrcClass * klass)
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_file_src_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_file_src_get_size);
   gstbasesrc_class->fill = GST_DEBUG_FUNCPTR (gst_file_src_fill);
+#ifdef HAVE_MMAP
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_file_src_create);
+#endif
+
+  gst_type_mark_as_plugin_api (GST_TYPE_FILE_SRC_READ_MODE, 0);
 
   if (sizeof (off_t) < 8) {
     GST_LOG ("No large file support, sizeof (off_t) = %" G_GSIZE_FORMAT "!",
@@ -193,6 +287,11 @@ gst_file_src_init (GstFileSrc * src)
 
   src->is_regular = FALSE;
 
+  src->read_mode = DEFAULT_READ_MODE;
+  src->readahead = DEFAULT_READAHEAD;
+  src->mapping = NULL;
+  src->file_memory = NULL;
+
   gst_base_src_set_blocksize (GST_BASE_SRC (src), DEFAULT_BLOCKSIZE);
 }
 
@@ -270,6 +369,12 @@ gst_file_src_set_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       gst_file_src_set_location (src, g_value_get_string (value), NULL);
       break;
+    case PROP_READ_MODE:
+      src->read_mode = g_value_get_enum (value);
+      break;
+    case PROP_READAHEAD:
+      src->readahead = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -290,12 +395,224 @@ gst_file_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCATION:
       g_value_set_string (value, src->filename);
       break;
+    case PROP_READ_MODE:
+      g_value_set_enum (value, src->read_mode);
+      break;
+    case PROP_READAHEAD:
+      g_value_set_uint64 (value, src->readahead);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* ask the kernel to prefetch the configured readahead after @offset. We
+ * always prefetch two windows and only renew them when we are half way
+ * through, so that there is not an extra syscall for every block. */
+static void
+gst_file_src_readahead (GstFileSrc * src, guint64 offset)
+{
+#ifdef HAVE_POSIX_FADVISE
+  guint64 start, end;
+
+  if (src->readahead == 0 || !src->is_regular)
+    return;
+
+  /* seeked backwards or far ahead, start over */
+  if (offset + src->readahead < src->readahead_end ||
+      offset > src->readahead_end)
+    src->readahead_end = offset;
+
+  if (offset + src->readahead <= src->readahead_end)
+    return;
+
+  start = src->readahead_end;
+  end = offset + 2 * src->readahead;
+
+  GST_LOG_OBJECT (src, "prefetching %" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT,
+      start, end);
+  posix_fadvise (src->fd, start, end - start, POSIX_FADV_WILLNEED);
+  src->readahead_end = end;
+#endif
+}
+
+#ifdef HAVE_MMAP
+static GstFileSrcMapping *
+gst_file_src_mapping_ref (GstFileSrcMapping * mapping)
+{
+  g_atomic_int_inc (&mapping->refcount);
+  return mapping;
+}
+
+static void
+gst_file_src_mapping_unref (GstFileSrcMapping * mapping)
+{
+  if (g_atomic_int_dec_and_test (&mapping->refcount)) {
+    munmap (mapping->data, mapping->size);
+    if (mapping->backing)
+      gst_file_backing_unref (mapping->backing);
+    g_slice_free (GstFileSrcMapping, mapping);
+  }
+}
+
+static void
+gst_file_src_clear_mapping (GstFileSrc * src)
+{
+  if (src->mapping) {
+    gst_file_src_mapping_unref (src->mapping);
+    src->mapping = NULL;
+  }
+}
+
+/* make sure we have a mapping covering @size bytes of the file */
+static gboolean
+gst_file_src_update_mapping (GstFileSrc * src, guint64 size)
+{
+  GstFileSrcMapping *mapping;
+  gpointer data;
+
+  if (src->mapping && src->mapping->size >= size)
+    return TRUE;
+
+  /* the file grew, map it again. Buffers pointing into the old mapping
+   * keep it alive */
+  if (size > G_MAXSIZE)
+    return FALSE;
+
+  data = mmap (NULL, size, PROT_READ, MAP_PRIVATE, src->fd, 0);
+  if (data == MAP_FAILED) {
+    GST_WARNING_OBJECT (src, "mmap failed: %s", g_strerror (errno));
+    return FALSE;
+  }
+#ifdef MADV_SEQUENTIAL
+  madvise (data, size, MADV_SEQUENTIAL);
+#endif
+
+  mapping = g_slice_new (GstFileSrcMapping);
+  mapping->refcount = 1;
+  mapping->data = data;
+  mapping->size = size;
+  mapping->backing = gst_file_backing_new (src->fd);
+
+  gst_file_src_clear_mapping (src);
+  src->mapping = mapping;
+
+  GST_DEBUG_OBJECT (src, "mapped %" G_GUINT64_FORMAT " bytes", size);
+
+  return TRUE;
+}
+
+/* get file memory for @length bytes at @offset, shared from one memory that
+ * covers the @size bytes of the file so that the fd is duplicated only once
+ * and not for every block */
+static GstMemory *
+gst_file_src_share_file_memory (GstFileSrc * src, guint64 offset,
+    guint length, guint64 size)
+{
+  if (src->file_memory == NULL || src->file_memory->size < size) {
+    GstMemory *mem;
+
+    if (size > G_MAXSIZE)
+      return NULL;
+
+    /* the file grew, buffers of the old memory keep it alive */
+    mem = gst_file_memory_new (src->fd, 0, size);
+    if (mem == NULL)
+      return NULL;
+
+    gst_clear_mini_object ((GstMiniObject **) & src->file_memory);
+    src->file_memory = mem;
+
+    GST_DEBUG_OBJECT (src, "file memory for %" G_GUINT64_FORMAT " bytes",
+        size);
+  }
+
+  return gst_memory_share (src->file_memory, offset, length);
+}
+
+static GstFlowReturn
+gst_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+  struct_stat stat_results;
+  GstMemory *mem;
+  GstBuffer *buf;
+
+  /* we can only wrap regular files and can't fill buffers from downstream
+   * without copying */
+  if (src->read_mode == GST_FILE_SRC_READ_MODE_READ || !src->is_regular ||
+      *buffer != NULL)
+    goto read_fallback;
+
+  if (offset == -1)
+    offset = src->read_position;
+
+  /* check the current size, a truncated file would make accessing the
+   * mapping fail. File memory checks the size itself when it is mapped. */
+  if (fstat (src->fd, &stat_results) < 0)
+    goto read_fallback;
+
+  if (src->mapping && (guint64) stat_results.st_size < src->mapping->size) {
+    GST_ELEMENT_WARNING (src, RESOURCE, READ, (NULL),
+        ("File \"%s\" was truncated, stopping to map it", src->filename));
+    gst_file_src_clear_mapping (src);
+    src->read_mode = GST_FILE_SRC_READ_MODE_READ;
+    goto read_fallback;
+  }
+
+  if (offset >= (guint64) stat_results.st_size) {
+    GST_DEBUG_OBJECT (src, "EOS");
+    return GST_FLOW_EOS;
+  }
+
+  length = MIN (length, stat_results.st_size - offset);
+
+  if (src->read_mode == GST_FILE_SRC_READ_MODE_FILE_MEMORY) {
+    mem = gst_file_src_share_file_memory (src, offset, length,
+        stat_results.st_size);
+    if (mem == NULL)
+      goto read_fallback;
+
+    GST_LOG_OBJECT (src, "File memory of %u bytes at offset 0x%"
+        G_GINT64_MODIFIER "x", length, offset);
+  } else {
+    if (!gst_file_src_update_mapping (src, stat_results.st_size))
+      goto read_fallback;
+
+    GST_LOG_OBJECT (src, "Wrapping %u bytes at offset 0x%" G_GINT64_MODIFIER
+        "x", length, offset);
+
+    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        src->mapping->data, src->mapping->size, offset, length,
+        gst_file_src_mapping_ref (src->mapping),
+        (GDestroyNotify) gst_file_src_mapping_unref);
+    if (src->mapping->backing)
+      gst_memory_set_file_backing (mem, src->mapping->backing);
+  }
+
+  gst_file_src_readahead (src, offset);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + length;
+
+  /* keep the position consistent with read mode, so that we can fall back
+   * at any time */
+  src->read_position = -1;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+read_fallback:
+  return GST_BASE_SRC_CLASS (parent_class)->create (basesrc, offset, length,
+      buffer);
+}
+#endif
+
 /***
  * read code below
  * that is to say, you shouldn't read the code below, but the code that reads
@@ -328,6 +645,8 @@ gst_file_src_fill (GstBaseSrc * basesrc, guint64 offset, guint length,
     src->read_position = offset;
   }
 
+  gst_file_src_readahead (src, src->read_position);
+
   if (!gst_buffer_map (buf, &info, GST_MAP_WRITE))
     goto buffer_write_fail;
   data = info.data;
@@ -509,6 +828,7 @@ gst_file_src_start (GstBaseSrc * basesrc)
 #endif
 
   src->read_position = 0;
+  src->readahead_end = 0;
 
   /* We need to check if the underlying file is seekable. */
   {
@@ -600,6 +920,12 @@ gst_file_src_stop (GstBaseSrc * basesrc)
 {
   GstFileSrc *src = GST_FILE_SRC (basesrc);
 
+#ifdef HAVE_MMAP
+  /* buffers that are still around keep their part of the file mapped */
+  gst_file_src_clear_mapping (src);
+  gst_clear_mini_object ((GstMiniObject **) & src->file_memory);
+#endif
+
   /* close the file */
   g_close (src->fd, NULL);
 
@@ -45,6 +45,25 @@ G_BEGIN_DECLS
 
 typedef struct _GstFileSrc GstFileSrc;
 typedef struct _GstFileSrcClass GstFileSrcClass;
+typedef struct _GstFileSrcMapping GstFileSrcMapping;
+
+/**
+ * GstFileSrcReadMode:
+ * @GST_FILE_SRC_READ_MODE_READ: Read the file into newly allocated buffers
+ * @GST_FILE_SRC_READ_MODE_MMAP: Map regular files into memory and push
+ *     read-only buffers that point into the mapping
+ * @GST_FILE_SRC_READ_MODE_FILE_MEMORY: Push read-only buffers of file memory
+ *     for regular files, that is only mapped when the data is accessed
+ *
+ * How filesrc gets the data of the file into buffers.
+ *
+ * Since: 1.20
+ */
+typedef enum {
+  GST_FILE_SRC_READ_MODE_READ,
+  GST_FILE_SRC_READ_MODE_MMAP,
+  GST_FILE_SRC_READ_MODE_FILE_MEMORY
+} GstFileSrcReadMode;
 
 /**
  * GstFileSrc:
@@ -63,6 +82,12 @@ struct _GstFileSrc {
   gboolean seekable;                    /* whether the file is seekable */
   gboolean is_regular;                  /* whether it's a (symlink to a)
                                            regular file */
+
+  GstFileSrcReadMode read_mode;
+  guint64 readahead;                    /* bytes to prefetch, 0 = off */
+  guint64 readahead_end;                /* end of the prefetched range */
+  GstFileSrcMapping *mapping;           /* current mapping of the file */
+  GstMemory *file_memory;               /* file memory covering the file */
 };
 
 struct _GstFileSrcClass {
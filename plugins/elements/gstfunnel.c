@@ -64,7 +64,7 @@ struct _GstFunnelPad
 {
   GstPad parent;
 
-  gboolean got_eos;
+  gboolean got_eos;             /* atomic */
 };
 
 struct _GstFunnelPadClass
@@ -175,6 +175,16 @@ restart:
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_funnel_finalize (GObject * object)
+{
+  GstFunnel *funnel = GST_FUNNEL_CAST (object);
+
+  gst_pad_array_cache_clear (&funnel->sinkpads);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_funnel_class_init (GstFunnelClass * klass)
 {
@@ -184,6 +194,7 @@ gst_funnel_class_init (GstFunnelClass * klass)
   gobject_class->set_property = gst_funnel_set_property;
   gobject_class->get_property = gst_funnel_get_property;
   gobject_class->dispose = GST_DEBUG_FUNCPTR (gst_funnel_dispose);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_funnel_finalize);
 
   g_object_class_install_property (gobject_class, PROP_FORWARD_STICKY_EVENTS,
       g_param_spec_boolean ("forward-sticky-events", "Forward sticky events",
@@ -214,6 +225,7 @@ gst_funnel_init (GstFunnel * funnel)
   gst_element_add_pad (GST_ELEMENT (funnel), funnel->srcpad);
 
   funnel->forward_sticky_events = DEFAULT_FORWARD_STICKY_EVENTS;
+  gst_pad_array_cache_init (&funnel->sinkpads);
 }
 
 static GstPad *
@@ -242,6 +254,11 @@ gst_funnel_request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   gst_element_add_pad (element, sinkpad);
 
+  GST_OBJECT_LOCK (element);
+  gst_pad_array_cache_set (&GST_FUNNEL_CAST (element)->sinkpads,
+      element->sinkpads);
+  GST_OBJECT_UNLOCK (element);
+
   GST_DEBUG_OBJECT (element, "requested pad %s:%s",
       GST_DEBUG_PAD_NAME (sinkpad));
 
@@ -249,28 +266,21 @@ gst_funnel_request_new_pad (GstElement * element, GstPadTemplate * templ,
 }
 
 static gboolean
-gst_funnel_all_sinkpads_eos_unlocked (GstFunnel * funnel, GstPad * pad)
+gst_funnel_all_sinkpads_eos (GstPadArray * pads)
 {
-  GstElement *element = GST_ELEMENT_CAST (funnel);
-  GList *item;
-  gboolean all_eos = FALSE;
-
+  guint i;
 
-  if (element->numsinkpads == 0)
-    goto done;
+  if (pads->n_pads == 0)
+    return FALSE;
 
-  for (item = element->sinkpads; item != NULL; item = g_list_next (item)) {
-    GstFunnelPad *sinkpad = GST_FUNNEL_PAD_CAST (item->data);
+  for (i = 0; i < pads->n_pads; i++) {
+    GstFunnelPad *sinkpad = GST_FUNNEL_PAD_CAST (pads->pads[i]);
 
-    if (!sinkpad->got_eos) {
+    if (!g_atomic_int_get (&sinkpad->got_eos))
       return FALSE;
-    }
   }
 
-  all_eos = TRUE;
-
-done:
-  return all_eos;
+  return TRUE;
 }
 
 static void
@@ -285,12 +295,13 @@ gst_funnel_release_pad (GstElement * element, GstPad * pad)
 
   gst_pad_set_active (pad, FALSE);
 
-  got_eos = fpad->got_eos;
+  got_eos = g_atomic_int_get (&fpad->got_eos);
 
   gst_element_remove_pad (GST_ELEMENT_CAST (funnel), pad);
 
   GST_OBJECT_LOCK (funnel);
-  if (!got_eos && gst_funnel_all_sinkpads_eos_unlocked (funnel, NULL)) {
+  gst_pad_array_cache_set (&funnel->sinkpads, element->sinkpads);
+  if (!got_eos && gst_funnel_all_sinkpads_eos (funnel->sinkpads.current)) {
     GST_DEBUG_OBJECT (funnel, "Pad removed. All others are EOS. Sending EOS");
     send_eos = TRUE;
   }
@@ -379,23 +390,20 @@ gst_funnel_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     GST_PAD_STREAM_LOCK (funnel->srcpad);
 
     if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
-      GST_OBJECT_LOCK (funnel);
-      fpad->got_eos = TRUE;
-      if (!gst_funnel_all_sinkpads_eos_unlocked (funnel, pad)) {
-        forward = FALSE;
-      } else {
-        forward = TRUE;
-      }
-      GST_OBJECT_UNLOCK (funnel);
+      GstPadArray *pads;
+
+      g_atomic_int_set (&fpad->got_eos, TRUE);
+      pads = gst_pad_array_cache_get (&funnel->sinkpads,
+          GST_OBJECT_CAST (funnel));
+      forward = gst_funnel_all_sinkpads_eos (pads);
+      gst_pad_array_unref (pads);
     } else if (pad != funnel->last_sinkpad) {
       forward = FALSE;
     }
   } else if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
     unlock = TRUE;
     GST_PAD_STREAM_LOCK (funnel->srcpad);
-    GST_OBJECT_LOCK (funnel);
-    fpad->got_eos = FALSE;
-    GST_OBJECT_UNLOCK (funnel);
+    g_atomic_int_set (&fpad->got_eos, FALSE);
   }
 
   if (forward && GST_EVENT_IS_SERIALIZED (event)) {
@@ -431,11 +439,8 @@ reset_pad (const GValue * data, gpointer user_data)
 {
   GstPad *pad = g_value_get_object (data);
   GstFunnelPad *fpad = GST_FUNNEL_PAD_CAST (pad);
-  GstFunnel *funnel = user_data;
 
-  GST_OBJECT_LOCK (funnel);
-  fpad->got_eos = FALSE;
-  GST_OBJECT_UNLOCK (funnel);
+  g_atomic_int_set (&fpad->got_eos, FALSE);
 }
 
 static GstStateChangeReturn
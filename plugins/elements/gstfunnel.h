@@ -28,6 +28,8 @@
 
 #include <gst/gst.h>
 
+#include "gstelements_private.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_FUNNEL \
@@ -58,6 +60,9 @@ struct _GstFunnel {
 
   GstPad *last_sinkpad;
   gboolean forward_sticky_events;
+
+  /* snapshot of the sinkpads, used with the srcpad STREAM_LOCK */
+  GstPadArrayCache sinkpads;
 };
 
 struct _GstFunnelClass {
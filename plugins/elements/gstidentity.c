@@ -26,6 +26,11 @@
  *
  * Dummy element that passes incoming data through unmodified. It has some
  * useful diagnostic functions, such as offset and timestamp checking.
+ *
+ * Since 1.20, #GstIdentity:checksum computes a checksum over all the data that
+ * passes through, which is reported in #GstIdentity:stats. Two identity
+ * elements at both ends of a pipeline that should not modify the data must
+ * report the same checksum.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -35,6 +40,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
 #include "gstelements_private.h"
 #include "../../gst/gst-i18n-lib.h"
 #include "gstidentity.h"
@@ -77,6 +86,7 @@ enum
 #define DEFAULT_TS_OFFSET               0
 #define DEFAULT_DROP_ALLOCATION         FALSE
 #define DEFAULT_EOS_AFTER               -1
+#define DEFAULT_CHECKSUM                GST_IDENTITY_CHECKSUM_NONE
 
 enum
 {
@@ -97,9 +107,112 @@ enum
   PROP_SIGNAL_HANDOFFS,
   PROP_DROP_ALLOCATION,
   PROP_EOS_AFTER,
-  PROP_STATS
+  PROP_STATS,
+  PROP_CHECKSUM
 };
 
+#define GST_TYPE_IDENTITY_CHECKSUM (gst_identity_checksum_get_type ())
+static GType
+gst_identity_checksum_get_type (void)
+{
+  static GType checksum_type = 0;
+  static const GEnumValue checksum[] = {
+    {GST_IDENTITY_CHECKSUM_NONE, "No checksum", "none"},
+    {GST_IDENTITY_CHECKSUM_CRC32C, "CRC-32C (Castagnoli)", "crc32c"},
+    {0, NULL, NULL},
+  };
+
+  if (!checksum_type) {
+    checksum_type = g_enum_register_static ("GstIdentityChecksum", checksum);
+  }
+  return checksum_type;
+}
+
+#ifndef __SSE4_2__
+/* slicing-by-8 tables for the reflected CRC-32C polynomial, filled in
+ * class_init */
+static guint32 crc32c_table[8][256];
+
+static void
+gst_identity_crc32c_init (void)
+{
+  guint32 i, j, crc;
+
+  for (i = 0; i < 256; i++) {
+    crc = i;
+    for (j = 0; j < 8; j++)
+      crc = (crc >> 1) ^ (0x82f63b78 & -(crc & 1));
+    crc32c_table[0][i] = crc;
+  }
+  for (i = 0; i < 256; i++) {
+    crc = crc32c_table[0][i];
+    for (j = 1; j < 8; j++) {
+      crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+      crc32c_table[j][i] = crc;
+    }
+  }
+}
+#endif
+
+static guint32
+gst_identity_crc32c_update (guint32 crc, const guint8 * data, gsize size)
+{
+  crc = ~crc;
+
+#ifdef __SSE4_2__
+  while (size > 0 && ((guintptr) data & 7)) {
+    crc = _mm_crc32_u8 (crc, *data++);
+    size--;
+  }
+#if GLIB_SIZEOF_VOID_P == 8
+  for (; size >= 8; size -= 8, data += 8)
+    crc = (guint32) _mm_crc32_u64 (crc, *(const guint64 *) data);
+#endif
+  for (; size >= 4; size -= 4, data += 4)
+    crc = _mm_crc32_u32 (crc, *(const guint32 *) data);
+  while (size-- > 0)
+    crc = _mm_crc32_u8 (crc, *data++);
+#else
+  for (; size >= 8; size -= 8, data += 8) {
+    guint32 lo = GST_READ_UINT32_LE (data) ^ crc;
+    guint32 hi = GST_READ_UINT32_LE (data + 4);
+
+    crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+        crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+        crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+        crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+  }
+  while (size-- > 0)
+    crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+#endif
+
+  return ~crc;
+}
+
+/* continues the checksum of the stream with the data of @buf. The memories
+ * are mapped one by one, mapping the buffer could merge them into a copy. */
+static guint32
+gst_identity_checksum_buffer (GstIdentity * identity, guint32 crc,
+    GstBuffer * buf)
+{
+  guint i, n_mem;
+
+  n_mem = gst_buffer_n_memory (buf);
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem = gst_buffer_peek_memory (buf, i);
+    GstMapInfo info;
+
+    if (!gst_memory_map (mem, &info, GST_MAP_READ)) {
+      GST_WARNING_OBJECT (identity, "failed to map memory %u", i);
+      continue;
+    }
+    crc = gst_identity_crc32c_update (crc, info.data, info.size);
+    gst_memory_unmap (mem, &info);
+  }
+
+  return crc;
+}
+
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_identity_debug, "identity", 0, "identity element");
@@ -121,6 +234,8 @@ static gboolean gst_identity_src_event (GstBaseTransform * trans,
     GstEvent * event);
 static GstFlowReturn gst_identity_transform_ip (GstBaseTransform * trans,
     GstBuffer * buf);
+static GstFlowReturn gst_identity_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list);
 static gboolean gst_identity_start (GstBaseTransform * trans);
 static gboolean gst_identity_stop (GstBaseTransform * trans);
 static GstStateChangeReturn gst_identity_change_state (GstElement * element,
@@ -292,6 +407,14 @@ gst_identity_class_init (GstIdentityClass * klass)
    *   the number of bytes that passed through.
    *   </para>
    * </listitem>
+   * <listitem>
+   *   <para>
+   *   #guint
+   *   <classname>&quot;checksum&quot;</classname>:
+   *   the checksum of the data that passed through, only present when
+   *   #GstIdentity:checksum is set (Since: 1.20).
+   *   </para>
+   * </listitem>
    * </itemizedlist>
    *
    * Since: 1.20
@@ -301,6 +424,25 @@ gst_identity_class_init (GstIdentityClass * klass)
           "Statistics", GST_TYPE_STRUCTURE,
           G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstIdentity:checksum:
+   *
+   * Compute a checksum over all the data that passes through. The checksum
+   * of the stream so far is the #guint "checksum" field of
+   * #GstIdentity:stats. It is reset when the element goes from READY to
+   * PAUSED, dropped buffers are not included.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_CHECKSUM,
+      g_param_spec_enum ("checksum", "Checksum",
+          "Checksum to compute over the data", GST_TYPE_IDENTITY_CHECKSUM,
+          DEFAULT_CHECKSUM, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+#ifndef __SSE4_2__
+  gst_identity_crc32c_init ();
+#endif
+
   gobject_class->finalize = gst_identity_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -324,6 +466,8 @@ gst_identity_class_init (GstIdentityClass * klass)
   gstbasetrans_class->accept_caps =
       GST_DEBUG_FUNCPTR (gst_identity_accept_caps);
   gstbasetrans_class->query = gst_identity_query;
+
+  gst_type_mark_as_plugin_api (GST_TYPE_IDENTITY_CHECKSUM, 0);
 }
 
 static void
@@ -347,8 +491,11 @@ gst_identity_init (GstIdentity * identity)
   g_cond_init (&identity->blocked_cond);
   identity->eos_after = DEFAULT_EOS_AFTER;
   identity->eos_after_counter = DEFAULT_EOS_AFTER;
+  identity->checksum = DEFAULT_CHECKSUM;
 
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (identity), TRUE);
+  gst_pad_set_chain_list_function (GST_BASE_TRANSFORM_SINK_PAD (identity),
+      GST_DEBUG_FUNCPTR (gst_identity_chain_list));
 
   GST_OBJECT_FLAG_SET (identity, GST_ELEMENT_FLAG_REQUIRE_CLOCK);
 }
@@ -722,6 +869,7 @@ gst_identity_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   GstClockTime rundts = GST_CLOCK_TIME_NONE;
   GstClockTime runpts = GST_CLOCK_TIME_NONE;
   GstClockTime ts, duration, runtimestamp;
+  guint32 checksum_value = 0;
   gsize size;
 
   size = gst_buffer_get_size (buf);
@@ -757,6 +905,10 @@ gst_identity_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   if (GST_BUFFER_FLAG_IS_SET (buf, identity->drop_buffer_flags))
     goto dropped;
 
+  if (identity->checksum != GST_IDENTITY_CHECKSUM_NONE)
+    checksum_value = gst_identity_checksum_buffer (identity,
+        identity->checksum_value, buf);
+
   if (identity->dump) {
     GstMapInfo info;
 
@@ -823,6 +975,8 @@ gst_identity_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
   GST_OBJECT_LOCK (trans);
   identity->num_bytes += gst_buffer_get_size (buf);
   identity->num_buffers++;
+  if (identity->checksum != GST_IDENTITY_CHECKSUM_NONE)
+    identity->checksum_value = checksum_value;
   GST_OBJECT_UNLOCK (trans);
 
   return ret;
@@ -858,6 +1012,66 @@ dropped:
   }
 }
 
+/* Whether transform_ip would do nothing but bookkeeping for every buffer */
+static gboolean
+gst_identity_is_plain_passthrough (GstIdentity * identity)
+{
+  if (identity->sync || identity->check_imperfect_timestamp
+      || identity->check_imperfect_offset || identity->error_after_counter >= 0
+      || identity->eos_after_counter >= 0 || identity->drop_probability > 0.0
+      || identity->drop_buffer_flags != 0 || identity->dump
+      || !identity->silent || identity->sleep_time != 0
+      || identity->checksum != GST_IDENTITY_CHECKSUM_NONE)
+    return FALSE;
+
+  /* datarate and single-segment disable passthrough */
+  if (!gst_base_transform_is_passthrough (GST_BASE_TRANSFORM_CAST (identity)))
+    return FALSE;
+
+  if (identity->signal_handoffs &&
+      g_signal_has_handler_pending (identity,
+          gst_identity_signals[SIGNAL_HANDOFF], 0, TRUE))
+    return FALSE;
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_identity_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (parent);
+  GstIdentity *identity = GST_IDENTITY (parent);
+  guint i, len;
+  guint64 num_bytes = 0;
+  GstBuffer *buf;
+
+  len = gst_buffer_list_length (list);
+
+  if (len == 0 || !gst_identity_is_plain_passthrough (identity)
+      || !gst_base_transform_can_push_list (trans))
+    return gst_pad_chain_list_buffers (pad, parent, list);
+
+  for (i = 0; i < len; i++)
+    num_bytes += gst_buffer_get_size (gst_buffer_list_get (list, i));
+
+  /* update prev values */
+  buf = gst_buffer_list_get (list, len - 1);
+  identity->prev_timestamp = GST_BUFFER_TIMESTAMP (buf);
+  identity->prev_duration = GST_BUFFER_DURATION (buf);
+  identity->prev_offset_end = GST_BUFFER_OFFSET_END (buf);
+  identity->prev_offset = GST_BUFFER_OFFSET (buf);
+
+  identity->offset += num_bytes;
+
+  GST_OBJECT_LOCK (trans);
+  identity->num_bytes += num_bytes;
+  identity->num_buffers += len;
+  GST_OBJECT_UNLOCK (trans);
+
+  return gst_base_transform_push_list (trans, list);
+}
+
 static void
 gst_identity_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -932,6 +1146,9 @@ gst_identity_set_property (GObject * object, guint prop_id,
     case PROP_EOS_AFTER:
       identity->eos_after = g_value_get_int (value);
       break;
+    case PROP_CHECKSUM:
+      identity->checksum = g_value_get_enum (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -951,6 +1168,9 @@ gst_identity_create_stats (GstIdentity * identity)
   s = gst_structure_new ("application/x-identity-stats",
       "num-bytes", G_TYPE_UINT64, identity->num_bytes,
       "num-buffers", G_TYPE_UINT64, identity->num_buffers, NULL);
+  if (identity->checksum != GST_IDENTITY_CHECKSUM_NONE)
+    gst_structure_set (s, "checksum", G_TYPE_UINT, identity->checksum_value,
+        NULL);
   GST_OBJECT_UNLOCK (identity);
 
   return s;
@@ -1018,6 +1238,9 @@ gst_identity_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_STATS:
       g_value_take_boxed (value, gst_identity_create_stats (identity));
       break;
+    case PROP_CHECKSUM:
+      g_value_set_enum (value, identity->checksum);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1158,6 +1381,7 @@ gst_identity_change_state (GstElement * element, GstStateChange transition)
         no_preroll = TRUE;
       identity->num_bytes = 0;
       identity->num_buffers = 0;
+      identity->checksum_value = 0;
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       GST_OBJECT_LOCK (identity);
@@ -42,6 +42,20 @@ G_BEGIN_DECLS
 #define GST_IS_IDENTITY_CLASS(klass) \
   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_IDENTITY))
 
+/**
+ * GstIdentityChecksum:
+ * @GST_IDENTITY_CHECKSUM_NONE: don't checksum the data
+ * @GST_IDENTITY_CHECKSUM_CRC32C: CRC-32C (Castagnoli)
+ *
+ * The checksum that is computed over the data passing through.
+ *
+ * Since: 1.20
+ */
+typedef enum {
+  GST_IDENTITY_CHECKSUM_NONE,
+  GST_IDENTITY_CHECKSUM_CRC32C
+} GstIdentityChecksum;
+
 typedef struct _GstIdentity GstIdentity;
 typedef struct _GstIdentityClass GstIdentityClass;
 
@@ -85,6 +99,8 @@ struct _GstIdentity {
   gint           eos_after_counter;
   guint64        num_bytes;
   guint64        num_buffers;
+  GstIdentityChecksum checksum;
+  guint32        checksum_value;
 };
 
 struct _GstIdentityClass {
@@ -125,6 +125,7 @@ static inline gboolean gst_input_selector_is_active_sinkpad (GstInputSelector *
 static GstPad *gst_input_selector_get_active_sinkpad (GstInputSelector * sel);
 static GstPad *gst_input_selector_get_linked_pad (GstInputSelector * sel,
     GstPad * pad, gboolean strict);
+static void gst_input_selector_wake_all (GstInputSelector * sel);
 
 #define GST_TYPE_SELECTOR_PAD \
   (gst_selector_pad_get_type())
@@ -165,6 +166,9 @@ struct _GstSelectorPad
 
   gboolean sending_cached_buffers;
   GQueue *cached_buffers;
+
+  GstClockID clock_id;          /* running time wait in clock sync-mode,
+                                   protected by the SELECTOR_LOCK */
 };
 
 struct _GstSelectorPadCachedBuffer
@@ -195,6 +199,8 @@ static GstIterator *gst_selector_pad_iterate_linked_pads (GstPad * pad,
     GstObject * parent);
 static GstFlowReturn gst_selector_pad_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_selector_pad_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static void gst_selector_pad_cache_buffer (GstSelectorPad * selpad,
     GstBuffer * buffer);
 static void gst_selector_pad_free_cached_buffers (GstSelectorPad * selpad);
@@ -558,6 +564,8 @@ gst_selector_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       selpad->flushing = TRUE;
       sel->eos = FALSE;
       selpad->group_done = FALSE;
+      if (selpad->clock_id)
+        gst_clock_id_unschedule (selpad->clock_id);
       GST_INPUT_SELECTOR_BROADCAST (sel);
       break;
     case GST_EVENT_FLUSH_STOP:
@@ -574,21 +582,22 @@ gst_selector_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
     }
     case GST_EVENT_TAG:
     {
-      GstTagList *tags, *oldtags, *newtags;
+      GstTagList *tags;
 
       gst_event_parse_tag (event, &tags);
 
       GST_OBJECT_LOCK (selpad);
-      oldtags = selpad->tags;
-
-      newtags = gst_tag_list_merge (oldtags, tags, GST_TAG_MERGE_REPLACE);
-      selpad->tags = newtags;
+      /* merge in place, this only copies the list when someone else is
+       * still holding on to it */
+      if (selpad->tags) {
+        selpad->tags = gst_tag_list_make_writable (selpad->tags);
+        gst_tag_list_insert (selpad->tags, tags, GST_TAG_MERGE_REPLACE);
+      } else {
+        selpad->tags = gst_tag_list_copy (tags);
+      }
+      GST_DEBUG_OBJECT (pad, "received tags %" GST_PTR_FORMAT, selpad->tags);
       GST_OBJECT_UNLOCK (selpad);
 
-      if (oldtags)
-        gst_tag_list_unref (oldtags);
-      GST_DEBUG_OBJECT (pad, "received tags %" GST_PTR_FORMAT, newtags);
-
       new_tags = TRUE;
       break;
     }
@@ -598,7 +607,7 @@ gst_selector_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       if (gst_input_selector_all_eos (sel)) {
         GST_DEBUG_OBJECT (pad, "All sink pad received EOS");
         sel->eos = TRUE;
-        GST_INPUT_SELECTOR_BROADCAST (sel);
+        gst_input_selector_wake_all (sel);
       } else {
         gst_input_selector_eos_wait (sel, selpad, event);
         forward = FALSE;
@@ -630,7 +639,7 @@ gst_selector_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
       gst_event_parse_stream_group_done (event, &selpad->group_id);
       selpad->group_done = TRUE;
       if (sel->sync_streams && active_sinkpad == pad)
-        GST_INPUT_SELECTOR_BROADCAST (sel);
+        gst_input_selector_wake_all (sel);
       break;
     }
     default:
@@ -751,6 +760,7 @@ gst_input_selector_wait_running_time (GstInputSelector * sel,
     GstPad *active_sinkpad;
     GstSelectorPad *active_selpad;
     GstClock *clock;
+    GstClockTime base_time;
     gint64 cur_running_time;
     GstClockTime running_time;
 
@@ -774,19 +784,17 @@ gst_input_selector_wait_running_time (GstInputSelector * sel,
     }
 
     cur_running_time = GST_CLOCK_TIME_NONE;
+    clock = NULL;
+    base_time = 0;
     if (sel->sync_mode == GST_INPUT_SELECTOR_SYNC_MODE_CLOCK) {
       clock = gst_element_get_clock (GST_ELEMENT_CAST (sel));
       if (clock) {
-        GstClockTime base_time;
-
         cur_running_time = gst_clock_get_time (clock);
         base_time = gst_element_get_base_time (GST_ELEMENT_CAST (sel));
         if (base_time <= cur_running_time)
           cur_running_time -= base_time;
         else
           cur_running_time = 0;
-
-        gst_object_unref (clock);
       }
     } else {
       GstSegment *active_seg;
@@ -815,6 +823,8 @@ gst_input_selector_wait_running_time (GstInputSelector * sel,
         selpad->group_id == active_selpad->group_id) {
       GST_DEBUG_OBJECT (selpad, "Active pad received group-done. Unblocking");
       GST_INPUT_SELECTOR_UNLOCK (sel);
+      if (clock)
+        gst_object_unref (clock);
       break;
     }
 
@@ -825,9 +835,24 @@ gst_input_selector_wait_running_time (GstInputSelector * sel,
           "Waiting for active streams to advance. %" GST_TIME_FORMAT " >= %"
           GST_TIME_FORMAT, GST_TIME_ARGS (running_time),
           GST_TIME_ARGS (cur_running_time));
-      GST_INPUT_SELECTOR_WAIT (sel);
+      if (clock) {
+        /* only the clock makes us progress, wait for it on our own instead
+         * of being woken up for every buffer of the active pad */
+        selpad->clock_id =
+            gst_clock_new_single_shot_id (clock, base_time + running_time);
+        GST_INPUT_SELECTOR_UNLOCK (sel);
+        gst_clock_id_wait (selpad->clock_id, NULL);
+        GST_INPUT_SELECTOR_LOCK (sel);
+        gst_clock_id_unref (selpad->clock_id);
+        selpad->clock_id = NULL;
+        gst_object_unref (clock);
+      } else {
+        GST_INPUT_SELECTOR_WAIT (sel);
+      }
     } else {
       GST_INPUT_SELECTOR_UNLOCK (sel);
+      if (clock)
+        gst_object_unref (clock);
       break;
     }
   }
@@ -981,23 +1006,69 @@ gst_input_selector_cleanup_old_cached_buffers (GstInputSelector * sel,
 #endif
 }
 
+/* Chains @data, a #GstBuffer or a #GstBufferList. Lists are forwarded as a
+ * whole unless sync-streams is enabled, in which case every buffer has to
+ * wait for the running time of the active pad and might need to be cached,
+ * and the buffers are chained one by one */
 static GstFlowReturn
-gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+gst_selector_pad_chain_data (GstPad * pad, GstObject * parent,
+    GstMiniObject * data)
 {
   GstInputSelector *sel;
   GstFlowReturn res;
   GstPad *active_sinkpad;
   GstPad *prev_active_sinkpad = NULL;
   GstSelectorPad *selpad;
+  GstBuffer *buf = NULL;
+  GstBufferList *list = NULL;
+  GstBuffer *pos_buf;
 
   sel = GST_INPUT_SELECTOR (parent);
   selpad = GST_SELECTOR_PAD_CAST (pad);
 
-  GST_DEBUG_OBJECT (selpad,
-      "entering chain for buf %p with timestamp %" GST_TIME_FORMAT, buf,
-      GST_TIME_ARGS (GST_BUFFER_PTS (buf)));
+  if (GST_IS_BUFFER_LIST (data)) {
+    guint i;
 
-  GST_INPUT_SELECTOR_LOCK (sel);
+    list = GST_BUFFER_LIST_CAST (data);
+
+    GST_INPUT_SELECTOR_LOCK (sel);
+    if (sel->sync_streams) {
+      guint len = gst_buffer_list_length (list);
+
+      GST_INPUT_SELECTOR_UNLOCK (sel);
+
+      res = GST_FLOW_OK;
+      for (i = 0; i < len; i++) {
+        res = gst_selector_pad_chain (pad, parent,
+            gst_buffer_ref (gst_buffer_list_get (list, i)));
+        if (res != GST_FLOW_OK)
+          break;
+      }
+      gst_buffer_list_unref (list);
+
+      return res;
+    }
+
+    GST_DEBUG_OBJECT (selpad, "entering chain for list %p of %u buffers",
+        list, gst_buffer_list_length (list));
+
+    /* the segment position is updated with the last valid timestamp */
+    pos_buf = NULL;
+    for (i = gst_buffer_list_length (list); i > 0; i--) {
+      if (GST_BUFFER_PTS_IS_VALID (gst_buffer_list_get (list, i - 1))) {
+        pos_buf = gst_buffer_list_get (list, i - 1);
+        break;
+      }
+    }
+  } else {
+    buf = pos_buf = GST_BUFFER_CAST (data);
+
+    GST_DEBUG_OBJECT (selpad,
+        "entering chain for buf %p with timestamp %" GST_TIME_FORMAT, buf,
+        GST_TIME_ARGS (GST_BUFFER_PTS (buf)));
+
+    GST_INPUT_SELECTOR_LOCK (sel);
+  }
 
   if (sel->flushing) {
     GST_INPUT_SELECTOR_UNLOCK (sel);
@@ -1012,7 +1083,7 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   /* In sync mode wait until the active pad has advanced
    * after the running time of the current buffer */
-  if (sel->sync_streams) {
+  if (buf && sel->sync_streams) {
     /* call chain for each cached buffer if we are not the active pad
      * or if we are the active pad but didn't push anything yet. */
     if (active_sinkpad != pad || !selpad->pushed) {
@@ -1069,14 +1140,14 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   }
 
   /* update the segment on the srcpad */
-  if (GST_BUFFER_PTS_IS_VALID (buf)) {
-    GstClockTime start_time = GST_BUFFER_PTS (buf);
+  if (pos_buf && GST_BUFFER_PTS_IS_VALID (pos_buf)) {
+    GstClockTime start_time = GST_BUFFER_PTS (pos_buf);
 
     GST_LOG_OBJECT (pad, "received start time %" GST_TIME_FORMAT,
         GST_TIME_ARGS (start_time));
-    if (GST_BUFFER_DURATION_IS_VALID (buf))
+    if (GST_BUFFER_DURATION_IS_VALID (pos_buf))
       GST_LOG_OBJECT (pad, "received end time %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (start_time + GST_BUFFER_DURATION (buf)));
+          GST_TIME_ARGS (start_time + GST_BUFFER_DURATION (pos_buf)));
 
     GST_OBJECT_LOCK (pad);
     selpad->segment.position = start_time;
@@ -1087,8 +1158,10 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   if (pad != active_sinkpad)
     goto ignore;
 
-  /* Tell all non-active pads that we advanced the running time */
-  if (sel->sync_streams)
+  /* Tell all non-active pads that we advanced the running time, in clock
+   * sync-mode they wait for the clock instead */
+  if (sel->sync_streams
+      && sel->sync_mode != GST_INPUT_SELECTOR_SYNC_MODE_CLOCK)
     GST_INPUT_SELECTOR_BROADCAST (sel);
 
   GST_INPUT_SELECTOR_UNLOCK (sel);
@@ -1113,6 +1186,27 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     prev_active_sinkpad = NULL;
   }
 
+  if (list) {
+    if (selpad->discont && gst_buffer_list_length (list) > 0) {
+      list = gst_buffer_list_make_writable (list);
+      buf = gst_buffer_list_get_writable (list, 0);
+
+      GST_DEBUG_OBJECT (pad, "Marking discont buffer %p", buf);
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+      selpad->discont = FALSE;
+    }
+
+    GST_LOG_OBJECT (pad, "Forwarding buffer list %p", list);
+    res = gst_pad_push_list (sel->srcpad, list);
+    GST_LOG_OBJECT (pad, "Buffer list %p forwarded result=%d", list, res);
+
+    GST_INPUT_SELECTOR_LOCK (sel);
+    selpad->pushed = TRUE;
+    GST_INPUT_SELECTOR_UNLOCK (sel);
+
+    goto done;
+  }
+
   if (selpad->discont) {
     buf = gst_buffer_make_writable (buf);
 
@@ -1161,11 +1255,11 @@ ignore:
   {
     gboolean active_pad_pushed = GST_SELECTOR_PAD_CAST (active_sinkpad)->pushed;
 
-    GST_DEBUG_OBJECT (pad, "Pad not active, discard buffer %p", buf);
+    GST_DEBUG_OBJECT (pad, "Pad not active, discard %p", data);
     /* when we drop a buffer, we're creating a discont on this pad */
     selpad->discont = TRUE;
     GST_INPUT_SELECTOR_UNLOCK (sel);
-    gst_buffer_unref (buf);
+    gst_mini_object_unref (data);
 
     /* figure out what to return upstream */
     GST_OBJECT_LOCK (selpad);
@@ -1179,13 +1273,27 @@ ignore:
   }
 flushing:
   {
-    GST_DEBUG_OBJECT (pad, "We are flushing, discard buffer %p", buf);
-    gst_buffer_unref (buf);
+    GST_DEBUG_OBJECT (pad, "We are flushing, discard %p", data);
+    gst_mini_object_unref (data);
     res = GST_FLOW_FLUSHING;
     goto done;
   }
 }
 
+static GstFlowReturn
+gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  return gst_selector_pad_chain_data (pad, parent, GST_MINI_OBJECT_CAST (buf));
+}
+
+static GstFlowReturn
+gst_selector_pad_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  return gst_selector_pad_chain_data (pad, parent,
+      GST_MINI_OBJECT_CAST (list));
+}
+
 static void gst_input_selector_dispose (GObject * object);
 static void gst_input_selector_finalize (GObject * object);
 
@@ -1472,8 +1580,11 @@ gst_input_selector_active_pad_changed (GstInputSelector * sel,
 {
   /* Wake up all non-active pads in sync mode, they might be
    * the active pad now */
-  if (sel->sync_streams)
-    GST_INPUT_SELECTOR_BROADCAST (sel);
+  if (sel->sync_streams) {
+    GST_INPUT_SELECTOR_LOCK (sel);
+    gst_input_selector_wake_all (sel);
+    GST_INPUT_SELECTOR_UNLOCK (sel);
+  }
 }
 
 static void
@@ -1749,6 +1860,22 @@ gst_input_selector_is_active_sinkpad (GstInputSelector * sel, GstPad * pad)
   return res;
 }
 
+/* Wake up all pads waiting for EOS, for a running time or to become the
+ * active pad, must be called with SELECTOR_LOCK */
+static void
+gst_input_selector_wake_all (GstInputSelector * sel)
+{
+  GList *walk;
+
+  for (walk = GST_ELEMENT_CAST (sel)->sinkpads; walk; walk = walk->next) {
+    GstSelectorPad *selpad = GST_SELECTOR_PAD_CAST (walk->data);
+
+    if (selpad->clock_id)
+      gst_clock_id_unschedule (selpad->clock_id);
+  }
+  GST_INPUT_SELECTOR_BROADCAST (sel);
+}
+
 /* Get or create the active sinkpad, must be called with SELECTOR_LOCK */
 static GstPad *
 gst_input_selector_get_active_sinkpad (GstInputSelector * sel)
@@ -1807,6 +1934,8 @@ gst_input_selector_request_new_pad (GstElement * element,
       GST_DEBUG_FUNCPTR (gst_selector_pad_query));
   gst_pad_set_chain_function (sinkpad,
       GST_DEBUG_FUNCPTR (gst_selector_pad_chain));
+  gst_pad_set_chain_list_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_selector_pad_chain_list));
   gst_pad_set_iterate_internal_links_function (sinkpad,
       GST_DEBUG_FUNCPTR (gst_selector_pad_iterate_linked_pads));
 
@@ -1842,6 +1971,8 @@ gst_input_selector_release_pad (GstElement * element, GstPad * pad)
    * reached. Otherwise we'll deadlock on the streaming thread further below
    * when deactivating the pad. */
   selpad->flushing = TRUE;
+  if (selpad->clock_id)
+    gst_clock_id_unschedule (selpad->clock_id);
   GST_INPUT_SELECTOR_BROADCAST (sel);
 
   sel->n_pads--;
@@ -1899,7 +2030,7 @@ gst_input_selector_change_state (GstElement * element,
       GST_INPUT_SELECTOR_LOCK (self);
       self->eos = TRUE;
       self->flushing = TRUE;
-      GST_INPUT_SELECTOR_BROADCAST (self);
+      gst_input_selector_wake_all (self);
       GST_INPUT_SELECTOR_UNLOCK (self);
       break;
     default:
@@ -101,6 +101,38 @@
 #include "gstmultiqueue.h"
 #include "gstcoreelementselements.h"
 
+/* The single queues are kept in binary heaps for each of the positions
+ * compute_high_time() and compute_high_id() look at, so that those don't
+ * have to iterate over all queues for every buffer. Every queue stores its
+ * index and key in each heap, all heaps have the lowest key on top and the
+ * ones looking for a maximum use negated keys. */
+enum
+{
+  HEAP_HIGH_TIME,               /* last_time of linked queues */
+  HEAP_LOW_TIME,                /* next_time of waiting not-linked queues */
+  HEAP_HIGH_ID,                 /* oldid of waiting linked queues */
+  HEAP_LOW_ID,                  /* nextid of waiting not-linked queues */
+  HEAP_GROUP_HIGH_TIME,         /* same as above within the queue's group */
+  HEAP_GROUP_LOW_TIME,
+  N_HEAPS
+};
+
+/* GstMultiQueueGroup:
+ *
+ * The streams of the same group. Groups are kept until the multiqueue is
+ * finalized, there usually are only a handful of them.
+ */
+typedef struct
+{
+  guint groupid;
+  /* number of single queues in the group */
+  guint count;
+  GPtrArray *high_time_heap;
+  GPtrArray *low_time_heap;
+  /* as computed by compute_high_time() */
+  GstClockTimeDiff high_time;
+} GstMultiQueueGroup;
+
 /* GstSingleQueue:
  * @sinkpad: associated sink #GstPad
  * @srcpad: associated source #GstPad
@@ -118,7 +150,12 @@ struct _GstSingleQueue
   guint id;
   /* group of streams to which this queue belongs to */
   guint groupid;
-  GstClockTimeDiff group_high_time;
+  GstMultiQueueGroup *group;
+
+  /* Protected by global lock, index and key in each of the heaps, the index
+   * is -1 when the queue is not in the heap */
+  gint heap_pos[N_HEAPS];
+  gint64 heap_key[N_HEAPS];
 
   GWeakRef mqueue;
   GWeakRef sinkpad;
@@ -126,6 +163,8 @@ struct _GstSingleQueue
 
   /* flowreturn of previous srcpad push */
   GstFlowReturn srcresult;
+  /* TRUE while dropping data after downstream returned EOS */
+  gboolean dropping;
   /* If something was actually pushed on
    * this pad after flushing/pad activation
    * and the srcresult corresponds to something
@@ -170,6 +209,10 @@ struct _GstSingleQueue
   gboolean last_query;
   GstQuery *last_handled_query;
 
+  /* Protected by global lock, only used with worker threads */
+  gboolean worker_paused;       /* TRUE when the queue must not be serviced */
+  gboolean worker_busy;         /* TRUE while a worker pushes from the queue */
+
   /* For interleave calculation */
   GThread *thread;              /* Streaming thread of SingleQueue */
   GstClockTime interleave;      /* Calculated interleve within the thread */
@@ -189,15 +232,31 @@ struct _GstMultiQueueItem
   guint32 posid;
 
   gboolean is_query;
+  GstQueueBudget *budget;       /* the size is charged to it */
 };
 
+/* A thread servicing the queues when worker-threads is set */
+typedef struct
+{
+  GstTask *task;
+  GRecMutex lock;
+} GstMultiQueueWorker;
+
 static GstSingleQueue *gst_single_queue_new (GstMultiQueue * mqueue, guint id);
 static void gst_single_queue_unref (GstSingleQueue * squeue);
 static GstSingleQueue *gst_single_queue_ref (GstSingleQueue * squeue);
 
 static void wake_up_next_non_linked (GstMultiQueue * mq);
+static void gst_multi_queue_start_workers (GstMultiQueue * mq);
+static void gst_multi_queue_stop_workers (GstMultiQueue * mq);
+static void gst_multi_queue_worker_loop (GstMultiQueue * mq);
 static void compute_high_id (GstMultiQueue * mq);
-static void compute_high_time (GstMultiQueue * mq, guint groupid);
+static void compute_high_time (GstMultiQueue * mq, GstMultiQueueGroup * group);
+static void gst_single_queue_set_group (GstMultiQueue * mq,
+    GstSingleQueue * sq, guint groupid);
+static void gst_single_queue_update_position (GstMultiQueue * mq,
+    GstSingleQueue * sq);
+static void gst_multi_queue_group_free (GstMultiQueueGroup * group);
 static void single_queue_overrun_cb (GstDataQueue * dq, GstSingleQueue * sq);
 static void single_queue_underrun_cb (GstDataQueue * dq, GstSingleQueue * sq);
 
@@ -256,6 +315,7 @@ enum
 #define DEFAULT_UNLINKED_CACHE_TIME 250 * GST_MSECOND
 
 #define DEFAULT_MINIMUM_INTERLEAVE (250 * GST_MSECOND)
+#define DEFAULT_WORKER_THREADS 0
 
 enum
 {
@@ -275,7 +335,9 @@ enum
   PROP_USE_INTERLEAVE,
   PROP_UNLINKED_CACHE_TIME,
   PROP_MINIMUM_INTERLEAVE,
+  PROP_WORKER_THREADS,
   PROP_STATS,
+  PROP_BUDGET,
   PROP_LAST
 };
 
@@ -369,13 +431,13 @@ gst_multiqueue_pad_get_group_id (GstMultiQueuePad * pad)
   mq = g_weak_ref_get (&pad->sq->mqueue);
 
   if (mq) {
-    GST_OBJECT_LOCK (mq);
+    GST_MULTI_QUEUE_MUTEX_LOCK (mq);
   }
 
   ret = pad->sq->groupid;
 
   if (mq) {
-    GST_OBJECT_UNLOCK (mq);
+    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
     gst_object_unref (mq);
   }
 
@@ -502,14 +564,14 @@ gst_multiqueue_pad_set_property (GObject * object, guint prop_id,
       if (pad->sq) {
         GstMultiQueue *mqueue = g_weak_ref_get (&pad->sq->mqueue);
 
-        if (mqueue)
-          GST_OBJECT_LOCK (mqueue);
-
-        pad->sq->groupid = g_value_get_uint (value);
-
         if (mqueue) {
-          GST_OBJECT_UNLOCK (mqueue);
+          GST_MULTI_QUEUE_MUTEX_LOCK (mqueue);
+          gst_single_queue_set_group (mqueue, pad->sq,
+              g_value_get_uint (value));
+          GST_MULTI_QUEUE_MUTEX_UNLOCK (mqueue);
           gst_object_unref (mqueue);
+        } else {
+          pad->sq->groupid = g_value_get_uint (value);
         }
       }
       break;
@@ -623,6 +685,8 @@ static GstPad *gst_multi_queue_request_new_pad (GstElement * element,
 static void gst_multi_queue_release_pad (GstElement * element, GstPad * pad);
 static GstStateChangeReturn gst_multi_queue_change_state (GstElement *
     element, GstStateChange transition);
+static void gst_multi_queue_set_context (GstElement * element,
+    GstContext * context);
 
 static void gst_multi_queue_loop (GstPad * pad);
 
@@ -809,6 +873,28 @@ gst_multi_queue_class_init (GstMultiQueueClass * klass)
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiQueue:worker-threads:
+   *
+   * Number of threads servicing all the queues, or 0 to use one streaming
+   * thread per queue.
+   *
+   * The worker threads always output the data with the lowest running time
+   * first, which keeps all streams interleaved in running time order,
+   * whether they are linked or not. A worker blocks while downstream blocks,
+   * so this should only be used when there are more workers than branches
+   * that can block at the same time, for example when prerolling sinks.
+   *
+   * This property can only be changed in the NULL state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_WORKER_THREADS,
+      g_param_spec_uint ("worker-threads", "Worker threads",
+          "Number of threads servicing all queues (0 = one thread per queue)",
+          0, G_MAXUINT, DEFAULT_WORKER_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstMultiQueue:stats:
    *
@@ -828,6 +914,29 @@ gst_multi_queue_class_init (GstMultiQueueClass * klass)
           "Multiqueue Statistics",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstMultiQueue:budget:
+   *
+   * A #GstQueueBudget shared with other queues, the bytes held by all the
+   * queues of the multiqueue are charged to it. While the budget is
+   * exhausted, new buffers are dropped or upstream waits until the data of
+   * its queue was pushed, depending on the #GstQueueBudget:policy. A queue
+   * without buffers always accepts one, so that all queues sharing the
+   * budget can make progress.
+   *
+   * The budget can also be set with a #GstContext of type
+   * #GST_QUEUE_BUDGET_CONTEXT_TYPE. It can only be changed up to the READY
+   * state.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BUDGET,
+      g_param_spec_object ("budget", "Budget",
+          "Memory budget shared with other queues (NULL = no shared budget)",
+          GST_TYPE_QUEUE_BUDGET,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_multi_queue_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -844,6 +953,8 @@ gst_multi_queue_class_init (GstMultiQueueClass * klass)
       GST_DEBUG_FUNCPTR (gst_multi_queue_release_pad);
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_multi_queue_change_state);
+  gstelement_class->set_context =
+      GST_DEBUG_FUNCPTR (gst_multi_queue_set_context);
 
   gst_type_mark_as_plugin_api (GST_TYPE_MULTIQUEUE_PAD, 0);
 }
@@ -870,13 +981,20 @@ gst_multi_queue_init (GstMultiQueue * mqueue)
   mqueue->use_interleave = DEFAULT_USE_INTERLEAVE;
   mqueue->min_interleave_time = DEFAULT_MINIMUM_INTERLEAVE;
   mqueue->unlinked_cache_time = DEFAULT_UNLINKED_CACHE_TIME;
+  mqueue->n_workers = DEFAULT_WORKER_THREADS;
 
   mqueue->counter = 1;
   mqueue->highid = -1;
   mqueue->high_time = GST_CLOCK_STIME_NONE;
 
+  mqueue->high_time_heap = g_ptr_array_new ();
+  mqueue->low_time_heap = g_ptr_array_new ();
+  mqueue->high_id_heap = g_ptr_array_new ();
+  mqueue->low_id_heap = g_ptr_array_new ();
+
   g_mutex_init (&mqueue->qlock);
   g_mutex_init (&mqueue->buffering_post_lock);
+  g_cond_init (&mqueue->worker_cond);
 }
 
 static void
@@ -888,9 +1006,21 @@ gst_multi_queue_finalize (GObject * object)
   mqueue->queues = NULL;
   mqueue->queues_cookie++;
 
+  g_ptr_array_free (mqueue->high_time_heap, TRUE);
+  g_ptr_array_free (mqueue->low_time_heap, TRUE);
+  g_ptr_array_free (mqueue->high_id_heap, TRUE);
+  g_ptr_array_free (mqueue->low_id_heap, TRUE);
+  g_list_free_full (mqueue->groups,
+      (GDestroyNotify) gst_multi_queue_group_free);
+  mqueue->groups = NULL;
+
+  /* after the queues, their items release what they charged */
+  gst_clear_object (&mqueue->budget);
+
   /* free/unref instance data */
   g_mutex_clear (&mqueue->qlock);
   g_mutex_clear (&mqueue->buffering_post_lock);
+  g_cond_clear (&mqueue->worker_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1017,6 +1147,17 @@ gst_multi_queue_set_property (GObject * object, guint prop_id,
         calculate_interleave (mq, NULL);
       GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
       break;
+    case PROP_WORKER_THREADS:
+      GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+      mq->n_workers = g_value_get_uint (value);
+      GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+      break;
+    case PROP_BUDGET:
+      GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+      gst_object_replace ((GstObject **) & mq->budget,
+          g_value_get_object (value));
+      GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1117,9 +1258,15 @@ gst_multi_queue_get_property (GObject * object, guint prop_id,
     case PROP_MINIMUM_INTERLEAVE:
       g_value_set_uint64 (value, mq->min_interleave_time);
       break;
+    case PROP_WORKER_THREADS:
+      g_value_set_uint (value, mq->n_workers);
+      break;
     case PROP_STATS:
       g_value_take_boxed (value, gst_multi_queue_get_stats (mq));
       break;
+    case PROP_BUDGET:
+      g_value_set_object (value, mq->budget);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1250,12 +1397,40 @@ gst_multi_queue_release_pad (GstElement * element, GstPad * pad)
 
   gst_pad_set_active (srcpad, FALSE);
   gst_pad_set_active (sinkpad, FALSE);
+
+  /* nothing changes the position of the queue anymore now */
+  GST_MULTI_QUEUE_MUTEX_LOCK (mqueue);
+  gst_single_queue_remove_position (mqueue, sq);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mqueue);
+
   gst_element_remove_pad (element, srcpad);
   gst_element_remove_pad (element, sinkpad);
   gst_object_unref (srcpad);
   gst_object_unref (sinkpad);
 }
 
+static void
+gst_multi_queue_set_context (GstElement * element, GstContext * context)
+{
+  GstMultiQueue *mq = GST_MULTI_QUEUE (element);
+  GstQueueBudget *budget;
+
+  if (gst_context_get_queue_budget (context, &budget)) {
+    /* the streaming threads read the budget without locking */
+    if (GST_STATE (mq) <= GST_STATE_READY) {
+      GST_DEBUG_OBJECT (mq, "using budget %" GST_PTR_FORMAT, budget);
+      GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+      gst_object_replace ((GstObject **) & mq->budget, GST_OBJECT (budget));
+      GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    } else {
+      GST_WARNING_OBJECT (mq, "ignoring budget, can only be set up to READY");
+    }
+    gst_object_unref (budget);
+  }
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
+
 static GstStateChangeReturn
 gst_multi_queue_change_state (GstElement * element, GstStateChange transition)
 {
@@ -1264,6 +1439,9 @@ gst_multi_queue_change_state (GstElement * element, GstStateChange transition)
   GstStateChangeReturn result;
 
   switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      gst_multi_queue_start_workers (mqueue);
+      break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:{
       GList *tmp;
 
@@ -1305,6 +1483,9 @@ gst_multi_queue_change_state (GstElement * element, GstStateChange transition)
   result = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 
   switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      gst_multi_queue_stop_workers (mqueue);
+      break;
     default:
       break;
   }
@@ -1312,6 +1493,95 @@ gst_multi_queue_change_state (GstElement * element, GstStateChange transition)
   return result;
 }
 
+static void
+gst_multi_queue_start_workers (GstMultiQueue * mq)
+{
+  guint i;
+
+  if (mq->n_workers == 0)
+    return;
+
+  GST_DEBUG_OBJECT (mq, "starting %u worker threads", mq->n_workers);
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  mq->workers = g_ptr_array_new ();
+  mq->workers_running = TRUE;
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+
+  for (i = 0; i < mq->n_workers; i++) {
+    GstMultiQueueWorker *worker = g_new0 (GstMultiQueueWorker, 1);
+
+    g_rec_mutex_init (&worker->lock);
+    worker->task = gst_task_new ((GstTaskFunction) gst_multi_queue_worker_loop,
+        mq, NULL);
+    gst_task_set_lock (worker->task, &worker->lock);
+    g_ptr_array_add (mq->workers, worker);
+    gst_task_start (worker->task);
+  }
+}
+
+static void
+gst_multi_queue_stop_workers (GstMultiQueue * mq)
+{
+  guint i;
+
+  if (mq->workers == NULL)
+    return;
+
+  GST_DEBUG_OBJECT (mq, "stopping worker threads");
+
+  for (i = 0; i < mq->workers->len; i++) {
+    GstMultiQueueWorker *worker = g_ptr_array_index (mq->workers, i);
+
+    gst_task_stop (worker->task);
+  }
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  mq->workers_running = FALSE;
+  g_cond_broadcast (&mq->worker_cond);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+
+  for (i = 0; i < mq->workers->len; i++) {
+    GstMultiQueueWorker *worker = g_ptr_array_index (mq->workers, i);
+
+    gst_task_join (worker->task);
+    gst_object_unref (worker->task);
+    g_rec_mutex_clear (&worker->lock);
+    g_free (worker);
+  }
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  g_ptr_array_free (mq->workers, TRUE);
+  mq->workers = NULL;
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+}
+
+/* wake up a worker for data that was just added to one of the queues */
+static void
+gst_multi_queue_wake_worker (GstMultiQueue * mq)
+{
+  if (mq->workers == NULL)
+    return;
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  g_cond_signal (&mq->worker_cond);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+}
+
+/* the worker version of pausing the task: make sure no worker services the
+ * queue anymore and wait for a worker that might still be pushing from it */
+static void
+gst_single_queue_pause_worker (GstMultiQueue * mq, GstSingleQueue * sq,
+    GstPad * srcpad)
+{
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  sq->worker_paused = TRUE;
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+
+  GST_PAD_STREAM_LOCK (srcpad);
+  GST_PAD_STREAM_UNLOCK (srcpad);
+}
+
 static gboolean
 gst_single_queue_start (GstMultiQueue * mq, GstSingleQueue * sq)
 {
@@ -1320,7 +1590,14 @@ gst_single_queue_start (GstMultiQueue * mq, GstSingleQueue * sq)
 
   GST_LOG_OBJECT (mq, "SingleQueue %d : starting task", sq->id);
 
-  if (srcpad) {
+  if (srcpad && mq->workers) {
+    GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+    sq->worker_paused = FALSE;
+    g_cond_broadcast (&mq->worker_cond);
+    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    gst_object_unref (srcpad);
+    res = TRUE;
+  } else if (srcpad) {
     res = gst_pad_start_task (srcpad,
         (GstTaskFunction) gst_multi_queue_loop, srcpad, NULL);
     gst_object_unref (srcpad);
@@ -1336,7 +1613,11 @@ gst_single_queue_pause (GstMultiQueue * mq, GstSingleQueue * sq)
   GstPad *srcpad = g_weak_ref_get (&sq->srcpad);
 
   GST_LOG_OBJECT (mq, "SingleQueue %d : pausing task", sq->id);
-  if (srcpad) {
+  if (srcpad && mq->workers) {
+    gst_single_queue_pause_worker (mq, sq, srcpad);
+    gst_object_unref (srcpad);
+    result = TRUE;
+  } else if (srcpad) {
     result = gst_pad_pause_task (srcpad);
     gst_object_unref (srcpad);
   }
@@ -1352,7 +1633,11 @@ gst_single_queue_stop (GstMultiQueue * mq, GstSingleQueue * sq)
   GstPad *srcpad = g_weak_ref_get (&sq->srcpad);
 
   GST_LOG_OBJECT (mq, "SingleQueue %d : stopping task", sq->id);
-  if (srcpad) {
+  if (srcpad && mq->workers) {
+    gst_single_queue_pause_worker (mq, sq, srcpad);
+    gst_object_unref (srcpad);
+    result = TRUE;
+  } else if (srcpad) {
     result = gst_pad_stop_task (srcpad);
     gst_object_unref (srcpad);
   }
@@ -1370,6 +1655,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
   if (flush) {
     GST_MULTI_QUEUE_MUTEX_LOCK (mq);
     sq->srcresult = GST_FLOW_FLUSHING;
+    gst_single_queue_update_position (mq, sq);
     gst_data_queue_set_flushing (sq->queue, TRUE);
 
     sq->flushing = TRUE;
@@ -1390,6 +1676,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
     sq->has_src_segment = FALSE;
     /* All pads start off OK for a smooth kick-off */
     sq->srcresult = GST_FLOW_OK;
+    sq->dropping = FALSE;
     sq->pushed = FALSE;
     sq->cur_time = 0;
     sq->max_size.visible = mq->max_size.visible;
@@ -1401,7 +1688,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
     sq->next_time = GST_CLOCK_STIME_NONE;
     sq->last_time = GST_CLOCK_STIME_NONE;
     sq->cached_sinktime = GST_CLOCK_STIME_NONE;
-    sq->group_high_time = GST_CLOCK_STIME_NONE;
+    gst_single_queue_update_position (mq, sq);
     gst_data_queue_set_flushing (sq->queue, FALSE);
 
     /* We will become active again on the next buffer/gap */
@@ -1415,6 +1702,18 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
   }
 }
 
+/* TRUE when the shared budget makes upstream of a queue with @visible items
+ * wait. Only a queue that holds buffers waits, they are pushed out and
+ * released again. */
+static gboolean
+single_queue_budget_blocks (GstMultiQueue * mq, guint visible)
+{
+  return mq->budget && visible > 0
+      && gst_queue_budget_is_exhausted (mq->budget)
+      && gst_queue_budget_get_policy (mq->budget) ==
+      GST_QUEUE_BUDGET_POLICY_BLOCK;
+}
+
 /* WITH LOCK TAKEN */
 static gint
 get_buffering_level (GstMultiQueue * mq, GstSingleQueue * sq)
@@ -1431,7 +1730,7 @@ get_buffering_level (GstMultiQueue * mq, GstSingleQueue * sq)
 
   /* get bytes and time buffer levels and take the max */
   if (sq->is_eos || sq->is_segment_done || sq->srcresult == GST_FLOW_NOT_LINKED
-      || sq->is_sparse) {
+      || sq->is_sparse || single_queue_budget_blocks (mq, size.visible)) {
     buffering_level = MAX_BUFFERING_LEVEL;
   } else {
     buffering_level = 0;
@@ -1671,6 +1970,7 @@ update_time_level (GstMultiQueue * mq, GstSingleQueue * sq)
        * In order for the high_time computation to be as efficient as possible,
        * we set the last_time */
       sq->last_time = sink_time;
+      gst_single_queue_update_position (mq, sq);
     }
     if (G_UNLIKELY (sink_time != GST_CLOCK_STIME_NONE)) {
       /* if we have a time, we become untainted and use the time */
@@ -2036,6 +2336,10 @@ gst_multi_queue_item_destroy (GstMultiQueueItem * item)
 {
   if (!item->is_query && item->object)
     gst_mini_object_unref (item->object);
+  if (item->budget) {
+    gst_queue_budget_release (item->budget, item->size);
+    gst_object_unref (item->budget);
+  }
   g_slice_free (GstMultiQueueItem, item);
 }
 
@@ -2056,6 +2360,7 @@ gst_multi_queue_buffer_item_new (GstMiniObject * object, guint32 curid)
   if (item->duration == GST_CLOCK_TIME_NONE)
     item->duration = 0;
   item->visible = TRUE;
+  item->budget = NULL;
   return item;
 }
 
@@ -2073,6 +2378,7 @@ gst_multi_queue_mo_item_new (GstMiniObject * object, guint32 curid)
   item->size = 0;
   item->duration = 0;
   item->visible = FALSE;
+  item->budget = NULL;
   return item;
 }
 
@@ -2093,7 +2399,6 @@ gst_multi_queue_loop (GstPad * pad)
   GstClockTimeDiff next_time;
   gboolean is_buffer;
   gboolean do_update_buffering = FALSE;
-  gboolean dropping = FALSE;
   GstPad *srcpad = NULL;
 
   sq = GST_MULTIQUEUE_PAD (pad)->sq;
@@ -2109,6 +2414,10 @@ next:
   if (sq->flushing)
     goto out_flushing;
 
+  /* workers only come here for queues with data and must never block */
+  if (mq->workers && gst_data_queue_is_empty (sq->queue))
+    goto done;
+
   /* Get something from the queue, blocking until that happens, or we get
    * flushed */
   if (!(gst_data_queue_pop (sq->queue, &sitem)))
@@ -2133,11 +2442,14 @@ next:
    * wait before pushing. If we're linked but there's a gap in the IDs,
    * or it's the first loop, or we just passed the previous highid,
    * we might need to wake some sleeping pad up, so there's extra work
-   * there too */
+   * there too.
+   * Workers already service the queues in running time order, so none of
+   * this is needed for them */
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
-  if (sq->srcresult == GST_FLOW_NOT_LINKED
-      || (sq->last_oldid == G_MAXUINT32) || (newid != (sq->last_oldid + 1))
-      || sq->last_oldid > mq->highid) {
+  if (!mq->workers && (sq->srcresult == GST_FLOW_NOT_LINKED
+          || (sq->last_oldid == G_MAXUINT32)
+          || (newid != (sq->last_oldid + 1))
+          || sq->last_oldid > mq->highid)) {
     GST_LOG_OBJECT (mq, "CHECKING sq->srcresult: %s",
         gst_flow_get_name (sq->srcresult));
 
@@ -2159,6 +2471,8 @@ next:
     if (sq->last_oldid != G_MAXUINT32)
       sq->oldid = sq->last_oldid;
 
+    gst_single_queue_update_position (mq, sq);
+
     if (sq->srcresult == GST_FLOW_NOT_LINKED) {
       gboolean should_wait;
       /* Go to sleep until it's time to push this buffer */
@@ -2166,21 +2480,21 @@ next:
       /* Recompute the highid */
       compute_high_id (mq);
       /* Recompute the high time */
-      compute_high_time (mq, sq->groupid);
+      compute_high_time (mq, sq->group);
 
       GST_DEBUG_OBJECT (mq,
           "groupid %d high_time %" GST_STIME_FORMAT " next_time %"
-          GST_STIME_FORMAT, sq->groupid, GST_STIME_ARGS (sq->group_high_time),
+          GST_STIME_FORMAT, sq->groupid, GST_STIME_ARGS (sq->group->high_time),
           GST_STIME_ARGS (next_time));
 
       if (mq->sync_by_running_time) {
-        if (sq->group_high_time == GST_CLOCK_STIME_NONE) {
+        if (sq->group->high_time == GST_CLOCK_STIME_NONE) {
           should_wait = GST_CLOCK_STIME_IS_VALID (next_time) &&
               (mq->high_time == GST_CLOCK_STIME_NONE
               || next_time > mq->high_time);
         } else {
           should_wait = GST_CLOCK_STIME_IS_VALID (next_time) &&
-              next_time > sq->group_high_time;
+              next_time > sq->group->high_time;
         }
       } else
         should_wait = newid > mq->highid;
@@ -2191,7 +2505,7 @@ next:
             "queue %d sleeping for not-linked wakeup with "
             "newid %u, highid %u, next_time %" GST_STIME_FORMAT
             ", high_time %" GST_STIME_FORMAT, sq->id, newid, mq->highid,
-            GST_STIME_ARGS (next_time), GST_STIME_ARGS (sq->group_high_time));
+            GST_STIME_ARGS (next_time), GST_STIME_ARGS (sq->group->high_time));
 
         /* Wake up all non-linked pads before we sleep */
         wake_up_next_non_linked (mq);
@@ -2206,24 +2520,24 @@ next:
         }
 
         /* Recompute the high time and ID */
-        compute_high_time (mq, sq->groupid);
+        compute_high_time (mq, sq->group);
         compute_high_id (mq);
 
         GST_DEBUG_OBJECT (mq, "queue %d woken from sleeping for not-linked "
             "wakeup with newid %u, highid %u, next_time %" GST_STIME_FORMAT
             ", high_time %" GST_STIME_FORMAT " mq high_time %" GST_STIME_FORMAT,
             sq->id, newid, mq->highid,
-            GST_STIME_ARGS (next_time), GST_STIME_ARGS (sq->group_high_time),
+            GST_STIME_ARGS (next_time), GST_STIME_ARGS (sq->group->high_time),
             GST_STIME_ARGS (mq->high_time));
 
         if (mq->sync_by_running_time) {
-          if (sq->group_high_time == GST_CLOCK_STIME_NONE) {
+          if (sq->group->high_time == GST_CLOCK_STIME_NONE) {
             should_wait = GST_CLOCK_STIME_IS_VALID (next_time) &&
                 (mq->high_time == GST_CLOCK_STIME_NONE
                 || next_time > mq->high_time);
           } else {
             should_wait = GST_CLOCK_STIME_IS_VALID (next_time) &&
-                next_time > sq->group_high_time;
+                next_time > sq->group->high_time;
           }
         } else
           should_wait = newid > mq->highid;
@@ -2231,16 +2545,17 @@ next:
 
       /* Re-compute the high_id in case someone else pushed */
       compute_high_id (mq);
-      compute_high_time (mq, sq->groupid);
+      compute_high_time (mq, sq->group);
     } else {
       compute_high_id (mq);
-      compute_high_time (mq, sq->groupid);
+      compute_high_time (mq, sq->group);
       /* Wake up all non-linked pads */
       wake_up_next_non_linked (mq);
     }
     /* We're done waiting, we can clear the nextid and nexttime */
     sq->nextid = 0;
     sq->next_time = GST_CLOCK_STIME_NONE;
+    gst_single_queue_update_position (mq, sq);
   }
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
@@ -2254,8 +2569,10 @@ next:
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
   next_time = get_running_time (&sq->src_segment, object, TRUE);
   if (GST_CLOCK_STIME_IS_VALID (next_time)) {
-    if (sq->last_time == GST_CLOCK_STIME_NONE || sq->last_time < next_time)
+    if (sq->last_time == GST_CLOCK_STIME_NONE || sq->last_time < next_time) {
       sq->last_time = next_time;
+      gst_single_queue_update_position (mq, sq);
+    }
     if (mq->high_time == GST_CLOCK_STIME_NONE || mq->high_time <= next_time) {
       /* Wake up all non-linked pads now that we advanced the high time */
       mq->high_time = next_time;
@@ -2265,7 +2582,7 @@ next:
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
   /* Try to push out the new object */
-  result = gst_single_queue_push_one (mq, sq, object, &dropping);
+  result = gst_single_queue_push_one (mq, sq, object, &sq->dropping);
   object = NULL;
 
   /* Check if we pushed something already and if this is
@@ -2277,6 +2594,8 @@ next:
    * deadlocks if downstream does any waiting too.
    */
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  /* pushing might have changed the EOS state of the srcpad */
+  gst_single_queue_update_position (mq, sq);
   if (sq->pushed && sq->srcresult == GST_FLOW_OK
       && result == GST_FLOW_NOT_LINKED) {
     GList *tmp;
@@ -2285,7 +2604,7 @@ next:
         sq->id);
 
     compute_high_id (mq);
-    compute_high_time (mq, sq->groupid);
+    compute_high_time (mq, sq->group);
     do_update_buffering = TRUE;
 
     /* maybe no-one is waiting */
@@ -2298,6 +2617,7 @@ next:
           GST_LOG_OBJECT (mq, "Waking up singlequeue %d", sq2->id);
           sq2->pushed = FALSE;
           sq2->srcresult = GST_FLOW_OK;
+          gst_single_queue_update_position (mq, sq2);
           g_cond_signal (&sq2->turn);
         }
       }
@@ -2311,22 +2631,23 @@ next:
    * can not simply throw this result to upstream, because
    * that might already be onto another segment, so we have to make
    * sure we are relaying the correct info wrt proper segment */
-  if (result == GST_FLOW_EOS && !dropping &&
+  if (result == GST_FLOW_EOS && !sq->dropping &&
       sq->srcresult != GST_FLOW_NOT_LINKED) {
     GST_DEBUG_OBJECT (mq, "starting EOS drop on sq %d", sq->id);
-    dropping = TRUE;
+    sq->dropping = TRUE;
     /* pretend we have not seen EOS yet for upstream's sake */
     result = sq->srcresult;
-  } else if (dropping && gst_data_queue_is_empty (sq->queue)) {
+  } else if (sq->dropping && gst_data_queue_is_empty (sq->queue)) {
     /* queue empty, so stop dropping
      * we can commit the result we have now,
      * which is either OK after a segment, or EOS */
     GST_DEBUG_OBJECT (mq, "committed EOS drop on sq %d", sq->id);
-    dropping = FALSE;
+    sq->dropping = FALSE;
     result = GST_FLOW_EOS;
   }
   sq->srcresult = result;
   sq->last_oldid = newid;
+  gst_single_queue_update_position (mq, sq);
 
   if (do_update_buffering)
     update_buffering (mq, sq);
@@ -2341,13 +2662,14 @@ next:
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
   if (mq->numwaiting > 0 && (GST_PAD_IS_EOS (srcpad)
           || sq->srcresult == GST_FLOW_EOS)) {
-    compute_high_time (mq, sq->groupid);
+    compute_high_time (mq, sq->group);
     compute_high_id (mq);
     wake_up_next_non_linked (mq);
   }
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
-  if (dropping)
+  /* workers go back to picking the next queue in running time order */
+  if (sq->dropping && !mq->workers)
     goto next;
 
   if (result != GST_FLOW_OK && result != GST_FLOW_NOT_LINKED
@@ -2388,7 +2710,13 @@ out_flushing:
     gst_single_queue_flush_queue (sq, FALSE);
     single_queue_underrun_cb (sq->queue, sq);
     gst_data_queue_set_flushing (sq->queue, TRUE);
-    gst_pad_pause_task (srcpad);
+    if (mq->workers) {
+      GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+      sq->worker_paused = TRUE;
+      GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    } else {
+      gst_pad_pause_task (srcpad);
+    }
     GST_CAT_LOG_OBJECT (multi_queue_debug, mq,
         "SingleQueue[%d] task paused, reason:%s",
         sq->id, gst_flow_get_name (sq->srcresult));
@@ -2396,6 +2724,95 @@ out_flushing:
   }
 }
 
+/* WITH LOCK TAKEN
+ * Returns the queue a worker should push from next: the one whose next
+ * object has the lowest running time. Events, queries and buffers without
+ * running time have GST_CLOCK_STIME_NONE, which sorts before everything
+ * else, and ties are broken by the order in which the objects came in. */
+static GstSingleQueue *
+gst_multi_queue_pick_queue (GstMultiQueue * mq)
+{
+  GstSingleQueue *best = NULL;
+  GstClockTimeDiff best_time = GST_CLOCK_STIME_NONE;
+  guint32 best_id = G_MAXUINT32;
+  GList *tmp;
+
+  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
+    GstDataQueueItem *sitem;
+    GstMultiQueueItem *item;
+    GstClockTimeDiff time;
+
+    if (sq->worker_paused || sq->worker_busy || sq->flushing)
+      continue;
+
+    /* peeking never blocks here, only the worker servicing a queue takes
+     * data out of it */
+    if (gst_data_queue_is_empty (sq->queue)
+        || !gst_data_queue_peek (sq->queue, &sitem))
+      continue;
+
+    item = (GstMultiQueueItem *) sitem;
+    time = get_running_time (&sq->src_segment, item->object, FALSE);
+
+    if (best == NULL || time < best_time || (time == best_time
+            && item->posid < best_id)) {
+      best = sq;
+      best_time = time;
+      best_id = item->posid;
+    }
+  }
+
+  return best;
+}
+
+static void
+gst_multi_queue_worker_loop (GstMultiQueue * mq)
+{
+  GstSingleQueue *sq = NULL;
+  GstPad *srcpad;
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  while (mq->workers_running && !(sq = gst_multi_queue_pick_queue (mq)))
+    g_cond_wait (&mq->worker_cond, &mq->qlock);
+
+  if (sq == NULL) {
+    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    return;
+  }
+
+  sq->worker_busy = TRUE;
+  gst_single_queue_ref (sq);
+  srcpad = g_weak_ref_get (&sq->srcpad);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+
+  GST_LOG_OBJECT (mq, "SingleQueue %d : serviced by worker", sq->id);
+
+  if (srcpad) {
+    /* take the stream lock like the srcpad task would, pausing the queue
+     * waits for it */
+    GST_PAD_STREAM_LOCK (srcpad);
+    if (!sq->worker_paused) {
+      gst_multi_queue_loop (srcpad);
+
+      /* the data queue only calls the empty callback when popping from an
+       * empty queue, which workers never do */
+      if (!sq->worker_paused && gst_data_queue_is_empty (sq->queue))
+        single_queue_underrun_cb (sq->queue, sq);
+    }
+    GST_PAD_STREAM_UNLOCK (srcpad);
+    gst_object_unref (srcpad);
+  }
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  sq->worker_busy = FALSE;
+  /* another worker might be waiting for this queue */
+  g_cond_signal (&mq->worker_cond);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+
+  gst_single_queue_unref (sq);
+}
+
 /**
  * gst_multi_queue_chain:
  *
@@ -2422,6 +2839,11 @@ gst_multi_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (sq->is_eos)
     goto was_eos;
 
+  if (mq->budget && gst_queue_budget_is_exhausted (mq->budget)
+      && gst_queue_budget_get_policy (mq->budget) ==
+      GST_QUEUE_BUDGET_POLICY_LEAK)
+    goto leaked;
+
   sq->active = TRUE;
 
   /* Get a unique incrementing id */
@@ -2437,6 +2859,10 @@ gst_multi_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       GST_TIME_ARGS (GST_BUFFER_DTS (buffer)), GST_TIME_ARGS (duration));
 
   item = gst_multi_queue_buffer_item_new (GST_MINI_OBJECT_CAST (buffer), curid);
+  if (mq->budget) {
+    item->budget = gst_object_ref (mq->budget);
+    gst_queue_budget_charge (item->budget, item->size);
+  }
 
   /* Update interleave before pushing data into queue */
   if (mq->use_interleave) {
@@ -2464,6 +2890,8 @@ gst_multi_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (!(gst_data_queue_push (sq->queue, (GstDataQueueItem *) item)))
     goto flushing;
 
+  gst_multi_queue_wake_worker (mq);
+
   /* update time level, we must do this after pushing the data in the queue so
    * that we never end up filling the queue first. */
   apply_buffer (mq, sq, timestamp, duration, &sq->sink_segment);
@@ -2488,6 +2916,14 @@ was_eos:
     gst_object_unref (mq);
     return GST_FLOW_EOS;
   }
+leaked:
+  {
+    GST_DEBUG_OBJECT (mq, "SingleQueue %d : budget exhausted, dropping buffer",
+        sq->id);
+    gst_buffer_unref (buffer);
+    gst_object_unref (mq);
+    return GST_FLOW_OK;
+  }
 }
 
 static gboolean
@@ -2512,9 +2948,13 @@ gst_multi_queue_sink_activate_mode (GstPad * pad, GstObject * parent,
         /* All pads start off linked until they push one buffer */
         sq->srcresult = GST_FLOW_OK;
         sq->pushed = FALSE;
+        if (mq)
+          gst_single_queue_update_position (mq, sq);
         gst_data_queue_set_flushing (sq->queue, FALSE);
       } else {
         sq->srcresult = GST_FLOW_FLUSHING;
+        if (mq)
+          gst_single_queue_update_position (mq, sq);
         sq->last_query = FALSE;
         g_cond_signal (&sq->query_handled);
         gst_data_queue_set_flushing (sq->queue, TRUE);
@@ -2662,6 +3102,8 @@ gst_multi_queue_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   if (!gst_data_queue_push (sq->queue, (GstDataQueueItem *) item))
     goto flushing;
 
+  gst_multi_queue_wake_worker (mq);
+
   /* mark EOS when we received one, we must do that after putting the
    * buffer in the queue because EOS marks the buffer as filled. */
   switch (type) {
@@ -2701,8 +3143,10 @@ gst_multi_queue_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       /* a new segment allows us to accept more buffers if we got EOS
        * from downstream */
       GST_MULTI_QUEUE_MUTEX_LOCK (mq);
-      if (sq->srcresult == GST_FLOW_EOS)
+      if (sq->srcresult == GST_FLOW_EOS) {
         sq->srcresult = GST_FLOW_OK;
+        gst_single_queue_update_position (mq, sq);
+      }
       GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
       break;
     case GST_EVENT_GAP:
@@ -2782,6 +3226,8 @@ gst_multi_queue_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
           GST_MULTI_QUEUE_MUTEX_LOCK (mq);
           if (!res || sq->flushing)
             goto out_flushing;
+          if (mq->workers)
+            g_cond_signal (&mq->worker_cond);
           /* it might be that the query has been taken out of the queue
            * while we were unlocked. So, we need to check if the last
            * handled query is the same one than the one we just
@@ -2873,6 +3319,7 @@ gst_multi_queue_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_MULTI_QUEUE_MUTEX_LOCK (mq);
       if (sq->srcresult == GST_FLOW_NOT_LINKED) {
         sq->srcresult = GST_FLOW_OK;
+        gst_single_queue_update_position (mq, sq);
         g_cond_signal (&sq->turn);
       }
       GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
@@ -2926,8 +3373,8 @@ wake_up_next_non_linked (GstMultiQueue * mq)
       if (sq->srcresult == GST_FLOW_NOT_LINKED) {
         GstClockTimeDiff high_time;
 
-        if (GST_CLOCK_STIME_IS_VALID (sq->group_high_time))
-          high_time = sq->group_high_time;
+        if (GST_CLOCK_STIME_IS_VALID (sq->group->high_time))
+          high_time = sq->group->high_time;
         else
           high_time = mq->high_time;
 
@@ -2952,50 +3399,231 @@ wake_up_next_non_linked (GstMultiQueue * mq)
   }
 }
 
-/* WITH LOCK TAKEN */
+/*
+ * Position tracking functions
+ */
+
+static inline void
+heap_set (GPtrArray * heap, guint slot, guint i, GstSingleQueue * sq)
+{
+  g_ptr_array_index (heap, i) = sq;
+  sq->heap_pos[slot] = i;
+}
+
 static void
-compute_high_id (GstMultiQueue * mq)
+heap_sift_up (GPtrArray * heap, guint slot, guint i)
 {
-  /* The high-id is either the highest id among the linked pads, or if all
-   * pads are not-linked, it's the lowest not-linked pad */
-  GList *tmp;
-  guint32 lowest = G_MAXUINT32;
-  guint32 highid = G_MAXUINT32;
+  GstSingleQueue *sq = g_ptr_array_index (heap, i);
 
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
-    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
-    GstPad *srcpad = g_weak_ref_get (&sq->srcpad);
+  while (i > 0) {
+    guint parent = (i - 1) / 2;
+    GstSingleQueue *psq = g_ptr_array_index (heap, parent);
 
-    if (!srcpad) {
-      GST_INFO_OBJECT (mq,
-          "srcpad has been removed already... ignoring single queue");
+    if (psq->heap_key[slot] <= sq->heap_key[slot])
+      break;
 
-      continue;
-    }
+    heap_set (heap, slot, i, psq);
+    i = parent;
+  }
+  heap_set (heap, slot, i, sq);
+}
 
-    GST_LOG_OBJECT (mq, "inspecting sq:%d , nextid:%d, oldid:%d, srcresult:%s",
-        sq->id, sq->nextid, sq->oldid, gst_flow_get_name (sq->srcresult));
+static void
+heap_sift_down (GPtrArray * heap, guint slot, guint i)
+{
+  GstSingleQueue *sq = g_ptr_array_index (heap, i);
 
-    /* No need to consider queues which are not waiting */
-    if (sq->nextid == 0) {
-      GST_LOG_OBJECT (mq, "sq:%d is not waiting - ignoring", sq->id);
-      gst_object_unref (srcpad);
-      continue;
+  while (2 * i + 1 < heap->len) {
+    guint child = 2 * i + 1;
+    GstSingleQueue *csq = g_ptr_array_index (heap, child);
+
+    if (child + 1 < heap->len) {
+      GstSingleQueue *rsq = g_ptr_array_index (heap, child + 1);
+
+      if (rsq->heap_key[slot] < csq->heap_key[slot]) {
+        child++;
+        csq = rsq;
+      }
     }
 
-    if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-      if (sq->nextid < lowest)
-        lowest = sq->nextid;
-    } else if (!GST_PAD_IS_EOS (srcpad) && sq->srcresult != GST_FLOW_EOS) {
-      /* If we don't have a global highid, or the global highid is lower than
-       * this single queue's last outputted id, store the queue's one,
-       * unless the singlequeue output is at EOS */
-      if ((highid == G_MAXUINT32) || (sq->oldid > highid))
-        highid = sq->oldid;
+    if (sq->heap_key[slot] <= csq->heap_key[slot])
+      break;
+
+    heap_set (heap, slot, i, csq);
+    i = child;
+  }
+  heap_set (heap, slot, i, sq);
+}
+
+/* Add @sq to the heap with @key, update its key or remove it from the heap
+ * depending on @member */
+static void
+heap_update (GPtrArray * heap, guint slot, GstSingleQueue * sq,
+    gboolean member, gint64 key)
+{
+  gint pos = sq->heap_pos[slot];
+
+  if (!member) {
+    GstSingleQueue *last;
+
+    if (pos < 0)
+      return;
+
+    sq->heap_pos[slot] = -1;
+    last = g_ptr_array_remove_index (heap, heap->len - 1);
+    if (last != sq) {
+      heap_set (heap, slot, pos, last);
+      heap_sift_up (heap, slot, pos);
+      heap_sift_down (heap, slot, last->heap_pos[slot]);
     }
+    return;
+  }
+
+  if (pos >= 0 && sq->heap_key[slot] == key)
+    return;
+
+  sq->heap_key[slot] = key;
+  if (pos < 0) {
+    g_ptr_array_add (heap, sq);
+    heap_sift_up (heap, slot, heap->len - 1);
+  } else {
+    heap_sift_up (heap, slot, pos);
+    heap_sift_down (heap, slot, sq->heap_pos[slot]);
+  }
+}
+
+static inline GstSingleQueue *
+heap_top (GPtrArray * heap)
+{
+  return heap->len > 0 ? g_ptr_array_index (heap, 0) : NULL;
+}
+
+static void
+gst_multi_queue_group_free (GstMultiQueueGroup * group)
+{
+  g_ptr_array_free (group->high_time_heap, TRUE);
+  g_ptr_array_free (group->low_time_heap, TRUE);
+  g_free (group);
+}
+
+/* WITH LOCK TAKEN
+ * Must be called whenever anything compute_high_time() and
+ * compute_high_id() look at changes for @sq, that is its srcresult, the EOS
+ * state of its srcpad, last_time, next_time, nextid or oldid */
+static void
+gst_single_queue_update_position (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  GstPad *srcpad = g_weak_ref_get (&sq->srcpad);
+  gboolean linked = FALSE, not_linked = FALSE;
+  gboolean has_last_time, has_next_time;
+
+  if (srcpad) {
+    not_linked = sq->srcresult == GST_FLOW_NOT_LINKED;
+    /* linked queues are only taken into account until they are EOS */
+    linked = !not_linked && !GST_PAD_IS_EOS (srcpad)
+        && sq->srcresult != GST_FLOW_EOS;
     gst_object_unref (srcpad);
   }
 
+  has_last_time = linked && GST_CLOCK_STIME_IS_VALID (sq->last_time);
+  has_next_time = not_linked && GST_CLOCK_STIME_IS_VALID (sq->next_time);
+
+  heap_update (mq->high_time_heap, HEAP_HIGH_TIME, sq, has_last_time,
+      has_last_time ? -sq->last_time : 0);
+  heap_update (mq->low_time_heap, HEAP_LOW_TIME, sq, has_next_time,
+      sq->next_time);
+  heap_update (mq->high_id_heap, HEAP_HIGH_ID, sq, linked && sq->nextid != 0,
+      -(gint64) sq->oldid);
+  heap_update (mq->low_id_heap, HEAP_LOW_ID, sq, not_linked
+      && sq->nextid != 0, sq->nextid);
+
+  if (sq->group) {
+    heap_update (sq->group->high_time_heap, HEAP_GROUP_HIGH_TIME, sq,
+        has_last_time, has_last_time ? -sq->last_time : 0);
+    heap_update (sq->group->low_time_heap, HEAP_GROUP_LOW_TIME, sq,
+        has_next_time, sq->next_time);
+  }
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_leave_group (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  if (sq->group == NULL)
+    return;
+
+  heap_update (sq->group->high_time_heap, HEAP_GROUP_HIGH_TIME, sq, FALSE, 0);
+  heap_update (sq->group->low_time_heap, HEAP_GROUP_LOW_TIME, sq, FALSE, 0);
+  sq->group->count--;
+  sq->group = NULL;
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_set_group (GstMultiQueue * mq, GstSingleQueue * sq,
+    guint groupid)
+{
+  GstMultiQueueGroup *group = NULL;
+  GList *tmp;
+
+  if (sq->group && sq->groupid == groupid)
+    return;
+
+  gst_single_queue_leave_group (mq, sq);
+
+  for (tmp = mq->groups; tmp; tmp = g_list_next (tmp)) {
+    if (((GstMultiQueueGroup *) tmp->data)->groupid == groupid) {
+      group = tmp->data;
+      break;
+    }
+  }
+
+  if (group == NULL) {
+    group = g_new0 (GstMultiQueueGroup, 1);
+    group->groupid = groupid;
+    group->high_time_heap = g_ptr_array_new ();
+    group->low_time_heap = g_ptr_array_new ();
+    group->high_time = GST_CLOCK_STIME_NONE;
+    mq->groups = g_list_prepend (mq->groups, group);
+  }
+
+  sq->groupid = groupid;
+  sq->group = group;
+  group->count++;
+
+  gst_single_queue_update_position (mq, sq);
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_remove_position (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  gst_single_queue_leave_group (mq, sq);
+
+  heap_update (mq->high_time_heap, HEAP_HIGH_TIME, sq, FALSE, 0);
+  heap_update (mq->low_time_heap, HEAP_LOW_TIME, sq, FALSE, 0);
+  heap_update (mq->high_id_heap, HEAP_HIGH_ID, sq, FALSE, 0);
+  heap_update (mq->low_id_heap, HEAP_LOW_ID, sq, FALSE, 0);
+}
+
+/* WITH LOCK TAKEN */
+static void
+compute_high_id (GstMultiQueue * mq)
+{
+  /* The high-id is either the highest id among the linked pads, or if all
+   * pads are not-linked, it's the lowest not-linked pad */
+  GstSingleQueue *sq;
+  guint32 lowest = G_MAXUINT32;
+  guint32 highid = G_MAXUINT32;
+
+  if ((sq = heap_top (mq->low_id_heap)))
+    lowest = sq->nextid;
+
+  /* the highest last outputted id of the waiting linked queues which are
+   * not at EOS yet */
+  if ((sq = heap_top (mq->high_id_heap)))
+    highid = sq->oldid;
+
   if (highid == G_MAXUINT32 || lowest < highid)
     mq->highid = lowest;
   else
@@ -3007,79 +3635,30 @@ compute_high_id (GstMultiQueue * mq)
 
 /* WITH LOCK TAKEN */
 static void
-compute_high_time (GstMultiQueue * mq, guint groupid)
+compute_high_time (GstMultiQueue * mq, GstMultiQueueGroup * group)
 {
   /* The high-time is either the highest last time among the linked
    * pads, or if all pads are not-linked, it's the lowest nex time of
    * not-linked pad */
-  GList *tmp;
+  GstSingleQueue *sq;
   GstClockTimeDiff highest = GST_CLOCK_STIME_NONE;
   GstClockTimeDiff lowest = GST_CLOCK_STIME_NONE;
   GstClockTimeDiff group_high = GST_CLOCK_STIME_NONE;
   GstClockTimeDiff group_low = GST_CLOCK_STIME_NONE;
   GstClockTimeDiff res;
-  /* Number of streams which belong to groupid */
-  guint group_count = 0;
 
   if (!mq->sync_by_running_time)
     /* return GST_CLOCK_STIME_NONE; */
     return;
 
-  for (tmp = mq->queues; tmp; tmp = tmp->next) {
-    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
-    GstPad *srcpad = g_weak_ref_get (&sq->srcpad);
-
-    if (!srcpad) {
-      GST_INFO_OBJECT (mq,
-          "srcpad has been removed already... ignoring single queue");
-
-      continue;
-    }
-
-    GST_LOG_OBJECT (mq,
-        "inspecting sq:%d (group:%d) , next_time:%" GST_STIME_FORMAT
-        ", last_time:%" GST_STIME_FORMAT ", srcresult:%s", sq->id, sq->groupid,
-        GST_STIME_ARGS (sq->next_time), GST_STIME_ARGS (sq->last_time),
-        gst_flow_get_name (sq->srcresult));
-
-    if (sq->groupid == groupid)
-      group_count++;
-
-    if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-      /* No need to consider queues which are not waiting */
-      if (!GST_CLOCK_STIME_IS_VALID (sq->next_time)) {
-        GST_LOG_OBJECT (mq, "sq:%d is not waiting - ignoring", sq->id);
-        gst_object_unref (srcpad);
-        continue;
-      }
-
-      if (lowest == GST_CLOCK_STIME_NONE || sq->next_time < lowest)
-        lowest = sq->next_time;
-      if (sq->groupid == groupid && (group_low == GST_CLOCK_STIME_NONE
-              || sq->next_time < group_low))
-        group_low = sq->next_time;
-    } else if (!GST_PAD_IS_EOS (srcpad) && sq->srcresult != GST_FLOW_EOS) {
-      /* If we don't have a global high time, or the global high time
-       * is lower than this single queue's last outputted time, store
-       * the queue's one, unless the singlequeue output is at EOS. */
-      if (highest == GST_CLOCK_STIME_NONE
-          || (sq->last_time != GST_CLOCK_STIME_NONE && sq->last_time > highest))
-        highest = sq->last_time;
-      if (sq->groupid == groupid && (group_high == GST_CLOCK_STIME_NONE
-              || (sq->last_time != GST_CLOCK_STIME_NONE
-                  && sq->last_time > group_high)))
-        group_high = sq->last_time;
-    }
-    GST_LOG_OBJECT (mq,
-        "highest now %" GST_STIME_FORMAT " lowest %" GST_STIME_FORMAT,
-        GST_STIME_ARGS (highest), GST_STIME_ARGS (lowest));
-    if (sq->groupid == groupid)
-      GST_LOG_OBJECT (mq,
-          "grouphigh %" GST_STIME_FORMAT " grouplow %" GST_STIME_FORMAT,
-          GST_STIME_ARGS (group_high), GST_STIME_ARGS (group_low));
-
-    gst_object_unref (srcpad);
-  }
+  if ((sq = heap_top (mq->high_time_heap)))
+    highest = sq->last_time;
+  if ((sq = heap_top (mq->low_time_heap)))
+    lowest = sq->next_time;
+  if ((sq = heap_top (group->high_time_heap)))
+    group_high = sq->last_time;
+  if ((sq = heap_top (group->low_time_heap)))
+    group_low = sq->next_time;
 
   if (highest == GST_CLOCK_STIME_NONE)
     mq->high_time = lowest;
@@ -3087,25 +3666,22 @@ compute_high_time (GstMultiQueue * mq, guint groupid)
     mq->high_time = highest;
 
   /* If there's only one stream of a given type, use the global high */
-  if (group_count < 2)
+  if (group->count < 2)
     res = GST_CLOCK_STIME_NONE;
   else if (group_high == GST_CLOCK_STIME_NONE)
     res = group_low;
   else
     res = group_high;
 
-  GST_LOG_OBJECT (mq, "group count %d for groupid %u", group_count, groupid);
+  GST_LOG_OBJECT (mq, "group count %d for groupid %u", group->count,
+      group->groupid);
   GST_LOG_OBJECT (mq,
       "MQ High time is now : %" GST_STIME_FORMAT ", group %d high time %"
       GST_STIME_FORMAT ", lowest non-linked %" GST_STIME_FORMAT,
-      GST_STIME_ARGS (mq->high_time), groupid, GST_STIME_ARGS (mq->high_time),
+      GST_STIME_ARGS (mq->high_time), group->groupid, GST_STIME_ARGS (res),
       GST_STIME_ARGS (lowest));
 
-  for (tmp = mq->queues; tmp; tmp = tmp->next) {
-    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
-    if (groupid == sq->groupid)
-      sq->group_high_time = res;
-  }
+  group->high_time = res;
 }
 
 #define IS_FILLED(q, format, value) (((q)->max_size.format) != 0 && \
@@ -3263,6 +3839,12 @@ single_queue_check_full (GstDataQueue * dataq, guint visible, guint bytes,
     goto done;
   }
 
+  /* stay within the memory budget shared with other queues */
+  if (single_queue_budget_blocks (mq, visible)) {
+    res = TRUE;
+    goto done;
+  }
+
   /* we never go past the max visible items unless we are in buffering mode */
   if (!mq->use_buffering && IS_FILLED (sq, visible, visible)) {
     res = TRUE;
@@ -3373,6 +3955,7 @@ gst_single_queue_new (GstMultiQueue * mqueue, guint id)
   gchar *name;
   GList *tmp;
   guint temp_id = (id == -1) ? 0 : id;
+  guint i;
 
   GST_MULTI_QUEUE_MUTEX_LOCK (mqueue);
 
@@ -3399,8 +3982,10 @@ gst_single_queue_new (GstMultiQueue * mqueue, guint id)
 
   mqueue->nbqueues++;
   sq->id = temp_id;
-  sq->groupid = DEFAULT_PAD_GROUP_ID;
-  sq->group_high_time = GST_CLOCK_STIME_NONE;
+  for (i = 0; i < N_HEAPS; i++)
+    sq->heap_pos[i] = -1;
+  gst_single_queue_set_group (mqueue, sq, DEFAULT_PAD_GROUP_ID);
+  sq->worker_paused = TRUE;
 
   mqueue->queues = g_list_insert_before (mqueue->queues, tmp, sq);
   mqueue->queues_cookie++;
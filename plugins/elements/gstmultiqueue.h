@@ -25,6 +25,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstdataqueue.h>
+#include <gst/base/gstqueuebudget.h>
 
 G_BEGIN_DECLS
 
@@ -74,6 +75,12 @@ struct _GstMultiQueue {
   guint32  highid;	/* contains highest id of last outputted object */
   GstClockTimeDiff high_time; /* highest start running time */
 
+  /* single queues sorted by the positions used to compute highid and
+   * high_time, and the groups of streams. Protected by the global lock */
+  GPtrArray *high_time_heap, *low_time_heap;
+  GPtrArray *high_id_heap, *low_id_heap;
+  GList *groups;
+
   GMutex   qlock;	/* Global queue lock (vs object lock or individual */
 			/* queues lock). Protects nbqueues, queues, global */
 			/* GstMultiQueueSize, counter and highid */
@@ -87,6 +94,16 @@ struct _GstMultiQueue {
   GstClockTimeDiff last_interleave_update;
 
   GstClockTime unlinked_cache_time;
+
+  /* worker threads servicing all queues, NULL when every queue has its own
+   * streaming thread. Protected by the global lock */
+  guint n_workers;
+  GPtrArray *workers;
+  gboolean workers_running;
+  GCond worker_cond;
+
+  /* memory budget shared with other queues, only changed up to READY */
+  GstQueueBudget *budget;
 };
 
 struct _GstMultiQueueClass {
@@ -100,6 +100,8 @@ static void gst_output_selector_release_pad (GstElement * element,
     GstPad * pad);
 static GstFlowReturn gst_output_selector_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_output_selector_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstStateChangeReturn gst_output_selector_change_state (GstElement *
     element, GstStateChange transition);
 static gboolean gst_output_selector_event (GstPad * pad, GstObject * parent,
@@ -163,6 +165,8 @@ gst_output_selector_init (GstOutputSelector * sel)
       "sink");
   gst_pad_set_chain_function (sel->sinkpad,
       GST_DEBUG_FUNCPTR (gst_output_selector_chain));
+  gst_pad_set_chain_list_function (sel->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_output_selector_chain_list));
   gst_pad_set_event_function (sel->sinkpad,
       GST_DEBUG_FUNCPTR (gst_output_selector_event));
   gst_pad_set_query_function (sel->sinkpad,
@@ -175,6 +179,8 @@ gst_output_selector_init (GstOutputSelector * sel)
   sel->nb_srcpads = 0;
   gst_segment_init (&sel->segment, GST_FORMAT_UNDEFINED);
   sel->pending_srcpad = NULL;
+  sel->streaming_srcpad = NULL;
+  sel->active_changed = FALSE;
 
   sel->resend_latest = FALSE;
   sel->latest_buffer = NULL;
@@ -195,6 +201,8 @@ gst_output_selector_reset (GstOutputSelector * osel)
     gst_buffer_unref (osel->latest_buffer);
     osel->latest_buffer = NULL;
   }
+  gst_clear_object (&osel->streaming_srcpad);
+  g_atomic_int_set (&osel->active_changed, TRUE);
   osel->segment_seqnum = GST_SEQNUM_INVALID;
   GST_OBJECT_UNLOCK (osel);
   gst_segment_init (&osel->segment, GST_FORMAT_UNDEFINED);
@@ -249,6 +257,7 @@ gst_output_selector_set_property (GObject * object, guint prop_id,
           sel->pending_srcpad = NULL;
         }
       }
+      g_atomic_int_set (&sel->active_changed, TRUE);
       GST_OBJECT_UNLOCK (object);
       break;
     }
@@ -388,6 +397,7 @@ gst_output_selector_request_new_pad (GstElement * element,
   GST_OBJECT_LOCK (osel);
   if (osel->active_srcpad == NULL) {
     osel->active_srcpad = srcpad;
+    g_atomic_int_set (&osel->active_changed, TRUE);
     GST_OBJECT_UNLOCK (osel);
     g_object_notify (G_OBJECT (osel), "active-pad");
   } else {
@@ -411,6 +421,7 @@ gst_output_selector_release_pad (GstElement * element, GstPad * pad)
   GST_OBJECT_LOCK (osel);
   if (osel->active_srcpad == pad) {
     osel->active_srcpad = NULL;
+    g_atomic_int_set (&osel->active_changed, TRUE);
     GST_OBJECT_UNLOCK (osel);
     g_object_notify (G_OBJECT (osel), "active-pad");
   } else {
@@ -497,15 +508,14 @@ gst_output_selector_switch (GstOutputSelector * osel)
   return res;
 }
 
-static GstFlowReturn
-gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+/* Update the latest buffer and the last stop from @buf and return the
+ * active srcpad, or %NULL if there is none. The returned pad is owned by
+ * the streaming thread, which only takes the object lock when the active pad
+ * was changed. */
+static GstPad *
+gst_output_selector_prepare_push (GstOutputSelector * osel, GstBuffer * buf)
 {
-  GstFlowReturn res;
-  GstOutputSelector *osel;
   GstClockTime position, duration;
-  GstPad *active_srcpad;
-
-  osel = GST_OUTPUT_SELECTOR (parent);
 
   /*
    * The _switch function might push a buffer if 'resend-latest' is true.
@@ -518,29 +528,40 @@ gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
    * So we always should check the pending_srcpad before going further down
    * the chain and pushing the new buffer
    */
-  while (osel->pending_srcpad) {
-    /* Do the switch */
-    gst_output_selector_switch (osel);
+  while (G_UNLIKELY (g_atomic_int_get (&osel->active_changed))) {
+    /* clear before looking at the pads, so that changes made from now on
+     * are picked up with the next buffer */
+    g_atomic_int_set (&osel->active_changed, FALSE);
+
+    while (osel->pending_srcpad) {
+      /* Do the switch */
+      gst_output_selector_switch (osel);
+    }
+
+    GST_OBJECT_LOCK (osel);
+    gst_object_replace ((GstObject **) & osel->streaming_srcpad,
+        (GstObject *) osel->active_srcpad);
+    GST_OBJECT_UNLOCK (osel);
   }
 
-  active_srcpad = gst_output_selector_get_active (osel);
-  if (!active_srcpad) {
+  if (!osel->streaming_srcpad) {
     GST_DEBUG_OBJECT (osel, "No active srcpad");
-    gst_buffer_unref (buf);
-    return GST_FLOW_OK;
+    return NULL;
   }
 
-  GST_OBJECT_LOCK (osel);
-  if (osel->latest_buffer) {
-    gst_buffer_unref (osel->latest_buffer);
-    osel->latest_buffer = NULL;
-  }
+  if (osel->resend_latest || osel->latest_buffer) {
+    GST_OBJECT_LOCK (osel);
+    if (osel->latest_buffer) {
+      gst_buffer_unref (osel->latest_buffer);
+      osel->latest_buffer = NULL;
+    }
 
-  if (osel->resend_latest) {
-    /* Keep reference to latest buffer to resend it after switch */
-    osel->latest_buffer = gst_buffer_ref (buf);
+    if (osel->resend_latest) {
+      /* Keep reference to latest buffer to resend it after switch */
+      osel->latest_buffer = gst_buffer_ref (buf);
+    }
+    GST_OBJECT_UNLOCK (osel);
   }
-  GST_OBJECT_UNLOCK (osel);
 
   /* Keep track of last stop and use it in SEGMENT start after
      switching to a new src pad */
@@ -555,10 +576,60 @@ gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     osel->segment.position = position;
   }
 
+  return osel->streaming_srcpad;
+}
+
+static GstFlowReturn
+gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstFlowReturn res;
+  GstOutputSelector *osel;
+  GstPad *active_srcpad;
+
+  osel = GST_OUTPUT_SELECTOR (parent);
+
+  active_srcpad = gst_output_selector_prepare_push (osel, buf);
+  if (!active_srcpad) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
+  }
+
   GST_LOG_OBJECT (osel, "pushing buffer to %" GST_PTR_FORMAT, active_srcpad);
   res = gst_pad_push (active_srcpad, buf);
 
-  gst_object_unref (active_srcpad);
+  return res;
+}
+
+static GstFlowReturn
+gst_output_selector_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFlowReturn res;
+  GstOutputSelector *osel;
+  GstPad *active_srcpad;
+  guint len;
+
+  osel = GST_OUTPUT_SELECTOR (parent);
+
+  len = gst_buffer_list_length (list);
+  if (len == 0) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  /* the last buffer of the list is the one to resend and the one that
+   * defines the last stop */
+  active_srcpad =
+      gst_output_selector_prepare_push (osel, gst_buffer_list_get (list,
+          len - 1));
+  if (!active_srcpad) {
+    gst_buffer_list_unref (list);
+    return GST_FLOW_OK;
+  }
+
+  GST_LOG_OBJECT (osel, "pushing buffer list to %" GST_PTR_FORMAT,
+      active_srcpad);
+  res = gst_pad_push_list (active_srcpad, list);
 
   return res;
 }
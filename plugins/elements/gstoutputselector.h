@@ -47,6 +47,11 @@ struct _GstOutputSelector {
   GstPad *pending_srcpad;
   guint nb_srcpads;
 
+  /* ref to the active srcpad as used by the streaming thread, refreshed
+   * when active_changed (atomic) is set */
+  GstPad *streaming_srcpad;
+  gint active_changed;
+
   gint pad_negotiation_mode;
 
   GstSegment segment;
@@ -54,6 +54,15 @@
  * the specified minimum thresholds require (by default: when the queue is
  * empty). The #GstQueue::overrun signal is emitted when the queue is filled
  * up. Both signals are emitted from the context of the streaming thread.
+ *
+ * Instead of a dedicated thread, the source pad can also be serviced from
+ * a #GstTaskPool shared with other elements by setting the
+ * #GstQueue:task-pool property. The queue then only occupies a thread of
+ * the pool while it has data to push.
+ *
+ * The memory held by several queues can be bounded together by sharing a
+ * #GstQueueBudget with the #GstQueue:budget property or with a #GstContext
+ * of type #GST_QUEUE_BUDGET_CONTEXT_TYPE set on the pipeline.
  */
 
 #include "gst/gst_private.h"
@@ -61,6 +70,7 @@
 #include <gst/gst.h>
 #include "gstqueue.h"
 #include "gstcoreelementselements.h"
+#include "gstelements_private.h"
 
 #include "../../gst/gst-i18n-lib.h"
 #include "../../gst/glib-compat-private.h"
@@ -122,33 +132,92 @@ enum
   PROP_MIN_THRESHOLD_TIME,
   PROP_LEAKY,
   PROP_SILENT,
-  PROP_FLUSH_ON_EOS
+  PROP_FLUSH_ON_EOS,
+  PROP_SPIN_TIME,
+  PROP_MAX_BATCH_BUFFERS,
+  PROP_MAX_BATCH_BYTES,
+  PROP_MAX_BATCH_TIME,
+  PROP_TASK_POOL,
+  PROP_BUDGET
 };
 
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS  200   /* 200 buffers */
 #define DEFAULT_MAX_SIZE_BYTES    (10 * 1024 * 1024)    /* 10 MB       */
 #define DEFAULT_MAX_SIZE_TIME     GST_SECOND    /* 1 second    */
-
+#define DEFAULT_SPIN_TIME         0
+#define DEFAULT_MAX_BATCH_BUFFERS 1     /* no batching */
+#define DEFAULT_MAX_BATCH_BYTES   0     /* unlimited */
+#define DEFAULT_MAX_BATCH_TIME    0     /* unlimited */
+
+/* items pushed by a task pool work item before it yields the pool thread */
+#define POOL_PUSH_BUDGET          64
+
+#ifdef GST_ENABLE_LOCK_TRACING
+#define GST_QUEUE_MUTEX_LOCK(q) \
+    _gst_tracer_mutex_lock (&q->qlock, GST_OBJECT_CAST (q), G_STRLOC)
+#define GST_QUEUE_MUTEX_UNLOCK(q) \
+    _gst_tracer_mutex_unlock (&q->qlock, GST_OBJECT_CAST (q))
+#define GST_QUEUE_COND_WAIT(q, cond) \
+    _gst_tracer_cond_wait (cond, &q->qlock, GST_OBJECT_CAST (q), G_STRLOC)
+#else
 #define GST_QUEUE_MUTEX_LOCK(q) G_STMT_START {                          \
   g_mutex_lock (&q->qlock);                                              \
 } G_STMT_END
 
+#define GST_QUEUE_MUTEX_UNLOCK(q) G_STMT_START {                        \
+  g_mutex_unlock (&q->qlock);                                            \
+} G_STMT_END
+
+#define GST_QUEUE_COND_WAIT(q, cond) g_cond_wait (cond, &q->qlock)
+#endif
+
 #define GST_QUEUE_MUTEX_LOCK_CHECK(q,label) G_STMT_START {              \
   GST_QUEUE_MUTEX_LOCK (q);                                             \
   if (q->srcresult != GST_FLOW_OK)                                      \
     goto label;                                                         \
 } G_STMT_END
 
-#define GST_QUEUE_MUTEX_UNLOCK(q) G_STMT_START {                        \
-  g_mutex_unlock (&q->qlock);                                            \
-} G_STMT_END
+/* With a spin time, waiters first busy-wait for the seqnum of the signal
+ * they are waiting for to change. The other side only has to signal the
+ * condition when the waiter actually went to sleep, which saves the futex
+ * wake/sleep pair for every item when both threads keep up. Returns TRUE
+ * if a signal happened and the caller must recheck its condition. Must be
+ * called with qlock held. */
+static gboolean
+gst_queue_spin_wait (GstQueue * queue, gint * seqnum)
+{
+  gint64 deadline;
+  gint seq;
+  gboolean changed = FALSE;
+
+  if (queue->spin_time == 0)
+    return FALSE;
+
+  seq = g_atomic_int_get (seqnum);
+  deadline = g_get_monotonic_time () + queue->spin_time / GST_USECOND;
+
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+  do {
+    if (g_atomic_int_get (seqnum) != seq) {
+      changed = TRUE;
+      break;
+    }
+  } while (g_get_monotonic_time () < deadline);
+  GST_QUEUE_MUTEX_LOCK (queue);
+
+  /* a signal could have happened after our last check, before we got the
+   * lock back, and it would not have woken us up */
+  return changed || g_atomic_int_get (seqnum) != seq;
+}
 
 #define GST_QUEUE_WAIT_DEL_CHECK(q, label) G_STMT_START {               \
   STATUS (q, q->sinkpad, "wait for DEL");                               \
-  q->waiting_del = TRUE;                                                \
-  g_cond_wait (&q->item_del, &q->qlock);                                  \
-  q->waiting_del = FALSE;                                               \
+  if (!gst_queue_spin_wait (q, &q->del_seqnum)) {                       \
+    q->waiting_del = TRUE;                                              \
+    GST_QUEUE_COND_WAIT (q, &q->item_del);                              \
+    q->waiting_del = FALSE;                                             \
+  }                                                                     \
   if (q->srcresult != GST_FLOW_OK) {                                    \
     STATUS (q, q->srcpad, "received DEL wakeup");                       \
     goto label;                                                         \
@@ -158,9 +227,11 @@ enum
 
 #define GST_QUEUE_WAIT_ADD_CHECK(q, label) G_STMT_START {               \
   STATUS (q, q->srcpad, "wait for ADD");                                \
-  q->waiting_add = TRUE;                                                \
-  g_cond_wait (&q->item_add, &q->qlock);                                  \
-  q->waiting_add = FALSE;                                               \
+  if (!gst_queue_spin_wait (q, &q->add_seqnum)) {                       \
+    q->waiting_add = TRUE;                                              \
+    GST_QUEUE_COND_WAIT (q, &q->item_add);                              \
+    q->waiting_add = FALSE;                                             \
+  }                                                                     \
   if (q->srcresult != GST_FLOW_OK) {                                    \
     STATUS (q, q->srcpad, "received ADD wakeup");                       \
     goto label;                                                         \
@@ -169,6 +240,7 @@ enum
 } G_STMT_END
 
 #define GST_QUEUE_SIGNAL_DEL(q) G_STMT_START {                          \
+  g_atomic_int_inc (&q->del_seqnum);                                    \
   if (q->waiting_del) {                                                 \
     STATUS (q, q->srcpad, "signal DEL");                                \
     g_cond_signal (&q->item_del);                                        \
@@ -176,10 +248,13 @@ enum
 } G_STMT_END
 
 #define GST_QUEUE_SIGNAL_ADD(q) G_STMT_START {                          \
+  g_atomic_int_inc (&q->add_seqnum);                                    \
   if (q->waiting_add) {                                                 \
     STATUS (q, q->sinkpad, "signal ADD");                               \
     g_cond_signal (&q->item_add);                                        \
   }                                                                     \
+  if (q->push_pool)                                                     \
+    gst_queue_schedule_push (q);                                        \
 } G_STMT_END
 
 #define _do_init \
@@ -202,6 +277,9 @@ static GstFlowReturn gst_queue_chain_list (GstPad * pad, GstObject * parent,
     GstBufferList * buffer_list);
 static GstFlowReturn gst_queue_push_one (GstQueue * queue);
 static void gst_queue_loop (GstPad * pad);
+static void gst_queue_schedule_push (GstQueue * queue);
+static gboolean gst_queue_start_pushing (GstQueue * queue);
+static void gst_queue_pause_pushing (GstQueue * queue);
 
 static GstFlowReturn gst_queue_handle_sink_event (GstPad * pad,
     GstObject * parent, GstEvent * event);
@@ -222,6 +300,9 @@ static gboolean gst_queue_sink_activate_mode (GstPad * pad, GstObject * parent,
 
 static gboolean gst_queue_is_empty (GstQueue * queue);
 static gboolean gst_queue_is_filled (GstQueue * queue);
+static gboolean gst_queue_budget_blocks (GstQueue * queue);
+
+static void gst_queue_set_context (GstElement * element, GstContext * context);
 
 
 typedef struct
@@ -231,26 +312,6 @@ typedef struct
   gboolean is_query;
 } GstQueueItem;
 
-#define GST_TYPE_QUEUE_LEAKY (queue_leaky_get_type ())
-
-static GType
-queue_leaky_get_type (void)
-{
-  static GType queue_leaky_type = 0;
-  static const GEnumValue queue_leaky[] = {
-    {GST_QUEUE_NO_LEAK, "Not Leaky", "no"},
-    {GST_QUEUE_LEAK_UPSTREAM, "Leaky on upstream (new buffers)", "upstream"},
-    {GST_QUEUE_LEAK_DOWNSTREAM, "Leaky on downstream (old buffers)",
-        "downstream"},
-    {0, NULL, NULL},
-  };
-
-  if (!queue_leaky_type) {
-    queue_leaky_type = g_enum_register_static ("GstQueueLeaky", queue_leaky);
-  }
-  return queue_leaky_type;
-}
-
 static guint gst_queue_signals[LAST_SIGNAL] = { 0 };
 
 static void
@@ -405,7 +466,119 @@ gst_queue_class_init (GstQueueClass * klass)
           G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
           G_PARAM_STATIC_STRINGS));
 
+  /**
+   * queue:spin-time:
+   *
+   * Busy-wait for up to this amount of time for data or free space before
+   * going to sleep. When both sides of the queue keep up with each other
+   * this avoids waking up a sleeping thread for every buffer, at the
+   * expense of CPU time spent spinning. Spinning is disabled on machines
+   * with a single CPU.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_SPIN_TIME,
+      g_param_spec_uint64 ("spin-time", "Spin time",
+          "Time in ns to busy-wait before sleeping when the queue is empty "
+          "or full (0 = disable)", 0, GST_SECOND, DEFAULT_SPIN_TIME,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * queue:max-batch-buffers:
+   *
+   * Maximum number of consecutive buffers that are taken out of the queue
+   * at once and pushed downstream as one #GstBufferList. Batching never
+   * crosses events or queries, so serialization is not affected. Set to 1
+   * to push every buffer on its own.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BATCH_BUFFERS,
+      g_param_spec_uint ("max-batch-buffers", "Max. batch buffers",
+          "Max. number of queued buffers to push downstream as one buffer "
+          "list (1 = disable batching)", 1, G_MAXUINT,
+          DEFAULT_MAX_BATCH_BUFFERS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * queue:max-batch-bytes:
+   *
+   * Maximum amount of data in bytes that is pushed downstream as one
+   * #GstBufferList when #queue:max-batch-buffers is bigger than 1.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BATCH_BYTES,
+      g_param_spec_uint ("max-batch-bytes", "Max. batch bytes",
+          "Max. amount of data in a pushed buffer list (bytes, 0=unlimited)",
+          0, G_MAXUINT, DEFAULT_MAX_BATCH_BYTES,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * queue:max-batch-time:
+   *
+   * Maximum timestamp difference between the first and the last buffer of
+   * a #GstBufferList pushed downstream when #queue:max-batch-buffers is
+   * bigger than 1. Limits the latency that batching adds.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_BATCH_TIME,
+      g_param_spec_uint64 ("max-batch-time", "Max. batch time",
+          "Max. timestamp span of a pushed buffer list (in ns, 0=unlimited)",
+          0, G_MAXUINT64, DEFAULT_MAX_BATCH_TIME,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * queue:task-pool:
+   *
+   * A #GstTaskPool, for example a #GstSharedTaskPool, to push the queued
+   * data from instead of a dedicated streaming thread. A work item is only
+   * scheduled on the pool when data is available, and it yields the pool
+   * thread again after a number of items so that other users of the pool
+   * are not starved.
+   *
+   * The pool must have been prepared with gst_task_pool_prepare(). Note
+   * that a work item blocks its pool thread while downstream blocks, for
+   * example in a sink waiting for preroll, so the pool needs enough
+   * threads for all queues that can block at the same time.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_TASK_POOL,
+      g_param_spec_object ("task-pool", "Task pool",
+          "Task pool to push data from instead of a dedicated thread "
+          "(NULL = dedicated thread)", GST_TYPE_TASK_POOL,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * queue:budget:
+   *
+   * A #GstQueueBudget shared with other queues, the bytes held by the queue
+   * are charged to it. While the budget is exhausted, the queue drops new
+   * buffers or makes upstream wait until its data was pushed, depending on
+   * the #GstQueueBudget:policy. A queue without buffers always accepts one,
+   * so that all queues sharing the budget can make progress.
+   *
+   * The budget can also be set with a #GstContext of type
+   * #GST_QUEUE_BUDGET_CONTEXT_TYPE, the last one set is used.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_BUDGET,
+      g_param_spec_object ("budget", "Budget",
+          "Memory budget shared with other queues (NULL = no shared budget)",
+          GST_TYPE_QUEUE_BUDGET,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_queue_finalize;
+  gstelement_class->set_context = gst_queue_set_context;
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Queue",
@@ -460,11 +633,16 @@ gst_queue_init (GstQueue * queue)
 
   queue->leaky = GST_QUEUE_NO_LEAK;
   queue->srcresult = GST_FLOW_FLUSHING;
+  queue->spin_time = DEFAULT_SPIN_TIME;
+  queue->max_batch.buffers = DEFAULT_MAX_BATCH_BUFFERS;
+  queue->max_batch.bytes = DEFAULT_MAX_BATCH_BYTES;
+  queue->max_batch.time = DEFAULT_MAX_BATCH_TIME;
 
   g_mutex_init (&queue->qlock);
   g_cond_init (&queue->item_add);
   g_cond_init (&queue->item_del);
   g_cond_init (&queue->query_handled);
+  g_cond_init (&queue->push_done);
 
   queue->queue =
       gst_queue_array_new_for_struct (sizeof (GstQueueItem),
@@ -497,11 +675,22 @@ gst_queue_finalize (GObject * object)
       gst_mini_object_unref (qitem->item);
   }
   gst_queue_array_free (queue->queue);
+  if (queue->spare_queue)
+    gst_queue_array_free (queue->spare_queue);
 
   g_mutex_clear (&queue->qlock);
   g_cond_clear (&queue->item_add);
   g_cond_clear (&queue->item_del);
   g_cond_clear (&queue->query_handled);
+  g_cond_clear (&queue->push_done);
+
+  if (queue->task_pool)
+    gst_object_unref (queue->task_pool);
+
+  if (queue->budget) {
+    gst_queue_budget_release (queue->budget, queue->budget_charged);
+    gst_object_unref (queue->budget);
+  }
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -698,12 +887,49 @@ apply_buffer_list (GstQueue * queue, GstBufferList * buffer_list,
   update_time_level (queue);
 }
 
+/* charges the change of the byte level to the budget, with QUEUE_LOCK */
+static inline void
+gst_queue_locked_update_budget (GstQueue * queue)
+{
+  guint64 bytes = queue->cur_level.bytes;
+
+  if (queue->budget == NULL || bytes == queue->budget_charged)
+    return;
+
+  if (bytes > queue->budget_charged)
+    gst_queue_budget_charge (queue->budget, bytes - queue->budget_charged);
+  else
+    gst_queue_budget_release (queue->budget, queue->budget_charged - bytes);
+  queue->budget_charged = bytes;
+}
+
+/* moves the charged bytes to @budget, with QUEUE_LOCK */
 static void
-gst_queue_locked_flush (GstQueue * queue, gboolean full)
+gst_queue_locked_set_budget (GstQueue * queue, GstQueueBudget * budget)
+{
+  if (queue->budget == budget)
+    return;
+
+  if (queue->budget) {
+    gst_queue_budget_release (queue->budget, queue->budget_charged);
+    gst_object_unref (queue->budget);
+  }
+  queue->budget = budget ? gst_object_ref (budget) : NULL;
+  queue->budget_charged = 0;
+  gst_queue_locked_update_budget (queue);
+
+  /* upstream might be waiting for the old budget */
+  GST_QUEUE_SIGNAL_DEL (queue);
+}
+
+/* drops all items of @items, sticky events are stored on the srcpad unless
+ * @full is set */
+static void
+gst_queue_drop_items (GstQueue * queue, GstQueueArray * items, gboolean full)
 {
   GstQueueItem *qitem;
 
-  while ((qitem = gst_queue_array_pop_head_struct (queue->queue))) {
+  while ((qitem = gst_queue_array_pop_head_struct (items))) {
     /* Then lose another reference because we are supposed to destroy that
        data when flushing */
     if (!full && !qitem->is_query && GST_IS_EVENT (qitem->item)
@@ -716,9 +942,16 @@ gst_queue_locked_flush (GstQueue * queue, gboolean full)
       gst_mini_object_unref (qitem->item);
     memset (qitem, 0, sizeof (GstQueueItem));
   }
+}
+
+/* resets the levels and segments after the items were removed */
+static void
+gst_queue_locked_reset (GstQueue * queue)
+{
   queue->last_query = FALSE;
   g_cond_signal (&queue->query_handled);
   GST_QUEUE_CLEAR_LEVEL (queue->cur_level);
+  gst_queue_locked_update_budget (queue);
   queue->min_threshold.buffers = queue->orig_min_threshold.buffers;
   queue->min_threshold.bytes = queue->orig_min_threshold.bytes;
   queue->min_threshold.time = queue->orig_min_threshold.time;
@@ -733,6 +966,42 @@ gst_queue_locked_flush (GstQueue * queue, gboolean full)
   GST_QUEUE_SIGNAL_DEL (queue);
 }
 
+static void
+gst_queue_locked_flush (GstQueue * queue, gboolean full)
+{
+  gst_queue_drop_items (queue, queue->queue, full);
+  gst_queue_locked_reset (queue);
+}
+
+/* Takes all items out of the queue in O(1) and resets it, so that a flush
+ * can release them without holding the lock. The returned array must be
+ * given back with gst_queue_locked_give_back_items(). */
+static GstQueueArray *
+gst_queue_locked_take_items (GstQueue * queue)
+{
+  GstQueueArray *items = queue->queue;
+
+  if (queue->spare_queue) {
+    queue->queue = queue->spare_queue;
+    queue->spare_queue = NULL;
+  } else {
+    queue->queue = gst_queue_array_new_for_struct (sizeof (GstQueueItem),
+        DEFAULT_MAX_SIZE_BUFFERS * 3 / 2);
+  }
+  gst_queue_locked_reset (queue);
+
+  return items;
+}
+
+static void
+gst_queue_locked_give_back_items (GstQueue * queue, GstQueueArray * items)
+{
+  if (queue->spare_queue == NULL)
+    queue->spare_queue = items;
+  else
+    gst_queue_array_free (items);
+}
+
 /* enqueue an item an update the level stats, with QUEUE_LOCK */
 static inline void
 gst_queue_locked_enqueue_buffer (GstQueue * queue, gpointer item)
@@ -750,6 +1019,9 @@ gst_queue_locked_enqueue_buffer (GstQueue * queue, gpointer item)
   qitem.is_query = FALSE;
   qitem.size = bsize;
   gst_queue_array_push_tail_struct (queue->queue, &qitem);
+  gst_queue_locked_update_budget (queue);
+  GST_SDT_PROBE5 (queue_enqueue, queue, item, queue->cur_level.buffers,
+      queue->cur_level.bytes, queue->cur_level.time);
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
@@ -771,6 +1043,9 @@ gst_queue_locked_enqueue_buffer_list (GstQueue * queue, gpointer item)
   qitem.is_query = FALSE;
   qitem.size = bsize;
   gst_queue_array_push_tail_struct (queue->queue, &qitem);
+  gst_queue_locked_update_budget (queue);
+  GST_SDT_PROBE5 (queue_enqueue, queue, item, queue->cur_level.buffers,
+      queue->cur_level.bytes, queue->cur_level.time);
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
@@ -815,6 +1090,8 @@ gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
   qitem.is_query = FALSE;
   qitem.size = 0;
   gst_queue_array_push_tail_struct (queue->queue, &qitem);
+  GST_SDT_PROBE5 (queue_enqueue, queue, item, queue->cur_level.buffers,
+      queue->cur_level.bytes, queue->cur_level.time);
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
@@ -895,6 +1172,9 @@ gst_queue_locked_dequeue (GstQueue * queue)
         item, GST_OBJECT_NAME (queue));
     item = NULL;
   }
+  gst_queue_locked_update_budget (queue);
+  GST_SDT_PROBE5 (queue_dequeue, queue, item, queue->cur_level.buffers,
+      queue->cur_level.bytes, queue->cur_level.time);
   GST_QUEUE_SIGNAL_DEL (queue);
 
   return item;
@@ -933,7 +1213,7 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       /* make sure it pauses, this should happen since we sent
        * flush_start downstream. */
-      gst_pad_pause_task (queue->srcpad);
+      gst_queue_pause_pushing (queue);
       GST_CAT_LOG_OBJECT (queue_dataflow, queue, "loop stopped");
 
       /* unblock query handler after the streaming thread is shut down.
@@ -945,17 +1225,28 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       GST_QUEUE_MUTEX_UNLOCK (queue);
       break;
     case GST_EVENT_FLUSH_STOP:
+    {
+      GstQueueArray *items;
+
       /* forward event */
       ret = gst_pad_push_event (queue->srcpad, event);
 
+      /* the queued data is released without the lock. Upstream is blocked
+       * on the stream lock we hold and our task only sees the new, empty
+       * array */
       GST_QUEUE_MUTEX_LOCK (queue);
-      gst_queue_locked_flush (queue, FALSE);
+      items = gst_queue_locked_take_items (queue);
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+
+      gst_queue_drop_items (queue, items, FALSE);
+
+      GST_QUEUE_MUTEX_LOCK (queue);
+      gst_queue_locked_give_back_items (queue, items);
       queue->srcresult = GST_FLOW_OK;
       queue->eos = FALSE;
       queue->unexpected = FALSE;
       if (gst_pad_is_active (queue->srcpad)) {
-        gst_pad_start_task (queue->srcpad, (GstTaskFunction) gst_queue_loop,
-            queue->srcpad, NULL);
+        gst_queue_start_pushing (queue);
       } else {
         GST_INFO_OBJECT (queue->srcpad, "not re-starting task on srcpad, "
             "pad not active any longer");
@@ -964,6 +1255,7 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 
       STATUS (queue, pad, "after flush");
       break;
+    }
     default:
       if (GST_EVENT_IS_SERIALIZED (event)) {
         /* serialized events go in the queue */
@@ -1007,8 +1299,7 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
                 queue->srcresult = GST_FLOW_OK;
                 queue->eos = FALSE;
                 queue->unexpected = FALSE;
-                gst_pad_start_task (queue->srcpad,
-                    (GstTaskFunction) gst_queue_loop, queue->srcpad, NULL);
+                gst_queue_start_pushing (queue);
               } else {
                 queue->eos = FALSE;
                 queue->unexpected = FALSE;
@@ -1073,7 +1364,7 @@ gst_queue_handle_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
         GST_QUEUE_SIGNAL_ADD (queue);
         while (queue->srcresult == GST_FLOW_OK &&
             queue->last_handled_query != query)
-          g_cond_wait (&queue->query_handled, &queue->qlock);
+          GST_QUEUE_COND_WAIT (queue, &queue->query_handled);
         queue->last_handled_query = NULL;
         if (queue->srcresult != GST_FLOW_OK)
           goto out_flushing;
@@ -1120,7 +1411,7 @@ gst_queue_is_empty (GstQueue * queue)
           queue->cur_level.bytes < queue->min_threshold.bytes) ||
       (queue->min_threshold.time > 0 &&
           queue->cur_level.time < queue->min_threshold.time)) &&
-      !gst_queue_is_filled (queue);
+      !gst_queue_is_filled (queue) && !gst_queue_budget_blocks (queue);
 }
 
 static gboolean
@@ -1134,6 +1425,134 @@ gst_queue_is_filled (GstQueue * queue)
               queue->cur_level.time >= queue->max_size.time)));
 }
 
+/* TRUE when the shared budget makes upstream wait. Only a queue that holds
+ * buffers waits, they are pushed out and released again. */
+static gboolean
+gst_queue_budget_blocks (GstQueue * queue)
+{
+  return queue->budget && queue->cur_level.buffers > 0
+      && gst_queue_budget_is_exhausted (queue->budget)
+      && gst_queue_budget_get_policy (queue->budget) ==
+      GST_QUEUE_BUDGET_POLICY_BLOCK;
+}
+
+/* the running time in the src segment of the first timestamped buffer in
+ * [@idx, @end), its index is stored in @found */
+static GstClockTimeDiff
+gst_queue_find_running_time (GstQueue * queue, guint idx, guint end,
+    guint * found)
+{
+  for (; idx < end; idx++) {
+    GstQueueItem *qitem = gst_queue_array_peek_nth_struct (queue->queue, idx);
+    GstClockTime timestamp;
+
+    if (!GST_IS_BUFFER (qitem->item))
+      continue;
+
+    timestamp = GST_BUFFER_DTS_OR_PTS (qitem->item);
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+      continue;
+
+    *found = idx;
+    return my_segment_to_running_time (&queue->src_segment, timestamp);
+  }
+
+  return GST_CLOCK_STIME_NONE;
+}
+
+/* when the time limit is exceeded, drops all the data that is older than the
+ * limit at once instead of item by item. The cut point is found with a
+ * binary search over the buffer timestamps, data without timestamps stays
+ * with the following buffer. Dropping stops at a SEGMENT event, the caller
+ * handles it and calls us again with the new segment. Returns TRUE when
+ * something was dropped. */
+static gboolean
+gst_queue_leak_downstream_time (GstQueue * queue)
+{
+  GstMiniObject *last = NULL;
+  GstClockTimeDiff threshold, rt;
+  guint lo, hi, mid, pos, dropped = 0;
+
+  if (queue->max_size.time == 0 || queue->cur_level.time < queue->max_size.time
+      || !GST_CLOCK_STIME_IS_VALID (queue->sinktime))
+    return FALSE;
+
+  /* buffers starting at or before this running time are too old */
+  threshold = queue->sinktime - (GstClockTimeDiff) queue->max_size.time;
+
+  lo = 0;
+  hi = gst_queue_array_get_length (queue->queue);
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    rt = gst_queue_find_running_time (queue, mid, hi, &pos);
+    if (!GST_CLOCK_STIME_IS_VALID (rt) || rt > threshold)
+      hi = mid;
+    else
+      lo = pos + 1;
+  }
+
+  while (dropped < lo) {
+    GstQueueItem *qitem = gst_queue_array_peek_head_struct (queue->queue);
+    GstMiniObject *item = qitem->item;
+
+    if (GST_IS_EVENT (item) && GST_EVENT_TYPE (item) == GST_EVENT_SEGMENT)
+      break;
+
+    if (GST_IS_BUFFER (item)) {
+      queue->cur_level.buffers--;
+    } else if (GST_IS_BUFFER_LIST (item)) {
+      queue->cur_level.buffers -=
+          gst_buffer_list_length (GST_BUFFER_LIST_CAST (item));
+    } else {
+      item = NULL;
+    }
+    queue->cur_level.bytes -= qitem->size;
+    gst_queue_array_pop_head_struct (queue->queue);
+    dropped++;
+
+    if (item) {
+      /* keep the last data to update the src position with */
+      if (last)
+        gst_mini_object_unref (last);
+      last = item;
+    } else {
+      if (GST_IS_EVENT (qitem->item) && GST_EVENT_IS_STICKY (qitem->item)) {
+        GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+            "Storing sticky event %s on srcpad",
+            GST_EVENT_TYPE_NAME (qitem->item));
+        gst_pad_store_sticky_event (queue->srcpad,
+            GST_EVENT_CAST (qitem->item));
+      }
+      if (!GST_IS_QUERY (qitem->item))
+        gst_mini_object_unref (qitem->item);
+    }
+  }
+
+  if (dropped == 0)
+    return FALSE;
+
+  GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+      "queue is full, leaked %u items on downstream end", dropped);
+
+  if (last) {
+    if (GST_IS_BUFFER (last))
+      apply_buffer (queue, GST_BUFFER_CAST (last), &queue->src_segment, FALSE);
+    else
+      apply_buffer_list (queue, GST_BUFFER_LIST_CAST (last),
+          &queue->src_segment, FALSE);
+    gst_mini_object_unref (last);
+  }
+  if (queue->cur_level.buffers == 0)
+    queue->cur_level.time = 0;
+  gst_queue_locked_update_budget (queue);
+  GST_QUEUE_SIGNAL_DEL (queue);
+
+  /* last buffer needs to get a DISCONT flag */
+  queue->head_needs_discont = TRUE;
+
+  return TRUE;
+}
+
 static void
 gst_queue_leak_downstream (GstQueue * queue)
 {
@@ -1141,6 +1560,9 @@ gst_queue_leak_downstream (GstQueue * queue)
   while (gst_queue_is_filled (queue)) {
     GstMiniObject *leak;
 
+    if (gst_queue_leak_downstream_time (queue))
+      continue;
+
     leak = gst_queue_locked_dequeue (queue);
     /* there is nothing to dequeue and the queue is still filled.. This should
      * not happen */
@@ -1211,6 +1633,25 @@ gst_queue_chain_buffer_or_list (GstPad * pad, GstObject * parent,
         gst_buffer_list_length (GST_BUFFER_LIST_CAST (obj)));
   }
 
+  /* stay within the memory budget shared with other queues */
+  if (queue->budget && gst_queue_budget_is_exhausted (queue->budget)) {
+    if (gst_queue_budget_get_policy (queue->budget) ==
+        GST_QUEUE_BUDGET_POLICY_LEAK) {
+      queue->tail_needs_discont = TRUE;
+      GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+          "budget exhausted, leaking buffer on upstream end");
+      goto out_unref;
+    }
+
+    while (gst_queue_budget_blocks (queue)) {
+      GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+          "budget exhausted, waiting for our data to be pushed");
+      /* the data might be below the min threshold, wake up the reader */
+      GST_QUEUE_SIGNAL_ADD (queue);
+      GST_QUEUE_WAIT_DEL_CHECK (queue, out_flushing);
+    }
+  }
+
   /* We make space available if we're "full" according to whatever
    * the user defined as "full". Note that this only applies to buffers.
    * We always handle events and they don't count in our statistics. */
@@ -1350,6 +1791,64 @@ gst_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       GST_MINI_OBJECT_CAST (buffer), FALSE);
 }
 
+/* take more buffers that directly follow @buffer out of the queue, within the
+ * configured batch limits, and return them together with @buffer as a buffer
+ * list. Returns @buffer if there was nothing to batch. Must be called with
+ * qlock held. */
+static GstMiniObject *
+gst_queue_locked_dequeue_batch (GstQueue * queue, GstBuffer * buffer)
+{
+  GstBufferList *buffer_list = NULL;
+  GstClockTime first_ts;
+  GstQueueItem *qitem;
+  guint64 bytes;
+
+  first_ts = GST_BUFFER_DTS_OR_PTS (buffer);
+  bytes = gst_buffer_get_size (buffer);
+
+  while ((qitem = gst_queue_array_peek_head_struct (queue->queue))) {
+    GstBuffer *next;
+    GstClockTime ts;
+
+    /* never batch across events, queries or buffer lists */
+    if (!GST_IS_BUFFER (qitem->item))
+      break;
+
+    next = GST_BUFFER_CAST (qitem->item);
+
+    if ((buffer_list ? gst_buffer_list_length (buffer_list) : 1) >=
+        queue->max_batch.buffers)
+      break;
+    if (queue->max_batch.bytes > 0
+        && bytes + qitem->size > queue->max_batch.bytes)
+      break;
+    ts = GST_BUFFER_DTS_OR_PTS (next);
+    if (queue->max_batch.time > 0 && GST_CLOCK_TIME_IS_VALID (first_ts)
+        && GST_CLOCK_TIME_IS_VALID (ts)
+        && ts > first_ts && ts - first_ts > queue->max_batch.time)
+      break;
+
+    if (buffer_list == NULL) {
+      buffer_list = gst_buffer_list_new_sized (MIN (queue->max_batch.buffers,
+              queue->cur_level.buffers + 1));
+      gst_buffer_list_add (buffer_list, buffer);
+    }
+
+    bytes += qitem->size;
+    gst_buffer_list_add (buffer_list,
+        GST_BUFFER_CAST (gst_queue_locked_dequeue (queue)));
+  }
+
+  if (buffer_list == NULL)
+    return GST_MINI_OBJECT_CAST (buffer);
+
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+      "batched %u buffers into buffer list %p",
+      gst_buffer_list_length (buffer_list), buffer_list);
+
+  return GST_MINI_OBJECT_CAST (buffer_list);
+}
+
 /* dequeue an item from the queue an push it downstream. This functions returns
  * the result of the push. */
 static GstFlowReturn
@@ -1363,6 +1862,9 @@ gst_queue_push_one (GstQueue * queue)
   if (data == NULL)
     goto no_item;
 
+  if (queue->max_batch.buffers > 1 && GST_IS_BUFFER (data))
+    data = gst_queue_locked_dequeue_batch (queue, GST_BUFFER_CAST (data));
+
 next:
   is_list = GST_IS_BUFFER_LIST (data);
 
@@ -1505,6 +2007,33 @@ out_flushing_query:
   }
 }
 
+/* stop pushing after srcresult was set to an error. Must be called with
+ * qlock held, releases it. */
+static void
+gst_queue_stop_pushing_locked (GstQueue * queue)
+{
+  gboolean eos = queue->eos;
+  GstFlowReturn ret = queue->srcresult;
+
+  gst_pad_pause_task (queue->srcpad);
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+      "pause task, reason:  %s", gst_flow_get_name (ret));
+  if (ret == GST_FLOW_FLUSHING) {
+    gst_queue_locked_flush (queue, FALSE);
+  } else {
+    GST_QUEUE_SIGNAL_DEL (queue);
+    queue->last_query = FALSE;
+    g_cond_signal (&queue->query_handled);
+  }
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+  /* let app know about us giving up if upstream is not expected to do so */
+  /* EOS is already taken care of elsewhere */
+  if (eos && (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)) {
+    GST_ELEMENT_FLOW_ERROR (queue, ret);
+    gst_pad_push_event (queue->srcpad, gst_event_new_eos ());
+  }
+}
+
 static void
 gst_queue_loop (GstPad * pad)
 {
@@ -1550,30 +2079,135 @@ gst_queue_loop (GstPad * pad)
   /* ERRORS */
 out_flushing:
   {
-    gboolean eos = queue->eos;
-    GstFlowReturn ret = queue->srcresult;
+    gst_queue_stop_pushing_locked (queue);
+    return;
+  }
+}
 
-    gst_pad_pause_task (queue->srcpad);
-    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
-        "pause task, reason:  %s", gst_flow_get_name (ret));
-    if (ret == GST_FLOW_FLUSHING) {
-      gst_queue_locked_flush (queue, FALSE);
-    } else {
-      GST_QUEUE_SIGNAL_DEL (queue);
-      queue->last_query = FALSE;
-      g_cond_signal (&queue->query_handled);
+/* push out up to POOL_PUSH_BUDGET items from a task pool thread. This is
+ * the equivalent of gst_queue_loop() when a task pool is used, it never
+ * waits for data but is scheduled again when data arrives. */
+static void
+gst_queue_pool_push_func (gpointer user_data)
+{
+  GstQueue *queue = user_data;
+  guint n_items = 0;
+  gboolean was_ok;
+
+  GST_PAD_STREAM_LOCK (queue->srcpad);
+  GST_QUEUE_MUTEX_LOCK (queue);
+
+  /* we might only run after pushing was stopped already */
+  was_ok = queue->srcresult == GST_FLOW_OK;
+
+  if (queue->push_idle && was_ok) {
+    queue->push_idle = FALSE;
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not empty");
+    if (!queue->silent) {
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_RUNNING], 0);
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_PUSHING], 0);
+      GST_QUEUE_MUTEX_LOCK (queue);
     }
+  }
+
+  while (queue->srcresult == GST_FLOW_OK && !gst_queue_is_empty (queue)
+      && n_items++ < POOL_PUSH_BUDGET)
+    queue->srcresult = gst_queue_push_one (queue);
+
+  queue->push_scheduled = FALSE;
+
+  if (queue->srcresult != GST_FLOW_OK) {
+    g_cond_broadcast (&queue->push_done);
+    if (was_ok)
+      gst_queue_stop_pushing_locked (queue);
+    else
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+  } else if (!gst_queue_is_empty (queue)) {
+    /* let the other work items of the pool run before we continue */
+    gst_queue_schedule_push (queue);
     GST_QUEUE_MUTEX_UNLOCK (queue);
-    /* let app know about us giving up if upstream is not expected to do so */
-    /* EOS is already taken care of elsewhere */
-    if (eos && (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)) {
-      GST_ELEMENT_FLOW_ERROR (queue, ret);
-      gst_pad_push_event (queue->srcpad, gst_event_new_eos ());
-    }
+  } else {
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is empty");
+    queue->push_idle = TRUE;
+    g_cond_broadcast (&queue->push_done);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    if (!queue->silent)
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_UNDERRUN], 0);
+  }
+
+  GST_PAD_STREAM_UNLOCK (queue->srcpad);
+
+  gst_object_unref (queue);
+}
+
+/* schedule a work item on the task pool if there is something to push and
+ * none is pending yet. Must be called with qlock held. */
+static void
+gst_queue_schedule_push (GstQueue * queue)
+{
+  GError *err = NULL;
+  gpointer id;
+
+  if (queue->push_scheduled || queue->srcresult != GST_FLOW_OK
+      || gst_queue_is_empty (queue))
+    return;
+
+  queue->push_scheduled = TRUE;
+  id = gst_task_pool_push (queue->push_pool, gst_queue_pool_push_func,
+      gst_object_ref (queue), &err);
+  if (G_UNLIKELY (err != NULL))
+    goto push_failed;
+
+  if (id)
+    gst_task_pool_dispose_handle (queue->push_pool, id);
+
+  return;
+
+  /* ERRORS */
+push_failed:
+  {
+    GST_ELEMENT_ERROR (queue, CORE, THREAD,
+        ("Failed to schedule streaming on the task pool."),
+        ("%s", err->message));
+    g_error_free (err);
+    gst_object_unref (queue);
+    queue->push_scheduled = FALSE;
+    queue->srcresult = GST_FLOW_ERROR;
+    GST_QUEUE_SIGNAL_DEL (queue);
+    g_cond_broadcast (&queue->push_done);
     return;
   }
 }
 
+/* start pushing data downstream, from the task pool if one is used or from
+ * the srcpad task otherwise. Must be called with qlock held. */
+static gboolean
+gst_queue_start_pushing (GstQueue * queue)
+{
+  if (queue->push_pool) {
+    gst_queue_schedule_push (queue);
+    return TRUE;
+  }
+
+  return gst_pad_start_task (queue->srcpad, (GstTaskFunction) gst_queue_loop,
+      queue->srcpad, NULL);
+}
+
+/* wait until data is no longer pushed downstream after srcresult was set to
+ * an error */
+static void
+gst_queue_pause_pushing (GstQueue * queue)
+{
+  if (queue->push_pool) {
+    /* the work item holds the stream lock while it is running */
+    GST_PAD_STREAM_LOCK (queue->srcpad);
+    GST_PAD_STREAM_UNLOCK (queue->srcpad);
+  } else {
+    gst_pad_pause_task (queue->srcpad);
+  }
+}
+
 static gboolean
 gst_queue_handle_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -1592,7 +2226,7 @@ gst_queue_handle_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         /* when we got not linked, assume downstream is linked again now and we
          * can try to start pushing again */
         queue->srcresult = GST_FLOW_OK;
-        gst_pad_start_task (pad, (GstTaskFunction) gst_queue_loop, pad, NULL);
+        gst_queue_start_pushing (queue);
       }
       GST_QUEUE_MUTEX_UNLOCK (queue);
 
@@ -1750,23 +2384,36 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
         queue->srcresult = GST_FLOW_OK;
         queue->eos = FALSE;
         queue->unexpected = FALSE;
-        result =
-            gst_pad_start_task (pad, (GstTaskFunction) gst_queue_loop, pad,
-            NULL);
+        if (queue->task_pool) {
+          queue->push_pool = gst_object_ref (queue->task_pool);
+          queue->push_idle = TRUE;
+        }
+        result = gst_queue_start_pushing (queue);
         GST_QUEUE_MUTEX_UNLOCK (queue);
       } else {
         /* step 1, unblock loop function */
         GST_QUEUE_MUTEX_LOCK (queue);
         queue->srcresult = GST_FLOW_FLUSHING;
         /* the item add signal will unblock */
+        g_atomic_int_inc (&queue->add_seqnum);
         g_cond_signal (&queue->item_add);
+        /* a work item on the task pool can still be pending */
+        while (queue->push_scheduled)
+          GST_QUEUE_COND_WAIT (queue, &queue->push_done);
         GST_QUEUE_MUTEX_UNLOCK (queue);
 
         /* step 2, make sure streaming finishes */
-        result = gst_pad_stop_task (pad);
+        if (queue->push_pool) {
+          GST_PAD_STREAM_LOCK (pad);
+          GST_PAD_STREAM_UNLOCK (pad);
+          result = TRUE;
+        } else {
+          result = gst_pad_stop_task (pad);
+        }
 
         GST_QUEUE_MUTEX_LOCK (queue);
         gst_queue_locked_flush (queue, FALSE);
+        gst_clear_object (&queue->push_pool);
         GST_QUEUE_MUTEX_UNLOCK (queue);
       }
       break;
@@ -1844,6 +2491,27 @@ gst_queue_set_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       queue->flush_on_eos = g_value_get_boolean (value);
       break;
+    case PROP_SPIN_TIME:
+      /* spinning only makes sense if the other side can run meanwhile */
+      if (g_get_num_processors () > 1)
+        queue->spin_time = g_value_get_uint64 (value);
+      break;
+    case PROP_MAX_BATCH_BUFFERS:
+      queue->max_batch.buffers = g_value_get_uint (value);
+      break;
+    case PROP_MAX_BATCH_BYTES:
+      queue->max_batch.bytes = g_value_get_uint (value);
+      break;
+    case PROP_MAX_BATCH_TIME:
+      queue->max_batch.time = g_value_get_uint64 (value);
+      break;
+    case PROP_TASK_POOL:
+      gst_object_replace ((GstObject **) & queue->task_pool,
+          g_value_get_object (value));
+      break;
+    case PROP_BUDGET:
+      gst_queue_locked_set_budget (queue, g_value_get_object (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1897,6 +2565,24 @@ gst_queue_get_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       g_value_set_boolean (value, queue->flush_on_eos);
       break;
+    case PROP_SPIN_TIME:
+      g_value_set_uint64 (value, queue->spin_time);
+      break;
+    case PROP_MAX_BATCH_BUFFERS:
+      g_value_set_uint (value, queue->max_batch.buffers);
+      break;
+    case PROP_MAX_BATCH_BYTES:
+      g_value_set_uint (value, queue->max_batch.bytes);
+      break;
+    case PROP_MAX_BATCH_TIME:
+      g_value_set_uint64 (value, queue->max_batch.time);
+      break;
+    case PROP_TASK_POOL:
+      g_value_set_object (value, queue->task_pool);
+      break;
+    case PROP_BUDGET:
+      g_value_set_object (value, queue->budget);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1904,3 +2590,20 @@ gst_queue_get_property (GObject * object,
 
   GST_QUEUE_MUTEX_UNLOCK (queue);
 }
+
+static void
+gst_queue_set_context (GstElement * element, GstContext * context)
+{
+  GstQueue *queue = GST_QUEUE (element);
+  GstQueueBudget *budget;
+
+  if (gst_context_get_queue_budget (context, &budget)) {
+    GST_DEBUG_OBJECT (queue, "using budget %" GST_PTR_FORMAT, budget);
+    GST_QUEUE_MUTEX_LOCK (queue);
+    gst_queue_locked_set_budget (queue, budget);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    gst_object_unref (budget);
+  }
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
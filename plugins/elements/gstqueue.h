@@ -26,6 +26,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstqueuearray.h>
+#include <gst/base/gstqueuebudget.h>
 
 G_BEGIN_DECLS
 
@@ -109,6 +110,8 @@ struct _GstQueue {
 
   /* the queue of data we're keeping our grubby hands on */
   GstQueueArray *queue;
+  /* empty array that replaces queue when flushing, with QUEUE_LOCK */
+  GstQueueArray *spare_queue;
 
   GstQueueSize
     cur_level,          /* currently in the queue */
@@ -125,6 +128,26 @@ struct _GstQueue {
   gboolean waiting_del;
   GCond item_del;      /* signals space now available for writing */
 
+  /* bumped for every ADD/DEL signal, so that a waiter can spin on them
+   * without holding qlock before going to sleep */
+  gint add_seqnum;
+  gint del_seqnum;
+  GstClockTime spin_time;
+
+  /* limits for the buffer lists pushed from the queued buffers */
+  GstQueueSize max_batch;
+
+  /* pushing from a task pool instead of the srcpad task */
+  GstTaskPool *task_pool;
+  GstTaskPool *push_pool;   /* pool in use while the srcpad is active */
+  gboolean push_scheduled;  /* a work item is pending or running */
+  gboolean push_idle;       /* the last work item emptied the queue */
+  GCond push_done;          /* signals that no work item is pending */
+
+  /* memory budget shared with other queues, with QUEUE_LOCK */
+  GstQueueBudget *budget;
+  guint64 budget_charged;   /* bytes of cur_level charged to budget */
+
   gboolean head_needs_discont, tail_needs_discont;
   gboolean push_newsegment;
 
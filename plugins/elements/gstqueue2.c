@@ -50,6 +50,12 @@
  * The temp-location property will be used to notify the application of the
  * allocated filename.
  *
+ * When #GstQueue2:ring-buffer-max-size is set, the pushed buffers point into
+ * the ring buffer and the ring buffer is only overwritten once they are
+ * released. To make sure upstream can always make progress, at most half of
+ * the ring buffer is used by buffers downstream, beyond that the data is
+ * copied.
+ *
  * If the #GstQueue2:use-buffering property is set to TRUE, and any writable
  * property is modified, #GstQueue2 will attempt to post a buffering message
  * if the changes to the properties also cause the buffering percentage to be
@@ -85,6 +91,15 @@
 #include <fcntl.h>
 #endif
 
+#if defined(HAVE_SYS_MMAN_H) && !defined(G_OS_WIN32)
+#include <sys/mman.h>
+#define HAVE_MMAP 1
+#endif
+
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -106,9 +121,20 @@ enum
 
 /* other defines */
 #define DEFAULT_BUFFER_SIZE 4096
+/* size of the pieces of the temp file we map, a multiple of the page size */
+#define TEMP_MMAP_CHUNK_SIZE (4 * 1024 * 1024)
+/* at most this part of the ring buffer is used by buffers downstream, after
+ * that we copy the data so that upstream can always make progress */
+#define MAX_PINNED_BYTES(queue) ((queue)->ring_buffer_max_size / 2)
 #define QUEUE_IS_USING_TEMP_FILE(queue) ((queue)->temp_template != NULL)
 #define QUEUE_IS_USING_RING_BUFFER(queue) ((queue)->ring_buffer_max_size != 0)  /* for consistency with the above macro */
 #define QUEUE_IS_USING_QUEUE(queue) (!QUEUE_IS_USING_TEMP_FILE(queue) && !QUEUE_IS_USING_RING_BUFFER (queue))
+#ifdef HAVE_MMAP
+/* data in a ring buffer file gets overwritten, so we only map growing files */
+#define QUEUE_IS_USING_TEMP_MMAP(queue) ((queue)->temp_mmap && QUEUE_IS_USING_TEMP_FILE (queue) && !QUEUE_IS_USING_RING_BUFFER (queue))
+#else
+#define QUEUE_IS_USING_TEMP_MMAP(queue) FALSE
+#endif
 
 #define QUEUE_MAX_BYTES(queue) MIN((queue)->max_level.bytes, (queue)->ring_buffer_max_size)
 
@@ -124,8 +150,16 @@ enum
 #define DEFAULT_LOW_WATERMARK      0.01
 #define DEFAULT_HIGH_WATERMARK     0.99
 #define DEFAULT_TEMP_REMOVE        TRUE
+#define DEFAULT_TEMP_MMAP          FALSE
 #define DEFAULT_RING_BUFFER_MAX_SIZE 0
 #define DEFAULT_USE_BITRATE_QUERY  TRUE
+#define DEFAULT_RATE_ESTIMATOR     GST_RATE_ESTIMATOR_AVERAGE
+#define DEFAULT_RATE_WINDOW        (2 * GST_SECOND)
+#define DEFAULT_PREFETCH_BYTES     0
+
+/* bounds of the seek threshold */
+#define MIN_SEEK_THRESHOLD         (512 * 1024)
+#define MAX_SEEK_THRESHOLD         (16 * 1024 * 1024)
 
 enum
 {
@@ -146,10 +180,15 @@ enum
   PROP_TEMP_TEMPLATE,
   PROP_TEMP_LOCATION,
   PROP_TEMP_REMOVE,
+  PROP_TEMP_MMAP,
   PROP_RING_BUFFER_MAX_SIZE,
   PROP_AVG_IN_RATE,
   PROP_USE_BITRATE_QUERY,
   PROP_BITRATE,
+  PROP_RATE_ESTIMATOR,
+  PROP_RATE_WINDOW,
+  PROP_PREFETCH_BYTES,
+  PROP_BUDGET,
   PROP_LAST
 };
 static GParamSpec *obj_props[PROP_LAST] = { NULL, };
@@ -274,6 +313,7 @@ G_DEFINE_TYPE_WITH_CODE (GstQueue2, gst_queue2, GST_TYPE_ELEMENT, _do_init);
 GST_ELEMENT_REGISTER_DEFINE (queue2, "queue2", GST_RANK_NONE, GST_TYPE_QUEUE2);
 
 static void gst_queue2_finalize (GObject * object);
+static void gst_queue2_free_ring_buffer (GstQueue2 * queue);
 
 static void gst_queue2_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -311,6 +351,10 @@ static GstStateChangeReturn gst_queue2_change_state (GstElement * element,
 
 static gboolean gst_queue2_is_empty (GstQueue2 * queue);
 static gboolean gst_queue2_is_filled (GstQueue2 * queue);
+static gboolean gst_queue2_budget_blocks (GstQueue2 * queue);
+
+static void gst_queue2_set_context (GstElement * element,
+    GstContext * context);
 
 static void update_cur_level (GstQueue2 * queue, GstQueue2Range * range);
 static void update_in_rates (GstQueue2 * queue, gboolean force);
@@ -434,6 +478,22 @@ gst_queue2_class_init (GstQueue2Class * klass)
       "Remove the Temporary File", "Remove the temp-location after use",
       DEFAULT_TEMP_REMOVE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstQueue2:temp-mmap
+   *
+   * When temp-template is set and the ring buffer is disabled, push buffers
+   * that point into a mapping of the temporary file instead of reading the
+   * data into newly allocated buffers. Falls back to reading when the file
+   * can't be mapped.
+   *
+   * Since: 1.20
+   */
+  obj_props[PROP_TEMP_MMAP] = g_param_spec_boolean ("temp-mmap",
+      "Map the Temporary File",
+      "Push buffers mapping the temp-location instead of copying the data",
+      DEFAULT_TEMP_MMAP,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS);
+
   /**
    * GstQueue2:ring-buffer-max-size
    *
@@ -467,8 +527,75 @@ gst_queue2_class_init (GstQueue2Class * klass)
       "Conversion value between data size and time",
       0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
 
+  /**
+   * GstQueue2:rate-estimator
+   *
+   * How to estimate the input data rate that is used for the rate estimate
+   * of the level, the #GstQueue2:avg-in-rate and the buffering statistics.
+   *
+   * Since: 1.20
+   */
+  obj_props[PROP_RATE_ESTIMATOR] = g_param_spec_enum ("rate-estimator",
+      "Rate estimator", "How to estimate the input data rate",
+      GST_TYPE_RATE_ESTIMATOR_MODE, DEFAULT_RATE_ESTIMATOR,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstQueue2:rate-window
+   *
+   * The half-life of the `ewma` and the length of the window of the
+   * `percentile` #GstQueue2:rate-estimator.
+   *
+   * Since: 1.20
+   */
+  obj_props[PROP_RATE_WINDOW] = g_param_spec_uint64 ("rate-window",
+      "Rate window (ns)",
+      "Half-life or window length of the input rate estimator",
+      0, G_MAXUINT64, DEFAULT_RATE_WINDOW,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstQueue2:prefetch-bytes
+   *
+   * When downloading to a temp file and a read far away from the downloaded
+   * data makes the queue seek, the download that was in progress is
+   * remembered. After this many bytes were downloaded at the new position,
+   * and as long as the reader is not close to catching up with them, the
+   * interrupted download is resumed. This matches demuxers that read an
+   * index before returning to the data they were reading. 0 disables
+   * resuming.
+   *
+   * Since: 1.20
+   */
+  obj_props[PROP_PREFETCH_BYTES] = g_param_spec_uint64 ("prefetch-bytes",
+      "Prefetch bytes",
+      "Bytes to download after a seek before resuming the interrupted "
+      "download (0 = disable)", 0, G_MAXUINT64, DEFAULT_PREFETCH_BYTES,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GstQueue2:budget
+   *
+   * A #GstQueueBudget shared with other queues. The bytes held in memory are
+   * charged to it, data downloaded to a temp file or a ring buffer is not.
+   * While the budget is exhausted, the queue drops new buffers or makes
+   * upstream wait until its data was pushed, depending on the
+   * #GstQueueBudget:policy, and reports itself as fully buffered.
+   *
+   * The budget can also be set with a #GstContext of type
+   * #GST_QUEUE_BUDGET_CONTEXT_TYPE, the last one set is used.
+   *
+   * Since: 1.20
+   */
+  obj_props[PROP_BUDGET] = g_param_spec_object ("budget", "Budget",
+      "Memory budget shared with other queues (NULL = no shared budget)",
+      GST_TYPE_QUEUE_BUDGET,
+      G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (gobject_class, PROP_LAST, obj_props);
 
+  gst_type_mark_as_plugin_api (GST_TYPE_RATE_ESTIMATOR_MODE, 0);
+
   /* set several parent class virtual functions */
   gobject_class->finalize = gst_queue2_finalize;
 
@@ -483,6 +610,7 @@ gst_queue2_class_init (GstQueue2Class * klass)
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_queue2_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_queue2_handle_query);
+  gstelement_class->set_context = GST_DEBUG_FUNCPTR (gst_queue2_set_context);
 }
 
 static void
@@ -539,7 +667,13 @@ gst_queue2_init (GstQueue2 * queue)
   queue->sinkresult = GST_FLOW_FLUSHING;
   queue->is_eos = FALSE;
   queue->in_timer = g_timer_new ();
+  gst_rate_estimator_init (&queue->in_estimator, DEFAULT_RATE_ESTIMATOR,
+      DEFAULT_RATE_WINDOW);
   queue->out_timer = g_timer_new ();
+  queue->seek_time = GST_CLOCK_TIME_NONE;
+  queue->seek_latency = GST_CLOCK_TIME_NONE;
+  queue->prefetch_bytes = DEFAULT_PREFETCH_BYTES;
+  queue->prefetch_pos = -1;
 
   g_mutex_init (&queue->qlock);
   queue->waiting_add = FALSE;
@@ -559,8 +693,13 @@ gst_queue2_init (GstQueue2 * queue)
   queue->temp_template = NULL;
   queue->temp_location = NULL;
   queue->temp_remove = DEFAULT_TEMP_REMOVE;
+  queue->temp_mmap = DEFAULT_TEMP_MMAP;
+  queue->mapping = NULL;
 
   queue->ring_buffer = NULL;
+  queue->arena = NULL;
+  g_queue_init (&queue->pins);
+  queue->pinned_bytes = 0;
   queue->ring_buffer_max_size = DEFAULT_RING_BUFFER_MAX_SIZE;
 
   queue->use_bitrate_query = DEFAULT_USE_BITRATE_QUERY;
@@ -593,10 +732,17 @@ gst_queue2_finalize (GObject * object)
   g_timer_destroy (queue->in_timer);
   g_timer_destroy (queue->out_timer);
 
+  gst_queue2_free_ring_buffer (queue);
+
   /* temp_file path cleanup  */
   g_free (queue->temp_template);
   g_free (queue->temp_location);
 
+  if (queue->budget) {
+    gst_queue_budget_release (queue->budget, queue->budget_charged);
+    gst_object_unref (queue->budget);
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -735,6 +881,9 @@ init_ranges (GstQueue2 * queue)
   clean_ranges (queue);
   /* make a range for offset 0 */
   queue->current = add_range (queue, 0, TRUE);
+  queue->seek_time = GST_CLOCK_TIME_NONE;
+  queue->prefetch_pos = -1;
+  queue->seek_bytes = 0;
 }
 
 /* calculate the diff between running time on the sink and src of the queue.
@@ -1029,6 +1178,10 @@ get_buffering_level (GstQueue2 * queue, gboolean * is_buffering,
      * here so that we can reuse the logic below to stop buffering */
     buflevel = MAX_BUFFERING_LEVEL;
     GST_LOG_OBJECT (queue, "we are %s", queue->is_eos ? "EOS" : "NOT_LINKED");
+  } else if (gst_queue2_budget_blocks (queue)) {
+    /* we can't get more data, waiting for it would stall the pipeline */
+    buflevel = MAX_BUFFERING_LEVEL;
+    GST_LOG_OBJECT (queue, "the shared budget is exhausted");
   } else {
     GST_LOG_OBJECT (queue,
         "Cur level bytes/time/rate-time/buffers %u/%" GST_TIME_FORMAT "/%"
@@ -1113,13 +1266,16 @@ get_buffering_stats (GstQueue2 * queue, gint percent, GstBufferingMode * mode,
     *buffering_left = (percent == 100 ? 0 : -1);
 
     if (queue->use_rate_estimate) {
-      guint64 max, cur;
+      guint64 target, cur;
 
-      max = queue->max_level.rate_time;
+      /* the time until the level reaches the high watermark at the
+       * estimated input rate */
+      target = gst_util_uint64_scale (queue->max_level.rate_time,
+          queue->high_watermark, MAX_BUFFERING_LEVEL);
       cur = queue->cur_level.rate_time;
 
-      if (percent != 100 && max > cur)
-        *buffering_left = (max - cur) / 1000000;
+      if (percent != 100 && target > cur)
+        *buffering_left = (target - cur) / GST_MSECOND;
     }
   }
 }
@@ -1224,7 +1380,7 @@ reset_rate_timer (GstQueue2 * queue)
   queue->bytes_in = 0;
   queue->bytes_out = 0;
   queue->byte_in_rate = 0.0;
-  queue->byte_in_period = 0;
+  gst_rate_estimator_reset (&queue->in_estimator);
   queue->byte_out_rate = 0.0;
   queue->last_update_in_rates_elapsed = 0.0;
   queue->last_in_elapsed = 0.0;
@@ -1235,21 +1391,17 @@ reset_rate_timer (GstQueue2 * queue)
 
 /* the interval in seconds to recalculate the rate */
 #define RATE_INTERVAL    0.2
-/* Tuning for rate estimation. We use a large window for the input rate because
- * it should be stable when connected to a network. The output rate is less
- * stable (the elements preroll, queues behind a demuxer fill, ...) and should
- * therefore adapt more quickly.
- * However, initial input rate may be subject to a burst, and should therefore
- * initially also adapt more quickly to changes, and only later on give higher
- * weight to previous values. */
-#define AVG_IN(avg,val,w1,w2)  ((avg) * (w1) + (val) * (w2)) / ((w1) + (w2))
+/* Tuning for rate estimation. The input rate is estimated with the configured
+ * #GstRateEstimatorMode, by default with a large window because it should be
+ * stable when connected to a network. The output rate is less stable (the
+ * elements preroll, queues behind a demuxer fill, ...) and should therefore
+ * adapt more quickly. */
 #define AVG_OUT(avg,val) ((avg) * 3.0 + (val)) / 4.0
 
 static void
 update_in_rates (GstQueue2 * queue, gboolean force)
 {
   gdouble elapsed, period;
-  gdouble byte_in_rate;
 
   if (!queue->in_timer_started) {
     queue->in_timer_started = TRUE;
@@ -1265,20 +1417,10 @@ update_in_rates (GstQueue2 * queue, gboolean force)
     period = elapsed - queue->last_in_elapsed;
 
     GST_DEBUG_OBJECT (queue,
-        "rates: period %f, in %" G_GUINT64_FORMAT ", global period %f",
-        period, queue->bytes_in, queue->byte_in_period);
-
-    byte_in_rate = queue->bytes_in / period;
+        "rates: period %f, in %" G_GUINT64_FORMAT, period, queue->bytes_in);
 
-    if (queue->byte_in_rate == 0.0)
-      queue->byte_in_rate = byte_in_rate;
-    else
-      queue->byte_in_rate = AVG_IN (queue->byte_in_rate, byte_in_rate,
-          (double) queue->byte_in_period, period);
-
-    /* another data point, cap at 16 for long time running average */
-    if (queue->byte_in_period < 16 * RATE_INTERVAL)
-      queue->byte_in_period += period;
+    queue->byte_in_rate = gst_rate_estimator_update (&queue->in_estimator,
+        queue->bytes_in, period);
 
     /* reset the values to calculate rate over the next interval */
     queue->last_in_elapsed = elapsed;
@@ -1367,6 +1509,8 @@ perform_seek_to_offset (GstQueue2 * queue, guint64 offset)
 
   /* until we receive the FLUSH_STOP from this seek, we skip data */
   queue->seeking = TRUE;
+  queue->seek_time = gst_util_get_timestamp ();
+  queue->seek_bytes = 0;
   GST_QUEUE2_MUTEX_UNLOCK (queue);
 
   debug_ranges (queue);
@@ -1399,10 +1543,17 @@ perform_seek_to_offset (GstQueue2 * queue, guint64 offset)
 static guint64
 get_seek_threshold (GstQueue2 * queue)
 {
-  guint64 threshold;
+  guint64 threshold = MIN_SEEK_THRESHOLD;
 
-  /* FIXME, find a good threshold based on the incoming rate. */
-  threshold = 1024 * 512;
+  /* rereading is cheaper than seeking for as much data as arrives while
+   * waiting for the first byte after a seek */
+  if (queue->byte_in_rate > 0.0
+      && GST_CLOCK_TIME_IS_VALID (queue->seek_latency)) {
+    gdouble bytes;
+
+    bytes = queue->byte_in_rate * queue->seek_latency / GST_SECOND;
+    threshold = CLAMP (bytes, MIN_SEEK_THRESHOLD, MAX_SEEK_THRESHOLD);
+  }
 
   if (QUEUE_IS_USING_RING_BUFFER (queue)) {
     threshold = MIN (threshold,
@@ -1459,13 +1610,63 @@ gst_queue2_have_data (GstQueue2 * queue, guint64 offset, guint length)
       }
     }
 
-    /* too far away, do a seek */
+    /* too far away, remember the download we interrupt, it is likely that
+     * the reader comes back to it */
+    if (queue->prefetch_bytes > 0 && queue->current && !queue->seeking &&
+        !QUEUE_IS_USING_RING_BUFFER (queue))
+      queue->prefetch_pos = queue->current->writing_pos;
+
+    /* and do a seek */
     perform_seek_to_offset (queue, offset);
   }
 
   return FALSE;
 }
 
+/* check if enough was downloaded since the last seek to resume the
+ * interrupted download */
+static gboolean
+prefetch_is_due (GstQueue2 * queue)
+{
+  GstQueue2Range *current = queue->current;
+
+  if (queue->prefetch_pos == -1 || queue->prefetch_bytes == 0)
+    return FALSE;
+
+  if (queue->seek_bytes < queue->prefetch_bytes)
+    return FALSE;
+
+  /* the reader is still consuming this range and would catch up */
+  if (current->max_reading_pos <= current->writing_pos &&
+      current->writing_pos - current->max_reading_pos < queue->prefetch_bytes)
+    return FALSE;
+
+  return TRUE;
+}
+
+/* resume the interrupted download, continuing the range that was filled
+ * there in the meantime */
+static void
+seek_to_prefetch (GstQueue2 * queue)
+{
+  GstQueue2Range *range;
+  guint64 offset = queue->prefetch_pos;
+
+  queue->prefetch_pos = -1;
+
+  if ((range = find_range (queue, offset))) {
+    if (range == queue->current)
+      return;
+    offset = range->writing_pos;
+  }
+
+  if (queue->upstream_size && offset >= queue->upstream_size)
+    return;
+
+  GST_DEBUG_OBJECT (queue, "resuming download at %" G_GUINT64_FORMAT, offset);
+  perform_seek_to_offset (queue, offset);
+}
+
 #ifdef HAVE_FSEEKO
 #define FSEEK_FILE(file,offset)  (fseeko (file, (off_t) offset, SEEK_SET) != 0)
 #elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
@@ -1529,6 +1730,404 @@ eos:
   }
 }
 
+#ifdef HAVE_MMAP
+struct _GstQueue2Mapping
+{
+  gint refcount;
+  gpointer data;
+  gsize size;
+  guint64 offset;               /* offset of the mapping in the file */
+};
+
+static GstQueue2Mapping *
+gst_queue2_mapping_ref (GstQueue2Mapping * mapping)
+{
+  g_atomic_int_inc (&mapping->refcount);
+  return mapping;
+}
+
+static void
+gst_queue2_mapping_unref (GstQueue2Mapping * mapping)
+{
+  if (g_atomic_int_dec_and_test (&mapping->refcount)) {
+    munmap (mapping->data, mapping->size);
+    g_slice_free (GstQueue2Mapping, mapping);
+  }
+}
+#endif
+
+static void
+gst_queue2_clear_mapping (GstQueue2 * queue)
+{
+#ifdef HAVE_MMAP
+  if (queue->mapping) {
+    gst_queue2_mapping_unref (queue->mapping);
+    queue->mapping = NULL;
+  }
+#endif
+}
+
+#ifdef HAVE_MMAP
+/* make sure we have a mapping of the temp file covering @offset */
+static gboolean
+gst_queue2_update_mapping (GstQueue2 * queue, guint64 offset)
+{
+  GstQueue2Mapping *mapping, *old;
+  guint64 start;
+  gpointer data;
+
+  old = queue->mapping;
+  if (old && offset >= old->offset && offset < old->offset + old->size)
+    return TRUE;
+
+  /* map the chunk around @offset. The part of the chunk after the end of the
+   * file can't be accessed yet but will become valid as the file grows */
+  start = offset - offset % TEMP_MMAP_CHUNK_SIZE;
+  data = mmap (NULL, TEMP_MMAP_CHUNK_SIZE, PROT_READ, MAP_SHARED,
+      fileno (queue->temp_file), (off_t) start);
+  if (data == MAP_FAILED) {
+    GST_WARNING_OBJECT (queue, "mmap failed: %s", g_strerror (errno));
+    return FALSE;
+  }
+#ifdef MADV_SEQUENTIAL
+  madvise (data, TEMP_MMAP_CHUNK_SIZE, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+  madvise (data, TEMP_MMAP_CHUNK_SIZE, MADV_WILLNEED);
+#endif
+
+#ifdef HAVE_POSIX_FADVISE
+  /* when playing on, the pages we read so far are not needed anymore until
+   * the next seek back. Buffers still pointing to them are unaffected,
+   * the pages are simply read again from the file. */
+  if (old && start > old->offset)
+    posix_fadvise (fileno (queue->temp_file), old->offset, old->size,
+        POSIX_FADV_DONTNEED);
+#endif
+
+  mapping = g_slice_new (GstQueue2Mapping);
+  mapping->refcount = 1;
+  mapping->data = data;
+  mapping->size = TEMP_MMAP_CHUNK_SIZE;
+  mapping->offset = start;
+
+  /* buffers pointing into the old mapping keep it alive */
+  gst_queue2_clear_mapping (queue);
+  queue->mapping = mapping;
+
+  GST_DEBUG_OBJECT (queue, "mapped %d bytes at offset %" G_GUINT64_FORMAT,
+      TEMP_MMAP_CHUNK_SIZE, start);
+
+  return TRUE;
+}
+
+/* must be called with MUTEX_LOCK. Wraps the available data in memory
+ * pointing into mappings of the temp file. */
+static GstFlowReturn
+gst_queue2_create_read_mapped (GstQueue2 * queue, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  GstQueue2Range *range;
+  GstBuffer *buf;
+  GstMemory *mem;
+  guint64 pos, end;
+  gsize mem_offset, mem_size;
+
+  while (!gst_queue2_have_data (queue, offset, length)) {
+    if (queue->use_buffering)
+      update_buffering (queue);
+
+    GST_DEBUG_OBJECT (queue, "waiting for add");
+    GST_QUEUE2_WAIT_ADD_CHECK (queue, queue->srcresult, out_flushing);
+  }
+
+  /* at EOS the range can end before the requested data */
+  end = offset + length;
+  if ((range = find_range (queue, offset)))
+    end = MIN (end, range->writing_pos);
+  if (end <= offset)
+    goto hit_eos;
+
+  /* the data might still be in the stdio buffer */
+  if (fflush (queue->temp_file) != 0)
+    goto could_not_read;
+
+  GST_LOG_OBJECT (queue, "Wrapping %" G_GUINT64_FORMAT " bytes at offset %"
+      G_GUINT64_FORMAT, end - offset, offset);
+
+  buf = gst_buffer_new ();
+  for (pos = offset; pos < end; pos += mem_size) {
+    if (!gst_queue2_update_mapping (queue, pos))
+      goto map_failed;
+
+    mem_offset = pos - queue->mapping->offset;
+    mem_size = MIN (end - pos, queue->mapping->size - mem_offset);
+
+    mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        queue->mapping->data, queue->mapping->size, mem_offset, mem_size,
+        gst_queue2_mapping_ref (queue->mapping),
+        (GDestroyNotify) gst_queue2_mapping_unref);
+    gst_buffer_append_memory (buf, mem);
+  }
+
+  queue->current->reading_pos = end;
+  update_cur_pos (queue, queue->current, end);
+  GST_QUEUE2_SIGNAL_DEL (queue);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = end;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+hit_eos:
+  {
+    GST_DEBUG_OBJECT (queue, "EOS hit and we don't have any requested data");
+    return GST_FLOW_EOS;
+  }
+out_flushing:
+  {
+    GST_DEBUG_OBJECT (queue, "we are flushing");
+    return GST_FLOW_FLUSHING;
+  }
+could_not_read:
+  {
+    GST_ELEMENT_ERROR (queue, RESOURCE, READ, (NULL), GST_ERROR_SYSTEM);
+    return GST_FLOW_ERROR;
+  }
+map_failed:
+  {
+    GST_ELEMENT_WARNING (queue, RESOURCE, READ, (NULL),
+        ("Could not map temp file, reading it instead"));
+    gst_buffer_unref (buf);
+    queue->temp_mmap = FALSE;
+    return GST_FLOW_NOT_SUPPORTED;
+  }
+}
+#endif
+
+/* The memory of the ring buffer. It is refcounted because buffers pushed
+ * downstream point into it and can outlive the queue's use of it. */
+struct _GstQueue2Arena
+{
+  gint refcount;
+  guint8 *data;
+  gsize size;
+  gboolean mapped;              /* allocated with mmap */
+
+  GMutex lock;                  /* protects queue */
+  GstQueue2 *queue;             /* NULL once the queue stopped using it */
+};
+
+/* A part of the ring buffer used by a buffer downstream that must not be
+ * overwritten until the buffer is freed */
+typedef struct
+{
+  GstQueue2Arena *arena;
+  guint64 offset;
+  guint size;
+  gboolean detached;            /* already removed from the queue */
+} GstQueue2Pin;
+
+static GstQueue2Arena *
+gst_queue2_arena_new (GstQueue2 * queue, gsize size)
+{
+  GstQueue2Arena *arena;
+  guint8 *data = NULL;
+  gboolean mapped = FALSE;
+
+#ifdef HAVE_MMAP
+  {
+    gint flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+#ifdef MAP_POPULATE
+    /* fault in all the pages now instead of while streaming */
+    flags |= MAP_POPULATE;
+#endif
+    data = mmap (NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (data == MAP_FAILED) {
+      GST_DEBUG_OBJECT (queue, "mmap failed: %s", g_strerror (errno));
+      data = NULL;
+    } else {
+      mapped = TRUE;
+#ifdef MADV_HUGEPAGE
+      /* large ring buffers are walked linearly, fewer TLB misses help */
+      madvise (data, size, MADV_HUGEPAGE);
+#endif
+    }
+  }
+#endif
+
+  if (data == NULL)
+    data = g_try_malloc (size);
+  if (data == NULL)
+    return NULL;
+
+  arena = g_slice_new (GstQueue2Arena);
+  arena->refcount = 1;
+  arena->data = data;
+  arena->size = size;
+  arena->mapped = mapped;
+  g_mutex_init (&arena->lock);
+  arena->queue = queue;
+
+  GST_DEBUG_OBJECT (queue, "allocated ring buffer of %" G_GSIZE_FORMAT
+      " bytes%s", size, mapped ? " with mmap" : "");
+
+  return arena;
+}
+
+static GstQueue2Arena *
+gst_queue2_arena_ref (GstQueue2Arena * arena)
+{
+  g_atomic_int_inc (&arena->refcount);
+  return arena;
+}
+
+static void
+gst_queue2_arena_unref (GstQueue2Arena * arena)
+{
+  if (g_atomic_int_dec_and_test (&arena->refcount)) {
+#ifdef HAVE_MMAP
+    if (arena->mapped)
+      munmap (arena->data, arena->size);
+    else
+#endif
+      g_free (arena->data);
+    g_mutex_clear (&arena->lock);
+    g_slice_free (GstQueue2Arena, arena);
+  }
+}
+
+/* must be called with MUTEX_LOCK */
+static gboolean
+gst_queue2_alloc_ring_buffer (GstQueue2 * queue)
+{
+  gst_queue2_free_ring_buffer (queue);
+
+  queue->arena = gst_queue2_arena_new (queue, queue->ring_buffer_max_size);
+  if (queue->arena == NULL)
+    return FALSE;
+
+  queue->ring_buffer = queue->arena->data;
+
+  return TRUE;
+}
+
+/* must be called with MUTEX_LOCK */
+static void
+gst_queue2_free_ring_buffer (GstQueue2 * queue)
+{
+  GstQueue2Arena *arena = queue->arena;
+
+  if (arena == NULL)
+    return;
+
+  /* buffers downstream keep the memory alive but don't notify us anymore */
+  g_mutex_lock (&arena->lock);
+  arena->queue = NULL;
+  g_mutex_unlock (&arena->lock);
+
+  g_queue_clear (&queue->pins);
+  queue->pinned_bytes = 0;
+
+  gst_queue2_arena_unref (arena);
+  queue->arena = NULL;
+  queue->ring_buffer = NULL;
+}
+
+static void
+gst_queue2_pin_free (GstQueue2Pin * pin)
+{
+  GstQueue2Arena *arena = pin->arena;
+  GstQueue2 *queue = NULL;
+
+  if (!pin->detached) {
+    g_mutex_lock (&arena->lock);
+    queue = arena->queue ? gst_object_ref (arena->queue) : NULL;
+    g_mutex_unlock (&arena->lock);
+  }
+
+  if (queue) {
+    GST_QUEUE2_MUTEX_LOCK (queue);
+    if (queue->arena == arena && g_queue_remove (&queue->pins, pin)) {
+      queue->pinned_bytes -= pin->size;
+      GST_LOG_OBJECT (queue, "released %u bytes at %" G_GUINT64_FORMAT,
+          pin->size, pin->offset);
+      /* the writer might be waiting for this part of the ring buffer */
+      GST_QUEUE2_SIGNAL_DEL (queue);
+    }
+    GST_QUEUE2_MUTEX_UNLOCK (queue);
+    gst_object_unref (queue);
+  }
+
+  gst_queue2_arena_unref (arena);
+  g_slice_free (GstQueue2Pin, pin);
+}
+
+/* must be called with MUTEX_LOCK. Wraps @size bytes at @offset of the ring
+ * buffer in memory that keeps the data from being overwritten. */
+static GstMemory *
+gst_queue2_wrap_ring_buffer (GstQueue2 * queue, guint64 offset, guint size)
+{
+  GstQueue2Pin *pin;
+
+  pin = g_slice_new (GstQueue2Pin);
+  pin->arena = gst_queue2_arena_ref (queue->arena);
+  pin->offset = offset;
+  pin->size = size;
+  pin->detached = FALSE;
+
+  g_queue_push_tail (&queue->pins, pin);
+  queue->pinned_bytes += size;
+
+  return gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      queue->arena->data, queue->arena->size, offset, size, pin,
+      (GDestroyNotify) gst_queue2_pin_free);
+}
+
+/* must be called with MUTEX_LOCK. Forgets the pins after the first @n_pins,
+ * so that the buffers holding them can be freed with the lock held. */
+static void
+gst_queue2_detach_pins (GstQueue2 * queue, guint n_pins)
+{
+  GstQueue2Pin *pin;
+
+  while (queue->pins.length > n_pins) {
+    pin = g_queue_pop_tail (&queue->pins);
+    queue->pinned_bytes -= pin->size;
+    pin->detached = TRUE;
+  }
+}
+
+/* must be called with MUTEX_LOCK. Returns how many of @size bytes can be
+ * written at @offset of the ring buffer without overwriting data that is
+ * still used downstream. */
+static guint
+gst_queue2_get_unpinned_space (GstQueue2 * queue, guint64 offset, guint size)
+{
+  guint64 rb_size = queue->ring_buffer_max_size;
+  GList *walk;
+
+  for (walk = queue->pins.head; walk && size > 0; walk = walk->next) {
+    GstQueue2Pin *pin = walk->data;
+    guint64 distance;
+
+    /* are we inside the pinned area */
+    if ((offset + rb_size - pin->offset) % rb_size < pin->size)
+      return 0;
+
+    /* or does the pinned area start before we are done */
+    distance = (pin->offset + rb_size - offset) % rb_size;
+    if (distance < size)
+      size = distance;
+  }
+
+  return size;
+}
+
 static GstFlowReturn
 gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     GstBuffer ** buffer)
@@ -1541,17 +2140,41 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
   guint64 rb_size;
   guint64 max_size;
   guint64 rpos;
+  gboolean wrap;
+  guint n_pins;
   GstFlowReturn ret = GST_FLOW_OK;
 
-  /* allocate the output buffer of the requested size */
-  if (*buffer == NULL)
-    buf = gst_buffer_new_allocate (NULL, length, NULL);
-  else
-    buf = *buffer;
+#ifdef HAVE_MMAP
+  /* we can't fill buffers from downstream without copying */
+  if (QUEUE_IS_USING_TEMP_MMAP (queue) && *buffer == NULL) {
+    ret = gst_queue2_create_read_mapped (queue, offset, length, buffer);
+    if (ret != GST_FLOW_NOT_SUPPORTED)
+      return ret;
+    ret = GST_FLOW_OK;
+  }
+#endif
 
-  if (!gst_buffer_map (buf, &info, GST_MAP_WRITE))
-    goto buffer_write_fail;
-  data = info.data;
+  /* point into the ring buffer unless downstream provided a buffer or too
+   * much of the ring buffer is still in use downstream */
+  wrap = QUEUE_IS_USING_RING_BUFFER (queue) && !QUEUE_IS_USING_TEMP_FILE (queue)
+      && queue->arena && *buffer == NULL
+      && queue->pinned_bytes + length <= MAX_PINNED_BYTES (queue);
+  n_pins = queue->pins.length;
+
+  if (wrap) {
+    buf = gst_buffer_new ();
+    data = NULL;
+  } else {
+    /* allocate the output buffer of the requested size */
+    if (*buffer == NULL)
+      buf = gst_buffer_new_allocate (NULL, length, NULL);
+    else
+      buf = *buffer;
+
+    if (!gst_buffer_map (buf, &info, GST_MAP_WRITE))
+      goto buffer_write_fail;
+    data = info.data;
+  }
 
   GST_DEBUG_OBJECT (queue, "Reading %u bytes from %" G_GUINT64_FORMAT, length,
       offset);
@@ -1644,17 +2267,23 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     while (read_length > 0) {
       gint64 read_return;
 
-      ret =
-          gst_queue2_read_data_at_offset (queue, file_offset, block_length,
-          data, &read_return);
-      if (ret != GST_FLOW_OK)
-        goto read_error;
+      if (wrap) {
+        gst_buffer_append_memory (buf,
+            gst_queue2_wrap_ring_buffer (queue, file_offset, block_length));
+        read_return = block_length;
+      } else {
+        ret =
+            gst_queue2_read_data_at_offset (queue, file_offset, block_length,
+            data, &read_return);
+        if (ret != GST_FLOW_OK)
+          goto read_error;
+        data += read_return;
+      }
 
       file_offset += read_return;
       if (QUEUE_IS_USING_RING_BUFFER (queue))
         file_offset %= rb_size;
 
-      data += read_return;
       read_length -= read_return;
       block_length = read_length;
       remaining -= read_return;
@@ -1666,8 +2295,10 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     GST_DEBUG_OBJECT (queue, "%u bytes left to read", remaining);
   }
 
-  gst_buffer_unmap (buf, &info);
-  gst_buffer_resize (buf, 0, length);
+  if (!wrap) {
+    gst_buffer_unmap (buf, &info);
+    gst_buffer_resize (buf, 0, length);
+  }
 
   GST_BUFFER_OFFSET (buf) = offset;
   GST_BUFFER_OFFSET_END (buf) = offset + length;
@@ -1680,7 +2311,10 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
 hit_eos:
   {
     GST_DEBUG_OBJECT (queue, "EOS hit and we don't have any requested data");
-    gst_buffer_unmap (buf, &info);
+    if (wrap)
+      gst_queue2_detach_pins (queue, n_pins);
+    else
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return GST_FLOW_EOS;
@@ -1688,7 +2322,10 @@ hit_eos:
 out_flushing:
   {
     GST_DEBUG_OBJECT (queue, "we are flushing");
-    gst_buffer_unmap (buf, &info);
+    if (wrap)
+      gst_queue2_detach_pins (queue, n_pins);
+    else
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return GST_FLOW_FLUSHING;
@@ -1696,7 +2333,10 @@ out_flushing:
 read_error:
   {
     GST_DEBUG_OBJECT (queue, "we have a read error");
-    gst_buffer_unmap (buf, &info);
+    if (wrap)
+      gst_queue2_detach_pins (queue, n_pins);
+    else
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return ret;
@@ -1840,6 +2480,9 @@ gst_queue2_close_temp_location_file (GstQueue2 * queue)
 
   GST_DEBUG_OBJECT (queue, "closing temp file");
 
+  /* buffers pointing into the file keep the mappings alive */
+  gst_queue2_clear_mapping (queue);
+
   fflush (queue->temp_file);
   fclose (queue->temp_file);
 
@@ -1862,9 +2505,52 @@ gst_queue2_flush_temp_file (GstQueue2 * queue)
 
   GST_DEBUG_OBJECT (queue, "flushing temp file");
 
+  /* truncating the file would make buffers pointing into a mapping of it
+   * crash when accessed. The ranges are cleared anyway and new data for an
+   * offset is the same as the old data of the stream there, so keep it. */
+  if (queue->mapping)
+    return;
+
   queue->temp_file = g_freopen (queue->temp_location, "wb+", queue->temp_file);
 }
 
+/* charges the change of the byte level to the budget, with QUEUE2_LOCK */
+static void
+gst_queue2_locked_update_budget (GstQueue2 * queue)
+{
+  guint64 bytes;
+
+  if (queue->budget == NULL)
+    return;
+
+  /* only the data held in memory counts */
+  bytes = QUEUE_IS_USING_QUEUE (queue) ? queue->cur_level.bytes : 0;
+  if (bytes > queue->budget_charged)
+    gst_queue_budget_charge (queue->budget, bytes - queue->budget_charged);
+  else if (bytes < queue->budget_charged)
+    gst_queue_budget_release (queue->budget, queue->budget_charged - bytes);
+  queue->budget_charged = bytes;
+}
+
+/* moves the charged bytes to @budget, with QUEUE2_LOCK */
+static void
+gst_queue2_locked_set_budget (GstQueue2 * queue, GstQueueBudget * budget)
+{
+  if (queue->budget == budget)
+    return;
+
+  if (queue->budget) {
+    gst_queue_budget_release (queue->budget, queue->budget_charged);
+    gst_object_unref (queue->budget);
+  }
+  queue->budget = budget ? gst_object_ref (budget) : NULL;
+  queue->budget_charged = 0;
+  gst_queue2_locked_update_budget (queue);
+
+  /* upstream might be waiting for the old budget */
+  GST_QUEUE2_SIGNAL_DEL (queue);
+}
+
 static void
 gst_queue2_locked_flush (GstQueue2 * queue, gboolean full, gboolean clear_temp)
 {
@@ -1893,6 +2579,7 @@ gst_queue2_locked_flush (GstQueue2 * queue, gboolean full, gboolean clear_temp)
   queue->last_query = FALSE;
   g_cond_signal (&queue->query_handled);
   GST_QUEUE2_CLEAR_LEVEL (queue->cur_level);
+  gst_queue2_locked_update_budget (queue);
   gst_segment_init (&queue->sink_segment, GST_FORMAT_TIME);
   gst_segment_init (&queue->src_segment, GST_FORMAT_TIME);
   queue->sinktime = queue->srctime = GST_CLOCK_TIME_NONE;
@@ -1922,6 +2609,15 @@ gst_queue2_wait_free_space (GstQueue2 * queue)
 
     GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
         "queue is full, waiting for free space");
+
+    /* report that we are filled, the application might wait for us */
+    if (queue->use_buffering && gst_queue2_budget_blocks (queue)) {
+      update_buffering (queue);
+      GST_QUEUE2_MUTEX_UNLOCK (queue);
+      gst_queue2_post_buffering (queue);
+      GST_QUEUE2_MUTEX_LOCK_CHECK (queue, queue->sinkresult, out_flushing);
+    }
+
     do {
       /* Wait for space to be available, we could be unlocked because of a flush. */
       GST_QUEUE2_WAIT_DEL_CHECK (queue, queue->sinkresult, out_flushing);
@@ -1965,6 +2661,21 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
   size = info.size;
   data = info.data;
 
+  /* the first data after a seek, update the average seek latency */
+  if (GST_CLOCK_TIME_IS_VALID (queue->seek_time)) {
+    GstClockTime latency = gst_util_get_timestamp () - queue->seek_time;
+
+    if (GST_CLOCK_TIME_IS_VALID (queue->seek_latency))
+      queue->seek_latency = (3 * queue->seek_latency + latency) / 4;
+    else
+      queue->seek_latency = latency;
+    queue->seek_time = GST_CLOCK_TIME_NONE;
+
+    GST_DEBUG_OBJECT (queue, "seek latency %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (queue->seek_latency));
+  }
+  queue->seek_bytes += size;
+
   GST_DEBUG_OBJECT (queue, "Writing %u bytes to %" G_GUINT64_FORMAT, size,
       writing_pos);
 
@@ -1995,6 +2706,14 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
        * buffer now */
       to_write = MIN (size, space);
 
+      /* don't overwrite data that buffers downstream still point to */
+      to_write = gst_queue2_get_unpinned_space (queue, writing_pos, to_write);
+      if (to_write == 0) {
+        GST_DEBUG_OBJECT (queue, "waiting for downstream to release data");
+        GST_QUEUE2_WAIT_DEL_CHECK (queue, queue->sinkresult, out_flushing);
+        continue;
+      }
+
       /* the writing position in the ring buffer after writing (part
        * or all of) the buffer */
       new_writing_pos = (writing_pos + to_write) % rb_size;
@@ -2192,6 +2911,8 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
     }
     if (do_seek)
       perform_seek_to_offset (queue, new_writing_pos);
+    else if (!QUEUE_IS_USING_RING_BUFFER (queue) && prefetch_is_due (queue))
+      seek_to_prefetch (queue);
 
     update_cur_level (queue, queue->current);
 
@@ -2416,6 +3137,8 @@ gst_queue2_locked_enqueue (GstQueue2 * queue, gpointer item,
     item = NULL;
   }
 
+  gst_queue2_locked_update_budget (queue);
+
   if (item) {
     /* update the buffering status */
     if (queue->use_buffering)
@@ -2549,6 +3272,7 @@ gst_queue2_locked_dequeue (GstQueue2 * queue, GstQueue2ItemType * item_type)
     item = NULL;
     *item_type = GST_QUEUE2_ITEM_TYPE_UNKNOWN;
   }
+  gst_queue2_locked_update_budget (queue);
   GST_QUEUE2_SIGNAL_DEL (queue);
 
   return item;
@@ -2850,6 +3574,18 @@ gst_queue2_is_empty (GstQueue2 * queue)
   return FALSE;
 }
 
+/* TRUE when the shared budget makes upstream wait. Only a queue that holds
+ * buffers in memory waits, they are pushed out and released again. */
+static gboolean
+gst_queue2_budget_blocks (GstQueue2 * queue)
+{
+  return queue->budget && QUEUE_IS_USING_QUEUE (queue)
+      && queue->cur_level.buffers > 0
+      && gst_queue_budget_is_exhausted (queue->budget)
+      && gst_queue_budget_get_policy (queue->budget) ==
+      GST_QUEUE_BUDGET_POLICY_BLOCK;
+}
+
 static gboolean
 gst_queue2_is_filled (GstQueue2 * queue)
 {
@@ -2885,6 +3621,10 @@ gst_queue2_is_filled (GstQueue2 * queue)
   if (queue->cur_level.buffers == 0)
     return FALSE;
 
+  /* stay within the memory budget shared with other queues */
+  if (gst_queue2_budget_blocks (queue))
+    return TRUE;
+
   /* we are filled if one of the current levels exceeds the max */
   res = CHECK_FILLED_REAL (buffers) || CHECK_FILLED_REAL (bytes)
       || CHECK_FILLED_REAL (time);
@@ -2916,6 +3656,12 @@ gst_queue2_chain_buffer_or_buffer_list (GstQueue2 * queue,
   if (queue->seeking)
     goto out_seeking;
 
+  if (QUEUE_IS_USING_QUEUE (queue) && queue->budget
+      && gst_queue_budget_is_exhausted (queue->budget)
+      && gst_queue_budget_get_policy (queue->budget) ==
+      GST_QUEUE_BUDGET_POLICY_LEAK)
+    goto out_leak;
+
   if (!gst_queue2_wait_free_space (queue))
     goto out_flushing;
 
@@ -2946,6 +3692,15 @@ out_eos:
 
     return GST_FLOW_EOS;
   }
+out_leak:
+  {
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+        "budget exhausted, leaking buffer on upstream end");
+    GST_QUEUE2_MUTEX_UNLOCK (queue);
+    gst_mini_object_unref (item);
+
+    return GST_FLOW_OK;
+  }
 out_seeking:
   {
     GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we are seeking");
@@ -3725,8 +4480,7 @@ gst_queue2_src_activate_pull (GstPad * pad, GstObject * parent, gboolean active)
         /* open the temp file now */
         result = gst_queue2_open_temp_location_file (queue);
       } else if (!queue->ring_buffer) {
-        queue->ring_buffer = g_malloc (queue->ring_buffer_max_size);
-        result = ! !queue->ring_buffer;
+        result = gst_queue2_alloc_ring_buffer (queue);
       } else {
         result = TRUE;
       }
@@ -3800,11 +4554,7 @@ gst_queue2_change_state (GstElement * element, GstStateChange transition)
           if (!gst_queue2_open_temp_location_file (queue))
             ret = GST_STATE_CHANGE_FAILURE;
         } else {
-          if (queue->ring_buffer) {
-            g_free (queue->ring_buffer);
-            queue->ring_buffer = NULL;
-          }
-          if (!(queue->ring_buffer = g_malloc (queue->ring_buffer_max_size)))
+          if (!gst_queue2_alloc_ring_buffer (queue))
             ret = GST_STATE_CHANGE_FAILURE;
         }
         init_ranges (queue);
@@ -3840,9 +4590,8 @@ gst_queue2_change_state (GstElement * element, GstStateChange transition)
       if (!QUEUE_IS_USING_QUEUE (queue)) {
         if (QUEUE_IS_USING_TEMP_FILE (queue)) {
           gst_queue2_close_temp_location_file (queue);
-        } else if (queue->ring_buffer) {
-          g_free (queue->ring_buffer);
-          queue->ring_buffer = NULL;
+        } else {
+          gst_queue2_free_ring_buffer (queue);
         }
         clean_ranges (queue);
       }
@@ -3976,12 +4725,28 @@ gst_queue2_set_property (GObject * object,
     case PROP_TEMP_REMOVE:
       queue->temp_remove = g_value_get_boolean (value);
       break;
+    case PROP_TEMP_MMAP:
+      queue->temp_mmap = g_value_get_boolean (value);
+      break;
     case PROP_RING_BUFFER_MAX_SIZE:
       queue->ring_buffer_max_size = g_value_get_uint64 (value);
       break;
     case PROP_USE_BITRATE_QUERY:
       queue->use_bitrate_query = g_value_get_boolean (value);
       break;
+    case PROP_RATE_ESTIMATOR:
+      gst_rate_estimator_init (&queue->in_estimator, g_value_get_enum (value),
+          queue->in_estimator.window);
+      break;
+    case PROP_RATE_WINDOW:
+      queue->in_estimator.window = g_value_get_uint64 (value);
+      break;
+    case PROP_PREFETCH_BYTES:
+      queue->prefetch_bytes = g_value_get_uint64 (value);
+      break;
+    case PROP_BUDGET:
+      gst_queue2_locked_set_budget (queue, g_value_get_object (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4050,6 +4815,9 @@ gst_queue2_get_property (GObject * object,
     case PROP_TEMP_REMOVE:
       g_value_set_boolean (value, queue->temp_remove);
       break;
+    case PROP_TEMP_MMAP:
+      g_value_set_boolean (value, queue->temp_mmap);
+      break;
     case PROP_RING_BUFFER_MAX_SIZE:
       g_value_set_uint64 (value, queue->ring_buffer_max_size);
       break;
@@ -4083,6 +4851,18 @@ gst_queue2_get_property (GObject * object,
       g_value_set_uint64 (value, (guint64) bitrate);
       break;
     }
+    case PROP_RATE_ESTIMATOR:
+      g_value_set_enum (value, queue->in_estimator.mode);
+      break;
+    case PROP_RATE_WINDOW:
+      g_value_set_uint64 (value, queue->in_estimator.window);
+      break;
+    case PROP_PREFETCH_BYTES:
+      g_value_set_uint64 (value, queue->prefetch_bytes);
+      break;
+    case PROP_BUDGET:
+      g_value_set_object (value, queue->budget);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4090,3 +4870,20 @@ gst_queue2_get_property (GObject * object,
 
   GST_QUEUE2_MUTEX_UNLOCK (queue);
 }
+
+static void
+gst_queue2_set_context (GstElement * element, GstContext * context)
+{
+  GstQueue2 *queue = GST_QUEUE2 (element);
+  GstQueueBudget *budget;
+
+  if (gst_context_get_queue_budget (context, &budget)) {
+    GST_DEBUG_OBJECT (queue, "using budget %" GST_PTR_FORMAT, budget);
+    GST_QUEUE2_MUTEX_LOCK (queue);
+    gst_queue2_locked_set_budget (queue, budget);
+    GST_QUEUE2_MUTEX_UNLOCK (queue);
+    gst_object_unref (budget);
+  }
+
+  GST_ELEMENT_CLASS (parent_class)->set_context (element, context);
+}
@@ -27,6 +27,9 @@
 #include <gst/gst.h>
 #include <stdio.h>
 #include <gst/base/gstqueuearray.h>
+#include <gst/base/gstqueuebudget.h>
+
+#include "gstelements_private.h"
 
 G_BEGIN_DECLS
 
@@ -47,6 +50,8 @@ typedef struct _GstQueue2 GstQueue2;
 typedef struct _GstQueue2Size GstQueue2Size;
 typedef struct _GstQueue2Class GstQueue2Class;
 typedef struct _GstQueue2Range GstQueue2Range;
+typedef struct _GstQueue2Mapping GstQueue2Mapping;
+typedef struct _GstQueue2Arena GstQueue2Arena;
 
 /* used to keep track of sizes (current and max) */
 struct _GstQueue2Size
@@ -130,7 +135,7 @@ struct _GstQueue2
   gdouble last_in_elapsed;
   guint64 bytes_in;
   gdouble byte_in_rate;
-  gdouble byte_in_period;
+  GstRateEstimator in_estimator;
 
   GTimer *out_timer;
   gboolean out_timer_started;
@@ -150,6 +155,8 @@ struct _GstQueue2
   gchar *temp_location;
   gboolean temp_remove;
   FILE *temp_file;
+  gboolean temp_mmap;
+  GstQueue2Mapping *mapping;     /* current mapping of the temp file */
   /* list of downloaded areas and the current area */
   GstQueue2Range *ranges;
   GstQueue2Range *current;
@@ -159,10 +166,26 @@ struct _GstQueue2
   GstEvent *starting_segment;
   gboolean seeking;
 
+  /* seek latency, to decide between seeking and rereading */
+  GstClockTime seek_time;
+  GstClockTime seek_latency;
+
+  /* read-ahead interrupted by a seek, resumed after prefetch_bytes */
+  guint64 prefetch_bytes;
+  guint64 prefetch_pos;
+  guint64 seek_bytes;
+
   GstEvent *stream_start_event;
 
   guint64 ring_buffer_max_size;
   guint8 * ring_buffer;
+  GstQueue2Arena *arena;       /* memory of the ring buffer */
+  GQueue pins;                 /* parts of the ring buffer used downstream */
+  guint64 pinned_bytes;
+
+  /* memory budget shared with other queues, with QUEUE2_LOCK */
+  GstQueueBudget *budget;
+  guint64 budget_charged;      /* bytes of cur_level charged to budget */
 
   gint downstream_may_block;
 
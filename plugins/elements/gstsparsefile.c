@@ -54,13 +54,11 @@ typedef struct _GstSparseRange GstSparseRange;
 
 struct _GstSparseRange
 {
-  GstSparseRange *next;
-
   gsize start;
   gsize stop;
 };
 
-#define RANGE_CONTAINS(r,o) ((r)->start <= (o) && (r)->stop > (o))
+#define RANGE(iter) ((GstSparseRange *) g_sequence_get (iter))
 
 struct _GstSparseFile
 {
@@ -69,47 +67,79 @@ struct _GstSparseFile
   gsize current_pos;
   gboolean was_writing;
 
-  GstSparseRange *ranges;
+  /* the written ranges, sorted by start. Ranges that touch are merged, so
+   * they never overlap and are sorted by stop too */
+  GSequence *ranges;
   guint n_ranges;
 
-  GstSparseRange *write_range;
-  GstSparseRange *read_range;
+  GSequenceIter *write_range;
 };
 
-static GstSparseRange *
+static void
+range_free (GstSparseRange * range)
+{
+  g_slice_free (GstSparseRange, range);
+}
+
+/* orders @key after all ranges that start at or before it, so that a search
+ * never stops at an equal range */
+static gint
+range_compare_start (GstSparseRange * a, GstSparseRange * b,
+    GstSparseRange * key)
+{
+  if (a == key)
+    return a->start < b->start ? -1 : 1;
+
+  return a->start <= b->start ? -1 : 1;
+}
+
+/* returns the iter of the first range starting after @offset, the range
+ * before it is the last one that starts at or before @offset */
+static GSequenceIter *
+find_range_after (GstSparseFile * file, gsize offset)
+{
+  GstSparseRange key = { offset, offset };
+
+  return g_sequence_search (file->ranges, &key,
+      (GCompareDataFunc) range_compare_start, &key);
+}
+
+/* the range that starts at or before @offset, or NULL */
+static GSequenceIter *
+find_range_before (GstSparseFile * file, gsize offset)
+{
+  GSequenceIter *iter = find_range_after (file, offset);
+
+  if (g_sequence_iter_is_begin (iter))
+    return NULL;
+
+  return g_sequence_iter_prev (iter);
+}
+
+static GSequenceIter *
 get_write_range (GstSparseFile * file, gsize offset)
 {
-  GstSparseRange *next, *prev, *result = NULL;
+  GSequenceIter *next, *result = NULL;
+  GstSparseRange *range;
 
-  if (file->write_range && file->write_range->stop == offset)
+  if (file->write_range && RANGE (file->write_range)->stop == offset)
     return file->write_range;
 
-  prev = NULL;
-  next = file->ranges;
-  while (next) {
-    if (next->start > offset)
-      break;
+  next = find_range_after (file, offset);
+  if (!g_sequence_iter_is_begin (next)) {
+    GSequenceIter *prev = g_sequence_iter_prev (next);
 
-    if (next->stop >= offset) {
-      result = next;
-      break;
-    }
-    prev = next;
-    next = next->next;
+    if (RANGE (prev)->stop >= offset)
+      result = prev;
   }
-  if (result == NULL) {
-    result = g_slice_new0 (GstSparseRange);
-    result->start = offset;
-    result->stop = offset;
 
-    result->next = next;
-    if (prev)
-      prev->next = result;
-    else
-      file->ranges = result;
+  if (result == NULL) {
+    range = g_slice_new0 (GstSparseRange);
+    range->start = offset;
+    range->stop = offset;
 
+    result = g_sequence_insert_before (next, range);
     file->write_range = result;
-    file->read_range = NULL;
 
     file->n_ranges++;
   }
@@ -119,21 +149,15 @@ get_write_range (GstSparseFile * file, gsize offset)
 static GstSparseRange *
 get_read_range (GstSparseFile * file, gsize offset, gsize count)
 {
-  GstSparseRange *walk, *result = NULL;
+  GSequenceIter *iter;
 
-  if (file->read_range && RANGE_CONTAINS (file->read_range, offset))
-    return file->read_range;
+  if ((iter = find_range_before (file, offset)) == NULL)
+    return NULL;
 
-  for (walk = file->ranges; walk; walk = walk->next) {
-    if (walk->start > offset)
-      break;
+  if (RANGE (iter)->stop < offset + count)
+    return NULL;
 
-    if (walk->stop >= offset + count) {
-      result = walk;
-      break;
-    }
-  }
-  return result;
+  return RANGE (iter);
 }
 
 /**
@@ -152,7 +176,7 @@ gst_sparse_file_new (void)
 
   result = g_slice_new0 (GstSparseFile);
   result->current_pos = 0;
-  result->ranges = NULL;
+  result->ranges = g_sequence_new ((GDestroyNotify) range_free);
   result->n_ranges = 0;
 
   return result;
@@ -192,10 +216,11 @@ gst_sparse_file_clear (GstSparseFile * file)
 {
   g_return_if_fail (file != NULL);
 
-  g_slice_free_chain (GstSparseRange, file->ranges, next);
+  g_sequence_remove_range (g_sequence_get_begin_iter (file->ranges),
+      g_sequence_get_end_iter (file->ranges));
   file->current_pos = 0;
-  file->ranges = NULL;
   file->n_ranges = 0;
+  file->write_range = NULL;
   file->was_writing = FALSE;
 }
 
@@ -216,7 +241,7 @@ gst_sparse_file_free (GstSparseFile * file)
     fflush (file->file);
     fclose (file->file);
   }
-  g_slice_free_chain (GstSparseRange, file->ranges, next);
+  g_sequence_free (file->ranges);
   g_slice_free (GstSparseFile, file);
 }
 
@@ -242,7 +267,8 @@ gsize
 gst_sparse_file_write (GstSparseFile * file, gsize offset, gconstpointer data,
     gsize count, gsize * available, GError ** error)
 {
-  GstSparseRange *range, *next;
+  GSequenceIter *iter, *next;
+  GstSparseRange *range;
   gsize stop;
 
   g_return_val_if_fail (file != NULL, 0);
@@ -264,27 +290,27 @@ gst_sparse_file_write (GstSparseFile * file, gsize offset, gconstpointer data,
   file->current_pos = offset + count;
 
   /* update the new stop position in the range */
-  range = get_write_range (file, offset);
+  iter = get_write_range (file, offset);
+  range = RANGE (iter);
   stop = offset + count;
   range->stop = MAX (range->stop, stop);
 
   /* see if we can merge with next region */
-  while ((next = range->next)) {
-    if (next->start > range->stop)
+  while (!g_sequence_iter_is_end (next = g_sequence_iter_next (iter))) {
+    GstSparseRange *nrange = RANGE (next);
+
+    if (nrange->start > range->stop)
       break;
 
     GST_DEBUG ("merging range %" G_GSIZE_FORMAT "-%" G_GSIZE_FORMAT ", next %"
         G_GSIZE_FORMAT "-%" G_GSIZE_FORMAT, range->start, range->stop,
-        next->start, next->stop);
+        nrange->start, nrange->stop);
 
-    range->stop = MAX (next->stop, range->stop);
-    range->next = next->next;
+    range->stop = MAX (nrange->stop, range->stop);
 
     if (file->write_range == next)
       file->write_range = NULL;
-    if (file->read_range == next)
-      file->read_range = NULL;
-    g_slice_free (GstSparseRange, next);
+    g_sequence_remove (next);
     file->n_ranges--;
   }
   if (available)
@@ -414,19 +440,13 @@ gboolean
 gst_sparse_file_get_range_before (GstSparseFile * file, gsize offset,
     gsize * start, gsize * stop)
 {
-  GstSparseRange *walk, *result = NULL;
+  GSequenceIter *iter;
+  GstSparseRange *result = NULL;
 
   g_return_val_if_fail (file != NULL, FALSE);
 
-  for (walk = file->ranges; walk; walk = walk->next) {
-    GST_DEBUG ("start %" G_GSIZE_FORMAT " > %" G_GSIZE_FORMAT,
-        walk->stop, offset);
-    if (walk->start > offset)
-      break;
-
-    if (walk->start <= offset)
-      result = walk;
-  }
+  if ((iter = find_range_before (file, offset)))
+    result = RANGE (iter);
 
   if (result) {
     if (start)
@@ -455,18 +475,20 @@ gboolean
 gst_sparse_file_get_range_after (GstSparseFile * file, gsize offset,
     gsize * start, gsize * stop)
 {
-  GstSparseRange *walk, *result = NULL;
+  GSequenceIter *iter;
+  GstSparseRange *result = NULL;
 
   g_return_val_if_fail (file != NULL, FALSE);
 
-  for (walk = file->ranges; walk; walk = walk->next) {
-    GST_DEBUG ("stop %" G_GSIZE_FORMAT " > %" G_GSIZE_FORMAT,
-        walk->stop, offset);
-    if (walk->stop > offset) {
-      result = walk;
-      break;
-    }
-  }
+  /* the first range ending after @offset is either the one containing it or
+   * the one after that */
+  iter = find_range_after (file, offset);
+  if (!g_sequence_iter_is_begin (iter)
+      && RANGE (g_sequence_iter_prev (iter))->stop > offset)
+    iter = g_sequence_iter_prev (iter);
+  if (!g_sequence_iter_is_end (iter))
+    result = RANGE (iter);
+
   if (result) {
     if (start)
       *start = result->start;
@@ -81,10 +81,13 @@ GST_ELEMENT_REGISTER_DEFINE (streamiddemux, "streamiddemux", GST_RANK_PRIMARY,
     GST_TYPE_STREAMID_DEMUX);
 
 static void gst_streamid_demux_dispose (GObject * object);
+static void gst_streamid_demux_finalize (GObject * object);
 static void gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static GstFlowReturn gst_streamid_demux_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_streamid_demux_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_streamid_demux_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static GstStateChangeReturn gst_streamid_demux_change_state (GstElement *
@@ -105,6 +108,7 @@ gst_streamid_demux_class_init (GstStreamidDemuxClass * klass)
 
   gobject_class->get_property = gst_streamid_demux_get_property;
   gobject_class->dispose = gst_streamid_demux_dispose;
+  gobject_class->finalize = gst_streamid_demux_finalize;
 
   g_object_class_install_property (gobject_class, PROP_ACTIVE_PAD,
       g_param_spec_object ("active-pad", "Active pad",
@@ -131,6 +135,8 @@ gst_streamid_demux_init (GstStreamidDemux * demux)
       "sink");
   gst_pad_set_chain_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_chain));
+  gst_pad_set_chain_list_function (demux->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_streamid_demux_chain_list));
   gst_pad_set_event_function (demux->sinkpad,
       GST_DEBUG_FUNCPTR (gst_streamid_demux_event));
 
@@ -156,6 +162,16 @@ gst_streamid_demux_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_streamid_demux_finalize (GObject * object)
+{
+  GstStreamidDemux *demux = GST_STREAMID_DEMUX (object);
+
+  g_hash_table_unref (demux->stream_id_pairs);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_streamid_demux_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
@@ -208,6 +224,10 @@ gst_streamid_demux_srcpad_create (GstStreamidDemux * demux, GstPad * pad,
   return TRUE;
 }
 
+/* The active srcpad is only changed from the streaming thread, or after
+ * the streaming thread was stopped, and the pads stay referenced by the
+ * stream-id table until then. The data path can thus use it without
+ * locking. */
 static GstFlowReturn
 gst_streamid_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -217,19 +237,13 @@ gst_streamid_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   demux = GST_STREAMID_DEMUX (parent);
 
-  GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT,
-      demux->active_srcpad);
-
-  GST_OBJECT_LOCK (demux);
-  if (demux->active_srcpad) {
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push (srcpad, buf);
-    gst_object_unref (srcpad);
-  } else {
-    GST_OBJECT_UNLOCK (demux);
+  srcpad = demux->active_srcpad;
+  if (!srcpad)
     goto no_active_srcpad;
-  }
+
+  GST_LOG_OBJECT (demux, "pushing buffer to %" GST_PTR_FORMAT, srcpad);
+
+  res = gst_pad_push (srcpad, buf);
 
   GST_LOG_OBJECT (demux, "handled buffer %s", gst_flow_get_name (res));
   return res;
@@ -238,6 +252,40 @@ gst_streamid_demux_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 no_active_srcpad:
   {
     GST_WARNING_OBJECT (demux, "srcpad is not initialized");
+    gst_buffer_unref (buf);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+}
+
+/* All buffers of a list belong to the stream of the last stream-start, so
+ * the whole list is forwarded at once */
+static GstFlowReturn
+gst_streamid_demux_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFlowReturn res = GST_FLOW_OK;
+  GstStreamidDemux *demux = NULL;
+  GstPad *srcpad = NULL;
+
+  demux = GST_STREAMID_DEMUX (parent);
+
+  srcpad = demux->active_srcpad;
+  if (!srcpad)
+    goto no_active_srcpad;
+
+  GST_LOG_OBJECT (demux, "pushing buffer list of %u buffers to %"
+      GST_PTR_FORMAT, gst_buffer_list_length (list), srcpad);
+
+  res = gst_pad_push_list (srcpad, list);
+
+  GST_LOG_OBJECT (demux, "handled buffer list %s", gst_flow_get_name (res));
+  return res;
+
+/* ERROR */
+no_active_srcpad:
+  {
+    GST_WARNING_OBJECT (demux, "srcpad is not initialized");
+    gst_buffer_list_unref (list);
     return GST_FLOW_NOT_NEGOTIATED;
   }
 }
@@ -249,7 +297,7 @@ gst_streamid_demux_get_srcpad_by_stream_id (GstStreamidDemux * demux,
   GstPad *srcpad = NULL;
 
   GST_DEBUG_OBJECT (demux, "stream_id = %s", stream_id);
-  if (demux->stream_id_pairs == NULL || stream_id == NULL) {
+  if (stream_id == NULL) {
     goto done;
   }
 
@@ -313,12 +361,7 @@ gst_streamid_demux_event (GstPad * pad, GstObject * parent, GstEvent * event)
       || GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
     res = gst_pad_event_default (pad, parent, event);
   } else if (demux->active_srcpad) {
-    GstPad *srcpad = NULL;
-    GST_OBJECT_LOCK (demux);
-    srcpad = gst_object_ref (demux->active_srcpad);
-    GST_OBJECT_UNLOCK (demux);
-    res = gst_pad_push_event (srcpad, event);
-    gst_object_unref (srcpad);
+    res = gst_pad_push_event (demux->active_srcpad, event);
   } else {
     gst_event_unref (event);
   }
@@ -370,10 +413,7 @@ gst_streamid_demux_reset (GstStreamidDemux * demux)
   demux->nb_srcpads = 0;
   GST_OBJECT_UNLOCK (demux);
 
-  if (demux->stream_id_pairs != NULL) {
-    g_hash_table_unref (demux->stream_id_pairs);
-    demux->stream_id_pairs = NULL;
-  }
+  g_hash_table_remove_all (demux->stream_id_pairs);
 
   it = gst_element_iterate_src_pads (GST_ELEMENT_CAST (demux));
   while (itret == GST_ITERATOR_OK || itret == GST_ITERATOR_RESYNC) {
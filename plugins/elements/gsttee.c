@@ -35,6 +35,13 @@
  * provide separate threads for each branch. Otherwise a blocked dataflow in one
  * branch would stall the other branches.
  *
+ * Alternatively the #GstTeePad:async property can be set on a src pad to give
+ * its branch a thread of its own. Buffers are then handed to that thread
+ * through a lock-free queue of at most #GstTeePad:max-size-buffers items, and
+ * up to #GstTeePad:max-batch-buffers consecutive buffers waiting in it are
+ * pushed downstream as one buffer list. What happens when the queue is full is
+ * configured per branch with #GstTeePad:leaky.
+ *
  * ## Example launch line
  * |[
  * gst-launch-1.0 filesrc location=song.ogg ! decodebin ! tee name=t ! queue ! audioconvert ! audioresample ! autoaudiosink t. ! queue ! audioconvert ! goom ! videoconvert ! autovideosink
@@ -50,11 +57,12 @@
 #endif
 
 #include "gsttee.h"
+#include "gstqueue.h"
 #include "gstcoreelementselements.h"
+#include "gstelements_private.h"
 #include "gst/glib-compat-private.h"
 
 #include <string.h>
-#include <stdio.h>
 
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -138,9 +146,27 @@ struct _GstTeePad
   GstPad parent;
 
   guint index;
-  gboolean pushed;
-  GstFlowReturn result;
-  gboolean removed;
+  gboolean removed;             /* atomic */
+
+  /* asynchronous branch */
+  gboolean async;
+  guint max_size_buffers;
+  guint max_batch_buffers;
+  GstQueueLeaky leaky;
+
+  /* TRUE when the branch thread is started, protected by the sinkpad
+   * STREAM_LOCK */
+  gboolean running;
+  GstAtomicQueue *queue;
+  gint n_buffers;               /* buffers and lists in queue, atomic */
+  gint srcresult;               /* GstFlowReturn of the branch, atomic */
+  gint flushing;                /* atomic */
+
+  /* only taken to sleep when the queue is empty or full */
+  GMutex lock;
+  GCond cond;
+  gint waiting_add;             /* atomic */
+  gint waiting_del;             /* atomic */
 };
 
 struct _GstTeePadClass
@@ -148,18 +174,455 @@ struct _GstTeePadClass
   GstPadClass parent;
 };
 
+#define DEFAULT_PAD_ASYNC		FALSE
+#define DEFAULT_PAD_MAX_SIZE_BUFFERS	64
+#define DEFAULT_PAD_MAX_BATCH_BUFFERS	1       /* no batching */
+#define DEFAULT_PAD_LEAKY		GST_QUEUE_NO_LEAK
+
+#define TEE_FLOW_IS_OK(ret) ((ret) == GST_FLOW_OK || (ret) == GST_FLOW_NOT_LINKED)
+
+enum
+{
+  PROP_PAD_0,
+  PROP_PAD_ASYNC,
+  PROP_PAD_MAX_SIZE_BUFFERS,
+  PROP_PAD_MAX_BATCH_BUFFERS,
+  PROP_PAD_LEAKY,
+};
+
 G_DEFINE_TYPE (GstTeePad, gst_tee_pad, GST_TYPE_PAD);
 
+static void gst_tee_pad_loop (GstTeePad * pad);
+
+static void
+gst_tee_pad_wake (GstTeePad * pad, gint * waiting)
+{
+  if (g_atomic_int_get (waiting)) {
+    g_mutex_lock (&pad->lock);
+    g_cond_broadcast (&pad->cond);
+    g_mutex_unlock (&pad->lock);
+  }
+}
+
+static void
+gst_tee_pad_set_result (GstTeePad * pad, GstFlowReturn ret)
+{
+  g_mutex_lock (&pad->lock);
+  if (!g_atomic_int_get (&pad->flushing))
+    g_atomic_int_set (&pad->srcresult, ret);
+  g_cond_broadcast (&pad->cond);
+  g_mutex_unlock (&pad->lock);
+}
+
+static void
+gst_tee_pad_set_flushing (GstTeePad * pad, gboolean flushing)
+{
+  g_mutex_lock (&pad->lock);
+  g_atomic_int_set (&pad->flushing, flushing);
+  g_atomic_int_set (&pad->srcresult, flushing ? GST_FLOW_FLUSHING :
+      GST_FLOW_OK);
+  g_cond_broadcast (&pad->cond);
+  g_mutex_unlock (&pad->lock);
+}
+
+static void
+gst_tee_pad_flush_queue (GstTeePad * pad)
+{
+  GstMiniObject *item;
+
+  while ((item = gst_atomic_queue_pop (pad->queue)))
+    gst_mini_object_unref (item);
+  g_atomic_int_set (&pad->n_buffers, 0);
+}
+
+/* hand @item to the branch thread, takes ownership of @item */
+static GstFlowReturn
+gst_tee_pad_enqueue (GstTeePad * pad, GstMiniObject * item, gboolean is_data)
+{
+  GstFlowReturn ret;
+  guint max_size = pad->max_size_buffers;
+
+  ret = g_atomic_int_get (&pad->srcresult);
+  if (G_UNLIKELY (!TEE_FLOW_IS_OK (ret)))
+    goto out;
+
+  if (is_data && max_size > 0
+      && (guint) g_atomic_int_get (&pad->n_buffers) >= max_size) {
+    switch (pad->leaky) {
+      case GST_QUEUE_LEAK_UPSTREAM:
+        GST_DEBUG_OBJECT (pad, "queue is full, leaking item %p", item);
+        goto out;
+      case GST_QUEUE_LEAK_DOWNSTREAM:
+        /* the branch thread drops the oldest items */
+        break;
+      default:
+        g_mutex_lock (&pad->lock);
+        g_atomic_int_set (&pad->waiting_del, TRUE);
+        while (pad->max_size_buffers > 0 &&
+            (guint) g_atomic_int_get (&pad->n_buffers) >= pad->max_size_buffers
+            &&
+            TEE_FLOW_IS_OK (g_atomic_int_get (&pad->srcresult))) {
+          GST_LOG_OBJECT (pad, "queue is full, waiting for free space");
+          g_cond_wait (&pad->cond, &pad->lock);
+        }
+        g_atomic_int_set (&pad->waiting_del, FALSE);
+        g_mutex_unlock (&pad->lock);
+
+        ret = g_atomic_int_get (&pad->srcresult);
+        if (!TEE_FLOW_IS_OK (ret))
+          goto out;
+        break;
+    }
+  }
+
+  if (is_data)
+    g_atomic_int_inc (&pad->n_buffers);
+  gst_atomic_queue_push (pad->queue, item);
+  gst_tee_pad_wake (pad, &pad->waiting_add);
+
+  return ret;
+
+out:
+  gst_mini_object_unref (item);
+  return ret;
+}
+
+/* called from the branch thread only, sets @leak when the queue overflowed
+ * and the item must be dropped */
+static GstMiniObject *
+gst_tee_pad_dequeue (GstTeePad * pad, gboolean * leak)
+{
+  GstMiniObject *item;
+  gint n_buffers;
+
+  *leak = FALSE;
+
+  item = gst_atomic_queue_pop (pad->queue);
+  if (item == NULL || GST_IS_EVENT (item))
+    return item;
+
+  n_buffers = g_atomic_int_add (&pad->n_buffers, -1);
+  gst_tee_pad_wake (pad, &pad->waiting_del);
+
+  if (pad->leaky == GST_QUEUE_LEAK_DOWNSTREAM && pad->max_size_buffers > 0
+      && (guint) n_buffers > pad->max_size_buffers) {
+    GST_DEBUG_OBJECT (pad, "queue is full, leaking item %p", item);
+    *leak = TRUE;
+  }
+
+  return item;
+}
+
+/* push @item and the buffers queued right behind it, takes ownership of
+ * @item */
+static GstFlowReturn
+gst_tee_pad_push_item (GstTeePad * pad, GstMiniObject * item)
+{
+  GstPad *srcpad = GST_PAD_CAST (pad);
+  GstBufferList *list;
+  GstMiniObject *next;
+  guint max_batch = pad->max_batch_buffers;
+  gboolean leak;
+
+  if (GST_IS_EVENT (item)) {
+    GstEvent *event = GST_EVENT_CAST (item);
+    gboolean is_eos = GST_EVENT_TYPE (event) == GST_EVENT_EOS;
+
+    gst_pad_push_event (srcpad, event);
+
+    return is_eos ? GST_FLOW_EOS : GST_FLOW_OK;
+  }
+
+  if (GST_IS_BUFFER_LIST (item))
+    return gst_pad_push_list (srcpad, GST_BUFFER_LIST_CAST (item));
+
+  /* never batch across events or buffer lists */
+  next = max_batch > 1 ? gst_atomic_queue_peek (pad->queue) : NULL;
+  if (next == NULL || !GST_IS_BUFFER (next))
+    return gst_pad_push (srcpad, GST_BUFFER_CAST (item));
+
+  list = gst_buffer_list_new_sized (MIN (max_batch, 64));
+  gst_buffer_list_add (list, GST_BUFFER_CAST (item));
+
+  while (gst_buffer_list_length (list) < max_batch
+      && (next = gst_atomic_queue_peek (pad->queue)) && GST_IS_BUFFER (next)) {
+    /* we are the only consumer, this is the buffer we peeked */
+    next = gst_tee_pad_dequeue (pad, &leak);
+    if (leak)
+      gst_mini_object_unref (next);
+    else
+      gst_buffer_list_add (list, GST_BUFFER_CAST (next));
+  }
+
+  GST_LOG_OBJECT (pad, "pushing %u buffers as a list",
+      gst_buffer_list_length (list));
+
+  return gst_pad_push_list (srcpad, list);
+}
+
+static void
+gst_tee_pad_loop (GstTeePad * pad)
+{
+  GstMiniObject *item;
+  GstFlowReturn ret;
+  gboolean leak;
+
+  item = gst_tee_pad_dequeue (pad, &leak);
+  if (item == NULL) {
+    g_mutex_lock (&pad->lock);
+    g_atomic_int_set (&pad->waiting_add, TRUE);
+    while (gst_atomic_queue_length (pad->queue) == 0 &&
+        !g_atomic_int_get (&pad->flushing))
+      g_cond_wait (&pad->cond, &pad->lock);
+    g_atomic_int_set (&pad->waiting_add, FALSE);
+    g_mutex_unlock (&pad->lock);
+    return;
+  }
+
+  if (leak) {
+    gst_mini_object_unref (item);
+    return;
+  }
+
+  ret = gst_tee_pad_push_item (pad, item);
+
+  GST_LOG_OBJECT (pad, "pushed item, result %s", gst_flow_get_name (ret));
+
+  if (G_LIKELY (TEE_FLOW_IS_OK (ret))) {
+    g_atomic_int_set (&pad->srcresult, ret);
+    return;
+  }
+
+  /* the branch is EOS or failed, make upstream see it and wait for a flush
+   * or a new stream */
+  gst_tee_pad_set_result (pad, ret);
+  gst_pad_pause_task (GST_PAD_CAST (pad));
+
+  if (ret < GST_FLOW_EOS) {
+    GstElement *tee = GST_ELEMENT_CAST (GST_OBJECT_PARENT (pad));
+
+    GST_ELEMENT_FLOW_ERROR (tee, ret);
+    gst_pad_push_event (GST_PAD_CAST (pad), gst_event_new_eos ());
+  }
+}
+
+/* called with the sinkpad STREAM_LOCK */
+static void
+gst_tee_pad_start (GstTee * tee, GstTeePad * pad)
+{
+  if (pad->running)
+    return;
+
+  GST_DEBUG_OBJECT (pad, "starting branch thread");
+
+  gst_tee_pad_flush_queue (pad);
+  gst_tee_pad_set_flushing (pad, FALSE);
+  pad->running = TRUE;
+  g_atomic_int_inc (&tee->n_async_pads);
+  gst_pad_start_task (GST_PAD_CAST (pad), (GstTaskFunction) gst_tee_pad_loop,
+      pad, NULL);
+}
+
+/* called with the sinkpad STREAM_LOCK, pushes the queued items from the
+ * calling thread when @drain is set and drops them otherwise */
+static void
+gst_tee_pad_stop (GstTee * tee, GstTeePad * pad, gboolean drain)
+{
+  GstMiniObject *item;
+  gboolean leak;
+
+  if (!pad->running)
+    return;
+
+  GST_DEBUG_OBJECT (pad, "stopping branch thread");
+
+  g_mutex_lock (&pad->lock);
+  g_atomic_int_set (&pad->flushing, TRUE);
+  g_cond_broadcast (&pad->cond);
+  g_mutex_unlock (&pad->lock);
+
+  gst_pad_stop_task (GST_PAD_CAST (pad));
+
+  if (drain) {
+    while ((item = gst_tee_pad_dequeue (pad, &leak))) {
+      if (leak)
+        gst_mini_object_unref (item);
+      else
+        gst_tee_pad_push_item (pad, item);
+    }
+  }
+  gst_tee_pad_flush_queue (pad);
+
+  pad->running = FALSE;
+  g_atomic_int_add (&tee->n_async_pads, -1);
+}
+
+static void
+gst_tee_pad_set_async (GstTeePad * pad, gboolean async)
+{
+  GstTee *tee;
+
+  tee = (GstTee *) gst_object_get_parent (GST_OBJECT_CAST (pad));
+
+  if (tee == NULL) {
+    pad->async = async;
+    return;
+  }
+
+  /* serialize against the dataflow, this waits for the current buffer */
+  GST_PAD_STREAM_LOCK (tee->sinkpad);
+  pad->async = async;
+  if (async && GST_PAD_IS_ACTIVE (pad))
+    gst_tee_pad_start (tee, pad);
+  else if (!async)
+    gst_tee_pad_stop (tee, pad, TRUE);
+  GST_PAD_STREAM_UNLOCK (tee->sinkpad);
+
+  gst_object_unref (tee);
+}
+
+static void
+gst_tee_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstTeePad *pad = GST_TEE_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_ASYNC:
+      gst_tee_pad_set_async (pad, g_value_get_boolean (value));
+      break;
+    case PROP_PAD_MAX_SIZE_BUFFERS:
+      pad->max_size_buffers = g_value_get_uint (value);
+      /* let a waiting upstream see the new limit */
+      g_mutex_lock (&pad->lock);
+      g_cond_broadcast (&pad->cond);
+      g_mutex_unlock (&pad->lock);
+      break;
+    case PROP_PAD_MAX_BATCH_BUFFERS:
+      pad->max_batch_buffers = g_value_get_uint (value);
+      break;
+    case PROP_PAD_LEAKY:
+      pad->leaky = (GstQueueLeaky) g_value_get_enum (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_tee_pad_get_property (GObject * object, guint prop_id, GValue * value,
+    GParamSpec * pspec)
+{
+  GstTeePad *pad = GST_TEE_PAD (object);
+
+  switch (prop_id) {
+    case PROP_PAD_ASYNC:
+      g_value_set_boolean (value, pad->async);
+      break;
+    case PROP_PAD_MAX_SIZE_BUFFERS:
+      g_value_set_uint (value, pad->max_size_buffers);
+      break;
+    case PROP_PAD_MAX_BATCH_BUFFERS:
+      g_value_set_uint (value, pad->max_batch_buffers);
+      break;
+    case PROP_PAD_LEAKY:
+      g_value_set_enum (value, pad->leaky);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_tee_pad_finalize (GObject * object)
+{
+  GstTeePad *pad = GST_TEE_PAD (object);
+
+  gst_tee_pad_flush_queue (pad);
+  gst_atomic_queue_unref (pad->queue);
+  g_mutex_clear (&pad->lock);
+  g_cond_clear (&pad->cond);
+
+  G_OBJECT_CLASS (gst_tee_pad_parent_class)->finalize (object);
+}
+
 static void
 gst_tee_pad_class_init (GstTeePadClass * klass)
 {
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = gst_tee_pad_set_property;
+  gobject_class->get_property = gst_tee_pad_get_property;
+  gobject_class->finalize = gst_tee_pad_finalize;
+
+  /**
+   * GstTeePad:async:
+   *
+   * Push the data of this branch from a thread of its own instead of the
+   * upstream streaming thread. Serialized events are queued along with the
+   * buffers, queries are still answered from the calling thread.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_ASYNC,
+      g_param_spec_boolean ("async", "Async",
+          "Push the data of this branch from a separate thread",
+          DEFAULT_PAD_ASYNC,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTeePad:max-size-buffers:
+   *
+   * Maximum number of buffers and buffer lists waiting for the thread of an
+   * async branch, 0 for no limit.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_MAX_SIZE_BUFFERS,
+      g_param_spec_uint ("max-size-buffers", "Max. size (buffers)",
+          "Max. number of buffers queued for an async branch (0=disable)",
+          0, G_MAXUINT, DEFAULT_PAD_MAX_SIZE_BUFFERS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTeePad:max-batch-buffers:
+   *
+   * Maximum number of consecutive queued buffers that the thread of an async
+   * branch pushes downstream as one #GstBufferList.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_MAX_BATCH_BUFFERS,
+      g_param_spec_uint ("max-batch-buffers", "Max. batch buffers",
+          "Max. number of queued buffers to push downstream as one buffer "
+          "list (1 = disable batching)", 1, G_MAXUINT,
+          DEFAULT_PAD_MAX_BATCH_BUFFERS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstTeePad:leaky:
+   *
+   * What to do when the queue of an async branch is full: block upstream,
+   * drop the new buffers or drop the oldest queued buffers.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_PAD_LEAKY,
+      g_param_spec_enum ("leaky", "Leaky",
+          "Where the queue of an async branch leaks, if at all",
+          GST_TYPE_QUEUE_LEAKY, DEFAULT_PAD_LEAKY,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_tee_pad_reset (GstTeePad * pad)
 {
-  pad->pushed = FALSE;
-  pad->result = GST_FLOW_NOT_LINKED;
   pad->removed = FALSE;
 }
 
@@ -167,6 +630,17 @@ static void
 gst_tee_pad_init (GstTeePad * pad)
 {
   gst_tee_pad_reset (pad);
+
+  pad->async = DEFAULT_PAD_ASYNC;
+  pad->max_size_buffers = DEFAULT_PAD_MAX_SIZE_BUFFERS;
+  pad->max_batch_buffers = DEFAULT_PAD_MAX_BATCH_BUFFERS;
+  pad->leaky = DEFAULT_PAD_LEAKY;
+
+  pad->queue = gst_atomic_queue_new (DEFAULT_PAD_MAX_SIZE_BUFFERS);
+  pad->srcresult = GST_FLOW_FLUSHING;
+  pad->flushing = TRUE;
+  g_mutex_init (&pad->lock);
+  g_cond_init (&pad->cond);
 }
 
 static GstPad *gst_tee_request_new_pad (GstElement * element,
@@ -221,7 +695,7 @@ gst_tee_finalize (GObject * object)
 
   tee = GST_TEE (object);
 
-  g_hash_table_unref (tee->pad_indexes);
+  gst_pad_array_cache_clear (&tee->srcpads);
 
   g_free (tee->last_message);
 
@@ -294,13 +768,15 @@ gst_tee_class_init (GstTeeClass * klass)
       "1-to-N pipe fitting",
       "Erik Walthinsen <omega@cse.ogi.edu>, " "Wim Taymans <wim@fluendo.com>");
   gst_element_class_add_static_pad_template (gstelement_class, &sinktemplate);
-  gst_element_class_add_static_pad_template (gstelement_class, &src_template);
+  gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
+      &src_template, GST_TYPE_TEE_PAD);
 
   gstelement_class->request_new_pad =
       GST_DEBUG_FUNCPTR (gst_tee_request_new_pad);
   gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_tee_release_pad);
 
   gst_type_mark_as_plugin_api (GST_TYPE_TEE_PULL_MODE, 0);
+  gst_type_mark_as_plugin_api (GST_TYPE_TEE_PAD, 0);
 }
 
 static void
@@ -321,7 +797,7 @@ gst_tee_init (GstTee * tee)
   GST_OBJECT_FLAG_SET (tee->sinkpad, GST_PAD_FLAG_PROXY_CAPS);
   gst_element_add_pad (GST_ELEMENT (tee), tee->sinkpad);
 
-  tee->pad_indexes = g_hash_table_new (NULL, NULL);
+  gst_pad_array_cache_init (&tee->srcpads);
 
   tee->last_message = NULL;
 }
@@ -362,27 +838,14 @@ gst_tee_request_new_pad (GstElement * element, GstPadTemplate * templ,
 
   GST_DEBUG_OBJECT (tee, "requesting pad");
 
-  GST_OBJECT_LOCK (tee);
-
-  if (name_templ && sscanf (name_templ, "src_%u", &index) == 1) {
-    GST_LOG_OBJECT (element, "name: %s (index %d)", name_templ, index);
-    if (g_hash_table_contains (tee->pad_indexes, GUINT_TO_POINTER (index))) {
-      GST_ERROR_OBJECT (element, "pad name %s is not unique", name_templ);
-      GST_OBJECT_UNLOCK (tee);
-      return NULL;
-    }
-    if (index >= tee->next_pad_index)
-      tee->next_pad_index = index + 1;
-  } else {
-    index = tee->next_pad_index;
-
-    while (g_hash_table_contains (tee->pad_indexes, GUINT_TO_POINTER (index)))
-      index++;
-
-    tee->next_pad_index = index + 1;
+  if (!gst_element_claim_pad_index (element, templ, name_templ, &index)) {
+    GST_ERROR_OBJECT (element, "pad name %s is not unique", name_templ);
+    return NULL;
   }
+  GST_LOG_OBJECT (element, "name: %s (index %d)", GST_STR_NULL (name_templ),
+      index);
 
-  g_hash_table_insert (tee->pad_indexes, GUINT_TO_POINTER (index), NULL);
+  GST_OBJECT_LOCK (tee);
 
   name = g_strdup_printf ("src_%u", index);
 
@@ -421,6 +884,10 @@ gst_tee_request_new_pad (GstElement * element, GstPadTemplate * templ,
   gst_pad_sticky_events_foreach (tee->sinkpad, forward_sticky_events, srcpad);
   gst_element_add_pad (GST_ELEMENT_CAST (tee), srcpad);
 
+  GST_OBJECT_LOCK (tee);
+  gst_pad_array_cache_set (&tee->srcpads, GST_ELEMENT_CAST (tee)->srcpads);
+  GST_OBJECT_UNLOCK (tee);
+
   return srcpad;
 
   /* ERRORS */
@@ -436,6 +903,7 @@ activate_failed:
     }
     GST_OBJECT_UNLOCK (tee);
     gst_object_unref (srcpad);
+    gst_element_release_pad_index (element, templ, index);
     if (changed) {
       gst_tee_notify_alloc_pad (tee);
     }
@@ -447,6 +915,7 @@ static void
 gst_tee_release_pad (GstElement * element, GstPad * pad)
 {
   GstTee *tee;
+  GstPadTemplate *templ;
   gboolean changed = FALSE;
   guint index;
 
@@ -454,10 +923,14 @@ gst_tee_release_pad (GstElement * element, GstPad * pad)
 
   GST_DEBUG_OBJECT (tee, "releasing pad");
 
+  /* the pad might be gone after removing it, the template is owned by the
+   * class */
+  templ = GST_PAD_PAD_TEMPLATE (pad);
+
   GST_OBJECT_LOCK (tee);
   index = GST_TEE_PAD_CAST (pad)->index;
   /* mark the pad as removed so that future pad_alloc fails with NOT_LINKED. */
-  GST_TEE_PAD_CAST (pad)->removed = TRUE;
+  g_atomic_int_set (&GST_TEE_PAD_CAST (pad)->removed, TRUE);
   if (tee->allocpad == pad) {
     tee->allocpad = NULL;
     changed = TRUE;
@@ -467,13 +940,15 @@ gst_tee_release_pad (GstElement * element, GstPad * pad)
   gst_pad_set_active (pad, FALSE);
   gst_element_remove_pad (GST_ELEMENT_CAST (tee), pad);
 
+  GST_OBJECT_LOCK (tee);
+  gst_pad_array_cache_set (&tee->srcpads, GST_ELEMENT_CAST (tee)->srcpads);
+  GST_OBJECT_UNLOCK (tee);
+
   if (changed) {
     gst_tee_notify_alloc_pad (tee);
   }
 
-  GST_OBJECT_LOCK (tee);
-  g_hash_table_remove (tee->pad_indexes, GUINT_TO_POINTER (index));
-  GST_OBJECT_UNLOCK (tee);
+  gst_element_release_pad_index (element, templ, index);
 }
 
 static void
@@ -551,11 +1026,103 @@ gst_tee_get_property (GObject * object, guint prop_id, GValue * value,
   GST_OBJECT_UNLOCK (tee);
 }
 
+typedef struct
+{
+  GstEvent *event;
+  gboolean result;
+  gboolean dispatched;
+} GstTeeEventData;
+
+/* takes ownership of @event */
+static gboolean
+gst_tee_pad_queue_event (GstTeePad * pad, GstEvent * event)
+{
+  GstFlowReturn ret = g_atomic_int_get (&pad->srcresult);
+
+  if (ret == GST_FLOW_EOS && (GST_EVENT_TYPE (event) == GST_EVENT_STREAM_START
+          || GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)) {
+    GST_DEBUG_OBJECT (pad, "new stream after EOS, restarting branch thread");
+    g_atomic_int_set (&pad->srcresult, GST_FLOW_OK);
+    gst_pad_start_task (GST_PAD_CAST (pad), (GstTaskFunction) gst_tee_pad_loop,
+        pad, NULL);
+    ret = GST_FLOW_OK;
+  }
+
+  if (TEE_FLOW_IS_OK (ret)) {
+    gst_tee_pad_enqueue (pad, GST_MINI_OBJECT_CAST (event), FALSE);
+    return TRUE;
+  }
+
+  /* the branch is not running, only keep the sticky events around */
+  if (GST_EVENT_IS_STICKY (event) && GST_EVENT_TYPE (event) != GST_EVENT_EOS) {
+    gst_pad_store_sticky_event (GST_PAD_CAST (pad), event);
+    gst_event_unref (event);
+    return TRUE;
+  }
+
+  GST_DEBUG_OBJECT (pad, "dropping event %" GST_PTR_FORMAT ", branch is %s",
+      event, gst_flow_get_name (ret));
+  gst_event_unref (event);
+  return FALSE;
+}
+
+static gboolean
+gst_tee_forward_event (GstPad * srcpad, GstTeeEventData * data)
+{
+  GstTeePad *pad = GST_TEE_PAD_CAST (srcpad);
+  GstEvent *event = data->event;
+  gboolean res;
+
+  if (!pad->running) {
+    res = gst_pad_push_event (srcpad, gst_event_ref (event));
+  } else {
+    switch (GST_EVENT_TYPE (event)) {
+      case GST_EVENT_FLUSH_START:
+        /* unblock the branch thread first */
+        res = gst_pad_push_event (srcpad, gst_event_ref (event));
+        gst_tee_pad_set_flushing (pad, TRUE);
+        gst_pad_pause_task (srcpad);
+        break;
+      case GST_EVENT_FLUSH_STOP:
+        gst_tee_pad_flush_queue (pad);
+        res = gst_pad_push_event (srcpad, gst_event_ref (event));
+        gst_tee_pad_set_flushing (pad, FALSE);
+        gst_pad_start_task (srcpad, (GstTaskFunction) gst_tee_pad_loop, pad,
+            NULL);
+        break;
+      default:
+        if (GST_EVENT_IS_SERIALIZED (event))
+          res = gst_tee_pad_queue_event (pad, gst_event_ref (event));
+        else
+          res = gst_pad_push_event (srcpad, gst_event_ref (event));
+        break;
+    }
+  }
+
+  data->result |= res;
+  data->dispatched = TRUE;
+
+  /* don't stop */
+  return FALSE;
+}
+
 static gboolean
 gst_tee_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
+  GstTee *tee = GST_TEE_CAST (parent);
   gboolean res;
 
+  /* async branches queue the serialized events with their data */
+  if (g_atomic_int_get (&tee->n_async_pads) > 0) {
+    GstTeeEventData data = { event, FALSE, FALSE };
+
+    gst_pad_forward (pad, (GstPadForwardFunction) gst_tee_forward_event,
+        &data);
+    gst_event_unref (event);
+
+    return data.dispatched ? data.result : TRUE;
+  }
+
   switch (GST_EVENT_TYPE (event)) {
     default:
       res = gst_pad_event_default (pad, parent, event);
@@ -839,6 +1406,7 @@ gst_tee_do_message (GstTee * tee, GstPad * pad, gpointer data, gboolean is_list)
   g_object_notify_by_pspec ((GObject *) tee, pspec_last_message);
 }
 
+/* takes ownership of one reference of @data */
 static GstFlowReturn
 gst_tee_do_push (GstTee * tee, GstPad * pad, gpointer data, gboolean is_list)
 {
@@ -848,143 +1416,97 @@ gst_tee_do_push (GstTee * tee, GstPad * pad, gpointer data, gboolean is_list)
   if (pad == tee->pull_pad) {
     /* don't push on the pad we're pulling from */
     res = GST_FLOW_OK;
+    gst_mini_object_unref (GST_MINI_OBJECT_CAST (data));
+  } else if (GST_TEE_PAD_CAST (pad)->running) {
+    res = gst_tee_pad_enqueue (GST_TEE_PAD_CAST (pad),
+        GST_MINI_OBJECT_CAST (data), TRUE);
   } else if (is_list) {
-    res =
-        gst_pad_push_list (pad,
-        gst_buffer_list_ref (GST_BUFFER_LIST_CAST (data)));
+    res = gst_pad_push_list (pad, GST_BUFFER_LIST_CAST (data));
   } else {
-    res = gst_pad_push (pad, gst_buffer_ref (GST_BUFFER_CAST (data)));
+    res = gst_pad_push (pad, GST_BUFFER_CAST (data));
   }
   return res;
 }
 
-static void
-clear_pads (GstPad * pad, GstTee * tee)
-{
-  GST_TEE_PAD_CAST (pad)->pushed = FALSE;
-  GST_TEE_PAD_CAST (pad)->result = GST_FLOW_NOT_LINKED;
-}
-
 static GstFlowReturn
 gst_tee_handle_data (GstTee * tee, gpointer data, gboolean is_list)
 {
-  GList *pads;
-  guint32 cookie;
+  GstPadArray *pads;
   GstFlowReturn ret, cret;
+  guint i;
 
   if (G_UNLIKELY (!tee->silent))
     gst_tee_do_message (tee, tee->sinkpad, data, is_list);
 
-  GST_OBJECT_LOCK (tee);
-  pads = GST_ELEMENT_CAST (tee)->srcpads;
+  /* the snapshot keeps a ref on all pads, a pad probe might release and
+   * destroy a pad while we push */
+  pads = gst_pad_array_cache_get (&tee->srcpads, GST_OBJECT_CAST (tee));
 
   /* special case for zero pads */
-  if (G_UNLIKELY (!pads))
+  if (G_UNLIKELY (pads->n_pads == 0))
     goto no_pads;
 
   /* special case for just one pad that avoids reffing the buffer */
-  if (!pads->next) {
-    GstPad *pad = GST_PAD_CAST (pads->data);
-
-    /* Keep another ref around, a pad probe
-     * might release and destroy the pad */
-    gst_object_ref (pad);
-    GST_OBJECT_UNLOCK (tee);
+  if (pads->n_pads == 1) {
+    GstPad *pad = pads->pads[0];
 
-    if (pad == tee->pull_pad) {
-      ret = GST_FLOW_OK;
-    } else if (is_list) {
-      ret = gst_pad_push_list (pad, GST_BUFFER_LIST_CAST (data));
-    } else {
-      ret = gst_pad_push (pad, GST_BUFFER_CAST (data));
-    }
+    ret = gst_tee_do_push (tee, pad, data, is_list);
 
-    GST_OBJECT_LOCK (tee);
-    if (GST_TEE_PAD_CAST (pad)->removed)
+    if (g_atomic_int_get (&GST_TEE_PAD_CAST (pad)->removed))
       ret = GST_FLOW_NOT_LINKED;
 
     if (ret == GST_FLOW_NOT_LINKED && tee->allow_not_linked) {
       ret = GST_FLOW_OK;
     }
-    GST_OBJECT_UNLOCK (tee);
 
-    gst_object_unref (pad);
+    gst_pad_array_unref (pads);
 
     return ret;
   }
 
-  /* mark all pads as 'not pushed on yet' */
-  g_list_foreach (pads, (GFunc) clear_pads, tee);
-
-restart:
   if (tee->allow_not_linked) {
     cret = GST_FLOW_OK;
   } else {
     cret = GST_FLOW_NOT_LINKED;
   }
-  pads = GST_ELEMENT_CAST (tee)->srcpads;
-  cookie = GST_ELEMENT_CAST (tee)->pads_cookie;
 
-  while (pads) {
-    GstPad *pad;
+  /* take the references for all pads at once, every push consumes one and
+   * the last pad gets ours */
+  gst_mini_object_ref_n (GST_MINI_OBJECT_CAST (data), pads->n_pads - 1);
 
-    pad = GST_PAD_CAST (pads->data);
-
-    if (G_LIKELY (!GST_TEE_PAD_CAST (pad)->pushed)) {
-      /* not yet pushed, release lock and start pushing */
-      gst_object_ref (pad);
-      GST_OBJECT_UNLOCK (tee);
+  /* pads requested while we push only get the next buffer, pads released
+   * while we push are not-linked */
+  for (i = 0; i < pads->n_pads; i++) {
+    GstPad *pad = pads->pads[i];
 
-      GST_LOG_OBJECT (pad, "Starting to push %s %p",
-          is_list ? "list" : "buffer", data);
+    GST_LOG_OBJECT (pad, "Starting to push %s %p",
+        is_list ? "list" : "buffer", data);
 
-      ret = gst_tee_do_push (tee, pad, data, is_list);
+    ret = gst_tee_do_push (tee, pad, data, is_list);
 
-      GST_LOG_OBJECT (pad, "Pushing item %p yielded result %s", data,
-          gst_flow_get_name (ret));
-
-      GST_OBJECT_LOCK (tee);
-      /* keep track of which pad we pushed and the result value */
-      if (GST_TEE_PAD_CAST (pad)->removed)
-        ret = GST_FLOW_NOT_LINKED;
-      GST_TEE_PAD_CAST (pad)->pushed = TRUE;
-      GST_TEE_PAD_CAST (pad)->result = ret;
-      gst_object_unref (pad);
-      pad = NULL;
-    } else {
-      /* already pushed, use previous return value */
-      ret = GST_TEE_PAD_CAST (pad)->result;
-      GST_LOG_OBJECT (pad, "pad already pushed with %s",
-          gst_flow_get_name (ret));
-    }
+    GST_LOG_OBJECT (pad, "Pushing item %p yielded result %s", data,
+        gst_flow_get_name (ret));
 
-    /* before we go combining the return value, check if the pad list is still
-     * the same. It could be possible that the pad we just pushed was removed
-     * and the return value it not valid anymore */
-    if (G_UNLIKELY (GST_ELEMENT_CAST (tee)->pads_cookie != cookie)) {
-      GST_LOG_OBJECT (tee, "pad list changed");
-      /* the list of pads changed, restart iteration. Pads that we already
-       * pushed on and are still in the new list, will not be pushed on
-       * again. */
-      goto restart;
-    }
+    if (g_atomic_int_get (&GST_TEE_PAD_CAST (pad)->removed))
+      ret = GST_FLOW_NOT_LINKED;
 
     /* stop pushing more buffers when we have a fatal error */
-    if (G_UNLIKELY (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED))
+    if (G_UNLIKELY (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)) {
+      /* drop the references of the pads we don't push to */
+      gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (data),
+          pads->n_pads - 1 - i);
       goto error;
+    }
 
     /* keep all other return values, overwriting the previous one. */
     if (G_LIKELY (ret != GST_FLOW_NOT_LINKED)) {
       GST_LOG_OBJECT (tee, "Replacing ret val %d with %d", cret, ret);
       cret = ret;
     }
-    pads = g_list_next (pads);
   }
-  GST_OBJECT_UNLOCK (tee);
 
-  gst_mini_object_unref (GST_MINI_OBJECT_CAST (data));
+  gst_pad_array_unref (pads);
 
-  /* no need to unset gvalue */
   return cret;
 
   /* ERRORS */
@@ -1003,11 +1525,12 @@ no_pads:
 error:
   {
     GST_DEBUG_OBJECT (tee, "received error %s", gst_flow_get_name (ret));
-    goto end;
+    gst_pad_array_unref (pads);
+    return ret;
   }
 end:
   {
-    GST_OBJECT_UNLOCK (tee);
+    gst_pad_array_unref (pads);
     gst_mini_object_unref (GST_MINI_OBJECT_CAST (data));
     return ret;
   }
@@ -1127,6 +1650,23 @@ gst_tee_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
       GST_OBJECT_UNLOCK (tee);
       break;
     }
+    case GST_PAD_MODE_PUSH:
+    {
+      GstTeePad *tpad = GST_TEE_PAD_CAST (pad);
+
+      /* the pad is flushing already, so upstream can't stay blocked on the
+       * branch while we wait for it */
+      if ((active && tpad->async) || (!active && tpad->running)) {
+        GST_PAD_STREAM_LOCK (tee->sinkpad);
+        if (active)
+          gst_tee_pad_start (tee, tpad);
+        else
+          gst_tee_pad_stop (tee, tpad, FALSE);
+        GST_PAD_STREAM_UNLOCK (tee->sinkpad);
+      }
+      res = TRUE;
+      break;
+    }
     default:
       res = TRUE;
       break;
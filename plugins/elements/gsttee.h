@@ -26,6 +26,8 @@
 
 #include <gst/gst.h>
 
+#include "gstelements_private.h"
+
 G_BEGIN_DECLS
 
 
@@ -69,9 +71,6 @@ struct _GstTee {
   GstPad         *sinkpad;
   GstPad         *allocpad;
 
-  GHashTable     *pad_indexes;
-  guint           next_pad_index;
-
   gboolean        has_chain;
   gboolean        silent;
   gchar          *last_message;
@@ -81,6 +80,11 @@ struct _GstTee {
   GstPad         *pull_pad;
 
   gboolean        allow_not_linked;
+
+  /* snapshot of the srcpads for the streaming thread */
+  GstPadArrayCache srcpads;
+
+  gint            n_async_pads;
 };
 
 struct _GstTeeClass {
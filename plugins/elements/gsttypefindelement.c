@@ -102,6 +102,20 @@ GST_STATIC_PAD_TEMPLATE ("src",
 #define TYPE_FIND_MIN_SIZE   (2*1024)
 #define TYPE_FIND_MAX_SIZE (128*1024)
 
+#define DEFAULT_URI_CACHE FALSE
+
+/* types found for URIs, shared by all typefind elements with uri-cache */
+typedef struct
+{
+  GstCaps *caps;
+  guint probability;
+} UriCacheEntry;
+
+#define URI_CACHE_MAX_SIZE 256
+
+static GMutex uri_cache_lock;
+static GHashTable *uri_cache;
+
 /* TypeFind signals and args */
 enum
 {
@@ -114,6 +128,7 @@ enum
   PROP_CAPS,
   PROP_MINIMUM,
   PROP_FORCE_CAPS,
+  PROP_URI_CACHE,
   PROP_LAST
 };
 enum
@@ -169,6 +184,7 @@ static void gst_type_find_element_send_cached_events (GstTypeFindElement *
     typefind);
 
 static void gst_type_find_element_loop (GstPad * pad);
+static void reset_typefinding_state (GstTypeFindElement * typefind);
 
 static guint gst_type_find_element_signals[LAST_SIGNAL] = { 0 };
 
@@ -263,6 +279,20 @@ gst_type_find_element_class_init (GstTypeFindElementClass * typefind_class)
       g_param_spec_boxed ("force-caps", _("force caps"),
           _("force caps without doing a typefind"), GST_TYPE_CAPS,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstTypeFindElement:uri-cache:
+   *
+   * Remember the type found for the URI of a stream, and use it for later
+   * streams with the same URI instead of typefinding them again. Only enable
+   * this when the content behind a URI doesn't change, like for local files
+   * that are opened over and over.
+   *
+   * Since: 1.20
+   */
+  g_object_class_install_property (gobject_class, PROP_URI_CACHE,
+      g_param_spec_boolean ("uri-cache", "URI cache",
+          "Reuse the type found for a URI for later streams from that URI",
+          DEFAULT_URI_CACHE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   /**
    * GstTypeFindElement::have-type:
    * @typefind: the typefind instance
@@ -332,6 +362,7 @@ gst_type_find_element_init (GstTypeFindElement * typefind)
   typefind->mode = MODE_TYPEFIND;
   typefind->caps = NULL;
   typefind->min_probability = 1;
+  typefind->uri_cache = DEFAULT_URI_CACHE;
 
   typefind->adapter = gst_adapter_new ();
 }
@@ -343,6 +374,7 @@ gst_type_find_element_dispose (GObject * object)
 
   gst_clear_object (&typefind->adapter);
   gst_clear_caps (&typefind->force_caps);
+  reset_typefinding_state (typefind);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
@@ -364,6 +396,11 @@ gst_type_find_element_set_property (GObject * object, guint prop_id,
       gst_caps_take (&typefind->force_caps, g_value_dup_boxed (value));
       GST_OBJECT_UNLOCK (typefind);
       break;
+    case PROP_URI_CACHE:
+      GST_OBJECT_LOCK (typefind);
+      typefind->uri_cache = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (typefind);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -392,6 +429,11 @@ gst_type_find_element_get_property (GObject * object, guint prop_id,
       g_value_set_boxed (value, typefind->force_caps);
       GST_OBJECT_UNLOCK (typefind);
       break;
+    case PROP_URI_CACHE:
+      GST_OBJECT_LOCK (typefind);
+      g_value_set_boolean (value, typefind->uri_cache);
+      GST_OBJECT_UNLOCK (typefind);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -582,6 +624,7 @@ start_typefinding (GstTypeFindElement * typefind)
   if (typefind->caps)
     gst_caps_replace (&typefind->caps, NULL);
   typefind->initial_offset = GST_BUFFER_OFFSET_NONE;
+  reset_typefinding_state (typefind);
   GST_OBJECT_UNLOCK (typefind);
 
   typefind->mode = MODE_TYPEFIND;
@@ -608,6 +651,7 @@ stop_typefinding (GstTypeFindElement * typefind)
     gst_type_find_element_send_cached_events (typefind);
 
   GST_OBJECT_LOCK (typefind);
+  reset_typefinding_state (typefind);
   avail = gst_adapter_available (typefind->adapter);
   if (avail == 0)
     goto no_data;
@@ -719,6 +763,9 @@ gst_type_find_element_sink_event (GstPad * pad, GstObject * parent,
           g_list_free (typefind->cached_events);
           typefind->cached_events = NULL;
           gst_adapter_clear (typefind->adapter);
+          /* the data typefind functions were excluded for is gone */
+          gst_plugin_feature_list_free (typefind->excluded);
+          typefind->excluded = NULL;
           GST_OBJECT_UNLOCK (typefind);
           /* fall through */
         }
@@ -796,21 +843,104 @@ gst_type_find_element_setcaps (GstTypeFindElement * typefind, GstCaps * caps)
   return TRUE;
 }
 
+static void
+reset_typefinding_state (GstTypeFindElement * typefind)
+{
+  gst_plugin_feature_list_free (typefind->excluded);
+  typefind->excluded = NULL;
+  g_free (typefind->uri);
+  typefind->uri = NULL;
+  typefind->have_uri = FALSE;
+}
+
+/* queries the uri of the stream once for every typefinding */
+static const gchar *
+gst_type_find_get_uri (GstTypeFindElement * typefind, GstPad * pad)
+{
+  GstQuery *query;
+
+  if (typefind->have_uri)
+    return typefind->uri;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (pad, query))
+    gst_query_parse_uri (query, &typefind->uri);
+  else
+    GST_INFO_OBJECT (typefind, "failed to query peer uri");
+  gst_query_unref (query);
+
+  typefind->have_uri = TRUE;
+
+  return typefind->uri;
+}
+
+static GstCaps *
+uri_cache_lookup (GstTypeFindElement * typefind, GstPad * pad,
+    GstTypeFindProbability * probability)
+{
+  UriCacheEntry *entry;
+  const gchar *uri;
+  GstCaps *caps = NULL;
+
+  if (!typefind->uri_cache || !(uri = gst_type_find_get_uri (typefind, pad)))
+    return NULL;
+
+  g_mutex_lock (&uri_cache_lock);
+  if (uri_cache && (entry = g_hash_table_lookup (uri_cache, uri))) {
+    caps = gst_caps_ref (entry->caps);
+    *probability = entry->probability;
+  }
+  g_mutex_unlock (&uri_cache_lock);
+
+  if (caps)
+    GST_DEBUG_OBJECT (typefind, "Skipping typefinding, using caps %"
+        GST_PTR_FORMAT " found before for %s", caps, uri);
+
+  return caps;
+}
+
+static void
+uri_cache_entry_free (UriCacheEntry * entry)
+{
+  gst_caps_unref (entry->caps);
+  g_slice_free (UriCacheEntry, entry);
+}
+
+static void
+uri_cache_store (GstTypeFindElement * typefind, GstPad * pad,
+    GstTypeFindProbability probability, GstCaps * caps)
+{
+  UriCacheEntry *entry;
+  const gchar *uri;
+
+  if (!typefind->uri_cache || !(uri = gst_type_find_get_uri (typefind, pad)))
+    return;
+
+  entry = g_slice_new (UriCacheEntry);
+  entry->caps = gst_caps_ref (caps);
+  entry->probability = probability;
+
+  g_mutex_lock (&uri_cache_lock);
+  if (uri_cache == NULL)
+    uri_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+        (GDestroyNotify) uri_cache_entry_free);
+  /* start over instead of tracking which entries are still in use */
+  if (g_hash_table_size (uri_cache) >= URI_CACHE_MAX_SIZE)
+    g_hash_table_remove_all (uri_cache);
+  g_hash_table_insert (uri_cache, g_strdup (uri), entry);
+  g_mutex_unlock (&uri_cache_lock);
+}
+
 static gchar *
 gst_type_find_get_extension (GstTypeFindElement * typefind, GstPad * pad)
 {
-  GstQuery *query;
-  gchar *uri, *result;
+  const gchar *uri;
+  gchar *result;
   size_t len;
   gint find;
 
-  query = gst_query_new_uri ();
-
   /* try getting the caps with an uri query and from the extension */
-  if (!gst_pad_peer_query (pad, query))
-    goto peer_query_failed;
-
-  gst_query_parse_uri (query, &uri);
+  uri = gst_type_find_get_uri (typefind, pad);
   if (uri == NULL)
     goto no_uri;
 
@@ -831,29 +961,18 @@ gst_type_find_get_extension (GstTypeFindElement * typefind, GstPad * pad)
   result = g_strdup (&uri[find + 1]);
 
   GST_DEBUG_OBJECT (typefind, "found extension %s", result);
-  gst_query_unref (query);
-  g_free (uri);
 
   return result;
 
   /* ERRORS */
-peer_query_failed:
-  {
-    GST_INFO_OBJECT (typefind, "failed to query peer uri");
-    gst_query_unref (query);
-    return NULL;
-  }
 no_uri:
   {
     GST_INFO_OBJECT (typefind, "could not parse the peer uri");
-    gst_query_unref (query);
     return NULL;
   }
 no_extension:
   {
     GST_INFO_OBJECT (typefind, "could not find uri extension in %s", uri);
-    gst_query_unref (query);
-    g_free (uri);
     return NULL;
   }
 }
@@ -934,6 +1053,8 @@ gst_type_find_element_chain_do_typefinding (GstTypeFindElement * typefind,
   if (typefind->force_caps) {
     caps = gst_caps_ref (typefind->force_caps);
     probability = GST_TYPE_FIND_MAXIMUM;
+  } else {
+    caps = uri_cache_lookup (typefind, typefind->sink, &probability);
   }
 
   if (!caps) {
@@ -953,8 +1074,10 @@ gst_type_find_element_chain_do_typefinding (GstTypeFindElement * typefind,
     ext = gst_type_find_get_extension (typefind, typefind->sink);
     /* map all available data */
     data = gst_adapter_map (typefind->adapter, avail);
-    caps = gst_type_find_helper_for_data_with_extension (GST_OBJECT (typefind),
-        data, avail, ext, &probability);
+    /* the adapter only grows while typefinding, typefind functions that
+     * ruled out a shorter prefix of the data don't need to run again */
+    caps = gst_type_find_helper_for_data_incremental (GST_OBJECT (typefind),
+        data, avail, ext, &typefind->excluded, &probability);
     gst_adapter_unmap (typefind->adapter);
     g_free (ext);
 
@@ -966,6 +1089,8 @@ gst_type_find_element_chain_do_typefinding (GstTypeFindElement * typefind,
     /* found a type */
     if (probability < typefind->min_probability)
       goto low_probability;
+
+    uri_cache_store (typefind, typefind->sink, probability, caps);
   }
 
   GST_OBJECT_UNLOCK (typefind);
@@ -1109,6 +1234,8 @@ gst_type_find_element_loop (GstPad * pad)
     if (typefind->force_caps) {
       found_caps = gst_caps_ref (typefind->force_caps);
       probability = GST_TYPE_FIND_MAXIMUM;
+    } else {
+      found_caps = uri_cache_lookup (typefind, pad, &probability);
     }
     GST_OBJECT_UNLOCK (typefind);
 
@@ -1150,6 +1277,9 @@ gst_type_find_element_loop (GstPad * pad)
 
         if (ret != GST_FLOW_OK)
           goto pause;
+
+        if (found_caps && probability >= typefind->min_probability)
+          uri_cache_store (typefind, pad, probability, found_caps);
       }
     }
 
@@ -1341,6 +1471,7 @@ gst_type_find_element_change_state (GstElement * element,
       g_list_free (typefind->cached_events);
       typefind->cached_events = NULL;
       typefind->mode = MODE_TYPEFIND;
+      reset_typefinding_state (typefind);
       GST_OBJECT_UNLOCK (typefind);
       break;
     default:
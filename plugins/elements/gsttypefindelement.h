@@ -57,6 +57,12 @@ struct _GstTypeFindElement {
 
   GList *               cached_events;
   GstCaps *             force_caps;
+  gboolean              uri_cache;
+
+  /* state of the current typefinding */
+  GList *               excluded;
+  gchar *               uri;
+  gboolean              have_uri;
 
   guint64		initial_offset;
   
@@ -92,6 +92,12 @@ static void gst_valve_get_property (GObject * object,
 
 static GstFlowReturn gst_valve_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_valve_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list);
+static GstFlowReturn gst_valve_drop_chain (GstPad * pad, GstObject * parent,
+    GstBuffer * buffer);
+static GstFlowReturn gst_valve_drop_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_valve_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_valve_query (GstPad * pad, GstObject * parent,
@@ -159,8 +165,12 @@ gst_valve_init (GstValve * valve)
   gst_element_add_pad (GST_ELEMENT (valve), valve->srcpad);
 
   valve->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
+  GST_DEBUG_REGISTER_FUNCPTR (gst_valve_drop_chain);
+  GST_DEBUG_REGISTER_FUNCPTR (gst_valve_drop_chain_list);
   gst_pad_set_chain_function (valve->sinkpad,
       GST_DEBUG_FUNCPTR (gst_valve_chain));
+  gst_pad_set_chain_list_function (valve->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_valve_chain_list));
   gst_pad_set_event_function (valve->sinkpad,
       GST_DEBUG_FUNCPTR (gst_valve_sink_event));
   gst_pad_set_query_function (valve->sinkpad,
@@ -170,6 +180,21 @@ gst_valve_init (GstValve * valve)
   gst_element_add_pad (GST_ELEMENT (valve), valve->sinkpad);
 }
 
+/* While dropping, the sinkpad gets chain functions that only discard the
+ * data, so the dropping side does not need to check the drop flag for every
+ * buffer. Must be called with the object lock. */
+static void
+gst_valve_set_chain_functions (GstValve * valve, gboolean drop)
+{
+  if (drop) {
+    gst_pad_set_chain_function (valve->sinkpad, gst_valve_drop_chain);
+    gst_pad_set_chain_list_function (valve->sinkpad,
+        gst_valve_drop_chain_list);
+  } else {
+    gst_pad_set_chain_function (valve->sinkpad, gst_valve_chain);
+    gst_pad_set_chain_list_function (valve->sinkpad, gst_valve_chain_list);
+  }
+}
 
 static void
 gst_valve_set_property (GObject * object,
@@ -178,10 +203,16 @@ gst_valve_set_property (GObject * object,
   GstValve *valve = GST_VALVE (object);
 
   switch (prop_id) {
-    case PROP_DROP:
-      g_atomic_int_set (&valve->drop, g_value_get_boolean (value));
+    case PROP_DROP:{
+      gboolean drop = g_value_get_boolean (value);
+
+      GST_OBJECT_LOCK (valve);
+      g_atomic_int_set (&valve->drop, drop);
+      gst_valve_set_chain_functions (valve, drop);
+      GST_OBJECT_UNLOCK (valve);
       gst_pad_push_event (valve->sinkpad, gst_event_new_reconfigure ());
       break;
+    }
     case PROP_DROP_MODE:
       valve->drop_mode = g_value_get_enum (value);
       break;
@@ -215,6 +246,17 @@ static gboolean
 forward_sticky_events (GstPad * pad, GstEvent ** event, gpointer user_data)
 {
   GstValve *valve = user_data;
+  GstEvent *current;
+
+  /* only send what changed while we were dropping, the other sticky events
+   * are still current on the srcpad */
+  current = gst_pad_get_sticky_event (valve->srcpad, GST_EVENT_TYPE (*event),
+      0);
+  if (current) {
+    gst_event_unref (current);
+    if (current == *event)
+      return TRUE;
+  }
 
   if (!gst_pad_push_event (valve->srcpad, gst_event_ref (*event)))
     valve->need_repush_sticky = TRUE;
@@ -233,29 +275,74 @@ static GstFlowReturn
 gst_valve_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstValve *valve = GST_VALVE (parent);
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstFlowReturn ret;
 
-  if (g_atomic_int_get (&valve->drop)) {
-    if (valve->drop_mode == GST_VALVE_DROP_MODE_TRANSFORM_TO_GAP) {
-      GstEvent *ev = gst_event_new_gap (GST_BUFFER_PTS (buffer),
-          GST_BUFFER_DURATION (buffer));
-      gst_pad_push_event (valve->srcpad, ev);
-    }
-    gst_buffer_unref (buffer);
-    valve->discont = TRUE;
-  } else {
-    if (valve->discont) {
-      buffer = gst_buffer_make_writable (buffer);
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-      valve->discont = FALSE;
-    }
+  if (valve->discont) {
+    buffer = gst_buffer_make_writable (buffer);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    valve->discont = FALSE;
+  }
 
-    if (valve->need_repush_sticky)
-      gst_valve_repush_sticky (valve);
+  if (valve->need_repush_sticky)
+    gst_valve_repush_sticky (valve);
+
+  ret = gst_pad_push (valve->srcpad, buffer);
+
+  /* Ignore errors if "drop" was changed while the thread was blocked
+   * downwards
+   */
+  if (g_atomic_int_get (&valve->drop))
+    ret = GST_FLOW_OK;
 
-    ret = gst_pad_push (valve->srcpad, buffer);
+  return ret;
+}
+
+static GstFlowReturn
+gst_valve_drop_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstValve *valve = GST_VALVE (parent);
+
+  if (valve->drop_mode == GST_VALVE_DROP_MODE_TRANSFORM_TO_GAP) {
+    GstEvent *ev = gst_event_new_gap (GST_BUFFER_PTS (buffer),
+        GST_BUFFER_DURATION (buffer));
+    gst_pad_push_event (valve->srcpad, ev);
+  }
+  gst_buffer_unref (buffer);
+  valve->discont = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+push_gap_for_buffer (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  GstValve *valve = user_data;
+
+  gst_pad_push_event (valve->srcpad, gst_event_new_gap (GST_BUFFER_PTS
+          (*buffer), GST_BUFFER_DURATION (*buffer)));
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_valve_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstValve *valve = GST_VALVE (parent);
+  GstFlowReturn ret;
+
+  if (valve->discont && gst_buffer_list_length (list) > 0) {
+    GstBuffer *buffer;
+
+    list = gst_buffer_list_make_writable (list);
+    buffer = gst_buffer_list_get_writable (list, 0);
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    valve->discont = FALSE;
   }
 
+  if (valve->need_repush_sticky)
+    gst_valve_repush_sticky (valve);
+
+  ret = gst_pad_push_list (valve->srcpad, list);
 
   /* Ignore errors if "drop" was changed while the thread was blocked
    * downwards
@@ -266,6 +353,20 @@ gst_valve_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   return ret;
 }
 
+static GstFlowReturn
+gst_valve_drop_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstValve *valve = GST_VALVE (parent);
+
+  if (valve->drop_mode == GST_VALVE_DROP_MODE_TRANSFORM_TO_GAP)
+    gst_buffer_list_foreach (list, push_gap_for_buffer, valve);
+  gst_buffer_list_unref (list);
+  valve->discont = TRUE;
+
+  return GST_FLOW_OK;
+}
+
 static inline gboolean
 gst_valve_event_needs_dropping (GstValve * valve, GstEvent * event)
 {
@@ -0,0 +1,638 @@
+/* GStreamer
+ *
+ * gstelementtime.c: tracing module that logs the time spent in elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-elementtime
+ * @short_description: log the time spent in each element
+ *
+ * A tracing module that measures the exclusive wall-clock and CPU time spent
+ * in the chain, getrange and event functions of each element, and in the
+ * loop functions of the streaming threads. The time spent in downstream
+ * pushes (or upstream pulls) is subtracted, so elements sharing a streaming
+ * thread can be told apart. For queue, queue2 and multiqueue it also
+ * measures how long the buffers waited in the queue.
+ *
+ * The values are logged as histograms with power of two buckets: bucket 0
+ * counts the calls below 2µs, bucket i the ones from 2^i to 2^(i+1) µs. The
+ * histograms are cumulative, every 'period' milliseconds (default 1000, 0 to
+ * only log when the tracer is shut down) one element-time record is logged
+ * for every element that was active.
+ *
+ * ```
+ * GST_TRACERS="elementtime(period=5000)" GST_TRACER_RECORD_FILE=trace.bin ./...
+ * ```
+ *
+ * The wall-clock time of loop functions includes the time spent blocking,
+ * e.g. in a queue waiting for data. CPU times are only available where
+ * per-thread CPU clocks are.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstelementtime.h"
+
+#include <string.h>
+#include <time.h>
+
+GST_DEBUG_CATEGORY_STATIC (gst_element_time_debug);
+#define GST_CAT_DEFAULT gst_element_time_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_element_time_debug, "elementtime", 0, \
+        "element time tracer");
+#define gst_element_time_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstElementTimeTracer, gst_element_time_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+#define DEFAULT_PERIOD (1000 * GST_MSECOND)
+
+/* 1µs to ~8s */
+#define N_BUCKETS 24
+
+/* bound for buffers that were dropped in a queue without being seen again */
+#define MAX_QUEUED 65536
+
+static GQuark stats_quark;
+static GstTracerRecord *tr_element_time;
+
+typedef struct
+{
+  guint64 count;
+  GstClockTime total;
+  guint64 buckets[N_BUCKETS];
+} Histogram;
+
+typedef struct
+{
+  GMutex lock;
+  gchar *id;
+  gchar *name;
+  gboolean active;
+
+  Histogram wall;
+  Histogram cpu;
+
+  /* for queues, the buffers or lists in the queue and when they entered, in
+   * microseconds modulo 2^32 to fit into a pointer everywhere */
+  gboolean is_queue;
+  GHashTable *queued;
+  Histogram queue_wait;
+} ElementTimeStats;
+
+typedef struct
+{
+  /* NULL if the time is not accounted to an element, e.g. for bins */
+  ElementTimeStats *stats;
+  GstClockTime wall_start;
+  GstClockTime cpu_start;
+  /* spent in nested pushes */
+  GstClockTime child_wall;
+  GstClockTime child_cpu;
+} Frame;
+
+typedef struct
+{
+  GArray *frames;
+  /* when the outermost push returned, for the time spent in the loop
+   * function of the thread */
+  GstClockTime idle_wall;
+  GstClockTime idle_cpu;
+} ThreadState;
+
+static void
+thread_state_free (ThreadState * state)
+{
+  g_array_free (state->frames, TRUE);
+  g_free (state);
+}
+
+static GPrivate thread_state_key =
+G_PRIVATE_INIT ((GDestroyNotify) thread_state_free);
+
+/* data helpers */
+
+static GstClockTime
+thread_cpu_time (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return GST_TIMESPEC_TO_TIME (ts);
+#endif
+  return 0;
+}
+
+static ThreadState *
+get_thread_state (void)
+{
+  ThreadState *state = g_private_get (&thread_state_key);
+
+  if (G_UNLIKELY (!state)) {
+    state = g_new0 (ThreadState, 1);
+    state->frames = g_array_sized_new (FALSE, FALSE, sizeof (Frame), 16);
+    state->idle_wall = GST_CLOCK_TIME_NONE;
+    g_private_set (&thread_state_key, state);
+  }
+  return state;
+}
+
+static void
+histogram_add (Histogram * h, GstClockTime value)
+{
+  guint64 us = value / GST_USECOND;
+  gint bucket = us < 2 ? 0 : g_bit_nth_msf (us, -1);
+
+  h->count++;
+  h->total += value;
+  h->buckets[MIN (bucket, N_BUCKETS - 1)]++;
+}
+
+static gchar *
+histogram_to_string (const Histogram * h)
+{
+  GString *s = g_string_sized_new (N_BUCKETS * 4);
+  guint i;
+
+  for (i = 0; i < N_BUCKETS; i++)
+    g_string_append_printf (s, i ? ",%" G_GUINT64_FORMAT : "%"
+        G_GUINT64_FORMAT, h->buckets[i]);
+
+  return g_string_free (s, FALSE);
+}
+
+static gboolean
+is_queue (GstElement * element)
+{
+  GstElementFactory *factory = gst_element_get_factory (element);
+  const gchar *name;
+
+  if (!factory)
+    return FALSE;
+
+  name = GST_OBJECT_NAME (factory);
+  return !g_strcmp0 (name, "queue") || !g_strcmp0 (name, "queue2") ||
+      !g_strcmp0 (name, "multiqueue");
+}
+
+static void
+free_element_stats (ElementTimeStats * stats)
+{
+  g_mutex_clear (&stats->lock);
+  g_free (stats->id);
+  g_free (stats->name);
+  if (stats->queued)
+    g_hash_table_unref (stats->queued);
+  g_free (stats);
+}
+
+/* the element of @pad, NULL for pads of bins. For proxy pads, the element
+ * of the ghost pad */
+static ElementTimeStats *
+get_element_stats (GstElementTimeTracer * self, GstPad * pad)
+{
+  GstObject *parent;
+  GstElement *element;
+  ElementTimeStats *stats;
+
+  if (!pad || !(parent = GST_OBJECT_PARENT (pad)))
+    return NULL;
+  if (GST_IS_PAD (parent) && !(parent = GST_OBJECT_PARENT (parent)))
+    return NULL;
+  if (!GST_IS_ELEMENT (parent) || GST_IS_BIN (parent))
+    return NULL;
+
+  element = GST_ELEMENT_CAST (parent);
+  stats = g_object_get_qdata ((GObject *) element, stats_quark);
+  if (G_LIKELY (stats))
+    return stats;
+
+  g_mutex_lock (&self->lock);
+  stats = g_object_get_qdata ((GObject *) element, stats_quark);
+  if (!stats) {
+    stats = g_new0 (ElementTimeStats, 1);
+    g_mutex_init (&stats->lock);
+    stats->id = g_strdup_printf ("%p", element);
+    stats->name = gst_element_get_name (element);
+    stats->is_queue = is_queue (element);
+    if (stats->is_queue)
+      stats->queued = g_hash_table_new (NULL, NULL);
+    /* owned by the tracer, elements can go away before it is reported */
+    g_object_set_qdata ((GObject *) element, stats_quark, stats);
+    g_ptr_array_add (self->elements, stats);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return stats;
+}
+
+static void
+add_sample (ElementTimeStats * stats, GstClockTime wall, GstClockTime cpu)
+{
+  g_mutex_lock (&stats->lock);
+  histogram_add (&stats->wall, wall);
+  histogram_add (&stats->cpu, cpu);
+  stats->active = TRUE;
+  g_mutex_unlock (&stats->lock);
+}
+
+static void
+log_element_stats (ElementTimeStats * stats, GstClockTime ts)
+{
+  gchar *wall, *cpu, *queue_wait;
+  Histogram h_wall, h_cpu, h_queue_wait;
+
+  g_mutex_lock (&stats->lock);
+  if (!stats->active) {
+    g_mutex_unlock (&stats->lock);
+    return;
+  }
+  stats->active = FALSE;
+  h_wall = stats->wall;
+  h_cpu = stats->cpu;
+  h_queue_wait = stats->queue_wait;
+  g_mutex_unlock (&stats->lock);
+
+  wall = histogram_to_string (&h_wall);
+  cpu = histogram_to_string (&h_cpu);
+  queue_wait = histogram_to_string (&h_queue_wait);
+
+  gst_tracer_record_log (tr_element_time, stats->id, stats->name,
+      h_wall.count, h_wall.total, wall, h_cpu.total, cpu, h_queue_wait.count,
+      h_queue_wait.total, queue_wait, ts);
+
+  g_free (wall);
+  g_free (cpu);
+  g_free (queue_wait);
+}
+
+static void
+log_stats (GstElementTimeTracer * self, GstClockTime ts)
+{
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  for (i = 0; i < self->elements->len; i++)
+    log_element_stats (g_ptr_array_index (self->elements, i), ts);
+  g_mutex_unlock (&self->lock);
+}
+
+static gboolean
+maybe_log_stats (GstElementTimeTracer * self, GstClockTime ts)
+{
+  if (self->period == 0 || ts < self->next_report)
+    return FALSE;
+
+  g_mutex_lock (&self->lock);
+  if (ts < self->next_report) {
+    g_mutex_unlock (&self->lock);
+    return FALSE;
+  }
+  if (self->next_report == 0) {
+    /* first call, report one period from now */
+    self->next_report = ts + self->period;
+    g_mutex_unlock (&self->lock);
+    return FALSE;
+  }
+  self->next_report = ts + self->period;
+  g_mutex_unlock (&self->lock);
+
+  log_stats (self, ts);
+  return TRUE;
+}
+
+/* Called when @pad pushes @object into the peer element, or pulls from
+ * it, the time until leave() is accounted to the peer */
+static void
+enter (GstElementTimeTracer * self, guint64 ts, GstPad * pad)
+{
+  ThreadState *state = get_thread_state ();
+  GstClockTime cpu = thread_cpu_time ();
+  Frame frame;
+
+  if (state->frames->len == 0 && GST_CLOCK_TIME_IS_VALID (state->idle_wall)) {
+    /* the time since the last push was in the loop function */
+    ElementTimeStats *stats = get_element_stats (self, pad);
+
+    if (stats)
+      add_sample (stats, GST_CLOCK_DIFF (state->idle_wall, ts),
+          GST_CLOCK_DIFF (state->idle_cpu, cpu));
+  }
+
+  frame.stats = get_element_stats (self, GST_PAD_PEER (pad));
+  frame.wall_start = ts;
+  frame.cpu_start = cpu;
+  frame.child_wall = 0;
+  frame.child_cpu = 0;
+  g_array_append_val (state->frames, frame);
+}
+
+static void
+leave (GstElementTimeTracer * self, guint64 ts)
+{
+  ThreadState *state = get_thread_state ();
+  GstClockTime cpu = thread_cpu_time ();
+  GstClockTime wall_total, cpu_total;
+  Frame *frame;
+
+  /* the tracer was added while pushing */
+  if (G_UNLIKELY (state->frames->len == 0))
+    return;
+
+  frame = &g_array_index (state->frames, Frame, state->frames->len - 1);
+  wall_total = GST_CLOCK_DIFF (frame->wall_start, ts);
+  cpu_total = GST_CLOCK_DIFF (frame->cpu_start, cpu);
+  if (frame->stats)
+    add_sample (frame->stats, wall_total - MIN (frame->child_wall, wall_total),
+        cpu_total - MIN (frame->child_cpu, cpu_total));
+  g_array_set_size (state->frames, state->frames->len - 1);
+
+  if (state->frames->len > 0) {
+    frame = &g_array_index (state->frames, Frame, state->frames->len - 1);
+    frame->child_wall += wall_total;
+    frame->child_cpu += cpu_total;
+  } else {
+    GstClockTime start = gst_util_get_timestamp ();
+
+    self->last_ts = ts;
+    if (maybe_log_stats (self, ts)) {
+      /* don't account the logging to the loop function */
+      ts += gst_util_get_timestamp () - start;
+      cpu = thread_cpu_time ();
+    }
+    state->idle_wall = ts;
+    state->idle_cpu = cpu;
+  }
+}
+
+static void
+queue_enter (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    gpointer object)
+{
+  ElementTimeStats *stats = get_element_stats (self, GST_PAD_PEER (pad));
+
+  if (!stats || !stats->is_queue)
+    return;
+
+  g_mutex_lock (&stats->lock);
+  if (g_hash_table_size (stats->queued) >= MAX_QUEUED)
+    g_hash_table_remove_all (stats->queued);
+  g_hash_table_insert (stats->queued, object,
+      GUINT_TO_POINTER ((guint32) (ts / GST_USECOND)));
+  g_mutex_unlock (&stats->lock);
+}
+
+static void
+queue_leave (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    gpointer object)
+{
+  ElementTimeStats *stats = get_element_stats (self, pad);
+  gpointer enter_ts;
+
+  if (!stats || !stats->is_queue)
+    return;
+
+  g_mutex_lock (&stats->lock);
+  if (g_hash_table_lookup_extended (stats->queued, object, NULL, &enter_ts)) {
+    guint32 wait = (guint32) (ts / GST_USECOND) - GPOINTER_TO_UINT (enter_ts);
+
+    g_hash_table_remove (stats->queued, object);
+    histogram_add (&stats->queue_wait, wait * GST_USECOND);
+    stats->active = TRUE;
+  }
+  g_mutex_unlock (&stats->lock);
+}
+
+/* hooks */
+
+static void
+do_push_buffer_pre (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    GstMiniObject * object)
+{
+  queue_leave (self, ts, pad, object);
+  queue_enter (self, ts, pad, object);
+  enter (self, ts, pad);
+}
+
+static void
+do_push_buffer_post (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    GstFlowReturn res)
+{
+  leave (self, ts);
+}
+
+static void
+do_pull_range_pre (GstElementTimeTracer * self, guint64 ts, GstPad * pad)
+{
+  enter (self, ts, pad);
+}
+
+static void
+do_pull_range_post (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    GstBuffer * buffer)
+{
+  leave (self, ts);
+}
+
+static void
+do_push_event_pre (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    ElementTimeStats *stats = get_element_stats (self, GST_PAD_PEER (pad));
+
+    /* the queued buffers were dropped */
+    if (stats && stats->is_queue) {
+      g_mutex_lock (&stats->lock);
+      g_hash_table_remove_all (stats->queued);
+      g_mutex_unlock (&stats->lock);
+    }
+  }
+  enter (self, ts, pad);
+}
+
+static void
+do_push_event_post (GstElementTimeTracer * self, guint64 ts, GstPad * pad,
+    gboolean res)
+{
+  leave (self, ts);
+}
+
+/* tracer class */
+
+static void
+gst_element_time_tracer_constructed (GObject * object)
+{
+  GstElementTimeTracer *self = GST_ELEMENT_TIME_TRACER (object);
+  gchar *params, *tmp;
+  GstStructure *params_struct = NULL;
+  const gchar *name;
+  gint period;
+
+  g_object_get (self, "params", &params, NULL);
+
+  if (!params)
+    return;
+
+  tmp = g_strdup_printf ("elementtime,%s", params);
+  params_struct = gst_structure_from_string (tmp, NULL);
+  g_free (tmp);
+  g_free (params);
+  if (!params_struct)
+    return;
+
+  /* Set the name if assigned */
+  name = gst_structure_get_string (params_struct, "name");
+  if (name)
+    gst_object_set_name (GST_OBJECT (self), name);
+
+  if (gst_structure_get_int (params_struct, "period", &period)) {
+    if (period >= 0)
+      self->period = period * GST_MSECOND;
+    else
+      GST_WARNING_OBJECT (self, "Invalid period %d", period);
+  }
+  gst_structure_free (params_struct);
+}
+
+static void
+gst_element_time_tracer_finalize (GObject * object)
+{
+  GstElementTimeTracer *self = GST_ELEMENT_TIME_TRACER (object);
+
+  /* final report */
+  log_stats (self, self->last_ts);
+
+  g_ptr_array_free (self->elements, TRUE);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_element_time_tracer_class_init (GstElementTimeTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_element_time_tracer_constructed;
+  gobject_class->finalize = gst_element_time_tracer_finalize;
+
+  stats_quark = g_quark_from_static_string ("elementtime:stats");
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_element_time = gst_tracer_record_new ("element-time.class",
+      "element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of calls measured",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "wall", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "exclusive wall-clock time spent in the element in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "wall-histogram", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "calls per power of two microsecond bucket of wall-clock time",
+          NULL),
+      "cpu", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "exclusive CPU time spent in the element in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "cpu-histogram", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "calls per power of two microsecond bucket of CPU time",
+          NULL),
+      "queue-count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "number of buffers that went through the queue",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "queue-wait", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "time the buffers spent waiting in the queue in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "queue-histogram", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "buffers per power of two microsecond bucket of queue wait time",
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the stats have been logged",
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_element_time, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_element_time_tracer_init (GstElementTimeTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->elements =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) free_element_stats);
+  self->period = DEFAULT_PERIOD;
+
+  gst_tracing_register_hook (tracer, "pad-push-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-push-post",
+      G_CALLBACK (do_push_buffer_post));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-post",
+      G_CALLBACK (do_push_buffer_post));
+  gst_tracing_register_hook (tracer, "pad-pull-range-pre",
+      G_CALLBACK (do_pull_range_pre));
+  gst_tracing_register_hook (tracer, "pad-pull-range-post",
+      G_CALLBACK (do_pull_range_post));
+  gst_tracing_register_hook (tracer, "pad-push-event-pre",
+      G_CALLBACK (do_push_event_pre));
+  gst_tracing_register_hook (tracer, "pad-push-event-post",
+      G_CALLBACK (do_push_event_post));
+}
@@ -0,0 +1,71 @@
+/* GStreamer
+ *
+ * gstelementtime.h: tracing module that logs the time spent in elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_ELEMENT_TIME_TRACER_H__
+#define __GST_ELEMENT_TIME_TRACER_H__
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_ELEMENT_TIME_TRACER \
+  (gst_element_time_tracer_get_type())
+#define GST_ELEMENT_TIME_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_ELEMENT_TIME_TRACER,GstElementTimeTracer))
+#define GST_ELEMENT_TIME_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_ELEMENT_TIME_TRACER,GstElementTimeTracerClass))
+#define GST_IS_ELEMENT_TIME_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_ELEMENT_TIME_TRACER))
+#define GST_IS_ELEMENT_TIME_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_ELEMENT_TIME_TRACER))
+#define GST_ELEMENT_TIME_TRACER_CAST(obj) ((GstElementTimeTracer *)(obj))
+
+typedef struct _GstElementTimeTracer GstElementTimeTracer;
+typedef struct _GstElementTimeTracerClass GstElementTimeTracerClass;
+
+/**
+ * GstElementTimeTracer:
+ *
+ * Opaque #GstElementTimeTracer data structure
+ */
+struct _GstElementTimeTracer {
+  GstTracer 	 parent;
+
+  /*< private >*/
+  GMutex lock;
+  /* ElementTimeStats of all elements seen so far */
+  GPtrArray *elements;
+  /* report every period, 0 to only report when the tracer is finalized */
+  GstClockTime period;
+  GstClockTime next_report;
+  /* of the last outermost push, for the final report */
+  GstClockTime last_ts;
+};
+
+struct _GstElementTimeTracerClass {
+  GstTracerClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_element_time_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_ELEMENT_TIME_TRACER_H__ */
@@ -31,6 +31,30 @@
  * ```
  * GST_TRACERS="latency(flags=pipeline+element)" GST_DEBUG=GST_TRACER:7 ./...
  * ```
+ *
+ * By default a latency probe is sent with every buffer. To bound the
+ * overhead, the probes can be sampled with the 'sample-interval' (only every
+ * Nth buffer of each pad) and 'sample-period' (at most one buffer per pad
+ * every this many milliseconds) parameters. The 'elements' parameter limits
+ * the tracing to the elements whose names match one of the '+' separated
+ * patterns, the sources for the pipeline latency and the measured elements
+ * for the element latency.
+ *
+ * ```
+ * GST_TRACERS="latency(flags=pipeline+element,sample-period=100,elements=dec*)" ...
+ * ```
+ *
+ * With 'summary-period' set to a number of milliseconds, the latencies are
+ * also collected in histograms per src-to-sink path and per element. Every
+ * period and when the tracer is destroyed, a cumulative 'latency-summary'
+ * and 'element-latency-summary' record is logged for each of them with the
+ * count, min, max, mean and 50th, 90th, 99th and 99.9th percentiles, with a
+ * precision of about 3%. The per-buffer records can then be turned off with
+ * 'per-buffer=false'.
+ *
+ * ```
+ * GST_TRACERS="latency(flags=pipeline+element,summary-period=10000,per-buffer=false)" ...
+ * ```
  */
 /* TODO(ensonic): if there are two sources feeding into a mixer/muxer and later
  * we fan-out with tee and have two sinks, each sink would get all two events,
@@ -64,10 +88,13 @@ static GQuark latency_probe_element;
 static GQuark latency_probe_element_id;
 static GQuark latency_probe_ts;
 static GQuark drop_sub_latency_quark;
+static GQuark sampler_state_quark;
 
 static GstTracerRecord *tr_latency;
 static GstTracerRecord *tr_element_latency;
 static GstTracerRecord *tr_element_reported_latency;
+static GstTracerRecord *tr_latency_summary;
+static GstTracerRecord *tr_element_latency_summary;
 
 /* The private stack for each thread */
 static GPrivate latency_query_stack =
@@ -80,6 +107,18 @@ struct LatencyQueryTableValue
   guint64 max;
 };
 
+/* The sink fields are unused for element paths */
+typedef struct
+{
+  gchar *src_element_id;
+  gchar *src_element;
+  gchar *src;
+  gchar *sink_element_id;
+  gchar *sink_element;
+  gchar *sink;
+  GstTracerHistogram hist;
+} LatencyPath;
+
 /* data helpers */
 
 /*
@@ -168,11 +207,101 @@ local_latency_query_stack_push (struct LatencyQueryTableValue *value)
   g_queue_push_tail (stack, value);
 }
 
+static void
+latency_path_free (LatencyPath * path)
+{
+  g_free (path->src_element_id);
+  g_free (path->src_element);
+  g_free (path->src);
+  g_free (path->sink_element_id);
+  g_free (path->sink_element);
+  g_free (path->sink);
+  gst_tracer_histogram_clear (&path->hist);
+  g_free (path);
+}
+
+static void
+log_path_summary (const gchar * key, LatencyPath * path, gpointer ts)
+{
+  GstTracerHistogram *hist = &path->hist;
+
+  gst_tracer_record_log (tr_latency_summary, path->src_element_id,
+      path->src_element, path->src, path->sink_element_id, path->sink_element,
+      path->sink, hist->count, hist->min, hist->max, hist->sum / hist->count,
+      gst_tracer_histogram_percentile (hist, 50),
+      gst_tracer_histogram_percentile (hist, 90),
+      gst_tracer_histogram_percentile (hist, 99),
+      gst_tracer_histogram_percentile (hist, 99.9),
+      *(GstClockTime *) ts);
+}
+
+static void
+log_element_path_summary (const gchar * key, LatencyPath * path, gpointer ts)
+{
+  GstTracerHistogram *hist = &path->hist;
+
+  gst_tracer_record_log (tr_element_latency_summary, path->src_element_id,
+      path->src_element, path->src, hist->count, hist->min, hist->max,
+      hist->sum / hist->count, gst_tracer_histogram_percentile (hist, 50),
+      gst_tracer_histogram_percentile (hist, 90),
+      gst_tracer_histogram_percentile (hist, 99),
+      gst_tracer_histogram_percentile (hist, 99.9),
+      *(GstClockTime *) ts);
+}
+
+/* called with the lock */
+static void
+log_summaries (GstLatencyTracer * self, GstClockTime ts)
+{
+  g_hash_table_foreach (self->paths, (GHFunc) log_path_summary, &ts);
+  g_hash_table_foreach (self->element_paths, (GHFunc) log_element_path_summary,
+      &ts);
+}
+
+static void
+record_latency (GstLatencyTracer * self, GHashTable * table,
+    const gchar * src_element_id, const gchar * src_element, const gchar * src,
+    const gchar * sink_element_id, const gchar * sink_element,
+    const gchar * sink, GstClockTimeDiff time, GstClockTime ts)
+{
+  gchar *key;
+  LatencyPath *path;
+
+  key = g_strjoin ("|", src_element_id, src_element, src, sink_element_id,
+      sink_element, sink, NULL);
+
+  g_mutex_lock (&self->lock);
+  path = g_hash_table_lookup (table, key);
+  if (!path) {
+    path = g_new0 (LatencyPath, 1);
+    path->src_element_id = g_strdup (src_element_id);
+    path->src_element = g_strdup (src_element);
+    path->src = g_strdup (src);
+    path->sink_element_id = g_strdup (sink_element_id);
+    path->sink_element = g_strdup (sink_element);
+    path->sink = g_strdup (sink);
+    g_hash_table_insert (table, key, path);
+  } else {
+    g_free (key);
+  }
+  gst_tracer_histogram_record (&path->hist, MAX (time, 0));
+  self->last_ts = MAX (self->last_ts, ts);
+
+  if (self->next_summary == 0) {
+    /* first measurement, report one period from now */
+    self->next_summary = ts + self->summary_period;
+  } else if (ts >= self->next_summary) {
+    self->next_summary = ts + self->summary_period;
+    log_summaries (self, ts);
+  }
+  g_mutex_unlock (&self->lock);
+}
+
 /* hooks */
 
 static void
-log_latency (const GstStructure * data, GstElement * sink_parent,
-    GstPad * sink_pad, guint64 sink_ts)
+log_latency (GstLatencyTracer * self, const GstStructure * data,
+    GstElement * sink_parent, GstPad * sink_pad, guint64 sink_ts)
 {
   guint64 src_ts;
   const char *src, *element_src, *id_element_src;
@@ -197,17 +326,22 @@ log_latency (const GstStructure * data, GstElement * sink_parent,
   id_element_sink = g_strdup_printf ("%p", sink_parent);
   element_sink = gst_element_get_name (sink_parent);
   sink = gst_pad_get_name (sink_pad);
-  gst_tracer_record_log (tr_latency, id_element_src, element_src, src,
-      id_element_sink, element_sink, sink, GST_CLOCK_DIFF (src_ts, sink_ts),
-      sink_ts);
+  if (self->per_buffer)
+    gst_tracer_record_log (tr_latency, id_element_src, element_src, src,
+        id_element_sink, element_sink, sink, GST_CLOCK_DIFF (src_ts, sink_ts),
+        sink_ts);
+  if (self->summary_period)
+    record_latency (self, self->paths, id_element_src, element_src, src,
+        id_element_sink, element_sink, sink, GST_CLOCK_DIFF (src_ts, sink_ts),
+        sink_ts);
   g_free (sink);
   g_free (element_sink);
   g_free (id_element_sink);
 }
 
 static void
-log_element_latency (const GstStructure * data, GstElement * parent,
-    GstPad * pad, guint64 sink_ts)
+log_element_latency (GstLatencyTracer * self, const GstStructure * data,
+    GstElement * parent, GstPad * pad, guint64 sink_ts)
 {
   guint64 src_ts;
   gchar *pad_name, *element_name, *element_id;
@@ -225,14 +359,36 @@ log_element_latency (const GstStructure * data, GstElement * parent,
   value = gst_structure_id_get_value (data, latency_probe_ts);
   src_ts = g_value_get_uint64 (value);
 
-  gst_tracer_record_log (tr_element_latency, element_id, element_name, pad_name,
-      GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
+  if (self->per_buffer)
+    gst_tracer_record_log (tr_element_latency, element_id, element_name,
+        pad_name, GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
+  if (self->summary_period)
+    record_latency (self, self->element_paths, element_id, element_name,
+        pad_name, NULL, NULL, NULL, GST_CLOCK_DIFF (src_ts, sink_ts), sink_ts);
 
   g_free (pad_name);
   g_free (element_name);
   g_free (element_id);
 }
 
+static gboolean
+sample_latency_probe (GstLatencyTracer * self, GstPad * pad, guint64 ts)
+{
+  GstTracerSamplerState *state;
+
+  if (!GST_TRACER_SAMPLER_IS_SAMPLING (&self->sampler))
+    return TRUE;
+
+  state = g_object_get_qdata ((GObject *) pad, sampler_state_quark);
+  if (G_UNLIKELY (!state)) {
+    state = g_new0 (GstTracerSamplerState, 1);
+    g_object_set_qdata_full ((GObject *) pad, sampler_state_quark, state,
+        g_free);
+  }
+
+  return gst_tracer_sampler_sample (&self->sampler, state, ts);
+}
+
 static void
 send_latency_probe (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
     guint64 ts)
@@ -245,9 +401,20 @@ send_latency_probe (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
   if (peer_pad && (!parent || (!GST_IS_BIN (parent)))) {
     gchar *pad_name, *element_name, *element_id;
     GstEvent *latency_probe;
+    gboolean pipeline, element;
+
+    pipeline = parent && self->flags & GST_LATENCY_TRACER_FLAG_PIPELINE &&
+        GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SOURCE) &&
+        gst_tracer_sampler_filter (&self->sampler, GST_OBJECT_CAST (parent));
+    element = peer_parent && self->flags & GST_LATENCY_TRACER_FLAG_ELEMENT &&
+        gst_tracer_sampler_filter (&self->sampler,
+        GST_OBJECT_CAST (peer_parent));
+
+    /* both probes are sent with the same sampled buffers */
+    if ((pipeline || element) && !sample_latency_probe (self, pad, ts))
+      pipeline = element = FALSE;
 
-    if (parent && self->flags & GST_LATENCY_TRACER_FLAG_PIPELINE &&
-        GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SOURCE)) {
+    if (pipeline) {
       element_id = g_strdup_printf ("%p", parent);
       element_name = gst_element_get_name (parent);
       pad_name = gst_pad_get_name (pad);
@@ -268,8 +435,7 @@ send_latency_probe (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
       gst_pad_push_event (pad, latency_probe);
     }
 
-    if (peer_parent && peer_pad &&
-        self->flags & GST_LATENCY_TRACER_FLAG_ELEMENT) {
+    if (element) {
       element_id = g_strdup_printf ("%p", peer_parent);
       element_name = gst_element_get_name (peer_parent);
       pad_name = gst_pad_get_name (peer_pad);
@@ -297,7 +463,8 @@ send_latency_probe (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
 }
 
 static void
-calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
+calculate_latency (GstLatencyTracer * self, GstElement * parent, GstPad * pad,
+    guint64 ts)
 {
   if (parent && (!GST_IS_BIN (parent)) &&
       (!GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SOURCE))) {
@@ -312,7 +479,8 @@ calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
       GST_DEBUG ("%s_%s: Should log full latency now (event %p)",
           GST_DEBUG_PAD_NAME (pad), ev);
       if (ev) {
-        log_latency (gst_event_get_structure (ev), peer_parent, peer_pad, ts);
+        log_latency (self, gst_event_get_structure (ev), peer_parent,
+            peer_pad, ts);
         g_object_set_qdata ((GObject *) pad, latency_probe_id, NULL);
       }
     }
@@ -321,7 +489,8 @@ calculate_latency (GstElement * parent, GstPad * pad, guint64 ts)
     GST_DEBUG ("%s_%s: Should log sub latency now (event %p)",
         GST_DEBUG_PAD_NAME (pad), ev);
     if (ev) {
-      log_element_latency (gst_event_get_structure (ev), parent, pad, ts);
+      log_element_latency (self, gst_event_get_structure (ev), parent, pad,
+          ts);
       g_object_set_qdata ((GObject *) pad, sub_latency_probe_id, NULL);
     }
     if (peer_pad)
@@ -338,7 +507,7 @@ do_push_buffer_pre (GstTracer * tracer, guint64 ts, GstPad * pad)
   GstElement *parent = get_real_pad_parent (pad);
 
   send_latency_probe (self, parent, pad, ts);
-  calculate_latency (parent, pad, ts);
+  calculate_latency (self, parent, pad, ts);
 
   if (parent)
     gst_object_unref (parent);
@@ -358,11 +527,12 @@ do_pull_range_pre (GstTracer * tracer, guint64 ts, GstPad * pad)
 }
 
 static void
-do_pull_range_post (GstTracer * self, guint64 ts, GstPad * pad)
+do_pull_range_post (GstTracer * tracer, guint64 ts, GstPad * pad)
 {
+  GstLatencyTracer *self = (GstLatencyTracer *) tracer;
   GstElement *parent = get_real_pad_parent (pad);
 
-  calculate_latency (parent, pad, ts);
+  calculate_latency (self, parent, pad, ts);
 
   if (parent)
     gst_object_unref (parent);
@@ -562,6 +732,8 @@ gst_latency_tracer_constructed (GObject * object)
 
   if (params_struct) {
     const gchar *name, *flags;
+    gint period;
+
     /* Set the name if assigned */
     name = gst_structure_get_string (params_struct, "name");
     if (name)
@@ -570,12 +742,12 @@ gst_latency_tracer_constructed (GObject * object)
     /* Read the flags if available */
     flags = gst_structure_get_string (params_struct, "flags");
 
-    self->flags = 0;
-
     if (flags) {
       GStrv split = g_strsplit (flags, "+", -1);
       gint i;
 
+      self->flags = 0;
+
       for (i = 0; split[i]; i++) {
         if (g_str_equal (split[i], "pipeline"))
           self->flags |= GST_LATENCY_TRACER_FLAG_PIPELINE;
@@ -589,18 +761,47 @@ gst_latency_tracer_constructed (GObject * object)
 
       g_strfreev (split);
     }
+
+    gst_tracer_sampler_configure (&self->sampler, params_struct);
+
+    if (gst_structure_get_int (params_struct, "summary-period", &period)) {
+      if (period >= 0)
+        self->summary_period = period * GST_MSECOND;
+      else
+        GST_WARNING ("Invalid summary-period %d", period);
+    }
+    gst_structure_get_boolean (params_struct, "per-buffer", &self->per_buffer);
+
     gst_structure_free (params_struct);
   }
 
   g_free (params);
 }
 
+static void
+gst_latency_tracer_finalize (GObject * object)
+{
+  GstLatencyTracer *self = GST_LATENCY_TRACER (object);
+
+  gst_tracer_sampler_clear (&self->sampler);
+
+  /* final summary */
+  if (self->last_ts)
+    log_summaries (self, self->last_ts);
+  g_hash_table_unref (self->paths);
+  g_hash_table_unref (self->element_paths);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_latency_tracer_class_init (GstLatencyTracerClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->constructed = gst_latency_tracer_constructed;
+  gobject_class->finalize = gst_latency_tracer_finalize;
 
   latency_probe_id = g_quark_from_static_string ("latency_probe.id");
   sub_latency_probe_id = g_quark_from_static_string ("sub_latency_probe.id");
@@ -611,6 +812,7 @@ gst_latency_tracer_class_init (GstLatencyTracerClass * klass)
   latency_probe_ts = g_quark_from_static_string ("latency_probe.ts");
   drop_sub_latency_quark =
       g_quark_from_static_string ("drop_sub_latency.quark");
+  sampler_state_quark = g_quark_from_static_string ("latency.sampler-state");
 
   /* announce trace formats */
   /* *INDENT-OFF* */
@@ -726,12 +928,172 @@ gst_latency_tracer_class_init (GstLatencyTracerClass * klass)
           "max", G_TYPE_UINT64, G_MAXUINT64,
           NULL),
       NULL);
+
+  tr_latency_summary = gst_tracer_record_new ("latency-summary.class",
+      "src-element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src-element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "sink-element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "sink-element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "sink", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of measured buffers",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "min", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the minimum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the maximum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "mean", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the mean latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p50", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the median latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p90", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 90th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p99", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 99th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p999", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 99.9th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the summary has been logged",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
+
+  tr_element_latency_summary = gst_tracer_record_new (
+      "element-latency-summary.class",
+      "element-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "element", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE,
+          GST_TRACER_VALUE_SCOPE_ELEMENT,
+          NULL),
+      "src", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of measured buffers",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "min", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the minimum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "max", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the maximum latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "mean", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the mean latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p50", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the median latency in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p90", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 90th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p99", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 99th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "p999", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "the 99.9th percentile in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the summary has been logged",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
   /* *INDENT-ON* */
 
   GST_OBJECT_FLAG_SET (tr_latency, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_element_latency, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_element_reported_latency,
       GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_latency_summary, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_element_latency_summary,
+      GST_OBJECT_FLAG_MAY_BE_LEAKED);
 }
 
 static void
@@ -741,6 +1103,13 @@ gst_latency_tracer_init (GstLatencyTracer * self)
 
   /* only trace pipeline latency by default */
   self->flags = GST_LATENCY_TRACER_FLAG_PIPELINE;
+  self->per_buffer = TRUE;
+
+  g_mutex_init (&self->lock);
+  self->paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) latency_path_free);
+  self->element_paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) latency_path_free);
 
   /* in push mode, pre/post will be called before/after the peer chain
    * function has been called. For this reaosn, we only use -pre to avoid
@@ -25,6 +25,9 @@
 #include <gst/gst.h>
 #include <gst/gsttracer.h>
 
+#include "gsttracerhistogram.h"
+#include "gsttracersampler.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_LATENCY_TRACER \
@@ -59,6 +62,19 @@ struct _GstLatencyTracer {
 
   /*< private >*/
   GstLatencyTracerFlags flags;
+  GstTracerSampler sampler;
+
+  /* log a record for every measured buffer */
+  gboolean per_buffer;
+
+  /* histograms per path, 0 to disable */
+  GstClockTime summary_period;
+  GstClockTime next_summary;
+  GstClockTime last_ts;
+  GMutex lock;
+  /* "ids|names" -> LatencyPath */
+  GHashTable *paths;
+  GHashTable *element_paths;
 };
 
 struct _GstLatencyTracerClass {
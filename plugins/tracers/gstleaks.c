@@ -39,7 +39,7 @@
  * active at the same time.
  *
  * Parameters can also be passed to each tracer. The leaks tracer currently
- * accepts five params:
+ * accepts six params:
  * 1. filters: (string) to filter which objects to record
  * 2. check-refs: (boolean) whether to record every location where a leaked
  *    object was reffed and unreffed
@@ -47,6 +47,14 @@
  * 4. name: (string) set a name for the tracer object itself
  * 5. log-leaks-on-deinit: (boolean) whether to report all leaks on
  *    gst_deinit() by printing them in the debug log; "true" by default
+ * 6. stack-traces-sample: (int) only record the stack trace of every Nth
+ *    tracked object, or ref/unref with check-refs; 1 by default
+ *
+ * The stack traces are recorded as raw return addresses and identical
+ * stacks are only stored once. They are only resolved to symbols, and
+ * source lines with `full`, when the leaks are reported. Together with
+ * `stack-traces-sample` this keeps the overhead low enough to leave the
+ * tracer running on real traffic.
  *
  * Examples:
  * ```
@@ -63,6 +71,8 @@
 
 #include "gstleaks.h"
 
+#include <string.h>
+
 #ifdef G_OS_UNIX
 #include <glib-unix.h>
 #include <pthread.h>
@@ -114,25 +124,126 @@ static guint gst_leaks_tracer_signals[LAST_SIGNAL] = { 0 };
 
 G_LOCK_DEFINE_STATIC (instances);
 
+#define MAX_STACK_DEPTH 64
+
+/* A unique stack, owned by GstLeaksTracer.stacks */
 typedef struct
 {
-  gboolean reffed;
+  guint hash;
+  guint n_addresses;
+  /* symbolized when first reported */
   gchar *trace;
+  gpointer addresses[];
+} LeakStack;
+
+typedef struct
+{
+  gboolean reffed;
+  LeakStack *stack;
   gint new_refcount;
   GstClockTime ts;
 } ObjectRefingInfo;
 
 typedef struct
 {
-  gchar *creation_trace;
+  LeakStack *creation_stack;
 
   GList *refing_infos;
 } ObjectRefingInfos;
 
+static guint
+leak_stack_hash (const LeakStack * stack)
+{
+  return stack->hash;
+}
+
+static gboolean
+leak_stack_equal (const LeakStack * a, const LeakStack * b)
+{
+  return a->hash == b->hash && a->n_addresses == b->n_addresses &&
+      memcmp (a->addresses, b->addresses,
+      a->n_addresses * sizeof (gpointer)) == 0;
+}
+
+static void
+leak_stack_free (LeakStack * stack)
+{
+  g_free (stack->trace);
+  g_free (stack);
+}
+
+static inline gboolean
+should_capture_stack (GstLeaksTracer * self)
+{
+  if ((gint) self->trace_flags == -1)
+    return FALSE;
+
+  return self->stack_sample <= 1 ||
+      (guint) g_atomic_int_add (&self->stack_count, 1) % self->stack_sample
+      == 0;
+}
+
+/* Called without the object lock, returns the number of addresses */
+static guint
+capture_stack (GstLeaksTracer * self, gpointer * addresses)
+{
+  if (!should_capture_stack (self))
+    return 0;
+
+  return gst_debug_get_stack_addresses (addresses, MAX_STACK_DEPTH);
+}
+
+/* Called with the object lock */
+static LeakStack *
+intern_stack (GstLeaksTracer * self, gpointer * addresses, guint n_addresses)
+{
+  LeakStack *stack, *existing;
+  guint i, hash = 5381;
+
+  if (n_addresses == 0)
+    return NULL;
+
+  for (i = 0; i < n_addresses; i++)
+    hash = hash * 33 + GPOINTER_TO_UINT (addresses[i]);
+
+  stack = g_malloc (sizeof (LeakStack) + n_addresses * sizeof (gpointer));
+  stack->hash = hash;
+  stack->n_addresses = n_addresses;
+  stack->trace = NULL;
+  memcpy (stack->addresses, addresses, n_addresses * sizeof (gpointer));
+
+  if (!self->stacks)
+    self->stacks = g_hash_table_new_full ((GHashFunc) leak_stack_hash,
+        (GEqualFunc) leak_stack_equal, (GDestroyNotify) leak_stack_free, NULL);
+
+  existing = g_hash_table_lookup (self->stacks, stack);
+  if (existing) {
+    leak_stack_free (stack);
+    return existing;
+  }
+
+  g_hash_table_add (self->stacks, stack);
+  return stack;
+}
+
+/* Called with the object lock */
+static const gchar *
+leak_stack_get_trace (GstLeaksTracer * self, LeakStack * stack)
+{
+  if (!stack)
+    return NULL;
+
+  if (!stack->trace)
+    stack->trace = gst_debug_symbolize_stack_addresses (
+        (gpointer const *) stack->addresses, stack->n_addresses,
+        self->trace_flags);
+
+  return stack->trace;
+}
+
 static void
 object_refing_info_free (ObjectRefingInfo * refinfo)
 {
-  g_free (refinfo->trace);
   g_free (refinfo);
 }
 
@@ -142,7 +253,6 @@ object_refing_infos_free (ObjectRefingInfos * infos)
   g_list_free_full (infos->refing_infos,
       (GDestroyNotify) object_refing_info_free);
 
-  g_free (infos->creation_trace);
   g_free (infos);
 }
 
@@ -229,6 +339,7 @@ set_params_from_structure (GstLeaksTracer * self, GstStructure * params)
 
   gst_structure_get_boolean (params, "check-refs", &self->check_refs);
   gst_structure_get_boolean (params, "log-leaks-on-deinit", &self->log_leaks);
+  gst_structure_get_uint (params, "stack-traces-sample", &self->stack_sample);
 }
 
 static void
@@ -382,11 +493,14 @@ handle_object_created (GstLeaksTracer * self, gpointer object, GType type,
     gboolean gobject)
 {
   ObjectRefingInfos *infos;
-
+  gpointer addresses[MAX_STACK_DEPTH];
+  guint n_addresses;
 
   if (!should_handle_object_type (self, type))
     return;
 
+  n_addresses = capture_stack (self, addresses);
+
   infos = g_malloc0 (sizeof (ObjectRefingInfos));
   if (gobject)
     g_object_weak_ref ((GObject *) object, object_weak_cb, self);
@@ -395,8 +509,7 @@ handle_object_created (GstLeaksTracer * self, gpointer object, GType type,
         mini_object_weak_cb, self);
 
   GST_OBJECT_LOCK (self);
-  if ((gint) self->trace_flags != -1)
-    infos->creation_trace = gst_debug_get_stack_trace (self->trace_flags);
+  infos->creation_stack = intern_stack (self, addresses, n_addresses);
 
   g_hash_table_insert (self->objects, object, infos);
 
@@ -433,6 +546,8 @@ handle_object_reffed (GstLeaksTracer * self, gpointer object, GType type,
 {
   ObjectRefingInfos *infos;
   ObjectRefingInfo *refinfo;
+  gpointer addresses[MAX_STACK_DEPTH];
+  guint n_addresses;
 
   if (!self->check_refs)
     return;
@@ -440,6 +555,8 @@ handle_object_reffed (GstLeaksTracer * self, gpointer object, GType type,
   if (!should_handle_object_type (self, type))
     return;
 
+  n_addresses = capture_stack (self, addresses);
+
   GST_OBJECT_LOCK (self);
   infos = g_hash_table_lookup (self->objects, object);
   if (!infos)
@@ -449,8 +566,7 @@ handle_object_reffed (GstLeaksTracer * self, gpointer object, GType type,
   refinfo->ts = ts;
   refinfo->new_refcount = new_refcount;
   refinfo->reffed = reffed;
-  if ((gint) self->trace_flags != -1)
-    refinfo->trace = gst_debug_get_stack_trace (self->trace_flags);
+  refinfo->stack = intern_stack (self, addresses, n_addresses);
 
   infos->refing_infos = g_list_prepend (infos->refing_infos, refinfo);
 
@@ -502,6 +618,7 @@ static void
 gst_leaks_tracer_init (GstLeaksTracer * self)
 {
   self->log_leaks = DEFAULT_LOG_LEAKS;
+  self->stack_sample = 1;
   self->objects = g_hash_table_new_full (NULL, NULL, NULL,
       (GDestroyNotify) object_refing_infos_free);
 
@@ -629,17 +746,18 @@ create_leaks_list (GstLeaksTracer * self)
 }
 
 static void
-process_leak (Leak * leak, GValue * ret_leaks)
+process_leak (GstLeaksTracer * self, Leak * leak, GValue * ret_leaks)
 {
   GstStructure *r, *s = NULL;
   GList *ref;
   GValue refings = G_VALUE_INIT;
+  const gchar *trace;
 
+  trace = leak_stack_get_trace (self, leak->infos->creation_stack);
   if (!ret_leaks) {
     /* log to the debug log */
     gst_tracer_record_log (tr_alive, g_type_name (leak->type), leak->obj,
-        leak->desc, leak->ref_count,
-        leak->infos->creation_trace ? leak->infos->creation_trace : "");
+        leak->desc, leak->ref_count, trace ? trace : "");
   } else {
     GValue s_value = G_VALUE_INIT;
     GValue obj_value = G_VALUE_INIT;
@@ -653,7 +771,7 @@ process_leak (Leak * leak, GValue * ret_leaks)
     s = gst_structure_new_empty ("object-alive");
     gst_structure_take_value (s, "object", &obj_value);
     gst_structure_set (s, "ref-count", G_TYPE_UINT, leak->ref_count,
-        "trace", G_TYPE_STRING, leak->infos->creation_trace, NULL);
+        "trace", G_TYPE_STRING, trace, NULL);
     /* avoid copy of structure */
     g_value_init (&s_value, GST_TYPE_STRUCTURE);
     g_value_take_boxed (&s_value, s);
@@ -668,18 +786,19 @@ process_leak (Leak * leak, GValue * ret_leaks)
   for (ref = g_list_last (leak->infos->refing_infos); ref; ref = ref->prev) {
     ObjectRefingInfo *refinfo = (ObjectRefingInfo *) ref->data;
 
+    trace = leak_stack_get_trace (self, refinfo->stack);
     if (!ret_leaks) {
       /* log to the debug log */
       gst_tracer_record_log (tr_refings, refinfo->ts, g_type_name (leak->type),
           leak->obj, refinfo->reffed ? "reffed" : "unreffed",
-          refinfo->new_refcount, refinfo->trace ? refinfo->trace : "");
+          refinfo->new_refcount, trace ? trace : "");
     } else {
       GValue r_value = G_VALUE_INIT;
       r = gst_structure_new_empty ("object-refings");
       gst_structure_set (r, "ts", GST_TYPE_CLOCK_TIME, refinfo->ts,
           "desc", G_TYPE_STRING, refinfo->reffed ? "reffed" : "unreffed",
           "ref-count", G_TYPE_UINT, refinfo->new_refcount,
-          "trace", G_TYPE_STRING, refinfo->trace, NULL);
+          "trace", G_TYPE_STRING, trace, NULL);
       /* avoid copy of structure */
       g_value_init (&r_value, GST_TYPE_STRUCTURE);
       g_value_take_boxed (&r_value, r);
@@ -709,7 +828,7 @@ process_leaks (GstLeaksTracer * self, GValue * ret_leaks)
   }
 
   for (l = leaks; l; l = l->next)
-    process_leak (l->data, ret_leaks);
+    process_leak (self, l->data, ret_leaks);
 
   g_list_free_full (leaks, (GDestroyNotify) leak_free);
 
@@ -755,6 +874,7 @@ gst_leaks_tracer_finalize (GObject * object)
   g_clear_pointer (&self->added, g_hash_table_unref);
   g_clear_pointer (&self->removed, g_hash_table_unref);
   g_clear_pointer (&self->unhandled_filter, g_hash_table_unref);
+  g_clear_pointer (&self->stacks, g_hash_table_unref);
 
   G_LOCK (instances);
   g_queue_remove (&instances, self);
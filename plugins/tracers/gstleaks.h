@@ -72,6 +72,12 @@ struct _GstLeaksTracer {
   gboolean log_leaks;
 
   GstStackTraceFlags trace_flags;
+  /* record the stack of every Nth tracked object or refing */
+  guint stack_sample;
+  gint stack_count;
+  /* Set of owned LeakStack, shared by all the objects and refings with the
+   * same stack.  Protected by object lock */
+  GHashTable *stacks;
 };
 
 struct _GstLeaksTracerClass {
@@ -0,0 +1,498 @@
+/* GStreamer
+ *
+ * gstlockstats.c: tracing module that measures lock contention
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-lockstats
+ * @short_description: measure lock contention
+ *
+ * A tracing module that measures how long threads wait for and hold the
+ * locks of GStreamer objects, per source location that takes the lock and
+ * object. The object locks, pad stream locks, the lock of queue and the
+ * system clock lock are instrumented when GStreamer is built with the
+ * lock_tracing option, otherwise this tracer doesn't see any locks.
+ *
+ * For each site and object, the number of acquisitions, how many of them
+ * had to wait, the total and maximum wait time and the total and maximum
+ * hold time are logged in lock-stats records, which are cumulative. The
+ * 'top' sites with the longest total wait (default 10, 0 for all) are
+ * logged every 'period' milliseconds (default 0, to only log when the tracer
+ * is shut down).
+ *
+ * ```
+ * GST_TRACERS="lockstats(period=1000,top=20)" GST_DEBUG=GST_TRACER:7 ./...
+ * ```
+ *
+ * The time spent in g_cond_wait() on the queue and clock locks does not
+ * count as holding the lock, for the other locks it does. The statistics are
+ * kept per thread so that the tracer doesn't add contention of its own.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstlockstats.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_lock_stats_debug);
+#define GST_CAT_DEFAULT gst_lock_stats_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_lock_stats_debug, "lockstats", 0, \
+        "lock statistics tracer");
+#define gst_lock_stats_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstLockStatsTracer, gst_lock_stats_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+#define DEFAULT_PERIOD 0
+#define DEFAULT_TOP 10
+
+static GstTracerRecord *tr_lock_stats;
+static gint tracer_ids;
+
+typedef struct
+{
+  /* the key: the static source location and the object, which might be gone */
+  const gchar *site;
+  gpointer object;
+
+  gchar *name;
+  guint64 count;
+  guint64 contended;
+  GstClockTime wait;
+  GstClockTime max_wait;
+  GstClockTime hold;
+  GstClockTime max_hold;
+} LockSite;
+
+typedef struct
+{
+  gpointer lock;
+  LockSite *site;
+  GstClockTime ts;
+  /* for recursive locks */
+  guint depth;
+} HeldLock;
+
+typedef struct
+{
+  gint ref_count;
+  guint tracer_id;
+
+  /* protects sites and last_ts against the reports */
+  GMutex lock;
+  /* set of LockSite */
+  GHashTable *sites;
+  GstClockTime last_ts;
+
+  /* HeldLock, innermost last. Only used by the thread */
+  GArray *held;
+} ThreadLocks;
+
+/* data helpers */
+
+static guint
+lock_site_hash (const LockSite * site)
+{
+  return g_direct_hash (site->site) ^ g_direct_hash (site->object);
+}
+
+static gboolean
+lock_site_equal (const LockSite * a, const LockSite * b)
+{
+  return a->site == b->site && a->object == b->object;
+}
+
+static void
+lock_site_free (LockSite * site)
+{
+  g_free (site->name);
+  g_free (site);
+}
+
+static LockSite *
+lock_site_copy (const LockSite * site)
+{
+  LockSite *copy = g_new (LockSite, 1);
+
+  *copy = *site;
+  copy->name = g_strdup (site->name);
+  return copy;
+}
+
+static ThreadLocks *
+thread_locks_ref (ThreadLocks * locks)
+{
+  g_atomic_int_inc (&locks->ref_count);
+  return locks;
+}
+
+static void
+thread_locks_unref (ThreadLocks * locks)
+{
+  if (!g_atomic_int_dec_and_test (&locks->ref_count))
+    return;
+
+  g_hash_table_unref (locks->sites);
+  g_array_free (locks->held, TRUE);
+  g_mutex_clear (&locks->lock);
+  g_free (locks);
+}
+
+static GPrivate thread_locks_key =
+G_PRIVATE_INIT ((GDestroyNotify) thread_locks_unref);
+
+static ThreadLocks *
+get_thread_locks (GstLockStatsTracer * self)
+{
+  ThreadLocks *locks = g_private_get (&thread_locks_key);
+
+  /* the tracer could have been replaced by another one */
+  if (G_LIKELY (locks && locks->tracer_id == self->id))
+    return locks;
+
+  locks = g_new0 (ThreadLocks, 1);
+  locks->ref_count = 1;
+  locks->tracer_id = self->id;
+  g_mutex_init (&locks->lock);
+  locks->sites = g_hash_table_new_full ((GHashFunc) lock_site_hash,
+      (GEqualFunc) lock_site_equal, (GDestroyNotify) lock_site_free, NULL);
+  locks->held = g_array_sized_new (FALSE, FALSE, sizeof (HeldLock), 8);
+
+  g_mutex_lock (&self->lock);
+  g_ptr_array_add (self->threads, thread_locks_ref (locks));
+  g_mutex_unlock (&self->lock);
+
+  g_private_replace (&thread_locks_key, locks);
+
+  return locks;
+}
+
+static gint
+compare_lock_sites (gconstpointer a, gconstpointer b)
+{
+  const LockSite *s1 = a, *s2 = b;
+
+  if (s1->wait != s2->wait)
+    return s1->wait < s2->wait ? 1 : -1;
+  if (s1->hold != s2->hold)
+    return s1->hold < s2->hold ? 1 : -1;
+  return 0;
+}
+
+/* merges the statistics of all threads, without holding any of their locks
+ * while logging as that can take other locks */
+static void
+log_stats (GstLockStatsTracer * self, GstClockTime ts)
+{
+  GHashTable *sites;
+  GPtrArray *threads;
+  GList *list, *l;
+  guint i, n;
+
+  g_mutex_lock (&self->lock);
+  threads = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      thread_locks_unref);
+  for (i = 0; i < self->threads->len; i++)
+    g_ptr_array_add (threads,
+        thread_locks_ref (g_ptr_array_index (self->threads, i)));
+  g_mutex_unlock (&self->lock);
+
+  sites = g_hash_table_new_full ((GHashFunc) lock_site_hash,
+      (GEqualFunc) lock_site_equal, (GDestroyNotify) lock_site_free, NULL);
+  for (i = 0; i < threads->len; i++) {
+    ThreadLocks *locks = g_ptr_array_index (threads, i);
+    GHashTableIter iter;
+    LockSite *site, *total;
+
+    g_mutex_lock (&locks->lock);
+    if (ts == GST_CLOCK_TIME_NONE || ts < locks->last_ts)
+      ts = locks->last_ts;
+    g_hash_table_iter_init (&iter, locks->sites);
+    while (g_hash_table_iter_next (&iter, (gpointer *) & site, NULL)) {
+      total = g_hash_table_lookup (sites, site);
+      if (!total) {
+        g_hash_table_add (sites, lock_site_copy (site));
+        continue;
+      }
+      total->count += site->count;
+      total->contended += site->contended;
+      total->wait += site->wait;
+      total->max_wait = MAX (total->max_wait, site->max_wait);
+      total->hold += site->hold;
+      total->max_hold = MAX (total->max_hold, site->max_hold);
+    }
+    g_mutex_unlock (&locks->lock);
+  }
+  g_ptr_array_free (threads, TRUE);
+
+  list = g_list_sort (g_hash_table_get_keys (sites), compare_lock_sites);
+  for (l = list, n = 0; l && (self->top == 0 || n < self->top); l = l->next,
+      n++) {
+    LockSite *site = l->data;
+    gchar *id = g_strdup_printf ("%p", site->object);
+
+    gst_tracer_record_log (tr_lock_stats, site->site, id,
+        site->name ? site->name : "", site->count, site->contended,
+        site->wait, site->max_wait, site->hold, site->max_hold,
+        ts == GST_CLOCK_TIME_NONE ? 0 : ts);
+    g_free (id);
+  }
+  g_list_free (list);
+  g_hash_table_unref (sites);
+}
+
+static void
+maybe_log_stats (GstLockStatsTracer * self, GstClockTime ts)
+{
+  /* the racy read only decides whether it's worth to look closer */
+  if (self->period == 0 || ts < self->next_report)
+    return;
+  if (!g_atomic_int_compare_and_exchange (&self->reporting, 0, 1))
+    return;
+
+  if (ts >= self->next_report) {
+    /* first call, report one period from now */
+    if (self->next_report != 0)
+      log_stats (self, ts);
+    self->next_report = ts + self->period;
+  }
+  g_atomic_int_set (&self->reporting, 0);
+}
+
+/* hooks */
+
+static void
+do_lock_acquired (GstLockStatsTracer * self, GstClockTime ts,
+    GstObject * object, gpointer lock, const gchar * site_name,
+    GstClockTime wait)
+{
+  ThreadLocks *locks = get_thread_locks (self);
+  LockSite key = { site_name, object }, *site;
+  HeldLock *held;
+  guint i;
+
+  for (i = locks->held->len; i > 0; i--) {
+    held = &g_array_index (locks->held, HeldLock, i - 1);
+    if (held->lock == lock) {
+      held->depth++;
+      return;
+    }
+  }
+
+  g_mutex_lock (&locks->lock);
+  site = g_hash_table_lookup (locks->sites, &key);
+  if (G_UNLIKELY (!site)) {
+    site = g_new0 (LockSite, 1);
+    site->site = site_name;
+    site->object = object;
+    site->name = g_strdup (object ? GST_OBJECT_NAME (object) : NULL);
+    g_hash_table_add (locks->sites, site);
+  }
+  site->count++;
+  if (wait > 0) {
+    site->contended++;
+    site->wait += wait;
+    site->max_wait = MAX (site->max_wait, wait);
+  }
+  g_mutex_unlock (&locks->lock);
+
+  g_array_set_size (locks->held, locks->held->len + 1);
+  held = &g_array_index (locks->held, HeldLock, locks->held->len - 1);
+  held->lock = lock;
+  held->site = site;
+  held->ts = ts;
+  held->depth = 1;
+}
+
+static void
+do_lock_released (GstLockStatsTracer * self, GstClockTime ts,
+    GstObject * object, gpointer lock)
+{
+  ThreadLocks *locks = get_thread_locks (self);
+  HeldLock *held = NULL;
+  GstClockTime hold;
+  guint i;
+
+  for (i = locks->held->len; i > 0; i--) {
+    held = &g_array_index (locks->held, HeldLock, i - 1);
+    if (held->lock == lock)
+      break;
+  }
+  /* taken before the tracer was there */
+  if (i == 0)
+    return;
+  if (--held->depth > 0)
+    return;
+
+  hold = ts - held->ts;
+  g_mutex_lock (&locks->lock);
+  held->site->hold += hold;
+  held->site->max_hold = MAX (held->site->max_hold, hold);
+  locks->last_ts = ts;
+  g_mutex_unlock (&locks->lock);
+
+  g_array_remove_index (locks->held, i - 1);
+
+  /* only report when this thread doesn't hold any lock anymore */
+  if (locks->held->len == 0)
+    maybe_log_stats (self, ts);
+}
+
+/* tracer class */
+
+static void
+gst_lock_stats_tracer_constructed (GObject * object)
+{
+  GstLockStatsTracer *self = GST_LOCK_STATS_TRACER (object);
+  gchar *params, *tmp;
+  GstStructure *params_struct = NULL;
+  const gchar *name;
+  gint period;
+  guint top;
+
+  g_object_get (self, "params", &params, NULL);
+
+  if (!params)
+    return;
+
+  tmp = g_strdup_printf ("lockstats,%s", params);
+  params_struct = gst_structure_from_string (tmp, NULL);
+  g_free (tmp);
+  g_free (params);
+  if (!params_struct)
+    return;
+
+  /* Set the name if assigned */
+  name = gst_structure_get_string (params_struct, "name");
+  if (name)
+    gst_object_set_name (GST_OBJECT (self), name);
+
+  if (gst_structure_get_int (params_struct, "period", &period)) {
+    if (period >= 0)
+      self->period = period * GST_MSECOND;
+    else
+      GST_WARNING_OBJECT (self, "Invalid period %d", period);
+  }
+  if (gst_structure_get_uint (params_struct, "top", &top))
+    self->top = top;
+  gst_structure_free (params_struct);
+}
+
+static void
+gst_lock_stats_tracer_finalize (GObject * object)
+{
+  GstLockStatsTracer *self = GST_LOCK_STATS_TRACER (object);
+
+  /* final report */
+  log_stats (self, GST_CLOCK_TIME_NONE);
+
+  g_ptr_array_free (self->threads, TRUE);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_lock_stats_tracer_class_init (GstLockStatsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_lock_stats_tracer_constructed;
+  gobject_class->finalize = gst_lock_stats_tracer_finalize;
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_lock_stats = gst_tracer_record_new ("lock-stats.class",
+      "site", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "source location that takes the lock",
+          NULL),
+      "object-id", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "address of the object",
+          NULL),
+      "object", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "name of the object",
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of times the lock was taken",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "contended", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "number of times the thread had to wait",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "wait", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "total wait time in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "max-wait", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "longest wait time in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "hold", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "total hold time in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "max-hold", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "longest hold time in ns",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the stats have been logged",
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_lock_stats, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_lock_stats_tracer_init (GstLockStatsTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  self->id = g_atomic_int_add (&tracer_ids, 1) + 1;
+  g_mutex_init (&self->lock);
+  self->threads = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      thread_locks_unref);
+  self->period = DEFAULT_PERIOD;
+  self->top = DEFAULT_TOP;
+
+  gst_tracing_register_hook (tracer, "lock-acquired",
+      G_CALLBACK (do_lock_acquired));
+  gst_tracing_register_hook (tracer, "lock-released",
+      G_CALLBACK (do_lock_released));
+}
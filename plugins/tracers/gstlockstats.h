@@ -0,0 +1,74 @@
+/* GStreamer
+ *
+ * gstlockstats.h: tracing module that measures lock contention
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_LOCK_STATS_TRACER_H__
+#define __GST_LOCK_STATS_TRACER_H__
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_LOCK_STATS_TRACER \
+  (gst_lock_stats_tracer_get_type())
+#define GST_LOCK_STATS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_LOCK_STATS_TRACER,GstLockStatsTracer))
+#define GST_LOCK_STATS_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_LOCK_STATS_TRACER,GstLockStatsTracerClass))
+#define GST_IS_LOCK_STATS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_LOCK_STATS_TRACER))
+#define GST_IS_LOCK_STATS_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_LOCK_STATS_TRACER))
+#define GST_LOCK_STATS_TRACER_CAST(obj) ((GstLockStatsTracer *)(obj))
+
+typedef struct _GstLockStatsTracer GstLockStatsTracer;
+typedef struct _GstLockStatsTracerClass GstLockStatsTracerClass;
+
+/**
+ * GstLockStatsTracer:
+ *
+ * Opaque #GstLockStatsTracer data structure
+ */
+struct _GstLockStatsTracer {
+  GstTracer 	 parent;
+
+  /*< private >*/
+  guint id;
+  /* protects threads */
+  GMutex lock;
+  /* ThreadLocks of all threads that took a lock */
+  GPtrArray *threads;
+  /* number of lock sites to report, 0 for all */
+  guint top;
+  /* report every period, 0 to only report when the tracer is finalized */
+  GstClockTime period;
+  GstClockTime next_report;
+  gint reporting;
+};
+
+struct _GstLockStatsTracerClass {
+  GstTracerClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_lock_stats_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_LOCK_STATS_TRACER_H__ */
@@ -0,0 +1,544 @@
+/* GStreamer
+ *
+ * gstmemusage.c: tracing module that accounts the allocated memory
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-memusage
+ * @short_description: account the allocated memory
+ *
+ * A tracing module that accounts the bytes of all #GstMemory to the
+ * allocator they come from and to the element that allocated them, that is
+ * the element whose chain, getrange or loop function was running in the
+ * allocating thread. For buffer pools, the buffers that are acquired and
+ * not yet released are accounted, and for structures like clock entries,
+ * their type.
+ *
+ * For each of them, the bytes that are currently allocated ('live'), their
+ * maximum ('peak'), and the number and total size of the allocations are
+ * logged in memory-usage records, which are cumulative. They are logged
+ * every 'period' milliseconds (default 1000, 0 to only log when the tracer
+ * is shut down) for the owners whose values changed.
+ *
+ * ```
+ * GST_TRACERS="memusage(period=5000)" GST_DEBUG=GST_TRACER:7 ./...
+ * ```
+ *
+ * Memory that only shares the data of another memory is not accounted, and
+ * neither is memory allocated outside of the streaming threads of elements,
+ * e.g. while preparing a buffer pool, which is accounted to an
+ * 'unattributed' owner. All allocations take a lock of the tracer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstmemusage.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_mem_usage_debug);
+#define GST_CAT_DEFAULT gst_mem_usage_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_mem_usage_debug, "memusage", 0, \
+        "memory usage tracer");
+#define gst_mem_usage_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstMemUsageTracer, gst_mem_usage_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+#define DEFAULT_PERIOD (1000 * GST_MSECOND)
+
+static GQuark owner_quark;
+static GstTracerRecord *tr_memory_usage;
+
+typedef struct
+{
+  const gchar *kind;
+  gchar *id;
+  gchar *name;
+  gboolean active;
+
+  guint64 live;
+  guint64 peak;
+  guint64 count;
+  guint64 bytes;
+} MemoryOwner;
+
+/* what an allocation was charged to, until it is freed */
+typedef struct
+{
+  MemoryOwner *owners[2];
+  gsize size;
+} Allocation;
+
+typedef struct
+{
+  /* MemoryOwner of the elements running in this thread, innermost last */
+  GPtrArray *stack;
+  /* of the element pushing from the loop function of the thread */
+  MemoryOwner *loop_owner;
+} ThreadState;
+
+static void
+thread_state_free (ThreadState * state)
+{
+  g_ptr_array_free (state->stack, TRUE);
+  g_free (state);
+}
+
+static GPrivate thread_state_key =
+G_PRIVATE_INIT ((GDestroyNotify) thread_state_free);
+
+/* data helpers */
+
+static ThreadState *
+get_thread_state (void)
+{
+  ThreadState *state = g_private_get (&thread_state_key);
+
+  if (G_UNLIKELY (!state)) {
+    state = g_new0 (ThreadState, 1);
+    state->stack = g_ptr_array_sized_new (16);
+    g_private_set (&thread_state_key, state);
+  }
+  return state;
+}
+
+static void
+free_owner (MemoryOwner * owner)
+{
+  g_free (owner->id);
+  g_free (owner->name);
+  g_free (owner);
+}
+
+static MemoryOwner *
+new_owner (GstMemUsageTracer * self, const gchar * kind, gpointer id,
+    const gchar * name)
+{
+  MemoryOwner *owner = g_new0 (MemoryOwner, 1);
+
+  owner->kind = kind;
+  owner->id = g_strdup_printf ("%p", id);
+  owner->name = g_strdup (name);
+  g_ptr_array_add (self->owners, owner);
+
+  return owner;
+}
+
+/* called with the lock for everything but elements. The owners stay with
+ * the tracer, @object can go away before they are reported */
+static MemoryOwner *
+get_object_owner (GstMemUsageTracer * self, GstObject * object,
+    const gchar * kind)
+{
+  MemoryOwner *owner;
+
+  owner = g_object_get_qdata ((GObject *) object, owner_quark);
+  if (G_UNLIKELY (!owner)) {
+    owner = new_owner (self, kind, object, GST_OBJECT_NAME (object));
+    g_object_set_qdata ((GObject *) object, owner_quark, owner);
+  }
+
+  return owner;
+}
+
+/* the element of @pad, NULL for pads of bins. For proxy pads, the element
+ * of the ghost pad */
+static MemoryOwner *
+get_element_owner (GstMemUsageTracer * self, GstPad * pad)
+{
+  GstObject *parent;
+  MemoryOwner *owner;
+
+  if (!pad || !(parent = GST_OBJECT_PARENT (pad)))
+    return NULL;
+  if (GST_IS_PAD (parent) && !(parent = GST_OBJECT_PARENT (parent)))
+    return NULL;
+  if (!GST_IS_ELEMENT (parent) || GST_IS_BIN (parent))
+    return NULL;
+
+  owner = g_object_get_qdata ((GObject *) parent, owner_quark);
+  if (G_LIKELY (owner))
+    return owner;
+
+  g_mutex_lock (&self->lock);
+  owner = get_object_owner (self, parent, "element");
+  g_mutex_unlock (&self->lock);
+
+  return owner;
+}
+
+/* the element running in the current thread, or the unattributed owner.
+ * Called with the lock */
+static MemoryOwner *
+get_current_owner (GstMemUsageTracer * self)
+{
+  ThreadState *state = get_thread_state ();
+  MemoryOwner *owner = NULL;
+
+  if (state->stack->len > 0)
+    owner = g_ptr_array_index (state->stack, state->stack->len - 1);
+  if (!owner)
+    owner = state->loop_owner;
+  if (!owner) {
+    if (G_UNLIKELY (!self->unattributed))
+      self->unattributed = new_owner (self, "unattributed", self,
+          "unattributed");
+    owner = self->unattributed;
+  }
+
+  return owner;
+}
+
+static void
+log_owner (MemoryOwner * owner, GstClockTime ts)
+{
+  gst_tracer_record_log (tr_memory_usage, owner->kind, owner->id, owner->name,
+      owner->live, owner->peak, owner->count, owner->bytes, ts);
+}
+
+/* called with the lock */
+static void
+log_stats (GstMemUsageTracer * self, GstClockTime ts)
+{
+  guint i;
+
+  for (i = 0; i < self->owners->len; i++) {
+    MemoryOwner *owner = g_ptr_array_index (self->owners, i);
+
+    if (owner->active) {
+      owner->active = FALSE;
+      log_owner (owner, ts);
+    }
+  }
+}
+
+/* called with the lock */
+static void
+charge (GstMemUsageTracer * self, guint64 ts, gpointer data,
+    MemoryOwner * owner0, MemoryOwner * owner1, gsize size)
+{
+  Allocation *alloc = g_new (Allocation, 1);
+  guint i;
+
+  alloc->owners[0] = owner0;
+  alloc->owners[1] = owner1;
+  alloc->size = size;
+  /* a leaked allocation whose address was reused would be replaced */
+  g_hash_table_insert (self->allocations, data, alloc);
+
+  for (i = 0; i < G_N_ELEMENTS (alloc->owners); i++) {
+    MemoryOwner *owner = alloc->owners[i];
+
+    if (!owner)
+      continue;
+    owner->live += size;
+    owner->peak = MAX (owner->peak, owner->live);
+    owner->count++;
+    owner->bytes += size;
+    owner->active = TRUE;
+  }
+
+  self->last_ts = ts;
+  if (self->period == 0 || ts < self->next_report)
+    return;
+  if (self->next_report != 0)
+    log_stats (self, ts);
+  /* first call, report one period from now */
+  self->next_report = ts + self->period;
+}
+
+/* called with the lock */
+static void
+uncharge (GstMemUsageTracer * self, gpointer data)
+{
+  Allocation *alloc = g_hash_table_lookup (self->allocations, data);
+  guint i;
+
+  /* allocated before the tracer was there */
+  if (!alloc)
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (alloc->owners); i++) {
+    MemoryOwner *owner = alloc->owners[i];
+
+    if (!owner)
+      continue;
+    owner->live -= MIN (owner->live, alloc->size);
+    owner->active = TRUE;
+  }
+  g_hash_table_remove (self->allocations, data);
+}
+
+static void
+enter (GstMemUsageTracer * self, GstPad * pad)
+{
+  ThreadState *state = get_thread_state ();
+
+  if (state->stack->len == 0) {
+    /* pushing from the loop function of the thread */
+    MemoryOwner *owner = get_element_owner (self, pad);
+
+    if (owner)
+      state->loop_owner = owner;
+  }
+  g_ptr_array_add (state->stack, get_element_owner (self, GST_PAD_PEER (pad)));
+}
+
+static void
+leave (GstMemUsageTracer * self)
+{
+  ThreadState *state = get_thread_state ();
+
+  /* the tracer was added while pushing */
+  if (G_LIKELY (state->stack->len > 0))
+    g_ptr_array_set_size (state->stack, state->stack->len - 1);
+}
+
+/* hooks */
+
+static void
+do_push_buffer_pre (GstMemUsageTracer * self, guint64 ts, GstPad * pad)
+{
+  enter (self, pad);
+}
+
+static void
+do_push_buffer_post (GstMemUsageTracer * self, guint64 ts, GstPad * pad)
+{
+  leave (self);
+}
+
+static void
+do_memory_alloc (GstMemUsageTracer * self, guint64 ts, GstMemory * mem)
+{
+  /* shares the data of the parent */
+  if (mem->parent)
+    return;
+
+  g_mutex_lock (&self->lock);
+  charge (self, ts, mem, get_current_owner (self),
+      get_object_owner (self, GST_OBJECT_CAST (mem->allocator), "allocator"),
+      mem->maxsize);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_memory_free (GstMemUsageTracer * self, guint64 ts, GstMemory * mem)
+{
+  if (mem->parent)
+    return;
+
+  g_mutex_lock (&self->lock);
+  uncharge (self, mem);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_buffer_pool_acquire (GstMemUsageTracer * self, guint64 ts,
+    GstBufferPool * pool, GstBuffer * buffer)
+{
+  gsize size = gst_buffer_get_size (buffer);
+
+  g_mutex_lock (&self->lock);
+  charge (self, ts, buffer, get_object_owner (self, GST_OBJECT_CAST (pool),
+          "pool"), NULL, size);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_buffer_pool_release (GstMemUsageTracer * self, guint64 ts,
+    GstBufferPool * pool, GstBuffer * buffer)
+{
+  g_mutex_lock (&self->lock);
+  uncharge (self, buffer);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_struct_alloc (GstMemUsageTracer * self, guint64 ts, const gchar * name,
+    gpointer data, gsize size)
+{
+  MemoryOwner *owner;
+
+  g_mutex_lock (&self->lock);
+  owner = g_hash_table_lookup (self->structs, name);
+  if (!owner) {
+    owner = new_owner (self, "struct", (gpointer) name, name);
+    g_hash_table_insert (self->structs, (gpointer) name, owner);
+  }
+  charge (self, ts, data, owner, get_current_owner (self), size);
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_struct_free (GstMemUsageTracer * self, guint64 ts, const gchar * name,
+    gpointer data)
+{
+  g_mutex_lock (&self->lock);
+  uncharge (self, data);
+  g_mutex_unlock (&self->lock);
+}
+
+/* tracer class */
+
+static void
+gst_mem_usage_tracer_constructed (GObject * object)
+{
+  GstMemUsageTracer *self = GST_MEM_USAGE_TRACER (object);
+  gchar *params, *tmp;
+  GstStructure *params_struct = NULL;
+  const gchar *name;
+  gint period;
+
+  g_object_get (self, "params", &params, NULL);
+
+  if (!params)
+    return;
+
+  tmp = g_strdup_printf ("memusage,%s", params);
+  params_struct = gst_structure_from_string (tmp, NULL);
+  g_free (tmp);
+  g_free (params);
+  if (!params_struct)
+    return;
+
+  /* Set the name if assigned */
+  name = gst_structure_get_string (params_struct, "name");
+  if (name)
+    gst_object_set_name (GST_OBJECT (self), name);
+
+  if (gst_structure_get_int (params_struct, "period", &period)) {
+    if (period >= 0)
+      self->period = period * GST_MSECOND;
+    else
+      GST_WARNING_OBJECT (self, "Invalid period %d", period);
+  }
+  gst_structure_free (params_struct);
+}
+
+static void
+gst_mem_usage_tracer_finalize (GObject * object)
+{
+  GstMemUsageTracer *self = GST_MEM_USAGE_TRACER (object);
+
+  /* final report */
+  log_stats (self, self->last_ts);
+
+  g_hash_table_unref (self->allocations);
+  g_hash_table_unref (self->structs);
+  g_ptr_array_free (self->owners, TRUE);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_mem_usage_tracer_class_init (GstMemUsageTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_mem_usage_tracer_constructed;
+  gobject_class->finalize = gst_mem_usage_tracer_finalize;
+
+  owner_quark = g_quark_from_static_string ("memusage:owner");
+
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_memory_usage = gst_tracer_record_new ("memory-usage.class",
+      "kind", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "element, allocator, pool, struct or unattributed",
+          NULL),
+      "owner-id", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "address of the owner",
+          NULL),
+      "owner", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "name of the owner",
+          NULL),
+      "live", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "bytes currently allocated",
+          NULL),
+      "peak", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "maximum of the allocated bytes",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "count", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of allocations",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "bytes", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "total size of the allocations",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS,
+          GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the stats have been logged",
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  GST_OBJECT_FLAG_SET (tr_memory_usage, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+}
+
+static void
+gst_mem_usage_tracer_init (GstMemUsageTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->owners = g_ptr_array_new_with_free_func ((GDestroyNotify) free_owner);
+  self->structs = g_hash_table_new (g_str_hash, g_str_equal);
+  self->allocations = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+  self->period = DEFAULT_PERIOD;
+
+  gst_tracing_register_hook (tracer, "pad-push-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-push-post",
+      G_CALLBACK (do_push_buffer_post));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-post",
+      G_CALLBACK (do_push_buffer_post));
+  gst_tracing_register_hook (tracer, "pad-pull-range-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-pull-range-post",
+      G_CALLBACK (do_push_buffer_post));
+  gst_tracing_register_hook (tracer, "memory-alloc",
+      G_CALLBACK (do_memory_alloc));
+  gst_tracing_register_hook (tracer, "memory-free",
+      G_CALLBACK (do_memory_free));
+  gst_tracing_register_hook (tracer, "buffer-pool-acquire",
+      G_CALLBACK (do_buffer_pool_acquire));
+  gst_tracing_register_hook (tracer, "buffer-pool-release",
+      G_CALLBACK (do_buffer_pool_release));
+  gst_tracing_register_hook (tracer, "struct-alloc",
+      G_CALLBACK (do_struct_alloc));
+  gst_tracing_register_hook (tracer, "struct-free",
+      G_CALLBACK (do_struct_free));
+}
@@ -0,0 +1,76 @@
+/* GStreamer
+ *
+ * gstmemusage.h: tracing module that accounts the allocated memory
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_MEM_USAGE_TRACER_H__
+#define __GST_MEM_USAGE_TRACER_H__
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_MEM_USAGE_TRACER \
+  (gst_mem_usage_tracer_get_type())
+#define GST_MEM_USAGE_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_MEM_USAGE_TRACER,GstMemUsageTracer))
+#define GST_MEM_USAGE_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_MEM_USAGE_TRACER,GstMemUsageTracerClass))
+#define GST_IS_MEM_USAGE_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_MEM_USAGE_TRACER))
+#define GST_IS_MEM_USAGE_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_MEM_USAGE_TRACER))
+#define GST_MEM_USAGE_TRACER_CAST(obj) ((GstMemUsageTracer *)(obj))
+
+typedef struct _GstMemUsageTracer GstMemUsageTracer;
+typedef struct _GstMemUsageTracerClass GstMemUsageTracerClass;
+
+/**
+ * GstMemUsageTracer:
+ *
+ * Opaque #GstMemUsageTracer data structure
+ */
+struct _GstMemUsageTracer {
+  GstTracer 	 parent;
+
+  /*< private >*/
+  GMutex lock;
+  /* MemoryOwner of all elements, pools, allocators and structures */
+  GPtrArray *owners;
+  /* struct name -> MemoryOwner */
+  GHashTable *structs;
+  /* memory, pooled buffer or structure -> Allocation */
+  GHashTable *allocations;
+  /* MemoryOwner of the allocations outside of any element */
+  gpointer unattributed;
+  /* report every period, 0 to only report when the tracer is finalized */
+  GstClockTime period;
+  GstClockTime next_report;
+  GstClockTime last_ts;
+};
+
+struct _GstMemUsageTracerClass {
+  GstTracerClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_mem_usage_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_MEM_USAGE_TRACER_H__ */
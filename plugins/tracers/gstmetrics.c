@@ -0,0 +1,894 @@
+/* GStreamer
+ *
+ * gstmetrics.c: tracing module that exports pipeline metrics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:tracer-metrics
+ * @short_description: export pipeline metrics for scraping
+ *
+ * A tracing module that aggregates metrics of all pipelines in memory and
+ * serves them in the OpenMetrics text format, as understood by Prometheus,
+ * over HTTP:
+ *
+ * - buffers, bytes and a buffer size histogram per sink element
+ * - the latency configured on the sinks
+ * - the processed and dropped buffers reported in QoS messages
+ * - the current level of queue, queue2 and multiqueue elements
+ * - the buffering percentage of the elements posting buffering messages
+ *
+ * All values are labeled with the names of the top-level pipeline and the
+ * element.
+ *
+ * The counters are updated in a per-thread slot of each element, without
+ * any locking on the data path, and only summed up when scraped.
+ *
+ * Parameters:
+ * - 'address': the address to listen on, 127.0.0.1 by default
+ * - 'port': the TCP port to listen on, 9090 by default
+ * - 'socket': the path of a unix socket to listen on instead
+ *
+ * ```
+ * GST_TRACERS="metrics(port=9100)" gst-launch-1.0 ...
+ * curl http://127.0.0.1:9100/metrics
+ * ```
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstmetrics.h"
+
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gio/gnetworking.h>
+#ifdef G_OS_UNIX
+#include <gio/gunixsocketaddress.h>
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (gst_metrics_debug);
+#define GST_CAT_DEFAULT gst_metrics_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_metrics_debug, "metrics", 0, \
+        "metrics tracer");
+#define gst_metrics_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstMetricsTracer, gst_metrics_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+#define DEFAULT_ADDRESS "127.0.0.1"
+#define DEFAULT_PORT 9090
+
+#define MAX_REQUEST_SIZE 4096
+
+/* upper bounds of the buffer size histogram buckets, in bytes */
+static const guint64 size_buckets[] = {
+  64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304
+};
+
+#define N_SIZE_BUCKETS G_N_ELEMENTS (size_buckets)
+
+static GQuark metrics_quark;
+
+/* Counters of one thread, only written by that thread */
+typedef struct _GstMetricsSlot GstMetricsSlot;
+struct _GstMetricsSlot
+{
+  GstMetricsSlot *next;
+
+  guint64 buffers;
+  guint64 bytes;
+  guint64 sizes[N_SIZE_BUCKETS + 1];
+};
+
+typedef struct
+{
+  GWeakRef element;
+  gchar *name;
+  /* top-level bin when the element was first seen */
+  gchar *pipeline;
+  gboolean is_sink;
+  gboolean is_queue;
+  gboolean is_multiqueue;
+
+  /* prepended atomically, freed with the tracer */
+  GstMetricsSlot *slots;
+
+  /* the rest is rarely updated, with the tracer lock */
+  gboolean have_latency;
+  GstClockTime latency;
+  gboolean have_qos;
+  guint64 qos_processed;
+  guint64 qos_dropped;
+  gint buffering;
+} GstElementMetrics;
+
+/* GstElementMetrics -> GstMetricsSlot of the current thread */
+static GPrivate thread_slots = G_PRIVATE_INIT ((GDestroyNotify)
+    g_hash_table_unref);
+
+/* data helpers */
+
+static gchar *
+get_pipeline_name (GstElement * element)
+{
+  GstObject *top = gst_object_ref (element), *parent;
+  gchar *name;
+
+  while ((parent = gst_object_get_parent (top))) {
+    gst_object_unref (top);
+    top = parent;
+  }
+  name = gst_object_get_name (top);
+  gst_object_unref (top);
+
+  return name;
+}
+
+static GstElementMetrics *
+get_element_metrics (GstMetricsTracer * self, GstElement * element)
+{
+  GstElementMetrics *metrics;
+
+  metrics = g_object_get_qdata ((GObject *) element, metrics_quark);
+  if (G_LIKELY (metrics))
+    return metrics;
+
+  g_mutex_lock (&self->lock);
+  metrics = g_object_get_qdata ((GObject *) element, metrics_quark);
+  if (!metrics) {
+    GstElementFactory *factory = gst_element_get_factory (element);
+    const gchar *factory_name = factory ? GST_OBJECT_NAME (factory) : NULL;
+
+    metrics = g_new0 (GstElementMetrics, 1);
+    g_weak_ref_init (&metrics->element, element);
+    metrics->name = gst_element_get_name (element);
+    metrics->pipeline = get_pipeline_name (element);
+    metrics->is_sink = GST_OBJECT_FLAG_IS_SET (element, GST_ELEMENT_FLAG_SINK);
+    metrics->is_queue = !g_strcmp0 (factory_name, "queue") ||
+        !g_strcmp0 (factory_name, "queue2");
+    metrics->is_multiqueue = !g_strcmp0 (factory_name, "multiqueue");
+    metrics->buffering = -1;
+    /* owned by the tracer, the element can go away before it is scraped */
+    g_object_set_qdata ((GObject *) element, metrics_quark, metrics);
+    g_ptr_array_add (self->elements, metrics);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return metrics;
+}
+
+static void
+free_element_metrics (GstElementMetrics * metrics)
+{
+  GstMetricsSlot *slot, *next;
+
+  for (slot = metrics->slots; slot; slot = next) {
+    next = slot->next;
+    g_free (slot);
+  }
+  g_weak_ref_clear (&metrics->element);
+  g_free (metrics->name);
+  g_free (metrics->pipeline);
+  g_free (metrics);
+}
+
+static GstMetricsSlot *
+get_thread_slot (GstElementMetrics * metrics)
+{
+  GHashTable *slots = g_private_get (&thread_slots);
+  GstMetricsSlot *slot;
+
+  if (G_UNLIKELY (!slots)) {
+    slots = g_hash_table_new (NULL, NULL);
+    g_private_set (&thread_slots, slots);
+  }
+
+  slot = g_hash_table_lookup (slots, metrics);
+  if (G_UNLIKELY (!slot)) {
+    slot = g_new0 (GstMetricsSlot, 1);
+    do {
+      slot->next = g_atomic_pointer_get (&metrics->slots);
+    } while (!g_atomic_pointer_compare_and_exchange (&metrics->slots,
+            slot->next, slot));
+    g_hash_table_insert (slots, metrics, slot);
+  }
+
+  return slot;
+}
+
+static GstElement *
+get_peer_element (GstPad * pad)
+{
+  GstPad *peer = GST_PAD_PEER (pad);
+  GstObject *parent;
+
+  if (!peer || !(parent = GST_OBJECT_PARENT (peer)))
+    return NULL;
+  /* proxy pads of ghost pads are not interesting, they're bins */
+  if (!GST_IS_ELEMENT (parent) || GST_IS_BIN (parent))
+    return NULL;
+
+  return GST_ELEMENT_CAST (parent);
+}
+
+static void
+count_buffer (GstMetricsSlot * slot, gsize size)
+{
+  guint i;
+
+  for (i = 0; i < N_SIZE_BUCKETS && size > size_buckets[i]; i++);
+
+  slot->buffers++;
+  slot->bytes += size;
+  slot->sizes[i]++;
+}
+
+/* hooks */
+
+static void
+do_push_buffer_pre (GstMetricsTracer * self, guint64 ts, GstPad * pad,
+    GstBuffer * buffer)
+{
+  GstElement *peer = get_peer_element (pad);
+  GstElementMetrics *metrics;
+
+  if (!peer)
+    return;
+
+  /* registers the queues for their levels too */
+  metrics = get_element_metrics (self, peer);
+  if (!metrics->is_sink)
+    return;
+
+  count_buffer (get_thread_slot (metrics), gst_buffer_get_size (buffer));
+}
+
+static gboolean
+count_list_item (GstBuffer ** buffer, guint idx, gpointer user_data)
+{
+  count_buffer (user_data, gst_buffer_get_size (*buffer));
+  return TRUE;
+}
+
+static void
+do_push_buffer_list_pre (GstMetricsTracer * self, guint64 ts, GstPad * pad,
+    GstBufferList * list)
+{
+  GstElement *peer = get_peer_element (pad);
+  GstElementMetrics *metrics;
+
+  if (!peer || !GST_OBJECT_FLAG_IS_SET (peer, GST_ELEMENT_FLAG_SINK))
+    return;
+
+  metrics = get_element_metrics (self, peer);
+  gst_buffer_list_foreach (list, count_list_item, get_thread_slot (metrics));
+}
+
+static void
+do_push_event_pre (GstMetricsTracer * self, guint64 ts, GstPad * pad,
+    GstEvent * event)
+{
+  GstObject *parent;
+  GstElementMetrics *metrics;
+  GstClockTime latency;
+
+  if (GST_EVENT_TYPE (event) != GST_EVENT_LATENCY)
+    return;
+
+  /* sent upstream by the sinks when the pipeline latency is configured */
+  parent = GST_OBJECT_PARENT (pad);
+  if (!parent || !GST_IS_ELEMENT (parent) ||
+      !GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SINK))
+    return;
+
+  gst_event_parse_latency (event, &latency);
+  metrics = get_element_metrics (self, GST_ELEMENT_CAST (parent));
+  g_mutex_lock (&self->lock);
+  metrics->have_latency = TRUE;
+  metrics->latency = latency;
+  g_mutex_unlock (&self->lock);
+}
+
+static void
+do_post_message_pre (GstMetricsTracer * self, guint64 ts, GstElement * element,
+    GstMessage * msg)
+{
+  GstElementMetrics *metrics;
+
+  switch (GST_MESSAGE_TYPE (msg)) {
+    case GST_MESSAGE_QOS:{
+      GstFormat format;
+      guint64 processed, dropped;
+
+      gst_message_parse_qos_stats (msg, &format, &processed, &dropped);
+      if (format != GST_FORMAT_BUFFERS && format != GST_FORMAT_DEFAULT)
+        return;
+
+      metrics = get_element_metrics (self, element);
+      g_mutex_lock (&self->lock);
+      metrics->have_qos = TRUE;
+      if (GST_CLOCK_TIME_IS_VALID (processed))
+        metrics->qos_processed = processed;
+      if (GST_CLOCK_TIME_IS_VALID (dropped))
+        metrics->qos_dropped = dropped;
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+    case GST_MESSAGE_BUFFERING:{
+      gint percent;
+
+      gst_message_parse_buffering (msg, &percent);
+      metrics = get_element_metrics (self, element);
+      g_mutex_lock (&self->lock);
+      metrics->buffering = percent;
+      g_mutex_unlock (&self->lock);
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/* exposition */
+
+static void
+append_labels (GString * s, GstElementMetrics * metrics,
+    const gchar * pipeline)
+{
+  const gchar *names[] = { "pipeline", "element" };
+  const gchar *values[] = { pipeline, metrics->name };
+  guint i;
+
+  g_string_append_c (s, '{');
+  for (i = 0; i < G_N_ELEMENTS (names); i++) {
+    const gchar *c;
+
+    g_string_append_printf (s, "%s%s=\"", i ? "," : "", names[i]);
+    for (c = values[i] ? values[i] : ""; *c; c++) {
+      if (*c == '\\' || *c == '"')
+        g_string_append_c (s, '\\');
+      if (*c == '\n')
+        g_string_append (s, "\\n");
+      else
+        g_string_append_c (s, *c);
+    }
+    g_string_append_c (s, '"');
+  }
+}
+
+static void
+append_sample (GString * s, const gchar * name, GstElementMetrics * metrics,
+    const gchar * pipeline, const gchar * extra_label, const gchar * value)
+{
+  g_string_append (s, name);
+  append_labels (s, metrics, pipeline);
+  if (extra_label)
+    g_string_append_printf (s, ",%s", extra_label);
+  g_string_append_printf (s, "} %s\n", value);
+}
+
+static void
+append_uint (GString * s, const gchar * name, GstElementMetrics * metrics,
+    const gchar * pipeline, guint64 value)
+{
+  gchar str[32];
+
+  g_snprintf (str, sizeof (str), "%" G_GUINT64_FORMAT, value);
+  append_sample (s, name, metrics, pipeline, NULL, str);
+}
+
+static void
+append_seconds (GString * s, const gchar * name, GstElementMetrics * metrics,
+    const gchar * pipeline, GstClockTime value)
+{
+  gchar str[G_ASCII_DTOSTR_BUF_SIZE];
+
+  g_ascii_dtostr (str, sizeof (str), (gdouble) value / GST_SECOND);
+  append_sample (s, name, metrics, pipeline, NULL, str);
+}
+
+typedef struct
+{
+  GstElementMetrics *metrics;
+  gchar *pipeline;
+
+  /* summed up slots */
+  guint64 buffers;
+  guint64 bytes;
+  guint64 sizes[N_SIZE_BUCKETS + 1];
+
+  /* copied with the lock */
+  gboolean have_latency;
+  GstClockTime latency;
+  gboolean have_qos;
+  guint64 qos_processed;
+  guint64 qos_dropped;
+  gint buffering;
+
+  /* read from the element */
+  gboolean have_level;
+  guint level_buffers;
+  guint level_bytes;
+  GstClockTime level_time;
+} Snapshot;
+
+static void
+read_queue_level (Snapshot * snap, GstElement * element)
+{
+  if (snap->metrics->is_queue) {
+    g_object_get (element, "current-level-buffers", &snap->level_buffers,
+        "current-level-bytes", &snap->level_bytes,
+        "current-level-time", &snap->level_time, NULL);
+    snap->have_level = TRUE;
+  } else if (snap->metrics->is_multiqueue) {
+    GstStructure *stats = NULL;
+    const GValue *queues;
+    guint i;
+
+    g_object_get (element, "stats", &stats, NULL);
+    if (!stats)
+      return;
+
+    /* the sum of all the single queues */
+    queues = gst_structure_get_value (stats, "queues");
+    for (i = 0; queues && i < gst_value_array_get_size (queues); i++) {
+      const GstStructure *q =
+          gst_value_get_structure (gst_value_array_get_value (queues, i));
+      guint buffers = 0, bytes = 0;
+      guint64 time = 0;
+
+      gst_structure_get (q, "buffers", G_TYPE_UINT, &buffers,
+          "bytes", G_TYPE_UINT, &bytes, "time", G_TYPE_UINT64, &time, NULL);
+      snap->level_buffers += buffers;
+      snap->level_bytes += bytes;
+      snap->level_time += time;
+    }
+    snap->have_level = TRUE;
+    gst_structure_free (stats);
+  }
+}
+
+static GArray *
+take_snapshots (GstMetricsTracer * self)
+{
+  GArray *snaps = g_array_new (FALSE, TRUE, sizeof (Snapshot));
+  guint i;
+
+  g_mutex_lock (&self->lock);
+  g_array_set_size (snaps, self->elements->len);
+  for (i = 0; i < self->elements->len; i++) {
+    GstElementMetrics *metrics = g_ptr_array_index (self->elements, i);
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+    GstMetricsSlot *slot;
+    guint j;
+
+    snap->metrics = metrics;
+    /* concurrent updates are only seen in the next scrape */
+    for (slot = g_atomic_pointer_get (&metrics->slots); slot;
+        slot = slot->next) {
+      snap->buffers += slot->buffers;
+      snap->bytes += slot->bytes;
+      for (j = 0; j <= N_SIZE_BUCKETS; j++)
+        snap->sizes[j] += slot->sizes[j];
+    }
+    snap->have_latency = metrics->have_latency;
+    snap->latency = metrics->latency;
+    snap->have_qos = metrics->have_qos;
+    snap->qos_processed = metrics->qos_processed;
+    snap->qos_dropped = metrics->qos_dropped;
+    snap->buffering = metrics->buffering;
+  }
+  g_mutex_unlock (&self->lock);
+
+  /* without the lock, getting the properties takes the element locks */
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+    GstElement *element = g_weak_ref_get (&snap->metrics->element);
+
+    if (element) {
+      snap->pipeline = get_pipeline_name (element);
+      read_queue_level (snap, element);
+      gst_object_unref (element);
+    } else {
+      snap->pipeline = g_strdup (snap->metrics->pipeline);
+    }
+  }
+
+  return snaps;
+}
+
+static gchar *
+build_metrics (GstMetricsTracer * self)
+{
+  GArray *snaps = take_snapshots (self);
+  GString *s = g_string_sized_new (4096);
+  guint i, j;
+
+  g_string_append (s, "# TYPE gst_sink_buffers counter\n"
+      "# HELP gst_sink_buffers Buffers received by the sink\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->metrics->is_sink)
+      append_uint (s, "gst_sink_buffers_total", snap->metrics, snap->pipeline,
+          snap->buffers);
+  }
+
+  g_string_append (s, "# TYPE gst_sink_bytes counter\n"
+      "# UNIT gst_sink_bytes bytes\n"
+      "# HELP gst_sink_bytes Bytes received by the sink\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->metrics->is_sink)
+      append_uint (s, "gst_sink_bytes_total", snap->metrics, snap->pipeline,
+          snap->bytes);
+  }
+
+  g_string_append (s, "# TYPE gst_sink_buffer_size_bytes histogram\n"
+      "# UNIT gst_sink_buffer_size_bytes bytes\n"
+      "# HELP gst_sink_buffer_size_bytes Sizes of the buffers received by "
+      "the sink\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+    guint64 count = 0;
+    gchar le[32], value[32];
+
+    if (!snap->metrics->is_sink)
+      continue;
+
+    for (j = 0; j <= N_SIZE_BUCKETS; j++) {
+      count += snap->sizes[j];
+      if (j < N_SIZE_BUCKETS)
+        g_snprintf (le, sizeof (le), "le=\"%" G_GUINT64_FORMAT "\"",
+            size_buckets[j]);
+      else
+        g_strlcpy (le, "le=\"+Inf\"", sizeof (le));
+      g_snprintf (value, sizeof (value), "%" G_GUINT64_FORMAT, count);
+      append_sample (s, "gst_sink_buffer_size_bytes_bucket", snap->metrics,
+          snap->pipeline, le, value);
+    }
+    append_uint (s, "gst_sink_buffer_size_bytes_count", snap->metrics,
+        snap->pipeline, count);
+    append_uint (s, "gst_sink_buffer_size_bytes_sum", snap->metrics,
+        snap->pipeline, snap->bytes);
+  }
+
+  g_string_append (s, "# TYPE gst_sink_latency_seconds gauge\n"
+      "# UNIT gst_sink_latency_seconds seconds\n"
+      "# HELP gst_sink_latency_seconds Latency configured on the sink\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_latency)
+      append_seconds (s, "gst_sink_latency_seconds", snap->metrics,
+          snap->pipeline, snap->latency);
+  }
+
+  g_string_append (s, "# TYPE gst_qos_processed counter\n"
+      "# HELP gst_qos_processed Buffers processed as reported in QoS "
+      "messages\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_qos)
+      append_uint (s, "gst_qos_processed_total", snap->metrics,
+          snap->pipeline, snap->qos_processed);
+  }
+
+  g_string_append (s, "# TYPE gst_qos_dropped counter\n"
+      "# HELP gst_qos_dropped Buffers dropped as reported in QoS "
+      "messages\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_qos)
+      append_uint (s, "gst_qos_dropped_total", snap->metrics,
+          snap->pipeline, snap->qos_dropped);
+  }
+
+  g_string_append (s, "# TYPE gst_queue_level_buffers gauge\n"
+      "# HELP gst_queue_level_buffers Buffers currently in the queue\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_level)
+      append_uint (s, "gst_queue_level_buffers", snap->metrics,
+          snap->pipeline, snap->level_buffers);
+  }
+
+  g_string_append (s, "# TYPE gst_queue_level_bytes gauge\n"
+      "# UNIT gst_queue_level_bytes bytes\n"
+      "# HELP gst_queue_level_bytes Bytes currently in the queue\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_level)
+      append_uint (s, "gst_queue_level_bytes", snap->metrics,
+          snap->pipeline, snap->level_bytes);
+  }
+
+  g_string_append (s, "# TYPE gst_queue_level_seconds gauge\n"
+      "# UNIT gst_queue_level_seconds seconds\n"
+      "# HELP gst_queue_level_seconds Amount of data currently in the "
+      "queue\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->have_level)
+      append_seconds (s, "gst_queue_level_seconds", snap->metrics,
+          snap->pipeline, snap->level_time);
+  }
+
+  g_string_append (s, "# TYPE gst_buffering_percent gauge\n"
+      "# HELP gst_buffering_percent Last reported buffering percentage\n");
+  for (i = 0; i < snaps->len; i++) {
+    Snapshot *snap = &g_array_index (snaps, Snapshot, i);
+
+    if (snap->buffering >= 0)
+      append_uint (s, "gst_buffering_percent", snap->metrics,
+          snap->pipeline, snap->buffering);
+  }
+
+  g_string_append (s, "# EOF\n");
+
+  for (i = 0; i < snaps->len; i++)
+    g_free (g_array_index (snaps, Snapshot, i).pipeline);
+  g_array_free (snaps, TRUE);
+
+  return g_string_free (s, FALSE);
+}
+
+/* server */
+
+static gboolean
+send_all (GSocket * socket, const gchar * data, gsize len,
+    GCancellable * cancellable)
+{
+  while (len > 0) {
+    gssize res = g_socket_send (socket, data, len, cancellable, NULL);
+
+    if (res <= 0)
+      return FALSE;
+    data += res;
+    len -= res;
+  }
+  return TRUE;
+}
+
+static void
+handle_connection (GstMetricsTracer * self, GSocket * conn)
+{
+  gchar request[MAX_REQUEST_SIZE + 1];
+  gsize len = 0;
+  gchar *body = NULL, *header;
+
+  /* a slow client can't block the server for long */
+  g_socket_set_timeout (conn, 5);
+
+  while (len < MAX_REQUEST_SIZE) {
+    gssize res = g_socket_receive (conn, request + len,
+        MAX_REQUEST_SIZE - len, self->cancellable, NULL);
+
+    if (res <= 0)
+      return;
+    len += res;
+    request[len] = '\0';
+    if (strstr (request, "\r\n\r\n") || strstr (request, "\n\n"))
+      break;
+  }
+
+  if (g_str_has_prefix (request, "GET /metrics ") ||
+      g_str_has_prefix (request, "GET / ")) {
+    body = build_metrics (self);
+    header = g_strdup_printf ("HTTP/1.0 200 OK\r\n"
+        "Content-Type: application/openmetrics-text; version=1.0.0; "
+        "charset=utf-8\r\n"
+        "Content-Length: %" G_GSIZE_FORMAT "\r\n"
+        "Connection: close\r\n\r\n", strlen (body));
+  } else {
+    header = g_strdup ("HTTP/1.0 404 Not Found\r\n"
+        "Content-Length: 0\r\nConnection: close\r\n\r\n");
+  }
+
+  if (send_all (conn, header, strlen (header), self->cancellable) && body)
+    send_all (conn, body, strlen (body), self->cancellable);
+
+  g_free (header);
+  g_free (body);
+}
+
+static gpointer
+server_thread (GstMetricsTracer * self)
+{
+  GError *err = NULL;
+
+  while (!g_cancellable_is_cancelled (self->cancellable)) {
+    GSocket *conn = g_socket_accept (self->socket, self->cancellable, &err);
+
+    if (!conn) {
+      if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        GST_WARNING_OBJECT (self, "failed to accept: %s", err->message);
+      g_clear_error (&err);
+      continue;
+    }
+
+    handle_connection (self, conn);
+    g_socket_close (conn, NULL);
+    g_object_unref (conn);
+  }
+
+  return NULL;
+}
+
+static gboolean
+start_server (GstMetricsTracer * self, const gchar * address, gint port)
+{
+  GSocketAddress *saddr = NULL;
+  GSocketFamily family;
+  GError *err = NULL;
+
+  if (self->socket_path) {
+#ifdef G_OS_UNIX
+    g_unlink (self->socket_path);
+    saddr = g_unix_socket_address_new (self->socket_path);
+#else
+    GST_ERROR_OBJECT (self, "unix sockets are not supported");
+    return FALSE;
+#endif
+  } else {
+    GInetAddress *iaddr = g_inet_address_new_from_string (address);
+
+    if (!iaddr) {
+      GST_ERROR_OBJECT (self, "invalid address '%s'", address);
+      return FALSE;
+    }
+    saddr = g_inet_socket_address_new (iaddr, port);
+    g_object_unref (iaddr);
+  }
+
+  family = g_socket_address_get_family (saddr);
+  self->socket = g_socket_new (family, G_SOCKET_TYPE_STREAM,
+      G_SOCKET_PROTOCOL_DEFAULT, &err);
+  if (!self->socket)
+    goto failed;
+
+  if (family != G_SOCKET_FAMILY_UNIX)
+    g_socket_set_option (self->socket, SOL_SOCKET, SO_REUSEADDR, TRUE, NULL);
+
+  if (!g_socket_bind (self->socket, saddr, TRUE, &err) ||
+      !g_socket_listen (self->socket, &err))
+    goto failed;
+  g_object_unref (saddr);
+
+  self->cancellable = g_cancellable_new ();
+  self->thread = g_thread_new ("GstMetricsTracer",
+      (GThreadFunc) server_thread, self);
+
+  return TRUE;
+
+failed:
+  {
+    GST_ERROR_OBJECT (self, "failed to listen: %s", err->message);
+    g_clear_error (&err);
+    g_clear_object (&self->socket);
+    g_object_unref (saddr);
+    return FALSE;
+  }
+}
+
+/* tracer class */
+
+static void
+gst_metrics_tracer_constructed (GObject * object)
+{
+  GstMetricsTracer *self = GST_METRICS_TRACER (object);
+  gchar *params, *tmp;
+  GstStructure *params_struct = NULL;
+  const gchar *address = DEFAULT_ADDRESS;
+  gint port = DEFAULT_PORT;
+
+  G_OBJECT_CLASS (parent_class)->constructed (object);
+
+  g_object_get (self, "params", &params, NULL);
+  if (params) {
+    tmp = g_strdup_printf ("metrics,%s", params);
+    params_struct = gst_structure_from_string (tmp, NULL);
+    g_free (tmp);
+    g_free (params);
+  }
+
+  if (params_struct) {
+    const gchar *name, *value;
+
+    /* Set the name if assigned */
+    name = gst_structure_get_string (params_struct, "name");
+    if (name)
+      gst_object_set_name (GST_OBJECT (self), name);
+
+    if ((value = gst_structure_get_string (params_struct, "address")))
+      address = value;
+    if (!gst_structure_get_int (params_struct, "port", &port))
+      port = DEFAULT_PORT;
+    self->socket_path =
+        g_strdup (gst_structure_get_string (params_struct, "socket"));
+  }
+
+  start_server (self, address, port);
+
+  if (params_struct)
+    gst_structure_free (params_struct);
+}
+
+static void
+gst_metrics_tracer_finalize (GObject * object)
+{
+  GstMetricsTracer *self = GST_METRICS_TRACER (object);
+
+  if (self->thread) {
+    g_cancellable_cancel (self->cancellable);
+    g_thread_join (self->thread);
+    self->thread = NULL;
+  }
+  g_clear_object (&self->cancellable);
+  if (self->socket) {
+    g_socket_close (self->socket, NULL);
+    g_clear_object (&self->socket);
+#ifdef G_OS_UNIX
+    if (self->socket_path)
+      g_unlink (self->socket_path);
+#endif
+  }
+  g_free (self->socket_path);
+
+  g_ptr_array_free (self->elements, TRUE);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_metrics_tracer_class_init (GstMetricsTracerClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->constructed = gst_metrics_tracer_constructed;
+  gobject_class->finalize = gst_metrics_tracer_finalize;
+
+  metrics_quark = g_quark_from_static_string ("metrics:element");
+}
+
+static void
+gst_metrics_tracer_init (GstMetricsTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  g_mutex_init (&self->lock);
+  self->elements =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) free_element_metrics);
+
+  gst_tracing_register_hook (tracer, "pad-push-pre",
+      G_CALLBACK (do_push_buffer_pre));
+  gst_tracing_register_hook (tracer, "pad-push-list-pre",
+      G_CALLBACK (do_push_buffer_list_pre));
+  gst_tracing_register_hook (tracer, "pad-push-event-pre",
+      G_CALLBACK (do_push_event_pre));
+  gst_tracing_register_hook (tracer, "element-post-message-pre",
+      G_CALLBACK (do_post_message_pre));
+}
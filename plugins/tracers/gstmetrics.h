@@ -0,0 +1,72 @@
+/* GStreamer
+ *
+ * gstmetrics.h: tracing module that exports pipeline metrics
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_METRICS_TRACER_H__
+#define __GST_METRICS_TRACER_H__
+
+#include <gst/gst.h>
+#include <gst/gsttracer.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_METRICS_TRACER \
+  (gst_metrics_tracer_get_type())
+#define GST_METRICS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_METRICS_TRACER,GstMetricsTracer))
+#define GST_METRICS_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_METRICS_TRACER,GstMetricsTracerClass))
+#define GST_IS_METRICS_TRACER(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_METRICS_TRACER))
+#define GST_IS_METRICS_TRACER_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_METRICS_TRACER))
+#define GST_METRICS_TRACER_CAST(obj) ((GstMetricsTracer *)(obj))
+
+typedef struct _GstMetricsTracer GstMetricsTracer;
+typedef struct _GstMetricsTracerClass GstMetricsTracerClass;
+
+/**
+ * GstMetricsTracer:
+ *
+ * Opaque #GstMetricsTracer data structure
+ */
+struct _GstMetricsTracer {
+  GstTracer 	 parent;
+
+  /*< private >*/
+  GMutex lock;
+  /* GstElementMetrics of all elements seen so far */
+  GPtrArray *elements;
+
+  GSocket *socket;
+  gchar *socket_path;
+  GCancellable *cancellable;
+  GThread *thread;
+};
+
+struct _GstMetricsTracerClass {
+  GstTracerClass parent_class;
+};
+
+G_GNUC_INTERNAL GType gst_metrics_tracer_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_METRICS_TRACER_H__ */
@@ -23,6 +23,22 @@
  * @short_description: log event stats
  *
  * A tracing module that builds usage statistic for elements and pads.
+ *
+ * The buffer statistics can be limited to a bounded overhead, so that the
+ * tracer can be left enabled in production:
+ *
+ * - 'sample-interval': only log every Nth buffer of each pad
+ * - 'sample-period': log at most one buffer per pad every this many
+ *   milliseconds
+ * - 'elements': only log the buffers pushed or pulled by the elements whose
+ *   names match one of these '+' separated patterns
+ *
+ * ```
+ * GST_TRACERS="stats(sample-interval=100,elements=queue*+vsink)" ...
+ * ```
+ *
+ * With sampling the buffer totals reported by gst-stats only cover the
+ * sampled buffers.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -39,6 +55,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_stats_debug);
 static GQuark data_quark;
 G_LOCK_DEFINE (_elem_stats);
 G_LOCK_DEFINE (_pad_stats);
+G_LOCK_DEFINE (_numa_stats);
 
 #define _do_init \
     GST_DEBUG_CATEGORY_INIT (gst_stats_debug, "stats", 0, "stats tracer"); \
@@ -54,6 +71,7 @@ static GstTracerRecord *tr_element_query;
 static GstTracerRecord *tr_event;
 static GstTracerRecord *tr_message;
 static GstTracerRecord *tr_query;
+static GstTracerRecord *tr_numa_memory;
 
 typedef struct
 {
@@ -63,6 +81,8 @@ typedef struct
   GstClockTime last_ts;
   /* hierarchy */
   guint parent_ix;
+  /* for the "sample-interval" and "sample-period" parameters */
+  GstTracerSamplerState sampling;
 } GstPadStats;
 
 typedef struct
@@ -356,13 +376,33 @@ do_element_stats (GstStatsTracer * self, GstPad * pad, GstClockTime elapsed1,
 
 /* hooks */
 
+static inline gboolean
+sample_buffer (GstStatsTracer * self, GstPadStats * this_pad_stats,
+    guint64 ts)
+{
+  if (!GST_TRACER_SAMPLER_IS_SAMPLING (&self->sampler))
+    return TRUE;
+
+  return gst_tracer_sampler_sample (&self->sampler, &this_pad_stats->sampling,
+      ts);
+}
+
 static void
 do_push_buffer_pre (GstStatsTracer * self, guint64 ts, GstPad * this_pad,
     GstBuffer * buffer)
 {
-  GstPadStats *this_pad_stats = get_pad_stats (self, this_pad);
-  GstPad *that_pad = GST_PAD_PEER (this_pad);
-  GstPadStats *that_pad_stats = get_pad_stats (self, that_pad);
+  GstPadStats *this_pad_stats;
+  GstPad *that_pad;
+  GstPadStats *that_pad_stats;
+
+  if (!gst_tracer_sampler_filter_pad (&self->sampler, this_pad))
+    return;
+  this_pad_stats = get_pad_stats (self, this_pad);
+  if (!sample_buffer (self, this_pad_stats, ts))
+    return;
+
+  that_pad = GST_PAD_PEER (this_pad);
+  that_pad_stats = get_pad_stats (self, that_pad);
 
   do_buffer_stats (self, this_pad, this_pad_stats, that_pad, that_pad_stats,
       buffer, ts);
@@ -401,12 +441,26 @@ static void
 do_push_buffer_list_pre (GstStatsTracer * self, guint64 ts, GstPad * this_pad,
     GstBufferList * list)
 {
-  GstPadStats *this_pad_stats = get_pad_stats (self, this_pad);
-  GstPad *that_pad = GST_PAD_PEER (this_pad);
-  GstPadStats *that_pad_stats = get_pad_stats (self, that_pad);
-  DoPushBufferListArgs args = { self, this_pad, this_pad_stats, that_pad,
-    that_pad_stats, ts
-  };
+  GstPadStats *this_pad_stats;
+  GstPad *that_pad;
+  GstPadStats *that_pad_stats;
+  DoPushBufferListArgs args;
+
+  if (!gst_tracer_sampler_filter_pad (&self->sampler, this_pad))
+    return;
+  this_pad_stats = get_pad_stats (self, this_pad);
+  /* the whole list is sampled or not */
+  if (!sample_buffer (self, this_pad_stats, ts))
+    return;
+
+  that_pad = GST_PAD_PEER (this_pad);
+  that_pad_stats = get_pad_stats (self, that_pad);
+  args.self = self;
+  args.this_pad = this_pad;
+  args.this_pad_stats = this_pad_stats;
+  args.that_pad = that_pad;
+  args.that_pad_stats = that_pad_stats;
+  args.ts = ts;
 
   gst_buffer_list_foreach (list, do_push_buffer_list_item, &args);
 }
@@ -436,7 +490,8 @@ do_pull_range_post (GstStatsTracer * self, guint64 ts, GstPad * this_pad,
   GstPad *that_pad = GST_PAD_PEER (this_pad);
   GstPadStats *that_pad_stats = get_pad_stats (self, that_pad);
 
-  if (buffer != NULL) {
+  if (buffer != NULL && gst_tracer_sampler_filter_pad (&self->sampler,
+          this_pad) && sample_buffer (self, this_pad_stats, ts)) {
     do_buffer_stats (self, this_pad, this_pad_stats, that_pad, that_pad_stats,
         buffer, ts);
   }
@@ -494,6 +549,25 @@ do_element_query_pre (GstStatsTracer * self, guint64 ts, GstElement * elem,
       GST_QUERY_TYPE_NAME (qry));
 }
 
+static void
+do_memory_numa_access (GstStatsTracer * self, guint64 ts, GstMemory * mem,
+    gint memory_node, gint thread_node)
+{
+  guint64 hits, misses;
+
+  G_LOCK (_numa_stats);
+  if (memory_node == thread_node)
+    self->numa_hits++;
+  else
+    self->numa_misses++;
+  hits = self->numa_hits;
+  misses = self->numa_misses;
+  G_UNLOCK (_numa_stats);
+
+  gst_tracer_record_log (tr_numa_memory, (guint64) (guintptr) g_thread_self (),
+      ts, memory_node, thread_node, hits, misses);
+}
+
 static void
 do_query_pre (GstStatsTracer * self, guint64 ts, GstPad * this_pad,
     GstQuery * qry)
@@ -543,15 +617,28 @@ gst_stats_tracer_constructed (GObject * object)
   name = gst_structure_get_string (params_struct, "name");
   if (name)
     gst_object_set_name (GST_OBJECT (self), name);
+
+  gst_tracer_sampler_configure (&self->sampler, params_struct);
   gst_structure_free (params_struct);
 }
 
+static void
+gst_stats_tracer_finalize (GObject * object)
+{
+  GstStatsTracer *self = GST_STATS_TRACER (object);
+
+  gst_tracer_sampler_clear (&self->sampler);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_stats_tracer_class_init (GstStatsTracerClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->constructed = gst_stats_tracer_constructed;
+  gobject_class->finalize = gst_stats_tracer_finalize;
 
   /* announce trace formats */
   /* *INDENT-OFF* */
@@ -773,6 +860,34 @@ gst_stats_tracer_class_init (GstStatsTracerClass * klass)
           "description", G_TYPE_STRING, "ipad direction",
           NULL),
       NULL);
+  tr_numa_memory = gst_tracer_record_new ("numa-memory.class",
+      "thread-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_THREAD,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "event ts",
+          NULL),
+      "memory-node", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_INT,
+          "description", G_TYPE_STRING, "NUMA node of the memory",
+          NULL),
+      "thread-node", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_INT,
+          "description", G_TYPE_STRING, "NUMA node of the accessing thread",
+          NULL),
+      "hits", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of node local accesses",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      "misses", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "number of accesses from another node",
+          "flags", GST_TYPE_TRACER_VALUE_FLAGS, GST_TRACER_VALUE_FLAGS_AGGREGATED,
+          NULL),
+      NULL);
   /* *INDENT-ON* */
 
   GST_OBJECT_FLAG_SET (tr_buffer, GST_OBJECT_FLAG_MAY_BE_LEAKED);
@@ -782,6 +897,7 @@ gst_stats_tracer_class_init (GstStatsTracerClass * klass)
   GST_OBJECT_FLAG_SET (tr_query, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_new_element, GST_OBJECT_FLAG_MAY_BE_LEAKED);
   GST_OBJECT_FLAG_SET (tr_new_pad, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+  GST_OBJECT_FLAG_SET (tr_numa_memory, GST_OBJECT_FLAG_MAY_BE_LEAKED);
 }
 
 static void
@@ -813,4 +929,6 @@ gst_stats_tracer_init (GstStatsTracer * self)
       G_CALLBACK (do_query_pre));
   gst_tracing_register_hook (tracer, "pad-query-post",
       G_CALLBACK (do_query_post));
+  gst_tracing_register_hook (tracer, "memory-numa-access",
+      G_CALLBACK (do_memory_numa_access));
 }
@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/gsttracer.h>
 
+#include "gsttracersampler.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_STATS_TRACER \
@@ -52,6 +54,8 @@ struct _GstStatsTracer {
 
   /*< private >*/
   guint num_elements, num_pads;
+  guint64 numa_hits, numa_misses;
+  GstTracerSampler sampler;
 };
 
 struct _GstStatsTracerClass {
@@ -0,0 +1,120 @@
+/* GStreamer
+ *
+ * gsttracerhistogram.c: log-linear histograms for the tracers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Values below 2^SUB_BITS get a bucket each. Above, every power of two is
+ * split into 2^(SUB_BITS - 1) linear buckets, so that a value is off by
+ * less than 1/2^(SUB_BITS - 1) when read back: 3% with 6 bits. Recording is
+ * constant time and the memory is fixed, 15kB per histogram, whatever the
+ * range of the values. */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gsttracerhistogram.h"
+
+#include <string.h>
+
+#define SUB_BITS 6
+#define SUB_COUNT (1 << SUB_BITS)
+#define HALF_COUNT (SUB_COUNT / 2)
+#define N_BUCKETS ((64 - SUB_BITS + 2) * HALF_COUNT)
+
+static inline guint
+msb (guint64 value)
+{
+  guint n = 0;
+
+  while (value >>= 1)
+    n++;
+
+  return n;
+}
+
+static inline guint
+bucket_index (guint64 value)
+{
+  guint shift;
+
+  if (value < SUB_COUNT)
+    return value;
+
+  shift = msb (value) - (SUB_BITS - 1);
+  return shift * HALF_COUNT + (guint) (value >> shift);
+}
+
+/* the highest value that ends up in @index */
+static inline guint64
+bucket_upper (guint index)
+{
+  guint shift;
+
+  if (index < SUB_COUNT)
+    return index;
+
+  shift = index / HALF_COUNT - 1;
+  return (((guint64) (index % HALF_COUNT + HALF_COUNT + 1)) << shift) - 1;
+}
+
+void
+gst_tracer_histogram_record (GstTracerHistogram * hist, guint64 value)
+{
+  if (G_UNLIKELY (!hist->buckets))
+    hist->buckets = g_new0 (guint64, N_BUCKETS);
+
+  if (hist->count == 0 || value < hist->min)
+    hist->min = value;
+  if (value > hist->max)
+    hist->max = value;
+  hist->count++;
+  hist->sum += value;
+  hist->buckets[bucket_index (value)]++;
+}
+
+/* Returns the value that @percentile (0 to 100) percent of the values are
+ * lower than or equal to, within the precision of the buckets */
+guint64
+gst_tracer_histogram_percentile (const GstTracerHistogram * hist,
+    gdouble percentile)
+{
+  guint64 rank, seen = 0;
+  guint i;
+
+  if (hist->count == 0)
+    return 0;
+
+  rank = (guint64) (percentile / 100.0 * hist->count + 0.5);
+  rank = CLAMP (rank, 1, hist->count);
+
+  for (i = 0; i < N_BUCKETS; i++) {
+    seen += hist->buckets[i];
+    if (seen >= rank)
+      return CLAMP (bucket_upper (i), hist->min, hist->max);
+  }
+
+  return hist->max;
+}
+
+void
+gst_tracer_histogram_clear (GstTracerHistogram * hist)
+{
+  g_free (hist->buckets);
+  memset (hist, 0, sizeof (GstTracerHistogram));
+}
@@ -0,0 +1,59 @@
+/* GStreamer
+ *
+ * gsttracerhistogram.h: log-linear histograms for the tracers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_TRACER_HISTOGRAM_H__
+#define __GST_TRACER_HISTOGRAM_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTracerHistogram GstTracerHistogram;
+
+/**
+ * GstTracerHistogram:
+ *
+ * A histogram of 64 bit values with a bounded relative error, like a HDR
+ * histogram with about 2 significant digits. Zero-initialized, the buckets
+ * are only allocated with the first value.
+ */
+struct _GstTracerHistogram {
+  /*< private >*/
+  guint64 count;
+  guint64 sum;
+  guint64 min;
+  guint64 max;
+  guint64 *buckets;
+};
+
+G_GNUC_INTERNAL
+void      gst_tracer_histogram_record     (GstTracerHistogram * hist,
+                                           guint64 value);
+
+G_GNUC_INTERNAL
+guint64   gst_tracer_histogram_percentile (const GstTracerHistogram * hist,
+                                           gdouble percentile);
+
+G_GNUC_INTERNAL
+void      gst_tracer_histogram_clear      (GstTracerHistogram * hist);
+
+G_END_DECLS
+
+#endif /* __GST_TRACER_HISTOGRAM_H__ */
@@ -30,6 +30,10 @@
 #include "gststats.h"
 #include "gstleaks.h"
 #include "gstfactories.h"
+#include "gstelementtime.h"
+#include "gstmetrics.h"
+#include "gstmemusage.h"
+#include "gstlockstats.h"
 
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -51,6 +55,17 @@ plugin_init (GstPlugin * plugin)
   if (!gst_tracer_register (plugin, "factories",
           gst_factories_tracer_get_type ()))
     return FALSE;
+  if (!gst_tracer_register (plugin, "elementtime",
+          gst_element_time_tracer_get_type ()))
+    return FALSE;
+  if (!gst_tracer_register (plugin, "metrics", gst_metrics_tracer_get_type ()))
+    return FALSE;
+  if (!gst_tracer_register (plugin, "memusage",
+          gst_mem_usage_tracer_get_type ()))
+    return FALSE;
+  if (!gst_tracer_register (plugin, "lockstats",
+          gst_lock_stats_tracer_get_type ()))
+    return FALSE;
   return TRUE;
 }
 
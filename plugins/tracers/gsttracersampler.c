@@ -0,0 +1,150 @@
+/* GStreamer
+ *
+ * gsttracersampler.c: sampling of the traced buffers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Shared by the tracers that hook every buffer, so that they can be left
+ * enabled with a bounded overhead. The checks are meant to be done first
+ * thing in the hooks, before looking up any per-pad or per-element data.
+ *
+ * Parameters:
+ * - sample-interval: only trace every Nth buffer
+ * - sample-period: trace at most one buffer per this many milliseconds
+ * - elements: only trace the elements whose names match one of these
+ *   '+' separated patterns, e.g. "elements=queue*+sink"
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gsttracersampler.h"
+
+/* The sampler is expected to be zero-initialized, as part of the tracer
+ * instance */
+void
+gst_tracer_sampler_configure (GstTracerSampler * sampler,
+    const GstStructure * params)
+{
+  const gchar *elements;
+  gint value;
+
+  if (gst_structure_get_int (params, "sample-interval", &value)) {
+    if (value >= 0)
+      sampler->interval = value;
+    else
+      GST_WARNING ("Invalid sample-interval %d", value);
+  }
+
+  if (gst_structure_get_int (params, "sample-period", &value)) {
+    if (value >= 0)
+      sampler->period = value * GST_MSECOND;
+    else
+      GST_WARNING ("Invalid sample-period %d", value);
+  }
+
+  elements = gst_structure_get_string (params, "elements");
+  if (elements) {
+    GStrv split = g_strsplit (elements, "+", -1);
+    gint i;
+
+    if (!sampler->elements)
+      sampler->elements = g_ptr_array_new_with_free_func ((GDestroyNotify)
+          g_pattern_spec_free);
+    for (i = 0; split[i]; i++) {
+      if (*split[i])
+        g_ptr_array_add (sampler->elements, g_pattern_spec_new (split[i]));
+    }
+    g_strfreev (split);
+  }
+}
+
+void
+gst_tracer_sampler_clear (GstTracerSampler * sampler)
+{
+  if (sampler->elements) {
+    g_ptr_array_unref (sampler->elements);
+    sampler->elements = NULL;
+  }
+}
+
+/* Whether the buffer traced at @ts should be looked at, based on the
+ * interval and period. @state is not locked, concurrent pushes on the same
+ * pad only make the sampling less exact. */
+gboolean
+gst_tracer_sampler_sample (const GstTracerSampler * sampler,
+    GstTracerSamplerState * state, GstClockTime ts)
+{
+  if (sampler->interval > 1) {
+    guint count = (guint) g_atomic_int_add (&state->count, 1);
+
+    if (count % sampler->interval != 0)
+      return FALSE;
+  }
+
+  if (sampler->period > 0) {
+    if (ts < state->next_ts)
+      return FALSE;
+    state->next_ts = ts + sampler->period;
+  }
+
+  return TRUE;
+}
+
+/* Whether @element is selected by the "elements" parameter */
+gboolean
+gst_tracer_sampler_filter (const GstTracerSampler * sampler,
+    GstObject * element)
+{
+  const gchar *name;
+  guint i;
+
+  if (!sampler->elements)
+    return TRUE;
+
+  if (!element || !(name = GST_OBJECT_NAME (element)))
+    return FALSE;
+
+  for (i = 0; i < sampler->elements->len; i++) {
+    if (g_pattern_match_string (g_ptr_array_index (sampler->elements, i),
+            name))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Same for the element of @pad, the element containing the ghost pad for
+ * proxy pads */
+gboolean
+gst_tracer_sampler_filter_pad (const GstTracerSampler * sampler, GstPad * pad)
+{
+  GstObject *parent;
+
+  if (!sampler->elements)
+    return TRUE;
+
+  if (!pad)
+    return FALSE;
+
+  parent = GST_OBJECT_PARENT (pad);
+  if (parent && GST_IS_PAD (parent))
+    parent = GST_OBJECT_PARENT (parent);
+
+  return gst_tracer_sampler_filter (sampler, parent);
+}
@@ -0,0 +1,84 @@
+/* GStreamer
+ *
+ * gsttracersampler.h: sampling of the traced buffers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_TRACER_SAMPLER_H__
+#define __GST_TRACER_SAMPLER_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstTracerSampler GstTracerSampler;
+typedef struct _GstTracerSamplerState GstTracerSamplerState;
+
+/**
+ * GstTracerSampler:
+ *
+ * Decides which buffers a tracer looks at, configured from the
+ * "sample-interval", "sample-period" and "elements" tracer parameters.
+ */
+struct _GstTracerSampler {
+  /*< private >*/
+  /* only every Nth buffer, 0 or 1 for all */
+  guint interval;
+  /* at most one buffer per period, 0 for no limit */
+  GstClockTime period;
+  /* GPatternSpec for the element names, NULL for all elements */
+  GPtrArray *elements;
+};
+
+/**
+ * GstTracerSamplerState:
+ *
+ * Sampling state, kept per pad so that the pads of a pipeline don't alias
+ * with the interval. Zero-initialized.
+ */
+struct _GstTracerSamplerState {
+  /*< private >*/
+  gint count;
+  GstClockTime next_ts;
+};
+
+#define GST_TRACER_SAMPLER_IS_SAMPLING(s) \
+  ((s)->interval > 1 || (s)->period > 0)
+
+G_GNUC_INTERNAL
+void      gst_tracer_sampler_configure  (GstTracerSampler * sampler,
+                                         const GstStructure * params);
+
+G_GNUC_INTERNAL
+void      gst_tracer_sampler_clear      (GstTracerSampler * sampler);
+
+G_GNUC_INTERNAL
+gboolean  gst_tracer_sampler_sample     (const GstTracerSampler * sampler,
+                                         GstTracerSamplerState * state,
+                                         GstClockTime ts);
+
+G_GNUC_INTERNAL
+gboolean  gst_tracer_sampler_filter     (const GstTracerSampler * sampler,
+                                         GstObject * element);
+
+G_GNUC_INTERNAL
+gboolean  gst_tracer_sampler_filter_pad (const GstTracerSampler * sampler,
+                                         GstPad * pad);
+
+G_END_DECLS
+
+#endif /* __GST_TRACER_SAMPLER_H__ */
@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2021 GStreamer developers
+#
+# This library is free software; you can redistribute it and/or
+# modify it under the terms of the GNU Library General Public
+# License as published by the Free Software Foundation; either
+# version 2 of the License, or (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Library General Public License for more details.
+#
+# You should have received a copy of the GNU Library General Public
+# License along with this library; if not, write to the
+# Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+# Boston, MA 02110-1301, USA.
+
+"""
+Generates constant element factory tables for statically linked plugins.
+
+The plugin descriptions are read from a plugins cache file as used for the
+documentation (docs/plugins/gst_plugins_cache.json). For every selected
+plugin a function
+
+    void gst_plugin_<name>_register_prelinked (void);
+
+is emitted that registers the plugin with gst_plugin_register_static(). Its
+element factories are added with gst_element_register_description(), so
+neither the element types nor their classes are set up during gst_init().
+
+Only element factories are described by the tables. Other features of the
+plugin, like typefinders or tracers, can be registered by a function passed
+with --extra-init, which is called with the plugin after its elements were
+added.
+
+Usage from meson:
+
+    gen = find_program('gst-gen-prelinked-registry')
+    prelinked = custom_target('prelinked-registry',
+        input : 'gst_plugins_cache.json',
+        output : 'gstprelinked.c',
+        command : [gen, '--version', meson.project_version(),
+                   '--plugin', 'coreelements', '@INPUT@', '@OUTPUT@'])
+"""
+
+import argparse
+import json
+import re
+import sys
+
+RANKS = {
+    'none': 'GST_RANK_NONE',
+    'marginal': 'GST_RANK_MARGINAL',
+    'secondary': 'GST_RANK_SECONDARY',
+    'primary': 'GST_RANK_PRIMARY',
+}
+
+DIRECTIONS = {
+    'src': 'GST_PAD_SRC',
+    'sink': 'GST_PAD_SINK',
+    'unknown': 'GST_PAD_UNKNOWN',
+}
+
+PRESENCES = {
+    'always': 'GST_PAD_ALWAYS',
+    'sometimes': 'GST_PAD_SOMETIMES',
+    'request': 'GST_PAD_REQUEST',
+}
+
+
+def c_string(s):
+    s = s.replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+    return '"%s"' % s
+
+
+def c_identifier(s):
+    return re.sub(r'[^A-Za-z0-9_]', '_', s)
+
+
+def get_type_function(type_name):
+    # GstFileSrc -> gst_file_src_get_type, GstRTPBin -> gst_rtp_bin_get_type
+    name = re.sub(r'([A-Z]+)([A-Z][a-z])', r'\1_\2', type_name)
+    name = re.sub(r'([a-z0-9])([A-Z])', r'\1_\2', name)
+    return name.lower() + '_get_type'
+
+
+def rank(value):
+    value = value.replace(' ', '')
+    for name, define in RANKS.items():
+        if value == name:
+            return define
+        if value.startswith(name) and value[len(name)] in '+-':
+            return '%s %s %s' % (define, value[len(name)],
+                                 value[len(name) + 1:])
+    return str(int(value))
+
+
+def write_plugin(out, name, plugin, args):
+    cname = c_identifier(name)
+    elements = sorted(plugin.get('elements', {}).items())
+    get_types = {}
+
+    for ename, element in elements:
+        type_name = element['hierarchy'][0]
+        get_types[ename] = args.get_type.get(ename,
+                                             get_type_function(type_name))
+
+    for func in sorted(set(get_types.values())):
+        out.write('GType %s (void);\n' % func)
+    if args.extra_init:
+        out.write('gboolean %s (GstPlugin * plugin);\n' % args.extra_init)
+    out.write('\n')
+
+    for ename, element in elements:
+        ecname = c_identifier(ename)
+        templates = sorted(element.get('pad-templates', {}).items())
+        if templates:
+            out.write('static const GstStaticPadTemplate %s_%s_templates[] = {\n'
+                      % (cname, ecname))
+            for tname, templ in templates:
+                out.write('  GST_STATIC_PAD_TEMPLATE (%s, %s, %s,\n'
+                          '      GST_STATIC_CAPS (%s)),\n'
+                          % (c_string(tname.replace('%%', '%')),
+                             DIRECTIONS[templ['direction']],
+                             PRESENCES[templ['presence']],
+                             c_string(templ['caps'])))
+            out.write('};\n\n')
+        interfaces = element.get('interfaces', [])
+        if interfaces:
+            out.write('static const gchar *const %s_%s_interfaces[] = {\n'
+                      % (cname, ecname))
+            for iface in interfaces:
+                out.write('  %s,\n' % c_string(iface))
+            out.write('  NULL\n};\n\n')
+
+    out.write('static const GstElementFactoryDescription %s_elements[] = {\n'
+              % cname)
+    for ename, element in elements:
+        ecname = c_identifier(ename)
+        templates = element.get('pad-templates', {})
+        out.write('  {%s, %s, %s,\n' % (c_string(ename),
+                                         rank(element['rank']),
+                                         get_types[ename]))
+        out.write('      %s,\n      %s,\n      %s,\n      %s,\n'
+                  % (c_string(element['long-name']),
+                     c_string(element['klass']),
+                     c_string(element['description']),
+                     c_string(element['author'])))
+        if templates:
+            out.write('      %s_%s_templates, G_N_ELEMENTS (%s_%s_templates),\n'
+                      % (cname, ecname, cname, ecname))
+        else:
+            out.write('      NULL, 0,\n')
+        if element.get('interfaces'):
+            out.write('      %s_%s_interfaces},\n' % (cname, ecname))
+        else:
+            out.write('      NULL},\n')
+    out.write('};\n\n')
+
+    out.write('static gboolean\n'
+              '%s_prelinked_init (GstPlugin * plugin)\n'
+              '{\n'
+              '  guint i;\n\n'
+              '  for (i = 0; i < G_N_ELEMENTS (%s_elements); i++) {\n'
+              '    if (!gst_element_register_description (plugin,\n'
+              '            &%s_elements[i]))\n'
+              '      return FALSE;\n'
+              '  }\n\n' % (cname, cname, cname))
+    if args.extra_init:
+        out.write('  return %s (plugin);\n' % args.extra_init)
+    else:
+        out.write('  return TRUE;\n')
+    out.write('}\n\n')
+
+    out.write('void\n'
+              'gst_plugin_%s_register_prelinked (void)\n'
+              '{\n'
+              '  gst_plugin_register_static (GST_VERSION_MAJOR, '
+              'GST_VERSION_MINOR,\n'
+              '      %s, %s,\n'
+              '      %s_prelinked_init, %s, %s, %s,\n'
+              '      %s, %s);\n'
+              '}\n\n' % (cname, c_string(name),
+                         c_string(plugin.get('description', name)),
+                         cname, c_string(args.version),
+                         c_string(plugin.get('license', 'unknown')),
+                         c_string(plugin.get('source', name)),
+                         c_string(plugin.get('package', name)),
+                         c_string(plugin.get('url', 'Unknown package origin'))))
+
+
+def parse_get_type(values):
+    res = {}
+    for value in values:
+        if '=' not in value:
+            raise argparse.ArgumentTypeError(
+                'expected ELEMENT=FUNCTION, got %s' % value)
+        element, func = value.split('=', 1)
+        res[element] = func
+    return res
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(
+        description='Generate constant element factory tables for '
+        'statically linked plugins')
+    parser.add_argument('--version', required=True,
+                        help='version of the plugins')
+    parser.add_argument('--plugin', action='append', default=[],
+                        help='plugin to generate the tables for, can be '
+                        'given multiple times. Defaults to all plugins')
+    parser.add_argument('--get-type', action='append', default=[],
+                        metavar='ELEMENT=FUNCTION',
+                        help='get_type function of an element if it does '
+                        'not follow the usual naming')
+    parser.add_argument('--extra-init', metavar='FUNCTION',
+                        help='function registering the other features of '
+                        'the plugin')
+    parser.add_argument('cache', help='plugins cache file')
+    parser.add_argument('output', help='C file to write')
+    args = parser.parse_args()
+    args.get_type = parse_get_type(args.get_type)
+
+    with open(args.cache, encoding='utf-8') as f:
+        cache = json.load(f)
+
+    if args.plugin:
+        names = args.plugin
+        for name in names:
+            if name not in cache:
+                sys.exit('Unknown plugin %s' % name)
+            if not cache[name].get('elements'):
+                sys.exit('Plugin %s has no elements' % name)
+    else:
+        names = [name for name in sorted(cache) if cache[name].get('elements')]
+
+    with open(args.output, 'w', encoding='utf-8') as out:
+        out.write('/* Generated by gst-gen-prelinked-registry.py, '
+                  'do not edit */\n\n'
+                  '#include <gst/gst.h>\n\n')
+        for name in names:
+            write_plugin(out, name, cache[name], args)
@@ -0,0 +1,264 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* A small harness for benchmarks that are tracked over time. Every case is
+ * run for a sweep of parameter values, each run is repeated after a number
+ * of warm-up runs and the statistics of the repetitions are printed as text
+ * or as a JSON document that can be compared between releases:
+ *
+ *  --warmup=N      untimed runs before measuring (default 1)
+ *  --repeat=N      measured runs (default 5)
+ *  --scale=F       multiply the iterations of every case by F
+ *  --filter=TEXT   only run the cases whose name contains TEXT
+ *  --json          print JSON instead of text
+ *  --output=FILE   write the results to FILE instead of stdout
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "gst/glib-compat-private.h"
+
+typedef struct
+{
+  gchar *name;
+  guint64 *params;
+  guint n_params;
+  guint64 iterations;
+  BenchFunc func;
+  gpointer user_data;
+} BenchCase;
+
+struct _Bench
+{
+  gchar *suite;
+  GPtrArray *cases;
+
+  gint warmup;
+  gint repeat;
+  gdouble scale;
+  gchar *filter;
+  gboolean json;
+  gchar *output;
+};
+
+static void
+bench_case_free (BenchCase * bcase)
+{
+  g_free (bcase->name);
+  g_free (bcase->params);
+  g_free (bcase);
+}
+
+Bench *
+bench_new (const gchar * suite, gint * argc, gchar *** argv)
+{
+  GOptionContext *ctx;
+  GError *err = NULL;
+  Bench *bench;
+
+  bench = g_new0 (Bench, 1);
+  bench->suite = g_strdup (suite);
+  bench->cases = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      bench_case_free);
+  bench->warmup = 1;
+  bench->repeat = 5;
+  bench->scale = 1.0;
+
+  {
+    GOptionEntry options[] = {
+      {"warmup", 0, 0, G_OPTION_ARG_INT, &bench->warmup,
+          "Untimed runs before measuring", "N"},
+      {"repeat", 0, 0, G_OPTION_ARG_INT, &bench->repeat,
+          "Number of measured runs", "N"},
+      {"scale", 0, 0, G_OPTION_ARG_DOUBLE, &bench->scale,
+          "Multiply the iterations of every case", "F"},
+      {"filter", 0, 0, G_OPTION_ARG_STRING, &bench->filter,
+          "Only run the cases whose name contains TEXT", "TEXT"},
+      {"json", 0, 0, G_OPTION_ARG_NONE, &bench->json,
+          "Print the results as JSON", NULL},
+      {"output", 'o', 0, G_OPTION_ARG_FILENAME, &bench->output,
+          "Write the results to FILE", "FILE"},
+      {NULL}
+    };
+
+    ctx = g_option_context_new ("- run the benchmarks");
+    g_option_context_add_main_entries (ctx, options, NULL);
+    g_option_context_add_group (ctx, gst_init_get_option_group ());
+    if (!g_option_context_parse (ctx, argc, argv, &err)) {
+      g_printerr ("Error initializing: %s\n", err->message);
+      exit (1);
+    }
+    g_option_context_free (ctx);
+  }
+
+  if (bench->warmup < 0 || bench->repeat < 1 || bench->scale <= 0.0) {
+    g_printerr ("invalid warmup, repeat or scale\n");
+    exit (1);
+  }
+
+  return bench;
+}
+
+void
+bench_add (Bench * bench, const gchar * name, const guint64 * params,
+    guint n_params, guint64 iterations, BenchFunc func, gpointer user_data)
+{
+  BenchCase *bcase = g_new0 (BenchCase, 1);
+
+  bcase->name = g_strdup (name);
+  if (n_params == 0) {
+    bcase->params = g_new0 (guint64, 1);
+    bcase->n_params = 1;
+  } else {
+    bcase->params = g_memdup2 (params, n_params * sizeof (guint64));
+    bcase->n_params = n_params;
+  }
+  bcase->iterations = iterations;
+  bcase->func = func;
+  bcase->user_data = user_data;
+
+  g_ptr_array_add (bench->cases, bcase);
+}
+
+static gint
+compare_time (gconstpointer a, gconstpointer b)
+{
+  GstClockTime ta = *(const GstClockTime *) a;
+  GstClockTime tb = *(const GstClockTime *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void
+append_result (Bench * bench, GString * out, gboolean first,
+    BenchCase * bcase, guint64 param, guint64 iterations,
+    GstClockTime * times)
+{
+  GstClockTime min, median;
+  gdouble mean = 0.0, var = 0.0, per_iter;
+  gint i, n = bench->repeat;
+
+  qsort (times, n, sizeof (GstClockTime), compare_time);
+  min = times[0];
+  median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+
+  for (i = 0; i < n; i++)
+    mean += times[i];
+  mean /= n;
+  for (i = 0; i < n; i++)
+    var += (times[i] - mean) * (times[i] - mean);
+  var /= n;
+
+  per_iter = (gdouble) median / iterations;
+
+  if (bench->json) {
+    g_string_append_printf (out, "%s\n    {\"name\": \"%s\", "
+        "\"param\": %" G_GUINT64_FORMAT ", \"iterations\": %" G_GUINT64_FORMAT
+        ", \"min_ns\": %" G_GUINT64_FORMAT ", \"median_ns\": %"
+        G_GUINT64_FORMAT ", \"mean_ns\": %.0f, \"stddev_ns\": %.0f, "
+        "\"ns_per_iteration\": %.3f, \"iterations_per_second\": %.0f}",
+        first ? "" : ",", bcase->name, param, iterations, min, median, mean,
+        sqrt (var), per_iter, per_iter > 0.0 ? 1e9 / per_iter : 0.0);
+  } else {
+    g_string_append_printf (out, "%-24s %10" G_GUINT64_FORMAT " %10"
+        G_GUINT64_FORMAT " %14.3f %14.3f %8.2f%%\n", bcase->name, param,
+        iterations, min / (gdouble) iterations, per_iter,
+        mean > 0.0 ? 100.0 * sqrt (var) / mean : 0.0);
+  }
+}
+
+gint
+bench_run (Bench * bench)
+{
+  GString *out;
+  GstClockTime *times;
+  gboolean first = TRUE;
+  guint i, j;
+  gint k;
+
+  out = g_string_new (NULL);
+  if (bench->json) {
+    g_string_append_printf (out, "{\n  \"suite\": \"%s\",\n"
+        "  \"version\": \"%s\",\n  \"warmup\": %d,\n  \"repeat\": %d,\n"
+        "  \"results\": [", bench->suite, gst_version_string (), bench->warmup,
+        bench->repeat);
+  } else {
+    g_string_append_printf (out, "%-24s %10s %10s %14s %14s %9s\n", "case",
+        "param", "iterations", "min ns/iter", "median ns/iter", "stddev");
+  }
+
+  times = g_new (GstClockTime, bench->repeat);
+
+  for (i = 0; i < bench->cases->len; i++) {
+    BenchCase *bcase = g_ptr_array_index (bench->cases, i);
+    guint64 iterations;
+
+    if (bench->filter && !strstr (bcase->name, bench->filter))
+      continue;
+
+    iterations = MAX (1, bcase->iterations * bench->scale);
+
+    for (j = 0; j < bcase->n_params; j++) {
+      guint64 param = bcase->params[j];
+
+      for (k = 0; k < bench->warmup; k++)
+        bcase->func (param, iterations, bcase->user_data);
+      for (k = 0; k < bench->repeat; k++)
+        times[k] = bcase->func (param, iterations, bcase->user_data);
+
+      append_result (bench, out, first, bcase, param, iterations, times);
+      first = FALSE;
+    }
+  }
+
+  g_free (times);
+
+  if (bench->json)
+    g_string_append (out, "\n  ]\n}\n");
+
+  if (bench->output) {
+    GError *err = NULL;
+
+    if (!g_file_set_contents (bench->output, out->str, out->len, &err)) {
+      g_printerr ("Could not write %s: %s\n", bench->output, err->message);
+      g_clear_error (&err);
+      g_string_free (out, TRUE);
+      return 1;
+    }
+  } else {
+    fputs (out->str, stdout);
+  }
+
+  g_string_free (out, TRUE);
+
+  return 0;
+}
+
+void
+bench_free (Bench * bench)
+{
+  g_ptr_array_unref (bench->cases);
+  g_free (bench->suite);
+  g_free (bench->filter);
+  g_free (bench->output);
+  g_free (bench);
+}
@@ -0,0 +1,50 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _Bench Bench;
+
+/* Runs @iterations iterations of the measured operation for @param and
+ * returns the time they took. Setup that should not be measured is done
+ * before taking the start timestamp. */
+typedef GstClockTime (*BenchFunc) (guint64 param, guint64 iterations,
+    gpointer user_data);
+
+Bench *   bench_new      (const gchar * suite, gint * argc, gchar *** argv);
+
+/* Adds a case that is run for each of the @n_params values of @params, or
+ * once with a param of 0 when @n_params is 0 */
+void      bench_add      (Bench * bench, const gchar * name,
+                          const guint64 * params, guint n_params,
+                          guint64 iterations, BenchFunc func,
+                          gpointer user_data);
+
+/* Runs all cases and prints the results, returns the exit code */
+gint      bench_run      (Bench * bench);
+
+void      bench_free     (Bench * bench);
+
+G_END_DECLS
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,163 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of GstBitReader when decoding video headers made
+ * of Exp-Golomb codes mixed with short fixed length fields, like the slice
+ * headers of H.264 and H.265. The Exp-Golomb helpers are compared against
+ * the usual way of parsing the codes one bit at a time. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/base/gstbitreader.h>
+#include <gst/base/gstbitwriter.h>
+
+#define DEFAULT_HEADERS (1000000)
+#define ITERATIONS (10)
+#define FIELDS_PER_HEADER (12)
+
+static void
+put_ue (GstBitWriter * writer, guint32 val)
+{
+  guint len = g_bit_storage (val + 1);
+
+  if (len > 1)
+    gst_bit_writer_put_bits_uint32 (writer, 0, len - 1);
+  gst_bit_writer_put_bits_uint32 (writer, val + 1, len);
+}
+
+static guint8 *
+make_headers (guint n_headers, guint * size)
+{
+  GstBitWriter *writer = gst_bit_writer_new ();
+  guint i, j;
+
+  for (i = 0; i < n_headers; i++) {
+    for (j = 0; j < FIELDS_PER_HEADER; j++) {
+      /* mostly small values, like slice types and deltas */
+      if (g_random_int_range (0, 8) == 0)
+        put_ue (writer, g_random_int_range (0, 65536));
+      else
+        put_ue (writer, g_random_int_range (0, 8));
+    }
+    gst_bit_writer_put_bits_uint32 (writer, g_random_int (), 5);
+    gst_bit_writer_put_bits_uint32 (writer, g_random_int (), 1);
+  }
+  gst_bit_writer_align_bytes (writer, 0);
+
+  *size = gst_bit_writer_get_size (writer) / 8;
+  return gst_bit_writer_free_and_get_data (writer);
+}
+
+static gboolean
+get_ue_bitwise (GstBitReader * reader, guint32 * val)
+{
+  guint i = 0;
+  guint8 bit;
+  guint32 value;
+
+  if (!gst_bit_reader_get_bits_uint8 (reader, &bit, 1))
+    return FALSE;
+  while (bit == 0) {
+    i++;
+    if (!gst_bit_reader_get_bits_uint8 (reader, &bit, 1))
+      return FALSE;
+  }
+  if (i > 31)
+    return FALSE;
+  if (!gst_bit_reader_get_bits_uint32 (reader, &value, i))
+    return FALSE;
+  *val = (1U << i) - 1 + value;
+  return TRUE;
+}
+
+static guint64
+decode_headers (const guint8 * data, guint size, guint n_headers,
+    gboolean bitwise)
+{
+  GstBitReader reader;
+  guint64 sum = 0;
+  guint i, j;
+
+  gst_bit_reader_init (&reader, data, size);
+  for (i = 0; i < n_headers; i++) {
+    guint32 val = 0;
+    guint8 flags = 0;
+
+    for (j = 0; j < FIELDS_PER_HEADER; j++) {
+      if (bitwise) {
+        if (!get_ue_bitwise (&reader, &val))
+          g_assert_not_reached ();
+      } else {
+        if (!gst_bit_reader_get_ue (&reader, &val))
+          g_assert_not_reached ();
+      }
+      sum += val;
+    }
+    if (!gst_bit_reader_get_bits_uint8 (&reader, &flags, 5) ||
+        !gst_bit_reader_get_bits_uint8 (&reader, &flags, 1))
+      g_assert_not_reached ();
+    sum += flags;
+  }
+  return sum;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstClockTime start, elapsed;
+  guint8 *data;
+  guint n_headers = DEFAULT_HEADERS, size, i;
+  guint64 sum_bitwise = 0, sum = 0;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    n_headers = atoi (argv[1]);
+
+  if (n_headers == 0) {
+    g_print ("usage: %s [<nheaders>]\n", argv[0]);
+    exit (-1);
+  }
+
+  data = make_headers (n_headers, &size);
+  g_print ("*** %u headers, %u bytes\n", n_headers, size);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    sum_bitwise = decode_headers (data, size, n_headers, TRUE);
+  elapsed = gst_util_get_timestamp () - start;
+  g_print ("*** %-10s %8.2f Mheaders/s\n", "bitwise",
+      (gdouble) n_headers * ITERATIONS / 1e6 /
+      ((gdouble) elapsed / GST_SECOND));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    sum = decode_headers (data, size, n_headers, FALSE);
+  elapsed = gst_util_get_timestamp () - start;
+  g_print ("*** %-10s %8.2f Mheaders/s\n", "get_ue",
+      (gdouble) n_headers * ITERATIONS / 1e6 /
+      ((gdouble) elapsed / GST_SECOND));
+
+  if (sum != sum_bitwise)
+    g_print ("*** mismatch: %" G_GUINT64_FORMAT " != %" G_GUINT64_FORMAT "\n",
+        sum, sum_bitwise);
+
+  g_free (data);
+
+  return 0;
+}
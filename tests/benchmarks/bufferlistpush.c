@@ -0,0 +1,158 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of pushing single buffers compared to pushing
+ * buffer lists through a chain of core elements that handle lists natively */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define BUFFER_COUNT (100000)
+#define LIST_SIZE (64)
+#define BUFFER_SIZE (188)
+
+static const gchar *chain_elements[] = {
+  "capsfilter", "identity", "valve", "funnel", "input-selector",
+  "output-selector", "clocksync", NULL
+};
+
+static GstElement *
+create_pipeline (GstPad ** srcpad)
+{
+  GstElement *pipeline, *current, *last = NULL, *sink;
+  GstPad *sinkpad = NULL;
+  GstSegment segment;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  for (i = 0; chain_elements[i]; i++) {
+    current = gst_element_factory_make (chain_elements[i], NULL);
+    if (!current) {
+      g_print ("no element named \"%s\" found, aborting...\n",
+          chain_elements[i]);
+      exit (1);
+    }
+    if (g_object_class_find_property (G_OBJECT_GET_CLASS (current), "sync"))
+      g_object_set (current, "sync", FALSE, NULL);
+    gst_bin_add (GST_BIN (pipeline), current);
+    if (last && !gst_element_link (last, current))
+      g_assert_not_reached ();
+    else if (!last)
+      sinkpad = gst_element_get_static_pad (current, "sink");
+    last = current;
+  }
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  if (!gst_element_link (last, sink))
+    g_assert_not_reached ();
+
+  *srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  if (gst_pad_link (*srcpad, sinkpad) != GST_PAD_LINK_OK)
+    g_assert_not_reached ();
+  gst_object_unref (sinkpad);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  gst_pad_set_active (*srcpad, TRUE);
+
+  gst_pad_push_event (*srcpad, gst_event_new_stream_start ("bench"));
+  gst_pad_push_event (*srcpad,
+      gst_event_new_caps (gst_caps_new_empty_simple ("video/mpegts")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (*srcpad, gst_event_new_segment (&segment));
+
+  return pipeline;
+}
+
+static void
+destroy_pipeline (GstElement * pipeline, GstPad * srcpad)
+{
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *pipeline;
+  GstPad *srcpad;
+  GstBuffer *buf;
+  GstClockTime start, end;
+  GstClockTimeDiff dur1, dur2;
+  guint i, j, buffers = BUFFER_COUNT, list_size = LIST_SIZE;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    buffers = atoi (argv[1]);
+  if (argc > 2)
+    list_size = atoi (argv[2]);
+
+  if (buffers == 0 || list_size == 0) {
+    g_print ("usage: %s [<nbuffers> [<list-size>]]\n", argv[0]);
+    exit (-1);
+  }
+
+  buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+
+  /* push single buffers */
+  pipeline = create_pipeline (&srcpad);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < buffers; i++) {
+    if (gst_pad_push (srcpad, gst_buffer_ref (buf)) != GST_FLOW_OK)
+      g_assert_not_reached ();
+  }
+  end = gst_util_get_timestamp ();
+  dur1 = GST_CLOCK_DIFF (start, end);
+  destroy_pipeline (pipeline, srcpad);
+  g_print ("*** total %" GST_TIME_FORMAT " - average %" GST_TIME_FORMAT
+      "  - Done pushing %u single buffers\n",
+      GST_TIME_ARGS (dur1), GST_TIME_ARGS (dur1 / buffers), buffers);
+
+  /* push the same amount of buffers in lists */
+  pipeline = create_pipeline (&srcpad);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < buffers; i += list_size) {
+    GstBufferList *list = gst_buffer_list_new_sized (list_size);
+
+    for (j = 0; j < list_size && i + j < buffers; j++)
+      gst_buffer_list_add (list, gst_buffer_ref (buf));
+
+    if (gst_pad_push_list (srcpad, list) != GST_FLOW_OK)
+      g_assert_not_reached ();
+  }
+  end = gst_util_get_timestamp ();
+  dur2 = GST_CLOCK_DIFF (start, end);
+  destroy_pipeline (pipeline, srcpad);
+  g_print ("*** total %" GST_TIME_FORMAT " - average %" GST_TIME_FORMAT
+      "  - Done pushing %u buffers in lists of %u\n",
+      GST_TIME_ARGS (dur2), GST_TIME_ARGS (dur2 / buffers), buffers,
+      list_size);
+
+  g_print ("*** speedup %6.4lf\n", ((gdouble) dur1 / (gdouble) dur2));
+
+  gst_buffer_unref (buf);
+
+  return 0;
+}
@@ -20,10 +20,13 @@
  */
 
 
+#include <string.h>
 #include <gst/gst.h>
 
 
 #define NUM_CAPS 10000
+#define NUM_LOOKUPS 1000000
+#define NUM_FIELDS 32
 
 #define AUDIO_FORMATS_ALL " { S8, U8, " \
     "S16LE, S16BE, U16LE, U16BE, " \
@@ -40,6 +43,60 @@
   "rate = (int) [ 1, MAX ], " \
   "channels = (int) [ 1, MAX ]"
 
+static void
+time_lookups (const GstStructure * s, const gchar * fieldname)
+{
+  GstClockTime start, end;
+  GQuark field_id = g_quark_from_string (fieldname);
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_LOOKUPS; i++)
+    g_assert (gst_structure_id_get_value (s, field_id) != NULL);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d lookups of the last of %d fields\n",
+      GST_TIME_ARGS (end - start), i, gst_structure_n_fields (s));
+}
+
+static void
+time_serialization (const GstCaps * caps)
+{
+  GstClockTime start, end;
+  gchar *str;
+  GBytes *bytes;
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    GstCaps *tmp;
+
+    str = gst_caps_to_string (caps);
+    tmp = gst_caps_from_string (str);
+    gst_caps_unref (tmp);
+    if (i < NUM_CAPS - 1)
+      g_free (str);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d string round trips of %d bytes\n",
+      GST_TIME_ARGS (end - start), i, (gint) strlen (str) + 1);
+  g_free (str);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    GstCaps *tmp;
+
+    bytes = gst_caps_to_binary (caps);
+    tmp = gst_caps_from_binary (g_bytes_get_data (bytes, NULL),
+        g_bytes_get_size (bytes), NULL);
+    gst_caps_unref (tmp);
+    if (i < NUM_CAPS - 1)
+      g_bytes_unref (bytes);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d binary round trips of %d bytes\n",
+      GST_TIME_ARGS (end - start), i, (gint) g_bytes_get_size (bytes));
+  g_bytes_unref (bytes);
+}
 
 gint
 main (gint argc, gchar * argv[])
@@ -69,7 +126,22 @@ main (gint argc, gchar * argv[])
       GST_TIME_ARGS (end - start), i);
 
   g_free (capses);
+
+  time_lookups (gst_caps_get_structure (protocaps, 0), "channels");
+  time_serialization (protocaps);
   gst_caps_unref (protocaps);
 
+  {
+    GstStructure *s = gst_structure_new_empty ("test");
+    gchar name[16];
+
+    for (i = 0; i < NUM_FIELDS; i++) {
+      g_snprintf (name, sizeof (name), "field%d", i);
+      gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+    }
+    time_lookups (s, name);
+    gst_structure_free (s);
+  }
+
   return 0;
 }
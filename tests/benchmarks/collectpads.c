@@ -0,0 +1,173 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the per-buffer overhead of GstCollectPads with 2 to 128 sink
+ * pads. Every sink pad is fed from its own thread and the collected function
+ * either pops the buffers pad by pad or all at once with
+ * gst_collect_pads_pop_all(). */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/base/gstcollectpads.h>
+
+#define DEFAULT_BUFFERS (20000)
+#define MAX_PADS (128)
+
+typedef struct
+{
+  GstPad *srcpad;
+  GstPad *sinkpad;
+  GThread *thread;
+} Input;
+
+static guint n_buffers = DEFAULT_BUFFERS;
+static gboolean pop_all;
+static guint n_collected;
+
+static gpointer
+push_thread (Input * input)
+{
+  GstSegment segment;
+  guint i;
+
+  gst_pad_push_event (input->srcpad, gst_event_new_stream_start ("test"));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (input->srcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    GST_BUFFER_PTS (buf) = i * GST_MSECOND;
+    if (gst_pad_push (input->srcpad, buf) != GST_FLOW_OK)
+      break;
+  }
+  gst_pad_push_event (input->srcpad, gst_event_new_eos ());
+
+  return NULL;
+}
+
+static GstFlowReturn
+collected_func (GstCollectPads * pads, gpointer user_data)
+{
+  GstBuffer *buffers[MAX_PADS];
+  guint i, n_pads = GPOINTER_TO_UINT (user_data), n_popped = 0;
+
+  if (pop_all) {
+    n_popped = gst_collect_pads_pop_all (pads, buffers, n_pads);
+  } else {
+    GSList *walk;
+
+    for (i = 0, walk = pads->data; walk; walk = walk->next, i++) {
+      buffers[i] = gst_collect_pads_pop (pads, (GstCollectData *) walk->data);
+      if (buffers[i])
+        n_popped++;
+    }
+  }
+
+  if (n_popped == 0)
+    return GST_FLOW_EOS;
+
+  for (i = 0; i < n_pads; i++)
+    gst_clear_buffer (&buffers[i]);
+  n_collected++;
+
+  return GST_FLOW_OK;
+}
+
+static GstClockTime
+run (guint n_pads, gboolean all)
+{
+  GstCollectPads *collect;
+  Input *inputs;
+  GstClockTime start, end;
+  guint i;
+
+  collect = gst_collect_pads_new ();
+  gst_collect_pads_set_function (collect, collected_func,
+      GUINT_TO_POINTER (n_pads));
+  pop_all = all;
+  n_collected = 0;
+
+  inputs = g_new0 (Input, n_pads);
+  for (i = 0; i < n_pads; i++) {
+    inputs[i].srcpad = gst_pad_new ("src", GST_PAD_SRC);
+    inputs[i].sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+    gst_collect_pads_add_pad (collect, inputs[i].sinkpad,
+        sizeof (GstCollectData), NULL, TRUE);
+    if (gst_pad_link (inputs[i].srcpad, inputs[i].sinkpad) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+    gst_pad_set_active (inputs[i].sinkpad, TRUE);
+    gst_pad_set_active (inputs[i].srcpad, TRUE);
+  }
+  gst_collect_pads_start (collect);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_pads; i++)
+    inputs[i].thread = g_thread_new ("input", (GThreadFunc) push_thread,
+        &inputs[i]);
+  for (i = 0; i < n_pads; i++)
+    g_thread_join (inputs[i].thread);
+  end = gst_util_get_timestamp ();
+
+  gst_collect_pads_stop (collect);
+  for (i = 0; i < n_pads; i++) {
+    gst_pad_set_active (inputs[i].srcpad, FALSE);
+    gst_pad_set_active (inputs[i].sinkpad, FALSE);
+    gst_collect_pads_remove_pad (collect, inputs[i].sinkpad);
+    gst_object_unref (inputs[i].srcpad);
+    gst_object_unref (inputs[i].sinkpad);
+  }
+  g_free (inputs);
+  gst_object_unref (collect);
+
+  if (n_collected != n_buffers)
+    g_print ("*** only collected %u of %u buffers\n", n_collected, n_buffers);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint n_pads;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    n_buffers = atoi (argv[1]);
+
+  if (n_buffers == 0) {
+    g_print ("usage: %s [<nbuffers>]\n", argv[0]);
+    exit (-1);
+  }
+
+  for (n_pads = 2; n_pads <= MAX_PADS; n_pads *= 2) {
+    GstClockTime single, all;
+
+    single = run (n_pads, FALSE);
+    all = run (n_pads, TRUE);
+
+    g_print ("*** %3u pads: pop %" GST_TIME_FORMAT " (%" G_GUINT64_FORMAT
+        " ns/buffer), pop_all %" GST_TIME_FORMAT " (%" G_GUINT64_FORMAT
+        " ns/buffer)\n", n_pads, GST_TIME_ARGS (single),
+        single / ((guint64) n_buffers * n_pads), GST_TIME_ARGS (all),
+        all / ((guint64) n_buffers * n_pads));
+  }
+
+  return 0;
+}
@@ -30,7 +30,7 @@ main (gint argc, gchar * argv[])
   GstElement *pipeline, *src, *e;
   GSList *saved_src_list, *src_list, *new_src_list;
   guint complexity_order, n_elements, i, j, max_this_level;
-  GstClockTime start, end;
+  GstClockTime start, end, t, add_time = 0, link_time = 0;
 
   gst_init (&argc, &argv);
 
@@ -81,9 +81,14 @@ main (gint argc, gchar * argv[])
     g_object_set (e, "silent", TRUE, NULL);
     new_src_list = g_slist_prepend (new_src_list, e);
 
+    t = gst_util_get_timestamp ();
     gst_bin_add (GST_BIN (pipeline), e);
+    add_time += gst_util_get_timestamp () - t;
+
+    t = gst_util_get_timestamp ();
     if (!gst_element_link (src, e))
       g_assert_not_reached ();
+    link_time += gst_util_get_timestamp () - t;
   }
 
   g_slist_free (saved_src_list);
@@ -92,6 +97,10 @@ main (gint argc, gchar * argv[])
   end = gst_util_get_timestamp ();
   g_print ("%" GST_TIME_FORMAT " - creating and linking %u elements\n",
       GST_TIME_ARGS (end - start), i);
+  g_print ("%" GST_TIME_FORMAT " - of which adding to the bin\n",
+      GST_TIME_ARGS (add_time));
+  g_print ("%" GST_TIME_FORMAT " - of which linking\n",
+      GST_TIME_ARGS (link_time));
 
   start = gst_util_get_timestamp ();
   if (gst_element_set_state (pipeline,
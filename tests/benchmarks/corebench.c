@@ -0,0 +1,324 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The core operations whose cost is tracked across releases: pushing
+ * buffers through chains of elements, querying caps through them,
+ * allocating buffers with and without a pool and converting between
+ * samples and time. It is registered as the
+ * "core" meson benchmark, which writes corebench.json to the build
+ * directory, see bench.c for the options. */
+
+#include "bench.h"
+
+#define BUFFER_SIZE (1400)
+
+static const guint64 chain_lengths[] = { 1, 4, 16 };
+static const guint64 buffer_sizes[] = { 64, 1400, 65536 };
+static const guint64 sample_rates[] = { 8000, 44100, 48000 };
+static const guint64 printf_kinds[] = { 0, 1, 2 };
+
+/* a pipeline of @n_elements identity elements and a fakesink, fed from a
+ * source pad that is not part of the pipeline */
+static GstElement *
+create_chain (guint64 n_elements, GstPad ** srcpad)
+{
+  GstElement *pipeline, *current, *last = NULL;
+  GstPad *sinkpad = NULL;
+  GstSegment segment;
+  guint64 i;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  for (i = 0; i <= n_elements; i++) {
+    if (i < n_elements) {
+      current = gst_element_factory_make ("identity", NULL);
+    } else {
+      current = gst_element_factory_make ("fakesink", NULL);
+      g_object_set (current, "sync", FALSE, NULL);
+    }
+    g_assert (current != NULL);
+    gst_bin_add (GST_BIN (pipeline), current);
+    if (last && !gst_element_link (last, current))
+      g_assert_not_reached ();
+    else if (!last)
+      sinkpad = gst_element_get_static_pad (current, "sink");
+    last = current;
+  }
+
+  *srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  if (gst_pad_link (*srcpad, sinkpad) != GST_PAD_LINK_OK)
+    g_assert_not_reached ();
+  gst_object_unref (sinkpad);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  gst_pad_set_active (*srcpad, TRUE);
+
+  gst_pad_push_event (*srcpad, gst_event_new_stream_start ("bench"));
+  gst_pad_push_event (*srcpad,
+      gst_event_new_caps (gst_caps_new_empty_simple ("application/x-bench")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (*srcpad, gst_event_new_segment (&segment));
+
+  return pipeline;
+}
+
+static void
+destroy_chain (GstElement * pipeline, GstPad * srcpad)
+{
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+}
+
+static GstClockTime
+bench_pad_push (guint64 n_elements, guint64 iterations, gpointer user_data)
+{
+  GstElement *pipeline;
+  GstPad *srcpad;
+  GstBuffer *buf;
+  GstClockTime start, end;
+  guint64 i;
+
+  pipeline = create_chain (n_elements, &srcpad);
+  buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    if (gst_pad_push (srcpad, gst_buffer_ref (buf)) != GST_FLOW_OK)
+      g_assert_not_reached ();
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_buffer_unref (buf);
+  destroy_chain (pipeline, srcpad);
+
+  return end - start;
+}
+
+static GstClockTime
+bench_caps_query (guint64 n_elements, guint64 iterations, gpointer user_data)
+{
+  GstElement *pipeline;
+  GstCaps *filter, *caps;
+  GstPad *srcpad;
+  GstClockTime start, end;
+  guint64 i;
+
+  pipeline = create_chain (n_elements, &srcpad);
+  filter = gst_caps_from_string ("application/x-bench, rate = (int) 48000; "
+      "application/x-other");
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    caps = gst_pad_peer_query_caps (srcpad, filter);
+    g_assert (!gst_caps_is_empty (caps));
+    gst_caps_unref (caps);
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_caps_unref (filter);
+  destroy_chain (pipeline, srcpad);
+
+  return end - start;
+}
+
+static GstClockTime
+bench_buffer_alloc (guint64 size, guint64 iterations, gpointer user_data)
+{
+  GstClockTime start, end;
+  GstBuffer *buf;
+  guint64 i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    buf = gst_buffer_new_allocate (NULL, size, NULL);
+    gst_buffer_unref (buf);
+  }
+  end = gst_util_get_timestamp ();
+
+  return end - start;
+}
+
+static GstClockTime
+bench_pool_acquire (guint64 size, guint64 iterations, gpointer user_data)
+{
+  GstBufferPool *pool;
+  GstStructure *conf;
+  GstClockTime start, end;
+  GstBuffer *buf;
+  guint64 i;
+
+  pool = gst_buffer_pool_new ();
+  conf = gst_buffer_pool_get_config (pool);
+  gst_buffer_pool_config_set_params (conf, NULL, size, 0, 0);
+  gst_buffer_pool_set_config (pool, conf);
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+    gst_buffer_unref (buf);
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+
+  return end - start;
+}
+
+/* converts sample offsets to time at @rate with gst_util_uint64_scale_int()
+ * or, when @user_data is set, with a precomputed GstUtilScaler */
+static GstClockTime
+bench_scale (guint64 rate, guint64 iterations, gpointer user_data)
+{
+  GstClockTime start, end;
+  GstUtilScaler scaler;
+  guint64 i, sum = 0;
+
+  gst_util_scaler_init (&scaler, GST_SECOND, rate);
+
+  start = gst_util_get_timestamp ();
+  if (user_data) {
+    for (i = 0; i < iterations; i++)
+      sum += gst_util_scaler_scale (&scaler, i * 1024);
+  } else {
+    for (i = 0; i < iterations; i++)
+      sum += gst_util_uint64_scale_int (i * 1024, GST_SECOND, rate);
+  }
+  end = gst_util_get_timestamp ();
+
+  /* keep the loop from being optimized away */
+  if (sum == 1)
+    g_print ("%" G_GUINT64_FORMAT, sum);
+
+  return end - start;
+}
+
+/* fakesrc ! @n_queues x queue ! fakesink, with flushing seeks as fast as the
+ * pipeline prerolls again */
+static GstClockTime
+bench_flushing_seek (guint64 n_queues, guint64 iterations, gpointer user_data)
+{
+  GstElement *pipeline, *src, *sink, *prev;
+  GstClockTime start, end;
+  guint64 i;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src, "can-activate-pull", TRUE, NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+
+  prev = src;
+  for (i = 0; i < n_queues; i++) {
+    GstElement *queue = gst_element_factory_make ("queue", NULL);
+
+    gst_bin_add (GST_BIN (pipeline), queue);
+    gst_element_link (prev, queue);
+    prev = queue;
+  }
+  gst_element_link (prev, sink);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    gst_element_seek_simple (pipeline, GST_FORMAT_BYTES, GST_SEEK_FLAG_FLUSH,
+        0);
+    gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return end - start;
+}
+
+/* formats a typical debug message, with a pointer extension when @kind is 1
+ * and a segment when @kind is 2 */
+static GstClockTime
+bench_strdup_printf (guint64 kind, guint64 iterations, gpointer user_data)
+{
+  GstClockTime start, end;
+  GstElement *element;
+  GstSegment segment;
+  gchar *str;
+  guint64 i;
+
+  element = gst_element_factory_make ("fakesrc", NULL);
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < iterations; i++) {
+    if (kind == 0) {
+      str = gst_info_strdup_printf ("pushing buffer of %u bytes with ts %"
+          GST_TIME_FORMAT ", offset %" G_GUINT64_FORMAT, 1400,
+          GST_TIME_ARGS (i * GST_MSECOND), i);
+    } else if (kind == 1) {
+      str = gst_info_strdup_printf ("element %" GST_PTR_FORMAT
+          " pushing buffer of %u bytes", element, 1400);
+    } else {
+      str = gst_info_strdup_printf ("configured segment %"
+          GST_SEGMENT_FORMAT, &segment);
+    }
+    g_free (str);
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_object_unref (element);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  Bench *bench;
+  gint ret;
+
+  bench = bench_new ("core", &argc, &argv);
+
+  bench_add (bench, "pad-push", chain_lengths, G_N_ELEMENTS (chain_lengths),
+      200000, bench_pad_push, NULL);
+  bench_add (bench, "caps-query", chain_lengths, G_N_ELEMENTS (chain_lengths),
+      20000, bench_caps_query, NULL);
+  bench_add (bench, "buffer-alloc", buffer_sizes, G_N_ELEMENTS (buffer_sizes),
+      200000, bench_buffer_alloc, NULL);
+  bench_add (bench, "pool-acquire", buffer_sizes, G_N_ELEMENTS (buffer_sizes),
+      200000, bench_pool_acquire, NULL);
+  bench_add (bench, "scale-int", sample_rates, G_N_ELEMENTS (sample_rates),
+      5000000, bench_scale, NULL);
+  bench_add (bench, "scaler", sample_rates, G_N_ELEMENTS (sample_rates),
+      5000000, bench_scale, GINT_TO_POINTER (TRUE));
+  bench_add (bench, "flushing-seek", chain_lengths,
+      G_N_ELEMENTS (chain_lengths), 2000, bench_flushing_seek, NULL);
+  bench_add (bench, "strdup-printf", printf_kinds, G_N_ELEMENTS (printf_kinds),
+      200000, bench_strdup_printf, NULL);
+
+  ret = bench_run (bench);
+  bench_free (bench);
+
+  return ret;
+}
@@ -0,0 +1,125 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the cost of pushing a buffer and combining the flow returns like
+ * a demuxer does, for 1 to 1024 source pads. Some of the pads are not linked
+ * so that the combiner can't take the shortcut of the previous combined
+ * flow return being the same as the new one. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/base/gstflowcombiner.h>
+
+#define DEFAULT_BUFFERS (1000000)
+#define MAX_PADS (1024)
+
+static GstFlowReturn
+sink_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static GstClockTime
+run (guint n_pads, guint n_buffers)
+{
+  GstFlowCombiner *combiner;
+  GstPad **srcpads, **sinkpads;
+  GstSegment segment;
+  GstBuffer *buf;
+  GstClockTime start, end;
+  guint i;
+
+  combiner = gst_flow_combiner_new ();
+  srcpads = g_new0 (GstPad *, n_pads);
+  sinkpads = g_new0 (GstPad *, n_pads);
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  buf = gst_buffer_new ();
+
+  for (i = 0; i < n_pads; i++) {
+    srcpads[i] = gst_pad_new (NULL, GST_PAD_SRC);
+    gst_pad_set_active (srcpads[i], TRUE);
+    gst_flow_combiner_add_pad (combiner, srcpads[i]);
+
+    /* every fourth pad is not linked */
+    if (i % 4 == 3)
+      continue;
+
+    sinkpads[i] = gst_pad_new (NULL, GST_PAD_SINK);
+    gst_pad_set_chain_function (sinkpads[i], sink_chain);
+    gst_pad_set_active (sinkpads[i], TRUE);
+    if (gst_pad_link (srcpads[i], sinkpads[i]) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+
+    gst_pad_push_event (srcpads[i], gst_event_new_stream_start ("test"));
+    gst_pad_push_event (srcpads[i], gst_event_new_segment (&segment));
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < n_buffers; i++) {
+    GstPad *pad = srcpads[i % n_pads];
+    GstFlowReturn ret;
+
+    ret = gst_pad_push (pad, gst_buffer_ref (buf));
+    ret = gst_flow_combiner_update_pad_flow (combiner, pad, ret);
+    if (ret != GST_FLOW_OK)
+      g_assert_not_reached ();
+  }
+  end = gst_util_get_timestamp ();
+
+  gst_flow_combiner_free (combiner);
+  for (i = 0; i < n_pads; i++) {
+    gst_pad_set_active (srcpads[i], FALSE);
+    gst_object_unref (srcpads[i]);
+    if (sinkpads[i]) {
+      gst_pad_set_active (sinkpads[i], FALSE);
+      gst_object_unref (sinkpads[i]);
+    }
+  }
+  g_free (srcpads);
+  g_free (sinkpads);
+  gst_buffer_unref (buf);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint n_buffers = DEFAULT_BUFFERS, n_pads;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    n_buffers = atoi (argv[1]);
+
+  if (n_buffers == 0) {
+    g_print ("usage: %s [<nbuffers>]\n", argv[0]);
+    exit (-1);
+  }
+
+  for (n_pads = 1; n_pads <= MAX_PADS; n_pads *= 2) {
+    GstClockTime elapsed = run (n_pads, n_buffers);
+
+    g_print ("*** %4u pads: %" GST_TIME_FORMAT " (%" G_GUINT64_FORMAT
+        " ns/buffer)\n", n_pads, GST_TIME_ARGS (elapsed),
+        elapsed / n_buffers);
+  }
+
+  return 0;
+}
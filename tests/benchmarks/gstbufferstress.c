@@ -25,6 +25,7 @@
 #define MAX_THREADS  1000
 
 static guint64 nbbuffers;
+static gsize buffer_size;
 static GMutex mutex;
 
 
@@ -44,7 +45,10 @@ run_test (void *user_data)
   g_assert (nbbuffers > 0);
 
   for (nb = nbbuffers; nb; nb--) {
-    buf = gst_buffer_new ();
+    if (buffer_size > 0)
+      buf = gst_buffer_new_allocate (NULL, buffer_size, NULL);
+    else
+      buf = gst_buffer_new ();
     gst_buffer_unref (buf);
   }
 
@@ -70,13 +74,16 @@ main (gint argc, gchar * argv[])
   gst_init (&argc, &argv);
   g_mutex_init (&mutex);
 
-  if (argc != 3) {
-    g_print ("usage: %s <num_threads> <nbbuffers>\n", argv[0]);
+  if (argc != 3 && argc != 4) {
+    g_print ("usage: %s <num_threads> <nbbuffers> [<buffer_size>]\n",
+        argv[0]);
     exit (-1);
   }
 
   num_threads = atoi (argv[1]);
   nbbuffers = atoi (argv[2]);
+  if (argc == 4)
+    buffer_size = atoi (argv[3]);
 
   if (num_threads <= 0 || num_threads > MAX_THREADS) {
     g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
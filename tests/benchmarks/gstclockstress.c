@@ -23,9 +23,11 @@
 #include <gst/glib-compat-private.h>
 
 #define MAX_THREADS  100
+#define PERIODIC_INTERVAL (100 * GST_MSECOND)
 
 static gboolean running = TRUE;
 static gint count = 0;
+static gint fired = 0;
 
 static void *
 run_test (void *user_data)
@@ -43,22 +45,62 @@ run_test (void *user_data)
   return NULL;
 }
 
+static gboolean
+async_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  g_atomic_int_inc (&fired);
+  return TRUE;
+}
+
+/* schedules and cancels async entries at random times, while the periodic
+ * entries of main() are pending */
+static void *
+run_async_test (void *user_data)
+{
+  gint prev;
+  GstClock *sysclock = GST_CLOCK_CAST (user_data);
+  GRand *rand = g_rand_new ();
+
+  while (running) {
+    GstClockID id;
+
+    id = gst_clock_new_single_shot_id (sysclock,
+        gst_clock_get_time (sysclock) +
+        g_rand_int_range (rand, 1, 1000) * GST_SECOND);
+    gst_clock_id_wait_async (id, async_cb, NULL, NULL);
+    gst_clock_id_unschedule (id);
+    gst_clock_id_unref (id);
+
+    prev = g_atomic_int_add (&count, 1);
+    if (prev == G_MAXINT)
+      g_warning ("overflow");
+  }
+  g_rand_free (rand);
+  g_thread_exit (NULL);
+  return NULL;
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
   GThread *threads[MAX_THREADS];
-  gint num_threads;
+  GstClockID *periodic = NULL;
+  gint num_threads, num_async = 0;
   gint t;
   GstClock *sysclock;
 
   gst_init (&argc, &argv);
 
-  if (argc != 2) {
-    g_print ("usage: %s <num_threads>\n", argv[0]);
+  if (argc != 2 && argc != 3) {
+    g_print ("usage: %s <num_threads> [<num_periodic_async_entries>]\n",
+        argv[0]);
     exit (-1);
   }
 
   num_threads = atoi (argv[1]);
+  if (argc == 3)
+    num_async = atoi (argv[2]);
 
   if (num_threads <= 0 || num_threads > MAX_THREADS) {
     g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
@@ -67,11 +109,24 @@ main (gint argc, gchar * argv[])
 
   sysclock = gst_system_clock_obtain ();
 
+  /* in async mode the threads add and cancel entries in a clock that already
+   * has a lot of periodic entries pending */
+  if (num_async > 0) {
+    GstClockTime now = gst_clock_get_time (sysclock);
+
+    periodic = g_new (GstClockID, num_async);
+    for (t = 0; t < num_async; t++) {
+      periodic[t] = gst_clock_new_periodic_id (sysclock,
+          now + (t % 100) * PERIODIC_INTERVAL / 100, PERIODIC_INTERVAL);
+      gst_clock_id_wait_async (periodic[t], async_cb, NULL, NULL);
+    }
+  }
+
   for (t = 0; t < num_threads; t++) {
     GError *error = NULL;
 
-    threads[t] = g_thread_try_new ("clockstresstest", run_test,
-        sysclock, &error);
+    threads[t] = g_thread_try_new ("clockstresstest",
+        num_async > 0 ? run_async_test : run_test, sysclock, &error);
 
     if (error) {
       printf ("ERROR: g_thread_try_new() %s\n", error->message);
@@ -92,7 +147,18 @@ main (gint argc, gchar * argv[])
     g_thread_join (threads[t]);
   }
 
-  g_print ("performed %d get_time operations\n", count);
+  if (num_async > 0) {
+    for (t = 0; t < num_async; t++) {
+      gst_clock_id_unschedule (periodic[t]);
+      gst_clock_id_unref (periodic[t]);
+    }
+    g_free (periodic);
+
+    g_print ("performed %d wait_async/unschedule operations, %d callbacks "
+        "fired\n", count, fired);
+  } else {
+    g_print ("performed %d get_time operations\n", count);
+  }
 
   gst_object_unref (sysclock);
 
@@ -24,6 +24,27 @@
 
 #define BUFFER_SIZE (1400)
 
+static gint
+compare_time (gconstpointer a, gconstpointer b)
+{
+  GstClockTime ta = *(const GstClockTime *) a;
+  GstClockTime tb = *(const GstClockTime *) b;
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+static void
+print_percentile (GstClockTime * lat, guint64 n, gdouble percentile)
+{
+  guint64 idx = (guint64) (n * percentile / 100.0);
+
+  if (idx >= n)
+    idx = n - 1;
+
+  g_print ("*** acquire latency p%-5.1lf %" GST_TIME_FORMAT "\n", percentile,
+      GST_TIME_ARGS (lat[idx]));
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
@@ -33,7 +54,9 @@ main (gint argc, gchar * argv[])
   GstClockTime start, end;
   GstClockTimeDiff dur1, dur2;
   guint64 nbuffers;
-  GstStructure *conf;
+  GstStructure *conf, *stats;
+  GstClockTime *lat;
+  gchar *str;
 
   gst_init (&argc, &argv);
 
@@ -87,6 +110,29 @@ main (gint argc, gchar * argv[])
 
   g_print ("*** speedup %6.4lf\n", ((gdouble) dur1 / (gdouble) dur2));
 
+  /* measure the latency of each acquire */
+  lat = g_new (GstClockTime, nbuffers);
+  for (i = 0; i < nbuffers; i++) {
+    start = gst_util_get_timestamp ();
+    gst_buffer_pool_acquire_buffer (pool, &tmp, NULL);
+    end = gst_util_get_timestamp ();
+    gst_buffer_unref (tmp);
+    lat[i] = end - start;
+  }
+  qsort (lat, nbuffers, sizeof (GstClockTime), compare_time);
+  print_percentile (lat, nbuffers, 50.0);
+  print_percentile (lat, nbuffers, 90.0);
+  print_percentile (lat, nbuffers, 99.0);
+  print_percentile (lat, nbuffers, 99.9);
+  print_percentile (lat, nbuffers, 100.0);
+  g_free (lat);
+
+  stats = gst_buffer_pool_get_stats (pool);
+  str = gst_structure_to_string (stats);
+  g_print ("*** pool stats %s\n", str);
+  g_free (str);
+  gst_structure_free (stats);
+
   gst_buffer_pool_set_active (pool, FALSE);
   gst_object_unref (pool);
 
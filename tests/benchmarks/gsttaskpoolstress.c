@@ -0,0 +1,129 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of short jobs on the shared and the work stealing
+ * task pools for 1 to 64 threads. Half of the jobs are pushed from the main
+ * thread, the other half are pushed by the jobs themselves. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define JOB_COUNT (200000)
+#define JOB_ITERATIONS (200)
+
+static GstTaskPool *pool;
+static gint jobs_left;
+static GMutex done_lock;
+static GCond done_cond;
+static gboolean done;
+
+static void
+finish_job (void)
+{
+  if (g_atomic_int_dec_and_test (&jobs_left)) {
+    g_mutex_lock (&done_lock);
+    done = TRUE;
+    g_cond_signal (&done_cond);
+    g_mutex_unlock (&done_lock);
+  }
+}
+
+static void
+child_job (gpointer user_data)
+{
+  volatile guint i, v = 0;
+
+  for (i = 0; i < JOB_ITERATIONS; i++)
+    v += i;
+
+  finish_job ();
+}
+
+static void
+parent_job (gpointer user_data)
+{
+  gst_task_pool_dispose_handle (pool, gst_task_pool_push (pool, child_job,
+          NULL, NULL));
+
+  child_job (NULL);
+}
+
+static GstClockTimeDiff
+run_jobs (guint jobs)
+{
+  GstClockTime start, end;
+  guint i;
+
+  gst_task_pool_prepare (pool, NULL);
+
+  g_atomic_int_set (&jobs_left, (jobs / 2) * 2);
+  done = FALSE;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < jobs / 2; i++)
+    gst_task_pool_dispose_handle (pool, gst_task_pool_push (pool, parent_job,
+            NULL, NULL));
+
+  g_mutex_lock (&done_lock);
+  while (!done)
+    g_cond_wait (&done_cond, &done_lock);
+  g_mutex_unlock (&done_lock);
+  end = gst_util_get_timestamp ();
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+  pool = NULL;
+
+  return GST_CLOCK_DIFF (start, end);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstClockTimeDiff dur1, dur2;
+  guint threads, max_threads = 64, jobs = JOB_COUNT;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    jobs = atoi (argv[1]);
+  if (argc > 2)
+    max_threads = atoi (argv[2]);
+
+  if (jobs < 2 || max_threads == 0) {
+    g_print ("usage: %s [<njobs> [<max-threads>]]\n", argv[0]);
+    exit (-1);
+  }
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    pool = gst_shared_task_pool_new ();
+    gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool),
+        threads);
+    dur1 = run_jobs (jobs);
+
+    pool = gst_work_stealing_task_pool_new (threads);
+    dur2 = run_jobs (jobs);
+
+    g_print ("*** %2u threads - shared %" GST_TIME_FORMAT
+        " - work stealing %" GST_TIME_FORMAT " - speedup %6.4lf\n", threads,
+        GST_TIME_ARGS (dur1), GST_TIME_ARGS (dur2),
+        ((gdouble) dur1 / (gdouble) dur2));
+  }
+
+  return 0;
+}
@@ -20,12 +20,48 @@
  */
 
 
+/* Measures gst_init() and the first use of the parts that are only set up
+ * when needed, so that moving work out of gst_init() doesn't go unnoticed */
+
 #include <gst/gst.h>
 
+static gint64 phase_start;
+
+static void
+phase_done (const gchar * name)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  g_print ("*** %-24s %8" G_GINT64_FORMAT " us\n", name, now - phase_start);
+  phase_start = now;
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
+  GstTagList *tags;
+  GstElement *element;
+  GList *factories;
+
+  phase_start = g_get_monotonic_time ();
   gst_init (&argc, &argv);
+  phase_done ("gst_init");
+
+  tags = gst_tag_list_new (GST_TAG_TITLE, "title", NULL);
+  gst_tag_list_unref (tags);
+  phase_done ("first tag list");
+
+  element = gst_element_factory_make ("fakesrc", NULL);
+  if (element)
+    gst_object_unref (element);
+  phase_done ("first element");
+
+  factories = gst_element_factory_list_get_elements
+      (GST_ELEMENT_FACTORY_TYPE_ANY, GST_RANK_NONE);
+  phase_done ("element factory list");
+
+  g_print ("*** %u element factories\n", g_list_length (factories));
+  gst_plugin_feature_list_free (factories);
 
   return 0;
 }
@@ -0,0 +1,201 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the switch latency and the CPU usage of an input-selector with
+ * many live inputs that are synchronized to the clock. Every input is fed
+ * from its own thread with one buffer every 10ms, the active pad is changed
+ * at a fixed interval and the time until the first buffer of the new input
+ * reaches the srcpad is recorded. */
+
+#include <stdlib.h>
+#include <time.h>
+#include <gst/gst.h>
+
+#define DEFAULT_PADS (1000)
+#define DEFAULT_SWITCHES (20)
+#define BUFFER_DURATION (10 * GST_MSECOND)
+#define SWITCH_INTERVAL (100 * G_TIME_SPAN_MILLISECOND)
+
+typedef struct
+{
+  GstPad *srcpad;
+  GThread *thread;
+  guint index;
+} Input;
+
+static gint running;
+
+static GMutex switch_lock;
+static guint switch_target;
+static gint64 switch_time;
+static gint64 total_latency, max_latency;
+static guint n_switched;
+
+static gpointer
+push_thread (Input * input)
+{
+  guint64 i = 0;
+
+  while (g_atomic_int_get (&running)) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    GST_BUFFER_PTS (buf) = i * BUFFER_DURATION;
+    GST_BUFFER_DURATION (buf) = BUFFER_DURATION;
+    GST_BUFFER_OFFSET (buf) = input->index;
+    if (gst_pad_push (input->srcpad, buf) == GST_FLOW_FLUSHING)
+      break;
+    i++;
+  }
+
+  return NULL;
+}
+
+static GstPadProbeReturn
+output_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  g_mutex_lock (&switch_lock);
+  if (switch_time != 0 && GST_BUFFER_OFFSET (buf) == switch_target) {
+    gint64 latency = g_get_monotonic_time () - switch_time;
+
+    total_latency += latency;
+    max_latency = MAX (max_latency, latency);
+    n_switched++;
+    switch_time = 0;
+  }
+  g_mutex_unlock (&switch_lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *pipeline, *sel, *sink;
+  GstPad *pad, **selpads;
+  Input *inputs;
+  GstSegment segment;
+  guint n_pads = DEFAULT_PADS, n_switches = DEFAULT_SWITCHES;
+  guint group_id, i;
+  clock_t start_cpu, end_cpu;
+  gint64 start, end;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    n_pads = atoi (argv[1]);
+  if (argc > 2)
+    n_switches = atoi (argv[2]);
+
+  if (n_pads < 2 || n_switches == 0) {
+    g_print ("usage: %s [<npads> [<nswitches>]]\n", argv[0]);
+    exit (-1);
+  }
+
+  pipeline = gst_pipeline_new (NULL);
+  sel = gst_element_factory_make ("input-selector", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  if (!sel || !sink) {
+    g_print ("input-selector or fakesink not found, aborting...\n");
+    exit (1);
+  }
+  g_object_set (sel, "sync-mode", 1 /* clock */ , NULL);
+  g_object_set (sink, "sync", TRUE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), sel, sink, NULL);
+  if (!gst_element_link (sel, sink))
+    g_assert_not_reached ();
+
+  pad = gst_element_get_static_pad (sel, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, output_probe, NULL, NULL);
+  gst_object_unref (pad);
+
+  inputs = g_new0 (Input, n_pads);
+  selpads = g_new0 (GstPad *, n_pads);
+  for (i = 0; i < n_pads; i++) {
+    selpads[i] = gst_element_request_pad_simple (sel, "sink_%u");
+    inputs[i].index = i;
+    inputs[i].srcpad = gst_pad_new ("src", GST_PAD_SRC);
+    if (gst_pad_link (inputs[i].srcpad, selpads[i]) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+  }
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  group_id = gst_util_group_id_next ();
+  for (i = 0; i < n_pads; i++) {
+    GstEvent *event;
+    gchar *stream_id = g_strdup_printf ("input%u", i);
+
+    gst_pad_set_active (inputs[i].srcpad, TRUE);
+    event = gst_event_new_stream_start (stream_id);
+    gst_event_set_group_id (event, group_id);
+    gst_pad_push_event (inputs[i].srcpad, event);
+    gst_pad_push_event (inputs[i].srcpad,
+        gst_event_new_caps (gst_caps_new_empty_simple ("video/x-raw")));
+    gst_pad_push_event (inputs[i].srcpad, gst_event_new_segment (&segment));
+    g_free (stream_id);
+  }
+
+  g_atomic_int_set (&running, TRUE);
+  for (i = 0; i < n_pads; i++)
+    inputs[i].thread = g_thread_new ("input", (GThreadFunc) push_thread,
+        &inputs[i]);
+
+  start = g_get_monotonic_time ();
+  start_cpu = clock ();
+  for (i = 0; i < n_switches; i++) {
+    guint target = (i * 7919 + 1) % n_pads;
+
+    g_usleep (SWITCH_INTERVAL);
+
+    g_mutex_lock (&switch_lock);
+    switch_target = target;
+    switch_time = g_get_monotonic_time ();
+    g_mutex_unlock (&switch_lock);
+
+    g_object_set (sel, "active-pad", selpads[target], NULL);
+  }
+  g_usleep (SWITCH_INTERVAL);
+  end_cpu = clock ();
+  end = g_get_monotonic_time ();
+
+  g_print ("*** %u pads, %u switches: average latency %" G_GINT64_FORMAT
+      "us, max %" G_GINT64_FORMAT "us\n", n_pads, n_switched,
+      n_switched ? total_latency / n_switched : 0, max_latency);
+  g_print ("*** CPU usage %.1f%% of one core\n",
+      100.0 * (end_cpu - start_cpu) / CLOCKS_PER_SEC /
+      ((end - start) / (gdouble) G_USEC_PER_SEC));
+
+  g_atomic_int_set (&running, FALSE);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  for (i = 0; i < n_pads; i++) {
+    g_thread_join (inputs[i].thread);
+    gst_pad_set_active (inputs[i].srcpad, FALSE);
+    gst_object_unref (inputs[i].srcpad);
+    gst_object_unref (selpads[i]);
+  }
+  g_free (inputs);
+  g_free (selpads);
+  gst_object_unref (pipeline);
+
+  return 0;
+}
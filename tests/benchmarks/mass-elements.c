@@ -31,6 +31,7 @@ main (gint argc, gchar * argv[])
 {
   GstMessage *msg;
   GstElement *pipeline, *src, *sink, *current, *last;
+  GstElementFactory *factory;
   guint i, buffers = BUFFER_COUNT, identities = IDENTITY_COUNT;
   GstClockTime start, end;
   const gchar *src_name = SRC_ELEMENT, *sink_name = SINK_ELEMENT;
@@ -81,6 +82,27 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " - creating %u identity elements\n",
       GST_TIME_ARGS (end - start), identities);
 
+  /* the same, but linking the pads by name without any checks */
+  start = gst_util_get_timestamp ();
+  current = gst_element_factory_make ("pipeline", NULL);
+  last = gst_element_factory_make (src_name, NULL);
+  gst_bin_add (GST_BIN (current), last);
+  for (i = 0; i < identities; i++) {
+    GstElement *e = gst_element_factory_make ("identity", NULL);
+
+    g_object_set (e, "silent", TRUE, NULL);
+    gst_bin_add (GST_BIN (current), e);
+    if (!gst_element_link_pads_full (last, "src", e, "sink",
+            GST_PAD_LINK_CHECK_NOTHING))
+      g_assert_not_reached ();
+    last = e;
+  }
+  end = gst_util_get_timestamp ();
+  gst_object_unref (current);
+  g_print ("%" GST_TIME_FORMAT
+      " - creating %u identity elements, linking without checks\n",
+      GST_TIME_ARGS (end - start), identities);
+
   start = gst_util_get_timestamp ();
   if (gst_element_set_state (pipeline,
           GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
@@ -114,5 +136,31 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " - unreffing pipeline\n",
       GST_TIME_ARGS (end - start));
 
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < identities; i++) {
+    current = gst_object_ref_sink (gst_element_factory_make ("identity", NULL));
+    g_object_set (current, "silent", TRUE, NULL);
+    gst_object_unref (current);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - creating and freeing %u identity elements\n",
+      GST_TIME_ARGS (end - start), identities);
+
+  factory = gst_element_factory_find ("identity");
+  g_assert (factory);
+  gst_element_factory_set_pool_size (factory, 1);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < identities; i++) {
+    current = gst_object_ref_sink (gst_element_factory_make ("identity", NULL));
+    g_object_set (current, "silent", TRUE, NULL);
+    gst_element_factory_recycle (current);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT
+      " - creating and recycling %u identity elements\n",
+      GST_TIME_ARGS (end - start), identities);
+  gst_element_factory_set_pool_size (factory, 0);
+  gst_object_unref (factory);
+
   return 0;
 }
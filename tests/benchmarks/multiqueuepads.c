@@ -0,0 +1,158 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the cost per buffer of pushing interleaved streams through a
+ * multiqueue that synchronizes them by running time, for a growing number
+ * of streams */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define BUFFERS_PER_PAD (1000)
+#define MIN_PADS (2)
+#define MAX_PADS (256)
+
+static GstElement *
+create_pipeline (guint n_pads, GstPad ** srcpads)
+{
+  GstElement *pipeline, *mq;
+  GstSegment segment;
+  guint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  mq = gst_element_factory_make ("multiqueue", NULL);
+  if (!mq) {
+    g_print ("no element named \"multiqueue\" found, aborting...\n");
+    exit (1);
+  }
+  g_object_set (mq, "sync-by-running-time", TRUE, NULL);
+  gst_bin_add (GST_BIN (pipeline), mq);
+
+  for (i = 0; i < n_pads; i++) {
+    GstElement *sink;
+    GstPad *mq_sinkpad, *mq_srcpad, *sinkpad;
+    gchar *name;
+
+    mq_sinkpad = gst_element_request_pad_simple (mq, "sink_%u");
+    name = g_strdup_printf ("src_%u", i);
+    mq_srcpad = gst_element_get_static_pad (mq, name);
+    g_free (name);
+
+    sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (sink, "sync", FALSE, NULL);
+    gst_bin_add (GST_BIN (pipeline), sink);
+    sinkpad = gst_element_get_static_pad (sink, "sink");
+    if (gst_pad_link (mq_srcpad, sinkpad) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+    gst_object_unref (sinkpad);
+    gst_object_unref (mq_srcpad);
+
+    srcpads[i] = gst_pad_new ("src", GST_PAD_SRC);
+    if (gst_pad_link (srcpads[i], mq_sinkpad) != GST_PAD_LINK_OK)
+      g_assert_not_reached ();
+    gst_object_unref (mq_sinkpad);
+  }
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  for (i = 0; i < n_pads; i++) {
+    gchar *stream_id = g_strdup_printf ("bench%u", i);
+
+    gst_pad_set_active (srcpads[i], TRUE);
+    gst_pad_push_event (srcpads[i], gst_event_new_stream_start (stream_id));
+    gst_pad_push_event (srcpads[i],
+        gst_event_new_caps (gst_caps_new_empty_simple ("audio/x-raw")));
+    gst_pad_push_event (srcpads[i], gst_event_new_segment (&segment));
+    g_free (stream_id);
+  }
+
+  return pipeline;
+}
+
+static void
+destroy_pipeline (GstElement * pipeline, guint n_pads, GstPad ** srcpads)
+{
+  guint i;
+
+  for (i = 0; i < n_pads; i++) {
+    gst_pad_set_active (srcpads[i], FALSE);
+    gst_object_unref (srcpads[i]);
+  }
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstPad *srcpads[MAX_PADS];
+  guint n_pads, buffers = BUFFERS_PER_PAD;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    buffers = atoi (argv[1]);
+
+  if (buffers == 0) {
+    g_print ("usage: %s [<nbuffers per pad>]\n", argv[0]);
+    exit (-1);
+  }
+
+  for (n_pads = MIN_PADS; n_pads <= MAX_PADS; n_pads *= 2) {
+    GstElement *pipeline;
+    GstMessage *msg;
+    GstClockTime start, end;
+    GstClockTimeDiff dur;
+    guint i, j;
+
+    pipeline = create_pipeline (n_pads, srcpads);
+
+    start = gst_util_get_timestamp ();
+    for (i = 0; i < buffers; i++) {
+      for (j = 0; j < n_pads; j++) {
+        GstBuffer *buf = gst_buffer_new ();
+
+        GST_BUFFER_PTS (buf) = i * 10 * GST_MSECOND;
+        GST_BUFFER_DURATION (buf) = 10 * GST_MSECOND;
+        if (gst_pad_push (srcpads[j], buf) != GST_FLOW_OK)
+          g_assert_not_reached ();
+      }
+    }
+    for (j = 0; j < n_pads; j++)
+      gst_pad_push_event (srcpads[j], gst_event_new_eos ());
+
+    msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+        GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+      g_assert_not_reached ();
+    gst_message_unref (msg);
+    end = gst_util_get_timestamp ();
+
+    dur = GST_CLOCK_DIFF (start, end);
+    g_print ("*** %3u pads: total %" GST_TIME_FORMAT " - average %"
+        GST_TIME_FORMAT " per buffer\n", n_pads, GST_TIME_ARGS (dur),
+        GST_TIME_ARGS (dur / (buffers * n_pads)));
+
+    destroy_pipeline (pipeline, n_pads, srcpads);
+  }
+
+  return 0;
+}
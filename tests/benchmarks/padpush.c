@@ -0,0 +1,244 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the cost per buffer of gst_pad_push() through chains of identity
+ * elements, as plain chains, with a buffer probe on every pad, pushing
+ * buffer lists, with every element inside a bin behind ghost pads and with
+ * a queue thread after every fourth element.
+ *
+ * The chain lengths can be given after the options, for example
+ * "padpush --json 1 8 64". See bench.c for the other options.
+ */
+
+#include <stdlib.h>
+
+#include "bench.h"
+
+#define BUFFER_SIZE (188)
+#define LIST_SIZE (64)
+#define QUEUE_DISTANCE (4)
+
+typedef enum
+{
+  CHAIN_PLAIN = 0,
+  CHAIN_PROBES = (1 << 0),
+  CHAIN_LISTS = (1 << 1),
+  CHAIN_GHOST = (1 << 2),
+  CHAIN_QUEUE = (1 << 3)
+} ChainFlags;
+
+static const guint64 default_lengths[] = { 1, 4, 16, 64 };
+
+static GstPadProbeReturn
+pass_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+add_probe (GstElement * element, const gchar * padname)
+{
+  GstPad *pad = gst_element_get_static_pad (element, padname);
+
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_BUFFER_LIST, pass_probe, NULL, NULL);
+  gst_object_unref (pad);
+}
+
+/* identity, inside its own bin with ghost pads when asked for */
+static GstElement *
+create_element (ChainFlags flags)
+{
+  GstElement *identity, *bin;
+  GstPad *pad;
+
+  identity = gst_element_factory_make ("identity", NULL);
+  g_assert (identity != NULL);
+
+  if (flags & CHAIN_PROBES)
+    add_probe (identity, "src");
+
+  if (!(flags & CHAIN_GHOST))
+    return identity;
+
+  bin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (bin), identity);
+
+  pad = gst_element_get_static_pad (identity, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (identity, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+  gst_object_unref (pad);
+
+  return bin;
+}
+
+static GstElement *
+create_chain (guint64 length, ChainFlags flags, GstPad ** srcpad)
+{
+  GstElement *pipeline, *current, *last = NULL;
+  GstPad *sinkpad = NULL;
+  GstSegment segment;
+  guint64 i;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  for (i = 0; i <= length; i++) {
+    if (i < length) {
+      current = create_element (flags);
+    } else {
+      current = gst_element_factory_make ("fakesink", NULL);
+      g_object_set (current, "sync", FALSE, NULL);
+    }
+    gst_bin_add (GST_BIN (pipeline), current);
+    if (last && !gst_element_link (last, current))
+      g_assert_not_reached ();
+    else if (!last)
+      sinkpad = gst_element_get_static_pad (current, "sink");
+    last = current;
+
+    if ((flags & CHAIN_QUEUE) && i < length && (i + 1) % QUEUE_DISTANCE == 0) {
+      current = gst_element_factory_make ("queue", NULL);
+      gst_bin_add (GST_BIN (pipeline), current);
+      if (!gst_element_link (last, current))
+        g_assert_not_reached ();
+      last = current;
+    }
+  }
+
+  *srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  if (gst_pad_link (*srcpad, sinkpad) != GST_PAD_LINK_OK)
+    g_assert_not_reached ();
+  gst_object_unref (sinkpad);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    g_assert_not_reached ();
+  gst_pad_set_active (*srcpad, TRUE);
+
+  gst_pad_push_event (*srcpad, gst_event_new_stream_start ("padpush"));
+  gst_pad_push_event (*srcpad,
+      gst_event_new_caps (gst_caps_new_empty_simple ("video/mpegts")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (*srcpad, gst_event_new_segment (&segment));
+
+  return pipeline;
+}
+
+/* wait for the queue threads to push everything to the sink */
+static void
+wait_eos (GstElement * pipeline, GstPad * srcpad)
+{
+  GstBus *bus;
+  GstMessage *msg;
+
+  gst_pad_push_event (srcpad, gst_event_new_eos ());
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  g_assert (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+static GstClockTime
+bench_chain (guint64 length, guint64 iterations, gpointer user_data)
+{
+  ChainFlags flags = GPOINTER_TO_INT (user_data);
+  GstElement *pipeline;
+  GstPad *srcpad;
+  GstBuffer *buf;
+  GstClockTime start, end;
+  guint64 i, j;
+
+  pipeline = create_chain (length, flags, &srcpad);
+  buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+
+  start = gst_util_get_timestamp ();
+  if (flags & CHAIN_LISTS) {
+    for (i = 0; i < iterations; i += LIST_SIZE) {
+      GstBufferList *list = gst_buffer_list_new_sized (LIST_SIZE);
+
+      for (j = 0; j < LIST_SIZE && i + j < iterations; j++)
+        gst_buffer_list_add (list, gst_buffer_ref (buf));
+
+      if (gst_pad_push_list (srcpad, list) != GST_FLOW_OK)
+        g_assert_not_reached ();
+    }
+  } else {
+    for (i = 0; i < iterations; i++) {
+      if (gst_pad_push (srcpad, gst_buffer_ref (buf)) != GST_FLOW_OK)
+        g_assert_not_reached ();
+    }
+  }
+  if (flags & CHAIN_QUEUE)
+    wait_eos (pipeline, srcpad);
+  end = gst_util_get_timestamp ();
+
+  gst_buffer_unref (buf);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (srcpad);
+  gst_object_unref (pipeline);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  const guint64 *lengths = default_lengths;
+  guint n_lengths = G_N_ELEMENTS (default_lengths);
+  guint64 *args = NULL;
+  Bench *bench;
+  gint i, ret;
+
+  bench = bench_new ("padpush", &argc, &argv);
+
+  if (argc > 1) {
+    args = g_new (guint64, argc - 1);
+    for (i = 1; i < argc; i++) {
+      args[i - 1] = g_ascii_strtoull (argv[i], NULL, 10);
+      if (args[i - 1] == 0) {
+        g_printerr ("usage: %s [options] [<chain-length> ...]\n", argv[0]);
+        exit (1);
+      }
+    }
+    lengths = args;
+    n_lengths = argc - 1;
+  }
+
+  bench_add (bench, "push", lengths, n_lengths, 100000, bench_chain,
+      GINT_TO_POINTER (CHAIN_PLAIN));
+  bench_add (bench, "push-probes", lengths, n_lengths, 100000, bench_chain,
+      GINT_TO_POINTER (CHAIN_PROBES));
+  bench_add (bench, "push-lists", lengths, n_lengths, 100000, bench_chain,
+      GINT_TO_POINTER (CHAIN_LISTS));
+  bench_add (bench, "push-ghost", lengths, n_lengths, 100000, bench_chain,
+      GINT_TO_POINTER (CHAIN_GHOST));
+  bench_add (bench, "push-queue", lengths, n_lengths, 100000, bench_chain,
+      GINT_TO_POINTER (CHAIN_QUEUE));
+
+  ret = bench_run (bench);
+  bench_free (bench);
+  g_free (args);
+
+  return ret;
+}
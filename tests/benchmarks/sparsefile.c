@@ -0,0 +1,78 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the range bookkeeping of the sparse file used by queue2 and
+ * downloadbuffer for their temp files, without any file I/O. A client seeks
+ * to random positions and downloads a few chunks from there, like a player
+ * that is scrubbed through a large download. After every chunk the element
+ * looks up the range around its read position and reads from it. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+
+/* not public API */
+#include "../../plugins/elements/gstsparsefile.c"
+
+#define DEFAULT_SEEKS (20000)
+#define FILE_SIZE (G_GUINT64_CONSTANT (1) << 32)
+#define CHUNK_SIZE (16 * 1024)
+#define CHUNKS_PER_SEEK (8)
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static guint8 chunk[CHUNK_SIZE];
+  GstSparseFile *file;
+  GstClockTime start, elapsed;
+  guint seeks = DEFAULT_SEEKS, i, j;
+  guint64 ops = 0;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    seeks = atoi (argv[1]);
+
+  file = gst_sparse_file_new ();
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < seeks; i++) {
+    gsize offset = (gsize) (g_random_double () * (FILE_SIZE - CHUNK_SIZE *
+            CHUNKS_PER_SEEK)) / CHUNK_SIZE * CHUNK_SIZE;
+
+    for (j = 0; j < CHUNKS_PER_SEEK; j++) {
+      gsize range_start, range_stop;
+
+      gst_sparse_file_write (file, offset, chunk, CHUNK_SIZE, NULL, NULL);
+      gst_sparse_file_get_range_after (file, offset, &range_start,
+          &range_stop);
+      gst_sparse_file_get_range_before (file, offset, &range_start,
+          &range_stop);
+      gst_sparse_file_read (file, offset, chunk, CHUNK_SIZE, NULL, NULL);
+      offset += CHUNK_SIZE;
+      ops += 4;
+    }
+  }
+  elapsed = gst_util_get_timestamp () - start;
+
+  g_print ("*** %u seeks, %u ranges, %.1f ns per operation\n", seeks,
+      gst_sparse_file_n_ranges (file), (gdouble) elapsed / ops);
+
+  gst_sparse_file_free (file);
+
+  return 0;
+}
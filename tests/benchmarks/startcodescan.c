@@ -0,0 +1,201 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Measures the throughput of the start code scans of GstByteReader and
+ * GstAdapter on a synthetic H.264 style bitstream. NAL units of random
+ * payload with emulation prevention applied are separated by start codes,
+ * the adapter is filled with buffers of a fixed size like a demuxer or
+ * network source would produce them.
+ *
+ * The special cased start code pattern is compared against the equivalent
+ * generic masked scan, which goes through the byte-wise state machine. */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/base/gstbytereader.h>
+#include <gst/base/gstadapter.h>
+
+#define DEFAULT_SIZE (32 * 1024 * 1024)
+#define DEFAULT_CHUNK_SIZE (4096)
+#define DEFAULT_NAL_SIZE (8192)
+#define ITERATIONS (10)
+
+static guint8 *
+make_bitstream (gsize size, gsize nal_size, guint * n_nals)
+{
+  guint8 *data = g_malloc (size);
+  gsize pos = 0;
+  guint zeroes = 0;
+
+  *n_nals = 0;
+  while (pos < size) {
+    gsize end = pos + g_random_int_range (nal_size / 4 + 1, nal_size * 2);
+
+    end = MIN (end, size);
+    if (pos + 4 <= end) {
+      data[pos++] = 0x00;
+      data[pos++] = 0x00;
+      data[pos++] = 0x01;
+      data[pos++] = 0x65;
+      zeroes = 0;
+      (*n_nals)++;
+    }
+    while (pos < end) {
+      guint8 b = g_random_int () & 0xff;
+
+      /* payload bytes are often zero in real streams, which is what makes
+       * the skipping scalar scan slow */
+      if (g_random_int_range (0, 4) == 0)
+        b = 0x00;
+      /* emulation prevention */
+      if (zeroes >= 2 && b <= 0x03) {
+        data[pos++] = 0x03;
+        zeroes = 0;
+        continue;
+      }
+      zeroes = (b == 0x00) ? zeroes + 1 : 0;
+      data[pos++] = b;
+    }
+  }
+  return data;
+}
+
+static void
+report (const gchar * what, guint found, gsize size, GstClockTime elapsed)
+{
+  g_print ("*** %-24s %8u start codes, %8.1f MB/s\n", what, found,
+      (gdouble) size * ITERATIONS / (1024 * 1024) /
+      ((gdouble) elapsed / GST_SECOND));
+}
+
+static guint
+scan_reader (const guint8 * data, gsize size, gboolean fast)
+{
+  GstByteReader reader;
+  guint offset = 0, found = 0;
+
+  gst_byte_reader_init (&reader, data, size);
+  while (offset + 4 <= size) {
+    guint pos;
+
+    if (fast) {
+      pos = gst_byte_reader_masked_scan_uint32 (&reader, 0xffffff00,
+          0x00000100, offset, size - offset);
+    } else {
+      pos = gst_byte_reader_masked_scan_uint32 (&reader, 0x00ffffff,
+          0x00000001, offset, size - offset);
+      if (pos != -1)
+        pos++;
+    }
+    if (pos == -1)
+      break;
+    found++;
+    offset = pos + 1;
+  }
+  return found;
+}
+
+static guint
+scan_adapter (GstAdapter * adapter, gboolean fast)
+{
+  gsize size = gst_adapter_available (adapter);
+  gsize offset = 0;
+  guint found = 0;
+
+  while (offset + 4 <= size) {
+    gssize pos;
+
+    if (fast) {
+      pos = gst_adapter_masked_scan_uint32 (adapter, 0xffffff00, 0x00000100,
+          offset, size - offset);
+    } else {
+      pos = gst_adapter_masked_scan_uint32 (adapter, 0x00ffffff, 0x00000001,
+          offset, size - offset);
+      if (pos != -1)
+        pos++;
+    }
+    if (pos == -1)
+      break;
+    found++;
+    offset = pos + 1;
+  }
+  return found;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstAdapter *adapter;
+  GstClockTime start;
+  guint8 *data;
+  gsize size = DEFAULT_SIZE, chunk_size = DEFAULT_CHUNK_SIZE;
+  gsize nal_size = DEFAULT_NAL_SIZE, pos;
+  guint n_nals, found = 0, i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    nal_size = atoi (argv[1]);
+  if (argc > 2)
+    chunk_size = atoi (argv[2]);
+
+  if (nal_size < 4 || chunk_size == 0) {
+    g_print ("usage: %s [<nal size> [<chunk size>]]\n", argv[0]);
+    exit (-1);
+  }
+
+  data = make_bitstream (size, nal_size, &n_nals);
+  g_print ("*** %u NAL units of around %" G_GSIZE_FORMAT " bytes, %"
+      G_GSIZE_FORMAT " byte chunks\n", n_nals, nal_size, chunk_size);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    found = scan_reader (data, size, FALSE);
+  report ("bytereader generic", found, size,
+      gst_util_get_timestamp () - start);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    found = scan_reader (data, size, TRUE);
+  report ("bytereader start code", found, size,
+      gst_util_get_timestamp () - start);
+
+  adapter = gst_adapter_new ();
+  for (pos = 0; pos < size; pos += chunk_size) {
+    gsize len = MIN (chunk_size, size - pos);
+
+    gst_adapter_push (adapter, gst_buffer_new_wrapped_full (0, data + pos,
+            len, 0, len, NULL, NULL));
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    found = scan_adapter (adapter, FALSE);
+  report ("adapter generic", found, size, gst_util_get_timestamp () - start);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++)
+    found = scan_adapter (adapter, TRUE);
+  report ("adapter start code", found, size,
+      gst_util_get_timestamp () - start);
+
+  g_object_unref (adapter);
+  g_free (data);
+
+  return 0;
+}
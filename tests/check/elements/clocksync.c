@@ -238,6 +238,59 @@ GST_START_TEST (test_sync_to_first)
 
 GST_END_TEST;
 
+static GstBuffer *
+buffer_new_with_pts (GstClockTime pts)
+{
+  GstBuffer *buf = gst_buffer_new ();
+
+  GST_BUFFER_PTS (buf) = pts;
+
+  return buf;
+}
+
+GST_START_TEST (test_tolerance)
+{
+  GstHarness *h = gst_harness_new_parse ("queue ! clocksync "
+      "tolerance=10000000");
+  GstElement *clocksync;
+  GstStructure *stats;
+  guint64 waits, skipped;
+
+  gst_harness_use_testclock (h);
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* the first buffer waits on the clock */
+  gst_harness_push (h, buffer_new_with_pts (100 * GST_MSECOND));
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, 42));
+  gst_harness_crank_single_clock_wait (h);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  /* within 10ms of the last wait, pushed without waiting */
+  gst_harness_push (h, buffer_new_with_pts (105 * GST_MSECOND));
+  gst_buffer_unref (gst_harness_pull (h));
+  gst_harness_push (h, buffer_new_with_pts (110 * GST_MSECOND));
+  gst_buffer_unref (gst_harness_pull (h));
+
+  /* outside of the window, waits again */
+  gst_harness_push (h, buffer_new_with_pts (111 * GST_MSECOND));
+  fail_unless (gst_harness_wait_for_clock_id_waits (h, 1, 42));
+  gst_harness_crank_single_clock_wait (h);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  clocksync = gst_harness_find_element (h, "clocksync");
+  g_object_get (clocksync, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "waits", &waits));
+  fail_unless (gst_structure_get_uint64 (stats, "skipped", &skipped));
+  fail_unless_equals_uint64 (waits, 2);
+  fail_unless_equals_uint64 (skipped, 2);
+  gst_structure_free (stats);
+  gst_object_unref (clocksync);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 clocksync_suite (void)
 {
@@ -250,6 +303,7 @@ clocksync_suite (void)
   tcase_add_test (tc_chain, test_stopping_element_unschedules_sync);
   tcase_add_test (tc_chain, test_no_sync_on_timestamp);
   tcase_add_test (tc_chain, test_sync_to_first);
+  tcase_add_test (tc_chain, test_tolerance);
 
 
   return s;
@@ -168,6 +168,77 @@ GST_START_TEST (test_concat_simple_time)
 
 GST_END_TEST;
 
+static void
+run_concat_prefetch (guint prefetch_buffers, gboolean threaded)
+{
+  GstElement *concat;
+  GstPad *sinks[3], *src, *output_sink;
+  GThread *threads[3];
+  gint i;
+
+  got_eos = FALSE;
+  buffer_count = 0;
+  gst_segment_init (&current_segment, GST_FORMAT_UNDEFINED);
+
+  concat = gst_element_factory_make ("concat", NULL);
+  fail_unless (concat != NULL);
+  g_object_set (concat, "prefetch-buffers", prefetch_buffers, NULL);
+
+  for (i = 0; i < 3; i++) {
+    sinks[i] = gst_element_request_pad_simple (concat, "sink_%u");
+    fail_unless (sinks[i] != NULL);
+  }
+
+  src = gst_element_get_static_pad (concat, "src");
+  output_sink = gst_pad_new ("sink", GST_PAD_SINK);
+  fail_unless (output_sink != NULL);
+  fail_unless (gst_pad_link (src, output_sink) == GST_PAD_LINK_OK);
+
+  gst_pad_set_chain_function (output_sink, output_chain_time);
+  gst_pad_set_event_function (output_sink, output_event_time);
+
+  gst_pad_set_active (output_sink, TRUE);
+  fail_unless (gst_element_set_state (concat,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  if (threaded) {
+    for (i = 0; i < 3; i++)
+      threads[i] = g_thread_new ("thread", (GThreadFunc) push_buffers_time,
+          sinks[i]);
+    for (i = 0; i < 3; i++)
+      g_thread_join (threads[i]);
+  } else {
+    /* the later streams are completely prefetched and only pushed
+     * downstream once the streams before them are done */
+    push_buffers_time (sinks[2]);
+    push_buffers_time (sinks[1]);
+    fail_unless_equals_int (buffer_count, 0);
+    push_buffers_time (sinks[0]);
+  }
+
+  fail_unless (got_eos);
+  fail_unless_equals_int (buffer_count, 3 * N_BUFFERS);
+
+  gst_element_set_state (concat, GST_STATE_NULL);
+  gst_pad_unlink (src, output_sink);
+  gst_object_unref (src);
+  for (i = 0; i < 3; i++) {
+    gst_element_release_request_pad (concat, sinks[i]);
+    gst_object_unref (sinks[i]);
+  }
+  gst_pad_set_active (output_sink, FALSE);
+  gst_object_unref (output_sink);
+  gst_object_unref (concat);
+}
+
+GST_START_TEST (test_concat_prefetch_time)
+{
+  run_concat_prefetch (N_BUFFERS, FALSE);
+  run_concat_prefetch (3, TRUE);
+}
+
+GST_END_TEST;
+
 static GstFlowReturn
 output_chain_bytes (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
@@ -300,6 +371,7 @@ concat_suite (void)
   tc_chain = tcase_create ("concat");
   tcase_add_test (tc_chain, test_concat_simple_time);
   tcase_add_test (tc_chain, test_concat_simple_bytes);
+  tcase_add_test (tc_chain, test_concat_prefetch_time);
   suite_add_tcase (s, tc_chain);
 
   return s;
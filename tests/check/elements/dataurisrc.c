@@ -476,6 +476,94 @@ GST_START_TEST (test_dataurisrc_push)
 
 GST_END_TEST;
 
+static void
+check_base64_ranges (const gchar * uri, const guint8 * expected, gsize size)
+{
+  GstElement *src;
+  GstPad *src_pad;
+  guint64 offset;
+  gsize length;
+
+  src = setup_dataurisrc ();
+  g_object_set (src, "uri", uri, NULL);
+  fail_unless_equals_int (gst_element_set_state (src, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  src_pad = gst_element_get_static_pad (src, "src");
+  fail_unless (gst_pad_activate_mode (src_pad, GST_PAD_MODE_PULL, TRUE));
+  fail_unless_equals_int (gst_element_set_state (src, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* every range decodes to the same bytes, whatever group it starts in */
+  for (offset = 0; offset < size; offset++) {
+    for (length = 1; offset + length <= size; length += 7) {
+      GstBuffer *buf = NULL;
+
+      fail_unless_equals_int (gst_pad_get_range (src_pad, offset, length,
+              &buf), GST_FLOW_OK);
+      fail_unless_equals_int (gst_buffer_get_size (buf), length);
+      fail_unless (gst_buffer_memcmp (buf, 0, expected + offset, length) == 0);
+      gst_buffer_unref (buf);
+    }
+  }
+
+  /* reads past the end are clipped */
+  {
+    GstBuffer *buf = NULL;
+
+    fail_unless_equals_int (gst_pad_get_range (src_pad, size - 2, 100, &buf),
+        GST_FLOW_OK);
+    fail_unless_equals_int (gst_buffer_get_size (buf), 2);
+    gst_buffer_unref (buf);
+    buf = NULL;
+    fail_unless_equals_int (gst_pad_get_range (src_pad, size, 100, &buf),
+        GST_FLOW_EOS);
+  }
+
+  gst_object_unref (src_pad);
+  fail_unless_equals_int (gst_element_set_state (src, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  cleanup_dataurisrc (src);
+}
+
+GST_START_TEST (test_dataurisrc_base64_ranges)
+{
+  guint8 bytes[100];
+  gchar *b64, *uri;
+  gsize i, len;
+
+  for (i = 0; i < G_N_ELEMENTS (bytes); i++)
+    bytes[i] = i * 37 + 11;
+
+  /* 100 bytes need padding, 99 bytes don't */
+  for (len = 99; len <= 100; len++) {
+    b64 = g_base64_encode (bytes, len);
+
+    /* padded, decoded on demand */
+    uri = g_strconcat ("data:;base64,", b64, NULL);
+    check_base64_ranges (uri, bytes, len);
+    g_free (uri);
+
+    /* without the padding */
+    if (len % 3 != 0) {
+      uri = g_strndup (b64, strcspn (b64, "="));
+      g_free (b64);
+      b64 = uri;
+      uri = g_strconcat ("data:;base64,", b64, NULL);
+      check_base64_ranges (uri, bytes, len);
+      g_free (uri);
+    }
+
+    /* line breaks make it fall back to decoding everything up front */
+    uri = g_strconcat ("data:;base64,", b64, "\n", NULL);
+    check_base64_ranges (uri, bytes, len);
+    g_free (uri);
+
+    g_free (b64);
+  }
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_dataurisrc_uri_iface)
 {
   const gchar *const *protocols;
@@ -580,6 +668,7 @@ dataurisrc_suite (void)
 
   tcase_add_test (tc_chain, test_dataurisrc_pull);
   tcase_add_test (tc_chain, test_dataurisrc_push);
+  tcase_add_test (tc_chain, test_dataurisrc_base64_ranges);
   tcase_add_test (tc_chain, test_dataurisrc_uri_iface);
   tcase_add_test (tc_chain, test_dataurisrc_from_uri);
   tcase_add_test (tc_chain, test_dataurisrc_uris);
@@ -1176,6 +1176,53 @@ GST_START_TEST (test_last_message_deep_notify)
 
 GST_END_TEST;
 
+GST_START_TEST (test_counting)
+{
+  GstElement *pipe, *src, *sink;
+  GstStructure *counters;
+  GstMessage *m;
+  guint64 buffers, bytes;
+
+  pipe = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("fakesrc", NULL);
+  gst_util_set_object_arg (G_OBJECT (src), "data", "pool");
+  gst_util_set_object_arg (G_OBJECT (src), "sizetype", "fixed");
+  /* 100 bytes per buffer at 1 MB/s: timestamps every 100 microseconds */
+  g_object_set (src, "num-buffers", 10, "sizemax", 100, "list-size", 8,
+      "format", GST_FORMAT_TIME, "datarate", 1000000, NULL);
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "counting", TRUE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipe), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  fail_unless_equals_int (gst_element_set_state (pipe, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  m = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipe), -1,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (m), GST_MESSAGE_EOS);
+  gst_message_unref (m);
+
+  g_object_get (sink, "counters", &counters, NULL);
+  fail_unless (gst_structure_get_uint64 (counters, "buffers", &buffers));
+  fail_unless (gst_structure_get_uint64 (counters, "bytes", &bytes));
+  fail_unless_equals_uint64 (buffers, 80);
+  fail_unless_equals_uint64 (bytes, 8000);
+  fail_unless (gst_structure_has_field_typed (counters, "average-latency",
+          G_TYPE_UINT64));
+  fail_unless (gst_structure_has_field_typed (counters, "rate",
+          G_TYPE_DOUBLE));
+  gst_structure_free (counters);
+
+  fail_unless_equals_int (gst_element_set_state (pipe, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipe);
+}
+
+GST_END_TEST;
+
 static Suite *
 fakesink_suite (void)
 {
@@ -1192,6 +1239,7 @@ fakesink_suite (void)
   tcase_add_test (tc_chain, test_position);
   tcase_add_test (tc_chain, test_notify_race);
   tcase_add_test (tc_chain, test_last_message_notify);
+  tcase_add_test (tc_chain, test_counting);
   tcase_skip_broken_test (tc_chain, test_last_message_deep_notify);
 
   return s;
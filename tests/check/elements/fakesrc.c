@@ -167,6 +167,50 @@ GST_START_TEST (test_sizetype_fixed)
 
 GST_END_TEST;
 
+GST_START_TEST (test_data_pool)
+{
+  GstElement *src;
+  GList *l;
+
+  src = setup_fakesrc ();
+
+  gst_util_set_object_arg (G_OBJECT (src), "data", "pool");
+  gst_util_set_object_arg (G_OBJECT (src), "sizetype", "fixed");
+  gst_util_set_object_arg (G_OBJECT (src), "filltype", "pattern");
+  g_object_set (G_OBJECT (src), "sizemax", 300, "list-size", 3,
+      "num-buffers", 10, NULL);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  while (!have_eos) {
+    g_usleep (1000);
+  }
+
+  /* every list counts as one buffer for num-buffers */
+  fail_unless_equals_int (g_list_length (buffers), 30);
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+    GstMapInfo info;
+
+    fail_unless_equals_int (gst_buffer_get_size (buf), 300);
+    fail_unless (gst_buffer_map (buf, &info, GST_MAP_READ));
+    fail_unless_equals_int (info.data[0], 0);
+    fail_unless_equals_int (info.data[299], 299 & 0xff);
+    gst_buffer_unmap (buf, &info);
+  }
+  gst_check_drop_buffers ();
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* cleanup */
+  cleanup_fakesrc (src);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_sizetype_random)
 {
   GstElement *src;
@@ -327,6 +371,7 @@ fakesrc_suite (void)
   tcase_add_test (tc_chain, test_sizetype_empty);
   tcase_add_test (tc_chain, test_sizetype_fixed);
   tcase_add_test (tc_chain, test_sizetype_random);
+  tcase_add_test (tc_chain, test_data_pool);
   tcase_add_test (tc_chain, test_no_preroll);
   tcase_add_test (tc_chain, test_reuse_push);
 
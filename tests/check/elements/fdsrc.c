@@ -30,8 +30,12 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SYS_SOCKET_H
+#include <sys/socket.h>
+#endif
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
 
 static gboolean have_eos = FALSE;
 
@@ -202,6 +206,151 @@ GST_START_TEST (test_seeking)
 
 GST_END_TEST;
 
+static guint num_lists = 0;
+
+static GstFlowReturn
+chain_list_func (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i;
+
+  num_lists++;
+  for (i = 0; i < gst_buffer_list_length (list); i++)
+    buffers = g_list_append (buffers,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_drain)
+{
+  GstElement *src;
+  gint pipe_fd[2];
+  gchar data[10000];
+
+#ifndef G_OS_WIN32
+  fail_if (pipe (pipe_fd) < 0);
+#else
+  fail_if (_pipe (pipe_fd, 16384, _O_BINARY) < 0);
+#endif
+
+  /* everything is readable right away, so the reads of one wakeup are
+   * pushed together */
+  memset (data, 0, sizeof (data));
+  fail_unless_equals_int (write (pipe_fd[1], data, sizeof (data)),
+      sizeof (data));
+  close (pipe_fd[1]);
+
+  src = setup_fdsrc ();
+  gst_pad_set_chain_list_function (mysinkpad, chain_list_func);
+  g_object_set (G_OBJECT (src), "fd", pipe_fd[0], "blocksize", 1000,
+      "max-drain-buffers", 4, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  while (!have_eos)
+    g_usleep (1000);
+
+  fail_unless_equals_int (g_list_length (buffers), 10);
+#ifndef G_OS_WIN32
+  fail_unless_equals_int (num_lists, 3);
+#endif
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* cleanup */
+  cleanup_fdsrc (src);
+  close (pipe_fd[0]);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+}
+
+GST_END_TEST;
+
+#ifdef HAVE_SYS_SOCKET_H
+GST_START_TEST (test_pass_fds)
+{
+  GstElement *src;
+  GstAllocator *shm;
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMemory *mem;
+  GstMapInfo info;
+  gint sv[2];
+
+  shm = gst_allocator_find (GST_ALLOCATOR_SHM);
+  if (shm == NULL)
+    return;
+
+  fail_if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv) < 0);
+
+  h = gst_harness_new ("fdsink");
+  g_object_set (h->element, "fd", sv[0], "pass-fds", TRUE, NULL);
+  gst_harness_set_src_caps_str (h, "application/x-test");
+
+  /* one buffer of shared memory and one of system memory that is copied */
+  buf = gst_buffer_new_allocate (shm, 100, NULL);
+  gst_buffer_memset (buf, 0, 0x11, 100);
+  GST_BUFFER_PTS (buf) = GST_SECOND;
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  buf = gst_buffer_new_allocate (NULL, 50, NULL);
+  gst_buffer_memset (buf, 0, 0x22, 50);
+  gst_buffer_append_memory (buf, gst_allocator_alloc (shm, 10, NULL));
+  GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+
+  gst_harness_teardown (h);
+  close (sv[0]);
+
+  src = setup_fdsrc ();
+  g_object_set (G_OBJECT (src), "fd", sv[1], "pass-fds", TRUE, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  while (!have_eos)
+    g_usleep (1000);
+
+  fail_unless_equals_int (g_list_length (buffers), 2);
+
+  buf = buffers->data;
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 1);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 100);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), GST_SECOND);
+  mem = gst_buffer_peek_memory (buf, 0);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_SHM));
+  fail_unless (GST_MEMORY_IS_READONLY (mem));
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_READ));
+  fail_unless (info.data[99] == 0x11);
+  gst_memory_unmap (mem, &info);
+
+  buf = buffers->next->data;
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 2);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 60);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT));
+  fail_unless (gst_buffer_map (buf, &info, GST_MAP_READ));
+  fail_unless (info.data[49] == 0x22);
+  gst_buffer_unmap (buf, &info);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* cleanup */
+  cleanup_fdsrc (src);
+  close (sv[1]);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  gst_object_unref (shm);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 fdsrc_suite (void)
 {
@@ -212,6 +361,10 @@ fdsrc_suite (void)
   tcase_add_test (tc_chain, test_num_buffers);
   tcase_add_test (tc_chain, test_nonseeking);
   tcase_add_test (tc_chain, test_seeking);
+  tcase_add_test (tc_chain, test_drain);
+#ifdef HAVE_SYS_SOCKET_H
+  tcase_add_test (tc_chain, test_pass_fds);
+#endif
 
   return s;
 }
@@ -381,6 +381,156 @@ GST_START_TEST (test_flush)
 
 GST_END_TEST;
 
+GST_START_TEST (test_async_write)
+{
+  GstElement *filesink;
+  gchar *tmp_fn;
+  GstSegment segment;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  sync_buffers = FALSE;
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  /* only allow a few buffers in flight so that we block in render */
+  g_object_set (filesink, "location", tmp_fn, "async-write", TRUE,
+      "max-inflight-bytes", (guint64) 100, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 0);
+
+  PUSH_BYTES (0);
+  PUSH_BYTES (1);
+  PUSH_BYTES (99);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 100);
+
+  PUSH_BYTES (8800);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8900);
+
+  PUSH_BUFFER_LIST (2, 50);
+  PUSH_BUFFER_LIST (3, 10);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 9030);
+
+  /* a seek has to wait for all pending writes */
+  segment.start = 8900;
+  if (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment))) {
+    CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8900);
+    CHECK_WRITTEN_BYTES (100, 8800, 9030);
+    CHECK_WRITTEN_BYTES (9020, 10, 9030);
+    PUSH_BYTES (200);
+    CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 9100);
+  } else {
+    GST_INFO ("seeking not supported for tempfile?!");
+  }
+
+  /* EOS waits for the data to be written */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  CHECK_WRITTEN_BYTES (8900, 200, 9100);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  CHECK_WRITTEN_BYTES (8900, 200, 9100);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_direct_io)
+{
+  GstElement *filesink;
+  gchar *tmp_fn;
+  GstSegment segment;
+  GstQuery *query;
+  GstCaps *caps;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  sync_buffers = FALSE;
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  g_object_set (filesink, "location", tmp_fn, "direct-io", TRUE,
+      "buffer-size", 8192, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  caps = gst_caps_new_empty_simple ("application/octet-stream");
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_caps (caps)));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* if the file system supports direct I/O an aligned pool is proposed */
+  query = gst_query_new_allocation (caps, TRUE);
+  gst_caps_unref (caps);
+  if (gst_pad_peer_query (mysrcpad, query)) {
+    GstAllocationParams params;
+    GstBufferPool *pool;
+    guint size;
+
+    fail_unless (gst_query_get_n_allocation_params (query) > 0);
+    gst_query_parse_nth_allocation_param (query, 0, NULL, &params);
+    fail_unless (params.align >= 4095);
+    fail_unless (gst_query_get_n_allocation_pools (query) > 0);
+    gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, NULL, NULL);
+    fail_unless (pool != NULL);
+    fail_unless_equals_int (size % (params.align + 1), 0);
+    gst_object_unref (pool);
+  } else {
+    GST_INFO ("direct I/O not supported for tempfile");
+  }
+  gst_query_unref (query);
+
+  /* unaligned data goes through the staging buffer */
+  PUSH_BYTES (1);
+  PUSH_BYTES (99);
+  PUSH_BYTES (8800);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8900);
+  PUSH_BUFFER_LIST (3, 10);
+  PUSH_BYTES (20000);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 28930);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  CHECK_WRITTEN_BYTES (0, 1, 28930);
+  CHECK_WRITTEN_BYTES (1, 99, 28930);
+  CHECK_WRITTEN_BYTES (100, 8800, 28930);
+  CHECK_WRITTEN_BYTES (8920, 10, 28930);
+  CHECK_WRITTEN_BYTES (8930, 20000, 28930);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *filesink;
@@ -496,6 +646,8 @@ filesink_suite (void)
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_async_write);
+  tcase_add_test (tc_chain, test_direct_io);
 
   return s;
 }
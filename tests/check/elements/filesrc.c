@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 
+#include <glib/gstdio.h>
 #include <gst/check/gstcheck.h>
 
 static gboolean have_eos = FALSE;
@@ -303,6 +304,194 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pull_mmap)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gchar *contents;
+  gsize size;
+  gint read_mode;
+
+  fail_unless (g_file_get_contents (TESTFILE, &contents, &size, NULL));
+  fail_unless (size > 200);
+
+  src = setup_filesrc ();
+
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "read-mode", 1,
+      "readahead", (guint64) 64 * 1024, NULL);
+  g_object_get (G_OBJECT (src), "read-mode", &read_mode, NULL);
+  fail_unless_equals_int (read_mode, 1);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, 100, 100, &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 100);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buffer), 100);
+
+  /* the data points into the file mapping and can't be written */
+  fail_unless (!gst_memory_is_writable (gst_buffer_peek_memory (buffer, 0)));
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  fail_unless (memcmp (info.data, contents + 100, 100) == 0);
+  gst_buffer_unmap (buffer, &info);
+
+  /* a writable map gives us a copy */
+  buffer = gst_buffer_make_writable (buffer);
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_WRITE));
+  fail_unless (memcmp (info.data, contents + 100, 100) == 0);
+  info.data[0] = ~contents[100];
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, 100, 10, &buffer) == GST_FLOW_OK);
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents + 100, 10) == 0);
+  gst_buffer_unref (buffer);
+
+  /* reads are clipped at the end of the file */
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, size - 10, 20, &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 10);
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents + size - 10, 10) == 0);
+  gst_buffer_unref (buffer);
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, size, 10, &buffer) == GST_FLOW_EOS);
+
+  /* buffers keep the file mapped after stopping */
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, 0, 10, &buffer) == GST_FLOW_OK);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents, 10) == 0);
+  gst_buffer_unref (buffer);
+
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
+/* buffers that point into the file mapping can be sent by fdsink without
+ * going through user space, the result must be the same */
+GST_START_TEST (test_mmap_to_fdsink)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *contents, *out_contents, *out_fn, *desc;
+  gsize size, out_size;
+  gint fd;
+
+  fail_unless (g_file_get_contents (TESTFILE, &contents, &size, NULL));
+
+  fd = g_file_open_tmp ("gstreamer-filesrc-test-XXXXXX", &out_fn, NULL);
+  fail_unless (fd >= 0);
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" read-mode=mmap "
+      "blocksize=1000 ! identity ! fdsink fd=%d", TESTFILE, fd);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+  g_close (fd, NULL);
+
+  fail_unless (g_file_get_contents (out_fn, &out_contents, &out_size, NULL));
+  fail_unless_equals_int (out_size, size);
+  fail_unless (memcmp (out_contents, contents, size) == 0);
+
+  g_remove (out_fn);
+  g_free (out_fn);
+  g_free (out_contents);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
+/* file memory is only mapped when the data is accessed and can also be sent
+ * by fdsink without mapping it */
+GST_START_TEST (test_file_memory)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstBuffer *buffer;
+  GstMemory *mem;
+  gchar *contents;
+  guint64 offset;
+  gsize size;
+
+  fail_unless (g_file_get_contents (TESTFILE, &contents, &size, NULL));
+  fail_unless (size > 200);
+
+  src = setup_filesrc ();
+
+  gst_util_set_object_arg (G_OBJECT (src), "read-mode", "file-memory");
+  g_object_set (G_OBJECT (src), "location", TESTFILE, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, 100, 100, &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 100);
+
+  mem = gst_buffer_peek_memory (buffer, 0);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_FILE));
+  fail_unless (gst_file_memory_get_fd (mem, &offset) >= 0);
+  fail_unless_equals_uint64 (offset, 100);
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents + 100, 100) == 0);
+
+  /* reads are clipped at the end of the file */
+  gst_buffer_unref (buffer);
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (pad, size - 10, 20, &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 10);
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents + size - 10, 10) == 0);
+
+  /* and the data stays available after stopping */
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+  fail_unless (gst_buffer_memcmp (buffer, 0, contents + size - 10, 10) == 0);
+  gst_buffer_unref (buffer);
+
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *src;
@@ -554,6 +743,11 @@ filesrc_suite (void)
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_reverse);
   tcase_add_test (tc_chain, test_pull);
+#ifdef HAVE_SYS_MMAN_H
+  tcase_add_test (tc_chain, test_pull_mmap);
+  tcase_add_test (tc_chain, test_mmap_to_fdsink);
+  tcase_add_test (tc_chain, test_file_memory);
+#endif
   tcase_add_test (tc_chain, test_coverage);
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_uri_query);
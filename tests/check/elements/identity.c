@@ -102,6 +102,151 @@ GST_START_TEST (test_signal_handoffs)
 
 GST_END_TEST;
 
+static void
+count_handoff_func (GstElement * identity, GstBuffer * buf, guint * count)
+{
+  (*count)++;
+}
+
+GST_START_TEST (test_buffer_list)
+{
+  GstHarness *h = gst_harness_new ("identity");
+  GstBufferList *list;
+  GstStructure *stats;
+  guint64 num_buffers, num_bytes;
+  guint count = 0;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++)
+    gst_buffer_list_add (list, gst_buffer_new_and_alloc (4));
+
+  /* without handoff handlers the list is forwarded as a whole */
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+  fail_unless_equals_int (3, gst_harness_buffers_received (h));
+
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "num-buffers", &num_buffers));
+  fail_unless (gst_structure_get_uint64 (stats, "num-bytes", &num_bytes));
+  fail_unless_equals_uint64 (num_buffers, 3);
+  fail_unless_equals_uint64 (num_bytes, 12);
+  gst_structure_free (stats);
+
+  /* with a handoff handler every buffer is signalled */
+  g_signal_connect (h->element, "handoff",
+      G_CALLBACK (count_handoff_func), &count);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++)
+    gst_buffer_list_add (list, gst_buffer_new_and_alloc (4));
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+  fail_unless_equals_int (6, gst_harness_buffers_received (h));
+  fail_unless_equals_int (count, 3);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_checksum)
+{
+  GstHarness *h = gst_harness_new ("identity");
+  GstBufferList *list;
+  GstBuffer *buf;
+  GstStructure *stats;
+  guint checksum;
+
+  gst_util_set_object_arg (G_OBJECT (h->element), "checksum", "crc32c");
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* the checksum continues over memories, buffers and lists */
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (gpointer) "12", 2, 0,
+          2, NULL, NULL));
+  gst_buffer_append_memory (buf,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, (gpointer) "3", 1, 0,
+          1, NULL, NULL));
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h, buf));
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, gst_buffer_new_wrapped (g_strdup ("456"), 3));
+  gst_buffer_list_add (list, gst_buffer_new_wrapped (g_strdup ("789"), 3));
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+  fail_unless_equals_int (3, gst_harness_buffers_received (h));
+
+  /* the check value of CRC-32C */
+  g_object_get (h->element, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "checksum", &checksum));
+  fail_unless_equals_int_hex (checksum, 0xe3069283);
+  gst_structure_free (stats);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstBuffer *
+create_timed_buffer (GstClockTime ts)
+{
+  GstBuffer *buf = gst_buffer_new_and_alloc (4);
+
+  GST_BUFFER_PTS (buf) = ts;
+  GST_BUFFER_DURATION (buf) = GST_SECOND;
+
+  return buf;
+}
+
+GST_START_TEST (test_buffer_list_position_discont)
+{
+  GstHarness *h = gst_harness_new ("identity");
+  GstBufferList *list;
+  GstBuffer *buf;
+  GstPad *srcpad;
+  gint64 pos;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  srcpad = gst_element_get_static_pad (h->element, "src");
+
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h,
+          create_timed_buffer (0)));
+  fail_unless (gst_pad_query_position (srcpad, GST_FORMAT_TIME, &pos));
+  fail_unless_equals_int64 (pos, GST_SECOND);
+
+  /* a dropped buffer leaves a DISCONT pending */
+  g_object_set (h->element, "drop-probability", 1.0, NULL);
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h,
+          create_timed_buffer (GST_SECOND)));
+  g_object_set (h->element, "drop-probability", 0.0, NULL);
+
+  list = gst_buffer_list_new ();
+  for (i = 2; i < 5; i++)
+    gst_buffer_list_add (list, create_timed_buffer (i * GST_SECOND));
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad, list));
+
+  /* the DISCONT is set on the first buffer of the list only */
+  buf = gst_harness_pull (h);
+  gst_buffer_unref (buf);
+  for (i = 2; i < 5; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), i * GST_SECOND);
+    fail_unless_equals_int (GST_BUFFER_IS_DISCONT (buf), i == 2);
+    gst_buffer_unref (buf);
+  }
+
+  /* the position of the source pad follows the list */
+  fail_unless (gst_pad_query_position (srcpad, GST_FORMAT_TIME, &pos));
+  fail_unless_equals_int64 (pos, 5 * GST_SECOND);
+
+  gst_object_unref (srcpad);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_sync_on_timestamp)
 {
   /* the reason to use the queue in front of the identity element
@@ -192,6 +337,9 @@ identity_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_one_buffer);
   tcase_add_test (tc_chain, test_signal_handoffs);
+  tcase_add_test (tc_chain, test_buffer_list);
+  tcase_add_test (tc_chain, test_buffer_list_position_discont);
+  tcase_add_test (tc_chain, test_checksum);
   tcase_add_test (tc_chain, test_sync_on_timestamp);
   tcase_add_test (tc_chain, test_stopping_element_unschedules_sync);
 
@@ -493,6 +493,82 @@ GST_START_TEST (test_activity_get_checkpoint)
 
 GST_END_TEST;
 
+typedef GstElement GstLeaksTestElement;
+typedef GstElementClass GstLeaksTestElementClass;
+
+static GType gst_leaks_test_element_get_type (void);
+G_DEFINE_TYPE (GstLeaksTestElement, gst_leaks_test_element, GST_TYPE_ELEMENT);
+
+static GstStaticPadTemplate leaks_test_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-leaks-test"));
+
+static void
+gst_leaks_test_element_class_init (GstLeaksTestElementClass * klass)
+{
+  gst_element_class_add_static_pad_template (klass, &leaks_test_sink_template);
+  gst_element_class_set_static_metadata (klass, "Leaks test", "Test",
+      "Element with a pad template", "GStreamer");
+}
+
+static void
+gst_leaks_test_element_init (GstLeaksTestElement * element)
+{
+}
+
+/* The caps of the pad templates of element factories are freed with the
+ * factory */
+GST_START_TEST (test_factory_template_caps_cleanup)
+{
+  GstTracer *tracer = get_tracer_by_name ("plain");
+  GstPluginFeature *factory;
+  GstStaticPadTemplate *templ;
+  GstStructure *cpoint;
+  const GValue *removed;
+  GstCaps *caps;
+  gchar *address;
+  gboolean found = FALSE;
+  guint i;
+
+  fail_unless (tracer);
+  fail_unless (gst_element_register (NULL, "leakstestelement",
+          GST_RANK_NONE, gst_leaks_test_element_get_type ()));
+  factory = gst_registry_find_feature (gst_registry_get (),
+      "leakstestelement", GST_TYPE_ELEMENT_FACTORY);
+  fail_unless (factory);
+
+  g_signal_emit_by_name (tracer, "activity-start-tracking");
+
+  templ = gst_element_factory_get_static_pad_templates (GST_ELEMENT_FACTORY
+      (factory))->data;
+  caps = gst_static_pad_template_get_caps (templ);
+  fail_if (GST_MINI_OBJECT_FLAG_IS_SET (caps, GST_MINI_OBJECT_FLAG_IMMORTAL));
+  address = g_strdup_printf ("%p", caps);
+  gst_caps_unref (caps);
+
+  gst_registry_remove_feature (gst_registry_get (), factory);
+  gst_object_unref (factory);
+
+  g_signal_emit_by_name (tracer, "activity-get-checkpoint", &cpoint);
+  removed = gst_structure_get_value (cpoint, "objects-removed-list");
+  fail_unless (G_VALUE_HOLDS (removed, GST_TYPE_LIST));
+  for (i = 0; i < gst_value_list_get_size (removed); i++) {
+    const GstStructure *rs =
+        gst_value_get_structure (gst_value_list_get_value (removed, i));
+
+    if (g_strcmp0 (gst_structure_get_string (rs, "address"), address) == 0)
+      found = TRUE;
+  }
+  fail_unless (found);
+  gst_structure_free (cpoint);
+  g_free (address);
+
+  g_signal_emit_by_name (tracer, "activity-stop-tracking");
+  gst_object_unref (tracer);
+}
+
+GST_END_TEST;
+
 static Suite *
 leakstracer_suite (void)
 {
@@ -509,6 +585,7 @@ leakstracer_suite (void)
   tcase_add_test (tc_chain_2, test_activity_start_stop);
   tcase_add_test (tc_chain_2, test_activity_log_checkpoint);
   tcase_add_test (tc_chain_2, test_activity_get_checkpoint);
+  tcase_add_test (tc_chain_2, test_factory_template_caps_cleanup);
 
   return s;
 }
@@ -1661,6 +1661,138 @@ GST_START_TEST (test_stream_status_messages)
 
 GST_END_TEST;
 
+static GMutex worker_mutex;
+static GCond worker_cond;
+static gboolean worker_gate_open;
+static GArray *worker_output;
+static GThread *worker_thread;
+static gboolean worker_thread_changed;
+
+static GstFlowReturn
+worker_chain_func (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+
+  g_mutex_lock (&worker_mutex);
+  /* block the worker on the first buffer until all data is queued */
+  while (!worker_gate_open)
+    g_cond_wait (&worker_cond, &worker_mutex);
+
+  if (worker_thread == NULL)
+    worker_thread = g_thread_self ();
+  else if (worker_thread != g_thread_self ())
+    worker_thread_changed = TRUE;
+
+  g_array_append_val (worker_output, pts);
+  g_cond_broadcast (&worker_cond);
+  g_mutex_unlock (&worker_mutex);
+
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+worker_event_func (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gst_event_unref (event);
+  return TRUE;
+}
+
+GST_START_TEST (test_worker_threads)
+{
+  GstElement *pipe, *mq;
+  GstPad *inputpads[2], *sinkpads[2];
+  GstSegment segment;
+  GstClockTime last;
+  guint i, j;
+
+  worker_gate_open = FALSE;
+  worker_output = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  worker_thread = NULL;
+  worker_thread_changed = FALSE;
+
+  pipe = gst_pipeline_new ("testbin");
+  mq = gst_element_factory_make ("multiqueue", NULL);
+  fail_unless (mq != NULL);
+  g_object_set (mq, "worker-threads", 1, "max-size-bytes", 0,
+      "max-size-buffers", 0, "max-size-time", (guint64) 0, NULL);
+  gst_bin_add (GST_BIN (pipe), mq);
+
+  for (i = 0; i < 2; i++) {
+    GstPad *mq_sinkpad, *mq_srcpad;
+
+    inputpads[i] = gst_pad_new ("dummysrc", GST_PAD_SRC);
+    mq_sinkpad = gst_element_request_pad_simple (mq, "sink_%u");
+    fail_unless (mq_sinkpad != NULL);
+    fail_unless (gst_pad_link (inputpads[i], mq_sinkpad) == GST_PAD_LINK_OK);
+    gst_pad_set_active (inputpads[i], TRUE);
+
+    mq_srcpad = mq_sinkpad_to_srcpad (mq, mq_sinkpad);
+    sinkpads[i] = gst_pad_new ("dummysink", GST_PAD_SINK);
+    gst_pad_set_chain_function (sinkpads[i], worker_chain_func);
+    gst_pad_set_event_function (sinkpads[i], worker_event_func);
+    fail_unless (gst_pad_link (mq_srcpad, sinkpads[i]) == GST_PAD_LINK_OK);
+    gst_pad_set_active (sinkpads[i], TRUE);
+
+    gst_object_unref (mq_sinkpad);
+    gst_object_unref (mq_srcpad);
+  }
+
+  gst_element_set_state (pipe, GST_STATE_PLAYING);
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  for (i = 0; i < 2; i++) {
+    gchar *stream_id = g_strdup_printf ("test%u", i);
+
+    gst_pad_push_event (inputpads[i], gst_event_new_stream_start (stream_id));
+    gst_pad_push_event (inputpads[i],
+        gst_event_new_caps (gst_caps_new_empty_simple ("foo/x-bar")));
+    gst_pad_push_event (inputpads[i], gst_event_new_segment (&segment));
+    g_free (stream_id);
+  }
+
+  /* queue all data of the first stream before the second one, the worker
+   * must still output it in running time order */
+  for (i = 0; i < 2; i++) {
+    for (j = 0; j < 5; j++) {
+      GstBuffer *buf = gst_buffer_new ();
+
+      GST_BUFFER_PTS (buf) = j * GST_SECOND;
+      GST_BUFFER_DURATION (buf) = GST_SECOND;
+      fail_unless_equals_int (gst_pad_push (inputpads[i], buf), GST_FLOW_OK);
+    }
+  }
+
+  g_mutex_lock (&worker_mutex);
+  worker_gate_open = TRUE;
+  g_cond_broadcast (&worker_cond);
+  while (worker_output->len < 10)
+    g_cond_wait (&worker_cond, &worker_mutex);
+  g_mutex_unlock (&worker_mutex);
+
+  fail_if (worker_thread_changed);
+  last = 0;
+  for (i = 0; i < worker_output->len; i++) {
+    GstClockTime pts = g_array_index (worker_output, GstClockTime, i);
+
+    fail_unless (pts >= last, "buffer %u with pts %" GST_TIME_FORMAT
+        " was pushed after %" GST_TIME_FORMAT, i, GST_TIME_ARGS (pts),
+        GST_TIME_ARGS (last));
+    last = pts;
+  }
+
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  for (i = 0; i < 2; i++) {
+    gst_object_unref (inputpads[i]);
+    gst_object_unref (sinkpads[i]);
+  }
+  gst_object_unref (pipe);
+  g_array_free (worker_output, TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 multiqueue_suite (void)
 {
@@ -1692,6 +1824,7 @@ multiqueue_suite (void)
   tcase_add_test (tc_chain, test_initial_events_nodelay);
 
   tcase_add_test (tc_chain, test_stream_status_messages);
+  tcase_add_test (tc_chain, test_worker_threads);
 
   return s;
 }
@@ -24,6 +24,7 @@
 #endif
 
 #include <gst/check/gstcheck.h>
+#include <gst/base/gstqueuebudget.h>
 
 #define UNDERRUN_LOCK() (g_mutex_lock (&underrun_mutex))
 #define UNDERRUN_UNLOCK() (g_mutex_unlock (&underrun_mutex))
@@ -496,6 +497,90 @@ GST_START_TEST (test_leaky_downstream)
 
 GST_END_TEST;
 
+static GstBuffer *
+timed_buffer_new (guint i)
+{
+  GstBuffer *buffer = gst_buffer_new_and_alloc (4);
+
+  GST_BUFFER_PTS (buffer) = i * 10 * GST_MSECOND;
+  GST_BUFFER_DURATION (buffer) = 10 * GST_MSECOND;
+
+  return buffer;
+}
+
+/* fill the queue with 100ms of data, lower the time limit and check that
+ * all the data that got too old is leaked at once, keeping the sticky
+ * events */
+GST_START_TEST (test_leaky_downstream_time)
+{
+  GstEvent *tag, *sticky;
+  GstBuffer *buffer;
+  GstSegment segment;
+  guint64 level;
+  guint i;
+
+  g_object_set (G_OBJECT (queue), "max-size-buffers", 0, "max-size-bytes", 0,
+      "max-size-time", 100 * GST_MSECOND, "leaky", 2, NULL);
+
+  block_src ();
+
+  UNDERRUN_LOCK ();
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  tag = gst_event_new_tag (gst_tag_list_new (GST_TAG_TITLE, "leaked", NULL));
+  for (i = 0; i < 10; i++) {
+    gst_pad_push (mysrcpad, timed_buffer_new (i));
+    if (i == 3)
+      gst_pad_push_event (mysrcpad, gst_event_ref (tag));
+  }
+  g_object_get (queue, "current-level-time", &level,
+      "current-level-buffers", &i, NULL);
+  fail_unless_equals_uint64 (level, 100 * GST_MSECOND);
+  fail_unless_equals_int (i, 10);
+
+  /* buffers 0 to 7 are older than 30ms and leaked with the next buffer */
+  g_object_set (G_OBJECT (queue), "max-size-time", 30 * GST_MSECOND, NULL);
+  gst_pad_push (mysrcpad, timed_buffer_new (10));
+
+  g_object_get (queue, "current-level-time", &level,
+      "current-level-buffers", &i, NULL);
+  fail_unless_equals_uint64 (level, 30 * GST_MSECOND);
+  fail_unless_equals_int (i, 3);
+
+  sticky = gst_pad_get_sticky_event (qsrcpad, GST_EVENT_TAG, 0);
+  fail_unless (sticky == tag);
+  gst_event_unref (sticky);
+  gst_event_unref (tag);
+
+  UNDERRUN_LOCK ();
+  mysinkpad = setup_sink_pad (queue, &sinktemplate);
+  unblock_src ();
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  for (i = 0; i < 3; i++) {
+    buffer = g_list_nth_data (buffers, i);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer),
+        (8 + i) * 10 * GST_MSECOND);
+    fail_unless_equals_int (!!GST_BUFFER_FLAG_IS_SET (buffer,
+            GST_BUFFER_FLAG_DISCONT), i == 0);
+  }
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
 /* set queue size to 6 buffers and 7 seconds
  * push 7 buffers with and without duration
  * check current-level-time
@@ -1181,6 +1266,247 @@ GST_START_TEST (test_initial_events_nodelay)
 
 GST_END_TEST;
 
+/* data must flow in order and nothing may get stuck when the threads
+ * busy-wait on each other before going to sleep */
+GST_START_TEST (test_spin_wait)
+{
+  GstSegment segment;
+  guint64 spin_time;
+  guint i;
+
+  g_object_set (G_OBJECT (queue), "max-size-buffers", 1,
+      "spin-time", (guint64) 50 * GST_USECOND, NULL);
+  g_object_get (G_OBJECT (queue), "spin-time", &spin_time, NULL);
+  if (g_get_num_processors () > 1)
+    fail_unless_equals_uint64 (spin_time, 50 * GST_USECOND);
+  else
+    fail_unless_equals_uint64 (spin_time, 0);
+
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < 1000; i++) {
+    GstBuffer *buffer = gst_buffer_new ();
+
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+    /* sometimes make the consumer go to sleep */
+    if (i % 100 == 0)
+      g_usleep (1000);
+  }
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 1000)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  for (i = 0; i < 1000; i++)
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (g_list_nth_data (buffers,
+                i)), i);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+static GList *list_sizes;
+
+static GstFlowReturn
+batch_chain_list_func (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  list_sizes = g_list_append (list_sizes,
+      GUINT_TO_POINTER (gst_buffer_list_length (list)));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_batch_push)
+{
+  GstSegment segment;
+  guint i;
+
+  g_object_set (G_OBJECT (queue), "max-batch-buffers", 4, NULL);
+
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_chain_list_function (mysinkpad, batch_chain_list_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  block_src ();
+
+  UNDERRUN_LOCK ();
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  /* 10 buffers, then an event that must not be batched across, then 3 more */
+  for (i = 0; i < 10; i++)
+    fail_unless_equals_int (gst_pad_push (mysrcpad,
+            gst_buffer_new_and_alloc (4)), GST_FLOW_OK);
+  gst_pad_push_event (mysrcpad,
+      gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
+          gst_structure_new_empty ("test")));
+  for (i = 0; i < 3; i++)
+    fail_unless_equals_int (gst_pad_push (mysrcpad,
+            gst_buffer_new_and_alloc (4)), GST_FLOW_OK);
+
+  UNDERRUN_LOCK ();
+  unblock_src ();
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  fail_unless_equals_int (g_list_length (buffers), 0);
+  fail_unless_equals_int (g_list_length (list_sizes), 4);
+  fail_unless_equals_int (GPOINTER_TO_UINT (g_list_nth_data (list_sizes, 0)),
+      4);
+  fail_unless_equals_int (GPOINTER_TO_UINT (g_list_nth_data (list_sizes, 1)),
+      4);
+  fail_unless_equals_int (GPOINTER_TO_UINT (g_list_nth_data (list_sizes, 2)),
+      2);
+  fail_unless_equals_int (GPOINTER_TO_UINT (g_list_nth_data (list_sizes, 3)),
+      3);
+  g_list_free (list_sizes);
+  list_sizes = NULL;
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_budget_leak)
+{
+  GstQueueBudget *budget;
+  GstContext *context;
+  GstBuffer *buffer1, *buffer2, *buffer3;
+  GstSegment segment;
+
+  /* exhausted after two buffers, available again once the queue is empty */
+  budget = gst_queue_budget_new (8, 0);
+  g_object_set (budget, "policy", GST_QUEUE_BUDGET_POLICY_LEAK, NULL);
+  context = gst_context_new (GST_QUEUE_BUDGET_CONTEXT_TYPE, TRUE);
+  gst_context_set_queue_budget (context, budget);
+  gst_element_set_context (queue, context);
+  gst_context_unref (context);
+
+  block_src ();
+
+  UNDERRUN_LOCK ();
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  buffer1 = gst_buffer_new_and_alloc (4);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer1), GST_FLOW_OK);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+  buffer2 = gst_buffer_new_and_alloc (4);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer2), GST_FLOW_OK);
+  fail_unless_equals_uint64 (gst_queue_budget_get_bytes (budget), 8);
+  fail_unless (gst_queue_budget_is_exhausted (budget));
+
+  /* the queue has room but the budget is exhausted, the buffer is leaked */
+  buffer3 = gst_buffer_new_and_alloc (4);
+  gst_buffer_ref (buffer3);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer3), GST_FLOW_OK);
+  ASSERT_BUFFER_REFCOUNT (buffer3, "buffer", 1);
+  gst_buffer_unref (buffer3);
+  fail_unless_equals_uint64 (gst_queue_budget_get_bytes (budget), 8);
+
+  UNDERRUN_LOCK ();
+  mysinkpad = setup_sink_pad (queue, &sinktemplate);
+  unblock_src ();
+  UNDERRUN_WAIT ();
+  UNDERRUN_UNLOCK ();
+
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  fail_unless_equals_uint64 (gst_queue_budget_get_bytes (budget), 0);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+  gst_object_unref (budget);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_task_pool)
+{
+  GstTaskPool *pool;
+  GstSegment segment;
+  GstPad *srcpad;
+  guint i;
+
+  pool = gst_shared_task_pool_new ();
+  gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool), 1);
+  gst_task_pool_prepare (pool, NULL);
+
+  g_object_set (G_OBJECT (queue), "max-size-buffers", 10, "task-pool", pool,
+      NULL);
+
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* no dedicated streaming thread */
+  srcpad = gst_element_get_static_pad (queue, "src");
+  fail_unless (gst_pad_get_task_state (srcpad) == GST_TASK_STOPPED);
+  gst_object_unref (srcpad);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrcpad, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < 200; i++) {
+    GstBuffer *buffer = gst_buffer_new ();
+
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  }
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 200)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  for (i = 0; i < 200; i++)
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (g_list_nth_data (buffers,
+                i)), i);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  g_object_set (G_OBJECT (queue), "task-pool", NULL, NULL);
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 static Suite *
 queue_suite (void)
 {
@@ -1193,6 +1519,7 @@ queue_suite (void)
   tcase_add_test (tc_chain, test_non_leaky_overrun);
   tcase_add_test (tc_chain, test_leaky_upstream);
   tcase_add_test (tc_chain, test_leaky_downstream);
+  tcase_add_test (tc_chain, test_leaky_downstream_time);
   tcase_add_test (tc_chain, test_time_level);
   tcase_add_test (tc_chain, test_time_level_task_not_started);
   tcase_add_test (tc_chain, test_queries_while_flushing);
@@ -1204,6 +1531,10 @@ queue_suite (void)
   tcase_add_test (tc_chain, test_sticky_not_linked);
   tcase_add_test (tc_chain, test_time_level_buffer_list);
   tcase_add_test (tc_chain, test_initial_events_nodelay);
+  tcase_add_test (tc_chain, test_spin_wait);
+  tcase_add_test (tc_chain, test_batch_push);
+  tcase_add_test (tc_chain, test_task_pool);
+  tcase_add_test (tc_chain, test_budget_leak);
 
   return s;
 }
@@ -448,6 +448,249 @@ GST_START_TEST (test_filled_read)
 
 GST_END_TEST;
 
+#define TEMP_MMAP_BUFFER_SIZE (1024 * 1024)
+#define TEMP_MMAP_SIZE (5 * TEMP_MMAP_BUFFER_SIZE)
+
+static GstBuffer *
+new_pattern_buffer (gsize size, guint64 offset)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gsize i;
+
+  buffer = gst_buffer_new_and_alloc (size);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+  for (i = 0; i < info.size; i++)
+    info.data[i] = (offset + i) % 251;
+  gst_buffer_unmap (buffer, &info);
+
+  return buffer;
+}
+
+static void
+check_pattern_data (GstBuffer * buffer, guint64 offset)
+{
+  GstMapInfo info;
+  gsize i;
+
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  for (i = 0; i < info.size; i++)
+    fail_unless_equals_int (info.data[i], (offset + i) % 251);
+  gst_buffer_unmap (buffer, &info);
+}
+
+GST_START_TEST (test_temp_mmap)
+{
+  GstElement *queue2;
+  GstBuffer *buffer, *tail;
+  GstPad *sinkpad, *srcpad;
+  GstSegment segment;
+  gchar *template;
+  guint64 offset;
+
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sinkpad = gst_element_get_static_pad (queue2, "sink");
+  srcpad = gst_element_get_static_pad (queue2, "src");
+
+  template = g_build_filename (g_get_tmp_dir (), "queue2-test-XXXXXX", NULL);
+  g_object_set (queue2, "temp-template", template, "temp-mmap", TRUE,
+      "use-buffering", FALSE, "max-size-buffers", (guint) 0,
+      "max-size-time", (guint64) 0, "max-size-bytes", (guint) 0, NULL);
+  g_free (template);
+
+  fail_unless (gst_pad_activate_mode (srcpad, GST_PAD_MODE_PULL, TRUE));
+  gst_element_set_state (queue2, GST_STATE_PLAYING);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_send_event (sinkpad, gst_event_new_stream_start ("test"));
+  gst_pad_send_event (sinkpad, gst_event_new_segment (&segment));
+
+  for (offset = 0; offset < TEMP_MMAP_SIZE;
+      offset += TEMP_MMAP_BUFFER_SIZE) {
+    buffer = new_pattern_buffer (TEMP_MMAP_BUFFER_SIZE, offset);
+    fail_unless (gst_pad_chain (sinkpad, buffer) == GST_FLOW_OK);
+  }
+
+  /* data inside one mapping is wrapped in a single read-only memory */
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (srcpad, 1000, 4096,
+          &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 4096);
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 1);
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffer, 0)));
+  check_pattern_data (buffer, 1000);
+  gst_buffer_unref (buffer);
+
+  /* reading across the end of a mapping gives one memory per mapping,
+   * queue2 maps the file in pieces of 4 MiB */
+  offset = 4 * 1024 * 1024 - 1000;
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (srcpad, offset, 4096,
+          &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 4096);
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 2);
+  check_pattern_data (buffer, offset);
+  gst_buffer_unref (buffer);
+
+  fail_unless (gst_pad_send_event (sinkpad, gst_event_new_eos ()));
+
+  /* at EOS we get the remaining data and then EOS */
+  offset = TEMP_MMAP_SIZE - 100;
+  tail = NULL;
+  fail_unless (gst_pad_get_range (srcpad, offset, 4096, &tail) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (tail), 100);
+  check_pattern_data (tail, offset);
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (srcpad, TEMP_MMAP_SIZE, 4096,
+          &buffer) == GST_FLOW_EOS);
+
+  gst_element_set_state (queue2, GST_STATE_NULL);
+
+  /* the buffers keep the data of the removed file alive */
+  check_pattern_data (tail, offset);
+  gst_buffer_unref (tail);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (queue2);
+}
+
+GST_END_TEST;
+
+static gint ring_buffer_pushed;
+
+static gpointer
+push_pattern_buffer (GstPad * sinkpad)
+{
+  fail_unless (gst_pad_chain (sinkpad,
+          new_pattern_buffer (12 * 1024, 8 * 1024)) == GST_FLOW_OK);
+  g_atomic_int_set (&ring_buffer_pushed, 1);
+
+  return NULL;
+}
+
+GST_START_TEST (test_ring_buffer_wrap)
+{
+  GstElement *queue2;
+  GstBuffer *first, *second, *buffer;
+  GstPad *sinkpad, *srcpad;
+  GThread *thread;
+  GstSegment segment;
+
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sinkpad = gst_element_get_static_pad (queue2, "sink");
+  srcpad = gst_element_get_static_pad (queue2, "src");
+
+  g_object_set (queue2, "ring-buffer-max-size", (guint64) 16 * 1024,
+      "use-buffering", FALSE,
+      "max-size-buffers", (guint) 0, "max-size-time", (guint64) 0,
+      "max-size-bytes", (guint) 16 * 1024, NULL);
+
+  fail_unless (gst_pad_activate_mode (srcpad, GST_PAD_MODE_PULL, TRUE));
+  gst_element_set_state (queue2, GST_STATE_PLAYING);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_send_event (sinkpad, gst_event_new_stream_start ("test"));
+  gst_pad_send_event (sinkpad, gst_event_new_segment (&segment));
+
+  fail_unless (gst_pad_chain (sinkpad,
+          new_pattern_buffer (8 * 1024, 0)) == GST_FLOW_OK);
+
+  /* the buffers point into the ring buffer */
+  first = second = NULL;
+  fail_unless (gst_pad_get_range (srcpad, 0, 4096, &first) == GST_FLOW_OK);
+  fail_unless (gst_pad_get_range (srcpad, 4096, 4096,
+          &second) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_n_memory (first), 1);
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (first, 0)));
+  check_pattern_data (first, 0);
+  check_pattern_data (second, 4096);
+
+  /* the writer wraps around and has to wait for the first buffer to be
+   * released before overwriting its data */
+  g_atomic_int_set (&ring_buffer_pushed, 0);
+  thread = g_thread_try_new ("gst-check", (GThreadFunc) push_pattern_buffer,
+      sinkpad, NULL);
+  fail_unless (thread != NULL);
+
+  g_usleep (G_USEC_PER_SEC / 10);
+  fail_if (g_atomic_int_get (&ring_buffer_pushed));
+
+  gst_buffer_unref (first);
+  g_thread_join (thread);
+  fail_unless (g_atomic_int_get (&ring_buffer_pushed));
+
+  /* the data of the second buffer was not overwritten */
+  check_pattern_data (second, 4096);
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (srcpad, 8 * 1024, 12 * 1024,
+          &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 12 * 1024);
+  check_pattern_data (buffer, 8 * 1024);
+  gst_buffer_unref (buffer);
+
+  gst_element_set_state (queue2, GST_STATE_NULL);
+
+  /* buffers can outlive the ring buffer */
+  check_pattern_data (second, 4096);
+  gst_buffer_unref (second);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (queue2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rate_estimator)
+{
+  GstElement *queue2;
+  GstBuffer *buffer;
+  GstPad *sinkpad, *srcpad;
+  GstSegment segment;
+  gint64 in_rate;
+  gint mode;
+  guint i;
+
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sinkpad = gst_element_get_static_pad (queue2, "sink");
+  srcpad = gst_element_get_static_pad (queue2, "src");
+
+  gst_util_set_object_arg (G_OBJECT (queue2), "rate-estimator", "ewma");
+  g_object_set (queue2, "rate-window", (guint64) GST_SECOND,
+      "ring-buffer-max-size", (guint64) 1024 * 1024, "use-buffering", FALSE,
+      "max-size-buffers", (guint) 0, "max-size-time", (guint64) 0,
+      "max-size-bytes", (guint) 1024 * 1024, NULL);
+  g_object_get (queue2, "rate-estimator", &mode, NULL);
+  fail_unless_equals_int (mode, 1);
+
+  fail_unless (gst_pad_activate_mode (srcpad, GST_PAD_MODE_PULL, TRUE));
+  gst_element_set_state (queue2, GST_STATE_PAUSED);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_send_event (sinkpad, gst_event_new_stream_start ("test"));
+  gst_pad_send_event (sinkpad, gst_event_new_segment (&segment));
+
+  /* a few rate intervals of data */
+  for (i = 0; i < 4; i++) {
+    buffer = gst_buffer_new_and_alloc (16 * 1024);
+    fail_unless (gst_pad_chain (sinkpad, buffer) == GST_FLOW_OK);
+    g_usleep (G_USEC_PER_SEC / 4);
+  }
+
+  g_object_get (queue2, "avg-in-rate", &in_rate, NULL);
+  fail_unless (in_rate > 0);
+
+  gst_element_set_state (queue2, GST_STATE_NULL);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (queue2);
+}
+
+GST_END_TEST;
 
 static GstPadProbeReturn
 block_callback (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
@@ -729,6 +972,9 @@ queue2_suite (void)
   tcase_add_test (tc_chain, test_simple_shutdown_while_running_ringbuffer);
   tcase_add_test (tc_chain, test_watermark_and_fill_level);
   tcase_add_test (tc_chain, test_filled_read);
+  tcase_add_test (tc_chain, test_temp_mmap);
+  tcase_add_test (tc_chain, test_ring_buffer_wrap);
+  tcase_add_test (tc_chain, test_rate_estimator);
   tcase_add_test (tc_chain, test_percent_overflow);
   tcase_add_test (tc_chain, test_small_ring_buffer);
   tcase_add_test (tc_chain, test_bitrate_query);
@@ -261,6 +261,139 @@ GST_START_TEST (test_streamiddemux_simple)
 
 GST_END_TEST;
 
+static guint num_buffers;
+
+static GstFlowReturn
+chain_count (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  num_buffers++;
+
+  return chain_ok (pad, parent, buffer);
+}
+
+static GstBufferList *
+create_buffer_list (guint n)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < n; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+
+  return list;
+}
+
+GST_START_TEST (test_streamiddemux_buffer_list)
+{
+  struct TestData td;
+
+  setup_test_objects (&td);
+
+  num_buffers = 0;
+
+  GST_DEBUG ("Creating mysink");
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_count);
+  gst_pad_set_active (td.mysink[0], TRUE);
+
+  td.mysink[1] = gst_pad_new ("mysink1", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[1], chain_count);
+  gst_pad_set_active (td.mysink[1], TRUE);
+
+  GST_DEBUG ("Creating mysrc");
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+  gst_pad_set_active (td.mysrc, TRUE);
+
+  GST_DEBUG ("Pushing buffer lists to two streams");
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test0");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push_list (td.mysrc,
+          create_buffer_list (10)) == GST_FLOW_OK);
+
+  gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+      GST_FORMAT_BYTES, "test1");
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push_list (td.mysrc,
+          create_buffer_list (10)) == GST_FLOW_OK);
+
+  fail_unless (gst_pad_push_event (td.mysrc,
+          gst_event_new_stream_start ("test0")));
+  set_active_srcpad (&td);
+  fail_unless (gst_pad_push_list (td.mysrc,
+          create_buffer_list (5)) == GST_FLOW_OK);
+
+  fail_unless_equals_int (num_buffers, 25);
+  fail_unless_equals_int (td.srcpad_cnt, 2);
+
+  GST_DEBUG ("Releasing mysink and mysrc");
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysink[1], FALSE);
+  gst_pad_set_active (td.mysrc, FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysink[1]);
+  gst_object_unref (td.mysrc);
+
+  GST_DEBUG ("Releasing streamiddemux");
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_streamiddemux_restart)
+{
+  struct TestData td;
+  guint i;
+
+  setup_test_objects (&td);
+
+  GST_DEBUG ("Creating mysink");
+  td.mysink[0] = gst_pad_new ("mysink0", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[0], chain_ok);
+  gst_pad_set_active (td.mysink[0], TRUE);
+
+  td.mysink[1] = gst_pad_new ("mysink1", GST_PAD_SINK);
+  gst_pad_set_chain_function (td.mysink[1], chain_ok);
+  gst_pad_set_active (td.mysink[1], TRUE);
+
+  GST_DEBUG ("Creating mysrc");
+  td.mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  fail_unless (GST_PAD_LINK_SUCCESSFUL (gst_pad_link (td.mysrc, td.demuxsink)));
+
+  /* the stream-id table has to be usable again after a restart */
+  for (i = 0; i < 2; i++) {
+    gst_pad_set_active (td.mysrc, TRUE);
+    gst_check_setup_events_with_stream_id (td.mysrc, td.demux, td.mycaps,
+        GST_FORMAT_BYTES, "test0");
+    set_active_srcpad (&td);
+    fail_unless (active_srcpad != NULL);
+    fail_unless (gst_pad_push (td.mysrc, gst_buffer_new ()) == GST_FLOW_OK);
+    fail_unless_equals_int (td.srcpad_cnt, i + 1);
+    gst_pad_set_active (td.mysrc, FALSE);
+
+    gst_object_replace ((GstObject **) & active_srcpad, NULL);
+    fail_unless (gst_element_set_state (td.demux, GST_STATE_READY) ==
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless (gst_element_set_state (td.demux, GST_STATE_PLAYING) ==
+        GST_STATE_CHANGE_SUCCESS);
+  }
+
+  GST_DEBUG ("Releasing mysink and mysrc");
+  gst_pad_set_active (td.mysink[0], FALSE);
+  gst_pad_set_active (td.mysink[1], FALSE);
+
+  gst_object_unref (td.mysink[0]);
+  gst_object_unref (td.mysink[1]);
+  gst_object_unref (td.mysrc);
+
+  GST_DEBUG ("Releasing streamiddemux");
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
 GList *expected[NUM_SUBSTREAMS];
 
 static gboolean
@@ -509,6 +642,8 @@ streamiddemux_suite (void)
   tcase_add_test (tc_chain, test_streamiddemux_simple);
   tcase_add_test (tc_chain, test_streamiddemux_num_buffers);
   tcase_add_test (tc_chain, test_streamiddemux_eos);
+  tcase_add_test (tc_chain, test_streamiddemux_buffer_list);
+  tcase_add_test (tc_chain, test_streamiddemux_restart);
   suite_add_tcase (s, tc_chain);
 
   return s;
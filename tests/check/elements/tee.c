@@ -939,6 +939,73 @@ GST_START_TEST (test_allocation_query_empty)
 
 GST_END_TEST;
 
+/* fakesrc num-buffers=100 ! tee ! fakesink, with every branch pushed from
+ * its own thread. Each fakesink should receive all buffers and the EOS. */
+GST_START_TEST (test_async_branches)
+{
+#define NUM_BRANCHES 3
+#define NUM_ASYNC_BUFFERS 100
+  GstElement *pipeline, *src, *tee;
+  GstElement *sinks[NUM_BRANCHES];
+  GstPad *req_pads[NUM_BRANCHES];
+  guint counts[NUM_BRANCHES];
+  GstBus *bus;
+  GstMessage *msg;
+  gint i;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  src = gst_check_setup_element ("fakesrc");
+  g_object_set (src, "num-buffers", NUM_ASYNC_BUFFERS, NULL);
+  tee = gst_check_setup_element ("tee");
+  fail_unless (gst_bin_add (GST_BIN (pipeline), src));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), tee));
+  fail_unless (gst_element_link (src, tee));
+
+  for (i = 0; i < NUM_BRANCHES; ++i) {
+    GstPad *sinkpad;
+
+    counts[i] = 0;
+
+    sinks[i] = gst_check_setup_element ("fakesink");
+    fail_unless (gst_bin_add (GST_BIN (pipeline), sinks[i]));
+    g_object_set (sinks[i], "signal-handoffs", TRUE, NULL);
+    g_signal_connect (sinks[i], "handoff", (GCallback) handoff, &counts[i]);
+
+    req_pads[i] = gst_element_request_pad_simple (tee, "src_%u");
+    fail_unless (req_pads[i] != NULL);
+    g_object_set (req_pads[i], "async", TRUE, "max-size-buffers", 4,
+        "max-batch-buffers", i + 1, NULL);
+
+    sinkpad = gst_element_get_static_pad (sinks[i], "sink");
+    fail_unless_equals_int (gst_pad_link (req_pads[i], sinkpad),
+        GST_PAD_LINK_OK);
+    gst_object_unref (sinkpad);
+  }
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (bus == NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  for (i = 0; i < NUM_BRANCHES; ++i) {
+    fail_unless_equals_int (counts[i], NUM_ASYNC_BUFFERS);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+
+  for (i = 0; i < NUM_BRANCHES; ++i) {
+    gst_element_release_request_pad (tee, req_pads[i]);
+    gst_object_unref (req_pads[i]);
+  }
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 tee_suite (void)
@@ -962,6 +1029,7 @@ tee_suite (void)
   tcase_add_test (tc_chain, test_allocation_query_allow_not_linked);
   tcase_add_test (tc_chain, test_allocation_query_failure);
   tcase_add_test (tc_chain, test_allocation_query_empty);
+  tcase_add_test (tc_chain, test_async_branches);
 
   return s;
 }
@@ -83,6 +83,85 @@ GST_START_TEST (test_valve_upstream_events_dont_send_sticky)
 
 GST_END_TEST;
 
+static GstBufferList *
+create_buffer_list (guint n)
+{
+  GstBufferList *list = gst_buffer_list_new_sized (n);
+  guint i;
+
+  for (i = 0; i < n; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+
+  return list;
+}
+
+GST_START_TEST (test_valve_buffer_list)
+{
+  GstHarness *h = gst_harness_new ("valve");
+  GstBuffer *buf;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  /* when not dropping, the whole list makes it through */
+  g_object_set (h->element, "drop", FALSE, NULL);
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad,
+          create_buffer_list (3)));
+  fail_unless_equals_int (3, gst_harness_buffers_received (h));
+
+  /* when dropping, the whole list is dropped */
+  g_object_set (h->element, "drop", TRUE, NULL);
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad,
+          create_buffer_list (3)));
+  fail_unless_equals_int (3, gst_harness_buffers_received (h));
+
+  /* and the first buffer after dropping is marked as discont */
+  g_object_set (h->element, "drop", FALSE, NULL);
+  fail_unless_equals_int (GST_FLOW_OK, gst_pad_push_list (h->srcpad,
+          create_buffer_list (2)));
+  fail_unless_equals_int (5, gst_harness_buffers_received (h));
+
+  gst_buffer_unref (gst_harness_pull (h));
+  gst_buffer_unref (gst_harness_pull (h));
+  gst_buffer_unref (gst_harness_pull (h));
+  buf = gst_harness_pull (h);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT));
+  gst_buffer_unref (buf);
+  buf = gst_harness_pull (h);
+  fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT));
+  gst_buffer_unref (buf);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_valve_repush_changed_sticky)
+{
+  GstHarness *h = gst_harness_new ("valve");
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h, gst_buffer_new ()));
+  fail_unless_equals_int (3, gst_harness_events_received (h));
+
+  /* the caps change is dropped together with the buffers */
+  g_object_set (h->element, "drop", TRUE, NULL);
+  fail_unless (gst_harness_push_event (h,
+          gst_event_new_caps (gst_caps_new_empty_simple ("othercaps"))));
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h, gst_buffer_new ()));
+  fail_unless_equals_int (3, gst_harness_events_received (h));
+  fail_unless_equals_int (1, gst_harness_buffers_received (h));
+
+  /* only the changed caps are sent again when reopening */
+  g_object_set (h->element, "drop", FALSE, NULL);
+  fail_unless_equals_int (GST_FLOW_OK, gst_harness_push (h, gst_buffer_new ()));
+  fail_unless_equals_int (4, gst_harness_events_received (h));
+  fail_unless_equals_int (2, gst_harness_buffers_received (h));
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 valve_suite (void)
 {
@@ -92,6 +171,8 @@ valve_suite (void)
   tc_chain = tcase_create ("valve_basic");
   tcase_add_test (tc_chain, test_valve_basic);
   tcase_add_test (tc_chain, test_valve_upstream_events_dont_send_sticky);
+  tcase_add_test (tc_chain, test_valve_buffer_list);
+  tcase_add_test (tc_chain, test_valve_repush_changed_sticky);
 
   suite_add_tcase (s, tc_chain);
 
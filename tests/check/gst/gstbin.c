@@ -301,6 +301,57 @@ GST_START_TEST (test_eos)
 
 GST_END_TEST;
 
+#define N_EOS_SINKS 8
+
+GST_START_TEST (test_eos_many_sinks)
+{
+  GstBus *bus;
+  GstElement *pipeline, *sinks[N_EOS_SINKS];
+  GstMessage *message;
+  guint i;
+
+  pipeline = gst_pipeline_new ("test_eos_many_sinks");
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline));
+
+  for (i = 0; i < N_EOS_SINKS; i++) {
+    sinks[i] = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (sinks[i], "async", FALSE, NULL);
+    gst_bin_add (GST_BIN (pipeline), sinks[i]);
+  }
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* the messages are handled synchronously, no EOS until all sinks posted
+   * one, also when a sink posts EOS twice */
+  for (i = 0; i < N_EOS_SINKS - 1; i++) {
+    gst_element_post_message (sinks[i],
+        gst_message_new_eos (GST_OBJECT_CAST (sinks[i])));
+    fail_if (gst_bus_pop_filtered (bus, GST_MESSAGE_EOS) != NULL);
+  }
+  gst_element_post_message (sinks[2],
+      gst_message_new_eos (GST_OBJECT_CAST (sinks[2])));
+  fail_if (gst_bus_pop_filtered (bus, GST_MESSAGE_EOS) != NULL);
+
+  gst_element_post_message (sinks[N_EOS_SINKS - 1],
+      gst_message_new_eos (GST_OBJECT_CAST (sinks[N_EOS_SINKS - 1])));
+  message = gst_bus_pop_filtered (bus, GST_MESSAGE_EOS);
+  fail_unless (message != NULL);
+  fail_unless (GST_MESSAGE_SRC (message) == GST_OBJECT_CAST (pipeline));
+  gst_message_unref (message);
+
+  /* the EOS messages were cleared, the sinks have to post again */
+  gst_element_post_message (sinks[0],
+      gst_message_new_eos (GST_OBJECT_CAST (sinks[0])));
+  fail_if (gst_bus_pop_filtered (bus, GST_MESSAGE_EOS) != NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_eos_recheck)
 {
   GstBus *bus;
@@ -874,6 +925,41 @@ GST_START_TEST (test_add_self)
 
 GST_END_TEST;
 
+/* the names of the children must be unique, also after removing children */
+GST_START_TEST (test_add_duplicate_name)
+{
+  GstElement *bin, *e1, *e2, *e3;
+
+  bin = gst_bin_new (NULL);
+  e1 = gst_element_factory_make ("fakesrc", "src");
+  e2 = gst_element_factory_make ("fakesrc", "src");
+  e3 = gst_element_factory_make ("fakesink", "sink");
+  gst_object_ref (e2);
+
+  fail_unless (gst_bin_add (GST_BIN (bin), e1));
+  fail_unless (gst_bin_add (GST_BIN (bin), e3));
+  ASSERT_WARNING (fail_if (gst_bin_add (GST_BIN (bin), e2)));
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (bin), 2);
+  fail_if (GST_OBJECT_IS_FLOATING (e2));
+  fail_unless (GST_OBJECT_PARENT (e2) == NULL);
+
+  /* the name can be used again once removed */
+  fail_unless (gst_bin_remove (GST_BIN (bin), e1));
+  fail_unless (gst_bin_add (GST_BIN (bin), e2));
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (bin), 2);
+
+  /* and is taken again by the new child */
+  fail_unless (gst_bin_remove (GST_BIN (bin), e3));
+  e3 = gst_element_factory_make ("fakesink", "src");
+  ASSERT_WARNING (fail_if (gst_bin_add (GST_BIN (bin), e3)));
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (bin), 1);
+
+  gst_object_unref (bin);
+  gst_object_unref (e2);
+}
+
+GST_END_TEST;
+
 
 /* g_print ("%10s: %4d => %4d\n", GST_OBJECT_NAME (msg->src), old, new); */
 
@@ -1306,6 +1392,67 @@ GST_START_TEST (test_iterate_sorted_unlinked)
 
 GST_END_TEST;
 
+static void
+check_sorted (GstBin * bin, ...)
+{
+  GstIterator *it;
+  GValue elem = { 0, };
+  GstElement *expected;
+  va_list args;
+
+  it = gst_bin_iterate_sorted (bin);
+  va_start (args, bin);
+  while ((expected = va_arg (args, GstElement *))) {
+    fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+    fail_unless (g_value_get_object (&elem) == (gpointer) expected,
+        "expected %s, got %s", GST_ELEMENT_NAME (expected),
+        GST_ELEMENT_NAME (g_value_get_object (&elem)));
+    g_value_reset (&elem);
+  }
+  va_end (args);
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_DONE);
+
+  g_value_unset (&elem);
+  gst_iterator_free (it);
+}
+
+GST_START_TEST (test_iterate_sorted_relink)
+{
+  GstElement *pipeline, *src, *sink, *identity, *bin, *sink2;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", "src");
+  sink = gst_element_factory_make ("fakesink", "sink");
+  identity = gst_element_factory_make ("identity", "identity");
+  bin = gst_bin_new ("bin");
+
+  gst_bin_add_many (GST_BIN (pipeline), sink, identity, src, bin, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  /* the order is the same when asking again */
+  check_sorted (GST_BIN (pipeline), sink, src, bin, identity, NULL);
+  check_sorted (GST_BIN (pipeline), sink, src, bin, identity, NULL);
+
+  /* relinking changes the order */
+  gst_element_unlink (src, sink);
+  fail_unless (gst_element_link_many (src, identity, sink, NULL));
+  check_sorted (GST_BIN (pipeline), sink, identity, src, bin, NULL);
+
+  /* and so does a child bin becoming a sink */
+  sink2 = gst_element_factory_make ("fakesink", "sink2");
+  gst_bin_add (GST_BIN (bin), sink2);
+  check_sorted (GST_BIN (pipeline), bin, sink, identity, src, NULL);
+
+  /* removed children are gone */
+  gst_bin_remove (GST_BIN (pipeline), identity);
+  check_sorted (GST_BIN (pipeline), bin, sink, src, NULL);
+
+  ASSERT_OBJECT_REFCOUNT (pipeline, "pipeline", 1);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 static void
 test_link_structure_change_state_changed_sync_cb (GstBus * bus,
     GstMessage * message, gpointer data)
@@ -1936,6 +2083,248 @@ GST_START_TEST (test_suppressed_flags_when_removing)
 
 GST_END_TEST;
 
+GST_START_TEST (test_task_config)
+{
+  GstElement *pipeline, *bin, *src, *sink;
+  GstTaskScheduling scheduling;
+  GstTask *task;
+  GstPad *pad;
+  guint *cpus, n_cpus;
+  gchar *str;
+  gint priority;
+
+  pipeline = gst_pipeline_new (NULL);
+  bin = gst_bin_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+
+  g_object_set (pipeline, "task-scheduling", GST_TASK_SCHEDULING_OTHER,
+      "task-cpus", "0-1", NULL);
+  g_object_get (pipeline, "task-cpus", &str, NULL);
+  fail_unless_equals_string (str, "0-1");
+  g_free (str);
+
+  /* the bin closest to the task wins */
+  g_object_set (bin, "task-cpus", "0", NULL);
+
+  gst_bin_add (GST_BIN (bin), src);
+  gst_bin_add_many (GST_BIN (pipeline), bin, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) != GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  pad = gst_element_get_static_pad (src, "src");
+  GST_OBJECT_LOCK (pad);
+  task = gst_object_ref (GST_PAD_TASK (pad));
+  GST_OBJECT_UNLOCK (pad);
+  gst_object_unref (pad);
+
+  scheduling = gst_task_get_scheduling (task, &priority);
+  fail_unless (scheduling == GST_TASK_SCHEDULING_OTHER);
+  fail_unless_equals_int (priority, 0);
+
+  cpus = gst_task_get_cpu_affinity (task, &n_cpus);
+  fail_unless_equals_int (n_cpus, 1);
+  fail_unless_equals_int (cpus[0], 0);
+  g_free (cpus);
+  gst_object_unref (task);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+#define N_CHAINS 4
+
+GST_START_TEST (test_state_change_pool)
+{
+  GstElement *pipeline, *src, *sink, *sinks[N_CHAINS];
+  GstTaskPool *pool;
+  GstState state;
+  guint i;
+
+  pool = gst_shared_task_pool_new ();
+  gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool), 2);
+  gst_task_pool_prepare (pool, NULL);
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set (pipeline, "state-change-pool", pool, NULL);
+
+  for (i = 0; i < N_CHAINS; i++) {
+    src = gst_element_factory_make ("fakesrc", NULL);
+    sinks[i] = sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (src, "is-live", TRUE, NULL);
+    gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+    fail_unless (gst_element_link (src, sink));
+  }
+
+  /* the live sources give NO_PREROLL, which wins over the ASYNC sinks */
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_NO_PREROLL);
+  for (i = 0; i < N_CHAINS; i++) {
+    fail_unless_equals_int (gst_element_get_state (sinks[i], &state, NULL, 0),
+        GST_STATE_CHANGE_ASYNC);
+  }
+
+  fail_unless (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_get_state (pipeline, &state, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (state, GST_STATE_PLAYING);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* a failing child fails the bin and the other children are brought back
+   * to their previous state */
+  g_object_set (sinks[N_CHAINS - 1], "state-error", 2, NULL);
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_FAILURE);
+  for (i = 0; i < N_CHAINS - 1; i++) {
+    fail_unless_equals_int (gst_element_get_state (sinks[i], &state, NULL, 0),
+        GST_STATE_CHANGE_SUCCESS);
+    fail_unless_equals_int (state, GST_STATE_READY);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_latency_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint *count = user_data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_LATENCY)
+    g_atomic_int_inc (count);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_recalculate_latency_unchanged)
+{
+  GstElement *pipeline, *src, *queue, *sink;
+  GstPad *pad;
+  gint count = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  queue = gst_element_factory_make ("queue", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (src, "num-buffers", 1, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, queue, sink, NULL);
+  fail_unless (gst_element_link_many (src, queue, sink, NULL));
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless_equals_int (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE), GST_STATE_CHANGE_SUCCESS);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM, count_latency_cb,
+      &count, NULL);
+
+  /* the children changed state since the last configuration */
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (count, 1);
+
+  /* nothing changed, no need to configure the same latency again */
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (count, 1);
+
+  /* a different latency is configured */
+  g_object_set (queue, "min-threshold-time", 10 * GST_MSECOND, NULL);
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (count, 2);
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (count, 2);
+
+  /* and so is the same one after a state change */
+  fail_unless_equals_int (gst_element_set_state (queue, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (gst_element_set_state (queue, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (count, 3);
+
+  gst_object_unref (pad);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_reconfigure_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint *count = user_data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) ==
+      GST_EVENT_RECONFIGURE)
+    g_atomic_int_inc (count);
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_attach_branch)
+{
+  GstElement *pipeline, *src, *tee, *sink, *branch[2];
+  GstPad *pad, *teepad;
+  GstState state;
+  gint count = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fakesrc", NULL);
+  tee = gst_element_factory_make ("tee", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "async", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, tee, sink, NULL);
+  fail_unless (gst_element_link_many (src, tee, sink, NULL));
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  pad = gst_element_get_static_pad (tee, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      count_reconfigure_cb, &count, NULL);
+
+  branch[0] = gst_element_factory_make ("queue", NULL);
+  branch[1] = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (branch[1], "async", FALSE, NULL);
+  fail_unless (gst_element_link (branch[0], branch[1]));
+
+  teepad = gst_element_request_pad_simple (tee, "src_%u");
+  fail_unless (gst_bin_attach_branch (GST_BIN (pipeline), teepad, branch, 2));
+  fail_unless (gst_pad_is_linked (teepad));
+  fail_unless (GST_OBJECT_PARENT (branch[0]) == GST_OBJECT (pipeline));
+
+  fail_unless_equals_int (gst_element_get_state (branch[0], &state, NULL, 0),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (state, GST_STATE_PLAYING);
+  fail_unless_equals_int (gst_element_get_state (branch[1], &state, NULL, 0),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (state, GST_STATE_PLAYING);
+
+  /* linking and activating the branch reconfigured upstream only once */
+  fail_unless_equals_int (g_atomic_int_get (&count), 1);
+
+  gst_object_unref (teepad);
+  gst_object_unref (pad);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bin_suite (void)
 {
@@ -1948,6 +2337,7 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_interface);
   tcase_add_test (tc_chain, test_iterate_all_by_element_factory_name);
   tcase_add_test (tc_chain, test_eos);
+  tcase_add_test (tc_chain, test_eos_many_sinks);
   tcase_add_test (tc_chain, test_eos_recheck);
   tcase_add_test (tc_chain, test_stream_start);
   tcase_add_test (tc_chain, test_children_state_change_order_flagged_sink);
@@ -1960,8 +2350,10 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_state_change_error_message);
   tcase_add_test (tc_chain, test_add_linked);
   tcase_add_test (tc_chain, test_add_self);
+  tcase_add_test (tc_chain, test_add_duplicate_name);
   tcase_add_test (tc_chain, test_iterate_sorted);
   tcase_add_test (tc_chain, test_iterate_sorted_unlinked);
+  tcase_add_test (tc_chain, test_iterate_sorted_relink);
   tcase_add_test (tc_chain, test_link_structure_change);
   tcase_add_test (tc_chain, test_state_failure_remove);
   tcase_add_test (tc_chain, test_state_failure_unref);
@@ -1971,6 +2363,10 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_deep_added_removed);
   tcase_add_test (tc_chain, test_suppressed_flags);
   tcase_add_test (tc_chain, test_suppressed_flags_when_removing);
+  tcase_add_test (tc_chain, test_task_config);
+  tcase_add_test (tc_chain, test_state_change_pool);
+  tcase_add_test (tc_chain, test_recalculate_latency_unchanged);
+  tcase_add_test (tc_chain, test_attach_branch);
 
   /* fails on OSX build bot for some reason, and is a bit silly anyway */
   if (0)
@@ -944,6 +944,101 @@ GST_START_TEST (test_new_memdup)
 
 GST_END_TEST;
 
+#define N_MANY_MEMORY 100
+
+GST_START_TEST (test_many_memory)
+{
+  GstMemory *mems[N_MANY_MEMORY];
+  GstBuffer *buf, *copy;
+  GstMapInfo map;
+  guint i;
+
+  fail_unless (gst_buffer_get_max_memory () < N_MANY_MEMORY);
+
+  buf = gst_buffer_new ();
+  for (i = 0; i < N_MANY_MEMORY; i++) {
+    mems[i] = gst_allocator_alloc (NULL, 4, NULL);
+    gst_memory_map (mems[i], &map, GST_MAP_WRITE);
+    memset (map.data, i, 4);
+    gst_memory_unmap (mems[i], &map);
+    gst_buffer_append_memory (buf, mems[i]);
+  }
+  /* a block inserted in front moves the others along */
+  gst_buffer_prepend_memory (buf, gst_allocator_alloc (NULL, 4, NULL));
+
+  /* nothing was merged, the buffer holds the memory that was added */
+  fail_unless_equals_int (gst_buffer_n_memory (buf), N_MANY_MEMORY + 1);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 4 * (N_MANY_MEMORY + 1));
+  for (i = 0; i < N_MANY_MEMORY; i++)
+    fail_unless (gst_buffer_peek_memory (buf, i + 1) == mems[i]);
+
+  /* a shallow copy shares all the memory */
+  copy = gst_buffer_copy (buf);
+  fail_unless_equals_int (gst_buffer_n_memory (copy), N_MANY_MEMORY + 1);
+  for (i = 0; i < N_MANY_MEMORY; i++)
+    fail_unless (gst_buffer_peek_memory (copy, i + 1) == mems[i]);
+  gst_buffer_unref (copy);
+
+  gst_buffer_remove_memory_range (buf, 0, N_MANY_MEMORY / 2);
+  fail_unless_equals_int (gst_buffer_n_memory (buf), N_MANY_MEMORY / 2 + 1);
+  fail_unless (gst_buffer_peek_memory (buf, 0) == mems[N_MANY_MEMORY / 2 - 1]);
+
+  /* mapping still merges on request */
+  fail_unless (gst_buffer_map (buf, &map, GST_MAP_READ));
+  fail_unless_equals_int (map.size, 4 * (N_MANY_MEMORY / 2 + 1));
+  fail_unless_equals_int (map.data[0], N_MANY_MEMORY / 2 - 1);
+  fail_unless_equals_int (map.data[map.size - 1], N_MANY_MEMORY - 1);
+  gst_buffer_unmap (buf, &map);
+
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_map_vectored)
+{
+  GstMemory *mems[N_MANY_MEMORY];
+  GstBufferMapVec vec;
+  GstBuffer *buf;
+  guint i;
+
+  /* an empty buffer has no mappings */
+  buf = gst_buffer_new ();
+  fail_unless (gst_buffer_map_vectored (buf, &vec, GST_MAP_READ));
+  fail_unless_equals_int (vec.n_maps, 0);
+  gst_buffer_unmap_vectored (buf, &vec);
+
+  for (i = 0; i < N_MANY_MEMORY; i++) {
+    mems[i] = gst_allocator_alloc (NULL, i + 1, NULL);
+    gst_buffer_append_memory (buf, mems[i]);
+  }
+
+  /* every memory is mapped in place, nothing is merged */
+  fail_unless (gst_buffer_map_vectored (buf, &vec, GST_MAP_WRITE));
+  fail_unless_equals_int (vec.n_maps, N_MANY_MEMORY);
+  for (i = 0; i < N_MANY_MEMORY; i++) {
+    fail_unless (vec.maps[i].memory == mems[i]);
+    fail_unless_equals_int (vec.maps[i].size, i + 1);
+    memset (vec.maps[i].data, i, vec.maps[i].size);
+  }
+  gst_buffer_unmap_vectored (buf, &vec);
+  fail_unless_equals_int (gst_buffer_n_memory (buf), N_MANY_MEMORY);
+  for (i = 0; i < N_MANY_MEMORY; i++)
+    fail_unless (gst_buffer_peek_memory (buf, i) == mems[i]);
+
+  /* can't map write on readonly buffer */
+  gst_buffer_ref (buf);
+  fail_unless (gst_buffer_map_vectored (buf, &vec, GST_MAP_READ));
+  fail_unless_equals_int (vec.maps[3].data[3], 3);
+  gst_buffer_unmap_vectored (buf, &vec);
+  ASSERT_CRITICAL (gst_buffer_map_vectored (buf, &vec, GST_MAP_WRITE));
+  gst_buffer_unref (buf);
+
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_suite (void)
 {
@@ -970,6 +1065,8 @@ gst_buffer_suite (void)
   tcase_add_test (tc_chain, test_writable_memory);
   tcase_add_test (tc_chain, test_wrapped_bytes);
   tcase_add_test (tc_chain, test_new_memdup);
+  tcase_add_test (tc_chain, test_many_memory);
+  tcase_add_test (tc_chain, test_map_vectored);
 
   return s;
 }
@@ -557,6 +557,79 @@ GST_START_TEST (test_foreach_modify_writeable_list)
 
 GST_END_TEST;
 
+GST_START_TEST (test_reset)
+{
+  GstBuffer *buf;
+  guint i, j;
+
+  /* the list can be refilled in a loop and keeps its storage */
+  for (j = 0; j < 3; j++) {
+    for (i = 0; i < 40; i++)
+      gst_buffer_list_add (list, gst_buffer_new ());
+    fail_unless_equals_int (gst_buffer_list_length (list), 40);
+
+    buf = gst_buffer_ref (gst_buffer_list_get (list, 0));
+    gst_buffer_list_reset (list);
+    fail_unless_equals_int (gst_buffer_list_length (list), 0);
+
+    /* the list doesn't hold the buffers anymore */
+    ASSERT_BUFFER_REFCOUNT (buf, "buf", 1);
+    fail_unless (gst_buffer_is_writable (buf));
+    gst_buffer_unref (buf);
+  }
+
+  /* a non-writable list can't be reset */
+  gst_buffer_list_add (list, gst_buffer_new ());
+  gst_buffer_list_ref (list);
+  ASSERT_CRITICAL (gst_buffer_list_reset (list));
+  fail_unless_equals_int (gst_buffer_list_length (list), 1);
+  gst_buffer_list_unref (list);
+
+  /* resetting an empty list does nothing */
+  gst_buffer_list_reset (list);
+  gst_buffer_list_reset (list);
+  fail_unless_equals_int (gst_buffer_list_length (list), 0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_repeated_buffer)
+{
+  GstBufferList *copy;
+  GstBuffer *buf, *other;
+  guint i;
+
+  /* the same buffer many times, with another one in between */
+  buf = gst_buffer_new ();
+  other = gst_buffer_new ();
+  for (i = 0; i < 10; i++)
+    gst_buffer_list_add (list, gst_buffer_ref (buf));
+  gst_buffer_list_add (list, gst_buffer_ref (other));
+  for (i = 0; i < 5; i++)
+    gst_buffer_list_add (list, gst_buffer_ref (buf));
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 16);
+
+  copy = gst_buffer_list_copy (list);
+  fail_unless_equals_int (gst_buffer_list_length (copy), 16);
+  for (i = 0; i < 16; i++)
+    fail_unless (gst_buffer_list_get (copy, i) == (i == 10 ? other : buf));
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 31);
+  ASSERT_BUFFER_REFCOUNT (other, "other", 3);
+
+  gst_buffer_list_unref (copy);
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 16);
+  ASSERT_BUFFER_REFCOUNT (other, "other", 2);
+
+  gst_buffer_list_reset (list);
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 1);
+  ASSERT_BUFFER_REFCOUNT (other, "other", 1);
+
+  gst_buffer_unref (buf);
+  gst_buffer_unref (other);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_list_suite (void)
 {
@@ -579,6 +652,8 @@ gst_buffer_list_suite (void)
   tcase_add_test (tc_chain, test_multiple_mutable_buffer_references);
   tcase_add_test (tc_chain, test_foreach_modify_non_writeable_list);
   tcase_add_test (tc_chain, test_foreach_modify_writeable_list);
+  tcase_add_test (tc_chain, test_reset);
+  tcase_add_test (tc_chain, test_repeated_buffer);
 
   return s;
 }
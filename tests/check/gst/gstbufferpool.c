@@ -336,6 +336,155 @@ GST_START_TEST (test_no_deadlock_for_buffer_discard)
 
 GST_END_TEST;
 
+static gpointer
+release_buf_delayed (gpointer p)
+{
+  g_usleep (G_USEC_PER_SEC / 100);
+  gst_buffer_unref (GST_BUFFER_CAST (p));
+  return NULL;
+}
+
+GST_START_TEST (test_pool_stats)
+{
+  GstBufferPool *pool = create_pool (10, 1, 1);
+  GstBuffer *buf;
+  GstStructure *stats;
+  GThread *thread;
+  guint hits, misses, waits;
+  GstClockTime wait_time;
+  gdouble hit_rate;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  /* preallocated buffer */
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  gst_buffer_unref (buf);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+
+  /* the only buffer is outstanding, this has to wait */
+  thread = g_thread_new (NULL, release_buf_delayed, buf);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  g_thread_join (thread);
+  gst_buffer_unref (buf);
+
+  stats = gst_buffer_pool_get_stats (pool);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_get (stats, "hits", G_TYPE_UINT, &hits,
+          "misses", G_TYPE_UINT, &misses, "hit-rate", G_TYPE_DOUBLE, &hit_rate,
+          "waits", G_TYPE_UINT, &waits, "wait-time", G_TYPE_UINT64, &wait_time,
+          NULL));
+  fail_unless_equals_int (hits, 2);
+  fail_unless_equals_int (misses, 1);
+  fail_unless_equals_float (hit_rate, 2.0 / 3.0);
+  fail_unless (waits >= 1);
+  fail_unless (wait_time > 0);
+  gst_structure_free (stats);
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static gpointer
+acquire_buf (gpointer p)
+{
+  GstBufferPool *pool = p;
+  GstBuffer *buf = NULL;
+  GstFlowReturn ret;
+
+  ret = gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+  if (buf)
+    gst_buffer_unref (buf);
+
+  return GINT_TO_POINTER (ret);
+}
+
+GST_START_TEST (test_flushing_wakes_up_waiters)
+{
+  GstBufferPool *pool = create_pool (10, 1, 1);
+  GstBuffer *buf;
+  GThread *thread1, *thread2;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+
+  /* both threads block until we flush */
+  thread1 = g_thread_new (NULL, acquire_buf, pool);
+  thread2 = g_thread_new (NULL, acquire_buf, pool);
+  g_usleep (G_USEC_PER_SEC / 100);
+  gst_buffer_pool_set_flushing (pool, TRUE);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (g_thread_join (thread1)),
+      GST_FLOW_FLUSHING);
+  fail_unless_equals_int (GPOINTER_TO_INT (g_thread_join (thread2)),
+      GST_FLOW_FLUSHING);
+
+  gst_buffer_pool_set_flushing (pool, FALSE);
+  gst_buffer_unref (buf);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  gst_buffer_unref (buf);
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool_trim_idle_buffers)
+{
+  GstBufferPool *pool = gst_buffer_pool_new ();
+  GstStructure *conf = gst_buffer_pool_get_config (pool);
+  GstClockTime idle_timeout;
+  GstBuffer *bufs[5], *buf;
+  gint i, dcount = 0;
+
+  gst_buffer_pool_config_set_params (conf, NULL, 10, 1, 0);
+  gst_buffer_pool_config_set_idle_timeout (conf, 10 * GST_MSECOND);
+  fail_unless (gst_buffer_pool_config_get_idle_timeout (conf, &idle_timeout));
+  fail_unless_equals_uint64 (idle_timeout, 10 * GST_MSECOND);
+  fail_unless (gst_buffer_pool_set_config (pool, conf));
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  /* grow the pool on demand */
+  for (i = 0; i < G_N_ELEMENTS (bufs); i++) {
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &bufs[i],
+            NULL) == GST_FLOW_OK);
+    buffer_track_destroy (bufs[i], &dcount);
+  }
+  for (i = 0; i < G_N_ELEMENTS (bufs); i++)
+    gst_buffer_unref (bufs[i]);
+  fail_unless_equals_int (dcount, 0);
+
+  /* only one buffer is used, the idle ones are trimmed after the timeout down
+   * to the minimum number of buffers */
+  for (i = 0; i < 2; i++) {
+    g_usleep (20 * 1000);
+    fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+            NULL) == GST_FLOW_OK);
+    gst_buffer_unref (buf);
+  }
+  fail_unless_equals_int (dcount, 4);
+
+  /* no trimming below the minimum */
+  g_usleep (20 * 1000);
+  fail_unless (gst_buffer_pool_acquire_buffer (pool, &buf,
+          NULL) == GST_FLOW_OK);
+  gst_buffer_unref (buf);
+  fail_unless_equals_int (dcount, 4);
+
+  gst_buffer_pool_set_active (pool, FALSE);
+  fail_unless_equals_int (dcount, 5);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_pool_suite (void)
 {
@@ -355,6 +504,9 @@ gst_buffer_pool_suite (void)
   tcase_add_test (tc_chain, test_pool_config_validate);
   tcase_add_test (tc_chain, test_flushing_pool_returns_flushing);
   tcase_add_test (tc_chain, test_no_deadlock_for_buffer_discard);
+  tcase_add_test (tc_chain, test_pool_stats);
+  tcase_add_test (tc_chain, test_flushing_wakes_up_waiters);
+  tcase_add_test (tc_chain, test_pool_trim_idle_buffers);
 
   return s;
 }
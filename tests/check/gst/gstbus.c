@@ -926,6 +926,145 @@ GST_START_TEST (test_single_gsource)
 
 GST_END_TEST;
 
+static gboolean
+count_until_eos (GstBus * bus, GstMessage * message, gpointer user_data)
+{
+  guint *count = user_data;
+
+  (*count)++;
+
+  return GST_MESSAGE_TYPE (message) != GST_MESSAGE_EOS;
+}
+
+GST_START_TEST (test_watch_batched_dispatch)
+{
+  GstBus *bus = gst_bus_new ();
+  GstMessage *message;
+  guint i, count = 0;
+
+  gst_bus_add_watch (bus, count_until_eos, &count);
+
+  for (i = 0; i < 5; i++)
+    gst_bus_post (bus, gst_message_new_application (NULL, NULL));
+  gst_bus_post (bus, gst_message_new_eos (NULL));
+  for (i = 0; i < 3; i++)
+    gst_bus_post (bus, gst_message_new_application (NULL, NULL));
+
+  /* several messages are handled per iteration, and the watch goes away as
+   * soon as the callback returns FALSE */
+  g_main_context_iteration (NULL, FALSE);
+  fail_unless_equals_int (count, 6);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+  fail_unless_equals_int (count, 6);
+
+  for (i = 0; i < 3; i++) {
+    message = gst_bus_pop (bus);
+    fail_unless (message != NULL);
+    gst_message_unref (message);
+  }
+  fail_if (gst_bus_have_pending (bus));
+
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_async_message_types)
+{
+  GstBus *bus = gst_bus_new ();
+  GstMessage *message;
+
+  fail_unless_equals_int (gst_bus_get_async_message_types (bus),
+      GST_MESSAGE_ANY);
+  gst_bus_set_async_message_types (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+  gst_bus_post (bus, gst_message_new_application (NULL, NULL));
+  gst_bus_post (bus, gst_message_new_element (NULL,
+          gst_structure_new_empty ("level")));
+  fail_if (gst_bus_have_pending (bus));
+
+  gst_bus_post (bus, gst_message_new_eos (NULL));
+  message = gst_bus_pop (bus);
+  fail_unless (message != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  gst_object_unref (bus);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_coalesce_message_types)
+{
+  GstBus *bus = gst_bus_new ();
+  GstObject *src1 = g_object_new (GST_TYPE_BIN, NULL);
+  GstObject *src2 = g_object_new (GST_TYPE_BIN, NULL);
+  GstMessage *message;
+  gint percent;
+
+  fail_unless_equals_int (gst_bus_get_coalesce_message_types (bus), 0);
+  gst_bus_set_coalesce_message_types (bus, GST_MESSAGE_BUFFERING);
+  fail_unless_equals_int (gst_bus_get_coalesce_message_types (bus),
+      GST_MESSAGE_BUFFERING);
+
+  gst_bus_post (bus, gst_message_new_buffering (src1, 10));
+  gst_bus_post (bus, gst_message_new_eos (src1));
+  gst_bus_post (bus, gst_message_new_buffering (src2, 20));
+  gst_bus_post (bus, gst_message_new_buffering (src1, 30));
+  gst_bus_post (bus, gst_message_new_eos (src1));
+  gst_bus_post (bus, gst_message_new_buffering (src1, 40));
+
+  /* the newest message takes the place of the oldest queued one */
+  message = gst_bus_peek (bus);
+  fail_unless (message != NULL);
+  gst_message_parse_buffering (message, &percent);
+  fail_unless_equals_int (percent, 40);
+  gst_message_unref (message);
+
+  message = gst_bus_pop (bus);
+  fail_unless (GST_MESSAGE_SRC (message) == src1);
+  gst_message_parse_buffering (message, &percent);
+  fail_unless_equals_int (percent, 40);
+  gst_message_unref (message);
+
+  /* other types are not coalesced */
+  message = gst_bus_pop (bus);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+
+  /* nor messages from other sources */
+  message = gst_bus_pop (bus);
+  fail_unless (GST_MESSAGE_SRC (message) == src2);
+  gst_message_parse_buffering (message, &percent);
+  fail_unless_equals_int (percent, 20);
+  gst_message_unref (message);
+
+  message = gst_bus_pop (bus);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (message), GST_MESSAGE_EOS);
+  gst_message_unref (message);
+  fail_if (gst_bus_have_pending (bus));
+
+  /* once popped, a new message is queued again */
+  gst_bus_post (bus, gst_message_new_buffering (src1, 50));
+  gst_bus_post (bus, gst_message_new_buffering (src1, 60));
+  message = gst_bus_pop (bus);
+  gst_message_parse_buffering (message, &percent);
+  fail_unless_equals_int (percent, 60);
+  gst_message_unref (message);
+  fail_if (gst_bus_have_pending (bus));
+
+  /* pending coalesced messages are released with the bus */
+  gst_bus_post (bus, gst_message_new_buffering (src1, 70));
+  gst_bus_post (bus, gst_message_new_buffering (src1, 80));
+
+  gst_object_unref (bus);
+  gst_object_unref (src1);
+  gst_object_unref (src2);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bus_suite (void)
 {
@@ -949,6 +1088,9 @@ gst_bus_suite (void)
   tcase_add_test (tc_chain, test_custom_main_context);
   tcase_add_test (tc_chain, test_async_message);
   tcase_add_test (tc_chain, test_single_gsource);
+  tcase_add_test (tc_chain, test_watch_batched_dispatch);
+  tcase_add_test (tc_chain, test_async_message_types);
+  tcase_add_test (tc_chain, test_coalesce_message_types);
   return s;
 }
 
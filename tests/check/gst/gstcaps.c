@@ -1817,6 +1817,228 @@ GST_START_TEST (test_remains_any)
 
 GST_END_TEST;
 
+GST_START_TEST (test_caps_cache)
+{
+  GstCaps *c1, *c2, *c3, *res1, *res2;
+  guint64 hits, misses;
+
+  gst_caps_cache_set_max_entries (2);
+
+  c1 = gst_caps_from_string ("video/x-raw, format = (string) { I420, NV12 }");
+  c2 = gst_caps_from_string ("video/x-raw, format = (string) NV12");
+  c3 = gst_caps_from_string ("video/x-raw, format = (string) I420");
+
+  /* writable caps are not cached */
+  res1 = gst_caps_intersect (c1, c2);
+  gst_caps_unref (res1);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 0);
+  fail_unless_equals_int (misses, 0);
+
+  gst_caps_ref (c1);
+  gst_caps_ref (c2);
+  gst_caps_ref (c3);
+
+  res1 = gst_caps_intersect (c1, c2);
+  res2 = gst_caps_intersect (c1, c2);
+  fail_unless (res1 == res2);
+  fail_unless (gst_caps_is_equal (res1, c2));
+  gst_caps_unref (res1);
+  gst_caps_unref (res2);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 1);
+  fail_unless_equals_int (misses, 1);
+
+  /* the mode is part of the key */
+  res1 = gst_caps_intersect_full (c1, c2, GST_CAPS_INTERSECT_FIRST);
+  gst_caps_unref (res1);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 1);
+  fail_unless_equals_int (misses, 2);
+
+  fail_unless (gst_caps_is_subset (c2, c1));
+  fail_unless (gst_caps_is_subset (c2, c1));
+  fail_if (gst_caps_is_subset (c1, c2));
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 2);
+  fail_unless_equals_int (misses, 4);
+
+  /* the first intersection was evicted by now */
+  res1 = gst_caps_intersect (c1, c2);
+  gst_caps_unref (res1);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 2);
+  fail_unless_equals_int (misses, 5);
+
+  fail_if (gst_caps_can_intersect (c2, c3));
+  res1 = gst_caps_intersect (c2, c3);
+  fail_unless (gst_caps_is_empty (res1));
+  gst_caps_unref (res1);
+
+  /* disabling drops the references on the cached caps */
+  gst_caps_cache_set_max_entries (0);
+  ASSERT_MINI_OBJECT_REFCOUNT (c1, "c1", 2);
+  ASSERT_MINI_OBJECT_REFCOUNT (c2, "c2", 2);
+  ASSERT_MINI_OBJECT_REFCOUNT (c3, "c3", 2);
+
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  gst_caps_unref (c3);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  gst_caps_unref (c3);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_caps_intern)
+{
+  GstCaps *c1, *c2, *c3, *copy;
+
+  c1 = gst_caps_intern (gst_caps_from_string
+      ("video/x-raw, format = (string) I420, framerate = (fraction) 30/1"));
+  c2 = gst_caps_intern (gst_caps_from_string
+      ("video/x-raw, framerate = (fraction) 60/2, format = (string) I420"));
+  c3 = gst_caps_intern (gst_caps_from_string
+      ("video/x-raw, format = (string) NV12, framerate = (fraction) 30/1"));
+
+  /* strictly equal fixed caps are interned as the same caps */
+  fail_unless (gst_caps_is_interned (c1));
+  fail_unless (c1 == c2);
+  fail_unless (c1 != c3);
+  fail_unless (gst_caps_is_equal (c1, c2));
+  fail_unless (gst_caps_is_strictly_equal (c1, c2));
+  fail_if (gst_caps_is_equal (c1, c3));
+  fail_if (gst_caps_is_strictly_equal (c1, c3));
+  fail_if (gst_caps_is_writable (c1));
+
+  /* copies are regular caps again */
+  copy = gst_caps_copy (c1);
+  fail_if (gst_caps_is_interned (copy));
+  fail_unless (gst_caps_is_equal (copy, c1));
+  fail_unless (gst_caps_is_strictly_equal (copy, c1));
+  gst_caps_unref (copy);
+
+  copy = gst_caps_copy_nth (c1, 0);
+  fail_if (gst_caps_is_interned (copy));
+  fail_unless (gst_caps_is_writable (copy));
+  fail_unless (gst_caps_is_equal (copy, c1));
+  fail_unless (gst_caps_is_strictly_equal (copy, c1));
+  gst_caps_unref (copy);
+
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  gst_caps_unref (c3);
+
+  /* non-fixed caps are returned unchanged */
+  c1 = gst_caps_from_string ("video/x-raw, format = (string) { I420, NV12 }");
+  c2 = gst_caps_intern (c1);
+  fail_unless (c1 == c2);
+  fail_if (gst_caps_is_interned (c2));
+  gst_caps_unref (c2);
+}
+
+GST_END_TEST;
+
+static void
+check_caps_binary (const gchar * str)
+{
+  GstCaps *caps, *caps2;
+  GBytes *bytes;
+  gsize consumed;
+
+  caps = gst_caps_from_string (str);
+  fail_unless (caps != NULL);
+  bytes = gst_caps_to_binary (caps);
+  fail_unless (bytes != NULL);
+  caps2 = gst_caps_from_binary (g_bytes_get_data (bytes, NULL),
+      g_bytes_get_size (bytes), &consumed);
+  fail_unless (caps2 != NULL, "could not parse binary caps for %s", str);
+  fail_unless_equals_int (consumed, g_bytes_get_size (bytes));
+  fail_unless (gst_caps_is_strictly_equal (caps, caps2),
+      "caps %s changed to %" GST_PTR_FORMAT, str, caps2);
+  g_bytes_unref (bytes);
+  gst_caps_unref (caps2);
+  gst_caps_unref (caps);
+}
+
+GST_START_TEST (test_caps_copy_on_write)
+{
+  GstCaps *caps, *copy;
+  GstStructure *s, *s2;
+  gint width;
+
+  caps = gst_caps_from_string ("video/x-raw, width=(int)320, height=(int)240; "
+      "video/x-bayer, width=(int)320; image/jpeg");
+
+  /* copies of caps that are not writable share the structures */
+  gst_caps_ref (caps);
+  copy = gst_caps_copy (caps);
+  gst_caps_ref (copy);
+  fail_unless (gst_caps_get_structure (caps, 0) ==
+      gst_caps_get_structure (copy, 0));
+  fail_unless (gst_caps_get_structure (caps, 2) ==
+      gst_caps_get_structure (copy, 2));
+
+  /* and they can't be modified while shared */
+  s = gst_caps_get_structure (copy, 1);
+  ASSERT_CRITICAL (gst_structure_set (s, "width", G_TYPE_INT, 640, NULL));
+  gst_caps_unref (copy);
+
+  /* structures of writable caps are unshared when accessed */
+  s = gst_caps_get_structure (copy, 1);
+  fail_if (s == gst_caps_get_structure (caps, 1));
+  gst_structure_set (s, "width", G_TYPE_INT, 640, NULL);
+  fail_unless (gst_structure_get_int (s, "width", &width));
+  fail_unless_equals_int (width, 640);
+  fail_unless (gst_structure_get_int (gst_caps_get_structure (caps, 1),
+          "width", &width));
+  fail_unless_equals_int (width, 320);
+
+  gst_caps_set_simple (copy, "height", G_TYPE_INT, 480, NULL);
+  fail_unless (gst_structure_get_int (gst_caps_get_structure (caps, 0),
+          "height", &width));
+  fail_unless_equals_int (width, 240);
+
+  /* a stolen structure belongs to the caller */
+  gst_caps_unref (caps);
+  s = gst_caps_steal_structure (caps, 2);
+  gst_structure_set (s, "width", G_TYPE_INT, 1, NULL);
+  s2 = gst_caps_get_structure (copy, 2);
+  fail_if (gst_structure_has_field (s2, "width"));
+  gst_structure_free (s);
+
+  gst_caps_unref (copy);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_caps_binary)
+{
+  GstCaps *caps;
+  GBytes *bytes;
+
+  check_caps_binary ("ANY");
+  check_caps_binary ("EMPTY");
+  check_caps_binary ("video/x-raw, format=(string){ I420, NV12 }, "
+      "width=(int)[ 1, 2147483647 ], framerate=(fraction)[ 0/1, 2147483647/1 ]");
+  check_caps_binary ("video/x-raw(memory:GLMemory, meta:Foo), "
+      "format=(string)RGBA; video/x-raw(ANY)");
+  check_caps_binary ("audio/x-raw, channel-mask=(bitmask)0x3, "
+      "layout=(string)interleaved; audio/x-raw(memory:SystemMemory)");
+
+  /* data of other types is rejected */
+  caps = gst_caps_new_empty_simple ("foo/bar");
+  bytes = gst_structure_to_binary (gst_caps_get_structure (caps, 0));
+  fail_unless (gst_caps_from_binary (g_bytes_get_data (bytes, NULL),
+          g_bytes_get_size (bytes), NULL) == NULL);
+  g_bytes_unref (bytes);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_caps_suite (void)
 {
@@ -1854,6 +2076,10 @@ gst_caps_suite (void)
   tcase_add_test (tc_chain, test_filter_and_map_in_place);
   tcase_add_test (tc_chain, test_equality);
   tcase_add_test (tc_chain, test_remains_any);
+  tcase_add_test (tc_chain, test_caps_cache);
+  tcase_add_test (tc_chain, test_caps_intern);
+  tcase_add_test (tc_chain, test_caps_copy_on_write);
+  tcase_add_test (tc_chain, test_caps_binary);
 
   return s;
 }
@@ -64,6 +64,65 @@ GST_START_TEST (test_basic_operations)
 
 GST_END_TEST;
 
+GST_START_TEST (test_many_features)
+{
+  GstCapsFeatures *a, *b, *sysmem;
+  gchar name[32];
+  guint i;
+
+  /* use more different features than can be represented as bits */
+  a = gst_caps_features_new_empty ();
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "m:feature%u", i);
+    gst_caps_features_add (a, name);
+  }
+  fail_unless_equals_int (gst_caps_features_get_size (a), 100);
+
+  /* same features in a different order */
+  b = gst_caps_features_new_empty ();
+  for (i = 100; i > 0; i--) {
+    g_snprintf (name, sizeof (name), "m:feature%u", i - 1);
+    gst_caps_features_add (b, name);
+  }
+  fail_unless (gst_caps_features_is_equal (a, b));
+  fail_unless (gst_caps_features_contains (b, "m:feature0"));
+  fail_unless (gst_caps_features_contains (b, "m:feature99"));
+  fail_if (gst_caps_features_contains (b, "m:feature100"));
+  fail_if (gst_caps_features_contains (b,
+          GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
+
+  gst_caps_features_remove (b, "m:feature99");
+  fail_if (gst_caps_features_is_equal (a, b));
+  fail_if (gst_caps_features_contains (b, "m:feature99"));
+  gst_caps_features_add (b, "m:feature100");
+  fail_if (gst_caps_features_is_equal (a, b));
+  fail_unless (gst_caps_features_contains (b, "m:feature100"));
+  gst_caps_features_free (b);
+
+  b = gst_caps_features_copy (a);
+  fail_unless (gst_caps_features_is_equal (a, b));
+  gst_caps_features_free (b);
+
+  /* the empty set and system memory are still the same */
+  b = gst_caps_features_new_empty ();
+  sysmem = gst_caps_features_new (GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY, NULL);
+  fail_unless (gst_caps_features_is_equal (b, sysmem));
+  fail_unless (gst_caps_features_contains (b,
+          GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
+  gst_caps_features_add (b, "m:feature99");
+  fail_if (gst_caps_features_is_equal (b, sysmem));
+  fail_if (gst_caps_features_contains (b,
+          GST_CAPS_FEATURE_MEMORY_SYSTEM_MEMORY));
+  gst_caps_features_add (sysmem, "m:feature99");
+  fail_if (gst_caps_features_is_equal (b, sysmem));
+
+  gst_caps_features_free (sysmem);
+  gst_caps_features_free (b);
+  gst_caps_features_free (a);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_from_to_string)
 {
   GstCapsFeatures *a, *b;
@@ -107,6 +166,7 @@ gst_capsfeatures_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_basic_operations);
   tcase_add_test (tc_chain, test_from_to_string);
+  tcase_add_test (tc_chain, test_many_features);
 
   return s;
 }
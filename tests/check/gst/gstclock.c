@@ -114,6 +114,126 @@ GST_START_TEST (test_set_master_refcount)
 
 GST_END_TEST;
 
+#define N_READERS 4
+
+static gint n_readers_done;
+
+static gpointer
+calibrate_thread (GstClock * clock)
+{
+  guint i = 0;
+
+  /* both calibrations give the same time, only a torn read of them
+   * can't */
+  while (g_atomic_int_get (&n_readers_done) < N_READERS) {
+    if (i++ % 2)
+      gst_clock_set_calibration (clock, 0, 0, 1, 1);
+    else
+      gst_clock_set_calibration (clock, 0, 0, GST_SECOND, GST_SECOND);
+  }
+
+  return NULL;
+}
+
+static gpointer
+read_thread (GstClock * clock)
+{
+  GstClockTime last = 0, t;
+  gboolean ok = TRUE;
+  guint i;
+
+  for (i = 0; i < 100000; i++) {
+    t = gst_clock_get_time (clock);
+    if (t < last || t > gst_clock_get_internal_time (clock))
+      ok = FALSE;
+    last = t;
+  }
+  g_atomic_int_inc (&n_readers_done);
+
+  return GINT_TO_POINTER (ok);
+}
+
+GST_START_TEST (test_get_time_calibration)
+{
+  GThread *writer, *readers[N_READERS];
+  GstClock *clock;
+  guint i;
+
+  clock = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockCalibration",
+      NULL);
+  gst_object_ref_sink (clock);
+  n_readers_done = 0;
+
+  writer = g_thread_new ("calibrate", (GThreadFunc) calibrate_thread, clock);
+  for (i = 0; i < N_READERS; i++)
+    readers[i] = g_thread_new ("read", (GThreadFunc) read_thread, clock);
+
+  for (i = 0; i < N_READERS; i++)
+    fail_unless (g_thread_join (readers[i]) == GINT_TO_POINTER (TRUE));
+  g_thread_join (writer);
+
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
+#define WINDOW_SIZE 16
+#define N_OBSERVATIONS 200
+
+GST_START_TEST (test_add_observation_regression)
+{
+  GstClockTime window[2 * WINDOW_SIZE];
+  GstClockTime slave, master;
+  GstClock *clock;
+  GRand *rand;
+  guint i, n = 0;
+
+  clock = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockRegression",
+      "window-size", WINDOW_SIZE, "window-threshold", 4, NULL);
+  gst_object_ref_sink (clock);
+  rand = g_rand_new_with_seed (1);
+
+  /* the results of the clock's own regression are compared with a full
+   * regression over the same window */
+  for (i = 0; i < N_OBSERVATIONS; i++) {
+    GstClockTime internal, external, num, denom;
+    GstClockTime ref_num, ref_denom, ref_b, ref_xbase;
+    gdouble r_squared, ref_r_squared;
+    gboolean res;
+
+    slave = 1000 * GST_SECOND + i * 100 * GST_MSECOND +
+        g_rand_int_range (rand, 0, 100 * GST_USECOND);
+    /* every now and then an observation that goes back in time */
+    if (i % 37 == 36)
+      slave -= 300 * GST_MSECOND;
+    master = gst_util_uint64_scale (slave, 100001, 100000) + 5 * GST_SECOND +
+        g_rand_int_range (rand, 0, 100 * GST_USECOND);
+
+    window[2 * (i % WINDOW_SIZE)] = slave;
+    window[2 * (i % WINDOW_SIZE) + 1] = master;
+    n = MIN (n + 1, WINDOW_SIZE);
+
+    res = gst_clock_add_observation_unapplied (clock, slave, master,
+        &r_squared, &internal, &external, &num, &denom);
+    fail_unless_equals_int (res, n >= 4);
+    if (!res)
+      continue;
+
+    fail_unless (gst_calculate_linear_regression (window, NULL, n, &ref_num,
+            &ref_denom, &ref_b, &ref_xbase, &ref_r_squared));
+    fail_unless_equals_uint64 (internal, ref_xbase);
+    fail_unless (ABS ((gdouble) num / denom - (gdouble) ref_num / ref_denom)
+        < 1e-6);
+    fail_unless (ABS (GST_CLOCK_DIFF (external, ref_b)) < GST_USECOND);
+    fail_unless (ABS (r_squared - ref_r_squared) < 1e-6);
+  }
+
+  g_rand_free (rand);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_clock_suite (void)
 {
@@ -122,6 +242,8 @@ gst_clock_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_set_master_refcount);
+  tcase_add_test (tc_chain, test_get_time_calibration);
+  tcase_add_test (tc_chain, test_add_observation_regression);
 
   return s;
 }
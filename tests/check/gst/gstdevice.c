@@ -539,6 +539,97 @@ GST_START_TEST (test_device_monitor)
 
 GST_END_TEST;
 
+/* Two providers whose probes only return once both are probing, which
+ * requires the monitor to probe them in parallel */
+typedef GstTestDeviceProvider GstTestBarrierProvider;
+typedef GstTestDeviceProviderClass GstTestBarrierProviderClass;
+typedef GstTestDeviceProvider GstTestBarrierProvider2;
+typedef GstTestDeviceProviderClass GstTestBarrierProvider2Class;
+
+GType gst_test_barrier_provider_get_type (void);
+GType gst_test_barrier_provider2_get_type (void);
+
+G_DEFINE_TYPE (GstTestBarrierProvider, gst_test_barrier_provider,
+    GST_TYPE_DEVICE_PROVIDER);
+G_DEFINE_TYPE (GstTestBarrierProvider2, gst_test_barrier_provider2,
+    gst_test_barrier_provider_get_type ());
+
+static gint barrier_probing;
+static gint barrier_met;
+
+static GList *
+gst_test_barrier_provider_probe (GstDeviceProvider * provider)
+{
+  gint64 end = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+  GstCaps *caps = gst_caps_new_empty_simple ("video/test");
+  GstDevice *device;
+
+  g_atomic_int_inc (&barrier_probing);
+  while (g_atomic_int_get (&barrier_probing) < 2
+      && g_get_monotonic_time () < end)
+    g_usleep (1000);
+  if (g_atomic_int_get (&barrier_probing) >= 2)
+    g_atomic_int_inc (&barrier_met);
+
+  device = g_object_new (gst_test_device_get_type (), "caps", caps,
+      "display-name", DISPLAY_NAME, "device-class", "Test/TestBarrier", NULL);
+  gst_caps_unref (caps);
+
+  return g_list_prepend (NULL, device);
+}
+
+static void
+gst_test_barrier_provider_class_init (GstTestBarrierProviderClass * klass)
+{
+  GstDeviceProviderClass *dpclass = GST_DEVICE_PROVIDER_CLASS (klass);
+
+  dpclass->probe = gst_test_barrier_provider_probe;
+
+  gst_device_provider_class_set_static_metadata (dpclass,
+      "Test Barrier Provider", "Test/TestBarrier",
+      "Lists test devices once another provider probes too",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_test_barrier_provider_init (GstTestBarrierProvider * self)
+{
+}
+
+static void
+gst_test_barrier_provider2_class_init (GstTestBarrierProvider2Class * klass)
+{
+}
+
+static void
+gst_test_barrier_provider2_init (GstTestBarrierProvider2 * self)
+{
+}
+
+GST_START_TEST (test_device_monitor_parallel_probe)
+{
+  GstDeviceMonitor *mon;
+  GList *devs;
+
+  gst_device_provider_register (NULL, "testbarrierprovider", 1,
+      gst_test_barrier_provider_get_type ());
+  gst_device_provider_register (NULL, "testbarrierprovider2", 1,
+      gst_test_barrier_provider2_get_type ());
+
+  mon = gst_device_monitor_new ();
+  fail_unless (gst_device_monitor_add_filter (mon, "TestBarrier", NULL) > 0);
+
+  barrier_probing = barrier_met = 0;
+  devs = gst_device_monitor_get_devices (mon);
+  fail_unless_equals_int (g_list_length (devs), 2);
+  fail_unless_equals_int (barrier_met, 2);
+  g_list_free_full (devs, (GDestroyNotify) gst_object_unref);
+
+  gst_object_unref (mon);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gst_device_suite (void)
@@ -552,6 +643,7 @@ gst_device_suite (void)
   tcase_add_test (tc_chain, test_device_provider);
   tcase_add_test (tc_chain, test_device_provider_monitor);
   tcase_add_test (tc_chain, test_device_monitor);
+  tcase_add_test (tc_chain, test_device_monitor_parallel_probe);
 
   return s;
 }
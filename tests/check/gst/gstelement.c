@@ -907,6 +907,97 @@ GST_START_TEST (test_foreach_pad)
 
 GST_END_TEST;
 
+GST_START_TEST (test_claim_pad_index)
+{
+  GstElement *e;
+  GstPadTemplate *templ, *templ2;
+  guint index;
+
+  e = g_object_new (gst_test_element3_get_type (), NULL);
+  templ = gst_element_get_pad_template (e, "src_%u");
+  templ2 = gst_element_get_pad_template (e, "src_%d");
+
+  fail_unless (gst_element_claim_pad_index (e, templ, NULL, &index));
+  fail_unless_equals_int (index, 0);
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_%u", &index));
+  fail_unless_equals_int (index, 1);
+
+  /* explicit names claim their index and move the next index past them */
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_5", &index));
+  fail_unless_equals_int (index, 5);
+  fail_if (gst_element_claim_pad_index (e, templ, "src_5", &index));
+  fail_if (gst_element_claim_pad_index (e, templ, "src_x", &index));
+  fail_if (gst_element_claim_pad_index (e, templ, "sink_6", &index));
+  fail_unless (gst_element_claim_pad_index (e, templ, NULL, &index));
+  fail_unless_equals_int (index, 6);
+
+  /* released indices can be claimed again but are not reused */
+  gst_element_release_pad_index (e, templ, 1);
+  fail_unless (gst_element_claim_pad_index (e, templ, NULL, &index));
+  fail_unless_equals_int (index, 7);
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_1", &index));
+  fail_unless_equals_int (index, 1);
+
+  /* indices already in use are skipped */
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_200", &index));
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_8", &index));
+  gst_element_release_pad_index (e, templ, 200);
+  fail_unless (gst_element_claim_pad_index (e, templ, "src_9", &index));
+  fail_unless (gst_element_claim_pad_index (e, templ, NULL, &index));
+  fail_unless_equals_int (index, 201);
+
+  /* each template has its own indices */
+  fail_unless (gst_element_claim_pad_index (e, templ2, NULL, &index));
+  fail_unless_equals_int (index, 0);
+
+  gst_object_unref (e);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_get_static_pad_many)
+{
+  GstElement *e;
+  GstPad *pad;
+  gchar name[32];
+  gint i;
+
+  e = gst_bin_new ("testbin");
+
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "src_%d", i);
+    fail_unless (gst_element_add_pad (e, gst_pad_new (name, GST_PAD_SRC)));
+  }
+
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "src_%d", i);
+    pad = gst_element_get_static_pad (e, name);
+    fail_unless (pad != NULL);
+    fail_unless_equals_string (GST_PAD_NAME (pad), name);
+    if (i % 2)
+      gst_element_remove_pad (e, pad);
+    gst_object_unref (pad);
+  }
+
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "src_%d", i);
+    pad = gst_element_get_static_pad (e, name);
+    fail_unless ((pad != NULL) == (i % 2 == 0));
+    if (pad)
+      gst_object_unref (pad);
+  }
+
+  /* names stay unique */
+  ASSERT_CRITICAL (gst_element_add_pad (e, gst_pad_new ("src_0",
+              GST_PAD_SRC)));
+  fail_unless (gst_element_add_pad (e, gst_pad_new ("src_1", GST_PAD_SRC)));
+  fail_unless_equals_int (e->numpads, 51);
+
+  gst_object_unref (e);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_element_suite (void)
 {
@@ -923,6 +1014,8 @@ gst_element_suite (void)
   tcase_add_test (tc_chain, test_property_notify_message);
   tcase_add_test (tc_chain, test_request_pad_templates);
   tcase_add_test (tc_chain, test_foreach_pad);
+  tcase_add_test (tc_chain, test_claim_pad_index);
+  tcase_add_test (tc_chain, test_get_static_pad_many);
 
   return s;
 }
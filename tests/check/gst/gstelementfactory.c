@@ -193,6 +193,228 @@ GST_START_TEST (test_class)
 
 GST_END_TEST;
 
+typedef GstElement GstIndexTestSink;
+typedef GstElementClass GstIndexTestSinkClass;
+
+GType gst_index_test_sink_get_type (void);
+G_DEFINE_TYPE (GstIndexTestSink, gst_index_test_sink, GST_TYPE_ELEMENT);
+
+static void
+gst_index_test_sink_class_init (GstIndexTestSinkClass * klass)
+{
+  static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+      GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS ("video/x-index-test"));
+
+  gst_element_class_add_static_pad_template (klass, &sink_template);
+  gst_element_class_set_metadata (klass, "Index test", "Sink/Video",
+      "Element for the factory index test", "GStreamer");
+}
+
+static void
+gst_index_test_sink_init (GstIndexTestSink * sink)
+{
+}
+
+static void
+check_list_get_elements (GstElementFactoryListType type, GstRank minrank)
+{
+  GList *all, *expected = NULL, *result, *l;
+
+  all = gst_registry_get_feature_list (gst_registry_get (),
+      GST_TYPE_ELEMENT_FACTORY);
+  for (l = all; l; l = l->next) {
+    GstElementFactory *factory = l->data;
+
+    if (gst_plugin_feature_get_rank (GST_PLUGIN_FEATURE (factory)) >= minrank
+        && gst_element_factory_list_is_type (factory, type))
+      expected = g_list_prepend (expected, factory);
+  }
+
+  result = gst_element_factory_list_get_elements (type, minrank);
+  fail_unless_equals_int (g_list_length (result), g_list_length (expected));
+  for (l = expected; l; l = l->next)
+    fail_unless (g_list_find (result, l->data) != NULL);
+
+  gst_plugin_feature_list_free (result);
+  g_list_free (expected);
+  gst_plugin_feature_list_free (all);
+}
+
+GST_START_TEST (test_list_get_elements)
+{
+  GList *list, *filtered;
+  GstCaps *caps;
+
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_ANY, GST_RANK_NONE);
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_SINK |
+      GST_ELEMENT_FACTORY_TYPE_SRC, GST_RANK_NONE);
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+      GST_RANK_NONE);
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_SINK |
+      GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, GST_RANK_NONE);
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_ANY, GST_RANK_PRIMARY);
+  check_list_get_elements (0, GST_RANK_NONE);
+
+  /* the index is updated when new factories are registered */
+  fail_unless (gst_element_register (NULL, "indextestsink", GST_RANK_NONE,
+          gst_index_test_sink_get_type ()));
+  check_list_get_elements (GST_ELEMENT_FACTORY_TYPE_SINK |
+      GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO, GST_RANK_NONE);
+
+  list = gst_element_factory_list_get_elements (GST_ELEMENT_FACTORY_TYPE_ANY,
+      GST_RANK_NONE);
+
+  caps = gst_caps_from_string ("video/x-index-test");
+  filtered = gst_element_factory_list_filter (list, caps, GST_PAD_SINK, FALSE);
+  fail_unless_equals_int (g_list_length (filtered), 1);
+  fail_unless_equals_string (GST_OBJECT_NAME (filtered->data),
+      "indextestsink");
+  gst_plugin_feature_list_free (filtered);
+
+  filtered = gst_element_factory_list_filter (list, caps, GST_PAD_SRC, FALSE);
+  fail_unless (filtered == NULL);
+  gst_caps_unref (caps);
+
+  /* the fakesink template takes ANY caps */
+  caps = gst_caps_from_string ("video/x-index-test; audio/x-other");
+  filtered = gst_element_factory_list_filter (list, caps, GST_PAD_SINK, FALSE);
+  fail_unless (g_list_length (filtered) >= 2);
+  gst_plugin_feature_list_free (filtered);
+  gst_caps_unref (caps);
+
+  gst_plugin_feature_list_free (list);
+}
+
+GST_END_TEST;
+
+typedef GstElement GstDescTestSrc;
+typedef GstElementClass GstDescTestSrcClass;
+
+GType gst_desc_test_src_get_type (void);
+G_DEFINE_TYPE (GstDescTestSrc, gst_desc_test_src, GST_TYPE_ELEMENT);
+
+static GstStaticPadTemplate desc_test_src_template =
+GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-desc-test"));
+
+static void
+gst_desc_test_src_class_init (GstDescTestSrcClass * klass)
+{
+  gst_element_class_add_static_pad_template (klass, &desc_test_src_template);
+  gst_element_class_set_metadata (klass, "Description test", "Source/Audio",
+      "Element for the factory description test", "GStreamer");
+}
+
+static void
+gst_desc_test_src_init (GstDescTestSrc * src)
+{
+  GstPad *pad;
+
+  pad = gst_pad_new_from_static_template (&desc_test_src_template, "src");
+  gst_element_add_pad (src, pad);
+}
+
+static const GstElementFactoryDescription desc_test_src_desc = {
+  "desctestsrc", GST_RANK_NONE, gst_desc_test_src_get_type,
+  "Description test", "Source/Audio",
+  "Element for the factory description test", "GStreamer",
+  &desc_test_src_template, 1, NULL
+};
+
+GST_START_TEST (test_register_description)
+{
+  GstElementFactory *factory;
+  const GList *templates;
+  GstStaticPadTemplate *templ;
+  GstElement *e;
+
+  fail_unless (gst_element_register_description (NULL, &desc_test_src_desc));
+
+  factory = gst_element_factory_find ("desctestsrc");
+  fail_unless (factory != NULL);
+
+  /* the details are available without setting up the element class */
+  fail_unless_equals_string (gst_element_factory_get_metadata (factory,
+          GST_ELEMENT_METADATA_KLASS), "Source/Audio");
+  fail_unless_equals_int (gst_element_factory_get_num_pad_templates (factory),
+      1);
+  templates = gst_element_factory_get_static_pad_templates (factory);
+  templ = templates->data;
+  fail_unless_equals_string (templ->name_template, "src");
+  fail_unless_equals_string (templ->static_caps.string, "audio/x-desc-test");
+  fail_unless (gst_element_factory_list_is_type (factory,
+          GST_ELEMENT_FACTORY_TYPE_SRC | GST_ELEMENT_FACTORY_TYPE_MEDIA_AUDIO));
+  fail_unless (g_type_from_name ("GstDescTestSrc") == 0);
+
+  e = gst_element_factory_create (factory, NULL);
+  fail_unless (e != NULL);
+  fail_unless (G_TYPE_FROM_INSTANCE (e) == gst_desc_test_src_get_type ());
+  fail_unless (gst_element_factory_get_element_type (factory) ==
+      gst_desc_test_src_get_type ());
+  fail_unless (gst_element_get_factory (e) == factory);
+  fail_unless (e->numpads == 1);
+  gst_object_unref (e);
+
+  gst_object_unref (factory);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pool)
+{
+  GstElementFactory *factory;
+  GstElement *e, *e2, *bin;
+  gboolean sync;
+  gchar *name;
+
+  factory = gst_element_factory_find ("fakesink");
+  fail_unless (factory != NULL);
+  fail_unless (gst_element_factory_set_pool_size (factory, 2));
+
+  /* the prototype element is handed out first */
+  e = gst_element_factory_make ("fakesink", "sink1");
+  fail_unless (e != NULL);
+  fail_unless (g_object_is_floating (e));
+  gst_object_ref_sink (e);
+  fail_unless_equals_string (GST_OBJECT_NAME (e), "sink1");
+
+  g_object_set (e, "sync", FALSE, NULL);
+  gst_element_factory_recycle (e);
+
+  /* properties are reset and a new name is given out */
+  e2 = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (e2 == e);
+  fail_unless (g_object_is_floating (e2));
+  gst_object_ref_sink (e2);
+  g_object_get (e2, "sync", &sync, "name", &name, NULL);
+  fail_unless (sync == TRUE);
+  fail_unless (strcmp (name, "sink1") != 0);
+  g_free (name);
+
+  /* elements that are still in use elsewhere are not recycled */
+  bin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (bin), gst_object_ref (e2));
+  gst_element_factory_recycle (e2);
+  e = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (e != e2);
+  gst_object_unref (bin);
+
+  /* construct properties other than the name bypass the pool */
+  gst_object_ref_sink (e);
+  gst_element_factory_recycle (e);
+  e2 = gst_element_factory_make_full ("fakesink", "sync", FALSE, NULL);
+  fail_unless (e2 != e);
+  gst_object_unref (e2);
+
+  fail_unless (gst_element_factory_set_pool_size (factory, 0));
+  e2 = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (e2 != NULL);
+  gst_object_unref (e2);
+
+  gst_object_unref (factory);
+}
+
+GST_END_TEST;
 
 static Suite *
 gst_element_factory_suite (void)
@@ -206,6 +428,9 @@ gst_element_factory_suite (void)
   tcase_add_test (tc_chain, test_element_factory);
   tcase_add_test (tc_chain, test_can_sink_any_caps);
   tcase_add_test (tc_chain, test_can_sink_all_caps);
+  tcase_add_test (tc_chain, test_list_get_elements);
+  tcase_add_test (tc_chain, test_pool);
+  tcase_add_test (tc_chain, test_register_description);
 
   return s;
 }
@@ -1233,6 +1233,98 @@ GST_START_TEST (test_activate_sink_and_src)
 
 GST_END_TEST;
 
+static gint nested_probe_count;
+
+static GstPadProbeReturn
+nested_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  nested_probe_count++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* wraps @element in @depth bins, ghosting its pads at every level */
+static GstElement *
+nest_in_bins (GstElement * element, guint depth)
+{
+  while (depth--) {
+    GstElement *bin = gst_bin_new (NULL);
+    GstPad *pad;
+
+    gst_bin_add (GST_BIN (bin), element);
+    pad = gst_element_get_static_pad (element, "sink");
+    gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+    gst_object_unref (pad);
+    pad = gst_element_get_static_pad (element, "src");
+    gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+    gst_object_unref (pad);
+    element = bin;
+  }
+
+  return element;
+}
+
+GST_START_TEST (test_nested_ghost_pads_push)
+{
+  GstHarness *h;
+  GstElement *b, *identity;
+  GstPad *sinkpad, *internal;
+  GstBufferList *list;
+  gulong id;
+
+  identity = gst_element_factory_make ("identity", NULL);
+  b = nest_in_bins (identity, 4);
+
+  h = gst_harness_new_with_element (b, "sink", "src");
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new ()),
+      GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+
+  list = gst_buffer_list_new ();
+  gst_buffer_list_add (list, gst_buffer_new ());
+  gst_buffer_list_add (list, gst_buffer_new ());
+  fail_unless_equals_int (gst_pad_push_list (h->srcpad, list), GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+  gst_buffer_unref (gst_harness_pull (h));
+
+  /* probes on the ghost pads and their internal pads are still called */
+  sinkpad = gst_element_get_static_pad (b, "sink");
+  internal = GST_PAD (gst_proxy_pad_get_internal (GST_PROXY_PAD (sinkpad)));
+  nested_probe_count = 0;
+  id = gst_pad_add_probe (sinkpad, GST_PAD_PROBE_TYPE_BUFFER,
+      nested_probe_cb, NULL, NULL);
+  gst_pad_add_probe (internal, GST_PAD_PROBE_TYPE_BUFFER,
+      nested_probe_cb, NULL, NULL);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new ()),
+      GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+  fail_unless_equals_int (nested_probe_count, 2);
+
+  gst_pad_remove_probe (sinkpad, id);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new ()),
+      GST_FLOW_OK);
+  gst_buffer_unref (gst_harness_pull (h));
+  fail_unless_equals_int (nested_probe_count, 3);
+
+  /* the flow return is still seen on the ghost pads */
+  fail_unless_equals_int (gst_pad_get_last_flow_return (sinkpad),
+      GST_FLOW_OK);
+  gst_pad_set_active (h->sinkpad, FALSE);
+  fail_unless_equals_int (gst_harness_push (h, gst_buffer_new ()),
+      GST_FLOW_FLUSHING);
+  fail_unless_equals_int (gst_pad_get_last_flow_return (sinkpad),
+      GST_FLOW_FLUSHING);
+
+  gst_object_unref (internal);
+  gst_object_unref (sinkpad);
+  gst_object_unref (b);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_activate_src_pull_mode)
 {
   GstElement *b;
@@ -1431,6 +1523,7 @@ gst_ghost_pad_suite (void)
 
   tcase_add_test (tc_chain, test_activate_src);
   tcase_add_test (tc_chain, test_activate_sink_and_src);
+  tcase_add_test (tc_chain, test_nested_ghost_pads_push);
   tcase_add_test (tc_chain, test_activate_src_pull_mode);
   tcase_add_test (tc_chain, test_activate_sink_switch_mode);
   tcase_add_test (tc_chain, test_deactivate_already_deactive_with_no_parent);
@@ -439,6 +439,127 @@ GST_START_TEST (info_set_and_unset_multiple)
   fail_unless_equals_int (cat3, GST_LEVEL_WARNING);
 }
 
+GST_END_TEST;
+
+GST_START_TEST (info_set_threshold_exact_and_wildcard)
+{
+  GstDebugLevel orig = gst_debug_get_default_threshold ();
+  GstDebugCategory *cat1, *cat2, *cat3;
+
+  cat1 = _gst_debug_category_new ("exactcat", 0, NULL);
+  fail_unless (_gst_debug_category_new ("exactcat", 0, NULL) == cat1);
+
+  /* the later patterns win, whether they have wildcards or not */
+  gst_debug_set_threshold_from_string ("exactc*:3,exactcat:5", TRUE);
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat1), 5);
+  gst_debug_set_threshold_from_string ("exactcat:5,exactc*:3", TRUE);
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat1), 3);
+
+  /* and the same applies to categories registered afterwards */
+  gst_debug_set_threshold_from_string ("exactc*:3,exactcat2:6", TRUE);
+  cat2 = _gst_debug_category_new ("exactcat2", 0, NULL);
+  cat3 = _gst_debug_category_new ("exactcat3", 0, NULL);
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat2), 6);
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat3), 3);
+
+  gst_debug_unset_threshold_for_name ("exactcat2");
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat2), 3);
+  gst_debug_unset_threshold_for_name ("exactc*");
+  gst_debug_unset_threshold_for_name ("exactcat");
+  fail_unless_equals_int (gst_debug_category_get_threshold (cat1),
+      GST_LEVEL_DEFAULT);
+
+  gst_debug_set_default_threshold (orig);
+}
+
+GST_END_TEST;
+
+static gpointer
+ring_buffer_log_thread (gpointer user_data)
+{
+  GST_DEBUG ("from the other thread");
+
+  return NULL;
+}
+
+GST_START_TEST (info_ring_buffer_logger)
+{
+  gchar **logs;
+  guint i;
+
+  gst_debug_remove_log_function (gst_debug_log_default);
+  gst_debug_add_ring_buffer_logger (1024, 0);
+  gst_debug_set_default_threshold (GST_LEVEL_LOG);
+
+  GST_DEBUG ("first message");
+  g_thread_join (g_thread_new ("logger", ring_buffer_log_thread, NULL));
+
+  /* the thread that logged last comes first */
+  logs = gst_debug_ring_buffer_logger_get_logs ();
+  fail_unless_equals_int (g_strv_length (logs), 2);
+  fail_unless (g_str_has_suffix (logs[0], "from the other thread\n"));
+  fail_unless (g_str_has_suffix (logs[1], "first message\n"));
+  g_strfreev (logs);
+
+  /* the oldest lines are dropped when the log is full */
+  for (i = 0; i < 1000; i++)
+    GST_LOG ("message %u", i);
+
+  logs = gst_debug_ring_buffer_logger_get_logs ();
+  fail_unless_equals_int (g_strv_length (logs), 2);
+  fail_unless (strlen (logs[0]) <= 1024);
+  fail_if (strstr (logs[0], "first message"));
+  fail_unless (g_str_has_suffix (logs[0], "message 999\n"));
+  g_strfreev (logs);
+
+  /* clean up */
+  gst_debug_set_default_threshold (GST_LEVEL_NONE);
+  gst_debug_remove_ring_buffer_logger ();
+  gst_debug_add_log_function (gst_debug_log_default, NULL, NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (info_deferred_logger)
+{
+  gchar str[] = "before";
+  GstCaps *caps;
+  gchar **logs;
+  guint i;
+
+  gst_debug_remove_log_function (gst_debug_log_default);
+  gst_debug_add_deferred_logger (4096);
+  gst_debug_set_default_threshold (GST_LEVEL_LOG);
+
+  caps = gst_caps_new_empty_simple ("video/x-raw");
+  GST_DEBUG ("deferred %d %s %" GST_PTR_FORMAT, 42, str, caps);
+  gst_caps_unref (caps);
+
+  /* the arguments are copied when logging */
+  strcpy (str, "after!");
+  logs = gst_debug_deferred_logger_get_logs ();
+  fail_unless_equals_int (g_strv_length (logs), 1);
+  fail_unless (g_pattern_match_simple ("*DEBUG*check*gstinfo.c:*"
+          ":info_deferred_logger: deferred 42 before video/x-raw\n", logs[0]));
+  g_strfreev (logs);
+
+  /* the oldest records are dropped when the log is full */
+  for (i = 0; i < 1000; i++)
+    GST_LOG ("message %u", i);
+
+  logs = gst_debug_deferred_logger_get_logs ();
+  fail_unless_equals_int (g_strv_length (logs), 1);
+  fail_if (strstr (logs[0], "deferred 42"));
+  fail_if (strstr (logs[0], "message 0\n"));
+  fail_unless (g_str_has_suffix (logs[0], "message 999\n"));
+  g_strfreev (logs);
+
+  /* clean up */
+  gst_debug_set_default_threshold (GST_LEVEL_NONE);
+  gst_debug_remove_deferred_logger ();
+  gst_debug_add_log_function (gst_debug_log_default, NULL, NULL);
+}
+
 GST_END_TEST;
 #endif
 
@@ -519,6 +640,36 @@ GST_START_TEST (info_post_gst_init_category_registration)
 
 GST_END_TEST;
 
+GST_START_TEST (info_stack_addresses)
+{
+  gpointer addresses[32];
+  gchar *trace;
+  guint n;
+
+  n = gst_debug_get_stack_addresses (addresses, G_N_ELEMENTS (addresses));
+  fail_unless (n <= G_N_ELEMENTS (addresses));
+
+  /* not all platforms can unwind the stack */
+  trace = gst_debug_get_stack_trace (GST_STACK_TRACE_SHOW_NONE);
+  if (!trace)
+    return;
+  g_free (trace);
+
+  fail_unless (n > 0);
+  fail_unless_equals_int (gst_debug_get_stack_addresses (addresses, 1), 1);
+
+  trace = gst_debug_symbolize_stack_addresses ((gpointer const *) addresses,
+      1, GST_STACK_TRACE_SHOW_NONE);
+  fail_unless (trace != NULL);
+  fail_unless (strlen (trace) > 0);
+  g_free (trace);
+
+  fail_unless (gst_debug_symbolize_stack_addresses (NULL, 0,
+          GST_STACK_TRACE_SHOW_NONE) == NULL);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_info_suite (void)
 {
@@ -529,6 +680,7 @@ gst_info_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, info_fourcc);
+  tcase_add_test (tc_chain, info_stack_addresses);
 #ifndef GST_DISABLE_GST_DEBUG
   tcase_add_test (tc_chain, info_segment_format_printf_extension);
   tcase_add_test (tc_chain, info_ptr_format_printf_extension);
@@ -540,6 +692,9 @@ gst_info_suite (void)
   tcase_add_test (tc_chain, info_register_same_debug_category_twice);
   tcase_add_test (tc_chain, info_set_and_unset_single);
   tcase_add_test (tc_chain, info_set_and_unset_multiple);
+  tcase_add_test (tc_chain, info_set_threshold_exact_and_wildcard);
+  tcase_add_test (tc_chain, info_ring_buffer_logger);
+  tcase_add_test (tc_chain, info_deferred_logger);
   tcase_add_test (tc_chain, info_post_gst_init_category_registration);
 #endif
 
@@ -424,6 +424,72 @@ GST_START_TEST (test_filter_of_filter_locking)
 
 GST_END_TEST;
 
+#define NUM_SNAPSHOT_PADS 5
+
+GST_START_TEST (test_list_snapshot)
+{
+  GstPad *pads[NUM_SNAPSHOT_PADS], *extra;
+  GList *l = NULL;
+  GstIterator *iter, *copy;
+  GValue item = { 0, };
+  gint i;
+
+  for (i = 0; i < NUM_SNAPSHOT_PADS; i++) {
+    pads[i] = gst_pad_new (NULL, GST_PAD_SRC);
+    l = g_list_append (l, pads[i]);
+  }
+
+  iter = gst_iterator_new_list_snapshot (GST_TYPE_PAD, l, NULL);
+  fail_unless (iter != NULL);
+  for (i = 0; i < NUM_SNAPSHOT_PADS; i++)
+    ASSERT_OBJECT_REFCOUNT (pads[i], "pad", 2);
+
+  /* changing the list doesn't affect the iterator */
+  extra = gst_pad_new (NULL, GST_PAD_SINK);
+  l = g_list_prepend (l, extra);
+  l = g_list_remove (l, pads[2]);
+
+  fail_unless (gst_iterator_next (iter, &item) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&item) == pads[0]);
+  g_value_reset (&item);
+
+  copy = gst_iterator_copy (iter);
+
+  for (i = 1; i < NUM_SNAPSHOT_PADS; i++) {
+    fail_unless (gst_iterator_next (iter, &item) == GST_ITERATOR_OK);
+    fail_unless (g_value_get_object (&item) == pads[i]);
+    g_value_reset (&item);
+  }
+  fail_unless (gst_iterator_next (iter, &item) == GST_ITERATOR_DONE);
+
+  /* the copy continues from where it was copied */
+  fail_unless (gst_iterator_next (copy, &item) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&item) == pads[1]);
+  g_value_reset (&item);
+
+  /* resync starts again at the beginning of the snapshot */
+  gst_iterator_resync (iter);
+  fail_unless (gst_iterator_next (iter, &item) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&item) == pads[0]);
+  g_value_unset (&item);
+
+  /* the copy keeps the shared snapshot alive */
+  gst_iterator_free (iter);
+  for (i = 0; i < NUM_SNAPSHOT_PADS; i++)
+    ASSERT_OBJECT_REFCOUNT (pads[i], "pad", 2);
+  gst_iterator_free (copy);
+  for (i = 0; i < NUM_SNAPSHOT_PADS; i++)
+    ASSERT_OBJECT_REFCOUNT (pads[i], "pad", 1);
+
+  /* clean up */
+  for (i = 0; i < NUM_SNAPSHOT_PADS; i++)
+    gst_object_unref (pads[i]);
+  gst_object_unref (extra);
+  g_list_free (l);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_iterator_suite (void)
 {
@@ -441,6 +507,7 @@ gst_iterator_suite (void)
   tcase_add_test (tc_chain, test_filter_locking);
   tcase_add_test (tc_chain, test_filter_of_filter);
   tcase_add_test (tc_chain, test_filter_of_filter_locking);
+  tcase_add_test (tc_chain, test_list_snapshot);
   return s;
 }
 
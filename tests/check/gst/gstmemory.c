@@ -24,6 +24,11 @@
 # include "config.h"
 #endif
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#include <glib/gstdio.h>
+#endif
+
 #include <gst/check/gstcheck.h>
 
 GST_START_TEST (test_submemory)
@@ -738,6 +743,368 @@ GST_START_TEST (test_no_error_and_no_warning_on_map_failure)
 GST_END_TEST;
 #endif /* !GST_DISABLE_GST_DEBUG */
 
+/* an allocator that counts the calls to its map and unmap functions */
+typedef struct
+{
+  GstMemory mem;
+  guint8 *data;
+} MyCountingMemory;
+
+typedef GstAllocator MyCountingAllocator;
+typedef GstAllocatorClass MyCountingAllocatorClass;
+
+GType my_counting_allocator_get_type (void);
+G_DEFINE_TYPE (MyCountingAllocator, my_counting_allocator, GST_TYPE_ALLOCATOR);
+
+static gint n_counting_maps, n_counting_unmaps;
+
+static GstMemory *
+_my_counting_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  MyCountingMemory *mem = g_slice_new (MyCountingMemory);
+
+  gst_memory_init (GST_MEMORY_CAST (mem), params->flags, allocator, NULL,
+      size, 0, 0, size);
+  mem->data = g_malloc0 (size);
+
+  return (GstMemory *) mem;
+}
+
+static void
+_my_counting_free (GstAllocator * allocator, GstMemory * mem)
+{
+  MyCountingMemory *cmem = (MyCountingMemory *) mem;
+
+  g_free (cmem->data);
+  g_slice_free (MyCountingMemory, cmem);
+}
+
+static gpointer
+_my_counting_mem_map (MyCountingMemory * mem, gsize maxsize, GstMapFlags flags)
+{
+  g_atomic_int_inc (&n_counting_maps);
+  return mem->data;
+}
+
+static gboolean
+_my_counting_mem_unmap (MyCountingMemory * mem)
+{
+  g_atomic_int_inc (&n_counting_unmaps);
+  return TRUE;
+}
+
+static void
+my_counting_allocator_class_init (MyCountingAllocatorClass * klass)
+{
+  klass->alloc = _my_counting_alloc;
+  klass->free = _my_counting_free;
+}
+
+static void
+my_counting_allocator_init (MyCountingAllocator * allocator)
+{
+  allocator->mem_type = "MyCountingMemory";
+  allocator->mem_map = (GstMemoryMapFunction) _my_counting_mem_map;
+  allocator->mem_unmap = (GstMemoryUnmapFunction) _my_counting_mem_unmap;
+}
+
+GST_START_TEST (test_map_cache)
+{
+  GstAllocator *alloc;
+  GstMemory *mem;
+  GstMapInfo info1, info2;
+
+  alloc = g_object_new (my_counting_allocator_get_type (), NULL);
+  GST_OBJECT_FLAG_SET (alloc, GST_ALLOCATOR_FLAG_CACHE_READ_MAPS);
+  mem = gst_allocator_alloc (alloc, 100, NULL);
+  n_counting_maps = n_counting_unmaps = 0;
+
+  /* nested read maps reuse the first mapping */
+  fail_unless (gst_memory_map (mem, &info1, GST_MAP_READ));
+  fail_unless (gst_memory_map (mem, &info2, GST_MAP_READ));
+  fail_unless (info1.data == info2.data);
+  fail_unless (info2.size == 100);
+  fail_unless_equals_int (n_counting_maps, 1);
+
+  /* only the last unmap calls into the allocator */
+  gst_memory_unmap (mem, &info1);
+  fail_unless_equals_int (n_counting_unmaps, 0);
+  gst_memory_unmap (mem, &info2);
+  fail_unless_equals_int (n_counting_unmaps, 1);
+
+  /* write maps are not cached */
+  fail_unless (gst_memory_map (mem, &info1, GST_MAP_WRITE));
+  fail_unless (gst_memory_map (mem, &info2, GST_MAP_WRITE));
+  fail_unless_equals_int (n_counting_maps, 3);
+  gst_memory_unmap (mem, &info2);
+  gst_memory_unmap (mem, &info1);
+  fail_unless_equals_int (n_counting_unmaps, 3);
+
+  /* sequential maps map again */
+  fail_unless (gst_memory_map (mem, &info1, GST_MAP_READ));
+  gst_memory_unmap (mem, &info1);
+  fail_unless_equals_int (n_counting_maps, 4);
+  fail_unless_equals_int (n_counting_unmaps, 4);
+
+  /* without the flag every map calls into the allocator */
+  GST_OBJECT_FLAG_UNSET (alloc, GST_ALLOCATOR_FLAG_CACHE_READ_MAPS);
+  fail_unless (gst_memory_map (mem, &info1, GST_MAP_READ));
+  fail_unless (gst_memory_map (mem, &info2, GST_MAP_READ));
+  gst_memory_unmap (mem, &info2);
+  gst_memory_unmap (mem, &info1);
+  fail_unless_equals_int (n_counting_maps, 6);
+  fail_unless_equals_int (n_counting_unmaps, 6);
+
+  gst_memory_unref (mem);
+  gst_object_unref (alloc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_numa_allocator)
+{
+  GstAllocationParams params;
+  GstAllocator *alloc;
+  GstMemory *mem, *sub, *copy;
+  GstMapInfo info;
+  gsize offset;
+
+  alloc = gst_allocator_find (GST_ALLOCATOR_SYSMEM_NUMA);
+  if (alloc == NULL)
+    return;
+
+  /* small blocks come from the system memory allocator */
+  mem = gst_allocator_alloc (alloc, 100, NULL);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_SYSMEM));
+  gst_memory_unref (mem);
+
+  gst_allocation_params_init (&params);
+  params.prefix = 16;
+  params.padding = 16;
+  params.flags = GST_MEMORY_FLAG_ZERO_PREFIXED | GST_MEMORY_FLAG_ZERO_PADDED;
+
+  /* larger than the hugepage threshold */
+  mem = gst_allocator_alloc (alloc, 4 * 1024 * 1024, &params);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_SYSMEM_NUMA));
+  fail_unless (gst_memory_get_sizes (mem, &offset, NULL) == 4 * 1024 * 1024);
+  fail_unless (offset == 16);
+
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  fail_unless (info.data[-1] == 0);
+  fail_unless (info.data[info.size] == 0);
+  memset (info.data, 0xab, info.size);
+  gst_memory_unmap (mem, &info);
+
+  sub = gst_memory_share (mem, 1024, 1024);
+  fail_unless (sub != NULL);
+  fail_unless (gst_memory_map (sub, &info, GST_MAP_READ));
+  fail_unless (info.size == 1024);
+  fail_unless (info.data[0] == 0xab);
+  gst_memory_unmap (sub, &info);
+
+  copy = gst_memory_copy (sub, 0, -1);
+  fail_unless (copy != NULL);
+  fail_unless (gst_memory_get_sizes (copy, NULL, NULL) == 1024);
+  fail_unless (gst_memory_map (copy, &info, GST_MAP_READ));
+  fail_unless (info.data[1023] == 0xab);
+  gst_memory_unmap (copy, &info);
+
+  gst_memory_unref (copy);
+  gst_memory_unref (sub);
+  gst_memory_unref (mem);
+
+  gst_object_unref (alloc);
+}
+
+GST_END_TEST;
+
+#define N_CACHE_MEMORY 100
+
+GST_START_TEST (test_cache_stats)
+{
+  GstMemory *mems[N_CACHE_MEMORY];
+  guint64 hits, misses, hits_after, misses_after;
+  guint i, round;
+
+  gst_allocator_cache_get_stats (&hits, &misses, NULL);
+
+  for (round = 0; round < 2; round++) {
+    for (i = 0; i < N_CACHE_MEMORY; i++) {
+      mems[i] = gst_allocator_alloc (NULL, 200, NULL);
+      fail_unless (mems[i] != NULL);
+    }
+    for (i = 0; i < N_CACHE_MEMORY; i++)
+      gst_memory_unref (mems[i]);
+  }
+
+  gst_allocator_cache_get_stats (&hits_after, &misses_after, NULL);
+
+  /* the caches are disabled with G_SLICE=always-malloc */
+  if (hits_after + misses_after == hits + misses)
+    return;
+
+  /* the second round is served from the blocks freed by the first one */
+  fail_unless (hits_after - hits >= N_CACHE_MEMORY);
+  fail_unless (hits_after + misses_after >= hits + misses + 2 * N_CACHE_MEMORY);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_shm_allocator)
+{
+  GstAllocator *alloc;
+  GstMemory *mem, *sub, *copy, *imported;
+  GstMapInfo info;
+  gsize offset, maxsize, size;
+  gint fd;
+
+  alloc = gst_allocator_find (GST_ALLOCATOR_SHM);
+  if (alloc == NULL)
+    return;
+
+  mem = gst_allocator_alloc (alloc, 1000, NULL);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_SHM));
+  fd = gst_shm_memory_get_fd (mem);
+  fail_unless (fd >= 0);
+
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  memset (info.data, 0xab, info.size);
+  gst_memory_unmap (mem, &info);
+
+  /* shared memory keeps the fd of its parent */
+  sub = gst_memory_share (mem, 100, 200);
+  fail_unless (sub != NULL);
+  fail_unless_equals_int (gst_shm_memory_get_fd (sub), fd);
+
+  /* a copy is new shared memory */
+  copy = gst_memory_copy (sub, 0, -1);
+  fail_unless (copy != NULL);
+  fail_unless (gst_memory_is_type (copy, GST_ALLOCATOR_SHM));
+  fail_unless (gst_shm_memory_get_fd (copy) >= 0);
+  fail_unless (gst_shm_memory_get_fd (copy) != fd);
+  fail_unless (gst_memory_get_sizes (copy, NULL, NULL) == 200);
+  fail_unless (gst_memory_map (copy, &info, GST_MAP_READ));
+  fail_unless (info.data[199] == 0xab);
+  gst_memory_unmap (copy, &info);
+
+  /* importing the fd maps the same data read-only */
+  size = gst_memory_get_sizes (sub, &offset, &maxsize);
+  imported = gst_shm_memory_new_from_fd (dup (fd), maxsize, offset, size);
+  fail_unless (imported != NULL);
+  fail_unless (GST_MEMORY_IS_READONLY (imported));
+  fail_unless (gst_memory_map (imported, &info, GST_MAP_READ));
+  fail_unless (info.size == 200);
+  fail_unless (info.data[0] == 0xab);
+  gst_memory_unmap (imported, &info);
+  fail_if (gst_memory_map (imported, &info, GST_MAP_WRITE));
+
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  info.data[100] = 0x12;
+  gst_memory_unmap (mem, &info);
+  fail_unless (gst_memory_map (imported, &info, GST_MAP_READ));
+  fail_unless (info.data[0] == 0x12);
+  gst_memory_unmap (imported, &info);
+
+  /* the fd must be large enough */
+  fail_unless (gst_shm_memory_new_from_fd (dup (fd), maxsize * 2, 0,
+          maxsize) == NULL);
+
+  gst_memory_unref (imported);
+  gst_memory_unref (copy);
+  gst_memory_unref (sub);
+  gst_memory_unref (mem);
+
+  gst_object_unref (alloc);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_file_memory)
+{
+  GstAllocator *alloc;
+  GstMemory *mem, *sub1, *sub2, *span, *big;
+  GstMapInfo info;
+  guint8 data[3 * 4096 + 100];
+  gchar *filename;
+  guint64 offset;
+  gsize span_offset;
+  gint fd, i;
+
+  alloc = gst_allocator_find (GST_ALLOCATOR_FILE);
+  if (alloc == NULL)
+    return;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i % 251;
+
+  fd = g_file_open_tmp ("gstreamer-memory-test-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  fail_unless (write (fd, data, sizeof (data)) == sizeof (data));
+
+  /* the offset doesn't have to be page aligned */
+  mem = gst_file_memory_new (fd, 100, 5000);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_FILE));
+  fail_unless (GST_MEMORY_IS_READONLY (mem));
+  fail_unless (gst_memory_get_sizes (mem, NULL, NULL) == 5000);
+  fail_unless (gst_file_memory_get_fd (mem, &offset) >= 0);
+  fail_unless (gst_file_memory_get_fd (mem, NULL) != fd);
+  fail_unless_equals_uint64 (offset, 100);
+
+  /* the memory keeps its own fd */
+  close (fd);
+
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_READ));
+  fail_unless_equals_int (info.size, 5000);
+  fail_unless (memcmp (info.data, data + 100, 5000) == 0);
+  gst_memory_unmap (mem, &info);
+  fail_if (gst_memory_map (mem, &info, GST_MAP_WRITE));
+
+  /* shared memory maps its own part of the file */
+  sub1 = gst_memory_share (mem, 0, 4000);
+  sub2 = gst_memory_share (mem, 4000, 1000);
+  fail_unless (gst_file_memory_get_fd (sub2, &offset) ==
+      gst_file_memory_get_fd (mem, NULL));
+  fail_unless_equals_uint64 (offset, 4100);
+  fail_unless (gst_memory_map (sub2, &info, GST_MAP_READ));
+  fail_unless_equals_int (info.size, 1000);
+  fail_unless (memcmp (info.data, data + 4100, 1000) == 0);
+  gst_memory_unmap (sub2, &info);
+
+  fail_unless (gst_memory_is_span (sub1, sub2, &span_offset));
+  fail_unless_equals_int (span_offset, 0);
+  fail_if (gst_memory_is_span (sub2, sub1, NULL));
+  span = gst_memory_share (mem, span_offset, 5000);
+  fail_unless (gst_memory_map (span, &info, GST_MAP_READ));
+  fail_unless (memcmp (info.data, data + 100, 5000) == 0);
+  gst_memory_unmap (span, &info);
+
+  /* a range beyond the end of the file can't be mapped */
+  big = gst_file_memory_new (gst_file_memory_get_fd (mem, NULL), 0,
+      2 * sizeof (data));
+  fail_unless (big != NULL);
+  fail_if (gst_memory_map (big, &info, GST_MAP_READ));
+  gst_memory_unref (big);
+
+  /* memory of the file allocator can't be allocated */
+  fail_unless (gst_allocator_alloc (alloc, 100, NULL) == NULL);
+
+  gst_memory_unref (span);
+  gst_memory_unref (sub2);
+  gst_memory_unref (sub1);
+  gst_memory_unref (mem);
+
+  g_remove (filename);
+  g_free (filename);
+  gst_object_unref (alloc);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_memory_suite (void)
 {
@@ -757,6 +1124,11 @@ gst_memory_suite (void)
   tcase_add_test (tc_chain, test_map_resize);
   tcase_add_test (tc_chain, test_alloc_params);
   tcase_add_test (tc_chain, test_lock);
+  tcase_add_test (tc_chain, test_map_cache);
+  tcase_add_test (tc_chain, test_numa_allocator);
+  tcase_add_test (tc_chain, test_shm_allocator);
+  tcase_add_test (tc_chain, test_file_memory);
+  tcase_add_test (tc_chain, test_cache_stats);
 #ifndef GST_DISABLE_GST_DEBUG
   tcase_add_test (tc_chain, test_no_error_and_no_warning_on_map_failure);
 #endif
@@ -797,6 +797,121 @@ GST_START_TEST (test_meta_custom_transform)
 
 GST_END_TEST;
 
+GST_START_TEST (test_meta_get_by_api)
+{
+  GstBuffer *buffer;
+  GstMetaTest *test1, *test2;
+  GstMetaFoo *foo;
+  gpointer state = NULL;
+
+  buffer = gst_buffer_new_and_alloc (4);
+  fail_unless (GST_META_TEST_GET (buffer) == NULL);
+  fail_unless (GST_META_FOO_GET (buffer) == NULL);
+  fail_unless_equals_int (gst_buffer_get_n_meta (buffer,
+          GST_META_TEST_API_TYPE), 0);
+
+  test1 = GST_META_TEST_ADD (buffer);
+  fail_unless (GST_META_TEST_GET (buffer) == test1);
+  fail_unless (GST_META_FOO_GET (buffer) == NULL);
+
+  foo = GST_META_FOO_ADD (buffer);
+  test2 = GST_META_TEST_ADD (buffer);
+  fail_unless (GST_META_FOO_GET (buffer) == foo);
+  fail_unless_equals_int (gst_buffer_get_n_meta (buffer,
+          GST_META_TEST_API_TYPE), 2);
+
+  /* the second meta of the same API is still found */
+  fail_unless (gst_buffer_remove_meta (buffer, (GstMeta *) test1));
+  fail_unless (GST_META_TEST_GET (buffer) == test2);
+
+  fail_unless (gst_buffer_remove_meta (buffer, (GstMeta *) test2));
+  fail_unless (GST_META_TEST_GET (buffer) == NULL);
+  fail_unless (gst_buffer_iterate_meta_filtered (buffer, &state,
+          GST_META_TEST_API_TYPE) == NULL);
+  fail_unless (GST_META_FOO_GET (buffer) == foo);
+
+  /* and so are metas removed from foreach */
+  gst_buffer_foreach_meta (buffer, foreach_meta_remove_one, foo);
+  fail_unless (GST_META_FOO_GET (buffer) == NULL);
+  fail_unless_equals_int (count_buffer_meta (buffer), 0);
+
+  gst_buffer_unref (buffer);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_meta_storage_reuse)
+{
+  GstBuffer *buffer, *copy;
+  GstMeta *metas[4];
+  guint i;
+
+  buffer = gst_buffer_new_and_alloc (4);
+
+  /* metas can be removed and added again in any order, no matter if they
+   * are stored inside the buffer or not */
+  for (i = 0; i < 4; i++)
+    metas[i] = (GstMeta *) GST_META_FOO_ADD (buffer);
+  fail_unless (gst_buffer_remove_meta (buffer, metas[0]));
+  fail_unless (gst_buffer_remove_meta (buffer, metas[2]));
+  fail_unless_equals_int (count_buffer_meta (buffer), 2);
+
+  metas[0] = (GstMeta *) GST_META_FOO_ADD (buffer);
+  metas[2] = (GstMeta *) GST_META_TEST_ADD (buffer);
+  fail_unless_equals_int (count_buffer_meta (buffer), 4);
+  fail_unless (GST_META_TEST_GET (buffer) == (GstMetaTest *) metas[2]);
+
+  copy = gst_buffer_copy (buffer);
+  fail_unless_equals_int (count_buffer_meta (copy), 4);
+  fail_unless (GST_META_TEST_GET (copy) != NULL);
+  fail_unless (GST_META_TEST_GET (copy) != GST_META_TEST_GET (buffer));
+  gst_buffer_unref (buffer);
+
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_buffer_remove_meta (copy,
+            (GstMeta *) GST_META_FOO_GET (copy)));
+  fail_unless_equals_int (count_buffer_meta (copy), 1);
+  gst_buffer_unref (copy);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_meta_copy_memory_tag)
+{
+  GstBuffer *buffer, *copy;
+  const gchar *tags[] = { GST_META_TAG_MEMORY_STR, NULL };
+
+  fail_unless (gst_meta_register_custom ("test-memory", tags, NULL, NULL,
+          NULL) != NULL);
+
+  buffer = gst_buffer_new_and_alloc (4);
+  fail_unless (gst_buffer_add_custom_meta (buffer, "test-memory") != NULL);
+  fail_unless (GST_META_FOO_ADD (buffer) != NULL);
+
+  /* a full copy keeps the memory meta */
+  copy = gst_buffer_copy (buffer);
+  fail_unless (gst_buffer_get_custom_meta (copy, "test-memory") != NULL);
+  fail_unless (GST_META_FOO_GET (copy) != NULL);
+  gst_buffer_unref (copy);
+
+  /* a region or metadata only copy doesn't */
+  copy = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL, 1, 2);
+  fail_unless (gst_buffer_get_custom_meta (copy, "test-memory") == NULL);
+  fail_unless (GST_META_FOO_GET (copy) != NULL);
+  gst_buffer_unref (copy);
+
+  copy = gst_buffer_new ();
+  fail_unless (gst_buffer_copy_into (copy, buffer, GST_BUFFER_COPY_METADATA,
+          0, -1));
+  fail_unless (gst_buffer_get_custom_meta (copy, "test-memory") == NULL);
+  fail_unless (GST_META_FOO_GET (copy) != NULL);
+  gst_buffer_unref (copy);
+
+  gst_buffer_unref (buffer);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffermeta_suite (void)
 {
@@ -816,6 +931,9 @@ gst_buffermeta_suite (void)
   tcase_add_test (tc_chain, test_meta_seqnum);
   tcase_add_test (tc_chain, test_meta_custom);
   tcase_add_test (tc_chain, test_meta_custom_transform);
+  tcase_add_test (tc_chain, test_meta_get_by_api);
+  tcase_add_test (tc_chain, test_meta_storage_reuse);
+  tcase_add_test (tc_chain, test_meta_copy_memory_tag);
 
   return s;
 }
@@ -182,6 +182,65 @@ GST_START_TEST (test_unref_threaded)
 
 GST_END_TEST;
 
+static gint qdata_thread_id;
+
+/* every thread sets, gets and steals its own qdata and adds itself as a
+ * parent of the shared object */
+static void
+thread_qdata (GstMiniObject * mobj)
+{
+  GstMiniObject *parent;
+  GQuark quark;
+  gchar *name;
+  int j;
+
+  THREAD_START ();
+
+  name = g_strdup_printf ("test-qdata-%d",
+      g_atomic_int_add (&qdata_thread_id, 1));
+  quark = g_quark_from_string (name);
+  parent = GST_MINI_OBJECT_CAST (gst_buffer_new ());
+
+  for (j = 0; j < refs_per_thread; ++j) {
+    gst_mini_object_set_qdata (mobj, quark, GINT_TO_POINTER (j + 1), NULL);
+    fail_unless (gst_mini_object_get_qdata (mobj,
+            quark) == GINT_TO_POINTER (j + 1));
+    gst_mini_object_add_parent (mobj, parent);
+    if (j % 2)
+      gst_mini_object_set_qdata (mobj, quark, NULL, NULL);
+    else
+      fail_unless (gst_mini_object_steal_qdata (mobj,
+              quark) == GINT_TO_POINTER (j + 1));
+    fail_unless (gst_mini_object_get_qdata (mobj, quark) == NULL);
+    gst_mini_object_remove_parent (mobj, parent);
+
+    if (j % num_threads == 0)
+      THREAD_SWITCH ();
+  }
+
+  gst_mini_object_unref (parent);
+  g_free (name);
+}
+
+GST_START_TEST (test_qdata_threaded)
+{
+  GstBuffer *buffer;
+  GstMiniObject *mobj;
+
+  buffer = gst_buffer_new_and_alloc (4);
+  mobj = GST_MINI_OBJECT_CAST (buffer);
+
+  qdata_thread_id = 0;
+  MAIN_START_THREADS (num_threads, thread_qdata, mobj);
+
+  MAIN_STOP_THREADS ();
+
+  fail_unless (gst_mini_object_is_writable (mobj));
+  gst_buffer_unref (buffer);
+}
+
+GST_END_TEST;
+
 /* ======== weak ref test ======== */
 
 static gboolean weak_ref_notify_succeeded = FALSE;
@@ -460,6 +519,90 @@ GST_START_TEST (test_dup_null_mini_object)
 
 GST_END_TEST;
 
+static GstStaticCaps immortal_caps = GST_STATIC_CAPS ("audio/x-immortal");
+
+GST_START_TEST (test_immortal)
+{
+  GstCaps *caps, *copy;
+  gint refcount, i;
+
+  caps = gst_caps_new_empty_simple ("video/x-immortal");
+  gst_mini_object_make_immortal (GST_MINI_OBJECT_CAST (caps));
+  fail_unless (GST_MINI_OBJECT_FLAG_IS_SET (caps,
+          GST_MINI_OBJECT_FLAG_IMMORTAL));
+
+  refcount = GST_CAPS_REFCOUNT_VALUE (caps);
+  for (i = 0; i < 10; i++)
+    gst_caps_ref (caps);
+  for (i = 0; i < 20; i++)
+    gst_caps_unref (caps);
+  fail_unless_equals_int (GST_CAPS_REFCOUNT_VALUE (caps), refcount);
+
+  /* never writable, making it writable copies */
+  fail_if (gst_caps_is_writable (caps));
+  copy = gst_caps_make_writable (caps);
+  fail_unless (copy != caps);
+  fail_if (GST_MINI_OBJECT_FLAG_IS_SET (copy, GST_MINI_OBJECT_FLAG_IMMORTAL));
+  fail_unless (gst_caps_is_writable (copy));
+  gst_caps_unref (copy);
+
+  /* caps of static caps are immortal */
+  caps = gst_static_caps_get (&immortal_caps);
+  fail_unless (GST_MINI_OBJECT_FLAG_IS_SET (caps,
+          GST_MINI_OBJECT_FLAG_IMMORTAL));
+  fail_unless (gst_static_caps_get (&immortal_caps) == caps);
+  gst_caps_unref (caps);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+static void
+ref_n_weak_notify (gpointer data, GstMiniObject * where_the_object_was)
+{
+  *(gboolean *) data = TRUE;
+}
+
+GST_START_TEST (test_ref_n)
+{
+  GstBuffer *buffer;
+  GstCaps *caps;
+  gboolean freed = FALSE;
+  gint refcount;
+
+  buffer = gst_buffer_new ();
+  gst_mini_object_weak_ref (GST_MINI_OBJECT_CAST (buffer), ref_n_weak_notify,
+      &freed);
+
+  fail_unless (gst_mini_object_ref_n (GST_MINI_OBJECT_CAST (buffer), 5) ==
+      GST_MINI_OBJECT_CAST (buffer));
+  ASSERT_MINI_OBJECT_REFCOUNT (buffer, "buffer", 6);
+  fail_if (gst_buffer_is_writable (buffer));
+
+  /* adding or dropping no reference does nothing */
+  gst_mini_object_ref_n (GST_MINI_OBJECT_CAST (buffer), 0);
+  gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (buffer), 0);
+  ASSERT_MINI_OBJECT_REFCOUNT (buffer, "buffer", 6);
+
+  gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (buffer), 4);
+  ASSERT_MINI_OBJECT_REFCOUNT (buffer, "buffer", 2);
+  fail_if (freed);
+
+  /* dropping the last references frees the object */
+  gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (buffer), 2);
+  fail_unless (freed);
+
+  /* immortal objects keep their refcount */
+  caps = gst_caps_new_empty_simple ("video/x-immortal");
+  gst_mini_object_make_immortal (GST_MINI_OBJECT_CAST (caps));
+  refcount = GST_CAPS_REFCOUNT_VALUE (caps);
+  gst_mini_object_ref_n (GST_MINI_OBJECT_CAST (caps), 10);
+  gst_mini_object_unref_n (GST_MINI_OBJECT_CAST (caps), 20);
+  fail_unless_equals_int (GST_CAPS_REFCOUNT_VALUE (caps), refcount);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_mini_object_suite (void)
 {
@@ -475,10 +618,13 @@ gst_mini_object_suite (void)
   tcase_add_test (tc_chain, test_make_writable);
   tcase_add_test (tc_chain, test_ref_threaded);
   tcase_add_test (tc_chain, test_unref_threaded);
+  tcase_add_test (tc_chain, test_qdata_threaded);
   tcase_add_test (tc_chain, test_weak_ref);
   //tcase_add_test (tc_chain, test_recycle_threaded);
   tcase_add_test (tc_chain, test_value_collection);
   tcase_add_test (tc_chain, test_dup_null_mini_object);
+  tcase_add_test (tc_chain, test_immortal);
+  tcase_add_test (tc_chain, test_ref_n);
   return s;
 }
 
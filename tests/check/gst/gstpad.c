@@ -2165,6 +2165,64 @@ GST_START_TEST (test_pad_probe_call_order)
 
 GST_END_TEST;
 
+static GstPadProbeReturn
+count_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  (*(guint *) user_data)++;
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_pad_probe_mask_update)
+{
+  GstPad *src, *sink;
+  guint event_count = 0, buffer_count = 0;
+  gulong id;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_set_active (src, TRUE);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, gst_check_chain_func);
+  gst_pad_set_active (sink, TRUE);
+
+  fail_unless_equals_int (gst_pad_link (src, sink), GST_PAD_LINK_OK);
+
+  /* an event-only probe must not see any buffers */
+  gst_pad_add_probe (src, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      count_probe_cb, &event_count, NULL);
+
+  fail_unless (gst_pad_push_event (src,
+          gst_event_new_stream_start ("test")) == TRUE);
+  fail_unless (gst_pad_push_event (src,
+          gst_event_new_segment (&dummy_segment)) == TRUE);
+  fail_unless_equals_int (event_count, 2);
+
+  fail_unless_equals_int (gst_pad_push (src, gst_buffer_new ()), GST_FLOW_OK);
+  fail_unless_equals_int (event_count, 2);
+
+  /* a buffer probe added later is called */
+  id = gst_pad_add_probe (src, GST_PAD_PROBE_TYPE_BUFFER,
+      count_probe_cb, &buffer_count, NULL);
+  fail_unless_equals_int (gst_pad_push (src, gst_buffer_new ()), GST_FLOW_OK);
+  fail_unless_equals_int (buffer_count, 1);
+  fail_unless_equals_int (event_count, 2);
+
+  /* and not called anymore after removal */
+  gst_pad_remove_probe (src, id);
+  fail_unless_equals_int (gst_pad_push (src, gst_buffer_new ()), GST_FLOW_OK);
+  fail_unless_equals_int (buffer_count, 1);
+
+  /* the event probe is still installed */
+  fail_unless (gst_pad_push_event (src, gst_event_new_eos ()) == TRUE);
+  fail_unless_equals_int (event_count, 3);
+
+  gst_check_drop_buffers ();
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
 static GstPadProbeReturn
 buffers_probe_handled (GstPad * pad, GstPadProbeInfo * info, gpointer gp)
 {
@@ -2676,6 +2734,220 @@ GST_START_TEST (test_sticky_events)
 
 GST_END_TEST;
 
+static GstEvent *
+new_custom_sticky (const gchar * name, gint value)
+{
+  return gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM_STICKY,
+      gst_structure_new (name, "value", G_TYPE_INT, value, NULL));
+}
+
+static gint
+get_custom_sticky (GstPad * pad, guint idx)
+{
+  GstEvent *event;
+  gint value = -1;
+
+  event = gst_pad_get_sticky_event (pad,
+      GST_EVENT_CUSTOM_DOWNSTREAM_STICKY, idx);
+  if (event) {
+    gst_structure_get_int (gst_event_get_structure (event), "value", &value);
+    gst_event_unref (event);
+  }
+  return value;
+}
+
+GST_START_TEST (test_sticky_events_lookup)
+{
+  GstPad *srcpad;
+  GstSegment seg;
+  GstEvent *event;
+  GstTagList *tags;
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_set_active (srcpad, TRUE);
+
+  fail_unless (gst_pad_get_sticky_event (srcpad, GST_EVENT_CAPS, 0) == NULL);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  gst_segment_init (&seg, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&seg)));
+
+  /* sticky multi events are stored once per name */
+  gst_pad_push_event (srcpad, new_custom_sticky ("a", 1));
+  gst_pad_push_event (srcpad, new_custom_sticky ("b", 2));
+  gst_pad_push_event (srcpad, new_custom_sticky ("a", 3));
+  fail_unless_equals_int (get_custom_sticky (srcpad, 0), 3);
+  fail_unless_equals_int (get_custom_sticky (srcpad, 1), 2);
+  fail_unless_equals_int (get_custom_sticky (srcpad, 2), -1);
+
+  tags = gst_tag_list_new (GST_TAG_TITLE, "title", NULL);
+  gst_pad_push_event (srcpad, gst_event_new_tag (tags));
+  fail_unless (gst_pad_get_sticky_event (srcpad, GST_EVENT_TAG, 0) != NULL);
+  gst_event_unref (gst_pad_get_sticky_event (srcpad, GST_EVENT_TAG, 0));
+
+  /* a new stream removes the tags but keeps the other events */
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test2")));
+  fail_unless (gst_pad_get_sticky_event (srcpad, GST_EVENT_TAG, 0) == NULL);
+  fail_unless_equals_int (get_custom_sticky (srcpad, 0), 3);
+  event = gst_pad_get_sticky_event (srcpad, GST_EVENT_SEGMENT, 0);
+  fail_unless (event != NULL);
+  gst_event_unref (event);
+
+  gst_pad_set_active (srcpad, FALSE);
+  fail_unless (gst_pad_get_sticky_event (srcpad, GST_EVENT_SEGMENT,
+          0) == NULL);
+  gst_object_unref (srcpad);
+}
+
+GST_END_TEST;
+
+static gint caps_event_count;
+
+static gboolean
+test_interned_caps_handler (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS)
+    caps_event_count++;
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+GST_START_TEST (test_sticky_interned_caps)
+{
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_event_function (sinkpad, test_interned_caps_handler);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+  caps_event_count = 0;
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+
+  /* identical interned caps are only sent once */
+  caps = gst_caps_intern (gst_caps_new_empty_simple ("foo/bar"));
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+  caps = gst_caps_intern (gst_caps_new_empty_simple ("foo/bar"));
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+  fail_unless_equals_int (caps_event_count, 1);
+
+  /* other caps are sent as before */
+  caps = gst_caps_new_empty_simple ("foo/bar");
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_caps (caps)));
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_caps (caps)));
+  gst_caps_unref (caps);
+  fail_unless_equals_int (caps_event_count, 3);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+}
+
+GST_END_TEST;
+
+static gint caps_query_count;
+
+static gboolean
+test_cache_caps_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CAPS ||
+      GST_QUERY_TYPE (query) == GST_QUERY_ACCEPT_CAPS)
+    caps_query_count++;
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+GST_START_TEST (test_cache_caps)
+{
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps, *filter, *result;
+  GstPadTemplate *tmpl;
+
+  caps = gst_caps_from_string ("foo/bar, width=(int)[ 1, 10 ]");
+  tmpl = gst_pad_template_new ("sink", GST_PAD_SINK, GST_PAD_ALWAYS, caps);
+  gst_caps_unref (caps);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  GST_PAD_SET_CACHE_CAPS (srcpad);
+  sinkpad = gst_pad_new_from_template (tmpl, "sink");
+  gst_object_unref (tmpl);
+  /* don't let accept-caps do a caps query internally */
+  GST_PAD_SET_ACCEPT_TEMPLATE (sinkpad);
+  gst_pad_set_query_function (sinkpad, test_cache_caps_query);
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+  caps_query_count = 0;
+
+  /* identical accept-caps queries are only done once */
+  caps = gst_caps_from_string ("foo/bar, width=(int)5");
+  fail_unless (gst_pad_peer_query_accept_caps (srcpad, caps));
+  fail_unless_equals_int (caps_query_count, 1);
+  gst_caps_unref (caps);
+  caps = gst_caps_from_string ("foo/bar, width=(int)5");
+  fail_unless (gst_pad_peer_query_accept_caps (srcpad, caps));
+  fail_unless_equals_int (caps_query_count, 1);
+  gst_caps_unref (caps);
+
+  /* different caps are queried again */
+  caps = gst_caps_from_string ("foo/bar, width=(int)20");
+  fail_if (gst_pad_peer_query_accept_caps (srcpad, caps));
+  fail_if (gst_pad_peer_query_accept_caps (srcpad, caps));
+  fail_unless_equals_int (caps_query_count, 2);
+  gst_caps_unref (caps);
+
+  /* same for caps queries, with and without filter */
+  result = gst_pad_peer_query_caps (srcpad, NULL);
+  gst_caps_unref (result);
+  result = gst_pad_peer_query_caps (srcpad, NULL);
+  fail_unless_equals_int (caps_query_count, 3);
+  caps = gst_caps_from_string ("foo/bar, width=(int)[ 1, 10 ]");
+  fail_unless (gst_caps_is_equal (result, caps));
+  gst_caps_unref (caps);
+  gst_caps_unref (result);
+
+  filter = gst_caps_from_string ("foo/bar, width=(int)[ 5, 20 ]");
+  result = gst_pad_peer_query_caps (srcpad, filter);
+  gst_caps_unref (result);
+  result = gst_pad_peer_query_caps (srcpad, filter);
+  fail_unless_equals_int (caps_query_count, 4);
+  caps = gst_caps_from_string ("foo/bar, width=(int)[ 5, 10 ]");
+  fail_unless (gst_caps_is_equal (result, caps));
+  gst_caps_unref (caps);
+  gst_caps_unref (result);
+
+  /* a reconfigure event invalidates the cache */
+  gst_pad_send_event (srcpad, gst_event_new_reconfigure ());
+  result = gst_pad_peer_query_caps (srcpad, filter);
+  gst_caps_unref (result);
+  fail_unless_equals_int (caps_query_count, 5);
+
+  /* and so does relinking */
+  fail_unless (gst_pad_unlink (srcpad, sinkpad));
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+  result = gst_pad_peer_query_caps (srcpad, filter);
+  gst_caps_unref (result);
+  fail_unless_equals_int (caps_query_count, 6);
+
+  /* without the flag all queries reach the peer */
+  GST_PAD_UNSET_CACHE_CAPS (srcpad);
+  result = gst_pad_peer_query_caps (srcpad, filter);
+  gst_caps_unref (result);
+  fail_unless_equals_int (caps_query_count, 7);
+  gst_caps_unref (filter);
+
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+}
+
+GST_END_TEST;
+
 static GstFlowReturn next_return;
 
 static GstFlowReturn
@@ -3418,6 +3690,7 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_pad_probe_flush_events);
   tcase_add_test (tc_chain, test_pad_probe_flush_events_only);
   tcase_add_test (tc_chain, test_pad_probe_call_order);
+  tcase_add_test (tc_chain, test_pad_probe_mask_update);
   tcase_add_test (tc_chain, test_pad_probe_handled_and_drop);
   tcase_add_test (tc_chain, test_events_query_unlinked);
   tcase_add_test (tc_chain, test_queue_src_caps_notify_linked);
@@ -3429,6 +3702,9 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_block_async_full_destroy_dispose);
   tcase_add_test (tc_chain, test_block_async_replace_callback_no_flush);
   tcase_add_test (tc_chain, test_sticky_events);
+  tcase_add_test (tc_chain, test_sticky_events_lookup);
+  tcase_add_test (tc_chain, test_sticky_interned_caps);
+  tcase_add_test (tc_chain, test_cache_caps);
   tcase_add_test (tc_chain, test_last_flow_return_push);
   tcase_add_test (tc_chain, test_last_flow_return_pull);
   tcase_add_test (tc_chain, test_flush_stop_inactive);
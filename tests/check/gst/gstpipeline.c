@@ -738,6 +738,143 @@ GST_START_TEST (test_pipeline_processing_deadline_no_queue)
 GST_END_TEST;
 
 
+/* a sink without pads counting the duration and position queries */
+typedef struct
+{
+  GstElement parent;
+
+  guint queries;
+  gint64 position;
+} GstQueryCounter;
+
+typedef struct
+{
+  GstElementClass parent_class;
+} GstQueryCounterClass;
+
+static GType gst_query_counter_get_type (void);
+G_DEFINE_TYPE (GstQueryCounter, gst_query_counter, GST_TYPE_ELEMENT);
+
+static gboolean
+gst_query_counter_query (GstElement * element, GstQuery * query)
+{
+  GstQueryCounter *counter = (GstQueryCounter *) element;
+  GstFormat format;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_DURATION:
+      counter->queries++;
+      gst_query_parse_duration (query, &format, NULL);
+      if (format != GST_FORMAT_TIME)
+        return FALSE;
+      gst_query_set_duration (query, GST_FORMAT_TIME, 10 * GST_SECOND);
+      return TRUE;
+    case GST_QUERY_POSITION:
+      counter->queries++;
+      gst_query_parse_position (query, &format, NULL);
+      if (format != GST_FORMAT_TIME)
+        return FALSE;
+      gst_query_set_position (query, GST_FORMAT_TIME, counter->position);
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static void
+gst_query_counter_class_init (GstQueryCounterClass * klass)
+{
+  GST_ELEMENT_CLASS (klass)->query = gst_query_counter_query;
+}
+
+static void
+gst_query_counter_init (GstQueryCounter * counter)
+{
+  GST_OBJECT_FLAG_SET (counter, GST_ELEMENT_FLAG_SINK);
+  counter->position = GST_SECOND;
+}
+
+GST_START_TEST (test_pipeline_query_cache)
+{
+  GstElement *pipeline;
+  GstQueryCounter *counter;
+  GstClock *clock;
+  gint64 value;
+
+  clock = gst_test_clock_new ();
+  pipeline = gst_pipeline_new ("pipeline");
+  gst_pipeline_use_clock (GST_PIPELINE (pipeline), clock);
+  counter = g_object_new (gst_query_counter_get_type (), NULL);
+  gst_bin_add (GST_BIN (pipeline), GST_ELEMENT (counter));
+
+  /* disabled by default */
+  fail_unless (gst_element_query_duration (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless (gst_element_query_duration (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int (counter->queries, 2);
+
+  g_object_set (pipeline, "query-cache-time", 60 * GST_SECOND, NULL);
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  counter->queries = 0;
+  fail_unless (gst_element_query_duration (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 10 * GST_SECOND);
+  fail_unless (gst_element_query_duration (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 10 * GST_SECOND);
+  fail_unless_equals_int (counter->queries, 1);
+
+  /* the cached position advances with the clock */
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, GST_SECOND);
+  fail_unless_equals_int (counter->queries, 2);
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 100 * GST_MSECOND);
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, GST_SECOND + 100 * GST_MSECOND);
+  fail_unless_equals_int (counter->queries, 2);
+
+  /* a duration change only drops the cached duration */
+  gst_element_post_message (GST_ELEMENT (counter),
+      gst_message_new_duration_changed (GST_OBJECT (counter)));
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int (counter->queries, 2);
+  fail_unless (gst_element_query_duration (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int (counter->queries, 3);
+
+  /* a seek drops the cached position and sets the rate */
+  counter->position = 5 * GST_SECOND;
+  gst_element_send_event (pipeline, gst_event_new_seek (2.0, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, 5 * GST_SECOND,
+          GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE));
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 5 * GST_SECOND);
+  fail_unless_equals_int (counter->queries, 4);
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 100 * GST_MSECOND);
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 5 * GST_SECOND + 200 * GST_MSECOND);
+  fail_unless_equals_int (counter->queries, 4);
+
+  /* the position doesn't advance anymore in PAUSED */
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 5 * GST_SECOND);
+  fail_unless_equals_int (counter->queries, 5);
+  gst_test_clock_advance_time (GST_TEST_CLOCK (clock), 100 * GST_MSECOND);
+  fail_unless (gst_element_query_position (pipeline, GST_FORMAT_TIME, &value));
+  fail_unless_equals_int64 (value, 5 * GST_SECOND);
+  fail_unless_equals_int (counter->queries, 5);
+
+  /* other formats are never cached */
+  fail_if (gst_element_query_position (pipeline, GST_FORMAT_BYTES, &value));
+  fail_unless_equals_int (counter->queries, 6);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_pipeline_suite (void)
 {
@@ -758,6 +895,7 @@ gst_pipeline_suite (void)
   tcase_add_test (tc_chain, test_pipeline_reset_start_time);
   tcase_add_test (tc_chain, test_pipeline_processing_deadline);
   tcase_add_test (tc_chain, test_pipeline_processing_deadline_no_queue);
+  tcase_add_test (tc_chain, test_pipeline_query_cache);
 
   return s;
 }
@@ -29,6 +29,7 @@
 #include <winsock2.h>
 #include <fcntl.h>
 #else
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #endif
@@ -321,6 +322,138 @@ GST_START_TEST (test_poll_controllable)
 
 GST_END_TEST;
 
+#define N_CONTROL_THREADS 4
+#define N_CONTROLS 10000
+
+static gpointer
+write_control_thread (GstPoll * set)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTROLS; i++)
+    fail_unless (gst_poll_write_control (set));
+
+  return NULL;
+}
+
+static gpointer
+read_control_thread (GstPoll * set)
+{
+  guint i;
+
+  for (i = 0; i < N_CONTROLS; i++) {
+    while (!gst_poll_read_control (set)) {
+      fail_unless (errno == EWOULDBLOCK || errno == EAGAIN);
+      g_thread_yield ();
+    }
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_poll_control_threads)
+{
+  GThread *threads[2 * N_CONTROL_THREADS];
+  GstPoll *set;
+  guint i;
+
+  set = gst_poll_new_timer ();
+  fail_if (set == NULL, "Failed to create a GstPoll");
+
+  /* the control is readable exactly while writes are pending */
+  fail_unless (gst_poll_write_control (set));
+  fail_unless (gst_poll_write_control (set));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 1);
+  fail_unless (gst_poll_read_control (set));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 1);
+  fail_unless (gst_poll_read_control (set));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+  fail_if (gst_poll_read_control (set));
+
+  for (i = 0; i < N_CONTROL_THREADS; i++) {
+    threads[i] = g_thread_new ("write", (GThreadFunc) write_control_thread,
+        set);
+    threads[N_CONTROL_THREADS + i] =
+        g_thread_new ("read", (GThreadFunc) read_control_thread, set);
+  }
+  for (i = 0; i < 2 * N_CONTROL_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+  fail_if (gst_poll_read_control (set));
+
+  gst_poll_free (set);
+}
+
+GST_END_TEST;
+
+#define N_PAIRS 64
+
+GST_START_TEST (test_poll_many_fds)
+{
+  GstPoll *set;
+  GstPollFD rfds[N_PAIRS], null_fd = GST_POLL_FD_INIT;
+  gint socks[N_PAIRS][2];
+  guchar c = 'A';
+  guint i;
+
+  /* enough fds to switch to an epoll based wait where available */
+  set = gst_poll_new (TRUE);
+  fail_if (set == NULL, "Failed to create a GstPoll");
+
+  for (i = 0; i < N_PAIRS; i++) {
+    fail_if (socketpair (PF_UNIX, SOCK_STREAM, 0, socks[i]) < 0,
+        "Could not create a pipe");
+    gst_poll_fd_init (&rfds[i]);
+    rfds[i].fd = socks[i][0];
+    fail_unless (gst_poll_add_fd (set, &rfds[i]));
+    fail_unless (gst_poll_fd_ctl_read (set, &rfds[i], TRUE));
+  }
+
+  fail_unless_equals_int (gst_poll_wait (set, 10 * GST_MSECOND), 0);
+
+  fail_unless (write (socks[3][1], &c, 1) == 1, "write() failed");
+  fail_unless (write (socks[N_PAIRS - 1][1], &c, 1) == 1, "write() failed");
+  fail_unless_equals_int (gst_poll_wait (set, GST_CLOCK_TIME_NONE), 2);
+  for (i = 0; i < N_PAIRS; i++)
+    fail_unless_equals_int (gst_poll_fd_can_read (set, &rfds[i]),
+        i == 3 || i == N_PAIRS - 1);
+
+  /* removing moves the last fd to the removed index */
+  fail_unless (read (socks[3][0], &c, 1) == 1, "read() failed");
+  fail_unless (gst_poll_remove_fd (set, &rfds[3]));
+  fail_unless_equals_int (gst_poll_wait (set, GST_CLOCK_TIME_NONE), 1);
+  fail_unless (gst_poll_fd_can_read (set, &rfds[N_PAIRS - 1]));
+  fail_unless (read (socks[N_PAIRS - 1][0], &c, 1) == 1, "read() failed");
+
+  fail_unless (write (socks[N_PAIRS - 1][1], &c, 1) == 1, "write() failed");
+  fail_unless (gst_poll_fd_ctl_read (set, &rfds[N_PAIRS - 1], FALSE));
+  fail_unless_equals_int (gst_poll_wait (set, 10 * GST_MSECOND), 0);
+  fail_unless (gst_poll_fd_ctl_read (set, &rfds[N_PAIRS - 1], TRUE));
+  fail_unless_equals_int (gst_poll_wait (set, GST_CLOCK_TIME_NONE), 1);
+  fail_unless (read (socks[N_PAIRS - 1][0], &c, 1) == 1, "read() failed");
+
+  /* fds that can't be used with epoll still work */
+  null_fd.fd = open ("/dev/null", O_RDONLY);
+  fail_if (null_fd.fd < 0);
+  fail_unless (gst_poll_add_fd (set, &null_fd));
+  fail_unless (gst_poll_fd_ctl_read (set, &null_fd, TRUE));
+  fail_unless_equals_int (gst_poll_wait (set, GST_CLOCK_TIME_NONE), 1);
+  fail_unless (gst_poll_fd_can_read (set, &null_fd));
+  fail_unless (write (socks[0][1], &c, 1) == 1, "write() failed");
+  fail_unless_equals_int (gst_poll_wait (set, GST_CLOCK_TIME_NONE), 2);
+  fail_unless (gst_poll_fd_can_read (set, &rfds[0]));
+
+  gst_poll_free (set);
+  close (null_fd.fd);
+  for (i = 0; i < N_PAIRS; i++) {
+    close (socks[i][0]);
+    close (socks[i][1]);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_poll_suite (void)
 {
@@ -339,6 +472,8 @@ gst_poll_suite (void)
   tcase_add_test (tc_chain, test_poll_wait_restart);
   tcase_add_test (tc_chain, test_poll_wait_flush);
   tcase_add_test (tc_chain, test_poll_controllable);
+  tcase_add_test (tc_chain, test_poll_many_fds);
+  tcase_add_test (tc_chain, test_poll_control_threads);
 #else
   tcase_skip_broken_test (tc_chain, test_poll_basic);
   tcase_skip_broken_test (tc_chain, test_poll_wait);
@@ -346,6 +481,8 @@ gst_poll_suite (void)
   tcase_skip_broken_test (tc_chain, test_poll_wait_restart);
   tcase_skip_broken_test (tc_chain, test_poll_wait_flush);
   tcase_skip_broken_test (tc_chain, test_poll_controllable);
+  tcase_skip_broken_test (tc_chain, test_poll_many_fds);
+  tcase_skip_broken_test (tc_chain, test_poll_control_threads);
 #endif
 
   return s;
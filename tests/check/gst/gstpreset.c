@@ -244,6 +244,48 @@ GST_START_TEST (test_two_instances)
 
 GST_END_TEST;
 
+GST_START_TEST (test_reload_changed_file)
+{
+  GstElement *elem;
+  gchar *preset_file_name;
+  gboolean res;
+  gint val;
+
+  elem = gst_element_factory_make (GST_PRESET_TEST_NAME, NULL);
+  g_object_set (elem, "test", 5, NULL);
+  res = gst_preset_save_preset (GST_PRESET (elem), "test");
+  fail_unless (res);
+  gst_object_unref (elem);
+
+  /* the values are cached for the next instances */
+  elem = gst_element_factory_make (GST_PRESET_TEST_NAME, NULL);
+  res = gst_preset_load_preset (GST_PRESET (elem), "test");
+  fail_unless (res);
+  g_object_get (elem, "test", &val, NULL);
+  fail_unless_equals_int (val, 5);
+  gst_object_unref (elem);
+
+  /* and dropped when the preset file changes */
+  preset_file_name = g_build_filename (g_get_user_data_dir (),
+      "gstreamer-" GST_API_VERSION, "presets", "GstPresetTest.prs", NULL);
+  fail_unless (g_file_set_contents (preset_file_name,
+          "[_presets_]\nelement-name=GstPresetTest\nversion=" PACKAGE_VERSION
+          "\n\n[test]\ntest=12345\n\n[other]\ntest=7\n", -1, NULL));
+  g_free (preset_file_name);
+
+  elem = gst_element_factory_make (GST_PRESET_TEST_NAME, NULL);
+  res = gst_preset_load_preset (GST_PRESET (elem), "test");
+  fail_unless (res);
+  g_object_get (elem, "test", &val, NULL);
+  fail_unless_equals_int (val, 12345);
+  res = gst_preset_load_preset (GST_PRESET (elem), "other");
+  fail_unless (res);
+  g_object_get (elem, "test", &val, NULL);
+  fail_unless_equals_int (val, 7);
+  gst_object_unref (elem);
+}
+
+GST_END_TEST;
 
 static void
 remove_preset_file (void)
@@ -302,6 +344,7 @@ gst_preset_suite (void)
     tcase_add_test (tc, test_add);
     tcase_add_test (tc, test_del);
     tcase_add_test (tc, test_two_instances);
+    tcase_add_test (tc, test_reload_changed_file);
   }
   tcase_add_unchecked_fixture (tc, test_setup, test_teardown);
 
@@ -135,6 +135,59 @@ GST_START_TEST (printf_percent)
 
 GST_END_TEST;
 
+GST_START_TEST (printf_reused_format)
+{
+  gchar format[64];
+  gchar *str;
+  gint i;
+
+  /* parse results are cached by format pointer, a different format at the
+   * same address must not use them */
+  for (i = 0; i < 2; i++) {
+    g_strlcpy (format, "%d and %s", sizeof (format));
+    str = test_printf (format, 1, "one");
+    fail_unless_equals_string (str, "1 and one");
+    g_free (str);
+
+    g_strlcpy (format, "%s and %d", sizeof (format));
+    str = test_printf (format, "two", 2);
+    fail_unless_equals_string (str, "two and 2");
+    g_free (str);
+
+    g_strlcpy (format, "%s", sizeof (format));
+    str = test_printf (format, "three");
+    fail_unless_equals_string (str, "three");
+    g_free (str);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (printf_large)
+{
+  gchar *str, *expected, *arg;
+  gint i;
+
+  /* more directives than fit on the stack, twice to also use the cache */
+  for (i = 0; i < 2; i++) {
+    str = test_printf ("%d %d %d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5,
+        6, 7, 8, 9, 10, 11, 12);
+    fail_unless_equals_string (str, "1 2 3 4 5 6 7 8 9 10 11 12");
+    g_free (str);
+  }
+
+  /* results longer than the stack buffer */
+  arg = g_strnfill (1000, 'x');
+  expected = g_strconcat ("<", arg, ">", NULL);
+  str = test_printf ("<%s>", arg);
+  fail_unless_equals_string (str, expected);
+  g_free (str);
+  g_free (expected);
+  g_free (arg);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_printf_suite (void)
 {
@@ -146,6 +199,8 @@ gst_printf_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, printf_I32_I64);
   tcase_add_test (tc_chain, printf_percent);
+  tcase_add_test (tc_chain, printf_reused_format);
+  tcase_add_test (tc_chain, printf_large);
 
   return s;
 }
@@ -609,6 +609,64 @@ GST_START_TEST (test_stress)
 
 GST_END_TEST;
 
+static void
+on_change_atomic (GstPromise * promise, gpointer user_data)
+{
+  struct change_data *res = user_data;
+
+  res->result = gst_promise_wait (promise);
+  g_atomic_int_inc (&res->change_count);
+}
+
+static gpointer
+_reply_thread (GstPromise * promise)
+{
+  gst_promise_reply (promise, gst_structure_new_empty ("reply"));
+
+  return NULL;
+}
+
+static gpointer
+_interrupt_thread (GstPromise * promise)
+{
+  gst_promise_interrupt (promise);
+
+  return NULL;
+}
+
+GST_START_TEST (test_reply_interrupt_race)
+{
+  int i;
+
+  for (i = 0; i < 200; i++) {
+    struct change_data data = { 0, };
+    GThread *reply, *interrupt;
+    GstPromiseResult result;
+    GstPromise *r;
+
+    r = gst_promise_new_with_change_func (on_change_atomic, &data, NULL);
+    reply = g_thread_new ("reply", (GThreadFunc) _reply_thread, r);
+    interrupt = g_thread_new ("interrupt", (GThreadFunc) _interrupt_thread, r);
+
+    /* whichever call came first wins and the change func runs once */
+    result = gst_promise_wait (r);
+    g_thread_join (reply);
+    g_thread_join (interrupt);
+
+    fail_unless (result == GST_PROMISE_RESULT_REPLIED
+        || result == GST_PROMISE_RESULT_INTERRUPTED);
+    fail_unless (data.result == result);
+    fail_unless_equals_int (data.change_count, 1);
+    if (result == GST_PROMISE_RESULT_REPLIED)
+      fail_unless (gst_structure_has_name (gst_promise_get_reply (r),
+              "reply"));
+
+    gst_promise_unref (r);
+  }
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_promise_suite (void)
 {
@@ -633,6 +691,7 @@ gst_promise_suite (void)
   tcase_add_test (tc_chain, test_expire_interrupt);
   tcase_add_test (tc_chain, test_expire_reply);
   tcase_add_test (tc_chain, test_stress);
+  tcase_add_test (tc_chain, test_reply_interrupt_race);
 
   return s;
 }
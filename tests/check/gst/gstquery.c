@@ -279,6 +279,50 @@ GST_START_TEST (test_queries)
 
 GST_END_TEST;
 
+#define N_QUERIES 1000
+
+static gpointer
+free_queries_thread (GstQuery ** queries)
+{
+  guint i;
+
+  for (i = 0; i < N_QUERIES; i++)
+    gst_query_unref (queries[i]);
+
+  return NULL;
+}
+
+/* queries and their structures are recycled through per-thread caches, make
+ * sure they can be freed from another thread and reused with all fields
+ * reset */
+GST_START_TEST (test_queries_other_thread)
+{
+  GstQuery **queries = g_new (GstQuery *, N_QUERIES);
+  GThread *thread;
+  guint round, i;
+
+  for (round = 0; round < 3; round++) {
+    for (i = 0; i < N_QUERIES; i++) {
+      GstClockTime min, max;
+      gboolean live;
+
+      queries[i] = gst_query_new_latency ();
+      gst_query_parse_latency (queries[i], &live, &min, &max);
+      fail_if (live);
+      fail_unless_equals_uint64 (min, 0);
+      fail_unless_equals_uint64 (max, GST_CLOCK_TIME_NONE);
+      gst_query_set_latency (queries[i], TRUE, i, i + 1);
+    }
+
+    thread = g_thread_new ("free", (GThreadFunc) free_queries_thread, queries);
+    g_thread_join (thread);
+  }
+
+  g_free (queries);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_query_suite (void)
 {
@@ -290,6 +334,7 @@ gst_query_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, create_queries);
   tcase_add_test (tc_chain, test_queries);
+  tcase_add_test (tc_chain, test_queries_other_thread);
   return s;
 }
 
@@ -203,6 +203,34 @@ GST_START_TEST (test_registry_update)
 
 GST_END_TEST;
 
+GST_START_TEST (test_registry_warm)
+{
+  const gchar *names[] = { "fakesrc", "identity", NULL };
+  const gchar *missing[] = { "identity", "no-such-feature", NULL };
+  GstElementFactory *factory;
+  const GList *l;
+
+  fail_unless (gst_registry_warm (gst_registry_get (), names));
+
+  factory = gst_element_factory_find ("identity");
+  fail_unless (factory != NULL);
+  fail_unless (gst_plugin_feature_is_loaded (GST_PLUGIN_FEATURE (factory)));
+  fail_unless (g_type_class_peek (gst_element_factory_get_element_type
+          (factory)) != NULL);
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
+
+    fail_unless (templ->static_caps.caps != NULL);
+  }
+  gst_object_unref (factory);
+
+  /* the known features are still warmed */
+  fail_if (gst_registry_warm (gst_registry_get (), missing));
+}
+
+GST_END_TEST;
+
 static Suite *
 registry_suite (void)
 {
@@ -212,6 +240,7 @@ registry_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_registry_update);
+  tcase_add_test (tc_chain, test_registry_warm);
 
   return s;
 }
@@ -211,6 +211,90 @@ GST_START_TEST (test_notifies)
 
 GST_END_TEST;
 
+static GstStream *
+new_numbered_stream (guint i)
+{
+  GstStream *stream;
+  GstCaps *caps;
+  gchar *id;
+
+  id = g_strdup_printf ("program/%u", i);
+  caps = gst_caps_from_string ("some/video-caps");
+  stream = gst_stream_new (id, caps, GST_STREAM_TYPE_VIDEO, 0);
+  gst_caps_unref (caps);
+  g_free (id);
+
+  return stream;
+}
+
+GST_START_TEST (test_collection_diff)
+{
+  GstStreamCollection *collection, *previous;
+  GList *added, *removed, *changed;
+  GstStream *stream;
+  GstCaps *caps;
+  guint i;
+
+  previous = gst_stream_collection_new (NULL);
+  for (i = 0; i < 40; i++)
+    gst_stream_collection_add_stream (previous, new_numbered_stream (i));
+
+  stream = gst_stream_collection_get_stream_by_id (previous, "program/25");
+  fail_unless (stream == gst_stream_collection_get_stream (previous, 25));
+  fail_unless (gst_stream_collection_get_stream_by_id (previous,
+          "program/40") == NULL);
+
+  fail_unless (gst_stream_collection_diff (previous, NULL, &added, NULL,
+          NULL));
+  fail_unless_equals_int (g_list_length (added), 40);
+  g_list_free (added);
+
+  /* share streams 1 to 39 except 30, re-create 2 and 3 of which only 3
+   * changes, and add 40 */
+  collection = gst_stream_collection_new (NULL);
+  for (i = 1; i < 40; i++) {
+    if (i == 30)
+      continue;
+    if (i == 2 || i == 3) {
+      stream = new_numbered_stream (i);
+      if (i == 3) {
+        caps = gst_caps_from_string ("some/other-caps");
+        gst_stream_set_caps (stream, caps);
+        gst_caps_unref (caps);
+      }
+    } else {
+      stream = gst_object_ref (gst_stream_collection_get_stream (previous, i));
+    }
+    gst_stream_collection_add_stream (collection, stream);
+  }
+  gst_stream_collection_add_stream (collection, new_numbered_stream (40));
+
+  fail_unless (gst_stream_collection_diff (collection, previous, &added,
+          &removed, &changed));
+  fail_unless_equals_int (g_list_length (added), 1);
+  fail_unless_equals_string (gst_stream_get_stream_id (added->data),
+      "program/40");
+  fail_unless_equals_int (g_list_length (removed), 2);
+  fail_unless_equals_string (gst_stream_get_stream_id (removed->data),
+      "program/0");
+  fail_unless_equals_string (gst_stream_get_stream_id (removed->next->data),
+      "program/30");
+  fail_unless_equals_int (g_list_length (changed), 1);
+  fail_unless_equals_string (gst_stream_get_stream_id (changed->data),
+      "program/3");
+  g_list_free (added);
+  g_list_free (removed);
+  g_list_free (changed);
+
+  fail_if (gst_stream_collection_diff (collection, collection, NULL, NULL,
+          NULL));
+
+  gst_object_unref (collection);
+  gst_object_unref (previous);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_streams_suite (void)
 {
@@ -221,6 +305,7 @@ gst_streams_suite (void)
   tcase_add_test (tc_chain, test_stream_creation);
   tcase_add_test (tc_chain, test_stream_event);
   tcase_add_test (tc_chain, test_notifies);
+  tcase_add_test (tc_chain, test_collection_diff);
   return s;
 }
 
@@ -1018,6 +1018,174 @@ GST_START_TEST (test_flagset)
 
 GST_END_TEST;
 
+GST_START_TEST (test_binary_serialization)
+{
+  GstStructure *s, *s2;
+  GstDateTime *dt;
+  GstCaps *caps;
+  GBytes *bytes;
+  const guint8 *data;
+  guint8 *padded;
+  gsize size, consumed, i;
+
+  s = gst_structure_from_string ("test, int=(int)-5, uint=(uint)4000000000, "
+      "int64=(gint64)-1234567890123, uint64=(guint64)18446744073709551615, "
+      "bool=(boolean)true, float=(float)0.5, double=(double)-3.25, "
+      "string=(string)\"a string\", frac=(fraction)30000/1001, "
+      "irange=(int)[ 2, 20, 2 ], i64range=(gint64)[ -10, 10 ], "
+      "drange=(double)[ 0.5, 1.5 ], frange=(fraction)[ 1/2, 3/2 ], "
+      "list=(int){ 1, 2, 3 }, array=(string)< a, b, c >, "
+      "nested=(structure)\"nested, width=(int)16;\", "
+      "bitmask=(bitmask)0x3", NULL);
+  fail_unless (s != NULL);
+
+  caps = gst_caps_from_string ("video/x-raw(memory:SystemMemory, meta:Foo), "
+      "width=(int)320; audio/x-raw");
+  dt = gst_date_time_new_ymd (2021, 6, 1);
+  gst_structure_set (s, "caps", GST_TYPE_CAPS, caps,
+      "null-string", G_TYPE_STRING, NULL,
+      "state", GST_TYPE_STATE, GST_STATE_PAUSED,
+      "flags", GST_TYPE_SEEK_FLAGS, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+      "date-time", GST_TYPE_DATE_TIME, dt, NULL);
+  gst_date_time_unref (dt);
+  gst_caps_unref (caps);
+
+  bytes = gst_structure_to_binary (s);
+  fail_unless (bytes != NULL);
+  data = g_bytes_get_data (bytes, &size);
+
+  s2 = gst_structure_from_binary (data, size, &consumed);
+  fail_unless (s2 != NULL);
+  fail_unless_equals_int (consumed, size);
+  fail_unless (gst_structure_is_equal (s, s2));
+  fail_unless (gst_structure_get_string (s2, "null-string") == NULL);
+  gst_structure_free (s2);
+
+  /* trailing data is not consumed */
+  padded = g_malloc (size + 4);
+  memcpy (padded, data, size);
+  memset (padded + size, 0xff, 4);
+  s2 = gst_structure_from_binary (padded, size + 4, &consumed);
+  fail_unless (s2 != NULL);
+  fail_unless_equals_int (consumed, size);
+  gst_structure_free (s2);
+  g_free (padded);
+
+  /* truncated data is rejected */
+  for (i = 0; i < size; i++)
+    fail_unless (gst_structure_from_binary (data, i, NULL) == NULL);
+
+  g_bytes_unref (bytes);
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_many_fields)
+{
+  GstStructure *s, *copy;
+  gchar name[16];
+  gint i, val;
+
+  s = gst_structure_new_empty ("test");
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+
+  /* replacing keeps the position of the field */
+  gst_structure_set (s, "field50", G_TYPE_INT, 500, NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 50), "field50");
+
+  /* removing moves the following fields */
+  for (i = 0; i < 100; i += 2) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    gst_structure_remove_field (s, name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 50);
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 0), "field1");
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 49), "field99");
+
+  copy = gst_structure_copy (s);
+  fail_unless (gst_structure_is_equal (s, copy));
+  for (i = 0; i < 100; i++) {
+    g_snprintf (name, sizeof (name), "field%d", i);
+    if (i % 2 == 0) {
+      fail_if (gst_structure_has_field (copy, name));
+    } else {
+      fail_unless (gst_structure_get_int (copy, name, &val));
+      fail_unless_equals_int (val, i);
+    }
+  }
+  gst_structure_free (copy);
+
+  /* unknown field names are not found */
+  fail_if (gst_structure_has_field (s, "never-used-as-a-field-name"));
+
+  gst_structure_remove_all_fields (s);
+  fail_unless_equals_int (gst_structure_n_fields (s), 0);
+  fail_if (gst_structure_has_field (s, "field1"));
+  gst_structure_set (s, "field1", G_TYPE_INT, 1, NULL);
+  fail_unless (gst_structure_get_int (s, "field1", &val));
+  fail_unless_equals_int (val, 1);
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
+#define QUARK_THREADS 4
+
+static gpointer
+check_field_quarks (gpointer data)
+{
+  gint id = GPOINTER_TO_INT (data);
+  GstStructure *s;
+  gchar name[32];
+  gint i, val;
+
+  for (i = 0; i < 1000; i++) {
+    s = gst_structure_new_empty ("GstQueryPosition");
+    fail_unless (gst_structure_has_name (s, "GstQueryPosition"));
+
+    /* names from the core table */
+    gst_structure_set (s, "format", G_TYPE_INT, i, "duration", G_TYPE_INT, i,
+        NULL);
+    fail_unless (gst_structure_id_has_field (s,
+            g_quark_from_static_string ("format")));
+
+    /* names that are shared and private to this thread */
+    g_snprintf (name, sizeof (name), "shared-%d", i % 300);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+    g_snprintf (name, sizeof (name), "thread%d-%d", id, i % 300);
+    fail_if (gst_structure_has_field (s, name));
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+    fail_unless (gst_structure_get_int (s, name, &val));
+    fail_unless_equals_int (val, i);
+    fail_unless_equals_int (gst_structure_nth_field_name (s, 3)[0], 't');
+    fail_unless (gst_structure_id_has_field (s, g_quark_try_string (name)));
+
+    gst_structure_free (s);
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_field_quarks)
+{
+  GThread *threads[QUARK_THREADS];
+  gint i;
+
+  for (i = 0; i < QUARK_THREADS; i++)
+    threads[i] = g_thread_new ("quarks", check_field_quarks,
+        GINT_TO_POINTER (i));
+  for (i = 0; i < QUARK_THREADS; i++)
+    g_thread_join (threads[i]);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_structure_suite (void)
 {
@@ -1050,6 +1218,9 @@ gst_structure_suite (void)
   tcase_add_test (tc_chain, test_map_in_place);
   tcase_add_test (tc_chain, test_filter_and_map_in_place);
   tcase_add_test (tc_chain, test_flagset);
+  tcase_add_test (tc_chain, test_binary_serialization);
+  tcase_add_test (tc_chain, test_many_fields);
+  tcase_add_test (tc_chain, test_field_quarks);
   return s;
 }
 
@@ -384,6 +384,200 @@ GST_START_TEST (test_stress_reschedule)
 
 GST_END_TEST;
 
+#define N_ASYNC_ENTRIES 300
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gint fired[N_ASYNC_ENTRIES];
+  GstClockTime times[N_ASYNC_ENTRIES];
+  guint n_fired;
+} AsyncOrderData;
+
+static AsyncOrderData async_order;
+
+static gboolean
+async_order_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  g_mutex_lock (&async_order.lock);
+  async_order.fired[async_order.n_fired] = GPOINTER_TO_INT (user_data);
+  async_order.times[async_order.n_fired] = time;
+  async_order.n_fired++;
+  g_cond_signal (&async_order.cond);
+  g_mutex_unlock (&async_order.lock);
+
+  return TRUE;
+}
+
+GST_START_TEST (test_async_order)
+{
+  GstClock *clock;
+  GstClockID ids[N_ASYNC_ENTRIES];
+  GstClockTime base;
+  gboolean seen[N_ASYNC_ENTRIES] = { FALSE, };
+  guint i, n_expected = 0;
+
+  clock = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockOrder", NULL);
+  gst_object_ref_sink (clock);
+
+  g_mutex_init (&async_order.lock);
+  g_cond_init (&async_order.cond);
+  async_order.n_fired = 0;
+
+  /* random times, the last entries all have the same time and must fire in
+   * the order they were added. Every third entry is unscheduled again. */
+  base = gst_clock_get_time (clock) + 50 * GST_MSECOND;
+  for (i = 0; i < N_ASYNC_ENTRIES; i++) {
+    GstClockTime time;
+
+    if (i < N_ASYNC_ENTRIES - 20)
+      time = base + g_random_int_range (0, 100) * GST_MSECOND;
+    else
+      time = base + 50 * GST_MSECOND;
+
+    ids[i] = gst_clock_new_single_shot_id (clock, time);
+    fail_unless (gst_clock_id_wait_async (ids[i], async_order_cb,
+            GINT_TO_POINTER (i), NULL) == GST_CLOCK_OK);
+  }
+  for (i = 0; i < N_ASYNC_ENTRIES; i++) {
+    if (i % 3 == 0)
+      gst_clock_id_unschedule (ids[i]);
+    else
+      n_expected++;
+  }
+
+  g_mutex_lock (&async_order.lock);
+  while (async_order.n_fired < n_expected)
+    g_cond_wait (&async_order.cond, &async_order.lock);
+  g_mutex_unlock (&async_order.lock);
+
+  /* nothing else fires */
+  g_usleep (20 * G_USEC_PER_SEC / 1000);
+  fail_unless_equals_int (async_order.n_fired, n_expected);
+
+  for (i = 0; i < n_expected; i++) {
+    gint idx = async_order.fired[i];
+
+    fail_if (idx % 3 == 0, "unscheduled entry %d fired", idx);
+    fail_if (seen[idx], "entry %d fired twice", idx);
+    seen[idx] = TRUE;
+    if (i > 0) {
+      fail_unless (async_order.times[i] >= async_order.times[i - 1]);
+      if (async_order.times[i] == async_order.times[i - 1] &&
+          idx >= N_ASYNC_ENTRIES - 20)
+        fail_unless (async_order.fired[i - 1] < idx);
+    }
+  }
+
+  for (i = 0; i < N_ASYNC_ENTRIES; i++)
+    gst_clock_id_unref (ids[i]);
+  gst_object_unref (clock);
+  g_cond_clear (&async_order.cond);
+  g_mutex_clear (&async_order.lock);
+}
+
+GST_END_TEST;
+
+static gboolean
+coalesce_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstClockTime *fired_at = user_data;
+
+  g_mutex_lock (&async_order.lock);
+  *fired_at = gst_clock_get_time (clock);
+  async_order.n_fired++;
+  g_cond_signal (&async_order.cond);
+  g_mutex_unlock (&async_order.lock);
+
+  return TRUE;
+}
+
+GST_START_TEST (test_async_coalesce)
+{
+  GstClock *clock;
+  GstClockID ids[20];
+  GstClockTime fired_at[20], base;
+  guint i;
+
+  clock = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockCoalesce",
+      "coalesce-slack", 500 * GST_MSECOND, NULL);
+  gst_object_ref_sink (clock);
+
+  g_mutex_init (&async_order.lock);
+  g_cond_init (&async_order.cond);
+  async_order.n_fired = 0;
+
+  base = gst_clock_get_time (clock) + 50 * GST_MSECOND;
+  for (i = 0; i < G_N_ELEMENTS (ids); i++) {
+    ids[i] = gst_clock_new_single_shot_id (clock, base + i * 10 * GST_MSECOND);
+    fail_unless (gst_clock_id_wait_async (ids[i], coalesce_cb, &fired_at[i],
+            NULL) == GST_CLOCK_OK);
+  }
+
+  g_mutex_lock (&async_order.lock);
+  while (async_order.n_fired < G_N_ELEMENTS (ids))
+    g_cond_wait (&async_order.cond, &async_order.lock);
+  g_mutex_unlock (&async_order.lock);
+
+  /* the first entry was waited for, all others fired with it */
+  fail_unless (fired_at[0] >= base);
+  fail_unless (fired_at[G_N_ELEMENTS (ids) - 1] <
+      base + (G_N_ELEMENTS (ids) - 1) * 10 * GST_MSECOND);
+
+  for (i = 0; i < G_N_ELEMENTS (ids); i++)
+    gst_clock_id_unref (ids[i]);
+  gst_object_unref (clock);
+  g_cond_clear (&async_order.cond);
+  g_mutex_clear (&async_order.lock);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_tsc_clock)
+{
+  GstClock *tsc, *mono;
+  GstClockTime last, t, m;
+  GstClockTimeDiff diff;
+  GstClockID id;
+  guint i;
+
+  /* falls back to the monotonic clock if the counter can't be used */
+  tsc = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockTSC",
+      "clock-type", GST_CLOCK_TYPE_TSC, NULL);
+  gst_object_ref_sink (tsc);
+  mono = g_object_new (GST_TYPE_SYSTEM_CLOCK, "name", "TestClockMono",
+      "clock-type", GST_CLOCK_TYPE_MONOTONIC, NULL);
+  gst_object_ref_sink (mono);
+
+  last = gst_clock_get_time (tsc);
+  for (i = 0; i < 100000; i++) {
+    t = gst_clock_get_time (tsc);
+    fail_unless (t >= last);
+    last = t;
+  }
+
+  t = gst_clock_get_time (tsc);
+  m = gst_clock_get_time (mono);
+  diff = GST_CLOCK_DIFF (t, m);
+  fail_unless (diff > -GST_MSECOND && diff < GST_MSECOND,
+      "TSC clock deviates %" G_GINT64_FORMAT "ns", diff);
+
+  fail_unless (gst_clock_get_resolution (tsc) > 0);
+
+  /* waits are done on the monotonic clock */
+  id = gst_clock_new_single_shot_id (tsc, t + 20 * GST_MSECOND);
+  fail_unless (gst_clock_id_wait (id, NULL) == GST_CLOCK_OK);
+  fail_unless (gst_clock_get_time (tsc) >= t + 20 * GST_MSECOND);
+  gst_clock_id_unref (id);
+
+  gst_object_unref (mono);
+  gst_object_unref (tsc);
+}
+
+GST_END_TEST;
 
 static Suite *
 gst_systemclock_suite (void)
@@ -396,6 +590,9 @@ gst_systemclock_suite (void)
   tcase_add_test (tc_chain, test_signedness);
   tcase_add_test (tc_chain, test_diff);
   tcase_add_test (tc_chain, test_async_full);
+  tcase_add_test (tc_chain, test_async_order);
+  tcase_add_test (tc_chain, test_async_coalesce);
+  tcase_add_test (tc_chain, test_tsc_clock);
   tcase_add_test (tc_chain, test_set_default);
   tcase_add_test (tc_chain, test_resolution);
   tcase_add_test (tc_chain, test_stress_cleanup_unschedule);
@@ -266,6 +266,52 @@ GST_START_TEST (test_merge)
     gst_tag_list_unref (merge);
 }
 
+GST_END_TEST
+GST_START_TEST (test_register_and_insert)
+{
+  GstTagList *list, *list2;
+  guint val;
+
+  /* registering after initialization publishes a new table of tags */
+  fail_if (gst_tag_exists ("gst-check-late-tag"));
+  gst_tag_register_static ("gst-check-late-tag", GST_TAG_FLAG_META,
+      G_TYPE_UINT, "late tag", "tag registered by the test", NULL);
+  fail_unless (gst_tag_exists ("gst-check-late-tag"));
+  fail_unless (gst_tag_exists (FTAG));
+  fail_unless (gst_tag_get_type ("gst-check-late-tag") == G_TYPE_UINT);
+  fail_unless (gst_tag_is_fixed ("gst-check-late-tag"));
+
+  /* registering again with the same type keeps the first registration */
+  gst_tag_register_static ("gst-check-late-tag", GST_TAG_FLAG_META,
+      G_TYPE_UINT, "other nick", "other blurb", NULL);
+  fail_unless_equals_string (gst_tag_get_nick ("gst-check-late-tag"),
+      "late tag");
+
+  list = gst_tag_list_new ("gst-check-late-tag", 1, FTAG, FIXED1, NULL);
+
+  /* inserting into an empty list copies everything */
+  list2 = gst_tag_list_new_empty ();
+  gst_tag_list_insert (list2, list, GST_TAG_MERGE_KEEP);
+  fail_unless (gst_tag_list_is_equal (list, list2));
+
+  /* updating a single tag in place */
+  gst_tag_list_unref (list);
+  list = gst_tag_list_new ("gst-check-late-tag", 2, NULL);
+  gst_tag_list_insert (list2, list, GST_TAG_MERGE_REPLACE);
+  fail_unless (gst_tag_list_get_uint (list2, "gst-check-late-tag", &val));
+  fail_unless_equals_int (val, 2);
+  check_tags (list2, FTAG, FIXED1, NULL);
+
+  gst_tag_list_insert (list2, list, GST_TAG_MERGE_KEEP_ALL);
+  fail_unless_equals_int (gst_tag_list_n_tags (list2), 2);
+
+  gst_tag_list_insert (list2, list, GST_TAG_MERGE_REPLACE_ALL);
+  fail_unless (gst_tag_list_is_equal (list, list2));
+
+  gst_tag_list_unref (list);
+  gst_tag_list_unref (list2);
+}
+
 GST_END_TEST
 GST_START_TEST (test_date_tags)
 {
@@ -592,6 +638,7 @@ GST_START_TEST (test_serialization)
   GstBuffer *b1, *b2;
   GstSample *s1, *s2;
   GstCaps *c2;
+  GBytes *bytes;
   gchar *s;
 
   b1 = gst_buffer_new_allocate (NULL, 1, NULL);
@@ -619,6 +666,15 @@ GST_START_TEST (test_serialization)
   gst_tag_list_unref (tags2);
   g_free (s);
 
+  bytes = gst_tag_list_to_binary (tags);
+  fail_unless (bytes != NULL);
+  tags2 = gst_tag_list_new_from_binary (g_bytes_get_data (bytes, NULL),
+      g_bytes_get_size (bytes));
+  fail_unless (tags2 != NULL);
+  fail_unless (gst_tag_list_is_equal (tags, tags2));
+  gst_tag_list_unref (tags2);
+  g_bytes_unref (bytes);
+
   gst_sample_unref (s1);
   gst_sample_unref (s2);
   gst_tag_list_unref (tags);
@@ -656,6 +712,7 @@ gst_tag_suite (void)
   tcase_add_test (tc_chain, test_add);
   tcase_add_test (tc_chain, test_merge);
   tcase_add_test (tc_chain, test_merge_strings_with_comma);
+  tcase_add_test (tc_chain, test_register_and_insert);
   tcase_add_test (tc_chain, test_date_tags);
   tcase_add_test (tc_chain, test_type);
   tcase_add_test (tc_chain, test_set_non_utf8_string);
@@ -22,6 +22,14 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include <gst/check/gstcheck.h>
 
 static GMutex task_lock;
@@ -464,6 +472,202 @@ GST_START_TEST (test_shared_task_pool_two_threads)
 
 GST_END_TEST;
 
+static gboolean thread_configured;
+
+static void
+task_affinity_func (void *data)
+{
+#ifdef HAVE_PTHREAD_SETAFFINITY_NP
+  cpu_set_t set;
+
+  CPU_ZERO (&set);
+  fail_unless (pthread_getaffinity_np (pthread_self (), sizeof (set),
+          &set) == 0);
+  thread_configured = CPU_COUNT (&set) == 1 && CPU_ISSET (0, &set);
+#else
+  thread_configured = TRUE;
+#endif
+
+  g_mutex_lock (&task_lock);
+  g_cond_signal (&task_cond);
+  g_mutex_unlock (&task_lock);
+
+  gst_task_pause (*(GstTask **) data);
+}
+
+GST_START_TEST (test_thread_config)
+{
+  GstTask *t;
+  gint priority;
+  guint *cpus, n_cpus;
+  const guint cpu0 = 0;
+
+  t = gst_task_new (task_affinity_func, &t, NULL);
+  fail_if (t == NULL);
+
+  fail_unless (gst_task_get_scheduling (t, NULL) ==
+      GST_TASK_SCHEDULING_INHERIT);
+  fail_unless (gst_task_get_cpu_affinity (t, &n_cpus) == NULL);
+  fail_unless_equals_int (n_cpus, 0);
+
+  gst_task_set_scheduling (t, GST_TASK_SCHEDULING_FIFO, 10);
+  fail_unless (gst_task_get_scheduling (t, &priority) ==
+      GST_TASK_SCHEDULING_FIFO);
+  fail_unless_equals_int (priority, 10);
+  /* realtime scheduling needs privileges, only test the affinity */
+  gst_task_set_scheduling (t, GST_TASK_SCHEDULING_INHERIT, 0);
+
+  gst_task_set_cpu_affinity (t, &cpu0, 1);
+  cpus = gst_task_get_cpu_affinity (t, &n_cpus);
+  fail_unless_equals_int (n_cpus, 1);
+  fail_unless_equals_int (cpus[0], 0);
+  g_free (cpus);
+
+  g_rec_mutex_init (&task_mutex);
+  gst_task_set_lock (t, &task_mutex);
+  g_cond_init (&task_cond);
+  g_mutex_init (&task_lock);
+
+  thread_configured = FALSE;
+  g_mutex_lock (&task_lock);
+  fail_unless (gst_task_start (t));
+  g_cond_wait (&task_cond, &task_lock);
+  g_mutex_unlock (&task_lock);
+
+  fail_unless (gst_task_join (t));
+  fail_unless (thread_configured);
+
+  gst_task_set_cpu_affinity (t, NULL, 0);
+  fail_unless (gst_task_get_cpu_affinity (t, &n_cpus) == NULL);
+
+  gst_object_unref (t);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  GstTaskPool *pool;
+  TaskData tdata;
+  gpointer handle;
+} StealData;
+
+/* pushes a blocking job on the queue of its own worker and waits for it to
+ * block, which can only happen when another worker steals it */
+static void
+steal_cb (StealData * sdata)
+{
+  sdata->handle = gst_task_pool_push (sdata->pool,
+      (GstTaskPoolFunction) task_cb, &sdata->tdata, NULL);
+
+  g_mutex_lock (&sdata->tdata.blocked_lock);
+  while (!sdata->tdata.blocked)
+    g_cond_wait (&sdata->tdata.blocked_cond, &sdata->tdata.blocked_lock);
+  g_mutex_unlock (&sdata->tdata.blocked_lock);
+
+  g_mutex_lock (&sdata->tdata.unblock_lock);
+  sdata->tdata.unblock = TRUE;
+  g_cond_signal (&sdata->tdata.unblock_cond);
+  g_mutex_unlock (&sdata->tdata.unblock_lock);
+}
+
+GST_START_TEST (test_work_stealing_task_pool_steal)
+{
+  GError *err = NULL;
+  StealData sdata;
+  gpointer handle;
+
+  sdata.pool = gst_work_stealing_task_pool_new (2);
+  fail_unless_equals_int (gst_work_stealing_task_pool_get_n_threads
+      (GST_WORK_STEALING_TASK_POOL (sdata.pool)), 2);
+  gst_task_pool_prepare (sdata.pool, &err);
+  fail_unless (err == NULL);
+
+  init_task_data (&sdata.tdata);
+
+  handle = gst_task_pool_push (sdata.pool, (GstTaskPoolFunction) steal_cb,
+      &sdata, &err);
+  fail_unless (err == NULL);
+  fail_unless (handle != NULL);
+
+  gst_task_pool_join (sdata.pool, handle);
+  gst_task_pool_join (sdata.pool, sdata.handle);
+
+  fail_unless (sdata.tdata.called == TRUE);
+
+  cleanup_task_data (&sdata.tdata);
+
+  gst_task_pool_cleanup (sdata.pool);
+
+  gst_object_unref (sdata.pool);
+}
+
+GST_END_TEST;
+
+#define N_JOBS 10000
+
+static void
+count_cb (gint * count)
+{
+  g_atomic_int_inc (count);
+}
+
+static void
+check_work_stealing_task_pool (gboolean pin)
+{
+  GstTaskPool *pool;
+  GError *err = NULL;
+  gpointer *handles;
+  gint count = 0;
+  guint i;
+
+  pool = gst_work_stealing_task_pool_new (0);
+  gst_work_stealing_task_pool_set_pin_threads (GST_WORK_STEALING_TASK_POOL
+      (pool), pin);
+  fail_unless (gst_work_stealing_task_pool_get_pin_threads
+      (GST_WORK_STEALING_TASK_POOL (pool)) == pin);
+  gst_task_pool_prepare (pool, &err);
+  fail_unless (err == NULL);
+
+  handles = g_new (gpointer, N_JOBS);
+  for (i = 0; i < N_JOBS; i++) {
+    handles[i] = gst_task_pool_push (pool, (GstTaskPoolFunction) count_cb,
+        &count, &err);
+    fail_unless (err == NULL);
+  }
+  for (i = 0; i < N_JOBS; i++)
+    gst_task_pool_join (pool, handles[i]);
+  g_free (handles);
+
+  fail_unless_equals_int (g_atomic_int_get (&count), N_JOBS);
+
+  /* jobs that are still queued are run on cleanup */
+  for (i = 0; i < N_JOBS; i++) {
+    gst_task_pool_dispose_handle (pool, gst_task_pool_push (pool,
+            (GstTaskPoolFunction) count_cb, &count, &err));
+    fail_unless (err == NULL);
+  }
+  gst_task_pool_cleanup (pool);
+
+  fail_unless_equals_int (g_atomic_int_get (&count), 2 * N_JOBS);
+
+  gst_object_unref (pool);
+}
+
+GST_START_TEST (test_work_stealing_task_pool_jobs)
+{
+  check_work_stealing_task_pool (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_work_stealing_task_pool_pinned)
+{
+  check_work_stealing_task_pool (TRUE);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_task_suite (void)
 {
@@ -480,6 +684,10 @@ gst_task_suite (void)
   tcase_add_test (tc_chain, test_resume);
   tcase_add_test (tc_chain, test_shared_task_pool_shared_thread);
   tcase_add_test (tc_chain, test_shared_task_pool_two_threads);
+  tcase_add_test (tc_chain, test_thread_config);
+  tcase_add_test (tc_chain, test_work_stealing_task_pool_steal);
+  tcase_add_test (tc_chain, test_work_stealing_task_pool_jobs);
+  tcase_add_test (tc_chain, test_work_stealing_task_pool_pinned);
 
   return s;
 }
@@ -25,6 +25,8 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/gsttracerrecord.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 static GList *messages;         /* NULL */
 static gboolean save_messages;  /* FALSE */
@@ -152,6 +154,70 @@ GST_START_TEST (serialize_static_record)
 
 GST_END_TEST;
 
+static gboolean
+contains (const gchar * data, gsize size, const gchar * str)
+{
+  gsize i, len = strlen (str);
+
+  for (i = 0; i + len <= size; i++) {
+    if (!memcmp (data + i, str, len))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+GST_START_TEST (serialize_binary_record)
+{
+  GstTracerRecord *tr;
+  gchar *filename, *contents = NULL;
+  gsize size = 0;
+  gint fd, i;
+
+  fd = g_file_open_tmp ("gst-tracer-record-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+  /* only picked up when the first record is created */
+  g_setenv ("GST_TRACER_RECORD_FILE", filename, TRUE);
+
+  /* *INDENT-OFF* */
+  tr = gst_tracer_record_new ("test.class",
+      "string", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          NULL),
+      "int", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_INT,
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+
+  save_messages = TRUE;
+  gst_tracer_record_log (tr, "binary-test-value", 1);
+  save_messages = FALSE;
+
+  /* nothing goes to the debug log */
+  fail_unless (messages == NULL);
+
+  /* the entries are written to the file in the background */
+  for (i = 0; i < 100; i++) {
+    g_free (contents);
+    fail_unless (g_file_get_contents (filename, &contents, &size, NULL));
+    if (contains (contents, size, "binary-test-value"))
+      break;
+    g_usleep (G_USEC_PER_SEC / 100);
+  }
+  fail_unless (size > 8);
+  fail_unless (!memcmp (contents, "GSTTRACE", 8));
+  fail_unless (contains (contents, size, "binary-test-value"));
+
+  g_unsetenv ("GST_TRACER_RECORD_FILE");
+  g_free (contents);
+  gst_object_unref (tr);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gst_tracer_record_suite (void)
@@ -163,6 +229,7 @@ gst_tracer_record_suite (void)
   tcase_add_checked_fixture (tc_chain, setup, cleanup);
   tcase_add_test (tc_chain, serialize_message_logging);
   tcase_add_test (tc_chain, serialize_static_record);
+  tcase_add_test (tc_chain, serialize_binary_record);
 
   /* FIXME: add more tests, e.g. enums, pointer types and optional fields */
 
@@ -349,6 +349,72 @@ GST_START_TEST (test_math_scale_random)
 
 GST_END_TEST;
 
+static guint64
+random_uint64 (GRand * rand)
+{
+  guint64 v = ((guint64) g_rand_int (rand)) << 32 | g_rand_int (rand);
+
+  /* values of all magnitudes */
+  return v >> g_rand_int_range (rand, 0, 64);
+}
+
+GST_START_TEST (test_math_scaler)
+{
+  static const guint64 ratios[][2] = {
+    {GST_SECOND, 48000}, {48000, GST_SECOND}, {GST_SECOND, 44100},
+    {1001, 30000}, {90000, GST_SECOND}, {1, 1}, {0, 5}, {7, 1}, {1, 1024},
+    {G_MAXUINT64, 3}, {3, G_MAXUINT64}, {G_MAXUINT64, G_MAXUINT64 - 1},
+  };
+  guint64 vals[64], results[64];
+  GstUtilScaler scaler;
+  GRand *rand;
+  gint i, j;
+
+  gst_util_scaler_init (&scaler, GST_SECOND, 48000);
+  fail_unless_equals_uint64 (scaler.num, 62500);
+  fail_unless_equals_uint64 (scaler.denom, 3);
+  fail_unless_equals_uint64 (gst_util_scaler_scale (&scaler, 48000),
+      GST_SECOND);
+  fail_unless_equals_uint64 (gst_util_scaler_scale (&scaler, 1), 20833);
+  fail_unless_equals_uint64 (gst_util_scaler_scale_round (&scaler, 1), 20833);
+  fail_unless_equals_uint64 (gst_util_scaler_scale_ceil (&scaler, 1), 20834);
+  fail_unless_equals_uint64 (gst_util_scaler_scale (&scaler, G_MAXUINT64),
+      G_MAXUINT64);
+
+  /* the results are the same as with gst_util_uint64_scale() */
+  rand = g_rand_new ();
+  for (i = 0; i < 2000; i++) {
+    guint64 num, denom;
+
+    if (i < G_N_ELEMENTS (ratios)) {
+      num = ratios[i][0];
+      denom = ratios[i][1];
+    } else {
+      num = random_uint64 (rand);
+      denom = random_uint64 (rand) | 1;
+    }
+    gst_util_scaler_init (&scaler, num, denom);
+
+    for (j = 0; j < G_N_ELEMENTS (vals); j++)
+      vals[j] = j < 4 ? G_MAXUINT64 - j : random_uint64 (rand);
+    gst_util_scaler_scale_array (&scaler, vals, results, G_N_ELEMENTS (vals));
+
+    for (j = 0; j < G_N_ELEMENTS (vals); j++) {
+      fail_unless_equals_uint64 (results[j],
+          gst_util_uint64_scale (vals[j], num, denom));
+      fail_unless_equals_uint64 (gst_util_scaler_scale (&scaler, vals[j]),
+          results[j]);
+      fail_unless_equals_uint64 (gst_util_scaler_scale_round (&scaler,
+              vals[j]), gst_util_uint64_scale_round (vals[j], num, denom));
+      fail_unless_equals_uint64 (gst_util_scaler_scale_ceil (&scaler, vals[j]),
+          gst_util_uint64_scale_ceil (vals[j], num, denom));
+    }
+  }
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_guint64_to_gdouble)
 {
   guint64 from[] = { 0, 1, 100, 10000, (guint64) (1) << 63,
@@ -1987,6 +2053,7 @@ gst_utils_suite (void)
   tcase_add_test (tc_chain, test_math_scale_ceil);
   tcase_add_test (tc_chain, test_math_scale_uint64);
   tcase_add_test (tc_chain, test_math_scale_random);
+  tcase_add_test (tc_chain, test_math_scaler);
 #ifdef HAVE_GSL
 #ifdef HAVE_GMP
   tcase_add_test (tc_chain, test_math_scale_gmp);
@@ -1119,6 +1119,73 @@ GST_START_TEST (test_value_intersect)
 
 GST_END_TEST;
 
+static void
+check_list_intersection (const gchar * list1, const gchar * list2,
+    const gchar ** expected)
+{
+  GValue v1 = G_VALUE_INIT, v2 = G_VALUE_INIT, dest = G_VALUE_INIT;
+  guint i, n;
+
+  g_value_init (&v1, GST_TYPE_LIST);
+  fail_unless (gst_value_deserialize (&v1, list1));
+  g_value_init (&v2, GST_TYPE_LIST);
+  fail_unless (gst_value_deserialize (&v2, list2));
+
+  n = g_strv_length ((gchar **) expected);
+  fail_unless_equals_int (gst_value_intersect (NULL, &v1, &v2), n > 0);
+  fail_unless_equals_int (gst_value_intersect (&dest, &v1, &v2), n > 0);
+
+  if (n == 1) {
+    gchar *str = gst_value_serialize (&dest);
+
+    fail_unless_equals_string (str, expected[0]);
+    g_free (str);
+  } else if (n > 1) {
+    fail_unless (GST_VALUE_HOLDS_LIST (&dest));
+    fail_unless_equals_int (gst_value_list_get_size (&dest), n);
+    /* the order of the first list is kept */
+    for (i = 0; i < n; i++) {
+      gchar *str = gst_value_serialize (gst_value_list_get_value (&dest, i));
+
+      fail_unless_equals_string (str, expected[i]);
+      g_free (str);
+    }
+  }
+
+  if (n > 0)
+    g_value_unset (&dest);
+  g_value_unset (&v1);
+  g_value_unset (&v2);
+}
+
+GST_START_TEST (test_value_intersect_long_lists)
+{
+  const gchar *strings[] = { "A", "C", "G", "H", NULL };
+  const gchar *dup_strings[] = { "A", "C", "A", NULL };
+  const gchar *ints[] = { "8", "1", NULL };
+  const gchar *fractions[] = { "30/1", "25/1", NULL };
+  const gchar *single[] = { "Q", NULL };
+  const gchar *none[] = { NULL };
+
+  check_list_intersection ("{ A, B, C, D, E, F, G, H, A }",
+      "{ H, G, X, A, C, Y, Z, W, R }", strings);
+  check_list_intersection ("{ A, B, C, D, E, F, G, A, A }",
+      "{ A, S, C, T, U, V, W, A, R }", dup_strings);
+  check_list_intersection ("{ 9, 8, 7, 6, 5, 4, 3, 2, 1 }",
+      "{ 1, 10, 11, 12, 13, 14, 15, 16, 8 }", ints);
+  check_list_intersection ("{ (fraction)60/2, (fraction)24/1, "
+      "(fraction)50/1, (fraction)25/1, (fraction)15/1, (fraction)12/1, "
+      "(fraction)10/1, (fraction)5/1 }", "{ (fraction)25/1, (fraction)30/1, "
+      "(fraction)1/1, (fraction)2/1, (fraction)3/1, (fraction)4/1, "
+      "(fraction)6/1, (fraction)7/1 }", fractions);
+  check_list_intersection ("{ A, B, C, D, E, F, G, Q }",
+      "{ Q, R, S, T, U, V, W, X }", single);
+  check_list_intersection ("{ A, B, C, D, E, F, G, H }",
+      "{ Q, R, S, T, U, V, W, X }", none);
+}
+
+GST_END_TEST;
+
 
 GST_START_TEST (test_value_subtract_int)
 {
@@ -3944,6 +4011,7 @@ gst_value_suite (void)
   tcase_add_test (tc_chain, test_deserialize_string);
   tcase_add_test (tc_chain, test_value_compare);
   tcase_add_test (tc_chain, test_value_intersect);
+  tcase_add_test (tc_chain, test_value_intersect_long_lists);
   tcase_add_test (tc_chain, test_value_subtract_int);
   tcase_add_test (tc_chain, test_value_subtract_int64);
   tcase_add_test (tc_chain, test_value_subtract_double);
@@ -305,6 +305,102 @@ create_and_fill_adapter (void)
   return adapter;
 }
 
+GST_START_TEST (test_map_vectored)
+{
+  GstAdapter *adapter;
+  const GstAdapterSpan *spans;
+  GstAdapterReader reader;
+  GstBuffer *buf;
+  guint8 data[64], copy[8];
+  const guint8 *ptr;
+  guint n_spans, i;
+  guint32 val32;
+  guint16 val16;
+  guint8 val8;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i;
+
+  adapter = gst_adapter_new ();
+
+  /* 0-9, 10-19 + 20-29 in two memories, 30-63 */
+  gst_adapter_push (adapter, gst_buffer_new_wrapped_full (0, data, 10, 0, 10,
+          NULL, NULL));
+  buf = gst_buffer_new_wrapped_full (0, data + 10, 10, 0, 10, NULL, NULL);
+  gst_buffer_append_memory (buf, gst_memory_new_wrapped (0, data + 20, 10, 0,
+          10, NULL, NULL));
+  gst_adapter_push (adapter, buf);
+  gst_adapter_push (adapter, gst_buffer_new_wrapped_full (0, data + 30, 34, 0,
+          34, NULL, NULL));
+
+  fail_unless (gst_adapter_map_vectored (adapter, 60, 5, &n_spans) == NULL);
+
+  /* the spans point into the original memory */
+  spans = gst_adapter_map_vectored (adapter, 5, 30, &n_spans);
+  fail_unless (spans != NULL);
+  fail_unless_equals_int (n_spans, 4);
+  fail_unless (spans[0].data == data + 5);
+  fail_unless_equals_int (spans[0].size, 5);
+  fail_unless (spans[1].data == data + 10);
+  fail_unless_equals_int (spans[1].size, 10);
+  fail_unless (spans[2].data == data + 20);
+  fail_unless_equals_int (spans[2].size, 10);
+  fail_unless (spans[3].data == data + 30);
+  fail_unless_equals_int (spans[3].size, 5);
+
+  gst_adapter_reader_init (&reader, spans, n_spans);
+  fail_unless_equals_int (gst_adapter_reader_get_remaining (&reader), 30);
+
+  fail_unless (gst_adapter_reader_get_uint8 (&reader, &val8));
+  fail_unless_equals_int (val8, 5);
+  fail_unless (gst_adapter_reader_peek_data (&reader, 4, &ptr));
+  fail_unless (ptr == data + 6);
+  /* crosses into the second span */
+  fail_unless (!gst_adapter_reader_peek_data (&reader, 5, &ptr));
+  fail_unless (gst_adapter_reader_copy (&reader, copy, 8));
+  fail_unless (memcmp (copy, data + 6, 8) == 0);
+  fail_unless_equals_int (gst_adapter_reader_get_pos (&reader), 1);
+
+  fail_unless (gst_adapter_reader_skip (&reader, 2));
+  fail_unless (gst_adapter_reader_get_uint32_be (&reader, &val32));
+  fail_unless_equals_int (val32, 0x08090a0b);
+  fail_unless (gst_adapter_reader_set_pos (&reader, 13));
+  fail_unless (gst_adapter_reader_get_uint16_le (&reader, &val16));
+  fail_unless_equals_int (val16, 0x1312);
+  fail_unless (gst_adapter_reader_get_uint32_le (&reader, &val32));
+  fail_unless_equals_int (val32, 0x17161514);
+  fail_unless (gst_adapter_reader_set_pos (&reader, 3));
+  fail_unless (gst_adapter_reader_get_uint16_be (&reader, &val16));
+  fail_unless_equals_int (val16, 0x0809);
+
+  fail_unless (gst_adapter_reader_set_pos (&reader, 28));
+  fail_unless (!gst_adapter_reader_get_uint32_be (&reader, &val32));
+  fail_unless (gst_adapter_reader_get_uint16_be (&reader, &val16));
+  fail_unless_equals_int (val16, 0x2122);
+  fail_unless_equals_int (gst_adapter_reader_get_remaining (&reader), 0);
+  fail_unless (!gst_adapter_reader_get_uint8 (&reader, &val8));
+  fail_unless (!gst_adapter_reader_skip (&reader, 1));
+  fail_unless (!gst_adapter_reader_set_pos (&reader, 31));
+
+  gst_adapter_unmap_vectored (adapter);
+
+  /* a range inside a single memory gives a single span */
+  spans = gst_adapter_map_vectored (adapter, 40, 10, &n_spans);
+  fail_unless_equals_int (n_spans, 1);
+  fail_unless (spans[0].data == data + 40);
+
+  /* flushing releases the mapping */
+  gst_adapter_flush (adapter, 12);
+  spans = gst_adapter_map_vectored (adapter, 0, 52, &n_spans);
+  fail_unless_equals_int (n_spans, 3);
+  fail_unless (spans[0].data == data + 12);
+  fail_unless_equals_int (spans[0].size, 8);
+
+  g_object_unref (adapter);
+}
+
+GST_END_TEST;
+
 /* Fill a buffer with a sequence of 32 bit ints and read them back out,
  * checking that they're still in the right order */
 GST_START_TEST (test_take_order)
@@ -1168,6 +1264,62 @@ GST_START_TEST (test_scan)
 
 GST_END_TEST;
 
+/* start codes split over buffers of different sizes must be found at the
+ * same positions as with a plain byte-wise scan */
+GST_START_TEST (test_scan_start_code)
+{
+  static const gsize sizes[] = { 1, 2, 3, 4, 5, 7, 16, 17, 19, 33, 100 };
+  static const gsize positions[] = { 0, 5, 14, 20, 31, 50, 99, 181, 252 };
+  guint8 data[256];
+  guint i, j, k;
+
+  memset (data, 0xff, sizeof (data));
+  for (i = 0; i < G_N_ELEMENTS (positions); i++) {
+    data[positions[i]] = 0x00;
+    data[positions[i] + 1] = 0x00;
+    data[positions[i] + 2] = 0x01;
+    data[positions[i] + 3] = i;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    GstAdapter *adapter = gst_adapter_new ();
+    gsize pos = 0;
+
+    while (pos < sizeof (data)) {
+      gsize len = MIN (sizes[i], sizeof (data) - pos);
+
+      gst_adapter_push (adapter,
+          gst_buffer_new_wrapped (g_memdup2 (data + pos, len), len));
+      pos += len;
+    }
+
+    for (j = 0; j < sizeof (data); j += 5) {
+      guint32 value = 0;
+      gssize expected = -1, found;
+
+      for (k = 0; k < G_N_ELEMENTS (positions); k++) {
+        if (positions[k] >= j) {
+          expected = positions[k];
+          break;
+        }
+      }
+      /* the byte after the start code must be inside the scanned range */
+      if (expected == 252)
+        expected = -1;
+
+      found = gst_adapter_masked_scan_uint32_peek (adapter, 0xffffff00,
+          0x00000100, j, sizeof (data) - j - 1, &value);
+      fail_unless_equals_int (found, expected);
+      if (found != -1)
+        fail_unless_equals_int (value, 0x00000100 | k);
+    }
+
+    g_object_unref (adapter);
+  }
+}
+
+GST_END_TEST;
+
 /* Fill a buffer with a sequence of 32 bit ints and read them back out
  * using take_buffer, checking that they're still in the right order */
 GST_START_TEST (test_take_list)
@@ -1465,6 +1617,8 @@ gst_adapter_suite (void)
   tcase_add_test (tc_chain, test_take_buf_order);
   tcase_add_test (tc_chain, test_timestamp);
   tcase_add_test (tc_chain, test_scan);
+  tcase_add_test (tc_chain, test_scan_start_code);
+  tcase_add_test (tc_chain, test_map_vectored);
   tcase_add_test (tc_chain, test_take_list);
   tcase_add_test (tc_chain, test_get_list);
   tcase_add_test (tc_chain, test_take_buffer_list);
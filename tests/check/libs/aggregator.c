@@ -742,7 +742,7 @@ _drop_buffer_probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 
 #define TIMEOUT_NUM_BUFFERS 20
 static void
-_test_timeout (gint buffer_wait)
+_test_timeout (gint buffer_wait, GstTaskPool * pool)
 {
   GstBus *bus;
   GstMessage *msg;
@@ -760,7 +760,7 @@ _test_timeout (gint buffer_wait)
       "sizemax", 4, "is-live", TRUE, "datarate", 4000, NULL);
 
   agg = gst_check_setup_element ("testaggregator");
-  g_object_set (agg, "latency", GST_USECOND, NULL);
+  g_object_set (agg, "latency", GST_USECOND, "task-pool", pool, NULL);
   sink = gst_check_setup_element ("fakesink");
   g_object_set (sink, "signal-handoffs", TRUE, NULL);
   g_signal_connect (sink, "handoff", (GCallback) handoff, &count);
@@ -801,14 +801,184 @@ _test_timeout (gint buffer_wait)
 
 GST_START_TEST (test_timeout_pipeline)
 {
-  _test_timeout (0);
+  _test_timeout (0, NULL);
 }
 
 GST_END_TEST;
 
 GST_START_TEST (test_timeout_pipeline_with_wait)
 {
-  _test_timeout (1000000 /* 1 ms */ );
+  _test_timeout (1000000 /* 1 ms */ , NULL);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_timeout_pipeline_task_pool)
+{
+  GstTaskPool *pool;
+
+  pool = gst_shared_task_pool_new ();
+  gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool), 1);
+  gst_task_pool_prepare (pool, NULL);
+
+  _test_timeout (1000000 /* 1 ms */ , pool);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static guint64
+_get_pad_stat (GstPad * pad, const gchar * field)
+{
+  GstStructure *stats;
+  guint64 val = 0;
+
+  g_object_get (pad, "stats", &stats, NULL);
+  fail_unless (stats != NULL);
+  fail_unless (gst_structure_has_name (stats,
+          "application/x-gst-aggregator-pad-stats"));
+  fail_unless (gst_structure_get_uint64 (stats, field, &val));
+  gst_structure_free (stats);
+
+  return val;
+}
+
+/* One live input never has data, with a quorum of one pad the other input
+ * does not have to wait for the huge latency every time */
+GST_START_TEST (test_quorum_pipeline)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstElement *pipeline, *src, *src1, *agg, *sink;
+  GstPad *srcpad, *src1pad, *aggpad, *aggpad1;
+  gint count = 0;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  src = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src, "num-buffers", TIMEOUT_NUM_BUFFERS, "sizetype", 2,
+      "sizemax", 4, "is-live", TRUE, "datarate", 4000, NULL);
+
+  src1 = gst_element_factory_make ("fakesrc", NULL);
+  g_object_set (src1, "num-buffers", TIMEOUT_NUM_BUFFERS, "sizetype", 2,
+      "sizemax", 4, "is-live", TRUE, "datarate", 4000, NULL);
+
+  agg = gst_check_setup_element ("testaggregator");
+  g_object_set (agg, "latency", 10 * GST_SECOND, "quorum", 1, NULL);
+  sink = gst_check_setup_element ("fakesink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", (GCallback) handoff, &count);
+
+  fail_unless (gst_bin_add (GST_BIN (pipeline), src));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), src1));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), agg));
+  fail_unless (gst_bin_add (GST_BIN (pipeline), sink));
+
+  src1pad = gst_element_get_static_pad (src1, "src");
+  fail_if (src1pad == NULL);
+  gst_pad_add_probe (src1pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
+      (GstPadProbeCallback) _drop_buffer_probe_cb, GINT_TO_POINTER (0), NULL);
+
+  fail_unless (gst_element_link (src, agg));
+  fail_unless (gst_element_link (src1, agg));
+  fail_unless (gst_element_link (agg, sink));
+
+  srcpad = gst_element_get_static_pad (src, "src");
+  aggpad = gst_pad_get_peer (srcpad);
+  aggpad1 = gst_pad_get_peer (src1pad);
+  gst_object_unref (srcpad);
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (bus == NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  fail_if (count < TIMEOUT_NUM_BUFFERS);
+
+  fail_unless_equals_uint64 (_get_pad_stat (aggpad, "buffers"),
+      TIMEOUT_NUM_BUFFERS);
+  fail_unless_equals_uint64 (_get_pad_stat (aggpad, "late"), 0);
+  fail_unless_equals_uint64 (_get_pad_stat (aggpad1, "buffers"), 0);
+  fail_unless (_get_pad_stat (aggpad1, "missed") > 0);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (aggpad);
+  gst_object_unref (aggpad1);
+  gst_object_unref (src1pad);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+#define TASK_POOL_AGGREGATORS 3
+
+/* Test several aggregators that share a single task pool thread */
+GST_START_TEST (test_task_pool_pipeline)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  GstElement *pipeline;
+  GstTaskPool *pool, *agg_pool;
+  gint counts[TASK_POOL_AGGREGATORS] = { 0, };
+  gint i;
+
+  pool = gst_shared_task_pool_new ();
+  gst_shared_task_pool_set_max_threads (GST_SHARED_TASK_POOL (pool), 1);
+  gst_task_pool_prepare (pool, NULL);
+
+  pipeline = gst_pipeline_new ("pipeline");
+  for (i = 0; i < TASK_POOL_AGGREGATORS; i++) {
+    GstElement *src, *src1, *agg, *sink;
+
+    src = gst_element_factory_make ("fakesrc", NULL);
+    g_object_set (src, "num-buffers", NUM_BUFFERS, "sizetype", 2, "sizemax",
+        4, NULL);
+    src1 = gst_element_factory_make ("fakesrc", NULL);
+    g_object_set (src1, "num-buffers", NUM_BUFFERS + 1, "sizetype", 2,
+        "sizemax", 4, NULL);
+
+    agg = gst_element_factory_make ("testaggregator", NULL);
+    g_object_set (agg, "task-pool", pool, NULL);
+    g_object_get (agg, "task-pool", &agg_pool, NULL);
+    fail_unless (agg_pool == pool);
+    gst_object_unref (agg_pool);
+
+    /* don't block the only pool thread in preroll */
+    sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (sink, "signal-handoffs", TRUE, "async", FALSE, NULL);
+    g_signal_connect (sink, "handoff", (GCallback) handoff, &counts[i]);
+
+    fail_unless (gst_bin_add (GST_BIN (pipeline), src));
+    fail_unless (gst_bin_add (GST_BIN (pipeline), src1));
+    fail_unless (gst_bin_add (GST_BIN (pipeline), agg));
+    fail_unless (gst_bin_add (GST_BIN (pipeline), sink));
+    fail_unless (gst_element_link (src, agg));
+    fail_unless (gst_element_link (src1, agg));
+    fail_unless (gst_element_link (agg, sink));
+  }
+
+  bus = gst_element_get_bus (pipeline);
+  fail_if (bus == NULL);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  msg = gst_bus_poll (bus, GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  for (i = 0; i < TASK_POOL_AGGREGATORS; i++)
+    fail_unless_equals_int (counts[i], NUM_BUFFERS + 1);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
 }
 
 GST_END_TEST;
@@ -1368,6 +1538,9 @@ gst_aggregator_suite (void)
   tcase_add_test (general, test_two_src_pipeline);
   tcase_add_test (general, test_timeout_pipeline);
   tcase_add_test (general, test_timeout_pipeline_with_wait);
+  tcase_add_test (general, test_timeout_pipeline_task_pool);
+  tcase_add_test (general, test_quorum_pipeline);
+  tcase_add_test (general, test_task_pool_pipeline);
   tcase_add_test (general, test_add_remove);
   tcase_add_test (general, test_change_state_intensive);
   tcase_add_test (general, test_flush_on_aggregate);
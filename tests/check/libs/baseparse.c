@@ -39,6 +39,7 @@ static gchar *raw_buffer = NULL;
 static gint raw_buffer_size = 0;
 static gint buffer_pull_count = 0;
 static gint current_offset = 0;
+static gint buffer_list_count = 0;
 
 #define TEST_VIDEO_WIDTH 640
 #define TEST_VIDEO_HEIGHT 480
@@ -60,6 +61,9 @@ struct _GstParserTester
 
   /* don't immediately set the src caps when receiving sink caps */
   gboolean delay_srccaps;
+
+  /* finish all complete frames at once with gst_base_parse_finish_frames() */
+  gboolean frame_list;
 };
 
 struct _GstParserTesterClass
@@ -134,6 +138,19 @@ gst_parser_tester_handle_frame (GstBaseParse * parse,
    * a full frame */
   test->last_frame_size = 0;
 
+  if (test->frame_list) {
+    gint sizes[16];
+    guint i, n_frames = MIN (frame_size / test->min_frame_size, 16);
+
+    for (i = 0; i < n_frames; i++)
+      sizes[i] = test->min_frame_size;
+
+    GST_BUFFER_DURATION (frame->buffer) =
+        gst_util_uint64_scale_round (GST_SECOND, TEST_VIDEO_FPS_D,
+        TEST_VIDEO_FPS_N);
+    return gst_base_parse_finish_frames (parse, frame, sizes, n_frames);
+  }
+
   while (frame_size >= test->min_frame_size) {
     GST_BUFFER_DURATION (frame->buffer) =
         gst_util_uint64_scale_round (GST_SECOND, TEST_VIDEO_FPS_D,
@@ -341,6 +358,108 @@ GST_START_TEST (parser_playback)
 GST_END_TEST;
 
 
+static GstPadProbeReturn
+count_buffer_lists (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  buffer_list_count++;
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (parser_playback_frame_list)
+{
+  GList *input = NULL;
+  GstBuffer *buffer;
+  gint i;
+
+  setup_parsertester ();
+  ((GstParserTester *) parsetest)->frame_list = TRUE;
+  gst_pad_add_probe (GST_BASE_PARSE_SRC_PAD (parsetest),
+      GST_PAD_PROBE_TYPE_BUFFER_LIST, count_buffer_lists, NULL, NULL);
+  buffer_list_count = 0;
+
+  /* every input buffer carries 3 frames, only the first one is timestamped */
+  for (i = 0; i < 6; i += 3) {
+    buffer = create_test_buffer (i);
+    buffer = gst_buffer_append (buffer, create_test_buffer (i + 1));
+    buffer = gst_buffer_append (buffer, create_test_buffer (i + 2));
+    input = g_list_append (input, buffer);
+  }
+
+  run_parser_playback_test (input, 6, 1.0);
+
+  /* one list per input buffer */
+  fail_unless_equals_int (buffer_list_count, 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (parser_save_load_index)
+{
+  GstBaseParse *parse;
+  GBytes *index, *reloaded, *garbage;
+  const guint8 *data;
+  gsize size;
+
+  setup_parsertester ();
+  parse = GST_BASE_PARSE (parsetest);
+
+  /* no index before the first stream */
+  fail_unless (gst_base_parse_save_index (parse) == NULL);
+
+  gst_element_set_state (parsetest, GST_STATE_PAUSED);
+
+  fail_unless (gst_base_parse_add_index_entry (parse, 2000, 2 * GST_SECOND,
+          TRUE, TRUE));
+  fail_unless (gst_base_parse_add_index_entry (parse, 0, 0, TRUE, TRUE));
+  fail_unless (gst_base_parse_add_index_entry (parse, 1000, GST_SECOND,
+          TRUE, TRUE));
+  /* delta units are not stored */
+  fail_unless (gst_base_parse_add_index_entry (parse, 1500,
+          3 * GST_SECOND / 2, FALSE, TRUE));
+
+  index = gst_base_parse_save_index (parse);
+  fail_unless (index != NULL);
+  data = g_bytes_get_data (index, &size);
+  fail_unless_equals_int (size, 24 + 3 * 16);
+  fail_unless (memcmp (data, "GstBPIdx", 8) == 0);
+  /* sorted by time */
+  fail_unless_equals_uint64 (GST_READ_UINT64_LE (data + 24), 0);
+  fail_unless_equals_uint64 (GST_READ_UINT64_LE (data + 40), GST_SECOND);
+  fail_unless_equals_uint64 (GST_READ_UINT64_LE (data + 48), 1000);
+  fail_unless_equals_uint64 (GST_READ_UINT64_LE (data + 56), 2 * GST_SECOND);
+
+  /* a new stream starts with an empty index, unless one was loaded */
+  gst_element_set_state (parsetest, GST_STATE_NULL);
+  fail_unless (gst_base_parse_load_index (parse, index));
+  gst_element_set_state (parsetest, GST_STATE_PAUSED);
+  reloaded = gst_base_parse_save_index (parse);
+  fail_unless (g_bytes_equal (index, reloaded));
+  g_bytes_unref (reloaded);
+
+  /* loading again in PAUSED merges with the existing entries */
+  fail_unless (gst_base_parse_load_index (parse, index));
+  reloaded = gst_base_parse_save_index (parse);
+  fail_unless (g_bytes_equal (index, reloaded));
+  g_bytes_unref (reloaded);
+
+  /* truncated and corrupted data is rejected */
+  garbage = g_bytes_new_from_bytes (index, 0, size - 1);
+  fail_if (gst_base_parse_load_index (parse, garbage));
+  g_bytes_unref (garbage);
+  /* unknown version */
+  garbage = g_bytes_new_static ("GstBPIdx\2\0\0\0\0\0\0\0"
+      "\0\0\0\0\0\0\0\0", 24);
+  fail_if (gst_base_parse_load_index (parse, garbage));
+  g_bytes_unref (garbage);
+
+  g_bytes_unref (index);
+
+  gst_element_set_state (parsetest, GST_STATE_NULL);
+  cleanup_parsertest ();
+}
+
+GST_END_TEST;
+
 /* Check https://bugzilla.gnome.org/show_bug.cgi?id=721941 */
 GST_START_TEST (parser_reverse_playback_on_passthrough)
 {
@@ -749,6 +868,8 @@ gst_baseparse_suite (void)
   suite_add_tcase (s, tc);
   tcase_add_checked_fixture (tc, baseparse_setup, baseparse_teardown);
   tcase_add_test (tc, parser_playback);
+  tcase_add_test (tc, parser_playback_frame_list);
+  tcase_add_test (tc, parser_save_load_index);
   tcase_add_test (tc, parser_empty_stream);
   tcase_add_test (tc, parser_reverse_playback_on_passthrough);
   tcase_add_test (tc, parser_reverse_playback);
@@ -23,6 +23,7 @@
 #endif
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
+#include <gst/check/gsttestclock.h>
 #include <gst/base/gstbasesink.h>
 
 GST_START_TEST (basesink_last_sample_enabled)
@@ -282,6 +283,233 @@ GST_START_TEST (basesink_position_query_handles_segment_offset)
 
 GST_END_TEST;
 
+typedef GstBaseSink GstGroupTestSink;
+typedef GstBaseSinkClass GstGroupTestSinkClass;
+
+static GType gst_group_test_sink_get_type (void);
+G_DEFINE_TYPE (GstGroupTestSink, gst_group_test_sink, GST_TYPE_BASE_SINK);
+
+static GstStaticPadTemplate group_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GArray *rendered_groups;
+
+static GstFlowReturn
+gst_group_test_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  guint len = gst_buffer_list_length (list);
+
+  g_array_append_val (rendered_groups, len);
+
+  return GST_FLOW_OK;
+}
+
+static void
+gst_group_test_sink_class_init (GstGroupTestSinkClass * klass)
+{
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &group_sink_template);
+  gst_element_class_set_metadata (GST_ELEMENT_CLASS (klass),
+      "Group test sink", "Sink", "Records rendered buffer lists", "Test");
+
+  klass->render_list = gst_group_test_sink_render_list;
+}
+
+static void
+gst_group_test_sink_init (GstGroupTestSink * sink)
+{
+}
+
+GST_START_TEST (basesink_sync_window)
+{
+  GstElement *pipeline, *sink;
+  GstBufferList *list;
+  GstStructure *stats;
+  GstSegment segment;
+  GstPad *pad;
+  guint64 rendered;
+  guint i;
+
+  rendered_groups = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  sink = g_object_new (gst_group_test_sink_get_type (), NULL);
+  g_object_set (sink, "async", FALSE, "sync", TRUE,
+      "sync-window", (guint64) GST_MSECOND, NULL);
+  pad = gst_element_get_static_pad (sink, "sink");
+
+  pipeline = gst_pipeline_new (NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_send_event (pad, gst_event_new_stream_start ("test")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_send_event (pad, gst_event_new_segment (&segment)));
+
+  /* buffers every 0.4ms, a 1ms window groups three of them */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 6; i++) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    GST_BUFFER_PTS (buf) = i * 400 * GST_USECOND;
+    GST_BUFFER_DURATION (buf) = 400 * GST_USECOND;
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_pad_chain_list (pad, list), GST_FLOW_OK);
+
+  fail_unless_equals_int (rendered_groups->len, 2);
+  fail_unless_equals_int (g_array_index (rendered_groups, guint, 0), 3);
+  fail_unless_equals_int (g_array_index (rendered_groups, guint, 1), 3);
+
+  g_object_get (sink, "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "rendered", &rendered));
+  fail_unless_equals_int (rendered, 6);
+  gst_structure_free (stats);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pad);
+  gst_object_unref (pipeline);
+  g_array_unref (rendered_groups);
+}
+
+GST_END_TEST;
+
+static void
+count_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gint * count)
+{
+  g_atomic_int_inc (count);
+}
+
+GST_START_TEST (basesink_async_clock_wait)
+{
+  GstElement *pipeline, *sink;
+  GstTaskPool *pool;
+  GstSegment segment;
+  GstBuffer *buf;
+  GstPad *pad;
+  gint count = 0;
+
+  pool = gst_shared_task_pool_new ();
+  gst_task_pool_prepare (pool, NULL);
+
+  sink = gst_element_factory_make ("fakesink", "sink");
+  g_object_set (sink, "async", FALSE, "sync", TRUE, "signal-handoffs", TRUE,
+      "task-pool", pool, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (count_handoff), &count);
+  pad = gst_element_get_static_pad (sink, "sink");
+
+  pipeline = gst_pipeline_new (NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_send_event (pad, gst_event_new_stream_start ("test")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_send_event (pad, gst_event_new_segment (&segment)));
+
+  /* the buffer is only rendered after the clock reached its time, but the
+   * streaming thread does not wait for it */
+  buf = gst_buffer_new ();
+  GST_BUFFER_PTS (buf) = 500 * GST_MSECOND;
+  fail_unless_equals_int (gst_pad_chain (pad, buf), GST_FLOW_OK);
+  fail_unless_equals_int (g_atomic_int_get (&count), 0);
+
+  /* serialized events wait for the pending buffers */
+  fail_unless (gst_pad_send_event (pad, gst_event_new_eos ()));
+  fail_unless_equals_int (g_atomic_int_get (&count), 1);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pad);
+  gst_object_unref (pipeline);
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_qos_probe (GstPad * pad, GstPadProbeInfo * info, gint * count)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_QOS)
+    *count += 1;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* pushes 20 late buffers, 10ms apart, and returns the number of QoS events
+ * that were sent upstream */
+static gint
+push_late_buffers (GstClockTime qos_interval)
+{
+  GstElement *pipeline, *sink;
+  GstPad *srcpad, *sinkpad;
+  GstClock *clock;
+  GstSegment segment;
+  gint count = 0;
+  guint i;
+
+  clock = gst_test_clock_new ();
+  sink = gst_element_factory_make ("fakesink", "sink");
+  g_object_set (sink, "async", FALSE, "sync", TRUE, "qos", TRUE,
+      "qos-interval", qos_interval, NULL);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  pipeline = gst_pipeline_new (NULL);
+  gst_pipeline_use_clock (GST_PIPELINE (pipeline), clock);
+  gst_bin_add (GST_BIN (pipeline), sink);
+
+  srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_add_probe (srcpad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      (GstPadProbeCallback) count_qos_probe, &count, NULL);
+  fail_unless_equals_int (gst_pad_link (srcpad, sinkpad), GST_PAD_LINK_OK);
+  gst_pad_set_active (srcpad, TRUE);
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_stream_start ("test")));
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (srcpad, gst_event_new_segment (&segment)));
+
+  gst_test_clock_set_time (GST_TEST_CLOCK (clock), GST_SECOND);
+  for (i = 0; i < 20; i++) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    GST_BUFFER_PTS (buf) = i * 10 * GST_MSECOND;
+    GST_BUFFER_DURATION (buf) = 10 * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (srcpad, buf), GST_FLOW_OK);
+  }
+
+  fail_unless_equals_int (gst_element_set_state (pipeline, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  gst_pad_set_active (srcpad, FALSE);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (pipeline);
+  gst_object_unref (clock);
+
+  return count;
+}
+
+GST_START_TEST (basesink_qos_interval)
+{
+  /* the first buffer only starts the measurements, all others are reported
+   * by default */
+  fail_unless_equals_int (push_late_buffers (0), 19);
+
+  /* with an interval of 100ms, only the buffers at 10ms and 110ms are */
+  fail_unless_equals_int (push_late_buffers (100 * GST_MSECOND), 2);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_basesrc_suite (void)
 {
@@ -294,6 +522,9 @@ gst_basesrc_suite (void)
   tcase_add_test (tc, basesink_test_gap);
   tcase_add_test (tc, basesink_test_eos_after_playing);
   tcase_add_test (tc, basesink_position_query_handles_segment_offset);
+  tcase_add_test (tc, basesink_sync_window);
+  tcase_add_test (tc, basesink_async_clock_wait);
+  tcase_add_test (tc, basesink_qos_interval);
 
   return s;
 }
@@ -27,6 +27,7 @@
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstconsistencychecker.h>
 #include <gst/base/gstbasesrc.h>
+#include <gst/base/gstpushsrc.h>
 
 static GstPadProbeReturn
 eos_event_counter (GstObject * pad, GstPadProbeInfo * info, guint * p_num_eos)
@@ -1108,6 +1109,129 @@ GST_START_TEST (basesrc_negotiate)
 
 GST_END_TEST;
 
+typedef struct
+{
+  GstPushSrc parent;
+  guint n_created;
+} ListSrc;
+
+typedef GstPushSrcClass ListSrcClass;
+
+static GType list_src_get_type (void);
+
+G_DEFINE_TYPE (ListSrc, list_src, GST_TYPE_PUSH_SRC);
+
+static void
+list_src_init (ListSrc * src)
+{
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+  gst_base_src_set_buffers_per_list (GST_BASE_SRC (src), 4);
+}
+
+static GstFlowReturn
+list_src_create_list (GstPushSrc * psrc, guint max_buffers,
+    GstBufferList * list)
+{
+  ListSrc *src = (ListSrc *) psrc;
+  guint i;
+
+  fail_unless (max_buffers > 0 && max_buffers <= 4);
+
+  for (i = 0; i < max_buffers; i++) {
+    GstBuffer *buf = gst_buffer_new ();
+
+    GST_BUFFER_OFFSET (buf) = src->n_created;
+    GST_BUFFER_PTS (buf) = src->n_created * GST_SECOND;
+    GST_BUFFER_DURATION (buf) = GST_SECOND;
+    src->n_created++;
+    gst_buffer_list_add (list, buf);
+  }
+
+  return GST_FLOW_OK;
+}
+
+static void
+list_src_class_init (ListSrcClass * klass)
+{
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &src_template);
+
+  klass->create_list = list_src_create_list;
+}
+
+static GList *list_lengths;
+
+static GstFlowReturn
+batch_chainlist_func (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  list_lengths = g_list_append (list_lengths,
+      GUINT_TO_POINTER (gst_buffer_list_length (list)));
+
+  return chainlist_func (pad, parent, list);
+}
+
+static gboolean
+batch_event_func (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&check_mutex);
+    done = TRUE;
+    g_cond_signal (&check_cond);
+    g_mutex_unlock (&check_mutex);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+GST_START_TEST (basesrc_create_list)
+{
+  GstElement *src;
+  gint64 position;
+
+  src = g_object_new (list_src_get_type (), "num-buffers", 10, NULL);
+
+  mysinkpad = gst_check_setup_sink_pad (src, &sinktemplate);
+  gst_pad_set_chain_list_function (mysinkpad, batch_chainlist_func);
+  gst_pad_set_event_function (mysinkpad, batch_event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  done = FALSE;
+  expect_offset = 0;
+  list_lengths = NULL;
+
+  gst_element_set_state (src, GST_STATE_PLAYING);
+
+  g_mutex_lock (&check_mutex);
+  while (!done)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* num-buffers limits the size of the last list */
+  fail_unless_equals_int (expect_offset, 10);
+  fail_unless_equals_int (((ListSrc *) src)->n_created, 10);
+  fail_unless_equals_int (g_list_length (list_lengths), 3);
+  fail_unless_equals_int (GPOINTER_TO_UINT (list_lengths->data), 4);
+  fail_unless_equals_int (GPOINTER_TO_UINT (list_lengths->next->data), 4);
+  fail_unless_equals_int (GPOINTER_TO_UINT (list_lengths->next->next->data),
+      2);
+
+  /* the position is after the last buffer of every list */
+  fail_unless (gst_pad_query_position (GST_BASE_SRC_PAD (src),
+          GST_FORMAT_TIME, &position));
+  fail_unless_equals_uint64 (position, 10 * GST_SECOND);
+
+  gst_element_set_state (src, GST_STATE_NULL);
+
+  gst_check_teardown_sink_pad (src);
+
+  gst_object_unref (src);
+  g_list_free (list_lengths);
+  list_lengths = NULL;
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_basesrc_suite (void)
 {
@@ -1126,6 +1250,7 @@ gst_basesrc_suite (void)
   tcase_add_test (tc, basesrc_create_bufferlist);
   tcase_add_test (tc, basesrc_time_automatic_eos);
   tcase_add_test (tc, basesrc_negotiate);
+  tcase_add_test (tc, basesrc_create_list);
 
   return s;
 }
@@ -235,6 +235,76 @@ GST_START_TEST (test_position_tracking)
 
 GST_END_TEST;
 
+GST_START_TEST (test_get_bits_word)
+{
+  guint8 data[24];
+  GstBitReader reader = GST_BIT_READER_INIT (data, sizeof (data));
+  guint i, pos, nbits;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = (i * 73 + 29) & 0xff;
+
+  /* compare against reading the same bits one at a time, near the end of
+   * the data too where the bits can't be loaded as one word */
+  for (pos = 0; pos < sizeof (data) * 8; pos++) {
+    for (nbits = 1; nbits <= 64 && pos + nbits <= sizeof (data) * 8; nbits++) {
+      guint64 val = 0, expected = 0;
+      guint j;
+
+      for (j = 0; j < nbits; j++) {
+        guint b = pos + j;
+
+        expected = (expected << 1) | ((data[b / 8] >> (7 - b % 8)) & 1);
+      }
+
+      fail_unless (gst_bit_reader_set_pos (&reader, pos));
+      fail_unless (gst_bit_reader_get_bits_uint64 (&reader, &val, nbits));
+      fail_unless_equals_uint64 (val, expected);
+      fail_unless_equals_int (gst_bit_reader_get_pos (&reader), pos + nbits);
+    }
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_exp_golomb)
+{
+  /* 1 010 011 00100 00111 0001000, then 31 zeros followed by 32 ones */
+  guint8 data[] = { 0xa6, 0x43, 0x88, 0x00, 0x00, 0x00, 0x01, 0xff,
+    0xff, 0xff, 0xfc
+  };
+  const guint32 ue_values[] = { 0, 1, 2, 3, 6, 7, G_MAXUINT32 - 1 };
+  const gint32 se_values[] = { 0, 1, -1, 2, -3, 4, G_MININT32 + 1 };
+  GstBitReader reader = GST_BIT_READER_INIT (data, sizeof (data));
+  guint32 ue;
+  gint32 se;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (ue_values); i++) {
+    fail_unless (gst_bit_reader_get_ue (&reader, &ue));
+    fail_unless_equals_int64 (ue, ue_values[i]);
+  }
+  fail_unless_equals_int (gst_bit_reader_get_pos (&reader), 87);
+
+  /* only a zero bit is left */
+  fail_if (gst_bit_reader_get_ue (&reader, &ue));
+  fail_unless_equals_int (gst_bit_reader_get_pos (&reader), 87);
+
+  gst_bit_reader_init (&reader, data, sizeof (data));
+  for (i = 0; i < G_N_ELEMENTS (se_values); i++) {
+    fail_unless (gst_bit_reader_get_se (&reader, &se));
+    fail_unless_equals_int (se, se_values[i]);
+  }
+
+  /* truncated code: 0001 with only one more bit left */
+  gst_bit_reader_init (&reader, data, 2);
+  fail_unless (gst_bit_reader_set_pos (&reader, 11));
+  fail_if (gst_bit_reader_get_ue (&reader, &ue));
+  fail_unless_equals_int (gst_bit_reader_get_pos (&reader), 11);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bit_reader_suite (void)
 {
@@ -246,6 +316,8 @@ gst_bit_reader_suite (void)
   tcase_add_test (tc_chain, test_initialization);
   tcase_add_test (tc_chain, test_get_bits);
   tcase_add_test (tc_chain, test_position_tracking);
+  tcase_add_test (tc_chain, test_get_bits_word);
+  tcase_add_test (tc_chain, test_exp_golomb);
 
   return s;
 }
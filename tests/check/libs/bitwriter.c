@@ -210,6 +210,47 @@ GST_START_TEST (test_reset_data_unaligned)
 
 GST_END_TEST;
 
+GST_START_TEST (test_chunked)
+{
+  GstBitWriter chunked, plain;
+  GstBuffer *buf;
+  guint8 *data;
+  guint i, size;
+
+  gst_bit_writer_init_chunked (&chunked, NULL, NULL, 2);
+  gst_bit_writer_init (&plain);
+
+  for (i = 0; i < 20; i++) {
+    fail_unless (gst_bit_writer_put_bits_uint8 (&chunked, i, 5));
+    fail_unless (gst_bit_writer_put_bits_uint16 (&chunked, i * 97, 11));
+    fail_unless (gst_bit_writer_put_bits_uint8 (&chunked, 1, 1));
+    fail_unless (gst_bit_writer_put_bits_uint8 (&plain, i, 5));
+    fail_unless (gst_bit_writer_put_bits_uint16 (&plain, i * 97, 11));
+    fail_unless (gst_bit_writer_put_bits_uint8 (&plain, 1, 1));
+  }
+  fail_unless (gst_bit_writer_align_bytes (&chunked, 1));
+  fail_unless (gst_bit_writer_align_bytes (&plain, 1));
+
+  size = gst_bit_writer_get_size (&plain) >> 3;
+
+  buf = gst_bit_writer_reset_and_get_buffer (&chunked);
+  fail_unless (gst_buffer_n_memory (buf) > 1);
+  fail_unless_equals_int (gst_buffer_get_size (buf), size);
+  fail_unless (gst_buffer_memcmp (buf, 0, gst_bit_writer_get_data (&plain),
+          size) == 0);
+  gst_buffer_unref (buf);
+
+  gst_bit_writer_init_chunked (&chunked, NULL, NULL, 0);
+  fail_unless (gst_bit_writer_put_bits_uint32 (&chunked, 0x12345678, 32));
+  data = gst_bit_writer_reset_and_get_data (&chunked);
+  fail_unless_equals_int (GST_READ_UINT32_BE (data), 0x12345678);
+  g_free (data);
+
+  gst_bit_writer_reset (&plain);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bit_writer_suite (void)
 {
@@ -222,6 +263,7 @@ gst_bit_writer_suite (void)
   tcase_add_test (tc_chain, test_data);
   tcase_add_test (tc_chain, test_reset);
   tcase_add_test (tc_chain, test_reset_data_unaligned);
+  tcase_add_test (tc_chain, test_chunked);
 
   return s;
 }
@@ -608,6 +608,65 @@ GST_START_TEST (test_scan)
 
 GST_END_TEST;
 
+GST_START_TEST (test_find_start_code)
+{
+  GstByteReader reader;
+  guint8 *data;
+  guint i, j, size = 200;
+
+  data = g_malloc (size);
+
+  /* place a single start code at every position so that the vector and
+   * scalar parts of the scan are both exercised */
+  for (i = 0; i + 3 <= size; i++) {
+    memset (data, 0xff, size);
+    data[i] = 0x00;
+    data[i + 1] = 0x00;
+    data[i + 2] = 0x01;
+    /* a lone zero in front must not be mistaken for the prefix */
+    if (i > 1)
+      data[i - 2] = 0x00;
+
+    gst_byte_reader_init (&reader, data, size);
+    fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0,
+            size), i);
+    fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0,
+            i + 3), i);
+    fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0,
+            i + 2), -1);
+    if (i > 0)
+      fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, i,
+              size - i), i);
+    fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, i + 1,
+            size - i - 1), -1);
+
+    /* offsets are relative to the current position */
+    if (i >= 10) {
+      fail_unless (gst_byte_reader_skip (&reader, 10));
+      fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0,
+              size - 10), i - 10);
+    }
+  }
+
+  /* all zeroes contain no start code, followed by one at the very end */
+  memset (data, 0x00, size);
+  gst_byte_reader_init (&reader, data, size);
+  fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0, size),
+      -1);
+  data[size - 1] = 0x01;
+  fail_unless_equals_int (gst_byte_reader_find_start_code (&reader, 0, size),
+      size - 3);
+
+  /* not enough data for the prefix */
+  for (j = 1; j < 3; j++)
+    fail_unless_equals_int (gst_byte_reader_find_start_code (&reader,
+            size - j, j), -1);
+
+  g_free (data);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_string_funcs)
 {
   GstByteReader reader, backup;
@@ -836,6 +895,7 @@ gst_byte_reader_suite (void)
   tcase_add_test (tc_chain, test_get_float_be);
   tcase_add_test (tc_chain, test_position_tracking);
   tcase_add_test (tc_chain, test_scan);
+  tcase_add_test (tc_chain, test_find_start_code);
   tcase_add_test (tc_chain, test_string_funcs);
   tcase_add_test (tc_chain, test_dup_string);
   tcase_add_test (tc_chain, test_sub_reader);
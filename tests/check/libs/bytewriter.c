@@ -237,6 +237,60 @@ GST_START_TEST (test_fill)
 }
 
 GST_END_TEST;
+
+GST_START_TEST (test_chunked)
+{
+  GstByteWriter writer;
+  GstBuffer *buf;
+  GstMapInfo info;
+  guint8 *data;
+  guint i;
+
+  gst_byte_writer_init_chunked (&writer, NULL, NULL, 16);
+  fail_unless_equals_int (gst_byte_writer_get_remaining (&writer), -1);
+
+  for (i = 0; i < 10; i++)
+    fail_unless (gst_byte_writer_put_uint32_be (&writer, i));
+
+  /* positions are relative to the current chunk */
+  fail_unless_equals_int (gst_byte_writer_get_pos (&writer), 8);
+  fail_unless (gst_byte_writer_set_pos (&writer, 6));
+  fail_unless (gst_byte_writer_put_uint8 (&writer, 0xaa));
+  fail_unless (gst_byte_writer_fill (&writer, 0x55, 40));
+  fail_unless (gst_byte_writer_set_pos (&writer, 0));
+  fail_unless (gst_byte_writer_put_uint8 (&writer, 0x11));
+
+  buf = gst_byte_writer_reset_and_get_buffer (&writer);
+  fail_unless_equals_int (gst_buffer_n_memory (buf), 4);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 39 + 40);
+
+  fail_unless (gst_buffer_map (buf, &info, GST_MAP_READ));
+  for (i = 0; i < 9; i++)
+    fail_unless_equals_int (GST_READ_UINT32_BE (info.data + i * 4), i);
+  fail_unless_equals_int (GST_READ_UINT16_BE (info.data + 36), 0);
+  fail_unless_equals_int (info.data[38], 0xaa);
+  fail_unless_equals_int (info.data[39], 0x11);
+  for (i = 40; i < info.size; i++)
+    fail_unless_equals_int (info.data[i], 0x55);
+  gst_buffer_unmap (buf, &info);
+  gst_buffer_unref (buf);
+
+  /* an empty writer gives an empty buffer */
+  gst_byte_writer_init_chunked (&writer, NULL, NULL, 0);
+  buf = gst_byte_writer_reset_and_get_buffer (&writer);
+  fail_unless_equals_int (gst_buffer_get_size (buf), 0);
+  gst_buffer_unref (buf);
+
+  gst_byte_writer_init_chunked (&writer, NULL, NULL, 4);
+  fail_unless (gst_byte_writer_put_string (&writer, "chunked"));
+  fail_unless (gst_byte_writer_put_uint16_le (&writer, 0x0201));
+  data = gst_byte_writer_reset_and_get_data (&writer);
+  fail_unless (memcmp (data, "chunked\0\001\002", 10) == 0);
+  g_free (data);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_byte_writer_suite (void)
 {
@@ -251,6 +305,7 @@ gst_byte_writer_suite (void)
   tcase_add_test (tc_chain, test_from_data);
   tcase_add_test (tc_chain, test_put_data_strings);
   tcase_add_test (tc_chain, test_fill);
+  tcase_add_test (tc_chain, test_chunked);
 
   return s;
 }
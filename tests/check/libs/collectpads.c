@@ -331,6 +331,26 @@ collected_cb (GstCollectPads * pads, gpointer user_data)
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+collected_all_cb (GstCollectPads * pads, gpointer user_data)
+{
+  GstBuffer *buffers[3];
+
+  /* more entries than pads, the last one must be cleared */
+  buffers[2] = (GstBuffer *) 0x1;
+  fail_unless_equals_int (gst_collect_pads_pop_all (pads, buffers, 3), 2);
+  fail_unless (buffers[2] == NULL);
+  outbuf1 = buffers[0];
+  outbuf2 = buffers[1];
+
+  g_mutex_lock (&lock);
+  collected = TRUE;
+  g_cond_signal (&cond);
+  g_mutex_unlock (&lock);
+
+  return GST_FLOW_OK;
+}
+
 static GstFlowReturn
 handle_buffer_cb (GstCollectPads * pads, GstCollectData * data,
     GstBuffer * buf, gpointer user_data)
@@ -498,6 +518,52 @@ GST_START_TEST (test_collect)
 GST_END_TEST;
 
 
+GST_START_TEST (test_collect_pop_all)
+{
+  GstBuffer *buf1, *buf2;
+  GThread *thread1, *thread2;
+
+  gst_collect_pads_set_function (collect, collected_all_cb, NULL);
+
+  data1 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad1, sizeof (TestData), NULL, TRUE);
+  fail_unless (data1 != NULL);
+
+  data2 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad2, sizeof (TestData), NULL, TRUE);
+  fail_unless (data2 != NULL);
+
+  buf1 = gst_buffer_new ();
+  buf2 = gst_buffer_new ();
+
+  gst_collect_pads_start (collect);
+
+  data1->pad = srcpad1;
+  data1->buffer = buf1;
+  thread1 = g_thread_try_new ("gst-check", push_buffer, data1, NULL);
+  fail_unless_collected (FALSE);
+
+  data2->pad = srcpad2;
+  data2->buffer = buf2;
+  thread2 = g_thread_try_new ("gst-check", push_buffer, data2, NULL);
+
+  /* both buffers are taken in one go, in the order the pads were added */
+  fail_unless_collected (TRUE);
+  fail_unless (outbuf1 == buf1);
+  fail_unless (outbuf2 == buf2);
+
+  /* the single wakeup released both pushing threads */
+  g_thread_join (thread1);
+  g_thread_join (thread2);
+
+  gst_collect_pads_stop (collect);
+
+  gst_buffer_unref (buf1);
+  gst_buffer_unref (buf2);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_collect_eos)
 {
   GstBuffer *buf1;
@@ -1085,6 +1151,7 @@ gst_collect_pads_suite (void)
   tcase_add_test (general, test_pad_add_remove);
 
   tcase_add_test (general, test_collect);
+  tcase_add_test (general, test_collect_pop_all);
   tcase_add_test (general, test_collect_eos);
   tcase_add_test (general, test_collect_twice);
   tcase_add_test (general, test_clip_running_time);
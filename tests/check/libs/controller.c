@@ -26,6 +26,7 @@
 #endif
 #include <gst/gst.h>
 #include <gst/check/gstcheck.h>
+#include <gst/math-compat.h>
 #include <gst/controller/gstinterpolationcontrolsource.h>
 #include <gst/controller/gstlfocontrolsource.h>
 #include <gst/controller/gsttriggercontrolsource.h>
@@ -1131,6 +1132,250 @@ GST_START_TEST (controller_timed_value_count)
 
 GST_END_TEST;
 
+#define N_LOOKUP_CP 1000
+
+static gdouble
+lookup_expected (GstClockTime ts)
+{
+  GstClockTime idx = ts / (10 * GST_MSECOND);
+
+  return MIN (idx, N_LOOKUP_CP - 1) / 10.0;
+}
+
+/* lookups with many control points, in all directions and after changes */
+GST_START_TEST (controller_timed_value_lookup)
+{
+  GstControlSource *cs;
+  GstTimedValueControlSource *tvcs;
+  gdouble *values, value;
+  guint i;
+
+  cs = gst_interpolation_control_source_new ();
+  tvcs = (GstTimedValueControlSource *) cs;
+  g_object_set (cs, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
+
+  /* insert out of order first, append the rest */
+  for (i = 0; i < N_LOOKUP_CP / 2; i++) {
+    guint j = (i * 7) % (N_LOOKUP_CP / 2);
+
+    fail_unless (gst_timed_value_control_source_set (tvcs,
+            j * 10 * GST_MSECOND, j / 10.0));
+  }
+  for (i = N_LOOKUP_CP / 2; i < N_LOOKUP_CP; i++) {
+    fail_unless (gst_control_source_get_value (cs, (i - 1) * 10 * GST_MSECOND,
+            &value));
+    fail_unless (gst_timed_value_control_source_set (tvcs,
+            i * 10 * GST_MSECOND, i / 10.0));
+  }
+  fail_unless_equals_int (gst_timed_value_control_source_get_count (tvcs),
+      N_LOOKUP_CP);
+
+  /* backwards and in jumps */
+  for (i = 0; i < 3000; i++) {
+    GstClockTime ts = ((3000 - i) * 7919 % 10500) * GST_MSECOND;
+
+    fail_unless (gst_control_source_get_value (cs, ts, &value));
+    fail_unless_equals_float (value, lookup_expected (ts));
+  }
+
+  /* sequential access with several samples per segment */
+  values = g_new (gdouble, 4000);
+  fail_unless (gst_control_source_get_value_array (cs, 0, 3 * GST_MSECOND,
+          4000, values));
+  for (i = 0; i < 4000; i++)
+    fail_unless_equals_float (values[i],
+        lookup_expected (i * 3 * GST_MSECOND));
+
+  /* and with several segments per sample */
+  fail_unless (gst_control_source_get_value_array (cs, 5 * GST_MSECOND,
+          25 * GST_MSECOND, 400, values));
+  for (i = 0; i < 400; i++)
+    fail_unless_equals_float (values[i],
+        lookup_expected (5 * GST_MSECOND + i * 25 * GST_MSECOND));
+
+  /* removing a point merges it into the previous segment */
+  fail_unless (gst_timed_value_control_source_unset (tvcs, 50 * GST_MSECOND));
+  fail_unless (gst_control_source_get_value (cs, 55 * GST_MSECOND, &value));
+  fail_unless_equals_float (value, 0.4);
+  fail_unless (gst_timed_value_control_source_set (tvcs, 55 * GST_MSECOND,
+          42.0));
+  fail_unless (gst_control_source_get_value (cs, 57 * GST_MSECOND, &value));
+  fail_unless_equals_float (value, 42.0);
+  fail_unless (gst_control_source_get_value (cs, 53 * GST_MSECOND, &value));
+  fail_unless_equals_float (value, 0.4);
+
+  /* nothing before the first point */
+  fail_unless (gst_timed_value_control_source_unset (tvcs, 0));
+  fail_if (gst_control_source_get_value (cs, 5 * GST_MSECOND, &value));
+
+  gst_timed_value_control_source_unset_all (tvcs);
+  fail_if (gst_control_source_get_value (cs, 5 * GST_MSECOND, &value));
+
+  g_free (values);
+  gst_object_unref (cs);
+}
+
+GST_END_TEST;
+
+/* compare the blocks from get_value_array() against single lookups */
+static void
+check_value_array (GstControlSource * cs, GstControlBinding * cb,
+    GstClockTime timestamp, GstClockTime interval)
+{
+  gdouble values[256], value;
+  gint ints[256];
+  guint i;
+
+  fail_unless (gst_control_source_get_value_array (cs, timestamp, interval,
+          G_N_ELEMENTS (values), values));
+  for (i = 0; i < G_N_ELEMENTS (ints); i++)
+    ints[i] = -1;
+  fail_unless (gst_control_binding_get_value_array (cb, timestamp, interval,
+          G_N_ELEMENTS (ints), ints));
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++) {
+    GstClockTime ts = timestamp + i * interval;
+    GValue *gval;
+
+    if (gst_control_source_get_value (cs, ts, &value)) {
+      fail_unless_equals_float (values[i], value);
+      gval = gst_control_binding_get_value (cb, ts);
+      fail_unless (gval != NULL);
+      fail_unless_equals_int (ints[i], g_value_get_int (gval));
+      g_value_unset (gval);
+      g_free (gval);
+    } else {
+      fail_unless (isnan (values[i]));
+      fail_unless_equals_int (ints[i], -1);
+    }
+  }
+}
+
+/* test the block processing of all interpolation modes and lfo waveforms */
+GST_START_TEST (controller_value_array_blocks)
+{
+  GstControlSource *cs;
+  GstControlBinding *cb;
+  GstTimedValueControlSource *tvcs;
+  GstElement *elem;
+  guint i;
+
+  elem = gst_element_factory_make ("testobj", NULL);
+  cs = gst_interpolation_control_source_new ();
+  tvcs = (GstTimedValueControlSource *) cs;
+  cb = gst_direct_control_binding_new (GST_OBJECT (elem), "int", cs);
+  fail_unless (gst_object_add_control_binding (GST_OBJECT (elem), cb));
+
+  fail_unless (gst_timed_value_control_source_set (tvcs,
+          100 * GST_MSECOND, 0.0));
+  fail_unless (gst_timed_value_control_source_set (tvcs,
+          250 * GST_MSECOND, 1.0));
+  fail_unless (gst_timed_value_control_source_set (tvcs,
+          600 * GST_MSECOND, 0.3));
+  fail_unless (gst_timed_value_control_source_set (tvcs,
+          1000 * GST_MSECOND, 0.7));
+
+  for (i = GST_INTERPOLATION_MODE_NONE;
+      i <= GST_INTERPOLATION_MODE_CUBIC_MONOTONIC; i++) {
+    g_object_set (cs, "mode", i, NULL);
+    check_value_array (cs, cb, 0, 7 * GST_MSECOND);
+    check_value_array (cs, cb, 100 * GST_MSECOND, 50 * GST_MSECOND);
+    check_value_array (cs, cb, 255 * GST_MSECOND, 0);
+  }
+  gst_object_unref (cs);
+
+  /* replaces the previous binding */
+  cs = gst_lfo_control_source_new ();
+  cb = gst_direct_control_binding_new (GST_OBJECT (elem), "int", cs);
+  fail_unless (gst_object_add_control_binding (GST_OBJECT (elem), cb));
+  g_object_set (cs, "frequency", 1.0, "timeshift", 300 * GST_MSECOND,
+      "amplitude", 0.5, "offset", 0.5, NULL);
+
+  for (i = GST_LFO_WAVEFORM_SINE; i <= GST_LFO_WAVEFORM_TRIANGLE; i++) {
+    g_object_set (cs, "waveform", i, NULL);
+    check_value_array (cs, cb, 0, 7 * GST_MSECOND);
+    check_value_array (cs, cb, 100 * GST_MSECOND, 1300 * GST_MSECOND);
+  }
+  gst_object_unref (cs);
+
+  gst_object_unref (elem);
+}
+
+GST_END_TEST;
+
+static void
+count_notify (GObject * object, GParamSpec * pspec, guint * count)
+{
+  (*count)++;
+}
+
+/* test syncing and getting the values of several properties at once */
+GST_START_TEST (controller_sync_values_batch)
+{
+  GstControlSource *cs1, *cs2;
+  GstElement *elem;
+  const gchar *names[] = { "int", "double" };
+  gint ints[5];
+  gdouble doubles[5];
+  gpointer arrays[] = { ints, doubles };
+  guint n_notify = 0, i;
+
+  elem = gst_element_factory_make ("testobj", NULL);
+  g_signal_connect (elem, "notify", G_CALLBACK (count_notify), &n_notify);
+
+  cs1 = gst_interpolation_control_source_new ();
+  cs2 = gst_interpolation_control_source_new ();
+  g_object_set (cs1, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  g_object_set (cs2, "mode", GST_INTERPOLATION_MODE_NONE, NULL);
+  fail_unless (gst_object_add_control_binding (GST_OBJECT (elem),
+          gst_direct_control_binding_new (GST_OBJECT (elem), "int", cs1)));
+  fail_unless (gst_object_add_control_binding (GST_OBJECT (elem),
+          gst_direct_control_binding_new (GST_OBJECT (elem), "double", cs2)));
+
+  fail_unless (gst_timed_value_control_source_set (
+          (GstTimedValueControlSource *) cs1, 0 * GST_SECOND, 0.0));
+  fail_unless (gst_timed_value_control_source_set (
+          (GstTimedValueControlSource *) cs1, 4 * GST_SECOND, 1.0));
+  fail_unless (gst_timed_value_control_source_set (
+          (GstTimedValueControlSource *) cs2, 0 * GST_SECOND, 0.1));
+  fail_unless (gst_timed_value_control_source_set (
+          (GstTimedValueControlSource *) cs2, 2 * GST_SECOND, 0.5));
+
+  /* batch syncing sets the properties without notifications */
+  fail_unless (gst_object_sync_values_batch (GST_OBJECT (elem), 0));
+  fail_unless_equals_int (GST_TEST_OBJ (elem)->val_int, 0);
+  fail_unless_equals_float (GST_TEST_OBJ (elem)->val_double, 10.0);
+  fail_unless (gst_object_sync_values_batch (GST_OBJECT (elem), GST_SECOND));
+  fail_unless_equals_int (GST_TEST_OBJ (elem)->val_int, 25);
+  fail_unless_equals_float (GST_TEST_OBJ (elem)->val_double, 10.0);
+  fail_unless (gst_object_sync_values_batch (GST_OBJECT (elem),
+          3 * GST_SECOND));
+  fail_unless_equals_int (GST_TEST_OBJ (elem)->val_int, 75);
+  fail_unless_equals_float (GST_TEST_OBJ (elem)->val_double, 50.0);
+  fail_unless_equals_int (n_notify, 0);
+
+  /* the regular sync still notifies, only "int" changes here */
+  fail_unless (gst_object_sync_values (GST_OBJECT (elem), 4 * GST_SECOND));
+  fail_unless_equals_int (GST_TEST_OBJ (elem)->val_int, 100);
+  fail_unless_equals_int (n_notify, 1);
+
+  /* all values for a block at once */
+  fail_unless (gst_object_get_value_arrays (GST_OBJECT (elem), 2, names,
+          0, GST_SECOND, 5, arrays));
+  for (i = 0; i < 5; i++) {
+    fail_unless_equals_int (ints[i], i * 25);
+    fail_unless_equals_float (doubles[i], i < 2 ? 10.0 : 50.0);
+  }
+  names[1] = "float";
+  fail_if (gst_object_get_value_arrays (GST_OBJECT (elem), 2, names,
+          0, GST_SECOND, 5, arrays));
+
+  gst_object_unref (cs1);
+  gst_object_unref (cs2);
+  gst_object_unref (elem);
+}
+
+GST_END_TEST;
 
 /* test lfo control source with sine waveform */
 GST_START_TEST (controller_lfo_sine)
@@ -1691,6 +1936,9 @@ gst_controller_suite (void)
   tcase_add_test (tc, controller_interpolation_linear_before_ts0);
   tcase_add_test (tc, controller_interpolation_linear_enums);
   tcase_add_test (tc, controller_timed_value_count);
+  tcase_add_test (tc, controller_timed_value_lookup);
+  tcase_add_test (tc, controller_value_array_blocks);
+  tcase_add_test (tc, controller_sync_values_batch);
   tcase_add_test (tc, controller_lfo_sine);
   tcase_add_test (tc, controller_lfo_sine_timeshift);
   tcase_add_test (tc, controller_lfo_square);
@@ -0,0 +1,367 @@
+/* GStreamer
+ *
+ * unit test for GstDataQueue
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/base/gstdataqueue.h>
+
+static void
+item_destroy (GstDataQueueItem * item)
+{
+  gst_mini_object_unref (item->object);
+  g_slice_free (GstDataQueueItem, item);
+}
+
+static GstDataQueueItem *
+item_new (guint64 offset)
+{
+  GstDataQueueItem *item = g_slice_new0 (GstDataQueueItem);
+  GstBuffer *buf = gst_buffer_new ();
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  item->object = GST_MINI_OBJECT_CAST (buf);
+  item->size = 10;
+  item->duration = GST_SECOND;
+  item->visible = TRUE;
+  item->destroy = (GDestroyNotify) item_destroy;
+
+  return item;
+}
+
+static guint max_visible;
+static gint n_full, n_empty;
+
+static gboolean
+check_full (GstDataQueue * queue, guint visible, guint bytes, guint64 time,
+    gpointer checkdata)
+{
+  return max_visible > 0 && visible >= max_visible;
+}
+
+static void
+full_cb (GstDataQueue * queue, gpointer checkdata)
+{
+  g_atomic_int_inc (&n_full);
+}
+
+static void
+empty_cb (GstDataQueue * queue, gpointer checkdata)
+{
+  g_atomic_int_inc (&n_empty);
+}
+
+static GstDataQueue *
+bounded_queue_new (guint visible, guint max_items)
+{
+  max_visible = visible;
+  n_full = n_empty = 0;
+
+  return gst_data_queue_new_bounded (check_full, full_cb, empty_cb, NULL,
+      max_items);
+}
+
+GST_START_TEST (test_bounded_push_pop)
+{
+  GstDataQueue *queue = bounded_queue_new (4, 16);
+  GstDataQueueItem *item;
+  GstDataQueueSize level;
+  guint i;
+
+  fail_unless (gst_data_queue_is_empty (queue));
+  for (i = 0; i < 3; i++)
+    fail_unless (gst_data_queue_push (queue, item_new (i)));
+  fail_if (gst_data_queue_is_full (queue));
+  fail_unless (gst_data_queue_push (queue, item_new (3)));
+  fail_unless (gst_data_queue_is_full (queue));
+
+  gst_data_queue_get_level (queue, &level);
+  fail_unless_equals_int (level.visible, 4);
+  fail_unless_equals_int (level.bytes, 40);
+  fail_unless_equals_uint64 (level.time, 4 * GST_SECOND);
+
+  fail_unless (gst_data_queue_peek (queue, &item));
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (item->object), 0);
+
+  for (i = 0; i < 4; i++) {
+    fail_unless (gst_data_queue_pop (queue, &item));
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (item->object), i);
+    item->destroy (item);
+  }
+  fail_unless (gst_data_queue_is_empty (queue));
+  gst_data_queue_get_level (queue, &level);
+  fail_unless_equals_int (level.visible, 0);
+  fail_unless_equals_int (level.bytes, 0);
+  fail_unless_equals_uint64 (level.time, 0);
+  fail_unless_equals_int (n_full, 0);
+
+  /* push_force ignores the limits, the items are dropped on flush */
+  for (i = 0; i < 8; i++)
+    fail_unless (gst_data_queue_push_force (queue, item_new (i)));
+  fail_unless (gst_data_queue_is_full (queue));
+  fail_unless_equals_int (n_full, 0);
+
+  /* only the head can be dropped */
+  fail_if (gst_data_queue_drop_head (queue, GST_TYPE_EVENT));
+  fail_unless (gst_data_queue_drop_head (queue, GST_TYPE_BUFFER));
+  fail_unless (gst_data_queue_peek (queue, &item));
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (item->object), 1);
+
+  gst_data_queue_flush (queue);
+  fail_unless (gst_data_queue_is_empty (queue));
+  gst_data_queue_get_level (queue, &level);
+  fail_unless_equals_int (level.visible, 0);
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+static gpointer
+push_thread (GstDataQueue * queue)
+{
+  GstDataQueueItem *item = item_new (0);
+
+  if (!gst_data_queue_push (queue, item)) {
+    item->destroy (item);
+    return GINT_TO_POINTER (FALSE);
+  }
+
+  return GINT_TO_POINTER (TRUE);
+}
+
+static gpointer
+pop_thread (GstDataQueue * queue)
+{
+  GstDataQueueItem *item;
+
+  if (!gst_data_queue_pop (queue, &item))
+    return GINT_TO_POINTER (FALSE);
+
+  item->destroy (item);
+
+  return GINT_TO_POINTER (TRUE);
+}
+
+GST_START_TEST (test_bounded_blocking)
+{
+  GstDataQueue *queue = bounded_queue_new (0, 2);
+  GstDataQueueItem *item;
+  GThread *thread;
+
+  /* the ring buffer is full after two items */
+  fail_unless (gst_data_queue_push (queue, item_new (0)));
+  fail_unless (gst_data_queue_push (queue, item_new (1)));
+  fail_unless (gst_data_queue_is_full (queue));
+
+  thread = g_thread_new ("push", (GThreadFunc) push_thread, queue);
+  while (g_atomic_int_get (&n_full) == 0)
+    g_usleep (1000);
+
+  /* popping makes room for the blocked push */
+  fail_unless (gst_data_queue_pop (queue, &item));
+  item->destroy (item);
+  fail_unless (g_thread_join (thread) == GINT_TO_POINTER (TRUE));
+
+  gst_data_queue_flush (queue);
+
+  /* a pop on the empty queue is woken up by a push */
+  thread = g_thread_new ("pop", (GThreadFunc) pop_thread, queue);
+  while (g_atomic_int_get (&n_empty) == 0)
+    g_usleep (1000);
+  fail_unless (gst_data_queue_push (queue, item_new (0)));
+  fail_unless (g_thread_join (thread) == GINT_TO_POINTER (TRUE));
+  fail_unless (gst_data_queue_is_empty (queue));
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bounded_flushing)
+{
+  GstDataQueue *queue = bounded_queue_new (1, 16);
+  GstDataQueueItem *item;
+  GThread *pop, *push;
+
+  /* a blocked pop is released when flushing */
+  pop = g_thread_new ("pop", (GThreadFunc) pop_thread, queue);
+  while (g_atomic_int_get (&n_empty) == 0)
+    g_usleep (1000);
+  gst_data_queue_set_flushing (queue, TRUE);
+  fail_unless (g_thread_join (pop) == GINT_TO_POINTER (FALSE));
+
+  item = item_new (0);
+  fail_if (gst_data_queue_push (queue, item));
+  gst_data_queue_set_flushing (queue, FALSE);
+  fail_unless (gst_data_queue_push (queue, item));
+
+  /* and so is a blocked push */
+  push = g_thread_new ("push", (GThreadFunc) push_thread, queue);
+  while (g_atomic_int_get (&n_full) == 0)
+    g_usleep (1000);
+  gst_data_queue_set_flushing (queue, TRUE);
+  fail_unless (g_thread_join (push) == GINT_TO_POINTER (FALSE));
+  fail_if (gst_data_queue_pop (queue, &item));
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_bounded_limits_changed)
+{
+  GstDataQueue *queue = bounded_queue_new (1, 16);
+  GThread *thread;
+
+  fail_unless (gst_data_queue_push (queue, item_new (0)));
+
+  thread = g_thread_new ("push", (GThreadFunc) push_thread, queue);
+  while (g_atomic_int_get (&n_full) == 0)
+    g_usleep (1000);
+
+  max_visible = 2;
+  gst_data_queue_limits_changed (queue);
+  fail_unless (g_thread_join (thread) == GINT_TO_POINTER (TRUE));
+  fail_unless (gst_data_queue_is_full (queue));
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+#define N_THREADS 4
+#define N_ITEMS 10000
+
+typedef struct
+{
+  GstDataQueue *queue;
+  guint id;
+  guint64 sum;
+  guint count;
+  gboolean ordered;
+} ThreadData;
+
+static gint n_popped;
+
+static gpointer
+mpmc_push_thread (ThreadData * data)
+{
+  guint i;
+
+  for (i = 0; i < N_ITEMS; i++) {
+    GstDataQueueItem *item = item_new (data->id * N_ITEMS + i);
+
+    fail_unless (gst_data_queue_push (data->queue, item));
+  }
+
+  return NULL;
+}
+
+static gpointer
+mpmc_pop_thread (ThreadData * data)
+{
+  guint64 last[N_THREADS] = { 0, };
+  GstDataQueueItem *item;
+
+  while (gst_data_queue_pop (data->queue, &item)) {
+    guint64 offset = GST_BUFFER_OFFSET (item->object);
+    guint producer = offset / N_ITEMS;
+
+    /* the items of one producer are seen in order by every consumer */
+    if (offset + 1 <= last[producer])
+      data->ordered = FALSE;
+    last[producer] = offset + 1;
+
+    data->sum += offset;
+    data->count++;
+    item->destroy (item);
+    g_atomic_int_inc (&n_popped);
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_bounded_mpmc)
+{
+  GstDataQueue *queue = bounded_queue_new (0, 8);
+  ThreadData producers[N_THREADS], consumers[N_THREADS];
+  GThread *threads[2 * N_THREADS];
+  guint64 sum = 0;
+  guint i, count = 0;
+
+  n_popped = 0;
+  for (i = 0; i < N_THREADS; i++) {
+    consumers[i].queue = queue;
+    consumers[i].sum = 0;
+    consumers[i].count = 0;
+    consumers[i].ordered = TRUE;
+    threads[N_THREADS + i] = g_thread_new ("pop",
+        (GThreadFunc) mpmc_pop_thread, &consumers[i]);
+  }
+  for (i = 0; i < N_THREADS; i++) {
+    producers[i].queue = queue;
+    producers[i].id = i;
+    threads[i] = g_thread_new ("push", (GThreadFunc) mpmc_push_thread,
+        &producers[i]);
+  }
+
+  for (i = 0; i < N_THREADS; i++)
+    g_thread_join (threads[i]);
+  while (g_atomic_int_get (&n_popped) < N_THREADS * N_ITEMS)
+    g_usleep (1000);
+  gst_data_queue_set_flushing (queue, TRUE);
+  for (i = 0; i < N_THREADS; i++) {
+    g_thread_join (threads[N_THREADS + i]);
+    fail_unless (consumers[i].ordered);
+    sum += consumers[i].sum;
+    count += consumers[i].count;
+  }
+
+  fail_unless_equals_int (count, N_THREADS * N_ITEMS);
+  fail_unless_equals_uint64 (sum,
+      (guint64) (N_THREADS * N_ITEMS) * (N_THREADS * N_ITEMS - 1) / 2);
+  fail_unless (gst_data_queue_is_empty (queue));
+
+  g_object_unref (queue);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_data_queue_suite (void)
+{
+  Suite *s = suite_create ("GstDataQueue");
+  TCase *tc_chain = tcase_create ("bounded");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_bounded_push_pop);
+  tcase_add_test (tc_chain, test_bounded_blocking);
+  tcase_add_test (tc_chain, test_bounded_flushing);
+  tcase_add_test (tc_chain, test_bounded_limits_changed);
+  tcase_add_test (tc_chain, test_bounded_mpmc);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gst_data_queue);
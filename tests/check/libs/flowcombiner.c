@@ -246,6 +246,80 @@ GST_START_TEST (test_no_pads_passthrough)
 
 GST_END_TEST;
 
+GST_START_TEST (test_update_pad_flow)
+{
+  GstFlowCombiner *combiner = gst_flow_combiner_new ();
+  GstPad *pads[16];
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (pads); i++) {
+    pads[i] = gst_pad_new (NULL, GST_PAD_SRC);
+    gst_flow_combiner_add_pad (combiner, pads[i]);
+  }
+  /* the pads are not active and start flushing */
+  gst_flow_combiner_reset (combiner);
+
+  /* all but one pad eos */
+  for (i = 1; i < G_N_ELEMENTS (pads); i++)
+    fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+            pads[i], GST_FLOW_EOS), GST_FLOW_OK);
+
+  /* the last one goes not-linked, now all are eos or not-linked */
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[0], GST_FLOW_NOT_LINKED), GST_FLOW_EOS);
+
+  /* back to ok on one pad */
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_OK), GST_FLOW_OK);
+
+  /* an error is kept until the pad recovers */
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[3], GST_FLOW_ERROR), GST_FLOW_ERROR);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_EOS), GST_FLOW_ERROR);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[3], GST_FLOW_EOS), GST_FLOW_EOS);
+
+  /* the first error in the list is used, the last added pad is checked
+   * first */
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[3], GST_FLOW_NOT_NEGOTIATED), GST_FLOW_NOT_NEGOTIATED);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[9], GST_FLOW_FLUSHING), GST_FLOW_FLUSHING);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_EOS), GST_FLOW_FLUSHING);
+
+  /* removing the pads removes their flows */
+  gst_flow_combiner_remove_pad (combiner, pads[9]);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_EOS), GST_FLOW_NOT_NEGOTIATED);
+  gst_flow_combiner_remove_pad (combiner, pads[3]);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_OK), GST_FLOW_OK);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[5], GST_FLOW_EOS), GST_FLOW_EOS);
+
+  /* reset puts all pads back to ok */
+  gst_flow_combiner_reset (combiner);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[1], GST_FLOW_EOS), GST_FLOW_OK);
+  fail_unless_equals_int (GST_PAD_LAST_FLOW_RETURN (pads[2]), GST_FLOW_OK);
+
+  /* update_flow() picks up flow returns set behind the combiner's back */
+  for (i = 0; i < G_N_ELEMENTS (pads); i++)
+    GST_PAD_LAST_FLOW_RETURN (pads[i]) = GST_FLOW_NOT_LINKED;
+  fail_unless_equals_int (gst_flow_combiner_update_flow (combiner,
+          GST_FLOW_NOT_LINKED), GST_FLOW_NOT_LINKED);
+  fail_unless_equals_int (gst_flow_combiner_update_pad_flow (combiner,
+          pads[0], GST_FLOW_EOS), GST_FLOW_EOS);
+
+  gst_flow_combiner_free (combiner);
+  for (i = 0; i < G_N_ELEMENTS (pads); i++)
+    gst_object_unref (pads[i]);
+}
+
+GST_END_TEST;
+
 static Suite *
 flow_combiner_suite (void)
 {
@@ -256,6 +330,7 @@ flow_combiner_suite (void)
   tcase_add_test (tc_chain, test_combined_flows);
   tcase_add_test (tc_chain, test_clear);
   tcase_add_test (tc_chain, test_no_pads_passthrough);
+  tcase_add_test (tc_chain, test_update_pad_flow);
 
   return s;
 }
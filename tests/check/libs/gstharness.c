@@ -293,6 +293,57 @@ GST_START_TEST (test_get_all_data)
 
 GST_END_TEST;
 
+GST_START_TEST (test_push_list_pull_n)
+{
+  GstHarness *h = gst_harness_new ("identity");
+  GstBufferList *list;
+  GstBuffer *bufs[8];
+  guint i;
+
+  gst_harness_set_src_caps_str (h, "mycaps");
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 8; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, 10);
+
+    GST_BUFFER_OFFSET (buf) = i;
+    gst_buffer_list_add (list, buf);
+  }
+  fail_unless_equals_int (gst_harness_push_list (h, list), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 8);
+  fail_unless_equals_uint64 (gst_harness_bytes_received (h), 80);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 8);
+
+  /* the buffers come out in order */
+  fail_unless_equals_int (gst_harness_pull_n (h, bufs, 5), 5);
+  for (i = 0; i < 5; i++) {
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (bufs[i]), i);
+    gst_buffer_unref (bufs[i]);
+  }
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+  fail_unless_equals_int (gst_harness_pull_n (h, bufs, 3), 3);
+  for (i = 0; i < 3; i++) {
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (bufs[i]), i + 5);
+    gst_buffer_unref (bufs[i]);
+  }
+
+  /* dropped buffers are still counted */
+  gst_harness_set_drop_buffers (h, TRUE);
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++)
+    gst_buffer_list_add (list, gst_harness_create_buffer (h, 100));
+  fail_unless_equals_int (gst_harness_push_list (h, list), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_push (h, gst_harness_create_buffer (h,
+              20)), GST_FLOW_OK);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 13);
+  fail_unless_equals_uint64 (gst_harness_bytes_received (h), 500);
+  fail_unless_equals_int (gst_harness_buffers_in_queue (h), 0);
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_harness_suite (void)
 {
@@ -313,6 +364,7 @@ gst_harness_suite (void)
       test_forward_sticky_events_to_sink_harness_while_teardown);
 
   tcase_add_test (tc_chain, test_get_all_data);
+  tcase_add_test (tc_chain, test_push_list_pull_n);
 
   return s;
 }
@@ -118,6 +118,39 @@ GST_START_TEST (test_functioning)
 
 GST_END_TEST;
 
+#define N_SERVERS 4
+
+GST_START_TEST (test_multiple_clocks)
+{
+  GstNetTimeProvider *ntp[N_SERVERS];
+  GstClock *client[N_SERVERS], *server;
+  gint i, port;
+
+  server = gst_system_clock_obtain ();
+
+  /* all clocks are served by the same thread */
+  for (i = 0; i < N_SERVERS; i++) {
+    ntp[i] = gst_net_time_provider_new (server, "127.0.0.1", 0);
+    fail_unless (ntp[i] != NULL, "failed to create network time provider");
+    g_object_get (ntp[i], "port", &port, NULL);
+
+    client[i] = gst_net_client_clock_new (NULL, "127.0.0.1", port, GST_SECOND);
+    fail_unless (client[i] != NULL, "failed to get network client clock");
+  }
+
+  for (i = 0; i < N_SERVERS; i++)
+    fail_unless (gst_clock_wait_for_sync (client[i], 5 * GST_SECOND),
+        "clock %d did not synchronize", i);
+
+  for (i = 0; i < N_SERVERS; i++) {
+    gst_object_unref (client[i]);
+    gst_object_unref (ntp[i]);
+  }
+  gst_object_unref (server);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_net_client_clock_suite (void)
 {
@@ -129,6 +162,7 @@ gst_net_client_clock_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_instantiation);
   tcase_add_test (tc_chain, test_functioning);
+  tcase_add_test (tc_chain, test_multiple_clocks);
 
   return s;
 }
@@ -107,6 +107,91 @@ GST_START_TEST (test_functioning)
 
 GST_END_TEST;
 
+#define N_CLIENTS 8
+#define N_REQUESTS 50
+
+GST_START_TEST (test_threads_stats)
+{
+  GstNetTimeProvider *ntp;
+  GstClock *clock;
+  GSocketAddress *server_addr;
+  GInetAddress *addr;
+  GSocket *sockets[N_CLIENTS];
+  GstStructure *stats;
+  guint64 requests, max_latency;
+  guint i, j, n_received = 0;
+  gint port = -1;
+
+  clock = gst_system_clock_obtain ();
+  ntp = g_initable_new (GST_TYPE_NET_TIME_PROVIDER, NULL, NULL, "clock", clock,
+      "address", "127.0.0.1", "port", 0, "n-threads", 4, NULL);
+  fail_unless (ntp != NULL, "failed to create net time provider");
+  gst_object_ref_sink (ntp);
+
+  g_object_get (ntp, "port", &port, NULL);
+  fail_unless (port > 0);
+
+  addr = g_inet_address_new_from_string ("127.0.0.1");
+  server_addr = g_inet_socket_address_new (addr, port);
+  g_object_unref (addr);
+
+  /* the clients are spread over the threads by their source port */
+  for (i = 0; i < N_CLIENTS; i++) {
+    sockets[i] = g_socket_new (G_SOCKET_FAMILY_IPV4, G_SOCKET_TYPE_DATAGRAM,
+        G_SOCKET_PROTOCOL_UDP, NULL);
+    fail_unless (sockets[i] != NULL, "could not create socket");
+    g_socket_set_timeout (sockets[i], 5);
+  }
+
+  for (j = 0; j < N_REQUESTS; j++) {
+    for (i = 0; i < N_CLIENTS; i++) {
+      GstNetTimePacket *packet = gst_net_time_packet_new (NULL);
+
+      packet->local_time = j;
+      fail_unless (gst_net_time_packet_send (packet, sockets[i], server_addr,
+              NULL));
+      g_free (packet);
+    }
+
+    for (i = 0; i < N_CLIENTS; i++) {
+      GstNetTimePacket *packet;
+
+      packet = gst_net_time_packet_receive (sockets[i], NULL, NULL);
+      fail_unless (packet != NULL, "failed to receive packet");
+      fail_unless_equals_uint64 (packet->local_time, j);
+      fail_unless (packet->remote_time <= gst_clock_get_time (clock));
+      g_free (packet);
+      n_received++;
+    }
+  }
+
+  /* the statistics are updated after the replies were sent */
+  for (i = 0; i < 100; i++) {
+    g_object_get (ntp, "stats", &stats, NULL);
+    fail_unless (stats != NULL);
+    fail_unless (gst_structure_get_uint64 (stats, "requests", &requests));
+    if (requests == n_received)
+      break;
+    gst_structure_free (stats);
+    g_usleep (10000);
+  }
+  fail_unless_equals_uint64 (requests, n_received);
+  fail_unless (gst_structure_get_uint64 (stats, "max-latency", &max_latency));
+  fail_unless (max_latency < GST_SECOND);
+  fail_unless (gst_structure_has_field_typed (stats, "request-rate",
+          G_TYPE_DOUBLE));
+  gst_structure_free (stats);
+
+  for (i = 0; i < N_CLIENTS; i++)
+    g_object_unref (sockets[i]);
+  g_object_unref (server_addr);
+
+  gst_object_unref (ntp);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_net_time_provider_suite (void)
 {
@@ -116,6 +201,7 @@ gst_net_time_provider_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_refcounts);
   tcase_add_test (tc_chain, test_functioning);
+  tcase_add_test (tc_chain, test_threads_stats);
 
   return s;
 }
@@ -1052,6 +1052,80 @@ GST_START_TEST (test_crank)
 
 GST_END_TEST;
 
+#define N_PENDING_IDS 10000
+
+static gboolean
+record_order_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GQueue *order = user_data;
+
+  g_queue_push_tail (order, id);
+  return TRUE;
+}
+
+GST_START_TEST (test_many_pending_ids)
+{
+  GstClock *clock;
+  GstTestClock *test_clock;
+  GstClockID ids[N_PENDING_IDS];
+  GQueue order = G_QUEUE_INIT;
+  GHashTable *index = g_hash_table_new (NULL, NULL);
+  GList *cur;
+  guint i;
+
+  clock = gst_test_clock_new ();
+  test_clock = GST_TEST_CLOCK (clock);
+
+  /* scattered times with many duplicates */
+  for (i = 0; i < N_PENDING_IDS; i++) {
+    ids[i] = gst_clock_new_single_shot_id (clock,
+        ((i * 7919) % 1000) * GST_MSECOND);
+    fail_unless_equals_int (gst_clock_id_wait_async (ids[i], record_order_cb,
+            &order, NULL), GST_CLOCK_OK);
+  }
+  gst_test_clock_wait_for_multiple_pending_ids (test_clock, N_PENDING_IDS,
+      NULL);
+  fail_unless (gst_test_clock_has_id (test_clock, ids[N_PENDING_IDS / 2]));
+  fail_unless_equals_uint64 (gst_test_clock_get_next_entry_time (test_clock),
+      0);
+
+  /* unscheduled ids are gone without being called */
+  gst_clock_id_unschedule (ids[0]);
+  fail_if (gst_test_clock_has_id (test_clock, ids[0]));
+
+  gst_test_clock_set_time (test_clock, GST_SECOND);
+  while (gst_test_clock_peek_id_count (test_clock) > 0) {
+    GstClockID id = gst_test_clock_process_next_clock_id (test_clock);
+
+    fail_unless (id != NULL);
+    gst_clock_id_unref (id);
+  }
+
+  /* the ids are processed by time, and in the order they were scheduled
+   * for the same time */
+  fail_unless_equals_int (order.length, N_PENDING_IDS - 1);
+  for (i = 0; i < N_PENDING_IDS; i++)
+    g_hash_table_insert (index, ids[i], GUINT_TO_POINTER (i));
+  for (cur = order.head; cur && cur->next; cur = cur->next) {
+    GstClockTime t1 = gst_clock_id_get_time (cur->data);
+    GstClockTime t2 = gst_clock_id_get_time (cur->next->data);
+
+    fail_unless (t1 <= t2);
+    if (t1 == t2)
+      fail_unless (GPOINTER_TO_UINT (g_hash_table_lookup (index, cur->data)) <
+          GPOINTER_TO_UINT (g_hash_table_lookup (index, cur->next->data)));
+  }
+
+  g_hash_table_unref (index);
+  g_queue_clear (&order);
+  for (i = 0; i < N_PENDING_IDS; i++)
+    gst_clock_id_unref (ids[i]);
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_late_crank)
 {
   GstClock *clock;
@@ -1123,6 +1197,7 @@ gst_test_clock_suite (void)
   tcase_add_test (tc_chain, test_periodic_async);
   tcase_add_test (tc_chain, test_periodic_uniqueness);
   tcase_add_test (tc_chain, test_crank);
+  tcase_add_test (tc_chain, test_many_pending_ids);
   tcase_add_test (tc_chain, test_late_crank);
 
   return s;
@@ -341,6 +341,164 @@ GST_START_TEST (test_array_peek_pop_tail)
 
 GST_END_TEST;
 
+/* grows full arrays with the head at every position, which moves either the
+ * wrapped part or the head part */
+GST_START_TEST (test_array_grow_wrapped)
+{
+  guint offset, i;
+
+  for (offset = 0; offset < 8; offset++) {
+    GstQueueArray *array = gst_queue_array_new (8);
+
+    for (i = 0; i < offset; i++) {
+      gst_queue_array_push_tail (array, GINT_TO_POINTER (i));
+      gst_queue_array_pop_head (array);
+    }
+
+    for (i = 0; i < 20; i++)
+      gst_queue_array_push_tail (array, GINT_TO_POINTER (i));
+
+    for (i = 0; i < 20; i++) {
+      fail_unless_equals_int (GPOINTER_TO_INT (gst_queue_array_peek_nth (array,
+                  0)), i);
+      fail_unless_equals_int (GPOINTER_TO_INT (gst_queue_array_pop_head
+              (array)), i);
+    }
+    fail_unless (gst_queue_array_is_empty (array));
+    gst_queue_array_free (array);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_array_push_pop_n)
+{
+  GstQueueArray *array;
+  gpointer in[40], out[40];
+  guint i, round;
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++)
+    in[i] = GINT_TO_POINTER (i);
+
+  array = gst_queue_array_new (4);
+
+  /* nothing to pop */
+  fail_unless_equals_int (gst_queue_array_pop_head_n (array, out, 4), 0);
+
+  /* wrap around the end of the array a few times */
+  for (round = 0; round < 10; round++) {
+    gst_queue_array_push_tail_n (array, in, 3);
+    fail_unless_equals_int (gst_queue_array_pop_head_n (array, out, 2), 2);
+    fail_unless_equals_pointer (out[0], in[0]);
+    fail_unless_equals_pointer (out[1], in[1]);
+    fail_unless_equals_int (gst_queue_array_pop_head_n (array, out, 5), 1);
+    fail_unless_equals_pointer (out[0], in[2]);
+  }
+
+  /* growing while the elements wrap around */
+  gst_queue_array_push_tail (array, in[0]);
+  gst_queue_array_push_tail (array, in[1]);
+  gst_queue_array_push_tail_n (array, in + 2, 38);
+  fail_unless_equals_int (gst_queue_array_get_length (array), 40);
+  for (i = 0; i < 40; i++)
+    fail_unless_equals_pointer (gst_queue_array_peek_nth (array, i), in[i]);
+
+  /* mixing single and bulk operations */
+  fail_unless_equals_pointer (gst_queue_array_pop_head (array), in[0]);
+  fail_unless_equals_int (gst_queue_array_pop_head_n (array, out, 38), 38);
+  for (i = 0; i < 38; i++)
+    fail_unless_equals_pointer (out[i], in[i + 1]);
+  fail_unless_equals_pointer (gst_queue_array_pop_tail (array), in[39]);
+  fail_unless (gst_queue_array_is_empty (array));
+
+  gst_queue_array_free (array);
+}
+
+GST_END_TEST;
+
+typedef struct
+{
+  guint64 a;
+  guint8 b;
+} TestStruct;
+
+GST_START_TEST (test_array_push_pop_n_struct)
+{
+  GstQueueArray *array;
+  TestStruct in[10], out[10], *s;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++) {
+    in[i].a = i * 1000;
+    in[i].b = i;
+  }
+
+  array = gst_queue_array_new_for_struct (sizeof (TestStruct), 4);
+
+  gst_queue_array_push_tail_struct (array, &in[0]);
+  gst_queue_array_push_tail_n (array, &in[1], 9);
+  fail_unless_equals_int (gst_queue_array_get_length (array), 10);
+
+  s = gst_queue_array_pop_head_struct (array);
+  fail_unless_equals_uint64 (s->a, 0);
+  fail_unless_equals_int (gst_queue_array_pop_head_n (array, out, 10), 9);
+  for (i = 0; i < 9; i++) {
+    fail_unless_equals_uint64 (out[i].a, in[i + 1].a);
+    fail_unless_equals_int (out[i].b, in[i + 1].b);
+  }
+
+  gst_queue_array_free (array);
+}
+
+GST_END_TEST;
+
+static void
+count_clear (gpointer data)
+{
+  guint *count = *(guint **) data;
+
+  (*count)++;
+}
+
+GST_START_TEST (test_array_shrink)
+{
+  GstQueueArray *array;
+  guint i, cleared = 0;
+
+  array = gst_queue_array_new_for_struct (sizeof (guint *), 2);
+  gst_queue_array_set_clear_func (array, count_clear);
+
+  /* a burst grows the array */
+  for (i = 0; i < 100; i++) {
+    guint *p = &cleared;
+
+    gst_queue_array_push_tail_struct (array, &p);
+  }
+  for (i = 0; i < 97; i++)
+    gst_queue_array_pop_head_struct (array);
+
+  /* shrinking keeps the remaining elements, wrapped or not */
+  gst_queue_array_shrink (array);
+  fail_unless_equals_int (gst_queue_array_get_length (array), 3);
+  for (i = 0; i < 10; i++) {
+    guint *p = &cleared;
+
+    gst_queue_array_push_tail_struct (array, &p);
+    gst_queue_array_pop_head_struct (array);
+  }
+  gst_queue_array_shrink (array);
+  fail_unless_equals_int (gst_queue_array_get_length (array), 3);
+
+  gst_queue_array_clear (array);
+  gst_queue_array_shrink (array);
+  fail_unless (gst_queue_array_is_empty (array));
+  fail_unless_equals_int (cleared, 3);
+
+  gst_queue_array_free (array);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_queue_array_suite (void)
 {
@@ -358,6 +516,10 @@ gst_queue_array_suite (void)
   tcase_add_test (tc_chain, test_array_grow_from_prealloc1);
   tcase_add_test (tc_chain, test_array_peek_pop_tail);
   tcase_add_test (tc_chain, test_array_peek_nth);
+  tcase_add_test (tc_chain, test_array_grow_wrapped);
+  tcase_add_test (tc_chain, test_array_push_pop_n);
+  tcase_add_test (tc_chain, test_array_push_pop_n_struct);
+  tcase_add_test (tc_chain, test_array_shrink);
 
   return s;
 }
@@ -0,0 +1,141 @@
+/* GStreamer
+ *
+ * unit test for GstQueueBudget
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/gst.h>
+#include <gst/check/gstcheck.h>
+#include <gst/base/gstqueuebudget.h>
+
+GST_START_TEST (test_watermarks)
+{
+  GstQueueBudget *budget = gst_queue_budget_new (100, 40);
+  guint64 level;
+
+  fail_if (gst_queue_budget_is_exhausted (budget));
+  fail_unless_equals_int (gst_queue_budget_get_policy (budget),
+      GST_QUEUE_BUDGET_POLICY_BLOCK);
+
+  gst_queue_budget_charge (budget, 60);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+  gst_queue_budget_charge (budget, 40);
+  fail_unless (gst_queue_budget_is_exhausted (budget));
+
+  g_object_get (budget, "current-level-bytes", &level, NULL);
+  fail_unless_equals_uint64 (level, 100);
+
+  /* stays exhausted until the low watermark is reached */
+  gst_queue_budget_release (budget, 30);
+  fail_unless (gst_queue_budget_is_exhausted (budget));
+  gst_queue_budget_release (budget, 30);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+  gst_queue_budget_charge (budget, 20);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+
+  gst_queue_budget_release (budget, 60);
+  fail_unless_equals_uint64 (gst_queue_budget_get_bytes (budget), 0);
+
+  /* a high watermark of 0 never exhausts */
+  g_object_set (budget, "high-watermark", (guint64) 0, NULL);
+  gst_queue_budget_charge (budget, 1000);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+  gst_queue_budget_release (budget, 1000);
+
+  gst_object_unref (budget);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_context)
+{
+  GstQueueBudget *budget = gst_queue_budget_new (100, 0);
+  GstQueueBudget *res = NULL;
+  GstContext *context;
+
+  context = gst_context_new ("other", TRUE);
+  fail_if (gst_context_get_queue_budget (context, &res));
+  gst_context_unref (context);
+
+  context = gst_context_new (GST_QUEUE_BUDGET_CONTEXT_TYPE, TRUE);
+  fail_if (gst_context_get_queue_budget (context, &res));
+  gst_context_set_queue_budget (context, budget);
+  fail_unless (gst_context_get_queue_budget (context, &res));
+  fail_unless (res == budget);
+  gst_object_unref (res);
+  gst_context_unref (context);
+
+  ASSERT_OBJECT_REFCOUNT (budget, "budget", 1);
+  gst_object_unref (budget);
+}
+
+GST_END_TEST;
+
+#define N_THREADS 4
+#define N_CHARGES 100000
+
+static gpointer
+charge_thread (GstQueueBudget * budget)
+{
+  guint i;
+
+  for (i = 0; i < N_CHARGES; i++) {
+    gst_queue_budget_charge (budget, i % 7 + 1);
+    gst_queue_budget_release (budget, i % 7 + 1);
+  }
+
+  return NULL;
+}
+
+GST_START_TEST (test_concurrent)
+{
+  GstQueueBudget *budget = gst_queue_budget_new (16, 0);
+  GThread *threads[N_THREADS];
+  guint i;
+
+  for (i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_new ("charge", (GThreadFunc) charge_thread, budget);
+  for (i = 0; i < N_THREADS; i++)
+    g_thread_join (threads[i]);
+
+  fail_unless_equals_uint64 (gst_queue_budget_get_bytes (budget), 0);
+  fail_if (gst_queue_budget_is_exhausted (budget));
+
+  gst_object_unref (budget);
+}
+
+GST_END_TEST;
+
+static Suite *
+gst_queue_budget_suite (void)
+{
+  Suite *s = suite_create ("GstQueueBudget");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_watermarks);
+  tcase_add_test (tc_chain, test_context);
+  tcase_add_test (tc_chain, test_concurrent);
+
+  return s;
+}
+
+GST_CHECK_MAIN (gst_queue_budget);
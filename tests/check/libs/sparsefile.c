@@ -211,6 +211,83 @@ GST_START_TEST (test_write_merge)
 
 GST_END_TEST;
 
+/* random writes without a file, checked against a map of written blocks */
+GST_START_TEST (test_random_ranges)
+{
+#define N_BLOCKS 2000
+#define BLOCK_SIZE 10
+  static gboolean written[N_BLOCKS];
+  GstSparseFile *file;
+  gchar buffer[BLOCK_SIZE * 4] = { 0, };
+  GRand *rand;
+  gint i, j;
+
+  memset (written, 0, sizeof (written));
+  rand = g_rand_new_with_seed (42);
+  file = gst_sparse_file_new ();
+
+  for (i = 0; i < 5000; i++) {
+    gint block = g_rand_int_range (rand, 0, N_BLOCKS - 4);
+    gint n = g_rand_int_range (rand, 1, 5);
+    guint n_ranges = 0;
+
+    fail_unless_equals_int (gst_sparse_file_write (file, block * BLOCK_SIZE,
+            buffer, n * BLOCK_SIZE, NULL, NULL), n * BLOCK_SIZE);
+    for (j = 0; j < n; j++)
+      written[block + j] = TRUE;
+
+    for (j = 0; j < N_BLOCKS; j++) {
+      if (written[j] && (j == 0 || !written[j - 1]))
+        n_ranges++;
+    }
+    fail_unless_equals_int (gst_sparse_file_n_ranges (file), n_ranges);
+
+    /* look up the ranges around a few offsets */
+    for (j = 0; j < 8; j++) {
+      gint b = g_rand_int_range (rand, 0, N_BLOCKS), k;
+      gsize offset = b * BLOCK_SIZE + g_rand_int_range (rand, 0, BLOCK_SIZE);
+      gsize start, stop;
+      gboolean found;
+
+      /* the range before ends after the last written block before b */
+      for (k = b; k >= 0 && !written[k]; k--);
+      found = gst_sparse_file_get_range_before (file, offset, &start, &stop);
+      fail_unless_equals_int (found, k >= 0);
+      if (found) {
+        gint e;
+
+        for (e = k; e < N_BLOCKS && written[e]; e++);
+        fail_unless_equals_int (stop, e * BLOCK_SIZE);
+        for (; k > 0 && written[k - 1]; k--);
+        fail_unless_equals_int (start, k * BLOCK_SIZE);
+      }
+
+      for (k = b; k < N_BLOCKS && !written[k]; k++);
+      found = gst_sparse_file_get_range_after (file, offset, &start, &stop);
+      fail_unless_equals_int (found, k < N_BLOCKS);
+      if (found) {
+        gint e;
+
+        for (e = k; e < N_BLOCKS && written[e]; e++);
+        fail_unless_equals_int (stop, e * BLOCK_SIZE);
+        for (; k > 0 && written[k - 1]; k--);
+        fail_unless_equals_int (start, k * BLOCK_SIZE);
+      }
+
+      /* reading works exactly when the block is written */
+      fail_unless_equals_int (gst_sparse_file_read (file, b * BLOCK_SIZE,
+              buffer, BLOCK_SIZE, NULL, NULL), written[b] ? BLOCK_SIZE : 0);
+    }
+  }
+
+  gst_sparse_file_free (file);
+  g_rand_free (rand);
+#undef N_BLOCKS
+#undef BLOCK_SIZE
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_cachefile_suite (void)
 {
@@ -220,6 +297,7 @@ gst_cachefile_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_write_read);
   tcase_add_test (tc_chain, test_write_merge);
+  tcase_add_test (tc_chain, test_random_ranges);
 
   return s;
 }
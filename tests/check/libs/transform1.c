@@ -282,6 +282,127 @@ GST_START_TEST (basetransform_chain_ip1)
 
 GST_END_TEST;
 
+static gpointer
+unref_buffer_later (GstBuffer * buffer)
+{
+  g_usleep (10 * G_TIME_SPAN_MILLISECOND);
+  gst_buffer_unref (buffer);
+  return NULL;
+}
+
+/* check the copy statistics and waiting for shared buffers to become
+ * writable */
+GST_START_TEST (basetransform_chain_ip_stats)
+{
+  TestTransData *trans;
+  GstBuffer *buffer;
+  GstStructure *stats;
+  GThread *thread;
+  guint64 in_place, copied, copied_bytes, deferred;
+
+  klass_transform_ip = transform_ip_1;
+  trans = gst_test_trans_new ();
+
+  gst_test_trans_push_segment (trans);
+
+  buffer = gst_buffer_new_and_alloc (20);
+  fail_unless (gst_test_trans_push (trans, buffer) == GST_FLOW_OK);
+  gst_buffer_unref (gst_test_trans_pop (trans));
+
+  /* a shared buffer is copied */
+  buffer = gst_buffer_new_and_alloc (20);
+  gst_buffer_ref (buffer);
+  fail_unless (gst_test_trans_push (trans, buffer) == GST_FLOW_OK);
+  gst_buffer_unref (buffer);
+  gst_buffer_unref (gst_test_trans_pop (trans));
+
+  /* unless the other reference is dropped while waiting */
+  g_object_set (trans->trans, "writable-wait", (guint64) GST_SECOND, NULL);
+  buffer = gst_buffer_new_and_alloc (20);
+  gst_buffer_ref (buffer);
+  thread = g_thread_new ("unref", (GThreadFunc) unref_buffer_later, buffer);
+  transform_ip_1_writable = FALSE;
+  fail_unless (gst_test_trans_push (trans, buffer) == GST_FLOW_OK);
+  fail_unless (transform_ip_1_writable == TRUE);
+  g_thread_join (thread);
+  fail_unless (gst_test_trans_pop (trans) == buffer);
+  gst_buffer_unref (buffer);
+
+  g_object_get (trans->trans, "copy-stats", &stats, NULL);
+  fail_unless (gst_structure_get (stats, "in-place", G_TYPE_UINT64, &in_place,
+          "copied", G_TYPE_UINT64, &copied, "copied-bytes", G_TYPE_UINT64,
+          &copied_bytes, "deferred", G_TYPE_UINT64, &deferred, NULL));
+  fail_unless_equals_uint64 (in_place, 2);
+  fail_unless_equals_uint64 (copied, 1);
+  fail_unless_equals_uint64 (copied_bytes, 20);
+  fail_unless_equals_uint64 (deferred, 1);
+  gst_structure_free (stats);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+static gint parallel_active, parallel_max_active;
+
+static GstFlowReturn
+transform_ip_parallel (GstBaseTransform * trans, GstBuffer * buf)
+{
+  gint active = g_atomic_int_add (&parallel_active, 1) + 1;
+  gint max;
+
+  do {
+    max = g_atomic_int_get (&parallel_max_active);
+  } while (active > max
+      && !g_atomic_int_compare_and_exchange (&parallel_max_active, max,
+          active));
+
+  /* make earlier buffers take longer so that they finish out of order */
+  g_usleep ((8 - GST_BUFFER_OFFSET (buf)) * G_TIME_SPAN_MILLISECOND);
+  g_atomic_int_add (&parallel_active, -1);
+
+  return GST_FLOW_OK;
+}
+
+/* buffers are transformed in parallel and pushed in input order */
+GST_START_TEST (basetransform_chain_ip_parallel)
+{
+  TestTransData *trans;
+  GstBuffer *buffer;
+  guint i;
+
+  klass_transform_ip = transform_ip_parallel;
+  trans = gst_test_trans_new ();
+  gst_base_transform_set_parallel (GST_BASE_TRANSFORM (trans->trans), TRUE);
+  g_object_set (trans->trans, "max-in-flight", 4, NULL);
+
+  gst_test_trans_push_segment (trans);
+
+  parallel_active = parallel_max_active = 0;
+  for (i = 0; i < 8; i++) {
+    buffer = gst_buffer_new_and_alloc (20);
+    GST_BUFFER_OFFSET (buffer) = i;
+    fail_unless (gst_test_trans_push (trans, buffer) == GST_FLOW_OK);
+  }
+
+  /* serialized events wait for all buffers */
+  fail_unless (gst_pad_push_event (trans->srcpad, gst_event_new_eos ()));
+
+  for (i = 0; i < 8; i++) {
+    buffer = gst_test_trans_pop (trans);
+    fail_unless (buffer != NULL);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (buffer), i);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+  fail_unless (parallel_max_active > 1);
+  fail_unless (parallel_max_active <= 4);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
 static gboolean set_caps_1_called;
 
 static gboolean
@@ -977,6 +1098,8 @@ gst_basetransform_suite (void)
   /* in place */
   tcase_add_test (tc, basetransform_chain_ip1);
   tcase_add_test (tc, basetransform_chain_ip2);
+  tcase_add_test (tc, basetransform_chain_ip_stats);
+  tcase_add_test (tc, basetransform_chain_ip_parallel);
   /* copy transform */
   tcase_add_test (tc, basetransform_chain_ct1);
   tcase_add_test (tc, basetransform_chain_ct2);
@@ -72,6 +72,212 @@ GST_START_TEST (test_buffer_range)
 
 GST_END_TEST;
 
+static gint nomagic_calls;
+
+static void
+magic_typefind (GstTypeFind * tf, gpointer unused)
+{
+  const guint8 *data;
+
+  data = gst_type_find_peek (tf, 0, 7);
+  if (data && memcmp (data, vorbisid, 7) == 0)
+    gst_type_find_suggest_empty_simple (tf, GST_TYPE_FIND_MAXIMUM,
+        "magic/x-test");
+}
+
+static void
+nomagic_typefind (GstTypeFind * tf, gpointer unused)
+{
+  nomagic_calls++;
+  gst_type_find_suggest_empty_simple (tf, GST_TYPE_FIND_LIKELY,
+      "nomagic/x-test");
+}
+
+/* typefinders with matching magic bytes are called before all others */
+GST_START_TEST (test_magic)
+{
+  static const guint8 other[30] = { 0x02, };
+  GList *list;
+  GstCaps *caps;
+  GstTypeFindProbability prob;
+
+  fail_unless (gst_type_find_register_with_magic (NULL, "magic/x-test",
+          GST_RANK_MARGINAL, magic_typefind, NULL, NULL, vorbisid, 7, NULL,
+          NULL));
+  fail_unless (gst_type_find_register (NULL, "nomagic/x-test",
+          GST_RANK_PRIMARY, nomagic_typefind, NULL, NULL, NULL, NULL));
+
+  list = gst_type_find_factory_get_list_for_data (vorbisid, 30);
+  fail_unless_equals_int (g_list_length (list), 1);
+  fail_unless_equals_string (GST_OBJECT_NAME (list->data), "magic/x-test");
+  gst_plugin_feature_list_free (list);
+
+  /* too short for the magic bytes */
+  list = gst_type_find_factory_get_list_for_data (vorbisid, 6);
+  fail_unless (list == NULL);
+  list = gst_type_find_factory_get_list_for_data (other, 30);
+  fail_unless (list == NULL);
+
+  nomagic_calls = 0;
+  caps = gst_type_find_helper_for_data (NULL, vorbisid, 30, &prob);
+  fail_unless (caps != NULL);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          "magic/x-test"));
+  fail_unless_equals_int (prob, GST_TYPE_FIND_MAXIMUM);
+  fail_unless_equals_int (nomagic_calls, 0);
+  gst_caps_unref (caps);
+
+  /* no magic match, everything is tried in order of rank */
+  caps = gst_type_find_helper_for_data (NULL, other, 30, &prob);
+  fail_unless (caps != NULL);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          "nomagic/x-test"));
+  fail_unless_equals_int (prob, GST_TYPE_FIND_LIKELY);
+  fail_unless_equals_int (nomagic_calls, 1);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+static void
+likely_typefind (GstTypeFind * tf, gpointer caps)
+{
+  if (gst_type_find_peek (tf, 0, 30))
+    gst_type_find_suggest (tf, GST_TYPE_FIND_LIKELY, caps);
+}
+
+static void
+maximum_typefind (GstTypeFind * tf, gpointer caps)
+{
+  if (gst_type_find_peek (tf, 0, 30))
+    gst_type_find_suggest (tf, GST_TYPE_FIND_MAXIMUM, caps);
+}
+
+static void
+register_parallel_typefind (const gchar * name, guint rank,
+    GstTypeFindFunction func)
+{
+  fail_unless (gst_type_find_register (NULL, name, rank, func, NULL, NULL,
+          gst_caps_new_empty_simple (name), (GDestroyNotify) gst_caps_unref));
+}
+
+static void
+check_parallel_result (GstTaskPool * pool, const gchar * name,
+    GstTypeFindProbability expected)
+{
+  GstTypeFindProbability prob;
+  GstCaps *caps;
+
+  caps = gst_type_find_helper_for_data_with_task_pool (NULL, vorbisid, 30,
+      NULL, pool, &prob);
+  fail_unless (caps != NULL);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (caps, 0),
+          name));
+  fail_unless_equals_int (prob, expected);
+  gst_caps_unref (caps);
+}
+
+/* the parallel typefinding gives the same result as the sequential one */
+GST_START_TEST (test_parallel)
+{
+  GstTaskPool *pool;
+  gint i;
+
+  pool = gst_task_pool_new ();
+  gst_task_pool_prepare (pool, NULL);
+
+  /* equal probabilities, the highest rank wins */
+  register_parallel_typefind ("likely/x-primary", GST_RANK_PRIMARY,
+      likely_typefind);
+  register_parallel_typefind ("likely/x-secondary", GST_RANK_SECONDARY,
+      likely_typefind);
+  for (i = 0; i < 10; i++) {
+    check_parallel_result (pool, "likely/x-primary", GST_TYPE_FIND_LIKELY);
+    check_parallel_result (NULL, "likely/x-primary", GST_TYPE_FIND_LIKELY);
+  }
+
+  /* a higher probability wins over a higher rank, and the highest rank
+   * wins among the maximums */
+  register_parallel_typefind ("maximum/x-marginal", GST_RANK_MARGINAL,
+      maximum_typefind);
+  register_parallel_typefind ("maximum/x-none", GST_RANK_NONE,
+      maximum_typefind);
+  for (i = 0; i < 10; i++) {
+    check_parallel_result (pool, "maximum/x-marginal", GST_TYPE_FIND_MAXIMUM);
+    check_parallel_result (NULL, "maximum/x-marginal", GST_TYPE_FIND_MAXIMUM);
+  }
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static gint short_calls;
+static gint long_calls;
+
+static void
+short_typefind (GstTypeFind * tf, gpointer unused)
+{
+  const guint8 *data;
+
+  short_calls++;
+  data = gst_type_find_peek (tf, 0, 4);
+  if (data && memcmp (data, "shrt", 4) == 0)
+    gst_type_find_suggest_empty_simple (tf, GST_TYPE_FIND_LIKELY,
+        "short/x-test");
+}
+
+static void
+long_typefind (GstTypeFind * tf, gpointer unused)
+{
+  long_calls++;
+  if (gst_type_find_peek (tf, 0, 64))
+    gst_type_find_suggest_empty_simple (tf, GST_TYPE_FIND_LIKELY,
+        "long/x-test");
+}
+
+/* typefinders that ruled out a prefix of the data are not called again */
+GST_START_TEST (test_incremental)
+{
+  static const guint8 data[64] = { 0, };
+  GstPluginFeature *short_factory, *long_factory;
+  GList *excluded = NULL;
+  GstCaps *caps;
+
+  fail_unless (gst_type_find_register (NULL, "short/x-test",
+          GST_RANK_PRIMARY, short_typefind, NULL, NULL, NULL, NULL));
+  fail_unless (gst_type_find_register (NULL, "long/x-test",
+          GST_RANK_PRIMARY, long_typefind, NULL, NULL, NULL, NULL));
+
+  caps = gst_type_find_helper_for_data_incremental (NULL, data, 32, NULL,
+      &excluded, NULL);
+  gst_clear_caps (&caps);
+  fail_unless_equals_int (short_calls, 1);
+  fail_unless_equals_int (long_calls, 1);
+
+  /* the long one ran out of data */
+  short_factory = gst_registry_find_feature (gst_registry_get (),
+      "short/x-test", GST_TYPE_TYPE_FIND_FACTORY);
+  long_factory = gst_registry_find_feature (gst_registry_get (),
+      "long/x-test", GST_TYPE_TYPE_FIND_FACTORY);
+  fail_unless (g_list_find (excluded, short_factory) != NULL);
+  fail_unless (g_list_find (excluded, long_factory) == NULL);
+
+  caps = gst_type_find_helper_for_data_incremental (NULL, data, 64, NULL,
+      &excluded, NULL);
+  fail_unless (caps != NULL);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (short_calls, 1);
+  fail_unless_equals_int (long_calls, 2);
+
+  gst_plugin_feature_list_free (excluded);
+  gst_object_unref (short_factory);
+  gst_object_unref (long_factory);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_typefindhelper_suite (void)
 {
@@ -80,6 +286,9 @@ gst_typefindhelper_suite (void)
 
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_buffer_range);
+  tcase_add_test (tc_chain, test_magic);
+  tcase_add_test (tc_chain, test_parallel);
+  tcase_add_test (tc_chain, test_incremental);
 
   return s;
 }
@@ -723,6 +723,96 @@ GST_START_TEST (test_flags)
 
 GST_END_TEST;
 
+static void
+check_template_instance (GstParseTemplate * templ, GstStructure * params,
+    gint num_buffers)
+{
+  GstElement *pipeline, *src, *sink;
+  GError *err = NULL;
+  GstPad *pad;
+  gboolean sync;
+  gint n;
+
+  pipeline = gst_parse_template_instantiate (templ, params, &err);
+  fail_unless (pipeline != NULL);
+  fail_unless (err == NULL);
+  fail_unless (GST_IS_PIPELINE (pipeline));
+
+  src = gst_bin_get_by_name (GST_BIN (pipeline), "src");
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  fail_unless (src != NULL);
+  fail_unless (sink != NULL);
+  g_object_get (src, "num-buffers", &n, NULL);
+  fail_unless_equals_int (n, num_buffers);
+  g_object_get (sink, "sync", &sync, NULL);
+  fail_unless (sync);
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (gst_pad_is_linked (pad));
+  gst_object_unref (pad);
+
+  gst_object_unref (src);
+  gst_object_unref (sink);
+  gst_object_unref (pipeline);
+}
+
+GST_START_TEST (test_template)
+{
+  GstParseTemplate *templ;
+  GstStructure *params;
+  GstElement *element;
+  GError *err = NULL;
+
+  templ = gst_parse_template_new ("fakesrc name=src num-buffers=${n} ! "
+      "identity ! fakesink name=sink sync=true", GST_PARSE_FLAG_NONE, &err);
+  fail_unless (templ != NULL);
+  fail_unless (err == NULL);
+
+  /* every instance gets its own elements and parameter values */
+  params = gst_structure_new ("params", "n", G_TYPE_INT, 3, NULL);
+  check_template_instance (templ, params, 3);
+  gst_structure_set (params, "n", G_TYPE_STRING, "7", NULL);
+  check_template_instance (templ, params, 7);
+  gst_structure_free (params);
+
+  /* a missing parameter is an error */
+  element = gst_parse_template_instantiate (templ, NULL, &err);
+  fail_unless (err != NULL);
+  fail_unless_equals_int (err->code, GST_PARSE_ERROR_COULD_NOT_SET_PROPERTY);
+  g_clear_error (&err);
+  if (element)
+    gst_object_unref (element);
+  gst_parse_template_unref (templ);
+
+  /* and so is any error while parsing */
+  if (!g_getenv ("GST_DEBUG"))
+    gst_debug_set_default_threshold (GST_LEVEL_NONE);
+  templ = gst_parse_template_new ("fakesrc ! coffeesink", GST_PARSE_FLAG_NONE,
+      &err);
+  fail_unless (templ == NULL);
+  fail_unless (err != NULL);
+  fail_unless_equals_int (err->code, GST_PARSE_ERROR_NO_SUCH_ELEMENT);
+  g_clear_error (&err);
+
+  templ = gst_parse_template_new ("fakesrc num-buffers=${n} ! fakesink",
+      GST_PARSE_FLAG_NONE, &err);
+  fail_unless (templ != NULL);
+  gst_parse_template_unref (templ);
+
+  /* bins are created again together with their children */
+  templ = gst_parse_template_new ("bin.( fakesrc name=src ! fakesink )",
+      GST_PARSE_FLAG_NONE, &err);
+  fail_unless (templ != NULL);
+  element = gst_parse_template_instantiate (templ, NULL, &err);
+  fail_unless (err == NULL);
+  fail_unless (GST_IS_BIN (element));
+  fail_unless_equals_int (GST_BIN_NUMCHILDREN (element), 2);
+  gst_object_unref (element);
+  gst_parse_template_unref (templ);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_parsing)
 {
   GstElement *pipeline;
@@ -753,6 +843,7 @@ parse_suite (void)
   tcase_add_test (tc_chain, test_missing_elements);
   tcase_add_test (tc_chain, test_parsing);
   tcase_add_test (tc_chain, test_preset);
+  tcase_add_test (tc_chain, test_template);
   return s;
 }
 
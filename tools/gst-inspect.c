@@ -1946,6 +1946,281 @@ print_all_plugin_automatic_install_info (void)
   gst_plugin_list_free (orig_plugins);
 }
 
+/* --json output, everything is taken from the registry and no plugin is
+ * loaded */
+static GString *json_out = NULL;
+static gint json_depth = 0;
+static gboolean json_first = TRUE;
+
+static void
+json_print_string (const gchar * str)
+{
+  const gchar *p;
+
+  g_string_append_c (json_out, '"');
+  for (p = str; *p; p++) {
+    switch (*p) {
+      case '"':
+        g_string_append (json_out, "\\\"");
+        break;
+      case '\\':
+        g_string_append (json_out, "\\\\");
+        break;
+      case '\n':
+        g_string_append (json_out, "\\n");
+        break;
+      case '\t':
+        g_string_append (json_out, "\\t");
+        break;
+      default:
+        if ((guchar) * p < 0x20)
+          g_string_append_printf (json_out, "\\u%04x", (guchar) * p);
+        else
+          g_string_append_c (json_out, *p);
+        break;
+    }
+  }
+  g_string_append_c (json_out, '"');
+}
+
+/* starts the next member of the current object or array */
+static void
+json_next (const gchar * key)
+{
+  if (!json_first)
+    g_string_append_c (json_out, ',');
+  if (json_depth > 0)
+    g_string_append_printf (json_out, "\n%*s", json_depth * 2, "");
+  if (key) {
+    json_print_string (key);
+    g_string_append (json_out, ": ");
+  }
+  json_first = FALSE;
+}
+
+static void
+json_begin (const gchar * key, gchar open)
+{
+  json_next (key);
+  g_string_append_c (json_out, open);
+  json_depth++;
+  json_first = TRUE;
+}
+
+static void
+json_end (gchar close)
+{
+  json_depth--;
+  if (!json_first)
+    g_string_append_printf (json_out, "\n%*s", json_depth * 2, "");
+  g_string_append_c (json_out, close);
+  json_first = FALSE;
+  if (json_depth == 0) {
+    g_print ("%s\n", json_out->str);
+    g_string_truncate (json_out, 0);
+  }
+}
+
+static void
+json_string (const gchar * key, const gchar * value)
+{
+  json_next (key);
+  if (value)
+    json_print_string (value);
+  else
+    g_string_append (json_out, "null");
+}
+
+static void
+json_int (const gchar * key, gint64 value)
+{
+  json_next (key);
+  g_string_append_printf (json_out, "%" G_GINT64_FORMAT, value);
+}
+
+static void
+json_boolean (const gchar * key, gboolean value)
+{
+  json_next (key);
+  g_string_append (json_out, value ? "true" : "false");
+}
+
+static void
+json_strv (const gchar * key, const gchar * const *strv)
+{
+  json_begin (key, '[');
+  for (; strv && *strv; strv++)
+    json_string (NULL, *strv);
+  json_end (']');
+}
+
+static void
+json_print_pad_templates (GstElementFactory * factory)
+{
+  const GList *l;
+
+  json_begin ("pad-templates", '[');
+  for (l = gst_element_factory_get_static_pad_templates (factory); l;
+      l = l->next) {
+    GstStaticPadTemplate *templ = l->data;
+    const gchar *direction, *presence;
+
+    direction = templ->direction == GST_PAD_SRC ? "src" :
+        templ->direction == GST_PAD_SINK ? "sink" : "unknown";
+    presence = templ->presence == GST_PAD_ALWAYS ? "always" :
+        templ->presence == GST_PAD_SOMETIMES ? "sometimes" : "request";
+
+    json_begin (NULL, '{');
+    json_string ("name", templ->name_template);
+    json_string ("direction", direction);
+    json_string ("presence", presence);
+    /* the caps as stored in the registry, not parsed */
+    json_string ("caps", templ->static_caps.string);
+    json_end ('}');
+  }
+  json_end (']');
+}
+
+static void
+json_print_metadata (GstPluginFeature * feature)
+{
+  gchar **keys = NULL;
+  gchar **key;
+
+  json_begin ("metadata", '{');
+  if (GST_IS_ELEMENT_FACTORY (feature))
+    keys = gst_element_factory_get_metadata_keys (GST_ELEMENT_FACTORY
+        (feature));
+  else if (GST_IS_DEVICE_PROVIDER_FACTORY (feature))
+    keys = gst_device_provider_factory_get_metadata_keys
+        (GST_DEVICE_PROVIDER_FACTORY (feature));
+
+  for (key = keys; key && *key; key++) {
+    const gchar *value;
+
+    if (GST_IS_ELEMENT_FACTORY (feature))
+      value = gst_element_factory_get_metadata (GST_ELEMENT_FACTORY (feature),
+          *key);
+    else
+      value = gst_device_provider_factory_get_metadata
+          (GST_DEVICE_PROVIDER_FACTORY (feature), *key);
+    json_string (*key, value);
+  }
+  g_strfreev (keys);
+  json_end ('}');
+}
+
+static void
+json_print_feature (GstPluginFeature * feature, gboolean with_plugin)
+{
+  json_begin (NULL, '{');
+  json_string ("name", GST_OBJECT_NAME (feature));
+  json_string ("type", G_OBJECT_TYPE_NAME (feature));
+  if (with_plugin)
+    json_string ("plugin", gst_plugin_feature_get_plugin_name (feature));
+  json_int ("rank", gst_plugin_feature_get_rank (feature));
+
+  if (GST_IS_ELEMENT_FACTORY (feature)) {
+    GstElementFactory *factory = GST_ELEMENT_FACTORY (feature);
+    GstURIType uri_type = gst_element_factory_get_uri_type (factory);
+
+    json_print_metadata (feature);
+    json_print_pad_templates (factory);
+    if (uri_type != GST_URI_UNKNOWN) {
+      json_string ("uri-type", uri_type == GST_URI_SRC ? "src" : "sink");
+      json_strv ("uri-protocols",
+          gst_element_factory_get_uri_protocols (factory));
+    }
+  } else if (GST_IS_DEVICE_PROVIDER_FACTORY (feature)) {
+    json_print_metadata (feature);
+  } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
+    GstTypeFindFactory *factory = GST_TYPE_FIND_FACTORY (feature);
+    GstCaps *caps;
+
+    json_strv ("extensions", gst_type_find_factory_get_extensions (factory));
+    if ((caps = gst_type_find_factory_get_caps (factory))) {
+      gchar *str = gst_caps_to_string (caps);
+
+      json_string ("caps", str);
+      g_free (str);
+    }
+  }
+  json_end ('}');
+}
+
+static void
+json_print_plugin (GstPlugin * plugin)
+{
+  GList *features, *f;
+
+  json_begin (NULL, '{');
+  json_string ("name", gst_plugin_get_name (plugin));
+  json_string ("description", gst_plugin_get_description (plugin));
+  json_string ("filename", gst_plugin_get_filename (plugin));
+  json_string ("version", gst_plugin_get_version (plugin));
+  json_string ("license", gst_plugin_get_license (plugin));
+  json_string ("source", gst_plugin_get_source (plugin));
+  json_string ("package", gst_plugin_get_package (plugin));
+  json_string ("origin", gst_plugin_get_origin (plugin));
+  json_string ("release-date", gst_plugin_get_release_date_string (plugin));
+  json_boolean ("blacklisted", GST_OBJECT_FLAG_IS_SET (plugin,
+          GST_PLUGIN_FLAG_BLACKLISTED));
+
+  features = gst_registry_get_feature_list_by_plugin (gst_registry_get (),
+      gst_plugin_get_name (plugin));
+  if (sort_output == SORT_TYPE_NAME)
+    features = g_list_sort (features, gst_plugin_feature_name_compare_func);
+  json_begin ("features", '[');
+  for (f = features; f; f = f->next) {
+    if (G_LIKELY (f->data != NULL))
+      json_print_feature (GST_PLUGIN_FEATURE (f->data), FALSE);
+  }
+  json_end (']');
+  gst_plugin_feature_list_free (features);
+
+  json_end ('}');
+}
+
+static int
+json_print_registry (const gchar * name, gboolean plugin_name)
+{
+  GList *plugins, *p;
+  int ret = 0;
+
+  json_out = g_string_new (NULL);
+
+  if (name) {
+    GstPluginFeature *feature = NULL;
+    GstPlugin *plugin;
+
+    if (!plugin_name
+        && (feature = gst_registry_lookup_feature (gst_registry_get (), name))) {
+      json_print_feature (feature, TRUE);
+      gst_object_unref (feature);
+    } else if ((plugin = gst_registry_find_plugin (gst_registry_get (), name))) {
+      json_print_plugin (plugin);
+      gst_object_unref (plugin);
+    } else {
+      g_printerr (_("No such element or plugin '%s'\n"), name);
+      ret = -1;
+    }
+  } else {
+    plugins = gst_registry_get_plugin_list (gst_registry_get ());
+    if (sort_output == SORT_TYPE_NAME)
+      plugins = g_list_sort (plugins, gst_plugin_name_compare_func);
+    json_begin (NULL, '[');
+    for (p = plugins; p; p = p->next)
+      json_print_plugin (GST_PLUGIN (p->data));
+    json_end (']');
+    gst_plugin_list_free (plugins);
+  }
+
+  g_string_free (json_out, TRUE);
+  json_out = NULL;
+
+  return ret;
+}
+
 #ifdef G_OS_UNIX
 static gboolean
 redirect_stdout (void)
@@ -2030,6 +2305,7 @@ main (int argc, char *argv[])
   gboolean uri_handlers = FALSE;
   gboolean check_exists = FALSE;
   gboolean color_always = FALSE;
+  gboolean json = FALSE;
   gchar *min_version = NULL;
   guint minver_maj = GST_VERSION_MAJOR;
   guint minver_min = GST_VERSION_MINOR;
@@ -2076,6 +2352,11 @@ main (int argc, char *argv[])
     {"color", 'C', 0, G_OPTION_ARG_NONE, &color_always,
           N_("Color output, even when not sending to a tty."),
         NULL},
+    {"json", '\0', 0, G_OPTION_ARG_NONE, &json,
+          N_("Print the registry information about all plugins, or the "
+              "specified element or plugin, as JSON without loading any "
+              "plugin"),
+        NULL},
     GST_TOOLS_GOPTION_VERSION,
     {NULL}
   };
@@ -2163,6 +2444,14 @@ main (int argc, char *argv[])
     return exit_code;
   }
 
+  if (json) {
+    if (argc > 2) {
+      g_printerr ("--json accepts at most one extra argument\n");
+      return -1;
+    }
+    return json_print_registry (argc > 1 ? argv[1] : NULL, plugin_name);
+  }
+
   no_colors = g_getenv ("GST_INSPECT_NO_COLORS");
   /* We only support truecolor */
   colored_output &= (no_colors == NULL);
@@ -45,6 +45,9 @@
 #define isatty _isatty
 #endif
 #include <locale.h>             /* for LC_ALL */
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 #include "tools.h"
 #ifdef HAVE_WINMM
 #include <timeapi.h>
@@ -76,6 +79,9 @@ static gboolean toc = FALSE;
 static gboolean messages = FALSE;
 static gboolean eos_on_shutdown = FALSE;
 static gchar **exclude_args = NULL;
+static gboolean stats = FALSE;
+static gdouble stats_duration = 0.0;
+static gdouble stats_warmup = 0.0;
 
 /* pipeline status */
 static gboolean is_live = FALSE;
@@ -550,6 +556,219 @@ w32_intr_handler (DWORD dwCtrlType)
 #endif /* G_OS_WIN32 */
 #endif /* G_OS_UNIX */
 
+/* buffers and bytes received by a sink while measuring */
+typedef struct
+{
+  GstElement *sink;
+  guint64 buffers;
+  guint64 bytes;
+} SinkStats;
+
+static GMutex stats_lock;
+static GPtrArray *sink_stats = NULL;
+static GstClockTime stats_start = GST_CLOCK_TIME_NONE;
+static GstClockTime stats_end = GST_CLOCK_TIME_NONE;
+static GstClockTime stats_cpu_start = GST_CLOCK_TIME_NONE;
+static GstClockTime stats_cpu_end = GST_CLOCK_TIME_NONE;
+static gboolean stats_measuring = FALSE;
+static gboolean stats_scheduled = FALSE;
+
+/* the cpu time used by the process so far */
+static GstClockTime
+get_cpu_time (void)
+{
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+  struct rusage ru;
+
+  if (getrusage (RUSAGE_SELF, &ru) == 0)
+    return GST_TIMEVAL_TO_TIME (ru.ru_utime) +
+        GST_TIMEVAL_TO_TIME (ru.ru_stime);
+#endif
+  return GST_CLOCK_TIME_NONE;
+}
+
+static GstPadProbeReturn
+sink_stats_probe (GstPad * pad, GstPadProbeInfo * info, SinkStats * s)
+{
+  guint64 buffers = 1, bytes;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST (info);
+
+    buffers = gst_buffer_list_length (list);
+    bytes = gst_buffer_list_calculate_size (list);
+  } else {
+    bytes = gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  }
+
+  g_mutex_lock (&stats_lock);
+  if (stats_measuring) {
+    s->buffers += buffers;
+    s->bytes += bytes;
+  }
+  g_mutex_unlock (&stats_lock);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+add_sink_stats (const GValue * item, gpointer user_data)
+{
+  GstElement *element = g_value_get_object (item);
+  GstObject *parent;
+  SinkStats *s;
+  gboolean counted;
+
+  if (!GST_OBJECT_FLAG_IS_SET (element, GST_ELEMENT_FLAG_SINK))
+    return;
+
+  /* sinks inside of sink bins are counted by the outermost bin */
+  parent = gst_object_get_parent (GST_OBJECT (element));
+  counted = parent && parent != user_data
+      && GST_OBJECT_FLAG_IS_SET (parent, GST_ELEMENT_FLAG_SINK);
+  if (parent)
+    gst_object_unref (parent);
+  if (counted)
+    return;
+
+  s = g_new0 (SinkStats, 1);
+  s->sink = gst_object_ref (element);
+  g_ptr_array_add (sink_stats, s);
+}
+
+static void
+free_sink_stats (SinkStats * s)
+{
+  gst_object_unref (s->sink);
+  g_free (s);
+}
+
+static void
+setup_stats (GstElement * pipeline)
+{
+  GstIterator *it;
+  GValue v = G_VALUE_INIT;
+  guint i;
+
+  sink_stats = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      free_sink_stats);
+
+  it = gst_bin_iterate_recurse (GST_BIN (pipeline));
+  while (gst_iterator_foreach (it, add_sink_stats, pipeline) ==
+      GST_ITERATOR_RESYNC) {
+    g_ptr_array_set_size (sink_stats, 0);
+    gst_iterator_resync (it);
+  }
+  gst_iterator_free (it);
+
+  for (i = 0; i < sink_stats->len; i++) {
+    SinkStats *s = g_ptr_array_index (sink_stats, i);
+
+    it = gst_element_iterate_sink_pads (s->sink);
+    while (gst_iterator_next (it, &v) == GST_ITERATOR_OK) {
+      gst_pad_add_probe (g_value_get_object (&v),
+          GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+          (GstPadProbeCallback) sink_stats_probe, s, NULL);
+      g_value_reset (&v);
+    }
+    g_value_unset (&v);
+    gst_iterator_free (it);
+  }
+}
+
+static void
+start_stats (void)
+{
+  guint i;
+
+  g_mutex_lock (&stats_lock);
+  for (i = 0; i < sink_stats->len; i++) {
+    SinkStats *s = g_ptr_array_index (sink_stats, i);
+
+    s->buffers = s->bytes = 0;
+  }
+  stats_measuring = TRUE;
+  stats_start = gst_util_get_timestamp ();
+  stats_cpu_start = get_cpu_time ();
+  g_mutex_unlock (&stats_lock);
+}
+
+static void
+stop_stats (void)
+{
+  g_mutex_lock (&stats_lock);
+  if (stats_measuring) {
+    stats_measuring = FALSE;
+    stats_end = gst_util_get_timestamp ();
+    stats_cpu_end = get_cpu_time ();
+  }
+  g_mutex_unlock (&stats_lock);
+}
+
+static void
+print_stats (void)
+{
+  GstClockTimeDiff elapsed;
+  gdouble secs;
+  guint i;
+
+  stop_stats ();
+
+  if (!GST_CLOCK_TIME_IS_VALID (stats_start)) {
+    gst_print (_("No statistics, the pipeline did not reach PLAYING or "
+            "stopped during the warm-up\n"));
+    return;
+  }
+
+  elapsed = GST_CLOCK_DIFF (stats_start, stats_end);
+  secs = MAX (elapsed, 1) / (gdouble) GST_SECOND;
+
+  gst_print (_("Statistics over %" GST_TIME_FORMAT ":\n"),
+      GST_TIME_ARGS (elapsed));
+  for (i = 0; i < sink_stats->len; i++) {
+    SinkStats *s = g_ptr_array_index (sink_stats, i);
+
+    gst_print ("  %s: %" G_GUINT64_FORMAT " buffers (%.1f/s), %"
+        G_GUINT64_FORMAT " bytes (%.3f MB/s)\n", GST_ELEMENT_NAME (s->sink),
+        s->buffers, s->buffers / secs, s->bytes, s->bytes / secs / 1e6);
+  }
+  if (GST_CLOCK_TIME_IS_VALID (stats_cpu_start)
+      && GST_CLOCK_TIME_IS_VALID (stats_cpu_end)) {
+    GstClockTime cpu = stats_cpu_end - stats_cpu_start;
+
+    gst_print (_("  CPU time: %" GST_TIME_FORMAT " (%.1f%% of one core)\n"),
+        GST_TIME_ARGS (cpu), 100.0 * cpu / MAX (elapsed, 1));
+  }
+}
+
+static gboolean
+warmup_done (gpointer user_data)
+{
+  PRINT (_("Warm-up done, measuring ...\n"));
+  start_stats ();
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+duration_done (gpointer user_data)
+{
+  GstElement *pipeline = (GstElement *) user_data;
+
+  stop_stats ();
+
+  if (eos_on_shutdown) {
+    PRINT (_("Duration elapsed -- Forcing EOS on the pipeline\n"));
+    gst_element_send_event (pipeline, gst_event_new_eos ());
+    waiting_eos = TRUE;
+  } else {
+    PRINT (_("Duration elapsed -- Stopping pipeline ...\n"));
+    g_main_loop_quit (loop);
+  }
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 do_initial_play (GstElement * pipeline)
 {
@@ -557,6 +776,21 @@ do_initial_play (GstElement * pipeline)
 
   tfthen = gst_util_get_timestamp ();
 
+  /* we get here again after buffering, keep measuring then */
+  if (!stats_scheduled) {
+    stats_scheduled = TRUE;
+
+    if (stats) {
+      if (stats_warmup > 0)
+        g_timeout_add ((guint) (stats_warmup * 1000), warmup_done, NULL);
+      else
+        start_stats ();
+    }
+    if (stats_duration > 0)
+      g_timeout_add ((guint) ((stats_warmup + stats_duration) * 1000),
+          duration_done, pipeline);
+  }
+
   if (gst_element_set_state (pipeline,
           GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
     gst_printerr (_("ERROR: pipeline doesn't want to play.\n"));
@@ -1102,6 +1336,16 @@ main (int argc, char *argv[])
         N_("Do not install a fault handler"), NULL},
     {"eos-on-shutdown", 'e', 0, G_OPTION_ARG_NONE, &eos_on_shutdown,
         N_("Force EOS on sources before shutting the pipeline down"), NULL},
+    {"stats", '\0', 0, G_OPTION_ARG_NONE, &stats,
+          N_("Print the number of buffers and bytes received by every sink "
+              "and the CPU time used at the end"), NULL},
+    {"duration", '\0', 0, G_OPTION_ARG_DOUBLE, &stats_duration,
+          N_("Stop the pipeline after running for the given time after the "
+              "warm-up, or force EOS with \"eos-on-shutdown\""),
+        N_("SECONDS")},
+    {"warmup", '\0', 0, G_OPTION_ARG_DOUBLE, &stats_warmup,
+          N_("Start measuring the statistics after running for the given "
+              "time"), N_("SECONDS")},
 #if 0
     {"index", 'i', 0, G_OPTION_ARG_NONE, &check_index,
         N_("Gather and print index statistics"), NULL},
@@ -1234,6 +1478,9 @@ main (int argc, char *argv[])
     winmm_timer_resolution = enable_winmm_timer_resolution ();
 #endif
 
+    if (stats)
+      setup_stats (pipeline);
+
     if (verbose) {
       deep_notify_id =
           gst_element_add_property_deep_notify_watch (pipeline, NULL, TRUE);
@@ -1322,6 +1569,9 @@ main (int argc, char *argv[])
       }
     }
 
+    if (stats)
+      print_stats ();
+
     /* No need to see all those pad caps going to NULL etc., it's just noise */
     if (deep_notify_id != 0)
       g_signal_handler_disconnect (pipeline, deep_notify_id);
@@ -1353,6 +1603,8 @@ main (int argc, char *argv[])
   }
 
   PRINT (_("Freeing pipeline ...\n"));
+  if (sink_stats)
+    g_ptr_array_unref (sink_stats);
   gst_object_unref (pipeline);
 
   gst_deinit ();
@@ -40,6 +40,15 @@ static GPtrArray *pads = NULL;
 static GHashTable *latencies = NULL;
 static GHashTable *element_latencies = NULL;
 static GQueue *element_reported_latencies = NULL;
+/* "element-id.element" -> last element-time GstStructure */
+static GHashTable *element_times = NULL;
+/* same keys as the latency tables -> last latency summary GstStructure */
+static GHashTable *latency_summaries = NULL;
+static GHashTable *element_latency_summaries = NULL;
+/* "kind.owner-id" -> last memory-usage GstStructure */
+static GHashTable *memory_usages = NULL;
+/* "site.object-id" -> last lock-stats GstStructure */
+static GHashTable *lock_stats = NULL;
 static guint64 num_buffers = 0, num_events = 0, num_messages = 0, num_queries =
     0;
 static guint num_elements = 0, num_bins = 0, num_pads = 0, num_ghostpads = 0;
@@ -628,6 +637,74 @@ do_element_latency_stats (GstStructure * s)
   have_element_latency = TRUE;
 }
 
+static void
+do_latency_summary (GstStructure * s)
+{
+  const gchar *src, *sink, *src_element, *sink_element, *src_element_id,
+      *sink_element_id;
+  guint64 ts = 0;
+
+  src = gst_structure_get_string (s, "src");
+  sink = gst_structure_get_string (s, "sink");
+  src_element = gst_structure_get_string (s, "src-element");
+  sink_element = gst_structure_get_string (s, "sink-element");
+  src_element_id = gst_structure_get_string (s, "src-element-id");
+  sink_element_id = gst_structure_get_string (s, "sink-element-id");
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts, NULL);
+
+  last_ts = MAX (last_ts, ts);
+
+  /* the summaries are cumulative, only keep the last record */
+  g_hash_table_insert (latency_summaries,
+      g_strdup_printf ("%s.%s.%s|%s.%s.%s", src_element_id, src_element, src,
+          sink_element_id, sink_element, sink), gst_structure_copy (s));
+}
+
+static void
+do_element_latency_summary (GstStructure * s)
+{
+  const gchar *src, *element, *element_id;
+  guint64 ts = 0;
+
+  src = gst_structure_get_string (s, "src");
+  element = gst_structure_get_string (s, "element");
+  element_id = gst_structure_get_string (s, "element-id");
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts, NULL);
+
+  last_ts = MAX (last_ts, ts);
+
+  g_hash_table_insert (element_latency_summaries,
+      g_strdup_printf ("%s.%s.%s", element_id, element, src),
+      gst_structure_copy (s));
+}
+
+static void
+print_latency_summaries (GHashTable * table)
+{
+  GList *keys, *l;
+
+  keys = g_list_sort (g_hash_table_get_keys (table), (GCompareFunc) strcmp);
+  for (l = keys; l; l = l->next) {
+    GstStructure *s = g_hash_table_lookup (table, l->data);
+    guint64 count = 0, min = 0, max = 0, mean = 0, p50 = 0, p90 = 0, p99 = 0,
+        p999 = 0;
+
+    gst_structure_get (s, "count", G_TYPE_UINT64, &count,
+        "min", G_TYPE_UINT64, &min, "max", G_TYPE_UINT64, &max,
+        "mean", G_TYPE_UINT64, &mean, "p50", G_TYPE_UINT64, &p50,
+        "p90", G_TYPE_UINT64, &p90, "p99", G_TYPE_UINT64, &p99,
+        "p999", G_TYPE_UINT64, &p999, NULL);
+
+    printf ("\t%s: count=%" G_GUINT64_FORMAT " mean=%" GST_TIME_FORMAT " min=%"
+        GST_TIME_FORMAT " max=%" GST_TIME_FORMAT "\n", (gchar *) l->data,
+        count, GST_TIME_ARGS (mean), GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+    printf ("\t\tp50=%" GST_TIME_FORMAT " p90=%" GST_TIME_FORMAT " p99=%"
+        GST_TIME_FORMAT " p99.9=%" GST_TIME_FORMAT "\n", GST_TIME_ARGS (p50),
+        GST_TIME_ARGS (p90), GST_TIME_ARGS (p99), GST_TIME_ARGS (p999));
+  }
+  g_list_free (keys);
+}
+
 static void
 do_element_reported_latency (GstStructure * s)
 {
@@ -656,6 +733,171 @@ do_element_reported_latency (GstStructure * s)
   have_element_reported_latency = TRUE;
 }
 
+static void
+do_element_time (GstStructure * s)
+{
+  const gchar *element_id, *element;
+  guint64 ts = 0;
+
+  element_id = gst_structure_get_string (s, "element-id");
+  element = gst_structure_get_string (s, "element");
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts, NULL);
+  if (!element_id || !element)
+    return;
+
+  last_ts = MAX (last_ts, ts);
+
+  /* the values are cumulative, only keep the last record */
+  g_hash_table_insert (element_times, g_strdup_printf ("%s.%s", element_id,
+          element), gst_structure_copy (s));
+}
+
+static gint
+sort_element_times (gconstpointer a, gconstpointer b)
+{
+  guint64 wall_a = 0, wall_b = 0;
+
+  gst_structure_get ((GstStructure *) a, "wall", G_TYPE_UINT64, &wall_a, NULL);
+  gst_structure_get ((GstStructure *) b, "wall", G_TYPE_UINT64, &wall_b, NULL);
+
+  return wall_a < wall_b ? 1 : (wall_a > wall_b ? -1 : 0);
+}
+
+static void
+print_element_time (GstStructure * s, gpointer unused)
+{
+  guint64 count = 0, wall = 0, cpu = 0, queue_count = 0, queue_wait = 0;
+
+  gst_structure_get (s, "count", G_TYPE_UINT64, &count,
+      "wall", G_TYPE_UINT64, &wall, "cpu", G_TYPE_UINT64, &cpu,
+      "queue-count", G_TYPE_UINT64, &queue_count,
+      "queue-wait", G_TYPE_UINT64, &queue_wait, NULL);
+
+  printf ("\t%s [%s]: calls: %" G_GUINT64_FORMAT ", wall: %" GST_TIME_FORMAT
+      ", cpu: %" GST_TIME_FORMAT "\n", gst_structure_get_string (s, "element"),
+      gst_structure_get_string (s, "element-id"), count, GST_TIME_ARGS (wall),
+      GST_TIME_ARGS (cpu));
+  printf ("\t\twall histogram: %s\n",
+      gst_structure_get_string (s, "wall-histogram"));
+  printf ("\t\tcpu histogram: %s\n",
+      gst_structure_get_string (s, "cpu-histogram"));
+  if (queue_count) {
+    printf ("\t\tqueued buffers: %" G_GUINT64_FORMAT ", mean wait: %"
+        GST_TIME_FORMAT "\n", queue_count,
+        GST_TIME_ARGS (queue_wait / queue_count));
+    printf ("\t\tqueue wait histogram: %s\n",
+        gst_structure_get_string (s, "queue-histogram"));
+  }
+}
+
+static void
+do_memory_usage (GstStructure * s)
+{
+  const gchar *kind, *owner_id;
+  guint64 ts = 0;
+
+  kind = gst_structure_get_string (s, "kind");
+  owner_id = gst_structure_get_string (s, "owner-id");
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts, NULL);
+  if (!kind || !owner_id)
+    return;
+
+  last_ts = MAX (last_ts, ts);
+
+  /* the values are cumulative, only keep the last record */
+  g_hash_table_insert (memory_usages, g_strdup_printf ("%s.%s", kind,
+          owner_id), gst_structure_copy (s));
+}
+
+static gint
+sort_memory_usages (gconstpointer a, gconstpointer b)
+{
+  const GstStructure *s1 = a, *s2 = b;
+  guint64 peak1 = 0, peak2 = 0;
+  gint res;
+
+  res = g_strcmp0 (gst_structure_get_string (s1, "kind"),
+      gst_structure_get_string (s2, "kind"));
+  if (res)
+    return res;
+
+  gst_structure_get (s1, "peak", G_TYPE_UINT64, &peak1, NULL);
+  gst_structure_get (s2, "peak", G_TYPE_UINT64, &peak2, NULL);
+
+  return peak1 < peak2 ? 1 : (peak1 > peak2 ? -1 : 0);
+}
+
+static void
+print_memory_usage (GstStructure * s, gpointer unused)
+{
+  guint64 live = 0, peak = 0, count = 0, bytes = 0;
+  gdouble secs = (gdouble) last_ts / GST_SECOND;
+
+  gst_structure_get (s, "live", G_TYPE_UINT64, &live,
+      "peak", G_TYPE_UINT64, &peak, "count", G_TYPE_UINT64, &count,
+      "bytes", G_TYPE_UINT64, &bytes, NULL);
+
+  printf ("\t%s %s [%s]: live: %" G_GUINT64_FORMAT ", peak: %"
+      G_GUINT64_FORMAT ", allocations: %" G_GUINT64_FORMAT " (%.1f/s), bytes: %"
+      G_GUINT64_FORMAT " (%.1f/s)\n", gst_structure_get_string (s, "kind"),
+      gst_structure_get_string (s, "owner"),
+      gst_structure_get_string (s, "owner-id"), live, peak, count,
+      secs > 0 ? count / secs : 0.0, bytes, secs > 0 ? bytes / secs : 0.0);
+}
+
+static void
+do_lock_stats (GstStructure * s)
+{
+  const gchar *site, *object_id;
+  guint64 ts = 0;
+
+  site = gst_structure_get_string (s, "site");
+  object_id = gst_structure_get_string (s, "object-id");
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts, NULL);
+  if (!site || !object_id)
+    return;
+
+  last_ts = MAX (last_ts, ts);
+
+  /* the values are cumulative, only keep the last record */
+  g_hash_table_insert (lock_stats, g_strdup_printf ("%s.%s", site,
+          object_id), gst_structure_copy (s));
+}
+
+static gint
+sort_lock_stats (gconstpointer a, gconstpointer b)
+{
+  const GstStructure *s1 = a, *s2 = b;
+  guint64 wait1 = 0, wait2 = 0;
+
+  gst_structure_get (s1, "wait", G_TYPE_UINT64, &wait1, NULL);
+  gst_structure_get (s2, "wait", G_TYPE_UINT64, &wait2, NULL);
+
+  return wait1 < wait2 ? 1 : (wait1 > wait2 ? -1 : 0);
+}
+
+static void
+print_lock_stats (GstStructure * s, gpointer unused)
+{
+  guint64 count = 0, contended = 0, wait = 0, max_wait = 0, hold = 0,
+      max_hold = 0;
+
+  gst_structure_get (s, "count", G_TYPE_UINT64, &count,
+      "contended", G_TYPE_UINT64, &contended, "wait", G_TYPE_UINT64, &wait,
+      "max-wait", G_TYPE_UINT64, &max_wait, "hold", G_TYPE_UINT64, &hold,
+      "max-hold", G_TYPE_UINT64, &max_hold, NULL);
+
+  printf ("	%s [%s] at %s: taken: %" G_GUINT64_FORMAT ", contended: %"
+      G_GUINT64_FORMAT " (%.1f%%)\n", gst_structure_get_string (s, "object"),
+      gst_structure_get_string (s, "object-id"),
+      gst_structure_get_string (s, "site"), count, contended,
+      count > 0 ? 100.0 * contended / count : 0.0);
+  printf ("		wait: %" GST_TIME_FORMAT " (max %" GST_TIME_FORMAT
+      "), hold: %" GST_TIME_FORMAT " (max %" GST_TIME_FORMAT ")\n",
+      GST_TIME_ARGS (wait), GST_TIME_ARGS (max_wait), GST_TIME_ARGS (hold),
+      GST_TIME_ARGS (max_hold));
+}
+
 static void
 do_factory_used (GstStructure * s)
 {
@@ -963,6 +1205,16 @@ init (void)
   element_latencies = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
       free_latency_stats);
   element_reported_latencies = g_queue_new ();
+  element_times = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_structure_free);
+  latency_summaries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_structure_free);
+  element_latency_summaries = g_hash_table_new_full (g_str_hash, g_str_equal,
+      g_free, (GDestroyNotify) gst_structure_free);
+  memory_usages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_structure_free);
+  lock_stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      (GDestroyNotify) gst_structure_free);
 
   plugin_stats = g_ptr_array_new_with_free_func (free_plugin_stats);
 
@@ -993,6 +1245,11 @@ done (void)
     g_queue_free_full (element_reported_latencies, free_reported_latency);
     element_reported_latencies = NULL;
   }
+  g_clear_pointer (&element_times, g_hash_table_destroy);
+  g_clear_pointer (&latency_summaries, g_hash_table_destroy);
+  g_clear_pointer (&element_latency_summaries, g_hash_table_destroy);
+  g_clear_pointer (&memory_usages, g_hash_table_destroy);
+  g_clear_pointer (&lock_stats, g_hash_table_destroy);
 
   g_clear_pointer (&plugin_stats, g_ptr_array_unref);
 
@@ -1117,6 +1374,18 @@ print_stats (void)
     g_list_free (list);
   }
 
+  /* latency percentiles */
+  if (g_hash_table_size (latency_summaries)) {
+    puts ("Latency Percentiles:");
+    print_latency_summaries (latency_summaries);
+    puts ("");
+  }
+  if (g_hash_table_size (element_latency_summaries)) {
+    puts ("Element Latency Percentiles:");
+    print_latency_summaries (element_latency_summaries);
+    puts ("");
+  }
+
   /* element reported latency stats */
   if (have_element_reported_latency) {
     puts ("Element Reported Latency:");
@@ -1125,6 +1394,42 @@ print_stats (void)
     puts ("");
   }
 
+  /* element time stats */
+  if (g_hash_table_size (element_times)) {
+    GList *list;
+
+    puts ("Element Time Statistics (histograms in calls per 2^n µs):");
+    list = g_hash_table_get_values (element_times);
+    list = g_list_sort (list, sort_element_times);
+    g_list_foreach (list, (GFunc) print_element_time, NULL);
+    puts ("");
+    g_list_free (list);
+  }
+
+  /* memory usage stats */
+  if (g_hash_table_size (memory_usages)) {
+    GList *list;
+
+    puts ("Memory Usage Statistics:");
+    list = g_hash_table_get_values (memory_usages);
+    list = g_list_sort (list, sort_memory_usages);
+    g_list_foreach (list, (GFunc) print_memory_usage, NULL);
+    puts ("");
+    g_list_free (list);
+  }
+
+  /* lock contention stats */
+  if (g_hash_table_size (lock_stats)) {
+    GList *list;
+
+    puts ("Lock Contention Statistics:");
+    list = g_hash_table_get_values (lock_stats);
+    list = g_list_sort (list, sort_lock_stats);
+    g_list_foreach (list, (GFunc) print_lock_stats, NULL);
+    puts ("");
+    g_list_free (list);
+  }
+
   if (plugin_stats->len > 0) {
     guint i, j, f;
 
@@ -1163,111 +1468,592 @@ print_stats (void)
   }
 }
 
+static gboolean
+dispatch_entry (GstStructure * s)
+{
+  const gchar *name = gst_structure_get_name (s);
+
+  if (!strcmp (name, "new-pad")) {
+    new_pad_stats (s);
+  } else if (!strcmp (name, "new-element")) {
+    new_element_stats (s);
+  } else if (!strcmp (name, "buffer")) {
+    do_buffer_stats (s);
+  } else if (!strcmp (name, "event")) {
+    do_event_stats (s);
+  } else if (!strcmp (name, "message")) {
+    do_message_stats (s);
+  } else if (!strcmp (name, "query")) {
+    do_query_stats (s);
+  } else if (!strcmp (name, "thread-rusage")) {
+    do_thread_rusage_stats (s);
+  } else if (!strcmp (name, "proc-rusage")) {
+    do_proc_rusage_stats (s);
+  } else if (!strcmp (name, "latency")) {
+    do_latency_stats (s);
+  } else if (!strcmp (name, "element-latency")) {
+    do_element_latency_stats (s);
+  } else if (!strcmp (name, "element-reported-latency")) {
+    do_element_reported_latency (s);
+  } else if (!strcmp (name, "latency-summary")) {
+    do_latency_summary (s);
+  } else if (!strcmp (name, "element-latency-summary")) {
+    do_element_latency_summary (s);
+  } else if (!strcmp (name, "factory-used")) {
+    do_factory_used (s);
+  } else if (!strcmp (name, "element-time")) {
+    do_element_time (s);
+  } else if (!strcmp (name, "memory-usage")) {
+    do_memory_usage (s);
+  } else if (!strcmp (name, "lock-stats")) {
+    do_lock_stats (s);
+  } else {
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* binary record files, as written when GST_TRACER_RECORD_FILE is set, see
+ * gsttracerrecord.c for the format */
+#define BINARY_MAGIC "GSTTRACE"
+#define BINARY_VERSION 1
+#define BINARY_BYTE_ORDER 0x01020304
+
+enum
+{
+  BINARY_FRAME_SCHEMA = 1,
+  BINARY_FRAME_ENTRY,
+  BINARY_FRAME_DROPPED
+};
+
+enum
+{
+  BINARY_INT32 = 0,
+  BINARY_UINT32,
+  BINARY_INT64,
+  BINARY_UINT64,
+  BINARY_BOOLEAN,
+  BINARY_DOUBLE,
+  BINARY_POINTER,
+  BINARY_ENUM,
+  BINARY_FLAGS,
+  BINARY_STRING,
+  BINARY_SERIALIZED
+};
+
+typedef struct
+{
+  GQuark name;
+  guint8 kind;
+  GType type;
+} BinaryField;
+
+typedef struct
+{
+  gchar *name;
+  guint n_fields;
+  BinaryField *fields;
+} BinarySchema;
+
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+} BinaryReader;
+
+static gboolean
+binary_read (BinaryReader * r, gpointer dest, gsize size)
+{
+  if (r->size < size)
+    return FALSE;
+  memcpy (dest, r->data, size);
+  r->data += size;
+  r->size -= size;
+  return TRUE;
+}
+
+static gboolean
+binary_read_string (BinaryReader * r, gchar ** str)
+{
+  guint32 len;
+
+  if (!binary_read (r, &len, sizeof (len)))
+    return FALSE;
+  if (len == G_MAXUINT32) {
+    *str = NULL;
+    return TRUE;
+  }
+  if (r->size < len)
+    return FALSE;
+  *str = g_strndup ((const gchar *) r->data, len);
+  r->data += len;
+  r->size -= len;
+  return TRUE;
+}
+
 static void
-collect_stats (const gchar * filename)
+binary_schema_free (BinarySchema * schema)
 {
-  FILE *log;
+  g_free (schema->name);
+  g_free (schema->fields);
+  g_free (schema);
+}
 
-  if ((log = fopen (filename, "rt"))) {
-    gchar line[5001];
+static BinarySchema *
+binary_parse_schema (BinaryReader * r, guint32 * id)
+{
+  BinarySchema *schema = g_new0 (BinarySchema, 1);
+  guint32 n_fields;
+  guint i;
 
-    /* probe format */
-    if (fgets (line, 5000, log)) {
-      GMatchInfo *match_info;
-      GRegex *parser;
-      GstStructure *s;
-      guint lnr = 0;
-      gchar *level, *data;
+  if (!binary_read (r, id, sizeof (*id)) ||
+      !binary_read_string (r, &schema->name) || !schema->name ||
+      !binary_read (r, &n_fields, sizeof (n_fields)) || n_fields > r->size)
+    goto error;
+
+  schema->fields = g_new0 (BinaryField, n_fields);
+  for (i = 0; i < n_fields; i++) {
+    BinaryField *field = &schema->fields[i];
+    gchar *name, *type_name;
+
+    if (!binary_read_string (r, &name) || !name)
+      goto error;
+    field->name = g_quark_from_string (name);
+    g_free (name);
+    if (!binary_read (r, &field->kind, 1) ||
+        !binary_read_string (r, &type_name))
+      goto error;
+    /* types of plugins that are not loaded are unknown here */
+    field->type = type_name ? g_type_from_name (type_name) : G_TYPE_INVALID;
+    g_free (type_name);
+    schema->n_fields++;
+  }
 
-      if (strchr (line, 27)) {
-        parser = ansi_log;
-        GST_INFO ("format is 'ansi'");
-      } else {
-        parser = raw_log;
-        GST_INFO ("format is 'raw'");
+  return schema;
+
+error:
+  binary_schema_free (schema);
+  return NULL;
+}
+
+static GstStructure *
+binary_parse_entry (BinaryReader * r, BinarySchema * schema)
+{
+  GstStructure *s = gst_structure_new_empty (schema->name);
+  guint i;
+
+  for (i = 0; i < schema->n_fields; i++) {
+    BinaryField *field = &schema->fields[i];
+    GValue value = G_VALUE_INIT;
+
+    switch (field->kind) {
+      case BINARY_INT32:
+      case BINARY_ENUM:{
+        gint32 v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        if (field->kind == BINARY_ENUM && G_TYPE_IS_ENUM (field->type)) {
+          g_value_init (&value, field->type);
+          g_value_set_enum (&value, v);
+        } else {
+          g_value_init (&value, G_TYPE_INT);
+          g_value_set_int (&value, v);
+        }
+        break;
       }
-      rewind (log);
-
-      /* parse the log */
-      while (!feof (log)) {
-        if (fgets (line, 5000, log)) {
-          if (g_regex_match (parser, line, 0, &match_info)) {
-            /* filter by level */
-            level = g_match_info_fetch (match_info, 4);
-            if (!strcmp (level, "TRACE")) {
-              data = g_match_info_fetch (match_info, 7);
-              if ((s = gst_structure_from_string (data, NULL))) {
-                const gchar *name = gst_structure_get_name (s);
-
-                if (!strcmp (name, "new-pad")) {
-                  new_pad_stats (s);
-                } else if (!strcmp (name, "new-element")) {
-                  new_element_stats (s);
-                } else if (!strcmp (name, "buffer")) {
-                  do_buffer_stats (s);
-                } else if (!strcmp (name, "event")) {
-                  do_event_stats (s);
-                } else if (!strcmp (name, "message")) {
-                  do_message_stats (s);
-                } else if (!strcmp (name, "query")) {
-                  do_query_stats (s);
-                } else if (!strcmp (name, "thread-rusage")) {
-                  do_thread_rusage_stats (s);
-                } else if (!strcmp (name, "proc-rusage")) {
-                  do_proc_rusage_stats (s);
-                } else if (!strcmp (name, "latency")) {
-                  do_latency_stats (s);
-                } else if (!strcmp (name, "element-latency")) {
-                  do_element_latency_stats (s);
-                } else if (!strcmp (name, "element-reported-latency")) {
-                  do_element_reported_latency (s);
-                } else if (!strcmp (name, "factory-used")) {
-                  do_factory_used (s);
-                } else {
-                  // TODO(ensonic): parse the xxx.class log lines
-                  if (!g_str_has_suffix (data, ".class")) {
-                    GST_WARNING ("unknown log entry: '%s'", data);
-                  }
-                }
-                gst_structure_free (s);
-              } else {
-                GST_WARNING ("unknown log entry: '%s'", data);
-              }
-              g_free (data);
-            }
-            g_free (level);
-          } else {
-            if (*line) {
-              GST_WARNING ("foreign log entry: %s:%d:'%s'", filename, lnr,
-                  g_strchomp (line));
+      case BINARY_UINT32:
+      case BINARY_FLAGS:{
+        guint32 v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        if (field->kind == BINARY_FLAGS && G_TYPE_IS_FLAGS (field->type)) {
+          g_value_init (&value, field->type);
+          g_value_set_flags (&value, v);
+        } else {
+          g_value_init (&value, G_TYPE_UINT);
+          g_value_set_uint (&value, v);
+        }
+        break;
+      }
+      case BINARY_INT64:{
+        gint64 v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        g_value_init (&value, G_TYPE_INT64);
+        g_value_set_int64 (&value, v);
+        break;
+      }
+      case BINARY_UINT64:
+      case BINARY_POINTER:{
+        guint64 v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        if (field->kind == BINARY_POINTER) {
+          g_value_init (&value, G_TYPE_POINTER);
+          g_value_set_pointer (&value, (gpointer) (guintptr) v);
+        } else {
+          g_value_init (&value, G_TYPE_UINT64);
+          g_value_set_uint64 (&value, v);
+        }
+        break;
+      }
+      case BINARY_BOOLEAN:{
+        guint8 v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        g_value_init (&value, G_TYPE_BOOLEAN);
+        g_value_set_boolean (&value, v != 0);
+        break;
+      }
+      case BINARY_DOUBLE:{
+        gdouble v;
+
+        if (!binary_read (r, &v, sizeof (v)))
+          goto error;
+        g_value_init (&value, G_TYPE_DOUBLE);
+        g_value_set_double (&value, v);
+        break;
+      }
+      case BINARY_STRING:
+      case BINARY_SERIALIZED:{
+        gchar *str;
+
+        if (!binary_read_string (r, &str))
+          goto error;
+        if (field->kind == BINARY_SERIALIZED && str && field->type) {
+          g_value_init (&value, field->type);
+          if (!gst_value_deserialize (&value, str))
+            g_value_unset (&value);
+        }
+        if (!G_IS_VALUE (&value)) {
+          g_value_init (&value, G_TYPE_STRING);
+          g_value_take_string (&value, str);
+        } else {
+          g_free (str);
+        }
+        break;
+      }
+      default:
+        goto error;
+    }
+    /* e.g. for longs, chars and floats */
+    if (field->type && field->type != G_VALUE_TYPE (&value) &&
+        g_value_type_transformable (G_VALUE_TYPE (&value), field->type)) {
+      GValue converted = G_VALUE_INIT;
+
+      g_value_init (&converted, field->type);
+      g_value_transform (&value, &converted);
+      g_value_unset (&value);
+      value = converted;
+    }
+    gst_structure_id_take_value (s, field->name, &value);
+  }
+
+  return s;
+
+error:
+  gst_structure_free (s);
+  return NULL;
+}
+
+/* input that is read sequentially, the first bytes are read ahead to probe
+ * the format */
+typedef struct
+{
+  FILE *file;
+  gchar peek[8];
+  gsize n_peek;
+  gsize peek_pos;
+} LogReader;
+
+static gboolean
+log_read (LogReader * r, gpointer dest, gsize size)
+{
+  guint8 *d = dest;
+
+  while (size > 0 && r->peek_pos < r->n_peek) {
+    *d++ = r->peek[r->peek_pos++];
+    size--;
+  }
+  return size == 0 || fread (d, 1, size, r->file) == size;
+}
+
+/* read a line of at most @max bytes into @line, returns FALSE at the end */
+static gboolean
+log_read_line (LogReader * r, GString * line, gsize max)
+{
+  gint c;
+
+  g_string_truncate (line, 0);
+  while (line->len < max) {
+    if (r->peek_pos < r->n_peek)
+      c = (guchar) r->peek[r->peek_pos++];
+    else if ((c = getc (r->file)) == EOF)
+      break;
+    g_string_append_c (line, c);
+    if (c == '\n')
+      break;
+  }
+  return line->len > 0;
+}
+
+/* periodic summaries */
+static GstClockTime interval = 0;
+static GstClockTime next_summary = GST_CLOCK_TIME_NONE;
+static guint64 last_num_buffers = 0, last_num_events = 0;
+static guint64 last_num_messages = 0, last_num_queries = 0;
+
+static void
+print_interval_summary (void)
+{
+  g_print ("%" GST_TIME_FORMAT ": %" G_GUINT64_FORMAT " buffers (+%"
+      G_GUINT64_FORMAT "), %" G_GUINT64_FORMAT " events (+%"
+      G_GUINT64_FORMAT "), %" G_GUINT64_FORMAT " messages (+%"
+      G_GUINT64_FORMAT "), %" G_GUINT64_FORMAT " queries (+%"
+      G_GUINT64_FORMAT "), %u threads, %u elements\n",
+      GST_TIME_ARGS (last_ts), num_buffers, num_buffers - last_num_buffers,
+      num_events, num_events - last_num_events, num_messages,
+      num_messages - last_num_messages, num_queries,
+      num_queries - last_num_queries, g_hash_table_size (threads),
+      num_elements - num_bins);
+  if (have_cpuload)
+    g_print ("  Avg CPU load: %4.1f %%\n", (gfloat) total_cpuload / 10.0);
+
+  last_num_buffers = num_buffers;
+  last_num_events = num_events;
+  last_num_messages = num_messages;
+  last_num_queries = num_queries;
+}
+
+/* the full statistics accumulate the element statistics into the bins when
+ * printing, so only the counters are printed while reading */
+static void
+maybe_print_summary (void)
+{
+  if (interval == 0 || !GST_CLOCK_TIME_IS_VALID (last_ts))
+    return;
+
+  if (!GST_CLOCK_TIME_IS_VALID (next_summary))
+    next_summary = last_ts + interval;
+
+  if (last_ts >= next_summary) {
+    print_interval_summary ();
+    next_summary += interval * ((last_ts - next_summary) / interval + 1);
+  }
+}
+
+static void
+collect_binary_stats (LogReader * log)
+{
+  GHashTable *schemas;
+  GByteArray *buf;
+  guint32 header[2];
+  guint64 dropped = 0;
+  gchar magic[8];
+
+  if (!log_read (log, magic, sizeof (magic))
+      || !log_read (log, header, sizeof (header))
+      || header[0] != BINARY_VERSION || header[1] != BINARY_BYTE_ORDER) {
+    fprintf (stderr, "unsupported tracer record file\n");
+    return;
+  }
+
+  schemas = g_hash_table_new_full (NULL, NULL, NULL,
+      (GDestroyNotify) binary_schema_free);
+  /* only one frame is in memory at a time */
+  buf = g_byte_array_new ();
+
+  while (TRUE) {
+    BinaryReader frame;
+    guint8 type;
+    guint32 len;
+
+    if (!log_read (log, &type, 1))
+      break;
+    if (!log_read (log, &len, sizeof (len))) {
+      GST_WARNING ("truncated tracer record file");
+      break;
+    }
+    g_byte_array_set_size (buf, len);
+    if (!log_read (log, buf->data, len)) {
+      GST_WARNING ("truncated tracer record file");
+      break;
+    }
+    frame.data = buf->data;
+    frame.size = len;
+
+    switch (type) {
+      case BINARY_FRAME_SCHEMA:{
+        BinarySchema *schema;
+        guint32 id;
+
+        if ((schema = binary_parse_schema (&frame, &id)))
+          g_hash_table_insert (schemas, GUINT_TO_POINTER (id), schema);
+        else
+          GST_WARNING ("invalid tracer record schema");
+        break;
+      }
+      case BINARY_FRAME_ENTRY:{
+        BinarySchema *schema;
+        GstStructure *s;
+        guint32 id;
+
+        if (!binary_read (&frame, &id, sizeof (id)) ||
+            !(schema = g_hash_table_lookup (schemas, GUINT_TO_POINTER (id)))) {
+          GST_WARNING ("tracer record entry without schema");
+          break;
+        }
+        if ((s = binary_parse_entry (&frame, schema))) {
+          if (!dispatch_entry (s))
+            GST_WARNING ("unknown log entry: '%s'", schema->name);
+          gst_structure_free (s);
+          maybe_print_summary ();
+        } else {
+          GST_WARNING ("invalid '%s' entry", schema->name);
+        }
+        break;
+      }
+      case BINARY_FRAME_DROPPED:{
+        guint32 n;
+
+        if (binary_read (&frame, &n, sizeof (n)))
+          dropped += n;
+        break;
+      }
+      default:
+        GST_WARNING ("unknown frame type %u", type);
+        break;
+    }
+  }
+
+  if (dropped)
+    fprintf (stderr, "%" G_GUINT64_FORMAT " tracer records were dropped, "
+        "the statistics are incomplete\n", dropped);
+
+  g_byte_array_unref (buf);
+  g_hash_table_destroy (schemas);
+}
+
+#define MAX_LINE_LENGTH 5000
+
+static void
+collect_text_stats (LogReader * log, const gchar * filename)
+{
+  GMatchInfo *match_info;
+  GRegex *parser;
+  GString *line;
+  GstStructure *s;
+  guint lnr = 0;
+  gchar *level, *data;
+
+  line = g_string_sized_new (MAX_LINE_LENGTH);
+
+  if (!log_read_line (log, line, MAX_LINE_LENGTH)) {
+    GST_WARNING ("empty log");
+    g_string_free (line, TRUE);
+    return;
+  }
+
+  if (strchr (line->str, 27)) {
+    parser = ansi_log;
+    GST_INFO ("format is 'ansi'");
+  } else {
+    parser = raw_log;
+    GST_INFO ("format is 'raw'");
+  }
+
+  /* parse the log */
+  do {
+    if (line->str[line->len - 1] != '\n' && line->len == MAX_LINE_LENGTH) {
+      fprintf (stderr, "line too long");
+      /* skip the rest of the line */
+      while (log_read_line (log, line, MAX_LINE_LENGTH)
+          && line->str[line->len - 1] != '\n');
+      lnr++;
+      continue;
+    }
+
+    /* only the TRACE lines are of interest, don't run the regex on the
+     * others */
+    if (!strstr (line->str, "TRACE")) {
+      lnr++;
+      continue;
+    }
+
+    if (g_regex_match (parser, line->str, 0, &match_info)) {
+      /* filter by level */
+      level = g_match_info_fetch (match_info, 4);
+      if (!strcmp (level, "TRACE")) {
+        data = g_match_info_fetch (match_info, 7);
+        if ((s = gst_structure_from_string (data, NULL))) {
+          if (!dispatch_entry (s)) {
+            // TODO(ensonic): parse the xxx.class log lines
+            if (!g_str_has_suffix (data, ".class")) {
+              GST_WARNING ("unknown log entry: '%s'", data);
             }
           }
-          g_match_info_free (match_info);
-          match_info = NULL;
-          lnr++;
+          gst_structure_free (s);
+          maybe_print_summary ();
         } else {
-          if (!feof (log)) {
-            // TODO(ensonic): run wc -L on the log file
-            fprintf (stderr, "line too long");
-          }
+          GST_WARNING ("unknown log entry: '%s'", data);
         }
+        g_free (data);
       }
+      g_free (level);
     } else {
-      GST_WARNING ("empty log");
+      GST_WARNING ("foreign log entry: %s:%d:'%s'", filename, lnr,
+          g_strchomp (line->str));
     }
-    fclose (log);
+    g_match_info_free (match_info);
+    match_info = NULL;
+    lnr++;
+  } while (log_read_line (log, line, MAX_LINE_LENGTH));
+
+  g_string_free (line, TRUE);
+}
+
+static void
+collect_stats (const gchar * filename)
+{
+  LogReader log = { NULL, };
+  gboolean is_stdin = !strcmp (filename, "-");
+
+  if (is_stdin)
+    log.file = stdin;
+  else if (!(log.file = fopen (filename, "rb")))
+    return;
+
+  /* probe format */
+  log.n_peek = fread (log.peek, 1, sizeof (log.peek), log.file);
+  if (log.n_peek == 8 && !memcmp (log.peek, BINARY_MAGIC, 8)) {
+    GST_INFO ("format is 'binary'");
+    collect_binary_stats (&log);
+  } else {
+    collect_text_stats (&log, filename);
   }
+
+  if (!is_stdin)
+    fclose (log.file);
 }
 
 gint
 main (gint argc, gchar * argv[])
 {
   gchar **filenames = NULL;
+  gdouble interval_secs = 0.0;
   guint num;
   GError *err = NULL;
   GOptionContext *ctx;
   GOptionEntry options[] = {
     GST_TOOLS_GOPTION_VERSION,
+    {"interval", 'i', 0, G_OPTION_ARG_DOUBLE, &interval_secs,
+          "Print a summary of the counters every SECONDS of logged time",
+        "SECONDS"},
     // TODO(ensonic): add a summary flag, if set read the whole thing, print
     // stats once, and exit
     {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL}
@@ -1283,7 +2069,7 @@ main (gint argc, gchar * argv[])
 
   g_set_prgname ("gst-stats-" GST_API_VERSION);
 
-  ctx = g_option_context_new ("FILE");
+  ctx = g_option_context_new ("FILE|-");
   g_option_context_add_main_entries (ctx, options, GETTEXT_PACKAGE);
   g_option_context_add_group (ctx, gst_init_get_option_group ());
   if (!g_option_context_parse (ctx, &argc, &argv, &err)) {
@@ -1305,6 +2091,9 @@ main (gint argc, gchar * argv[])
     return 1;
   }
 
+  if (interval_secs > 0)
+    interval = interval_secs * GST_SECOND;
+
   if (init ()) {
     collect_stats (filenames[0]);
     print_stats ();